@@ -21,6 +21,7 @@ check_include_files("sys/types.h;ifaddrs.h" HAVE_IFADDRS_H)
 check_include_file("netinet/in.h"           HAVE_NETINET_IN_H)
 check_include_file("netdb.h"                HAVE_NETDB_H)
 check_include_file("pwd.h"                  HAVE_PWD_H)
+check_include_file("sys/mman.h"             HAVE_SYS_MMAN_H)
 check_include_file("sys/select.h"           HAVE_SYS_SELECT_H)
 check_include_file("sys/socket.h"           HAVE_SYS_SOCKET_H)
 check_include_file("sys/time.h"             HAVE_SYS_TIME_H)
@@ -55,6 +56,20 @@ if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
 		}"
 		HAVE_LINUX_IF_BONDING_H
 	)
+	#
+	# AF_XDP capture in dumpcap attaches its XDP program with a
+	# BPF link, which Linux supports for XDP as of 5.9.
+	#
+	check_c_source_compiles(
+		"#include <sys/socket.h>
+		#include <linux/if_xdp.h>
+		#include <linux/bpf.h>
+		int main(void)
+		{
+			return XDP_UMEM_PGOFF_FILL_RING != 0 && BPF_LINK_CREATE != 0 && BPF_XDP != 0;
+		}"
+		HAVE_AF_XDP
+	)
 endif()
 
 #Functions
@@ -101,6 +116,13 @@ if(UNIX)
 	check_symbol_exists("strerrorname_np" "string.h" HAVE_STRERRORNAME_NP)
 	check_symbol_exists("strptime"      "time.h"     HAVE_STRPTIME)
 	check_symbol_exists("vasprintf"     "stdio.h"    HAVE_VASPRINTF)
+	check_symbol_exists("fwrite_unlocked" "stdio.h"  HAVE_FWRITE_UNLOCKED)
+	check_symbol_exists("fallocate"     "fcntl.h"    HAVE_FALLOCATE)
+	check_symbol_exists("fopencookie"   "stdio.h"    HAVE_FOPENCOOKIE)
+	check_symbol_exists("funopen"       "stdio.h"    HAVE_FUNOPEN)
+	check_symbol_exists("shm_open"      "sys/mman.h" HAVE_SHM_OPEN)
+	check_symbol_exists("recvmmsg"      "sys/socket.h" HAVE_RECVMMSG)
+	check_symbol_exists("sched_setaffinity" "sched.h" HAVE_SCHED_SETAFFINITY)
 	cmake_pop_check_state()
 endif()
 
@@ -52,6 +52,7 @@
 #include <errno.h>
 
 #include <wsutil/ws_getopt.h>
+#include <ws_attributes.h>
 
 #include <glib.h>
 
@@ -77,6 +78,7 @@
 
 #include <wsutil/wsgcrypt.h>
 
+#include "ui/clopts_common.h"
 #include "ui/failure_message.h"
 
 /*
@@ -139,6 +141,8 @@ static gboolean cap_order          = TRUE;  /* Report if packets are in chronolo
 
 static gboolean cap_file_hashes    = TRUE;  /* Calculate file hashes */
 
+static guint32 num_threads         = 1;     /* Files to read at the same time */
+
 // Strongest to weakest
 #define HASH_SIZE_SHA256 32
 #define HASH_SIZE_RMD160 20
@@ -147,17 +151,12 @@ static gboolean cap_file_hashes    = TRUE;  /* Calculate file hashes */
 #define HASH_STR_SIZE (65) /* Max hash size * 2 + '\0' */
 #define HASH_BUF_SIZE (1024 * 1024)
 
-
-static gchar file_sha256[HASH_STR_SIZE];
-static gchar file_rmd160[HASH_STR_SIZE];
-static gchar file_sha1[HASH_STR_SIZE];
-
-static char  *hash_buf = NULL;
-static gcry_md_hd_t hd = NULL;
-
-static guint num_ipv4_addresses;
-static guint num_ipv6_addresses;
-static guint num_decryption_secrets;
+/*
+ * The callbacks count these for the file being read on this thread.
+ */
+static WS_THREAD_LOCAL guint num_ipv4_addresses;
+static WS_THREAD_LOCAL guint num_ipv6_addresses;
+static WS_THREAD_LOCAL guint num_decryption_secrets;
 
 /*
  * If we have at least two packets with time stamps, and they're not in
@@ -211,6 +210,14 @@ typedef struct _capture_info {
     GArray               *interface_packet_counts;  /* array of per_packet interface_id counts; one entry per file IDB */
     guint32               pkt_interface_id_unknown; /* counts if packet interface_id didn't match a known one */
     GArray               *idb_info_strings;         /* array of IDB info strings */
+
+    gchar                 file_sha256[HASH_STR_SIZE];
+    gchar                 file_rmd160[HASH_STR_SIZE];
+    gchar                 file_sha1[HASH_STR_SIZE];
+
+    guint                 num_ipv4_addresses;
+    guint                 num_ipv6_addresses;
+    guint                 num_decryption_secrets;
 } capture_info;
 
 static char *decimal_point;
@@ -742,9 +749,9 @@ print_stats(const gchar *filename, capture_info *cf_info)
         }
     }
     if (cap_file_hashes) {
-        printf     ("SHA256:              %s\n", file_sha256);
-        printf     ("RIPEMD160:           %s\n", file_rmd160);
-        printf     ("SHA1:                %s\n", file_sha1);
+        printf     ("SHA256:              %s\n", cf_info->file_sha256);
+        printf     ("RIPEMD160:           %s\n", cf_info->file_rmd160);
+        printf     ("SHA1:                %s\n", cf_info->file_sha1);
     }
     if (cap_order)          printf     ("Strict time order:   %s\n", order_string(cf_info->order));
 
@@ -797,14 +804,14 @@ print_stats(const gchar *filename, capture_info *cf_info)
         }
 
         if (cap_file_nrb) {
-            if (num_ipv4_addresses != 0)
-                printf   ("Number of resolved IPv4 addresses in file: %u\n", num_ipv4_addresses);
-            if (num_ipv6_addresses != 0)
-                printf   ("Number of resolved IPv6 addresses in file: %u\n", num_ipv6_addresses);
+            if (cf_info->num_ipv4_addresses != 0)
+                printf   ("Number of resolved IPv4 addresses in file: %u\n", cf_info->num_ipv4_addresses);
+            if (cf_info->num_ipv6_addresses != 0)
+                printf   ("Number of resolved IPv6 addresses in file: %u\n", cf_info->num_ipv6_addresses);
         }
         if (cap_file_dsb) {
-            if (num_decryption_secrets != 0)
-                printf   ("Number of decryption secrets in file: %u\n", num_decryption_secrets);
+            if (cf_info->num_decryption_secrets != 0)
+                printf   ("Number of decryption secrets in file: %u\n", cf_info->num_decryption_secrets);
         }
     }
 }
@@ -1024,17 +1031,17 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
     if (cap_file_hashes) {
         putsep();
         putquote();
-        printf("%s", file_sha256);
+        printf("%s", cf_info->file_sha256);
         putquote();
 
         putsep();
         putquote();
-        printf("%s", file_rmd160);
+        printf("%s", cf_info->file_rmd160);
         putquote();
 
         putsep();
         putquote();
-        printf("%s", file_sha1);
+        printf("%s", cf_info->file_sha1);
         putquote();
     }
 
@@ -1164,34 +1171,54 @@ hash_to_str(const unsigned char *hash, size_t length, char *str)
     }
 }
 
+/*
+ * Each call has its own hash handle and buffer, so that files can be
+ * hashed on several threads at once.
+ */
 static void
-calculate_hashes(const char *filename)
+calculate_hashes(const char *filename, capture_info *cf_info)
 {
     FILE  *fh;
     size_t hash_bytes;
+    gcry_md_hd_t hd = NULL;
+    char  *hash_buf;
 
-    (void) g_strlcpy(file_sha256, "<unknown>", HASH_STR_SIZE);
-    (void) g_strlcpy(file_rmd160, "<unknown>", HASH_STR_SIZE);
-    (void) g_strlcpy(file_sha1, "<unknown>", HASH_STR_SIZE);
+    (void) g_strlcpy(cf_info->file_sha256, "<unknown>", HASH_STR_SIZE);
+    (void) g_strlcpy(cf_info->file_rmd160, "<unknown>", HASH_STR_SIZE);
+    (void) g_strlcpy(cf_info->file_sha1, "<unknown>", HASH_STR_SIZE);
 
     if (cap_file_hashes) {
+        gcry_md_open(&hd, GCRY_MD_SHA256, 0);
+        if (hd) {
+            gcry_md_enable(hd, GCRY_MD_RMD160);
+            gcry_md_enable(hd, GCRY_MD_SHA1);
+        }
         fh = ws_fopen(filename, "rb");
         if (fh && hd) {
+            hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
             while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
                 gcry_md_write(hd, hash_buf, hash_bytes);
             }
+            g_free(hash_buf);
             gcry_md_final(hd);
-            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, file_sha256);
-            hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, file_rmd160);
-            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, file_sha1);
+            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, cf_info->file_sha256);
+            hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, cf_info->file_rmd160);
+            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, cf_info->file_sha1);
         }
         if (fh) fclose(fh);
-        if (hd) gcry_md_reset(hd);
+        gcry_md_close(hd);
     }
 }
 
+/*
+ * Open and read the file, and fill in cf_info.  Returns 0 on success,
+ * 1 if the information was gathered in spite of an error, and 2 on
+ * failure.  Unless it fails, cf_info->wth is left open for
+ * print_cap_file(); nothing is written to the standard output, so this
+ * can be run for several files at once.
+ */
 static int
-process_cap_file(const char *filename, gboolean need_separator)
+read_cap_file(const char *filename, capture_info *cf_info)
 {
     int                   status = 0;
     int                   err;
@@ -1205,7 +1232,6 @@ process_cap_file(const char *filename, gboolean need_separator)
     guint32               snaplen_max_inferred =          0;
     wtap_rec              rec;
     Buffer                buf;
-    capture_info          cf_info;
     gboolean              have_times = TRUE;
     nstime_t              start_time;
     int                   start_time_tsprec;
@@ -1218,8 +1244,8 @@ process_cap_file(const char *filename, gboolean need_separator)
     guint                 i;
     wtapng_iface_descriptions_t *idb_info;
 
-    cf_info.wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
-    if (!cf_info.wth) {
+    cf_info->wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+    if (!cf_info->wth) {
         cfile_open_failure_message(filename, err, err_info);
         return 2;
     }
@@ -1229,11 +1255,7 @@ process_cap_file(const char *filename, gboolean need_separator)
      * bother calculating them for files that are not known capture types
      * where we wouldn't print them anyway.
      */
-    calculate_hashes(filename);
-
-    if (need_separator && long_report) {
-        printf("\n");
-    }
+    calculate_hashes(filename, cf_info);
 
     nstime_set_zero(&start_time);
     start_time_tsprec = WTAP_TSPREC_UNKNOWN;
@@ -1242,25 +1264,28 @@ process_cap_file(const char *filename, gboolean need_separator)
     nstime_set_zero(&cur_time);
     nstime_set_zero(&prev_time);
 
-    cf_info.encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
+    cf_info->encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
 
-    idb_info = wtap_file_get_idb_info(cf_info.wth);
+    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
     ws_assert(idb_info->interface_data != NULL);
 
-    cf_info.num_interfaces = idb_info->interface_data->len;
-    cf_info.interface_packet_counts  = g_array_sized_new(FALSE, TRUE, sizeof(guint32), cf_info.num_interfaces);
-    g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
-    cf_info.pkt_interface_id_unknown = 0;
+    cf_info->num_interfaces = idb_info->interface_data->len;
+    cf_info->interface_packet_counts  = g_array_sized_new(FALSE, TRUE, sizeof(guint32), cf_info->num_interfaces);
+    g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
+    cf_info->pkt_interface_id_unknown = 0;
 
     g_free(idb_info);
     idb_info = NULL;
 
     /* Register callbacks for new name<->address maps from the file and
        decryption secrets from the file. */
-    wtap_set_cb_new_ipv4(cf_info.wth, count_ipv4_address);
-    wtap_set_cb_new_ipv6(cf_info.wth, count_ipv6_address);
-    wtap_set_cb_new_secrets(cf_info.wth, count_decryption_secret);
+    wtap_set_cb_new_ipv4(cf_info->wth, count_ipv4_address);
+    wtap_set_cb_new_ipv6(cf_info->wth, count_ipv6_address);
+    wtap_set_cb_new_secrets(cf_info->wth, count_decryption_secret);
+
+    /* We only look at the records' metadata, never at the packet data. */
+    wtap_set_skip_packet_data(cf_info->wth, TRUE);
 
     /* Zero out the counters for the callbacks. */
     num_ipv4_addresses = 0;
@@ -1270,7 +1295,7 @@ process_cap_file(const char *filename, gboolean need_separator)
     /* Tally up data that we need to parse through the file to find */
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
-    while (wtap_read(cf_info.wth, &rec, &buf, &err, &err_info, &data_offset))  {
+    while (wtap_read(cf_info->wth, &rec, &buf, &err, &err_info, &data_offset))  {
         if (rec.presence_flags & WTAP_HAS_TS) {
             prev_time = cur_time;
             cur_time = rec.ts;
@@ -1315,7 +1340,7 @@ process_cap_file(const char *filename, gboolean need_separator)
 
             if ((rec.rec_header.packet_header.pkt_encap > 0) &&
                     (rec.rec_header.packet_header.pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
-                cf_info.encap_counts[rec.rec_header.packet_header.pkt_encap] += 1;
+                cf_info->encap_counts[rec.rec_header.packet_header.pkt_encap] += 1;
             } else {
                 fprintf(stderr, "capinfos: Unknown packet encapsulation %d in frame %u of file \"%s\"\n",
                         rec.rec_header.packet_header.pkt_encap, packet, filename);
@@ -1323,37 +1348,37 @@ process_cap_file(const char *filename, gboolean need_separator)
 
             /* Packet interface_id info */
             if (rec.presence_flags & WTAP_HAS_INTERFACE_ID) {
-                /* cf_info.num_interfaces is size, not index, so it's one more than max index */
-                if (rec.rec_header.packet_header.interface_id >= cf_info.num_interfaces) {
+                /* cf_info->num_interfaces is size, not index, so it's one more than max index */
+                if (rec.rec_header.packet_header.interface_id >= cf_info->num_interfaces) {
                     /*
                      * OK, re-fetch the number of interfaces, as there might have
                      * been an interface that was in the middle of packets, and
                      * grow the array to be big enough for the new number of
                      * interfaces.
                      */
-                    idb_info = wtap_file_get_idb_info(cf_info.wth);
+                    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
-                    cf_info.num_interfaces = idb_info->interface_data->len;
-                    g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
+                    cf_info->num_interfaces = idb_info->interface_data->len;
+                    g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
 
                     g_free(idb_info);
                     idb_info = NULL;
                 }
-                if (rec.rec_header.packet_header.interface_id < cf_info.num_interfaces) {
-                    g_array_index(cf_info.interface_packet_counts, guint32,
+                if (rec.rec_header.packet_header.interface_id < cf_info->num_interfaces) {
+                    g_array_index(cf_info->interface_packet_counts, guint32,
                             rec.rec_header.packet_header.interface_id) += 1;
                 }
                 else {
-                    cf_info.pkt_interface_id_unknown += 1;
+                    cf_info->pkt_interface_id_unknown += 1;
                 }
             }
             else {
                 /* it's for interface_id 0 */
-                if (cf_info.num_interfaces != 0) {
-                    g_array_index(cf_info.interface_packet_counts, guint32, 0) += 1;
+                if (cf_info->num_interfaces != 0) {
+                    g_array_index(cf_info->interface_packet_counts, guint32, 0) += 1;
                 }
                 else {
-                    cf_info.pkt_interface_id_unknown += 1;
+                    cf_info->pkt_interface_id_unknown += 1;
                 }
             }
         }
@@ -1363,6 +1388,10 @@ process_cap_file(const char *filename, gboolean need_separator)
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
 
+    cf_info->num_ipv4_addresses = num_ipv4_addresses;
+    cf_info->num_ipv6_addresses = num_ipv6_addresses;
+    cf_info->num_decryption_secrets = num_decryption_secrets;
+
     /*
      * Get IDB info strings.
      * We do this at the end, so we can get information for all IDBs in
@@ -1370,14 +1399,14 @@ process_cap_file(const char *filename, gboolean need_separator)
      * we get, for example, a count of the number of statistics entries
      * for each interface as of the *end* of the file.
      */
-    idb_info = wtap_file_get_idb_info(cf_info.wth);
+    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
-    cf_info.idb_info_strings = g_array_sized_new(FALSE, FALSE, sizeof(gchar*), cf_info.num_interfaces);
-    cf_info.num_interfaces = idb_info->interface_data->len;
-    for (i = 0; i < cf_info.num_interfaces; i++) {
+    cf_info->idb_info_strings = g_array_sized_new(FALSE, FALSE, sizeof(gchar*), cf_info->num_interfaces);
+    cf_info->num_interfaces = idb_info->interface_data->len;
+    for (i = 0; i < cf_info->num_interfaces; i++) {
         const wtap_block_t if_descr = g_array_index(idb_info->interface_data, wtap_block_t, i);
         gchar *s = wtap_get_debug_if_descr(if_descr, 21, "\n");
-        g_array_append_val(cf_info.idb_info_strings, s);
+        g_array_append_val(cf_info->idb_info_strings, s);
     }
 
     g_free(idb_info);
@@ -1394,90 +1423,198 @@ process_cap_file(const char *filename, gboolean need_separator)
             fprintf(stderr,
                     "  (will continue anyway, checksums might be incorrect)\n");
         } else {
-            cleanup_capture_info(&cf_info);
-            wtap_close(cf_info.wth);
+            cleanup_capture_info(cf_info);
+            wtap_close(cf_info->wth);
             return 2;
         }
     }
 
     /* File size */
-    size = wtap_file_size(cf_info.wth, &err);
+    size = wtap_file_size(cf_info->wth, &err);
     if (size == -1) {
         fprintf(stderr,
                 "capinfos: Can't get size of \"%s\": %s.\n",
                 filename, g_strerror(err));
-        cleanup_capture_info(&cf_info);
-        wtap_close(cf_info.wth);
+        cleanup_capture_info(cf_info);
+        wtap_close(cf_info->wth);
         return 2;
     }
 
-    cf_info.filesize = size;
+    cf_info->filesize = size;
 
     /* File Type */
-    cf_info.file_type = wtap_file_type_subtype(cf_info.wth);
-    cf_info.compression_type = wtap_get_compression_type(cf_info.wth);
+    cf_info->file_type = wtap_file_type_subtype(cf_info->wth);
+    cf_info->compression_type = wtap_get_compression_type(cf_info->wth);
 
     /* File Encapsulation */
-    cf_info.file_encap = wtap_file_encap(cf_info.wth);
+    cf_info->file_encap = wtap_file_encap(cf_info->wth);
 
-    cf_info.file_tsprec = wtap_file_tsprec(cf_info.wth);
+    cf_info->file_tsprec = wtap_file_tsprec(cf_info->wth);
 
     /* Packet size limit (snaplen) */
-    cf_info.snaplen = wtap_snapshot_length(cf_info.wth);
-    if (cf_info.snaplen > 0)
-        cf_info.snap_set = TRUE;
+    cf_info->snaplen = wtap_snapshot_length(cf_info->wth);
+    if (cf_info->snaplen > 0)
+        cf_info->snap_set = TRUE;
     else
-        cf_info.snap_set = FALSE;
+        cf_info->snap_set = FALSE;
 
-    cf_info.snaplen_min_inferred = snaplen_min_inferred;
-    cf_info.snaplen_max_inferred = snaplen_max_inferred;
+    cf_info->snaplen_min_inferred = snaplen_min_inferred;
+    cf_info->snaplen_max_inferred = snaplen_max_inferred;
 
     /* # of packets */
-    cf_info.packet_count = packet;
+    cf_info->packet_count = packet;
 
     /* File Times */
-    cf_info.times_known = have_times;
-    cf_info.start_time = start_time;
-    cf_info.start_time_tsprec = start_time_tsprec;
-    cf_info.stop_time = stop_time;
-    cf_info.stop_time_tsprec = stop_time_tsprec;
-    nstime_delta(&cf_info.duration, &stop_time, &start_time);
+    cf_info->times_known = have_times;
+    cf_info->start_time = start_time;
+    cf_info->start_time_tsprec = start_time_tsprec;
+    cf_info->stop_time = stop_time;
+    cf_info->stop_time_tsprec = stop_time_tsprec;
+    nstime_delta(cf_info->duration, &stop_time, &start_time);
     /* Duration precision is the higher of the start and stop time precisions. */
-    if (cf_info.stop_time_tsprec > cf_info.start_time_tsprec)
-        cf_info.duration_tsprec = cf_info.stop_time_tsprec;
+    if (cf_info->stop_time_tsprec > cf_info->start_time_tsprec)
+        cf_info->duration_tsprec = cf_info->stop_time_tsprec;
     else
-        cf_info.duration_tsprec = cf_info.start_time_tsprec;
-    cf_info.know_order = know_order;
-    cf_info.order = order;
+        cf_info->duration_tsprec = cf_info->start_time_tsprec;
+    cf_info->know_order = know_order;
+    cf_info->order = order;
 
     /* Number of packet bytes */
-    cf_info.packet_bytes = bytes;
+    cf_info->packet_bytes = bytes;
 
-    cf_info.data_rate   = 0.0;
-    cf_info.packet_rate = 0.0;
-    cf_info.packet_size = 0.0;
+    cf_info->data_rate   = 0.0;
+    cf_info->packet_rate = 0.0;
+    cf_info->packet_size = 0.0;
 
     if (packet > 0) {
         double delta_time = nstime_to_sec(&stop_time) - nstime_to_sec(&start_time);
         if (delta_time > 0.0) {
-            cf_info.data_rate   = (double)bytes  / delta_time; /* Data rate per second */
-            cf_info.packet_rate = (double)packet / delta_time; /* packet rate per second */
+            cf_info->data_rate   = (double)bytes  / delta_time; /* Data rate per second */
+            cf_info->packet_rate = (double)packet / delta_time; /* packet rate per second */
         }
-        cf_info.packet_size = (double)bytes / packet;                  /* Avg packet size      */
+        cf_info->packet_size = (double)bytes / packet;                  /* Avg packet size      */
+    }
+
+    return status;
+}
+
+/*
+ * Print what read_cap_file() found, and close the file.
+ */
+static void
+print_cap_file(const char *filename, capture_info *cf_info, gboolean need_separator)
+{
+    if (need_separator && long_report) {
+        printf("\n");
     }
 
     if (long_report) {
-        print_stats(filename, &cf_info);
+        print_stats(filename, cf_info);
     } else {
-        print_stats_table(filename, &cf_info);
+        print_stats_table(filename, cf_info);
     }
 
-    cleanup_capture_info(&cf_info);
-    wtap_close(cf_info.wth);
+    cleanup_capture_info(cf_info);
+    wtap_close(cf_info->wth);
+}
+
+static int
+process_cap_file(const char *filename, gboolean need_separator)
+{
+    capture_info cf_info;
+    int          status;
 
+    status = read_cap_file(filename, &cf_info);
+    if (status != 2) {
+        print_cap_file(filename, &cf_info, need_separator);
+    }
     return status;
 }
 
+/*
+ * A file being read by one of the -j threads.
+ */
+typedef struct {
+    const char   *filename;
+    capture_info  cf_info;
+    int           status;
+    gboolean      done;
+} file_job_t;
+
+static GMutex file_jobs_mutex;
+static GCond  file_jobs_cond;
+
+static void
+read_file_job(gpointer data, gpointer user_data _U_)
+{
+    file_job_t *job = (file_job_t *)data;
+
+    job->status = read_cap_file(job->filename, &job->cf_info);
+
+    g_mutex_lock(&file_jobs_mutex);
+    job->done = TRUE;
+    g_cond_broadcast(&file_jobs_cond);
+    g_mutex_unlock(&file_jobs_mutex);
+}
+
+/*
+ * Read the files on num_threads threads, and print what was found in
+ * the order in which they were given.  No more than two files per
+ * thread are read ahead of the one being printed, so that we don't
+ * have every file open at once.
+ */
+static int
+process_cap_files_in_parallel(char **filenames, int num_files)
+{
+    GThreadPool *pool;
+    file_job_t  *jobs;
+    int          next_job = 0;
+    int          i;
+    int          overall_error_status = 0;
+    gboolean     need_separator = FALSE;
+
+    jobs = g_new0(file_job_t, num_files);
+    pool = g_thread_pool_new(read_file_job, NULL, (gint)num_threads, TRUE, NULL);
+
+    for (i = 0; i < num_files; i++) {
+        while (next_job < num_files && next_job < i + 2 * (int)num_threads) {
+            jobs[next_job].filename = filenames[next_job];
+            g_thread_pool_push(pool, &jobs[next_job], NULL);
+            next_job++;
+        }
+
+        g_mutex_lock(&file_jobs_mutex);
+        while (!jobs[i].done)
+            g_cond_wait(&file_jobs_cond, &file_jobs_mutex);
+        g_mutex_unlock(&file_jobs_mutex);
+
+        if (jobs[i].status != 2) {
+            print_cap_file(jobs[i].filename, &jobs[i].cf_info, need_separator);
+            need_separator = TRUE;
+        }
+        if (jobs[i].status) {
+            overall_error_status = jobs[i].status;
+            if (stop_after_failure)
+                break;
+        }
+    }
+
+    /*
+     * If we stopped early, drop the files that haven't been started,
+     * wait for the ones that have, and close them.
+     */
+    g_thread_pool_free(pool, TRUE, TRUE);
+    for (i++; i < next_job; i++) {
+        if (jobs[i].done && jobs[i].status != 2) {
+            cleanup_capture_info(&jobs[i].cf_info);
+            wtap_close(jobs[i].cf_info.wth);
+        }
+    }
+    g_free(jobs);
+
+    return overall_error_status;
+}
+
 static void
 print_usage(FILE *output)
 {
@@ -1536,6 +1673,7 @@ print_usage(FILE *output)
     fprintf(output, "  -h, --help               display this help and exit\n");
     fprintf(output, "  -v, --version            display version info and exit\n");
     fprintf(output, "  -C cancel processing if file open fails (default is to continue)\n");
+    fprintf(output, "  -j <n> read up to <n> files at the same time (default is 1)\n");
     fprintf(output, "  -A generate all infos (default)\n");
     fprintf(output, "  -K disable displaying the capture comment\n");
     fprintf(output, "\n");
@@ -1646,7 +1784,7 @@ main(int argc, char *argv[])
     wtap_init(TRUE);
 
     /* Process the options */
-    while ((opt = ws_getopt_long(argc, argv, "abcdehiklmnoqrstuvxyzABCDEFHIKLMNQRST", long_options, NULL)) !=-1) {
+    while ((opt = ws_getopt_long(argc, argv, "abcdehij:klmnoqrstuvxyzABCDEFHIKLMNQRST", long_options, NULL)) !=-1) {
 
         switch (opt) {
 
@@ -1762,6 +1900,10 @@ main(int argc, char *argv[])
                 stop_after_failure = TRUE;
                 break;
 
+            case 'j':
+                num_threads = get_nonzero_guint32(ws_optarg, "number of threads");
+                break;
+
             case 'A':
                 enable_all_infos();
                 break;
@@ -1841,16 +1983,15 @@ main(int argc, char *argv[])
 
     if (cap_file_hashes) {
         gcry_check_version(NULL);
-        gcry_md_open(&hd, GCRY_MD_SHA256, 0);
-        if (hd) {
-            gcry_md_enable(hd, GCRY_MD_RMD160);
-            gcry_md_enable(hd, GCRY_MD_SHA1);
-        }
-        hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
     }
 
     overall_error_status = 0;
 
+    if (num_threads > 1 && argc - ws_optind > 1) {
+        overall_error_status = process_cap_files_in_parallel(&argv[ws_optind], argc - ws_optind);
+        goto exit;
+    }
+
     for (opt = ws_optind; opt < argc; opt++) {
 
         status = process_cap_file(argv[opt], need_separator);
@@ -1871,8 +2012,6 @@ main(int argc, char *argv[])
     }
 
 exit:
-    g_free(hash_buf);
-    gcry_md_close(hd);
     wtap_cleanup();
     free_progdirs();
     return overall_error_status;
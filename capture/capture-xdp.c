@@ -0,0 +1,445 @@
+/* capture-xdp.c
+ * Capturing from Linux AF_XDP sockets
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include "capture/capture-xdp.h"
+
+#ifdef HAVE_AF_XDP
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#include <linux/bpf.h>
+#include <linux/ethtool.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <linux/sockios.h>
+
+#ifndef AF_XDP
+#define AF_XDP  44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+/*
+ * Each queue's UMEM has XDP_NUM_FRAMES frames of XDP_FRAME_SIZE bytes,
+ * which is enough for a standard MTU; all of them start out on the
+ * fill ring, so the fill and receive rings have room for all of them.
+ */
+#define XDP_FRAME_SIZE          4096
+#define XDP_NUM_FRAMES          4096
+#define XDP_COMP_RING_SIZE      64
+
+typedef struct {
+    guint32    *producer;
+    guint32    *consumer;
+    void       *desc;
+    guint32     mask;
+    void       *map;
+    size_t      map_size;
+} xdp_ring;
+
+typedef struct {
+    int         fd;
+    guint8     *umem;
+    xdp_ring    rx;
+    xdp_ring    fill;
+    xdp_ring    comp;
+    guint32     rx_seen;        /* Receive ring index up to which xdp_capture_poll_rx() has reported */
+} xdp_queue;
+
+struct _xdp_capture {
+    unsigned int ifindex;
+    int          map_fd;        /* XSKMAP of the queues' sockets */
+    int          prog_fd;
+    int          link_fd;       /* Attachment of prog_fd to the interface */
+    guint        queue_count;
+    xdp_queue   *queues;
+};
+
+static int
+sys_bpf(int cmd, union bpf_attr *attr)
+{
+    return (int)syscall(__NR_bpf, cmd, attr, sizeof *attr);
+}
+
+/*
+ * Number of receive queues of the interface; 1 if the driver doesn't
+ * say.
+ */
+static guint
+xdp_get_queue_count(const char *ifname)
+{
+    struct ethtool_channels channels;
+    struct ifreq ifr;
+    int fd;
+    guint count = 1;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return count;
+    memset(&channels, 0, sizeof channels);
+    channels.cmd = ETHTOOL_GCHANNELS;
+    memset(&ifr, 0, sizeof ifr);
+    g_strlcpy(ifr.ifr_name, ifname, sizeof ifr.ifr_name);
+    ifr.ifr_data = (char *)&channels;
+    if (ioctl(fd, SIOCETHTOOL, &ifr) == 0 &&
+        channels.combined_count + channels.rx_count > 0) {
+        count = channels.combined_count + channels.rx_count;
+    }
+    close(fd);
+    return count;
+}
+
+static gboolean
+xdp_map_ring(int fd, xdp_ring *ring, const struct xdp_ring_offset *off,
+             guint32 entries, size_t entry_size, off_t pgoff)
+{
+    guint8 *map;
+
+    ring->map_size = off->desc + entries * entry_size;
+    map = (guint8 *)mmap(NULL, ring->map_size, PROT_READ|PROT_WRITE,
+                         MAP_SHARED|MAP_POPULATE, fd, pgoff);
+    if (map == MAP_FAILED)
+        return FALSE;
+    ring->map = map;
+    ring->producer = (guint32 *)(map + off->producer);
+    ring->consumer = (guint32 *)(map + off->consumer);
+    ring->desc = map + off->desc;
+    ring->mask = entries - 1;
+    return TRUE;
+}
+
+static gboolean
+xdp_open_queue(xdp_capture *xc, guint queue_id, char *errmsg, size_t errmsg_len)
+{
+    xdp_queue *queue = &xc->queues[queue_id];
+    struct xdp_umem_reg mr;
+    struct xdp_mmap_offsets off;
+    struct sockaddr_xdp sxdp;
+    socklen_t optlen;
+    int entries = XDP_NUM_FRAMES;
+    int comp_entries = XDP_COMP_RING_SIZE;
+    guint64 *fill;
+    guint32 i;
+
+    queue->fd = socket(AF_XDP, SOCK_RAW, 0);
+    if (queue->fd < 0) {
+        snprintf(errmsg, errmsg_len, "Can't create AF_XDP socket: %s", g_strerror(errno));
+        return FALSE;
+    }
+
+    queue->umem = (guint8 *)mmap(NULL, (size_t)XDP_NUM_FRAMES * XDP_FRAME_SIZE,
+                                 PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (queue->umem == MAP_FAILED) {
+        queue->umem = NULL;
+        snprintf(errmsg, errmsg_len, "Can't allocate UMEM: %s", g_strerror(errno));
+        return FALSE;
+    }
+    memset(&mr, 0, sizeof mr);
+    mr.addr = (guint64)(uintptr_t)queue->umem;
+    mr.len = (guint64)XDP_NUM_FRAMES * XDP_FRAME_SIZE;
+    mr.chunk_size = XDP_FRAME_SIZE;
+    mr.headroom = 0;
+    if (setsockopt(queue->fd, SOL_XDP, XDP_UMEM_REG, &mr, sizeof mr) < 0 ||
+        setsockopt(queue->fd, SOL_XDP, XDP_UMEM_FILL_RING, &entries, sizeof entries) < 0 ||
+        setsockopt(queue->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &comp_entries, sizeof comp_entries) < 0 ||
+        setsockopt(queue->fd, SOL_XDP, XDP_RX_RING, &entries, sizeof entries) < 0) {
+        snprintf(errmsg, errmsg_len, "Can't set up AF_XDP rings: %s", g_strerror(errno));
+        return FALSE;
+    }
+
+    optlen = sizeof off;
+    if (getsockopt(queue->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0 ||
+        !xdp_map_ring(queue->fd, &queue->rx, &off.rx, XDP_NUM_FRAMES,
+                      sizeof (struct xdp_desc), XDP_PGOFF_RX_RING) ||
+        !xdp_map_ring(queue->fd, &queue->fill, &off.fr, XDP_NUM_FRAMES,
+                      sizeof (guint64), XDP_UMEM_PGOFF_FILL_RING) ||
+        !xdp_map_ring(queue->fd, &queue->comp, &off.cr, XDP_COMP_RING_SIZE,
+                      sizeof (guint64), XDP_UMEM_PGOFF_COMPLETION_RING)) {
+        snprintf(errmsg, errmsg_len, "Can't map AF_XDP rings: %s", g_strerror(errno));
+        return FALSE;
+    }
+
+    /* Hand all the frames to the kernel. */
+    fill = (guint64 *)queue->fill.desc;
+    for (i = 0; i < XDP_NUM_FRAMES; i++)
+        fill[i] = (guint64)i * XDP_FRAME_SIZE;
+    g_atomic_int_set((gint *)queue->fill.producer, XDP_NUM_FRAMES);
+
+    /* Use zero-copy mode if the driver supports it. */
+    memset(&sxdp, 0, sizeof sxdp);
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = xc->ifindex;
+    sxdp.sxdp_queue_id = queue_id;
+    sxdp.sxdp_flags = XDP_ZEROCOPY;
+    if (bind(queue->fd, (struct sockaddr *)&sxdp, sizeof sxdp) < 0) {
+        sxdp.sxdp_flags = XDP_COPY;
+        if (bind(queue->fd, (struct sockaddr *)&sxdp, sizeof sxdp) < 0) {
+            snprintf(errmsg, errmsg_len, "Can't bind AF_XDP socket to queue %u: %s",
+                     queue_id, g_strerror(errno));
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * Load the program that redirects each packet to the socket for its
+ * receive queue:
+ *
+ *   return bpf_redirect_map(&xsks, ctx->rx_queue_index, XDP_PASS);
+ *
+ * and attach it to the interface, natively if the driver supports it.
+ */
+static gboolean
+xdp_attach_program(xdp_capture *xc, char *errmsg, size_t errmsg_len)
+{
+    struct bpf_insn insns[] = {
+        /* r2 = ctx->rx_queue_index */
+        { BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1,
+          offsetof(struct xdp_md, rx_queue_index), 0 },
+        /* r1 = xsks */
+        { BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, xc->map_fd },
+        { 0, 0, 0, 0, 0 },
+        /* r3 = XDP_PASS, for packets on queues without a socket */
+        { BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS },
+        { BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map },
+        { BPF_JMP | BPF_EXIT, 0, 0, 0, 0 },
+    };
+    static const char license[] = "GPL";
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof attr);
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (guint64)(uintptr_t)insns;
+    attr.insn_cnt = G_N_ELEMENTS(insns);
+    attr.license = (guint64)(uintptr_t)license;
+    xc->prog_fd = sys_bpf(BPF_PROG_LOAD, &attr);
+    if (xc->prog_fd < 0) {
+        snprintf(errmsg, errmsg_len, "Can't load XDP program: %s", g_strerror(errno));
+        return FALSE;
+    }
+
+    memset(&attr, 0, sizeof attr);
+    attr.link_create.prog_fd = xc->prog_fd;
+    attr.link_create.target_ifindex = xc->ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = XDP_FLAGS_DRV_MODE;
+    xc->link_fd = sys_bpf(BPF_LINK_CREATE, &attr);
+    if (xc->link_fd < 0) {
+        attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+        xc->link_fd = sys_bpf(BPF_LINK_CREATE, &attr);
+    }
+    if (xc->link_fd < 0) {
+        snprintf(errmsg, errmsg_len, "Can't attach XDP program: %s", g_strerror(errno));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+xdp_capture *
+xdp_capture_open(const char *ifname, char *errmsg, size_t errmsg_len)
+{
+    xdp_capture *xc;
+    union bpf_attr attr;
+    guint i;
+
+    xc = g_new0(xdp_capture, 1);
+    xc->map_fd = -1;
+    xc->prog_fd = -1;
+    xc->link_fd = -1;
+
+    xc->ifindex = if_nametoindex(ifname);
+    if (xc->ifindex == 0) {
+        snprintf(errmsg, errmsg_len, "No such interface %s", ifname);
+        goto fail;
+    }
+
+    xc->queue_count = xdp_get_queue_count(ifname);
+    xc->queues = g_new0(xdp_queue, xc->queue_count);
+    for (i = 0; i < xc->queue_count; i++)
+        xc->queues[i].fd = -1;
+
+    memset(&attr, 0, sizeof attr);
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof (guint32);
+    attr.value_size = sizeof (guint32);
+    attr.max_entries = xc->queue_count;
+    xc->map_fd = sys_bpf(BPF_MAP_CREATE, &attr);
+    if (xc->map_fd < 0) {
+        snprintf(errmsg, errmsg_len, "Can't create XSKMAP: %s", g_strerror(errno));
+        goto fail;
+    }
+
+    for (i = 0; i < xc->queue_count; i++) {
+        guint32 key = i;
+        guint32 value;
+
+        if (!xdp_open_queue(xc, i, errmsg, errmsg_len))
+            goto fail;
+        value = (guint32)xc->queues[i].fd;
+        memset(&attr, 0, sizeof attr);
+        attr.map_fd = xc->map_fd;
+        attr.key = (guint64)(uintptr_t)&key;
+        attr.value = (guint64)(uintptr_t)&value;
+        if (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+            snprintf(errmsg, errmsg_len, "Can't add AF_XDP socket to XSKMAP: %s",
+                     g_strerror(errno));
+            goto fail;
+        }
+    }
+
+    if (!xdp_attach_program(xc, errmsg, errmsg_len))
+        goto fail;
+    return xc;
+
+fail:
+    xdp_capture_close(xc);
+    return NULL;
+}
+
+static void
+xdp_unmap_ring(xdp_ring *ring)
+{
+    if (ring->map != NULL)
+        munmap(ring->map, ring->map_size);
+}
+
+void
+xdp_capture_close(xdp_capture *xc)
+{
+    guint i;
+
+    /* Closing the link detaches the program. */
+    if (xc->link_fd >= 0)
+        close(xc->link_fd);
+    if (xc->prog_fd >= 0)
+        close(xc->prog_fd);
+    if (xc->map_fd >= 0)
+        close(xc->map_fd);
+    for (i = 0; i < xc->queue_count; i++) {
+        xdp_queue *queue = &xc->queues[i];
+
+        xdp_unmap_ring(&queue->rx);
+        xdp_unmap_ring(&queue->fill);
+        xdp_unmap_ring(&queue->comp);
+        if (queue->fd >= 0)
+            close(queue->fd);
+        if (queue->umem != NULL)
+            munmap(queue->umem, (size_t)XDP_NUM_FRAMES * XDP_FRAME_SIZE);
+    }
+    g_free(xc->queues);
+    g_free(xc);
+}
+
+guint
+xdp_capture_queue_count(xdp_capture *xc)
+{
+    return xc->queue_count;
+}
+
+guint
+xdp_capture_ring_size(xdp_capture *xc _U_)
+{
+    return XDP_NUM_FRAMES;
+}
+
+int
+xdp_capture_fd(xdp_capture *xc, guint queue)
+{
+    return xc->queues[queue].fd;
+}
+
+guint32
+xdp_capture_poll_rx(xdp_capture *xc, guint queue, guint32 *first)
+{
+    xdp_queue *q = &xc->queues[queue];
+    guint32 producer = (guint32)g_atomic_int_get((gint *)q->rx.producer);
+    guint32 count = producer - q->rx_seen;
+
+    *first = q->rx_seen;
+    q->rx_seen = producer;
+    return count;
+}
+
+const guint8 *
+xdp_capture_rx_packet(xdp_capture *xc, guint queue, guint32 idx, guint32 *len)
+{
+    xdp_queue *q = &xc->queues[queue];
+    const struct xdp_desc *desc = &((const struct xdp_desc *)q->rx.desc)[idx & q->rx.mask];
+
+    *len = desc->len;
+    return q->umem + desc->addr;
+}
+
+void
+xdp_capture_rx_release(xdp_capture *xc, guint queue, guint32 count)
+{
+    xdp_queue *q = &xc->queues[queue];
+    const struct xdp_desc *rx = (const struct xdp_desc *)q->rx.desc;
+    guint64 *fill = (guint64 *)q->fill.desc;
+    guint32 consumer = *q->rx.consumer;
+    guint32 producer = *q->fill.producer;
+    guint32 i;
+
+    /*
+     * Every frame is on the fill ring, on the receive ring or with us,
+     * and the fill ring has room for all of them, so this can't
+     * overflow it.
+     */
+    for (i = 0; i < count; i++) {
+        fill[(producer + i) & q->fill.mask] =
+            rx[(consumer + i) & q->rx.mask].addr & ~((guint64)XDP_FRAME_SIZE - 1);
+    }
+    g_atomic_int_set((gint *)q->fill.producer, producer + count);
+    g_atomic_int_set((gint *)q->rx.consumer, consumer + count);
+}
+
+guint64
+xdp_capture_drops(xdp_capture *xc)
+{
+    guint64 drops = 0;
+    guint i;
+
+    for (i = 0; i < xc->queue_count; i++) {
+        struct xdp_statistics stats;
+        socklen_t optlen = sizeof stats;
+
+        if (getsockopt(xc->queues[i].fd, SOL_XDP, XDP_STATISTICS, &stats, &optlen) == 0)
+            drops += stats.rx_dropped + stats.rx_ring_full;
+    }
+    return drops;
+}
+
+#endif /* HAVE_AF_XDP */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,92 @@
+/** @file
+ *
+ * Capturing from Linux AF_XDP sockets
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#ifndef __CAPTURE_XDP_H__
+#define __CAPTURE_XDP_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#ifdef HAVE_AF_XDP
+
+/*
+ * An interface being captured from with one AF_XDP socket per receive
+ * queue, and an XDP program that redirects every packet the interface
+ * receives to the socket of its queue.  Packets are received straight
+ * into each socket's UMEM, and read from there in place.
+ *
+ * Each queue's receive ring is meant to be read by two threads: one
+ * that waits for packets and finds out which have arrived, with
+ * xdp_capture_poll_rx(), and one that reads them with
+ * xdp_capture_rx_packet() and gives them back to the kernel, in the
+ * order they arrived, with xdp_capture_rx_release().
+ */
+typedef struct _xdp_capture xdp_capture;
+
+/**
+ * Start capturing from all receive queues of ifname.  Returns NULL
+ * and puts a message in errmsg on failure.
+ */
+xdp_capture *xdp_capture_open(const char *ifname, char *errmsg, size_t errmsg_len);
+
+/** Stop capturing, and detach the XDP program. */
+void xdp_capture_close(xdp_capture *xc);
+
+/** Number of receive queues, each with its own socket. */
+guint xdp_capture_queue_count(xdp_capture *xc);
+
+/** Number of entries in each socket's receive ring. */
+guint xdp_capture_ring_size(xdp_capture *xc);
+
+/** File descriptor of queue's socket, to poll() for packets. */
+int xdp_capture_fd(xdp_capture *xc, guint queue);
+
+/**
+ * Returns the number of packets that have arrived on queue since the
+ * last call, and sets *first to the ring index of the first of them.
+ */
+guint32 xdp_capture_poll_rx(xdp_capture *xc, guint queue, guint32 *first);
+
+/** Returns the data of the packet at ring index idx of queue. */
+const guint8 *xdp_capture_rx_packet(xdp_capture *xc, guint queue, guint32 idx,
+                                    guint32 *len);
+
+/** Give the count oldest packets of queue back to the kernel. */
+void xdp_capture_rx_release(xdp_capture *xc, guint queue, guint32 count);
+
+/**
+ * Number of packets dropped because a receive ring was full or the
+ * kernel had no free UMEM frame for them.
+ */
+guint64 xdp_capture_drops(xdp_capture *xc);
+
+#endif /* HAVE_AF_XDP */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __CAPTURE_XDP_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
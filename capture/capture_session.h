@@ -99,6 +99,7 @@ struct _capture_session {
 #endif
     gboolean  session_will_restart;       /**< Set when session will restart */
     guint32   count;                      /**< Total number of frames captured */
+    int       pending_records;            /**< Records written by the child that we haven't read yet */
     capture_options *capture_opts;        /**< options for this capture */
     capture_file *cf;                     /**< handle to cfile */
     wtap_rec rec;                         /**< record we're reading packet metadata into */
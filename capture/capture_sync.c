@@ -85,6 +85,7 @@
 #include <wsutil/filesystem.h>
 #include <wsutil/file_util.h>
 #include <wsutil/report_message.h>
+#include <wsutil/shm_ring.h>
 #include "extcap.h"
 
 #ifdef _WIN32
@@ -136,6 +137,7 @@ capture_session_init(capture_session *cap_session, capture_file *cf,
     cap_session->group                           = getgid();
 #endif
     cap_session->count                           = 0;
+    cap_session->pending_records                 = 0;
     cap_session->session_will_restart            = FALSE;
 
     cap_session->new_file                        = new_file;
@@ -336,6 +338,10 @@ sync_pipe_start(capture_options *capture_opts, GPtrArray *capture_comments,
             argv = sync_pipe_add_arg(argv, &argc, capture_opts->temp_dir);
     }
 
+    if (capture_opts->live_shm && !capture_opts->multi_files_on) {
+        argv = sync_pipe_add_arg(argv, &argc, "--live-shm");
+    }
+
     if (capture_opts->multi_files_on) {
         if (capture_opts->has_autostop_filesize) {
             char sfilesize[ARGV_NUMBER_LEN];
@@ -1878,6 +1884,10 @@ sync_pipe_input_cb(GIOChannel *pipe_io, capture_session *cap_session)
         cap_session->drops(cap_session, num, name);
         break;
         }
+    case SP_STATS:
+        /* dumpcap --stats-interval; we just pass them on to the log */
+        ws_info("Capture statistics: %s", buffer);
+        break;
     default:
         ws_assert_not_reached();
     }
@@ -2205,6 +2215,39 @@ sync_pipe_kill(ws_process_id fork_child)
     }
 }
 
+
+/* read the capture file we've just opened from the shared memory ring
+   the capture child is copying it to, if it's doing so */
+void
+sync_pipe_attach_live_ring(capture_session *cap_session)
+{
+#ifndef _WIN32
+    capture_file *cf = (capture_file *)cap_session->cf;
+    ws_shm_ring *ring;
+    char *name;
+    int err;
+
+    if (!cap_session->capture_opts->live_shm ||
+        cap_session->capture_opts->multi_files_on ||
+        cap_session->fork_child == WS_INVALID_PID ||
+        cf->provider.wth == NULL)
+        return;
+
+    name = ws_shm_ring_capture_name((long)cap_session->fork_child);
+    ring = ws_shm_ring_open(name, &err);
+    if (ring != NULL) {
+        wtap_set_live_ring(cf->provider.wth, ring);
+    } else {
+        /* We just read it from the file, as usual. */
+        ws_debug("Can't open %s: %s", name, g_strerror(err));
+    }
+    g_free(name);
+#else
+    (void)cap_session;
+#endif
+}
+
+
 void capture_sync_set_fetch_dumpcap_pid_cb(void(*cb)(ws_process_id pid)) {
     fetch_dumpcap_pid = cb;
 }
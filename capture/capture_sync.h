@@ -55,6 +55,11 @@ sync_pipe_stop(capture_session *cap_session);
 extern void
 sync_pipe_kill(ws_process_id fork_child);
 
+/** Read the capture file we've just opened from shared memory, if the
+ *  capture child is sharing it there (--live-shm) */
+extern void
+sync_pipe_attach_live_ring(capture_session *cap_session);
+
 /**
  * Set wireless channel using dumpcap
  *  On success, *data points to a buffer containing the dumpcap output,
@@ -0,0 +1,283 @@
+/* flow-snaplen.c
+ * Per-flow snapshot lengths for captured packets
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include "capture/flow-snaplen.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <wsutil/pint.h>
+
+/* Number of entries in the flow table; must be a power of 2 */
+#define FLOW_TABLE_SIZE     65536
+
+#define ETHERTYPE_IPv4      0x0800
+#define ETHERTYPE_IPv6      0x86DD
+#define ETHERTYPE_VLAN      0x8100
+#define ETHERTYPE_QINQ      0x88A8
+#define ETHERTYPE_QINQ_OLD  0x9100
+
+#define IP_PROTO_HOPOPTS    0
+#define IP_PROTO_TCP        6
+#define IP_PROTO_UDP        17
+#define IP_PROTO_ROUTING    43
+#define IP_PROTO_FRAGMENT   44
+#define IP_PROTO_DSTOPTS    60
+
+#define TCP_FLAG_SYN        0x02
+#define TCP_FLAG_ACK        0x10
+
+typedef struct {
+    guint8  addr[2][16];    /**< IPv4 addresses are in the first 4 bytes */
+    guint16 port[2];
+    guint8  proto;
+    guint8  in_use;
+    guint32 packets;        /**< Packets seen in the flow */
+} flow_entry;
+
+struct _flow_snaplen {
+    guint32     full_packets;
+    guint32     payload_bytes;
+    flow_entry *table;
+};
+
+flow_snaplen *
+flow_snaplen_new(guint32 full_packets, guint32 payload_bytes)
+{
+    flow_snaplen *fs = g_new(flow_snaplen, 1);
+
+    fs->full_packets = full_packets;
+    fs->payload_bytes = payload_bytes;
+    fs->table = g_new0(flow_entry, FLOW_TABLE_SIZE);
+    return fs;
+}
+
+void
+flow_snaplen_free(flow_snaplen *fs)
+{
+    if (fs == NULL)
+        return;
+    g_free(fs->table);
+    g_free(fs);
+}
+
+/*
+ * Find the network-layer header; returns FALSE if the link-layer type
+ * isn't one we know, or the packet isn't IPv4 or IPv6.
+ */
+static gboolean
+flow_snaplen_network(int linktype, const guint8 *pd, guint32 caplen,
+                     guint32 *offset, gboolean *ipv6)
+{
+    guint32 off;
+    guint16 ethertype;
+    guint32 family;
+
+    switch (linktype) {
+
+    case 1:     /* DLT_EN10MB */
+        off = 12;
+        if (caplen < off + 2)
+            return FALSE;
+        ethertype = pntoh16(pd + off);
+        while (ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_QINQ ||
+               ethertype == ETHERTYPE_QINQ_OLD) {
+            off += 4;
+            if (caplen < off + 2)
+                return FALSE;
+            ethertype = pntoh16(pd + off);
+        }
+        off += 2;
+        break;
+
+    case 113:   /* DLT_LINUX_SLL */
+        if (caplen < 16)
+            return FALSE;
+        ethertype = pntoh16(pd + 14);
+        off = 16;
+        break;
+
+    case 276:   /* DLT_LINUX_SLL2 */
+        if (caplen < 20)
+            return FALSE;
+        ethertype = pntoh16(pd);
+        off = 20;
+        break;
+
+    case 0:     /* DLT_NULL */
+    case 108:   /* DLT_LOOP */
+        if (caplen < 4)
+            return FALSE;
+        /* DLT_NULL is in the byte order of the host that wrote it. */
+        family = linktype == 108 ? pntoh32(pd) : pletoh32(pd);
+        if (linktype == 0 && (family & 0xFFFF0000) != 0)
+            family = pntoh32(pd);
+        off = 4;
+        if (family == 2)
+            ethertype = ETHERTYPE_IPv4;
+        else if (family == 10 || family == 24 || family == 28 || family == 30)
+            ethertype = ETHERTYPE_IPv6;     /* Linux, BSDs, macOS */
+        else
+            return FALSE;
+        break;
+
+    case 12:    /* DLT_RAW */
+    case 14:    /* DLT_RAW on OpenBSD */
+    case 101:   /* LINKTYPE_RAW */
+        if (caplen < 1)
+            return FALSE;
+        off = 0;
+        ethertype = (pd[0] >> 4) == 6 ? ETHERTYPE_IPv6 : ETHERTYPE_IPv4;
+        break;
+
+    case 228:   /* DLT_IPV4 */
+        off = 0;
+        ethertype = ETHERTYPE_IPv4;
+        break;
+
+    case 229:   /* DLT_IPV6 */
+        off = 0;
+        ethertype = ETHERTYPE_IPv6;
+        break;
+
+    default:
+        return FALSE;
+    }
+
+    if (ethertype == ETHERTYPE_IPv4)
+        *ipv6 = FALSE;
+    else if (ethertype == ETHERTYPE_IPv6)
+        *ipv6 = TRUE;
+    else
+        return FALSE;
+    *offset = off;
+    return TRUE;
+}
+
+static guint32
+flow_snaplen_hash(const flow_entry *key)
+{
+    const guint8 *p = (const guint8 *)key;
+    guint32 hash = 2166136261U;
+    size_t i;
+
+    /* FNV-1a, over everything but the packet count */
+    for (i = 0; i < offsetof(flow_entry, packets); i++) {
+        hash ^= p[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+guint32
+flow_snaplen_caplen(flow_snaplen *fs, int linktype, const guint8 *pd,
+                    guint32 caplen)
+{
+    flow_entry key, *entry;
+    guint32 off, header_len, keep;
+    gboolean ipv6, syn = FALSE;
+    guint8 proto;
+
+    if (!flow_snaplen_network(linktype, pd, caplen, &off, &ipv6))
+        return caplen;
+
+    memset(&key, 0, sizeof key);
+    if (!ipv6) {
+        if (caplen < off + 20 || (pd[off] >> 4) != 4)
+            return caplen;
+        /* Only the first fragment has the TCP or UDP header. */
+        if ((pntoh16(pd + off + 6) & 0x1FFF) != 0)
+            return caplen;
+        proto = pd[off + 9];
+        memcpy(key.addr[0], pd + off + 12, 4);
+        memcpy(key.addr[1], pd + off + 16, 4);
+        off += (pd[off] & 0x0F) * 4;
+    } else {
+        if (caplen < off + 40 || (pd[off] >> 4) != 6)
+            return caplen;
+        proto = pd[off + 6];
+        memcpy(key.addr[0], pd + off + 8, 16);
+        memcpy(key.addr[1], pd + off + 24, 16);
+        off += 40;
+        /* Skip the extension headers that can come before TCP or UDP. */
+        while (proto == IP_PROTO_HOPOPTS || proto == IP_PROTO_ROUTING ||
+               proto == IP_PROTO_DSTOPTS || proto == IP_PROTO_FRAGMENT) {
+            if (caplen < off + 8)
+                return caplen;
+            if (proto == IP_PROTO_FRAGMENT) {
+                if ((pntoh16(pd + off + 2) & 0xFFF8) != 0)
+                    return caplen;
+                proto = pd[off];
+                off += 8;
+            } else {
+                proto = pd[off];
+                off += (pd[off + 1] + 1) * 8;
+            }
+        }
+    }
+
+    if (proto == IP_PROTO_TCP) {
+        if (caplen < off + 20)
+            return caplen;
+        header_len = (pd[off + 12] >> 4) * 4;
+        syn = (pd[off + 13] & (TCP_FLAG_SYN|TCP_FLAG_ACK)) == TCP_FLAG_SYN;
+    } else if (proto == IP_PROTO_UDP) {
+        header_len = 8;
+    } else {
+        return caplen;
+    }
+    if (caplen < off + 4)
+        return caplen;
+    key.port[0] = pntoh16(pd + off);
+    key.port[1] = pntoh16(pd + off + 2);
+    key.proto = proto;
+    key.in_use = 1;
+
+    /* Both directions of the flow have the same key. */
+    if (key.port[0] > key.port[1] ||
+        (key.port[0] == key.port[1] && memcmp(key.addr[0], key.addr[1], 16) > 0)) {
+        guint8 addr[16];
+        guint16 port;
+
+        memcpy(addr, key.addr[0], 16);
+        memcpy(key.addr[0], key.addr[1], 16);
+        memcpy(key.addr[1], addr, 16);
+        port = key.port[0];
+        key.port[0] = key.port[1];
+        key.port[1] = port;
+    }
+
+    entry = &fs->table[flow_snaplen_hash(&key) & (FLOW_TABLE_SIZE - 1)];
+    if (syn || memcmp(entry, &key, offsetof(flow_entry, packets)) != 0) {
+        *entry = key;
+    }
+    if (entry->packets < fs->full_packets) {
+        entry->packets++;
+        return caplen;
+    }
+
+    keep = off + header_len + fs->payload_bytes;
+    return MIN(keep, caplen);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,66 @@
+/** @file
+ *
+ * Per-flow snapshot lengths for captured packets
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#ifndef __FLOW_SNAPLEN_H__
+#define __FLOW_SNAPLEN_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Keeps all of the first packets of each TCP or UDP flow, and only the
+ * headers, up to and including the TCP or UDP header, and a given number
+ * of payload bytes of the rest.  Both directions of a flow count towards
+ * the same total; a TCP SYN without an ACK starts a new flow.
+ *
+ * Flows are looked up in a fixed-size table, so memory use doesn't grow
+ * with the number of flows; a flow can lose its entry to another one
+ * that hashes to the same place, and then starts again as a new flow.
+ */
+typedef struct _flow_snaplen flow_snaplen;
+
+/**
+ * Keep full_packets packets of each flow, and payload_bytes bytes of
+ * payload of the packets after that.
+ */
+flow_snaplen *flow_snaplen_new(guint32 full_packets, guint32 payload_bytes);
+
+void flow_snaplen_free(flow_snaplen *fs);
+
+/**
+ * Returns how much of a packet with link-layer type linktype (a DLT_ or
+ * LINKTYPE_ value), of which caplen bytes were captured, to keep.
+ * Packets that aren't TCP or UDP over IPv4 or IPv6, or whose link-layer
+ * type isn't understood, are kept whole.
+ */
+guint32 flow_snaplen_caplen(flow_snaplen *fs, int linktype, const guint8 *pd,
+                            guint32 caplen);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FLOW_SNAPLEN_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
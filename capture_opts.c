@@ -133,6 +133,7 @@ capture_opts_init(capture_options *capture_opts)
     capture_opts->print_file_names                = FALSE;
     capture_opts->print_name_to                   = NULL;
     capture_opts->temp_dir                        = NULL;
+    capture_opts->live_shm                        = FALSE;
     capture_opts->compress_type                   = NULL;
     capture_opts->closed_msg                      = NULL;
     capture_opts->extcap_terminate_id             = 0;
@@ -1013,22 +1014,50 @@ capture_opts_add_opt(capture_options *capture_opts, int opt, const char *optarg_
             cmdarg_err("--compress-type can be set only once");
             return 1;
         }
-        if (strcmp(optarg_str_p, "none") == 0) {
-            ;
-        } else if (strcmp(optarg_str_p, "gzip") == 0) {
+        {
+            /* "none", "gzip", or "zstd", optionally followed by ":level" */
+            const char *level_str = strchr(optarg_str_p, ':');
+            size_t type_len = level_str ? (size_t)(level_str - optarg_str_p) : strlen(optarg_str_p);
+            int min_level = 0, max_level = 0;
+            char *p;
+            long level;
+
+            if (type_len == 4 && strncmp(optarg_str_p, "none", 4) == 0 && level_str == NULL) {
+                ;
+            } else if (type_len == 4 && strncmp(optarg_str_p, "gzip", 4) == 0) {
 #ifdef HAVE_ZLIB
-            ;
+                min_level = 1;
+                max_level = 9;
 #else
-            cmdarg_err("'gzip' compression is not supported");
-            return 1;
+                cmdarg_err("'gzip' compression is not supported");
+                return 1;
 #endif
-        } else {
-#ifdef HAVE_ZLIB
-            cmdarg_err("parameter of --compress-type can be 'none' or 'gzip'");
+            } else if (type_len == 4 && strncmp(optarg_str_p, "zstd", 4) == 0) {
+#ifdef HAVE_ZSTD
+                min_level = 1;
+                max_level = 22;
 #else
-            cmdarg_err("parameter of --compress-type can only be 'none'");
+                cmdarg_err("'zstd' compression is not supported");
+                return 1;
 #endif
-            return 1;
+            } else {
+                cmdarg_err("parameter of --compress-type can be 'none'"
+#ifdef HAVE_ZLIB
+                           ", 'gzip[:level]'"
+#endif
+#ifdef HAVE_ZSTD
+                           ", 'zstd[:level]'"
+#endif
+                           );
+                return 1;
+            }
+            if (level_str != NULL) {
+                level = strtol(level_str + 1, &p, 10);
+                if (p == level_str + 1 || *p != '\0' || level < min_level || level > max_level) {
+                    cmdarg_err("The compression level must be between %d and %d", min_level, max_level);
+                    return 1;
+                }
+            }
         }
         capture_opts->compress_type = g_strdup(optarg_str_p);
         break;
@@ -1056,6 +1085,9 @@ capture_opts_add_opt(capture_options *capture_opts, int opt, const char *optarg_
 #endif /* S_IRWXU */
         capture_opts->temp_dir = g_strdup(optarg_str_p);
         break;
+    case LONGOPT_LIVE_SHM:        /* share the capture file in shared memory */
+        capture_opts->live_shm = TRUE;
+        break;
     default:
         /* the caller is responsible to send us only the right opt's */
         ws_assert_not_reached();
@@ -48,6 +48,7 @@ extern "C" {
 #define LONGOPT_SET_TSTAMP_TYPE   LONGOPT_BASE_CAPTURE+2
 #define LONGOPT_COMPRESS_TYPE     LONGOPT_BASE_CAPTURE+3
 #define LONGOPT_CAPTURE_TMPDIR    LONGOPT_BASE_CAPTURE+4
+#define LONGOPT_LIVE_SHM          LONGOPT_BASE_CAPTURE+5
 
 /*
  * Options for capturing common to all capturing programs.
@@ -89,7 +90,8 @@ extern "C" {
     {"list-time-stamp-types", ws_no_argument,       NULL, LONGOPT_LIST_TSTAMP_TYPES}, \
     {"time-stamp-type",       ws_required_argument, NULL, LONGOPT_SET_TSTAMP_TYPE}, \
     {"compress-type",         ws_required_argument, NULL, LONGOPT_COMPRESS_TYPE}, \
-    {"temp-dir",              ws_required_argument, NULL, LONGOPT_CAPTURE_TMPDIR},
+    {"temp-dir",              ws_required_argument, NULL, LONGOPT_CAPTURE_TMPDIR}, \
+    {"live-shm",              ws_no_argument,       NULL, LONGOPT_LIVE_SHM},
 
 
 #define OPTSTRING_CAPTURE_COMMON \
@@ -323,6 +325,8 @@ typedef struct capture_options_tag {
                                                    files as we close them */
     gchar             *print_name_to;         /**< output file name */
     gchar             *temp_dir;              /**< temporary directory path */
+    gboolean           live_shm;              /**< TRUE if the capture child shares what
+                                                   it writes in shared memory */
 
     /* internally used (don't touch from outside) */
     gboolean           output_to_pipe;        /**< save_file is a pipe (named or stdout) */
@@ -42,8 +42,19 @@
 #include <wsutil/str_util.h>
 #include <wsutil/wslog.h>
 
+#include "ui/clopts_common.h"
 #include "ui/failure_message.h"
 
+/*
+ * A file whose type is being found, possibly on another thread.
+ */
+typedef struct {
+    const char *filename;
+    int         file_type_subtype;  /* -1 if it couldn't be opened */
+    int         err;
+    gchar      *err_info;
+} file_job_t;
+
 static void
 print_usage(FILE *output)
 {
@@ -53,6 +64,42 @@ print_usage(FILE *output)
     fprintf(output, "Miscellaneous:\n");
     fprintf(output, "  -h, --help               display this help and exit\n");
     fprintf(output, "  -v, --version            display version info and exit\n");
+    fprintf(output, "  -j <n>                   open up to <n> files at the same time\n");
+}
+
+static void
+open_file_job(gpointer data, gpointer user_data _U_)
+{
+    file_job_t *job = (file_job_t *)data;
+    wtap *wth;
+
+    wth = wtap_open_offline(job->filename, WTAP_TYPE_AUTO, &job->err, &job->err_info, FALSE);
+    if (wth) {
+        job->file_type_subtype = wtap_file_type_subtype(wth);
+        wtap_close(wth);
+    } else {
+        job->file_type_subtype = -1;
+    }
+}
+
+/*
+ * Print the file's type, or report why we couldn't get it.  Returns
+ * FALSE if an error should be reported in the exit status.
+ */
+static gboolean
+print_file_job(file_job_t *job)
+{
+    if (job->file_type_subtype != -1) {
+        printf("%s: %s\n", job->filename, wtap_file_type_subtype_name(job->file_type_subtype));
+    } else {
+        if (job->err == WTAP_ERR_FILE_UNKNOWN_FORMAT)
+            printf("%s: unknown\n", job->filename);
+        else {
+            cfile_open_failure_message(job->filename, job->err, job->err_info);
+            return FALSE;
+        }
+    }
+    return TRUE;
 }
 
 /*
@@ -92,10 +139,10 @@ main(int argc, char *argv[])
         cfile_write_failure_message,
         cfile_close_failure_message
     };
-    wtap  *wth;
-    int    err;
-    gchar *err_info;
     int    i;
+    guint32 num_threads = 1;
+    file_job_t *jobs;
+    GThreadPool *pool;
     int    opt;
     int    overall_error_status;
     static const struct ws_option long_options[] = {
@@ -153,7 +200,7 @@ main(int argc, char *argv[])
     wtap_init(TRUE);
 
     /* Process the options */
-    while ((opt = ws_getopt_long(argc, argv, "hv", long_options, NULL)) !=-1) {
+    while ((opt = ws_getopt_long(argc, argv, "hj:v", long_options, NULL)) !=-1) {
 
         switch (opt) {
 
@@ -163,6 +210,10 @@ main(int argc, char *argv[])
                 exit(0);
                 break;
 
+            case 'j':
+                num_threads = get_nonzero_guint32(ws_optarg, "number of threads");
+                break;
+
             case 'v':
                 show_version();
                 exit(0);
@@ -175,29 +226,36 @@ main(int argc, char *argv[])
         }
     }
 
-    if (argc < 2) {
+    if (argc - ws_optind < 1) {
         print_usage(stderr);
         return 1;
     }
 
     overall_error_status = 0;
 
-    for (i = 1; i < argc; i++) {
-        wth = wtap_open_offline(argv[i], WTAP_TYPE_AUTO, &err, &err_info, FALSE);
-
-        if(wth) {
-            printf("%s: %s\n", argv[i], wtap_file_type_subtype_name(wtap_file_type_subtype(wth)));
-            wtap_close(wth);
-        } else {
-            if (err == WTAP_ERR_FILE_UNKNOWN_FORMAT)
-                printf("%s: unknown\n", argv[i]);
-            else {
-                cfile_open_failure_message(argv[i], err, err_info);
-                overall_error_status = 2; /* remember that an error has occurred */
-            }
+    /*
+     * With -j, open the files on a pool of threads, and then print the
+     * results in the order in which the files were given.
+     */
+    jobs = g_new0(file_job_t, argc - ws_optind);
+    for (i = ws_optind; i < argc; i++) {
+        jobs[i - ws_optind].filename = argv[i];
+    }
+    if (num_threads > 1) {
+        pool = g_thread_pool_new(open_file_job, NULL, (gint)num_threads, TRUE, NULL);
+        for (i = 0; i < argc - ws_optind; i++) {
+            g_thread_pool_push(pool, &jobs[i], NULL);
         }
+        g_thread_pool_free(pool, FALSE, TRUE);
+    }
 
+    for (i = 0; i < argc - ws_optind; i++) {
+        if (num_threads <= 1)
+            open_file_job(&jobs[i], NULL);
+        if (!print_file_job(&jobs[i]))
+            overall_error_status = 2; /* remember that an error has occurred */
     }
+    g_free(jobs);
 
     wtap_cleanup();
     free_progdirs();
@@ -61,6 +61,7 @@ struct packet_provider_data {
     frame_data  *prev_cap;
     frame_data_sequence *frames;         /* Sequence of frames, if we're keeping that information */
     GTree       *frames_modified_blocks; /* BST with modified blocks for frames (key = frame_data) */
+    GPtrArray   *idbs;                   /* IDBs seen so far, if wth is being read on another thread */
 };
 
 typedef struct _capture_file {
@@ -70,6 +71,7 @@ typedef struct _capture_file {
     gchar                      *source;               /* Temp file source, e.g. "Pipe from elsewhere" */
     gboolean                    is_tempfile;          /* Is capture file a temporary file? */
     gboolean                    unsaved_changes;      /* Does the capture file have changes that have not been saved? */
+    gboolean                    shb_comment_changed;  /* Has the section comment been changed since the file was last saved? */
     gboolean                    stop_flag;            /* Stop current processing (loading, searching, etc.) */
 
     gint64                      f_datalen;            /* Size of capture file data (uncompressed) */
@@ -91,6 +93,8 @@ typedef struct _capture_file {
     dfilter_t                  *rfcode;               /* Compiled read filter program */
     dfilter_t                  *dfcode;               /* Compiled display filter program */
     gchar                      *dfilter;              /* Display filter string */
+    gboolean                    dfilter_applied;      /* TRUE if every frame has been filtered with dfilter */
+    gboolean                    dfilter_refines;      /* TRUE if dfilter only narrows the filter every frame was last filtered with */
     gboolean                    redissecting;         /* TRUE if currently redissecting (cf_redissect_packets) */
     gboolean                    read_lock;            /* TRUE if currently processing a file (cf_read) */
     rescan_type                 redissection_queued;  /* Queued redissection type. */
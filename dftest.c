@@ -20,6 +20,7 @@
 #include <glib.h>
 
 #include <epan/epan.h>
+#include <epan/epan_dissect.h>
 #include <epan/timestamp.h>
 #include <epan/prefs.h>
 #include <epan/dfilter/dfilter.h>
@@ -55,6 +56,111 @@ putloc(FILE *fp, dfilter_loc_t loc)
     fputc('\n', fp);
 }
 
+static const nstime_t *
+dftest_get_frame_ts(struct packet_provider_data *prov _U_, guint32 frame_num _U_)
+{
+    static nstime_t empty;
+
+    return &empty;
+}
+
+/*
+ * Dissect the packets in a capture file, the way "tshark -Y" does, and
+ * run the filter over each of them with profiling turned on.
+ */
+static int
+profile_capture(dfilter_t *df, const char *filename)
+{
+    static const struct packet_provider_funcs funcs = {
+        dftest_get_frame_ts,
+        NULL,
+        NULL,
+        NULL
+    };
+    wtap        *wth;
+    wtap_rec    rec;
+    Buffer      buf;
+    int         err;
+    gchar       *err_info = NULL;
+    gint64      data_offset;
+    epan_t      *epan;
+    epan_dissect_t *edt;
+    frame_data  fdata;
+    frame_data  ref_frame;
+    frame_data  prev_dis_frame;
+    const frame_data *ref = NULL;
+    const frame_data *prev_dis = NULL;
+    nstime_t    elapsed_time;
+    guint32     cum_bytes = 0;
+    guint32     framenum = 0;
+
+    wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    if (wth == NULL) {
+        cfile_open_failure_message(filename, err, err_info);
+        return 2;
+    }
+
+    epan = epan_new(NULL, &funcs);
+    edt = epan_dissect_new(epan, TRUE, FALSE);
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    nstime_set_zero(&elapsed_time);
+
+    dfilter_start_profile(df);
+
+    while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+        if (rec.rec_type != REC_TYPE_PACKET) {
+            wtap_rec_reset(&rec);
+            continue;
+        }
+        framenum++;
+        frame_data_init(&fdata, framenum, &rec, data_offset, cum_bytes);
+        frame_data_set_before_dissect(&fdata, &elapsed_time, &ref, prev_dis);
+        if (ref == &fdata) {
+            ref_frame = fdata;
+            ref = &ref_frame;
+        }
+
+        epan_dissect_prime_with_dfilter(edt, df);
+        epan_dissect_run(edt, wtap_file_type_subtype(wth), &rec,
+            tvb_new_real_data(ws_buffer_start_ptr(&buf),
+                rec.rec_header.packet_header.caplen,
+                rec.rec_header.packet_header.caplen),
+            &fdata, NULL);
+        dfilter_apply_edt(df, edt);
+
+        frame_data_set_after_dissect(&fdata, &cum_bytes);
+        prev_dis_frame = fdata;
+        prev_dis = &prev_dis_frame;
+
+        epan_dissect_reset(edt);
+        frame_data_destroy(&fdata);
+        wtap_rec_reset(&rec);
+    }
+    if (err != 0)
+        cfile_read_failure_message(filename, err, err_info);
+
+    printf("\nProfile over %u packets of %s:\n", framenum, filename);
+    dfilter_dump_profile(df);
+
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+    epan_dissect_free(edt);
+    epan_free(epan);
+    wtap_close(wth);
+
+    return err != 0 ? 2 : 0;
+}
+
+static void
+print_usage(FILE *output)
+{
+    fprintf(output, "Usage: dftest [-r <infile>] <filter>\n");
+    fprintf(output, "\n");
+    fprintf(output, "  -r <infile>    run the filter over the packets in <infile> and show how\n");
+    fprintf(output, "                 often each instruction ran and how long it took\n");
+}
+
 int
 main(int argc, char **argv)
 {
@@ -76,6 +182,9 @@ main(int argc, char **argv)
     dfilter_t		*df;
     gchar		*err_msg;
     dfilter_loc_t	err_loc;
+    const char		*read_file = NULL;
+    int			arg = 1;
+    int			exit_status = 0;
 
     cmdarg_err_init(dftest_cmdarg_err, dftest_cmdarg_err_cont);
 
@@ -87,6 +196,25 @@ main(int argc, char **argv)
 
     ws_noisy("Finished log init and parsing command line log arguments");
 
+    /*
+     * Filters can start with "-", as in "-2 == tcp.dstport", so take
+     * only the arguments that are exactly our options as options.
+     */
+    while (arg < argc) {
+        if (strcmp(argv[arg], "-h") == 0 || strcmp(argv[arg], "--help") == 0) {
+            print_usage(stdout);
+            exit(0);
+        } else if (strcmp(argv[arg], "-r") == 0 && arg + 1 < argc) {
+            read_file = argv[arg + 1];
+            arg += 2;
+        } else if (strcmp(argv[arg], "--") == 0) {
+            arg++;
+            break;
+        } else {
+            break;
+        }
+    }
+
     /*
      * Get credential information for later use.
      */
@@ -141,13 +269,13 @@ main(int argc, char **argv)
     prefs_apply_all();
 
     /* Check for filter on command line */
-    if (argc <= 1) {
-        fprintf(stderr, "Usage: dftest <filter>\n");
+    if (arg >= argc) {
+        print_usage(stderr);
         exit(1);
     }
 
     /* Get filter text */
-    text = get_args_as_string(argc, argv, 1);
+    text = get_args_as_string(argc, argv, arg);
 
     /* Expand macros. */
     expanded_text = dfilter_expand(text, &err_msg);
@@ -184,12 +312,14 @@ main(int argc, char **argv)
     else {
         printf("\nSyntax tree:\n%s\n\n", dfilter_syntax_tree(df));
         dfilter_dump(df);
+        if (read_file != NULL)
+            exit_status = profile_capture(df, read_file);
     }
 
     dfilter_free(df);
     epan_cleanup();
     g_free(expanded_text);
-    exit(0);
+    exit(exit_status);
 }
 
 /*
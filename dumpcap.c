@@ -7,6 +7,7 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#define _GNU_SOURCE /* For fopencookie(). */
 #include <config.h>
 #define WS_LOG_DOMAIN LOG_DOMAIN_CAPCHILD
 
@@ -50,6 +51,31 @@
 #include "capture/capture_ifinfo.h"
 #include "capture/capture-pcap-util.h"
 #include "capture/capture-pcap-util-int.h"
+#include "capture/capture-xdp.h"
+#include "capture/flow-snaplen.h"
+
+/* After libpcap's headers, so that its BPF macros take precedence. */
+#ifdef __linux__
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef TPACKET3_HDRLEN
+/* We can read directly from TPACKET_V3 rings. */
+#define DUMPCAP_TPACKET
+#endif
+#endif
+
+#ifdef HAVE_SCHED_SETAFFINITY
+/* We can pin our threads to CPUs. */
+#include <sched.h>
+#define DUMPCAP_CPU_AFFINITY
+#endif
+
 #ifdef _WIN32
 #include "capture/capture-wpcap.h"
 #endif /* _WIN32 */
@@ -79,6 +105,7 @@
 #include "wsutil/please_report_bug.h"
 #include "wsutil/glib-compat.h"
 #include <wsutil/ws_assert.h>
+#include <wsutil/shm_ring.h>
 
 #include "capture/ws80211_utils.h"
 
@@ -109,12 +136,67 @@ FILE *debug_log;   /* for logging debug messages to  */
                    /*  is defined                    */
 #endif
 
-static GAsyncQueue *pcap_queue;
-static gint64 pcap_queue_bytes;
-static gint64 pcap_queue_packets;
 static gint64 pcap_queue_byte_limit = 0;
 static gint64 pcap_queue_packet_limit = 0;
 
+/*
+ * Set while the writer thread is waiting for packets to be queued, so
+ * that the capture threads know to wake it up.
+ */
+static GMutex pcap_queue_mutex;
+static GCond pcap_queue_cond;
+static gint pcap_queue_writer_waiting;
+
+#ifdef DUMPCAP_TPACKET
+/* Number of TPACKET_V3 fanout sockets and threads per interface, 0 to use libpcap */
+static guint tpacket_fanout = 0;
+#endif
+
+#ifdef HAVE_AF_XDP
+/* TRUE to read interfaces with AF_XDP sockets instead of libpcap */
+static gboolean use_af_xdp = FALSE;
+#endif
+
+/*
+ * With --flow-snaplen, the number of packets of each TCP or UDP flow to
+ * write whole, and the number of payload bytes to write of the rest.
+ */
+static gboolean use_flow_snaplen = FALSE;
+static guint32 flow_snaplen_packets = 0;
+static guint32 flow_snaplen_payload = 0;
+
+/*
+ * With --reorder-window, how long, in microseconds, to hold back
+ * packets so that those from different sources are written in time
+ * order, and since when we've been holding back the oldest one.
+ */
+static gint64 reorder_window = 0;
+static gint64 reorder_held_since = 0;
+
+/*
+ * With --stats-interval, how often, in microseconds, to report capture
+ * statistics, when we last did, and a histogram of how long writing
+ * each packet to the capture file took since then; bucket i counts the
+ * writes that took less than 2^i microseconds, and the last bucket the
+ * ones that took longer.
+ */
+#define STATS_WRITE_BUCKETS 16
+static gint64 stats_interval = 0;
+static gint64 stats_last_time = 0;
+static guint64 stats_write_hist[STATS_WRITE_BUCKETS];
+static guint64 stats_write_bytes = 0;
+
+#ifdef DUMPCAP_CPU_AFFINITY
+/*
+ * With --reader-cpus, the CPUs to pin the capture threads to, handed out
+ * in the order the threads are started, and the next one to hand out;
+ * with --writer-cpu, the CPU to pin the thread writing the file to.
+ */
+static GArray *reader_cpus = NULL;
+static guint reader_cpu_next = 0;
+static int writer_cpu = -1;
+#endif
+
 static gboolean capture_child = FALSE; /* FALSE: standalone call, TRUE: this is an Wireshark capture child */
 static const char *report_capture_filename = NULL; /* capture child file name */
 #ifdef _WIN32
@@ -179,6 +261,80 @@ typedef struct _pcapng_pipe_info {
 
 struct _loop_data; /* forward declaration so we can use it in the cap_pipe_dispatch function pointer */
 
+/*
+ * A packet or pcapng block queued by a capture thread for the writer.
+ */
+typedef struct _pcap_queue_element {
+    union {
+        struct pcap_pkthdr  phdr;
+        pcapng_block_header_t  bh;
+#ifdef HAVE_AF_XDP
+        struct {
+            guint           queue;
+            guint32         first;        /**< Receive ring index of the first packet */
+            guint32         count;
+        } batch;                          /**< Packets in an AF_XDP socket's receive ring */
+#endif
+    } u;
+    gint64              ts;           /**< Time stamp in microseconds, for ordering the sources */
+    u_char             *pd;
+    guint               pd_size;      /**< Allocated size of pd */
+} pcap_queue_element;
+
+/*
+ * When capturing with one thread per source, each source has its own
+ * single-producer, single-consumer ring of queued packets: its capture
+ * thread is the only one that advances head, and the writer thread is
+ * the only one that advances tail, so neither needs a lock.  The
+ * elements and their data buffers are reused, so queueing a packet
+ * only costs a copy of its data.
+ */
+typedef struct _pcap_queue_ring {
+    pcap_queue_element *elements;
+    guint               mask;         /**< Number of elements - 1; the number is a power of 2 */
+    guint               head;         /**< Next element to fill, only changed by the capture thread */
+    guint               tail;         /**< Next element to write, only changed by the writer thread */
+    gint                bytes;        /**< Bytes queued */
+    gint                bytes_high;   /**< Most bytes queued since the last --stats-interval report */
+    gint                packets_high; /**< Most elements queued since then */
+} pcap_queue_ring;
+
+#ifdef DUMPCAP_TPACKET
+/*
+ * One of the sockets in a PACKET_FANOUT group reading from an interface
+ * with a TPACKET_V3 ring.  Its thread hands each block of packets the
+ * kernel fills to the writer thread through queue, without copying it;
+ * the writer gives the block back to the kernel once it's written.
+ */
+typedef struct _tpacket_member {
+    struct _capture_src *pcap_src;
+    int                  fd;
+    guint8              *map;         /**< The mmap()ed ring */
+    guint                block_size;
+    guint                block_nr;
+    guint                next_block;  /**< Next block the thread will hand over */
+    GThread             *tid;
+    int                  cpu;         /**< CPU to pin tid to, or -1 */
+    pcap_queue_ring     *queue;
+} tpacket_member;
+#endif
+
+#ifdef HAVE_AF_XDP
+/*
+ * The thread waiting for packets on one receive queue of an interface
+ * read with AF_XDP.  It hands each batch of packets that arrives to the
+ * writer thread through queue; the packets stay in the socket's UMEM
+ * until they're written.
+ */
+typedef struct _xdp_reader {
+    struct _capture_src *pcap_src;
+    guint                queue_id;
+    GThread             *tid;
+    int                  cpu;         /**< CPU to pin tid to, or -1 */
+    pcap_queue_ring     *queue;
+} xdp_reader;
+#endif
+
 /*
  * A source of packets from which we're capturing.
  */
@@ -193,6 +349,31 @@ typedef struct _capture_src {
     gboolean                     pcap_err;
     guint                        interface_id;
     GThread                     *tid;
+    int                          cpu;                    /**< CPU to pin tid to, or -1 */
+    pcap_queue_ring             *queue;                  /**< Packets queued by tid */
+#ifdef DUMPCAP_TPACKET
+    tpacket_member              *tpacket;                /**< Fanout sockets, if reading TPACKET_V3 rings rather than with libpcap */
+    guint                        tpacket_count;          /**< Number of fanout sockets */
+    guint64                      tpacket_drops;          /**< Packets the kernel dropped on the fanout sockets */
+    guint8                      *tpacket_buf;            /**< Buffer for re-inserting VLAN tags */
+    guint                        tpacket_buf_size;
+#endif
+#ifdef HAVE_AF_XDP
+    xdp_capture                 *xdp;                    /**< AF_XDP sockets, if reading with them rather than with libpcap */
+    xdp_reader                  *xdp_readers;            /**< One per receive queue */
+    struct bpf_program           xdp_filter;             /**< Capture filter, applied by the writer thread */
+#endif
+    flow_snaplen                *flows;                  /**< Per-flow snapshot lengths, with --flow-snaplen */
+    guint64                      bytes_received;         /**< Bytes on the wire of the packets that passed the filter */
+    guint64                      bytes_captured;         /**< Bytes of them we were given */
+    guint64                      bytes_kept;             /**< Bytes of them we wrote */
+    guint32                      truncated;              /**< Packets cut short by flows */
+    guint64                      dispatch_us;            /**< Time spent in pcap_dispatch() since the last --stats-interval report */
+    guint32                      dispatch_calls;         /**< Calls to it since then */
+    guint32                      stats_received;         /**< received at the last report */
+    guint32                      stats_dropped;          /**< dropped at the last report */
+    guint32                      stats_flushed;          /**< flushed at the last report */
+    guint64                      stats_bytes;            /**< bytes_captured at the last report */
     int                          snaplen;
     int                          linktype;
     gboolean                     ts_nsec;                /**< TRUE if we're using nanosecond precision. */
@@ -237,6 +418,15 @@ typedef struct _saved_idb {
     guint idb_len;
 } saved_idb_t;
 
+#if defined(HAVE_SHM_OPEN) && (defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN))
+/*
+ * With --live-shm, we copy what we write to the capture file to a ring
+ * in shared memory, from which our parent can read it.
+ */
+#define DUMPCAP_LIVE_SHM
+#define LIVE_SHM_RING_SIZE  (32 * 1024 * 1024)
+#endif
+
 /*
  * Global capture loop state.
  */
@@ -259,6 +449,9 @@ typedef struct _loop_data {
     int       save_file_fd;
     char     *io_buffer;           /**< Our IO buffer if we increase the size from the standard size */
     guint64   bytes_written;       /**< Bytes written for the current file. */
+#ifdef DUMPCAP_LIVE_SHM
+    ws_shm_ring *live_ring;        /**< Ring we copy the file to for our parent, or NULL */
+#endif
     /* autostop conditions */
     int       packets_written;     /**< Packets written for the current file. */
     int       file_count;
@@ -268,15 +461,6 @@ typedef struct _loop_data {
     int      interval_s;
 } loop_data;
 
-typedef struct _pcap_queue_element {
-    capture_src        *pcap_src;
-    union {
-        struct pcap_pkthdr  phdr;
-        pcapng_block_header_t  bh;
-    } u;
-    u_char             *pd;
-} pcap_queue_element;
-
 /*
  * This needs to be static, so that the SIGINT handler can clear the "go"
  * flag and for saved_shb_idb_lock.
@@ -343,12 +527,22 @@ static void capture_loop_get_errmsg(char *errmsg, size_t errmsglen,
                                     size_t secondary_errmsglen,
                                     const char *fname, int err,
                                     gboolean is_close);
+#ifdef DUMPCAP_TPACKET
+static void tpacket_close(capture_src *pcap_src);
+static guint64 tpacket_drops(capture_src *pcap_src);
+#endif
+#ifdef HAVE_AF_XDP
+static void xdp_close(capture_src *pcap_src);
+#endif
 
 WS_NORETURN static void exit_main(int err);
 
 static void report_new_capture_file(const char *filename);
 static void report_packet_count(unsigned int packet_count);
 static void report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop, gchar *name);
+static void report_flow_snaplen(capture_src *pcap_src, gchar *name);
+static void report_capture_stats(const char *stats);
+static void capture_stats_report(gint64 now);
 static void report_capture_error(const char *error_msg, const char *secondary_error_msg);
 static void report_cfilter_error(capture_options *capture_opts, guint i, const char *errmsg);
 
@@ -398,6 +592,28 @@ print_usage(FILE *output)
     fprintf(output, "                           set channel on wifi interface\n");
     fprintf(output, "  -S                       print statistics for each interface once per second\n");
     fprintf(output, "  -M                       for -D, -L, and -S, produce machine-readable output\n");
+#ifdef DUMPCAP_TPACKET
+    fprintf(output, "  --tpacket-fanout <count> read Ethernet interfaces with <count> TPACKET_V3\n");
+    fprintf(output, "                           fanout sockets and threads instead of libpcap\n");
+#endif
+#ifdef HAVE_AF_XDP
+    fprintf(output, "  --af-xdp                 read Ethernet interfaces with AF_XDP sockets instead\n");
+    fprintf(output, "                           of libpcap; packets captured aren't passed to the host\n");
+#endif
+    fprintf(output, "  --reorder-window <ms>    when capturing with threads, hold packets back for up\n");
+    fprintf(output, "                           to <ms> milliseconds to write them in time order\n");
+    fprintf(output, "  --flow-snaplen <packets>[:<bytes>]\n");
+    fprintf(output, "                           write the first <packets> packets of each TCP or UDP\n");
+    fprintf(output, "                           flow whole, and only the headers and <bytes> bytes\n");
+    fprintf(output, "                           of payload (def: 0) of the rest\n");
+    fprintf(output, "  --stats-interval <secs>  report queue, dispatch and write statistics\n");
+    fprintf(output, "                           every <secs> seconds while capturing\n");
+#ifdef DUMPCAP_CPU_AFFINITY
+    fprintf(output, "  --reader-cpus <cpu>[,<cpu>...]\n");
+    fprintf(output, "                           pin the capture threads, in interface order, to\n");
+    fprintf(output, "                           these CPUs (e.g. 2,4-7)\n");
+    fprintf(output, "  --writer-cpu <cpu>       pin the thread writing the capture file to a CPU\n");
+#endif
     fprintf(output, "\n");
 #ifdef HAVE_PCAP_REMOTE
     fprintf(output, "RPCAP options:\n");
@@ -436,6 +652,7 @@ print_usage(FILE *output)
     fprintf(output, "                           add a capture comment to the output file\n");
     fprintf(output, "                           (only for pcapng)\n");
     fprintf(output, "  --temp-dir <directory>   write temporary files to this directory\n");
+    fprintf(output, "  --live-shm               also pass live capture data via shared memory\n");
     fprintf(output, "                           (default: %s)\n", g_get_tmp_dir());
     fprintf(output, "\n");
 
@@ -2821,6 +3038,9 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
 #endif
         pcap_src->interface_id = i;
         pcap_src->linktype = -1;
+        if (use_flow_snaplen) {
+            pcap_src->flows = flow_snaplen_new(flow_snaplen_packets, flow_snaplen_payload);
+        }
 #ifdef _WIN32
         pcap_src->cap_pipe_h = INVALID_HANDLE_VALUE;
 #endif
@@ -3024,12 +3244,20 @@ static void capture_loop_close_input(loop_data *ld)
             }
         } else {
             /* Capture device.  If open, close the pcap_t. */
+#ifdef DUMPCAP_TPACKET
+            tpacket_close(pcap_src);
+#endif
+#ifdef HAVE_AF_XDP
+            xdp_close(pcap_src);
+#endif
             if (pcap_src->pcap_h != NULL) {
                 ws_debug("capture_loop_close_input: closing %p", (void *)pcap_src->pcap_h);
                 pcap_close(pcap_src->pcap_h);
                 pcap_src->pcap_h = NULL;
             }
         }
+        flow_snaplen_free(pcap_src->flows);
+        pcap_src->flows = NULL;
     }
 
     ld->go = FALSE;
@@ -3182,6 +3410,92 @@ capture_loop_init_pcapng_output(capture_options *capture_opts, loop_data *ld,
     return successful;
 }
 
+#ifdef DUMPCAP_LIVE_SHM
+/*
+ * Write to the capture file, and copy what we wrote to the ring.
+ */
+static ssize_t
+live_shm_write(loop_data *ld, const char *buf, size_t size)
+{
+    size_t left = size;
+    ssize_t n;
+
+    while (left != 0) {
+        n = ws_write(ld->save_file_fd, buf + (size - left), (unsigned int)left);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        left -= (size_t)n;
+    }
+    ws_shm_ring_write(ld->live_ring, buf, size - left);
+    return left == size ? -1 : (ssize_t)(size - left);
+}
+
+static int
+live_shm_close(loop_data *ld)
+{
+    return ws_close(ld->save_file_fd) < 0 ? EOF : 0;
+}
+
+#ifdef HAVE_FOPENCOOKIE
+static ssize_t
+live_shm_cookie_write(void *cookie, const char *buf, size_t size)
+{
+    return live_shm_write((loop_data *)cookie, buf, size);
+}
+#else
+static int
+live_shm_cookie_write(void *cookie, const char *buf, int size)
+{
+    return (int)live_shm_write((loop_data *)cookie, buf, (size_t)size);
+}
+#endif
+
+static int
+live_shm_cookie_close(void *cookie)
+{
+    return live_shm_close((loop_data *)cookie);
+}
+
+/*
+ * Create the ring our parent can read the capture file from, and open a
+ * FILE that writes to both.  Returns NULL, and opens nothing, if we
+ * can't; the parent then just reads the file.
+ */
+static FILE *
+live_shm_fdopen(loop_data *ld)
+{
+    char *name;
+    int err;
+    FILE *fh;
+
+    name = ws_shm_ring_capture_name((long)getpid());
+    ld->live_ring = ws_shm_ring_create(name, LIVE_SHM_RING_SIZE, &err);
+    if (ld->live_ring == NULL) {
+        ws_info("Can't create shared memory %s: %s", name, g_strerror(err));
+        g_free(name);
+        return NULL;
+    }
+    g_free(name);
+#ifdef HAVE_FOPENCOOKIE
+    {
+        cookie_io_functions_t funcs = { NULL, live_shm_cookie_write, NULL, live_shm_cookie_close };
+
+        fh = fopencookie(ld, "wb", funcs);
+    }
+#else
+    fh = funopen(ld, NULL, live_shm_cookie_write, NULL, live_shm_cookie_close);
+#endif
+    if (fh == NULL) {
+        ws_shm_ring_close(ld->live_ring);
+        ld->live_ring = NULL;
+    }
+    return fh;
+}
+#endif /* DUMPCAP_LIVE_SHM */
+
 /* set up to write to the already-opened capture output file/files */
 static gboolean
 capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *errmsg, int errmsg_len)
@@ -3201,16 +3515,23 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
     if (capture_opts->multi_files_on) {
         ld->pdh = ringbuf_init_libpcap_fdopen(&err);
     } else {
+#ifdef DUMPCAP_LIVE_SHM
+        ld->pdh = NULL;
+        if (capture_opts->live_shm && capture_opts->capture_child &&
+            !capture_opts->output_to_pipe)
+            ld->pdh = live_shm_fdopen(ld);
+        if (ld->pdh == NULL)
+#endif
         ld->pdh = ws_fdopen(ld->save_file_fd, "wb");
         if (ld->pdh == NULL) {
             err = errno;
         } else {
-            size_t buffsize = IO_BUF_SIZE;
+            size_t buffsize = RINGBUFFER_IO_BUF_SIZE;
 #ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
             ws_statb64 statb;
 
             if (ws_fstat64(ld->save_file_fd, &statb) == 0) {
-                if (statb.st_blksize > IO_BUF_SIZE) {
+                if (statb.st_blksize > RINGBUFFER_IO_BUF_SIZE) {
                     buffsize = statb.st_blksize;
                 }
             }
@@ -3241,6 +3562,10 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
             ld->pdh = NULL;
             g_free(ld->io_buffer);
             ld->io_buffer = NULL;
+#ifdef DUMPCAP_LIVE_SHM
+            ws_shm_ring_close(ld->live_ring);
+            ld->live_ring = NULL;
+#endif
         }
     }
 
@@ -3288,6 +3613,14 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
                     if (pcap_stats(pcap_src->pcap_h, &stats) >= 0) {
                         isb_ifrecv = pcap_src->received;
                         isb_ifdrop = stats.ps_drop + pcap_src->dropped + pcap_src->flushed;
+#ifdef DUMPCAP_TPACKET
+                        if (pcap_src->tpacket)
+                            isb_ifdrop += tpacket_drops(pcap_src);
+#endif
+#ifdef HAVE_AF_XDP
+                        if (pcap_src->xdp)
+                            isb_ifdrop += xdp_capture_drops(pcap_src->xdp);
+#endif
                    } else {
                         isb_ifrecv = G_MAXUINT64;
                         isb_ifdrop = G_MAXUINT64;
@@ -3314,10 +3647,39 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
         }
         g_free(ld->io_buffer);
         ld->io_buffer = NULL;
+#ifdef DUMPCAP_LIVE_SHM
+        /* Our parent can go on reading the ring if it has it open. */
+        ws_shm_ring_close(ld->live_ring);
+        ld->live_ring = NULL;
+#endif
         return success;
     }
 }
 
+/*
+ * Call pcap_dispatch(), keeping track of the time it takes for
+ * --stats-interval.
+ */
+static int
+capture_loop_pcap_dispatch(capture_src *pcap_src, int cnt)
+{
+    gint64 start = 0;
+    int    inpkts;
+
+    if (stats_interval > 0)
+        start = g_get_monotonic_time();
+    if (use_threads) {
+        inpkts = pcap_dispatch(pcap_src->pcap_h, cnt, capture_loop_queue_packet_cb, (u_char *)pcap_src);
+    } else {
+        inpkts = pcap_dispatch(pcap_src->pcap_h, cnt, capture_loop_write_packet_cb, (u_char *)pcap_src);
+    }
+    if (stats_interval > 0) {
+        pcap_src->dispatch_us += g_get_monotonic_time() - start;
+        pcap_src->dispatch_calls++;
+    }
+    return inpkts;
+}
+
 /* dispatch incoming packets (pcap or capture pipe)
  *
  * Waits for incoming packets to be available, and calls pcap_dispatch()
@@ -3408,11 +3770,7 @@ capture_loop_dispatch(loop_data *ld,
                  * processing immediately, rather than processing all packets
                  * in a batch before quitting.
                  */
-                if (use_threads) {
-                    inpkts = pcap_dispatch(pcap_src->pcap_h, 1, capture_loop_queue_packet_cb, (u_char *)pcap_src);
-                } else {
-                    inpkts = pcap_dispatch(pcap_src->pcap_h, 1, capture_loop_write_packet_cb, (u_char *)pcap_src);
-                }
+                inpkts = capture_loop_pcap_dispatch(pcap_src, 1);
                 if (inpkts < 0) {
                     if (inpkts == -1) {
                         /* Error, rather than pcap_breakloop(). */
@@ -3444,17 +3802,9 @@ capture_loop_dispatch(loop_data *ld,
              * after processing packets.  We therefore process only one packet
              * at a time, so that we can check the pipe after every packet.
              */
-            if (use_threads) {
-                inpkts = pcap_dispatch(pcap_src->pcap_h, 1, capture_loop_queue_packet_cb, (u_char *)pcap_src);
-            } else {
-                inpkts = pcap_dispatch(pcap_src->pcap_h, 1, capture_loop_write_packet_cb, (u_char *)pcap_src);
-            }
+            inpkts = capture_loop_pcap_dispatch(pcap_src, 1);
 #else
-            if (use_threads) {
-                inpkts = pcap_dispatch(pcap_src->pcap_h, -1, capture_loop_queue_packet_cb, (u_char *)pcap_src);
-            } else {
-                inpkts = pcap_dispatch(pcap_src->pcap_h, -1, capture_loop_write_packet_cb, (u_char *)pcap_src);
-            }
+            inpkts = capture_loop_pcap_dispatch(pcap_src, -1);
 #endif
             if (inpkts < 0) {
                 if (inpkts == -1) {
@@ -3586,7 +3936,11 @@ capture_loop_open_output(capture_options *capture_opts, int *save_file_fd,
                                              (capture_opts->has_ring_num_files) ? capture_opts->ring_num_files : 0,
                                              capture_opts->group_read_access,
                                              capture_opts->compress_type,
-                                             capture_opts->has_nametimenum);
+                                             /* Wireshark reads the current file as it's written. */
+                                             !capture_child,
+                                             capture_opts->has_nametimenum,
+                                             capture_opts->has_autostop_filesize ?
+                                                 (guint64)capture_opts->autostop_filesize * 1000 : 0);
 
                 /* capfile_name is unused as the ringbuffer provides its own filename. */
                 if (*save_file_fd != -1) {
@@ -3795,12 +4149,126 @@ do_file_switch_or_stop(capture_options *capture_opts)
     return TRUE;
 }
 
+#ifdef DUMPCAP_CPU_AFFINITY
+/*
+ * Get the NUMA node of a CPU, or -1 if we can't tell.
+ */
+static int
+cpu_numa_node(int cpu)
+{
+    char        *path;
+    GDir        *dir;
+    const gchar *name;
+    int          node = -1;
+
+    path = ws_strdup_printf("/sys/devices/system/cpu/cpu%d", cpu);
+    dir = g_dir_open(path, 0, NULL);
+    g_free(path);
+    if (dir == NULL)
+        return -1;
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        if (g_str_has_prefix(name, "node") && g_ascii_isdigit(name[4])) {
+            node = (int)strtol(name + 4, NULL, 10);
+            break;
+        }
+    }
+    g_dir_close(dir);
+    return node;
+}
+
+/*
+ * Get the NUMA node of the device behind a network interface, or -1 if
+ * we can't tell or the system has only one node.
+ */
+static int
+interface_numa_node(const char *ifname)
+{
+    char  *path;
+    gchar *contents;
+    int    node = -1;
+
+    path = ws_strdup_printf("/sys/class/net/%s/device/numa_node", ifname);
+    if (g_file_get_contents(path, &contents, NULL, NULL)) {
+        node = (int)strtol(contents, NULL, 10);
+        g_free(contents);
+    }
+    g_free(path);
+    return node;
+}
+
+/*
+ * Pick the CPU for the next capture thread, reading from the interface
+ * ifname, and say where it'll run.
+ */
+static int
+reader_cpu_take(const char *ifname)
+{
+    int cpu, cpu_node, if_node;
+
+    if (reader_cpus == NULL)
+        return -1;
+    cpu = g_array_index(reader_cpus, int, reader_cpu_next % reader_cpus->len);
+    reader_cpu_next++;
+
+    cpu_node = cpu_numa_node(cpu);
+    if_node = interface_numa_node(ifname);
+    if (if_node >= 0 && cpu_node >= 0 && if_node != cpu_node) {
+        ws_warning("Capture thread for %s on CPU %d (NUMA node %d), but the interface is on NUMA node %d.",
+                   ifname, cpu, cpu_node, if_node);
+    } else {
+        ws_message("Capture thread for %s on CPU %d (NUMA node %d).",
+                   ifname, cpu, cpu_node);
+    }
+    return cpu;
+}
+
+/*
+ * Pin the calling thread to a CPU, if it's not -1.
+ */
+static void
+pin_thread_to_cpu(int cpu)
+{
+    cpu_set_t cpus;
+
+    if (cpu < 0)
+        return;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    if (sched_setaffinity(0, sizeof cpus, &cpus) == -1)
+        ws_warning("Can't pin thread to CPU %d: %s.", cpu, g_strerror(errno));
+}
+#else
+static inline int reader_cpu_take(const char *ifname _U_) { return -1; }
+static inline void pin_thread_to_cpu(int cpu _U_) { }
+#endif
+
+/*
+ * Reallocate ring's elements from the thread that fills it, once it's
+ * been pinned to a CPU, so that, as the pages are placed when they're
+ * first touched, they end up on that CPU's NUMA node.  The packet
+ * buffers are allocated by that thread anyway.  This must be done
+ * before anything is queued.
+ */
+static void
+pcap_queue_ring_localize(pcap_queue_ring *ring)
+{
+    pcap_queue_element *elements;
+
+    elements = g_new0(pcap_queue_element, ring->mask + 1);
+    g_free(ring->elements);
+    ring->elements = elements;
+}
+
 static void *
 pcap_read_handler(void* arg)
 {
     capture_src *pcap_src = (capture_src *)arg;
     char         errmsg[MSG_MAX_LENGTH+1];
 
+    if (pcap_src->cpu >= 0) {
+        pin_thread_to_cpu(pcap_src->cpu);
+        pcap_queue_ring_localize(pcap_src->queue);
+    }
     ws_info("Started thread for interface %d.", pcap_src->interface_id);
 
     /* If this is a pipe input it might finish early. */
@@ -3814,101 +4282,764 @@ pcap_read_handler(void* arg)
     return (NULL);
 }
 
-/* Try to pop an item off the packet queue and if it exists, write it */
-static gboolean
-capture_loop_dequeue_packet(void) {
-    pcap_queue_element *queue_element;
+static pcap_queue_ring *
+pcap_queue_ring_new(gint64 elements)
+{
+    pcap_queue_ring *ring;
+    guint            n;
 
-    g_async_queue_lock(pcap_queue);
-    queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            pcap_queue_bytes -= queue_element->u.bh.block_total_length;
-        } else {
-            pcap_queue_bytes -= queue_element->u.phdr.caplen;
-        }
-        pcap_queue_packets -= 1;
+    for (n = 1; n < elements; n <<= 1)
+        ;
+
+    ring = g_new0(pcap_queue_ring, 1);
+    ring->elements = g_new0(pcap_queue_element, n);
+    ring->mask = n - 1;
+    return ring;
+}
+
+static void
+pcap_queue_ring_free(pcap_queue_ring *ring)
+{
+    guint i;
+
+    for (i = 0; i <= ring->mask; i++) {
+        /* Elements with no buffer of their own may point elsewhere. */
+        if (ring->elements[i].pd_size != 0)
+            g_free(ring->elements[i].pd);
     }
-    g_async_queue_unlock(pcap_queue);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            ws_info("Dequeued a block of type 0x%08x of length %d captured on interface %d.",
-                  queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
-                  queue_element->pcap_src->interface_id);
+    g_free(ring->elements);
+    g_free(ring);
+}
 
-            capture_loop_write_pcapng_cb(queue_element->pcap_src,
-                                        &queue_element->u.bh,
-                                        queue_element->pd);
-        } else {
-            ws_info("Dequeued a packet of length %d captured on interface %d.",
-                queue_element->u.phdr.caplen, queue_element->pcap_src->interface_id);
+/*
+ * Get the element to fill for a packet of len bytes from pcap_src's
+ * ring, or NULL if the queue limits have been reached.
+ */
+static pcap_queue_element *
+pcap_queue_reserve(capture_src *pcap_src, guint len)
+{
+    pcap_queue_ring    *ring = pcap_src->queue;
+    guint               queued;
+    pcap_queue_element *queue_element;
 
-            capture_loop_write_packet_cb((u_char *) queue_element->pcap_src,
-                                        &queue_element->u.phdr,
-                                        queue_element->pd);
-        }
+    queued = ring->head - (guint)g_atomic_int_get(&ring->tail);
+    if (queued > ring->mask ||
+        (pcap_queue_packet_limit > 0 && queued >= pcap_queue_packet_limit) ||
+        (pcap_queue_byte_limit > 0 && g_atomic_int_get(&ring->bytes) >= pcap_queue_byte_limit)) {
+        return NULL;
+    }
+
+    queue_element = &ring->elements[ring->head & ring->mask];
+    if (queue_element->pd_size < len) {
         g_free(queue_element->pd);
-        g_free(queue_element);
-        return TRUE;
+        queue_element->pd = (u_char *)g_malloc(len);
+        queue_element->pd_size = len;
     }
-    return FALSE;
+    return queue_element;
 }
 
 /*
- * Note: this code will never be run on any OS other than Windows.
- *
- * We keep the arguments in case there's something in the future
- * that needs to be reported as an NPCAP bug.
+ * Make the element at the head of ring, e.g. the one returned by
+ * pcap_queue_reserve(), visible to the writer thread, and wake it up
+ * if it's waiting.
  */
-static char *
-handle_npcap_bug(char *adapter_name _U_, char *cap_err_str _U_)
+static void
+pcap_queue_commit(pcap_queue_ring *ring, guint len)
 {
-    gboolean have_npcap = FALSE;
+    gint bytes = g_atomic_int_add(&ring->bytes, (gint)len) + (gint)len;
+    gint packets = (gint)(ring->head + 1 - (guint)g_atomic_int_get(&ring->tail));
 
-#ifdef _WIN32
-    have_npcap = caplibs_have_npcap();
-#endif
+    g_atomic_int_set(&ring->head, ring->head + 1);
+    if (stats_interval > 0) {
+        /* The reporter may reset these meanwhile; that only loses a peak. */
+        if (bytes > g_atomic_int_get(&ring->bytes_high))
+            g_atomic_int_set(&ring->bytes_high, bytes);
+        if (packets > g_atomic_int_get(&ring->packets_high))
+            g_atomic_int_set(&ring->packets_high, packets);
+    }
 
-    if (!have_npcap) {
-        /*
-         * We're not using Npcap, so don't recomment a user
-         * file a bug against Npcap.
-         */
-        return g_strdup("");
+    if (g_atomic_int_get(&pcap_queue_writer_waiting)) {
+        g_mutex_lock(&pcap_queue_mutex);
+        g_cond_signal(&pcap_queue_cond);
+        g_mutex_unlock(&pcap_queue_mutex);
     }
+}
 
-    return ws_strdup_printf("If you have not removed that adapter, this "
-                          "is probably a known issue in Npcap resulting from "
-                          "the behavior of the Windows networking stack. "
-                          "Work is being done in Npcap to improve the "
-                          "handling of this issue; it does not need to "
-                          "be reported as a Wireshark or Npcap bug.");
+#ifdef DUMPCAP_TPACKET
+/*
+ * Size of the blocks of a TPACKET_V3 ring; the kernel hands us a block
+ * when it's full or TPACKET_BLOCK_TIMEOUT milliseconds after its first
+ * packet arrived.
+ */
+#define TPACKET_BLOCK_SIZE      (1024 * 1024)
+#define TPACKET_FRAME_SIZE      2048
+#define TPACKET_BLOCK_TIMEOUT   50
+
+static void
+tpacket_close(capture_src *pcap_src)
+{
+    guint i;
+
+    if (pcap_src->tpacket == NULL)
+        return;
+    for (i = 0; i < pcap_src->tpacket_count; i++) {
+        tpacket_member *member = &pcap_src->tpacket[i];
+
+        if (member->map != NULL)
+            munmap(member->map, (size_t)member->block_size * member->block_nr);
+        if (member->fd >= 0)
+            close(member->fd);
+        if (member->queue != NULL)
+            pcap_queue_ring_free(member->queue);
+    }
+    g_free(pcap_src->tpacket);
+    pcap_src->tpacket = NULL;
+    pcap_src->tpacket_count = 0;
+    g_free(pcap_src->tpacket_buf);
+    pcap_src->tpacket_buf = NULL;
+    pcap_src->tpacket_buf_size = 0;
 }
 
-/* Do the low-level work of a capture.
-   Returns TRUE if it succeeds, FALSE otherwise. */
+/*
+ * Read from pcap_src's interface with tpacket_fanout AF_PACKET sockets
+ * in a PACKET_FANOUT group, each with a TPACKET_V3 ring, rather than
+ * with libpcap.  The pcap_t stays open, so that we still have its
+ * link-layer type, time stamp precision, promiscuous mode and compiled
+ * filter, but it's given a filter that rejects everything.
+ *
+ * Only Ethernet devices are handled; on anything else, where libpcap
+ * may rewrite the link-layer header, we keep using libpcap.
+ */
 static gboolean
-capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct pcap_stat *stats)
+tpacket_open(capture_src *pcap_src, interface_options *interface_opts,
+             char *errmsg, size_t errmsg_len)
 {
-#ifdef _WIN32
-    DWORD             upd_time, cur_time; /* GetTickCount() returns a "DWORD" (which is 'unsigned long') */
-#else
-    struct timeval    upd_time, cur_time;
-#endif
-    int               err_close;
-    int               inpkts;
-    GTimer           *autostop_duration_timer = NULL;
-    gboolean          write_ok;
-    gboolean          close_ok;
-    gboolean          cfilter_error         = FALSE;
-    char              errmsg[MSG_MAX_LENGTH+1];
-    char              secondary_errmsg[MSG_MAX_LENGTH+1];
-    capture_src      *pcap_src;
-    interface_options *interface_opts;
-    guint             i, error_index        = 0;
-
-    *errmsg           = '\0';
-    *secondary_errmsg = '\0';
+    struct bpf_program  fcode;
+    struct bpf_insn     reject = BPF_STMT(BPF_RET|BPF_K, 0);
+    struct bpf_program  reject_all;
+    struct sock_fprog   sock_filter;
+    struct tpacket_req3 req;
+    struct sockaddr_ll  sll;
+    unsigned int        ifindex;
+    int                 version = TPACKET_V3;
+    int                 fanout;
+    guint               block_nr;
+    guint               i;
+
+    if (pcap_src->linktype != DLT_EN10MB) {
+        snprintf(errmsg, errmsg_len, "the link-layer type isn't Ethernet");
+        return FALSE;
+    }
+    ifindex = if_nametoindex(interface_opts->name);
+    if (ifindex == 0) {
+        snprintf(errmsg, errmsg_len, "%s", g_strerror(errno));
+        return FALSE;
+    }
+    if (pcap_compile(pcap_src->pcap_h, &fcode,
+                     interface_opts->cfilter ? interface_opts->cfilter : "",
+                     1, PCAP_NETMASK_UNKNOWN) < 0) {
+        snprintf(errmsg, errmsg_len, "%s", pcap_geterr(pcap_src->pcap_h));
+        return FALSE;
+    }
+    sock_filter.len = fcode.bf_len;
+    sock_filter.filter = (struct sock_filter *)(void *)fcode.bf_insns;
+
+    /* Split the capture buffer (-B) between the sockets. */
+    block_nr = (guint)(((gint64)MAX(interface_opts->buffer_size, 1) * 1024 * 1024 /
+                        tpacket_fanout) / TPACKET_BLOCK_SIZE);
+    block_nr = MAX(block_nr, 4);
+
+    memset(&req, 0, sizeof req);
+    req.tp_block_size = TPACKET_BLOCK_SIZE;
+    req.tp_block_nr = block_nr;
+    req.tp_frame_size = TPACKET_FRAME_SIZE;
+    req.tp_frame_nr = (TPACKET_BLOCK_SIZE / TPACKET_FRAME_SIZE) * block_nr;
+    req.tp_retire_blk_tov = TPACKET_BLOCK_TIMEOUT;
+
+    memset(&sll, 0, sizeof sll);
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    sll.sll_ifindex = (int)ifindex;
+
+    fanout = (int)((getpid() + pcap_src->interface_id) & 0xffff) |
+             ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16);
+
+    pcap_src->tpacket = g_new0(tpacket_member, tpacket_fanout);
+    pcap_src->tpacket_count = tpacket_fanout;
+    for (i = 0; i < tpacket_fanout; i++)
+        pcap_src->tpacket[i].fd = -1;
+    for (i = 0; i < tpacket_fanout; i++) {
+        tpacket_member *member = &pcap_src->tpacket[i];
+
+        member->pcap_src = pcap_src;
+        member->block_size = TPACKET_BLOCK_SIZE;
+        member->block_nr = block_nr;
+        /* Protocol 0, so that we get nothing until we bind. */
+        member->fd = socket(AF_PACKET, SOCK_RAW, 0);
+        if (member->fd < 0 ||
+            setsockopt(member->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof version) < 0 ||
+            setsockopt(member->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof req) < 0) {
+            goto fail;
+        }
+        member->map = (guint8 *)mmap(NULL, (size_t)TPACKET_BLOCK_SIZE * block_nr,
+                                     PROT_READ|PROT_WRITE, MAP_SHARED, member->fd, 0);
+        if (member->map == MAP_FAILED) {
+            member->map = NULL;
+            goto fail;
+        }
+        if (setsockopt(member->fd, SOL_SOCKET, SO_ATTACH_FILTER, &sock_filter, sizeof sock_filter) < 0 ||
+            bind(member->fd, (struct sockaddr *)&sll, sizeof sll) < 0 ||
+            setsockopt(member->fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof fanout) < 0) {
+            goto fail;
+        }
+        member->queue = pcap_queue_ring_new(block_nr);
+    }
+    pcap_freecode(&fcode);
+
+    /* libpcap's own socket doesn't need to see any packets now. */
+    reject_all.bf_len = 1;
+    reject_all.bf_insns = &reject;
+    pcap_setfilter(pcap_src->pcap_h, &reject_all);
+
+    ws_info("Reading interface %u with %u TPACKET_V3 sockets of %u blocks.",
+            pcap_src->interface_id, tpacket_fanout, block_nr);
+    return TRUE;
+
+fail:
+    snprintf(errmsg, errmsg_len, "%s", g_strerror(errno));
+    pcap_freecode(&fcode);
+    tpacket_close(pcap_src);
+    return FALSE;
+}
+
+/*
+ * Hand each block of member's ring to the writer thread as the kernel
+ * fills it.
+ */
+static void *
+tpacket_read_handler(void *arg)
+{
+    tpacket_member  *member = (tpacket_member *)arg;
+    pcap_queue_ring *ring = member->queue;
+    struct pollfd    pfd;
+
+    if (member->cpu >= 0) {
+        pin_thread_to_cpu(member->cpu);
+        pcap_queue_ring_localize(ring);
+    }
+    ws_info("Started thread for interface %d.", member->pcap_src->interface_id);
+
+    pfd.fd = member->fd;
+    pfd.events = POLLIN | POLLERR;
+    pfd.revents = 0;
+    while (global_ld.go) {
+        struct tpacket_block_desc *bd;
+        pcap_queue_element        *queue_element;
+
+        /*
+         * Don't hand over a block the writer still has, i.e. one we
+         * handed over block_nr blocks ago and that hasn't been written.
+         */
+        if (ring->head - (guint)g_atomic_int_get(&ring->tail) >= member->block_nr) {
+            g_usleep(1000);
+            continue;
+        }
+        bd = (struct tpacket_block_desc *)(member->map +
+                                           (size_t)member->next_block * member->block_size);
+        if (!(g_atomic_int_get((gint *)&bd->hdr.bh1.block_status) & TP_STATUS_USER)) {
+            poll(&pfd, 1, CAP_READ_TIMEOUT);
+            continue;
+        }
+
+        queue_element = &ring->elements[ring->head & ring->mask];
+        queue_element->pd = (u_char *)bd;
+        queue_element->ts = (gint64)bd->hdr.bh1.ts_first_pkt.ts_sec * 1000000 +
+                            bd->hdr.bh1.ts_first_pkt.ts_nsec / 1000;
+        pcap_queue_commit(ring, 0);
+        member->next_block = (member->next_block + 1) % member->block_nr;
+    }
+
+    ws_info("Stopped thread for interface %d.", member->pcap_src->interface_id);
+    g_thread_exit(NULL);
+    return (NULL);
+}
+
+/*
+ * Write all the packets in a block from a TPACKET_V3 ring, and give
+ * the block back to the kernel.
+ */
+static void
+tpacket_write_block(capture_src *pcap_src, struct tpacket_block_desc *bd)
+{
+    struct tpacket3_hdr *ppd;
+    guint32              i;
+
+    ws_info("Dequeued a block of %u packets captured on interface %d.",
+            bd->hdr.bh1.num_pkts, pcap_src->interface_id);
+
+    ppd = (struct tpacket3_hdr *)((guint8 *)bd + bd->hdr.bh1.offset_to_first_pkt);
+    for (i = 0; i < bd->hdr.bh1.num_pkts; i++) {
+        struct pcap_pkthdr phdr;
+        const u_char      *pd = (const u_char *)ppd + ppd->tp_mac;
+
+        phdr.ts.tv_sec = ppd->tp_sec;
+        phdr.ts.tv_usec = pcap_src->ts_nsec ? ppd->tp_nsec : ppd->tp_nsec / 1000;
+        phdr.caplen = ppd->tp_snaplen;
+        phdr.len = ppd->tp_len;
+
+        /*
+         * The kernel strips the VLAN tag the NIC removed from the data;
+         * put it back, as libpcap does.
+         */
+        if ((ppd->tp_status & TP_STATUS_VLAN_VALID) && phdr.caplen >= 12) {
+            guint16 tpid = (ppd->tp_status & TP_STATUS_VLAN_TPID_VALID) ?
+                           ppd->hv1.tp_vlan_tpid : ETH_P_8021Q;
+
+            if (pcap_src->tpacket_buf_size < phdr.caplen + 4) {
+                pcap_src->tpacket_buf_size = phdr.caplen + 4;
+                pcap_src->tpacket_buf = (guint8 *)g_realloc(pcap_src->tpacket_buf,
+                                                            pcap_src->tpacket_buf_size);
+            }
+            memcpy(pcap_src->tpacket_buf, pd, 12);
+            pcap_src->tpacket_buf[12] = tpid >> 8;
+            pcap_src->tpacket_buf[13] = tpid & 0xff;
+            pcap_src->tpacket_buf[14] = ppd->hv1.tp_vlan_tci >> 8;
+            pcap_src->tpacket_buf[15] = ppd->hv1.tp_vlan_tci & 0xff;
+            memcpy(pcap_src->tpacket_buf + 16, pd + 12, phdr.caplen - 12);
+            pd = pcap_src->tpacket_buf;
+            phdr.caplen += 4;
+            phdr.len += 4;
+        }
+        if (phdr.caplen > (guint32)pcap_src->snaplen)
+            phdr.caplen = pcap_src->snaplen;
+
+        pcap_src->received++;
+        capture_loop_write_packet_cb((u_char *)pcap_src, &phdr, pd);
+        ppd = (struct tpacket3_hdr *)((guint8 *)ppd + ppd->tp_next_offset);
+    }
+
+    g_atomic_int_set((gint *)&bd->hdr.bh1.block_status, TP_STATUS_KERNEL);
+}
+
+/*
+ * Get the number of packets the kernel dropped because pcap_src's
+ * TPACKET_V3 rings were full.
+ */
+static guint64
+tpacket_drops(capture_src *pcap_src)
+{
+    guint i;
+
+    for (i = 0; i < pcap_src->tpacket_count; i++) {
+        struct tpacket_stats_v3 stats;
+        socklen_t               len = sizeof stats;
+
+        /* Reading the statistics resets them. */
+        if (getsockopt(pcap_src->tpacket[i].fd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0)
+            pcap_src->tpacket_drops += stats.tp_drops;
+    }
+    return pcap_src->tpacket_drops;
+}
+#endif /* DUMPCAP_TPACKET */
+
+#ifdef HAVE_AF_XDP
+static void
+xdp_close(capture_src *pcap_src)
+{
+    guint i;
+
+    if (pcap_src->xdp == NULL)
+        return;
+    for (i = 0; i < xdp_capture_queue_count(pcap_src->xdp); i++) {
+        if (pcap_src->xdp_readers[i].queue != NULL)
+            pcap_queue_ring_free(pcap_src->xdp_readers[i].queue);
+    }
+    g_free(pcap_src->xdp_readers);
+    pcap_src->xdp_readers = NULL;
+    xdp_capture_close(pcap_src->xdp);
+    pcap_src->xdp = NULL;
+    pcap_freecode(&pcap_src->xdp_filter);
+}
+
+/*
+ * Read from pcap_src's interface with an AF_XDP socket per receive
+ * queue rather than with libpcap.  As with tpacket_open(), the pcap_t
+ * stays open with a filter that rejects everything; the capture
+ * filter is applied by the writer thread, as the packets are
+ * redirected to the sockets before any socket filter could see them.
+ *
+ * Only Ethernet devices are handled.  Unlike the other ways of
+ * capturing, this takes the packets away from the host's network
+ * stack.
+ */
+static gboolean
+xdp_open(capture_src *pcap_src, interface_options *interface_opts,
+         char *errmsg, size_t errmsg_len)
+{
+    struct bpf_insn     reject = BPF_STMT(BPF_RET|BPF_K, 0);
+    struct bpf_program  reject_all;
+    guint               i;
+
+    if (pcap_src->linktype != DLT_EN10MB) {
+        snprintf(errmsg, errmsg_len, "the link-layer type isn't Ethernet");
+        return FALSE;
+    }
+    if (interface_opts->cfilter != NULL && *interface_opts->cfilter != '\0') {
+        if (pcap_compile(pcap_src->pcap_h, &pcap_src->xdp_filter, interface_opts->cfilter,
+                         1, PCAP_NETMASK_UNKNOWN) < 0) {
+            snprintf(errmsg, errmsg_len, "%s", pcap_geterr(pcap_src->pcap_h));
+            return FALSE;
+        }
+    }
+
+    pcap_src->xdp = xdp_capture_open(interface_opts->name, errmsg, errmsg_len);
+    if (pcap_src->xdp == NULL) {
+        pcap_freecode(&pcap_src->xdp_filter);
+        return FALSE;
+    }
+    pcap_src->xdp_readers = g_new0(xdp_reader, xdp_capture_queue_count(pcap_src->xdp));
+    for (i = 0; i < xdp_capture_queue_count(pcap_src->xdp); i++) {
+        xdp_reader *reader = &pcap_src->xdp_readers[i];
+
+        reader->pcap_src = pcap_src;
+        reader->queue_id = i;
+        /* Each batch has at least one packet, so this never fills up. */
+        reader->queue = pcap_queue_ring_new(xdp_capture_ring_size(pcap_src->xdp));
+    }
+
+    reject_all.bf_len = 1;
+    reject_all.bf_insns = &reject;
+    pcap_setfilter(pcap_src->pcap_h, &reject_all);
+
+    ws_info("Reading interface %u with %u AF_XDP sockets.",
+            pcap_src->interface_id, xdp_capture_queue_count(pcap_src->xdp));
+    return TRUE;
+}
+
+/*
+ * Hand each batch of packets that arrives on reader's receive queue to
+ * the writer thread.  AF_XDP doesn't give us the time packets arrived,
+ * so the whole batch gets the time we found it.
+ */
+static void *
+xdp_read_handler(void *arg)
+{
+    xdp_reader      *reader = (xdp_reader *)arg;
+    xdp_capture     *xc = reader->pcap_src->xdp;
+    pcap_queue_ring *ring = reader->queue;
+    struct pollfd    pfd;
+
+    if (reader->cpu >= 0) {
+        pin_thread_to_cpu(reader->cpu);
+        pcap_queue_ring_localize(ring);
+    }
+    ws_info("Started thread for interface %d.", reader->pcap_src->interface_id);
+
+    pfd.fd = xdp_capture_fd(xc, reader->queue_id);
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    while (global_ld.go) {
+        pcap_queue_element *queue_element;
+        guint32             first, count;
+
+        if (ring->head - (guint)g_atomic_int_get(&ring->tail) > ring->mask) {
+            g_usleep(1000);
+            continue;
+        }
+        count = xdp_capture_poll_rx(xc, reader->queue_id, &first);
+        if (count == 0) {
+            poll(&pfd, 1, CAP_READ_TIMEOUT);
+            continue;
+        }
+
+        queue_element = &ring->elements[ring->head & ring->mask];
+        queue_element->u.batch.queue = reader->queue_id;
+        queue_element->u.batch.first = first;
+        queue_element->u.batch.count = count;
+        queue_element->ts = g_get_real_time();
+        pcap_queue_commit(ring, 0);
+    }
+
+    ws_info("Stopped thread for interface %d.", reader->pcap_src->interface_id);
+    g_thread_exit(NULL);
+    return (NULL);
+}
+
+/*
+ * Write the packets in a batch from an AF_XDP socket that pass the
+ * capture filter, and give them all back to the kernel.
+ */
+static void
+xdp_write_batch(capture_src *pcap_src, pcap_queue_element *queue_element)
+{
+    guint32 i;
+
+    ws_info("Dequeued a batch of %u packets captured on interface %d.",
+            queue_element->u.batch.count, pcap_src->interface_id);
+
+    for (i = 0; i < queue_element->u.batch.count; i++) {
+        struct pcap_pkthdr phdr;
+        const u_char      *pd;
+        guint32            len;
+
+        pd = xdp_capture_rx_packet(pcap_src->xdp, queue_element->u.batch.queue,
+                                   queue_element->u.batch.first + i, &len);
+        phdr.ts.tv_sec = (time_t)(queue_element->ts / 1000000);
+        phdr.ts.tv_usec = (suseconds_t)(queue_element->ts % 1000000);
+        if (pcap_src->ts_nsec)
+            phdr.ts.tv_usec *= 1000;
+        phdr.caplen = len;
+        phdr.len = len;
+        if (pcap_src->xdp_filter.bf_insns != NULL &&
+            !pcap_offline_filter(&pcap_src->xdp_filter, &phdr, pd))
+            continue;
+        if (phdr.caplen > (guint32)pcap_src->snaplen)
+            phdr.caplen = pcap_src->snaplen;
+
+        pcap_src->received++;
+        capture_loop_write_packet_cb((u_char *)pcap_src, &phdr, pd);
+    }
+
+    xdp_capture_rx_release(pcap_src->xdp, queue_element->u.batch.queue,
+                           queue_element->u.batch.count);
+}
+#endif /* HAVE_AF_XDP */
+
+/*
+ * If ring isn't empty and the time stamp of its oldest element is
+ * earlier than *earliest_ts, or *earliest_ring is NULL, make it the
+ * earliest ring.  If it's empty, and empty_rings isn't NULL, count it.
+ */
+static void
+pcap_queue_check_earliest(pcap_queue_ring *ring, pcap_queue_ring **earliest_ring,
+                          gint64 *earliest_ts, guint *empty_rings)
+{
+    guint tail;
+
+    if (ring == NULL)
+        return;
+    tail = ring->tail;
+    if ((guint)g_atomic_int_get(&ring->head) == tail) {
+        if (empty_rings != NULL)
+            (*empty_rings)++;
+        return;
+    }
+    if (*earliest_ring == NULL || ring->elements[tail & ring->mask].ts < *earliest_ts) {
+        *earliest_ring = ring;
+        *earliest_ts = ring->elements[tail & ring->mask].ts;
+    }
+}
+
+/*
+ * Find the ring whose oldest queued packet has the earliest time
+ * stamp, so that packets from different interfaces are written in
+ * time order as far as possible, and return its source.  Sets
+ * *empty_rings to the number of rings of sources that are still open
+ * that have nothing queued, and so might yet queue an earlier packet.
+ */
+static capture_src *
+pcap_queue_earliest(pcap_queue_ring **earliest_ring, guint *empty_rings)
+{
+    guint        i;
+    capture_src *pcap_src, *earliest = NULL;
+    gint64       earliest_ts = 0;
+
+    *earliest_ring = NULL;
+    *empty_rings = 0;
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_queue_ring *ring = *earliest_ring;
+        guint           *empty;
+
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        empty = pcap_src->cap_pipe_err == PIPOK ? empty_rings : NULL;
+#ifdef DUMPCAP_TPACKET
+        if (pcap_src->tpacket) {
+            guint j;
+
+            for (j = 0; j < pcap_src->tpacket_count; j++) {
+                pcap_queue_check_earliest(pcap_src->tpacket[j].queue,
+                                          earliest_ring, &earliest_ts, empty);
+            }
+        } else
+#endif
+#ifdef HAVE_AF_XDP
+        if (pcap_src->xdp) {
+            guint j;
+
+            for (j = 0; j < xdp_capture_queue_count(pcap_src->xdp); j++) {
+                pcap_queue_check_earliest(pcap_src->xdp_readers[j].queue,
+                                          earliest_ring, &earliest_ts, empty);
+            }
+        } else
+#endif
+        pcap_queue_check_earliest(pcap_src->queue, earliest_ring, &earliest_ts, empty);
+        if (*earliest_ring != ring)
+            earliest = pcap_src;
+    }
+    return earliest;
+}
+
+/*
+ * With --reorder-window, hold back the oldest packet queued until
+ * every open source has queued something, so that none of them can
+ * still queue an earlier one, or until it's older than the window, or
+ * has been held back for that long, whichever is first; otherwise,
+ * packets are written as soon as they're the oldest queued.  Returns
+ * FALSE, and sets *end_time to the monotonic time until which to wait,
+ * if it can't be written yet.
+ */
+static gboolean
+pcap_queue_may_write(pcap_queue_ring *ring, guint empty_rings, gint64 *end_time)
+{
+    gint64 now, age, held;
+
+    if (reorder_window == 0 || empty_rings == 0 || !global_ld.go) {
+        reorder_held_since = 0;
+        return TRUE;
+    }
+    now = g_get_monotonic_time();
+    if (reorder_held_since == 0)
+        reorder_held_since = now;
+    held = now - reorder_held_since;
+    age = g_get_real_time() - ring->elements[ring->tail & ring->mask].ts;
+    if (age >= reorder_window || held >= reorder_window) {
+        reorder_held_since = 0;
+        return TRUE;
+    }
+    *end_time = now + reorder_window - MAX(age, held);
+    return FALSE;
+}
+
+/* Try to pop an item off the packet queues and if it exists, write it */
+static gboolean
+capture_loop_dequeue_packet(void) {
+    capture_src        *pcap_src;
+    pcap_queue_ring    *ring;
+    pcap_queue_element *queue_element;
+    guint               len;
+    guint               empty_rings;
+    gint64              end_time = 0;
+
+    pcap_src = pcap_queue_earliest(&ring, &empty_rings);
+    if (pcap_src == NULL || !pcap_queue_may_write(ring, empty_rings, &end_time)) {
+        /*
+         * Nothing we can write yet; wait for a capture thread to queue
+         * something, or until the reorder window lets us write what's
+         * queued.  Check again after saying we're waiting, so that we
+         * don't miss a packet committed in between.
+         */
+        if (pcap_src == NULL)
+            end_time = g_get_monotonic_time() + WRITER_THREAD_TIMEOUT;
+
+        g_mutex_lock(&pcap_queue_mutex);
+        g_atomic_int_set(&pcap_queue_writer_waiting, 1);
+        while ((pcap_src = pcap_queue_earliest(&ring, &empty_rings)) == NULL ||
+               !pcap_queue_may_write(ring, empty_rings, &end_time)) {
+            if (!g_cond_wait_until(&pcap_queue_cond, &pcap_queue_mutex, end_time)) {
+                /* We'll try again on the next call. */
+                pcap_src = NULL;
+                break;
+            }
+        }
+        g_atomic_int_set(&pcap_queue_writer_waiting, 0);
+        g_mutex_unlock(&pcap_queue_mutex);
+        if (pcap_src == NULL)
+            return FALSE;
+    }
+
+    queue_element = &ring->elements[ring->tail & ring->mask];
+#ifdef DUMPCAP_TPACKET
+    if (pcap_src->tpacket) {
+        /* The block is still in the mapped ring; nothing to account for. */
+        len = 0;
+        tpacket_write_block(pcap_src, (struct tpacket_block_desc *)queue_element->pd);
+    } else
+#endif
+#ifdef HAVE_AF_XDP
+    if (pcap_src->xdp) {
+        /* The packets are still in the UMEM; nothing to account for. */
+        len = 0;
+        xdp_write_batch(pcap_src, queue_element);
+    } else
+#endif
+    if (pcap_src->from_pcapng) {
+        len = queue_element->u.bh.block_total_length;
+        ws_info("Dequeued a block of type 0x%08x of length %d captured on interface %d.",
+              queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
+              pcap_src->interface_id);
+
+        capture_loop_write_pcapng_cb(pcap_src,
+                                    &queue_element->u.bh,
+                                    queue_element->pd);
+    } else {
+        len = queue_element->u.phdr.caplen;
+        ws_info("Dequeued a packet of length %d captured on interface %d.",
+            queue_element->u.phdr.caplen, pcap_src->interface_id);
+
+        capture_loop_write_packet_cb((u_char *) pcap_src,
+                                    &queue_element->u.phdr,
+                                    queue_element->pd);
+    }
+    g_atomic_int_add(&ring->bytes, -(gint)len);
+    g_atomic_int_set(&ring->tail, ring->tail + 1);
+    return TRUE;
+}
+
+/*
+ * Note: this code will never be run on any OS other than Windows.
+ *
+ * We keep the arguments in case there's something in the future
+ * that needs to be reported as an NPCAP bug.
+ */
+static char *
+handle_npcap_bug(char *adapter_name _U_, char *cap_err_str _U_)
+{
+    gboolean have_npcap = FALSE;
+
+#ifdef _WIN32
+    have_npcap = caplibs_have_npcap();
+#endif
+
+    if (!have_npcap) {
+        /*
+         * We're not using Npcap, so don't recomment a user
+         * file a bug against Npcap.
+         */
+        return g_strdup("");
+    }
+
+    return ws_strdup_printf("If you have not removed that adapter, this "
+                          "is probably a known issue in Npcap resulting from "
+                          "the behavior of the Windows networking stack. "
+                          "Work is being done in Npcap to improve the "
+                          "handling of this issue; it does not need to "
+                          "be reported as a Wireshark or Npcap bug.");
+}
+
+/* Do the low-level work of a capture.
+   Returns TRUE if it succeeds, FALSE otherwise. */
+static gboolean
+capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct pcap_stat *stats)
+{
+#ifdef _WIN32
+    DWORD             upd_time, cur_time; /* GetTickCount() returns a "DWORD" (which is 'unsigned long') */
+#else
+    struct timeval    upd_time, cur_time;
+#endif
+    int               err_close;
+    int               inpkts;
+    GTimer           *autostop_duration_timer = NULL;
+    gboolean          write_ok;
+    gboolean          close_ok;
+    gboolean          cfilter_error         = FALSE;
+    char              errmsg[MSG_MAX_LENGTH+1];
+    char              secondary_errmsg[MSG_MAX_LENGTH+1];
+    capture_src      *pcap_src;
+    interface_options *interface_opts;
+    guint             i, error_index        = 0;
+
+    *errmsg           = '\0';
+    *secondary_errmsg = '\0';
 
     /* init the loop data */
     global_ld.go                  = TRUE;
@@ -3965,6 +5096,25 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             snprintf(secondary_errmsg, sizeof(secondary_errmsg), "%s", please_report_bug());
             goto error;
         }
+#ifdef DUMPCAP_TPACKET
+        if (tpacket_fanout > 0 && !pcap_src->from_cap_pipe && pcap_src->pcap_h != NULL) {
+            if (!tpacket_open(pcap_src, interface_opts, errmsg, sizeof(errmsg))) {
+                ws_warning("Can't use TPACKET_V3 fanout on %s (%s); using libpcap.",
+                           interface_opts->display_name, errmsg);
+            }
+        }
+#endif
+#ifdef HAVE_AF_XDP
+        if (use_af_xdp && !pcap_src->from_cap_pipe && pcap_src->pcap_h != NULL) {
+            char xdp_errmsg[MSG_MAX_LENGTH+1];
+
+            if (!xdp_open(pcap_src, interface_opts, xdp_errmsg, sizeof(xdp_errmsg))) {
+                snprintf(errmsg, sizeof(errmsg), "Can't capture from %s with AF_XDP (%s).",
+                         interface_opts->display_name, xdp_errmsg);
+                goto error;
+            }
+        }
+#endif
     }
 
     /* If we're supposed to write to a capture file, open it for output
@@ -4031,15 +5181,66 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     /* WOW, everything is prepared! */
     /* please fasten your seat belts, we will enter now the actual capture loop */
     if (use_threads) {
-        pcap_queue = g_async_queue_new();
-        pcap_queue_bytes = 0;
-        pcap_queue_packets = 0;
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+#ifdef DUMPCAP_TPACKET
+            if (pcap_src->tpacket)
+                continue;
+#endif
+#ifdef HAVE_AF_XDP
+            if (pcap_src->xdp)
+                continue;
+#endif
+            /*
+             * Size the ring for the packet limit; if there's only a byte
+             * limit, assume the packets are small.
+             */
+            pcap_src->queue = pcap_queue_ring_new(pcap_queue_packet_limit > 0 ?
+                                                  pcap_queue_packet_limit :
+                                                  MIN(MAX(pcap_queue_byte_limit / 64, 1024), 1024 * 1024));
+        }
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            interface_opts = &g_array_index(capture_opts->ifaces, interface_options, i);
+#ifdef DUMPCAP_TPACKET
+            if (pcap_src->tpacket) {
+                guint j;
+
+                for (j = 0; j < pcap_src->tpacket_count; j++) {
+                    pcap_src->tpacket[j].cpu = reader_cpu_take(interface_opts->name);
+                    pcap_src->tpacket[j].tid = g_thread_new("Capture read",
+                                                            tpacket_read_handler,
+                                                            &pcap_src->tpacket[j]);
+                }
+                continue;
+            }
+#endif
+#ifdef HAVE_AF_XDP
+            if (pcap_src->xdp) {
+                guint j;
+
+                for (j = 0; j < xdp_capture_queue_count(pcap_src->xdp); j++) {
+                    pcap_src->xdp_readers[j].cpu = reader_cpu_take(interface_opts->name);
+                    pcap_src->xdp_readers[j].tid = g_thread_new("Capture read",
+                                                                xdp_read_handler,
+                                                                &pcap_src->xdp_readers[j]);
+                }
+                continue;
+            }
+#endif
             /* XXX - Add an interface name here? */
+            pcap_src->cpu = reader_cpu_take(interface_opts->name);
             pcap_src->tid = g_thread_new("Capture read", pcap_read_handler, pcap_src);
         }
     }
+#ifdef DUMPCAP_CPU_AFFINITY
+    if (writer_cpu >= 0) {
+        /* This thread writes the file. */
+        pin_thread_to_cpu(writer_cpu);
+        ws_message("Writing on CPU %d (NUMA node %d).", writer_cpu, cpu_numa_node(writer_cpu));
+    }
+#endif
+    stats_last_time = g_get_monotonic_time();
     while (global_ld.go) {
         /* dispatch incoming packets */
         if (use_threads) {
@@ -4114,6 +5315,13 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 *stats_known = TRUE;
             }
 #endif
+            if (stats_interval > 0) {
+                gint64 now = g_get_monotonic_time();
+
+                if (now - stats_last_time >= stats_interval)
+                    capture_stats_report(now);
+            }
+
             /* Let the parent process know. */
             if (global_ld.inpkts_to_sync_pipe) {
                 /* do sync here */
@@ -4156,6 +5364,22 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
             ws_info("Waiting for thread of interface %u...", pcap_src->interface_id);
+#ifdef DUMPCAP_TPACKET
+            if (pcap_src->tpacket) {
+                guint j;
+
+                for (j = 0; j < pcap_src->tpacket_count; j++)
+                    g_thread_join(pcap_src->tpacket[j].tid);
+            } else
+#endif
+#ifdef HAVE_AF_XDP
+            if (pcap_src->xdp) {
+                guint j;
+
+                for (j = 0; j < xdp_capture_queue_count(pcap_src->xdp); j++)
+                    g_thread_join(pcap_src->xdp_readers[j].tid);
+            } else
+#endif
             g_thread_join(pcap_src->tid);
             ws_info("Thread of interface %u terminated.", pcap_src->interface_id);
         }
@@ -4168,6 +5392,13 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 fflush(global_ld.pdh);
             }
         }
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            if (pcap_src->queue != NULL) {
+                pcap_queue_ring_free(pcap_src->queue);
+                pcap_src->queue = NULL;
+            }
+        }
     }
 
 
@@ -4350,6 +5581,14 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 *stats_known = TRUE;
                 /* Let the parent process know. */
                 pcap_dropped += stats->ps_drop;
+#ifdef DUMPCAP_TPACKET
+                if (pcap_src->tpacket)
+                    pcap_dropped += (guint32)tpacket_drops(pcap_src);
+#endif
+#ifdef HAVE_AF_XDP
+                if (pcap_src->xdp)
+                    pcap_dropped += (guint32)xdp_capture_drops(pcap_src->xdp);
+#endif
             } else {
                 snprintf(errmsg, sizeof(errmsg),
                            "Can't get packet-drop statistics: %s",
@@ -4358,6 +5597,9 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             }
         }
         report_packet_drops(received, pcap_dropped, pcap_src->dropped, pcap_src->flushed, stats->ps_ifdrop, interface_opts->display_name);
+        if (use_flow_snaplen) {
+            report_flow_snaplen(pcap_src, interface_opts->display_name);
+        }
     }
 
     /* close the input file (pcap or capture pipe) */
@@ -4469,6 +5711,105 @@ capture_loop_get_errmsg(char *errmsg, size_t errmsglen, char *secondary_errmsg,
     }
 }
 
+/*
+ * Add a write to the capture file that started at start, of len bytes,
+ * to the --stats-interval statistics.
+ */
+static void
+capture_stats_write_done(gint64 start, guint len)
+{
+    gint64 elapsed = g_get_monotonic_time() - start;
+    guint  bucket = 0;
+
+    while (bucket < STATS_WRITE_BUCKETS - 1 && elapsed >= ((gint64)1 << bucket))
+        bucket++;
+    stats_write_hist[bucket]++;
+    stats_write_bytes += len;
+}
+
+/*
+ * Take the most that's been queued on ring since we last looked, and
+ * start again.
+ */
+static void
+capture_stats_queue_high(pcap_queue_ring *ring, gint *bytes, gint *packets)
+{
+    if (ring == NULL)
+        return;
+    *bytes = MAX(*bytes, g_atomic_int_get(&ring->bytes_high));
+    *packets = MAX(*packets, g_atomic_int_get(&ring->packets_high));
+    g_atomic_int_set(&ring->bytes_high, 0);
+    g_atomic_int_set(&ring->packets_high, 0);
+}
+
+/*
+ * Report what happened since we last did, for --stats-interval: for each
+ * interface, the packets and bytes received, the packets dropped because
+ * the queue was full or flushed at the end, how long we spent in
+ * pcap_dispatch(), and the most that was queued for the writer; then how
+ * long writes to the capture file took.
+ */
+static void
+capture_stats_report(gint64 now)
+{
+    gint64       elapsed = now - stats_last_time;
+    capture_src *pcap_src;
+    GString     *str;
+    guint        i, j;
+
+    if (elapsed <= 0)
+        return;
+    str = g_string_new(NULL);
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        gint queue_bytes = 0, queue_packets = 0;
+        guint64 bytes;
+
+        pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+        capture_stats_queue_high(pcap_src->queue, &queue_bytes, &queue_packets);
+#ifdef DUMPCAP_TPACKET
+        for (j = 0; j < pcap_src->tpacket_count; j++)
+            capture_stats_queue_high(pcap_src->tpacket[j].queue, &queue_bytes, &queue_packets);
+#endif
+#ifdef HAVE_AF_XDP
+        if (pcap_src->xdp != NULL) {
+            for (j = 0; j < xdp_capture_queue_count(pcap_src->xdp); j++)
+                capture_stats_queue_high(pcap_src->xdp_readers[j].queue, &queue_bytes, &queue_packets);
+        }
+#endif
+        bytes = pcap_src->bytes_captured - pcap_src->stats_bytes;
+        g_string_printf(str,
+            "interface=%u packets=%u bytes=%" PRIu64 " bytes_per_s=%" PRIu64
+            " dropped=%u flushed=%u dispatch_calls=%u dispatch_us=%" PRIu64
+            " queue_bytes_max=%d queue_packets_max=%d",
+            pcap_src->interface_id,
+            pcap_src->received - pcap_src->stats_received,
+            bytes, bytes * G_USEC_PER_SEC / (guint64)elapsed,
+            pcap_src->dropped - pcap_src->stats_dropped,
+            pcap_src->flushed - pcap_src->stats_flushed,
+            pcap_src->dispatch_calls, pcap_src->dispatch_us,
+            queue_bytes, queue_packets);
+        report_capture_stats(str->str);
+
+        pcap_src->stats_received = pcap_src->received;
+        pcap_src->stats_dropped = pcap_src->dropped;
+        pcap_src->stats_flushed = pcap_src->flushed;
+        pcap_src->stats_bytes = pcap_src->bytes_captured;
+        pcap_src->dispatch_calls = 0;
+        pcap_src->dispatch_us = 0;
+    }
+
+    g_string_printf(str, "interval_us=%" PRId64 " write_bytes=%" PRIu64 " write_us=",
+                    elapsed, stats_write_bytes);
+    for (j = 0; j < STATS_WRITE_BUCKETS; j++) {
+        g_string_append_printf(str, "%s%" PRIu64, j ? "," : "", stats_write_hist[j]);
+        stats_write_hist[j] = 0;
+    }
+    report_capture_stats(str->str);
+    stats_write_bytes = 0;
+    stats_last_time = now;
+    g_string_free(str, TRUE);
+}
+
 /*
  * We wrote one packet. Update some statistics and check if we've met any
  * autostop or ring buffer conditions.
@@ -4546,6 +5887,10 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
 
     if (global_ld.pdh) {
         gboolean successful;
+        gint64 start = 0;
+
+        if (stats_interval > 0)
+            start = g_get_monotonic_time();
 
         /* We're supposed to write the packet to a file; do so.
            If this fails, set "ld->go" to FALSE, to stop the capture, and set
@@ -4556,6 +5901,8 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
                                        &global_ld.bytes_written, &err);
 
         fflush(global_ld.pdh);
+        if (stats_interval > 0)
+            capture_stats_write_done(start, bh->block_total_length);
         if (!successful) {
             global_ld.go = FALSE;
             global_ld.err = err;
@@ -4586,6 +5933,7 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
     capture_src *pcap_src = (capture_src *) (void *) pcap_src_p;
     int          err;
     guint        ts_mul    = pcap_src->ts_nsec ? 1000000000 : 1000000;
+    guint32      caplen    = phdr->caplen;
 
     ws_debug("capture_loop_write_packet_cb");
 
@@ -4597,8 +5945,21 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
+    pcap_src->bytes_received += phdr->len;
+    pcap_src->bytes_captured += phdr->caplen;
+    if (pcap_src->flows != NULL) {
+        caplen = flow_snaplen_caplen(pcap_src->flows, pcap_src->linktype, pd, phdr->caplen);
+        if (caplen < phdr->caplen)
+            pcap_src->truncated++;
+    }
+    pcap_src->bytes_kept += caplen;
+
     if (global_ld.pdh) {
         gboolean successful;
+        gint64 start = 0;
+
+        if (stats_interval > 0)
+            start = g_get_monotonic_time();
 
         /* We're supposed to write the packet to a file; do so.
            If this fails, set "ld->go" to FALSE, to stop the capture, and set
@@ -4607,7 +5968,7 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
             successful = pcapng_write_enhanced_packet_block(global_ld.pdh,
                                                             NULL,
                                                             phdr->ts.tv_sec, (gint32)phdr->ts.tv_usec,
-                                                            phdr->caplen, phdr->len,
+                                                            caplen, phdr->len,
                                                             pcap_src->interface_id,
                                                             ts_mul,
                                                             pd, 0,
@@ -4615,10 +5976,12 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         } else {
             successful = libpcap_write_packet(global_ld.pdh,
                                               phdr->ts.tv_sec, (gint32)phdr->ts.tv_usec,
-                                              phdr->caplen, phdr->len,
+                                              caplen, phdr->len,
                                               pd,
                                               &global_ld.bytes_written, &err);
         }
+        if (stats_interval > 0)
+            capture_stats_write_done(start, caplen);
         if (!successful) {
             global_ld.go = FALSE;
             global_ld.err = err;
@@ -4626,7 +5989,7 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         } else {
 #if defined(DEBUG_DUMPCAP) || defined(DEBUG_CHILD_DUMPCAP)
             ws_info("Wrote a pcap packet of length %d captured on interface %u.",
-                   phdr->caplen, pcap_src->interface_id);
+                   caplen, pcap_src->interface_id);
 #endif
             capture_loop_wrote_one_packet(pcap_src);
         }
@@ -4640,7 +6003,6 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
 {
     capture_src        *pcap_src = (capture_src *) (void *) pcap_src_p;
     pcap_queue_element *queue_element;
-    gboolean            limit_reached;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4650,46 +6012,22 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
+    queue_element = pcap_queue_reserve(pcap_src, phdr->caplen);
     if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.phdr = *phdr;
-    queue_element->pd = (u_char *)g_malloc(phdr->caplen);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, phdr->caplen);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += phdr->caplen;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         ws_info("Dropped a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
-    } else {
-        pcap_src->received++;
-        ws_info("Queued a packet of length %d captured on interface %u.",
-              phdr->caplen, pcap_src->interface_id);
+        return;
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
-    ws_info("Queue size is now %" PRId64 " bytes (%" PRId64 " packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+    queue_element->u.phdr = *phdr;
+    queue_element->ts = (gint64)phdr->ts.tv_sec * 1000000 +
+        (pcap_src->ts_nsec ? phdr->ts.tv_usec / 1000 : phdr->ts.tv_usec);
+    memcpy(queue_element->pd, pd, phdr->caplen);
+    pcap_queue_commit(pcap_src->queue, phdr->caplen);
+
+    pcap_src->received++;
+    ws_info("Queued a packet of length %d captured on interface %u.",
+          phdr->caplen, pcap_src->interface_id);
 }
 
 /* one pcapng block was captured, queue it */
@@ -4697,7 +6035,6 @@ static void
 capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd)
 {
     pcap_queue_element *queue_element;
-    gboolean            limit_reached;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4707,46 +6044,25 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
+    queue_element = pcap_queue_reserve(pcap_src, bh->block_total_length);
     if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.bh = *bh;
-    queue_element->pd = (u_char *)g_malloc(bh->block_total_length);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, bh->block_total_length);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += bh->block_total_length;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         ws_info("Dropped a packet of length %d captured on interface %u.",
               bh->block_total_length, pcap_src->interface_id);
-    } else {
-        pcap_src->received++;
-        ws_info("Queued a block of type 0x%08x of length %d captured on interface %u.",
-              bh->block_type, bh->block_total_length, pcap_src->interface_id);
+        return;
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
-    ws_info("Queue size is now %" PRId64 " bytes (%" PRId64 " packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+    queue_element->u.bh = *bh;
+    /*
+     * The time stamps in pcapng blocks depend on the resolution of
+     * their interface, so order them by the time they arrived here.
+     */
+    queue_element->ts = g_get_real_time();
+    memcpy(queue_element->pd, pd, bh->block_total_length);
+    pcap_queue_commit(pcap_src->queue, bh->block_total_length);
+
+    pcap_src->received++;
+    ws_info("Queued a block of type 0x%08x of length %d captured on interface %u.",
+          bh->block_type, bh->block_total_length, pcap_src->interface_id);
 }
 
 static int
@@ -4808,6 +6124,39 @@ out:
     return ret;
 }
 
+#ifdef DUMPCAP_CPU_AFFINITY
+/*
+ * Parse a list of CPUs and ranges of them, e.g. "2,4-7", for
+ * --reader-cpus, appending them to *cpus.
+ */
+static gboolean
+parse_cpu_list(const char *list, GArray **cpus)
+{
+    gchar  **items = g_strsplit(list, ",", -1);
+    gchar  **range;
+    int      first, last, cpu;
+    guint    i;
+    gboolean ok = TRUE;
+
+    if (*cpus == NULL)
+        *cpus = g_array_new(FALSE, FALSE, sizeof (int));
+    for (i = 0; ok && items[i] != NULL; i++) {
+        range = g_strsplit(items[i], "-", 2);
+        first = get_natural_int(range[0], "CPU");
+        last = range[1] != NULL ? get_natural_int(range[1], "CPU") : first;
+        if (last < first || last >= CPU_SETSIZE) {
+            cmdarg_err("Invalid CPU range \"%s\"", items[i]);
+            ok = FALSE;
+        }
+        for (cpu = first; ok && cpu <= last; cpu++)
+            g_array_append_val(*cpus, cpu);
+        g_strfreev(range);
+    }
+    g_strfreev(items);
+    return ok;
+}
+#endif
+
 static void
 gather_dumpcap_compiled_info(feature_list l)
 {
@@ -4825,6 +6174,13 @@ gather_dumpcap_runtime_info(feature_list l)
 #define LONGOPT_IFNAME             LONGOPT_BASE_APPLICATION+1
 #define LONGOPT_IFDESCR            LONGOPT_BASE_APPLICATION+2
 #define LONGOPT_CAPTURE_COMMENT    LONGOPT_BASE_APPLICATION+3
+#define LONGOPT_TPACKET_FANOUT     LONGOPT_BASE_APPLICATION+4
+#define LONGOPT_AF_XDP             LONGOPT_BASE_APPLICATION+5
+#define LONGOPT_FLOW_SNAPLEN       LONGOPT_BASE_APPLICATION+6
+#define LONGOPT_REORDER_WINDOW     LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_STATS_INTERVAL     LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_READER_CPUS        LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_WRITER_CPU         LONGOPT_BASE_APPLICATION+10
 
 /* And now our feature presentation... [ fade to music ] */
 int
@@ -4839,6 +6195,13 @@ main(int argc, char *argv[])
         {"ifname", ws_required_argument, NULL, LONGOPT_IFNAME},
         {"ifdescr", ws_required_argument, NULL, LONGOPT_IFDESCR},
         {"capture-comment", ws_required_argument, NULL, LONGOPT_CAPTURE_COMMENT},
+        {"tpacket-fanout", ws_required_argument, NULL, LONGOPT_TPACKET_FANOUT},
+        {"af-xdp", ws_no_argument, NULL, LONGOPT_AF_XDP},
+        {"flow-snaplen", ws_required_argument, NULL, LONGOPT_FLOW_SNAPLEN},
+        {"reorder-window", ws_required_argument, NULL, LONGOPT_REORDER_WINDOW},
+        {"stats-interval", ws_required_argument, NULL, LONGOPT_STATS_INTERVAL},
+        {"reader-cpus", ws_required_argument, NULL, LONGOPT_READER_CPUS},
+        {"writer-cpu", ws_required_argument, NULL, LONGOPT_WRITER_CPU},
         {0, 0, 0, 0 }
     };
 
@@ -5168,6 +6531,7 @@ main(int argc, char *argv[])
 #endif
         case LONGOPT_COMPRESS_TYPE:        /* compress type */
         case LONGOPT_CAPTURE_TMPDIR:       /* capture temp directory */
+        case LONGOPT_LIVE_SHM:             /* live capture in shared memory */
             status = capture_opts_add_opt(&global_capture_opts, opt, ws_optarg);
             if (status != 0) {
                 exit_main(status);
@@ -5202,6 +6566,61 @@ main(int argc, char *argv[])
             }
             g_ptr_array_add(capture_comments, g_strdup(ws_optarg));
             break;
+        case LONGOPT_TPACKET_FANOUT:
+#ifdef DUMPCAP_TPACKET
+            tpacket_fanout = get_positive_int(ws_optarg, "TPACKET fanout socket count");
+#else
+            cmdarg_err("--tpacket-fanout is only supported on Linux");
+            arg_error = TRUE;
+#endif
+            break;
+        case LONGOPT_AF_XDP:
+#ifdef HAVE_AF_XDP
+            use_af_xdp = TRUE;
+#else
+            cmdarg_err("--af-xdp is only supported on Linux, if dumpcap was built with AF_XDP support");
+            arg_error = TRUE;
+#endif
+            break;
+        case LONGOPT_FLOW_SNAPLEN:
+        {
+            gchar **parts = g_strsplit(ws_optarg, ":", 2);
+
+            use_flow_snaplen = TRUE;
+            flow_snaplen_packets = get_natural_int(parts[0], "flow snapshot packet count");
+            if (parts[1] != NULL) {
+                flow_snaplen_payload = get_natural_int(parts[1], "flow snapshot payload length");
+            }
+            g_strfreev(parts);
+            break;
+        }
+        case LONGOPT_REORDER_WINDOW:
+            reorder_window = (gint64)get_natural_int(ws_optarg, "reorder window") * 1000;
+            break;
+        case LONGOPT_STATS_INTERVAL:
+            stats_interval = (gint64)get_positive_int(ws_optarg, "statistics interval") * G_USEC_PER_SEC;
+            break;
+        case LONGOPT_READER_CPUS:
+#ifdef DUMPCAP_CPU_AFFINITY
+            if (!parse_cpu_list(ws_optarg, &reader_cpus))
+                arg_error = TRUE;
+#else
+            cmdarg_err("--reader-cpus isn't supported on this platform");
+            arg_error = TRUE;
+#endif
+            break;
+        case LONGOPT_WRITER_CPU:
+#ifdef DUMPCAP_CPU_AFFINITY
+            writer_cpu = get_natural_int(ws_optarg, "writer CPU");
+            if (writer_cpu >= CPU_SETSIZE) {
+                cmdarg_err("The writer CPU must be less than %d", CPU_SETSIZE);
+                arg_error = TRUE;
+            }
+#else
+            cmdarg_err("--writer-cpu isn't supported on this platform");
+            arg_error = TRUE;
+#endif
+            break;
         case 'Z':
             capture_child = TRUE;
 #ifdef _WIN32
@@ -5308,6 +6727,24 @@ main(int argc, char *argv[])
     if ((pcap_queue_byte_limit > 0) || (pcap_queue_packet_limit > 0)) {
         use_threads = TRUE;
     }
+#ifdef DUMPCAP_TPACKET
+    if (tpacket_fanout > 0) {
+        /* The fanout sockets are read by threads of their own. */
+        use_threads = TRUE;
+    }
+#endif
+#ifdef HAVE_AF_XDP
+    if (use_af_xdp) {
+        /* So are the AF_XDP sockets. */
+        use_threads = TRUE;
+    }
+#endif
+#ifdef DUMPCAP_CPU_AFFINITY
+    if (reader_cpus != NULL) {
+        /* Only threads of their own can be pinned away from the writer. */
+        use_threads = TRUE;
+    }
+#endif
     if ((pcap_queue_byte_limit == 0) && (pcap_queue_packet_limit == 0)) {
         /* Use some default if the user hasn't specified some */
         /* XXX: Are these defaults good enough? */
@@ -5756,6 +7193,43 @@ report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32
     }
 }
 
+/*
+ * With --flow-snaplen, report how much of what passed the capture filter
+ * we wrote.
+ */
+static void
+report_flow_snaplen(capture_src *pcap_src, gchar *name)
+{
+    if (capture_child) {
+        ws_debug("Bytes received/captured/written on interface '%s': %" PRIu64 "/%" PRIu64 "/%" PRIu64 " (%u packets truncated)",
+            name, pcap_src->bytes_received, pcap_src->bytes_captured, pcap_src->bytes_kept, pcap_src->truncated);
+    } else {
+        fprintf(stderr,
+            "Bytes received/captured/written on interface '%s': %" PRIu64 "/%" PRIu64 "/%" PRIu64 " (%.1f%%), %u packets truncated\n",
+            name, pcap_src->bytes_received, pcap_src->bytes_captured, pcap_src->bytes_kept,
+            pcap_src->bytes_captured ? 100.0 * pcap_src->bytes_kept / pcap_src->bytes_captured : 0.0,
+            pcap_src->truncated);
+        fflush(stderr);
+    }
+}
+
+/*
+ * With --stats-interval, send our parent, or write to the standard
+ * error, one line of capture statistics, as space-separated key=value
+ * pairs.
+ */
+static void
+report_capture_stats(const char *stats)
+{
+    if (capture_child) {
+        ws_debug("Statistics: %s", stats);
+        pipe_write_block(2, SP_STATS, stats);
+    } else {
+        fprintf(stderr, "Statistics: %s\n", stats);
+        fflush(stderr);
+    }
+}
+
 
 /************************************************************************************************/
 /* signal_pipe handling */
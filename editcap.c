@@ -99,6 +99,19 @@ static fd_hash_t fd_hash[MAX_DUP_DEPTH];
 static int       dup_window    = DEFAULT_DUP_DEPTH;
 static int       cur_dup_entry = 0;
 
+/*
+ * For -d and -D, the number of entries in the fd_hash[] window with
+ * each digest and length, so that a packet can be checked against the
+ * window without comparing it with every entry in it.  Each count holds
+ * its own key, and is changed in place.
+ */
+typedef struct {
+    fd_hash_t  entry;
+    guint      count;
+} fd_hash_count_t;
+
+static GHashTable *fd_hash_counts = NULL;
+
 static guint32   ignored_bytes  = 0;  /* Used with -I */
 
 #define ONE_BILLION 1000000000
@@ -141,6 +154,7 @@ static guint                  max_selected              = 0;
 static gboolean               keep_em                   = FALSE;
 static int                    out_file_type_subtype     = WTAP_FILE_TYPE_SUBTYPE_UNKNOWN;
 static int                    out_frame_type            = -2; /* Leave frame type alone */
+static wtap_compression_type  out_compression_type      = WTAP_UNCOMPRESSED;
 static gboolean               verbose                   = FALSE; /* Not so verbose         */
 static struct time_adjustment time_adj                  = {NSTIME_INIT_ZERO, 0}; /* no adjustment */
 static nstime_t               relative_time_window      = NSTIME_INIT_ZERO; /* de-dup time window */
@@ -156,6 +170,9 @@ static gboolean               dup_detect_by_time        = FALSE;
 static gboolean               skip_radiotap             = FALSE;
 static gboolean               discard_all_secrets       = FALSE;
 static gboolean               discard_cap_comments      = FALSE;
+static gboolean               write_record_index        = FALSE;
+static gboolean               threaded_write            = FALSE;
+static guint32                split_threads             = 0;
 
 static int                    do_strict_time_adjustment = FALSE;
 static struct time_adjustment strict_time_adj           = {NSTIME_INIT_ZERO, 0}; /* strict time adjustment */
@@ -570,10 +587,29 @@ remove_vlan_info(const wtap_packet_header *phdr, guint8* fd, guint32* len) {
     }
 }
 
+static guint
+fd_hash_hash(gconstpointer key)
+{
+    const fd_hash_t *entry = (const fd_hash_t *)key;
+
+    /* The digest is already well mixed. */
+    return pntoh32(entry->digest) ^ entry->len;
+}
+
+static gboolean
+fd_hash_equal(gconstpointer a, gconstpointer b)
+{
+    const fd_hash_t *entry_a = (const fd_hash_t *)a;
+    const fd_hash_t *entry_b = (const fd_hash_t *)b;
+
+    return entry_a->len == entry_b->len
+        && memcmp(entry_a->digest, entry_b->digest, 16) == 0;
+}
+
 static gboolean
 is_duplicate(guint8* fd, guint32 len) {
-    int i;
     const struct ieee80211_radiotap_header* tap_header;
+    fd_hash_count_t *count;
 
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
@@ -599,22 +635,31 @@ is_duplicate(guint8* fd, guint32 len) {
     if (cur_dup_entry >= dup_window)
         cur_dup_entry = 0;
 
+    /*
+     * The entry we're about to replace drops out of the window.  (An
+     * entry that hasn't been used yet has a zero digest and length,
+     * which no packet has, so it won't be found.)
+     */
+    count = (fd_hash_count_t *)g_hash_table_lookup(fd_hash_counts, &fd_hash[cur_dup_entry]);
+    if (count != NULL && --count->count == 0)
+        g_hash_table_remove(fd_hash_counts, &fd_hash[cur_dup_entry]);
+
     /* Calculate our digest */
     gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
 
     fd_hash[cur_dup_entry].len = len;
 
-    /* Look for duplicates */
-    for (i = 0; i < dup_window; i++) {
-        if (i == cur_dup_entry)
-            continue;
-
-        if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-            && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
-        }
+    /* Look for duplicates among the rest of the window */
+    count = (fd_hash_count_t *)g_hash_table_lookup(fd_hash_counts, &fd_hash[cur_dup_entry]);
+    if (count != NULL) {
+        count->count++;
+        return TRUE;
     }
 
+    count = g_new(fd_hash_count_t, 1);
+    count->entry = fd_hash[cur_dup_entry];
+    count->count = 1;
+    g_hash_table_insert(fd_hash_counts, &count->entry, count);
     return FALSE;
 }
 
@@ -835,6 +880,13 @@ print_usage(FILE *output)
     fprintf(output, "                         when writing the output file.  Does not discard\n");
     fprintf(output, "                         comments added by \"--capture-comment\" in the same\n");
     fprintf(output, "                         command line.\n");
+    fprintf(output, "  --compress <type>      compress the output file; <type> is \"gzip\",\n");
+    fprintf(output, "                         \"zstd\" or \"none\" (the default).\n");
+    fprintf(output, "  --record-index         write an index of the packets at the end of pcapng\n");
+    fprintf(output, "                         output files, for fast seeking by other tools.\n");
+    fprintf(output, "  --threaded-write       write (and compress) output on a separate thread.\n");
+    fprintf(output, "  --threads <n>          with -c or -i, and an input file with a record\n");
+    fprintf(output, "                         index, write up to <n> output files at once.\n");
     fprintf(output, "\n");
     fprintf(output, "Miscellaneous:\n");
     fprintf(output, "  -h, --help             display this help and exit.\n");
@@ -977,10 +1029,10 @@ editcap_dump_open(const char *filename, const wtap_dump_params *params,
 
     if (strcmp(filename, "-") == 0) {
         /* Write to the standard output. */
-        pdh = wtap_dump_open_stdout(out_file_type_subtype, WTAP_UNCOMPRESSED,
+        pdh = wtap_dump_open_stdout(out_file_type_subtype, out_compression_type,
                                     params, err, err_info);
     } else {
-        pdh = wtap_dump_open(filename, out_file_type_subtype, WTAP_UNCOMPRESSED,
+        pdh = wtap_dump_open(filename, out_file_type_subtype, out_compression_type,
                              params, err, err_info);
     }
     if (pdh == NULL)
@@ -1100,6 +1152,275 @@ process_new_idbs(wtap *wth, wtap_dumper *pdh, GArray *idbs_seen,
     return TRUE;
 }
 
+/*
+ * With --threads, when splitting an input file that has a record index,
+ * each output file is written by a job on a thread pool, which reads
+ * its records with its own handle on the input file.  The split points
+ * are worked out beforehand from the time stamps in the index.
+ */
+typedef enum {
+    SPLIT_OK,
+    SPLIT_OPEN_FAILED,
+    SPLIT_DUMP_OPEN_FAILED,
+    SPLIT_READ_FAILED,
+    SPLIT_WRITE_FAILED,
+    SPLIT_CLOSE_FAILED
+} split_status_t;
+
+typedef struct {
+    char           *filename;
+    guint32         first_record;   /* counting from 0 */
+    guint32         end_record;     /* one past the last one */
+    split_status_t  status;
+    guint32         failed_record;  /* counting from 1, for messages */
+    int             err;
+    gchar          *err_info;
+} split_job_t;
+
+typedef struct {
+    const char             *infile;
+    wtap                   *index_wth;  /* only used to look up the index */
+    const wtap_dump_params *params;
+    GArray                 *idbs;
+    /*
+     * Opening and closing files touches the blocks in params and the
+     * file type tables, which aren't thread-safe, so only one job does
+     * that at a time; reading and writing records is done in parallel.
+     */
+    GMutex                  open_close_mutex;
+} split_context_t;
+
+static split_job_t *
+split_job_new(GPtrArray *jobs, guint32 first_record, const wtap_rec *rec,
+              gchar *fprefix, gchar *fsuffix)
+{
+    split_job_t *job = g_new0(split_job_t, 1);
+
+    job->filename = fileset_get_filename_by_pattern(jobs->len, rec, fprefix, fsuffix);
+    job->first_record = first_record;
+    g_ptr_array_add(jobs, job);
+    return job;
+}
+
+/*
+ * Add a job for each output file that splitting the records in the
+ * input file's index would produce, in the same way the main loop does.
+ */
+static GPtrArray *
+split_jobs_from_index(wtap *index_wth, guint32 split_packet_count,
+                      const nstime_t *secs_per_block, gchar *fprefix,
+                      gchar *fsuffix)
+{
+    GPtrArray *jobs = g_ptr_array_new();
+    guint32 num_records = wtap_get_record_index_count(index_wth);
+    nstime_t block_next = NSTIME_INIT_UNSET;
+    split_job_t *job = NULL;
+    wtap_rec rec;
+
+    memset(&rec, 0, sizeof rec);
+    for (guint32 i = 0; i < num_records; i++) {
+        const wtap_record_index_entry *entry = wtap_get_record_index_entry(index_wth, i);
+
+        /* The index has a time stamp for every record. */
+        rec.presence_flags = WTAP_HAS_TS;
+        rec.ts = entry->ts;
+
+        if (job == NULL) {
+            job = split_job_new(jobs, i, &rec, fprefix, fsuffix);
+        } else if (split_packet_count != 0 &&
+                   i - job->first_record == split_packet_count) {
+            job->end_record = i;
+            job = split_job_new(jobs, i, &rec, fprefix, fsuffix);
+        }
+
+        if (!nstime_is_unset(secs_per_block)) {
+            if (nstime_is_unset(&block_next)) {
+                block_next = rec.ts;
+                nstime_add(&block_next, secs_per_block);
+            }
+            /* This makes an empty file for each interval with no records. */
+            while (nstime_cmp(&rec.ts, &block_next) > 0) {
+                job->end_record = i;
+                nstime_add(&block_next, secs_per_block);
+                job = split_job_new(jobs, i, &rec, fprefix, fsuffix);
+            }
+        }
+    }
+    if (job != NULL)
+        job->end_record = num_records;
+    return jobs;
+}
+
+static void
+split_job_run(gpointer data, gpointer user_data)
+{
+    split_job_t *job = (split_job_t *)data;
+    split_context_t *ctx = (split_context_t *)user_data;
+    wtap *wth;
+    wtap_dumper *pdh;
+    wtap_rec rec;
+    Buffer buf;
+    int err;
+    gchar *err_info = NULL;
+
+    g_mutex_lock(&ctx->open_close_mutex);
+    wth = wtap_open_offline(ctx->infile, WTAP_TYPE_AUTO, &job->err, &job->err_info, TRUE);
+    if (wth == NULL) {
+        g_mutex_unlock(&ctx->open_close_mutex);
+        job->status = SPLIT_OPEN_FAILED;
+        return;
+    }
+    pdh = editcap_dump_open(job->filename, ctx->params, ctx->idbs, &job->err, &job->err_info);
+    if (pdh == NULL) {
+        wtap_close(wth);
+        g_mutex_unlock(&ctx->open_close_mutex);
+        job->status = SPLIT_DUMP_OPEN_FAILED;
+        return;
+    }
+    g_mutex_unlock(&ctx->open_close_mutex);
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    for (guint32 i = job->first_record; i < job->end_record; i++) {
+        const wtap_record_index_entry *entry = wtap_get_record_index_entry(ctx->index_wth, i);
+
+        if (!wtap_seek_read(wth, entry->offset, &rec, &buf, &job->err, &job->err_info)) {
+            job->status = SPLIT_READ_FAILED;
+            job->failed_record = i + 1;
+            break;
+        }
+        if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), &job->err, &job->err_info)) {
+            job->status = SPLIT_WRITE_FAILED;
+            job->failed_record = i + 1;
+            break;
+        }
+        wtap_rec_reset(&rec);
+    }
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+
+    g_mutex_lock(&ctx->open_close_mutex);
+    if (!wtap_dump_close(pdh, NULL, &err, &err_info)) {
+        if (job->status == SPLIT_OK) {
+            job->status = SPLIT_CLOSE_FAILED;
+            job->err = err;
+            job->err_info = err_info;
+        } else {
+            g_free(err_info);
+        }
+    }
+    wtap_close(wth);
+    g_mutex_unlock(&ctx->open_close_mutex);
+}
+
+/*
+ * Split the input file on split_threads threads.  Returns FALSE, without
+ * writing anything, if the input file has no record index.
+ */
+static gboolean
+split_in_parallel(const char *infile, const char *outfile,
+                  const wtap_dump_params *params, guint32 split_packet_count,
+                  const nstime_t *secs_per_block, int *ret)
+{
+    split_context_t ctx;
+    wtap *index_wth;
+    wtap_block_t if_data;
+    gchar *fprefix, *fsuffix;
+    GPtrArray *jobs;
+    GThreadPool *pool;
+    int err;
+    gchar *err_info;
+
+    /* Only files opened for random access have their index read. */
+    index_wth = wtap_open_offline(infile, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    if (index_wth == NULL) {
+        cfile_open_failure_message(infile, err, err_info);
+        *ret = INVALID_FILE;
+        return TRUE;
+    }
+    if (wtap_get_record_index_count(index_wth) == 0) {
+        wtap_close(index_wth);
+        return FALSE;
+    }
+    if (!fileset_extract_prefix_suffix(outfile, &fprefix, &fsuffix)) {
+        wtap_close(index_wth);
+        *ret = CANT_EXTRACT_PREFIX;
+        return TRUE;
+    }
+
+    ctx.infile = infile;
+    ctx.index_wth = index_wth;
+    ctx.params = params;
+    ctx.idbs = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
+    while ((if_data = wtap_get_next_interface_description(index_wth)) != NULL) {
+        wtap_block_t if_data_copy = wtap_block_make_copy(if_data);
+        g_array_append_val(ctx.idbs, if_data_copy);
+    }
+    g_mutex_init(&ctx.open_close_mutex);
+
+    jobs = split_jobs_from_index(index_wth, split_packet_count, secs_per_block,
+                                 fprefix, fsuffix);
+    g_free(fprefix);
+    g_free(fsuffix);
+
+    pool = g_thread_pool_new(split_job_run, &ctx, (gint)split_threads, TRUE, NULL);
+    for (guint i = 0; i < jobs->len; i++)
+        g_thread_pool_push(pool, jobs->pdata[i], NULL);
+    /* Wait for all the jobs to finish. */
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    for (guint i = 0; i < jobs->len; i++) {
+        split_job_t *job = (split_job_t *)jobs->pdata[i];
+
+        if (verbose && job->status == SPLIT_OK)
+            fprintf(stderr, "Wrote records %u to %u to file %s\n",
+                    job->first_record + 1, job->end_record, job->filename);
+        switch (job->status) {
+
+        case SPLIT_OK:
+            break;
+
+        case SPLIT_OPEN_FAILED:
+            cfile_open_failure_message(infile, job->err, job->err_info);
+            *ret = INVALID_FILE;
+            break;
+
+        case SPLIT_DUMP_OPEN_FAILED:
+            cfile_dump_open_failure_message(job->filename, job->err, job->err_info,
+                                            out_file_type_subtype);
+            *ret = INVALID_FILE;
+            break;
+
+        case SPLIT_READ_FAILED:
+            cfile_read_failure_message(infile, job->err, job->err_info);
+            *ret = INVALID_FILE;
+            break;
+
+        case SPLIT_WRITE_FAILED:
+            cfile_write_failure_message(infile, job->filename, job->err,
+                                        job->err_info, job->failed_record,
+                                        out_file_type_subtype);
+            *ret = DUMP_ERROR;
+            break;
+
+        case SPLIT_CLOSE_FAILED:
+            cfile_close_failure_message(job->filename, job->err, job->err_info);
+            *ret = WRITE_ERROR;
+            break;
+        }
+        g_free(job->filename);
+        g_free(job);
+    }
+    g_ptr_array_free(jobs, TRUE);
+
+    g_mutex_clear(&ctx.open_close_mutex);
+    for (guint i = 0; i < ctx.idbs->len; i++)
+        wtap_block_unref(g_array_index(ctx.idbs, wtap_block_t, i));
+    g_array_free(ctx.idbs, TRUE);
+    wtap_close(index_wth);
+    return TRUE;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -1128,6 +1449,10 @@ main(int argc, char *argv[])
 #define LONGOPT_DISCARD_ALL_SECRETS  LONGOPT_BASE_APPLICATION+5
 #define LONGOPT_CAPTURE_COMMENT      LONGOPT_BASE_APPLICATION+6
 #define LONGOPT_DISCARD_CAPTURE_COMMENT LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_COMPRESS             LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_RECORD_INDEX         LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_THREADED_WRITE       LONGOPT_BASE_APPLICATION+10
+#define LONGOPT_THREADS              LONGOPT_BASE_APPLICATION+11
 
     static const struct ws_option long_options[] = {
         {"novlan", ws_no_argument, NULL, LONGOPT_NO_VLAN},
@@ -1139,6 +1464,10 @@ main(int argc, char *argv[])
         {"version", ws_no_argument, NULL, 'v'},
         {"capture-comment", ws_required_argument, NULL, LONGOPT_CAPTURE_COMMENT},
         {"discard-capture-comment", ws_no_argument, NULL, LONGOPT_DISCARD_CAPTURE_COMMENT},
+        {"compress", ws_required_argument, NULL, LONGOPT_COMPRESS},
+        {"record-index", ws_no_argument, NULL, LONGOPT_RECORD_INDEX},
+        {"threaded-write", ws_no_argument, NULL, LONGOPT_THREADED_WRITE},
+        {"threads", ws_required_argument, NULL, LONGOPT_THREADS},
         {0, 0, 0, 0 }
     };
 
@@ -1317,6 +1646,40 @@ main(int argc, char *argv[])
             break;
         }
 
+        case LONGOPT_RECORD_INDEX:
+        {
+            write_record_index = TRUE;
+            break;
+        }
+
+        case LONGOPT_THREADED_WRITE:
+        {
+            threaded_write = TRUE;
+            break;
+        }
+
+        case LONGOPT_THREADS:
+        {
+            split_threads = get_nonzero_guint32(ws_optarg, "number of threads");
+            break;
+        }
+
+        case LONGOPT_COMPRESS:
+        {
+            if (strcmp(ws_optarg, "none") == 0) {
+                out_compression_type = WTAP_UNCOMPRESSED;
+            } else {
+                out_compression_type = wtap_name_to_compression_type(ws_optarg);
+                if (out_compression_type == WTAP_UNCOMPRESSED) {
+                    fprintf(stderr, "editcap: \"%s\" isn't a supported compression type\n\n",
+                            ws_optarg);
+                    ret = INVALID_OPTION;
+                    goto clean_exit;
+                }
+            }
+            break;
+        }
+
         case 'a':
         {
             guint frame_number;
@@ -1655,6 +2018,8 @@ main(int argc, char *argv[])
     }
 
     wtap_dump_params_init_no_idbs(&params, wth);
+    params.write_record_index = write_record_index;
+    params.threaded_write = threaded_write;
 
     /*
      * Discard any secrets we read in while opening the file.
@@ -1763,10 +2128,41 @@ main(int argc, char *argv[])
             nstime_set_unset(&fd_hash[i].frame_time);
         }
     }
+    if (dup_detect) {
+        fd_hash_counts = g_hash_table_new_full(fd_hash_hash, fd_hash_equal,
+                                               NULL, g_free);
+    }
 
     /* Set up an array of all IDBs seen */
     idbs_seen = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
 
+    /*
+     * Split on several threads if we can: that needs the input file's
+     * record index, and nothing but splitting to be done to the records.
+     */
+    if (split_threads > 1 &&
+        (split_packet_count != 0 || !nstime_is_unset(&secs_per_block))) {
+        if (argc > ws_optind + 2 || check_startstop || rem_vlan ||
+            dup_detect || dup_detect_by_time || frames_user_comments != NULL ||
+            err_prob >= 0.0 || snaplen != 0 || chop.len_begin != 0 ||
+            chop.len_end != 0 || !nstime_is_zero(&time_adj.tv) ||
+            do_strict_time_adjustment || out_frame_type != -2 ||
+            discard_all_secrets) {
+            fprintf(stderr, "editcap: --threads only applies to splitting with no other changes; using one thread\n");
+        } else {
+            /* If we don't have an application name add one */
+            if (wtap_block_get_string_option_value(g_array_index(params.shb_hdrs, wtap_block_t, 0), OPT_SHB_USERAPPL, &shb_user_appl) != WTAP_OPTTYPE_SUCCESS) {
+                wtap_block_add_string_option_format(g_array_index(params.shb_hdrs, wtap_block_t, 0), OPT_SHB_USERAPPL, "%s", get_appname_and_version());
+            }
+            if (split_in_parallel(argv[ws_optind], argv[ws_optind+1], &params,
+                                  split_packet_count, &secs_per_block, &ret)) {
+                goto clean_exit;
+            }
+            fprintf(stderr, "editcap: %s has no record index; using one thread\n",
+                    argv[ws_optind]);
+        }
+    }
+
     /* Read all of the packets in turn */
     wtap_rec_init(&read_rec);
     ws_buffer_init(&read_buf, 1514);
@@ -1827,6 +2223,13 @@ main(int argc, char *argv[])
             goto clean_exit;
         }
 
+        /*
+         * The packet data may be in place in a read-only mapping of
+         * the file; get our own copy if we're going to change it.
+         */
+        if (rem_vlan || chop.len_begin != 0 || chop.len_end != 0 ||
+            err_prob > 0.0)
+            ws_buffer_assure_space(&read_buf, 0);
         buf = ws_buffer_start_ptr(&read_buf);
 
         /*
@@ -2329,6 +2732,8 @@ main(int argc, char *argv[])
     }
 
 clean_exit:
+    if (fd_hash_counts != NULL)
+        g_hash_table_destroy(fd_hash_counts);
     if (dsb_filenames) {
         g_array_free(dsb_types, TRUE);
         g_ptr_array_free(dsb_filenames, TRUE);
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #include <wsutil/strtoi.h>
 #include <wsutil/ws_assert.h>
@@ -82,6 +83,7 @@
 #include "addr_and_mask.h"
 #include "ipv6.h"
 #include "addr_resolv.h"
+#include "addr_resolv_data.h"
 #include "wsutil/filesystem.h"
 
 #include <wsutil/report_message.h>
@@ -99,12 +101,11 @@
 #define ENAME_SUBNETS   "subnets"
 #define ENAME_ETHERS    "ethers"
 #define ENAME_IPXNETS   "ipxnets"
-#define ENAME_MANUF     "manuf"
-#define ENAME_WKA       "wka"
 #define ENAME_SERVICES  "services"
 #define ENAME_VLANS     "vlans"
 #define ENAME_SS7PCS    "ss7pcs"
 #define ENAME_ENTERPRISES "enterprises.tsv"
+#define ENAME_DNSCACHE  "dnscache"
 
 #define HASHETHSIZE      2048
 #define HASHHOSTSIZE     2048
@@ -225,6 +226,13 @@ static wmem_map_t *eth_hashtable = NULL;
 static wmem_map_t *serv_port_hashtable = NULL;
 static GHashTable *enterprises_hashtable = NULL;
 
+/* The manuf, wka and services hash tables only get entries from the
+ * built-in tables as they're looked up, until something asks for the
+ * whole hash table. */
+static gboolean manuf_hashtable_complete = FALSE;
+static gboolean wka_hashtable_complete = FALSE;
+static gboolean serv_port_hashtable_complete = FALSE;
+
 static subnet_length_entry_t subnet_length_entries[SUBNETLENGTHSIZE]; /* Ordered array of entries */
 static gboolean have_subnet_entry = FALSE;
 
@@ -285,6 +293,8 @@ e_addr_resolve gbl_resolv_flags = {
 };
 static guint name_resolve_concurrency = 500;
 static gboolean resolve_synchronously = FALSE;
+static gboolean use_dns_cache = FALSE;
+static guint dns_cache_lifetime = 86400;
 
 /*
  *  Global variables (can be changed in GUI sections)
@@ -294,15 +304,11 @@ static gboolean resolve_synchronously = FALSE;
 
 gchar *g_ethers_path    = NULL;     /* global ethers file     */
 gchar *g_pethers_path   = NULL;     /* personal ethers file   */
-gchar *g_wka_path       = NULL;     /* global well-known-addresses file */
-gchar *g_manuf_path     = NULL;     /* global manuf file      */
 gchar *g_ipxnets_path   = NULL;     /* global ipxnets file    */
 gchar *g_pipxnets_path  = NULL;     /* personal ipxnets file  */
-gchar *g_services_path  = NULL;     /* global services file   */
 gchar *g_pservices_path = NULL;     /* personal services file */
 gchar *g_pvlan_path     = NULL;     /* personal vlans file    */
 gchar *g_ss7pcs_path    = NULL;     /* personal ss7pcs file   */
-gchar *g_enterprises_path = NULL;   /* global enterprises file   */
 gchar *g_penterprises_path = NULL;  /* personal enterprises file */
                                     /* first resolving call   */
 
@@ -350,6 +356,24 @@ static  gboolean  async_dns_initialized = FALSE;
 static  guint       async_dns_in_flight = 0;
 static  wmem_list_t *async_dns_queue_head = NULL;
 
+/*
+ * Names found with c-ares, if the "name_resolve_cache" preference is set.
+ * They're saved in the dnscache file in the personal configuration
+ * directory when the host name tables are cleaned up, and read back in the
+ * next time they're set up, so that later runs needn't look them up again.
+ * c-ares doesn't tell us the TTL of a PTR record, so each name is kept for
+ * dns_cache_lifetime seconds from when it was looked up.
+ */
+typedef struct _dns_cache_entry
+{
+    time_t           expires;
+    char             name[MAXNAMELEN];
+} dns_cache_entry_t;
+
+static  wmem_map_t  *dns_cache_ipv4 = NULL;
+static  wmem_map_t  *dns_cache_ipv6 = NULL;
+static  gboolean     dns_cache_changed = FALSE;
+
 //UAT for providing a list of DNS servers to C-ARES for name resolution
 gboolean use_custom_dns_server_list = FALSE;
 struct dns_server_data {
@@ -421,6 +445,41 @@ dnsserver_uat_fld_port_chk_cb(void* r _U_, const char* p, guint len _U_, const v
     return TRUE;
 }
 
+static dns_cache_entry_t *
+dns_cache_new_entry(const char *name, const time_t expires)
+{
+    dns_cache_entry_t *entry = wmem_new(wmem_epan_scope(), dns_cache_entry_t);
+
+    entry->expires = expires;
+    (void) g_strlcpy(entry->name, name, MAXNAMELEN);
+    return entry;
+}
+
+static void
+dns_cache_add_ipv4(const guint32 addr, const char *name, const time_t expires)
+{
+    if (dns_cache_ipv4 == NULL || !name || name[0] == '\0')
+        return;
+
+    wmem_map_insert(dns_cache_ipv4, GUINT_TO_POINTER(addr),
+            dns_cache_new_entry(name, expires));
+    dns_cache_changed = TRUE;
+}
+
+static void
+dns_cache_add_ipv6(const ws_in6_addr *addr, const char *name, const time_t expires)
+{
+    ws_in6_addr *addr_key;
+
+    if (dns_cache_ipv6 == NULL || !name || name[0] == '\0')
+        return;
+
+    addr_key = wmem_new(wmem_epan_scope(), ws_in6_addr);
+    memcpy(addr_key, addr, sizeof *addr_key);
+    wmem_map_insert(dns_cache_ipv6, addr_key, dns_cache_new_entry(name, expires));
+    dns_cache_changed = TRUE;
+}
+
 static void
 c_ares_ghba_sync_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
     sync_dns_data_t *sdd = (sync_dns_data_t *)arg;
@@ -431,9 +490,11 @@ c_ares_ghba_sync_cb(void *arg, int status, int timeouts _U_, struct hostent *he)
             switch(sdd->family) {
                 case AF_INET:
                     add_ipv4_name(sdd->addr.ip4, he->h_name, FALSE);
+                    dns_cache_add_ipv4(sdd->addr.ip4, he->h_name, time(NULL) + dns_cache_lifetime);
                     break;
                 case AF_INET6:
                     add_ipv6_name(&sdd->addr.ip6, he->h_name, FALSE);
+                    dns_cache_add_ipv6(&sdd->addr.ip6, he->h_name, time(NULL) + dns_cache_lifetime);
                     break;
                 default:
                     /* Throw an exception? */
@@ -654,6 +715,61 @@ static subnet_entry_t subnet_lookup(const guint32 addr);
 static void subnet_entry_set(guint32 subnet_addr, const guint8 mask_length, const gchar* name);
 
 
+/*
+ * The services, manuf, wka and enterprises.tsv files that come with
+ * Wireshark are compiled into tables at build time (see
+ * addr_resolv_data.h); the personal services and enterprises files are
+ * read at startup, and override them.
+ */
+
+static int
+compare_data_service(const void *key, const void *elem)
+{
+    guint port = *(const guint *)key;
+    const addr_resolv_data_service_t *entry = (const addr_resolv_data_service_t *)elem;
+
+    return port < entry->port ? -1 : port > entry->port;
+}
+
+static const addr_resolv_data_service_t *
+data_service_lookup(guint port)
+{
+    return (const addr_resolv_data_service_t *)bsearch(&port,
+            addr_resolv_data_services, addr_resolv_data_services_count,
+            sizeof addr_resolv_data_services[0], compare_data_service);
+}
+
+static gchar *
+data_strdup(guint32 offset)
+{
+    const char *str = addr_resolv_data_str(offset);
+
+    return str != NULL ? wmem_strdup(wmem_epan_scope(), str) : NULL;
+}
+
+/*
+ * Add an entry for a port to the services hash table, with the names
+ * from the built-in table; the hash table's entry for a port, if there
+ * is one, has all of its names.
+ */
+static serv_port_t *
+serv_port_new(guint port)
+{
+    serv_port_t *serv_port_table;
+    const addr_resolv_data_service_t *data;
+
+    serv_port_table = wmem_new0(wmem_epan_scope(), serv_port_t);
+    data = data_service_lookup(port);
+    if (data != NULL) {
+        serv_port_table->tcp_name = data_strdup(data->tcp_name);
+        serv_port_table->udp_name = data_strdup(data->udp_name);
+        serv_port_table->sctp_name = data_strdup(data->sctp_name);
+        serv_port_table->dccp_name = data_strdup(data->dccp_name);
+    }
+    wmem_map_insert(serv_port_hashtable, GUINT_TO_POINTER(port), serv_port_table);
+    return serv_port_table;
+}
+
 static void
 add_service_name(port_type proto, const guint port, const char *service_name)
 {
@@ -661,8 +777,7 @@ add_service_name(port_type proto, const guint port, const char *service_name)
 
     serv_port_table = (serv_port_t *)wmem_map_lookup(serv_port_hashtable, GUINT_TO_POINTER(port));
     if (serv_port_table == NULL) {
-        serv_port_table = wmem_new0(wmem_epan_scope(), serv_port_t);
-        wmem_map_insert(serv_port_hashtable, GUINT_TO_POINTER(port), serv_port_table);
+        serv_port_table = serv_port_new(port);
     }
 
     switch(proto) {
@@ -797,6 +912,9 @@ _serv_name_lookup(port_type proto, guint port, serv_port_t **value_ret)
     serv_port_t *serv_port_table;
 
     serv_port_table = (serv_port_t *)wmem_map_lookup(serv_port_hashtable, GUINT_TO_POINTER(port));
+    if (serv_port_table == NULL && data_service_lookup(port) != NULL) {
+        serv_port_table = serv_port_new(port);
+    }
 
     if (value_ret != NULL)
         *value_ret = serv_port_table;
@@ -836,8 +954,7 @@ serv_name_lookup(port_type proto, guint port)
         return name;
 
     if (serv_port_table == NULL) {
-        serv_port_table = wmem_new0(wmem_epan_scope(), serv_port_t);
-        wmem_map_insert(serv_port_hashtable, GUINT_TO_POINTER(port), serv_port_table);
+        serv_port_table = serv_port_new(port);
     }
     if (serv_port_table->numeric == NULL) {
         serv_port_table->numeric = wmem_strdup_printf(wmem_epan_scope(), "%u", port);
@@ -852,12 +969,7 @@ initialize_services(void)
     gboolean parse_file = TRUE;
     ws_assert(serv_port_hashtable == NULL);
     serv_port_hashtable = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
-
-    /* Compute the pathname of the services file. */
-    if (g_services_path == NULL) {
-        g_services_path = get_datafile_path(ENAME_SERVICES);
-    }
-    parse_services_file(g_services_path);
+    serv_port_hashtable_complete = FALSE;
 
     /* Compute the pathname of the personal services file */
     if (g_pservices_path == NULL) {
@@ -879,8 +991,6 @@ static void
 service_name_lookup_cleanup(void)
 {
     serv_port_hashtable = NULL;
-    g_free(g_services_path);
-    g_services_path = NULL;
     g_free(g_pservices_path);
     g_pservices_path = NULL;
 }
@@ -941,11 +1051,6 @@ initialize_enterprises(void)
     ws_assert(enterprises_hashtable == NULL);
     enterprises_hashtable = g_hash_table_new_full(NULL, NULL, NULL, g_free);
 
-    if (g_enterprises_path == NULL) {
-        g_enterprises_path = get_datafile_path(ENAME_ENTERPRISES);
-    }
-    parse_enterprises_file(g_enterprises_path);
-
     if (g_penterprises_path == NULL) {
         /* Check profile directory before personal configuration */
         g_penterprises_path = get_persconffile_path(ENAME_ENTERPRISES, TRUE);
@@ -957,10 +1062,29 @@ initialize_enterprises(void)
     parse_enterprises_file(g_penterprises_path);
 }
 
+static int
+compare_data_enterprise(const void *key, const void *elem)
+{
+    guint32 number = *(const guint32 *)key;
+    const addr_resolv_data_enterprise_t *entry = (const addr_resolv_data_enterprise_t *)elem;
+
+    return number < entry->number ? -1 : number > entry->number;
+}
+
 const gchar *
 try_enterprises_lookup(guint32 value)
 {
-    return (const gchar *)g_hash_table_lookup(enterprises_hashtable, GUINT_TO_POINTER(value));
+    const gchar *name;
+    const addr_resolv_data_enterprise_t *data;
+
+    name = (const gchar *)g_hash_table_lookup(enterprises_hashtable, GUINT_TO_POINTER(value));
+    if (name != NULL)
+        return name;
+
+    data = (const addr_resolv_data_enterprise_t *)bsearch(&value,
+            addr_resolv_data_enterprises, addr_resolv_data_enterprises_count,
+            sizeof addr_resolv_data_enterprises[0], compare_data_enterprise);
+    return data != NULL ? addr_resolv_data_str(data->name) : NULL;
 }
 
 const gchar *
@@ -992,9 +1116,6 @@ enterprises_cleanup(void)
     ws_assert(enterprises_hashtable);
     g_hash_table_destroy(enterprises_hashtable);
     enterprises_hashtable = NULL;
-    ws_assert(g_enterprises_path);
-    g_free(g_enterprises_path);
-    g_enterprises_path = NULL;
     g_free(g_penterprises_path);
     g_penterprises_path = NULL;
     g_free(g_pservices_path);
@@ -1070,9 +1191,11 @@ c_ares_ghba_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
             switch(caqm->family) {
                 case AF_INET:
                     add_ipv4_name(caqm->addr.ip4, he->h_name, FALSE);
+                    dns_cache_add_ipv4(caqm->addr.ip4, he->h_name, time(NULL) + dns_cache_lifetime);
                     break;
                 case AF_INET6:
                     add_ipv6_name(&caqm->addr.ip6, he->h_name, FALSE);
+                    dns_cache_add_ipv6(&caqm->addr.ip6, he->h_name, time(NULL) + dns_cache_lifetime);
                     break;
                 default:
                     /* Throw an exception? */
@@ -1570,7 +1693,7 @@ get_ethbyaddr(const guint8 *addr)
 } /* get_ethbyaddr */
 
 static hashmanuf_t *
-manuf_hash_new_entry(const guint8 *addr, char* name, char* longname)
+manuf_hash_new_entry(const guint8 *addr, const char* name, const char* longname)
 {
     guint manuf_key;
     hashmanuf_t *manuf_value;
@@ -1604,38 +1727,43 @@ manuf_hash_new_entry(const guint8 *addr, char* name, char* longname)
     return manuf_value;
 }
 
-static void
-wka_hash_new_entry(const guint8 *addr, char* name)
+static int
+compare_data_manuf(const void *key, const void *elem)
 {
-    guint8 *wka_key;
-
-    wka_key = (guint8 *)wmem_alloc(wmem_epan_scope(), 6);
-    memcpy(wka_key, addr, 6);
+    guint32 oui = *(const guint32 *)key;
+    const addr_resolv_data_manuf_t *entry = (const addr_resolv_data_manuf_t *)elem;
 
-    wmem_map_insert(wka_hashtable, wka_key, wmem_strdup(wmem_epan_scope(), name));
+    return oui < entry->oui ? -1 : oui > entry->oui;
 }
 
-static void
-add_manuf_name(const guint8 *addr, unsigned int mask, gchar *name, gchar *longname)
+/*
+ * Look up a manufacturer ID in the hash table, which caches the ones
+ * found in the built-in table, or, failing that, in the built-in table.
+ */
+static hashmanuf_t *
+manuf_key_lookup(guint32 manuf_key)
 {
-    switch (mask)
-    {
-    case 0:
-        /* This is a manufacturer ID; add it to the manufacturer ID hash table */
-        manuf_hash_new_entry(addr, name, longname);
-        break;
+    hashmanuf_t *manuf_value;
+    const addr_resolv_data_manuf_t *data;
+    guint8 addr[3];
 
-    case 48:
-        /* This is a well-known MAC address; add it to the Ethernet hash table */
-        add_eth_name(addr, name);
-        break;
+    manuf_value = (hashmanuf_t*)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
+    if (manuf_value != NULL) {
+        return manuf_value;
+    }
 
-    default:
-        /* This is a range of well-known addresses; add it to the well-known-address table */
-        wka_hash_new_entry(addr, name);
-        break;
+    data = (const addr_resolv_data_manuf_t *)bsearch(&manuf_key,
+            addr_resolv_data_manuf, addr_resolv_data_manuf_count,
+            sizeof addr_resolv_data_manuf[0], compare_data_manuf);
+    if (data == NULL) {
+        return NULL;
     }
-} /* add_manuf_name */
+    addr[0] = (guint8)(manuf_key >> 16);
+    addr[1] = (guint8)(manuf_key >> 8);
+    addr[2] = (guint8)manuf_key;
+    return manuf_hash_new_entry(addr, addr_resolv_data_str(data->name),
+            addr_resolv_data_str(data->longname));
+}
 
 static hashmanuf_t *
 manuf_name_lookup(const guint8 *addr)
@@ -1655,7 +1783,7 @@ manuf_name_lookup(const guint8 *addr)
 
 
     /* first try to find a "perfect match" */
-    manuf_value = (hashmanuf_t*)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
+    manuf_value = manuf_key_lookup(manuf_key);
     if (manuf_value != NULL) {
         return manuf_value;
     }
@@ -1667,7 +1795,7 @@ manuf_name_lookup(const guint8 *addr)
      * 0x02 locally administered bit */
     if ((manuf_key & 0x00010000) != 0) {
         manuf_key &= 0x00FEFFFF;
-        manuf_value = (hashmanuf_t*)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
+        manuf_value = manuf_key_lookup(manuf_key);
         if (manuf_value != NULL) {
             return manuf_value;
         }
@@ -1678,17 +1806,21 @@ manuf_name_lookup(const guint8 *addr)
 
 } /* manuf_name_lookup */
 
-static gchar *
+static int
+compare_data_ether(const void *key, const void *elem)
+{
+    const addr_resolv_data_ether_t *entry = (const addr_resolv_data_ether_t *)elem;
+
+    return memcmp(key, entry->addr, sizeof entry->addr);
+}
+
+static const gchar *
 wka_name_lookup(const guint8 *addr, const unsigned int mask)
 {
     guint8     masked_addr[6];
     guint      num;
     gint       i;
-    gchar     *name;
-
-    if (wka_hashtable == NULL) {
-        return NULL;
-    }
+    const addr_resolv_data_ether_t *data;
     /* Get the part of the address covered by the mask. */
     for (i = 0, num = mask; num >= 8; i++, num -= 8)
         masked_addr[i] = addr[i];   /* copy octets entirely covered by the mask */
@@ -1699,9 +1831,11 @@ wka_name_lookup(const guint8 *addr, const unsigned int mask)
     for (; i < 6; i++)
         masked_addr[i] = 0;
 
-    name = (gchar *)wmem_map_lookup(wka_hashtable, masked_addr);
+    data = (const addr_resolv_data_ether_t *)bsearch(masked_addr,
+            addr_resolv_data_wka, addr_resolv_data_wka_count,
+            sizeof addr_resolv_data_wka[0], compare_data_ether);
 
-    return name;
+    return data != NULL ? addr_resolv_data_str(data->name) : NULL;
 
 } /* wka_name_lookup */
 
@@ -1736,13 +1870,14 @@ eth_addr_cmp(gconstpointer a, gconstpointer b)
 static void
 initialize_ethers(void)
 {
-    ether_t *eth;
-    guint    mask = 0;
+    guint i;
 
     /* hash table initialization */
     wka_hashtable   = wmem_map_new(wmem_epan_scope(), eth_addr_hash, eth_addr_cmp);
     manuf_hashtable = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
     eth_hashtable   = wmem_map_new(wmem_epan_scope(), eth_addr_hash, eth_addr_cmp);
+    manuf_hashtable_complete = FALSE;
+    wka_hashtable_complete = FALSE;
 
     /* Compute the pathname of the ethers file. */
     if (g_ethers_path == NULL) {
@@ -1761,27 +1896,13 @@ initialize_ethers(void)
         }
     }
 
-    /* Compute the pathname of the manuf file */
-    if (g_manuf_path == NULL)
-        g_manuf_path = get_datafile_path(ENAME_MANUF);
-
-    /* Read it and initialize the hash table */
-    set_ethent(g_manuf_path);
-    while ((eth = get_ethent(&mask, TRUE))) {
-        add_manuf_name(eth->addr, mask, eth->name, eth->longname);
+    /* The manufacturer IDs and well-known address ranges are looked up in
+     * the built-in tables as needed; add the well-known addresses to the
+     * Ethernet hash table. */
+    for (i = 0; i < addr_resolv_data_ethers_count; i++) {
+        add_eth_name(addr_resolv_data_ethers[i].addr,
+                addr_resolv_data_str(addr_resolv_data_ethers[i].name));
     }
-    end_ethent();
-
-    /* Compute the pathname of the wka file */
-    if (g_wka_path == NULL)
-        g_wka_path = get_datafile_path(ENAME_WKA);
-
-    /* Read it and initialize the hash table */
-    set_ethent(g_wka_path);
-    while ((eth = get_ethent(&mask, TRUE))) {
-        add_manuf_name(eth->addr, mask, eth->name, eth->longname);
-    }
-    end_ethent();
 
 } /* initialize_ethers */
 
@@ -1792,10 +1913,6 @@ ethers_cleanup(void)
     g_ethers_path = NULL;
     g_free(g_pethers_path);
     g_pethers_path = NULL;
-    g_free(g_manuf_path);
-    g_manuf_path = NULL;
-    g_free(g_wka_path);
-    g_wka_path = NULL;
 }
 
 /* Resolve ethernet address */
@@ -1811,7 +1928,7 @@ eth_addr_resolve(hashether_t *tp) {
         return tp;
     } else {
         guint         mask;
-        gchar        *name;
+        const gchar  *name;
         address       ether_addr;
 
         /* Unknown name.  Try looking for it in the well-known-address
@@ -2911,6 +3028,20 @@ addr_resolve_pref_init(module_t *nameres)
             10,
             &name_resolve_concurrency);
 
+    prefs_register_bool_preference(nameres, "name_resolve_cache",
+            "Keep resolved names between runs",
+            "Save the names found with DNS in the \"dnscache\" file in the"
+            " personal configuration directory, and use them in later runs"
+            " instead of looking the addresses up again.",
+            &use_dns_cache);
+
+    prefs_register_uint_preference(nameres, "name_resolve_cache_lifetime",
+            "Resolved name lifetime",
+            "How long, in seconds, a name saved in the \"dnscache\" file"
+            " is used before the address is looked up again.",
+            10,
+            &dns_cache_lifetime);
+
     prefs_register_bool_preference(nameres, "hosts_file_handling",
             "Only use the profile \"hosts\" file",
             "By default \"hosts\" files will be loaded from multiple sources."
@@ -2949,22 +3080,16 @@ disable_name_resolution(void) {
     gbl_resolv_flags.ss7pc_name                         = FALSE;
 }
 
-gboolean
-host_name_lookup_process(void) {
+/*
+ * Send queued lookups until name_resolve_concurrency of them are in
+ * flight.
+ */
+static void
+submit_async_dns_queue(void)
+{
     async_dns_queue_msg_t *caqm;
-    struct timeval tv = { 0, 0 };
-    int nfds;
-    fd_set rfds, wfds;
-    gboolean nro = new_resolved_objects;
     wmem_list_frame_t* head;
 
-    new_resolved_objects = FALSE;
-    nro |= maxmind_db_lookup_process();
-
-    if (!async_dns_initialized)
-        /* c-ares not initialized. Bail out and cancel timers. */
-        return nro;
-
     head = wmem_list_head(async_dns_queue_head);
 
     while (head != NULL && async_dns_in_flight <= name_resolve_concurrency) {
@@ -2982,6 +3107,23 @@ host_name_lookup_process(void) {
 
         head = wmem_list_head(async_dns_queue_head);
     }
+}
+
+gboolean
+host_name_lookup_process(void) {
+    struct timeval tv = { 0, 0 };
+    int nfds;
+    fd_set rfds, wfds;
+    gboolean nro = new_resolved_objects;
+
+    new_resolved_objects = FALSE;
+    nro |= maxmind_db_lookup_process();
+
+    if (!async_dns_initialized)
+        /* c-ares not initialized. Bail out and cancel timers. */
+        return nro;
+
+    submit_async_dns_queue();
 
     FD_ZERO(&rfds);
     FD_ZERO(&wfds);
@@ -3000,6 +3142,46 @@ host_name_lookup_process(void) {
     return nro;
 }
 
+void
+host_name_lookup_wait(void) {
+    struct timeval tv;
+    int nfds;
+    fd_set rfds, wfds;
+
+    if (!async_dns_initialized)
+        return;
+
+    for (;;) {
+        submit_async_dns_queue();
+
+        /*
+         * As in wait_for_sync_resolv(), wake up at least once a second
+         * so that c-ares can handle timeouts, rather than asking
+         * ares_timeout(), which is linear in the number of requests
+         * outstanding.
+         */
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        nfds = ares_fds(ghba_chan, &rfds, &wfds);
+        if (nfds == 0) {
+            /* Nothing's waiting for a reply; are we done? */
+            if (wmem_list_count(async_dns_queue_head) == 0)
+                break;
+            continue;
+        }
+        if (select(nfds, &rfds, &wfds, NULL, &tv) == -1) { /* call to select() failed */
+            /* If it's interrupted by a signal, no need to put out a message */
+            if (errno != EINTR)
+                fprintf(stderr, "Warning: call to select() failed, error is %s\n", g_strerror(errno));
+            return;
+        }
+        ares_process(ghba_chan, &rfds, &wfds);
+    }
+}
+
 static void
 _host_name_lookup_cleanup(void) {
     async_dns_queue_head = NULL;
@@ -3115,6 +3297,35 @@ add_manually_resolved_ipv4(gpointer key, gpointer value, gpointer user_data _U_)
     add_ipv4_name(GPOINTER_TO_UINT(key), resolved_ipv4_entry->name, TRUE);
 }
 
+/*
+ * Add a name from the dnscache file, unless we already have one for
+ * the address that lasts longer, e.g. because we've looked it up since
+ * whoever wrote the file did.
+ */
+static void
+dns_cache_merge_ipv4(const guint32 addr, const char *name, const time_t expires)
+{
+    dns_cache_entry_t *entry;
+
+    if (dns_cache_ipv4 == NULL)
+        return;
+    entry = (dns_cache_entry_t *)wmem_map_lookup(dns_cache_ipv4, GUINT_TO_POINTER(addr));
+    if (entry == NULL || entry->expires < expires)
+        dns_cache_add_ipv4(addr, name, expires);
+}
+
+static void
+dns_cache_merge_ipv6(const ws_in6_addr *addr, const char *name, const time_t expires)
+{
+    dns_cache_entry_t *entry;
+
+    if (dns_cache_ipv6 == NULL)
+        return;
+    entry = (dns_cache_entry_t *)wmem_map_lookup(dns_cache_ipv6, addr);
+    if (entry == NULL || entry->expires < expires)
+        dns_cache_add_ipv6(addr, name, expires);
+}
+
 static void
 add_manually_resolved_ipv6(gpointer key, gpointer value, gpointer user_data _U_)
 {
@@ -3134,6 +3345,160 @@ add_manually_resolved(void)
     }
 }
 
+/*
+ * Each line of the dnscache file is an address, a name, and the time,
+ * in seconds since the Epoch, at which the name expires, separated by
+ * tabs.  Names that have expired are ignored.
+ *
+ * When setting up, the names are also added to the host name tables.
+ * When writing the cache back, the file is read again first and merged
+ * with what we have, so that names another instance looked up and saved
+ * since we read it aren't lost.
+ */
+static void
+read_dns_cache(gboolean merging)
+{
+    char *path;
+    FILE *cf;
+    char line[MAX_LINELEN];
+    gchar *addr_str, *name, *expires_str;
+    union {
+        guint32 ip4_addr;
+        ws_in6_addr ip6_addr;
+    } host_addr;
+    gint64 expires;
+    time_t now = time(NULL);
+
+    path = get_persconffile_path(ENAME_DNSCACHE, FALSE);
+    cf = ws_fopen(path, "r");
+    g_free(path);
+    if (cf == NULL)
+        return;
+
+    while (fgetline(line, sizeof(line), cf) >= 0) {
+        if (line[0] == '#')
+            continue;
+
+        if ((addr_str = strtok(line, "\t")) == NULL ||
+            (name = strtok(NULL, "\t")) == NULL ||
+            (expires_str = strtok(NULL, "\t")) == NULL)
+            continue;
+
+        if (!ws_strtoi64(expires_str, NULL, &expires) || expires <= (gint64)now)
+            continue;
+
+        if (ws_inet_pton6(addr_str, &host_addr.ip6_addr)) {
+            if (!merging)
+                add_ipv6_name(&host_addr.ip6_addr, name, FALSE);
+            dns_cache_merge_ipv6(&host_addr.ip6_addr, name, (time_t)expires);
+        } else if (ws_inet_pton4(addr_str, &host_addr.ip4_addr)) {
+            if (!merging)
+                add_ipv4_name(host_addr.ip4_addr, name, FALSE);
+            dns_cache_merge_ipv4(host_addr.ip4_addr, name, (time_t)expires);
+        }
+    }
+
+    fclose(cf);
+
+    /* Nothing new to write back yet. */
+    if (!merging)
+        dns_cache_changed = FALSE;
+}
+
+typedef struct {
+    FILE   *cf;
+    time_t  now;
+} dns_cache_write_t;
+
+static void
+write_dns_cache_ipv4(gpointer key, gpointer value, gpointer user_data)
+{
+    dns_cache_entry_t *entry = (dns_cache_entry_t *)value;
+    dns_cache_write_t *dcw = (dns_cache_write_t *)user_data;
+    guint32 addr = GPOINTER_TO_UINT(key);
+    char addr_str[WS_INET_ADDRSTRLEN];
+
+    if (entry->expires <= dcw->now)
+        return;
+
+    ws_inet_ntop4(&addr, addr_str, sizeof addr_str);
+    fprintf(dcw->cf, "%s\t%s\t%" PRId64 "\n", addr_str, entry->name, (gint64)entry->expires);
+}
+
+static void
+write_dns_cache_ipv6(gpointer key, gpointer value, gpointer user_data)
+{
+    dns_cache_entry_t *entry = (dns_cache_entry_t *)value;
+    dns_cache_write_t *dcw = (dns_cache_write_t *)user_data;
+    char addr_str[WS_INET6_ADDRSTRLEN];
+
+    if (entry->expires <= dcw->now)
+        return;
+
+    ws_inet_ntop6(key, addr_str, sizeof addr_str);
+    fprintf(dcw->cf, "%s\t%s\t%" PRId64 "\n", addr_str, entry->name, (gint64)entry->expires);
+}
+
+/*
+ * Write the cache to a temporary file of our own and move that into
+ * place, so that another instance reading the cache never sees half of
+ * it, and two instances exiting at once don't write to the same file.
+ * Whichever renames its file last wins, but it has merged in what was
+ * on disk just before.
+ */
+static void
+write_dns_cache(void)
+{
+    char *pf_dir_path;
+    char *path, *tmp_path;
+    int fd;
+    dns_cache_write_t dcw;
+
+    if (!dns_cache_changed)
+        return;
+    dns_cache_changed = FALSE;
+
+    if (create_persconffile_dir(&pf_dir_path) == -1) {
+        g_free(pf_dir_path);
+        return;
+    }
+
+    read_dns_cache(TRUE);
+
+    path = get_persconffile_path(ENAME_DNSCACHE, FALSE);
+    tmp_path = ws_strdup_printf("%s.XXXXXX", path);
+    if ((fd = g_mkstemp(tmp_path)) == -1) {
+        g_free(tmp_path);
+        g_free(path);
+        return;
+    }
+    if ((dcw.cf = ws_fdopen(fd, "w")) == NULL) {
+        ws_close(fd);
+        ws_unlink(tmp_path);
+        g_free(tmp_path);
+        g_free(path);
+        return;
+    }
+
+    dcw.now = time(NULL);
+    fputs("# Names looked up with DNS, with the time, in seconds since the Epoch,\n"
+          "# at which each one expires.  This file is rewritten when Wireshark,\n"
+          "# TShark, or sharkd exits.\n", dcw.cf);
+    if (dns_cache_ipv4)
+        wmem_map_foreach(dns_cache_ipv4, write_dns_cache_ipv4, &dcw);
+    if (dns_cache_ipv6)
+        wmem_map_foreach(dns_cache_ipv6, write_dns_cache_ipv6, &dcw);
+
+    if (fclose(dcw.cf) == 0) {
+        if (ws_rename(tmp_path, path) != 0)
+            ws_unlink(tmp_path);
+    } else {
+        ws_unlink(tmp_path);
+    }
+    g_free(tmp_path);
+    g_free(path);
+}
+
 static void
 host_name_lookup_init(void)
 {
@@ -3152,6 +3517,12 @@ host_name_lookup_init(void)
     ws_assert(async_dns_queue_head == NULL);
     async_dns_queue_head = wmem_list_new(wmem_epan_scope());
 
+    if (use_dns_cache) {
+        dns_cache_ipv4 = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
+        dns_cache_ipv6 = wmem_map_new(wmem_epan_scope(), ipv6_oat_hash, ipv6_equal);
+        read_dns_cache(FALSE);
+    }
+
     if (manually_resolved_ipv4_list == NULL)
         manually_resolved_ipv4_list = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
 
@@ -3208,6 +3579,10 @@ host_name_lookup_cleanup(void)
 
     _host_name_lookup_cleanup();
 
+    write_dns_cache();
+    dns_cache_ipv4 = NULL;
+    dns_cache_ipv6 = NULL;
+
     ipxnet_hash_table = NULL;
     ipv4_hash_table = NULL;
     ipv6_hash_table = NULL;
@@ -3452,7 +3827,7 @@ get_manuf_name_if_known(const guint8 *addr)
     oct = addr[2];
     manuf_key = manuf_key | oct;
 
-    manuf_value = (hashmanuf_t *)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
+    manuf_value = manuf_key_lookup(manuf_key);
     if ((manuf_value == NULL) || (manuf_value->status == HASHETHER_STATUS_UNRESOLVED)) {
         return NULL;
     }
@@ -3466,7 +3841,7 @@ uint_get_manuf_name_if_known(const guint manuf_key)
 {
     hashmanuf_t *manuf_value;
 
-    manuf_value = (hashmanuf_t *)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
+    manuf_value = manuf_key_lookup(manuf_key);
     if ((manuf_value == NULL) || (manuf_value->status == HASHETHER_STATUS_UNRESOLVED)) {
         return NULL;
     }
@@ -3644,12 +4019,29 @@ get_host_ipaddr6(const char *host, ws_in6_addr *addrp)
 wmem_map_t *
 get_manuf_hashtable(void)
 {
+    guint i;
+
+    if (manuf_hashtable != NULL && !manuf_hashtable_complete) {
+        for (i = 0; i < addr_resolv_data_manuf_count; i++) {
+            manuf_key_lookup(addr_resolv_data_manuf[i].oui);
+        }
+        manuf_hashtable_complete = TRUE;
+    }
     return manuf_hashtable;
 }
 
 wmem_map_t *
 get_wka_hashtable(void)
 {
+    guint i;
+
+    if (wka_hashtable != NULL && !wka_hashtable_complete) {
+        for (i = 0; i < addr_resolv_data_wka_count; i++) {
+            wmem_map_insert(wka_hashtable, (gpointer)addr_resolv_data_wka[i].addr,
+                    (gpointer)addr_resolv_data_str(addr_resolv_data_wka[i].name));
+        }
+        wka_hashtable_complete = TRUE;
+    }
     return wka_hashtable;
 }
 
@@ -3662,6 +4054,15 @@ get_eth_hashtable(void)
 wmem_map_t *
 get_serv_port_hashtable(void)
 {
+    guint i;
+
+    if (serv_port_hashtable != NULL && !serv_port_hashtable_complete) {
+        for (i = 0; i < addr_resolv_data_services_count; i++) {
+            if (!wmem_map_contains(serv_port_hashtable, GUINT_TO_POINTER(addr_resolv_data_services[i].port)))
+                serv_port_new(addr_resolv_data_services[i].port);
+        }
+        serv_port_hashtable_complete = TRUE;
+    }
     return serv_port_hashtable;
 }
 
@@ -195,6 +195,14 @@ WS_DLL_PUBLIC void disable_name_resolution(void);
  */
 WS_DLL_PUBLIC gboolean host_name_lookup_process(void);
 
+/** If we're using c-ares, send all queued host name lookups, no more than
+ *  the "name_resolve_concurrency" preference at a time, and wait for them
+ *  all to finish.  TShark calls this between its two passes, so that the
+ *  addresses seen in the first pass are resolved together rather than one
+ *  at a time in the second.
+ */
+WS_DLL_PUBLIC void host_name_lookup_wait(void);
+
 /* get_hostname returns the host name or "%d.%d.%d.%d" if not found */
 WS_DLL_PUBLIC const gchar *get_hostname(const guint addr);
 
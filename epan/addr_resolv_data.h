@@ -0,0 +1,98 @@
+/** @file
+ *
+ * Tables of manufacturer IDs, well-known addresses, services and
+ * enterprise numbers, generated at build time from the manuf, wka,
+ * services and enterprises.tsv files by tools/make-addr-resolv-data.py.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __ADDR_RESOLV_DATA_H__
+#define __ADDR_RESOLV_DATA_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Names are offsets into addr_resolv_data_strings rather than pointers,
+ * so that the tables need no relocations and stay in shared read-only
+ * pages; 0 means there's no name.  The strings are split into chunks
+ * to stay within compilers' limits on the length of a string literal.
+ */
+#define ADDR_RESOLV_DATA_CHUNK_SIZE 16384
+
+extern const char addr_resolv_data_strings[][ADDR_RESOLV_DATA_CHUNK_SIZE];
+
+static inline const char *
+addr_resolv_data_str(const guint32 offset)
+{
+    if (offset == 0)
+        return NULL;
+    return addr_resolv_data_strings[offset / ADDR_RESOLV_DATA_CHUNK_SIZE] +
+        offset % ADDR_RESOLV_DATA_CHUNK_SIZE;
+}
+
+/* Manufacturer IDs; oui is the first three octets, most significant first. */
+typedef struct {
+    guint32 oui;
+    guint32 name;
+    guint32 longname;
+} addr_resolv_data_manuf_t;
+
+/* Well-known address ranges, with the bits past the mask cleared, and
+ * well-known addresses. */
+typedef struct {
+    guint8  addr[6];
+    guint32 name;
+} addr_resolv_data_ether_t;
+
+typedef struct {
+    guint16 port;
+    guint32 tcp_name;
+    guint32 udp_name;
+    guint32 sctp_name;
+    guint32 dccp_name;
+} addr_resolv_data_service_t;
+
+typedef struct {
+    guint32 number;
+    guint32 name;
+} addr_resolv_data_enterprise_t;
+
+/* Each table is sorted by its first member. */
+extern const addr_resolv_data_manuf_t addr_resolv_data_manuf[];
+extern const guint addr_resolv_data_manuf_count;
+extern const addr_resolv_data_ether_t addr_resolv_data_wka[];
+extern const guint addr_resolv_data_wka_count;
+extern const addr_resolv_data_ether_t addr_resolv_data_ethers[];
+extern const guint addr_resolv_data_ethers_count;
+extern const addr_resolv_data_service_t addr_resolv_data_services[];
+extern const guint addr_resolv_data_services_count;
+extern const addr_resolv_data_enterprise_t addr_resolv_data_enterprises[];
+extern const guint addr_resolv_data_enterprises_count;
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __ADDR_RESOLV_DATA_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
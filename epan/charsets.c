@@ -110,6 +110,7 @@ get_utf_8_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
     wmem_strbuf_t *str;
     guint8 ch;
     const guint8 *prev;
+    size_t valid_len;
 
     str = wmem_strbuf_sized_new(scope, length+1, 0);
 
@@ -119,6 +120,19 @@ get_utf_8_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
      * U+FFFD Substitution of Maximal Subparts. */
     while (length > 0) {
         gsize unichar_len;
+
+        /* Copy as much well-formed UTF-8 as there is in one go; what
+         * follows works out what to substitute for the bad sequence
+         * after it, if there is one. */
+        valid_len = ws_utf8_valid_prefix_len(ptr, length);
+        if (valid_len != 0) {
+            wmem_strbuf_append_len(str, (const char *)ptr, valid_len);
+            ptr += valid_len;
+            length -= (gint)valid_len;
+            if (length == 0)
+                break;
+        }
+
         ch = *ptr;
 
         if (ch < 0x80) {
@@ -37,6 +37,7 @@
 #define BLUE_COMPONENT(x)  (guint16) ( (((x)        & 0xff) * 65535 / 255))
 
 static int read_filters_file(const gchar *path, FILE *f, gpointer user_data, color_filter_add_cb_func add_cb);
+static void color_filter_index_reset(void);
 
 /* the currently active filters */
 static GSList *color_filter_list = NULL;
@@ -46,6 +47,22 @@ static GSList *color_filter_list = NULL;
 static GSList *color_filter_deleted_list = NULL;
 static GSList *color_filter_valid_list   = NULL;
 
+/* The compiled filters of the enabled filters in color_filter_list, in
+ * order, so that the tree is primed once for all of them and filters with
+ * the same text are only run once per packet; rebuilt when the list or
+ * its filters change. */
+static dfilter_set_t *color_filter_set = NULL;
+static GPtrArray *color_filter_set_filters = NULL; /* color_filter_t *, by set index */
+static gboolean color_filter_set_stale = TRUE;
+
+/* The filters that packets have matched, by index - 1. Frames keep the
+ * index of their color filter rather than a pointer to it, which saves
+ * space in every frame_data. The filters are in color_filter_list or in
+ * color_filter_deleted_list, so they stay around as long as the table
+ * refers to them. */
+static GPtrArray *color_filter_indexed = NULL;
+static GHashTable *color_filter_indexes = NULL; /* color_filter_t * -> index */
+
 /* Color Filters can en-/disabled. */
 static gboolean filters_enabled = TRUE;
 
@@ -190,6 +207,7 @@ color_filters_set_tmp(guint8 filt_nr, const gchar *filter, gboolean disabled, gc
                 colorf->filter_text = g_strdup(tmpfilter);
                 colorf->c_colorfilter = compiled_filter;
                 colorf->disabled = ((i!=filt_nr) ? TRUE : disabled);
+                color_filter_set_stale = TRUE;
                 /* Remember that there are now temporary coloring filters set */
                 if( filter )
                     tmp_colors_set = TRUE;
@@ -349,7 +367,9 @@ gboolean
 color_filters_init(gchar** err_msg, color_filter_add_cb_func add_cb)
 {
     /* delete all currently existing filters */
+    color_filter_index_reset();
     color_filter_list_delete(&color_filter_list);
+    color_filter_set_stale = TRUE;
 
     /* now try to construct the filters list */
     return color_filters_get(err_msg, add_cb);
@@ -362,6 +382,7 @@ color_filters_reload(gchar** err_msg, color_filter_add_cb_func add_cb)
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
+    color_filter_set_stale = TRUE;
 
     /* now try to construct the filters list */
     return color_filters_get(err_msg, add_cb);
@@ -371,6 +392,7 @@ void
 color_filters_cleanup(void)
 {
     /* delete the previously deleted filters */
+    color_filter_index_reset();
     color_filter_list_delete(&color_filter_deleted_list);
 }
 
@@ -456,6 +478,7 @@ color_filters_apply(GSList *tmp_cfl, GSList *edit_cfl, gchar** err_msg)
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
+    color_filter_set_stale = TRUE;
 
     /* clone all list entries from tmp/edit to normal list */
     color_filter_valid_list = NULL;
@@ -493,15 +516,26 @@ tmp_color_filters_used(void)
     return tmp_colors_set;
 }
 
-/* prepare the epan_dissect_t for the filter */
 static void
-prime_edt(gpointer data, gpointer user_data)
+build_color_filter_set(void)
 {
-    color_filter_t *colorf = (color_filter_t *)data;
-    epan_dissect_t *edt    = (epan_dissect_t *)user_data;
+    GSList         *curr;
+    color_filter_t *colorf;
 
-    if (colorf->c_colorfilter != NULL)
-        epan_dissect_prime_with_dfilter(edt, colorf->c_colorfilter);
+    dfilter_set_free(color_filter_set);
+    color_filter_set = dfilter_set_new();
+    if (color_filter_set_filters == NULL)
+        color_filter_set_filters = g_ptr_array_new();
+    g_ptr_array_set_size(color_filter_set_filters, 0);
+
+    for (curr = color_filter_list; curr != NULL; curr = g_slist_next(curr)) {
+        colorf = (color_filter_t *)curr->data;
+        if (!colorf->disabled && colorf->c_colorfilter != NULL) {
+            dfilter_set_add(color_filter_set, colorf->c_colorfilter);
+            g_ptr_array_add(color_filter_set_filters, colorf);
+        }
+    }
+    color_filter_set_stale = FALSE;
 }
 
 /* Prime the epan_dissect_t with all the compiler
@@ -509,35 +543,81 @@ prime_edt(gpointer data, gpointer user_data)
 void
 color_filters_prime_edt(epan_dissect_t *edt)
 {
-    if (color_filters_used())
-        g_slist_foreach(color_filter_list, prime_edt, edt);
+    if (color_filters_used()) {
+        if (color_filter_set_stale)
+            build_color_filter_set();
+        dfilter_set_prime_proto_tree(color_filter_set, edt->tree);
+    }
 }
 
 /* * Return the color_t for later use */
 const color_filter_t *
 color_filters_colorize_packet(epan_dissect_t *edt)
 {
-    GSList         *curr;
-    color_filter_t *colorf;
+    guint i;
 
     /* If we have color filters, "search" for the matching one. */
     if ((edt->tree != NULL) && (color_filters_used())) {
-        curr = color_filter_list;
-
-        while(curr != NULL) {
-            colorf = (color_filter_t *)curr->data;
-            if ( (!colorf->disabled) &&
-                 (colorf->c_colorfilter != NULL) &&
-                 dfilter_apply_edt(colorf->c_colorfilter, edt)) {
-                return colorf;
+        if (color_filter_set_stale)
+            build_color_filter_set();
+        dfilter_set_reset(color_filter_set);
+
+        for (i = 0; i < color_filter_set_filters->len; i++) {
+            if (dfilter_set_apply_edt(color_filter_set, i, edt)) {
+                return (const color_filter_t *)g_ptr_array_index(color_filter_set_filters, i);
             }
-            curr = g_slist_next(curr);
         }
     }
 
     return NULL;
 }
 
+static void
+color_filter_index_reset(void)
+{
+    if (color_filter_indexed != NULL) {
+        g_ptr_array_free(color_filter_indexed, TRUE);
+        color_filter_indexed = NULL;
+        g_hash_table_destroy(color_filter_indexes);
+        color_filter_indexes = NULL;
+    }
+}
+
+guint16
+color_filters_get_index(const color_filter_t *colorf)
+{
+    guint index;
+
+    if (colorf == NULL)
+        return 0;
+
+    if (color_filter_indexed == NULL) {
+        color_filter_indexed = g_ptr_array_new();
+        color_filter_indexes = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+
+    index = GPOINTER_TO_UINT(g_hash_table_lookup(color_filter_indexes, colorf));
+    if (index == 0) {
+        if (color_filter_indexed->len >= G_MAXUINT16) {
+            /* Only if the filters have been changed tens of thousands of
+             * times with a file open; leave the packet uncolored. */
+            return 0;
+        }
+        g_ptr_array_add(color_filter_indexed, (gpointer)colorf);
+        index = color_filter_indexed->len;
+        g_hash_table_insert(color_filter_indexes, (gpointer)colorf, GUINT_TO_POINTER(index));
+    }
+    return (guint16)index;
+}
+
+const color_filter_t *
+color_filters_get_by_index(guint16 index)
+{
+    if (index == 0 || color_filter_indexed == NULL || index > color_filter_indexed->len)
+        return NULL;
+    return (const color_filter_t *)g_ptr_array_index(color_filter_indexed, index - 1);
+}
+
 /* read filters from the given file */
 /* XXX - Would it make more sense to use GStrings here instead of reallocing
    our buffers? */
@@ -679,6 +759,7 @@ read_filters_file(const gchar *path, FILE *f, gpointer user_data, color_filter_a
                 /* internal call */
                 colorf->c_colorfilter = temp_dfilter;
                 *cfl = g_slist_append(*cfl, colorf);
+                color_filter_set_stale = TRUE;
             } else {
                 /* external call */
                 /* just editing, don't need the compiled filter */
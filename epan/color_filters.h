@@ -117,6 +117,22 @@ WS_DLL_PUBLIC void color_filters_prime_edt(struct epan_dissect *edt);
 WS_DLL_PUBLIC const color_filter_t *
 color_filters_colorize_packet(struct epan_dissect *edt);
 
+/** Get the index by which a frame_data refers to a color filter.
+ *
+ * @param colorf the color filter, or NULL
+ * @return the index, or 0 for NULL
+ */
+WS_DLL_PUBLIC guint16
+color_filters_get_index(const color_filter_t *colorf);
+
+/** Get the color filter with a given index.
+ *
+ * @param index an index from color_filters_get_index()
+ * @return the color filter, or NULL for 0 or an index that's no longer valid
+ */
+WS_DLL_PUBLIC const color_filter_t *
+color_filters_get_by_index(guint16 index);
+
 /** Clone the currently active filter list.
  *
  * @param user_data will be returned by each call to color_filter_add_cb()
@@ -35,6 +35,8 @@
 /* #define DEBUG_CONVERSATION */
 #include "conversation_debug.h"
 
+#include <wsutil/perf_stats.h>
+
 #ifdef DEBUG_CONVERSATION
 int _debug_conversation_indent = 0;
 #endif
@@ -98,8 +100,79 @@ static wmem_map_t *conversation_hashtable_no_addr2_or_port2 = NULL;
  */
 static wmem_map_t *conversation_hashtable_id = NULL;
 
+/*
+ * Index of the conversations in conversation_hashtable_exact_addr_port
+ * between two IPv4 or two IPv6 addresses, which are most of them, and
+ * which find_conversation() looks up in both directions.  The keys are
+ * fixed-size, to be hashed and compared quickly, and have the endpoints
+ * in a canonical order, so that one lookup finds the chains for both
+ * directions.
+ */
+typedef struct {
+    guint8  addrs[2][16];   /* zero-padded for IPv4 */
+    guint32 ports[2];
+    guint32 addr_len;       /* 4 or 16 */
+    guint32 ctype;
+} conv_ip_key_t;
+
+typedef struct {
+    conv_ip_key_t   key;
+    /* The exact table's chains for the key's endpoints in order, and in
+     * reverse; the same chains, with the same heads, as in that table. */
+    conversation_t *chains[2];
+} conv_ip_entry_t;
+
+static wmem_map_t *conversation_ip_index = NULL;
+
+/*
+ * Index of the IPv4 and IPv6 endpoints that are the first endpoints of
+ * conversations in the wildcard tables, with how many there are in each;
+ * when the search for an exact match fails, find_conversation() looks
+ * up each endpoint of the packet here once, instead of looking it up in
+ * each of the wildcard tables, which seldom have anything for it.
+ */
+enum {
+    CONV_WILDCARD_NO_ADDR2,
+    CONV_WILDCARD_NO_PORT2,
+    CONV_WILDCARD_NO_ADDR2_OR_PORT2,
+    CONV_WILDCARD_COUNT
+};
+
+#define CONV_WILDCARD_ALL ((1U << CONV_WILDCARD_COUNT) - 1)
+
+typedef struct {
+    guint8  addr[16];       /* zero-padded for IPv4 */
+    guint32 port;
+    guint32 addr_len;       /* 4 or 16 */
+    guint32 ctype;
+} conv_ip_endpoint_key_t;
+
+typedef struct {
+    conv_ip_endpoint_key_t key;
+    guint                  counts[CONV_WILDCARD_COUNT];
+} conv_ip_endpoint_t;
+
+static wmem_map_t *conversation_ip_endpoints = NULL;
+
 static guint32 new_index;
 
+/*
+ * Expiry of idle conversations.  When it's on, all the conversations
+ * are kept on a list, least recently used first.
+ */
+static gboolean conversation_expiry;
+static guint conversation_max_count;   /* 0 for no limit */
+static conversation_t *conversation_lru_first;
+static conversation_t *conversation_lru_last;
+static guint conversation_lru_count;
+static guint64 conversation_expired_count;
+static guint64 conversation_proto_data_freed;
+
+/*
+ * Functions that free protocols' conversation data, by protocol.
+ */
+static wmem_map_t *conversation_proto_data_free_funcs = NULL;
+
 /*
  * Placeholder for address-less conversations.
  */
@@ -133,9 +206,9 @@ conversation_get_key_type(conversation_element_t *elements)
     return elements[count].conversation_type_val;
 }
 
-/* Create a string based on element types. */
-static char*
-conversation_element_list_name(wmem_allocator_t *allocator, conversation_element_t *elements) {
+/* Append a string based on element types to a string buffer. */
+static void
+conversation_element_list_name_buf(wmem_strbuf_t *conv_hash_group, conversation_element_t *elements) {
     const char *type_names[] = {
         "endpoint",
         "address",
@@ -144,17 +217,29 @@ conversation_element_list_name(wmem_allocator_t *allocator, conversation_element
         "uint",
         "uint64",
     };
-    char *sep = "";
-    wmem_strbuf_t *conv_hash_group = wmem_strbuf_new(allocator, "");
     size_t element_count = conversation_element_count(elements);
     for (size_t i = 0; i < element_count; i++) {
         conversation_element_t *cur_el = &elements[i];
-        wmem_strbuf_append_printf(conv_hash_group, "%s%s", sep, type_names[cur_el->type]);
-        sep = ",";
+        if (i > 0) {
+            wmem_strbuf_append_c(conv_hash_group, ',');
+        }
+        wmem_strbuf_append(conv_hash_group, type_names[cur_el->type]);
     }
+}
+
+/* Create a string based on element types. */
+static char*
+conversation_element_list_name(wmem_allocator_t *allocator, conversation_element_t *elements) {
+    wmem_strbuf_t *conv_hash_group = wmem_strbuf_new(allocator, "");
+    conversation_element_list_name_buf(conv_hash_group, elements);
     return wmem_strbuf_finalize(conv_hash_group);
 }
 
+/* Room for the names of the usual element lists, e.g.
+ * "address,port,address,port,endpoint", so that looking one up doesn't
+ * allocate. */
+#define CONV_ELEMENT_LIST_NAME_LEN 64
+
 #if 0 // debugging
 static char* conversation_element_list_values(conversation_element_t *elements) {
     const char *type_names[] = {
@@ -442,6 +527,214 @@ conversation_match_element_list(gconstpointer v1, gconstpointer v2)
     return TRUE;
 }
 
+/*
+ * Hash a fixed-size key, a multiple of 4 bytes long.
+ */
+static guint
+conversation_hash_ip_key(const void *key, size_t len)
+{
+    const guint8 *p = (const guint8 *)key;
+    guint32 hash_val = 0;
+    guint32 word;
+
+    for (size_t i = 0; i < len; i += sizeof word) {
+        memcpy(&word, p + i, sizeof word);
+        hash_val = (hash_val ^ word) * 0x9e3779b1;
+        hash_val ^= hash_val >> 15;
+    }
+    return hash_val;
+}
+
+static guint
+conversation_ip_key_hash(gconstpointer v)
+{
+    return conversation_hash_ip_key(v, sizeof (conv_ip_key_t));
+}
+
+static gboolean
+conversation_ip_key_equal(gconstpointer v1, gconstpointer v2)
+{
+    return memcmp(v1, v2, sizeof (conv_ip_key_t)) == 0;
+}
+
+static guint
+conversation_ip_endpoint_key_hash(gconstpointer v)
+{
+    return conversation_hash_ip_key(v, sizeof (conv_ip_endpoint_key_t));
+}
+
+static gboolean
+conversation_ip_endpoint_key_equal(gconstpointer v1, gconstpointer v2)
+{
+    return memcmp(v1, v2, sizeof (conv_ip_endpoint_key_t)) == 0;
+}
+
+/*
+ * The length of an address, if it's the sort the IP indexes are for,
+ * or 0.
+ */
+static guint32
+conversation_ip_addr_len(const address *addr)
+{
+    if (addr->type == AT_IPv4 && addr->len == 4)
+        return 4;
+    if (addr->type == AT_IPv6 && addr->len == 16)
+        return 16;
+    return 0;
+}
+
+/*
+ * Fill in an IP index key for a pair of endpoints, and which of the
+ * entry's chains is for them in this order.  Returns FALSE if the
+ * endpoints aren't the sort the index is for.
+ */
+static gboolean
+conversation_ip_key_init(conv_ip_key_t *key, guint *dir, const address *addr1,
+        const guint32 port1, const address *addr2, const guint32 port2,
+        const conversation_type ctype)
+{
+    guint32 addr_len = conversation_ip_addr_len(addr1);
+    int cmp;
+
+    if (addr_len == 0 || addr2->type != addr1->type || addr2->len != addr1->len)
+        return FALSE;
+
+    cmp = memcmp(addr1->data, addr2->data, addr_len);
+    *dir = (cmp > 0 || (cmp == 0 && port1 > port2)) ? 1 : 0;
+
+    memset(key, 0, sizeof *key);
+    memcpy(key->addrs[*dir], addr1->data, addr_len);
+    memcpy(key->addrs[!*dir], addr2->data, addr_len);
+    key->ports[*dir] = port1;
+    key->ports[!*dir] = port2;
+    key->addr_len = addr_len;
+    key->ctype = ctype;
+    return TRUE;
+}
+
+static gboolean
+conversation_ip_endpoint_key_init(conv_ip_endpoint_key_t *key,
+        const address *addr, const guint32 port, const conversation_type ctype)
+{
+    guint32 addr_len = conversation_ip_addr_len(addr);
+
+    if (addr_len == 0)
+        return FALSE;
+
+    memset(key, 0, sizeof *key);
+    memcpy(key->addr, addr->data, addr_len);
+    key->port = port;
+    key->addr_len = addr_len;
+    key->ctype = ctype;
+    return TRUE;
+}
+
+/*
+ * Bring the IP indexes up to date after a conversation has been added to
+ * one of the hash tables, or removed from it.
+ */
+static void
+conversation_ip_index_update(wmem_map_t *hashtable, conversation_t *conv, const gboolean added)
+{
+    const conversation_element_t *key = conv->key_ptr;
+    conversation_type ctype = conversation_get_key_type(conv->key_ptr);
+    int wildcard;
+
+    if (hashtable == conversation_hashtable_exact_addr_port) {
+        conv_ip_key_t ip_key;
+        conv_ip_entry_t *entry;
+        conversation_t *chain_head;
+        guint dir;
+
+        if (!conversation_ip_key_init(&ip_key, &dir,
+                    &key[ADDR1_IDX].addr_val, key[PORT1_IDX].port_val,
+                    &key[ADDR2_IDX].addr_val, key[PORT2_IDX].port_val, ctype))
+            return;
+
+        chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
+        entry = (conv_ip_entry_t *)wmem_map_lookup(conversation_ip_index, &ip_key);
+        if (entry == NULL) {
+            if (chain_head == NULL)
+                return;
+            entry = wmem_new0(wmem_file_scope(), conv_ip_entry_t);
+            entry->key = ip_key;
+            wmem_map_insert(conversation_ip_index, &entry->key, entry);
+        }
+        entry->chains[dir] = chain_head;
+        if (entry->chains[0] == NULL && entry->chains[1] == NULL) {
+            /* Both chains are gone, as conversations are expired */
+            wmem_map_remove(conversation_ip_index, &entry->key);
+            wmem_free(wmem_file_scope(), entry);
+        }
+        return;
+    }
+
+    if (hashtable == conversation_hashtable_no_addr2)
+        wildcard = CONV_WILDCARD_NO_ADDR2;
+    else if (hashtable == conversation_hashtable_no_port2)
+        wildcard = CONV_WILDCARD_NO_PORT2;
+    else if (hashtable == conversation_hashtable_no_addr2_or_port2)
+        wildcard = CONV_WILDCARD_NO_ADDR2_OR_PORT2;
+    else
+        return;
+
+    conv_ip_endpoint_key_t ep_key;
+    conv_ip_endpoint_t *endpoint;
+
+    if (!conversation_ip_endpoint_key_init(&ep_key, &key[ADDR1_IDX].addr_val,
+                key[PORT1_IDX].port_val, ctype))
+        return;
+
+    endpoint = (conv_ip_endpoint_t *)wmem_map_lookup(conversation_ip_endpoints, &ep_key);
+    if (endpoint == NULL) {
+        endpoint = wmem_new0(wmem_file_scope(), conv_ip_endpoint_t);
+        endpoint->key = ep_key;
+        wmem_map_insert(conversation_ip_endpoints, &endpoint->key, endpoint);
+    }
+    if (added) {
+        endpoint->counts[wildcard]++;
+    } else {
+        endpoint->counts[wildcard]--;
+        if (endpoint->counts[CONV_WILDCARD_NO_ADDR2] == 0 &&
+            endpoint->counts[CONV_WILDCARD_NO_PORT2] == 0 &&
+            endpoint->counts[CONV_WILDCARD_NO_ADDR2_OR_PORT2] == 0) {
+            wmem_map_remove(conversation_ip_endpoints, &endpoint->key);
+            wmem_free(wmem_file_scope(), endpoint);
+        }
+    }
+}
+
+/*
+ * Which of the wildcard tables might have a conversation with the given
+ * first endpoint, as a mask of (1 << CONV_WILDCARD_xxx) bits.
+ */
+static guint
+conversation_ip_wildcards(const address *addr, const guint32 port, const conversation_type ctype)
+{
+    conv_ip_endpoint_key_t ep_key;
+    conv_ip_endpoint_t *endpoint;
+    guint wildcards = 0;
+
+    if (!conversation_ip_endpoint_key_init(&ep_key, addr, port, ctype))
+        return CONV_WILDCARD_ALL;   /* not indexed */
+
+    endpoint = (conv_ip_endpoint_t *)wmem_map_lookup(conversation_ip_endpoints, &ep_key);
+    if (endpoint != NULL) {
+        for (int i = 0; i < CONV_WILDCARD_COUNT; i++) {
+            if (endpoint->counts[i] != 0)
+                wildcards |= 1U << i;
+        }
+    }
+    return wildcards;
+}
+
+/* The number of conversations created for the current file, for perf_stats. */
+static guint64
+conversation_count(void)
+{
+    return new_index;
+}
+
 /**
  * Create a new hash tables for conversations.
  */
@@ -520,6 +813,18 @@ conversation_init(void)
                                                        conversation_match_element_list);
     wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), id_map_key),
                     conversation_hashtable_id);
+
+    conversation_ip_index = wmem_map_new_flat_autoreset(wmem_epan_scope(), wmem_file_scope(),
+                                                        conversation_ip_key_hash,
+                                                        conversation_ip_key_equal);
+    conversation_ip_endpoints = wmem_map_new_flat_autoreset(wmem_epan_scope(), wmem_file_scope(),
+                                                            conversation_ip_endpoint_key_hash,
+                                                            conversation_ip_endpoint_key_equal);
+
+    conversation_proto_data_free_funcs = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
+
+    ws_perf_gauge_register("epan.conversations", "Conversations",
+                           WS_PERF_UNIT_COUNT, conversation_count);
 }
 
 /**
@@ -532,6 +837,46 @@ conversation_epan_reset(void)
      * Start the conversation indices over at 0.
      */
     new_index = 0;
+
+    /*
+     * The conversations on the expiry list have gone with the file.
+     */
+    conversation_lru_first = NULL;
+    conversation_lru_last = NULL;
+    conversation_lru_count = 0;
+}
+
+/*
+ * Put a conversation at the end of the expiry list, as it's been used
+ * in the given frame.
+ */
+static void
+conversation_touch(conversation_t *conv, const guint32 frame_num)
+{
+    if (frame_num > conv->last_used_frame)
+        conv->last_used_frame = frame_num;
+
+    if (conv == conversation_lru_last)
+        return;
+
+    if (conv->lru_prev != NULL || conv == conversation_lru_first) {
+        /* Take it off the list */
+        if (conv->lru_prev != NULL)
+            conv->lru_prev->lru_next = conv->lru_next;
+        else
+            conversation_lru_first = conv->lru_next;
+        conv->lru_next->lru_prev = conv->lru_prev;
+    } else {
+        conversation_lru_count++;
+    }
+
+    conv->lru_prev = conversation_lru_last;
+    conv->lru_next = NULL;
+    if (conversation_lru_last != NULL)
+        conversation_lru_last->lru_next = conv;
+    else
+        conversation_lru_first = conv;
+    conversation_lru_last = conv;
 }
 
 /*
@@ -591,6 +936,8 @@ conversation_insert_into_hashtable(wmem_map_t *hashtable, conversation_t *conv)
             }
         }
     }
+
+    conversation_ip_index_update(hashtable, conv, TRUE);
 }
 
 /*
@@ -603,6 +950,10 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
     conversation_t *chain_head, *cur, *prev;
 
     chain_head = (conversation_t *)wmem_map_lookup(hashtable, conv->key_ptr);
+    if (chain_head == NULL) {
+        /* XXX: Conversation not found. Wrong hashtable? */
+        return;
+    }
 
     if (conv == chain_head) {
         /* We are currently the front of the chain */
@@ -625,6 +976,7 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 
             wmem_map_insert(hashtable, chain_head->key_ptr, chain_head);
         }
+        conversation_ip_index_update(hashtable, conv, FALSE);
     }
     else {
         /* We are not the front of the chain. Loop through to find us.
@@ -650,6 +1002,8 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
 
         if (chain_head->latest_found == conv)
             chain_head->latest_found = prev;
+
+        conversation_ip_index_update(hashtable, conv, FALSE);
     }
 }
 
@@ -657,13 +1011,17 @@ conversation_t *conversation_new_full(const guint32 setup_frame, conversation_el
 {
     DISSECTOR_ASSERT(elements);
 
-    char *el_list_map_key = conversation_element_list_name(wmem_epan_scope(), elements);
-    wmem_map_t *el_list_map = (wmem_map_t *) wmem_map_lookup(conversation_hashtable_element_list, el_list_map_key);
+    char el_list_name[CONV_ELEMENT_LIST_NAME_LEN];
+    wmem_strbuf_t el_list_map_key;
+    wmem_strbuf_init_buf(&el_list_map_key, NULL, el_list_name, sizeof el_list_name, 0);
+    conversation_element_list_name_buf(&el_list_map_key, elements);
+    wmem_map_t *el_list_map = (wmem_map_t *) wmem_map_lookup(conversation_hashtable_element_list, wmem_strbuf_get_str(&el_list_map_key));
     if (!el_list_map) {
         el_list_map = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), conversation_hash_element_list,
                 conversation_match_element_list);
-        wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_file_scope(), el_list_map_key), el_list_map);
+        wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_file_scope(), wmem_strbuf_get_str(&el_list_map_key)), el_list_map);
     }
+    wmem_strbuf_release(&el_list_map_key);
 
     size_t element_count = conversation_element_count(elements);
     conversation_element_t *conv_key = wmem_memdup(wmem_file_scope(), elements, sizeof(conversation_element_t) * element_count);
@@ -683,6 +1041,8 @@ conversation_t *conversation_new_full(const guint32 setup_frame, conversation_el
 
     conversation->key_ptr = conv_key;
     conversation_insert_into_hashtable(el_list_map, conversation);
+    if (conversation_expiry)
+        conversation_touch(conversation, setup_frame);
     return conversation;
 }
 
@@ -867,6 +1227,9 @@ conversation_new(const guint32 setup_frame, const address *addr1, const address
     conversation_insert_into_hashtable(hashtable, conversation);
     DENDENT();
 
+    if (conversation_expiry)
+        conversation_touch(conversation, setup_frame);
+
     return conversation;
 }
 
@@ -887,6 +1250,9 @@ conversation_new_by_id(const guint32 setup_frame, const conversation_type ctype,
     conversation->key_ptr = elements;
     conversation_insert_into_hashtable(conversation_hashtable_id, conversation);
 
+    if (conversation_expiry)
+        conversation_touch(conversation, setup_frame);
+
     return conversation;
 }
 
@@ -983,12 +1349,13 @@ conversation_set_addr2(conversation_t *conv, const address *addr)
     DENDENT();
 }
 
-static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_hashtable, const guint32 frame_num, conversation_element_t *conv_key)
+/*
+ * Find the latest conversation in a chain set up before frame_num.
+ */
+static conversation_t *conversation_lookup_chain(conversation_t *chain_head, const guint32 frame_num)
 {
     conversation_t* convo = NULL;
     conversation_t* match = NULL;
-    conversation_t* chain_head = NULL;
-    chain_head = (conversation_t *)wmem_map_lookup(conversation_hashtable, conv_key);
 
     if (chain_head && (chain_head->setup_frame <= frame_num)) {
         match = chain_head;
@@ -1008,16 +1375,26 @@ static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_ha
 
     if (match) {
         chain_head->latest_found = match;
+        if (conversation_expiry)
+            conversation_touch(match, frame_num);
     }
 
     return match;
 }
 
+static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_hashtable, const guint32 frame_num, conversation_element_t *conv_key)
+{
+    return conversation_lookup_chain((conversation_t *)wmem_map_lookup(conversation_hashtable, conv_key), frame_num);
+}
+
 conversation_t *find_conversation_full(const guint32 frame_num, conversation_element_t *elements)
 {
-    char *el_list_map_key = conversation_element_list_name(NULL, elements);
-    wmem_map_t *el_list_map = (wmem_map_t *) wmem_map_lookup(conversation_hashtable_element_list, el_list_map_key);
-    g_free(el_list_map_key);
+    char el_list_name[CONV_ELEMENT_LIST_NAME_LEN];
+    wmem_strbuf_t el_list_map_key;
+    wmem_strbuf_init_buf(&el_list_map_key, NULL, el_list_name, sizeof el_list_name, 0);
+    conversation_element_list_name_buf(&el_list_map_key, elements);
+    wmem_map_t *el_list_map = (wmem_map_t *) wmem_map_lookup(conversation_hashtable_element_list, wmem_strbuf_get_str(&el_list_map_key));
+    wmem_strbuf_release(&el_list_map_key);
     if (!el_list_map) {
         return NULL;
     }
@@ -1134,6 +1511,9 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
         const guint32 port_a, const guint32 port_b, const guint options)
 {
     conversation_t *conversation, *other_conv;
+    conv_ip_key_t ip_key;
+    guint ip_dir;
+    guint wildcards_a, wildcards_b;
 
     if (!addr_a) {
         addr_a = &null_address_;
@@ -1157,21 +1537,38 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
          * Neither search address B nor search port B are wildcarded,
          * start out with an exact match.
          */
-        DPRINT(("trying exact match: %s:%d -> %s:%d",
-                    addr_a_str, port_a, addr_b_str, port_b));
-        conversation = conversation_lookup_exact(frame_num, addr_a, port_a, addr_b, port_b, ctype);
-        /*
-         * Look for an alternate conversation in the opposite direction, which
-         * might fit better. Note that using the helper functions such as
-         * find_conversation_pinfo and find_or_create_conversation will finally
-         * call this function and look for an orientation-agnostic conversation.
-         * If oriented conversations had to be implemented, amend this code or
-         * create new functions.
-         */
+        if (conversation_ip_key_init(&ip_key, &ip_dir, addr_a, port_a, addr_b, port_b, ctype)) {
+            /*
+             * Look up both directions at once, in the index of IP
+             * conversations, which has the same chains.
+             */
+            conv_ip_entry_t *entry = (conv_ip_entry_t *)wmem_map_lookup(conversation_ip_index, &ip_key);
 
-        DPRINT(("trying exact match: %s:%d -> %s:%d",
-                    addr_b_str, port_b, addr_a_str, port_a));
-        other_conv = conversation_lookup_exact(frame_num, addr_b, port_b, addr_a, port_a, ctype);
+            DPRINT(("trying exact match in both directions: %s:%d <-> %s:%d",
+                        addr_a_str, port_a, addr_b_str, port_b));
+            if (entry != NULL) {
+                conversation = conversation_lookup_chain(entry->chains[ip_dir], frame_num);
+                other_conv = conversation_lookup_chain(entry->chains[!ip_dir], frame_num);
+            } else {
+                conversation = other_conv = NULL;
+            }
+        } else {
+            DPRINT(("trying exact match: %s:%d -> %s:%d",
+                        addr_a_str, port_a, addr_b_str, port_b));
+            conversation = conversation_lookup_exact(frame_num, addr_a, port_a, addr_b, port_b, ctype);
+            /*
+             * Look for an alternate conversation in the opposite direction, which
+             * might fit better. Note that using the helper functions such as
+             * find_conversation_pinfo and find_or_create_conversation will finally
+             * call this function and look for an orientation-agnostic conversation.
+             * If oriented conversations had to be implemented, amend this code or
+             * create new functions.
+             */
+
+            DPRINT(("trying exact match: %s:%d -> %s:%d",
+                        addr_b_str, port_b, addr_a_str, port_a));
+            other_conv = conversation_lookup_exact(frame_num, addr_b, port_b, addr_a, port_a, ctype);
+        }
         if (other_conv != NULL) {
             if (conversation != NULL) {
                 if(other_conv->conv_index > conversation->conv_index) {
@@ -1195,6 +1592,13 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
             goto end;
     }
 
+    /*
+     * Find out which of the wildcard tables could have anything for
+     * either endpoint, if they're IP endpoints; they rarely do.
+     */
+    wildcards_a = conversation_ip_wildcards(addr_a, port_a, ctype);
+    wildcards_b = conversation_ip_wildcards(addr_b, port_b, ctype);
+
     /*
      * Well, that didn't find anything.  Try matches that wildcard
      * one of the addresses, if we have two ports.
@@ -1211,7 +1615,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
          */
         DPRINT(("trying wildcarded match: %s:%d -> *:%d",
                     addr_a_str, port_a, port_b));
-        conversation = conversation_lookup_no_addr2(frame_num, addr_a, port_a, port_b, ctype);
+        conversation = (wildcards_a & (1U << CONV_WILDCARD_NO_ADDR2)) ?
+            conversation_lookup_no_addr2(frame_num, addr_a, port_a, port_b, ctype) : NULL;
         if ((conversation == NULL) && (addr_a->type == AT_FC)) {
             /* In Fibre channel, OXID & RXID are never swapped as
              * TCP/UDP ports are in TCP/IP.
@@ -1261,7 +1666,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
         if (!(options & NO_ADDR_B)) {
             DPRINT(("trying wildcarded match: %s:%d -> *:%d",
                         addr_b_str, port_b, port_a));
-            conversation = conversation_lookup_no_addr2(frame_num, addr_b, port_b, port_a, ctype);
+            conversation = (wildcards_b & (1U << CONV_WILDCARD_NO_ADDR2)) ?
+                conversation_lookup_no_addr2(frame_num, addr_b, port_b, port_a, ctype) : NULL;
             if (conversation != NULL) {
                 /*
                  * If this is for a connection-oriented
@@ -1304,7 +1710,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
          */
         DPRINT(("trying wildcarded match: %s:%d -> %s:*",
                     addr_a_str, port_a, addr_b_str));
-        conversation = conversation_lookup_no_port2(frame_num, addr_a, port_a, addr_b, ctype);
+        conversation = (wildcards_a & (1U << CONV_WILDCARD_NO_PORT2)) ?
+            conversation_lookup_no_port2(frame_num, addr_a, port_a, addr_b, ctype) : NULL;
         if ((conversation == NULL) && (addr_a->type == AT_FC)) {
             /* In Fibre channel, OXID & RXID are never swapped as
              * TCP/UDP ports are in TCP/IP
@@ -1353,7 +1760,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
         if (!(options & NO_PORT_B)) {
             DPRINT(("trying wildcarded match: %s:%d -> %s:*",
                         addr_b_str, port_b, addr_a_str));
-            conversation = conversation_lookup_no_port2(frame_num, addr_b, port_b, addr_a, ctype);
+            conversation = (wildcards_b & (1U << CONV_WILDCARD_NO_PORT2)) ?
+                conversation_lookup_no_port2(frame_num, addr_b, port_b, addr_a, ctype) : NULL;
             if (conversation != NULL) {
                 /*
                  * If this is for a connection-oriented
@@ -1390,7 +1798,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
      * (Neither "addr_b" nor "port_b" take part in this lookup.)
      */
     DPRINT(("trying wildcarded match: %s:%d -> *:*", addr_a_str, port_a));
-    conversation = conversation_lookup_no_addr2_or_port2(frame_num, addr_a, port_a, ctype);
+    conversation = (wildcards_a & (1U << CONV_WILDCARD_NO_ADDR2_OR_PORT2)) ?
+        conversation_lookup_no_addr2_or_port2(frame_num, addr_a, port_a, ctype) : NULL;
     if (conversation != NULL) {
         /*
          * If this is for a connection-oriented protocol:
@@ -1447,7 +1856,8 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
         } else {
             DPRINT(("trying wildcarded match: %s:%d -> *:*",
                         addr_b_str, port_b));
-            conversation = conversation_lookup_no_addr2_or_port2(frame_num, addr_b, port_b, ctype);
+            conversation = (wildcards_b & (1U << CONV_WILDCARD_NO_ADDR2_OR_PORT2)) ?
+                conversation_lookup_no_addr2_or_port2(frame_num, addr_b, port_b, ctype) : NULL;
         }
         if (conversation != NULL) {
             /*
@@ -1541,7 +1951,7 @@ conversation_set_dissector_from_frame_number(conversation_t *conversation,
         const guint32 starting_frame_num, const dissector_handle_t handle)
 {
     if (!conversation->dissector_tree) {
-        conversation->dissector_tree = wmem_tree_new(wmem_file_scope());
+        conversation->dissector_tree = wmem_tree_new_sorted32(wmem_file_scope());
     }
     wmem_tree_insert32(conversation->dissector_tree, starting_frame_num, (void *)handle);
 }
@@ -1828,6 +2238,92 @@ conversation_get_id_from_elements(struct _packet_info *pinfo, conversation_type
     return pinfo->conv_elements[0].uint_val;
 }
 
+void
+conversation_set_expiry(const gboolean enable, const guint max_conversations)
+{
+    conversation_expiry = enable;
+    conversation_max_count = max_conversations;
+}
+
+void
+conversation_register_proto_data_free(const int proto, conversation_proto_data_free_func free_func)
+{
+    wmem_map_insert(conversation_proto_data_free_funcs, GINT_TO_POINTER(proto), (void *)free_func);
+}
+
+static void
+conversation_free_proto_data(gpointer key, gpointer value, gpointer userdata)
+{
+    conversation_t *conv = (conversation_t *)userdata;
+    conversation_proto_data_free_func free_func = (conversation_proto_data_free_func)value;
+    void *proto_data;
+
+    proto_data = wmem_tree_lookup32(conv->data_list, GPOINTER_TO_UINT(key));
+    if (proto_data != NULL) {
+        free_func(conv, proto_data);
+        wmem_tree_remove32(conv->data_list, GPOINTER_TO_UINT(key));
+        conversation_proto_data_freed++;
+    }
+}
+
+/*
+ * Remove a conversation from its hash table and the expiry list, so that
+ * it's no longer found, and free the data of the protocols that have
+ * registered a function to do so.
+ *
+ * The conversation itself, its key and the rest of its data are left to
+ * be freed along with the file scope: dissectors keep pointers to
+ * conversations in their own tables, e.g. DCE/RPC's bind and call keys,
+ * and those mustn't be left dangling, or match a new conversation that
+ * gets the same address.
+ */
+static void
+conversation_expire_one(conversation_t *conv)
+{
+    char *el_list_map_key = conversation_element_list_name(NULL, conv->key_ptr);
+    wmem_map_t *hashtable = (wmem_map_t *)wmem_map_lookup(conversation_hashtable_element_list, el_list_map_key);
+    g_free(el_list_map_key);
+    if (hashtable != NULL)
+        conversation_remove_from_hashtable(hashtable, conv);
+
+    if (conv->lru_prev != NULL)
+        conv->lru_prev->lru_next = conv->lru_next;
+    else
+        conversation_lru_first = conv->lru_next;
+    if (conv->lru_next != NULL)
+        conv->lru_next->lru_prev = conv->lru_prev;
+    else
+        conversation_lru_last = conv->lru_prev;
+    conv->lru_prev = NULL;
+    conv->lru_next = NULL;
+    conversation_lru_count--;
+
+    if (conv->data_list != NULL)
+        wmem_map_foreach(conversation_proto_data_free_funcs, conversation_free_proto_data, conv);
+    conversation_expired_count++;
+}
+
+guint
+conversation_expire(const guint32 oldest_frame)
+{
+    guint expired = 0;
+
+    while (conversation_lru_first != NULL &&
+            (conversation_lru_first->last_used_frame < oldest_frame ||
+             (conversation_max_count != 0 && conversation_lru_count > conversation_max_count))) {
+        conversation_expire_one(conversation_lru_first);
+        expired++;
+    }
+    return expired;
+}
+
+void
+conversation_get_expiry_stats(guint64 *expired_conversations, guint64 *freed_proto_data)
+{
+    *expired_conversations = conversation_expired_count;
+    *freed_proto_data = conversation_proto_data_freed;
+}
+
 wmem_map_t *
 get_conversation_hashtables(void)
 {
@@ -200,6 +200,10 @@ typedef struct conversation {
     wmem_tree_t *dissector_tree;	/** tree containing protocol dissector client associated with conversation */
     guint	options;		/** wildcard flags */
     conversation_element_t *key_ptr;	/** Keys are conversation element arrays terminated with a CE_CONVERSATION_TYPE */
+    wmem_map_t *heur_hints;		/** heuristic dissector that last took a packet in this conversation, by heuristic dissector list */
+    struct conversation *lru_prev;	/** previous conversation on the expiry list, used less recently */
+    struct conversation *lru_next;	/** next conversation on the expiry list, used more recently */
+    guint32 last_used_frame;		/** highest frame number in which this conversation was found, if expiry is on */
 } conversation_t;
 
 /*
@@ -473,6 +477,56 @@ WS_DLL_PUBLIC void conversation_set_addr2(conversation_t *conv, const address *a
  */
 WS_DLL_PUBLIC wmem_map_t *get_conversation_hashtables(void);
 
+/**
+ * Turn expiry of idle conversations on or off.  It's meant for long-running
+ * live captures, where packets are dissected once, in order, and where
+ * keeping every conversation would use up all the memory; it must be turned
+ * on before the first packet is dissected.
+ *
+ * Expired conversations are no longer found, and the conversation data of
+ * the protocols that have registered a function to free it is freed.  The
+ * conversations themselves, and the rest of their data, are left to be
+ * freed along with the file scope, as dissectors may still have pointers
+ * to them.  A packet that would have been part of an expired conversation
+ * gets a new one.
+ *
+ * @param enable TRUE to turn it on.
+ * @param max_conversations The most conversations to keep, expiring the
+ * least recently used ones beyond that, or 0 for no limit.
+ */
+WS_DLL_PUBLIC void conversation_set_expiry(const gboolean enable, const guint max_conversations);
+
+/** A function to free a protocol's data for a conversation, and whatever it
+ * points to, when the conversation is expired.  The protocol must not keep
+ * pointers to that data anywhere but in the conversation. */
+typedef void (*conversation_proto_data_free_func)(conversation_t *conv, void *proto_data);
+
+/**
+ * Register a function to free a protocol's conversation data when a
+ * conversation is expired.  The data is removed from the conversation once
+ * it's freed.  Data of protocols that haven't registered one is kept until
+ * the file scope is freed.
+ */
+WS_DLL_PUBLIC void conversation_register_proto_data_free(const int proto, conversation_proto_data_free_func free_func);
+
+/**
+ * Expire the conversations that haven't been used since before a frame,
+ * and then, if there are too many, the least recently used ones.  This
+ * does nothing unless expiry was turned on with conversation_set_expiry(),
+ * and mustn't be called in the middle of dissecting a packet.
+ *
+ * @param oldest_frame The number of the oldest frame whose conversations
+ * are to be kept, or 0 to expire only the conversations beyond the limit.
+ * @return The number of conversations expired.
+ */
+WS_DLL_PUBLIC guint conversation_expire(const guint32 oldest_frame);
+
+/**
+ * Get how many conversations have been expired, and for how many of them the
+ * protocols' data was freed, so far.
+ */
+WS_DLL_PUBLIC void conversation_get_expiry_stats(guint64 *expired_conversations, guint64 *freed_proto_data);
+
 /* Temporary function to handle port_type to conversation_type conversion
    For now it's a 1-1 mapping, but the intention is to remove
    many of the port_type instances in favor of conversation_type
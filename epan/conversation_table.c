@@ -11,6 +11,7 @@
 
 #include "config.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "proto.h"
@@ -264,6 +265,115 @@ conversation_equal(gconstpointer key1, gconstpointer key2)
     return FALSE;
 }
 
+/*
+ * Tables with a max_items limit are kept within it by dropping the less
+ * busy half of their entries whenever they outgrow it, which leaves room
+ * for new ones.  An entry that's dropped and seen again starts over, so
+ * the busiest entries are kept with their counts intact, while the
+ * counts of entries that only just made it may be low.
+ */
+typedef struct {
+    guint   idx;
+    guint64 bytes;
+} prune_item_t;
+
+static int
+prune_item_cmp(const void *a, const void *b)
+{
+    guint64 bytes_a = ((const prune_item_t *)a)->bytes;
+    guint64 bytes_b = ((const prune_item_t *)b)->bytes;
+
+    /* Busiest first */
+    return (bytes_a < bytes_b) ? 1 : (bytes_a > bytes_b) ? -1 : 0;
+}
+
+static void
+prune_conversation_table_data(conv_hash_t *ch)
+{
+    guint n_items = ch->conv_array->len;
+    guint n_keep = MAX(ch->max_items / 2, 1);
+    prune_item_t *items = g_new(prune_item_t, n_items);
+    GArray *kept;
+    guint i;
+
+    for (i = 0; i < n_items; i++) {
+        conv_item_t *conv = &g_array_index(ch->conv_array, conv_item_t, i);
+
+        items[i].idx = i;
+        items[i].bytes = conv->tx_bytes_total + conv->rx_bytes_total;
+    }
+    qsort(items, n_items, sizeof(prune_item_t), prune_item_cmp);
+
+    kept = g_array_sized_new(FALSE, FALSE, sizeof(conv_item_t), ch->max_items + 1);
+    g_hash_table_remove_all(ch->hashtable);
+    for (i = 0; i < n_items; i++) {
+        conv_item_t *conv = &g_array_index(ch->conv_array, conv_item_t, items[i].idx);
+        conv_key_t *new_key;
+
+        if (i >= n_keep) {
+            free_address(&conv->src_address);
+            free_address(&conv->dst_address);
+            continue;
+        }
+        g_array_append_val(kept, *conv);
+
+        /* The addresses' data stays where it was, so the keys can refer to it */
+        new_key = g_new(conv_key_t, 1);
+        set_address(&new_key->addr1, conv->src_address.type, conv->src_address.len, conv->src_address.data);
+        set_address(&new_key->addr2, conv->dst_address.type, conv->dst_address.len, conv->dst_address.data);
+        new_key->port1 = conv->src_port;
+        new_key->port2 = conv->dst_port;
+        new_key->conv_id = conv->conv_id;
+        g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(kept->len - 1));
+    }
+    ch->pruned_items += n_items - n_keep;
+
+    g_array_free(ch->conv_array, TRUE);
+    ch->conv_array = kept;
+    g_free(items);
+}
+
+static void
+prune_endpoint_table_data(conv_hash_t *ch)
+{
+    guint n_items = ch->conv_array->len;
+    guint n_keep = MAX(ch->max_items / 2, 1);
+    prune_item_t *items = g_new(prune_item_t, n_items);
+    GArray *kept;
+    guint i;
+
+    for (i = 0; i < n_items; i++) {
+        endpoint_item_t *endpoint = &g_array_index(ch->conv_array, endpoint_item_t, i);
+
+        items[i].idx = i;
+        items[i].bytes = endpoint->tx_bytes_total + endpoint->rx_bytes_total;
+    }
+    qsort(items, n_items, sizeof(prune_item_t), prune_item_cmp);
+
+    kept = g_array_sized_new(FALSE, FALSE, sizeof(endpoint_item_t), ch->max_items + 1);
+    g_hash_table_remove_all(ch->hashtable);
+    for (i = 0; i < n_items; i++) {
+        endpoint_item_t *endpoint = &g_array_index(ch->conv_array, endpoint_item_t, items[i].idx);
+        endpoint_key_t *new_key;
+
+        if (i >= n_keep) {
+            free_address(&endpoint->myaddress);
+            continue;
+        }
+        g_array_append_val(kept, *endpoint);
+
+        new_key = g_new(endpoint_key_t, 1);
+        set_address(&new_key->myaddress, endpoint->myaddress.type, endpoint->myaddress.len, endpoint->myaddress.data);
+        new_key->port = endpoint->port;
+        g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(kept->len - 1));
+    }
+    ch->pruned_items += n_items - n_keep;
+
+    g_array_free(ch->conv_array, TRUE);
+    ch->conv_array = kept;
+    g_free(items);
+}
+
 void
 reset_conversation_table_data(conv_hash_t *ch)
 {
@@ -288,6 +398,7 @@ reset_conversation_table_data(conv_hash_t *ch)
 
     ch->conv_array=NULL;
     ch->hashtable=NULL;
+    ch->pruned_items=0;
 }
 
 void reset_endpoint_table_data(conv_hash_t *ch)
@@ -312,6 +423,7 @@ void reset_endpoint_table_data(conv_hash_t *ch)
 
     ch->conv_array=NULL;
     ch->hashtable=NULL;
+    ch->pruned_items=0;
 }
 
 /* For backwards source and binary compatibility */
@@ -770,6 +882,10 @@ add_conversation_table_data_with_conv_id(
             memcpy(&conv_item->start_abs_time, abs_ts, sizeof(conv_item->start_abs_time));
         }
     }
+
+    if (ch->max_items != 0 && ch->conv_array->len > ch->max_items) {
+        prune_conversation_table_data(ch);
+    }
 }
 
 /*
@@ -890,6 +1006,10 @@ add_endpoint_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboo
         endpoint_item->rx_frames_total+=num_frames;
         endpoint_item->rx_bytes_total+=num_bytes;
     }
+
+    if (ch->max_items != 0 && ch->conv_array->len > ch->max_items) {
+        prune_endpoint_table_data(ch);
+    }
 }
 
 /* For backwards source and binary compatibility */
@@ -55,6 +55,8 @@ typedef struct _conversation_hash_t {
     GArray      *conv_array;      /**< array of conversation values */
     void        *user_data;       /**< "GUI" specifics (if necessary) */
     guint       flags;            /**< flags given to the tap packet */
+    guint       max_items;        /**< if nonzero, the most entries to keep; the less busy ones are forgotten */
+    guint64     pruned_items;     /**< entries forgotten to stay within max_items */
 } conv_hash_t;
 
 /** Key for hash lookups */
@@ -0,0 +1,221 @@
+/* conversation_test.c
+ * Tests for expiring conversations.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/address.h>
+#include <epan/conversation.h>
+#include <epan/prefs.h>
+#include <epan/proto.h>
+#include <epan/wmem_scopes.h>
+#include <wiretap/wtap.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/wslog.h>
+
+#define TEST_CONVERSATIONS  6
+
+static guint32 addr_a = 0x0100a8c0;    /* 192.168.0.1 */
+static guint32 addr_b = 0x0a00000a;    /* 10.0.0.10 */
+
+static int test_proto;
+static guint data_freed;
+
+static const nstime_t *
+test_get_frame_ts(struct packet_provider_data *prov _U_, guint32 frame_num _U_)
+{
+    static nstime_t empty;
+
+    return &empty;
+}
+
+static const struct packet_provider_funcs test_funcs = {
+    test_get_frame_ts,
+    NULL,
+    NULL,
+    NULL
+};
+
+static void
+test_free_proto_data(conversation_t *conv _U_, void *proto_data)
+{
+    wmem_free(wmem_file_scope(), proto_data);
+    data_freed++;
+}
+
+/* Conversation k is from port 1000 + k. */
+static conversation_t *
+new_test_conversation(guint32 frame_num, guint k)
+{
+    address src, dst;
+    conversation_t *conv;
+
+    set_address(&src, AT_IPv4, 4, &addr_a);
+    set_address(&dst, AT_IPv4, 4, &addr_b);
+    conv = conversation_new(frame_num, &src, &dst, CONVERSATION_TCP,
+        1000 + k, 80, 0);
+    conversation_add_proto_data(conv, test_proto, wmem_new0(wmem_file_scope(), int));
+    return conv;
+}
+
+static conversation_t *
+find_test_conversation(guint32 frame_num, guint k)
+{
+    address src, dst;
+
+    set_address(&src, AT_IPv4, 4, &addr_a);
+    set_address(&dst, AT_IPv4, 4, &addr_b);
+    return find_conversation(frame_num, &src, &dst, CONVERSATION_TCP,
+        1000 + k, 80, 0);
+}
+
+static void
+test_expire_by_age(void)
+{
+    epan_t *session;
+    conversation_t *convs[TEST_CONVERSATIONS];
+    guint64 expired_before, freed_before, expired, freed;
+    guint k;
+
+    conversation_set_expiry(TRUE, 0);
+    session = epan_new(NULL, &test_funcs);
+    conversation_get_expiry_stats(&expired_before, &freed_before);
+    data_freed = 0;
+
+    /* Conversation k is set up in frame k + 1. */
+    for (k = 0; k < TEST_CONVERSATIONS; k++)
+        convs[k] = new_test_conversation(k + 1, k);
+
+    /* Using conversation 0 again keeps it. */
+    g_assert_true(find_test_conversation(TEST_CONVERSATIONS + 1, 0) == convs[0]);
+
+    /* Expire those not used since before frame 4: conversations 1 and 2. */
+    g_assert_cmpuint(conversation_expire(4), ==, 2);
+    g_assert_null(find_test_conversation(TEST_CONVERSATIONS + 2, 1));
+    g_assert_null(find_test_conversation(TEST_CONVERSATIONS + 2, 2));
+    for (k = 3; k < TEST_CONVERSATIONS; k++)
+        g_assert_true(find_test_conversation(TEST_CONVERSATIONS + 2, k) == convs[k]);
+    g_assert_true(find_test_conversation(TEST_CONVERSATIONS + 2, 0) == convs[0]);
+
+    /* Their data was freed, and taken off them. */
+    g_assert_cmpuint(data_freed, ==, 2);
+    g_assert_null(conversation_get_proto_data(convs[1], test_proto));
+    g_assert_nonnull(conversation_get_proto_data(convs[0], test_proto));
+
+    conversation_get_expiry_stats(&expired, &freed);
+    g_assert_cmpuint(expired - expired_before, ==, 2);
+    g_assert_cmpuint(freed - freed_before, ==, 2);
+
+    /* Nothing else is that old. */
+    g_assert_cmpuint(conversation_expire(4), ==, 0);
+
+    epan_free(session);
+    conversation_set_expiry(FALSE, 0);
+}
+
+static void
+test_expire_by_count(void)
+{
+    epan_t *session;
+    conversation_t *convs[TEST_CONVERSATIONS];
+    guint64 expired_before, freed_before, expired, freed;
+    guint k;
+
+    conversation_set_expiry(TRUE, 3);
+    session = epan_new(NULL, &test_funcs);
+    conversation_get_expiry_stats(&expired_before, &freed_before);
+    data_freed = 0;
+
+    for (k = 0; k < TEST_CONVERSATIONS; k++)
+        convs[k] = new_test_conversation(k + 1, k);
+    /* Conversation 1 is now the most recently used. */
+    g_assert_true(find_test_conversation(TEST_CONVERSATIONS + 1, 1) == convs[1]);
+
+    /*
+     * Keep the 3 most recently used, 1, 5 and 4; a cutoff of frame 0
+     * expires by count alone.
+     */
+    g_assert_cmpuint(conversation_expire(0), ==, 3);
+    g_assert_null(find_test_conversation(TEST_CONVERSATIONS + 2, 0));
+    g_assert_null(find_test_conversation(TEST_CONVERSATIONS + 2, 2));
+    g_assert_null(find_test_conversation(TEST_CONVERSATIONS + 2, 3));
+    g_assert_true(find_test_conversation(TEST_CONVERSATIONS + 2, 1) == convs[1]);
+    g_assert_true(find_test_conversation(TEST_CONVERSATIONS + 2, 4) == convs[4]);
+    g_assert_true(find_test_conversation(TEST_CONVERSATIONS + 2, 5) == convs[5]);
+    g_assert_cmpuint(data_freed, ==, 3);
+
+    conversation_get_expiry_stats(&expired, &freed);
+    g_assert_cmpuint(expired - expired_before, ==, 3);
+    g_assert_cmpuint(freed - freed_before, ==, 3);
+
+    /* An expired conversation's packets get a new one. */
+    g_assert_nonnull(new_test_conversation(TEST_CONVERSATIONS + 3, 0));
+    g_assert_true(find_test_conversation(TEST_CONVERSATIONS + 3, 0) != convs[0]);
+
+    /* That made 4; the least recently used, 1, goes. */
+    g_assert_cmpuint(conversation_expire(0), ==, 1);
+    g_assert_null(find_test_conversation(TEST_CONVERSATIONS + 4, 1));
+
+    epan_free(session);
+    conversation_set_expiry(FALSE, 0);
+}
+
+int
+main(int argc, char **argv)
+{
+    char *configuration_init_error;
+    int ret;
+
+    ws_log_init("conversation_test", NULL);
+
+    g_test_init(&argc, &argv, NULL);
+
+    configuration_init_error = configuration_init(argv[0], NULL);
+    if (configuration_init_error != NULL) {
+        g_printerr("conversation_test: Can't get pathname of directory containing the program: %s.\n",
+            configuration_init_error);
+        g_free(configuration_init_error);
+    }
+
+    wtap_init(FALSE);
+    if (!epan_init(NULL, NULL, FALSE))
+        return 2;
+    epan_load_settings();
+    prefs_apply_all();
+
+    /* A protocol that registers nothing else, to hang test data on. */
+    test_proto = proto_get_id_by_filter_name("frame");
+    conversation_register_proto_data_free(test_proto, test_free_proto_data);
+
+    g_test_add_func("/conversation/expire_by_age", test_expire_by_age);
+    g_test_add_func("/conversation/expire_by_count", test_expire_by_count);
+
+    ret = g_test_run();
+
+    epan_cleanup();
+    wtap_cleanup();
+
+    return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -113,24 +113,14 @@ extern "C" {
 #endif
 
 /**
- * It is a step of the PBKDF2 (specifically the PKCS #5 v2.0) defined in
- * the RFC 2898 to derive a key (used as PMK in WPA)
- * @param ppbytes [IN] pointer to a password (sequence of between 8 and
- * 63 ASCII encoded characters)
- * @param ssid [IN] pointer to the SSID string encoded in max 32 ASCII
- * encoded characters
- * @param iterations [IN] times to hash the password (4096 for WPA)
- * @param count [IN] ???
- * @param output [OUT] pointer to a preallocated buffer of
- * SHA1_DIGEST_LEN characters that will contain a part of the key
+ * Like Dot11DecryptRsnaPwd2Psk(), but looks the PSK up in the context's
+ * cache of earlier derivations first, and adds it there otherwise.
  */
-static INT Dot11DecryptRsnaPwd2PskStep(
-    const guint8 *ppbytes,
-    const guint passLength,
+static void Dot11DecryptRsnaPwd2PskCached(
+    PDOT11DECRYPT_CONTEXT ctx,
+    const CHAR *passphrase,
     const CHAR *ssid,
     const size_t ssidLength,
-    const INT iterations,
-    const INT count,
     UCHAR *output)
     ;
 
@@ -959,6 +949,7 @@ Dot11DecryptUsingUserTk(
             }
         }
     }
+    dot11decrypt_cipher_close(&sa->cipher);
     g_free(sa);
     return ret;
 }
@@ -1080,7 +1071,7 @@ INT Dot11DecryptSetKeys(
     for (i=0, success=0; i<(INT)keys_nr; i++) {
         if (Dot11DecryptValidateKey(keys+i)==TRUE) {
             if (keys[i].KeyType==DOT11DECRYPT_KEY_TYPE_WPA_PWD) {
-                Dot11DecryptRsnaPwd2Psk(keys[i].UserPwd.Passphrase, keys[i].UserPwd.Ssid, keys[i].UserPwd.SsidLen, keys[i].KeyData.Wpa.Psk);
+                Dot11DecryptRsnaPwd2PskCached(ctx, keys[i].UserPwd.Passphrase, keys[i].UserPwd.Ssid, keys[i].UserPwd.SsidLen, keys[i].KeyData.Wpa.Psk);
                 keys[i].KeyData.Wpa.PskLen = DOT11DECRYPT_WPA_PWD_PSK_LEN;
             }
             memcpy(&ctx->keys[success], &keys[i], sizeof(keys[i]));
@@ -1114,6 +1105,7 @@ Dot11DecryptRecurseCleanSA(
     DOT11DECRYPT_SEC_ASSOCIATION *sa = (DOT11DECRYPT_SEC_ASSOCIATION *)first_sa;
     if (sa != NULL) {
         Dot11DecryptRecurseCleanSA((gpointer)sa->next);
+        dot11decrypt_cipher_close(&sa->cipher);
         g_free(sa);
     }
 }
@@ -1181,6 +1173,13 @@ INT Dot11DecryptInitContext(
         return DOT11DECRYPT_RET_UNSUCCESS;
     }
 
+    /* Derived PSKs depend only on passphrase and SSID, so they are kept
+     * when the keys are set again, e.g. for the next capture file. */
+    if (ctx->psk_cache == NULL) {
+        ctx->psk_cache = g_hash_table_new_full(g_bytes_hash, g_bytes_equal,
+                                               (GDestroyNotify)g_bytes_unref, g_free);
+    }
+
     ws_debug("Context initialized!");
     return DOT11DECRYPT_RET_SUCCESS;
 }
@@ -1196,6 +1195,11 @@ INT Dot11DecryptDestroyContext(
     Dot11DecryptCleanKeys(ctx);
     Dot11DecryptCleanSecAssoc(ctx);
 
+    if (ctx->psk_cache != NULL) {
+        g_hash_table_destroy(ctx->psk_cache);
+        ctx->psk_cache = NULL;
+    }
+
     ws_debug("Context destroyed!");
     return DOT11DECRYPT_RET_SUCCESS;
 }
@@ -1284,7 +1288,8 @@ Dot11DecryptRsnaMng(
            }
            ret = Dot11DecryptGcmpDecrypt(try_data, mac_header_len, (INT)*decrypt_len,
                                          DOT11DECRYPT_GET_TK(sa->wpa.ptk, sa->wpa.akm),
-                                         Dot11DecryptGetTkLen(sa->wpa.cipher) / 8);
+                                         Dot11DecryptGetTkLen(sa->wpa.cipher) / 8,
+                                         &sa->cipher);
            if (ret) {
               continue;
            }
@@ -1306,7 +1311,7 @@ Dot11DecryptRsnaMng(
            ret = Dot11DecryptCcmpDecrypt(try_data, mac_header_len, (INT)*decrypt_len,
                                          DOT11DECRYPT_GET_TK(sa->wpa.ptk, sa->wpa.akm),
                                          Dot11DecryptGetTkLen(sa->wpa.cipher) / 8,
-                                         trailer);
+                                         trailer, &sa->cipher);
            if (ret) {
               continue;
            }
@@ -1617,12 +1622,17 @@ Dot11DecryptRsna4WHandshake(
         sa = Dot11DecryptGetSa(ctx, id);
         if (sa == NULL || sa->handshake >= 2) {
             /* Either no SA exists or one exists but we're reauthenticating */
+            DOT11DECRYPT_KEY_ITEM *prev_key = sa ? sa->key : NULL;
+
             sa = Dot11DecryptNewSa(id);
             if (sa == NULL) {
                 ws_warning("Failed to alloc broadcast sa");
                 return DOT11DECRYPT_RET_NO_VALID_HANDSHAKE;
             }
             sa = Dot11DecryptAddSa(ctx, id, sa);
+            /* Try the key that worked last time first, rather than
+             * deriving a PTK from each configured key in turn */
+            sa->key = prev_key;
         }
         memcpy(sa->wpa.nonce, eapol_parsed->nonce, 32);
 
@@ -1686,7 +1696,7 @@ Dot11DecryptRsna4WHandshake(
                 memcpy(&pkt_key, tmp_key, sizeof(pkt_key));
                 memcpy(&pkt_key.UserPwd.Ssid, ctx->pkt_ssid, ctx->pkt_ssid_len);
                 pkt_key.UserPwd.SsidLen = ctx->pkt_ssid_len;
-                Dot11DecryptRsnaPwd2Psk(pkt_key.UserPwd.Passphrase, pkt_key.UserPwd.Ssid,
+                Dot11DecryptRsnaPwd2PskCached(ctx, pkt_key.UserPwd.Passphrase, pkt_key.UserPwd.Ssid,
                     pkt_key.UserPwd.SsidLen, pkt_key.KeyData.Wpa.Psk);
                 tmp_pkt_key = &pkt_key;
             } else {
@@ -1896,7 +1906,7 @@ Dot11DecryptScanFtAssocForKeys(
             memcpy(&pkt_key, tmp_key, sizeof(pkt_key));
             memcpy(&pkt_key.UserPwd.Ssid, ctx->pkt_ssid, ctx->pkt_ssid_len);
             pkt_key.UserPwd.SsidLen = ctx->pkt_ssid_len;
-            Dot11DecryptRsnaPwd2Psk(pkt_key.UserPwd.Passphrase, pkt_key.UserPwd.Ssid,
+            Dot11DecryptRsnaPwd2PskCached(ctx, pkt_key.UserPwd.Passphrase, pkt_key.UserPwd.Ssid,
                 pkt_key.UserPwd.SsidLen, pkt_key.KeyData.Wpa.Psk);
             tmp_pkt_key = &pkt_key;
         } else {
@@ -2650,72 +2660,70 @@ Dot11DecryptFtDerivePtk(
 #define MAX_SSID_LENGTH 32 /* maximum SSID length */
 
 static INT
-Dot11DecryptRsnaPwd2PskStep(
-    const guint8 *ppBytes,
-    const guint ppLength,
+Dot11DecryptRsnaPwd2Psk(
+    const CHAR *passphrase,
     const CHAR *ssid,
     const size_t ssidLength,
-    const INT iterations,
-    const INT count,
     UCHAR *output)
 {
-    UCHAR digest[MAX_SSID_LENGTH+4] = { 0 };  /* SSID plus 4 bytes of count */
-    INT i, j;
+    GByteArray *pp_ba;
 
     if (ssidLength > MAX_SSID_LENGTH) {
         /* This "should not happen" */
         return DOT11DECRYPT_RET_UNSUCCESS;
     }
 
-    /* U1 = PRF(P, S || INT(i)) */
-    memcpy(digest, ssid, ssidLength);
-    digest[ssidLength] = (UCHAR)((count>>24) & 0xff);
-    digest[ssidLength+1] = (UCHAR)((count>>16) & 0xff);
-    digest[ssidLength+2] = (UCHAR)((count>>8) & 0xff);
-    digest[ssidLength+3] = (UCHAR)(count & 0xff);
-    if (ws_hmac_buffer(GCRY_MD_SHA1, digest, digest, (guint32) ssidLength + 4, ppBytes, ppLength)) {
-      return DOT11DECRYPT_RET_UNSUCCESS;
+    pp_ba = g_byte_array_new();
+    if (!uri_str_to_bytes(passphrase, pp_ba)) {
+        g_byte_array_free(pp_ba, TRUE);
+        return DOT11DECRYPT_RET_UNSUCCESS;
     }
 
-    /* output = U1 */
-    memcpy(output, digest, 20);
-    for (i = 1; i < iterations; i++) {
-        /* Un = PRF(P, Un-1) */
-        if (ws_hmac_buffer(GCRY_MD_SHA1, digest, digest, HASH_SHA1_LENGTH, ppBytes, ppLength)) {
-          return DOT11DECRYPT_RET_UNSUCCESS;
-        }
-
-        /* output = output xor Un */
-        for (j = 0; j < 20; j++) {
-            output[j] ^= digest[j];
-        }
+    /* PSK = PBKDF2(HMAC-SHA1, passphrase, SSID, 4096, 256) */
+    if (gcry_kdf_derive(pp_ba->data, pp_ba->len, GCRY_KDF_PBKDF2, GCRY_MD_SHA1,
+                        ssid, ssidLength, 4096,
+                        DOT11DECRYPT_WPA_PWD_PSK_LEN, output)) {
+        g_byte_array_free(pp_ba, TRUE);
+        return DOT11DECRYPT_RET_UNSUCCESS;
     }
+    g_byte_array_free(pp_ba, TRUE);
 
     return DOT11DECRYPT_RET_SUCCESS;
 }
 
-static INT
-Dot11DecryptRsnaPwd2Psk(
+static void
+Dot11DecryptRsnaPwd2PskCached(
+    PDOT11DECRYPT_CONTEXT ctx,
     const CHAR *passphrase,
     const CHAR *ssid,
     const size_t ssidLength,
     UCHAR *output)
 {
-    UCHAR m_output[40] = { 0 };
-    GByteArray *pp_ba = g_byte_array_new();
-
-    if (!uri_str_to_bytes(passphrase, pp_ba)) {
-        g_byte_array_free(pp_ba, TRUE);
-        return 0;
+    GByteArray *cache_key;
+    GBytes *lookup_key;
+    const UCHAR *psk;
+
+    /* The SSID may hold any bytes, so the key is the NUL-terminated
+     * passphrase followed by the SSID. */
+    cache_key = g_byte_array_new();
+    g_byte_array_append(cache_key, (const guint8 *)passphrase, (guint)strlen(passphrase) + 1);
+    g_byte_array_append(cache_key, (const guint8 *)ssid, (guint)ssidLength);
+    lookup_key = g_byte_array_free_to_bytes(cache_key);
+
+    psk = (const UCHAR *)g_hash_table_lookup(ctx->psk_cache, lookup_key);
+    if (psk != NULL) {
+        memcpy(output, psk, DOT11DECRYPT_WPA_PWD_PSK_LEN);
+        g_bytes_unref(lookup_key);
+        return;
     }
 
-    Dot11DecryptRsnaPwd2PskStep(pp_ba->data, pp_ba->len, ssid, ssidLength, 4096, 1, m_output);
-    Dot11DecryptRsnaPwd2PskStep(pp_ba->data, pp_ba->len, ssid, ssidLength, 4096, 2, &m_output[20]);
-
-    memcpy(output, m_output, DOT11DECRYPT_WPA_PWD_PSK_LEN);
-    g_byte_array_free(pp_ba, TRUE);
-
-    return 0;
+    ws_debug("Deriving PSK from passphrase");
+    if (Dot11DecryptRsnaPwd2Psk(passphrase, ssid, ssidLength, output) != DOT11DECRYPT_RET_SUCCESS) {
+        g_bytes_unref(lookup_key);
+        return;
+    }
+    g_hash_table_insert(ctx->psk_cache, lookup_key,
+                        g_memdup2(output, DOT11DECRYPT_WPA_PWD_PSK_LEN));
 }
 
 /*
@@ -78,7 +78,8 @@ int Dot11DecryptCcmpDecrypt(
 	int len,
 	guint8 *TK1,
 	int tk_len,
-	int mic_len)
+	int mic_len,
+	PDOT11DECRYPT_CIPHER cipher)
 {
 	PDOT11DECRYPT_MAC_FRAME wh;
 	guint8 aad[30]; /* Max aad_len. See Table 12-1 IEEE 802.11 2016 */
@@ -102,14 +103,12 @@ int Dot11DecryptCcmpDecrypt(
 	ccmp_construct_nonce(wh, pn, nonce);
 	dot11decrypt_construct_aad(wh, aad, &aad_len);
 
-	if (gcry_cipher_open(&handle, GCRY_CIPHER_AES, GCRY_CIPHER_MODE_CCM, 0)) {
+	handle = dot11decrypt_cipher_get(cipher, GCRY_CIPHER_MODE_CCM, TK1, tk_len);
+	if (!handle) {
 		return 1;
 	}
-	if (gcry_cipher_setkey(handle, TK1, tk_len)) {
-		goto err_out;
-	}
 	if (gcry_cipher_setiv(handle, nonce, sizeof(nonce))) {
-		goto err_out;
+		return 1;
 	}
 
 	guint64 ccm_lengths[3];
@@ -117,24 +116,20 @@ int Dot11DecryptCcmpDecrypt(
 	ccm_lengths[1] = aad_len;
 	ccm_lengths[2] = mic_len;
 	if (gcry_cipher_ctl(handle, GCRYCTL_SET_CCM_LENGTHS, ccm_lengths, sizeof(ccm_lengths))) {
-		goto err_out;
+		return 1;
 	}
 	if (gcry_cipher_authenticate(handle, aad, aad_len)) {
-		goto err_out;
+		return 1;
 	}
 	if (gcry_cipher_decrypt(handle, m + z + DOT11DECRYPT_CCMP_HEADER, data_len, NULL, 0)) {
-		goto err_out;
+		return 1;
 	}
 	if (gcry_cipher_checktag(handle, mic, mic_len)) {
-		goto err_out;
+		return 1;
 	}
 
 	/* TODO replay check	(IEEE 802.11i-2004, pg. 62)			*/
 	/* TODO PN must be incremental (IEEE 802.11i-2004, pg. 62)		*/
 
-	gcry_cipher_close(handle);
 	return 0;
-err_out:
-	gcry_cipher_close(handle);
-	return 1;
 }
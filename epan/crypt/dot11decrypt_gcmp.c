@@ -57,7 +57,8 @@ int Dot11DecryptGcmpDecrypt(
 	int mac_header_len,
 	int len,
 	guint8 *TK1,
-	int tk_len)
+	int tk_len,
+	PDOT11DECRYPT_CIPHER cipher)
 {
 	PDOT11DECRYPT_MAC_FRAME wh;
 	guint8 aad[30];
@@ -81,31 +82,25 @@ int Dot11DecryptGcmpDecrypt(
 	gcmp_construct_nonce(wh, pn, nonce);
 	dot11decrypt_construct_aad(wh, aad, &aad_len);
 
-	if (gcry_cipher_open(&handle, GCRY_CIPHER_AES, GCRY_CIPHER_MODE_GCM, 0)) {
+	handle = dot11decrypt_cipher_get(cipher, GCRY_CIPHER_MODE_GCM, TK1, tk_len);
+	if (!handle) {
 		return 1;
 	}
-	if (gcry_cipher_setkey(handle, TK1, tk_len)) {
-		goto err_out;
-	}
 	if (gcry_cipher_setiv(handle, nonce, sizeof(nonce))) {
-		goto err_out;
+		return 1;
 	}
 	if (gcry_cipher_authenticate(handle, aad, aad_len)) {
-		goto err_out;
+		return 1;
 	}
 	if (gcry_cipher_decrypt(handle, m + z + DOT11DECRYPT_GCMP_HEADER, data_len, NULL, 0)) {
-		goto err_out;
+		return 1;
 	}
 	if (gcry_cipher_checktag(handle, mic, sizeof(mic))) {
-		goto err_out;
+		return 1;
 	}
 
 	/* TODO replay check	(IEEE 802.11i-2004, pg. 62)			*/
 	/* TODO PN must be incremental (IEEE 802.11i-2004, pg. 62)		*/
 
-	gcry_cipher_close(handle);
 	return 0;
-err_out:
-	gcry_cipher_close(handle);
-	return 1;
 }
@@ -175,14 +175,16 @@ int Dot11DecryptCcmpDecrypt(
 	int len,
 	guint8 *TK1,
 	int tk_len,
-	int mic_len);
+	int mic_len,
+	PDOT11DECRYPT_CIPHER cipher);
 
 int Dot11DecryptGcmpDecrypt(
 	guint8 *m,
 	int mac_header_len,
 	int len,
 	guint8 *TK1,
-	int tk_len);
+	int tk_len,
+	PDOT11DECRYPT_CIPHER cipher);
 
 INT Dot11DecryptTkipDecrypt(
 	UCHAR *tkip_mpdu,
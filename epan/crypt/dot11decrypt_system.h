@@ -100,6 +100,15 @@ typedef struct _DOT11DECRYPT_SEC_ASSOCIATION_ID {
 	UCHAR sta[DOT11DECRYPT_MAC_LEN];
 } DOT11DECRYPT_SEC_ASSOCIATION_ID, *PDOT11DECRYPT_SEC_ASSOCIATION_ID;
 
+/* An AES handle for CCMP or GCMP, opened and keyed on the first frame */
+/* and kept for the following ones as long as the key stays the same.  */
+typedef struct _DOT11DECRYPT_CIPHER {
+	struct gcry_cipher_handle *hd;
+	INT mode;
+	UCHAR key[DOT11DECRYPT_TK_MAX_LEN];
+	size_t key_len;
+} DOT11DECRYPT_CIPHER, *PDOT11DECRYPT_CIPHER;
+
 typedef struct _DOT11DECRYPT_SEC_ASSOCIATION {
     /* This is for reassociations. A linked list of old security
      * associations is kept.  GCS
@@ -123,6 +132,7 @@ typedef struct _DOT11DECRYPT_SEC_ASSOCIATION {
 	    INT ptk_len;
 	} wpa;
 
+	DOT11DECRYPT_CIPHER cipher;	/* CCMP/GCMP handle keyed with the TK */
 
 } DOT11DECRYPT_SEC_ASSOCIATION, *PDOT11DECRYPT_SEC_ASSOCIATION;
 
@@ -132,6 +142,7 @@ typedef struct _DOT11DECRYPT_CONTEXT {
 	size_t keys_nr;
 	CHAR pkt_ssid[DOT11DECRYPT_WPA_SSID_MAX_LEN];
 	size_t pkt_ssid_len;
+	GHashTable *psk_cache;	/* PSKs derived from passphrases, by passphrase and SSID */
 } DOT11DECRYPT_CONTEXT, *PDOT11DECRYPT_CONTEXT;
 
 typedef enum _DOT11DECRYPT_HS_MSG_TYPE {
@@ -399,6 +399,49 @@ dot11decrypt_derive_ft_ptk(const guint8 *pmk_r1, size_t pmk_r1_len,
     return TRUE;
 }
 
+/*
+ * Returns an AES handle for the given mode keyed with the key, reusing the
+ * one from the previous call if mode and key are unchanged. Setting the
+ * nonce resets the CCM and GCM state, so the handle can be used as is.
+ */
+gcry_cipher_hd_t
+dot11decrypt_cipher_get(PDOT11DECRYPT_CIPHER cipher, int mode,
+                        const guint8 *key, size_t key_len)
+{
+    gcry_cipher_hd_t handle;
+
+    if (cipher->hd && cipher->mode == mode && cipher->key_len == key_len &&
+        memcmp(cipher->key, key, key_len) == 0) {
+        return cipher->hd;
+    }
+    dot11decrypt_cipher_close(cipher);
+
+    if (key_len > sizeof(cipher->key)) {
+        return NULL;
+    }
+    if (gcry_cipher_open(&handle, GCRY_CIPHER_AES, mode, 0)) {
+        return NULL;
+    }
+    if (gcry_cipher_setkey(handle, key, key_len)) {
+        gcry_cipher_close(handle);
+        return NULL;
+    }
+    cipher->hd = handle;
+    cipher->mode = mode;
+    memcpy(cipher->key, key, key_len);
+    cipher->key_len = key_len;
+    return handle;
+}
+
+void
+dot11decrypt_cipher_close(PDOT11DECRYPT_CIPHER cipher)
+{
+    if (cipher->hd) {
+        gcry_cipher_close(cipher->hd);
+    }
+    memset(cipher, 0, sizeof(*cipher));
+}
+
 /*
  * Editor modelines
  *
@@ -58,6 +58,13 @@ dot11decrypt_derive_ft_ptk(const guint8 *pmk_r1, size_t pmk_r1_len,
                            const guint8 *bssid, const guint8 *sta_addr,
                            int hash_algo,
                            guint8 *ptk, const size_t ptk_len, guint8 *ptk_name);
+
+gcry_cipher_hd_t
+dot11decrypt_cipher_get(PDOT11DECRYPT_CIPHER cipher, int mode,
+                        const guint8 *key, size_t key_len);
+
+void
+dot11decrypt_cipher_close(PDOT11DECRYPT_CIPHER cipher);
 #endif /* _DOT11DECRYPT_UTIL_H */
 
 /*
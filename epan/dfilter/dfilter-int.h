@@ -29,6 +29,9 @@ struct epan_dfilter {
 	GSList		**registers;
 	gboolean	*attempted_load;
 	GDestroyNotify	*free_registers;
+	/* List nodes taken out of the registers when a run finishes, reused
+	 * by the next run so that loading a register doesn't allocate. */
+	GSList		*free_nodes;
 	int		*interesting_fields;
 	int		num_interesting_fields;
 	GPtrArray	*deprecated;
@@ -38,6 +41,9 @@ struct epan_dfilter {
 	char		*syntax_tree_str;
 	/* Used to pass arguments to functions. List of Lists (list of registers). */
 	GSList		*function_stack;
+	struct df_prefilter *prefilter;
+	/* Instruction counts and times, if dfilter_start_profile() was called. */
+	struct dfvm_profile *profile;
 };
 
 typedef struct {
@@ -16,12 +16,14 @@
 #include "syntax-tree.h"
 #include "gencode.h"
 #include "semcheck.h"
+#include "prefilter.h"
 #include "dfvm.h"
 #include <epan/epan_dissect.h>
 #include <epan/exceptions.h>
 #include "dfilter.h"
 #include "dfilter-macro.h"
 #include "scanner_lex.h"
+#include <wsutil/perf_stats.h>
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 #include "grammar.h"
@@ -215,8 +217,11 @@ dfilter_free(dfilter_t *df)
 	g_free(df->registers);
 	g_free(df->attempted_load);
 	g_free(df->free_registers);
+	g_slist_free(df->free_nodes);
 	g_free(df->expanded_text);
 	g_free(df->syntax_tree_str);
+	df_prefilter_free(df->prefilter);
+	dfvm_free_profile(df);
 	g_free(df);
 }
 
@@ -368,6 +373,7 @@ dfilter_compile_real(const gchar *text, dfilter_t **dfp,
 	gboolean failure = FALSE;
 	unsigned token_count = 0;
 	char		*tree_str;
+	df_prefilter_t	*prefilter;
 
 	ws_assert(dfp);
 	*dfp = NULL;
@@ -500,6 +506,9 @@ dfilter_compile_real(const gchar *text, dfilter_t **dfp,
 			tree_str = dump_syntax_tree_str(dfw->st_root);
 		}
 
+		/* Before code generation takes the values from the tree */
+		prefilter = dfw_prefilter(dfw);
+
 		/* Create bytecode */
 		dfw_gencode(dfw);
 
@@ -515,6 +524,7 @@ dfilter_compile_real(const gchar *text, dfilter_t **dfp,
 		dfw->references = NULL;
 		dfilter->raw_references = dfw->raw_references;
 		dfw->raw_references = NULL;
+		dfilter->prefilter = prefilter;
 
 		if (save_tree) {
 			ws_assert(tree_str);
@@ -575,13 +585,26 @@ FAILURE:
 gboolean
 dfilter_apply(dfilter_t *df, proto_tree *tree)
 {
-	return dfvm_apply(df, tree);
+	guint64 start = ws_perf_timer_start();
+	gboolean passed;
+
+	passed = dfvm_apply(df, tree);
+	ws_perf_timer_stop(WS_PERF_FILTER_TIME, start);
+	return passed;
 }
 
 gboolean
 dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt)
 {
-	return dfvm_apply(df, edt->tree);
+	return dfilter_apply(df, edt->tree);
+}
+
+gboolean
+dfilter_may_match_bytes(const dfilter_t *df, const guint8 *data, size_t len)
+{
+	if (df->prefilter == NULL)
+		return TRUE;
+	return df_prefilter_may_match(df->prefilter, data, len);
 }
 
 
@@ -627,6 +650,18 @@ dfilter_dump(dfilter_t *df)
 	}
 }
 
+void
+dfilter_start_profile(dfilter_t *df)
+{
+	dfvm_start_profile(df);
+}
+
+void
+dfilter_dump_profile(dfilter_t *df)
+{
+	dfvm_dump_profile(stdout, df);
+}
+
 const char *
 dfilter_text(dfilter_t *df)
 {
@@ -639,6 +674,134 @@ dfilter_syntax_tree(dfilter_t *df)
 	return df->syntax_tree_str;
 }
 
+enum {
+	DF_SET_NOT_RUN = 0,
+	DF_SET_MATCHED,
+	DF_SET_NOT_MATCHED
+};
+
+struct epan_dfilter_set {
+	GPtrArray	*filters;	/* dfilter_t *, in the order added */
+	GArray		*run_as;	/* guint, index of the filter with the same text that is run */
+	GByteArray	*results;	/* DF_SET_ values, by index */
+	GArray		*bitmap;	/* guint32 */
+	GHashTable	*by_text;	/* expanded text -> index + 1 of the first filter with it */
+	GHashTable	*fields;	/* interesting fields of all of the filters */
+};
+
+dfilter_set_t *
+dfilter_set_new(void)
+{
+	dfilter_set_t *set = g_new(dfilter_set_t, 1);
+
+	set->filters = g_ptr_array_new();
+	set->run_as = g_array_new(FALSE, FALSE, sizeof(guint));
+	set->results = g_byte_array_new();
+	set->bitmap = g_array_new(FALSE, TRUE, sizeof(guint32));
+	set->by_text = g_hash_table_new(g_str_hash, g_str_equal);
+	set->fields = g_hash_table_new(g_direct_hash, g_direct_equal);
+	return set;
+}
+
+void
+dfilter_set_free(dfilter_set_t *set)
+{
+	if (set == NULL)
+		return;
+
+	g_ptr_array_free(set->filters, TRUE);
+	g_array_free(set->run_as, TRUE);
+	g_byte_array_free(set->results, TRUE);
+	g_array_free(set->bitmap, TRUE);
+	g_hash_table_destroy(set->by_text);
+	g_hash_table_destroy(set->fields);
+	g_free(set);
+}
+
+guint
+dfilter_set_add(dfilter_set_t *set, dfilter_t *df)
+{
+	guint index = set->filters->len;
+	guint run_as = index;
+	guint8 result = DF_SET_NOT_RUN;
+	guint first;
+	int i;
+
+	g_ptr_array_add(set->filters, df);
+
+	/* A filter with field references gives a result that depends on
+	 * the references loaded into it, so it's only run for itself. */
+	if (g_hash_table_size(df->references) == 0 &&
+			g_hash_table_size(df->raw_references) == 0) {
+		first = GPOINTER_TO_UINT(g_hash_table_lookup(set->by_text, df->expanded_text));
+		if (first != 0)
+			run_as = first - 1;
+		else
+			g_hash_table_insert(set->by_text, df->expanded_text, GUINT_TO_POINTER(index + 1));
+	}
+	g_array_append_val(set->run_as, run_as);
+	g_byte_array_append(set->results, &result, 1);
+	g_array_set_size(set->bitmap, index / 32 + 1);
+
+	if (run_as == index) {
+		for (i = 0; i < df->num_interesting_fields; i++) {
+			g_hash_table_add(set->fields, GINT_TO_POINTER(df->interesting_fields[i]));
+		}
+	}
+	return index;
+}
+
+void
+dfilter_set_prime_proto_tree(const dfilter_set_t *set, proto_tree *tree)
+{
+	GHashTableIter iter;
+	gpointer key;
+
+	g_hash_table_iter_init(&iter, set->fields);
+	while (g_hash_table_iter_next(&iter, &key, NULL)) {
+		proto_tree_prime_with_hfid(tree, GPOINTER_TO_INT(key));
+	}
+}
+
+void
+dfilter_set_reset(dfilter_set_t *set)
+{
+	if (set->results->len != 0)
+		memset(set->results->data, DF_SET_NOT_RUN, set->results->len);
+}
+
+gboolean
+dfilter_set_apply_edt(dfilter_set_t *set, guint index, epan_dissect_t *edt)
+{
+	guint run_as;
+
+	ws_assert(index < set->filters->len);
+	run_as = g_array_index(set->run_as, guint, index);
+	if (set->results->data[run_as] == DF_SET_NOT_RUN) {
+		if (dfilter_apply_edt(g_ptr_array_index(set->filters, run_as), edt))
+			set->results->data[run_as] = DF_SET_MATCHED;
+		else
+			set->results->data[run_as] = DF_SET_NOT_MATCHED;
+	}
+	return set->results->data[run_as] == DF_SET_MATCHED;
+}
+
+const guint32 *
+dfilter_set_apply_all_edt(dfilter_set_t *set, epan_dissect_t *edt)
+{
+	guint32 *bitmap;
+	guint i;
+
+	bitmap = (guint32 *)(void *)set->bitmap->data;
+	if (set->bitmap->len != 0)
+		memset(bitmap, 0, set->bitmap->len * sizeof(guint32));
+	for (i = 0; i < set->filters->len; i++) {
+		if (dfilter_set_apply_edt(set, i, edt))
+			bitmap[i / 32] |= (guint32)1 << (i % 32);
+	}
+	return bitmap;
+}
+
 void
 dfilter_log_full(const char *domain, enum ws_log_level level,
 			const char *file, long line, const char *func,
@@ -690,7 +853,7 @@ load_references(GHashTable *table, proto_tree *tree, gboolean raw)
 		g_ptr_array_set_size(refs, 0);
 
 		while (hfinfo) {
-			finfos = proto_find_finfo(tree, hfinfo->id);
+			finfos = proto_find_finfo_indexed(tree, hfinfo->id);
 			if ((finfos == NULL) || (g_ptr_array_len(finfos) == 0)) {
 				hfinfo = hfinfo->same_name_next;
 				continue;
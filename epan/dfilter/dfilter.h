@@ -85,6 +85,15 @@ dfilter_apply_edt(dfilter_t *df, struct epan_dissect *edt);
 gboolean
 dfilter_apply(dfilter_t *df, proto_tree *tree);
 
+/* Check a packet's raw data for something the filter requires, such as
+ * the bytes in 'frame contains "..."'. Returns FALSE if the packet
+ * can't match the filter, and TRUE if it might (or if the filter has
+ * nothing that can be checked that way), so that a packet for which it
+ * returns FALSE needn't be dissected to find out that it doesn't match. */
+WS_DLL_PUBLIC
+gboolean
+dfilter_may_match_bytes(const dfilter_t *df, const guint8 *data, size_t len);
+
 /* Prime a proto_tree using the fields/protocols used in a dfilter. */
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
@@ -107,6 +116,18 @@ WS_DLL_PUBLIC
 void
 dfilter_dump(dfilter_t *df);
 
+/* Count how many times each instruction of the filter is run, how long
+ * it takes, and whether each field read finds the field, from now on.
+ * Profiling makes the filter slower, so this is for tools like dftest. */
+WS_DLL_PUBLIC
+void
+dfilter_start_profile(dfilter_t *df);
+
+/* Print what was counted since dfilter_start_profile(). */
+WS_DLL_PUBLIC
+void
+dfilter_dump_profile(dfilter_t *df);
+
 /* Text after macro expansion. */
 WS_DLL_PUBLIC
 const char *
@@ -117,6 +138,52 @@ WS_DLL_PUBLIC
 const char *
 dfilter_syntax_tree(dfilter_t *df);
 
+/* A set of filters that are all run over the same packets, such as the
+ * filters of the tap listeners or of several clients. The tree is primed
+ * once with the fields of all of them, filters with the same text are
+ * only run once per packet, and each filter is only run when its result
+ * is first asked for. The filters aren't owned by the set, and must not
+ * be freed while it's in use. */
+typedef struct epan_dfilter_set dfilter_set_t;
+
+WS_DLL_PUBLIC
+dfilter_set_t *
+dfilter_set_new(void);
+
+WS_DLL_PUBLIC
+void
+dfilter_set_free(dfilter_set_t *set);
+
+/* Adds a filter to the set, returning the index by which its result
+ * is asked for. */
+WS_DLL_PUBLIC
+guint
+dfilter_set_add(dfilter_set_t *set, dfilter_t *df);
+
+/* Prime a proto_tree using the fields/protocols used by the filters. */
+WS_DLL_PUBLIC
+void
+dfilter_set_prime_proto_tree(const dfilter_set_t *set, proto_tree *tree);
+
+/* Forget the results for the last packet; call before asking for those
+ * of a new one. */
+WS_DLL_PUBLIC
+void
+dfilter_set_reset(dfilter_set_t *set);
+
+/* Apply the filter with the given index, or return its result for this
+ * packet if it, or a filter with the same text, has already been run. */
+WS_DLL_PUBLIC
+gboolean
+dfilter_set_apply_edt(dfilter_set_t *set, guint index, struct epan_dissect *edt);
+
+/* Apply all the filters, returning a bitmap in which bit (index % 32) of
+ * element (index / 32) is set if the filter with that index matched. The
+ * bitmap belongs to the set and is overwritten by the next call. */
+WS_DLL_PUBLIC
+const guint32 *
+dfilter_set_apply_all_edt(dfilter_set_t *set, struct epan_dissect *edt);
+
 /* Print bytecode of dfilter to log */
 WS_DLL_PUBLIC
 void
@@ -11,9 +11,27 @@
 
 #include "dfvm.h"
 
+#include <stdlib.h>
+
 #include <ftypes/ftypes.h>
+#include <wsutil/time_util.h>
 #include <wsutil/ws_assert.h>
 
+/* How often, and for how long, an instruction was run while profiling. */
+typedef struct {
+	guint64		runs;
+	guint64		ns;
+	guint64		hits;		/* READ_TREE that found the field */
+	guint64		misses;		/* READ_TREE that didn't */
+} dfvm_insn_profile_t;
+
+struct dfvm_profile {
+	dfvm_insn_profile_t	*insns;
+	guint64		runs;
+	guint64		matches;
+	guint64		ns;
+};
+
 static void
 debug_register(GSList *reg, guint32 num);
 
@@ -50,6 +68,7 @@ dfvm_opcode_tostr(dfvm_opcode_t code)
 		case DFVM_ANY_MATCHES:		return "ANY_MATCHES";
 		case DFVM_ALL_IN_RANGE:		return "ALL_IN_RANGE";
 		case DFVM_ANY_IN_RANGE:		return "ANY_IN_RANGE";
+		case DFVM_ANY_IN_SET:		return "ANY_IN_SET";
 		case DFVM_SLICE:		return "SLICE";
 		case DFVM_LENGTH:		return "LENGTH";
 		case DFVM_BITWISE_AND:		return "BITWISE_AND";
@@ -93,6 +112,16 @@ dfvm_value_free(dfvm_value_t *v)
 		case PCRE:
 			ws_regex_free(v->value.pcre);
 			break;
+		case INTEGER_SET:
+			g_free(v->value.int_set->uint_keys);
+			g_free(v->value.int_set->sint_keys);
+			g_ptr_array_free(v->value.int_set->fvalues, TRUE);
+			g_free(v->value.int_set);
+			break;
+		case INTEGER_CONST:
+			fvalue_free(v->value.int_const->fvalue);
+			g_free(v->value.int_const);
+			break;
 		default:
 			/* nothing */
 			;
@@ -207,6 +236,100 @@ dfvm_value_new_guint(guint num)
 	return v;
 }
 
+static int
+compare_uint_keys(const void *a, const void *b)
+{
+	guint64 key_a = *(const guint64 *)a;
+	guint64 key_b = *(const guint64 *)b;
+
+	if (key_a == key_b)
+		return 0;
+	return key_a < key_b ? -1 : 1;
+}
+
+static int
+compare_sint_keys(const void *a, const void *b)
+{
+	gint64 key_a = *(const gint64 *)a;
+	gint64 key_b = *(const gint64 *)b;
+
+	if (key_a == key_b)
+		return 0;
+	return key_a < key_b ? -1 : 1;
+}
+
+/*
+ * Takes ownership of fvalues, which must all be of the same signed or
+ * unsigned integer type.
+ */
+dfvm_value_t*
+dfvm_value_new_int_set(GPtrArray *fvalues)
+{
+	dfvm_value_t *v = dfvm_value_new(INTEGER_SET);
+	dfvm_int_set_t *set;
+	enum ft_result res;
+	guint i, n;
+
+	ws_assert(fvalues->len > 0);
+
+	set = g_new0(dfvm_int_set_t, 1);
+	set->is_signed = IS_FT_INT(fvalue_type_ftenum(g_ptr_array_index(fvalues, 0)));
+	set->fvalues = fvalues;
+	g_ptr_array_set_free_func(fvalues, (GDestroyNotify)fvalue_free);
+
+	if (set->is_signed) {
+		set->sint_keys = g_new(gint64, fvalues->len);
+		for (i = 0; i < fvalues->len; i++) {
+			res = fvalue_to_sinteger64(g_ptr_array_index(fvalues, i), &set->sint_keys[i]);
+			ws_assert(res == FT_OK);
+		}
+		qsort(set->sint_keys, fvalues->len, sizeof(gint64), compare_sint_keys);
+		for (i = 1, n = 1; i < fvalues->len; i++) {
+			if (set->sint_keys[i] != set->sint_keys[n - 1])
+				set->sint_keys[n++] = set->sint_keys[i];
+		}
+	}
+	else {
+		set->uint_keys = g_new(guint64, fvalues->len);
+		for (i = 0; i < fvalues->len; i++) {
+			res = fvalue_to_uinteger64(g_ptr_array_index(fvalues, i), &set->uint_keys[i]);
+			ws_assert(res == FT_OK);
+		}
+		qsort(set->uint_keys, fvalues->len, sizeof(guint64), compare_uint_keys);
+		for (i = 1, n = 1; i < fvalues->len; i++) {
+			if (set->uint_keys[i] != set->uint_keys[n - 1])
+				set->uint_keys[n++] = set->uint_keys[i];
+		}
+	}
+	set->count = n;
+
+	v->value.int_set = set;
+	return v;
+}
+
+/*
+ * Takes ownership of fv, which must be of a signed or unsigned integer type.
+ */
+dfvm_value_t*
+dfvm_value_new_int_const(fvalue_t *fv)
+{
+	dfvm_value_t *v = dfvm_value_new(INTEGER_CONST);
+	dfvm_int_const_t *c;
+	enum ft_result res;
+
+	c = g_new0(dfvm_int_const_t, 1);
+	c->fvalue = fv;
+	c->is_signed = IS_FT_INT(fvalue_type_ftenum(fv));
+	if (c->is_signed)
+		res = fvalue_to_sinteger64(fv, &c->sint_key);
+	else
+		res = fvalue_to_uinteger64(fv, &c->uint_key);
+	ws_assert(res == FT_OK);
+
+	v->value.int_const = c;
+	return v;
+}
+
 static char *
 dfvm_value_tostr(dfvm_value_t *v)
 {
@@ -231,6 +354,12 @@ dfvm_value_tostr(dfvm_value_t *v)
 				aux, fvalue_type_name(v->value.fvalue));
 			g_free(aux);
 			break;
+		case INTEGER_CONST:
+			aux = fvalue_to_debug_repr(NULL, v->value.int_const->fvalue);
+			s = ws_strdup_printf("%s <%s>",
+				aux, fvalue_type_name(v->value.int_const->fvalue));
+			g_free(aux);
+			break;
 		case DRANGE:
 			s = drange_tostr(v->value.drange);
 			break;
@@ -246,6 +375,22 @@ dfvm_value_tostr(dfvm_value_t *v)
 		case INTEGER:
 			s = ws_strdup_printf("%"G_GUINT32_FORMAT, v->value.numeric);
 			break;
+		case INTEGER_SET:
+		{
+			GString *repr = g_string_new(NULL);
+			GPtrArray *fvalues = v->value.int_set->fvalues;
+			guint i;
+
+			for (i = 0; i < fvalues->len; i++) {
+				aux = fvalue_to_debug_repr(NULL, g_ptr_array_index(fvalues, i));
+				g_string_append_printf(repr, "%s ", aux);
+				g_free(aux);
+			}
+			g_string_append_printf(repr, "<%s>",
+				fvalue_type_name(g_ptr_array_index(fvalues, 0)));
+			s = g_string_free(repr, FALSE);
+			break;
+		}
 		default:
 			s = ws_strdup("FIXME");
 	}
@@ -432,6 +577,11 @@ dfvm_dump_str(wmem_allocator_t *alloc, dfilter_t *df, gboolean print_references)
 					arg1_str, arg2_str, arg3_str);
 				break;
 
+			case DFVM_ANY_IN_SET:
+				wmem_strbuf_append_printf(buf, "%05d %s\t%s in { %s }\n",
+					id, opcode_str, arg1_str, arg2_str);
+				break;
+
 			case DFVM_BITWISE_AND:
 				wmem_strbuf_append_printf(buf, "%05d %s\t%s & %s -> %s\n",
 					id, opcode_str, arg1_str, arg2_str, arg3_str);
@@ -616,8 +766,33 @@ dfvm_get_raw_fvalue(const field_info *fi)
 	return fv;
 }
 
+/* Adds data to the start of a register's list, using a node left over
+ * from an earlier run if there is one. */
 static GSList *
-filter_finfo_fvalues(GSList *fvalues, GPtrArray *finfos, drange_t *range, gboolean raw)
+register_prepend(dfilter_t *df, GSList *list, gpointer data)
+{
+	GSList *node = df->free_nodes;
+
+	if (node == NULL) {
+		return g_slist_prepend(list, data);
+	}
+	df->free_nodes = node->next;
+	node->data = data;
+	node->next = list;
+	return node;
+}
+
+/* Gives a list's nodes back for reuse. */
+static void
+register_release(dfilter_t *df, GSList *list)
+{
+	if (list != NULL) {
+		df->free_nodes = g_slist_concat(list, df->free_nodes);
+	}
+}
+
+static GSList *
+filter_finfo_fvalues(dfilter_t *df, GSList *fvalues, GPtrArray *finfos, drange_t *range, gboolean raw)
 {
 	int length; /* maximum proto layer number. The numbers are sequential. */
 	field_info *last_finfo, *finfo;
@@ -639,7 +814,7 @@ filter_finfo_fvalues(GSList *fvalues, GPtrArray *finfos, drange_t *range, gboole
 					fv = dfvm_get_raw_fvalue(finfo);
 				else
 					fv = &finfo->value;
-				fvalues = g_slist_prepend(fvalues, fv);
+				fvalues = register_prepend(df, fvalues, fv);
 			}
 		}
 		else {
@@ -650,7 +825,7 @@ filter_finfo_fvalues(GSList *fvalues, GPtrArray *finfos, drange_t *range, gboole
 					fv = dfvm_get_raw_fvalue(finfo);
 				else
 					fv = &finfo->value;
-				fvalues = g_slist_prepend(fvalues, fv);
+				fvalues = register_prepend(df, fvalues, fv);
 			}
 		}
 	}
@@ -701,7 +876,7 @@ read_tree(dfilter_t *df, proto_tree *tree,
 		}
 
 		if (range) {
-			fvalues = filter_finfo_fvalues(fvalues, finfos, range, raw);
+			fvalues = filter_finfo_fvalues(df, fvalues, finfos, range, raw);
 		}
 		else {
 			len = finfos->len;
@@ -711,7 +886,7 @@ read_tree(dfilter_t *df, proto_tree *tree,
 					fv = dfvm_get_raw_fvalue(finfo);
 				else
 					fv = &finfo->value;
-				fvalues = g_slist_prepend(fvalues, fv);
+				fvalues = register_prepend(df, fvalues, fv);
 			}
 		}
 
@@ -734,7 +909,7 @@ read_tree(dfilter_t *df, proto_tree *tree,
 }
 
 static GSList *
-filter_refs_fvalues(GPtrArray *refs_array, drange_t *range)
+filter_refs_fvalues(dfilter_t *df, GPtrArray *refs_array, drange_t *range)
 {
 	int length; /* maximum proto layer number. The numbers are sequential. */
 	df_reference_t *last_ref = NULL;
@@ -755,20 +930,20 @@ filter_refs_fvalues(GPtrArray *refs_array, drange_t *range)
 		int layer = ref->proto_layer_num;
 
 		if (range == NULL) {
-			fvalues = g_slist_prepend(fvalues, ref->value);
+			fvalues = register_prepend(df, fvalues, ref->value);
 			continue;
 		}
 
 		if (cookie == layer) {
 			if (cookie_matches) {
-				fvalues = g_slist_prepend(fvalues, ref->value);
+				fvalues = register_prepend(df, fvalues, ref->value);
 			}
 		}
 		else {
 			cookie = layer;
 			cookie_matches = drange_contains_layer(range, layer, length);
 			if (cookie_matches) {
-				fvalues = g_slist_prepend(fvalues, ref->value);
+				fvalues = register_prepend(df, fvalues, ref->value);
 			}
 		}
 	}
@@ -813,7 +988,7 @@ read_reference(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *arg2,
 		return FALSE;
 	}
 
-	df->registers[reg] = filter_refs_fvalues(refs, range);
+	df->registers[reg] = filter_refs_fvalues(df, refs, range);
 	// These values are referenced only, do not try to free it later.
 	df->free_registers[reg] = NULL;
 	return TRUE;
@@ -826,6 +1001,15 @@ enum match_how {
 
 typedef ft_bool_t (*DFVMCompareFunc)(const fvalue_t*, const fvalue_t*);
 typedef ft_bool_t (*DFVMTestFunc)(const fvalue_t*);
+/* Says whether the result of an ordering (<0, 0 or >0) satisfies a test. */
+typedef ft_bool_t (*DFVMOrderFunc)(int);
+
+static ft_bool_t order_eq(int cmp) { return cmp == 0; }
+static ft_bool_t order_ne(int cmp) { return cmp != 0; }
+static ft_bool_t order_gt(int cmp) { return cmp > 0; }
+static ft_bool_t order_ge(int cmp) { return cmp >= 0; }
+static ft_bool_t order_lt(int cmp) { return cmp < 0; }
+static ft_bool_t order_le(int cmp) { return cmp <= 0; }
 
 static gboolean
 cmp_test(enum match_how how, DFVMCompareFunc match_func,
@@ -880,6 +1064,55 @@ cmp_test_unary(enum match_how how, DFVMTestFunc test_func, GSList *arg1)
 	return want_all;
 }
 
+/* Compare a value with an integer constant directly if it's the same kind of
+ * integer, and with cmp() otherwise, to get the same result as that would. */
+static ft_bool_t
+int_const_test(DFVMCompareFunc cmp, DFVMOrderFunc order,
+			fvalue_t *fv, const dfvm_int_const_t *c)
+{
+	ftenum_t ftype = fvalue_type_ftenum(fv);
+	guint64 uint_val;
+	gint64 sint_val;
+
+	if (c->is_signed) {
+		if (IS_FT_INT(ftype) && fvalue_to_sinteger64(fv, &sint_val) == FT_OK) {
+			if (sint_val == c->sint_key)
+				return order(0);
+			return order(sint_val < c->sint_key ? -1 : 1);
+		}
+	}
+	else {
+		if (IS_FT_UINT(ftype) && fvalue_to_uinteger64(fv, &uint_val) == FT_OK) {
+			if (uint_val == c->uint_key)
+				return order(0);
+			return order(uint_val < c->uint_key ? -1 : 1);
+		}
+	}
+	return cmp(fv, c->fvalue);
+}
+
+static gboolean
+cmp_test_int_const(enum match_how how, DFVMCompareFunc cmp, DFVMOrderFunc order,
+					GSList *arg1, const dfvm_int_const_t *c)
+{
+	GSList *list1;
+	gboolean want_all = (how == MATCH_ALL);
+	gboolean want_any = (how == MATCH_ANY);
+	ft_bool_t have_match;
+
+	for (list1 = arg1; list1; list1 = g_slist_next(list1)) {
+		have_match = int_const_test(cmp, order, list1->data, c);
+		if (want_all && have_match == FT_FALSE) {
+			return FALSE;
+		}
+		else if (want_any && have_match == FT_TRUE) {
+			return TRUE;
+		}
+	}
+	/* want_all || !want_any */
+	return want_all;
+}
+
 static gboolean
 all_test_unary(dfilter_t *df, DFVMTestFunc func, dfvm_value_t *arg1)
 {
@@ -890,7 +1123,7 @@ all_test_unary(dfilter_t *df, DFVMTestFunc func, dfvm_value_t *arg1)
 
 /* cmp(A) <=> cmp(a1) OR cmp(a2) OR cmp(a3) OR ... */
 static gboolean
-any_test(dfilter_t *df, DFVMCompareFunc cmp,
+any_test(dfilter_t *df, DFVMCompareFunc cmp, DFVMOrderFunc order,
 				dfvm_value_t *arg1, dfvm_value_t *arg2)
 {
 	ws_assert(arg1->type == REGISTER);
@@ -906,12 +1139,16 @@ any_test(dfilter_t *df, DFVMCompareFunc cmp,
 		list2.next = NULL;
 		return cmp_test(MATCH_ANY, cmp, list1, &list2);
 	}
+	if (arg2->type == INTEGER_CONST) {
+		ws_assert(order);
+		return cmp_test_int_const(MATCH_ANY, cmp, order, list1, arg2->value.int_const);
+	}
 	ws_assert_not_reached();
 }
 
 /* cmp(A) <=> cmp(a1) AND cmp(a2) AND cmp(a3) AND ... */
 static gboolean
-all_test(dfilter_t *df, DFVMCompareFunc cmp,
+all_test(dfilter_t *df, DFVMCompareFunc cmp, DFVMOrderFunc order,
 				dfvm_value_t *arg1, dfvm_value_t *arg2)
 {
 	ws_assert(arg1->type == REGISTER);
@@ -927,6 +1164,10 @@ all_test(dfilter_t *df, DFVMCompareFunc cmp,
 		list2.next = NULL;
 		return cmp_test(MATCH_ALL, cmp, list1, &list2);
 	}
+	if (arg2->type == INTEGER_CONST) {
+		ws_assert(order);
+		return cmp_test_int_const(MATCH_ALL, cmp, order, list1, arg2->value.int_const);
+	}
 	ws_assert_not_reached();
 }
 
@@ -1039,6 +1280,49 @@ all_in_range(dfilter_t *df, dfvm_value_t *arg1,
 	return match_in_range(df, MATCH_ALL, arg1, arg_low, arg_high);
 }
 
+static gboolean
+int_set_contains(const dfvm_int_set_t *set, const fvalue_t *fv)
+{
+	guint64 uint_key;
+	gint64 sint_key;
+	guint i;
+
+	if (set->is_signed) {
+		if (fvalue_to_sinteger64(fv, &sint_key) == FT_OK)
+			return bsearch(&sint_key, set->sint_keys, set->count,
+					sizeof(gint64), compare_sint_keys) != NULL;
+	}
+	else {
+		if (fvalue_to_uinteger64(fv, &uint_key) == FT_OK)
+			return bsearch(&uint_key, set->uint_keys, set->count,
+					sizeof(guint64), compare_uint_keys) != NULL;
+	}
+
+	/* The value can't be represented like the keys (it's out of range, or
+	 * of another type); compare it with each constant, as an OR-ed series
+	 * of == tests would. */
+	for (i = 0; i < set->fvalues->len; i++) {
+		if (fvalue_eq(fv, g_ptr_array_index(set->fvalues, i)) == FT_TRUE)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static gboolean
+any_in_set(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *arg2)
+{
+	GSList *list1;
+
+	ws_assert(arg1->type == REGISTER);
+	ws_assert(arg2->type == INTEGER_SET);
+
+	for (list1 = df->registers[arg1->value.numeric]; list1; list1 = g_slist_next(list1)) {
+		if (int_set_contains(arg2->value.int_set, list1->data))
+			return TRUE;
+	}
+	return FALSE;
+}
+
 /* Clear registers that were populated during evaluation.
  * If we created the values, then these will be freed as well. */
 static void
@@ -1055,7 +1339,7 @@ free_register_overhead(dfilter_t* df)
 				}
 				df->free_registers[i] = NULL;
 			}
-			g_slist_free(df->registers[i]);
+			register_release(df, df->registers[i]);
 			df->registers[i] = NULL;
 		}
 	}
@@ -1082,7 +1366,7 @@ mk_slice(dfilter_t *df, dfvm_value_t *from_arg, dfvm_value_t *to_arg,
 		 * already caught the cases in which a slice
 		 * cannot be made. */
 		ws_assert(new_fv);
-		to_list = g_slist_prepend(to_list, new_fv);
+		to_list = register_prepend(df, to_list, new_fv);
 
 		from_list = g_slist_next(from_list);
 	}
@@ -1104,7 +1388,7 @@ mk_length(dfilter_t *df, dfvm_value_t *from_arg, dfvm_value_t *to_arg)
 		old_fv = from_list->data;
 		new_fv = fvalue_new(FT_UINT32);
 		fvalue_set_uinteger(new_fv, fvalue_length(old_fv));
-		to_list = g_slist_prepend(to_list, new_fv);
+		to_list = register_prepend(df, to_list, new_fv);
 
 		from_list = g_slist_next(from_list);
 	}
@@ -1173,7 +1457,7 @@ debug_register(GSList *reg, guint32 num)
 typedef fvalue_t* (*DFVMBinaryFunc)(const fvalue_t*, const fvalue_t*, char **);
 
 static void
-mk_binary_internal(DFVMBinaryFunc func,
+mk_binary_internal(dfilter_t *df, DFVMBinaryFunc func,
 			GSList *arg1, GSList *arg2, GSList **retval)
 {
 	GSList *list1, *list2;
@@ -1195,7 +1479,7 @@ mk_binary_internal(DFVMBinaryFunc func,
 				err_msg = NULL;
 			}
 			else {
-				to_list = g_slist_prepend(to_list, result);
+				to_list = register_prepend(df, to_list, result);
 			}
 			list2 = g_slist_next(list2);
 		}
@@ -1236,7 +1520,7 @@ mk_binary(dfilter_t *df, DFVMBinaryFunc func,
 		ws_assert_not_reached();
 	}
 
-	mk_binary_internal(func, list1, list2, &result);
+	mk_binary_internal(df, func, list1, list2, &result);
 	//debug_register(result, to_arg->value.numeric);
 
 	df->registers[to_arg->value.numeric] = result;
@@ -1244,7 +1528,7 @@ mk_binary(dfilter_t *df, DFVMBinaryFunc func,
 }
 
 static void
-mk_minus_internal(GSList *arg1, GSList **retval)
+mk_minus_internal(dfilter_t *df, GSList *arg1, GSList **retval)
 {
 	GSList *list1;
 	GSList *to_list = NULL;
@@ -1262,7 +1546,7 @@ mk_minus_internal(GSList *arg1, GSList **retval)
 			err_msg = NULL;
 		}
 		else {
-			to_list = g_slist_prepend(to_list, result);
+			to_list = register_prepend(df, to_list, result);
 		}
 		list1 = g_slist_next(list1);
 	}
@@ -1276,7 +1560,7 @@ mk_minus(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *to_arg)
 	GSList *list1 = df->registers[arg1->value.numeric];
 	GSList *result = NULL;
 
-	mk_minus_internal(list1, &result);
+	mk_minus_internal(df, list1, &result);
 
 	df->registers[to_arg->value.numeric] = result;
 	df->free_registers[to_arg->value.numeric] = (GDestroyNotify)fvalue_free;
@@ -1286,7 +1570,7 @@ static void
 put_fvalue(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *to_arg)
 {
 	fvalue_t *fv = arg1->value.fvalue;
-	df->registers[to_arg->value.numeric] = g_slist_append(NULL, fv);
+	df->registers[to_arg->value.numeric] = register_prepend(df, NULL, fv);
 
 	/* Memory is owned by the dfvm_value_t. */
 	df->free_registers[to_arg->value.numeric] = NULL;
@@ -1295,25 +1579,28 @@ put_fvalue(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *to_arg)
 static void
 stack_push(dfilter_t *df, dfvm_value_t *arg1)
 {
-	GSList *arg;
+	GSList *arg = NULL;
 
 	if (arg1->type == FVALUE) {
-		arg = g_slist_prepend(NULL, arg1->value.fvalue);
+		arg = register_prepend(df, NULL, arg1->value.fvalue);
 	}
 	else if (arg1->type == REGISTER) {
-		arg = g_slist_copy(df->registers[arg1->value.numeric]);
+		for (GSList *l = df->registers[arg1->value.numeric]; l != NULL; l = l->next) {
+			arg = register_prepend(df, arg, l->data);
+		}
+		arg = g_slist_reverse(arg);
 	}
 	else {
 		ws_assert_not_reached();
 	}
-	df->function_stack = g_slist_prepend(df->function_stack, arg);
+	df->function_stack = register_prepend(df, df->function_stack, arg);
 }
 
 static void
 stack_pop(dfilter_t *df, dfvm_value_t *arg1)
 {
 	guint count;
-	GSList *reg;
+	GSList *reg, *top;
 
 	count = arg1->value.numeric;
 
@@ -1322,14 +1609,17 @@ stack_pop(dfilter_t *df, dfvm_value_t *arg1)
 		 * contentes are not owned by us. */
 		reg = df->function_stack->data;
 		/* Free the list but not the data it contains. */
-		g_slist_free(reg);
+		register_release(df, reg);
 		/* remove top of stack */
-		df->function_stack = g_slist_delete_link(df->function_stack, df->function_stack);
+		top = df->function_stack;
+		df->function_stack = top->next;
+		top->next = NULL;
+		register_release(df, top);
 	}
 }
 
 static gboolean
-check_exists(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
+check_exists(dfilter_t *df, proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
 {
 	GPtrArray		*finfos;
 	header_field_info	*hfinfo;
@@ -1351,9 +1641,9 @@ check_exists(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
 			return TRUE;
 		}
 
-		fvalues = filter_finfo_fvalues(NULL, finfos, range, FALSE);
+		fvalues = filter_finfo_fvalues(df, NULL, finfos, range, FALSE);
 		exists = (fvalues != NULL);
-		g_slist_free(fvalues);
+		register_release(df, fvalues);
 		if (exists) {
 			return TRUE;
 		}
@@ -1364,6 +1654,69 @@ check_exists(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
 	return FALSE;
 }
 
+void
+dfvm_start_profile(dfilter_t *df)
+{
+	dfvm_free_profile(df);
+	df->profile = g_new0(struct dfvm_profile, 1);
+	df->profile->insns = g_new0(dfvm_insn_profile_t, df->insns->len);
+}
+
+void
+dfvm_free_profile(dfilter_t *df)
+{
+	if (df->profile == NULL)
+		return;
+	g_free(df->profile->insns);
+	g_free(df->profile);
+	df->profile = NULL;
+}
+
+void
+dfvm_dump_profile(FILE *f, dfilter_t *df)
+{
+	struct dfvm_profile *profile = df->profile;
+	dfvm_insn_profile_t *ip;
+	dfvm_insn_t	*insn;
+	guint		id;
+
+	if (profile == NULL)
+		return;
+
+	fprintf(f, "Runs: %" G_GUINT64_FORMAT ", matched: %" G_GUINT64_FORMAT "\n",
+		profile->runs, profile->matches);
+	fprintf(f, "Total time: %.3f ms, %.1f ns per run\n",
+		profile->ns / 1e6,
+		profile->runs ? (double)profile->ns / profile->runs : 0.0);
+	fprintf(f, "\nInstruction         Runs       Time (ns)    ns/run        Hits      Misses\n");
+	for (id = 0; id < df->insns->len; id++) {
+		insn = g_ptr_array_index(df->insns, id);
+		ip = &profile->insns[id];
+		fprintf(f, "%05u %-12s %10" G_GUINT64_FORMAT " %15" G_GUINT64_FORMAT " %9.1f",
+			id, dfvm_opcode_tostr(insn->op), ip->runs, ip->ns,
+			ip->runs ? (double)ip->ns / ip->runs : 0.0);
+		if (insn->op == DFVM_READ_TREE || insn->op == DFVM_READ_TREE_R)
+			fprintf(f, " %11" G_GUINT64_FORMAT " %11" G_GUINT64_FORMAT,
+				ip->hits, ip->misses);
+		fputc('\n', f);
+	}
+}
+
+/* Charge the time since the last instruction started to it, and count
+ * a run of the next one. */
+static inline void
+profile_insn(struct dfvm_profile *profile, int *prev_id, guint64 *prev_start, int id)
+{
+	guint64 now = ws_clock_get_monotonic_ns();
+
+	if (*prev_id >= 0)
+		profile->insns[*prev_id].ns += now - *prev_start;
+	if (id >= 0)
+		profile->insns[id].runs++;
+	*prev_id = id;
+	*prev_start = now;
+}
+
 gboolean
 dfvm_apply(dfilter_t *df, proto_tree *tree)
 {
@@ -1373,11 +1726,17 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 	dfvm_value_t	*arg1;
 	dfvm_value_t	*arg2;
 	dfvm_value_t	*arg3 = NULL;
+	struct dfvm_profile *profile = df->profile;
+	int		prof_id = -1;
+	guint64		prof_start = 0, prof_run_start = 0;
 
 	ws_assert(tree);
 
 	length = df->insns->len;
 
+	if (profile)
+		prof_run_start = ws_clock_get_monotonic_ns();
+
 	for (id = 0; id < length; id++) {
 
 	  AGAIN:
@@ -1386,21 +1745,36 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 		arg2 = insn->arg2;
 		arg3 = insn->arg3;
 
+		if (G_UNLIKELY(profile != NULL))
+			profile_insn(profile, &prof_id, &prof_start, id);
+
 		switch (insn->op) {
 			case DFVM_CHECK_EXISTS:
-				accum = check_exists(tree, arg1, NULL);
+				accum = check_exists(df, tree, arg1, NULL);
 				break;
 
 			case DFVM_CHECK_EXISTS_R:
-				accum = check_exists(tree, arg1, arg2);
+				accum = check_exists(df, tree, arg1, arg2);
 				break;
 
 			case DFVM_READ_TREE:
 				accum = read_tree(df, tree, arg1, arg2, NULL);
+				if (G_UNLIKELY(profile != NULL)) {
+					if (accum)
+						profile->insns[id].hits++;
+					else
+						profile->insns[id].misses++;
+				}
 				break;
 
 			case DFVM_READ_TREE_R:
 				accum = read_tree(df, tree, arg1, arg2, arg3);
+				if (G_UNLIKELY(profile != NULL)) {
+					if (accum)
+						profile->insns[id].hits++;
+					else
+						profile->insns[id].misses++;
+				}
 				break;
 
 			case DFVM_READ_REFERENCE:
@@ -1436,51 +1810,51 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				break;
 
 			case DFVM_ALL_EQ:
-				accum = all_test(df, fvalue_eq, arg1, arg2);
+				accum = all_test(df, fvalue_eq, order_eq, arg1, arg2);
 				break;
 
 			case DFVM_ANY_EQ:
-				accum = any_test(df, fvalue_eq, arg1, arg2);
+				accum = any_test(df, fvalue_eq, order_eq, arg1, arg2);
 				break;
 
 			case DFVM_ALL_NE:
-				accum = all_test(df, fvalue_ne, arg1, arg2);
+				accum = all_test(df, fvalue_ne, order_ne, arg1, arg2);
 				break;
 
 			case DFVM_ANY_NE:
-				accum = any_test(df, fvalue_ne, arg1, arg2);
+				accum = any_test(df, fvalue_ne, order_ne, arg1, arg2);
 				break;
 
 			case DFVM_ALL_GT:
-				accum = all_test(df, fvalue_gt, arg1, arg2);
+				accum = all_test(df, fvalue_gt, order_gt, arg1, arg2);
 				break;
 
 			case DFVM_ANY_GT:
-				accum = any_test(df, fvalue_gt, arg1, arg2);
+				accum = any_test(df, fvalue_gt, order_gt, arg1, arg2);
 				break;
 
 			case DFVM_ALL_GE:
-				accum = all_test(df, fvalue_ge, arg1, arg2);
+				accum = all_test(df, fvalue_ge, order_ge, arg1, arg2);
 				break;
 
 			case DFVM_ANY_GE:
-				accum = any_test(df, fvalue_ge, arg1, arg2);
+				accum = any_test(df, fvalue_ge, order_ge, arg1, arg2);
 				break;
 
 			case DFVM_ALL_LT:
-				accum = all_test(df, fvalue_lt, arg1, arg2);
+				accum = all_test(df, fvalue_lt, order_lt, arg1, arg2);
 				break;
 
 			case DFVM_ANY_LT:
-				accum = any_test(df, fvalue_lt, arg1, arg2);
+				accum = any_test(df, fvalue_lt, order_lt, arg1, arg2);
 				break;
 
 			case DFVM_ALL_LE:
-				accum = all_test(df, fvalue_le, arg1, arg2);
+				accum = all_test(df, fvalue_le, order_le, arg1, arg2);
 				break;
 
 			case DFVM_ANY_LE:
-				accum = any_test(df, fvalue_le, arg1, arg2);
+				accum = any_test(df, fvalue_le, order_le, arg1, arg2);
 				break;
 
 			case DFVM_BITWISE_AND:
@@ -1512,11 +1886,11 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				break;
 
 			case DFVM_ALL_CONTAINS:
-				accum = all_test(df, fvalue_contains, arg1, arg2);
+				accum = all_test(df, fvalue_contains, NULL, arg1, arg2);
 				break;
 
 			case DFVM_ANY_CONTAINS:
-				accum = any_test(df, fvalue_contains, arg1, arg2);
+				accum = any_test(df, fvalue_contains, NULL, arg1, arg2);
 				break;
 
 			case DFVM_ALL_MATCHES:
@@ -1535,6 +1909,10 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				accum = any_in_range(df, arg1, arg2, arg3);
 				break;
 
+			case DFVM_ANY_IN_SET:
+				accum = any_in_set(df, arg1, arg2);
+				break;
+
 			case DFVM_UNARY_MINUS:
 				mk_minus(df, arg1, arg2);
 				break;
@@ -1545,6 +1923,12 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 
 			case DFVM_RETURN:
 				free_register_overhead(df);
+				if (G_UNLIKELY(profile != NULL)) {
+					profile_insn(profile, &prof_id, &prof_start, -1);
+					profile->runs++;
+					profile->matches += accum ? 1 : 0;
+					profile->ns += prof_start - prof_run_start;
+				}
 				return accum;
 
 			case DFVM_IF_TRUE_GOTO:
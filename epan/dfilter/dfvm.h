@@ -27,9 +27,31 @@ typedef enum {
 	INTEGER,
 	DRANGE,
 	FUNCTION_DEF,
-	PCRE
+	PCRE,
+	INTEGER_SET,
+	INTEGER_CONST
 } dfvm_value_type_t;
 
+/* An integer constant that a field is compared with, converted in advance so
+ * that values of the same kind of integer can be compared with it directly,
+ * without going through the fvalue comparison functions. */
+typedef struct {
+	gboolean	is_signed;
+	guint64		uint_key;	/* if !is_signed */
+	gint64		sint_key;	/* if is_signed */
+	fvalue_t	*fvalue;	/* the constant, as given */
+} dfvm_int_const_t;
+
+/* A set of integer constants, for testing membership with a binary search
+ * rather than a chain of equality tests. */
+typedef struct {
+	gboolean	is_signed;
+	guint		count;		/* number of distinct keys */
+	guint64		*uint_keys;	/* sorted, if !is_signed */
+	gint64		*sint_keys;	/* sorted, if is_signed */
+	GPtrArray	*fvalues;	/* the constants, as given */
+} dfvm_int_set_t;
+
 typedef struct {
 	dfvm_value_type_t	type;
 
@@ -40,6 +62,8 @@ typedef struct {
 		header_field_info	*hfinfo;
 		df_func_def_t		*funcdef;
 		ws_regex_t		*pcre;
+		dfvm_int_set_t		*int_set;
+		dfvm_int_const_t	*int_const;
 	} value;
 
 	int ref_count;
@@ -77,6 +101,7 @@ typedef enum {
 	DFVM_ANY_MATCHES,
 	DFVM_ALL_IN_RANGE,
 	DFVM_ANY_IN_RANGE,
+	DFVM_ANY_IN_SET,
 	DFVM_SLICE,
 	DFVM_LENGTH,
 	DFVM_BITWISE_AND,
@@ -139,6 +164,12 @@ dfvm_value_new_pcre(ws_regex_t *re);
 dfvm_value_t*
 dfvm_value_new_guint(guint num);
 
+dfvm_value_t*
+dfvm_value_new_int_set(GPtrArray *fvalues);
+
+dfvm_value_t*
+dfvm_value_new_int_const(fvalue_t *fv);
+
 void
 dfvm_dump(FILE *f, dfilter_t *df);
 
@@ -148,6 +179,15 @@ dfvm_dump_str(wmem_allocator_t *alloc, dfilter_t *df, gboolean print_references)
 gboolean
 dfvm_apply(dfilter_t *df, proto_tree *tree);
 
+void
+dfvm_start_profile(dfilter_t *df);
+
+void
+dfvm_dump_profile(FILE *f, dfilter_t *df);
+
+void
+dfvm_free_profile(dfilter_t *df);
+
 fvalue_t *
 dfvm_get_raw_fvalue(const field_info *fi);
 
@@ -56,6 +56,7 @@ select_opcode(dfvm_opcode_t op, stmatch_t how)
 		case DFVM_ANY_MATCHES:
 		case DFVM_ANY_IN_RANGE:
 			return how == STNODE_MATCH_ANY ? op : op - 1;
+		case DFVM_ANY_IN_SET:
 		case DFVM_NOT_ALL_ZERO:
 		case DFVM_IF_TRUE_GOTO:
 		case DFVM_IF_FALSE_GOTO:
@@ -388,6 +389,17 @@ gen_relation_insn(dfwork_t *dfw, dfvm_opcode_t op,
 	dfw_append_insn(dfw, insn);
 }
 
+static gboolean
+is_int_constant(stnode_t *node)
+{
+	ftenum_t ftype;
+
+	if (stnode_type_id(node) != STTYPE_FVALUE)
+		return FALSE;
+	ftype = fvalue_type_ftenum(stnode_data(node));
+	return IS_FT_INT(ftype) || IS_FT_UINT(ftype);
+}
+
 static void
 gen_relation(dfwork_t *dfw, dfvm_opcode_t op, stmatch_t how,
 					stnode_t *st_arg1, stnode_t *st_arg2)
@@ -397,7 +409,14 @@ gen_relation(dfwork_t *dfw, dfvm_opcode_t op, stmatch_t how,
 
 	/* Create code for the LHS and RHS of the relation */
 	val1 = gen_entity(dfw, st_arg1, &jumps);
-	val2 = gen_entity(dfw, st_arg2, &jumps);
+	if (op != DFVM_ANY_CONTAINS && op != DFVM_ANY_MATCHES &&
+			is_int_constant(st_arg2)) {
+		/* Let the VM compare integers directly. */
+		val2 = dfvm_value_new_int_const(stnode_steal_data(st_arg2));
+	}
+	else {
+		val2 = gen_entity(dfw, st_arg2, &jumps);
+	}
 
 	/* Then combine them in a DFVM insruction */
 	op = select_opcode(op, how);
@@ -421,6 +440,76 @@ fixup_jumps(gpointer data, gpointer user_data)
 	}
 }
 
+static gboolean
+is_int_set_element(stnode_t *node1, stnode_t *node2, ftenum_t *ftype)
+{
+	ftenum_t node_ftype;
+
+	if (node2 != NULL || !is_int_constant(node1))
+		return FALSE;
+	node_ftype = fvalue_type_ftenum(stnode_data(node1));
+	if (*ftype == FT_NONE)
+		*ftype = node_ftype;
+	return node_ftype == *ftype;
+}
+
+/* If the set has more than one integer constant, test them all with one
+ * DFVM_ANY_IN_SET instruction, which looks the values up in a sorted array,
+ * and return the elements that are left. */
+static GSList *
+gen_relation_in_int_set(dfwork_t *dfw, dfvm_value_t *val1,
+				GSList *nodelist_head, GSList **jumps_ptr)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*jmp;
+	GSList		*nodelist, *rest = NULL;
+	stnode_t	*node1, *node2;
+	ftenum_t	ftype = FT_NONE;
+	GPtrArray	*fvalues;
+	guint		count = 0;
+
+	for (nodelist = nodelist_head; nodelist; nodelist = nodelist->next->next) {
+		if (is_int_set_element(nodelist->data, nodelist->next->data, &ftype))
+			count++;
+	}
+	if (count < 2)
+		return nodelist_head;
+
+	fvalues = g_ptr_array_sized_new(count);
+	ftype = FT_NONE;
+	for (nodelist = nodelist_head; nodelist; nodelist = nodelist->next->next) {
+		node1 = nodelist->data;
+		node2 = nodelist->next->data;
+		if (is_int_set_element(node1, node2, &ftype)) {
+			g_ptr_array_add(fvalues, stnode_steal_data(node1));
+			stnode_free(node1);
+		}
+		else {
+			/* Set elements are always in pairs. */
+			rest = g_slist_prepend(rest, node1);
+			rest = g_slist_prepend(rest, node2);
+		}
+	}
+	g_slist_free(nodelist_head);
+	rest = g_slist_reverse(rest);
+
+	insn = dfvm_insn_new(DFVM_ANY_IN_SET);
+	insn->arg1 = dfvm_value_ref(val1);
+	insn->arg2 = dfvm_value_ref(dfvm_value_new_int_set(fvalues));
+	dfw_append_insn(dfw, insn);
+
+	/* Exit if we found a match */
+	if (rest) {
+		insn = dfvm_insn_new(DFVM_IF_TRUE_GOTO);
+		jmp = dfvm_value_new(INSN_NUMBER);
+		insn->arg1 = dfvm_value_ref(jmp);
+		dfw_append_insn(dfw, insn);
+		*jumps_ptr = g_slist_prepend(*jumps_ptr, jmp);
+	}
+
+	return rest;
+}
+
 /* Generate the code for the in operator.  It behaves much like an OR-ed
  * series of == tests, but without the redundant existence checks. */
 static void
@@ -440,7 +529,11 @@ gen_relation_in(dfwork_t *dfw, stmatch_t how,
 	val1 = gen_entity(dfw, st_arg1, &jumps);
 
 	/* Create code for the set on the RHS of the relation */
-	nodelist_head = nodelist = stnode_steal_data(st_arg2);
+	nodelist_head = stnode_steal_data(st_arg2);
+	if (select_opcode(DFVM_ANY_EQ, how) == DFVM_ANY_EQ) {
+		nodelist_head = gen_relation_in_int_set(dfw, val1, nodelist_head, &jumps);
+	}
+	nodelist = nodelist_head;
 	while (nodelist) {
 		node1 = nodelist->data;
 		nodelist = g_slist_next(nodelist);
@@ -665,6 +758,55 @@ gen_exists_slice(dfwork_t *dfw, stnode_t *st_node)
 	g_slist_free(jumps);
 }
 
+/* A rough estimate of how much work it is to evaluate a node, so that the
+ * operand of "and" or "or" that's cheaper to test can be tested first. */
+#define COST_FUNCTION	10
+#define COST_MATCHES	10
+#define COST_CONTAINS	4
+
+static int
+estimate_cost(stnode_t *st_node)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (st_node == NULL)
+		return 0;
+
+	switch (stnode_type_id(st_node)) {
+		case STTYPE_FVALUE:
+		case STTYPE_PCRE:
+			return 0;
+		case STTYPE_FIELD:
+		case STTYPE_REFERENCE:
+			return 1;
+		case STTYPE_SLICE:
+			return 1 + estimate_cost(sttype_slice_entity(st_node));
+		case STTYPE_FUNCTION:
+			return COST_FUNCTION;
+		case STTYPE_SET:
+			/* Elements are in pairs. */
+			return g_slist_length(stnode_data(st_node)) / 2;
+		case STTYPE_TEST:
+		case STTYPE_ARITHMETIC:
+			sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+			switch (st_op) {
+				case STNODE_OP_NOT:
+				case STNODE_OP_AND:
+				case STNODE_OP_OR:
+					return estimate_cost(st_arg1) + estimate_cost(st_arg2);
+				case STNODE_OP_MATCHES:
+					return COST_MATCHES + estimate_cost(st_arg1);
+				case STNODE_OP_CONTAINS:
+					return COST_CONTAINS + estimate_cost(st_arg1) + estimate_cost(st_arg2);
+				default:
+					return 1 + estimate_cost(st_arg1) + estimate_cost(st_arg2);
+			}
+		default:
+			return 1;
+	}
+}
+
 static void
 gen_test(dfwork_t *dfw, stnode_t *st_node)
 {
@@ -678,6 +820,16 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
 	st_how = sttype_test_get_match(st_node);
 
+	if (st_op == STNODE_OP_AND || st_op == STNODE_OP_OR) {
+		/* Evaluating a test has no side effects, so the result is the
+		 * same either way round. */
+		if (estimate_cost(st_arg2) < estimate_cost(st_arg1)) {
+			stnode_t *st_tmp = st_arg1;
+			st_arg1 = st_arg2;
+			st_arg2 = st_tmp;
+		}
+	}
+
 	switch (st_op) {
 		case STNODE_OP_UNINITIALIZED:
 			ws_assert_not_reached();
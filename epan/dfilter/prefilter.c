@@ -0,0 +1,180 @@
+/*
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#define WS_LOG_DOMAIN LOG_DOMAIN_DFILTER
+
+#include "prefilter.h"
+
+#include <string.h>
+
+#include "syntax-tree.h"
+#include "sttype-field.h"
+#include "sttype-op.h"
+#include <epan/tvbuff.h>
+#include <wsutil/wmem/wmem_strutl.h>
+#include <wsutil/ws_assert.h>
+
+/*
+ * The only tests handled are 'frame contains <bytes>', and "and", "or"
+ * of them: the "frame" protocol's value is the whole of the frame's data,
+ * so if the bytes aren't anywhere in the data, the test fails, and the
+ * packet doesn't have to be dissected to find that out.
+ */
+typedef enum {
+	PREFILTER_CONTAINS,
+	PREFILTER_AND,
+	PREFILTER_OR
+} df_prefilter_type_t;
+
+struct df_prefilter {
+	df_prefilter_type_t	type;
+	guint8			*needle;	/* PREFILTER_CONTAINS */
+	size_t			needle_len;
+	df_prefilter_t		*left;		/* PREFILTER_AND, PREFILTER_OR */
+	df_prefilter_t		*right;
+};
+
+static df_prefilter_t *
+prefilter_new_op(df_prefilter_type_t type, df_prefilter_t *left, df_prefilter_t *right)
+{
+	df_prefilter_t *pf = g_new0(df_prefilter_t, 1);
+
+	pf->type = type;
+	pf->left = left;
+	pf->right = right;
+	return pf;
+}
+
+static gboolean
+is_frame_field(stnode_t *node)
+{
+	header_field_info *hfinfo;
+
+	if (stnode_type_id(node) != STTYPE_FIELD)
+		return FALSE;
+	/* A layer or raw reference selects something other than the
+	 * frame's data as given. */
+	if (sttype_field_drange(node) != NULL || sttype_field_raw(node))
+		return FALSE;
+	hfinfo = sttype_field_hfinfo(node);
+	return hfinfo->type == FT_PROTOCOL && strcmp(hfinfo->abbrev, "frame") == 0 &&
+		hfinfo->same_name_prev_id == -1 && hfinfo->same_name_next == NULL;
+}
+
+static df_prefilter_t *
+prefilter_contains(stnode_t *st_node, stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	df_prefilter_t *pf;
+	tvbuff_t *tvb;
+	guint len;
+
+	if (sttype_test_get_match(st_node) == STNODE_MATCH_ALL)
+		return NULL;
+	if (!is_frame_field(st_arg1) || stnode_type_id(st_arg2) != STTYPE_FVALUE)
+		return NULL;
+	if (fvalue_type_ftenum(stnode_data(st_arg2)) != FT_PROTOCOL)
+		return NULL;
+	tvb = fvalue_get_protocol(stnode_data(st_arg2));
+	if (tvb == NULL)
+		return NULL;
+	len = tvb_captured_length(tvb);
+	if (len == 0)
+		return NULL;
+
+	pf = g_new0(df_prefilter_t, 1);
+	pf->type = PREFILTER_CONTAINS;
+	pf->needle = (guint8 *)tvb_memdup(NULL, tvb, 0, len);
+	pf->needle_len = len;
+	return pf;
+}
+
+static df_prefilter_t *
+prefilter_from_node(stnode_t *st_node)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	df_prefilter_t	*left, *right;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST)
+		return NULL;
+
+	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+
+	switch (st_op) {
+		case STNODE_OP_AND:
+			/* Either test failing is enough. */
+			left = prefilter_from_node(st_arg1);
+			right = prefilter_from_node(st_arg2);
+			if (left && right)
+				return prefilter_new_op(PREFILTER_AND, left, right);
+			return left ? left : right;
+
+		case STNODE_OP_OR:
+			/* Both tests have to fail. */
+			left = prefilter_from_node(st_arg1);
+			right = prefilter_from_node(st_arg2);
+			if (left && right)
+				return prefilter_new_op(PREFILTER_OR, left, right);
+			df_prefilter_free(left);
+			df_prefilter_free(right);
+			return NULL;
+
+		case STNODE_OP_CONTAINS:
+			return prefilter_contains(st_node, st_arg1, st_arg2);
+
+		default:
+			return NULL;
+	}
+}
+
+df_prefilter_t *
+dfw_prefilter(dfwork_t *dfw)
+{
+	return prefilter_from_node(dfw->st_root);
+}
+
+gboolean
+df_prefilter_may_match(const df_prefilter_t *pf, const guint8 *data, size_t len)
+{
+	switch (pf->type) {
+		case PREFILTER_CONTAINS:
+			return ws_memmem(data, len, pf->needle, pf->needle_len) != NULL;
+		case PREFILTER_AND:
+			return df_prefilter_may_match(pf->left, data, len) &&
+				df_prefilter_may_match(pf->right, data, len);
+		case PREFILTER_OR:
+			return df_prefilter_may_match(pf->left, data, len) ||
+				df_prefilter_may_match(pf->right, data, len);
+	}
+	ws_assert_not_reached();
+}
+
+void
+df_prefilter_free(df_prefilter_t *pf)
+{
+	if (pf == NULL)
+		return;
+	df_prefilter_free(pf->left);
+	df_prefilter_free(pf->right);
+	g_free(pf->needle);
+	g_free(pf);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,31 @@
+/** @file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef PREFILTER_H
+#define PREFILTER_H
+
+#include "dfilter-int.h"
+
+/* A test of a packet's raw bytes that a packet must pass for it to
+ * possibly match a filter. */
+typedef struct df_prefilter df_prefilter_t;
+
+/* Returns NULL if nothing in the filter can be tested that way.
+ * Must be called after the semantic check and before code generation,
+ * which takes the values out of the syntax tree. */
+df_prefilter_t *
+dfw_prefilter(dfwork_t *dfw);
+
+gboolean
+df_prefilter_may_match(const df_prefilter_t *pf, const guint8 *data, size_t len);
+
+void
+df_prefilter_free(df_prefilter_t *pf);
+
+#endif
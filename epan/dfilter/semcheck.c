@@ -1149,6 +1149,50 @@ check_arithmetic_entity(dfwork_t *dfw, stnode_t *st_arg, ftenum_t lhs_ftype)
 	return ftype;
 }
 
+/* Pre-compute the result of a binary operation on constants. If that fails,
+ * say with a division by zero, leave it to be done (and fail) at run time,
+ * as it would have been. */
+static void
+fold_constant_arithmetic(stnode_t *st_node, stnode_op_t st_op,
+				stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	const fvalue_t *fv1 = stnode_data(st_arg1);
+	const fvalue_t *fv2 = stnode_data(st_arg2);
+	fvalue_t *new_fv;
+	char *err_msg = NULL;
+
+	switch (st_op) {
+		case STNODE_OP_ADD:
+			new_fv = fvalue_add(fv1, fv2, &err_msg);
+			break;
+		case STNODE_OP_SUBTRACT:
+			new_fv = fvalue_subtract(fv1, fv2, &err_msg);
+			break;
+		case STNODE_OP_MULTIPLY:
+			new_fv = fvalue_multiply(fv1, fv2, &err_msg);
+			break;
+		case STNODE_OP_DIVIDE:
+			new_fv = fvalue_divide(fv1, fv2, &err_msg);
+			break;
+		case STNODE_OP_MODULO:
+			new_fv = fvalue_modulo(fv1, fv2, &err_msg);
+			break;
+		case STNODE_OP_BITWISE_AND:
+			new_fv = fvalue_bitwise_and(fv1, fv2, &err_msg);
+			break;
+		default:
+			ws_assert_not_reached();
+	}
+
+	if (new_fv == NULL) {
+		ws_noisy("Not folding %s: %s", stnode_todisplay(st_node), err_msg);
+		g_free(err_msg);
+		return;
+	}
+	/* Replaces the operator with the result */
+	stnode_replace(st_node, STTYPE_FVALUE, new_fv);
+}
+
 ftenum_t
 check_arithmetic_expr(dfwork_t *dfw, stnode_t *st_node, ftenum_t lhs_ftype)
 {
@@ -1228,6 +1272,11 @@ check_arithmetic_expr(dfwork_t *dfw, stnode_t *st_node, ftenum_t lhs_ftype)
 			stnode_todisplay(st_arg1), stnode_todisplay(st_arg2));
 	}
 
+	if (stnode_type_id(st_arg1) == STTYPE_FVALUE &&
+			stnode_type_id(st_arg2) == STTYPE_FVALUE) {
+		fold_constant_arithmetic(st_node, st_op, st_arg1, st_arg2);
+	}
+
 	return ftype1;
 }
 
@@ -0,0 +1,184 @@
+/* dissector_profile.c
+ * Routines for profiling dissectors: how often each protocol's dissectors
+ * are called, how long they take, and how much packet-scope memory they
+ * allocate.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <wsutil/time_util.h>
+#include <wsutil/wmem/wmem.h>
+
+#include "dissector_profile.h"
+
+typedef struct {
+    dissector_profile_entry_t counts;
+    guint active;                   /* calls of it in progress */
+} profile_entry_t;
+
+/* A call in progress. */
+typedef struct {
+    profile_entry_t *entry;
+    guint64          start_ns;
+    guint64          start_bytes;
+    guint64          child_ns;      /* spent in the dissectors it called */
+    guint64          child_bytes;   /* allocated by them */
+} profile_frame_t;
+
+gboolean dissector_profiling = FALSE;
+
+static GHashTable *profile_entries;     /* profile_entry_t, by key */
+static GArray     *profile_stack;       /* profile_frame_t, innermost last */
+
+void
+dissector_profile_set_enabled(gboolean enable)
+{
+    if (enable && profile_entries == NULL) {
+        profile_entries = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                NULL, g_free);
+        profile_stack = g_array_new(FALSE, FALSE, sizeof (profile_frame_t));
+    }
+    dissector_profiling = enable;
+}
+
+gboolean
+dissector_profile_is_enabled(void)
+{
+    return dissector_profiling;
+}
+
+static void
+reset_entry(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+    profile_entry_t *entry = (profile_entry_t *)value;
+
+    entry->counts.calls = 0;
+    entry->counts.accepted = 0;
+    entry->counts.inclusive_ns = 0;
+    entry->counts.exclusive_ns = 0;
+    entry->counts.bytes_allocated = 0;
+}
+
+void
+dissector_profile_reset(void)
+{
+    if (profile_entries != NULL)
+        g_hash_table_foreach(profile_entries, reset_entry, NULL);
+}
+
+static void
+add_entry(gpointer key _U_, gpointer value, gpointer user_data)
+{
+    profile_entry_t *entry = (profile_entry_t *)value;
+    GArray *entries = (GArray *)user_data;
+
+    if (entry->counts.calls != 0)
+        g_array_append_val(entries, entry->counts);
+}
+
+static gint
+compare_entries(gconstpointer a, gconstpointer b)
+{
+    const dissector_profile_entry_t *entry_a = (const dissector_profile_entry_t *)a;
+    const dissector_profile_entry_t *entry_b = (const dissector_profile_entry_t *)b;
+
+    if (entry_a->exclusive_ns != entry_b->exclusive_ns)
+        return entry_a->exclusive_ns > entry_b->exclusive_ns ? -1 : 1;
+    if (entry_a->calls != entry_b->calls)
+        return entry_a->calls > entry_b->calls ? -1 : 1;
+    return 0;
+}
+
+GArray *
+dissector_profile_get_entries(void)
+{
+    GArray *entries;
+
+    entries = g_array_new(FALSE, FALSE, sizeof (dissector_profile_entry_t));
+    if (profile_entries != NULL) {
+        g_hash_table_foreach(profile_entries, add_entry, entries);
+        g_array_sort(entries, compare_entries);
+    }
+    return entries;
+}
+
+void
+dissector_profile_enter(const void *key, int proto_id,
+    const char *heur_short_name, packet_info *pinfo)
+{
+    profile_entry_t *entry;
+    profile_frame_t  frame;
+
+    entry = (profile_entry_t *)g_hash_table_lookup(profile_entries, key);
+    if (entry == NULL) {
+        entry = g_new0(profile_entry_t, 1);
+        entry->counts.proto_id = proto_id;
+        entry->counts.heur_short_name = heur_short_name;
+        g_hash_table_insert(profile_entries, (gpointer)key, entry);
+    }
+    entry->counts.calls++;
+    entry->active++;
+
+    frame.entry = entry;
+    frame.child_ns = 0;
+    frame.child_bytes = 0;
+    frame.start_bytes = wmem_bytes_allocated(pinfo->pool);
+    frame.start_ns = ws_clock_get_monotonic_ns();
+    g_array_append_val(profile_stack, frame);
+}
+
+void
+dissector_profile_leave(packet_info *pinfo, gboolean accepted)
+{
+    guint64          now_ns = ws_clock_get_monotonic_ns();
+    profile_frame_t *frame, *parent;
+    profile_entry_t *entry;
+    guint64          elapsed_ns, allocated;
+
+    if (profile_stack->len == 0)
+        return;
+    frame = &g_array_index(profile_stack, profile_frame_t, profile_stack->len - 1);
+    entry = frame->entry;
+    elapsed_ns = now_ns - frame->start_ns;
+    allocated = wmem_bytes_allocated(pinfo->pool) - frame->start_bytes;
+
+    /*
+     * If a protocol's dissectors end up calling one another, count
+     * the time once, for the outermost call.
+     */
+    entry->active--;
+    if (entry->active == 0)
+        entry->counts.inclusive_ns += elapsed_ns;
+    entry->counts.exclusive_ns += elapsed_ns - frame->child_ns;
+    entry->counts.bytes_allocated += allocated - frame->child_bytes;
+    if (accepted)
+        entry->counts.accepted++;
+
+    g_array_set_size(profile_stack, profile_stack->len - 1);
+    if (profile_stack->len != 0) {
+        parent = &g_array_index(profile_stack, profile_frame_t, profile_stack->len - 1);
+        parent->child_ns += elapsed_ns;
+        parent->child_bytes += allocated;
+    }
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
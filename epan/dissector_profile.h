@@ -0,0 +1,80 @@
+/** @file
+ * Declarations of routines for profiling dissectors: how often each
+ * protocol's dissectors are called, how long they take, and how much
+ * packet-scope memory they allocate.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __DISSECTOR_PROFILE_H__
+#define __DISSECTOR_PROFILE_H__
+
+#include "ws_symbol_export.h"
+#include <epan/packet_info.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** What's been counted for a protocol's dissectors, or for one heuristic
+ * dissector. */
+typedef struct {
+    int         proto_id;           /**< The protocol */
+    const char *heur_short_name;    /**< The heuristic dissector's short name, or NULL for the protocol's other dissectors */
+    guint64     calls;              /**< Times it was called */
+    guint64     accepted;           /**< Times it took the packet */
+    guint64     inclusive_ns;       /**< Time spent in it, including the dissectors it called, in nanoseconds */
+    guint64     exclusive_ns;       /**< Time spent in it, not including the dissectors it called, in nanoseconds */
+    guint64     bytes_allocated;    /**< Bytes it, not the dissectors it called, allocated from pinfo->pool */
+} dissector_profile_entry_t;
+
+/** Turn dissector profiling on or off.  It's off by default, and costs
+ * nothing then; when it's on, timing each call slows dissection
+ * somewhat.  This mustn't be called in the middle of dissecting a packet.
+ *
+ * @param enable TRUE to turn it on, FALSE to turn it off.
+ */
+WS_DLL_PUBLIC void dissector_profile_set_enabled(gboolean enable);
+
+/** Is dissector profiling on?
+ *
+ * @return TRUE if it's on.
+ */
+WS_DLL_PUBLIC gboolean dissector_profile_is_enabled(void);
+
+/** Zero what's been counted so far.  This mustn't be called in the middle
+ * of dissecting a packet.
+ */
+WS_DLL_PUBLIC void dissector_profile_reset(void);
+
+/** Get what's been counted so far, for everything that has been called,
+ * sorted by exclusive time, most first.
+ *
+ * @return A GArray of dissector_profile_entry_t, to be freed with
+ * g_array_free(entries, TRUE).
+ */
+WS_DLL_PUBLIC GArray *dissector_profile_get_entries(void);
+
+/*
+ * For packet.c: set if profiling is on, and calls to note when a
+ * dissector, or heuristic dissector, is entered and left.  The key
+ * is the protocol_t for dissectors, and the heur_dtbl_entry_t for
+ * heuristic dissectors; each dissector_profile_enter() must be matched
+ * by a dissector_profile_leave(), even if the dissector throws an
+ * exception.
+ */
+extern gboolean dissector_profiling;
+
+extern void dissector_profile_enter(const void *key, int proto_id,
+    const char *heur_short_name, packet_info *pinfo);
+extern void dissector_profile_leave(packet_info *pinfo, gboolean accepted);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __DISSECTOR_PROFILE_H__ */
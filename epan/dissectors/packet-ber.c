@@ -207,6 +207,35 @@ static int      last_length_offset;
 static int      last_length_len;
 static gboolean last_ind;
 
+/* Indefinite lengths resolved so far in the current packet.  Finding
+ * one means walking everything up to its EOC, including any nested
+ * indefinite lengths, and dissecting each level resolves its own
+ * length again, so without this nested indefinite lengths take time
+ * proportional to their depth times their size. */
+typedef struct {
+    tvbuff_t *tvb;
+    int       offset;
+} ber_indef_key_t;
+
+static wmem_map_t *ber_indef_lengths = NULL;
+
+static guint
+ber_indef_key_hash(gconstpointer k)
+{
+    const ber_indef_key_t *key = (const ber_indef_key_t *)k;
+
+    return g_direct_hash(key->tvb) ^ g_int_hash(&key->offset);
+}
+
+static gboolean
+ber_indef_key_equal(gconstpointer a, gconstpointer b)
+{
+    const ber_indef_key_t *ka = (const ber_indef_key_t *)a;
+    const ber_indef_key_t *kb = (const ber_indef_key_t *)b;
+
+    return ka->tvb == kb->tvb && ka->offset == kb->offset;
+}
+
 static const value_string ber_class_codes[] = {
     { BER_CLASS_UNI,    "UNIVERSAL" },
     { BER_CLASS_APP,    "APPLICATION" },
@@ -1311,6 +1340,25 @@ try_get_ber_length(tvbuff_t *tvb, int offset, guint32 *length, gboolean *ind, gi
             }
         } else {
             /* 8.1.3.6 */
+            ber_indef_key_t key;
+            gpointer cached = NULL;
+            /* The cache lives in packet scope; we may be called outside it. */
+            gboolean use_cache = wmem_in_scope(wmem_packet_scope());
+
+            key.tvb = tvb;
+            key.offset = offset;
+            if (use_cache)
+                cached = wmem_map_lookup(ber_indef_lengths, &key);
+            /* The EOC check guards against a tvb freed during this
+             * packet and another one allocated at the same address. */
+            if (cached && tvb_bytes_exist(tvb, offset + GPOINTER_TO_UINT(cached) - 2, 2) &&
+                tvb_get_ntohs(tvb, offset + GPOINTER_TO_UINT(cached) - 2) == 0) {
+                if (length)
+                    *length = GPOINTER_TO_UINT(cached);
+                if (ind)
+                    *ind = TRUE;
+                return offset;
+            }
 
             tmp_offset = offset;
             /* ok in here we can traverse the BER to find the length, this will fix most indefinite length issues */
@@ -1330,6 +1378,13 @@ try_get_ber_length(tvbuff_t *tvb, int offset, guint32 *length, gboolean *ind, gi
             tmp_length += 2;
             tmp_ind = TRUE;
             offset = tmp_offset;
+
+            if (use_cache && tmp_length <= (guint32)G_MAXINT32) {
+                ber_indef_key_t *new_key = wmem_new(wmem_packet_scope(), ber_indef_key_t);
+
+                *new_key = key;
+                wmem_map_insert(ber_indef_lengths, new_key, GUINT_TO_POINTER(tmp_length));
+            }
         }
     }
 
@@ -4566,6 +4621,7 @@ proto_register_ber(void)
     ber_oid_dissector_table = register_dissector_table("ber.oid", "BER OID", proto_ber, FT_STRING, BASE_NONE);
     ber_syntax_dissector_table = register_dissector_table("ber.syntax", "BER syntax", proto_ber, FT_STRING, BASE_NONE);
     syntax_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free); /* oid to syntax */
+    ber_indef_lengths = wmem_map_new_autoreset(wmem_epan_scope(), wmem_packet_scope(), ber_indef_key_hash, ber_indef_key_equal);
 
     register_ber_syntax_dissector("ASN.1", proto_ber, dissect_ber_syntax);
 
@@ -120,8 +120,14 @@ typedef struct _diam_vnd_t {
 	guint32  code;
 	wmem_array_t *vs_avps;
 	value_string_ext *vs_avps_ext;
+	/* the vendor's AVPs with codes below DIAM_AVP_DIRECT_MAX, indexed
+	   by code; AVPs with higher codes are only in dictionary.avps */
+	diam_avp_t **avps;
+	guint32 avps_len;
 } diam_vnd_t;
 
+#define DIAM_AVP_DIRECT_MAX 65536
+
 struct _diam_avp_t {
 	guint32 code;
 	diam_vnd_t *vendor;
@@ -183,8 +189,8 @@ typedef struct _proto_avp_t {
 
 static const char *simple_avp(diam_ctx_t *, diam_avp_t *, tvbuff_t *, diam_sub_dis_t *);
 
-static diam_vnd_t unknown_vendor = { 0xffffffff, NULL, NULL };
-static diam_vnd_t no_vnd = { 0, NULL, NULL };
+static diam_vnd_t unknown_vendor = { 0xffffffff, NULL, NULL, NULL, 0 };
+static diam_vnd_t no_vnd = { 0, NULL, NULL, NULL, 0 };
 static diam_avp_t unknown_avp = {0, &unknown_vendor, simple_avp, -1, -1, NULL };
 static const value_string *cmd_vs;
 static diam_dictionary_t dictionary = { NULL, NULL, NULL, NULL };
@@ -791,7 +797,6 @@ dissect_diameter_avp(diam_ctx_t *c, tvbuff_t *tvb, int offset, diam_sub_dis_t *d
 	guint32 flags_bits_idx = (len & 0xE0000000) >> 29;
 	guint32 flags_bits     = (len & 0xFF000000) >> 24;
 	guint32 vendorid       = vendor_flag ? tvb_get_ntohl(tvb,offset+8) : 0 ;
-	wmem_tree_key_t k[3];
 	diam_avp_t *a;
 	proto_item *pi, *avp_item;
 	proto_tree *avp_tree, *save_tree;
@@ -801,16 +806,31 @@ dissect_diameter_avp(diam_ctx_t *c, tvbuff_t *tvb, int offset, diam_sub_dis_t *d
 	const char *avp_str = NULL;
 	guint8 pad_len;
 
-	k[0].length = 1;
-	k[0].key = &code;
+	if (vendorid == 0) {
+		vendor = &no_vnd;
+	} else {
+		vendor = (diam_vnd_t *)wmem_tree_lookup32(dictionary.vnds,vendorid);
+		if (!vendor && vendorid == unknown_vendor.code)
+			vendor = &unknown_vendor;
+	}
+
+	a = NULL;
+	if (vendor && code < vendor->avps_len) {
+		a = vendor->avps[code];
+	} else if (vendor && code >= DIAM_AVP_DIRECT_MAX) {
+		wmem_tree_key_t k[3];
 
-	k[1].length = 1;
-	k[1].key = &vendorid;
+		k[0].length = 1;
+		k[0].key = &code;
 
-	k[2].length = 0;
-	k[2].key = NULL;
+		k[1].length = 1;
+		k[1].key = &vendorid;
 
-	a = (diam_avp_t *)wmem_tree_lookup32_array(dictionary.avps,k);
+		k[2].length = 0;
+		k[2].key = NULL;
+
+		a = (diam_avp_t *)wmem_tree_lookup32_array(dictionary.avps,k);
+	}
 
 	len &= 0x00ffffff;
 	pad_len =  (len % 4) ? 4 - (len % 4) : 0 ;
@@ -818,12 +838,8 @@ dissect_diameter_avp(diam_ctx_t *c, tvbuff_t *tvb, int offset, diam_sub_dis_t *d
 	if (!a) {
 		a = &unknown_avp;
 
-		if (vendor_flag) {
-			if (! (vendor = (diam_vnd_t *)wmem_tree_lookup32(dictionary.vnds,vendorid) ))
-				vendor = &unknown_vendor;
-		} else {
-			vendor = &no_vnd;
-		}
+		if (!vendor)
+			vendor = &unknown_vendor;
 	} else {
 		vendor = (diam_vnd_t *)a->vendor;
 	}
@@ -1395,10 +1411,6 @@ dissect_diameter_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, voi
 	diam_sub_dis_inf->subscription_id_type = SUBSCRIPTION_ID_TYPE_UNKNOWN;
 	diam_sub_dis_inf->user_equipment_info_type = USER_EQUIPMENT_INFO_TYPE_UNKNOWN;
 
-	/* Load header fields if not already done */
-	if (hf_diameter_code == -1)
-		proto_registrar_get_byname("diameter.code");
-
 	col_set_str(pinfo->cinfo, COL_PROTOCOL, "DIAMETER");
 
 	if (have_tap_listener(exported_pdu_tap)){
@@ -1696,10 +1708,6 @@ dissect_diameter_avps(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void
 	diam_ctx_t *c = wmem_new0(wmem_packet_scope(), diam_ctx_t);
 	diam_sub_dis_t *diam_sub_dis_inf = wmem_new0(wmem_packet_scope(), diam_sub_dis_t);
 
-	/* Load header fields if not already done */
-	if (hf_diameter_code == -1)
-		proto_registrar_get_byname("diameter.code");
-
 	col_set_str(pinfo->cinfo, COL_PROTOCOL, "DIAMETER");
 	col_set_str(pinfo->cinfo, COL_INFO, "AVPs:");
 
@@ -2180,6 +2188,8 @@ dictionary_load(void)
 			wmem_array_set_null_terminator(vnd->vs_avps);
 			wmem_array_bzero(vnd->vs_avps);
 			vnd->vs_avps_ext = NULL;
+			vnd->avps = NULL;
+			vnd->avps_len = 0;
 			wmem_tree_insert32(dictionary.vnds,vnd->code,vnd);
 			g_hash_table_insert(vendors,v->name,vnd);
 		}
@@ -2276,7 +2286,18 @@ dictionary_load(void)
 		if (avp != NULL) {
 			g_hash_table_insert(build_dict.avps, a->name, avp);
 
-			{
+			if (a->code < DIAM_AVP_DIRECT_MAX) {
+				if (a->code >= vnd->avps_len) {
+					guint32 new_len = MAX(vnd->avps_len, 64);
+
+					while (new_len <= a->code)
+						new_len *= 2;
+					vnd->avps = (diam_avp_t **)wmem_realloc(wmem_epan_scope(), vnd->avps, new_len * sizeof(diam_avp_t *));
+					memset(vnd->avps + vnd->avps_len, 0, (new_len - vnd->avps_len) * sizeof(diam_avp_t *));
+					vnd->avps_len = new_len;
+				}
+				vnd->avps[a->code] = avp;
+			} else {
 				wmem_tree_key_t k[3];
 
 				k[0].length = 1;
@@ -2515,7 +2536,7 @@ real_register_diameter_fields(void)
 }
 
 static void
-register_diameter_fields(const char *unused _U_)
+register_diameter_fields(void)
 {
 	/*
 	 * The hf_base[] array for Diameter refers to a variable
@@ -2544,8 +2565,9 @@ proto_register_diameter(void)
 	/* Diameter AVPs without Diameter header, for EAP-TTLS (RFC 5281, Section 10) */
 	register_dissector("diameter_avps", dissect_diameter_avps, proto_diameter);
 
-	/* Delay registration of Diameter fields */
-	proto_register_prefix("diameter", register_diameter_fields);
+	/* Delay loading the dictionary and registering the Diameter fields
+	 * until Diameter is first dissected or filtered on */
+	proto_register_deferred_init(proto_diameter, register_diameter_fields);
 
 	/* Register dissector table(s) to do sub dissection of AVPs (OctetStrings) */
 	diameter_dissector_table = register_dissector_table("diameter.base", "Diameter Base AVP", proto_diameter, FT_UINT32, BASE_DEC);
@@ -403,6 +403,7 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 	guint32      interface_queue;
 	guint64      drop_count;
 	guint64      packetid;
+	nstime_t     shift_offset;
 	proto_tree  *volatile tree;
 	proto_tree  *comments_tree;
 	proto_tree  *volatile fh_tree = NULL;
@@ -839,8 +840,9 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 								  " the valid range is 0-1000000000",
 								  (long) pinfo->abs_ts.nsecs);
 			}
+			frame_data_get_shift_offset(pinfo->fd, &shift_offset);
 			item = proto_tree_add_time(fh_tree, hf_frame_shift_offset, tvb,
-					    0, 0, &(pinfo->fd->shift_offset));
+					    0, 0, &shift_offset);
 			proto_item_set_generated(item);
 
 			if (generate_epoch_time) {
@@ -1230,10 +1232,10 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 	/* Attempt to (re-)calculate color filters (if any). */
 	if (pinfo->fd->need_colorize) {
 		color_filter = color_filters_colorize_packet(fr_data->color_edt);
-		pinfo->fd->color_filter = color_filter;
+		pinfo->fd->color_index = color_filters_get_index(color_filter);
 		pinfo->fd->need_colorize = 0;
 	} else {
-		color_filter = pinfo->fd->color_filter;
+		color_filter = color_filters_get_by_index(pinfo->fd->color_index);
 	}
 	if (color_filter) {
 		ensure_tree_item(fh_tree, 1);
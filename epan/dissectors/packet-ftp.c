@@ -1864,6 +1864,8 @@ proto_register_ftp(void)
                              10,
                              &pref_export_maxsize);
     ftp_eo_tap = register_export_object(proto_ftp_data, ftp_eo_packet, ftp_eo_cleanup);
+    /* Data from later packets is appended to entries that have already been added */
+    set_eo_entries_updated(proto_ftp_data);
 }
 
 void
@@ -10241,30 +10241,6 @@ dissect_gtp_common(tvbuff_t * tvb, packet_info * pinfo, proto_tree * tree)
         args->ip_list = wmem_list_new(wmem_packet_scope());
     }
 
-    /*
-    * Do we have a conversation for this connection?
-    */
-    conversation = find_or_create_conversation(pinfo);
-
-    /*
-    * Do we already know this conversation?
-    */
-    gtp_info = (gtp_conv_info_t *)conversation_get_proto_data(conversation, proto_gtp);
-    if (gtp_info == NULL) {
-        /* No.  Attach that information to the conversation, and add
-        * it to the list of information structures.
-        */
-        gtp_info = wmem_new(wmem_file_scope(), gtp_conv_info_t);
-        /*Request/response matching tables*/
-        gtp_info->matched = g_hash_table_new(gtp_sn_hash, gtp_sn_equal_matched);
-        gtp_info->unmatched = g_hash_table_new(gtp_sn_hash, gtp_sn_equal_unmatched);
-
-        conversation_add_proto_data(conversation, proto_gtp, gtp_info);
-
-        gtp_info->next = gtp_info_items;
-        gtp_info_items = gtp_info;
-    }
-
     gtp_hdr->flags = tvb_get_guint8(tvb, offset);
 
     if (!(gtp_hdr->flags & 0x10)){
@@ -10729,6 +10705,34 @@ dissect_gtp_common(tvbuff_t * tvb, packet_info * pinfo, proto_tree * tree)
             if (args) {
                 cause_aux = args->last_cause;
             }
+
+            /*
+            * Do we have a conversation for this connection?
+            * It's only needed to match requests and responses, so
+            * T-PDUs, which are nearly all of the GTP-U traffic, don't
+            * set one up.
+            */
+            conversation = find_or_create_conversation(pinfo);
+
+            /*
+            * Do we already know this conversation?
+            */
+            gtp_info = (gtp_conv_info_t *)conversation_get_proto_data(conversation, proto_gtp);
+            if (gtp_info == NULL) {
+                /* No.  Attach that information to the conversation, and add
+                * it to the list of information structures.
+                */
+                gtp_info = wmem_new(wmem_file_scope(), gtp_conv_info_t);
+                /*Request/response matching tables*/
+                gtp_info->matched = g_hash_table_new(gtp_sn_hash, gtp_sn_equal_matched);
+                gtp_info->unmatched = g_hash_table_new(gtp_sn_hash, gtp_sn_equal_unmatched);
+
+                conversation_add_proto_data(conversation, proto_gtp, gtp_info);
+
+                gtp_info->next = gtp_info_items;
+                gtp_info_items = gtp_info;
+            }
+
             gcrp = gtp_match_response(tvb, pinfo, gtp_tree, seq_no, gtp_hdr->message, gtp_info, cause_aux);
             /*pass packet to tap for response time reporting*/
             if (gcrp) {
@@ -1114,6 +1114,24 @@ push_res(http_conv_t *conv_data, packet_info *pinfo)
  */
 static http_info_value_t	*stat_info;
 
+/* The fields that tie requests and responses together. */
+static int * const req_res_fields[] = {
+	&hf_http_notification,
+	&hf_http_response,
+	&hf_http_request,
+	&hf_http_response_number,
+	&hf_http_request_number,
+	&hf_http_time,
+	&hf_http_request_in,
+	&hf_http_response_in,
+	&hf_http_prev_request_in,
+	&hf_http_prev_response_in,
+	&hf_http_next_request_in,
+	&hf_http_next_response_in,
+	&hf_http_response_for_uri,
+	NULL
+};
+
 static int
 dissect_http_message(tvbuff_t *tvb, int offset, packet_info *pinfo,
 		     proto_tree *tree, http_conv_t *conv_data,
@@ -1562,7 +1580,7 @@ dissect_http_message(tvbuff_t *tvb, int offset, packet_info *pinfo,
 		}
 	}
 
-	if (tree) {
+	if (proto_fields_are_wanted(tree, req_res_fields)) {
 		proto_item *pi;
 		http_req_res_t *prev = curr ? curr->prev : NULL;
 		http_req_res_t *next = curr ? curr->next : NULL;
@@ -270,6 +270,10 @@ typedef struct {
     http2_header_repr_info_t header_repr_info[2];
     wmem_map_t *per_stream_info;
     gboolean    fix_dynamic_table[2];
+    /* decompressed header blocks seen so far in this session, so that
+       frames carrying an identical block share one array of
+       http2_header_t */
+    wmem_map_t *header_block_cache;
 #endif
     guint32 current_stream_id;
     tcp_flow_t *fwd_flow;
@@ -1330,6 +1334,24 @@ get_stream_info(http2_session_t *http2_session)
 
     return stream_info;
 }
+
+static guint http2_header_block_hash(gconstpointer key)
+{
+    wmem_array_t *headers = (wmem_array_t *)key;
+
+    return wmem_strong_hash((const guint8 *)wmem_array_get_raw(headers),
+                            wmem_array_get_count(headers) * sizeof(http2_header_t));
+}
+
+static gboolean http2_header_block_equal(gconstpointer lhs, gconstpointer rhs)
+{
+    wmem_array_t *a = (wmem_array_t *)lhs;
+    wmem_array_t *b = (wmem_array_t *)rhs;
+    guint count = wmem_array_get_count(a);
+
+    return count == wmem_array_get_count(b) &&
+           memcmp(wmem_array_get_raw(a), wmem_array_get_raw(b), count * sizeof(http2_header_t)) == 0;
+}
 #endif
 
 static http2_session_t*
@@ -1358,6 +1380,9 @@ get_http2_session(packet_info *pinfo, conversation_t* conversation)
         h2session->per_stream_info = wmem_map_new(wmem_file_scope(),
                                                   g_direct_hash,
                                                   g_direct_equal);
+        h2session->header_block_cache = wmem_map_new(wmem_file_scope(),
+                                                     http2_header_block_hash,
+                                                     http2_header_block_equal);
         /* Unless found otherwise, assume that some earlier Header Block
          * Fragments were missing and that recovery should be attempted. */
         h2session->fix_dynamic_table[0] = TRUE;
@@ -1632,15 +1657,16 @@ process_http2_header_repr_info(wmem_array_t *headers,
 
         if(header_repr_info->complete) {
             if(header_repr_info->type == HTTP2_HD_HEADER_TABLE_SIZE_UPDATE) {
-                http2_header_t *out;
-
-                out = wmem_new(wmem_file_scope(), http2_header_t);
+                http2_header_t out;
 
-                out->type = header_repr_info->type;
-                out->length = i - start;
-                out->table.header_table_size = header_repr_info->integer;
+                /* Zero the unused part of the union, so that header
+                   blocks can be compared byte by byte. */
+                memset(&out, 0, sizeof(out));
+                out.type = header_repr_info->type;
+                out.length = i - start;
+                out.table.header_table_size = header_repr_info->integer;
 
-                wmem_array_append(headers, out, 1);
+                wmem_array_append_one(headers, out);
 
                 reset_http2_header_repr_info(header_repr_info);
                 /* continue to decode header table size update or
@@ -1997,7 +2023,7 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
                 char *cached_pstr;
                 guint32 len;
                 guint datalen = (guint)(4 + nv.namelen + 4 + nv.valuelen);
-                http2_header_t *out;
+                http2_header_t out;
 
                 if (decompressed_bytes + datalen >= MAX_HTTP2_HEADER_SIZE) {
                     header_data->header_size_reached = decompressed_bytes;
@@ -2005,13 +2031,12 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
                     break;
                 }
 
-                out = wmem_new(wmem_file_scope(), http2_header_t);
+                memset(&out, 0, sizeof(out));
+                out.type = header_repr_info->type;
+                out.length = rv;
+                out.table.data.idx = header_repr_info->integer;
 
-                out->type = header_repr_info->type;
-                out->length = rv;
-                out->table.data.idx = header_repr_info->integer;
-
-                out->table.data.datalen = datalen;
+                out.table.data.datalen = datalen;
                 decompressed_bytes += datalen;
 
                 /* Prepare buffer... with the following format
@@ -2020,7 +2045,7 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
                    value length (uint32)
                    value (string)
                 */
-                http2_header_pstr = (char *)wmem_realloc(wmem_file_scope(), http2_header_pstr, out->table.data.datalen);
+                http2_header_pstr = (char *)wmem_realloc(wmem_file_scope(), http2_header_pstr, out.table.data.datalen);
 
                 /* nv.namelen and nv.valuelen are of size_t.  In order
                    to get length in 4 bytes, we have to copy it to
@@ -2035,14 +2060,14 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
 
                 cached_pstr = (char *)wmem_map_lookup(http2_hdrcache_map, http2_header_pstr);
                 if (cached_pstr) {
-                    out->table.data.data = cached_pstr;
+                    out.table.data.data = cached_pstr;
                 } else {
                     wmem_map_insert(http2_hdrcache_map, http2_header_pstr, http2_header_pstr);
-                    out->table.data.data = http2_header_pstr;
+                    out.table.data.data = http2_header_pstr;
                     http2_header_pstr = NULL;
                 }
 
-                wmem_array_append(headers, out, 1);
+                wmem_array_append_one(headers, out);
 
                 reset_http2_header_repr_info(header_repr_info);
             }
@@ -2056,6 +2081,21 @@ inflate_http2_header_block(tvbuff_t *tvb, packet_info *pinfo, guint offset, prot
             }
         }
 
+        /* Since header fields are interned in http2_hdrcache_map, a
+           block that decompresses and was encoded the same way as an
+           earlier one in this session (e.g. the same request sent
+           again, using the same dynamic table entries) has the same
+           bytes, and the earlier copy can be shared. */
+        if (wmem_array_get_count(headers) > 0) {
+            wmem_array_t *cached_headers = (wmem_array_t *)wmem_map_lookup(h2session->header_block_cache, headers);
+            if (cached_headers) {
+                wmem_destroy_array(headers);
+                headers = cached_headers;
+            } else {
+                wmem_map_insert(h2session->header_block_cache, headers, headers);
+            }
+        }
+
         wmem_list_append(header_list, headers);
 
         if(!header_data->current) {
@@ -37,6 +37,7 @@
 #include <epan/decode_as.h>
 #include <epan/proto_data.h>
 #include <epan/exported_pdu.h>
+#include <epan/tvb_view.h>
 
 #include <wiretap/erf_record.h>
 #include <wsutil/str_util.h>
@@ -314,8 +315,8 @@ const value_string ip_version_vals[] = {
 #define IPH_TOS                 1
 #define IPH_LEN                 2
 #define IPH_ID                  4
-#define IPH_TTL                 6
-#define IPH_OFF                 8
+#define IPH_OFF                 6
+#define IPH_TTL                 8
 #define IPH_P                   9
 #define IPH_SUM                 10
 #define IPH_SRC                 12
@@ -664,8 +665,14 @@ static void
 add_geoip_info(proto_tree *tree, packet_info *pinfo, tvbuff_t *tvb, gint offset, guint32 src32,
                guint32 dst32)
 {
-  add_geoip_info_entry(tree, pinfo, tvb, offset, g_htonl(src32), FALSE);
-  add_geoip_info_entry(tree, pinfo, tvb, offset, g_htonl(dst32), TRUE);
+  ws_in4_addr src = g_htonl(src32);
+  ws_in4_addr dst = g_htonl(dst32);
+
+  /* Let both addresses be resolved at once. */
+  maxmind_db_prefetch_ipv4(&src);
+  maxmind_db_prefetch_ipv4(&dst);
+  add_geoip_info_entry(tree, pinfo, tvb, offset, src, FALSE);
+  add_geoip_info_entry(tree, pinfo, tvb, offset, dst, TRUE);
 }
 
 const value_string ipopt_type_class_vals[] = {
@@ -1864,6 +1871,7 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
   proto_tree *tree;
   proto_item *item = NULL, *ttl_item;
   guint16 ttl_valid;
+  tvb_view_t hdr;
 
   tree = parent_tree;
   iph = wmem_new0(pinfo->pool, ws_ip4);
@@ -1871,9 +1879,12 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
   col_set_str(pinfo->cinfo, COL_PROTOCOL, "IPv4");
   col_clear(pinfo->cinfo, COL_INFO);
 
-  iph->ip_ver = tvb_get_bits8(tvb, 0, 4);
+  /* Check once that the fixed-length header is there. */
+  tvb_view_init(&hdr, tvb, offset, IPH_MIN_LEN);
 
-  hlen = tvb_get_bits8(tvb, 4, 4) * 4;  /* IP header length, in bytes */
+  iph->ip_ver = tvb_view_get_guint8(&hdr, IPH_V_HL) >> 4;
+
+  hlen = (tvb_view_get_guint8(&hdr, IPH_V_HL) & 0x0f) * 4;  /* IP header length, in bytes */
 
   ti = proto_tree_add_item(tree, proto_ip, tvb, offset, hlen, ENC_NA);
   ip_tree = proto_item_add_subtree(ti, ett_ip);
@@ -1917,7 +1928,7 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
   proto_tree_add_uint_bits_format_value(ip_tree, hf_ip_hdr_len, tvb, (offset<<3)+4, 4, hlen,
                                ENC_BIG_ENDIAN, "%u bytes (%u)", hlen, hlen>>2);
 
-  iph->ip_tos = tvb_get_guint8(tvb, offset + 1);
+  iph->ip_tos = tvb_view_get_guint8(&hdr, IPH_TOS);
   if (g_ip_dscp_actif) {
     col_add_str(pinfo->cinfo, COL_DSCP_VALUE,
                 val_to_str_ext(IPDSFIELD_DSCP(iph->ip_tos), &dscp_short_vals_ext, "%u"));
@@ -1956,7 +1967,7 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
      inside an ICMP datagram; we need to somehow let the
      dissector we call know that, as it might want to avoid
      doing its checksumming. */
-  iph->ip_len = tvb_get_ntohs(tvb, offset + 2);
+  iph->ip_len = tvb_view_get_ntohs(&hdr, IPH_LEN);
 
   if (iph->ip_len < hlen) {
     if (ip_tso_supported && !iph->ip_len) {
@@ -2010,11 +2021,11 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
   /* Only export after adjusting the length */
   export_pdu(tvb, pinfo);
 
-  iph->ip_id  = tvb_get_ntohs(tvb, offset + 4);
+  iph->ip_id  = tvb_view_get_ntohs(&hdr, IPH_ID);
   if (tree)
     proto_tree_add_uint(ip_tree, hf_ip_id, tvb, offset + 4, 2, iph->ip_id);
 
-  iph->ip_off = tvb_get_ntohs(tvb, offset + 6);
+  iph->ip_off = tvb_view_get_ntohs(&hdr, IPH_OFF);
 
   if (ip_security_flag) {
     /* RFC 3514 - The Security Flag in the IPv4 Header (April Fool's joke) */
@@ -2044,15 +2055,15 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
   tf = proto_tree_add_uint_format_value(ip_tree, hf_ip_frag_offset, tvb, offset + 6, 2,
                                         iph->ip_off, "%u", (iph->ip_off & IP_OFFSET) * 8);
 
-  iph->ip_ttl = tvb_get_guint8(tvb, offset + 8);
+  iph->ip_ttl = tvb_view_get_guint8(&hdr, IPH_TTL);
   ttl_item = proto_tree_add_item(ip_tree, hf_ip_ttl, tvb, offset + 8, 1, ENC_BIG_ENDIAN);
 
-  iph->ip_proto = tvb_get_guint8(tvb, offset + 9);
+  iph->ip_proto = tvb_view_get_guint8(&hdr, IPH_P);
   if (tree) {
     proto_tree_add_item(ip_tree, hf_ip_proto, tvb, offset + 9, 1, ENC_BIG_ENDIAN);
   }
 
-  iph->ip_sum = tvb_get_ntohs(tvb, offset + 10);
+  iph->ip_sum = tvb_view_get_ntohs(&hdr, IPH_SUM);
 
   /*
    * If checksum checking is enabled, and we have the entire IP header
@@ -2114,7 +2125,7 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
                                     offset + 10, 0, PROTO_CHECKSUM_E_UNVERIFIED);
     proto_item_set_generated(item);
   }
-  src32 = tvb_get_ntohl(tvb, offset + IPH_SRC);
+  src32 = tvb_view_get_ntohl(&hdr, IPH_SRC);
   set_address_tvb(&pinfo->net_src, AT_IPv4, 4, tvb, offset + IPH_SRC);
   copy_address_shallow(&pinfo->src, &pinfo->net_src);
   copy_address_shallow(&iph->ip_src, &pinfo->src);
@@ -2155,7 +2166,10 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
   else
     dst_off = 0;
 
-  dst32 = tvb_get_ntohl(tvb, offset + IPH_DST + dst_off);
+  if (dst_off == 0)
+    dst32 = tvb_view_get_ntohl(&hdr, IPH_DST);
+  else
+    dst32 = tvb_get_ntohl(tvb, offset + IPH_DST + dst_off);
   set_address_tvb(&pinfo->net_dst, AT_IPv4, 4, tvb, offset + IPH_DST + dst_off);
   copy_address_shallow(&pinfo->dst, &pinfo->net_dst);
   copy_address_shallow(&iph->ip_dst, &pinfo->net_dst);
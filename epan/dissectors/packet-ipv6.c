@@ -1027,6 +1027,9 @@ add_geoip_info_entry(proto_tree *tree, packet_info *pinfo, tvbuff_t *tvb, gint o
 static void
 add_geoip_info(proto_tree *tree, packet_info *pinfo, tvbuff_t *tvb, gint offset, const ws_in6_addr *src, const ws_in6_addr *dst)
 {
+    /* Let both addresses be resolved at once. */
+    maxmind_db_prefetch_ipv6(src);
+    maxmind_db_prefetch_ipv6(dst);
     add_geoip_info_entry(tree, pinfo, tvb, offset, src, FALSE);
     add_geoip_info_entry(tree, pinfo, tvb, offset, dst, TRUE);
 }
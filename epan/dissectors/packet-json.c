@@ -80,6 +80,8 @@ static gboolean hide_extended_path_based_filtering = FALSE;
 
 static gboolean unescape_strings = FALSE;
 
+static guint json_max_tree_depth = 0;
+
 static tvbparse_wanted_t* want;
 static tvbparse_wanted_t* want_ignore;
 
@@ -109,6 +111,11 @@ typedef struct {
 									Array -1: no key, -2: has key  */
 	wmem_stack_t* stack_path;
 	packet_info* pinfo;
+	/* Are the path based filtering fields going to be looked at? If not,
+	   the paths aren't built; they're only placeholders on stack_path. */
+	gboolean want_paths;
+	/* nesting of objects and arrays */
+	guint depth;
 } json_parser_data_t;
 
 #define JSON_COMPACT_TOP_ITEM -3
@@ -465,6 +472,7 @@ dissect_json(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
 
 	/* Save pinfo*/
 	parser_data.pinfo = pinfo;
+	parser_data.depth = 0;
 	/* JSON dissector can be called in a JSON native file or when transported
 	 * by another protocol, will make entry in the Protocol column on summary display accordingly
 	 */
@@ -519,6 +527,9 @@ dissect_json(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
 	wmem_stack_push(parser_data.stack, json_tree);
 
 	// extended path based filtering
+	parser_data.want_paths = proto_field_is_wanted(json_tree, hf_json_path) ||
+		proto_field_is_wanted(json_tree, hf_json_path_with_value) ||
+		proto_field_is_wanted(json_tree, hf_json_member_with_value);
 	parser_data.stack_path = wmem_stack_new(pinfo->pool);
 	wmem_stack_push(parser_data.stack_path, "");
 	wmem_stack_push(parser_data.stack_path, "");
@@ -597,6 +608,9 @@ before_object(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t
 	ti = proto_tree_add_item(tree, hf_json_object, tok->tvb, tok->offset, tok->len, ENC_NA);
 
 	subtree = proto_item_add_subtree(ti, ett_json_object);
+	if (json_max_tree_depth && data->depth >= json_max_tree_depth)
+		subtree = NULL;
+	data->depth++;
 	wmem_stack_push(data->stack, subtree);
 
 	if (json_compact) {
@@ -624,6 +638,7 @@ after_object(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *
 	json_parser_data_t *data = (json_parser_data_t *) tvbparse_data;
 
 	wmem_stack_pop(data->stack);
+	data->depth--;
 
 	if (json_compact) {
 		proto_tree *tree_compact = (proto_tree *)wmem_stack_peek(data->stack_compact);
@@ -663,7 +678,7 @@ before_member(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t
 	wmem_stack_push(data->stack_path, base_path);
 	wmem_stack_push(data->stack_path, last_key_string);
 
-	char* path = join_strings(data->pinfo->pool, base_path, key_string_without_quotation_marks, '/');
+	char* path = data->want_paths ? join_strings(data->pinfo->pool, base_path, key_string_without_quotation_marks, '/') : "";
 	wmem_stack_push(data->stack_path, path);
 	/* stack won't write/free pointer. */
 	wmem_stack_push(data->stack_path, (void *)key_string_without_quotation_marks);
@@ -706,7 +721,7 @@ after_member(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *
 	// extended path based filtering
 	wmem_stack_pop(data->stack_path); // Pop key
 	char* path = (char*)wmem_stack_pop(data->stack_path);
-	if (tree)
+	if (tree && data->want_paths)
 	{
 		proto_item* path_item = proto_tree_add_string(tree, hf_json_path, tok->tvb, tok->offset, tok->len, path);
 		proto_item_set_generated(path_item);
@@ -733,6 +748,9 @@ before_array(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *
 	ti = proto_tree_add_item(tree, hf_json_array, tok->tvb, tok->offset, tok->len, ENC_NA);
 
 	subtree = proto_item_add_subtree(ti, ett_json_array);
+	if (json_max_tree_depth && data->depth >= json_max_tree_depth)
+		subtree = NULL;
+	data->depth++;
 	wmem_stack_push(data->stack, subtree);
 
 	// extended path based filtering
@@ -741,7 +759,7 @@ before_array(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *
 	wmem_stack_push(data->stack_path, base_path);
 	wmem_stack_push(data->stack_path, last_key_string);
 
-	char* path = join_strings(data->pinfo->pool, base_path, "[]", '/');
+	char* path = data->want_paths ? join_strings(data->pinfo->pool, base_path, "[]", '/') : "";
 
 	wmem_stack_push(data->stack_path, path);
 	wmem_stack_push(data->stack_path, "[]");
@@ -759,6 +777,7 @@ after_array(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *e
 	json_parser_data_t *data = (json_parser_data_t *) tvbparse_data;
 
 	wmem_stack_pop(data->stack);
+	data->depth--;
 
 	// extended path based filtering
 	wmem_stack_pop(data->stack_path); // Pop key
@@ -796,7 +815,11 @@ after_value(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *t
 	char* path = (char*)wmem_stack_pop(data->stack_path);
 
 	const char* value_str = NULL;
-	if (value_id == JSON_TOKEN_STRING && tok->len >= 2)
+	if (!tree && !data->want_paths)
+	{
+		/* Nothing will be added; skip converting the value */
+	}
+	else if (value_id == JSON_TOKEN_STRING && tok->len >= 2)
 	{
 		value_str = get_json_string(data->pinfo->pool, tok, TRUE);
 	}
@@ -805,18 +828,21 @@ after_value(void *tvbparse_data, const void *wanted_data _U_, tvbparse_elem_t *t
 		value_str = get_json_string(data->pinfo->pool, tok, FALSE);
 	}
 
-	char* path_with_value = join_strings(data->pinfo->pool, path, value_str, ':');
-	char* memeber_with_value = join_strings(data->pinfo->pool, key_string, value_str, ':');
-	proto_item* path_with_value_item = proto_tree_add_string(tree, hf_json_path_with_value, tok->tvb, tok->offset, tok->len, path_with_value);
-	proto_item* member_with_value_item = proto_tree_add_string(tree, hf_json_member_with_value, tok->tvb, tok->offset, tok->len, memeber_with_value);
+	if (data->want_paths)
+	{
+		char* path_with_value = join_strings(data->pinfo->pool, path, value_str, ':');
+		char* memeber_with_value = join_strings(data->pinfo->pool, key_string, value_str, ':');
+		proto_item* path_with_value_item = proto_tree_add_string(tree, hf_json_path_with_value, tok->tvb, tok->offset, tok->len, path_with_value);
+		proto_item* member_with_value_item = proto_tree_add_string(tree, hf_json_member_with_value, tok->tvb, tok->offset, tok->len, memeber_with_value);
 
-	proto_item_set_generated(path_with_value_item);
-	proto_item_set_generated(member_with_value_item);
+		proto_item_set_generated(path_with_value_item);
+		proto_item_set_generated(member_with_value_item);
 
-	if (hide_extended_path_based_filtering)
-	{
-		proto_item_set_hidden(path_with_value_item);
-		proto_item_set_hidden(member_with_value_item);
+		if (hide_extended_path_based_filtering)
+		{
+			proto_item_set_hidden(path_with_value_item);
+			proto_item_set_hidden(member_with_value_item);
+		}
 	}
 
 	wmem_stack_push(data->stack_path, path);
@@ -1197,6 +1223,12 @@ proto_register_json(void)
 		"Replace character escapes with the escaped literal value",
 		&unescape_strings);
 
+	prefs_register_uint_preference(json_module, "max_tree_depth",
+		"Maximum depth of the JSON tree",
+		"Objects and arrays nested more deeply than this are shown without their contents,"
+		" which can't then be filtered on either; 0 means no limit.",
+		10, &json_max_tree_depth);
+
 	/* Fill hash table with static headers */
 	register_static_headers();
 }
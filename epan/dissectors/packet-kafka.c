@@ -1593,6 +1593,115 @@ dissect_kafka_record(tvbuff_t *tvb, packet_info *pinfo _U_, proto_tree *tree, in
     return end_offset;
 }
 
+/*
+ * Decompressed batches are kept, keyed by the frame and the position of
+ * the compressed data in it, so that redissecting a frame (which the GUI
+ * does every time it is selected) doesn't decompress it all over again.
+ * The least recently used batches are dropped once the cache holds more
+ * than kafka_decompress_cache_size megabytes.
+ */
+typedef struct _kafka_decompressed_key_t {
+    guint32 frame;
+    guint32 offset;
+    guint32 length;
+    int     codec;
+} kafka_decompressed_key_t;
+
+typedef struct _kafka_decompressed_t {
+    kafka_decompressed_key_t key;
+    guint8 *compressed;     /* copy of the input, to check the key against */
+    guint8 *data;
+    guint   data_len;
+    GList   lru_link;
+} kafka_decompressed_t;
+
+static guint kafka_decompress_cache_size = 32;
+static GHashTable *kafka_decompress_cache;
+static GQueue kafka_decompress_lru = G_QUEUE_INIT;
+static gsize kafka_decompress_cache_bytes;
+
+static guint
+kafka_decompressed_hash(gconstpointer k)
+{
+    const kafka_decompressed_key_t *key = (const kafka_decompressed_key_t *)k;
+    return key->frame ^ (key->offset << 8) ^ (key->length << 16) ^ key->codec;
+}
+
+static gboolean
+kafka_decompressed_equal(gconstpointer k1, gconstpointer k2)
+{
+    return memcmp(k1, k2, sizeof(kafka_decompressed_key_t)) == 0;
+}
+
+static void
+kafka_decompressed_free(gpointer p)
+{
+    kafka_decompressed_t *entry = (kafka_decompressed_t *)p;
+
+    g_queue_unlink(&kafka_decompress_lru, &entry->lru_link);
+    kafka_decompress_cache_bytes -= entry->key.length + entry->data_len;
+    g_free(entry->compressed);
+    g_free(entry->data);
+    g_free(entry);
+}
+
+static void
+kafka_decompress_cache_add(const kafka_decompressed_key_t *key, const guint8 *compressed, GByteArray *decompressed)
+{
+    gsize bound = (gsize)kafka_decompress_cache_size << 20;
+    gsize entry_bytes = key->length + decompressed->len;
+
+    if (entry_bytes > bound) {
+        g_byte_array_free(decompressed, TRUE);
+        return;
+    }
+    if (!kafka_decompress_cache) {
+        kafka_decompress_cache = g_hash_table_new_full(kafka_decompressed_hash, kafka_decompressed_equal,
+                NULL, kafka_decompressed_free);
+    }
+    while (kafka_decompress_cache_bytes + entry_bytes > bound && kafka_decompress_lru.tail) {
+        kafka_decompressed_t *oldest = (kafka_decompressed_t *)kafka_decompress_lru.tail->data;
+        g_hash_table_remove(kafka_decompress_cache, &oldest->key);
+    }
+
+    kafka_decompressed_t *entry = g_new0(kafka_decompressed_t, 1);
+    entry->key = *key;
+    entry->compressed = (guint8 *)g_memdup2(compressed, key->length);
+    entry->data_len = decompressed->len;
+    entry->data = g_byte_array_free(decompressed, FALSE);
+    entry->lru_link.data = entry;
+    /* Replaces (and frees) any entry with the same key but other input. */
+    g_hash_table_replace(kafka_decompress_cache, &entry->key, entry);
+    g_queue_push_head_link(&kafka_decompress_lru, &entry->lru_link);
+    kafka_decompress_cache_bytes += entry_bytes;
+}
+
+static const kafka_decompressed_t *
+kafka_decompress_cache_lookup(const kafka_decompressed_key_t *key, const guint8 *compressed)
+{
+    kafka_decompressed_t *entry;
+
+    if (!kafka_decompress_cache) {
+        return NULL;
+    }
+    entry = (kafka_decompressed_t *)g_hash_table_lookup(kafka_decompress_cache, key);
+    if (!entry || memcmp(entry->compressed, compressed, key->length) != 0) {
+        return NULL;
+    }
+    g_queue_unlink(&kafka_decompress_lru, &entry->lru_link);
+    g_queue_push_head_link(&kafka_decompress_lru, &entry->lru_link);
+    return entry;
+}
+
+static void
+kafka_decompress_cache_clear(void)
+{
+    if (kafka_decompress_cache) {
+        g_hash_table_destroy(kafka_decompress_cache);
+        kafka_decompress_cache = NULL;
+    }
+}
+
 static gboolean
 decompress_none(tvbuff_t *tvb, packet_info *pinfo _U_, int offset, guint32 length _U_, tvbuff_t **decompressed_tvb, int *decompressed_offset)
 {
@@ -1601,12 +1710,19 @@ decompress_none(tvbuff_t *tvb, packet_info *pinfo _U_, int offset, guint32 lengt
     return TRUE;
 }
 
+/*
+ * The decompressors below append the decompressed data to out, so that a
+ * batch ends up in one contiguous buffer however many frames or chunks it
+ * was compressed in.
+ */
 static gboolean
-decompress_gzip(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, tvbuff_t **decompressed_tvb, int *decompressed_offset)
+decompress_gzip(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, GByteArray *out)
 {
-    *decompressed_tvb = tvb_child_uncompress(tvb, tvb, offset, length);
-    *decompressed_offset = 0;
-    if (*decompressed_tvb) {
+    tvbuff_t *uncompressed_tvb = tvb_uncompress(tvb, offset, length);
+    if (uncompressed_tvb) {
+        guint uncompressed_len = tvb_captured_length(uncompressed_tvb);
+        g_byte_array_append(out, tvb_get_ptr(uncompressed_tvb, 0, uncompressed_len), uncompressed_len);
+        tvb_free(uncompressed_tvb);
         return TRUE;
     } else {
         col_append_str(pinfo->cinfo, COL_INFO, " [gzip decompression failed] ");
@@ -1615,15 +1731,16 @@ decompress_gzip(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, t
 }
 
 #ifdef HAVE_LZ4FRAME_H
+/* Kept across batches; LZ4F_decompress() makes it ready for the next frame
+ * once a frame is complete, and it is thrown away after an error. */
+static LZ4F_decompressionContext_t kafka_lz4_ctxt;
+
 static gboolean
-decompress_lz4(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, tvbuff_t **decompressed_tvb, int *decompressed_offset)
+decompress_lz4(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, GByteArray *out)
 {
-    LZ4F_decompressionContext_t lz4_ctxt = NULL;
     LZ4F_frameInfo_t lz4_info;
     LZ4F_errorCode_t rc = 0;
-    size_t src_offset = 0, src_size = 0, dst_size = 0;
-    guchar *decompressed_buffer = NULL;
-    tvbuff_t *composite_tvb = NULL;
+    size_t src_offset = 0, src_size = 0, dst_size = 0, block_size = 0;
 
     gboolean ret = FALSE;
 
@@ -1640,79 +1757,76 @@ decompress_lz4(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, tv
         }
     }
 
-    /* Allocate output buffer */
-    rc = LZ4F_createDecompressionContext(&lz4_ctxt, LZ4F_VERSION);
-    if (LZ4F_isError(rc)) {
-        goto end;
+    if (!kafka_lz4_ctxt) {
+        rc = LZ4F_createDecompressionContext(&kafka_lz4_ctxt, LZ4F_VERSION);
+        if (LZ4F_isError(rc)) {
+            kafka_lz4_ctxt = NULL;
+            goto end;
+        }
     }
 
     src_offset = length;
-    rc = LZ4F_getFrameInfo(lz4_ctxt, &lz4_info, data, &src_offset);
+    rc = LZ4F_getFrameInfo(kafka_lz4_ctxt, &lz4_info, data, &src_offset);
     if (LZ4F_isError(rc)) {
         goto end;
     }
 
     switch (lz4_info.blockSizeID) {
         case LZ4F_max64KB:
-            dst_size = 1 << 16;
+            block_size = 1 << 16;
             break;
         case LZ4F_max256KB:
-            dst_size = 1 << 18;
+            block_size = 1 << 18;
             break;
         case LZ4F_max1MB:
-            dst_size = 1 << 20;
+            block_size = 1 << 20;
             break;
         case LZ4F_max4MB:
-            dst_size = 1 << 22;
+            block_size = 1 << 22;
             break;
         default:
             goto end;
     }
 
-    if (lz4_info.contentSize && lz4_info.contentSize < dst_size) {
-        dst_size = (size_t)lz4_info.contentSize;
+    if (lz4_info.contentSize && lz4_info.contentSize < block_size) {
+        block_size = (size_t)lz4_info.contentSize;
     }
 
     do {
+        guint out_len = out->len;
         src_size = length - src_offset; // set the number of available octets
         if (src_size == 0) {
             goto end;
         }
-        decompressed_buffer = (guchar*)wmem_alloc(pinfo->pool, dst_size);
-        rc = LZ4F_decompress(lz4_ctxt, decompressed_buffer, &dst_size,
+        dst_size = block_size;
+        g_byte_array_set_size(out, out_len + (guint)dst_size);
+        rc = LZ4F_decompress(kafka_lz4_ctxt, &out->data[out_len], &dst_size,
                               &data[src_offset], &src_size, NULL);
+        g_byte_array_set_size(out, out_len + (LZ4F_isError(rc) ? 0 : (guint)dst_size));
         if (LZ4F_isError(rc)) {
             goto end;
         }
         if (dst_size == 0) {
             goto end;
         }
-        if (!composite_tvb) {
-            composite_tvb = tvb_new_composite();
-        }
-        tvb_composite_append(composite_tvb,
-                             tvb_new_child_real_data(tvb, (guint8*)decompressed_buffer, (guint)dst_size, (gint)dst_size));
         src_offset += src_size; // bump up the offset for the next iteration
     } while (rc > 0);
 
     ret = TRUE;
 end:
-    if (composite_tvb) {
-        tvb_composite_finalize(composite_tvb);
-    }
-    LZ4F_freeDecompressionContext(lz4_ctxt);
-    if (ret == 1) {
-        *decompressed_tvb = composite_tvb;
-        *decompressed_offset = 0;
-    }
-    else {
+    if (!ret) {
+        /* The context is left partway through a frame; start afresh. */
+        if (kafka_lz4_ctxt) {
+            LZ4F_freeDecompressionContext(kafka_lz4_ctxt);
+            kafka_lz4_ctxt = NULL;
+        }
         col_append_str(pinfo->cinfo, COL_INFO, " [lz4 decompression failed]");
     }
     return ret;
 }
 #else
 static gboolean
-decompress_lz4(tvbuff_t *tvb _U_, packet_info *pinfo, int offset _U_, guint32 length _U_, tvbuff_t **decompressed_tvb _U_, int *decompressed_offset _U_)
+decompress_lz4(tvbuff_t *tvb _U_, packet_info *pinfo, int offset _U_, guint32 length _U_, GByteArray *out _U_)
 {
     col_append_str(pinfo->cinfo, COL_INFO, " [lz4 decompression unsupported]");
     return FALSE;
@@ -1721,12 +1835,11 @@ decompress_lz4(tvbuff_t *tvb _U_, packet_info *pinfo, int offset _U_, guint32 le
 
 #ifdef HAVE_SNAPPY
 static gboolean
-decompress_snappy(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, tvbuff_t **decompressed_tvb, int *decompressed_offset)
+decompress_snappy(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, GByteArray *out)
 {
     guint8 *data = (guint8*)tvb_memdup(pinfo->pool, tvb, offset, length);
     size_t uncompressed_size;
     snappy_status rc = SNAPPY_OK;
-    tvbuff_t *composite_tvb = NULL;
     gboolean ret = FALSE;
 
     if (tvb_memeql(tvb, offset, kafka_xerial_header, sizeof(kafka_xerial_header)) == 0) {
@@ -1759,17 +1872,13 @@ decompress_snappy(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length,
             if (rc != SNAPPY_OK) {
                 goto end;
             }
-            guint8 *decompressed_buffer = (guint8*)wmem_alloc(pinfo->pool, uncompressed_size);
-            rc = snappy_uncompress(&data[pos], chunk_size, decompressed_buffer, &uncompressed_size);
+            guint out_len = out->len;
+            g_byte_array_set_size(out, out_len + (guint)uncompressed_size);
+            rc = snappy_uncompress(&data[pos], chunk_size, (char *)&out->data[out_len], &uncompressed_size);
             if (rc != SNAPPY_OK) {
                 goto end;
             }
-
-            if (!composite_tvb) {
-                composite_tvb = tvb_new_composite();
-            }
-            tvb_composite_append(composite_tvb,
-                      tvb_new_child_real_data(tvb, decompressed_buffer, (guint)uncompressed_size, (gint)uncompressed_size));
+            g_byte_array_set_size(out, out_len + (guint)uncompressed_size);
             pos += chunk_size;
         }
 
@@ -1781,26 +1890,17 @@ decompress_snappy(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length,
             goto end;
         }
 
-        guint8 *decompressed_buffer = (guint8*)wmem_alloc(pinfo->pool, uncompressed_size);
+        g_byte_array_set_size(out, (guint)uncompressed_size);
 
-        rc = snappy_uncompress(data, length, decompressed_buffer, &uncompressed_size);
+        rc = snappy_uncompress(data, length, (char *)out->data, &uncompressed_size);
         if (rc != SNAPPY_OK) {
             goto end;
         }
-
-        *decompressed_tvb = tvb_new_child_real_data(tvb, decompressed_buffer, (guint)uncompressed_size, (gint)uncompressed_size);
-        *decompressed_offset = 0;
+        g_byte_array_set_size(out, (guint)uncompressed_size);
 
     }
     ret = TRUE;
 end:
-    if (composite_tvb) {
-        tvb_composite_finalize(composite_tvb);
-        if (ret == 1) {
-            *decompressed_tvb = composite_tvb;
-            *decompressed_offset = 0;
-        }
-    }
     if (ret == FALSE) {
         col_append_str(pinfo->cinfo, COL_INFO, " [snappy decompression failed]");
     }
@@ -1808,7 +1908,7 @@ end:
 }
 #else
 static gboolean
-decompress_snappy(tvbuff_t *tvb _U_, packet_info *pinfo, int offset _U_, int length _U_, tvbuff_t **decompressed_tvb _U_, int *decompressed_offset _U_)
+decompress_snappy(tvbuff_t *tvb _U_, packet_info *pinfo, int offset _U_, guint32 length _U_, GByteArray *out _U_)
 {
     col_append_str(pinfo->cinfo, COL_INFO, " [snappy decompression unsupported]");
     return FALSE;
@@ -1816,79 +1916,141 @@ decompress_snappy(tvbuff_t *tvb _U_, packet_info *pinfo, int offset _U_, int len
 #endif /* HAVE_SNAPPY */
 
 #ifdef HAVE_ZSTD
+/* Kept across batches and reset at the start of each one. */
+static ZSTD_DStream *kafka_zds;
+
 static gboolean
-decompress_zstd(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, tvbuff_t **decompressed_tvb, int *decompressed_offset)
+decompress_zstd(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, GByteArray *out)
 {
     ZSTD_inBuffer input = { tvb_memdup(pinfo->pool, tvb, offset, length), length, 0 };
-    ZSTD_DStream *zds = ZSTD_createDStream();
     size_t rc = 0;
-    tvbuff_t *composite_tvb = NULL;
     gboolean ret = FALSE;
 
+    if (!kafka_zds) {
+        kafka_zds = ZSTD_createDStream();
+        if (!kafka_zds) {
+            goto end;
+        }
+    }
+    if (ZSTD_isError(ZSTD_initDStream(kafka_zds))) {
+        goto end;
+    }
+
     do {
-        ZSTD_outBuffer output = { wmem_alloc(pinfo->pool, ZSTD_DStreamOutSize()), ZSTD_DStreamOutSize(), 0 };
-        rc = ZSTD_decompressStream(zds, &output, &input);
+        guint out_len = out->len;
+        g_byte_array_set_size(out, out_len + (guint)ZSTD_DStreamOutSize());
+        ZSTD_outBuffer output = { out->data, out->len, out_len };
+        rc = ZSTD_decompressStream(kafka_zds, &output, &input);
+        g_byte_array_set_size(out, (guint)output.pos);
         // rc holds either the number of decompressed offsets or the error code.
         // Both values are positive, one has to use ZSTD_isError to determine if the call succeeded.
         if (ZSTD_isError(rc)) {
             goto end;
         }
-        if (!composite_tvb) {
-            composite_tvb = tvb_new_composite();
+        if (output.pos == out_len && input.pos == input.size && rc > 0) {
+            // The frame is truncated: no more input, and nothing came out.
+            goto end;
         }
-        tvb_composite_append(composite_tvb,
-                             tvb_new_child_real_data(tvb, (guint8*)output.dst, (guint)output.pos, (gint)output.pos));
         // rc == 0 means there is nothing more to decompress, but there could be still something in the data
     } while (rc > 0);
     ret = TRUE;
 end:
-    if (composite_tvb) {
-        tvb_composite_finalize(composite_tvb);
-    }
-    ZSTD_freeDStream(zds);
-    if (ret == 1) {
-        *decompressed_tvb = composite_tvb;
-        *decompressed_offset = 0;
-    }
-    else {
+    if (ret == FALSE) {
         col_append_str(pinfo->cinfo, COL_INFO, " [zstd decompression failed]");
     }
     return ret;
 }
 #else
 static gboolean
-decompress_zstd(tvbuff_t *tvb _U_, packet_info *pinfo, int offset _U_, guint32 length _U_, tvbuff_t **decompressed_tvb _U_, int *decompressed_offset _U_)
+decompress_zstd(tvbuff_t *tvb _U_, packet_info *pinfo, int offset _U_, guint32 length _U_, GByteArray *out _U_)
 {
     col_append_str(pinfo->cinfo, COL_INFO, " [zstd compression unsupported]");
     return FALSE;
 }
 #endif /* HAVE_ZSTD */
 
+static void
+kafka_decompress_shutdown(void)
+{
+    kafka_decompress_cache_clear();
+#ifdef HAVE_LZ4FRAME_H
+    if (kafka_lz4_ctxt) {
+        LZ4F_freeDecompressionContext(kafka_lz4_ctxt);
+        kafka_lz4_ctxt = NULL;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_freeDStream(kafka_zds);
+    kafka_zds = NULL;
+#endif
+}
+
 // Max is currently 2^22 in
 // https://github.com/apache/kafka/blob/trunk/clients/src/main/java/org/apache/kafka/common/record/KafkaLZ4BlockOutputStream.java
 #define MAX_DECOMPRESSION_SIZE (1 << 22)
 static gboolean
 decompress(tvbuff_t *tvb, packet_info *pinfo, int offset, guint32 length, int codec, tvbuff_t **decompressed_tvb, int *decompressed_offset)
 {
+    kafka_decompressed_key_t key;
+    const kafka_decompressed_t *cached;
+    const guint8 *compressed;
+    GByteArray *out;
+    gboolean ret;
+
     if (length > MAX_DECOMPRESSION_SIZE) {
         expert_add_info(pinfo, NULL, &ei_kafka_bad_decompression_length);
         return FALSE;
     }
+    if (codec == KAFKA_MESSAGE_CODEC_NONE) {
+        return decompress_none(tvb, pinfo, offset, length, decompressed_tvb, decompressed_offset);
+    }
+
+    memset(&key, 0, sizeof(key));
+    key.frame = pinfo->num;
+    key.offset = tvb_raw_offset(tvb) + offset;
+    key.length = length;
+    key.codec = codec;
+    compressed = tvb_get_ptr(tvb, offset, length);
+
+    cached = kafka_decompress_cache_lookup(&key, compressed);
+    if (cached) {
+        *decompressed_tvb = tvb_new_child_real_data(tvb,
+                (const guint8 *)wmem_memdup(pinfo->pool, cached->data, cached->data_len),
+                cached->data_len, cached->data_len);
+        *decompressed_offset = 0;
+        return TRUE;
+    }
+
+    out = g_byte_array_new();
     switch (codec) {
         case KAFKA_MESSAGE_CODEC_SNAPPY:
-            return decompress_snappy(tvb, pinfo, offset, length, decompressed_tvb, decompressed_offset);
+            ret = decompress_snappy(tvb, pinfo, offset, length, out);
+            break;
         case KAFKA_MESSAGE_CODEC_LZ4:
-            return decompress_lz4(tvb, pinfo, offset, length, decompressed_tvb, decompressed_offset);
+            ret = decompress_lz4(tvb, pinfo, offset, length, out);
+            break;
         case KAFKA_MESSAGE_CODEC_ZSTD:
-            return decompress_zstd(tvb, pinfo, offset, length, decompressed_tvb, decompressed_offset);
+            ret = decompress_zstd(tvb, pinfo, offset, length, out);
+            break;
         case KAFKA_MESSAGE_CODEC_GZIP:
-            return decompress_gzip(tvb, pinfo, offset, length, decompressed_tvb, decompressed_offset);
-        case KAFKA_MESSAGE_CODEC_NONE:
-            return decompress_none(tvb, pinfo, offset, length, decompressed_tvb, decompressed_offset);
+            ret = decompress_gzip(tvb, pinfo, offset, length, out);
+            break;
         default:
             col_append_str(pinfo->cinfo, COL_INFO, " [unsupported compression type]");
-            return FALSE;
+            ret = FALSE;
+            break;
     }
+    if (!ret) {
+        g_byte_array_free(out, TRUE);
+        return FALSE;
+    }
+
+    *decompressed_tvb = tvb_new_child_real_data(tvb,
+            (const guint8 *)wmem_memdup(pinfo->pool, out->data, out->len),
+            out->len, out->len);
+    *decompressed_offset = 0;
+    kafka_decompress_cache_add(&key, compressed, out);
+    return TRUE;
 }
 
 /*
@@ -10265,6 +10427,11 @@ proto_register_kafka_preferences(const int proto)
                                    "Show length for string and bytes fields in the protocol tree",
                                    "",
                                    &kafka_show_string_bytes_lengths);
+    prefs_register_uint_preference(kafka_module, "decompress_cache_size",
+                                   "Decompressed batch cache size (MB)",
+                                   "How much decompressed record data to keep so that"
+                                   " redissecting a frame doesn't decompress its batches again",
+                                   10, &kafka_decompress_cache_size);
 }
 
 
@@ -10288,6 +10455,9 @@ proto_register_kafka(void)
 
     proto_kafka = protocol_handle;
 
+    register_cleanup_routine(kafka_decompress_cache_clear);
+    register_shutdown_routine(kafka_decompress_shutdown);
+
 }
 
 void
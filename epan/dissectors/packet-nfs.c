@@ -1118,14 +1118,10 @@ static guint
 nfs_name_snoop_matched_hash(gconstpointer k)
 {
 	const nfs_name_snoop_key_t *key = (const nfs_name_snoop_key_t *)k;
-	int i;
-	guint hash;
 
-	hash = key->key;
-	for (i=0; i<key->fh_length; i++)
-		hash ^= key->fh[i];
-
-	return hash;
+	/* XORing the bytes of the file handle together left only 256 possible
+	 * values, so with many file handles every lookup walked a long chain. */
+	return key->key ^ wmem_strong_hash(key->fh, key->fh_length);
 }
 
 
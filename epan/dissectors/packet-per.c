@@ -1159,7 +1159,7 @@ DEBUG_ENTRY("dissect_per_boolean");
 	} else {
 		value=0;
 	}
-	if(hf_index!=-1){
+	if(hf_index!=-1 && proto_field_is_wanted(tree, hf_index)){
 		char bits[10];
 		bits[0] = mask&0x80?'0'+value:'.';
 		bits[1] = mask&0x40?'0'+value:'.';
@@ -1176,6 +1176,10 @@ DEBUG_ENTRY("dissect_per_boolean");
 		actx->created_item = proto_tree_add_boolean_format(tree, hf_index, tvb, offset>>3, 1, value,
 								   "%s %s: %s", bits, hfi->name,
 								   value?"True":"False");
+	} else if(hf_index!=-1){
+		/* Nobody will look at the text; this only fakes the item,
+		 * which callers may still hang subtrees off. */
+		actx->created_item = proto_tree_add_boolean(tree, hf_index, tvb, offset>>3, 1, value);
 	} else {
 		actx->created_item = NULL;
 	}
@@ -1963,7 +1967,8 @@ DEBUG_ENTRY("dissect_per_sequence");
 	memset(optional_mask, 0, sizeof(optional_mask));
 	for(i=0;i<num_opts;i++){
 		offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_optional_field_bit, &optional_field_flag);
-		if (tree) {
+		/* Naming the bit walks the sequence; skip it if nobody will see it. */
+		if (proto_field_is_wanted(tree, hf_per_optional_field_bit)) {
 			proto_item_append_text(actx->created_item, " (%s %s present)",
 				index_get_optional_name(sequence, i), optional_field_flag?"is":"is NOT");
 		}
@@ -2030,7 +2035,7 @@ DEBUG_ENTRY("dissect_per_sequence");
 		extension_mask=0;
 		for(i=0;i<num_extensions;i++){
 			offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_extension_present_bit, &extension_bit);
-			if (tree) {
+			if (proto_field_is_wanted(tree, hf_per_extension_present_bit)) {
 				proto_item_append_text(actx->created_item, " (%s %s present)",
 					index_get_extension_name(sequence, i), extension_bit?"is":"is NOT");
 			}
@@ -2128,7 +2133,8 @@ DEBUG_ENTRY("dissect_per_sequence_eag");
 	memset(optional_mask, 0, sizeof(optional_mask));
 	for(i=0;i<num_opts;i++){
 		offset=dissect_per_boolean(tvb, offset, actx, tree, hf_per_optional_field_bit, &optional_field_flag);
-		if (tree) {
+		/* Naming the bit walks the sequence; skip it if nobody will see it. */
+		if (proto_field_is_wanted(tree, hf_per_optional_field_bit)) {
 			proto_item_append_text(actx->created_item, " (%s %s present)",
 				index_get_optional_name(sequence, i), optional_field_flag?"is":"is NOT");
 		}
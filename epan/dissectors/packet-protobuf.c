@@ -171,7 +171,8 @@ static gint add_default_value = (gint) ADD_DEFAULT_VALUE_NONE;
 /* dynamic wireshark header fields for protobuf fields */
 static hf_register_info *dynamic_hf = NULL;
 static guint dynamic_hf_size = 0;
-/* the key is full name of protobuf fields, the value is header field id */
+/* the key is the descriptor of a protobuf message or field, the value is header field id.
+ * The descriptors live as long as pbw_pool, and the table is rebuilt whenever it is. */
 static GHashTable *pbf_hf_hash = NULL;
 
 /* Protobuf field value subdissector table list.
@@ -553,8 +554,8 @@ protobuf_dissect_field_value(proto_tree *value_tree, tvbuff_t *tvb, guint offset
     proto_tree* pbf_tree = field_tree;
     dissector_handle_t field_dissector = field_full_name ? dissector_get_string_handle(protobuf_field_subdissector_table, field_full_name) : NULL;
 
-    if (pbf_as_hf && field_full_name) {
-        hf_id_ptr = (int*)g_hash_table_lookup(pbf_hf_hash, field_full_name);
+    if (pbf_as_hf && field_desc) {
+        hf_id_ptr = (int*)g_hash_table_lookup(pbf_hf_hash, field_desc);
         DISSECTOR_ASSERT_HINT(hf_id_ptr && (*hf_id_ptr) > 0, "hf must have been initialized properly");
     }
 
@@ -1084,7 +1085,7 @@ add_missing_fields_with_default_values(tvbuff_t* tvb, guint offset, packet_info*
     const PbwDescriptor* message_desc, int* parsed_fields, int parsed_fields_count, json_dumper *dumper)
 {
     const PbwFieldDescriptor* field_desc;
-    const gchar* field_name, * field_full_name, * enum_value_name, * string_value;
+    const gchar* field_name, * enum_value_name, * string_value;
     int field_count = pbw_Descriptor_field_count(message_desc);
     int field_type, i, j;
     guint64 field_number;
@@ -1156,8 +1157,6 @@ add_missing_fields_with_default_values(tvbuff_t* tvb, guint offset, packet_info*
             continue;
         }
 
-        field_full_name = pbw_FieldDescriptor_full_name(field_desc);
-
         /* add common tree item for this field */
         field_tree = proto_tree_add_subtree_format(message_tree, tvb, offset, 0, ett_protobuf_field, &ti_field,
             "Field(%" PRIu64 "): %s %s", field_number, field_name, "=");
@@ -1172,8 +1171,8 @@ add_missing_fields_with_default_values(tvbuff_t* tvb, guint offset, packet_info*
         proto_item_set_generated(ti_field_number);
 
         hf_id_ptr = NULL;
-        if (pbf_as_hf && field_full_name) {
-            hf_id_ptr = (int*)g_hash_table_lookup(pbf_hf_hash, field_full_name);
+        if (pbf_as_hf) {
+            hf_id_ptr = (int*)g_hash_table_lookup(pbf_hf_hash, field_desc);
             DISSECTOR_ASSERT_HINT(hf_id_ptr && (*hf_id_ptr) > 0, "hf must have been initialized properly");
         }
 
@@ -1414,7 +1413,7 @@ dissect_protobuf_message(tvbuff_t *tvb, guint offset, guint length, packet_info
 
     if (pbf_as_hf && message_desc) {
         /* support filtering with message name as wireshark field name */
-        int *hf_id_ptr = (int*)g_hash_table_lookup(pbf_hf_hash, message_name);
+        int *hf_id_ptr = (int*)g_hash_table_lookup(pbf_hf_hash, message_desc);
         DISSECTOR_ASSERT_HINT(hf_id_ptr && (*hf_id_ptr) > 0, "hf of message should initialized properly");
         ti_message = proto_tree_add_item(protobuf_tree, *hf_id_ptr, tvb, offset, length, ENC_NA);
         proto_item_set_text(ti_message, "Message: %s", message_name);
@@ -1794,7 +1793,7 @@ collect_fields(const PbwDescriptor* message, void* userdata)
     hf->hfinfo.type = FT_BYTES;
     hf->hfinfo.display = BASE_NONE;
     wmem_list_append(hf_list, hf);
-    g_hash_table_insert(pbf_hf_hash, g_strdup(pbw_Descriptor_full_name(message)), hf->p_id);
+    g_hash_table_insert(pbf_hf_hash, (gpointer)message, hf->p_id);
 
     /* add fields of this message as fields */
     for (i = 0; i < total_num; i++) {
@@ -1889,7 +1888,7 @@ collect_fields(const PbwDescriptor* message, void* userdata)
         }
 
         wmem_list_append(hf_list, hf);
-        g_hash_table_insert(pbf_hf_hash, g_strdup(pbw_FieldDescriptor_full_name(field_desc)), hf->p_id);
+        g_hash_table_insert(pbf_hf_hash, (gpointer)field_desc, hf->p_id);
     }
 }
 
@@ -1906,7 +1905,7 @@ update_header_fields(gboolean force_reload)
         int i;
         wmem_list_frame_t *it;
         wmem_list_t* hf_list = wmem_list_new(NULL);
-        pbf_hf_hash = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        pbf_hf_hash = g_hash_table_new(g_direct_hash, g_direct_equal);
         DISSECTOR_ASSERT(pbw_pool);
         pbw_foreach_message(pbw_pool, collect_fields, hf_list);
         dynamic_hf_size = wmem_list_count(hf_list);
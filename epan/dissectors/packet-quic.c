@@ -419,6 +419,7 @@ typedef struct quic_info_data {
     quic_ciphers    client_initial_ciphers;
     quic_ciphers    server_initial_ciphers;
     quic_ciphers    client_0rtt_ciphers;
+    int             client_0rtt_cipher_algo;    /**< Cipher algorithm of client_0rtt_ciphers, found by trial decryption. */
     quic_ciphers    client_handshake_ciphers;
     quic_ciphers    server_handshake_ciphers;
     quic_pp_state_t client_pp;
@@ -2770,6 +2771,7 @@ quic_decrypt_message(quic_pp_cipher *pp_cipher, tvbuff_t *head, guint header_len
     gcry_error_t    err;
     guint8         *header;
     guint8          nonce[TLS13_AEAD_NONCE_LENGTH];
+    const guint8   *ciphertext;
     guint8         *buffer;
     guint8          atag[16];
     guint           buffer_length;
@@ -2792,7 +2794,10 @@ quic_decrypt_message(quic_pp_cipher *pp_cipher, tvbuff_t *head, guint header_len
         *error = "Decryption not possible, ciphertext is too short";
         return;
     }
-    buffer = (guint8 *)tvb_memdup(wmem_file_scope(), head, header_length, buffer_length);
+    /* Decrypt straight from the packet into the buffer that is kept for
+     * later passes, freeing it again if decryption fails. */
+    ciphertext = tvb_get_ptr(head, header_length, buffer_length);
+    buffer = (guint8 *)wmem_alloc(wmem_file_scope(), buffer_length);
     tvb_memcpy(head, atag, header_length + buffer_length, 16);
 
     memcpy(nonce, pp_cipher->pp_iv, TLS13_AEAD_NONCE_LENGTH);
@@ -2803,6 +2808,7 @@ quic_decrypt_message(quic_pp_cipher *pp_cipher, tvbuff_t *head, guint header_len
     err = gcry_cipher_setiv(pp_cipher->pp_cipher, nonce, TLS13_AEAD_NONCE_LENGTH);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (setiv) failed: %s", gcry_strerror(err));
+        wmem_free(wmem_file_scope(), buffer);
         return;
     }
 
@@ -2810,22 +2816,27 @@ quic_decrypt_message(quic_pp_cipher *pp_cipher, tvbuff_t *head, guint header_len
     err = gcry_cipher_authenticate(pp_cipher->pp_cipher, header, header_length);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (authenticate) failed: %s", gcry_strerror(err));
+        wmem_free(wmem_file_scope(), buffer);
         return;
     }
 
     /* Output ciphertext (C) */
-    err = gcry_cipher_decrypt(pp_cipher->pp_cipher, buffer, buffer_length, NULL, 0);
+    err = gcry_cipher_decrypt(pp_cipher->pp_cipher, buffer, buffer_length, ciphertext, buffer_length);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (decrypt) failed: %s", gcry_strerror(err));
+        wmem_free(wmem_file_scope(), buffer);
         return;
     }
 
     err = gcry_cipher_checktag(pp_cipher->pp_cipher, atag, 16);
     if (err) {
         *error = wmem_strdup_printf(wmem_file_scope(), "Decryption (checktag) failed: %s", gcry_strerror(err));
+        wmem_free(wmem_file_scope(), buffer);
         return;
     }
 
+    ssl_debug_count_decryption(0, 1, buffer_length);
+
     result->error = NULL;
     result->data = buffer;
     result->data_len = buffer_length;
@@ -3002,6 +3013,7 @@ quic_hp_cipher_prepare(quic_hp_cipher *hp_cipher, int hash_algo, int cipher_algo
             *error = "Failed to derive key material for HP cipher";
             return FALSE;
         }
+        ssl_debug_count_decryption(1, 0, 0);
     }
 
     return TRUE;
@@ -3031,6 +3043,7 @@ quic_pp_cipher_prepare(quic_pp_cipher *pp_cipher, int hash_algo, int cipher_algo
             *error = "Failed to derive key material for PP cipher";
             return FALSE;
         }
+        ssl_debug_count_decryption(1, 0, 0);
     }
 
     return TRUE;
@@ -3751,7 +3764,7 @@ dissect_quic_long_header(tvbuff_t *tvb, packet_info *pinfo, proto_tree *quic_tre
             conn->version = version;
             quic_ciphers_reset(ciphers);
             quic_create_initial_decoders(&conn->client_dcid_initial, &error, conn);
-        } else if (long_packet_type == QUIC_LPT_0RTT) {
+        } else if (long_packet_type == QUIC_LPT_0RTT && !quic_are_ciphers_initialized(ciphers)) {
             early_data_secret_len = tls13_get_quic_secret(pinfo, FALSE, TLS_SECRET_0RTT_APP, DIGEST_MIN_SIZE, DIGEST_MAX_SIZE, early_data_secret);
             if (early_data_secret_len == 0) {
                 error = "Secrets are not available";
@@ -3778,14 +3791,25 @@ dissect_quic_long_header(tvbuff_t *tvb, packet_info *pinfo, proto_tree *quic_tre
                 if (quic_decrypt_header(tvb, pn_offset, &ciphers->hp_cipher, hp_cipher_algo, &first_byte, &pkn32, FALSE)) {
                     error = NULL;
                 }
+            } else if (early_data_secret_len == 0) {
+                // Keep the ciphers found for the first 0-RTT packet rather
+                // than setting them up again for each of the others.
+                hp_cipher_algo = conn->client_0rtt_cipher_algo;
+                if (quic_decrypt_header(tvb, pn_offset, &ciphers->hp_cipher, hp_cipher_algo, &first_byte, &pkn32, FALSE)) {
+                    error = NULL;
+                }
             } else {
                 // Cipher is not stored with 0-RTT data or key, perform trial decryption.
                 for (guint i = 0; quic_create_0rtt_decoder(i, early_data_secret, early_data_secret_len, ciphers, &hp_cipher_algo, version); i++) {
                     if (quic_is_hp_cipher_initialized(&ciphers->hp_cipher) && quic_decrypt_header(tvb, pn_offset, &ciphers->hp_cipher, hp_cipher_algo, &first_byte, &pkn32, FALSE)) {
+                        conn->client_0rtt_cipher_algo = hp_cipher_algo;
                         error = NULL;
                         break;
                     }
                 }
+                if (error) {
+                    quic_ciphers_reset(ciphers);
+                }
             }
             if (!error) {
                 quic_set_full_packet_number(conn, quic_packet, from_server, first_byte, pkn32);
@@ -1402,8 +1402,9 @@ dissect_attribute_value_pairs(proto_tree *tree, packet_info *pinfo, tvbuff_t *tv
 
 	GHashTable *vsa_buffer_table = NULL;
 
-	if (hf_radius_code == -1)
-		proto_registrar_get_byname("radius.code");
+	/* Other dissectors call us directly, so the dictionary might not
+	 * have been loaded yet. */
+	proto_run_deferred_init(proto_radius);
 
 	/*
 	 * In case we throw an exception, clean up whatever stuff we've
@@ -1990,10 +1991,6 @@ dissect_radius(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data _
 			val_to_str_ext_const(rh.rh_code, &radius_pkt_type_codes_ext, "Unknown Packet"),
 			rh.rh_ident);
 
-	/* Load header fields if not already done */
-	if (hf_radius_code == -1)
-		proto_registrar_get_byname("radius.code");
-
 	ti = proto_tree_add_item(tree, proto_radius, tvb, 0, rh.rh_pktlength, ENC_NA);
 	radius_tree = proto_item_add_subtree(ti, ett_radius);
 	proto_tree_add_uint(radius_tree, hf_radius_code, tvb, 0, 1, rh.rh_code);
@@ -2599,7 +2596,7 @@ _radius_load_dictionary(gchar* dir)
 }
 
 static void
-register_radius_fields(const char *unused _U_)
+register_radius_fields(void)
 {
 	hf_register_info base_hf[] = {
 		{ &hf_radius_req,
@@ -2871,7 +2868,7 @@ proto_register_radius(void)
 	prefs_register_obsolete_preference(radius_module, "request_ttl");
 
 	radius_tap = register_tap("radius");
-	proto_register_prefix("radius", register_radius_fields);
+	proto_register_deferred_init(proto_radius, register_radius_fields);
 
 	dict = g_new(radius_dictionary_t, 1);
 	/*
@@ -1298,6 +1298,8 @@ static sip_info_value_t *stat_info;
 
 static GHashTable *sip_hash = NULL;           /* Hash table */
 static GHashTable *sip_headers_hash = NULL;     /* Hash table */
+/* Compact (one letter) header names, lower case, to hf entry (POS_x); 0 if none */
+static guint sip_compact_headers[128];
 
 /* Types for hash table keys and values */
 #define MAX_CALL_ID_SIZE 128
@@ -1381,6 +1383,14 @@ sip_init_protocol(void)
         ascii_strdown_inplace(value_copy);
         g_hash_table_insert(sip_headers_hash, (gpointer)value_copy, GINT_TO_POINTER(i));
     }
+
+    memset(sip_compact_headers, 0, sizeof(sip_compact_headers));
+    for (i = 1; i < array_length(sip_headers); i++){
+        if (sip_headers[i].compact_name != NULL) {
+            /* All the compact names are single letters */
+            sip_compact_headers[g_ascii_tolower(sip_headers[i].compact_name[0]) & 0x7f] = i;
+        }
+    }
 }
 
 static void
@@ -5190,13 +5200,13 @@ static gint sip_is_known_sip_header(gchar *header_name, guint header_len)
         pos = GPOINTER_TO_UINT(g_hash_table_lookup(sip_headers_hash, header_name));
         if (pos!=0)
             return pos;
+        return -1;
     }
 
-    /* Look for compact name match */
-    for (pos = 1; pos < array_length(sip_headers); pos++) {
-        if (sip_headers[pos].compact_name != NULL &&
-                header_len == strlen(sip_headers[pos].compact_name) &&
-                g_ascii_strncasecmp(header_name, sip_headers[pos].compact_name, header_len) == 0)
+    /* Look for compact name match; header_name has been lower cased */
+    if (header_len == 1 && (guchar)header_name[0] < 0x80) {
+        pos = sip_compact_headers[(guchar)header_name[0]];
+        if (pos != 0)
             return pos;
     }
 
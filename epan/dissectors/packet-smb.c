@@ -21369,6 +21369,8 @@ proto_register_smb(void)
 	register_srt_table(proto_smb, NULL, 3, smbstat_packet, smbstat_init, NULL);
 	/* Register the tap for the "Export Object" function */
 	smb_eo_tap = register_export_object(proto_smb, smb_eo_packet, smb_eo_cleanup);
+	/* Files are reassembled into entries that have already been added */
+	set_eo_entries_updated(proto_smb);
 }
 
 void
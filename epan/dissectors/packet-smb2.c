@@ -104,6 +104,8 @@ void proto_reg_handoff_smb2(void);
 #define SMB2_COMP_HEADER 0xFC
 
 static wmem_map_t *smb2_sessions = NULL;
+/* File names seen in opens, so that a file opened many times has one copy */
+static wmem_map_t *smb2_file_names = NULL;
 
 static const char smb_header_label[] = "SMB2 Header";
 static const char smb_transform_header_label[] = "SMB2 Transform Header";
@@ -1624,7 +1626,9 @@ static gchar *policy_hnd_to_file_id(wmem_allocator_t *pool, const e_ctx_hnd *hnd
 	return guid_to_str(pool, &hnd->uuid);
 }
 static guint smb2_eo_files_hash(gconstpointer k) {
-	return g_str_hash(policy_hnd_to_file_id(wmem_packet_scope(), (const e_ctx_hnd *)k));
+	/* Hash the GUID itself rather than its string form, which would be
+	 * formatted and allocated on every lookup. */
+	return wmem_strong_hash((const guint8 *)&((const e_ctx_hnd *)k)->uuid, sizeof(e_guid_t));
 }
 static gint smb2_eo_files_equal(gconstpointer k1, gconstpointer k2) {
 int	are_equal;
@@ -1646,6 +1650,18 @@ int	are_equal;
 	return are_equal;
 }
 
+static char *
+smb2_intern_file_name(const char *name)
+{
+	char *interned = (char *)wmem_map_lookup(smb2_file_names, name);
+
+	if (!interned) {
+		interned = wmem_strdup(wmem_file_scope(), name);
+		wmem_map_insert(smb2_file_names, interned, interned);
+	}
+	return interned;
+}
+
 static void
 feed_eo_smb2(tvbuff_t * tvb,packet_info *pinfo,smb2_info_t * si, guint16 dataoffset,guint32 length, guint64 file_offset) {
 
@@ -2408,15 +2424,16 @@ dissect_smb2_fid(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int offset
 			sfi->frame_end = G_MAXUINT32;
 
 			if (si->saved && si->saved->extra_info_type == SMB2_EI_FILENAME) {
-				sfi->name = wmem_strdup(wmem_file_scope(), (char *)si->saved->extra_info);
+				sfi->name = smb2_intern_file_name((char *)si->saved->extra_info);
 			} else {
-				sfi->name = wmem_strdup_printf(wmem_file_scope(), "[unknown]");
+				sfi->name = smb2_intern_file_name("[unknown]");
 			}
 
+			/* dcerpc_store_polhnd_name() keeps its own copy. */
 			if (si->saved && si->saved->extra_info_type == SMB2_EI_FILENAME) {
-				fid_name = wmem_strdup_printf(wmem_file_scope(), "File: %s", (char *)si->saved->extra_info);
+				fid_name = wmem_strdup_printf(pinfo->pool, "File: %s", (char *)si->saved->extra_info);
 			} else {
-				fid_name = wmem_strdup_printf(wmem_file_scope(), "File: ");
+				fid_name = wmem_strdup_printf(pinfo->pool, "File: ");
 			}
 			dcerpc_store_polhnd_name(&policy_hnd, pinfo,
 						  fid_name);
@@ -14058,6 +14075,7 @@ proto_register_smb2(void)
 
 	register_srt_table(proto_smb2, NULL, 1, smb2stat_packet, smb2stat_init, NULL);
 	smb2_sessions = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), smb2_sesid_info_hash, smb2_sesid_info_equal);
+	smb2_file_names = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_str_hash, g_str_equal);
 }
 
 void
@@ -28,6 +28,7 @@
 #include <epan/exported_pdu.h>
 #include <epan/in_cksum.h>
 #include <epan/proto_data.h>
+#include <epan/tvb_view.h>
 
 #include <wsutil/utf8_entities.h>
 #include <wsutil/str_util.h>
@@ -728,6 +729,19 @@ static dissector_handle_t tcp_opt_unknown_handle;
 static guint32 tcp_stream_count;
 static guint32 mptcp_stream_count;
 
+/*
+ * The frames in each TCP stream, so that a UI that wants one stream's
+ * packets only has to dissect those. Frame numbers are stored as LEB128
+ * encoded differences from the previous frame in the stream, which is a
+ * byte or two per frame for most streams.
+ */
+typedef struct {
+    guint32 last_frame;
+    wmem_array_t *deltas;   /* of guint8 */
+} tcp_stream_frames_t;
+
+static wmem_array_t *tcp_stream_frames;  /* of tcp_stream_frames_t, indexed by stream */
+
 
 
 /*
@@ -1681,16 +1695,17 @@ static struct tcp_analysis *
 init_tcp_conversation_data(packet_info *pinfo, int direction)
 {
     struct tcp_analysis *tcpd;
+    tcp_stream_frames_t stream_frames = { 0, NULL };
 
     /* Initialize the tcp protocol data structure to add to the tcp conversation */
     tcpd=wmem_new0(wmem_file_scope(), struct tcp_analysis);
     tcpd->flow1.win_scale = (direction >= 0) ? pinfo->src_win_scale : pinfo->dst_win_scale;
     tcpd->flow1.window = G_MAXUINT32;
-    tcpd->flow1.multisegment_pdus=wmem_tree_new(wmem_file_scope());
+    tcpd->flow1.multisegment_pdus=wmem_tree_new_sorted32(wmem_file_scope());
 
     tcpd->flow2.window = G_MAXUINT32;
     tcpd->flow2.win_scale = (direction >= 0) ? pinfo->dst_win_scale : pinfo->src_win_scale;
-    tcpd->flow2.multisegment_pdus=wmem_tree_new(wmem_file_scope());
+    tcpd->flow2.multisegment_pdus=wmem_tree_new_sorted32(wmem_file_scope());
 
     if (tcp_reassemble_out_of_order) {
         tcpd->flow1.ooo_segments=wmem_list_new(wmem_file_scope());
@@ -1727,6 +1742,7 @@ init_tcp_conversation_data(packet_info *pinfo, int direction)
     tcpd->flow2.closing_initiator = FALSE;
     tcpd->stream = tcp_stream_count++;
     tcpd->server_port = 0;
+    wmem_array_append_one(tcp_stream_frames, stream_frames);
 
     return tcpd;
 }
@@ -1860,6 +1876,72 @@ guint32 get_mptcp_stream_count(void)
     return mptcp_stream_count;
 }
 
+/* Note that a frame is in a stream; done on the first pass */
+static void
+tcp_stream_add_frame(guint32 stream, guint32 frame)
+{
+    tcp_stream_frames_t *stream_frames;
+    guint32 delta;
+    guint8 byte;
+
+    if (stream >= wmem_array_get_count(tcp_stream_frames))
+        return;
+
+    stream_frames = (tcp_stream_frames_t *)wmem_array_index(tcp_stream_frames, stream);
+    /* A frame can have the same stream in it more than once, e.g. in ICMP errors. */
+    if (frame <= stream_frames->last_frame)
+        return;
+
+    if (!stream_frames->deltas)
+        stream_frames->deltas = wmem_array_sized_new(wmem_file_scope(), sizeof(guint8), 16);
+
+    delta = frame - stream_frames->last_frame;
+    stream_frames->last_frame = frame;
+    while (delta >= 0x80) {
+        byte = (guint8)(delta | 0x80);
+        wmem_array_append_one(stream_frames->deltas, byte);
+        delta >>= 7;
+    }
+    byte = (guint8)delta;
+    wmem_array_append_one(stream_frames->deltas, byte);
+}
+
+/* Return the frames in a stream */
+GArray *
+get_tcp_stream_frames(guint32 stream)
+{
+    tcp_stream_frames_t *stream_frames;
+    const guint8 *deltas;
+    guint count, i;
+    guint32 frame = 0, delta = 0;
+    int shift = 0;
+    GArray *frames;
+
+    if (!tcp_stream_frames || stream >= wmem_array_get_count(tcp_stream_frames))
+        return NULL;
+
+    stream_frames = (tcp_stream_frames_t *)wmem_array_index(tcp_stream_frames, stream);
+    frames = g_array_new(FALSE, FALSE, sizeof(guint32));
+    if (!stream_frames->deltas)
+        return frames;
+
+    deltas = (const guint8 *)wmem_array_get_raw(stream_frames->deltas);
+    count = wmem_array_get_count(stream_frames->deltas);
+    for (i = 0; i < count; i++) {
+        delta |= (guint32)(deltas[i] & 0x7f) << shift;
+        if (deltas[i] & 0x80) {
+            shift += 7;
+            continue;
+        }
+        frame += delta;
+        g_array_append_val(frames, frame);
+        delta = 0;
+        shift = 0;
+    }
+
+    return frames;
+}
+
 /* Calculate the timestamps relative to this conversation */
 static void
 tcp_calculate_timestamps(packet_info *pinfo, struct tcp_analysis *tcpd,
@@ -1883,6 +1965,11 @@ tcp_calculate_timestamps(packet_info *pinfo, struct tcp_analysis *tcpd,
 static void
 tcp_print_timestamps(packet_info *pinfo, tvbuff_t *tvb, proto_tree *parent_tree, struct tcp_analysis *tcpd, struct tcp_per_packet_data_t *tcppd)
 {
+    static int * const timestamp_fields[] = {
+        &hf_tcp_ts_relative,
+        &hf_tcp_ts_delta,
+        NULL
+    };
     proto_item  *item;
     proto_tree  *tree;
     nstime_t    ts;
@@ -1890,6 +1977,10 @@ tcp_print_timestamps(packet_info *pinfo, tvbuff_t *tvb, proto_tree *parent_tree,
     if (!tcpd)
         return;
 
+    /* Don't bother looking up the per-packet data if nobody will see it. */
+    if (!proto_fields_are_wanted(parent_tree, timestamp_fields))
+        return;
+
     tree=proto_tree_add_subtree(parent_tree, tvb, 0, 0, ett_tcp_timestamps, &item, "Timestamps");
     proto_item_set_generated(item);
 
@@ -2084,29 +2175,30 @@ pdu_store_window_scale_option(guint8 ws, struct tcp_analysis *tcpd)
 static void
 tcp_analyze_get_acked_struct(guint32 frame, guint32 seq, guint32 ack, gboolean createflag, struct tcp_analysis *tcpd)
 {
-
-    wmem_tree_key_t key[4];
-
-    key[0].length = 1;
-    key[0].key = &frame;
-
-    key[1].length = 1;
-    key[1].key = &seq;
-
-    key[2].length = 1;
-    key[2].key = &ack;
-
-    key[3].length = 0;
-    key[3].key = NULL;
+    struct tcp_acked *first_ta;
 
     if (!tcpd) {
         return;
     }
 
-    tcpd->ta = (struct tcp_acked *)wmem_tree_lookup32_array(tcpd->acked_table, key);
-    if((!tcpd->ta) && createflag) {
+    /*
+     * The entries are keyed by frame alone, rather than by frame, seq
+     * and ack in nested trees, which took several tree nodes per frame;
+     * the few frames with more than one segment of the conversation
+     * have a list.
+     */
+    first_ta = (struct tcp_acked *)wmem_tree_lookup32(tcpd->acked_table, frame);
+    for (tcpd->ta = first_ta; tcpd->ta; tcpd->ta = tcpd->ta->next) {
+        if (tcpd->ta->seq == seq && tcpd->ta->ack == ack) {
+            return;
+        }
+    }
+    if (createflag) {
         tcpd->ta = wmem_new0(wmem_file_scope(), struct tcp_acked);
-        wmem_tree_insert32_array(tcpd->acked_table, key, (void *)tcpd->ta);
+        tcpd->ta->seq = seq;
+        tcpd->ta->ack = ack;
+        tcpd->ta->next = first_ta;
+        wmem_tree_insert32(tcpd->acked_table, frame, (void *)tcpd->ta);
     }
 }
 
@@ -7551,10 +7643,14 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     guint8     conversation_completeness = 0;
     gboolean   conversation_is_new = FALSE;
     guint8     ace;
+    tvb_view_t hdr;
+
+    /* Check once that the fixed-length header is there. */
+    tvb_view_init(&hdr, tvb, offset, TCPH_MIN_LEN);
 
     tcph = wmem_new0(pinfo->pool, struct tcpheader);
-    tcph->th_sport = tvb_get_ntohs(tvb, offset);
-    tcph->th_dport = tvb_get_ntohs(tvb, offset + 2);
+    tcph->th_sport = tvb_view_get_ntohs(&hdr, 0);
+    tcph->th_dport = tvb_view_get_ntohs(&hdr, 2);
     copy_address_shallow(&tcph->ip_src, &pinfo->src);
     copy_address_shallow(&tcph->ip_dst, &pinfo->dst);
 
@@ -7610,13 +7706,13 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     p_add_proto_data(pinfo->pool, pinfo, hf_tcp_srcport, pinfo->curr_layer_num, GUINT_TO_POINTER(tcph->th_sport));
     p_add_proto_data(pinfo->pool, pinfo, hf_tcp_dstport, pinfo->curr_layer_num, GUINT_TO_POINTER(tcph->th_dport));
 
-    tcph->th_rawseq = tvb_get_ntohl(tvb, offset + 4);
+    tcph->th_rawseq = tvb_view_get_ntohl(&hdr, 4);
     tcph->th_seq = tcph->th_rawseq;
-    tcph->th_rawack = tvb_get_ntohl(tvb, offset + 8);
+    tcph->th_rawack = tvb_view_get_ntohl(&hdr, 8);
     tcph->th_ack = tcph->th_rawack;
-    th_off_x2 = tvb_get_guint8(tvb, offset + 12);
-    tcpinfo.flags = tcph->th_flags = tvb_get_ntohs(tvb, offset + 12) & TH_MASK;
-    tcph->th_win = tvb_get_ntohs(tvb, offset + 14);
+    th_off_x2 = tvb_view_get_guint8(&hdr, 12);
+    tcpinfo.flags = tcph->th_flags = tvb_view_get_ntohs(&hdr, 12) & TH_MASK;
+    tcph->th_win = tvb_view_get_ntohs(&hdr, 14);
     real_window = tcph->th_win;
     tcph->th_hlen = hi_nibble(th_off_x2) * 4;  /* TCP header length, in bytes */
 
@@ -7737,6 +7833,10 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
          */
         tcph->th_stream = tcpd->stream;
 
+        if (!PINFO_FD_VISITED(pinfo)) {
+            tcp_stream_add_frame(tcpd->stream, pinfo->num);
+        }
+
         /* initialize the SACK blocks seen to 0 */
         if(tcp_analyze_seq && tcpd->fwd->tcp_analyze_seq_info) {
             tcpd->fwd->tcp_analyze_seq_info->num_sack_ranges = 0;
@@ -7985,7 +8085,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
         }
     } else {
         /* Note if the ACK field is non-zero */
-        if (tvb_get_ntohl(tvb, offset+8) != 0) {
+        if (tvb_view_get_ntohl(&hdr, 8) != 0) {
             expert_add_info(pinfo, tf, &ei_tcp_ack_nonzero);
         }
     }
@@ -8143,7 +8243,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
      * Assume, initially, that we can't desegment.
      */
     pinfo->can_desegment = 0;
-    th_sum = tvb_get_ntohs(tvb, offset + 16);
+    th_sum = tvb_view_get_ntohs(&hdr, 16);
     if (!pinfo->fragmented && tvb_bytes_exist(tvb, 0, reported_len)) {
         /* The packet isn't part of an un-reassembled fragmented datagram
            and isn't truncated.  This means we have all the data, and thus
@@ -8505,16 +8605,83 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     return tvb_captured_length(tvb);
 }
 
+static void
+tcp_free_flow_data(tcp_flow_t *flow)
+{
+    tcp_unacked_t *ual, *tmpual;
+    wmem_list_frame_t *frame;
+
+    if (flow->tcp_analyze_seq_info) {
+        for (ual = flow->tcp_analyze_seq_info->segments; ual; ual = tmpual) {
+            tmpual = ual->next;
+            wmem_free(wmem_file_scope(), ual);
+        }
+        wmem_free(wmem_file_scope(), flow->tcp_analyze_seq_info);
+    }
+    wmem_tree_destroy(flow->multisegment_pdus, FALSE, TRUE);
+    if (flow->ooo_segments) {
+        for (frame = wmem_list_head(flow->ooo_segments); frame; frame = wmem_list_frame_next(frame)) {
+            ooo_segment_item *fd = (ooo_segment_item *)wmem_list_frame_data(frame);
+            wmem_free(wmem_file_scope(), fd->data);
+            wmem_free(wmem_file_scope(), fd);
+        }
+        wmem_destroy_list(flow->ooo_segments);
+    }
+    if (flow->process_info) {
+        wmem_free(wmem_file_scope(), flow->process_info->username);
+        wmem_free(wmem_file_scope(), flow->process_info->command);
+        wmem_free(wmem_file_scope(), flow->process_info);
+    }
+}
+
+static gboolean
+tcp_free_acked_list(const void *key _U_, void *value, void *userdata _U_)
+{
+    struct tcp_acked *ta = (struct tcp_acked *)value;
+    struct tcp_acked *next;
+
+    for (; ta; ta = next) {
+        next = ta->next;
+        wmem_free(wmem_file_scope(), ta);
+    }
+    return FALSE;
+}
+
+/* Free the data for an expired conversation.  If it's an MPTCP subflow,
+ * the MPTCP connection still refers to it, so leave it alone. */
+static void
+tcp_free_conversation_data(conversation_t *conv _U_, void *proto_data)
+{
+    struct tcp_analysis *tcpd = (struct tcp_analysis *)proto_data;
+
+    if (tcpd->mptcp_analysis)
+        return;
+
+    tcp_free_flow_data(&tcpd->flow1);
+    tcp_free_flow_data(&tcpd->flow2);
+    wmem_tree_foreach(tcpd->acked_table, tcp_free_acked_list, NULL);
+    wmem_tree_destroy(tcpd->acked_table, FALSE, FALSE);
+    wmem_free(wmem_file_scope(), tcpd);
+}
+
 static void
 tcp_init(void)
 {
     tcp_stream_count = 0;
+    tcp_stream_frames = wmem_array_new(wmem_file_scope(), sizeof(tcp_stream_frames_t));
 
     /* MPTCP init */
     mptcp_stream_count = 0;
     mptcp_tokens = wmem_tree_new(wmem_file_scope());
 }
 
+static void
+tcp_cleanup(void)
+{
+    /* It's freed along with the rest of file scope. */
+    tcp_stream_frames = NULL;
+}
+
 void
 proto_register_tcp(void)
 {
@@ -9695,6 +9862,8 @@ proto_register_tcp(void)
         &read_seq_as_syn_cookie);
 
     register_init_routine(tcp_init);
+    register_cleanup_routine(tcp_cleanup);
+    conversation_register_proto_data_free(proto_tcp, tcp_free_conversation_data);
     reassembly_table_register(&tcp_reassembly_table,
                           &tcp_reassembly_table_functions);
 
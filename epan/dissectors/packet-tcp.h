@@ -159,14 +159,21 @@ typedef struct _tcp_unacked_t {
 	nstime_t ts;
 } tcp_unacked_t;
 
+/* The analysis results for a segment.  They're kept by frame number, in
+ * a list for the rare frames with more than one segment of a conversation
+ * in them; the fields are ordered to keep the structure small, as there's
+ * one for most segments.
+ */
 struct tcp_acked {
-	guint32 frame_acked;
-	nstime_t ts;
+	struct tcp_acked *next;	/* another segment in the same frame */
+	guint32 seq;		/* the segment's sequence and ack numbers */
+	guint32 ack;
 
-	guint32  rto_frame;
+	nstime_t ts;
 	nstime_t rto_ts;	/* Time since previous packet for
 				   retransmissions. */
-	guint16 flags; /* see TCP_A_* in packet-tcp.c */
+	guint32 frame_acked;
+	guint32  rto_frame;
 	guint32 dupack_num;	/* dup ack number */
 	guint32 dupack_frame;	/* dup ack to frame # */
 	guint32 bytes_in_flight; /* number of bytes in flight */
@@ -174,6 +181,7 @@ struct tcp_acked {
 
 	guint32 new_data_seq; /* For segments with old data,
 				 where new data starts */
+	guint16 flags; /* see TCP_A_* in packet-tcp.c */
 };
 
 /* One instance of this structure is created for each pdu that spans across
@@ -440,7 +448,8 @@ struct tcp_analysis {
 	 */
 	struct tcp_acked *ta;
 	/* This structure contains a tree containing all the various ta's
-	 * keyed by frame number.
+	 * keyed by frame number, each the head of a list of the frame's
+	 * segments.
 	 */
 	wmem_tree_t	*acked_table;
 
@@ -551,6 +560,15 @@ extern void add_tcp_process_info(guint32 frame_num, address *local_addr, address
  */
 WS_DLL_PUBLIC guint32 get_tcp_stream_count(void);
 
+/** Get the frames in a TCP stream, as recorded on the first pass
+ *
+ * @param stream The stream number, as in tcp.stream
+ * @return A GArray of the guint32 numbers of the frames in the stream, in
+ * order, which the caller must free with g_array_free(), or NULL if there's
+ * no such stream
+ */
+WS_DLL_PUBLIC GArray *get_tcp_stream_frames(guint32 stream);
+
 /** Get the current number of MPTCP streams
  *
  * @return The number of MPTCP streams
@@ -2990,6 +2990,7 @@ ssl_cipher_init(gcry_cipher_hd_t *cipher, gint algo, guchar* sk,
         if (err != 0)
             return -1;
     }
+    ssl_debug_count_decryption(1, 0, 0);
     return 0;
 }
 static inline gint
@@ -3995,6 +3996,8 @@ ssl_decoder_destroy_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U
 
     if (dec->evp)
         ssl_cipher_cleanup(&dec->evp);
+    if (dec->mac_hd)
+        ssl_hmac_cleanup(&dec->mac_hd);
 
 #ifdef HAVE_ZLIB
     if (dec->decomp != NULL && dec->decomp->compression == 1 /* DEFLATE */)
@@ -4055,6 +4058,7 @@ tls13_cipher_create(const char *label_prefix, int cipher_algo, int cipher_mode,
     cipher->hd = hd;
     memcpy(cipher->iv, write_iv, iv_length);
     *error = NULL;
+    ssl_debug_count_decryption(1, 0, 0);
 
 end:
     wmem_free(NULL, write_key);
@@ -4702,23 +4706,47 @@ ssl_decrypt_pre_master_secret(SslDecryptSession *ssl_session,
 
 /* Decryption integrity check {{{ */
 
+/*
+ * Returns the decoder's HMAC, ready for a record. It is opened and keyed for
+ * the first record only; gcry_md_reset() keeps the key for the next ones.
+ */
+static SSL_HMAC *
+ssl_decoder_get_mac(SslDecoder *decoder)
+{
+    gint md;
+
+    if (decoder->mac_hd) {
+        ssl_hmac_reset(&decoder->mac_hd);
+        return &decoder->mac_hd;
+    }
+
+    md=ssl_get_digest_by_name(ssl_cipher_suite_dig(decoder->cipher_suite)->name);
+    if (ssl_hmac_init(&decoder->mac_hd,md) != 0) {
+        decoder->mac_hd = NULL;
+        return NULL;
+    }
+    if (ssl_hmac_setkey(&decoder->mac_hd,decoder->mac_key.data,decoder->mac_key.data_len) != 0) {
+        ssl_hmac_cleanup(&decoder->mac_hd);
+        decoder->mac_hd = NULL;
+        return NULL;
+    }
+    ssl_debug_count_decryption(1, 0, 0);
+    return &decoder->mac_hd;
+}
+
 static gint
 tls_check_mac(SslDecoder*decoder, gint ct, gint ver, guint8* data,
         guint32 datalen, guint8* mac)
 {
-    SSL_HMAC hm;
-    gint     md;
+    SSL_HMAC *hm;
     guint32  len;
     guint8   buf[DIGEST_MAX_SIZE];
     gint16   temp;
 
-    md=ssl_get_digest_by_name(ssl_cipher_suite_dig(decoder->cipher_suite)->name);
-    ssl_debug_printf("tls_check_mac mac type:%s md %d\n",
-        ssl_cipher_suite_dig(decoder->cipher_suite)->name, md);
+    ssl_debug_printf("tls_check_mac mac type:%s\n",
+        ssl_cipher_suite_dig(decoder->cipher_suite)->name);
 
-    if (ssl_hmac_init(&hm,md) != 0)
-        return -1;
-    if (ssl_hmac_setkey(&hm,decoder->mac_key.data,decoder->mac_key.data_len) != 0)
+    if ((hm = ssl_decoder_get_mac(decoder)) == NULL)
         return -1;
 
     /* hash sequence number */
@@ -4726,28 +4754,27 @@ tls_check_mac(SslDecoder*decoder, gint ct, gint ver, guint8* data,
 
     decoder->seq++;
 
-    ssl_hmac_update(&hm,buf,8);
+    ssl_hmac_update(hm,buf,8);
 
     /* hash content type */
     buf[0]=ct;
-    ssl_hmac_update(&hm,buf,1);
+    ssl_hmac_update(hm,buf,1);
 
     /* hash version,data length and data*/
     /* *((gint16*)buf) = g_htons(ver); */
     temp = g_htons(ver);
     memcpy(buf, &temp, 2);
-    ssl_hmac_update(&hm,buf,2);
+    ssl_hmac_update(hm,buf,2);
 
     /* *((gint16*)buf) = g_htons(datalen); */
     temp = g_htons(datalen);
     memcpy(buf, &temp, 2);
-    ssl_hmac_update(&hm,buf,2);
-    ssl_hmac_update(&hm,data,datalen);
+    ssl_hmac_update(hm,buf,2);
+    ssl_hmac_update(hm,data,datalen);
 
     /* get digest and digest len*/
     len = sizeof(buf);
-    ssl_hmac_final(&hm,buf,&len);
-    ssl_hmac_cleanup(&hm);
+    ssl_hmac_final(hm,buf,&len);
     ssl_print_data("Mac", buf, len);
     if(memcmp(mac,buf,len))
         return -1;
@@ -4821,21 +4848,17 @@ static gint
 dtls_check_mac(SslDecoder*decoder, gint ct,int ver, guint8* data,
         guint32 datalen, guint8* mac, const guchar *cid, guint8 cidl)
 {
-    SSL_HMAC hm;
-    gint     md;
+    SSL_HMAC *hm;
     guint32  len;
     guint8   buf[DIGEST_MAX_SIZE];
     gint16   temp;
 
     gboolean is_cid = ((ct == SSL_ID_TLS12_CID) && (ver == DTLSV1DOT2_VERSION));
 
-    md=ssl_get_digest_by_name(ssl_cipher_suite_dig(decoder->cipher_suite)->name);
-    ssl_debug_printf("dtls_check_mac mac type:%s md %d\n",
-        ssl_cipher_suite_dig(decoder->cipher_suite)->name, md);
+    ssl_debug_printf("dtls_check_mac mac type:%s\n",
+        ssl_cipher_suite_dig(decoder->cipher_suite)->name);
 
-    if (ssl_hmac_init(&hm,md) != 0)
-        return -1;
-    if (ssl_hmac_setkey(&hm,decoder->mac_key.data,decoder->mac_key.data_len) != 0)
+    if ((hm = ssl_decoder_get_mac(decoder)) == NULL)
         return -1;
 
     ssl_debug_printf("dtls_check_mac seq: %" PRIu64 " epoch: %d\n",decoder->seq,decoder->epoch);
@@ -4843,54 +4866,53 @@ dtls_check_mac(SslDecoder*decoder, gint ct,int ver, guint8* data,
     if (is_cid) {
         /* hash seq num placeholder */
         memset(buf,0xFF,8);
-        ssl_hmac_update(&hm,buf,8);
+        ssl_hmac_update(hm,buf,8);
 
         /* hash content type + cid length + content type */
         buf[0]=ct;
         buf[1]=cidl;
         buf[2]=ct;
-        ssl_hmac_update(&hm,buf,3);
+        ssl_hmac_update(hm,buf,3);
 
         /* hash version */
         temp = g_htons(ver);
         memcpy(buf, &temp, 2);
-        ssl_hmac_update(&hm,buf,2);
+        ssl_hmac_update(hm,buf,2);
 
         /* hash sequence number */
         phton64(buf, decoder->seq);
         buf[0]=decoder->epoch>>8;
         buf[1]=(guint8)decoder->epoch;
-        ssl_hmac_update(&hm,buf,8);
+        ssl_hmac_update(hm,buf,8);
 
         /* hash cid */
-        ssl_hmac_update(&hm,cid,cidl);
+        ssl_hmac_update(hm,cid,cidl);
     } else {
         /* hash sequence number */
         phton64(buf, decoder->seq);
         buf[0]=decoder->epoch>>8;
         buf[1]=(guint8)decoder->epoch;
-        ssl_hmac_update(&hm,buf,8);
+        ssl_hmac_update(hm,buf,8);
 
         /* hash content type */
         buf[0]=ct;
-        ssl_hmac_update(&hm,buf,1);
+        ssl_hmac_update(hm,buf,1);
 
         /* hash version */
         temp = g_htons(ver);
         memcpy(buf, &temp, 2);
-        ssl_hmac_update(&hm,buf,2);
+        ssl_hmac_update(hm,buf,2);
     }
 
     /* data length and data */
     temp = g_htons(datalen);
     memcpy(buf, &temp, 2);
-    ssl_hmac_update(&hm,buf,2);
-    ssl_hmac_update(&hm,data,datalen);
+    ssl_hmac_update(hm,buf,2);
+    ssl_hmac_update(hm,data,datalen);
 
     /* get digest and digest len */
     len = sizeof(buf);
-    ssl_hmac_final(&hm,buf,&len);
-    ssl_hmac_cleanup(&hm);
+    ssl_hmac_final(hm,buf,&len);
     ssl_print_data("Mac", buf, len);
     if(memcmp(mac,buf,len))
         return -1;
@@ -4925,6 +4947,7 @@ tls_decrypt_aead_record(SslDecryptSession *ssl, SslDecoder *decoder,
     const guint8    draft_version = ssl->session.tls13_draft_version;
     const guchar   *auth_tag_wire;
     guchar          auth_tag_calc[16];
+    guchar          aad_buf[23 + 255];      /* longest AAD, with a 255-byte CID */
     guchar         *aad = NULL;
     guint           aad_len = 0;
 
@@ -5001,7 +5024,7 @@ tls_decrypt_aead_record(SslDecryptSession *ssl, SslDecoder *decoder,
     if (is_cid) { /* if connection ID */
         if (ssl->session.deprecated_cid) {
             aad_len = 14 + cidl;
-            aad = wmem_alloc(wmem_packet_scope(), aad_len);
+            aad = aad_buf;
             phton64(aad, decoder->seq);         /* record sequence number */
             phton16(aad, decoder->epoch);       /* DTLS 1.2 includes epoch. */
             aad[8] = ct;                        /* TLSCompressed.type */
@@ -5011,7 +5034,7 @@ tls_decrypt_aead_record(SslDecryptSession *ssl, SslDecoder *decoder,
             phton16(aad + 12 + cidl, ciphertext_len);  /* TLSCompressed.length */
         } else {
             aad_len = 23 + cidl;
-            aad = wmem_alloc(wmem_packet_scope(), aad_len);
+            aad = aad_buf;
             memset(aad, 0xFF, 8);               /* seq_num_placeholder */
             aad[8] = ct;                        /* TLSCompressed.type */
             aad[9] = cidl;                      /* cid_length */
@@ -5024,7 +5047,7 @@ tls_decrypt_aead_record(SslDecryptSession *ssl, SslDecoder *decoder,
         }
     } else if (is_v12) {
         aad_len = 13;
-        aad = wmem_alloc(wmem_packet_scope(), aad_len);
+        aad = aad_buf;
         phton64(aad, decoder->seq);         /* record sequence number */
         if (version == DTLSV1DOT2_VERSION) {
             phton16(aad, decoder->epoch);   /* DTLS 1.2 includes epoch. */
@@ -5034,7 +5057,7 @@ tls_decrypt_aead_record(SslDecryptSession *ssl, SslDecoder *decoder,
         phton16(aad + 11, ciphertext_len);  /* TLSCompressed.length */
     } else if (draft_version >= 25 || draft_version == 0) {
         aad_len = 5;
-        aad = wmem_alloc(wmem_packet_scope(), aad_len);
+        aad = aad_buf;
         aad[0] = ct;                        /* TLSCiphertext.opaque_type (23) */
         phton16(aad + 1, record_version);   /* TLSCiphertext.legacy_record_version (0x0303) */
         phton16(aad + 3, inl);              /* TLSCiphertext.length */
@@ -5308,6 +5331,7 @@ ssl_decrypt_record(SslDecryptSession *ssl, SslDecoder *decoder, guint8 ct, guint
 skip_mac:
 
     *outl = worklen;
+    ssl_debug_count_decryption(0, 1, worklen);
 
     if (decoder->compression > 0) {
         ssl_debug_printf("ssl_decrypt_record: compression method %d\n", decoder->compression);
@@ -5787,6 +5811,8 @@ ssl_common_cleanup(ssl_master_key_map_t *mk_map, FILE **ssl_keylog_file,
     g_free(decrypted_data->data);
     g_free(compressed_data->data);
 
+    ssl_debug_print_decryption_stats();
+
     /* close the previous keylog file now that the cache are cleared, this
      * allows the cache to be filled with the full keylog file contents. */
     if (*ssl_keylog_file) {
@@ -6237,6 +6263,94 @@ typedef struct ssl_master_key_match_group {
     GHashTable *master_key_ht;
 } ssl_master_key_match_group_t;
 
+typedef struct ssl_master_key_label {
+    const char *label;          /* including the space after it */
+    GHashTable *master_key_ht;
+    guint       secret_len;     /* required secret length, or 0 for any */
+} ssl_master_key_label_t;
+
+/* Decodes exactly out_len bytes of hex, failing on any non-hex digit. */
+static gboolean
+tls_keylog_decode_hex(guchar *out, const char *in, gsize out_len)
+{
+    for (gsize i = 0; i < out_len; i++) {
+        int a = ws_xton(in[i*2]);
+        int b = ws_xton(in[i*2 + 1]);
+        if (a == -1 || b == -1)
+            return FALSE;
+        out[i] = a << 4 | b;
+    }
+    return TRUE;
+}
+
+/*
+ * Handles the "<LABEL> <client_random> <secret>" lines that make up nearly
+ * all of a key log written by a TLS library, without going through the
+ * regex. Only a line that is exactly in that form is taken; anything else
+ * returns FALSE and is left to the regex so that it is treated the same as
+ * before.
+ *
+ * A key that is already known with the same secret (as happens when the
+ * file is re-read after being rewritten, or the same keys are also in a
+ * Decryption Secrets Block) is not stored again, and a new key is stored in
+ * a single allocation instead of four.
+ */
+static gboolean
+tls_keylog_process_line_fast(const ssl_master_key_label_t *labels, guint num_labels,
+                             const char *line, gsize linelen)
+{
+    const ssl_master_key_label_t *l = NULL;
+    guchar crandom[32], secret[64];
+    gsize label_len = 0;
+
+    for (guint i = 0; i < num_labels; i++) {
+        label_len = strlen(labels[i].label);
+        if (linelen > label_len && memcmp(line, labels[i].label, label_len) == 0) {
+            l = &labels[i];
+            break;
+        }
+    }
+    if (!l) {
+        return FALSE;
+    }
+    line += label_len;
+    linelen -= label_len;
+
+    if (linelen < 2 * sizeof(crandom) + 3 || line[2 * sizeof(crandom)] != ' ') {
+        return FALSE;
+    }
+    const char *hex_secret = line + 2 * sizeof(crandom) + 1;
+    gsize secret_len = (linelen - 2 * sizeof(crandom) - 1) / 2;
+    if ((linelen - 2 * sizeof(crandom) - 1) & 1 || secret_len > sizeof(secret) ||
+            (l->secret_len && secret_len != l->secret_len)) {
+        return FALSE;
+    }
+    if (!tls_keylog_decode_hex(crandom, line, sizeof(crandom)) ||
+            !tls_keylog_decode_hex(secret, hex_secret, secret_len)) {
+        return FALSE;
+    }
+
+    StringInfo lookup_key = { crandom, (guint)sizeof(crandom) };
+    const StringInfo *known = (const StringInfo *)g_hash_table_lookup(l->master_key_ht, &lookup_key);
+    if (known && known->data_len == secret_len && memcmp(known->data, secret, secret_len) == 0) {
+        return TRUE;
+    }
+
+    StringInfo *key = (StringInfo *)wmem_alloc(wmem_file_scope(),
+            2 * sizeof(StringInfo) + sizeof(crandom) + secret_len);
+    StringInfo *value = key + 1;
+    key->data = (guchar *)(value + 1);
+    key->data_len = (guint)sizeof(crandom);
+    memcpy(key->data, crandom, sizeof(crandom));
+    value->data = key->data + sizeof(crandom);
+    value->data_len = (guint)secret_len;
+    memcpy(value->data, secret, secret_len);
+
+    ssl_debug_printf("    matched %s\n", l->label);
+    g_hash_table_insert(l->master_key_ht, key, value);
+    return TRUE;
+}
+
 void
 tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data, guint datalen)
 {
@@ -6254,6 +6368,16 @@ tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data,
         { "early_exporter",     mk_map->tls13_early_exporter },
         { "exporter",           mk_map->tls13_exporter },
     };
+    const ssl_master_key_label_t mk_labels[] = {
+        { "CLIENT_RANDOM ",                     mk_map->crandom, SSL_MASTER_SECRET_LENGTH },
+        { "CLIENT_EARLY_TRAFFIC_SECRET ",       mk_map->tls13_client_early, 0 },
+        { "CLIENT_HANDSHAKE_TRAFFIC_SECRET ",   mk_map->tls13_client_handshake, 0 },
+        { "SERVER_HANDSHAKE_TRAFFIC_SECRET ",   mk_map->tls13_server_handshake, 0 },
+        { "CLIENT_TRAFFIC_SECRET_0 ",           mk_map->tls13_client_appdata, 0 },
+        { "SERVER_TRAFFIC_SECRET_0 ",           mk_map->tls13_server_appdata, 0 },
+        { "EARLY_EXPORTER_SECRET ",             mk_map->tls13_early_exporter, 0 },
+        { "EXPORTER_SECRET ",                   mk_map->tls13_exporter, 0 },
+    };
 
     /* The format of the file is a series of records with one of the following formats:
      *   - "RSA xxxx yyyy"
@@ -6315,6 +6439,9 @@ tls_keylog_process_lines(const ssl_master_key_map_t *mk_map, const guint8 *data,
         }
 
         ssl_debug_printf("  checking keylog line: %.*s\n", (int)linelen, line);
+        if (tls_keylog_process_line_fast(mk_labels, G_N_ELEMENTS(mk_labels), line, linelen)) {
+            continue;
+        }
         GMatchInfo *mi;
         if (g_regex_match_full(regex, line, linelen, 0, G_REGEX_MATCH_ANCHORED, &mi, NULL)) {
             gchar *hex_key, *hex_pre_ms_or_ms;
@@ -6402,6 +6529,8 @@ ssl_load_keyfile(const gchar *tls_keylog_filename, FILE **keylog_file,
 
     for (;;) {
         char buf[1110], *line;
+        gint64 line_start = ws_ftell64(*keylog_file);
+        size_t linelen;
         line = fgets(buf, sizeof(buf), *keylog_file);
         if (!line) {
             if (feof(*keylog_file)) {
@@ -6414,7 +6543,15 @@ ssl_load_keyfile(const gchar *tls_keylog_filename, FILE **keylog_file,
             }
             break;
         }
-        tls_keylog_process_lines(mk_map, (guint8 *)line, (int)strlen(line));
+        linelen = strlen(line);
+        tls_keylog_process_lines(mk_map, (guint8 *)line, (int)linelen);
+        if (linelen > 0 && line[linelen - 1] != '\n' && feof(*keylog_file) && line_start >= 0) {
+            /* The last line may still be being written. Read it again next
+             * time so that the complete line replaces whatever was taken
+             * from this part of it; an unchanged line is not stored twice. */
+            ws_fseek64(*keylog_file, line_start, SEEK_SET);
+            break;
+        }
     }
 }
 /** SSL keylog file handling. }}} */
@@ -6474,6 +6611,36 @@ ssl_debug_printf(const gchar* fmt, ...)
     va_end(ap);
 }
 
+/*
+ * What decryption has cost since the last capture file was closed: key
+ * setups (cipher and MAC handles opened and keyed) against records
+ * decrypted. With handles reused per direction, there should be a handful
+ * of setups per connection, however many records it has.
+ */
+static guint   ssl_decrypt_setups;
+static guint   ssl_decrypt_records;
+static guint64 ssl_decrypt_bytes;
+
+void
+ssl_debug_count_decryption(guint setups, guint records, guint64 bytes)
+{
+    ssl_decrypt_setups  += setups;
+    ssl_decrypt_records += records;
+    ssl_decrypt_bytes   += bytes;
+}
+
+void
+ssl_debug_print_decryption_stats(void)
+{
+    if (ssl_decrypt_setups || ssl_decrypt_records) {
+        ssl_debug_printf("decryption: %u key setups, %u records, %" PRIu64 " bytes of plaintext\n",
+                ssl_decrypt_setups, ssl_decrypt_records, ssl_decrypt_bytes);
+    }
+    ssl_decrypt_setups  = 0;
+    ssl_decrypt_records = 0;
+    ssl_decrypt_bytes   = 0;
+}
+
 void
 ssl_print_data(const gchar* name, const guchar* data, size_t len)
 {
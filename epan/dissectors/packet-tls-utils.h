@@ -336,6 +336,7 @@ typedef struct _SslDecoder {
     StringInfo mac_key; /* for block and stream ciphers */
     StringInfo write_iv; /* for AEAD ciphers (at least GCM, CCM) */
     SSL_CIPHER_CTX evp;
+    gcry_md_hd_t mac_hd; /**< HMAC keyed with mac_key, opened on first use and reset for each record. */
     SslDecompress *decomp;
     guint64 seq;    /**< Implicit (TLS) or explicit (DTLS) record sequence number. */
     guint16 epoch;
@@ -2553,6 +2554,10 @@ extern void
 ssl_set_debug(const gchar* name);
 extern void
 ssl_debug_flush(void);
+extern void
+ssl_debug_count_decryption(guint setups, guint records, guint64 bytes);
+extern void
+ssl_debug_print_decryption_stats(void);
 #else
 
 /* No debug: nullify debug operation*/
@@ -2564,6 +2569,8 @@ ssl_debug_printf(const gchar* fmt _U_,...)
 #define ssl_print_string(a, b)
 #define ssl_set_debug(name)
 #define ssl_debug_flush()
+#define ssl_debug_count_decryption(setups, records, bytes)
+#define ssl_debug_print_decryption_stats()
 
 #endif /* SSL_DECRYPT_DEBUG */
 
@@ -30,6 +30,7 @@
 #include "epan_dissect.h"
 
 #include <wsutil/nstime.h>
+#include <wsutil/perf_stats.h>
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 
@@ -106,7 +107,10 @@
 static GSList *epan_plugin_register_all_procotols = NULL;
 static GSList *epan_plugin_register_all_handoffs = NULL;
 
-static wmem_allocator_t *pinfo_pool_cache = NULL;
+/* One spare pinfo->pool per thread, so that dissecting a packet usually
+ * doesn't create an allocator, and threads dissecting at the same time
+ * don't hand the same one out twice. */
+static GPrivate pinfo_pool_cache = G_PRIVATE_INIT((GDestroyNotify)wmem_destroy_allocator);
 
 /* Global variables holding the content of the corresponding environment variable
  * to save fetching it repeatedly.
@@ -233,6 +237,26 @@ static void epan_plugin_register_all_tap_listeners(gpointer data, gpointer user_
 		plug->register_all_tap_listeners();
 }
 
+/* Bytes allocated in each wmem scope since it was created, for perf_stats;
+ * the packet scope is the calling thread's. */
+static guint64
+epan_scope_bytes_allocated(void)
+{
+	return wmem_bytes_allocated(wmem_epan_scope());
+}
+
+static guint64
+file_scope_bytes_allocated(void)
+{
+	return wmem_bytes_allocated(wmem_file_scope());
+}
+
+static guint64
+packet_scope_bytes_allocated(void)
+{
+	return wmem_bytes_allocated(wmem_packet_scope());
+}
+
 gboolean
 epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 {
@@ -263,6 +287,12 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 	 */
 	/* initialize memory allocation subsystem */
 	wmem_init_scopes();
+	ws_perf_gauge_register("wmem.epan_scope", "Bytes allocated in epan scope",
+			       WS_PERF_UNIT_BYTES, epan_scope_bytes_allocated);
+	ws_perf_gauge_register("wmem.file_scope", "Bytes allocated in file scope",
+			       WS_PERF_UNIT_BYTES, file_scope_bytes_allocated);
+	ws_perf_gauge_register("wmem.packet_scope", "Bytes allocated in packet scope",
+			       WS_PERF_UNIT_BYTES, packet_scope_bytes_allocated);
 
 	/* initialize the GUID to name mapping table */
 	guids_init();
@@ -322,6 +352,8 @@ epan_init(register_cb cb, gpointer client_data, gboolean load_plugins)
 		wslua_init(cb, client_data);
 #endif
 		g_slist_foreach(epan_plugins, epan_plugin_post_init, NULL);
+		/* Rates are worked out from now. */
+		ws_perf_reset();
 	}
 	CATCH(DissectorError) {
 		/*
@@ -370,6 +402,9 @@ epan_load_settings(void)
 void
 epan_cleanup(void)
 {
+	/* The gauges read tables that are about to be freed. */
+	ws_perf_gauges_cleanup();
+
 	g_slist_foreach(epan_plugins, epan_plugin_cleanup, NULL);
 	g_slist_free(epan_plugins);
 	epan_plugins = NULL;
@@ -432,10 +467,8 @@ epan_cleanup(void)
 	libwireshark_plugins = NULL;
 #endif
 
-	if (pinfo_pool_cache != NULL) {
-		wmem_destroy_allocator(pinfo_pool_cache);
-		pinfo_pool_cache = NULL;
-	}
+	/* Frees this thread's cached pool. */
+	g_private_replace(&pinfo_pool_cache, NULL);
 
 	wmem_cleanup_scopes();
 }
@@ -541,9 +574,9 @@ epan_dissect_init(epan_dissect_t *edt, epan_t *session, const gboolean create_pr
 	edt->session = session;
 
 	memset(&edt->pi, 0, sizeof(edt->pi));
-	if (pinfo_pool_cache != NULL) {
-		edt->pi.pool = pinfo_pool_cache;
-		pinfo_pool_cache = NULL;
+	edt->pi.pool = (wmem_allocator_t *)g_private_get(&pinfo_pool_cache);
+	if (edt->pi.pool != NULL) {
+		g_private_set(&pinfo_pool_cache, NULL);
 	}
 	else {
 		edt->pi.pool = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
@@ -617,11 +650,15 @@ epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 	wtap_rec *rec, tvbuff_t *tvb, frame_data *fd,
 	column_info *cinfo)
 {
+	guint64 start;
+
 #ifdef HAVE_LUA
 	wslua_prime_dfilter(edt); /* done before entering wmem scope */
 #endif
 	wmem_enter_packet_scope();
+	start = ws_perf_timer_start();
 	dissect_record(edt, file_type_subtype, rec, tvb, fd, cinfo);
+	ws_perf_timer_stop(WS_PERF_DISSECT_TIME, start);
 
 	/* free all memory allocated */
 	wmem_leave_packet_scope();
@@ -634,9 +671,13 @@ epan_dissect_run_with_taps(epan_dissect_t *edt, int file_type_subtype,
 	wtap_rec *rec, tvbuff_t *tvb, frame_data *fd,
 	column_info *cinfo)
 {
+	guint64 start;
+
 	wmem_enter_packet_scope();
 	tap_queue_init(edt);
+	start = ws_perf_timer_start();
 	dissect_record(edt, file_type_subtype, rec, tvb, fd, cinfo);
+	ws_perf_timer_stop(WS_PERF_DISSECT_TIME, start);
 	tap_push_tapped_queue(edt);
 
 	/* free all memory allocated */
@@ -649,11 +690,15 @@ void
 epan_dissect_file_run(epan_dissect_t *edt, wtap_rec *rec,
 	tvbuff_t *tvb, frame_data *fd, column_info *cinfo)
 {
+	guint64 start;
+
 #ifdef HAVE_LUA
 	wslua_prime_dfilter(edt); /* done before entering wmem scope */
 #endif
 	wmem_enter_packet_scope();
+	start = ws_perf_timer_start();
 	dissect_file(edt, rec, tvb, fd, cinfo);
+	ws_perf_timer_stop(WS_PERF_DISSECT_TIME, start);
 
 	/* free all memory allocated */
 	wmem_leave_packet_scope();
@@ -665,9 +710,13 @@ void
 epan_dissect_file_run_with_taps(epan_dissect_t *edt, wtap_rec *rec,
 	tvbuff_t *tvb, frame_data *fd, column_info *cinfo)
 {
+	guint64 start;
+
 	wmem_enter_packet_scope();
 	tap_queue_init(edt);
+	start = ws_perf_timer_start();
 	dissect_file(edt, rec, tvb, fd, cinfo);
+	ws_perf_timer_stop(WS_PERF_DISSECT_TIME, start);
 	tap_push_tapped_queue(edt);
 
 	/* free all memory allocated */
@@ -698,9 +747,9 @@ epan_dissect_cleanup(epan_dissect_t* edt)
 		proto_tree_free(edt->tree);
 	}
 
-	if (pinfo_pool_cache == NULL) {
+	if (g_private_get(&pinfo_pool_cache) == NULL) {
 		wmem_free_all(edt->pi.pool);
-		pinfo_pool_cache = edt->pi.pool;
+		g_private_set(&pinfo_pool_cache, edt->pi.pool);
 	}
 	else {
 		wmem_destroy_allocator(edt->pi.pool);
@@ -760,17 +809,14 @@ epan_dissect_packet_contains_field(epan_dissect_t* edt,
 {
 	GPtrArray* array;
 	int field_id;
-	gboolean contains_field;
 
 	if (!edt || !edt->tree)
 		return FALSE;
 	field_id = proto_get_id_by_filter_name(field_name);
 	if (field_id < 0)
 		return FALSE;
-	array = proto_find_finfo(edt->tree, field_id);
-	contains_field = (array->len > 0) ? TRUE : FALSE;
-	g_ptr_array_free(array, TRUE);
-	return contains_field;
+	array = proto_find_finfo_indexed(edt->tree, field_id);
+	return (array != NULL && array->len > 0);
 }
 
 /*
@@ -48,6 +48,21 @@ extern "C" {
 
 enum { except_no_call, except_call };
 
+/*
+ * Nothing changes the signal mask between a TRY and a THROW, so there's
+ * no need to save and restore it.  On the BSDs and macOS, setjmp() and
+ * longjmp() do, which costs a system call for every TRY block; use the
+ * variants that don't.  Elsewhere, setjmp() already doesn't.
+ */
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+    defined(__OpenBSD__) || defined(__DragonFly__)
+#define except_setjmp(env)          _setjmp(env)
+#define except_longjmp(env, val)    _longjmp(env, val)
+#else
+#define except_setjmp(env)          setjmp(env)
+#define except_longjmp(env, val)    longjmp(env, val)
+#endif
+
 typedef struct {
     unsigned long except_group;
     unsigned long except_code;
@@ -174,7 +189,7 @@ WS_DLL_PUBLIC void except_free(void *);
         struct except_stacknode except_sn;                      \
         struct except_catch except_ch;                          \
         except_setup_try(&except_sn, &except_ch, ID, NUM);      \
-        if (setjmp(except_ch.except_jmp))                       \
+        if (except_setjmp(except_ch.except_jmp))                \
             *(PPE) = &except_ch.except_obj;                     \
         else                                                    \
             *(PPE) = 0
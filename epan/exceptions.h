@@ -417,7 +417,7 @@
 	 * about with except_state in here would indicate that THROW is \
 	 * doing the wrong thing.                   \
 	 */					    \
-        longjmp(except_ch.except_jmp,1);            \
+        except_longjmp(except_ch.except_jmp,1);     \
     }
 
 #define EXCEPT_CODE			except_code(exc)
@@ -62,6 +62,15 @@ typedef void (*export_object_gui_reset_cb)(void);
  */
 WS_DLL_PUBLIC int register_export_object(const int proto_id, tap_packet_cb export_packet_func, export_object_gui_reset_cb reset_cb);
 
+/** Note that the Export Object handler for a protocol changes entries,
+ * through get_entry, after it has added them. Otherwise an entry is
+ * assumed to be complete once it has been added, so that it can be
+ * saved and freed straight away.
+ *
+ * @param proto_id is the protocol passed to register_export_object
+ */
+WS_DLL_PUBLIC void set_eo_entries_updated(const int proto_id);
+
 /** Get protocol ID from Export Object
  *
  * @param eo Registered Export Object
@@ -90,6 +99,13 @@ WS_DLL_PUBLIC tap_packet_cb get_eo_packet_func(register_eo_t* eo);
  */
 WS_DLL_PUBLIC export_object_gui_reset_cb get_eo_reset_func(register_eo_t* eo);
 
+/** Get whether entries can change after they are added
+ *
+ * @param eo Registered Export Object
+ * @return TRUE if set_eo_entries_updated was called for the protocol
+ */
+WS_DLL_PUBLIC gboolean get_eo_entries_updated(register_eo_t* eo);
+
 /** Get Export Object by its short protocol name
  *
  * @param name short protocol name to fetch.
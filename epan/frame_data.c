@@ -230,13 +230,62 @@ frame_data_init(frame_data *fdata, guint32 num, const wtap_rec *rec,
   fdata->abs_ts = rec->ts;
   fdata->has_modified_block = 0;
   fdata->need_colorize = 0;
-  fdata->color_filter = NULL;
-  fdata->shift_offset.secs = 0;
-  fdata->shift_offset.nsecs = 0;
+  fdata->color_index = 0;
+  fdata->has_shift_offset = 0;
   fdata->frame_ref_num = 0;
   fdata->prev_dis_num = 0;
 }
 
+/* Time shifts applied by the user, keyed by frame_data pointer. */
+static GHashTable *shift_offsets;
+
+void
+frame_data_get_shift_offset(const frame_data *fdata, nstime_t *shift_offset)
+{
+  const nstime_t *offset = NULL;
+
+  if (fdata->has_shift_offset && shift_offsets)
+    offset = (const nstime_t *)g_hash_table_lookup(shift_offsets, fdata);
+  if (offset)
+    *shift_offset = *offset;
+  else
+    nstime_set_zero(shift_offset);
+}
+
+void
+frame_data_set_shift_offset(frame_data *fdata, const nstime_t *shift_offset)
+{
+  nstime_t *offset;
+
+  if (nstime_is_zero(shift_offset)) {
+    if (fdata->has_shift_offset) {
+      g_hash_table_remove(shift_offsets, fdata);
+      fdata->has_shift_offset = 0;
+    }
+    return;
+  }
+
+  if (!shift_offsets)
+    shift_offsets = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+  offset = g_new(nstime_t, 1);
+  *offset = *shift_offset;
+  g_hash_table_insert(shift_offsets, fdata, offset);
+  fdata->has_shift_offset = 1;
+}
+
+/*
+ * Not done by frame_data_destroy(), which is also used to throw away
+ * per-packet data when redissecting, and that must keep the shift.
+ */
+void
+frame_data_clear_shift_offset(frame_data *fdata)
+{
+  if (fdata->has_shift_offset) {
+    g_hash_table_remove(shift_offsets, fdata);
+    fdata->has_shift_offset = 0;
+  }
+}
+
 void
 frame_data_set_before_dissect(frame_data *fdata,
                 nstime_t *elapsed_time,
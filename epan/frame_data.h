@@ -59,7 +59,6 @@ typedef enum {
    XXX - shuffle the fields to try to keep the most commonly-accessed
    fields within the first 16 or 32 bytes, so they all fit in a cache
    line? */
-struct _color_filter; /* Forward */
 DIAG_OFF_PEDANTIC
 typedef struct _frame_data {
   guint32      num;          /**< Frame number */
@@ -67,11 +66,10 @@ typedef struct _frame_data {
   guint32      cap_len;      /**< Amount actually captured */
   guint32      cum_bytes;    /**< Cumulative bytes into the capture */
   gint64       file_off;     /**< File offset */
-  /* These two are pointers, meaning 64-bit on LP64 (64-bit UN*X) and
-     LLP64 (64-bit Windows) platforms.  Put them here, one after the
-     other, so they don't require padding between them. */
+  /* This is a pointer, meaning 64-bit on LP64 (64-bit UN*X) and
+     LLP64 (64-bit Windows) platforms.  Put it here, after the 64-bit
+     file offset, so it doesn't require padding. */
   GSList      *pfd;          /**< Per frame proto data */
-  const struct _color_filter *color_filter;  /**< Per-packet matching color_filter_t object */
   guint16      subnum;       /**< subframe number, for protocols that require this */
   /* Keep the bitfields below to 16 bits, so this plus the previous field
      are 32 bits. */
@@ -86,12 +84,15 @@ typedef struct _frame_data {
   unsigned int has_ts           : 1; /**< 1 = has time stamp, 0 = no time stamp */
   unsigned int has_modified_block : 1; /** 1 = block for this packet has been modified */
   unsigned int need_colorize    : 1; /**< 1 = need to (re-)calculate packet color */
+  unsigned int has_shift_offset : 1; /**< 1 = time stamp has been shifted, see frame_data_get_shift_offset() */
   unsigned int tsprec           : 4; /**< Time stamp precision -2^tsprec gives up to femtoseconds */
-  nstime_t     abs_ts;       /**< Absolute timestamp */
-  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
+  /* Put this here, so it fills the 32 bits that would otherwise be
+     padding before abs_ts on LP64 and LLP64 platforms. */
   guint32      frame_ref_num; /**< Previous reference frame (0 if this is one) */
+  nstime_t     abs_ts;       /**< Absolute timestamp */
   guint32      prev_dis_num; /**< Previous displayed frame (0 if first one) */
   guint8       tcp_snd_manual_analysis;   /**< TCP SEQ Analysis Overriding, 0 = none, 1 = OOO, 2 = RET , 3 = Fast RET, 4 = Spurious RET */
+  guint16      color_index;  /**< Matching color filter, see color_filters_get_by_index(); 0 if none */
 } frame_data;
 DIAG_ON_PEDANTIC
 
@@ -106,6 +107,23 @@ WS_DLL_PUBLIC void frame_data_init(frame_data *fdata, guint32 num,
                 const wtap_rec *rec, gint64 offset,
                 guint32 cum_bytes);
 
+/**
+ * Gets how much the frame's abs_ts has been shifted by the user.
+ *
+ * Very few frames are ever shifted, so the offset is kept in a table
+ * outside frame_data rather than costing 16 bytes in every frame; the
+ * frame must not move in memory while it has one.
+ */
+WS_DLL_PUBLIC void frame_data_get_shift_offset(const frame_data *fdata,
+                nstime_t *shift_offset);
+
+/** Sets how much the frame's abs_ts has been shifted by the user. */
+WS_DLL_PUBLIC void frame_data_set_shift_offset(frame_data *fdata,
+                const nstime_t *shift_offset);
+
+/** Forgets the frame's shift; done when the frame itself is freed. */
+extern void frame_data_clear_shift_offset(frame_data *fdata);
+
 extern void frame_delta_abs_time(const struct epan_session *epan, const frame_data *fdata,
                 guint32 prev_num, nstime_t *delta);
 /**
@@ -12,6 +12,10 @@
 
 #include <glib.h>
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #include <epan/packet.h>
 
 #include "frame_data_sequence.h"
@@ -29,9 +33,49 @@
 #define LOG2_NODES_PER_LEVEL    10
 #define NODES_PER_LEVEL         (1<<LOG2_NODES_PER_LEVEL)
 
+/*
+ * The leaf nodes are carved, in frame order, out of large chunks of
+ * memory rather than being allocated one by one, so that walking the
+ * frames in order - as refiltering and retapping do - touches memory
+ * sequentially instead of hopping between scattered 72K allocations,
+ * and a 100M-frame file needs a few hundred mappings rather than
+ * 100,000 of them.  Each chunk has twice as many leaves as the one
+ * before it, up to ARENA_MAX_CHUNK_LEAVES, so small files don't pay
+ * for a big chunk.
+ *
+ * Where available, chunks of 2MB or more are mapped so that the
+ * kernel can back them with transparent huge pages, or, if the
+ * WIRESHARK_FRAME_HUGETLB environment variable is set, explicitly
+ * with MAP_HUGETLB huge pages, which must have been reserved.
+ */
+#define ARENA_MAX_CHUNK_LEAVES  256
+#define ARENA_HUGE_PAGE_SIZE    (2*1024*1024)
+
+/*
+ * To find frames by time, we keep, for each leaf node, the latest time
+ * stamp of any frame up to and including the last frame in that leaf.
+ * That's non-decreasing even if the frames aren't in time order, and the
+ * first frame at or after a given time is in the first leaf whose
+ * latest time is at or after it, so a binary search over the leaves
+ * followed by a scan of at most one leaf finds it.  That costs 16 bytes
+ * per 1024 frames.
+ */
+
+typedef struct {
+  void        *mem;             /* Start of the chunk */
+  size_t       size;            /* Size of the chunk */
+  gboolean     mapped;          /* Allocated with mmap() rather than g_malloc() */
+} arena_chunk;
+
 struct _frame_data_sequence {
   guint32      count;           /* Total number of frames */
   void        *ptree_root;      /* Pointer to the root node */
+  GArray      *chunks;          /* arena_chunks the leaf nodes are in */
+  frame_data  *next_leaf;       /* Next free leaf in the last chunk */
+  guint        leaves_left;     /* Number of free leaves in the last chunk */
+  GArray      *leaf_max_ts;     /* Latest time stamp up to the end of each leaf */
+  nstime_t     max_ts;          /* Latest time stamp so far */
+  gboolean     time_index_stale; /* leaf_max_ts needs to be rebuilt */
 };
 
 /*
@@ -55,9 +99,115 @@ new_frame_data_sequence(void)
   fds = (frame_data_sequence *)g_malloc(sizeof *fds);
   fds->count = 0;
   fds->ptree_root = NULL;
+  fds->chunks = g_array_new(FALSE, FALSE, sizeof (arena_chunk));
+  fds->next_leaf = NULL;
+  fds->leaves_left = 0;
+  fds->leaf_max_ts = g_array_new(FALSE, FALSE, sizeof (nstime_t));
+  nstime_set_unset(&fds->max_ts);
+  fds->time_index_stale = FALSE;
   return fds;
 }
 
+/*
+ * Add a frame's time stamp to the time index; frames must be added in
+ * frame number order.
+ */
+static void
+time_index_add(frame_data_sequence *fds, const frame_data *fdata)
+{
+  if (fdata->has_ts &&
+      (nstime_is_unset(&fds->max_ts) || nstime_cmp(&fdata->abs_ts, &fds->max_ts) > 0))
+    fds->max_ts = fdata->abs_ts;
+
+  /* fdata->num - 1 is the frame's index. */
+  if (LEAF_INDEX(fdata->num - 1) == 0)
+    g_array_append_val(fds->leaf_max_ts, fds->max_ts);
+  else
+    g_array_index(fds->leaf_max_ts, nstime_t, fds->leaf_max_ts->len - 1) = fds->max_ts;
+}
+
+static void *
+arena_chunk_map(size_t *size)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS)
+  static int use_hugetlb = -1;
+  size_t map_size;
+  void *mem;
+
+  if (*size < ARENA_HUGE_PAGE_SIZE)
+    return NULL;
+
+  map_size = (*size + ARENA_HUGE_PAGE_SIZE - 1) & ~((size_t)ARENA_HUGE_PAGE_SIZE - 1);
+
+#ifdef MAP_HUGETLB
+  if (use_hugetlb == -1)
+    use_hugetlb = g_getenv("WIRESHARK_FRAME_HUGETLB") != NULL;
+  if (use_hugetlb) {
+    mem = mmap(NULL, map_size, PROT_READ|PROT_WRITE,
+               MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+    if (mem != MAP_FAILED) {
+      *size = map_size;
+      return mem;
+    }
+    /* No huge pages reserved; don't try again. */
+    use_hugetlb = 0;
+  }
+#else
+  (void)use_hugetlb;
+#endif
+
+  mem = mmap(NULL, map_size, PROT_READ|PROT_WRITE,
+             MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED)
+    return NULL;
+#ifdef MADV_HUGEPAGE
+  madvise(mem, map_size, MADV_HUGEPAGE);
+#endif
+  *size = map_size;
+  return mem;
+#else
+  (void)size;
+  return NULL;
+#endif
+}
+
+/*
+ * Get memory for a new leaf node.
+ */
+static frame_data *
+arena_new_leaf(frame_data_sequence *fds)
+{
+  frame_data *leaf;
+
+  if (fds->leaves_left == 0) {
+    arena_chunk chunk;
+    guint leaves;
+
+    /* Double the number of leaves in each chunk, up to a limit. */
+    if (fds->chunks->len < 8)
+      leaves = MIN(1U << fds->chunks->len, ARENA_MAX_CHUNK_LEAVES);
+    else
+      leaves = ARENA_MAX_CHUNK_LEAVES;
+    chunk.size = (sizeof (frame_data))*NODES_PER_LEVEL*leaves;
+    chunk.mem = arena_chunk_map(&chunk.size);
+    chunk.mapped = chunk.mem != NULL;
+    if (chunk.mapped) {
+      /* Use the space up to the end of the last huge page as well. */
+      leaves = (guint)(chunk.size / ((sizeof (frame_data))*NODES_PER_LEVEL));
+    } else {
+      chunk.mem = g_malloc(chunk.size);
+    }
+    g_array_append_val(fds->chunks, chunk);
+    fds->next_leaf = (frame_data *)chunk.mem;
+    fds->leaves_left = leaves;
+  }
+
+  leaf = fds->next_leaf;
+  fds->next_leaf += NODES_PER_LEVEL;
+  fds->leaves_left--;
+  return leaf;
+}
+
 /*
  * Add a new frame_data structure to a frame_data_sequence.
  */
@@ -80,7 +230,7 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
   if (fds->count == 0) {
     /* The tree is empty; allocate the first leaf node, which will be
        the root node. */
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+    leaf = arena_new_leaf(fds);
     node = &leaf[0];
     fds->ptree_root = leaf;
   } else if (fds->count < NODES_PER_LEVEL) {
@@ -91,7 +241,7 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     /* It's a 1-level tree that will turn into a 2-level tree. */
     level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
     level1[0] = (frame_data *)fds->ptree_root;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+    leaf = arena_new_leaf(fds);
     level1[1] = leaf;
     node = &leaf[0];
     fds->ptree_root = level1;
@@ -100,7 +250,7 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     level1 = (frame_data **)fds->ptree_root;
     leaf = level1[fds->count >> LOG2_NODES_PER_LEVEL];
     if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+      leaf = arena_new_leaf(fds);
       level1[fds->count >> LOG2_NODES_PER_LEVEL] = leaf;
     }
     node = &leaf[LEAF_INDEX(fds->count)];
@@ -110,7 +260,7 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     level2[0] = (frame_data **)fds->ptree_root;
     level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
     level2[1] = level1;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+    leaf = arena_new_leaf(fds);
     level1[0] = leaf;
     node = &leaf[0];
     fds->ptree_root = level2;
@@ -124,7 +274,7 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     }
     leaf = level1[LEVEL_1_INDEX(fds->count)];
     if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+      leaf = arena_new_leaf(fds);
       level1[LEVEL_1_INDEX(fds->count)] = leaf;
     }
     node = &leaf[LEAF_INDEX(fds->count)];
@@ -136,7 +286,7 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     level3[1] = level2;
     level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
     level2[0] = level1;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+    leaf = arena_new_leaf(fds);
     level1[0] = leaf;
     node = &leaf[0];
     fds->ptree_root = level3;
@@ -162,13 +312,15 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     }
     leaf = level1[LEVEL_1_INDEX(fds->count)];
     if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
+      leaf = arena_new_leaf(fds);
       level1[LEVEL_1_INDEX(fds->count)] = leaf;
     }
     node = &leaf[LEAF_INDEX(fds->count)];
   }
   *node = *fdata;
   fds->count++;
+  if (!fds->time_index_stale)
+    time_index_add(fds, node);
   return node;
 }
 
@@ -224,6 +376,97 @@ frame_data_sequence_find(frame_data_sequence *fds, guint32 num)
   return &leaf[LEAF_INDEX(num)];
 }
 
+/*
+ * Get the frame_data for the frame after fdata, or for the first frame
+ * if fdata is NULL.
+ */
+frame_data *
+frame_data_sequence_next(frame_data_sequence *fds, frame_data *fdata)
+{
+  if (fdata == NULL)
+    return frame_data_sequence_find(fds, 1);
+
+  /*
+   * fdata->num is the index of the next frame; if that isn't the
+   * first entry of a leaf node, the next frame is right after this
+   * one, and we don't need to walk the tree.
+   */
+  if (LEAF_INDEX(fdata->num) != 0 && fdata->num < fds->count)
+    return fdata + 1;
+  return frame_data_sequence_find(fds, fdata->num + 1);
+}
+
+/*
+ * Rebuild the time index from scratch.
+ */
+static void
+time_index_rebuild(frame_data_sequence *fds)
+{
+  frame_data *fdata;
+
+  g_array_set_size(fds->leaf_max_ts, 0);
+  nstime_set_unset(&fds->max_ts);
+  for (fdata = frame_data_sequence_next(fds, NULL); fdata != NULL;
+       fdata = frame_data_sequence_next(fds, fdata))
+    time_index_add(fds, fdata);
+  fds->time_index_stale = FALSE;
+}
+
+/*
+ * Find the first frame whose time stamp is at or after ts.
+ */
+frame_data *
+frame_data_sequence_find_by_time(frame_data_sequence *fds, const nstime_t *ts)
+{
+  guint lo, hi, mid;
+  guint32 num, last;
+  frame_data *fdata;
+
+  if (fds == NULL || fds->count == 0)
+    return NULL;
+
+  if (fds->time_index_stale)
+    time_index_rebuild(fds);
+
+  /* Find the first leaf with a frame at or after ts. */
+  lo = 0;
+  hi = fds->leaf_max_ts->len;
+  while (lo < hi) {
+    const nstime_t *leaf_max;
+
+    mid = lo + (hi - lo) / 2;
+    leaf_max = &g_array_index(fds->leaf_max_ts, nstime_t, mid);
+    if (nstime_is_unset(leaf_max) || nstime_cmp(leaf_max, ts) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo == fds->leaf_max_ts->len)
+    return NULL;
+
+  /* Every frame in earlier leaves is before ts; scan this one. */
+  num = (lo << LOG2_NODES_PER_LEVEL) + 1;
+  last = MIN(num + NODES_PER_LEVEL - 1, fds->count);
+  for (fdata = frame_data_sequence_find(fds, num); fdata != NULL && fdata->num <= last;
+       fdata = frame_data_sequence_next(fds, fdata)) {
+    if (fdata->has_ts && nstime_cmp(&fdata->abs_ts, ts) >= 0)
+      return fdata;
+  }
+
+  /* Shouldn't happen, as the leaf's latest time is at or after ts. */
+  return NULL;
+}
+
+/*
+ * Note that frame time stamps have changed.
+ */
+void
+frame_data_sequence_times_changed(frame_data_sequence *fds)
+{
+  if (fds != NULL)
+    fds->time_index_stale = TRUE;
+}
+
 /* recursively frees a frame_data radix level */
 static void
 free_frame_data_array(void *array, guint count, guint level, gboolean last)
@@ -266,11 +509,13 @@ free_frame_data_array(void *array, guint count, guint level, gboolean last)
 
     for (i=0; i < level_count; i++) {
       frame_data_destroy(&real_array[i]);
+      frame_data_clear_shift_offset(&real_array[i]);
     }
   }
 
-  /* free the array itself */
-  g_free(array);
+  /* free the array itself; leaf nodes are freed with their arena chunk */
+  if (level > 1)
+    g_free(array);
 }
 
 /*
@@ -280,6 +525,7 @@ void
 free_frame_data_sequence(frame_data_sequence *fds)
 {
   guint   levels;
+  guint   i;
 
   /* calculate how many levels we have */
   if (fds->count == 0) {
@@ -307,6 +553,21 @@ free_frame_data_sequence(frame_data_sequence *fds)
     free_frame_data_array(fds->ptree_root, fds->count, levels, TRUE);
   }
 
+  /* free the arena the leaf nodes were in */
+  for (i = 0; i < fds->chunks->len; i++) {
+    arena_chunk *chunk = &g_array_index(fds->chunks, arena_chunk, i);
+
+#ifdef HAVE_SYS_MMAN_H
+    if (chunk->mapped) {
+      munmap(chunk->mem, chunk->size);
+      continue;
+    }
+#endif
+    g_free(chunk->mem);
+  }
+  g_array_free(fds->chunks, TRUE);
+  g_array_free(fds->leaf_max_ts, TRUE);
+
   /* free the header struct */
   g_free(fds);
 }
@@ -28,6 +28,28 @@ WS_DLL_PUBLIC frame_data *frame_data_sequence_add(frame_data_sequence *fds,
 WS_DLL_PUBLIC frame_data *frame_data_sequence_find(frame_data_sequence *fds,
     guint32 num);
 
+/*
+ * Get the frame_data for the frame after fdata, or for the first frame
+ * if fdata is NULL; returns NULL after the last frame.  Cheaper than
+ * frame_data_sequence_find() when walking all frames in order.
+ */
+WS_DLL_PUBLIC frame_data *frame_data_sequence_next(frame_data_sequence *fds,
+    frame_data *fdata);
+
+/*
+ * Find the first frame whose time stamp is at or after ts, or NULL if
+ * there's no such frame.  This is O(log n) in the number of frames, even
+ * if the frames aren't in time order.
+ */
+WS_DLL_PUBLIC frame_data *frame_data_sequence_find_by_time(frame_data_sequence *fds,
+    const nstime_t *ts);
+
+/*
+ * Note that the time stamps of frames already in the sequence have been
+ * changed, e.g. by a time shift, so that the time index gets rebuilt.
+ */
+WS_DLL_PUBLIC void frame_data_sequence_times_changed(frame_data_sequence *fds);
+
 /*
  * Free a frame_data_sequence and all the frame_data structures in it.
  */
@@ -0,0 +1,127 @@
+/* frame_data_test.c
+ * Tests for frame_data time shifts.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/frame_data.h>
+#include <epan/frame_data_sequence.h>
+#include <wiretap/wtap.h>
+
+#define TEST_FRAMES 3
+
+static frame_data_sequence *
+new_test_sequence(void)
+{
+    frame_data_sequence *fds = new_frame_data_sequence();
+    wtap_rec rec;
+    frame_data fdlocal;
+    guint32 num;
+
+    memset(&rec, 0, sizeof rec);
+    rec.rec_type = REC_TYPE_PACKET;
+    rec.presence_flags = WTAP_HAS_TS;
+    rec.tsprec = WTAP_TSPREC_USEC;
+    rec.rec_header.packet_header.caplen = 60;
+    rec.rec_header.packet_header.len = 60;
+    for (num = 1; num <= TEST_FRAMES; num++) {
+        rec.ts.secs = num;
+        frame_data_init(&fdlocal, num, &rec, 60 * (num - 1), 60 * (num - 1));
+        frame_data_sequence_add(fds, &fdlocal);
+    }
+    return fds;
+}
+
+static void
+test_shift_survives_redissect(void)
+{
+    frame_data_sequence *fds = new_test_sequence();
+    frame_data *fdata = frame_data_sequence_find(fds, 2);
+    nstime_t shift = NSTIME_INIT_SECS_NSECS(5, 250);
+    nstime_t offset;
+
+    frame_data_set_shift_offset(fdata, &shift);
+    frame_data_get_shift_offset(fdata, &offset);
+    g_assert_cmpint(nstime_cmp(&offset, &shift), ==, 0);
+
+    /*
+     * Redissecting throws away each frame's per-packet data, the
+     * selected frame's with frame_data_destroy() and the rest with
+     * frame_data_reset(); neither may take the shift with it.
+     */
+    frame_data_destroy(fdata);
+    frame_data_get_shift_offset(fdata, &offset);
+    g_assert_cmpint(nstime_cmp(&offset, &shift), ==, 0);
+    frame_data_reset(fdata);
+    frame_data_get_shift_offset(fdata, &offset);
+    g_assert_cmpint(nstime_cmp(&offset, &shift), ==, 0);
+
+    /* The other frames aren't shifted. */
+    frame_data_get_shift_offset(frame_data_sequence_find(fds, 1), &offset);
+    g_assert_true(nstime_is_zero(&offset));
+    frame_data_get_shift_offset(frame_data_sequence_find(fds, 3), &offset);
+    g_assert_true(nstime_is_zero(&offset));
+
+    /* Setting a zero shift drops it. */
+    nstime_set_zero(&shift);
+    frame_data_set_shift_offset(fdata, &shift);
+    frame_data_get_shift_offset(fdata, &offset);
+    g_assert_true(nstime_is_zero(&offset));
+
+    free_frame_data_sequence(fds);
+}
+
+static void
+test_shift_freed_with_sequence(void)
+{
+    frame_data_sequence *fds = new_test_sequence();
+    nstime_t shift = NSTIME_INIT_SECS_NSECS(-1, 0);
+    nstime_t offset;
+    guint32 num;
+
+    for (num = 1; num <= TEST_FRAMES; num++)
+        frame_data_set_shift_offset(frame_data_sequence_find(fds, num), &shift);
+    free_frame_data_sequence(fds);
+
+    /* A new file's frames start out unshifted. */
+    fds = new_test_sequence();
+    for (num = 1; num <= TEST_FRAMES; num++) {
+        frame_data_get_shift_offset(frame_data_sequence_find(fds, num), &offset);
+        g_assert_true(nstime_is_zero(&offset));
+    }
+    free_frame_data_sequence(fds);
+}
+
+int
+main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/frame_data/shift_survives_redissect", test_shift_survives_redissect);
+    g_test_add_func("/frame_data/shift_freed_with_sequence", test_shift_freed_with_sequence);
+
+    return g_test_run();
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
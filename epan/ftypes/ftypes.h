@@ -312,7 +312,7 @@ fvalue_init(fvalue_t *fv, ftenum_t ftype);
 void
 fvalue_cleanup(fvalue_t *fv);
 
-void
+WS_DLL_PUBLIC void
 fvalue_free(fvalue_t *fv);
 
 WS_DLL_PUBLIC
@@ -435,7 +435,7 @@ fvalue_get_sinteger64(fvalue_t *fv);
 WS_DLL_PUBLIC double
 fvalue_get_floating(fvalue_t *fv);
 
-ft_bool_t
+WS_DLL_PUBLIC ft_bool_t
 fvalue_eq(const fvalue_t *a, const fvalue_t *b);
 
 ft_bool_t
@@ -447,13 +447,13 @@ fvalue_gt(const fvalue_t *a, const fvalue_t *b);
 ft_bool_t
 fvalue_ge(const fvalue_t *a, const fvalue_t *b);
 
-ft_bool_t
+WS_DLL_PUBLIC ft_bool_t
 fvalue_lt(const fvalue_t *a, const fvalue_t *b);
 
 ft_bool_t
 fvalue_le(const fvalue_t *a, const fvalue_t *b);
 
-ft_bool_t
+WS_DLL_PUBLIC ft_bool_t
 fvalue_contains(const fvalue_t *a, const fvalue_t *b);
 
 ft_bool_t
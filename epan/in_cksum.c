@@ -13,10 +13,23 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <epan/tvbuff.h>
 #include <epan/in_cksum.h>
+#include <wsutil/ws_cpuid.h>
+
+#include "in_cksum_int.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IN_CKSUM_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define IN_CKSUM_NEON
+#endif
 
 /*
  * Checksum routine for Internet Protocol family headers (Portable Version).
@@ -28,6 +41,119 @@
 #define ADDCARRY(x)  {if ((x) > 65535) (x) -= 65535;}
 #define REDUCE {l_util.l = sum; sum = l_util.s[0] + l_util.s[1]; ADDCARRY(sum);}
 
+/*
+ * The bulk of the data is summed by one of the routines below, which
+ * take a run of 16-bit words and return their one's complement sum,
+ * folded to 16 bits. Summing the words of a run two or four at a time
+ * in wider integers, as they do, gives the same sum: the carries out of
+ * each 16 bits end up being added back in when the result is folded
+ * (RFC 1071, section 2).
+ */
+guint32
+in_cksum_fold(guint64 sum)
+{
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return (guint32)sum;
+}
+
+/* Sum the 32-bit halves of each 64 bits into a 64-bit total, which
+ * can't overflow for any buffer we could be given. */
+guint32
+in_cksum_words_scalar(const guint8 *p, size_t len)
+{
+	guint64 sum = 0;
+	guint64 v;
+	guint16 w;
+
+	while (len >= 8) {
+		memcpy(&v, p, sizeof v);
+		sum += (guint32)v;
+		sum += v >> 32;
+		p += 8;
+		len -= 8;
+	}
+	while (len >= 2) {
+		memcpy(&w, p, sizeof w);
+		sum += w;
+		p += 2;
+		len -= 2;
+	}
+	return in_cksum_fold(sum);
+}
+
+#ifdef IN_CKSUM_SSE2
+/* 64-bit lanes, each adding 32-bit words; several accumulators, so that
+ * the additions needn't wait for one another. */
+static guint32
+in_cksum_words_sse2(const guint8 *p, size_t len)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i acc0 = _mm_setzero_si128();
+	__m128i acc1 = _mm_setzero_si128();
+	__m128i acc2 = _mm_setzero_si128();
+	__m128i acc3 = _mm_setzero_si128();
+	__m128i v0, v1;
+	guint64 lanes[2];
+
+	while (len >= 32) {
+		v0 = _mm_loadu_si128((const __m128i *)(const void *)p);
+		v1 = _mm_loadu_si128((const __m128i *)(const void *)(p + 16));
+		acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(v0, zero));
+		acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(v0, zero));
+		acc2 = _mm_add_epi64(acc2, _mm_unpacklo_epi32(v1, zero));
+		acc3 = _mm_add_epi64(acc3, _mm_unpackhi_epi32(v1, zero));
+		p += 32;
+		len -= 32;
+	}
+	acc0 = _mm_add_epi64(_mm_add_epi64(acc0, acc1), _mm_add_epi64(acc2, acc3));
+	_mm_storeu_si128((__m128i *)(void *)lanes, acc0);
+	return in_cksum_fold((guint64)in_cksum_fold(lanes[0]) +
+			in_cksum_fold(lanes[1]) + in_cksum_words_scalar(p, len));
+}
+#endif
+
+#ifdef IN_CKSUM_NEON
+/* Two 64-bit lanes, each adding two 32-bit words per 16 bytes. */
+static guint32
+in_cksum_words_neon(const guint8 *p, size_t len)
+{
+	uint64x2_t acc = vdupq_n_u64(0);
+
+	while (len >= 16) {
+		acc = vpadalq_u32(acc, vreinterpretq_u32_u8(vld1q_u8(p)));
+		p += 16;
+		len -= 16;
+	}
+	return in_cksum_fold((guint64)in_cksum_fold(vgetq_lane_u64(acc, 0)) +
+			in_cksum_fold(vgetq_lane_u64(acc, 1)) + in_cksum_words_scalar(p, len));
+}
+#endif
+
+typedef guint32 (*in_cksum_words_func)(const guint8 *p, size_t len);
+
+static in_cksum_words_func
+in_cksum_select_words(void)
+{
+#ifdef HAVE_AVX2
+	if (ws_cpuid_avx2())
+		return in_cksum_words_avx2;
+#endif
+#if defined(IN_CKSUM_SSE2)
+	return in_cksum_words_sse2;
+#elif defined(IN_CKSUM_NEON)
+	return in_cksum_words_neon;
+#else
+	return in_cksum_words_scalar;
+#endif
+}
+
+/* Chosen on first use; threads racing to do that all store the same thing. */
+static in_cksum_words_func in_cksum_words;
+
 int
 in_cksum(const vec_t *vec, int veclen)
 {
@@ -45,6 +171,9 @@ in_cksum(const vec_t *vec, int veclen)
 		guint32	l;
 	} l_util;
 
+	if (G_UNLIKELY(in_cksum_words == NULL))
+		in_cksum_words = in_cksum_select_words();
+
 	for (; veclen != 0; vec++, veclen--) {
 		if (vec->len == 0)
 			continue;
@@ -76,22 +205,15 @@ in_cksum(const vec_t *vec, int veclen)
 			byte_swapped = 1;
 		}
 		/*
-		 * Unroll the loop to make overhead from
-		 * branches &c small.
+		 * Sum all the whole words at once, leaving
+		 * at most one byte.
 		 */
-		while ((mlen -= 32) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			sum += w[4]; sum += w[5]; sum += w[6]; sum += w[7];
-			sum += w[8]; sum += w[9]; sum += w[10]; sum += w[11];
-			sum += w[12]; sum += w[13]; sum += w[14]; sum += w[15];
-			w += 16;
-		}
-		mlen += 32;
-		while ((mlen -= 8) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			w += 4;
+		if (mlen >= 2) {
+			REDUCE;
+			sum += in_cksum_words((const guint8 *)w, mlen & ~1);
+			w += mlen / 2;
+			mlen &= 1;
 		}
-		mlen += 8;
 		if (mlen == 0 && byte_swapped == 0)
 			continue;
 		REDUCE;
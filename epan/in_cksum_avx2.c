@@ -0,0 +1,64 @@
+/* in_cksum_avx2.c
+ * Internet checksum routine with AVX2 intrinsics
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <glib.h>
+
+#include <immintrin.h>
+
+#include "in_cksum_int.h"
+
+/* 64-bit lanes, each adding 32-bit words, as in in_cksum_words_sse2();
+ * the caller has checked with ws_cpuid_avx2() that we can use this. */
+guint32
+in_cksum_words_avx2(const guint8 *p, size_t len)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i acc0 = _mm256_setzero_si256();
+	__m256i acc1 = _mm256_setzero_si256();
+	__m256i acc2 = _mm256_setzero_si256();
+	__m256i acc3 = _mm256_setzero_si256();
+	__m256i v0, v1;
+	guint64 lanes[4];
+
+	while (len >= 64) {
+		v0 = _mm256_loadu_si256((const __m256i *)(const void *)p);
+		v1 = _mm256_loadu_si256((const __m256i *)(const void *)(p + 32));
+		acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v0, zero));
+		acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v0, zero));
+		acc2 = _mm256_add_epi64(acc2, _mm256_unpacklo_epi32(v1, zero));
+		acc3 = _mm256_add_epi64(acc3, _mm256_unpackhi_epi32(v1, zero));
+		p += 64;
+		len -= 64;
+	}
+	acc0 = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+	_mm256_storeu_si256((__m256i *)(void *)lanes, acc0);
+	return in_cksum_fold((guint64)in_cksum_fold(lanes[0]) +
+			in_cksum_fold(lanes[1]) + in_cksum_fold(lanes[2]) +
+			in_cksum_fold(lanes[3]) + in_cksum_words_scalar(p, len));
+}
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,26 @@
+/** @file
+ * Internet checksum routines, used by in_cksum.c
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __IN_CKSUM_INT_H__
+#define __IN_CKSUM_INT_H__
+
+#include <glib.h>
+
+/* Fold a sum of 16-bit words, however wide, to 16 bits. */
+guint32 in_cksum_fold(guint64 sum);
+
+/* Return the folded sum of the len / 2 16-bit words at p; len is even. */
+guint32 in_cksum_words_scalar(const guint8 *p, size_t len);
+
+#ifdef HAVE_AVX2
+guint32 in_cksum_words_avx2(const guint8 *p, size_t len);
+#endif
+
+#endif /* __IN_CKSUM_INT_H__ */
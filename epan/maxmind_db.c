@@ -66,6 +66,12 @@ typedef struct _mmdbr_response_t {
 
 static wmem_map_t *mmdb_ipv4_map;
 static wmem_map_t *mmdb_ipv6_map;
+
+// Map value for addresses that have been sent to mmdbresolve, but not
+// answered yet.
+static mmdb_lookup_t mmdb_pending;
+// Requests made while resolving synchronously, each of which gets a response.
+static guint mmdb_sync_requests_in_flight;
 static GAsyncQueue *mmdbr_response_q; // g_allocated mmdbr_response_t *
 static GThread *read_mmdbr_stdout_thread;
 
@@ -168,6 +174,7 @@ write_mmdbr_stdin_worker(gpointer data _U_) {
     GIOStatus status;
     GError *err = NULL;
     gsize bytes_written;
+    GString *requests = g_string_new("");
     MMDB_DEBUG("starting write worker");
 
     while (1) {
@@ -183,20 +190,37 @@ write_mmdbr_stdin_worker(gpointer data _U_) {
         }
         if (strcmp(request, mmdbr_stop_sentinel) == 0) {
             g_free(request);
+            g_string_free(requests, TRUE);
             return NULL;
         }
 
-        MMDB_DEBUG("write %s ql %d", request, g_async_queue_length(mmdbr_request_q));
-        status = g_io_channel_write_chars(mmdbr_pipe.stdin_io, request, strlen(request), &bytes_written, &err);
+        // Send everything that's queued up in one write.
+        gboolean stopping = FALSE;
+        g_string_assign(requests, request);
+        g_free(request);
+        while (!stopping && (request = (char *) g_async_queue_try_pop(mmdbr_request_q)) != NULL) {
+            if (strcmp(request, mmdbr_stop_sentinel) == 0) {
+                stopping = TRUE;
+            } else {
+                g_string_append(requests, request);
+            }
+            g_free(request);
+        }
+
+        MMDB_DEBUG("write %s ql %d", requests->str, g_async_queue_length(mmdbr_request_q));
+        status = g_io_channel_write_chars(mmdbr_pipe.stdin_io, requests->str, requests->len, &bytes_written, &err);
         if (status != G_IO_STATUS_NORMAL) {
             MMDB_DEBUG("write error %s. exiting thread.", err->message);
             g_clear_error(&err);
-            g_free(request);
+            g_string_free(requests, TRUE);
             return NULL;
         }
         g_clear_error(&err);
-        g_free(request);
+        if (stopping) {
+            break;
+        }
     }
+    g_string_free(requests, TRUE);
     return NULL;
 }
 
@@ -412,6 +436,7 @@ static void mmdb_resolve_stop(void) {
         g_free(response);
         MMDB_DEBUG("cleaned response %p", response);
     }
+    mmdb_sync_requests_in_flight = 0;
 }
 
 /**
@@ -633,6 +658,10 @@ static void maxmind_db_pop_response(mmdb_response_t *response)
     }
     MMDB_DEBUG("popped response %s city %s country %s", response->is_ipv4 ? "v4" : "v6", mmdb_val->city, mmdb_val->country);
 
+    if (mmdb_sync_requests_in_flight > 0) {
+        mmdb_sync_requests_in_flight--;
+    }
+
     if (response->is_ipv4) {
         wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(response->ipv4_addr), mmdb_val);
     } else {
@@ -645,7 +674,7 @@ static void maxmind_db_await_response(void)
 {
     mmdb_response_t *response;
 
-    if (mmdbr_response_q != NULL) {
+    if (mmdbr_response_q != NULL && mmdb_sync_requests_in_flight > 0) {
         MMDB_DEBUG("entering blocking wait for response");
         response = (mmdb_response_t *) g_async_queue_pop(mmdbr_response_q);
         MMDB_DEBUG("exiting blocking wait for response");
@@ -670,50 +699,75 @@ gboolean maxmind_db_lookup_process(void)
     return new_entries;
 }
 
+static void
+maxmind_db_request(const char *addr_str) {
+    MMDB_DEBUG("looking up %s", addr_str);
+    g_async_queue_push(mmdbr_request_q, ws_strdup_printf("%s\n", addr_str));
+    if (resolve_synchronously) {
+        mmdb_sync_requests_in_flight++;
+    }
+}
+
+void
+maxmind_db_prefetch_ipv4(const ws_in4_addr *addr) {
+    if (wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr))) {
+        return;
+    }
+
+    if (mmdbr_pipe_valid()) {
+        char addr_str[WS_INET_ADDRSTRLEN];
+        ws_inet_ntop4(addr, addr_str, WS_INET_ADDRSTRLEN);
+        wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), &mmdb_pending);
+        maxmind_db_request(addr_str);
+    } else {
+        wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), &mmdb_not_found);
+    }
+}
+
+void
+maxmind_db_prefetch_ipv6(const ws_in6_addr *addr) {
+    if (wmem_map_lookup(mmdb_ipv6_map, addr->bytes)) {
+        return;
+    }
+
+    if (mmdbr_pipe_valid()) {
+        char addr_str[WS_INET6_ADDRSTRLEN];
+        ws_inet_ntop6(addr, addr_str, WS_INET6_ADDRSTRLEN);
+        wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), &mmdb_pending);
+        maxmind_db_request(addr_str);
+    } else {
+        wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), &mmdb_not_found);
+    }
+}
+
 const mmdb_lookup_t *
 maxmind_db_lookup_ipv4(const ws_in4_addr *addr) {
+    maxmind_db_prefetch_ipv4(addr);
+
     mmdb_lookup_t *result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr));
 
-    if (!result) {
-        result = &mmdb_not_found;
-        wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), result);
-
-        if (mmdbr_pipe_valid()) {
-            char addr_str[WS_INET_ADDRSTRLEN];
-            ws_inet_ntop4(addr, addr_str, WS_INET_ADDRSTRLEN);
-            MMDB_DEBUG("looking up %s", addr_str);
-            g_async_queue_push(mmdbr_request_q, ws_strdup_printf("%s\n", addr_str));
-            if (resolve_synchronously) {
-                maxmind_db_await_response();
-                result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr));
-            }
-        }
+    // Responses come back in the order the requests were made, so this
+    // also collects the results of any addresses prefetched before this one.
+    while (result == &mmdb_pending && resolve_synchronously && mmdb_sync_requests_in_flight > 0) {
+        maxmind_db_await_response();
+        result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr));
     }
 
-    return result;
+    return result == &mmdb_pending ? &mmdb_not_found : result;
 }
 
 const mmdb_lookup_t *
 maxmind_db_lookup_ipv6(const ws_in6_addr *addr) {
-    mmdb_lookup_t * result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
-
-    if (!result) {
-        result = &mmdb_not_found;
-        wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), result);
-
-        if (mmdbr_pipe_valid()) {
-            char addr_str[WS_INET6_ADDRSTRLEN];
-            ws_inet_ntop6(addr, addr_str, WS_INET6_ADDRSTRLEN);
-            MMDB_DEBUG("looking up %s", addr_str);
-            g_async_queue_push(mmdbr_request_q, ws_strdup_printf("%s\n", addr_str));
-            if (resolve_synchronously) {
-                maxmind_db_await_response();
-                result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
-            }
-        }
+    maxmind_db_prefetch_ipv6(addr);
+
+    mmdb_lookup_t *result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
+
+    while (result == &mmdb_pending && resolve_synchronously && mmdb_sync_requests_in_flight > 0) {
+        maxmind_db_await_response();
+        result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
     }
 
-    return result;
+    return result == &mmdb_pending ? &mmdb_not_found : result;
 }
 
 gchar *
@@ -745,6 +799,11 @@ maxmind_db_set_synchrony(gboolean synchronous) {
     resolve_synchronously = synchronous;
 }
 
+gboolean
+maxmind_db_is_running(void) {
+    return mmdbr_pipe_valid();
+}
+
 #else // HAVE_MAXMINDDB
 
 void
@@ -770,6 +829,12 @@ maxmind_db_lookup_ipv6(const ws_in6_addr *addr _U_) {
     return &mmdb_not_found;
 }
 
+void
+maxmind_db_prefetch_ipv4(const ws_in4_addr *addr _U_) {}
+
+void
+maxmind_db_prefetch_ipv6(const ws_in6_addr *addr _U_) {}
+
 gchar *
 maxmind_db_get_paths(void) {
     return g_strdup("");
@@ -780,6 +845,11 @@ maxmind_db_set_synchrony(gboolean synchronous _U_) {
     /* Nothing to set. */
 }
 
+gboolean
+maxmind_db_is_running(void) {
+    return FALSE;
+}
+
 #endif // HAVE_MAXMINDDB
 
 
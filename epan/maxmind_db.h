@@ -62,6 +62,23 @@ WS_DLL_PUBLIC WS_RETNONNULL const mmdb_lookup_t *maxmind_db_lookup_ipv4(const ws
  */
 WS_DLL_PUBLIC WS_RETNONNULL const mmdb_lookup_t *maxmind_db_lookup_ipv6(const ws_in6_addr *addr);
 
+/**
+ * Start looking up an IPv4 address without waiting for the result.
+ * When lookups are synchronous, prefetching all the addresses that are
+ * about to be looked up lets them be resolved together, rather than
+ * waiting for the resolver once for each of them.
+ *
+ * @param addr IPv4 address to look up
+ */
+WS_DLL_PUBLIC void maxmind_db_prefetch_ipv4(const ws_in4_addr *addr);
+
+/**
+ * Start looking up an IPv6 address without waiting for the result.
+ *
+ * @param addr IPv6 address to look up
+ */
+WS_DLL_PUBLIC void maxmind_db_prefetch_ipv6(const ws_in6_addr *addr);
+
 /**
  * Get all configured paths
  *
@@ -97,6 +114,14 @@ static inline gboolean maxmind_db_has_coords(const mmdb_lookup_t *result)
  */
 WS_DLL_PUBLIC void maxmind_db_set_synchrony(gboolean synchronous);
 
+/**
+ * Check whether we have databases to look addresses up in, i.e. whether
+ * the resolver process that does the lookups is running.
+ *
+ * @return TRUE if lookups can be done, FALSE otherwise.
+ */
+WS_DLL_PUBLIC gboolean maxmind_db_is_running(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
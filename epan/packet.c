@@ -33,6 +33,8 @@
 #include <epan/wmem_scopes.h>
 
 #include <epan/column-info.h>
+#include <epan/conversation.h>
+#include <epan/dissector_profile.h>
 #include <epan/exceptions.h>
 #include <epan/reassemble.h>
 #include <epan/stream.h>
@@ -40,6 +42,7 @@
 #include <epan/prefs.h>
 #include <epan/range.h>
 
+#include <wsutil/bits_ctz.h>
 #include <wsutil/str_util.h>
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
@@ -92,8 +95,32 @@ struct dissector_table {
 	protocol_t	*protocol;
 	GHashFunc	hash_func;
 	gboolean	supports_decode_as;
+	/*
+	 * The last lookup in a uint table, and what it found (NULL if
+	 * nothing).  Stacked encapsulations look up the same value in
+	 * the same table over and over (e.g. the ethertype of the inner
+	 * and outer Ethernet headers, or the UDP port of a tunnel), so
+	 * this saves the hash lookup for most packets.  Any change to
+	 * the table's entries clears it.
+	 */
+	gboolean	last_uint_valid;
+	guint32		last_uint;
+	dtbl_entry_t	*last_uint_entry;
+	/*
+	 * The values that have been looked up in a uint table since the
+	 * last init_dissection(), whether or not anything was found, so
+	 * that a change to the table, e.g. from Decode As, can be checked
+	 * for whether it could affect any packet dissected so far.  Values
+	 * below SEEN_UINTS_BITMAP_VALUES - ports, ethertypes and the like,
+	 * i.e. nearly all of them - are in a bitmap, the others in a hash
+	 * table.  Both are allocated on first use.
+	 */
+	guint8		*seen_uints;
+	GHashTable	*seen_uints_large;
 };
 
+#define SEEN_UINTS_BITMAP_VALUES	65536
+
 /*
  * Dissector tables. const char * -> dissector_table *
  */
@@ -193,6 +220,9 @@ destroy_dissector_table(void *data)
 
 	g_hash_table_destroy(table->hash_table);
 	g_slist_free(table->dissector_handles);
+	g_free(table->seen_uints);
+	if (table->seen_uints_large)
+		g_hash_table_destroy(table->seen_uints_large);
 	g_slice_free(struct dissector_table, data);
 }
 
@@ -337,12 +367,28 @@ init_dissection(void)
 	expert_packet_init();
 }
 
+static void
+forget_seen_uints(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	struct dissector_table *sub_dissectors = (struct dissector_table *)value;
+
+	g_free(sub_dissectors->seen_uints);
+	sub_dissectors->seen_uints = NULL;
+	if (sub_dissectors->seen_uints_large) {
+		g_hash_table_destroy(sub_dissectors->seen_uints_large);
+		sub_dissectors->seen_uints_large = NULL;
+	}
+}
+
 void
 cleanup_dissection(void)
 {
 	/* Cleanup protocol-specific variables. */
 	g_slist_foreach(cleanup_routines, &call_routine, NULL);
 
+	/* The next dissection starts with no table lookups recorded. */
+	g_hash_table_foreach(dissector_tables, forget_seen_uints, NULL);
+
 	/* Cleanup the stream-handling tables */
 	stream_cleanup();
 
@@ -478,6 +524,35 @@ final_registration_all_protocols(void)
 }
 
 
+/*
+ * With a time budget, the time by which the record being dissected has
+ * to be done; it's checked before each dissector is called.
+ */
+static gint64 dissection_budget_us;
+static gint64 dissection_deadline;
+
+void
+set_dissection_time_budget(guint64 budget_us)
+{
+	dissection_budget_us = (gint64)MIN(budget_us, (guint64)G_MAXINT64 / 2);
+}
+
+static inline void
+start_dissection_budget(void)
+{
+	if (G_UNLIKELY(dissection_budget_us != 0))
+		dissection_deadline = g_get_monotonic_time() + dissection_budget_us;
+}
+
+static inline void
+check_dissection_budget(void)
+{
+	if (G_UNLIKELY(dissection_budget_us != 0) &&
+	    g_get_monotonic_time() > dissection_deadline) {
+		THROW_MESSAGE(DissectorError, "Dissection took longer than the time allowed for a packet");
+	}
+}
+
 /* Creates the top-most tvbuff and calls dissect_frame() */
 void
 dissect_record(epan_dissect_t *edt, int file_type_subtype,
@@ -530,6 +605,7 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 		break;
 	}
 
+	start_dissection_budget();
 	if (cinfo != NULL)
 		col_init(cinfo, edt->session);
 	edt->pi.epan = edt->session;
@@ -647,6 +723,7 @@ dissect_file(epan_dissect_t *edt, wtap_rec *rec,
 {
 	file_data_t file_dissector_data;
 
+	start_dissection_budget();
 	if (cinfo != NULL)
 		col_init(cinfo, edt->session);
 	edt->pi.epan = edt->session;
@@ -804,6 +881,49 @@ remove_last_layer(packet_info *pinfo, gboolean reduce_count)
  * The only time this function will return 0 is if it is a new style dissector
  * and if the dissector rejected the packet.
  */
+static int
+call_dissector_func(dissector_handle_t handle, tvbuff_t *tvb,
+		    packet_info *pinfo, proto_tree *tree, void *data)
+{
+	int len;
+
+	if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
+		len = ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
+	}
+	else if (handle->dissector_type == DISSECTOR_TYPE_CALLBACK) {
+		len = ((dissector_cb_t)handle->dissector_func)(tvb, pinfo, tree, data, handle->dissector_data);
+	}
+	else {
+		ws_assert_not_reached();
+	}
+	return len;
+}
+
+/*
+ * Call the dissector for a handle, charging the time it takes, and
+ * what it allocates, to its protocol; the profile has to be told
+ * when the dissector is left, even if it throws an exception.
+ */
+static int
+call_dissector_func_profiled(dissector_handle_t handle, tvbuff_t *tvb,
+			     packet_info *pinfo, proto_tree *tree, void *data)
+{
+	volatile int len = 0;
+
+	dissector_profile_enter(handle->protocol, proto_get_id(handle->protocol),
+	    NULL, pinfo);
+	TRY {
+		len = call_dissector_func(handle, tvb, pinfo, tree, data);
+	}
+	CATCH_ALL {
+		dissector_profile_leave(pinfo, FALSE);
+		RETHROW;
+	}
+	ENDTRY;
+	dissector_profile_leave(pinfo, len != 0);
+	return len;
+}
+
 static int
 call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			      packet_info *pinfo, proto_tree *tree, void *data)
@@ -811,6 +931,8 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 	const char *saved_proto;
 	int         len;
 
+	check_dissection_budget();
+
 	saved_proto = pinfo->current_proto;
 
 	if ((handle->protocol != NULL) && (!proto_is_pino(handle->protocol))) {
@@ -818,14 +940,12 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			proto_get_protocol_short_name(handle->protocol);
 	}
 
-	if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
-		len = ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
-	}
-	else if (handle->dissector_type == DISSECTOR_TYPE_CALLBACK) {
-		len = ((dissector_cb_t)handle->dissector_func)(tvb, pinfo, tree, data, handle->dissector_data);
-	}
-	else {
-		ws_assert_not_reached();
+	proto_run_deferred_init_protocol(handle->protocol);
+
+	if (G_UNLIKELY(dissector_profiling) && handle->protocol != NULL) {
+		len = call_dissector_func_profiled(handle, tvb, pinfo, tree, data);
+	} else {
+		len = call_dissector_func(handle, tvb, pinfo, tree, data);
 	}
 	pinfo->current_proto = saved_proto;
 
@@ -1102,11 +1222,17 @@ find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 		ws_assert_not_reached();
 	}
 
+	if (sub_dissectors->last_uint_valid && sub_dissectors->last_uint == pattern)
+		return sub_dissectors->last_uint_entry;
+
 	/*
 	 * Find the entry.
 	 */
-	return (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table,
+	sub_dissectors->last_uint_entry = (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table,
 				   GUINT_TO_POINTER(pattern));
+	sub_dissectors->last_uint = pattern;
+	sub_dissectors->last_uint_valid = TRUE;
+	return sub_dissectors->last_uint_entry;
 }
 
 #if 0
@@ -1188,6 +1314,7 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	sub_dissectors->last_uint_valid = FALSE;
 
 	/*
 	 * Now, if this table supports "Decode As", add this handle
@@ -1339,6 +1466,7 @@ dissector_delete_uint(const char *name, const guint32 pattern,
 		 */
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		sub_dissectors->last_uint_valid = FALSE;
 	}
 }
 
@@ -1380,6 +1508,7 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	ws_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
+	sub_dissectors->last_uint_valid = FALSE;
 }
 
 static void
@@ -1389,6 +1518,7 @@ dissector_delete_from_table(gpointer key _U_, gpointer value, gpointer user_data
 	ws_assert (sub_dissectors);
 
 	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
+	sub_dissectors->last_uint_valid = FALSE;
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
 }
 
@@ -1434,6 +1564,7 @@ dissector_change_uint(const char *name, const guint32 pattern, dissector_handle_
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	sub_dissectors->last_uint_valid = FALSE;
 }
 
 /* Reset an entry in a uint dissector table to its initial value. */
@@ -1462,6 +1593,22 @@ dissector_reset_uint(const char *name, const guint32 pattern)
 	} else {
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		sub_dissectors->last_uint_valid = FALSE;
+	}
+}
+
+/* Record that a value has been looked up in a uint dissector table. */
+static inline void
+note_uint_lookup(dissector_table_t sub_dissectors, const guint32 uint_val)
+{
+	if (uint_val < SEEN_UINTS_BITMAP_VALUES) {
+		if (G_UNLIKELY(sub_dissectors->seen_uints == NULL))
+			sub_dissectors->seen_uints = (guint8 *)g_malloc0(SEEN_UINTS_BITMAP_VALUES / 8);
+		sub_dissectors->seen_uints[uint_val >> 3] |= (guint8)(1 << (uint_val & 7));
+	} else {
+		if (sub_dissectors->seen_uints_large == NULL)
+			sub_dissectors->seen_uints_large = g_hash_table_new(g_direct_hash, g_direct_equal);
+		g_hash_table_add(sub_dissectors->seen_uints_large, GUINT_TO_POINTER(uint_val));
 	}
 }
 
@@ -1475,6 +1622,7 @@ dissector_is_uint_changed(dissector_table_t const sub_dissectors, const guint32
 {
 	if (sub_dissectors != NULL) {
 		dtbl_entry_t *dtbl_entry = find_uint_dtbl_entry(sub_dissectors, uint_val);
+		note_uint_lookup(sub_dissectors, uint_val);
 		if (dtbl_entry != NULL)
 			return (dtbl_entry->current != dtbl_entry->initial);
 	}
@@ -1496,6 +1644,7 @@ dissector_try_uint_new(dissector_table_t sub_dissectors, const guint32 uint_val,
 	int len;
 
 	dtbl_entry = find_uint_dtbl_entry(sub_dissectors, uint_val);
+	note_uint_lookup(sub_dissectors, uint_val);
 	if (dtbl_entry == NULL) {
 		/*
 		 * There's no entry in the table for our value.
@@ -1558,6 +1707,7 @@ dissector_get_uint_handle(dissector_table_t const sub_dissectors, const guint32
 	dtbl_entry_t *dtbl_entry;
 
 	dtbl_entry = find_uint_dtbl_entry(sub_dissectors, uint_val);
+	note_uint_lookup(sub_dissectors, uint_val);
 	if (dtbl_entry != NULL)
 		return dtbl_entry->current;
 	else
@@ -2491,6 +2641,87 @@ dissector_all_tables_foreach_changed (DATFunc  func,
 	g_hash_table_foreach(dissector_tables, dissector_all_tables_foreach_func, &info);
 }
 
+/*
+ * The handles that the uint values looked up so far currently map to.
+ */
+typedef struct {
+	dissector_table_t	sub_dissectors;
+	guint32			uint_val;
+	dissector_handle_t	handle;
+} uint_lookup_t;
+
+struct dissector_uint_lookups {
+	GArray	*lookups;	/* uint_lookup_t */
+};
+
+static void
+save_uint_lookup(dissector_table_t sub_dissectors, guint32 uint_val, GArray *lookups)
+{
+	uint_lookup_t lookup;
+	dtbl_entry_t *dtbl_entry;
+
+	/* Not dissector_get_uint_handle(), which would note the lookup. */
+	dtbl_entry = find_uint_dtbl_entry(sub_dissectors, uint_val);
+	lookup.sub_dissectors = sub_dissectors;
+	lookup.uint_val = uint_val;
+	lookup.handle = dtbl_entry ? dtbl_entry->current : NULL;
+	g_array_append_val(lookups, lookup);
+}
+
+static void
+save_table_uint_lookups(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	dissector_table_t sub_dissectors = (dissector_table_t)value;
+	GArray *lookups = (GArray *)user_data;
+	GHashTableIter iter;
+	gpointer seen;
+	guint32 i;
+
+	if (sub_dissectors->seen_uints) {
+		for (i = 0; i < SEEN_UINTS_BITMAP_VALUES; i += 8) {
+			guint8 bits = sub_dissectors->seen_uints[i >> 3];
+
+			for (; bits != 0; bits &= bits - 1)
+				save_uint_lookup(sub_dissectors, i + ws_ctz(bits), lookups);
+		}
+	}
+	if (sub_dissectors->seen_uints_large) {
+		g_hash_table_iter_init(&iter, sub_dissectors->seen_uints_large);
+		while (g_hash_table_iter_next(&iter, &seen, NULL))
+			save_uint_lookup(sub_dissectors, GPOINTER_TO_UINT(seen), lookups);
+	}
+}
+
+dissector_uint_lookups_t *
+dissector_all_tables_save_uint_lookups(void)
+{
+	dissector_uint_lookups_t *saved = g_new(dissector_uint_lookups_t, 1);
+
+	saved->lookups = g_array_new(FALSE, FALSE, sizeof (uint_lookup_t));
+	g_hash_table_foreach(dissector_tables, save_table_uint_lookups, saved->lookups);
+	return saved;
+}
+
+gboolean
+dissector_all_tables_uint_lookups_changed(dissector_uint_lookups_t *saved)
+{
+	gboolean changed = FALSE;
+	guint i;
+
+	for (i = 0; i < saved->lookups->len; i++) {
+		uint_lookup_t *lookup = &g_array_index(saved->lookups, uint_lookup_t, i);
+		dtbl_entry_t *dtbl_entry = find_uint_dtbl_entry(lookup->sub_dissectors, lookup->uint_val);
+
+		if ((dtbl_entry ? dtbl_entry->current : NULL) != lookup->handle) {
+			changed = TRUE;
+			break;
+		}
+	}
+	g_array_free(saved->lookups, TRUE);
+	g_free(saved);
+	return changed;
+}
+
 /*
  * Walk one dissector table calling a user supplied function only on
  * any entry that has been changed from its original state.
@@ -2642,6 +2873,11 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 	sub_dissectors->param   = param;
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->supports_decode_as = FALSE;
+	sub_dissectors->last_uint_valid = FALSE;
+	sub_dissectors->last_uint = 0;
+	sub_dissectors->last_uint_entry = NULL;
+	sub_dissectors->seen_uints = NULL;
+	sub_dissectors->seen_uints_large = NULL;
 	g_hash_table_insert(dissector_tables, (gpointer)name, (gpointer) sub_dissectors);
 	return sub_dissectors;
 }
@@ -2672,6 +2908,11 @@ dissector_table_t register_custom_dissector_table(const char *name,
 	sub_dissectors->param   = BASE_NONE;
 	sub_dissectors->protocol  = find_protocol_by_id(proto);
 	sub_dissectors->supports_decode_as = FALSE;
+	sub_dissectors->last_uint_valid = FALSE;
+	sub_dissectors->last_uint = 0;
+	sub_dissectors->last_uint_entry = NULL;
+	sub_dissectors->seen_uints = NULL;
+	sub_dissectors->seen_uints_large = NULL;
 	g_hash_table_insert(dissector_tables, (gpointer)name, (gpointer) sub_dissectors);
 	return sub_dissectors;
 }
@@ -2827,6 +3068,7 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 	hdtbl_entry->short_name = g_strdup(internal_name);
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
+	hdtbl_entry->hits      = 0;
 
 	/* do the table insertion */
 	g_hash_table_insert(heuristic_short_names, (gpointer)hdtbl_entry->short_name, hdtbl_entry);
@@ -2881,6 +3123,163 @@ heur_dissector_delete(const char *name, heur_dissector_t dissector, const int pr
 	}
 }
 
+/*
+ * Call a heuristic dissector, charging the time it takes, and what it
+ * allocates, to it if we're profiling.
+ */
+static int
+call_heur_dissector_func(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			 packet_info *pinfo, proto_tree *tree, void *data)
+{
+	volatile int len = 0;
+
+	check_dissection_budget();
+
+	proto_run_deferred_init_protocol(hdtbl_entry->protocol);
+
+	if (G_LIKELY(!dissector_profiling) || hdtbl_entry->protocol == NULL) {
+		return (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	}
+
+	dissector_profile_enter(hdtbl_entry, proto_get_id(hdtbl_entry->protocol),
+	    hdtbl_entry->short_name, pinfo);
+	TRY {
+		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	}
+	CATCH_ALL {
+		dissector_profile_leave(pinfo, FALSE);
+		RETHROW;
+	}
+	ENDTRY;
+	dissector_profile_leave(pinfo, len != 0);
+	return len;
+}
+
+/*
+ * Try one heuristic dissector; returns what it returned, or -1 if it's
+ * disabled and wasn't tried.
+ */
+static int
+try_heur_dissector_entry(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			 packet_info *pinfo, proto_tree *tree, void *data,
+			 guint16 saved_can_desegment, guint saved_layers_len,
+			 guint saved_tree_count)
+{
+	int proto_id;
+	int len;
+
+	/* XXX - why set this now and above? */
+	pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
+
+	if (hdtbl_entry->protocol != NULL &&
+		(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
+		/*
+		 * No - don't try this dissector.
+		 */
+		return -1;
+	}
+
+	if (hdtbl_entry->protocol != NULL) {
+		proto_id = proto_get_id(hdtbl_entry->protocol);
+		/* do NOT change this behavior - wslua uses the protocol short name set here in order
+		   to determine which Lua-based heurisitc dissector to call */
+		pinfo->current_proto =
+			proto_get_protocol_short_name(hdtbl_entry->protocol);
+
+		/*
+		 * Add the protocol name to the layers; we'll remove it
+		 * if the dissector fails.
+		 */
+		add_layer(pinfo, proto_id);
+	}
+
+	pinfo->heur_list_name = hdtbl_entry->list_name;
+
+	len = call_heur_dissector_func(hdtbl_entry, tvb, pinfo, tree, data);
+	if (hdtbl_entry->protocol != NULL &&
+		(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
+		/*
+		 * We added a protocol layer above. The dissector
+		 * didn't accept the packet or it didn't add any
+		 * items to the tree so remove it from the list.
+		 */
+		while (wmem_list_count(pinfo->layers) > saved_layers_len) {
+			/*
+			 * Only reduce the layer number if the dissector
+			 * rejected the data. Since tree can be NULL on
+			 * the first pass, we cannot check it or it will
+			 * break dissectors that rely on a stable value.
+			 */
+			remove_last_layer(pinfo, len == 0);
+		}
+	}
+	return len;
+}
+
+/*
+ * Move the entry of a heuristic dissector list that just took a packet
+ * towards the front, for it to be tried sooner next time.
+ */
+static void
+promote_heur_dissector_entry(heur_dissector_list_t sub_dissectors,
+			     GSList *entry, GSList *prev_entry)
+{
+	heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+	GSList           **link;
+
+	if (prev_entry == NULL)
+		return;		/* it's already at the front */
+
+	switch (prefs.heur_dissector_order) {
+
+	case HEUR_ORDER_MOVE_TO_FRONT:
+		sub_dissectors->dissectors = g_slist_remove_link(sub_dissectors->dissectors, entry);
+		sub_dissectors->dissectors = g_slist_concat(entry, sub_dissectors->dissectors);
+		break;
+
+	case HEUR_ORDER_HIT_COUNT:
+		/*
+		 * Put it ahead of all the ones that have taken fewer
+		 * packets; the list is kept in that order, so they're
+		 * all just before it.  Those with the same count stay
+		 * ahead, so that two protocols taking turns don't keep
+		 * swapping places.
+		 */
+		for (link = &sub_dissectors->dissectors; *link != entry;
+		    link = &(*link)->next) {
+			if (((heur_dtbl_entry_t *)(*link)->data)->hits < hdtbl_entry->hits)
+				break;
+		}
+		if (*link != entry) {
+			prev_entry->next = entry->next;
+			entry->next = *link;
+			*link = entry;
+		}
+		break;
+	}
+}
+
+/*
+ * Note which heuristic dissector took the packet in the packet's
+ * conversation, or that none did.
+ */
+static void
+set_heur_conversation_hint(conversation_t *conv,
+			   heur_dissector_list_t sub_dissectors,
+			   heur_dtbl_entry_t *hdtbl_entry)
+{
+	if (conv == NULL)
+		return;
+	if (hdtbl_entry == NULL) {
+		if (conv->heur_hints != NULL)
+			wmem_map_remove(conv->heur_hints, sub_dissectors);
+		return;
+	}
+	if (conv->heur_hints == NULL)
+		conv->heur_hints = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+	wmem_map_insert(conv->heur_hints, sub_dissectors, hdtbl_entry);
+}
+
 gboolean
 dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			packet_info *pinfo, proto_tree *tree, heur_dtbl_entry_t **heur_dtbl_entry, void *data)
@@ -2893,7 +3292,8 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	guint16            saved_can_desegment;
 	guint              saved_layers_len = 0;
 	heur_dtbl_entry_t *hdtbl_entry;
-	int                proto_id;
+	heur_dtbl_entry_t *hint = NULL;
+	conversation_t    *conv = NULL;
 	int                len;
 	guint              saved_tree_count = tree ? tree->tree_data->count : 0;
 
@@ -2919,72 +3319,64 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 	DISSECTOR_ASSERT(saved_layers_len < PINFO_LAYER_MAX_RECURSION_DEPTH);
 
-	for (entry = sub_dissectors->dissectors; entry != NULL;
+	/*
+	 * If we're remembering which heuristic dissector took each
+	 * conversation, try the one that took this conversation's last
+	 * packet first.
+	 */
+	if (prefs.heur_conversation_hints) {
+		conv = find_conversation_pinfo(pinfo, 0);
+		if (conv != NULL && conv->heur_hints != NULL)
+			hint = (heur_dtbl_entry_t *)wmem_map_lookup(conv->heur_hints, sub_dissectors);
+		if (hint != NULL &&
+		    try_heur_dissector_entry(hint, tvb, pinfo, tree, data,
+			saved_can_desegment, saved_layers_len, saved_tree_count) > 0) {
+			if (ws_log_msg_is_active(WS_LOG_DOMAIN, LOG_LEVEL_DEBUG)) {
+				ws_debug("Frame: %d | Layers: %s | Dissector: %s (conversation hint)\n", pinfo->num, proto_list_layers(pinfo), hint->short_name);
+			}
+			hint->hits++;
+			*heur_dtbl_entry = hint;
+			status = TRUE;
+		}
+	}
+
+	for (entry = sub_dissectors->dissectors; entry != NULL && !status;
 	    entry = g_slist_next(entry)) {
-		/* XXX - why set this now and above? */
-		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
 		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
-
-		if (hdtbl_entry->protocol != NULL &&
-			(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
-			/*
-			 * No - don't try this dissector.
-			 */
+		if (hdtbl_entry == hint) {
+			/* We've already tried it. */
+			prev_entry = entry;
 			continue;
 		}
 
-		if (hdtbl_entry->protocol != NULL) {
-			proto_id = proto_get_id(hdtbl_entry->protocol);
-			/* do NOT change this behavior - wslua uses the protocol short name set here in order
-			   to determine which Lua-based heurisitc dissector to call */
-			pinfo->current_proto =
-				proto_get_protocol_short_name(hdtbl_entry->protocol);
-
-			/*
-			 * Add the protocol name to the layers; we'll remove it
-			 * if the dissector fails.
-			 */
-			add_layer(pinfo, proto_id);
-		}
-
-		pinfo->heur_list_name = hdtbl_entry->list_name;
-
-		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
-		if (hdtbl_entry->protocol != NULL &&
-			(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
-			/*
-			 * We added a protocol layer above. The dissector
-			 * didn't accept the packet or it didn't add any
-			 * items to the tree so remove it from the list.
-			 */
-			while (wmem_list_count(pinfo->layers) > saved_layers_len) {
-				/*
-				 * Only reduce the layer number if the dissector
-				 * rejected the data. Since tree can be NULL on
-				 * the first pass, we cannot check it or it will
-				 * break dissectors that rely on a stable value.
-				 */
-				remove_last_layer(pinfo, len == 0);
-			}
-		}
-		if (len) {
+		len = try_heur_dissector_entry(hdtbl_entry, tvb, pinfo, tree, data,
+		    saved_can_desegment, saved_layers_len, saved_tree_count);
+		if (len > 0) {
 			if (ws_log_msg_is_active(WS_LOG_DOMAIN, LOG_LEVEL_DEBUG)) {
 				ws_debug("Frame: %d | Layers: %s | Dissector: %s\n", pinfo->num, proto_list_layers(pinfo), hdtbl_entry->short_name);
 			}
 
 			*heur_dtbl_entry = hdtbl_entry;
+			hdtbl_entry->hits++;
 
-			/* Bubble the matched entry to the top for faster search next time. */
-			if (prev_entry != NULL) {
-				sub_dissectors->dissectors = g_slist_remove_link(sub_dissectors->dissectors, entry);
-				sub_dissectors->dissectors = g_slist_concat(entry, sub_dissectors->dissectors);
-			}
+			/* Move the matched entry up for faster search next time. */
+			promote_heur_dissector_entry(sub_dissectors, entry, prev_entry);
 			status = TRUE;
 			break;
 		}
 		prev_entry = entry;
 	}
 
+	if (prefs.heur_conversation_hints && *heur_dtbl_entry != hint) {
+		/*
+		 * The dissector that took the packet might just have set
+		 * up the conversation.
+		 */
+		if (conv == NULL && status)
+			conv = find_conversation_pinfo(pinfo, 0);
+		set_heur_conversation_hint(conv, sub_dissectors, *heur_dtbl_entry);
+	}
+
 	pinfo->current_proto = saved_curr_proto;
 	pinfo->heur_list_name = saved_heur_list_name;
 	pinfo->can_desegment = saved_can_desegment;
@@ -3487,7 +3879,7 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 	pinfo->heur_list_name = heur_dtbl_entry->list_name;
 
 	/* call the dissector, in case of failure call data handle (might happen with exported PDUs) */
-	if (!(*heur_dtbl_entry->dissector)(tvb, pinfo, tree, data)) {
+	if (!call_heur_dissector_func(heur_dtbl_entry, tvb, pinfo, tree, data)) {
 		call_dissector_work(data_handle, tvb, pinfo, tree, TRUE, NULL);
 
 		/*
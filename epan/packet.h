@@ -141,6 +141,32 @@ WS_DLL_PUBLIC void dissector_table_foreach (const char *table_name, DATFunc func
 WS_DLL_PUBLIC void dissector_all_tables_foreach_changed (DATFunc func,
     gpointer user_data);
 
+/** What the values looked up in uint dissector tables since dissection was
+ * last initialized map to. */
+typedef struct dissector_uint_lookups dissector_uint_lookups_t;
+
+/** Save the dissector that each value looked up in a uint dissector table
+ * since dissection was last initialized currently maps to.
+ *
+ * Save them before changing the tables, e.g. with Decode As, and pass them
+ * to dissector_all_tables_uint_lookups_changed() afterwards to find out
+ * whether the change can alter how any packet dissected so far is dissected.
+ *
+ * @return The saved lookups.
+ */
+WS_DLL_PUBLIC dissector_uint_lookups_t *dissector_all_tables_save_uint_lookups(void);
+
+/** Check whether any of the saved uint dissector table lookups would now
+ * find a different dissector, and free the saved lookups.
+ *
+ * Only uint tables are tracked; changes to string or custom tables must
+ * be assumed to change dissection.
+ *
+ * @param[in] saved The lookups saved by dissector_all_tables_save_uint_lookups().
+ * @return TRUE if any lookup would now find a different dissector.
+ */
+WS_DLL_PUBLIC gboolean dissector_all_tables_uint_lookups_changed(dissector_uint_lookups_t *saved);
+
 /** Iterate over dissectors in a table by handle.
  *
  * Walk one dissector table's list of handles calling a user supplied
@@ -459,6 +485,7 @@ typedef struct heur_dtbl_entry {
 	const gchar *display_name;     /* the string used to present heuristic to user */
 	gchar *short_name;     /* string used for "internal" use to uniquely identify heuristic */
 	gboolean enabled;
+	guint hits;            /* number of times it has taken a packet */
 } heur_dtbl_entry_t;
 
 /** A protocol uses this function to register a heuristic sub-dissector list.
@@ -803,6 +830,16 @@ extern void dissect_record(struct epan_dissect *edt, int file_type_subtype,
 extern void dissect_file(struct epan_dissect *edt,
     wtap_rec *rec, tvbuff_t *tvb, frame_data *fd, column_info *cinfo);
 
+/** Limit how long dissecting a single record may take.  Once a record
+ * has taken longer, each dissector called for it throws DissectorError
+ * instead of being called, so the rest of the record is left undissected
+ * and the tree says why.  The limit is off by default, and costs nothing
+ * then.  This mustn't be called in the middle of dissecting a record.
+ *
+ * @param budget_us The limit, in microseconds, or 0 for no limit.
+ */
+WS_DLL_PUBLIC void set_dissection_time_budget(guint64 budget_us);
+
 /* Structure passed to the ethertype dissector */
 typedef struct ethertype_data_s
 {
@@ -0,0 +1,642 @@
+/* perf_epan.c
+ * Microbenchmarks for tvbuffs, display filters, field values,
+ * conversations and exceptions.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Each benchmark runs an operation a given number of times.  Run
+ * "perf_epan -m perf" to time them: the number of times is raised until
+ * a run takes long enough to time, and the time per operation is
+ * reported.  Otherwise each one is run a few times, just to make sure
+ * that it works.  The allocator benchmarks are in wmem_test.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/address.h>
+#include <epan/conversation.h>
+#include <epan/exceptions.h>
+#include <epan/prefs.h>
+#include <epan/tvbuff.h>
+#include <epan/dfilter/dfilter.h>
+#include <epan/ftypes/ftypes.h>
+#include <wiretap/wtap.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/wslog.h>
+
+/* How long a timed run must take, in microseconds. */
+#define PERF_MIN_TIME   (500 * 1000)
+
+/* Iterations of each benchmark when not timing it. */
+#define SMOKE_ITERATIONS 100
+
+typedef void (*perf_func)(gconstpointer data, guint64 iterations);
+
+/* Results go here, so the compiler can't leave the work out. */
+static volatile guint64 perf_sink;
+
+static void
+perf_run(const char *name, perf_func func, gconstpointer data)
+{
+    guint64 iterations = 1;
+    gint64 start, elapsed;
+    double scale;
+
+    if (!g_test_perf()) {
+        func(data, SMOKE_ITERATIONS);
+        return;
+    }
+
+    for (;;) {
+        start = g_get_monotonic_time();
+        func(data, iterations);
+        elapsed = g_get_monotonic_time() - start;
+        if (elapsed >= PERF_MIN_TIME)
+            break;
+        /* Aim a bit past the minimum, growing at most tenfold a time. */
+        scale = elapsed > 0 ? 1.4 * PERF_MIN_TIME / elapsed : 10.0;
+        if (scale > 10.0)
+            scale = 10.0;
+        iterations = MAX(iterations + 1, (guint64)(iterations * scale));
+    }
+
+    g_test_minimized_result(elapsed * 1000.0 / iterations,
+        "%s: %.1f ns/op (%" G_GUINT64_FORMAT " iterations)",
+        name, elapsed * 1000.0 / iterations, iterations);
+}
+
+/*
+ * An Ethernet frame holding an HTTP request, from 192.168.0.1:50000 to
+ * 10.0.0.2:80.
+ */
+static const char http_request[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: perf_epan\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+static guint8 packet_data[1500];
+static guint packet_len;
+
+static void
+build_packet(void)
+{
+    static const guint8 headers[] = {
+        /* Ethernet */
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb,
+        0x08, 0x00,
+        /* IPv4; the total length is filled in below */
+        0x45, 0x00, 0x00, 0x00, 0x00, 0x01, 0x40, 0x00, 0x40, 0x06, 0x00, 0x00,
+        0xc0, 0xa8, 0x00, 0x01, 0x0a, 0x00, 0x00, 0x02,
+        /* TCP */
+        0xc3, 0x50, 0x00, 0x50, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+        0x50, 0x18, 0x72, 0x10, 0x00, 0x00, 0x00, 0x00,
+    };
+    guint ip_len;
+
+    memcpy(packet_data, headers, sizeof headers);
+    memcpy(packet_data + sizeof headers, http_request, strlen(http_request));
+    packet_len = (guint)(sizeof headers + strlen(http_request));
+    ip_len = packet_len - 14;
+    packet_data[16] = ip_len >> 8;
+    packet_data[17] = ip_len & 0xff;
+}
+
+/* tvbuffs */
+
+static guint8 tvb_data[1500];
+static wmem_allocator_t *perf_allocator;
+
+static void
+perf_tvb_get_guint8(gconstpointer data, guint64 iterations)
+{
+    tvbuff_t *tvb = (tvbuff_t *)data;
+    guint64 sum = 0;
+
+    for (guint64 i = 0; i < iterations; i++)
+        sum += tvb_get_guint8(tvb, (gint)(i & 1023));
+    perf_sink += sum;
+}
+
+static void
+perf_tvb_get_ntohs(gconstpointer data, guint64 iterations)
+{
+    tvbuff_t *tvb = (tvbuff_t *)data;
+    guint64 sum = 0;
+
+    for (guint64 i = 0; i < iterations; i++)
+        sum += tvb_get_ntohs(tvb, (gint)(i & 1023));
+    perf_sink += sum;
+}
+
+static void
+perf_tvb_get_ntohl(gconstpointer data, guint64 iterations)
+{
+    tvbuff_t *tvb = (tvbuff_t *)data;
+    guint64 sum = 0;
+
+    for (guint64 i = 0; i < iterations; i++)
+        sum += tvb_get_ntohl(tvb, (gint)(i & 1023));
+    perf_sink += sum;
+}
+
+static void
+perf_tvb_get_letohl(gconstpointer data, guint64 iterations)
+{
+    tvbuff_t *tvb = (tvbuff_t *)data;
+    guint64 sum = 0;
+
+    for (guint64 i = 0; i < iterations; i++)
+        sum += tvb_get_letohl(tvb, (gint)(i & 1023));
+    perf_sink += sum;
+}
+
+static void
+perf_tvb_get_ntoh64(gconstpointer data, guint64 iterations)
+{
+    tvbuff_t *tvb = (tvbuff_t *)data;
+    guint64 sum = 0;
+
+    for (guint64 i = 0; i < iterations; i++)
+        sum += tvb_get_ntoh64(tvb, (gint)(i & 1023));
+    perf_sink += sum;
+}
+
+static void
+perf_tvb_memcpy(gconstpointer data, guint64 iterations)
+{
+    tvbuff_t *tvb = (tvbuff_t *)data;
+    guint8 buf[16];
+    guint64 sum = 0;
+
+    for (guint64 i = 0; i < iterations; i++) {
+        tvb_memcpy(tvb, buf, (gint)(i & 1023), sizeof buf);
+        sum += buf[0];
+    }
+    perf_sink += sum;
+}
+
+static void
+perf_tvb_find_guint8(gconstpointer data, guint64 iterations)
+{
+    tvbuff_t *tvb = (tvbuff_t *)data;
+    guint64 sum = 0;
+
+    /* tvb_data has 0xff only at offset 1200. */
+    for (guint64 i = 0; i < iterations; i++)
+        sum += tvb_find_guint8(tvb, (gint)(i & 1023), -1, 0xff);
+    perf_sink += sum;
+}
+
+static void
+perf_tvb_get_string_enc(gconstpointer data, guint64 iterations)
+{
+    tvbuff_t *tvb = (tvbuff_t *)data;
+    guint64 sum = 0;
+
+    for (guint64 i = 0; i < iterations; i++) {
+        sum += tvb_get_string_enc(perf_allocator, tvb, (gint)(i & 1023), 32, ENC_ASCII)[0];
+        if ((i & 1023) == 1023)
+            wmem_free_all(perf_allocator);
+    }
+    wmem_free_all(perf_allocator);
+    perf_sink += sum;
+}
+
+static void
+run_tvb_accessors(const char *kind, tvbuff_t *tvb)
+{
+    static const struct {
+        const char *name;
+        perf_func func;
+    } accessors[] = {
+        { "tvb_get_guint8", perf_tvb_get_guint8 },
+        { "tvb_get_ntohs", perf_tvb_get_ntohs },
+        { "tvb_get_ntohl", perf_tvb_get_ntohl },
+        { "tvb_get_letohl", perf_tvb_get_letohl },
+        { "tvb_get_ntoh64", perf_tvb_get_ntoh64 },
+        { "tvb_memcpy 16 bytes", perf_tvb_memcpy },
+        { "tvb_find_guint8", perf_tvb_find_guint8 },
+        { "tvb_get_string_enc 32 bytes", perf_tvb_get_string_enc },
+    };
+    char *name;
+
+    for (size_t i = 0; i < G_N_ELEMENTS(accessors); i++) {
+        name = g_strdup_printf("%s %s", kind, accessors[i].name);
+        perf_run(name, accessors[i].func, tvb);
+        g_free(name);
+    }
+}
+
+static void
+perf_test_tvb_real(void)
+{
+    tvbuff_t *tvb = tvb_new_real_data(tvb_data, sizeof tvb_data, sizeof tvb_data);
+
+    run_tvb_accessors("real", tvb);
+    tvb_free(tvb);
+}
+
+static void
+perf_test_tvb_subset(void)
+{
+    tvbuff_t *tvb = tvb_new_real_data(tvb_data, sizeof tvb_data, sizeof tvb_data);
+    tvbuff_t *subset = tvb_new_subset_remaining(tvb, 14);
+
+    run_tvb_accessors("subset", subset);
+    tvb_free_chain(tvb);
+}
+
+static void
+perf_test_tvb_composite(void)
+{
+    tvbuff_t *tvb = tvb_new_real_data(tvb_data, sizeof tvb_data, sizeof tvb_data);
+    tvbuff_t *composite = tvb_new_composite();
+
+    /* Four members, so that many of the reads span two of them. */
+    for (gint i = 0; i < 4; i++)
+        tvb_composite_append(composite, tvb_new_subset_length(tvb, i * 375, 375));
+    tvb_composite_finalize(composite);
+
+    run_tvb_accessors("composite", composite);
+    /* The composite is in the chain of its first member. */
+    tvb_free_chain(tvb);
+}
+
+/* Display filters */
+
+static epan_t *perf_epan;
+static epan_dissect_t *perf_edt;
+
+static const struct {
+    const char *text;
+    gboolean passes;
+} perf_filters[] = {
+    { "tcp", TRUE },
+    { "tcp.port == 80", TRUE },
+    { "udp.port == 53", FALSE },
+    { "ip.src == 192.168.0.1 && tcp.flags.push == 1", TRUE },
+    { "ip.addr in {10.0.0.0/8 172.16.0.0/12}", TRUE },
+    { "tcp.len > 10 && !udp", TRUE },
+    { "http.request.method == \"GET\"", TRUE },
+    { "http.host contains \"example\"", TRUE },
+    { "frame matches \"(?i)user-agent\"", TRUE },
+};
+
+static const nstime_t *
+perf_get_frame_ts(struct packet_provider_data *prov _U_, guint32 frame_num _U_)
+{
+    static nstime_t empty;
+
+    return &empty;
+}
+
+/* Dissect the packet once, with a full tree, for the filters to look at. */
+static void
+dissect_packet(void)
+{
+    static const struct packet_provider_funcs funcs = {
+        perf_get_frame_ts,
+        NULL,
+        NULL,
+        NULL
+    };
+    static frame_data fdata;
+    wtap_rec rec;
+    nstime_t elapsed_time;
+    const frame_data *ref = NULL;
+    guint32 cum_bytes = 0;
+
+    perf_epan = epan_new(NULL, &funcs);
+    perf_edt = epan_dissect_new(perf_epan, TRUE, TRUE);
+
+    memset(&rec, 0, sizeof(rec));
+    rec.rec_type = REC_TYPE_PACKET;
+    rec.presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN;
+    rec.rec_header.packet_header.caplen = packet_len;
+    rec.rec_header.packet_header.len = packet_len;
+    rec.rec_header.packet_header.pkt_encap = WTAP_ENCAP_ETHERNET;
+
+    nstime_set_zero(&elapsed_time);
+    frame_data_init(&fdata, 1, &rec, 0, cum_bytes);
+    frame_data_set_before_dissect(&fdata, &elapsed_time, &ref, NULL);
+    epan_dissect_run(perf_edt, wtap_pcap_file_type_subtype(), &rec,
+        tvb_new_real_data(packet_data, packet_len, packet_len), &fdata, NULL);
+    frame_data_set_after_dissect(&fdata, &cum_bytes);
+}
+
+static void
+perf_dfilter_apply(gconstpointer data, guint64 iterations)
+{
+    const dfilter_t *dfcode = (const dfilter_t *)data;
+    guint64 passed = 0;
+
+    for (guint64 i = 0; i < iterations; i++)
+        passed += dfilter_apply_edt(dfcode, perf_edt);
+    perf_sink += passed;
+}
+
+static void
+perf_dfilter_compile(gconstpointer data, guint64 iterations)
+{
+    const char *text = (const char *)data;
+    dfilter_t *dfcode;
+
+    for (guint64 i = 0; i < iterations; i++) {
+        g_assert_true(dfilter_compile(text, &dfcode, NULL));
+        dfilter_free(dfcode);
+    }
+}
+
+static void
+perf_test_dfilter_apply(void)
+{
+    dfilter_t *dfcode;
+    char *err_msg = NULL;
+    char *name;
+
+    for (size_t i = 0; i < G_N_ELEMENTS(perf_filters); i++) {
+        if (!dfilter_compile(perf_filters[i].text, &dfcode, &err_msg)) {
+            g_test_message("%s: %s", perf_filters[i].text, err_msg);
+            g_free(err_msg);
+            g_test_fail();
+            continue;
+        }
+        g_assert_true(dfilter_apply_edt(dfcode, perf_edt) == perf_filters[i].passes);
+        name = g_strdup_printf("dfilter_apply %s", perf_filters[i].text);
+        perf_run(name, perf_dfilter_apply, dfcode);
+        g_free(name);
+        dfilter_free(dfcode);
+    }
+}
+
+static void
+perf_test_dfilter_compile(void)
+{
+    char *name;
+
+    for (size_t i = 0; i < G_N_ELEMENTS(perf_filters); i++) {
+        name = g_strdup_printf("dfilter_compile %s", perf_filters[i].text);
+        perf_run(name, perf_dfilter_compile, perf_filters[i].text);
+        g_free(name);
+    }
+}
+
+/* Field values */
+
+typedef ft_bool_t (*fvalue_cmp_func)(const fvalue_t *a, const fvalue_t *b);
+
+typedef struct {
+    fvalue_cmp_func cmp;
+    fvalue_t *a;
+    fvalue_t *b;
+} fvalue_cmp_data;
+
+static void
+perf_fvalue_cmp(gconstpointer data, guint64 iterations)
+{
+    const fvalue_cmp_data *cmp_data = (const fvalue_cmp_data *)data;
+    guint64 sum = 0;
+
+    for (guint64 i = 0; i < iterations; i++)
+        sum += cmp_data->cmp(cmp_data->a, cmp_data->b) == FT_TRUE;
+    perf_sink += sum;
+}
+
+static void
+run_fvalue_cmp(const char *name, fvalue_cmp_func cmp, ftenum_t ftype,
+    const char *a, const char *b, gboolean expected)
+{
+    fvalue_cmp_data cmp_data;
+    char *err_msg = NULL;
+
+    cmp_data.cmp = cmp;
+    cmp_data.a = fvalue_from_literal(ftype, a, FALSE, &err_msg);
+    g_assert_nonnull(cmp_data.a);
+    cmp_data.b = fvalue_from_literal(ftype, b, FALSE, &err_msg);
+    g_assert_nonnull(cmp_data.b);
+    g_assert_true((cmp(cmp_data.a, cmp_data.b) == FT_TRUE) == expected);
+
+    perf_run(name, perf_fvalue_cmp, &cmp_data);
+
+    fvalue_free(cmp_data.a);
+    fvalue_free(cmp_data.b);
+}
+
+static void
+perf_test_fvalue_compare(void)
+{
+    GString *haystack = g_string_new(NULL);
+
+    run_fvalue_cmp("fvalue_eq uint32", fvalue_eq, FT_UINT32, "80", "443", FALSE);
+    run_fvalue_cmp("fvalue_lt uint32", fvalue_lt, FT_UINT32, "80", "443", TRUE);
+    run_fvalue_cmp("fvalue_eq uint64", fvalue_eq, FT_UINT64,
+        "18446744073709551615", "18446744073709551615", TRUE);
+    run_fvalue_cmp("fvalue_eq ipv4", fvalue_eq, FT_IPv4, "192.168.0.1", "192.168.0.2", FALSE);
+    run_fvalue_cmp("fvalue_eq ipv6", fvalue_eq, FT_IPv6, "2001:db8::1", "2001:db8::1", TRUE);
+    run_fvalue_cmp("fvalue_eq ether", fvalue_eq, FT_ETHER,
+        "00:11:22:33:44:55", "00:11:22:33:44:55", TRUE);
+    run_fvalue_cmp("fvalue_eq string", fvalue_eq, FT_STRING,
+        "application/x-www-form-urlencoded", "application/x-www-form-urlencodee", FALSE);
+    run_fvalue_cmp("fvalue_contains string", fvalue_contains, FT_STRING,
+        "Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/115.0",
+        "Firefox", TRUE);
+
+    /* 256 bytes, with the needle at the end. */
+    for (guint i = 0; i < 256; i++)
+        g_string_append_printf(haystack, "%s%02x", i ? ":" : "", i < 252 ? i & 0x7f : i);
+    run_fvalue_cmp("fvalue_contains bytes", fvalue_contains, FT_BYTES,
+        haystack->str, "fc:fd:fe:ff", TRUE);
+    g_string_free(haystack, TRUE);
+}
+
+/* Conversations */
+
+#define PERF_CONVERSATIONS 10000
+
+typedef struct {
+    guint32 addr_a[PERF_CONVERSATIONS];
+    guint32 addr_b[PERF_CONVERSATIONS];
+    guint32 port_a[PERF_CONVERSATIONS];
+    guint32 port_b[PERF_CONVERSATIONS];
+    gboolean reversed;
+    guint32 port_offset;
+} conversation_data;
+
+static void
+perf_find_conversation(gconstpointer data, guint64 iterations)
+{
+    const conversation_data *conv = (const conversation_data *)data;
+    address addr_a, addr_b;
+    guint64 found = 0;
+    guint k;
+
+    for (guint64 i = 0; i < iterations; i++) {
+        /* Not in the order they were made in. */
+        k = (guint)((i * 7919) % PERF_CONVERSATIONS);
+        set_address(&addr_a, AT_IPv4, 4, &conv->addr_a[k]);
+        set_address(&addr_b, AT_IPv4, 4, &conv->addr_b[k]);
+        if (conv->reversed)
+            found += find_conversation(2, &addr_b, &addr_a, CONVERSATION_TCP,
+                conv->port_b[k] + conv->port_offset, conv->port_a[k], 0) != NULL;
+        else
+            found += find_conversation(2, &addr_a, &addr_b, CONVERSATION_TCP,
+                conv->port_a[k] + conv->port_offset, conv->port_b[k], 0) != NULL;
+    }
+    g_assert_true(found == (conv->port_offset ? 0 : iterations));
+    perf_sink += found;
+}
+
+static void
+perf_test_conversation_find(void)
+{
+    conversation_data *conv = g_new0(conversation_data, 1);
+    address addr_a, addr_b;
+
+    for (guint k = 0; k < PERF_CONVERSATIONS; k++) {
+        conv->addr_a[k] = g_htonl(0xc0a80000 | (k & 0xff));
+        conv->addr_b[k] = g_htonl(0x0a000000 | k);
+        conv->port_a[k] = 1024 + k;
+        conv->port_b[k] = k & 1 ? 443 : 80;
+        set_address(&addr_a, AT_IPv4, 4, &conv->addr_a[k]);
+        set_address(&addr_b, AT_IPv4, 4, &conv->addr_b[k]);
+        conversation_new(1, &addr_a, &addr_b, CONVERSATION_TCP,
+            conv->port_a[k], conv->port_b[k], 0);
+    }
+
+    perf_run("find_conversation", perf_find_conversation, conv);
+    conv->reversed = TRUE;
+    perf_run("find_conversation reversed", perf_find_conversation, conv);
+    conv->reversed = FALSE;
+    /* The ports are 1024 + k, so this misses every time. */
+    conv->port_offset = PERF_CONVERSATIONS;
+    perf_run("find_conversation not found", perf_find_conversation, conv);
+
+    g_free(conv);
+}
+
+/* Exceptions */
+
+/*
+ * A TRY block that nothing is thrown in is what every subdissector call
+ * costs; one that catches a ReportedBoundsError is what a truncated
+ * packet costs.
+ */
+static void
+perf_except_try(gconstpointer data _U_, guint64 iterations)
+{
+    /* Changed between setjmp() and longjmp(). */
+    volatile guint64 sum = 0;
+
+    for (guint64 i = 0; i < iterations; i++) {
+        TRY {
+            sum += i;
+        }
+        CATCH(ReportedBoundsError) {
+            sum--;
+        }
+        ENDTRY;
+    }
+    perf_sink += sum;
+}
+
+static void
+perf_except_throw(gconstpointer data _U_, guint64 iterations)
+{
+    /* Changed between setjmp() and longjmp(). */
+    volatile guint64 sum = 0;
+
+    for (guint64 i = 0; i < iterations; i++) {
+        TRY {
+            THROW(ReportedBoundsError);
+        }
+        CATCH(ReportedBoundsError) {
+            sum++;
+        }
+        ENDTRY;
+    }
+    perf_sink += sum;
+}
+
+static void
+perf_test_except_try(void)
+{
+    perf_run("TRY without a throw", perf_except_try, NULL);
+    perf_run("TRY with a caught throw", perf_except_throw, NULL);
+}
+
+int
+main(int argc, char **argv)
+{
+    char *configuration_init_error;
+    int ret;
+
+    ws_log_init("perf_epan", NULL);
+
+    g_test_init(&argc, &argv, NULL);
+
+    configuration_init_error = configuration_init(argv[0], NULL);
+    if (configuration_init_error != NULL) {
+        g_printerr("perf_epan: Can't get pathname of directory containing the program: %s.\n",
+            configuration_init_error);
+        g_free(configuration_init_error);
+    }
+
+    wtap_init(FALSE);
+    if (!epan_init(NULL, NULL, FALSE))
+        return 2;
+    epan_load_settings();
+    prefs_apply_all();
+
+    for (guint i = 0; i < sizeof tvb_data; i++)
+        tvb_data[i] = (guint8)(i * 31 % 251);
+    tvb_data[1200] = 0xff;
+    perf_allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+    build_packet();
+    dissect_packet();
+
+    g_test_add_func("/tvb/real", perf_test_tvb_real);
+    g_test_add_func("/tvb/subset", perf_test_tvb_subset);
+    g_test_add_func("/tvb/composite", perf_test_tvb_composite);
+    g_test_add_func("/dfilter/apply", perf_test_dfilter_apply);
+    g_test_add_func("/dfilter/compile", perf_test_dfilter_compile);
+    g_test_add_func("/ftypes/compare", perf_test_fvalue_compare);
+    g_test_add_func("/conversation/find", perf_test_conversation_find);
+    g_test_add_func("/except/try", perf_test_except_try);
+
+    ret = g_test_run();
+
+    epan_dissect_free(perf_edt);
+    epan_free(perf_epan);
+    wmem_destroy_allocator(perf_allocator);
+    epan_cleanup();
+    wtap_cleanup();
+
+    return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -141,6 +141,12 @@ static const enum_val_t gui_update_channel[] = {
     {NULL, NULL, -1}
 };
 
+static const enum_val_t heur_dissector_order_vals[] = {
+    {"MOVE_TO_FRONT", "Move the one that took the packet to the front", HEUR_ORDER_MOVE_TO_FRONT},
+    {"HIT_COUNT", "Order them by how many packets they have taken", HEUR_ORDER_HIT_COUNT},
+    {NULL, NULL, -1}
+};
+
 static const enum_val_t gui_selection_style[] = {
     {"DEFAULT", "DEFAULT",   COLOR_STYLE_DEFAULT},
     {"FLAT",    "FLAT",      COLOR_STYLE_FLAT},
@@ -3485,6 +3491,14 @@ prefs_register_modules(void)
                                    "To prevent sorting by mistake (which can take some time to calculate), it can be disabled",
                                    &prefs.gui_packet_list_sortable);
 
+    prefs_register_uint_preference(gui_module, "packet_list_cache_size",
+                                   "Packet list column text cache size (MB)",
+                                   "The amount of memory to use for the column text of packets that have been shown "
+                                   "in the packet list. Packets that haven't been shown recently are dissected again "
+                                   "when they're needed. 0 means no limit",
+                                   10,
+                                   &prefs.gui_packet_list_cache_size);
+
 
     prefs_register_bool_preference(gui_module, "interfaces_show_hidden",
                                    "Show hidden interfaces",
@@ -3750,6 +3764,19 @@ prefs_register_modules(void)
                                    "Currently ICMP and ICMPv6 use this preference to add VLAN ID to conversation tracking, and IPv4 uses this preference to take VLAN ID into account during reassembly",
                                    &prefs.strict_conversation_tracking_heuristics);
 
+    prefs_register_enum_preference(protocols_module, "heuristic_dissector_order",
+                                   "Order of heuristic dissectors",
+                                   "How to reorder each list of heuristic dissectors as they take packets, "
+                                   "so that the ones most likely to take the next packet are tried first.",
+                                   (gint *)&prefs.heur_dissector_order, heur_dissector_order_vals, FALSE);
+
+    prefs_register_bool_preference(protocols_module, "heuristic_conversation_hints",
+                                   "Remember which heuristic dissector took each conversation",
+                                   "Try the heuristic dissector that took the last packet of a conversation first "
+                                   "for the next packet of that conversation, rather than going through the list again. "
+                                   "This costs a conversation lookup each time a heuristic dissector list is tried.",
+                                   &prefs.heur_conversation_hints);
+
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
      * configuration screen within the preferences dialog
@@ -4190,6 +4217,7 @@ pre_init_prefs(void)
     prefs.gui_packet_list_show_related = TRUE;
     prefs.gui_packet_list_show_minimap = TRUE;
     prefs.gui_packet_list_sortable     = TRUE;
+    prefs.gui_packet_list_cache_size   = 256;
     g_free (prefs.gui_interfaces_hide_types);
     prefs.gui_interfaces_hide_types = g_strdup("");
     prefs.gui_interfaces_show_hidden = FALSE;
@@ -4252,6 +4280,8 @@ pre_init_prefs(void)
     prefs.st_sort_showfullname = FALSE;
     prefs.display_hidden_proto_items = FALSE;
     prefs.display_byte_fields_with_spaces = FALSE;
+    prefs.heur_dissector_order = HEUR_ORDER_MOVE_TO_FRONT;
+    prefs.heur_conversation_hints = FALSE;
 
     /* set the default values for the io graph dialog */
     prefs.gui_io_graph_automatic_update = TRUE;
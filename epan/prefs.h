@@ -126,6 +126,15 @@ typedef enum {
 } elide_mode_e;
 
 
+/*
+ * How heuristic dissector lists are reordered as their dissectors take
+ * packets.
+ */
+typedef enum {
+    HEUR_ORDER_MOVE_TO_FRONT,   /* the one that took the packet goes first */
+    HEUR_ORDER_HIT_COUNT        /* the ones that took the most packets go first */
+} heur_order_e;
+
 /*
  * Update channel.
  */
@@ -204,6 +213,8 @@ typedef struct _e_prefs {
   gboolean     enable_incomplete_dissectors_check;
   gboolean     incomplete_dissectors_check_debug;
   gboolean     strict_conversation_tracking_heuristics;
+  heur_order_e heur_dissector_order;
+  gboolean     heur_conversation_hints;
   gboolean     filter_expressions_old;  /* TRUE if old filter expressions preferences were loaded. */
   gboolean     gui_update_enabled;
   software_update_channel_e gui_update_channel;
@@ -220,6 +231,7 @@ typedef struct _e_prefs {
   gboolean     gui_packet_list_show_related;
   gboolean     gui_packet_list_show_minimap;
   gboolean     gui_packet_list_sortable;
+  guint        gui_packet_list_cache_size; /* MB of column strings to keep, 0 for no limit */
   gint         gui_decimal_places1; /* Used for type 1 calculations */
   gint         gui_decimal_places2; /* Used for type 2 calculations */
   gint         gui_decimal_places3; /* Used for type 3 calculations */
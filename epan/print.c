@@ -27,6 +27,7 @@
 #include <epan/prefs.h>
 #include <epan/print.h>
 #include <epan/charsets.h>
+#include <wsutil/arrow_writer.h>
 #include <wsutil/json_dumper.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/utf8_entities.h>
@@ -79,9 +80,15 @@ struct _output_fields {
     gchar         aggregator;
     GPtrArray    *fields;
     GHashTable   *field_indicies;
+    gint         *hf_field_index;   /* field index + 1 of each hfid, 0 if none, -1 if not looked up yet */
+    guint         hf_field_index_len;
+    gint         *col_field_index;  /* field index + 1 of each column, 0 if none */
+    gint          col_field_index_len;
     GPtrArray   **field_values;
     gchar         quote;
     gboolean      includes_col_fields;
+    arrow_type   *arrow_types;      /* -T arrow: type of each field's column */
+    field_info  **arrow_last;       /* -T arrow, occurrence=l: last value of each field */
 };
 
 static gchar *get_field_hex_value(GSList *src_list, field_info *fi);
@@ -309,7 +316,7 @@ write_pdml_proto_tree(output_fields_t* fields, gchar **protocolfilter, pf_flags
     ws_assert(edt);
     ws_assert(fh);
 
-    cfp = edt->pi.fd->color_filter;
+    cfp = color_filters_get_by_index(edt->pi.fd->color_index);
 
     /* Create the output */
     if (use_color && (cfp != NULL)) {
@@ -980,10 +987,10 @@ write_json_proto_node_hex_dump(proto_node *node, write_json_data *pdata)
     }
 
     /* Dump raw hex-encoded dissected information including position, length, bitmask, type */
-    json_dumper_value_anyf(pdata->dumper, "%" PRId32, fi->start);
-    json_dumper_value_anyf(pdata->dumper, "%" PRId32, fi->length);
-    json_dumper_value_anyf(pdata->dumper, "%" PRIu64, fi->hfinfo->bitmask);
-    json_dumper_value_anyf(pdata->dumper, "%" PRId32, (gint32)fvalue_type_ftenum(&fi->value));
+    json_dumper_value_int64(pdata->dumper, fi->start);
+    json_dumper_value_int64(pdata->dumper, fi->length);
+    json_dumper_value_uint64(pdata->dumper, fi->hfinfo->bitmask);
+    json_dumper_value_int64(pdata->dumper, fvalue_type_ftenum(&fi->value));
 
     json_dumper_end_array(pdata->dumper);
 }
@@ -1607,7 +1614,7 @@ void
 write_psml_columns(epan_dissect_t *edt, FILE *fh, gboolean use_color)
 {
     gint i;
-    const color_filter_t *cfp = edt->pi.fd->color_filter;
+    const color_filter_t *cfp = color_filters_get_by_index(edt->pi.fd->color_index);
 
     if (use_color && (cfp != NULL)) {
         fprintf(fh, "<packet foreground='#%06x' background='#%06x'>\n",
@@ -1960,17 +1967,9 @@ json_write_field_hex_value(write_json_data *pdata, field_info *fi)
     pd = get_field_data(pdata->src_list, fi);
 
     if (pd) {
-        gint i;
-        guint len = fi->length * 2 + 1;
-        gchar* str = (gchar*)g_malloc0(len);
-        static const char hex[] = "0123456789abcdef";
+        gchar* str = (gchar*)g_malloc(fi->length * 2 + 1);
         /* Print a simple hex dump */
-        for (i = 0; i < fi->length; i++) {
-            guint8 c = pd[i];
-            str[2 * i] = hex[c >> 4];
-            str[2 * i + 1] = hex[c & 0xf];
-        }
-        str[2 * fi->length] = '\0';
+        *bytes_to_hexstr(str, pd, fi->length) = '\0';
         json_dumper_value_string(pdata->dumper, str);
         g_free(str);
     } else {
@@ -2066,6 +2065,11 @@ void output_fields_free(output_fields_t* fields)
             g_free(fields->field_values);
         }
 
+        g_free(fields->hf_field_index);
+        g_free(fields->col_field_index);
+        g_free(fields->arrow_types);
+        g_free(fields->arrow_last);
+
         for (i = 0; i < fields->fields->len; ++i) {
             gchar* field = (gchar *)g_ptr_array_index(fields->fields,i);
             g_free(field);
@@ -2352,6 +2356,51 @@ static void format_field_values(output_fields_t* fields, gpointer field_index, g
     g_ptr_array_add(fv_p, (gpointer)value);
 }
 
+/*
+ * Get the index, plus 1, of a field in the list of fields to output, or
+ * 0 if it isn't in the list.  This is looked up by name the first time
+ * each hfid is seen, and from then on by hfid, as going by the name for
+ * every node of every tree takes longer than formatting the values.
+ */
+static gint output_fields_hf_index(output_fields_t *fields, header_field_info *hfinfo)
+{
+    gint field_index;
+
+    if ((guint)hfinfo->id >= fields->hf_field_index_len) {
+        guint old_len = fields->hf_field_index_len;
+        guint new_len = MAX(old_len * 2, (guint)hfinfo->id + 1);
+
+        fields->hf_field_index = g_renew(gint, fields->hf_field_index, new_len);
+        for (guint i = old_len; i < new_len; i++)
+            fields->hf_field_index[i] = -1;
+        fields->hf_field_index_len = new_len;
+    }
+
+    field_index = fields->hf_field_index[hfinfo->id];
+    if (field_index < 0) {
+        field_index = GPOINTER_TO_INT(g_hash_table_lookup(fields->field_indicies, hfinfo->abbrev));
+        fields->hf_field_index[hfinfo->id] = field_index;
+    }
+    return field_index;
+}
+
+/* The same for the fields naming columns, by column number. */
+static gint output_fields_col_index(output_fields_t *fields, column_info *cinfo, gint col)
+{
+    if (fields->col_field_index == NULL || fields->col_field_index_len != cinfo->num_cols) {
+        g_free(fields->col_field_index);
+        fields->col_field_index = g_new(gint, cinfo->num_cols);
+        fields->col_field_index_len = cinfo->num_cols;
+        for (gint i = 0; i < cinfo->num_cols; i++) {
+            /* Prepend COLUMN_FIELD_FILTER as the field name */
+            gchar *col_name = ws_strdup_printf("%s%s", COLUMN_FIELD_FILTER, cinfo->columns[i].col_title);
+            fields->col_field_index[i] = GPOINTER_TO_INT(g_hash_table_lookup(fields->field_indicies, col_name));
+            g_free(col_name);
+        }
+    }
+    return fields->col_field_index[col];
+}
+
 static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
 {
     write_field_data_t *call_data;
@@ -2364,7 +2413,7 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
     /* dissection with an invisible proto tree? */
     ws_assert(fi);
 
-    field_index = g_hash_table_lookup(call_data->fields->field_indicies, fi->hfinfo->abbrev);
+    field_index = GINT_TO_POINTER(output_fields_hf_index(call_data->fields, fi->hfinfo));
     if (NULL != field_index) {
         format_field_values(call_data->fields, field_index,
                             get_node_field_value(fi, call_data->edt) /* g_ alloc'd string */
@@ -2378,11 +2427,30 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
     }
 }
 
+static void output_fields_prepare_indicies(output_fields_t *fields)
+{
+    gsize i;
+
+    if (NULL == fields->field_indicies) {
+        /* Prepare a lookup table from string abbreviation for field to its index. */
+        fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
+
+        i = 0;
+        while (i < fields->fields->len) {
+            gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+            /* Store field indicies +1 so that zero is not a valid value,
+             * and can be distinguished from NULL as a pointer.
+             */
+            ++i;
+            g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
+        }
+    }
+}
+
 static void write_specified_fields(fields_format format, output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh, json_dumper *dumper)
 {
     gsize     i;
     gint      col;
-    gchar    *col_name;
     gpointer  field_index;
 
     write_field_data_t data;
@@ -2400,20 +2468,7 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     data.fields = fields;
     data.edt = edt;
 
-    if (NULL == fields->field_indicies) {
-        /* Prepare a lookup table from string abbreviation for field to its index. */
-        fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
-
-        i = 0;
-        while (i < fields->fields->len) {
-            gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
-            /* Store field indicies +1 so that zero is not a valid value,
-             * and can be distinguished from NULL as a pointer.
-             */
-            ++i;
-            g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
-        }
-    }
+    output_fields_prepare_indicies(fields);
 
     /* Array buffer to store values for this packet              */
     /*  Allocate an array for the 'GPtrarray *' the first time   */
@@ -2432,11 +2487,7 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
         for (col = 0; col < cinfo->num_cols; col++) {
             if (!get_column_visible(col))
                 continue;
-            /* Prepend COLUMN_FIELD_FILTER as the field name */
-            col_name = ws_strdup_printf("%s%s", COLUMN_FIELD_FILTER, cinfo->columns[col].col_title);
-            field_index = g_hash_table_lookup(fields->field_indicies, col_name);
-            g_free(col_name);
-
+            field_index = GINT_TO_POINTER(output_fields_col_index(fields, cinfo, col));
             if (NULL != field_index) {
                 format_field_values(fields, field_index, g_strdup(get_column_text(cinfo, col)));
             }
@@ -2566,6 +2617,205 @@ void write_fields_finale(output_fields_t* fields _U_ , FILE *fh _U_)
     /* Nothing to do */
 }
 
+static arrow_type arrow_type_for_ftype(enum ftenum ftype)
+{
+    if (ftype == FT_CHAR)
+        return ARROW_TYPE_UTF8;
+    if (IS_FT_UINT(ftype))
+        return ARROW_TYPE_UINT64;
+    if (IS_FT_INT(ftype))
+        return ARROW_TYPE_INT64;
+
+    switch (ftype) {
+    case FT_BOOLEAN:
+        return ARROW_TYPE_BOOL;
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        return ARROW_TYPE_DOUBLE;
+    case FT_IPv4:
+        return ARROW_TYPE_UINT32;
+    case FT_ABSOLUTE_TIME:
+        return ARROW_TYPE_TIMESTAMP;
+    case FT_RELATIVE_TIME:
+        return ARROW_TYPE_DURATION;
+    default:
+        return ARROW_TYPE_UTF8;
+    }
+}
+
+/*
+ * The column type of a field. Fields registered more than once under the
+ * same name can disagree on the type, in which case the column holds the
+ * values as text like -T fields does.
+ */
+static arrow_type arrow_type_for_field(const gchar *field)
+{
+    header_field_info *hfinfo;
+    arrow_type type = ARROW_TYPE_UTF8;
+
+    if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+        return ARROW_TYPE_UTF8;
+
+    hfinfo = proto_registrar_get_byname(field);
+    if (hfinfo)
+        type = arrow_type_for_ftype(hfinfo->type);
+    for (; hfinfo; hfinfo = hfinfo->same_name_next) {
+        if (arrow_type_for_ftype(hfinfo->type) != type)
+            return ARROW_TYPE_UTF8;
+    }
+    return type;
+}
+
+arrow_writer *write_arrow_preamble(output_fields_t* fields, FILE *fh)
+{
+    arrow_writer *writer;
+    gsize i;
+
+    ws_assert(fields);
+    ws_assert(fields->fields);
+    ws_assert(fh);
+
+    writer = arrow_writer_new(fh, 0);
+    fields->arrow_types = g_new(arrow_type, fields->fields->len);
+    if (fields->occurrence == 'l')
+        fields->arrow_last = g_new0(field_info *, fields->fields->len);
+
+    /* With occurrence=a each row holds a list of all the values. */
+    for (i = 0; i < fields->fields->len; i++) {
+        const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+
+        fields->arrow_types[i] = arrow_type_for_field(field);
+        arrow_writer_add_column(writer, field, fields->arrow_types[i],
+                                fields->occurrence == 'a');
+    }
+    return writer;
+}
+
+static void write_arrow_field_value(output_fields_t *fields, guint indx, field_info *fi,
+                                    epan_dissect_t *edt, arrow_writer *writer)
+{
+    enum ftenum ftype = fvalue_type_ftenum(&fi->value);
+    const nstime_t *ts;
+    gchar *str;
+
+    switch (fields->arrow_types[indx]) {
+    case ARROW_TYPE_INT64:
+        arrow_writer_append_int(writer, indx, IS_FT_INT64(ftype) ?
+                                fvalue_get_sinteger64(&fi->value) :
+                                fvalue_get_sinteger(&fi->value));
+        break;
+    case ARROW_TYPE_UINT64:
+        arrow_writer_append_uint(writer, indx, IS_FT_UINT64(ftype) ?
+                                 fvalue_get_uinteger64(&fi->value) :
+                                 fvalue_get_uinteger(&fi->value));
+        break;
+    case ARROW_TYPE_UINT32:
+        arrow_writer_append_uint(writer, indx, g_ntohl(fvalue_get_uinteger(&fi->value)));
+        break;
+    case ARROW_TYPE_DOUBLE:
+        arrow_writer_append_double(writer, indx, fvalue_get_floating(&fi->value));
+        break;
+    case ARROW_TYPE_BOOL:
+        arrow_writer_append_bool(writer, indx, fvalue_get_uinteger64(&fi->value) != 0);
+        break;
+    case ARROW_TYPE_TIMESTAMP:
+    case ARROW_TYPE_DURATION:
+        ts = fvalue_get_time(&fi->value);
+        arrow_writer_append_int(writer, indx, (gint64)ts->secs * 1000000000 + ts->nsecs);
+        break;
+    case ARROW_TYPE_UTF8:
+        str = get_node_field_value(fi, edt);
+        if (str) {
+            arrow_writer_append_string(writer, indx, str);
+            g_free(str);
+        }
+        break;
+    }
+}
+
+typedef struct {
+    output_fields_t *fields;
+    epan_dissect_t  *edt;
+    arrow_writer    *writer;
+} write_arrow_data_t;
+
+static void proto_tree_write_node_arrow(proto_node *node, gpointer data)
+{
+    write_arrow_data_t *call_data = (write_arrow_data_t *)data;
+    field_info *fi = PNODE_FINFO(node);
+    gpointer    field_index;
+
+    /* dissection with an invisible proto tree? */
+    ws_assert(fi);
+
+    field_index = GINT_TO_POINTER(output_fields_hf_index(call_data->fields, fi->hfinfo));
+    if (NULL != field_index) {
+        guint indx = GPOINTER_TO_UINT(field_index) - 1;
+
+        /*
+         * A non-list column keeps the first value it is given, so for
+         * occurrence=l hold the value back until the whole tree is seen.
+         */
+        if (call_data->fields->arrow_last)
+            call_data->fields->arrow_last[indx] = fi;
+        else
+            write_arrow_field_value(call_data->fields, indx, fi, call_data->edt, call_data->writer);
+    }
+
+    if (node->first_child != NULL) {
+        proto_tree_children_foreach(node, proto_tree_write_node_arrow, call_data);
+    }
+}
+
+void write_arrow_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, arrow_writer *writer)
+{
+    write_arrow_data_t data;
+    gsize i;
+    gint  col;
+
+    ws_assert(fields);
+    ws_assert(fields->arrow_types);
+    ws_assert(edt);
+    ws_assert(writer);
+
+    output_fields_prepare_indicies(fields);
+
+    data.fields = fields;
+    data.edt = edt;
+    data.writer = writer;
+    proto_tree_children_foreach(edt->tree, proto_tree_write_node_arrow, &data);
+
+    if (fields->arrow_last) {
+        for (i = 0; i < fields->fields->len; i++) {
+            if (fields->arrow_last[i]) {
+                write_arrow_field_value(fields, (guint)i, fields->arrow_last[i], edt, writer);
+                fields->arrow_last[i] = NULL;
+            }
+        }
+    }
+
+    if (fields->includes_col_fields) {
+        for (col = 0; col < cinfo->num_cols; col++) {
+            gpointer  field_index;
+
+            if (!get_column_visible(col))
+                continue;
+            field_index = GINT_TO_POINTER(output_fields_col_index(fields, cinfo, col));
+            if (NULL != field_index) {
+                arrow_writer_append_string(writer, GPOINTER_TO_UINT(field_index) - 1,
+                                           get_column_text(cinfo, col));
+            }
+        }
+    }
+
+    arrow_writer_end_row(writer);
+}
+
+void write_arrow_finale(arrow_writer *writer)
+{
+    arrow_writer_finish(writer);
+}
+
 /* Returns an g_malloced string */
 gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt)
 {
@@ -2700,9 +2950,15 @@ output_fields_t* output_fields_new(void)
     fields->aggregator          = ',';
     fields->fields              = NULL; /*Do lazy initialisation */
     fields->field_indicies      = NULL;
+    fields->hf_field_index      = NULL;
+    fields->hf_field_index_len  = 0;
+    fields->col_field_index     = NULL;
+    fields->col_field_index_len = 0;
     fields->field_values        = NULL;
     fields->quote               ='\0';
     fields->includes_col_fields = FALSE;
+    fields->arrow_types         = NULL;
+    fields->arrow_last          = NULL;
     return fields;
 }
 
@@ -19,6 +19,7 @@
 #include <epan/packet.h>
 #include <epan/print_stream.h>
 
+#include <wsutil/arrow_writer.h>
 #include <wsutil/json_dumper.h>
 
 #include "ws_symbol_export.h"
@@ -136,6 +137,10 @@ WS_DLL_PUBLIC void write_fields_preamble(output_fields_t* fields, FILE *fh);
 WS_DLL_PUBLIC void write_fields_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
 WS_DLL_PUBLIC void write_fields_finale(output_fields_t* fields, FILE *fh);
 
+WS_DLL_PUBLIC arrow_writer *write_arrow_preamble(output_fields_t* fields, FILE *fh);
+WS_DLL_PUBLIC void write_arrow_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, arrow_writer *writer);
+WS_DLL_PUBLIC void write_arrow_finale(arrow_writer *writer);
+
 WS_DLL_PUBLIC gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt);
 
 extern void print_cache_field_handles(void);
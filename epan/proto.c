@@ -378,6 +378,7 @@ struct _protocol {
                                        can be added to a dissector table, but use the
                                        parent_proto_id for things like enable/disable */
 	GList      *heur_list;          /* Heuristic dissectors associated with this protocol */
+	proto_deferred_init_t deferred_init; /* Expensive initialization, run on first use */
 };
 
 /* List of all protocols */
@@ -397,10 +398,13 @@ static GPtrArray *deregistered_slice = NULL;
 /* indexed by prefix, contains initializers */
 static GHashTable* prefixes = NULL;
 
+/* Number of protocols whose deferred initialization hasn't been run yet */
+static guint num_deferred_inits = 0;
+
 /* Contains information about a field when a dissector calls
  * proto_tree_add_item.  */
-#define FIELD_INFO_NEW(pool, fi)  fi = wmem_new(pool, field_info)
-#define FIELD_INFO_FREE(pool, fi) wmem_free(pool, fi)
+#define FIELD_INFO_NEW(tree_data, fi)  fi = (field_info *)wmem_slab_alloc((tree_data)->finfo_slab)
+#define FIELD_INFO_FREE(tree_data, fi) wmem_slab_free((tree_data)->finfo_slab, fi)
 
 /* Contains the space for proto_nodes. */
 #define PROTO_NODE_INIT(node)			\
@@ -408,8 +412,8 @@ static GHashTable* prefixes = NULL;
 	node->last_child = NULL;		\
 	node->next = NULL;
 
-#define PROTO_NODE_FREE(pool, node)			\
-	wmem_free(pool, node)
+#define PROTO_NODE_FREE(tree_data, node)			\
+	wmem_slab_free((tree_data)->node_slab, node)
 
 /* String space for protocol and field items for the GUI */
 #define ITEM_LABEL_NEW(pool, il)			\
@@ -708,8 +712,11 @@ proto_cleanup_base(void)
 	g_free(tree_is_expanded);
 	tree_is_expanded = NULL;
 
-	if (prefixes)
+	if (prefixes) {
 		g_hash_table_destroy(prefixes);
+		prefixes = NULL;
+	}
+	num_deferred_inits = 0;
 }
 
 void
@@ -717,6 +724,7 @@ proto_cleanup(void)
 {
 	proto_free_deregistered_fields();
 	proto_cleanup_base();
+	value_string_auto_index_cleanup();
 
 	g_slist_free(dissector_plugins);
 	dissector_plugins = NULL;
@@ -818,6 +826,10 @@ proto_tree_reset(proto_tree *tree)
 		g_hash_table_remove_all(tree_data->interesting_hfids);
 	}
 
+	if (tree_data->field_index) {
+		g_hash_table_remove_all(tree_data->field_index);
+	}
+
 	/* Reset track of the number of children */
 	tree_data->count = 0;
 
@@ -842,6 +854,13 @@ proto_tree_free(proto_tree *tree)
 		g_hash_table_destroy(tree_data->interesting_hfids);
 	}
 
+	if (tree_data->field_index) {
+		g_hash_table_destroy(tree_data->field_index);
+	}
+
+	wmem_destroy_slab(tree_data->node_slab);
+	wmem_destroy_slab(tree_data->finfo_slab);
+
 	g_slice_free(tree_data_t, tree_data);
 
 	g_slice_free(proto_tree, tree);
@@ -896,6 +915,51 @@ proto_field_is_referenced(proto_tree *tree, int proto_id)
 	return FALSE;
 }
 
+/* Is anybody going to look at an item for this field if it's added to
+   the tree?  This is the test TRY_TO_FAKE_THIS_ITEM() makes, except that
+   a protocol counts as wanted if any of its fields is; if it returns
+   FALSE, whatever work goes into getting the item's value and formatting
+   its text can be skipped.
+*/
+gboolean
+proto_field_is_wanted(proto_tree *tree, const int hfindex)
+{
+	register header_field_info *hfinfo;
+
+	if (!tree)
+		return FALSE;
+
+	if (PTREE_DATA(tree)->visible)
+		return TRUE;
+
+	PROTO_REGISTRAR_GET_NTH(hfindex, hfinfo);
+	if (hfinfo->ref_type == HF_REF_TYPE_DIRECT)
+		return TRUE;
+
+	if (hfinfo->type == FT_PROTOCOL &&
+	    (hfinfo->ref_type != HF_REF_TYPE_NONE || !PTREE_DATA(tree)->fake_protocols))
+		return TRUE;
+
+	return FALSE;
+}
+
+gboolean
+proto_fields_are_wanted(proto_tree *tree, int * const *fields)
+{
+	if (!tree)
+		return FALSE;
+
+	if (PTREE_DATA(tree)->visible)
+		return TRUE;
+
+	for (; *fields != NULL; fields++) {
+		if (proto_field_is_wanted(tree, **fields))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
 
 /* Finds a record in the hfinfo array by id. */
 header_field_info *
@@ -972,16 +1036,85 @@ initialize_prefix(gpointer k, gpointer v, gpointer u _U_) {
 	return TRUE;
 }
 
-/** Initialize every remaining uninitialized prefix. */
+/** Initialize every remaining uninitialized prefix, and run every
+ * remaining deferred initialization routine. */
 void
 proto_initialize_all_prefixes(void) {
-	g_hash_table_foreach_remove(prefixes, initialize_prefix, NULL);
+	GList *list;
+
+	if (prefixes)
+		g_hash_table_foreach_remove(prefixes, initialize_prefix, NULL);
+
+	for (list = protocols; list != NULL && num_deferred_inits != 0; list = g_list_next(list))
+		proto_run_deferred_init_protocol((protocol_t *)list->data);
+}
+
+/* Register a routine to do the expensive part of a protocol's
+ * initialization the first time the protocol is used. */
+void
+proto_register_deferred_init(const int proto_id, proto_deferred_init_t func)
+{
+	protocol_t *protocol = find_protocol_by_id(proto_id);
+
+	DISSECTOR_ASSERT(protocol != NULL && func != NULL);
+	DISSECTOR_ASSERT_HINT(protocol->deferred_init == NULL,
+	    "A protocol can only have one deferred initialization routine");
+
+	protocol->deferred_init = func;
+	num_deferred_inits++;
+}
+
+void
+proto_run_deferred_init_protocol(protocol_t *protocol)
+{
+	proto_deferred_init_t func;
+
+	if (G_LIKELY(num_deferred_inits == 0) || protocol == NULL ||
+	    protocol->deferred_init == NULL)
+		return;
+
+	/* Clear it first, so that the routine can look up the protocol's
+	 * fields without being called again. */
+	func = protocol->deferred_init;
+	protocol->deferred_init = NULL;
+	num_deferred_inits--;
+	func();
+}
+
+void
+proto_run_deferred_init(const int proto_id)
+{
+	if (num_deferred_inits == 0)
+		return;
+
+	proto_run_deferred_init_protocol(find_protocol_by_id(proto_id));
+}
+
+/* If the protocol whose filter name starts field_name has a deferred
+ * initialization routine that hasn't been run, run it; returns TRUE
+ * if it did, in which case field_name might now be registered. */
+static gboolean
+run_deferred_init_for_field_name(const char *field_name)
+{
+	protocol_t *protocol;
+	gchar      *filter_name;
+
+	filter_name = g_strndup(field_name, strcspn(field_name, "."));
+	protocol = (protocol_t *)g_hash_table_lookup(proto_filter_names, filter_name);
+	g_free(filter_name);
+
+	if (protocol == NULL || protocol->deferred_init == NULL)
+		return FALSE;
+
+	proto_run_deferred_init_protocol(protocol);
+	return TRUE;
 }
 
 /* Finds a record in the hfinfo array by name.
  * If it fails to find it in the already registered fields,
  * it tries to find and call an initializer in the prefixes
- * table and if so it looks again.
+ * table, or the field's protocol's deferred initialization
+ * routine, and if so it looks again.
  */
 
 header_field_info *
@@ -1000,12 +1133,25 @@ proto_registrar_get_byname(const char *field_name)
 	hfinfo = (header_field_info *)g_hash_table_lookup(gpa_name_map, field_name);
 
 	if (hfinfo) {
+		/* Filtering on a field counts as using its protocol. */
+		if (G_UNLIKELY(num_deferred_inits != 0))
+			proto_run_deferred_init(hfinfo->parent == -1 ? hfinfo->id : hfinfo->parent);
 		g_free(last_field_name);
 		last_field_name = g_strdup(field_name);
 		last_hfinfo = hfinfo;
 		return hfinfo;
 	}
 
+	if (num_deferred_inits != 0 && run_deferred_init_for_field_name(field_name)) {
+		hfinfo = (header_field_info *)g_hash_table_lookup(gpa_name_map, field_name);
+		if (hfinfo) {
+			g_free(last_field_name);
+			last_field_name = g_strdup(field_name);
+			last_hfinfo = hfinfo;
+			return hfinfo;
+		}
+	}
+
 	if (!prefixes)
 		return NULL;
 
@@ -5970,7 +6116,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 		/* XXX - is it safe to continue here? */
 	}
 
-	pnode = wmem_new(PNODE_POOL(tree), proto_node);
+	pnode = (proto_node *)wmem_slab_alloc(PTREE_DATA(tree)->node_slab);
 	PROTO_NODE_INIT(pnode);
 	pnode->parent = tnode;
 	PNODE_FINFO(pnode) = fi;
@@ -6306,7 +6452,7 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 {
 	field_info *fi;
 
-	FIELD_INFO_NEW(PNODE_POOL(tree), fi);
+	FIELD_INFO_NEW(PTREE_DATA(tree), fi);
 
 	fi->hfinfo     = hfinfo;
 	fi->start      = start;
@@ -7350,6 +7496,8 @@ proto_tree_create_root(packet_info *pinfo)
 
 	/* Don't initialize the tree_data_t. Wait until we know we need it */
 	pnode->tree_data->interesting_hfids = NULL;
+	pnode->tree_data->field_index = NULL;
+	pnode->tree_data->field_index_count = 0;
 
 	/* Set the default to FALSE so it's easier to
 	 * find errors; if we expect to see the protocol tree
@@ -7363,6 +7511,10 @@ proto_tree_create_root(packet_info *pinfo)
 	/* Keep track of the number of children */
 	pnode->tree_data->count = 0;
 
+	/* There are lots of these, all the same size, freed all at once */
+	pnode->tree_data->node_slab = wmem_slab_new(pinfo->pool, sizeof(proto_node));
+	pnode->tree_data->finfo_slab = wmem_slab_new(pinfo->pool, sizeof(field_info));
+
 	return (proto_tree *)pnode;
 }
 
@@ -7649,6 +7801,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	protocol->can_toggle = TRUE;
 	protocol->parent_proto_id = -1;
 	protocol->heur_list = NULL;
+	protocol->deferred_init = NULL;
 
 	/* List will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
@@ -7708,6 +7861,7 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 
 	protocol->parent_proto_id = parent_proto;
 	protocol->heur_list = NULL;
+	protocol->deferred_init = NULL;
 
 	/* List will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
@@ -9079,6 +9233,28 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 
 	tmp_fld_check_assert(hfinfo);
 
+	/* Big plain value_strings get an index, so that looking up values
+	 * in them with hf_try_val_to_str() isn't a linear search. */
+	if (hfinfo->strings != NULL &&
+	    FIELD_DISPLAY(hfinfo->display) != BASE_CUSTOM &&
+	    !(hfinfo->display & (BASE_RANGE_STRING|BASE_EXT_STRING|BASE_VAL64_STRING|BASE_UNIT_STRING))) {
+		switch (hfinfo->type) {
+			case FT_CHAR:
+			case FT_UINT8:
+			case FT_UINT16:
+			case FT_UINT24:
+			case FT_UINT32:
+			case FT_INT8:
+			case FT_INT16:
+			case FT_INT24:
+			case FT_INT32:
+				value_string_auto_index_register((const value_string *)hfinfo->strings);
+				break;
+			default:
+				break;
+		}
+	}
+
 	hfinfo->parent         = parent;
 	hfinfo->same_name_next = NULL;
 	hfinfo->same_name_prev_id = -1;
@@ -10734,6 +10910,59 @@ proto_find_first_finfo(proto_tree *tree, const int id)
 	return ffdata.array;
 }
 
+/* Helper function for proto_find_finfo_indexed() */
+static gboolean
+index_finfo(proto_node *node, gpointer data)
+{
+	GHashTable *field_index = (GHashTable *)data;
+	field_info *fi = PNODE_FINFO(node);
+	GPtrArray  *ptrs;
+
+	if (fi && fi->hfinfo) {
+		ptrs = (GPtrArray *)g_hash_table_lookup(field_index,
+			GINT_TO_POINTER(fi->hfinfo->id));
+		if (!ptrs) {
+			ptrs = g_ptr_array_new();
+			g_hash_table_insert(field_index,
+				GINT_TO_POINTER(fi->hfinfo->id), ptrs);
+		}
+		g_ptr_array_add(ptrs, fi);
+	}
+
+	/* Don't stop traversing. */
+	return FALSE;
+}
+
+GPtrArray *
+proto_find_finfo_indexed(proto_tree *tree, const int id)
+{
+	tree_data_t *tree_data;
+
+	if (!tree)
+		return NULL;
+
+	ws_assert(tree->parent == NULL);
+	tree_data = PTREE_DATA(tree);
+
+	if (tree_data->field_index == NULL) {
+		tree_data->field_index = g_hash_table_new_full(g_direct_hash,
+			g_direct_equal, NULL, (GDestroyNotify)g_ptr_array_unref);
+	}
+
+	/* (Re)build it if the tree has been reset since it was built, or
+	 * items have been added since. */
+	if (g_hash_table_size(tree_data->field_index) == 0 ||
+			tree_data->field_index_count != tree_data->count) {
+		g_hash_table_remove_all(tree_data->field_index);
+		proto_tree_traverse_pre_order(tree, index_finfo,
+			tree_data->field_index);
+		tree_data->field_index_count = tree_data->count;
+	}
+
+	return (GPtrArray *)g_hash_table_lookup(tree_data->field_index,
+		GINT_TO_POINTER(id));
+}
+
 /* Helper function for proto_all_finfos() */
 static gboolean
 every_finfo(proto_node *node, gpointer data)
@@ -11033,6 +11262,16 @@ proto_registrar_dump_values(void)
 					       VALUE_STRING_EXT_VS_NAME(vse_p),
 					       value_string_ext_match_type_str(vse_p));
 				}
+			} else if (value_string_auto_index_match_type_str(vals) != NULL) {
+				/* A big plain value_string, which would be searched
+				 * linearly if it hadn't been indexed; it might be
+				 * worth making it a value_string_ext. */
+				for (vi = 0; vals[vi].strptr; vi++)
+					;
+				printf("I\t%s\t%d\t%s\n",
+				       hfinfo->abbrev,
+				       vi,
+				       value_string_auto_index_match_type_str(vals));
 			}
 			vi = 0;
 			while (vals[vi].strptr) {
@@ -869,6 +869,10 @@ typedef struct {
     gboolean             fake_protocols;
     guint                count;
     struct _packet_info *pinfo;
+    wmem_slab_t         *node_slab;     /**< proto_nodes, from pinfo->pool */
+    wmem_slab_t         *finfo_slab;    /**< field_infos, from pinfo->pool */
+    GHashTable          *field_index;   /**< hfid -> GPtrArray of field_infos, see proto_find_finfo_indexed() */
+    guint                field_index_count; /**< count when field_index was built */
 } tree_data_t;
 
 /** Each proto_tree, proto_item is one of these. */
@@ -1072,6 +1076,28 @@ extern void proto_cleanup(void);
 */
 WS_DLL_PUBLIC gboolean proto_field_is_referenced(proto_tree *tree, int proto_id);
 
+/** Is an item for this field going to be looked at if it's added to the
+    tree, either because the tree is visible, or because a filter, a
+    column, a tap or an output field refers to the field?
+    If this returns FALSE, nothing will look at the item, and, except at
+    the top level of the tree, proto_tree_add_...() won't really add it,
+    so the dissector can skip working out its value, looking up
+    value strings for it, and formatting text for it, as long as it
+    doesn't skip anything else, such as updating its state, adding
+    expert info, or calling subdissectors.
+ @param tree the tree the item would be added to
+ @param hfindex the field
+ @return TRUE if the item is wanted */
+WS_DLL_PUBLIC gboolean proto_field_is_wanted(proto_tree *tree, const int hfindex);
+
+/** Is an item for any of these fields going to be looked at if it's added
+    to the tree?  This lets a dissector skip a whole block of items, such
+    as a subtree of generated fields, if none of them is wanted.
+ @param tree the tree the items would be added to
+ @param fields a NULL-terminated array of pointers to the fields
+ @return TRUE if any of the items is wanted */
+WS_DLL_PUBLIC gboolean proto_fields_are_wanted(proto_tree *tree, int * const *fields);
+
 /** Create a subtree under an existing item.
  @param pi the parent item of the new subtree
  @param idx one of the ett_ array elements registered with proto_register_subtree_array()
@@ -2473,9 +2499,39 @@ typedef void (*prefix_initializer_t)(const char* match);
 WS_DLL_PUBLIC void
 proto_register_prefix(const char *prefix,  prefix_initializer_t initializer);
 
-/** Initialize every remaining uninitialized prefix. */
+/** Initialize every remaining uninitialized prefix, and run every
+    remaining deferred initialization routine. */
 WS_DLL_PUBLIC void proto_initialize_all_prefixes(void);
 
+/** This type of function can be registered to do the expensive part of a
+    protocol's initialization, such as loading a dictionary or building
+    big tables, only if the protocol is actually used. */
+typedef void (*proto_deferred_init_t)(void);
+
+/** Register a deferred initialization routine for a protocol.  It's called
+    once, the first time one of the protocol's dissectors is called through
+    a handle or as a heuristic dissector, one of the protocol's fields is
+    looked up by name (for instance by a display filter), or
+    proto_initialize_all_prefixes() is called.  It may register fields and
+    subtrees, but it must not add the protocol to dissector tables, as the
+    protocol won't be called until it's in them.
+ @param proto_id protocol id returned by proto_register_protocol (0-indexed)
+ @param func the deferred initialization routine */
+WS_DLL_PUBLIC void
+proto_register_deferred_init(const int proto_id, proto_deferred_init_t func);
+
+/** Run a protocol's deferred initialization routine if it hasn't been run.
+    Dissector functions that other dissectors call directly, rather than
+    through a handle, should call this first.
+ @param proto_id protocol id returned by proto_register_protocol (0-indexed) */
+WS_DLL_PUBLIC void
+proto_run_deferred_init(const int proto_id);
+
+/** Same as proto_run_deferred_init(), for the protocol_t; cheap when
+    there's nothing to run.  Used when calling dissectors. */
+extern void
+proto_run_deferred_init_protocol(protocol_t *protocol);
+
 /** Register a header_field array.
  @param parent the protocol handle from proto_register_protocol()
  @param hf the hf_register_info array
@@ -2736,6 +2792,17 @@ proto_get_finfo_ptr_array because it has to search through the tree.
 @return GPtrArry pointer */
 WS_DLL_PUBLIC GPtrArray* proto_find_first_finfo(proto_tree *tree, const int hfindex);
 
+/** Return GPtrArray* of field_info pointers for all hfindex that appear in
+    tree, in the order proto_find_finfo() finds them. Works with any tree,
+    primed or unprimed: the first call for a dissected tree indexes all of
+    its fields, and later calls, for any field, just look it up, until the
+    tree is reset. Use it once dissection is done, when several fields are
+    looked up in the same tree. The caller should *not* free the GPtrArray.
+ @param tree root of the tree of interest
+ @param hfindex index of field info of interest
+ @return GPtrArray pointer, or NULL if the field isn't in the tree */
+WS_DLL_PUBLIC GPtrArray* proto_find_finfo_indexed(proto_tree *tree, const int hfindex);
+
 /** Return GPtrArray* of field_info pointers containg all hfindexes that appear
     in tree.
  @param tree tree of interest
@@ -17,6 +17,7 @@
 #include <epan/reassemble.h>
 #include <epan/tvbuff-int.h>
 
+#include <wsutil/perf_stats.h>
 #include <wsutil/str_util.h>
 #include <wsutil/ws_assert.h>
 
@@ -316,6 +317,22 @@ reassembled_key_free(gpointer ptr)
 	g_slice_free(reassembled_key, (reassembled_key *)ptr);
 }
 
+/*
+ * Forget where fragment_insert() has got to in a list of fragments, and
+ * free its index of the list, if any; it's done when the list is changed
+ * other than by fragment_insert(), and when the list is freed.
+ */
+static void
+fragment_forget_positions(fragment_head *fd_head)
+{
+	if (fd_head->offset_index != NULL) {
+		wmem_tree_destroy(fd_head->offset_index, FALSE, FALSE);
+		fd_head->offset_index = NULL;
+	}
+	fd_head->first_gap = NULL;
+	fd_head->contiguous_len = 0;
+}
+
 /*
  * For a fragment hash table entry, free the associated fragments.
  * The entry value (fd_chain) is freed herein and the entry is freed
@@ -336,6 +353,7 @@ free_all_fragments(gpointer key_arg _U_, gpointer value, gpointer user_data _U_)
 		fd_i = fd_head->next;
 		if(fd_head->tvb_data && !(fd_head->flags&FD_SUBSET_TVB))
 			tvb_free(fd_head->tvb_data);
+		fragment_forget_positions(fd_head);
 		g_slice_free(fragment_head, fd_head);
 	}
 
@@ -416,6 +434,7 @@ free_fragments(gpointer data, gpointer user_data _U_)
 		}
 		g_slice_free(fragment_item, fd_i);
 	}
+	fragment_forget_positions(fd_head);
 	g_slice_free(fragment_head, fd_head);
 }
 
@@ -636,6 +655,7 @@ fragment_delete(reassembly_table *table, const packet_info *pinfo,
 		g_slice_free(fragment_item, fd);
 		fd=tmp_fd;
 	}
+	fragment_forget_positions(fd_head);
 	g_slice_free(fragment_head, fd_head);
 	g_hash_table_remove(table->fragment_table, key);
 
@@ -874,6 +894,7 @@ fragment_truncate(reassembly_table *table, const packet_info *pinfo,
 	} else {
 		fd_head->next = NULL;
 	}
+	fragment_forget_positions(fd_head);
 	fragment_item *tmp_fd;
 	for (; fd_i; fd_i = tmp_fd) {
 		tmp_fd=fd_i->next;
@@ -981,6 +1002,8 @@ fragment_reassembled(reassembly_table *table, fragment_head *fd_head,
 				fd_head);
 		}
 	}
+	/* No more fragments will be added to it. */
+	fragment_forget_positions(fd_head);
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in = pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
@@ -1072,6 +1095,83 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
 	fd_i->next = fd;
 }
 
+/*
+ * Once the list of fragments for a reassembly by byte offset is at least
+ * this long, keep an index of it, so that adding a fragment out of order
+ * takes O(log n) rather than O(n).
+ */
+#define FRAGMENT_INDEX_MIN_LEN 32
+
+static void
+fragment_build_index(fragment_head *fd_head)
+{
+	fragment_item *fd_i;
+
+	fd_head->offset_index = wmem_tree_new(NULL);
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next)
+		wmem_tree_insert32(fd_head->offset_index, fd_i->offset, fd_i);
+}
+
+/*
+ * Like LINK_FRAG(), for reassemblies by byte offset, but also keeping
+ * track of how much data there is with no gap from offset 0, so that
+ * fragment_add_work() needn't walk the whole list to see whether the
+ * reassembly is complete.
+ *
+ * As each fragment is found by fragment_add_work() only if it starts at
+ * or before the end of the data before it, the fragments up to and
+ * including first_gap have all been counted, and a fragment inserted
+ * among them is counted as well; we only need to go on from first_gap.
+ */
+static void
+fragment_insert(fragment_head *fd_head, fragment_item *fd)
+{
+	fragment_item *fd_i, *prev;
+	guint len;
+
+	/*
+	 * Find the last fragment starting at or before this one, after
+	 * which it goes.
+	 */
+	if (fd_head->offset_index != NULL) {
+		prev = (fragment_item *)wmem_tree_lookup32_le(fd_head->offset_index, fd->offset);
+	} else if (fd_head->first_gap != NULL && fd->offset >= fd_head->first_gap->offset) {
+		/* Most fragments are added at or after the first gap. */
+		prev = fd_head->first_gap;
+		for (len = 0; prev->next && prev->next->offset <= fd->offset; prev = prev->next)
+			len++;
+		if (len >= FRAGMENT_INDEX_MIN_LEN)
+			fragment_build_index(fd_head);
+	} else {
+		prev = NULL;
+		for (len = 0, fd_i = fd_head->next; fd_i && fd_i->offset <= fd->offset; fd_i = fd_i->next, len++)
+			prev = fd_i;
+		if (len >= FRAGMENT_INDEX_MIN_LEN)
+			fragment_build_index(fd_head);
+	}
+	if (prev == NULL) {
+		fd->next = fd_head->next;
+		fd_head->next = fd;
+	} else {
+		fd->next = prev->next;
+		prev->next = fd;
+	}
+	if (fd_head->offset_index != NULL)
+		wmem_tree_insert32(fd_head->offset_index, fd->offset, fd);
+
+	/* Now see how far the data goes with no gap. */
+	if (fd_head->first_gap != NULL && fd->offset < fd_head->first_gap->offset) {
+		if (fd->offset + fd->len > fd_head->contiguous_len)
+			fd_head->contiguous_len = fd->offset + fd->len;
+	}
+	fd_i = fd_head->first_gap ? fd_head->first_gap->next : fd_head->next;
+	for (; fd_i && fd_i->offset <= fd_head->contiguous_len; fd_i = fd_i->next) {
+		if (fd_i->offset + fd_i->len > fd_head->contiguous_len)
+			fd_head->contiguous_len = fd_i->offset + fd_i->len;
+		fd_head->first_gap = fd_i;
+	}
+}
+
 /*
  * This function adds a new fragment to the fragment hash table.
  * If this is the first fragment seen for this datagram, a new entry
@@ -1236,7 +1336,7 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 			fd_head->flags |= FD_OVERLAPCONFLICT;
 		}
 		/* it was just an overlap, link it and return */
-		LINK_FRAG(fd_head,fd);
+		fragment_insert(fd_head,fd);
 		return TRUE;
 	}
 
@@ -1250,7 +1350,7 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 		THROW(BoundsError);
 	}
 	fd->tvb_data = tvb_clone_offset_len(tvb, offset, fd->len);
-	LINK_FRAG(fd_head,fd);
+	fragment_insert(fd_head,fd);
 
 
 	if( !(fd_head->flags & FD_DATALEN_SET) ){
@@ -1263,21 +1363,13 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 
 	/*
 	 * Check if we have received the entire fragment.
-	 * This is easy since the list is sorted and the head is faked.
-	 *
-	 * First, we compute the amount of contiguous data that's
-	 * available.  (The check for fd_i->offset <= max rules out
-	 * fragments that don't start before or at the end of the
-	 * previous fragment, i.e. fragments that have a gap between
-	 * them and the previous fragment.)
+	 * fragment_insert() has kept track of the amount of contiguous
+	 * data that's available, not counting fragments that don't
+	 * start before or at the end of the previous fragment, i.e.
+	 * fragments that have a gap between them and the previous
+	 * fragment.
 	 */
-	max = 0;
-	for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
-		if ( ((fd_i->offset)<=max) &&
-			((fd_i->offset+fd_i->len)>max) ){
-			max = fd_i->offset+fd_i->len;
-		}
-	}
+	max = fd_head->contiguous_len;
 
 	if (max < (fd_head->datalen)) {
 		/*
@@ -2648,6 +2740,9 @@ fragment_start_seq_check(reassembly_table *table, const packet_info *pinfo,
 		fd_head->flags = FD_BLOCKSEQUENCE|FD_DATALEN_SET;
 		fd_head->tvb_data = NULL;
 		fd_head->error = NULL;
+		fd_head->first_gap = NULL;
+		fd_head->contiguous_len = 0;
+		fd_head->offset_index = NULL;
 
 		insert_fd_head(table, fd_head, pinfo, id, data);
 	}
@@ -3032,10 +3127,49 @@ reassembly_table_cleanup_reg_tables(void)
 	g_list_foreach(reassembly_table_list, reassembly_table_cleanup_reg_table, NULL);
 }
 
+/*
+ * The number of entries in the fragment tables, i.e. the packets being
+ * reassembled, and in the reassembled tables, of all the registered
+ * reassembly tables, for perf_stats.
+ */
+static guint64
+reassembly_tables_fragment_count(void)
+{
+	GList *list;
+	guint64 count = 0;
+
+	for (list = reassembly_table_list; list != NULL; list = list->next) {
+		reassembly_table *table = ((register_reassembly_table_t *)list->data)->table;
+
+		if (table->fragment_table != NULL)
+			count += g_hash_table_size(table->fragment_table);
+	}
+	return count;
+}
+
+static guint64
+reassembly_tables_reassembled_count(void)
+{
+	GList *list;
+	guint64 count = 0;
+
+	for (list = reassembly_table_list; list != NULL; list = list->next) {
+		reassembly_table *table = ((register_reassembly_table_t *)list->data)->table;
+
+		if (table->reassembled_table != NULL)
+			count += g_hash_table_size(table->reassembled_table);
+	}
+	return count;
+}
+
 void reassembly_tables_init(void)
 {
 	register_init_routine(&reassembly_table_init_reg_tables);
 	register_cleanup_routine(&reassembly_table_cleanup_reg_tables);
+	ws_perf_gauge_register("epan.reassembly_pending", "Reassemblies in progress",
+			       WS_PERF_UNIT_COUNT, reassembly_tables_fragment_count);
+	ws_perf_gauge_register("epan.reassembled", "Reassembled table entries",
+			       WS_PERF_UNIT_COUNT, reassembly_tables_reassembled_count);
 }
 
 static void
@@ -3046,6 +3180,91 @@ reassembly_table_free(gpointer p, gpointer user_data _U_)
 	g_free(reg_table);
 }
 
+/*
+ * For a fragment hash table entry, free the associated fragments if no
+ * fragment has been added to it since before the cutoff frame.
+ */
+static gboolean
+expire_fragments(gpointer key_arg, gpointer value, gpointer user_data)
+{
+	fragment_head *fd_head = (fragment_head *)value;
+	guint32 oldest_frame = *(guint32 *)user_data;
+
+	if (fd_head == NULL || fd_head->frame >= oldest_frame)
+		return FALSE;
+	return free_all_fragments(key_arg, value, NULL);
+}
+
+typedef struct {
+	guint32 oldest_frame;
+	GPtrArray *allocated_fragments;
+} expire_reassembled_data_t;
+
+/*
+ * For a reassembled-packet hash table entry, queue the fragment data to be
+ * freed if the packet was reassembled before the cutoff frame.  As the
+ * test only looks at the fragment data, either all the entries for it are
+ * removed or none of them are.
+ */
+static gboolean
+expire_reassembled_fragments(gpointer key_arg, gpointer value,
+			     gpointer user_data)
+{
+	expire_reassembled_data_t *data = (expire_reassembled_data_t *)user_data;
+	fragment_head *fd_head = (fragment_head *)value;
+
+	if (fd_head != NULL && fd_head->flags != FD_VISITED_FREE &&
+	    fd_head->reassembled_in >= data->oldest_frame)
+		return FALSE;
+	return free_all_reassembled_fragments(key_arg, value,
+					      data->allocated_fragments);
+}
+
+static guint64 reassembly_expired_count = 0;
+
+static void
+reassembly_table_expire_reg_table(gpointer p, gpointer user_data)
+{
+	register_reassembly_table_t* reg_table = (register_reassembly_table_t*)p;
+	reassembly_table *table = reg_table->table;
+	expire_reassembled_data_t *data = (expire_reassembled_data_t *)user_data;
+
+	if (table->fragment_table != NULL) {
+		reassembly_expired_count += g_hash_table_foreach_remove(table->fragment_table,
+				expire_fragments, &data->oldest_frame);
+	}
+	if (table->reassembled_table != NULL) {
+		g_hash_table_foreach_remove(table->reassembled_table,
+				expire_reassembled_fragments, data);
+	}
+}
+
+guint
+reassembly_tables_expire(const guint32 oldest_frame)
+{
+	expire_reassembled_data_t data;
+	guint64 expired_before = reassembly_expired_count;
+
+	if (oldest_frame == 0)
+		return 0;
+
+	data.oldest_frame = oldest_frame;
+	data.allocated_fragments = g_ptr_array_new();
+	g_list_foreach(reassembly_table_list, reassembly_table_expire_reg_table, &data);
+
+	reassembly_expired_count += data.allocated_fragments->len;
+	g_ptr_array_foreach(data.allocated_fragments, free_fragments, NULL);
+	g_ptr_array_free(data.allocated_fragments, TRUE);
+
+	return (guint)(reassembly_expired_count - expired_before);
+}
+
+guint64
+reassembly_tables_get_expired_count(void)
+{
+	return reassembly_expired_count;
+}
+
 void
 reassembly_table_cleanup(void)
 {
@@ -91,6 +91,16 @@ typedef struct _fragment_head {
 	 * an error, in which case it's the string for the error.
 	 */
 	const char *error;
+	/*
+	 * Used by fragment_add and its variants to avoid walking the whole
+	 * list of fragments for each one added; private to reassemble.c.
+	 */
+	struct _fragment_item *first_gap;	/**< last fragment before the first gap in the
+					 * data, or NULL if not yet known */
+	guint32 contiguous_len;		/**< length of the data with no gap from offset 0,
+					 * up to the end of first_gap */
+	struct _wmem_tree_t *offset_index;	/**< the last fragment at each offset, once
+					 * there are enough fragments for it to be worthwhile */
 } fragment_head;
 
 /*
@@ -505,6 +515,29 @@ show_fragment_seq_tree(fragment_head *ipfd_head, const fragment_items *fit,
  */
 extern void reassembly_tables_init(void);
 
+/*
+ * Free the fragment data, in all the registered reassembly tables, that
+ * hasn't been used since before a frame: partly reassembled packets to
+ * which no fragment has been added since then, and packets reassembled
+ * before then.  This is for long-running captures in which packets are
+ * dissected once, in order, to keep memory use bounded; a fragment that
+ * belongs with expired ones starts a new reassembly.  It mustn't be called
+ * in the middle of dissecting a packet.
+ *
+ * @param oldest_frame The number of the oldest frame whose fragment data
+ * is to be kept.
+ * @return The number of reassembled, or partly reassembled, packets freed.
+ */
+WS_DLL_PUBLIC guint
+reassembly_tables_expire(const guint32 oldest_frame);
+
+/*
+ * Get the number of reassembled, or partly reassembled, packets freed by
+ * reassembly_tables_expire() so far.
+ */
+WS_DLL_PUBLIC guint64
+reassembly_tables_get_expired_count(void);
+
 /* Cleanup internal structures
  */
 extern void
@@ -3246,6 +3246,81 @@ test_fragment_add_check_duplicate_conflict(void)
         print_fragment_table();
     }
 }
+/* Test case for fragment_add_check with enough fragments, added out of
+ * order with a duplicate, for the reassembly code to index them.
+ *
+ * 100 fragments of 2 bytes are added: the odd-numbered ones from the last
+ * down, then the even-numbered ones from the second up, with the 51st
+ * added twice, and finally the first.
+ */
+#define MANY_FRAGMENTS 100
+
+static void
+add_one_of_many(guint32 frag_nr, guint32 frame)
+{
+    fragment_head *fd_head;
+
+    pinfo.num = frame;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, frag_nr * 2, &pinfo,
+                               12, NULL, frag_nr * 2, 2,
+                               frag_nr != MANY_FRAGMENTS - 1);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+}
+
+static void
+test_fragment_add_check_many_out_of_order(void)
+{
+    fragment_head *fd_head;
+    fragment_item *fd;
+    guint32 i, count;
+
+    printf("Starting test test_fragment_add_check_many_out_of_order\n");
+
+    for (i = MANY_FRAGMENTS - 1; i < MANY_FRAGMENTS; i -= 2) {
+        add_one_of_many(i, i + 1);
+    }
+    for (i = 2; i < MANY_FRAGMENTS; i += 2) {
+        add_one_of_many(i, i + 1);
+        if (i == 50) {
+            add_one_of_many(i, MANY_FRAGMENTS + 1);
+        }
+    }
+
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(0,g_hash_table_size(test_reassembly_table.reassembled_table));
+
+    /* finally, add the first fragment */
+    pinfo.num = MANY_FRAGMENTS + 2;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 0, &pinfo, 12,
+                               NULL, 0, 2, TRUE);
+
+    ASSERT_EQ(0,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_NE_POINTER(NULL,fd_head);
+
+    /* check the contents of the structure */
+    ASSERT_EQ(MANY_FRAGMENTS * 2,fd_head->datalen);
+    ASSERT_EQ(MANY_FRAGMENTS + 2,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET|FD_OVERLAP,fd_head->flags);
+    ASSERT_NE_POINTER(NULL,fd_head->tvb_data);
+
+    /* the fragments are in order, with the duplicate after the original */
+    count = 0;
+    for (fd = fd_head->next; fd != NULL; fd = fd->next) {
+        ASSERT_EQ((count > 50 ? count - 1 : count) * 2,fd->offset);
+        ASSERT_EQ(2,fd->len);
+        ASSERT_EQ(count == 51 ? FD_OVERLAP : 0,fd->flags);
+        count++;
+    }
+    ASSERT_EQ(MANY_FRAGMENTS + 1,count);
+
+    /* test the actual reassembly */
+    ASSERT(!tvb_memeql(fd_head->tvb_data,0,data,MANY_FRAGMENTS * 2));
+
+    if (debug) {
+        print_tables();
+    }
+}
+
 /**********************************************************************************
  *
  * main
@@ -3294,6 +3369,7 @@ main(int argc _U_, char **argv _U_)
         test_fragment_add_check_duplicate_last,
 #endif
         test_fragment_add_check_duplicate_conflict,
+        test_fragment_add_check_many_out_of_order,
     };
 
     /* a tvbuff for testing with */
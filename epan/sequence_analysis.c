@@ -126,9 +126,11 @@ seq_analysis_item_t* sequence_analysis_create_sai_with_addresses(packet_info *pi
 
 void sequence_analysis_use_color_filter(packet_info *pinfo, seq_analysis_item_t *sai)
 {
-    if (pinfo->fd->color_filter) {
-        sai->bg_color = color_t_to_rgb(&pinfo->fd->color_filter->bg_color);
-        sai->fg_color = color_t_to_rgb(&pinfo->fd->color_filter->fg_color);
+    const color_filter_t *color_filter = color_filters_get_by_index(pinfo->fd->color_index);
+
+    if (color_filter) {
+        sai->bg_color = color_t_to_rgb(&color_filter->bg_color);
+        sai->fg_color = color_t_to_rgb(&color_filter->fg_color);
         sai->has_color_filter = TRUE;
     }
 }
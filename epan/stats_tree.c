@@ -115,6 +115,7 @@ free_stat_node(stat_node *node)
     }
 
     g_free(node->rng);
+    g_free(node->rng_bins);
     g_free(node->name);
     g_free(node);
 }
@@ -216,6 +217,7 @@ stats_tree_reinit(void *p)
     }
 
     st->root.children = NULL;
+    st->root.last_child = NULL;
     st->root.counter = 0;
     switch (st->root.datatype)
     {
@@ -464,7 +466,6 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node_dataty
 {
 
     stat_node *node = g_new0(stat_node, 1);
-    stat_node *last_chld = NULL;
 
     node->datatype = datatype;
     switch (datatype)
@@ -509,17 +510,12 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node_dataty
 
     if (node->parent->children) {
         /* insert as last child */
-
-        for (last_chld = node->parent->children;
-             last_chld->next;
-             last_chld = last_chld->next ) ;
-
-        last_chld->next = node;
-
+        node->parent->last_child->next = node;
     } else {
         /* insert as first child */
         node->parent->children = node;
     }
+    node->parent->last_child = node;
 
     if(node->parent->hash) {
         g_hash_table_replace(node->parent->hash,node->name,node);
@@ -836,6 +832,86 @@ get_range(char *rngstr)
 }
 
 
+static int
+range_bin_cmp(const void *a, const void *b)
+{
+    const range_pair_t *rng_a = (*(stat_node * const *)a)->rng;
+    const range_pair_t *rng_b = (*(stat_node * const *)b)->rng;
+
+    return (rng_a->floor < rng_b->floor) ? -1 : (rng_a->floor > rng_b->floor) ? 1 : 0;
+}
+
+/*
+ * Sort the children of a range node by range, so that the one a value
+ * falls in can be found by a binary search rather than by trying each.
+ * That only works if no value is in more than one of the ranges, which
+ * is how they're normally set up; otherwise the first child whose range
+ * has the value in it gets it, as before.
+ */
+static void
+setup_range_bins(stat_node *rng_root)
+{
+    stat_node *child;
+    guint n = 0;
+    guint i;
+
+    for (child = rng_root->children; child; child = child->next) {
+        if (!child->rng)
+            return;
+        n++;
+    }
+    if (n == 0)
+        return;
+
+    rng_root->rng_bins = g_new(stat_node *, n);
+    for (child = rng_root->children, i = 0; child; child = child->next, i++) {
+        rng_root->rng_bins[i] = child;
+    }
+    qsort(rng_root->rng_bins, n, sizeof(stat_node *), range_bin_cmp);
+
+    for (i = 1; i < n; i++) {
+        if (rng_root->rng_bins[i]->rng->floor <= rng_root->rng_bins[i - 1]->rng->ceil) {
+            g_free(rng_root->rng_bins);
+            rng_root->rng_bins = NULL;
+            return;
+        }
+    }
+    rng_root->num_rng_bins = n;
+}
+
+/* The child of a range node that value is in, if any */
+static stat_node *
+find_range_bin(const stat_node *rng_root, gint value)
+{
+    stat_node *child;
+    guint lo, hi, mid;
+
+    if (rng_root->rng_bins) {
+        /* Find the last range that starts at or before the value */
+        lo = 0;
+        hi = rng_root->num_rng_bins;
+        while (lo < hi) {
+            mid = lo + (hi - lo) / 2;
+            if (rng_root->rng_bins[mid]->rng->floor <= value) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo > 0 && value <= rng_root->rng_bins[lo - 1]->rng->ceil) {
+            return rng_root->rng_bins[lo - 1];
+        }
+        return NULL;
+    }
+
+    for (child = rng_root->children; child; child = child->next) {
+        if (child->rng && value >= child->rng->floor && value <= child->rng->ceil) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
 extern int
 stats_tree_create_range_node(stats_tree *st, const gchar *name, int parent_id, ...)
 {
@@ -850,6 +926,7 @@ stats_tree_create_range_node(stats_tree *st, const gchar *name, int parent_id, .
         range_node->rng = get_range(curr_range);
     }
     va_end( list );
+    setup_range_bins(rng_root);
 
     return rng_root->id;
 }
@@ -872,6 +949,7 @@ stats_tree_create_range_node_string(stats_tree *st, const gchar *name,
     if (range_node->rng->floor == range_node->rng->ceil) {
         range_node->rng->ceil = G_MAXINT;
     }
+    setup_range_bins(rng_root);
 
     return rng_root->id;
 }
@@ -905,6 +983,7 @@ stats_tree_range_node_with_pname(stats_tree *st, const gchar *name,
         range_node->rng = get_range(curr_range);
     }
     va_end( list );
+    setup_range_bins(rng_root);
 
     return rng_root->id;
 }
@@ -918,7 +997,6 @@ stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
     stat_node *node = NULL;
     stat_node *parent = NULL;
     stat_node *child = NULL;
-    gint stat_floor, stat_ceil;
 
     if (parent_id >= 0 && parent_id < (int) st->parents->len) {
         parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
@@ -945,23 +1023,18 @@ stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
     }
     node->st_flags |= ST_FLG_AVERAGE;
 
-    for ( child = node->children; child; child = child->next) {
-        stat_floor =  child->rng->floor;
-        stat_ceil = child->rng->ceil;
-
-        if ( value_in_range >= stat_floor && value_in_range <= stat_ceil ) {
-            child->counter++;
-            child->total.int_total += value_in_range;
-            if (child->minvalue.int_min > value_in_range) {
-                child->minvalue.int_min = value_in_range;
-            }
-            if (child->maxvalue.int_max < value_in_range) {
-                child->maxvalue.int_max = value_in_range;
-            }
-            child->st_flags |= ST_FLG_AVERAGE;
-            update_burst_calc(child, 1);
-            return node->id;
+    child = find_range_bin(node, value_in_range);
+    if (child) {
+        child->counter++;
+        child->total.int_total += value_in_range;
+        if (child->minvalue.int_min > value_in_range) {
+            child->minvalue.int_min = value_in_range;
+        }
+        if (child->maxvalue.int_max < value_in_range) {
+            child->maxvalue.int_max = value_in_range;
         }
+        child->st_flags |= ST_FLG_AVERAGE;
+        update_burst_calc(child, 1);
     }
 
     return node->id;
@@ -90,11 +90,16 @@ struct _stat_node {
 	/** relatives */
 	stat_node		*parent;
 	stat_node		*children;
+	stat_node		*last_child;
 	stat_node		*next;
 
 	/** used to check if value is within range */
 	range_pair_t		*rng;
 
+	/** a range node's children sorted by range, if their ranges don't overlap */
+	stat_node		**rng_bins;
+	guint			num_rng_bins;
+
 	/** node presentation data */
 	st_node_pres		*pr;
 };
@@ -25,7 +25,9 @@
 
 #include <epan/packet_info.h>
 #include <epan/dfilter/dfilter.h>
+#include <epan/epan_dissect.h>
 #include <epan/tap.h>
+#include <wsutil/perf_stats.h>
 #include <wsutil/wslog.h>
 
 static gboolean tapping_is_active=FALSE;
@@ -86,6 +88,7 @@ typedef struct _tap_listener_t {
 	guint flags;
 	gchar *fstring;
 	dfilter_t *code;
+	guint filter_index;	/* of code in tap_filter_set */
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
@@ -95,6 +98,15 @@ typedef struct _tap_listener_t {
 
 static tap_listener_t *tap_listener_queue=NULL;
 
+/* If not NULL, the tapdata of the only listener that's given packets. */
+static void *tap_exclusive_tapdata=NULL;
+
+/* The filters of all the listeners, so that the tree is primed once for
+ * all of them and listeners with the same filter only run it once per
+ * packet; rebuilt when the listeners or their filters change. */
+static dfilter_set_t *tap_filter_set=NULL;
+static gboolean tap_filter_set_stale=TRUE;
+
 static GSList *tap_plugins = NULL;
 
 #ifdef HAVE_PLUGINS
@@ -260,22 +272,34 @@ tap_queue_packet(int tap_id, packet_info *pinfo, const void *tap_specific_data)
  * Functions used by file.c to drive the tap subsystem
  * ********************************************************************** */
 
-void tap_build_interesting (epan_dissect_t *edt)
+static void
+build_tap_filter_set(void)
 {
 	tap_listener_t *tl;
 
+	dfilter_set_free(tap_filter_set);
+	tap_filter_set=dfilter_set_new();
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->code){
+			tl->filter_index=dfilter_set_add(tap_filter_set, tl->code);
+		}
+	}
+	tap_filter_set_stale=FALSE;
+}
+
+void tap_build_interesting (epan_dissect_t *edt)
+{
 	/* nothing to do, just return */
 	if(!tap_listener_queue){
 		return;
 	}
 
-	/* loop over all tap listeners and build the list of all
-	   interesting hf_fields */
-	for(tl=tap_listener_queue;tl;tl=tl->next){
-		if(tl->code){
-			epan_dissect_prime_with_dfilter(edt, tl->code);
-		}
+	/* build the list of all interesting hf_fields of all tap
+	   listeners */
+	if(tap_filter_set_stale){
+		build_tap_filter_set();
 	}
+	dfilter_set_prime_proto_tree(tap_filter_set, edt->tree);
 }
 
 /* This function is used to delete/initialize the tap queue and prime an
@@ -319,10 +343,18 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 		return;
 	}
 
+	if(tap_filter_set_stale){
+		build_tap_filter_set();
+	}
+	dfilter_set_reset(tap_filter_set);
+
 	/* loop over all tap listeners and call the listener callback
 	   for all packets that match the filter. */
 	for(i=0;i<tap_packet_index;i++){
 		for(tl=tap_listener_queue;tl;tl=tl->next){
+			if(tap_exclusive_tapdata && tl->tapdata!=tap_exclusive_tapdata){
+				continue;
+			}
 			tp=&tap_packet_array[i];
 			/* Don't tap the packet if it's an "error packet"
 			 * unless the listener has requested that we do so.
@@ -350,7 +382,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					 */
 					guint flags = tl->flags;
 					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
+						if (!dfilter_set_apply_edt(tap_filter_set, tl->filter_index, edt)){
 							/* The packet didn't
 							 * pass the filter. */
 							if (tl->flags & TL_IGNORE_DISPLAY_FILTER)
@@ -362,8 +394,10 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 
 					/* So call the per-packet routine. */
 					tap_packet_status status;
+					guint64 start = ws_perf_timer_start();
 
 					status = tl->packet(tl->tapdata, tp->pinfo, edt, tp->tap_specific_data, flags);
+					ws_perf_timer_stop(WS_PERF_TAP_TIME, start);
 
 					switch (status) {
 
@@ -385,6 +419,17 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 }
 
 
+/* Only give packets to the listener registered with tapdata, or to all
+ * listeners if tapdata is NULL. This lets a UI run its own listener over
+ * some of the frames, e.g. the ones in one stream, without the other
+ * listeners seeing those frames a second time.
+ */
+void
+set_tap_listener_exclusive(void *tapdata)
+{
+	tap_exclusive_tapdata=tapdata;
+}
+
 /* This function can be used by a dissector to fetch any tapped data before
  * returning.
  * This can be useful if one wants to extract the data inside dissector  BEFORE
@@ -577,6 +622,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	tl->next=tap_listener_queue;
 
 	tap_listener_queue=tl;
+	tap_filter_set_stale=TRUE;
 
 	return NULL;
 }
@@ -612,6 +658,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 			dfilter_free(tl->code);
 			tl->code=NULL;
 		}
+		tap_filter_set_stale=TRUE;
 		tl->needs_redraw=TRUE;
 		g_free(tl->fstring);
 		if(fstring){
@@ -659,6 +706,7 @@ tap_listeners_dfilter_recompile(void)
 		}
 		tl->code=code;
 	}
+	tap_filter_set_stale=TRUE;
 }
 
 /* this function removes a tap listener
@@ -689,7 +737,11 @@ remove_tap_listener(void *tapdata)
 			return;
 		}
 	}
+	if(tap_exclusive_tapdata==tapdata){
+		tap_exclusive_tapdata=NULL;
+	}
 	free_tap_listener(tl);
+	tap_filter_set_stale=TRUE;
 }
 
 /*
@@ -743,6 +795,15 @@ have_filtering_tap_listeners(void)
 	return FALSE;
 }
 
+/*
+ * Return TRUE if we have any tap listeners at all, FALSE otherwise.
+ */
+gboolean
+have_tap_listeners(void)
+{
+	return tap_listener_queue != NULL;
+}
+
 /*
  * Get the union of all the flags for all the tap listeners; that gives
  * an indication of whether the protocol tree, or the columns, are
@@ -773,6 +834,9 @@ void tap_cleanup(void)
 		free_tap_listener(elem_lq);
 	}
 	tap_listener_queue = NULL;
+	dfilter_set_free(tap_filter_set);
+	tap_filter_set = NULL;
+	tap_filter_set_stale = TRUE;
 
 	while(head_dl){
 		elem_dl = head_dl;
@@ -242,6 +242,13 @@ WS_DLL_PUBLIC void tap_listeners_dfilter_recompile(void);
 /** this function removes a tap listener */
 WS_DLL_PUBLIC void remove_tap_listener(void *tapdata);
 
+/**
+ * Only give packets to the listener registered with tapdata, or to every
+ * listener again if tapdata is NULL, e.g. while retapping just the frames
+ * of one stream with cf_retap_frames().
+ */
+WS_DLL_PUBLIC void set_tap_listener_exclusive(void *tapdata);
+
 /**
  * Return TRUE if we have one or more tap listeners that require dissection,
  * FALSE otherwise.
@@ -254,6 +261,9 @@ WS_DLL_PUBLIC gboolean have_tap_listener(int tap_id);
 /** Return TRUE if we have any tap listeners with filters, FALSE otherwise. */
 WS_DLL_PUBLIC gboolean have_filtering_tap_listeners(void);
 
+/** Return TRUE if we have any tap listeners at all, FALSE otherwise. */
+WS_DLL_PUBLIC gboolean have_tap_listeners(void);
+
 /**
  * Get the union of all the flags for all the tap listeners; that gives
  * an indication of whether the protocol tree, or the columns, are
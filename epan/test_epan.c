@@ -9,6 +9,7 @@
 #include "config.h"
 
 #include "strutil.h"
+#include "in_cksum.h"
 #include <wsutil/utf8_entities.h>
 
 /*
@@ -74,6 +75,66 @@ void test_label_escape_control(void)
     g_assert_cmpuint(pos, ==, strlen(dst));
 }
 
+/* The Internet checksum of the bytes of vec, a byte at a time. */
+static int
+in_cksum_reference(const vec_t *vec, int veclen)
+{
+    guint64 sum = 0;
+    guint pos = 0;
+
+    for (int i = 0; i < veclen; i++) {
+        for (int j = 0; j < vec[i].len; j++, pos++) {
+            /* Bytes at even offsets are the high bytes of the words. */
+            sum += (pos & 1) ? vec[i].ptr[j] : (guint)vec[i].ptr[j] << 8;
+        }
+    }
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return g_ntohs((guint16)~sum);
+}
+
+/* in_cksum() sums most of the data with whichever routine suits the
+ * processor; check it against the simple one with all the lengths and
+ * alignments that take it down different paths. */
+void test_in_cksum(void)
+{
+    guint8 *data;
+    vec_t vec[3];
+    int len, offset, split;
+
+    data = g_malloc(4096 + 64);
+    for (int i = 0; i < 4096 + 64; i++)
+        data[i] = (guint8)g_test_rand_int();
+
+    for (len = 0; len <= 300; len++) {
+        for (offset = 0; offset < 8; offset++) {
+            SET_CKSUM_VEC_PTR(vec[0], data + offset, len);
+            g_assert_cmpint(in_cksum(vec, 1), ==, in_cksum_reference(vec, 1));
+        }
+    }
+
+    /* Pieces starting and ending at odd and even offsets */
+    for (split = 0; split <= 130; split++) {
+        for (offset = 0; offset < 4; offset++) {
+            SET_CKSUM_VEC_PTR(vec[0], data + offset, split);
+            SET_CKSUM_VEC_PTR(vec[1], data + 1000 + offset, 257);
+            SET_CKSUM_VEC_PTR(vec[2], data + 3 * offset, 130 - split);
+            g_assert_cmpint(in_cksum(vec, 3), ==, in_cksum_reference(vec, 3));
+        }
+    }
+
+    /* Large, all ones, and all zeros */
+    SET_CKSUM_VEC_PTR(vec[0], data + 1, 4095);
+    g_assert_cmpint(in_cksum(vec, 1), ==, in_cksum_reference(vec, 1));
+    memset(data, 0xff, 4096);
+    SET_CKSUM_VEC_PTR(vec[0], data, 4096);
+    g_assert_cmpint(in_cksum(vec, 1), ==, in_cksum_reference(vec, 1));
+    memset(data, 0, 4096);
+    g_assert_cmpint(in_cksum(vec, 1), ==, 0xffff);
+
+    g_free(data);
+}
+
 int main(int argc, char **argv)
 {
     int ret;
@@ -86,6 +147,8 @@ int main(int argc, char **argv)
     g_test_add_func("/label/escape_whitespace", test_label_strcat_escape_whitespace);
     g_test_add_func("/label/escape_control", test_label_escape_control);
 
+    g_test_add_func("/checksum/in_cksum", test_in_cksum);
+
     ret = g_test_run();
 
     return ret;
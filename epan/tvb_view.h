@@ -0,0 +1,167 @@
+/** @file
+ *
+ * Checked-once views of fixed-layout regions of a tvbuff
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __TVB_VIEW_H__
+#define __TVB_VIEW_H__
+
+#include <glib.h>
+#include <string.h>
+
+#include <epan/tvbuff.h>
+#include <wsutil/pint.h>
+#include <wsutil/ws_assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A view of a region of a tvbuff, such as a protocol's fixed-length header,
+ * whose presence is checked once, when the view is set up, rather than on
+ * each access; the accessors then just read the data.
+ *
+ * If the region isn't all there, as with a short frame, the accessors fall
+ * back on the checked tvb_get_ routines, so that those throw the same
+ * exception, at the same point in dissection, as they would have without
+ * the view; a dissector can be converted to use views without changing
+ * what it shows for short frames.
+ *
+ * Offsets given to the accessors are from the start of the view, and must
+ * be within the length given when setting it up.
+ */
+typedef struct tvb_view {
+    tvbuff_t     *tvb;
+    const guint8 *data;     /* NULL if the region isn't all there */
+    gint          offset;
+    guint         length;
+} tvb_view_t;
+
+/*
+ * Set up a view of length bytes at offset in tvb.
+ */
+static inline void
+tvb_view_init(tvb_view_t *view, tvbuff_t *tvb, const gint offset, const guint length)
+{
+    view->tvb    = tvb;
+    view->offset = offset;
+    view->length = length;
+    if (tvb_bytes_exist(tvb, offset, (gint)length))
+        view->data = tvb_get_ptr(tvb, offset, (gint)length);
+    else
+        view->data = NULL;
+}
+
+/*
+ * Is the whole region there?
+ */
+static inline gboolean
+tvb_view_is_complete(const tvb_view_t *view)
+{
+    return view->data != NULL;
+}
+
+static inline guint8
+tvb_view_get_guint8(const tvb_view_t *view, const guint off)
+{
+    ws_assert(off + 1 <= view->length);
+    if (G_LIKELY(view->data != NULL))
+        return view->data[off];
+    return tvb_get_guint8(view->tvb, view->offset + off);
+}
+
+static inline guint16
+tvb_view_get_ntohs(const tvb_view_t *view, const guint off)
+{
+    ws_assert(off + 2 <= view->length);
+    if (G_LIKELY(view->data != NULL))
+        return pntoh16(view->data + off);
+    return tvb_get_ntohs(view->tvb, view->offset + off);
+}
+
+static inline guint32
+tvb_view_get_ntoh24(const tvb_view_t *view, const guint off)
+{
+    ws_assert(off + 3 <= view->length);
+    if (G_LIKELY(view->data != NULL))
+        return pntoh24(view->data + off);
+    return tvb_get_ntoh24(view->tvb, view->offset + off);
+}
+
+static inline guint32
+tvb_view_get_ntohl(const tvb_view_t *view, const guint off)
+{
+    ws_assert(off + 4 <= view->length);
+    if (G_LIKELY(view->data != NULL))
+        return pntoh32(view->data + off);
+    return tvb_get_ntohl(view->tvb, view->offset + off);
+}
+
+static inline guint64
+tvb_view_get_ntoh64(const tvb_view_t *view, const guint off)
+{
+    ws_assert(off + 8 <= view->length);
+    if (G_LIKELY(view->data != NULL))
+        return pntoh64(view->data + off);
+    return tvb_get_ntoh64(view->tvb, view->offset + off);
+}
+
+static inline guint16
+tvb_view_get_letohs(const tvb_view_t *view, const guint off)
+{
+    ws_assert(off + 2 <= view->length);
+    if (G_LIKELY(view->data != NULL))
+        return pletoh16(view->data + off);
+    return tvb_get_letohs(view->tvb, view->offset + off);
+}
+
+static inline guint32
+tvb_view_get_letohl(const tvb_view_t *view, const guint off)
+{
+    ws_assert(off + 4 <= view->length);
+    if (G_LIKELY(view->data != NULL))
+        return pletoh32(view->data + off);
+    return tvb_get_letohl(view->tvb, view->offset + off);
+}
+
+/*
+ * Returns an IPv4 address in network byte order, as tvb_get_ipv4() does.
+ */
+static inline guint32
+tvb_view_get_ipv4(const tvb_view_t *view, const guint off)
+{
+    guint32 addr;
+
+    ws_assert(off + 4 <= view->length);
+    if (G_LIKELY(view->data != NULL)) {
+        memcpy(&addr, view->data + off, sizeof addr);
+        return addr;
+    }
+    return tvb_get_ipv4(view->tvb, view->offset + off);
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __TVB_VIEW_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -16,6 +16,7 @@
 #include <string.h>
 
 #include "tvbuff.h"
+#include "tvb_view.h"
 #include "proto.h"
 #include "exceptions.h"
 #include "wsutil/pint.h"
@@ -405,10 +406,10 @@ run_tests(void)
 	guint		subset_length[6];
 	guint		subset_reported_length[6];
 	guint8		temp;
-	guint8		*comp[6];
-	tvbuff_t	*tvb_comp[6];
-	guint		comp_length[6];
-	guint		comp_reported_length[6];
+	guint8		*comp[7];
+	tvbuff_t	*tvb_comp[7];
+	guint		comp_length[7];
+	guint		comp_reported_length[7];
 	tvbuff_t	*tvb_comp_subset;
 	guint		comp_subset_length;
 	guint		comp_subset_reported_length;
@@ -580,6 +581,29 @@ run_tests(void)
 	tvb_composite_append(tvb_comp[5], tvb_comp[3]);
 	tvb_composite_finalize(tvb_comp[5]);
 
+	/* Many members, appended and prepended */
+	printf("Making Composite 6\n");
+	tvb_comp[6]		= tvb_new_composite();
+	comp_length[6]		= 0;
+	comp_reported_length[6]	= 0;
+	comp[6]			= (guint8*)g_malloc(3 * (small_length[0] + large_length[0]) + subset_length[2]);
+	len = 0;
+	memcpy(&comp[6][len], subset[2], subset_length[2]);
+	len += subset_length[2];
+	for (i = 0; i < 3; i++) {
+		memcpy(&comp[6][len], small[i], small_length[i]);
+		len += small_length[i];
+		memcpy(&comp[6][len], large[i], large_length[i]);
+		len += large_length[i];
+		tvb_composite_append(tvb_comp[6], tvb_small[i]);
+		tvb_composite_append(tvb_comp[6], tvb_large[i]);
+		comp_reported_length[6] += small_reported_length[i] + large_reported_length[i];
+	}
+	tvb_composite_prepend(tvb_comp[6], tvb_subset[2]);
+	comp_reported_length[6] += subset_reported_length[2];
+	comp_length[6] = len;
+	tvb_composite_finalize(tvb_comp[6]);
+
 	/* A subset of one of the composites. */
 	tvb_comp_subset = tvb_new_subset_remaining(tvb_comp[1], 1);
 	comp_subset = &comp[1][1];
@@ -593,6 +617,7 @@ run_tests(void)
 	test(tvb_comp[3], "Composite 3", comp[3], comp_length[3], comp_reported_length[3]);
 	test(tvb_comp[4], "Composite 4", comp[4], comp_length[4], comp_reported_length[4]);
 	test(tvb_comp[5], "Composite 5", comp[5], comp_length[5], comp_reported_length[5]);
+	test(tvb_comp[6], "Composite 6", comp[6], comp_length[6], comp_reported_length[6]);
 
 	/* Test the subset of the composite. */
 	test(tvb_comp_subset, "Subset of Composite", comp_subset, comp_subset_length, comp_subset_reported_length);
@@ -604,6 +629,7 @@ run_tests(void)
 	g_free(comp[3]);
 	g_free(comp[4]);
 	g_free(comp[5]);
+	g_free(comp[6]);
 
 	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
 }
@@ -700,6 +726,62 @@ varint_tests(void)
 	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
 }
 
+static void
+view_tests(void)
+{
+	static const guint8 hdr[] = {
+		0x45, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+		0x07, 0x08, 0x09, 0x0a
+	};
+	tvbuff_t	*tvb_parent, *tvb;
+	tvb_view_t	view;
+	volatile unsigned long got_ex;
+
+	tvb_parent = tvb_new_real_data((const guint8*)"", 0, 0);
+	tvb = tvb_new_child_real_data(tvb_parent, hdr, sizeof hdr, sizeof hdr + 4);
+
+	/* All there: the accessors read the data. */
+	tvb_view_init(&view, tvb, 2, 8);
+	if (!tvb_view_is_complete(&view) ||
+	    tvb_view_get_guint8(&view, 0) != 0x01 ||
+	    tvb_view_get_ntohs(&view, 0) != 0x0102 ||
+	    tvb_view_get_ntoh24(&view, 1) != 0x020304 ||
+	    tvb_view_get_ntohl(&view, 4) != 0x05060708 ||
+	    tvb_view_get_ntoh64(&view, 0) != G_GUINT64_CONSTANT(0x0102030405060708) ||
+	    tvb_view_get_letohs(&view, 0) != 0x0201 ||
+	    tvb_view_get_letohl(&view, 4) != 0x08070605 ||
+	    tvb_view_get_ipv4(&view, 4) != tvb_get_ipv4(tvb, 6)) {
+		printf("Failed view of complete region\n");
+		failed = TRUE;
+	}
+
+	/* Not all there: what's there can be read, and reading what isn't
+	 * throws the same exception as tvb_get_ntohl() would. */
+	tvb_view_init(&view, tvb, 4, 12);
+	got_ex = 0;
+	TRY {
+		if (tvb_view_is_complete(&view) ||
+		    tvb_view_get_ntohl(&view, 4) != 0x0708090a) {
+			printf("Failed view of incomplete region\n");
+			failed = TRUE;
+		}
+		tvb_view_get_ntohl(&view, 8);
+	}
+	CATCH_ALL {
+		got_ex = exc->except_id.except_code;
+	}
+	ENDTRY;
+	if (got_ex != BoundsError) {
+		printf("Failed view of incomplete region with exception=%lu while expected exception=%lu\n",
+			   got_ex, (unsigned long)BoundsError);
+		failed = TRUE;
+	} else {
+		printf("Passed views\n");
+	}
+
+	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
+}
+
 /* Note: valgrind can be used to check for tvbuff memory leaks */
 int
 main(void)
@@ -711,6 +793,7 @@ main(void)
 	except_init();
 	run_tests();
 	varint_tests();
+	view_tests();
 	except_deinit();
 	exit(failed?1:0);
 }
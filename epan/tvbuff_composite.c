@@ -16,7 +16,7 @@
 #include "proto.h"	/* XXX - only used for DISSECTOR_ASSERT, probably a new header file? */
 
 typedef struct {
-	GSList		*tvbs;
+	GPtrArray	*tvbs;
 
 	/* Used for quick testing to see if this
 	 * is the tvbuff that a COMPOSITE is
@@ -24,6 +24,10 @@ typedef struct {
 	guint		*start_offsets;
 	guint		*end_offsets;
 
+	/* The member the last access started in; most accesses
+	 * start in the same one or in the next one. */
+	guint		last_member;
+
 } tvb_comp_t;
 
 struct tvb_composite {
@@ -38,7 +42,7 @@ composite_free(tvbuff_t *tvb)
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite = &composite_tvb->composite;
 
-	g_slist_free(composite->tvbs);
+	g_ptr_array_free(composite->tvbs, TRUE);
 
 	g_free(composite->start_offsets);
 	g_free(composite->end_offsets);
@@ -51,37 +55,66 @@ composite_offset(const tvbuff_t *tvb _U_, const guint counter)
 	return counter;
 }
 
+/*
+ * Find the member tvbuff that the given offset is in, or return the
+ * number of members if it's at or past the end.
+ */
+static guint
+composite_find_member(tvb_comp_t *composite, guint abs_offset)
+{
+	guint num_members = composite->tvbs->len;
+	guint i = composite->last_member;
+	guint low, high, mid;
+
+	/* Try the member the last access started in, and the one after it. */
+	if (abs_offset >= composite->start_offsets[i]) {
+		if (abs_offset <= composite->end_offsets[i])
+			return i;
+		if (i + 1 < num_members && abs_offset <= composite->end_offsets[i + 1]) {
+			composite->last_member = i + 1;
+			return i + 1;
+		}
+	}
+
+	/* Find the first member that ends at or after the offset. */
+	if (abs_offset > composite->end_offsets[num_members - 1])
+		return num_members;
+	low = 0;
+	high = num_members - 1;
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (abs_offset <= composite->end_offsets[mid])
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	composite->last_member = low;
+	return low;
+}
+
 static const guint8*
 composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset;
-	GSList	   *slist;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
 	/* Maybe the range specified by offset/length
 	 * is contiguous inside one of the member tvbuffs */
 	composite = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->tvbs->len) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return "";
 	}
 
+	member_tvb = (tvbuff_t *)g_ptr_array_index(composite->tvbs, i);
 	member_offset = abs_offset - composite->start_offsets[i];
 
 	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
@@ -108,63 +141,61 @@ composite_memcpy(tvbuff_t *tvb, void* _target, guint abs_offset, guint abs_lengt
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	guint8 *target = (guint8 *) _target;
 
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset, member_length;
-	GSList	   *slist;
+	guint	    copied = 0;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
 	/* Maybe the range specified by offset/length
 	 * is contiguous inside one of the member tvbuffs */
 	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->tvbs->len) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return target;
 	}
 
+	member_tvb = (tvbuff_t *)g_ptr_array_index(composite->tvbs, i);
 	member_offset = abs_offset - composite->start_offsets[i];
 
 	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
 		DISSECTOR_ASSERT(!tvb->real_data);
 		return tvb_memcpy(member_tvb, target, member_offset, abs_length);
 	}
-	else {
-		/* The requested data is non-contiguous inside
-		 * the member tvb. We have to memcpy() the part that's in the member tvb,
-		 * then iterate across the other member tvb's, copying their portions
-		 * until we have copied all data.
-		 */
+
+	/* The requested data is non-contiguous inside
+	 * the member tvb. We have to memcpy() the part that's in the member tvb,
+	 * then iterate across the other member tvb's, copying their portions
+	 * until we have copied all data.
+	 */
+	for (;;) {
 		member_length = tvb_captured_length_remaining(member_tvb, member_offset);
 
 		/* composite_memcpy() can't handle a member_length of zero. */
 		DISSECTOR_ASSERT(member_length > 0);
 
-		tvb_memcpy(member_tvb, target, member_offset, member_length);
-		abs_offset	+= member_length;
-		abs_length	-= member_length;
-
-		/* Recurse */
-		if (abs_length > 0) {
-			composite_memcpy(tvb, target + member_length, abs_offset, abs_length);
-		}
+		if (member_length > abs_length)
+			member_length = abs_length;
+		tvb_memcpy(member_tvb, target + copied, member_offset, member_length);
+		copied     += member_length;
+		abs_length -= member_length;
+		if (abs_length == 0)
+			break;
 
-		return target;
+		/* On to the next member; the caller has checked that
+		 * the data is all there. */
+		i++;
+		DISSECTOR_ASSERT(i < composite->tvbs->len);
+		member_tvb = (tvbuff_t *)g_ptr_array_index(composite->tvbs, i);
+		member_offset = 0;
 	}
 
-	DISSECTOR_ASSERT_NOT_REACHED();
+	return target;
 }
 
 static const struct tvb_ops tvb_composite_ops = {
@@ -198,9 +229,10 @@ tvb_new_composite(void)
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite = &composite_tvb->composite;
 
-	composite->tvbs		 = NULL;
+	composite->tvbs		 = g_ptr_array_new();
 	composite->start_offsets = NULL;
 	composite->end_offsets	 = NULL;
+	composite->last_member	 = 0;
 
 	return tvb;
 }
@@ -219,11 +251,11 @@ tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
 	 */
 	if (member && member->length) {
 		composite       = &composite_tvb->composite;
-		composite->tvbs = g_slist_append(composite->tvbs, member);
+		g_ptr_array_add(composite->tvbs, member);
 
 		/* Attach the composite TVB to the first TVB only. */
-		if (!composite->tvbs->next) {
-			tvb_add_to_chain((tvbuff_t *)composite->tvbs->data, tvb);
+		if (composite->tvbs->len == 1) {
+			tvb_add_to_chain(member, tvb);
 		}
 	}
 }
@@ -242,11 +274,11 @@ tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member)
 	 */
 	if (member && member->length) {
 		composite       = &composite_tvb->composite;
-		composite->tvbs = g_slist_prepend(composite->tvbs, member);
+		g_ptr_array_insert(composite->tvbs, 0, member);
 
 		/* Attach the composite TVB to the first TVB only. */
-		if (!composite->tvbs->next) {
-			tvb_add_to_chain((tvbuff_t *)composite->tvbs->data, tvb);
+		if (composite->tvbs->len == 1) {
+			tvb_add_to_chain(member, tvb);
 		}
 	}
 }
@@ -255,11 +287,10 @@ void
 tvb_composite_finalize(tvbuff_t *tvb)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	GSList	   *slist;
 	guint	    num_members;
 	tvbuff_t   *member_tvb;
 	tvb_comp_t *composite;
-	int	    i = 0;
+	guint	    i;
 
 	DISSECTOR_ASSERT(tvb && !tvb->initialized);
 	DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops);
@@ -268,7 +299,7 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	DISSECTOR_ASSERT(tvb->contained_length == 0);
 
 	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
+	num_members = composite->tvbs->len;
 
 	/* Dissectors should not create composite TVBs if they're not going to
 	 * put at least one TVB in them.
@@ -279,15 +310,13 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	composite->start_offsets = g_new(guint, num_members);
 	composite->end_offsets = g_new(guint, num_members);
 
-	for (slist = composite->tvbs; slist != NULL; slist = slist->next) {
-		DISSECTOR_ASSERT((guint) i < num_members);
-		member_tvb = (tvbuff_t *)slist->data;
+	for (i = 0; i < num_members; i++) {
+		member_tvb = (tvbuff_t *)g_ptr_array_index(composite->tvbs, i);
 		composite->start_offsets[i] = tvb->length;
 		tvb->length += member_tvb->length;
 		tvb->reported_length += member_tvb->reported_length;
 		tvb->contained_length += member_tvb->contained_length;
 		composite->end_offsets[i] = tvb->length - 1;
-		i++;
 	}
 
 	tvb->initialized = TRUE;
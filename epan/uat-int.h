@@ -61,6 +61,7 @@ struct epan_uat {
     uat_rep_free_cb_t free_rep;
     gboolean loaded;
     gboolean from_global;
+    gchar* loaded_checksum; /**< Checksum of the file the records were loaded from, if they have not been modified since. */
 };
 
 WS_DLL_PUBLIC
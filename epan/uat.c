@@ -92,6 +92,7 @@ uat_t* uat_new(const char* name,
     uat->changed = FALSE;
     uat->loaded = FALSE;
     uat->from_global = FALSE;
+    uat->loaded_checksum = NULL;
     uat->rep = NULL;
     uat->free_rep = NULL;
     uat->help = g_strdup(help);
@@ -115,6 +116,15 @@ uat_t* uat_new(const char* name,
     return uat;
 }
 
+/*
+ * The records no longer match the file they were loaded from, so they can't
+ * be kept when a profile with the same file is loaded.
+ */
+static void uat_forget_loaded_file(uat_t* uat) {
+    g_free(uat->loaded_checksum);
+    uat->loaded_checksum = NULL;
+}
+
 void* uat_add_record(uat_t* uat, const void* data, gboolean valid_rec) {
     void* rec;
     gboolean* valid;
@@ -158,6 +168,8 @@ void uat_update_record(uat_t *uat, const void *record, gboolean valid_rec) {
         ws_assert_not_reached();
     }
 
+    uat_forget_loaded_file(uat);
+
     valid = &g_array_index(uat->valid_data, gboolean, pos);
     *valid = valid_rec;
 }
@@ -171,6 +183,8 @@ void uat_swap(uat_t* uat, guint a, guint b) {
 
     if (a == b) return;
 
+    uat_forget_loaded_file(uat);
+
     tmp = g_malloc(s);
     memcpy(tmp, UAT_INDEX_PTR(uat,a), s);
     memcpy(UAT_INDEX_PTR(uat,a), UAT_INDEX_PTR(uat,b), s);
@@ -188,6 +202,8 @@ void uat_insert_record_idx(uat_t* uat, guint idx, const void *src_record) {
     /* Allow insert before an existing item or append after the last item. */
     ws_assert( idx <= uat->raw_data->len );
 
+    uat_forget_loaded_file(uat);
+
     /* Store a copy of the record and invoke copy_cb to clone pointers too. */
     g_array_insert_vals(uat->raw_data, idx, src_record, 1);
     void *rec = UAT_INDEX_PTR(uat, idx);
@@ -207,6 +223,8 @@ void uat_remove_record_idx(uat_t* uat, guint idx) {
 
     ws_assert( idx < uat->raw_data->len );
 
+    uat_forget_loaded_file(uat);
+
     if (uat->free_cb) {
         uat->free_cb(UAT_INDEX_PTR(uat,idx));
     }
@@ -440,6 +458,7 @@ gboolean uat_save(uat_t* uat, char** error) {
     fclose(fp);
 
     uat->changed = FALSE;
+    uat_forget_loaded_file(uat);
 
     return TRUE;
 }
@@ -479,6 +498,8 @@ void uat_clear(uat_t* uat) {
     *((uat)->user_ptr) = NULL;
     *((uat)->nrows_p) = 0;
 
+    uat_forget_loaded_file(uat);
+
     if (uat->reset_cb) {
         uat->reset_cb();
     }
@@ -491,7 +512,15 @@ void uat_unload_all(void) {
         uat_t* u = (uat_t *)g_ptr_array_index(all_uats,i);
         /* Do not unload if not in profile */
         if (u->from_profile) {
-            uat_clear(u);
+            /*
+             * Records that are still exactly what was read from a file
+             * are kept until the next profile's file is loaded; if it has
+             * the same contents, uat_load() reuses them rather than
+             * parsing the file again.
+             */
+            if (!u->loaded_checksum || u->changed) {
+                uat_clear(u);
+            }
             u->loaded = FALSE;
         }
     }
@@ -508,6 +537,7 @@ void uat_cleanup(void) {
         g_free(uat->help);
         g_free(uat->name);
         g_free(uat->filename);
+        g_free(uat->loaded_checksum);
         g_array_free(uat->user_data, TRUE);
         g_array_free(uat->raw_data, TRUE);
         g_array_free(uat->valid_data, TRUE);
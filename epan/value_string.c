@@ -24,6 +24,14 @@
 
 /* REGULAR VALUE STRING */
 
+static const gchar *value_string_auto_index_lookup(const guint32 val,
+        const value_string *vs, gint *idx);
+
+/* Searching a value_string that's registered for a field, and that has more
+   than this many entries, past the first this many uses an index instead of
+   going on linearly; see value_string_auto_index_register(). */
+#define VS_AUTO_INDEX_MIN_ENTRIES 32
+
 /* Tries to match val against each element in the value_string array vs.
    Returns the associated string ptr on a match.
    Formats val with fmt, and returns the resulting string, on failure. */
@@ -91,6 +99,8 @@ try_val_to_str_idx(const guint32 val, const value_string *vs, gint *idx)
                 return(vs[i].strptr);
             }
             i++;
+            if (i == VS_AUTO_INDEX_MIN_ENTRIES)
+                return value_string_auto_index_lookup(val, vs, idx);
         }
     }
 
@@ -106,6 +116,219 @@ try_val_to_str(const guint32 val, const value_string *vs)
     return try_val_to_str_idx(val, vs, &ignore_me);
 }
 
+/* AUTOMATICALLY INDEXED VALUE STRING */
+
+/* Big value_strings that aren't value_string_exts, such as the ones in
+ * generated ASN.1 dissectors, are often not sorted, so a value_string_ext
+ * couldn't do better than a linear search for them anyway.  Instead,
+ * proto_register_field_init() hands us each field's value_string, and,
+ * for the big ones, we build an index from value to position in the
+ * array, so that try_val_to_str_idx() can find values past the first
+ * VS_AUTO_INDEX_MIN_ENTRIES in constant or logarithmic time.
+ *
+ * The index is a direct map if the values are dense, and a sorted array
+ * otherwise.  Either way, it gives the first entry for each value, so
+ * the results are the same as those of a linear search.
+ *
+ * Registering only notes the value_string; the index is built the first
+ * time a lookup gets past VS_AUTO_INDEX_MIN_ENTRIES.  Most big
+ * value_strings are never searched in a given session, so this keeps
+ * the sorting out of epan_init().
+ */
+typedef struct {
+    guint32 value;
+    gint    idx;
+} vs_auto_index_entry_t;
+
+typedef struct {
+    guint32                first_value;  /* for the direct map */
+    guint32                map_len;      /* 0 if there's no direct map */
+    gint                  *map;          /* -1 for values that aren't there */
+    guint                  num_sorted;   /* distinct values */
+    vs_auto_index_entry_t *sorted;
+} vs_auto_index_t;
+
+/* Maps a value_string array to its vs_auto_index_t, or to NULL if the
+ * index hasn't been built yet. */
+static GHashTable *vs_auto_indexes = NULL;
+
+static void
+vs_auto_index_free(gpointer data)
+{
+    vs_auto_index_t *vsai = (vs_auto_index_t *)data;
+
+    if (vsai == NULL)
+        return;
+    g_free(vsai->map);
+    g_free(vsai->sorted);
+    g_free(vsai);
+}
+
+static int
+vs_auto_index_entry_compare(const void *a, const void *b)
+{
+    const vs_auto_index_entry_t *entry_a = (const vs_auto_index_entry_t *)a;
+    const vs_auto_index_entry_t *entry_b = (const vs_auto_index_entry_t *)b;
+
+    if (entry_a->value != entry_b->value)
+        return entry_a->value < entry_b->value ? -1 : 1;
+    /* The first entry with a value is the one a linear search finds. */
+    return entry_a->idx < entry_b->idx ? -1 : (entry_a->idx > entry_b->idx);
+}
+
+static vs_auto_index_t *
+vs_auto_index_build(const value_string *vs)
+{
+    vs_auto_index_t *vsai;
+    guint num_entries, i, j;
+
+    for (num_entries = 0; vs[num_entries].strptr != NULL; num_entries++)
+        ;
+
+    vsai = g_new0(vs_auto_index_t, 1);
+
+    vsai->sorted = g_new(vs_auto_index_entry_t, num_entries);
+    for (i = 0; i < num_entries; i++) {
+        vsai->sorted[i].value = vs[i].value;
+        vsai->sorted[i].idx   = (gint)i;
+    }
+    qsort(vsai->sorted, num_entries, sizeof (vs_auto_index_entry_t),
+            vs_auto_index_entry_compare);
+
+    /* Keep only the first entry for each value. */
+    for (i = 1, j = 0; i < num_entries; i++) {
+        if (vsai->sorted[i].value != vsai->sorted[j].value)
+            vsai->sorted[++j] = vsai->sorted[i];
+    }
+    vsai->num_sorted = j + 1;
+
+    /* Use a direct map if it wouldn't be much bigger than the sorted
+     * array. */
+    if (vsai->sorted[j].value - vsai->sorted[0].value < 4 * (guint32)vsai->num_sorted) {
+        vsai->first_value = vsai->sorted[0].value;
+        vsai->map_len     = vsai->sorted[j].value - vsai->first_value + 1;
+        vsai->map         = g_new(gint, vsai->map_len);
+        for (i = 0; i < vsai->map_len; i++)
+            vsai->map[i] = -1;
+        for (i = 0; i < vsai->num_sorted; i++)
+            vsai->map[vsai->sorted[i].value - vsai->first_value] = vsai->sorted[i].idx;
+        g_free(vsai->sorted);
+        vsai->sorted = NULL;
+    }
+
+    return vsai;
+}
+
+/* Returns the index for vs, building it if need be, or NULL if vs
+ * wasn't registered. */
+static vs_auto_index_t *
+vs_auto_index_get(const value_string *vs)
+{
+    gpointer vsai;
+
+    if (vs_auto_indexes == NULL ||
+        !g_hash_table_lookup_extended(vs_auto_indexes, vs, NULL, &vsai))
+        return NULL;
+
+    if (vsai == NULL) {
+        vsai = vs_auto_index_build(vs);
+        g_hash_table_insert(vs_auto_indexes, (gpointer)vs, vsai);
+    }
+    return (vs_auto_index_t *)vsai;
+}
+
+void
+value_string_auto_index_register(const value_string *vs)
+{
+    guint num_entries;
+
+    if (vs == NULL)
+        return;
+
+    /* We only need to know that it's big enough. */
+    for (num_entries = 0; num_entries <= VS_AUTO_INDEX_MIN_ENTRIES; num_entries++) {
+        if (vs[num_entries].strptr == NULL)
+            return;
+    }
+
+    if (vs_auto_indexes == NULL)
+        vs_auto_indexes = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                NULL, vs_auto_index_free);
+    else if (g_hash_table_contains(vs_auto_indexes, vs))
+        return;
+
+    g_hash_table_insert(vs_auto_indexes, (gpointer)vs, NULL);
+}
+
+void
+value_string_auto_index_cleanup(void)
+{
+    if (vs_auto_indexes) {
+        g_hash_table_destroy(vs_auto_indexes);
+        vs_auto_indexes = NULL;
+    }
+}
+
+const gchar *
+value_string_auto_index_match_type_str(const value_string *vs)
+{
+    vs_auto_index_t *vsai;
+
+    if ((vsai = vs_auto_index_get(vs)) == NULL)
+        return NULL;
+    return vsai->map ? "[Direct (indexed) Access]" : "[Binary Search]";
+}
+
+/* Called by try_val_to_str_idx() once it has looked at the first
+ * VS_AUTO_INDEX_MIN_ENTRIES entries of vs without finding val. */
+static const gchar *
+value_string_auto_index_lookup(const guint32 val, const value_string *vs, gint *idx)
+{
+    vs_auto_index_t *vsai;
+    guint low, mid, max;
+    gint i;
+
+    vsai = vs_auto_index_get(vs);
+
+    if (vsai == NULL) {
+        /* Not indexed; go on linearly. */
+        for (i = VS_AUTO_INDEX_MIN_ENTRIES; vs[i].strptr; i++) {
+            if (vs[i].value == val) {
+                *idx = i;
+                return vs[i].strptr;
+            }
+        }
+        *idx = -1;
+        return NULL;
+    }
+
+    if (vsai->map) {
+        if (val - vsai->first_value < vsai->map_len) {
+            i = vsai->map[val - vsai->first_value];
+            if (i >= 0) {
+                *idx = i;
+                return vs[i].strptr;
+            }
+        }
+        *idx = -1;
+        return NULL;
+    }
+
+    for (low = 0, max = vsai->num_sorted; low < max; ) {
+        mid = (low + max) / 2;
+        if (val < vsai->sorted[mid].value) {
+            max = mid;
+        } else if (val > vsai->sorted[mid].value) {
+            low = mid + 1;
+        } else {
+            *idx = vsai->sorted[mid].idx;
+            return vs[*idx].strptr;
+        }
+    }
+    *idx = -1;
+    return NULL;
+}
+
 const gchar *
 char_val_to_str(char val, const value_string *vs, const char *msg)
 {
@@ -365,6 +365,22 @@ WS_DLL_LOCAL
 const gchar *
 val64_string_ext_match_type_str(const val64_string_ext *vse);
 
+/* Note a big value_string, so that try_val_to_str() and the like needn't
+ * search it linearly; called when registering a field that uses it.  The
+ * index is built on the first lookup that needs it. */
+WS_DLL_LOCAL
+void
+value_string_auto_index_register(const value_string *vs);
+
+WS_DLL_LOCAL
+void
+value_string_auto_index_cleanup(void);
+
+/* How an indexed value_string is searched, or NULL if it isn't indexed. */
+WS_DLL_LOCAL
+const gchar *
+value_string_auto_index_match_type_str(const value_string *vs);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
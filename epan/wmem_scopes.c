@@ -13,6 +13,7 @@
 
 #include "wmem_scopes.h"
 
+#include <ws_attributes.h>
 #include <wsutil/ws_assert.h>
 
 /* One of the supposed benefits of wmem over the old emem was going to be that
@@ -35,8 +36,17 @@
  * perfect, but it should stop most of the bad behaviour that emem permitted.
  */
 
-/* TODO: Make these thread-local */
-static wmem_allocator_t *packet_scope = NULL;
+/* The packet scope is per thread, so that packets dissected on different
+ * threads don't share, or contend for, one allocator. The thread that calls
+ * wmem_init_scopes() gets one straight away; any other thread gets its own
+ * the first time it enters the packet scope, and it's freed when that
+ * thread exits.
+ *
+ * The file and epan scopes are shared by the whole process, and, like
+ * every other wmem allocator, aren't thread-safe; see wmem_scopes.h.
+ */
+static WS_THREAD_LOCAL wmem_allocator_t *packet_scope = NULL;
+static GPrivate thread_packet_scope = G_PRIVATE_INIT((GDestroyNotify)wmem_destroy_allocator);
 static wmem_allocator_t *file_scope   = NULL;
 static wmem_allocator_t *epan_scope   = NULL;
 
@@ -53,7 +63,13 @@ wmem_packet_scope(void)
 void
 wmem_enter_packet_scope(void)
 {
-    ws_assert(packet_scope);
+    if (packet_scope == NULL) {
+        /* This thread hasn't dissected a packet before. */
+        ws_assert(epan_scope);
+        packet_scope = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+        wmem_leave_scope(packet_scope);
+        g_private_set(&thread_packet_scope, packet_scope);
+    }
     ws_assert(wmem_in_scope(file_scope));
     ws_assert(!wmem_in_scope(packet_scope));
 
@@ -93,13 +109,15 @@ wmem_leave_file_scope(void)
 {
     ws_assert(file_scope);
     ws_assert(wmem_in_scope(file_scope));
-    ws_assert(!wmem_in_scope(packet_scope));
+    ws_assert(!packet_scope || !wmem_in_scope(packet_scope));
 
     wmem_leave_scope(file_scope);
 
     /* this seems like a good time to do garbage collection */
     wmem_gc(file_scope);
-    wmem_gc(packet_scope);
+    if (packet_scope) {
+        wmem_gc(packet_scope);
+    }
 }
 
 /* Epan Scope */
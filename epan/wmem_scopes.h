@@ -31,6 +31,8 @@ wmem_epan_scope(void);
  * @brief Fetch the current packet scope.
  *
  * Allocated memory is freed when wmem_leave_packet_scope() is called, which is normally at the end of packet dissection.
+ * Each thread has its own packet scope, as each epan_dissect_t has its own pinfo->pool, so packets can be
+ * dissected on several threads at once without sharing an allocator.
  * N.B. Please use pinfo->pool in new code when possible. See
  * <https://www.wireshark.org/lists/wireshark-dev/202107/msg00052.html>
  */
@@ -50,6 +52,10 @@ wmem_leave_packet_scope(void);
  * @brief Fetch the current file scope.
  *
  * Allocated memory is freed when wmem_leave_file_scope() is called, which is normally when a capture file is closed.
+ * The file scope, like the epan scope, is shared by all threads and is not thread-safe: it, and the wmem
+ * structures allocated in it, may only be used by one thread at a time. Code that dissects on several
+ * threads must keep file-scoped state on one of them, e.g. the one doing the sequential first pass, and
+ * allocate everything else from pinfo->pool.
  */
 WS_DLL_PUBLIC
 wmem_allocator_t *
@@ -65,6 +71,8 @@ wmem_leave_file_scope(void);
 
 /* Scope Management */
 
+/* Call wmem_init_scopes() and wmem_cleanup_scopes() from the same thread,
+ * and don't call wmem_cleanup_scopes() while other threads are dissecting. */
 WS_DLL_PUBLIC
 void
 wmem_init_scopes(void);
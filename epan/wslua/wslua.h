@@ -245,6 +245,14 @@ struct _wslua_tap {
     int draw_ref;
     int reset_ref;
     gboolean all_fields;
+    /* batch mode; see Listener:set_batch() */
+    int batch_ref;
+    int batch_fields_ref;           /* the table of Fields, to keep them alive */
+    int batch_values_ref;           /* the arrays of values being collected */
+    struct _wslua_header_field_info** batch_fields;
+    guint batch_nfields;
+    guint batch_size;
+    guint batch_count;
 };
 
 /* a "File" object can be different things under the hood. It can either
@@ -789,7 +797,9 @@ extern TreeItem push_TreeItem(lua_State *L, proto_tree *tree, proto_item *item);
 extern void clear_outstanding_TreeItem(void);
 
 extern FieldInfo* push_FieldInfo(lua_State *L, field_info* f);
+extern int push_FieldInfo_value(lua_State *L, field_info* f);
 extern void clear_outstanding_FieldInfo(void);
+extern void clear_FieldInfo_cache(void);
 
 extern void wslua_print_stack(char* s, lua_State* L);
 
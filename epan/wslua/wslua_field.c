@@ -33,15 +33,80 @@ WSLUA_CLASS_DEFINE(FieldInfo,FAIL_ON_NULL_OR_EXPIRED("FieldInfo"));
 
 static GPtrArray* outstanding_FieldInfo = NULL;
 
+/* Freed FieldInfos, kept for reuse; Field extractors make one for every
+ * value they return, for every packet. */
+static GPtrArray* free_FieldInfos = NULL;
+#define MAX_FREE_FIELDINFOS 1024
+
+/* The FieldInfos pushed for the current packet, in a table in the
+ * registry indexed by their field_info, so that calling an extractor
+ * again for the same packet, as dissectors and taps often do, returns
+ * the same FieldInfos rather than making new ones.  The table is
+ * replaced when the generation changes. */
+static int fieldinfo_cache_ref = LUA_NOREF;
+static guint fieldinfo_cache_generation = 0;
+static guint fieldinfo_generation = 1;
+
+static void free_FieldInfo(FieldInfo fi) {
+    if (free_FieldInfos->len < MAX_FREE_FIELDINFOS)
+        g_ptr_array_add(free_FieldInfos,fi);
+    else
+        g_free(fi);
+}
+
 FieldInfo* push_FieldInfo(lua_State* L, field_info* f) {
-    FieldInfo fi = (FieldInfo) g_malloc(sizeof(struct _wslua_field_info));
+    FieldInfo fi;
+    FieldInfo* p;
+
+    if (fieldinfo_cache_generation != fieldinfo_generation) {
+        luaL_unref(L, LUA_REGISTRYINDEX, fieldinfo_cache_ref);
+        lua_newtable(L);
+        fieldinfo_cache_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        fieldinfo_cache_generation = fieldinfo_generation;
+    }
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, fieldinfo_cache_ref);
+    lua_pushlightuserdata(L, f);
+    lua_rawget(L, -2);
+    if (!lua_isnil(L, -1)) {
+        lua_remove(L, -2);
+        return (FieldInfo*)lua_touserdata(L, -1);
+    }
+    lua_pop(L, 1);
+
+    if (free_FieldInfos->len)
+        fi = (FieldInfo)g_ptr_array_remove_index_fast(free_FieldInfos, free_FieldInfos->len - 1);
+    else
+        fi = (FieldInfo)g_malloc(sizeof(struct _wslua_field_info));
     fi->ws_fi = f;
     fi->expired = FALSE;
     g_ptr_array_add(outstanding_FieldInfo,fi);
-    return pushFieldInfo(L,fi);
+    p = pushFieldInfo(L,fi);
+
+    /* cache[f] = the new FieldInfo, leaving only it on the stack */
+    lua_pushlightuserdata(L, f);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, -4);
+    lua_remove(L, -2);
+    return p;
 }
 
-CLEAR_OUTSTANDING(FieldInfo,expired,TRUE)
+void clear_FieldInfo_cache(void) {
+    fieldinfo_generation++;
+}
+
+void clear_outstanding_FieldInfo(void) {
+    clear_FieldInfo_cache();
+    while (outstanding_FieldInfo->len) {
+        FieldInfo fi = (FieldInfo)g_ptr_array_remove_index_fast(outstanding_FieldInfo,0);
+        if (fi) {
+            if (!fi->expired)
+                fi->expired = TRUE;
+            else
+                free_FieldInfo(fi);
+        }
+    }
+}
 
 /* WSLUA_ATTRIBUTE FieldInfo_len RO The length of this field. */
 WSLUA_METAMETHOD FieldInfo__len(lua_State* L) {
@@ -65,25 +130,12 @@ WSLUA_METAMETHOD FieldInfo__unm(lua_State* L) {
     return 1;
 }
 
-/* WSLUA_ATTRIBUTE FieldInfo_value RO The value of this field. */
-WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
-    /*
-       Obtain the Value of the field.
-
-       Previous to 1.11.4, this function retrieved the value for most field types,
-       but for `ftypes.UINT_BYTES` it retrieved the `ByteArray` of the field's entire `TvbRange`.
-       In other words, it returned a `ByteArray` that included the leading length byte(s),
-       instead of just the *value* bytes. That was a bug, and has been changed in 1.11.4.
-       Furthermore, it retrieved an `ftypes.GUID` as a `ByteArray`, which is also incorrect.
-
-       If you wish to still get a `ByteArray` of the `TvbRange`, use `fieldinfo.range`
-       to get the `TvbRange`, and then use `tvbrange:bytes()` to convert it to a `ByteArray`.
-       */
-    FieldInfo fi = checkFieldInfo(L,1);
-
-    switch(fi->ws_fi->hfinfo->type) {
+/* Pushes the value of a field_info the way FieldInfo.value gets it;
+ * returns the number of values pushed. */
+int push_FieldInfo_value(lua_State* L, field_info* f) {
+    switch(f->hfinfo->type) {
         case FT_BOOLEAN:
-                lua_pushboolean(L,(int)fvalue_get_uinteger64(&(fi->ws_fi->value)));
+                lua_pushboolean(L,(int)fvalue_get_uinteger64(&(f->value)));
                 return 1;
         case FT_CHAR:
         case FT_UINT8:
@@ -91,67 +143,67 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
         case FT_UINT24:
         case FT_UINT32:
         case FT_FRAMENUM:
-                lua_pushnumber(L,(lua_Number)(fvalue_get_uinteger(&(fi->ws_fi->value))));
+                lua_pushnumber(L,(lua_Number)(fvalue_get_uinteger(&(f->value))));
                 return 1;
         case FT_INT8:
         case FT_INT16:
         case FT_INT24:
         case FT_INT32:
-                lua_pushnumber(L,(lua_Number)(fvalue_get_sinteger(&(fi->ws_fi->value))));
+                lua_pushnumber(L,(lua_Number)(fvalue_get_sinteger(&(f->value))));
                 return 1;
         case FT_FLOAT:
         case FT_DOUBLE:
-                lua_pushnumber(L,(lua_Number)(fvalue_get_floating(&(fi->ws_fi->value))));
+                lua_pushnumber(L,(lua_Number)(fvalue_get_floating(&(f->value))));
                 return 1;
         case FT_INT64: {
-                pushInt64(L,(Int64)(fvalue_get_sinteger64(&(fi->ws_fi->value))));
+                pushInt64(L,(Int64)(fvalue_get_sinteger64(&(f->value))));
                 return 1;
             }
         case FT_UINT64: {
-                pushUInt64(L,fvalue_get_uinteger64(&(fi->ws_fi->value)));
+                pushUInt64(L,fvalue_get_uinteger64(&(f->value)));
                 return 1;
             }
         case FT_ETHER: {
                 Address eth = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,eth,AT_ETHER,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,eth,AT_ETHER,f->length,f->ds_tvb,f->start);
                 pushAddress(L,eth);
                 return 1;
             }
         case FT_IPv4:{
                 Address ipv4 = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,ipv4,AT_IPv4,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,ipv4,AT_IPv4,f->length,f->ds_tvb,f->start);
                 pushAddress(L,ipv4);
                 return 1;
             }
         case FT_IPv6: {
                 Address ipv6 = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,ipv6,AT_IPv6,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,ipv6,AT_IPv6,f->length,f->ds_tvb,f->start);
                 pushAddress(L,ipv6);
                 return 1;
             }
         case FT_FCWWN: {
                 Address fcwwn = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,fcwwn,AT_FCWWN,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,fcwwn,AT_FCWWN,f->length,f->ds_tvb,f->start);
                 pushAddress(L,fcwwn);
                 return 1;
             }
         case FT_IPXNET:{
                 Address ipx = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,ipx,AT_IPX,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,ipx,AT_IPX,f->length,f->ds_tvb,f->start);
                 pushAddress(L,ipx);
                 return 1;
             }
         case FT_ABSOLUTE_TIME:
         case FT_RELATIVE_TIME: {
                 NSTime nstime = (NSTime)g_malloc(sizeof(nstime_t));
-                *nstime = *fvalue_get_time(&(fi->ws_fi->value));
+                *nstime = *fvalue_get_time(&(f->value));
                 pushNSTime(L,nstime);
                 return 1;
             }
         case FT_STRING:
         case FT_STRINGZ:
         case FT_STRINGZPAD: {
-                gchar* repr = fvalue_to_string_repr(NULL, &fi->ws_fi->value,FTREPR_DISPLAY,BASE_NONE);
+                gchar* repr = fvalue_to_string_repr(NULL, &f->value,FTREPR_DISPLAY,BASE_NONE);
                 if (repr)
                 {
                     lua_pushstring(L, repr);
@@ -164,10 +216,10 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
                 return 1;
             }
         case FT_NONE:
-                if (fi->ws_fi->length > 0 && fi->ws_fi->rep) {
+                if (f->length > 0 && f->rep) {
                     /* it has a length, but calling fvalue_get() on an FT_NONE asserts,
                        so get the label instead (it's a FT_NONE, so a label is what it basically is) */
-                    lua_pushstring(L, fi->ws_fi->rep->representation);
+                    lua_pushstring(L, f->rep->representation);
                     return 1;
                 }
                 return 0;
@@ -178,15 +230,15 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
         case FT_OID:
             {
                 ByteArray ba = g_byte_array_new();
-                g_byte_array_append(ba, fvalue_get_bytes(&fi->ws_fi->value),
-                                    fvalue_length(&fi->ws_fi->value));
+                g_byte_array_append(ba, fvalue_get_bytes(&f->value),
+                                    fvalue_length(&f->value));
                 pushByteArray(L,ba);
                 return 1;
             }
         case FT_PROTOCOL:
             {
                 ByteArray ba = g_byte_array_new();
-                tvbuff_t* tvb = fvalue_get_protocol(&fi->ws_fi->value);
+                tvbuff_t* tvb = fvalue_get_protocol(&f->value);
                 guint8* raw;
                 if (tvb != NULL) {
                     raw = (guint8 *)tvb_memdup(NULL, tvb, 0, tvb_captured_length(tvb));
@@ -205,6 +257,25 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
     }
 }
 
+/* WSLUA_ATTRIBUTE FieldInfo_value RO The value of this field. */
+WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
+    /*
+       Obtain the Value of the field.
+
+       Previous to 1.11.4, this function retrieved the value for most field types,
+       but for `ftypes.UINT_BYTES` it retrieved the `ByteArray` of the field's entire `TvbRange`.
+       In other words, it returned a `ByteArray` that included the leading length byte(s),
+       instead of just the *value* bytes. That was a bug, and has been changed in 1.11.4.
+       Furthermore, it retrieved an `ftypes.GUID` as a `ByteArray`, which is also incorrect.
+
+       If you wish to still get a `ByteArray` of the `TvbRange`, use `fieldinfo.range`
+       to get the `TvbRange`, and then use `tvbrange:bytes()` to convert it to a `ByteArray`.
+       */
+    FieldInfo fi = checkFieldInfo(L,1);
+
+    return push_FieldInfo_value(L, fi->ws_fi);
+}
+
 /* WSLUA_ATTRIBUTE FieldInfo_label RO The string representing this field. */
 WSLUA_METAMETHOD FieldInfo__tostring(lua_State* L) {
     /* The string representation of the field. */
@@ -436,7 +507,7 @@ static int FieldInfo__gc(lua_State* L) {
         fi->expired = TRUE;
     else
         /* do NOT free fi->ws_fi */
-        g_free(fi);
+        free_FieldInfo(fi);
 
     return 0;
 }
@@ -800,6 +871,11 @@ int Field_register(lua_State* L) {
 
     WSLUA_REGISTER_CLASS_WITH_ATTRS(Field);
     outstanding_FieldInfo = g_ptr_array_new();
+    if (!free_FieldInfos)
+        free_FieldInfos = g_ptr_array_new_with_free_func(g_free);
+    /* The cache belonged to the previous Lua state, if any. */
+    fieldinfo_cache_ref = LUA_NOREF;
+    fieldinfo_cache_generation = 0;
 
     return 0;
 }
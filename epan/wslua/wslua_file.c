@@ -196,12 +196,13 @@ static int File_read_line(lua_State *L, FILE_T ft) {
 }
 
 /* This internal function reads X number of bytes from the file, same as `io.read(num)` in Lua.
- * Since we have to use file_wrappers.c, and an intermediate buffer, we read it in chunks
- * of 1024 bytes at a time. (or less if called with a smaller number)  To do that, we use
- * Lua's buffer manager to push it into Lua as those chunks, while ending up with one long
- * Lua string in the end.
+ * Since we have to use file_wrappers.c, we read it in chunks of LUAL_BUFFERSIZE bytes at a
+ * time (or less if called with a smaller number) straight into Lua's buffer manager, like
+ * Lua's own io library does, ending up with one long Lua string in the end.
  */
-#define WSLUA_BUFFERSIZE 1024
+
+/* default size of the blocks File:read_into() reads */
+#define WSLUA_BLOCKSIZE 65536
 
 /* Lua 5.1 used lua_objlen() instead of lua_rawlen() */
 #if LUA_VERSION_NUM == 501
@@ -216,18 +217,19 @@ static int File_read_chars(lua_State *L, FILE_T ft, size_t n) {
     size_t rlen;  /* how much to read */
     size_t nr;  /* number of chars actually read */
     int    nri; /* temp number of chars read, as an int to handle -1 errors */
-    gchar buff[WSLUA_BUFFERSIZE];  /* for file_read to write to, and we push into Lua */
+    char  *buff;  /* for file_read to write to, inside the Lua buffer */
     luaL_Buffer b;
 
-    rlen = WSLUA_BUFFERSIZE;  /* try to read that much each time */
+    rlen = LUAL_BUFFERSIZE;  /* try to read that much each time */
     luaL_buffinit(L, &b); /* initialize Lua buffer */
 
     do {
+        buff = luaL_prepbuffer(&b);
         if (rlen > n) rlen = n;  /* cannot read more than asked */
         nri = file_read(buff, (unsigned int)rlen, ft);
         if (nri < 1) break;
         nr = (size_t) nri;
-        luaL_addlstring(&b, buff, nr);
+        luaL_addsize(&b, nr);
         n -= nr;  /* still have to read `n' chars */
     } while (n > 0 && nr == rlen);  /* until end of count or eof */
 
@@ -332,6 +334,71 @@ WSLUA_METHOD File_read(lua_State* L) {
     return n - 1;
 }
 
+WSLUA_METHOD File_read_into(lua_State* L) {
+    /* Reads a block from the File into a <<lua_class_ByteArray,`ByteArray`>>, replacing its contents.
+
+       Calling `read()` or `lines()` for every field or line of a large file makes a new Lua string
+       each time. Readers of big text or log formats can instead read large blocks into the same
+       `ByteArray` over and over, and split them up in Lua, for example with `ByteArray:raw()` and
+       `string.find()`. Remember that a block usually ends in the middle of a line or record.
+
+       ===== Example
+
+       [source,lua]
+       ----
+       local block = ByteArray.new()
+       while file:read_into(block) do
+           local data = block:raw()
+           -- parse data
+       end
+       ----
+
+       @since 4.1.0
+     */
+#define WSLUA_ARG_File_read_into_BYTEARRAY 2 /* The <<lua_class_ByteArray,`ByteArray`>> to read into. */
+#define WSLUA_OPTARG_File_read_into_LENGTH 3 /* The most bytes to read (default=65536). */
+    File f = checkFile(L,1);
+    ByteArray ba = checkByteArray(L,WSLUA_ARG_File_read_into_BYTEARRAY);
+    lua_Integer len = luaL_optinteger(L,WSLUA_OPTARG_File_read_into_LENGTH,WSLUA_BLOCKSIZE);
+    int nread;
+    int err = 0;
+    gchar *err_info = NULL;
+
+    if (!f->file) {
+        return luaL_error(L, "Error getting File handle for read_into");
+    }
+
+    if (!file_is_reader(f)) {
+        ws_warning("Error in File read: this File object instance is for writing only");
+        return 0;
+    }
+
+    if (len <= 0 || len > G_MAXINT) {
+        WSLUA_OPTARG_ERROR(File_read_into,LENGTH,"must be a positive number");
+        return 0;
+    }
+
+    g_byte_array_set_size(ba, (guint)len);
+    nread = file_read(ba->data, (unsigned int)len, f->file);
+    g_byte_array_set_size(ba, nread > 0 ? (guint)nread : 0);
+
+    if (nread < 0) {
+        err = file_error(f->file, &err_info);
+        lua_pushnil(L);
+        lua_pushstring(L, err_info ? err_info : wtap_strerror(err));
+        g_free(err_info);
+        return 2;
+    }
+
+    if (nread == 0) {
+        lua_pushnil(L);  /* EOF */
+        return 1;
+    }
+
+    lua_pushinteger(L, nread);
+    WSLUA_RETURN(1); /* The number of bytes read, or nil at the end of the file. */
+}
+
 WSLUA_METHOD File_seek(lua_State* L) {
     /* Seeks in the File, similar to Lua's `file:seek()`.  See Lua 5.x ref manual for `file:seek()`. */
     static const int mode[] = { SEEK_SET, SEEK_CUR, SEEK_END };
@@ -491,6 +558,7 @@ WSLUA_ATTRIBUTES File_attributes[] = {
 WSLUA_METHODS File_methods[] = {
     WSLUA_CLASS_FNREG(File,lines),
     WSLUA_CLASS_FNREG(File,read),
+    WSLUA_CLASS_FNREG(File,read_into),
     WSLUA_CLASS_FNREG(File,seek),
     WSLUA_CLASS_FNREG(File,write),
     { NULL, NULL }
@@ -67,12 +67,107 @@ static int tap_packet_cb_error_handler(lua_State* L) {
 }
 
 
+static int tap_batch_cb_error_handler(lua_State* L) {
+    const gchar* error = lua_tostring(L,1);
+    report_failure("Lua: Error during execution of Listener batch callback:\n %s",error);
+    return 0;
+}
+
+/* Starts a new set of arrays for the batch values. */
+static void new_batch_values(Listener tap) {
+    guint i;
+
+    luaL_unref(tap->L, LUA_REGISTRYINDEX, tap->batch_values_ref);
+    lua_createtable(tap->L, tap->batch_nfields, 0);
+    for (i = 0; i < tap->batch_nfields; i++) {
+        lua_createtable(tap->L, tap->batch_size, 0);
+        lua_rawseti(tap->L, -2, i + 1);
+    }
+    tap->batch_values_ref = luaL_ref(tap->L, LUA_REGISTRYINDEX);
+    tap->batch_count = 0;
+}
+
+/* Adds the first value of each of the batch fields in the tree to the
+ * batch; called with lua_pcall(), as converting a value can fail. */
+static int tap_batch_collect(lua_State* L) {
+    Listener tap = (Listener)lua_touserdata(L,1);
+    proto_tree* tree = (proto_tree*)lua_touserdata(L,2);
+    guint i;
+
+    tap->batch_count++;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, tap->batch_values_ref);
+    for (i = 0; i < tap->batch_nfields; i++) {
+        header_field_info* hfi = tap->batch_fields[i]->hfi;
+        field_info* fi = NULL;
+
+        /* The same field Field() would return first. */
+        while (hfi && !fi) {
+            GPtrArray* found = proto_get_finfo_ptr_array(tree, hfi->id);
+            if (found && found->len)
+                fi = (field_info*)g_ptr_array_index(found, 0);
+            else
+                hfi = (hfi->same_name_prev_id != -1) ? proto_registrar_get_nth(hfi->same_name_prev_id) : NULL;
+        }
+
+        lua_rawgeti(L, -1, i + 1);
+        if (fi && push_FieldInfo_value(L, fi) == 1)
+            lua_rawseti(L, -2, tap->batch_count);
+        lua_pop(L, 1);
+    }
+    return 0;
+}
+
+/* Hands the values collected so far to the batch function. */
+static void lua_tap_batch_flush(Listener tap) {
+    if (tap->batch_ref == LUA_NOREF || tap->batch_count == 0) return;
+
+    lua_settop(tap->L,0);
+    lua_pushcfunction(tap->L,tap_batch_cb_error_handler);
+    lua_rawgeti(tap->L, LUA_REGISTRYINDEX, tap->batch_ref);
+    lua_pushinteger(tap->L, tap->batch_count);
+    lua_rawgeti(tap->L, LUA_REGISTRYINDEX, tap->batch_values_ref);
+    new_batch_values(tap);
+
+    switch ( lua_pcall(tap->L,2,0,1) ) {
+        case 0:
+            break;
+        case LUA_ERRRUN:
+            break;
+        case LUA_ERRMEM:
+            ws_warning("Memory alloc error while calling listener tap callback batch");
+            break;
+        case LUA_ERRERR:
+            ws_warning("Error while running the error handler function for listener tap callback batch");
+            break;
+        default:
+            ws_assert_not_reached();
+            break;
+    }
+    lua_settop(tap->L,0);
+}
+
 static tap_packet_status lua_tap_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data, tap_flags_t flags _U_) {
     Listener tap = (Listener)tapdata;
     tap_packet_status retval = TAP_PACKET_DONT_REDRAW;
     TreeItem lua_tree_tap;
 
-    if (tap->packet_ref == LUA_NOREF) return TAP_PACKET_DONT_REDRAW; /* XXX - report error and return TAP_PACKET_FAILED? */
+    if (tap->batch_ref != LUA_NOREF && tap->batch_nfields) {
+        lua_settop(tap->L,0);
+        lua_pushcfunction(tap->L,tap_batch_cb_error_handler);
+        lua_pushcfunction(tap->L,tap_batch_collect);
+        lua_pushlightuserdata(tap->L,tap);
+        lua_pushlightuserdata(tap->L,edt->tree);
+        if (lua_pcall(tap->L,2,0,1) != 0)
+            ws_warning("Error while collecting the values for a listener batch");
+        lua_settop(tap->L,0);
+
+        if (tap->batch_count >= tap->batch_size) {
+            lua_tap_batch_flush(tap);
+            retval = TAP_PACKET_REDRAW;
+        }
+    }
+
+    if (tap->packet_ref == LUA_NOREF) return retval; /* XXX - report error and return TAP_PACKET_FAILED? */
 
     lua_settop(tap->L,0);
     lua_pushcfunction(tap->L,tap_packet_cb_error_handler);
@@ -114,6 +209,8 @@ static tap_packet_status lua_tap_packet(void *tapdata, packet_info *pinfo, epan_
 
     clear_outstanding_Pinfo();
     clear_outstanding_Tvb();
+    /* The next packet's field_infos might be where this one's were. */
+    clear_FieldInfo_cache();
 
     lua_pinfo = NULL;
     lua_tvb = NULL;
@@ -132,6 +229,10 @@ static int tap_reset_cb_error_handler(lua_State* L) {
 static void lua_tap_reset(void *tapdata) {
     Listener tap = (Listener)tapdata;
 
+    /* Values collected before a reset belong to the previous run. */
+    if (tap->batch_count)
+        new_batch_values(tap);
+
     if (tap->reset_ref == LUA_NOREF) return;
 
     lua_pushcfunction(tap->L,tap_reset_cb_error_handler);
@@ -165,6 +266,9 @@ static void lua_tap_draw(void *tapdata) {
     Listener tap = (Listener)tapdata;
     const gchar* error;
 
+    /* Deliver any partial batch, so that draw() sees every packet. */
+    lua_tap_batch_flush(tap);
+
     if (tap->draw_ref == LUA_NOREF) return;
 
     lua_pushcfunction(tap->L,tap_draw_cb_error_handler);
@@ -201,6 +305,7 @@ static void deregister_Listener (lua_State* L _U_, Listener tap) {
 
     remove_tap_listener(tap);
 
+    g_free(tap->batch_fields);
     g_free(tap->filter);
     g_free(tap->name);
     g_free(tap);
@@ -236,6 +341,13 @@ WSLUA_CONSTRUCTOR Listener_new(lua_State* L) {
     tap->draw_ref = LUA_NOREF;
     tap->reset_ref = LUA_NOREF;
     tap->all_fields = all_fields;
+    tap->batch_ref = LUA_NOREF;
+    tap->batch_fields_ref = LUA_NOREF;
+    tap->batch_values_ref = LUA_NOREF;
+    tap->batch_fields = NULL;
+    tap->batch_nfields = 0;
+    tap->batch_size = 0;
+    tap->batch_count = 0;
 
     /*
      * XXX - do all Lua taps require the protocol tree?  If not, it might
@@ -320,6 +432,85 @@ WSLUA_METHOD Listener_remove(lua_State* L) {
     return 0;
 }
 
+WSLUA_METHOD Listener_set_batch(lua_State* L) {
+    /*
+    Makes the `Listener` collect the values of some fields for a number of
+    packets, and pass them all at once to its `batch` function, rather than
+    having its `packet` function called, with a new `Pinfo` and `Tvb`, for
+    every packet.
+
+    For each packet, the value collected for a field is the value of the
+    first `FieldInfo` its extractor would return, as given by `FieldInfo.value`,
+    or nil if the packet doesn't have the field.
+
+    @since 4.1.0
+
+    ===== Example
+
+    [source,lua]
+    ----
+    local f_len = Field.new("frame.len")
+    local f_src = Field.new("ip.src")
+    local tap = Listener.new("frame", "ip")
+    local bytes = {}
+
+    tap:set_batch({ f_len, f_src }, 1000)
+
+    function tap.batch(count, values)
+        local lens, srcs = values[1], values[2]
+        for i = 1, count do
+            local src = tostring(srcs[i])
+            bytes[src] = (bytes[src] or 0) + lens[i]
+        end
+    end
+    ----
+    */
+#define WSLUA_ARG_Listener_set_batch_FIELDS 2 /* An array of <<lua_class_Field,`Field`>> extractors. */
+#define WSLUA_OPTARG_Listener_set_batch_SIZE 3 /* The most packets to collect before calling `batch`; the default is 256. */
+    Listener tap = checkListener(L,1);
+    lua_Integer size = luaL_optinteger(L,WSLUA_OPTARG_Listener_set_batch_SIZE,256);
+    guint nfields = 0;
+    guint i;
+
+    luaL_checktype(L,WSLUA_ARG_Listener_set_batch_FIELDS,LUA_TTABLE);
+    if (size < 1) {
+        WSLUA_OPTARG_ERROR(Listener_set_batch,SIZE,"must be at least 1");
+        return 0;
+    }
+
+    for (;;) {
+        lua_rawgeti(L,WSLUA_ARG_Listener_set_batch_FIELDS,nfields + 1);
+        if (lua_isnil(L,-1)) {
+            lua_pop(L,1);
+            break;
+        }
+        if (!isField(L,-1)) {
+            WSLUA_ARG_ERROR(Listener_set_batch,FIELDS,"must be an array of Field extractors");
+            return 0;
+        }
+        lua_pop(L,1);
+        nfields++;
+    }
+
+    g_free(tap->batch_fields);
+    tap->batch_fields = g_new(Field, nfields);
+    for (i = 0; i < nfields; i++) {
+        lua_rawgeti(L,WSLUA_ARG_Listener_set_batch_FIELDS,i + 1);
+        tap->batch_fields[i] = toField(L,-1);
+        lua_pop(L,1);
+    }
+
+    luaL_unref(L, LUA_REGISTRYINDEX, tap->batch_fields_ref);
+    lua_pushvalue(L,WSLUA_ARG_Listener_set_batch_FIELDS);
+    tap->batch_fields_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    tap->batch_nfields = nfields;
+    tap->batch_size = (guint)size;
+    new_batch_values(tap);
+
+    return 0;
+}
+
 WSLUA_METAMETHOD Listener__tostring(lua_State* L) {
     /* Generates a string of debug info for the tap `Listener`. */
     Listener tap = checkListener(L,1);
@@ -376,6 +567,24 @@ WSLUA_ATTRIBUTE_FUNC_SETTER(Listener,draw);
 */
 WSLUA_ATTRIBUTE_FUNC_SETTER(Listener,reset);
 
+/* WSLUA_ATTRIBUTE Listener_batch WO A function that will be called with the field values collected
+    by a `Listener` set up with `Listener:set_batch()`, once
+    it has collected them for the given number of packets, and before `draw` is called.
+
+    When later called by Wireshark, the `batch` function will be given:
+      1. The number of packets in the batch
+      2. An array with, for each field given to `Listener:set_batch()`, an array of its
+         value in each packet
+
+    [source,lua]
+    ----
+    function tap.batch(count,values) ... end
+    ----
+
+    @since 4.1.0
+*/
+WSLUA_ATTRIBUTE_FUNC_SETTER(Listener,batch);
+
 
 static int Listener__gc(lua_State* L _U_) {
     /* do NOT free Listener here, only in deregister_Listener */
@@ -390,6 +599,7 @@ WSLUA_ATTRIBUTES Listener_attributes[] = {
     WSLUA_ATTRIBUTE_WOREG(Listener,packet),
     WSLUA_ATTRIBUTE_WOREG(Listener,draw),
     WSLUA_ATTRIBUTE_WOREG(Listener,reset),
+    WSLUA_ATTRIBUTE_WOREG(Listener,batch),
     { NULL, NULL, NULL }
 };
 
@@ -397,6 +607,7 @@ WSLUA_METHODS Listener_methods[] = {
     WSLUA_CLASS_FNREG(Listener,new),
     WSLUA_CLASS_FNREG(Listener,remove),
     WSLUA_CLASS_FNREG(Listener,list),
+    WSLUA_CLASS_FNREG(Listener,set_batch),
     { NULL, NULL }
 };
 
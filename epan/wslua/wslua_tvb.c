@@ -341,13 +341,26 @@ WSLUA_CLASS_DEFINE(TvbRange,FAIL_ON_NULL("TvbRange"));
     If the <<lua_class_TvbRange,`TvbRange`>> span is outside the <<lua_class_Tvb,`Tvb`>>'s range the creation will cause a runtime error.
     */
 
+/* A TvbRange made by push_TvbRange() is allocated together with its Tvb,
+ * and, once both the garbage collector and the end of the packet are done
+ * with it, kept for reuse, as dissectors make one for nearly every item
+ * they add. */
+typedef struct {
+    struct _wslua_tvbrange tvbr;
+    struct _wslua_tvb tvb;
+} wslua_tvbrange_block_t;
+
+static GPtrArray* free_TvbRanges = NULL;
+#define MAX_FREE_TVBRANGES 1024
+
 static void free_TvbRange(TvbRange tvbr) {
     if (!(tvbr && tvbr->tvb)) return;
 
     if (!tvbr->tvb->expired) {
         tvbr->tvb->expired = TRUE;
+    } else if (free_TvbRanges->len < MAX_FREE_TVBRANGES) {
+        g_ptr_array_add(free_TvbRanges, tvbr);
     } else {
-        free_Tvb(tvbr->tvb);
         g_free(tvbr);
     }
 }
@@ -361,6 +374,7 @@ void clear_outstanding_TvbRange(void) {
 
 
 gboolean push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
+    wslua_tvbrange_block_t* block;
     TvbRange tvbr;
 
     if (!ws_tvb) {
@@ -379,8 +393,13 @@ gboolean push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
         return FALSE;
     }
 
-    tvbr = (TvbRange)g_malloc(sizeof(struct _wslua_tvbrange));
-    tvbr->tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    if (free_TvbRanges->len) {
+        block = (wslua_tvbrange_block_t*)g_ptr_array_remove_index_fast(free_TvbRanges, free_TvbRanges->len - 1);
+    } else {
+        block = g_new(wslua_tvbrange_block_t, 1);
+    }
+    tvbr = &block->tvbr;
+    tvbr->tvb = &block->tvb;
     tvbr->tvb->ws_tvb = ws_tvb;
     tvbr->tvb->expired = FALSE;
     tvbr->tvb->need_free = FALSE;
@@ -1486,6 +1505,8 @@ WSLUA_META TvbRange_meta[] = {
 
 int TvbRange_register(lua_State* L) {
     outstanding_TvbRange = g_ptr_array_new();
+    if (!free_TvbRanges)
+        free_TvbRanges = g_ptr_array_new_with_free_func(g_free);
     WSLUA_REGISTER_CLASS(TvbRange);
     return 0;
 }
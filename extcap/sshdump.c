@@ -40,7 +40,9 @@ static gchar* sshdump_extcap_interface;
 #define SSHDUMP_VERSION_MINOR "1"
 #define SSHDUMP_VERSION_RELEASE "0"
 
-#define SSH_READ_BLOCK_SIZE 256
+/* libssh returns as soon as some data is available, so a large block only
+ * means fewer reads and fifo writes when the capture is busy. */
+#define SSH_READ_BLOCK_SIZE (64 * 1024)
 
 enum {
 	EXTCAP_BASE_OPTIONS_ENUM,
@@ -80,7 +82,7 @@ static int ssh_loop_read(ssh_channel channel, FILE* fp)
 {
 	int nbytes;
 	int ret = EXIT_SUCCESS;
-	char buffer[SSH_READ_BLOCK_SIZE];
+	char* buffer = (char*)g_malloc(SSH_READ_BLOCK_SIZE);
 
 	/* read from stdin until data are available */
 	while (ssh_channel_is_open(channel) && !ssh_channel_is_eof(channel)) {
@@ -114,6 +116,7 @@ static int ssh_loop_read(ssh_channel channel, FILE* fp)
 	}
 
 end:
+	g_free(buffer);
 	if (ssh_channel_send_eof(channel) != SSH_OK) {
 		ws_warning("Error sending EOF in ssh channel");
 		ret = EXIT_FAILURE;
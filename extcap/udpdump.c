@@ -11,6 +11,7 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#define _GNU_SOURCE /* For recvmmsg(). */
 #include "config.h"
 #define WS_LOG_DOMAIN "udpdump"
 
@@ -60,6 +61,12 @@
 
 #define PKT_BUF_SIZE 65535
 
+/* Datagrams read by each recvmmsg() call */
+#define UDPDUMP_RECV_BATCH 64
+
+/* Size of the stdio buffer of the fifo, so that writes are batched */
+#define UDPDUMP_WRITE_BUF_SIZE (1024 * 1024)
+
 #define UDPDUMP_EXPORT_HEADER_LEN 40
 
 enum {
@@ -164,6 +171,9 @@ static int setup_dumpfile(const char* fifo, FILE** fp)
 		return EXIT_FAILURE;
 	}
 
+	/* Packets are flushed after each batch of received datagrams */
+	setvbuf(*fp, NULL, _IOFBF, UDPDUMP_WRITE_BUF_SIZE);
+
 	if (!libpcap_write_file_header(*fp, 252, PCAP_SNAPLEN, FALSE, &bytes_written, &err)) {
 		ws_warning("Can't write pcap file header: %s", g_strerror(err));
 		return EXIT_FAILURE;
@@ -236,19 +246,17 @@ static void add_end_options(guint8* mbuf, guint* offset)
 	*offset += 4;
 }
 
+/* mbuf must have room for the export header and PKT_BUF_SIZE bytes. It's reused
+ * for each packet; the padding of the header is left as zeroes. */
 static int dump_packet(const char* proto_name, const guint16 listenport, const char* buf,
-		const ssize_t buflen, const struct sockaddr_in clientaddr, FILE* fp)
+		const ssize_t buflen, const struct sockaddr_in clientaddr, guint8* mbuf, FILE* fp)
 {
-	guint8* mbuf;
 	guint offset = 0;
 	gint64 curtime = g_get_real_time();
 	guint64 bytes_written = 0;
 	int err;
 	int ret = EXIT_SUCCESS;
 
-	/* The space we need is the standard header + variable lengths */
-	mbuf = (guint8*)g_malloc0(UDPDUMP_EXPORT_HEADER_LEN + ((strlen(proto_name) + 3) & 0xfffffffc) + buflen);
-
 	add_proto_name(mbuf, &offset, proto_name);
 	add_ip_source_address(mbuf, &offset, clientaddr.sin_addr.s_addr);
 	add_ip_dest_address(mbuf, &offset, WS_IN4_LOOPBACK);
@@ -266,20 +274,52 @@ static int dump_packet(const char* proto_name, const guint16 listenport, const c
 		ret = EXIT_FAILURE;
 	}
 
-	fflush(fp);
-
-	g_free(mbuf);
 	return ret;
 }
 
+static void handle_recv_error(const char* function)
+{
+	switch(errno) {
+		case EAGAIN:
+		case EINTR:
+			break;
+		default:
+#ifdef _WIN32
+			{
+				wchar_t *errmsg = NULL;
+				int err = WSAGetLastError();
+				FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+					NULL, err,
+					MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
+					(LPWSTR)&errmsg, 0, NULL);
+				ws_warning("Error in %s: %S (err=%d)", function, errmsg, err);
+				LocalFree(errmsg);
+			}
+#else
+			ws_warning("Error in %s: %s (errno=%d)", function, strerror(errno), errno);
+#endif
+			extcap_end_application = TRUE;
+			break;
+	}
+}
+
 static void run_listener(const char* fifo, const guint16 port, const char* proto_name)
 {
-	struct sockaddr_in clientaddr;
-	socklen_t clientlen = sizeof(clientaddr);
 	socket_handle_t sock;
 	char* buf;
-	ssize_t buflen;
+	guint8* mbuf;
 	FILE* fp = NULL;
+#ifdef HAVE_RECVMMSG
+	struct mmsghdr msgs[UDPDUMP_RECV_BATCH];
+	struct iovec iovecs[UDPDUMP_RECV_BATCH];
+	struct sockaddr_in clientaddrs[UDPDUMP_RECV_BATCH];
+	int nmsgs;
+	int i;
+#else
+	struct sockaddr_in clientaddr;
+	socklen_t clientlen = sizeof(clientaddr);
+	ssize_t buflen;
+#endif
 
 	if (setup_dumpfile(fifo, &fp) == EXIT_FAILURE) {
 		if (fp)
@@ -292,43 +332,57 @@ static void run_listener(const char* fifo, const guint16 port, const char* proto
 
 	ws_debug("Listener running on port %u", port);
 
-	buf = (char*)g_malloc(PKT_BUF_SIZE);
+	/* The space we need is the standard header + variable lengths */
+	mbuf = (guint8*)g_malloc0(UDPDUMP_EXPORT_HEADER_LEN + ((strlen(proto_name) + 3) & 0xfffffffc) + PKT_BUF_SIZE);
+
+#ifdef HAVE_RECVMMSG
+	buf = (char*)g_malloc(UDPDUMP_RECV_BATCH * PKT_BUF_SIZE);
+	memset(msgs, 0x0, sizeof(msgs));
+	for (i = 0; i < UDPDUMP_RECV_BATCH; i++) {
+		iovecs[i].iov_base = buf + i * PKT_BUF_SIZE;
+		iovecs[i].iov_len = PKT_BUF_SIZE;
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &clientaddrs[i];
+	}
+
 	while(!extcap_end_application) {
-		memset(buf, 0x0, PKT_BUF_SIZE);
+		for (i = 0; i < UDPDUMP_RECV_BATCH; i++)
+			msgs[i].msg_hdr.msg_namelen = (socklen_t)sizeof(clientaddrs[i]);
+
+		/* Wait for one datagram, then take whatever else is already queued */
+		nmsgs = recvmmsg(sock, msgs, UDPDUMP_RECV_BATCH, MSG_WAITFORONE, NULL);
+		if (nmsgs < 0) {
+			handle_recv_error("recvmmsg");
+			continue;
+		}
 
+		for (i = 0; i < nmsgs && !extcap_end_application; i++) {
+			if (dump_packet(proto_name, port, (const char*)iovecs[i].iov_base, msgs[i].msg_len,
+					clientaddrs[i], mbuf, fp) == EXIT_FAILURE)
+				extcap_end_application = TRUE;
+		}
+
+		fflush(fp);
+	}
+#else
+	buf = (char*)g_malloc(PKT_BUF_SIZE);
+	while(!extcap_end_application) {
 		buflen = recvfrom(sock, buf, PKT_BUF_SIZE, 0, (struct sockaddr *)&clientaddr, &clientlen);
 		if (buflen < 0) {
-			switch(errno) {
-				case EAGAIN:
-				case EINTR:
-					break;
-				default:
-#ifdef _WIN32
-					{
-						wchar_t *errmsg = NULL;
-						int err = WSAGetLastError();
-						FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-							NULL, err,
-							MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-							(LPWSTR)&errmsg, 0, NULL);
-						ws_warning("Error in recvfrom: %S (err=%d)", errmsg, err);
-						LocalFree(errmsg);
-					}
-#else
-					ws_warning("Error in recvfrom: %s (errno=%d)", strerror(errno), errno);
-#endif
-					extcap_end_application = TRUE;
-					break;
-			}
+			handle_recv_error("recvfrom");
 		} else {
-			if (dump_packet(proto_name, port, buf, buflen, clientaddr, fp) == EXIT_FAILURE)
+			if (dump_packet(proto_name, port, buf, buflen, clientaddr, mbuf, fp) == EXIT_FAILURE)
 				extcap_end_application = TRUE;
+			fflush(fp);
 		}
 	}
+#endif
 
 	fclose(fp);
 	closesocket(sock);
 	g_free(buf);
+	g_free(mbuf);
 }
 
 int main(int argc, char *argv[])
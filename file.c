@@ -22,6 +22,7 @@
 #include <wsutil/file_util.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/json_dumper.h>
+#include <wsutil/report_message.h>
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 #include <ui/version_info.h>
@@ -53,6 +54,7 @@
 #include "ui/simple_dialog.h"
 #include "ui/main_statusbar.h"
 #include "ui/progress_dlg.h"
+#include "ui/record_copy.h"
 #include "ui/urls.h"
 #include "ui/ws_ui_util.h"
 #include "ui/packet_list_utils.h"
@@ -90,20 +92,6 @@ static match_result match_protocol_tree(capture_file *cf, frame_data *fdata,
 static void match_subtree_text(proto_node *node, gpointer data);
 static match_result match_summary_line(capture_file *cf, frame_data *fdata,
         wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow_and_wide(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow_and_wide_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_wide(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_wide_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_binary(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
 static match_result match_regex(capture_file *cf, frame_data *fdata,
         wtap_rec *, Buffer *, void *criterion);
 static match_result match_dfilter(capture_file *cf, frame_data *fdata,
@@ -117,12 +105,27 @@ static gboolean find_packet(capture_file *cf, ws_match_function match_function,
 
 static void cf_rename_failure_alert_box(const char *filename, int err);
 
+static gboolean can_copy_pcapng_blocks(capture_file *cf, guint save_format,
+        wtap_compression_type compression_type, gboolean discard_comments,
+        addrinfo_lists_t *addr_lists, GArray **rewrites_p);
+static cf_write_status_t copy_pcapng_blocks(capture_file *cf,
+        GArray *rewrites, const char *to_filename);
+static void pcapng_blocks_copied(capture_file *cf, GArray *rewrites);
+
 /* Seconds spent processing packets between pushing UI updates. */
 #define PROGBAR_UPDATE_INTERVAL 0.150
 
 /* Show the progress bar after this many seconds. */
 #define PROGBAR_SHOW_DELAY 0.5
 
+/*
+ * Microseconds cf_continue_tail() may spend dissecting before it hands
+ * control back to the UI, and how many records it reads between looks
+ * at the clock.
+ */
+#define TAIL_SLICE_USEC         (50 * 1000)
+#define TAIL_SLICE_CHECK_RECORDS 64
+
 /*
  * Maximum number of records we support in a file.
  *
@@ -281,6 +284,7 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
 
     /* No user changes yet. */
     cf->unsaved_changes = FALSE;
+    cf->shb_comment_changed = FALSE;
 
     cf->computed_elapsed = 0;
 
@@ -305,6 +309,8 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
     cf->provider.prev_dis = NULL;
     cf->provider.prev_cap = NULL;
     cf->cum_bytes = 0;
+    cf->dfilter_applied = TRUE;
+    cf->dfilter_refines = FALSE;
 
     /* Create new epan session for dissection.
      * (The old one was freed in cf_close().)
@@ -372,6 +378,7 @@ cf_close(capture_file *cf)
     }
     /* ...which means we have no changes to that file to save. */
     cf->unsaved_changes = FALSE;
+    cf->shb_comment_changed = FALSE;
 
     /* no open_routine type */
     cf->open_type = WTAP_TYPE_AUTO;
@@ -496,6 +503,8 @@ cf_read(capture_file *cf, gboolean reloading)
     guint                tap_flags;
     gboolean             compiled _U_;
     volatile gboolean    is_read_aborted = FALSE;
+    volatile gboolean    packet_list_thawed = FALSE;
+    gboolean             packet_selected;
 
     /* The update_progress_dlg call below might end up accepting a user request to
      * trigger redissection/rescans which can modify/destroy the dissection
@@ -549,7 +558,11 @@ cf_read(capture_file *cf, gboolean reloading)
        XXX - do we know this at open time? */
     cf->compression_type = wtap_get_compression_type(cf->provider.wth);
 
-    /* The packet list window will be empty until the file is completly loaded */
+    /* The packet list window will be empty until the file is completely
+       loaded, or until it's taken long enough to load that we've put up
+       a progress bar. After that we show the packets as we read them, as
+       we do for a live capture, so that the user can start looking at the
+       start of a big file while the rest of it is read. */
     packet_list_freeze();
 
     cf->stop_flag = FALSE;
@@ -607,7 +620,12 @@ cf_read(capture_file *cf, gboolean reloading)
                     /* update the packet bar content on the first run or frequently on very large files */
                     update_progress_dlg(progbar, progbar_val, status_str);
                     compute_elapsed(cf, start_time);
-                    packets_bar_update();
+                    if (!packet_list_thawed) {
+                        packet_list_thaw();
+                        packet_list_thawed = TRUE;
+                    } else {
+                        packets_bar_update();
+                    }
                     g_timer_start(prog_timer);
                 }
                 /*
@@ -686,7 +704,10 @@ cf_read(capture_file *cf, gboolean reloading)
        WTAP_ENCAP_PER_PACKET). */
     cf->lnk_t = wtap_file_encap(cf->provider.wth);
 
-    cf->current_frame = frame_data_sequence_find(cf->provider.frames, cf->first_displayed);
+    /* The user might have selected a packet while we were reading. */
+    packet_selected = cf->current_frame != NULL;
+    if (!packet_selected)
+        cf->current_frame = frame_data_sequence_find(cf->provider.frames, cf->first_displayed);
 
     packet_list_thaw();
     if (reloading)
@@ -694,9 +715,10 @@ cf_read(capture_file *cf, gboolean reloading)
     else
         cf_callback_invoke(cf_cb_file_read_finished, cf);
 
-    /* If we have any displayed packets to select, select the first of those
+    /* If we have any displayed packets to select, and the user didn't
+       select one while we were reading, select the first of those
        packets by making the first row the selected row. */
-    if (cf->first_displayed != 0) {
+    if (cf->first_displayed != 0 && !packet_selected) {
         packet_list_select_row_from_data(NULL);
     }
 
@@ -755,11 +777,14 @@ cf_read(capture_file *cf, gboolean reloading)
 
 #ifdef HAVE_LIBPCAP
 cf_read_status_t
-cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
+cf_continue_tail(capture_file *cf, int *to_read_p, wtap_rec *rec,
         Buffer *buf, int *err)
 {
     gchar            *err_info;
+    volatile int      to_read = *to_read_p;
     volatile int      newly_displayed_packets = 0;
+    gint64            slice_end;
+    volatile gboolean out_of_time = FALSE;
     dfilter_t        *dfcode;
     epan_dissect_t    edt;
     gboolean          create_proto_tree;
@@ -800,6 +825,8 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
 
     epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
 
+    slice_end = g_get_monotonic_time() + TAIL_SLICE_USEC;
+
     TRY {
         gint64 data_offset = 0;
         column_info *cinfo;
@@ -808,6 +835,17 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
         cinfo = (tap_flags & TL_REQUIRES_COLUMNS) ? &cf->cinfo : NULL;
 
         while (to_read != 0) {
+            /*
+             * If the capture child is writing records faster than we
+             * can dissect them, stop once we've used up our time slice
+             * and leave the rest for the caller to hand back to us, so
+             * that the UI gets to redraw and handle input in between.
+             */
+            if (to_read % TAIL_SLICE_CHECK_RECORDS == 0 &&
+                    g_get_monotonic_time() > slice_end) {
+                out_of_time = TRUE;
+                break;
+            }
             wtap_cleareof(cf->provider.wth);
             if (!wtap_read(cf->provider.wth, rec, buf, err, &err_info,
                         &data_offset)) {
@@ -841,6 +879,11 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
     }
     ENDTRY;
 
+    /* Only hand back records if we ran out of time; if we hit an error or
+       the end of what's been written so far, there's nothing to come back
+       for. */
+    *to_read_p = out_of_time ? to_read : 0;
+
     /* Update the file encapsulation; it might have changed based on the
        packets we've read. */
     cf->lnk_t = wtap_file_encap(cf->provider.wth);
@@ -1166,6 +1209,22 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
             &cf->provider.ref, cf->provider.prev_dis);
     cf->provider.prev_cap = fdata;
 
+    /* If we've dissected the frame before, and going by its bytes it
+       can't match the display filter, we needn't dissect it again to
+       find that out; whatever state dissecting it set up the first time
+       is still there for the frames that depend on it.  Taps might
+       want to see it, though, and a reference frame is displayed
+       whether or not it matches. */
+    if (dfcode != NULL && fdata->visited && !fdata->ref_time &&
+            !have_tap_listeners() &&
+            !dfilter_may_match_bytes(dfcode, ws_buffer_start_ptr(buf), fdata->cap_len)) {
+        fdata->passed_dfilter = 0;
+        if (add_to_packet_list) {
+            packet_list_append(cinfo, fdata);
+        }
+        return;
+    }
+
     if (dfcode != NULL) {
         epan_dissect_prime_with_dfilter(edt, dfcode);
     }
@@ -1469,6 +1528,70 @@ cf_merge_files_to_tempfile(gpointer pd_window, const char *temp_dir, char **out_
         return CF_OK;
 }
 
+/*
+ * Does the filter new_text only narrow the filter old_text, i.e. is it
+ * old_text ANDed with something else?  Any frame that new_text matches
+ * then also matches old_text.  We only look at the text, so we're
+ * conservative: old_text mustn't have a top-level "or" or "xor" that the
+ * "and" would bind more tightly than, and neither filter may use field
+ * references, whose values change with the selected frame.
+ */
+static gboolean
+dfilter_text_narrows(const char *old_text, const char *new_text)
+{
+    size_t old_len = strlen(old_text);
+    const char *p;
+
+    if (old_len == 0 || strncmp(new_text, old_text, old_len) != 0)
+        return FALSE;
+    if (strstr(new_text, "${") != NULL)
+        return FALSE;
+
+    p = new_text + old_len;
+    while (g_ascii_isspace(*p))
+        p++;
+    if (strncmp(p, "&&", 2) == 0) {
+        p += 2;
+    } else if (g_ascii_strncasecmp(p, "and", 3) == 0 &&
+            (g_ascii_isspace(p[3]) || p[3] == '(' || p[3] == '!')) {
+        p += 3;
+    } else {
+        return FALSE;
+    }
+    while (g_ascii_isspace(*p))
+        p++;
+    if (*p == '\0')
+        return FALSE;
+
+    /* A filter wrapped in parentheses binds as a whole. */
+    if (old_text[0] == '(' && old_text[old_len - 1] == ')') {
+        int depth = 0;
+        size_t i;
+
+        for (i = 0; i < old_len; i++) {
+            if (old_text[i] == '(')
+                depth++;
+            else if (old_text[i] == ')' && --depth == 0)
+                break;
+        }
+        if (i == old_len - 1)
+            return TRUE;
+    }
+
+    /* Otherwise, give up on anything that might be an "or" or "xor". */
+    if (strstr(old_text, "||") != NULL || strstr(old_text, "^^") != NULL)
+        return FALSE;
+    for (p = old_text; *p != '\0'; p++) {
+        if ((p == old_text || !g_ascii_isalnum(p[-1])) &&
+                (g_ascii_strncasecmp(p, "or", 2) == 0 || g_ascii_strncasecmp(p, "xor", 3) == 0)) {
+            const char *end = p + (g_ascii_tolower(*p) == 'x' ? 3 : 2);
+            if (!g_ascii_isalnum(*end) && *end != '_' && *end != '.')
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+
 cf_status_t
 cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
 {
@@ -1513,6 +1636,14 @@ cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
         }
     }
 
+    /* If every frame was filtered with the current filter, and the new
+     * one just narrows it, only the frames that are displayed now need to
+     * be looked at again.  The frames will reflect the new filter once
+     * it's been applied to all of them. */
+    cf->dfilter_refines = !force && cf->dfilter_applied && dftext != NULL &&
+        cf->dfilter != NULL && dfilter_text_narrows(cf->dfilter, dftext);
+    cf->dfilter_applied = FALSE;
+
     /* We have a valid filter.  Replace the current filter. */
     g_free(cf->dfilter);
     cf->dfilter = dftext;
@@ -1634,12 +1765,20 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     gboolean    compiled _U_;
     guint32     frames_count;
     gboolean    queued_rescan_type = RESCAN_NONE;
+    gboolean    refine, skip;
 
     /* Rescan in progress, clear pending actions. */
     cf->redissection_queued = RESCAN_NONE;
     ws_assert(!cf->read_lock);
     cf->read_lock = TRUE;
 
+    /* If the display filter only narrows the one the frames were last
+     * filtered with, frames that didn't match that can't match this one.
+     * Taps want to see every frame, though. */
+    refine = cf->dfilter_refines && !redissect && !have_tap_listeners();
+    cf->dfilter_refines = FALSE;
+    cf->dfilter_applied = FALSE;
+
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
 
@@ -1784,8 +1923,9 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
         wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
     }
 
+    fdata = NULL;
     for (framenum = 1; framenum <= frames_count; framenum++) {
-        fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+        fdata = frame_data_sequence_next(cf->provider.frames, fdata);
 
         /* Create the progress bar if necessary.
            We check on every iteration of the loop, so that it takes no
@@ -1856,7 +1996,12 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
         /* Frame dependencies from the previous dissection/filtering are no longer valid. */
         fdata->dependent_of_displayed = 0;
 
-        if (!cf_read_record(cf, fdata, &rec, &buf))
+        /* If we're narrowing the filter, a frame that didn't match the
+           old one can't match the new one, so we needn't read or dissect
+           it again. */
+        skip = refine && fdata->visited && !fdata->passed_dfilter && !fdata->ref_time;
+
+        if (!skip && !cf_read_record(cf, fdata, &rec, &buf))
             break; /* error reading the frame */
 
         /* If the previous frame is displayed, and we haven't yet seen the
@@ -1867,9 +2012,15 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
             preceding_frame = prev_frame;
         }
 
-        add_packet_to_packet_list(fdata, cf, &edt, dfcode,
-                cinfo, &rec, &buf,
-                add_to_packet_list);
+        if (skip) {
+            frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                    &cf->provider.ref, cf->provider.prev_dis);
+            cf->provider.prev_cap = fdata;
+        } else {
+            add_packet_to_packet_list(fdata, cf, &edt, dfcode,
+                    cinfo, &rec, &buf,
+                    add_to_packet_list);
+        }
 
         /* If this frame is displayed, and this is the first frame we've
            seen displayed after the selected frame, remember this frame -
@@ -1899,6 +2050,9 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     /* We are done redissecting the packet list. */
     cf->redissecting = FALSE;
 
+    /* If we got through all of the frames, they all reflect the filter. */
+    cf->dfilter_applied = framenum > frames_count;
+
     if (redissect) {
         frames_count = cf->count;
         /* Clear out what remains of the visited flags and per-frame data
@@ -2023,8 +2177,9 @@ cf_reftime_packets(capture_file* cf)
     cf->provider.prev_dis = NULL;
     cf->cum_bytes = 0;
 
+    fdata = NULL;
     for (framenum = 1; framenum <= cf->count; framenum++) {
-        fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+        fdata = frame_data_sequence_next(cf->provider.frames, fdata);
 
         /* just add some value here until we know if it is being displayed or not */
         fdata->cum_bytes = cf->cum_bytes + fdata->pkt_len;
@@ -2089,6 +2244,77 @@ cf_reftime_packets(capture_file* cf)
     }
 }
 
+/*
+ * Recalculate the ref time after the time reference mark of one frame
+ * was set or cleared.  Only the frames from that one up to the next
+ * time reference frame depend on it, so only those are updated, rather
+ * than scanning the whole file as cf_reftime_packets() does.
+ */
+void
+cf_reftime_packet_toggled(capture_file *cf, frame_data *toggled)
+{
+    frame_data *fdata, *prev;
+    const frame_data *ref = NULL;
+    guint32     cum_bytes = 0;
+    gboolean    prev_dis_fixed = toggled->passed_dfilter;
+    nstime_t    rel_ts;
+
+    /* The reference frame and byte count carried into the toggled frame. */
+    if (toggled->num > 1) {
+        prev = frame_data_sequence_find(cf->provider.frames, toggled->num - 1);
+        ref = prev->frame_ref_num ?
+            frame_data_sequence_find(cf->provider.frames, prev->frame_ref_num) : prev;
+        for (; prev != NULL; prev = prev->num > 1 ?
+                frame_data_sequence_find(cf->provider.frames, prev->num - 1) : NULL) {
+            if (prev->passed_dfilter || prev->ref_time) {
+                cum_bytes = prev->cum_bytes;
+                break;
+            }
+        }
+    }
+
+    for (fdata = toggled; fdata != NULL;
+            fdata = frame_data_sequence_next(cf->provider.frames, fdata)) {
+        gboolean displayed = fdata->passed_dfilter || fdata->ref_time;
+
+        /* A frame that doesn't match the filter is displayed only while
+           it's a time reference, so the next displayed frame's previous
+           displayed frame changes with it. */
+        if (fdata != toggled && displayed && !prev_dis_fixed) {
+            fdata->prev_dis_num = toggled->ref_time ? toggled->num : toggled->prev_dis_num;
+            prev_dis_fixed = TRUE;
+        }
+
+        /* From the next time reference on, nothing depends on this. */
+        if (fdata != toggled && fdata->ref_time)
+            return;
+
+        if (ref == NULL || fdata->ref_time)
+            ref = fdata;
+        fdata->frame_ref_num = (fdata != ref) ? ref->num : 0;
+        nstime_delta(&rel_ts, &fdata->abs_ts, &ref->abs_ts);
+        if ((gint32)cf->elapsed_time.secs < rel_ts.secs
+                || ((gint32)cf->elapsed_time.secs == rel_ts.secs && (gint32)cf->elapsed_time.nsecs < rel_ts.nsecs)) {
+            cf->elapsed_time = rel_ts;
+        }
+
+        if (displayed) {
+            cum_bytes = fdata->ref_time ? fdata->pkt_len : cum_bytes + fdata->pkt_len;
+            fdata->cum_bytes = cum_bytes;
+        } else {
+            fdata->cum_bytes = cum_bytes + fdata->pkt_len;
+        }
+    }
+
+    /* We got to the end, so what new frames carry on from has changed. */
+    cf->provider.ref = ref;
+    cf->cum_bytes = cum_bytes;
+    if (!prev_dis_fixed) {
+        cf->provider.prev_dis = toggled->ref_time ? toggled :
+            (toggled->prev_dis_num ? frame_data_sequence_find(cf->provider.frames, toggled->prev_dis_num) : NULL);
+    }
+}
+
 typedef enum {
     PSP_FINISHED,
     PSP_STOPPED,
@@ -2138,8 +2364,9 @@ process_specified_records(capture_file *cf, packet_range_t *range,
 
     /* Iterate through all the packets, printing the packets that
        were selected by the current display filter.  */
+    fdata = NULL;
     for (framenum = 1; framenum <= cf->count; framenum++) {
-        fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+        fdata = frame_data_sequence_next(cf->provider.frames, fdata);
 
         /* Create the progress bar if necessary.
            We check on every iteration of the loop, so that it takes no
@@ -2314,6 +2541,53 @@ cf_retap_packets(capture_file *cf)
     return CF_READ_OK;
 }
 
+cf_read_status_t
+cf_retap_frames(capture_file *cf, const GArray *frames)
+{
+    retap_callback_args_t callback_args;
+    gboolean         create_proto_tree;
+    guint            tap_flags;
+    wtap_rec         rec;
+    Buffer           buf;
+    guint            i;
+    cf_read_status_t status = CF_READ_OK;
+
+    /* Presumably the user closed the capture file. */
+    if (cf == NULL || frames == NULL) {
+        return CF_READ_ABORTED;
+    }
+
+    tap_flags = union_of_tap_listener_flags();
+    callback_args.cinfo = (tap_flags & TL_REQUIRES_COLUMNS) ? &cf->cinfo : NULL;
+    create_proto_tree =
+        (have_filtering_tap_listeners() || (tap_flags & TL_REQUIRES_PROTO_TREE));
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    epan_dissect_init(&callback_args.edt, cf->epan, create_proto_tree, FALSE);
+
+    for (i = 0; i < frames->len; i++) {
+        frame_data *fdata = frame_data_sequence_find(cf->provider.frames,
+                g_array_index(frames, guint32, i));
+
+        if (fdata == NULL) {
+            continue;
+        }
+        if (!cf_read_record(cf, fdata, &rec, &buf)) {
+            status = CF_READ_ERROR;
+            break;
+        }
+        retap_packet(cf, fdata, &rec, &buf, &callback_args);
+        wtap_rec_reset(&rec);
+    }
+
+    epan_dissect_cleanup(&callback_args.edt);
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+
+    return status;
+}
+
 typedef struct {
     print_args_t *print_args;
     gboolean      print_header_line;
@@ -3252,6 +3526,25 @@ typedef struct {
     ws_mempbrk_pattern *pattern;
 } cbs_t;    /* "Counted byte string" */
 
+typedef gboolean (*ws_bytes_match_function)(const cbs_t *info,
+        const guint8 *buf_start, guint32 buf_len,
+        guint32 *search_pos, guint32 *search_len);
+static gboolean match_narrow_and_wide(const cbs_t *info, const guint8 *buf_start,
+        guint32 buf_len, guint32 *search_pos, guint32 *search_len);
+static gboolean match_narrow_and_wide_case(const cbs_t *info, const guint8 *buf_start,
+        guint32 buf_len, guint32 *search_pos, guint32 *search_len);
+static gboolean match_narrow(const cbs_t *info, const guint8 *buf_start,
+        guint32 buf_len, guint32 *search_pos, guint32 *search_len);
+static gboolean match_narrow_case(const cbs_t *info, const guint8 *buf_start,
+        guint32 buf_len, guint32 *search_pos, guint32 *search_len);
+static gboolean match_wide(const cbs_t *info, const guint8 *buf_start,
+        guint32 buf_len, guint32 *search_pos, guint32 *search_len);
+static gboolean match_wide_case(const cbs_t *info, const guint8 *buf_start,
+        guint32 buf_len, guint32 *search_pos, guint32 *search_len);
+static gboolean match_binary(const cbs_t *info, const guint8 *buf_start,
+        guint32 buf_len, guint32 *search_pos, guint32 *search_len);
+static gboolean find_packet_data(capture_file *cf, ws_bytes_match_function match,
+        const cbs_t *info, search_direction dir);
 
 /*
  * The current match_* routines only support ASCII case insensitivity and don't
@@ -3294,13 +3587,13 @@ cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
             switch (cf->scs_type) {
 
                 case SCS_NARROW_AND_WIDE:
-                    return find_packet(cf, match_narrow_and_wide_case, &info, dir);
+                    return find_packet_data(cf, match_narrow_and_wide_case, &info, dir);
 
                 case SCS_NARROW:
-                    return find_packet(cf, match_narrow_case, &info, dir);
+                    return find_packet_data(cf, match_narrow_case, &info, dir);
 
                 case SCS_WIDE:
-                    return find_packet(cf, match_wide_case, &info, dir);
+                    return find_packet_data(cf, match_wide_case, &info, dir);
 
                 default:
                     ws_assert_not_reached();
@@ -3311,13 +3604,13 @@ cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
             switch (cf->scs_type) {
 
                 case SCS_NARROW_AND_WIDE:
-                    return find_packet(cf, match_narrow_and_wide, &info, dir);
+                    return find_packet_data(cf, match_narrow_and_wide, &info, dir);
 
                 case SCS_NARROW:
-                    return find_packet(cf, match_narrow, &info, dir);
+                    return find_packet_data(cf, match_narrow, &info, dir);
 
                 case SCS_WIDE:
-                    return find_packet(cf, match_wide, &info, dir);
+                    return find_packet_data(cf, match_wide, &info, dir);
 
                 default:
                     ws_assert_not_reached();
@@ -3325,35 +3618,25 @@ cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
             }
         }
     } else
-        return find_packet(cf, match_binary, &info, dir);
+        return find_packet_data(cf, match_binary, &info, dir);
 }
 
-static match_result
-match_narrow_and_wide(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+static gboolean
+match_narrow_and_wide(const cbs_t *info, const guint8 *buf_start, guint32 buf_len,
+        guint32 *search_pos, guint32 *search_len)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
     const guint8 *ascii_text = info->data;
     size_t        textlen    = info->data_len;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
+    gboolean      result;
+    const guint8 *pd, *buf_end;
     guint32       i;
     guint8        c_char;
     size_t        c_match    = 0;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
+    result = FALSE;
     buf_end = buf_start + buf_len;
     for (pd = buf_start; pd < buf_end; pd++) {
-        pd = (guint8 *)memchr(pd, ascii_text[0], buf_end - pd);
+        pd = (const guint8 *)memchr(pd, ascii_text[0], buf_end - pd);
         if (pd == NULL) break;
         /* Try narrow match at this start location */
         c_match = 0;
@@ -3362,11 +3645,11 @@ match_narrow_and_wide(capture_file *cf, frame_data *fdata,
             if (c_char == ascii_text[c_match]) {
                 c_match++;
                 if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    cf->search_pos = i + (guint32)(pd - buf_start);
+                    result = TRUE;
+                    *search_pos = i + (guint32)(pd - buf_start);
                     /* Save the position of the last character
                        for highlighting the field. */
-                    cf->search_len = i + 1;
+                    *search_len = i + 1;
                     goto done;
                 }
             } else {
@@ -3381,11 +3664,11 @@ match_narrow_and_wide(capture_file *cf, frame_data *fdata,
             if (c_char == ascii_text[c_match]) {
                 c_match++;
                 if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    cf->search_pos = i + (guint32)(pd - buf_start);
+                    result = TRUE;
+                    *search_pos = i + (guint32)(pd - buf_start);
                     /* Save the position of the last character
                        for highlighting the field. */
-                    cf->search_len = i + 1;
+                    *search_len = i + 1;
                     goto done;
                 }
                 i++;
@@ -3401,35 +3684,25 @@ done:
 }
 
 /* Case insensitive match */
-static match_result
-match_narrow_and_wide_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+static gboolean
+match_narrow_and_wide_case(const cbs_t *info, const guint8 *buf_start, guint32 buf_len,
+        guint32 *search_pos, guint32 *search_len)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
     const guint8 *ascii_text = info->data;
     size_t        textlen    = info->data_len;
     ws_mempbrk_pattern *pattern = info->pattern;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
+    gboolean      result;
+    const guint8 *pd, *buf_end;
     guint32       i;
     guint8        c_char;
     size_t        c_match    = 0;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
     ws_assert(pattern != NULL);
 
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
+    result = FALSE;
     buf_end = buf_start + buf_len;
     for (pd = buf_start; pd < buf_end; pd++) {
-        pd = (guint8 *)ws_mempbrk_exec(pd, buf_end - pd, pattern, &c_char);
+        pd = (const guint8 *)ws_mempbrk_exec(pd, buf_end - pd, pattern, &c_char);
         if (pd == NULL) break;
         /* Try narrow match at this start location */
         c_match = 0;
@@ -3438,11 +3711,11 @@ match_narrow_and_wide_case(capture_file *cf, frame_data *fdata,
             if (c_char == ascii_text[c_match]) {
                 c_match++;
                 if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    cf->search_pos = i + (guint32)(pd - buf_start);
+                    result = TRUE;
+                    *search_pos = i + (guint32)(pd - buf_start);
                     /* Save the position of the last character
                        for highlighting the field. */
-                    cf->search_len = i + 1;
+                    *search_len = i + 1;
                     goto done;
                 }
             } else {
@@ -3457,11 +3730,11 @@ match_narrow_and_wide_case(capture_file *cf, frame_data *fdata,
             if (c_char == ascii_text[c_match]) {
                 c_match++;
                 if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    cf->search_pos = i + (guint32)(pd - buf_start);
+                    result = TRUE;
+                    *search_pos = i + (guint32)(pd - buf_start);
                     /* Save the position of the last character
                        for highlighting the field. */
-                    cf->search_len = i + 1;
+                    *search_len = i + 1;
                     goto done;
                 }
                 i++;
@@ -3476,32 +3749,22 @@ done:
     return result;
 }
 
-static match_result
-match_narrow(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+static gboolean
+match_narrow(const cbs_t *info, const guint8 *buf_start, guint32 buf_len,
+        guint32 *search_pos, guint32 *search_len)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
     const guint8 *ascii_text = info->data;
     size_t        textlen    = info->data_len;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
+    gboolean      result;
+    const guint8 *pd, *buf_end;
     guint32       i;
     guint8        c_char;
     size_t        c_match    = 0;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
+    result = FALSE;
     buf_end = buf_start + buf_len;
     for (pd = buf_start; pd < buf_end; pd++) {
-        pd = (guint8 *)memchr(pd, ascii_text[0], buf_end - pd);
+        pd = (const guint8 *)memchr(pd, ascii_text[0], buf_end - pd);
         if (pd == NULL) break;
         c_match = 0;
         for (i = 0; pd + i < buf_end; i++) {
@@ -3509,11 +3772,11 @@ match_narrow(capture_file *cf, frame_data *fdata,
             if (c_char == ascii_text[c_match]) {
                 c_match++;
                 if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    cf->search_pos = i + (guint32)(pd - buf_start);
+                    result = TRUE;
+                    *search_pos = i + (guint32)(pd - buf_start);
                     /* Save the position of the last character
                        for highlighting the field. */
-                    cf->search_len = i + 1;
+                    *search_len = i + 1;
                     goto done;
                 }
             } else {
@@ -3527,35 +3790,25 @@ done:
 }
 
 /* Case insensitive match */
-static match_result
-match_narrow_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+static gboolean
+match_narrow_case(const cbs_t *info, const guint8 *buf_start, guint32 buf_len,
+        guint32 *search_pos, guint32 *search_len)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
     const guint8 *ascii_text = info->data;
     size_t        textlen    = info->data_len;
     ws_mempbrk_pattern *pattern = info->pattern;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
+    gboolean      result;
+    const guint8 *pd, *buf_end;
     guint32       i;
     guint8        c_char;
     size_t        c_match    = 0;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
     ws_assert(pattern != NULL);
 
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
+    result = FALSE;
     buf_end = buf_start + buf_len;
     for (pd = buf_start; pd < buf_end; pd++) {
-        pd = (guint8 *)ws_mempbrk_exec(pd, buf_end - pd, pattern, &c_char);
+        pd = (const guint8 *)ws_mempbrk_exec(pd, buf_end - pd, pattern, &c_char);
         if (pd == NULL) break;
         c_match = 0;
         for (i = 0; pd + i < buf_end; i++) {
@@ -3563,11 +3816,11 @@ match_narrow_case(capture_file *cf, frame_data *fdata,
             if (c_char == ascii_text[c_match]) {
                 c_match++;
                 if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    cf->search_pos = i + (guint32)(pd - buf_start);
+                    result = TRUE;
+                    *search_pos = i + (guint32)(pd - buf_start);
                     /* Save the position of the last character
                        for highlighting the field. */
-                    cf->search_len = i + 1;
+                    *search_len = i + 1;
                     goto done;
                 }
             } else {
@@ -3580,32 +3833,22 @@ done:
     return result;
 }
 
-static match_result
-match_wide(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+static gboolean
+match_wide(const cbs_t *info, const guint8 *buf_start, guint32 buf_len,
+        guint32 *search_pos, guint32 *search_len)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
     const guint8 *ascii_text = info->data;
     size_t        textlen    = info->data_len;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
+    gboolean      result;
+    const guint8 *pd, *buf_end;
     guint32       i;
     guint8        c_char;
     size_t        c_match    = 0;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
+    result = FALSE;
     buf_end = buf_start + buf_len;
     for (pd = buf_start; pd < buf_end; pd++) {
-        pd = (guint8 *)memchr(pd, ascii_text[0], buf_end - pd);
+        pd = (const guint8 *)memchr(pd, ascii_text[0], buf_end - pd);
         if (pd == NULL) break;
         c_match = 0;
         for (i = 0; pd + i < buf_end; i++) {
@@ -3613,11 +3856,11 @@ match_wide(capture_file *cf, frame_data *fdata,
             if (c_char == ascii_text[c_match]) {
                 c_match++;
                 if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    cf->search_pos = i + (guint32)(pd - buf_start);
+                    result = TRUE;
+                    *search_pos = i + (guint32)(pd - buf_start);
                     /* Save the position of the last character
                        for highlighting the field. */
-                    cf->search_len = i + 1;
+                    *search_len = i + 1;
                     goto done;
                 }
                 i++;
@@ -3633,35 +3876,25 @@ done:
 }
 
 /* Case insensitive match */
-static match_result
-match_wide_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+static gboolean
+match_wide_case(const cbs_t *info, const guint8 *buf_start, guint32 buf_len,
+        guint32 *search_pos, guint32 *search_len)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
     const guint8 *ascii_text = info->data;
     size_t        textlen    = info->data_len;
     ws_mempbrk_pattern *pattern = info->pattern;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
+    gboolean      result;
+    const guint8 *pd, *buf_end;
     guint32       i;
     guint8        c_char;
     size_t        c_match    = 0;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
     ws_assert(pattern != NULL);
 
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
+    result = FALSE;
     buf_end = buf_start + buf_len;
     for (pd = buf_start; pd < buf_end; pd++) {
-        pd = (guint8 *)ws_mempbrk_exec(pd, buf_end - pd, pattern, &c_char);
+        pd = (const guint8 *)ws_mempbrk_exec(pd, buf_end - pd, pattern, &c_char);
         if (pd == NULL) break;
         c_match = 0;
         for (i = 0; pd + i < buf_end; i++) {
@@ -3669,11 +3902,11 @@ match_wide_case(capture_file *cf, frame_data *fdata,
             if (c_char == ascii_text[c_match]) {
                 c_match++;
                 if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    cf->search_pos = i + (guint32)(pd - buf_start);
+                    result = TRUE;
+                    *search_pos = i + (guint32)(pd - buf_start);
                     /* Save the position of the last character
                        for highlighting the field. */
-                    cf->search_len = i + 1;
+                    *search_len = i + 1;
                     goto done;
                 }
                 i++;
@@ -3688,45 +3921,35 @@ done:
     return result;
 }
 
-static match_result
-match_binary(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+static gboolean
+match_binary(const cbs_t *info, const guint8 *buf_start, guint32 buf_len,
+        guint32 *search_pos, guint32 *search_len)
 {
-    cbs_t        *info        = (cbs_t *)criterion;
     const guint8 *binary_data = info->data;
     size_t        datalen     = info->data_len;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
+    gboolean      result;
+    const guint8 *pd, *buf_end;
     guint32       i;
     size_t        c_match     = 0;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
+    result = FALSE;
     buf_end = buf_start + buf_len;
     /* Not clear if using memcmp() is faster. memmem() on systems that
      * have it should be faster, though.
      */
     for (pd = buf_start; pd < buf_end; pd++) {
-        pd = (guint8 *)memchr(pd, binary_data[0], buf_end - pd);
+        pd = (const guint8 *)memchr(pd, binary_data[0], buf_end - pd);
         if (pd == NULL) break;
         c_match = 0;
         for (i = 0; pd + i < buf_end; i++) {
             if (pd[i] == binary_data[c_match]) {
                 c_match++;
                 if (c_match == datalen) {
-                    result = MR_MATCHED;
-                    cf->search_pos = i + (guint32)(pd - buf_start);
+                    result = TRUE;
+                    *search_pos = i + (guint32)(pd - buf_start);
                     /* Save the position of the last character
                        for highlighting the field. */
-                    cf->search_len = i + 1;
+                    *search_len = i + 1;
                     goto done;
                 }
             } else {
@@ -3739,6 +3962,223 @@ done:
     return result;
 }
 
+/*
+ * Byte searches don't need the frames dissected, so rather than matching
+ * one frame at a time as find_packet() asks about them, we read a batch
+ * of the frames it's going to ask about and match them on a thread pool.
+ * The reading stays on this thread, as the capture file's wtap handle
+ * can't be shared.  The batches start small, so that "find next" with a
+ * match close by doesn't read far ahead, and grow as the search goes on.
+ */
+#define FIND_BATCH_MIN_FRAMES   64
+#define FIND_BATCH_MAX_FRAMES   8192
+#define FIND_BATCH_MAX_BYTES    (16 * 1024 * 1024)
+/* Fewer frames than this aren't worth handing to another thread. */
+#define FIND_CHUNK_FRAMES       256
+
+typedef struct {
+    guint32   framenum;
+    guint32   offset;           /* Offset of the frame's data in the batch */
+    guint32   len;
+    gboolean  matched;
+    guint32   search_pos;
+    guint32   search_len;
+} find_batch_frame_t;
+
+typedef struct {
+    ws_bytes_match_function match;
+    const cbs_t *info;
+    search_direction dir;
+    GArray      *frames;        /* find_batch_frame_t, in search order */
+    GByteArray  *bytes;
+    guint        next;          /* Index of the frame we'll be asked about next */
+    guint        max_frames;
+    GThreadPool *pool;
+    GMutex       mutex;
+    GCond        cond;
+    guint        pending;       /* Chunks still being matched */
+} find_batch_t;
+
+typedef struct {
+    find_batch_t *batch;
+    guint         first;
+    guint         last;
+} find_batch_chunk_t;
+
+static void
+find_batch_match(find_batch_t *batch, guint first, guint last)
+{
+    guint i;
+
+    for (i = first; i < last; i++) {
+        find_batch_frame_t *bf = &g_array_index(batch->frames, find_batch_frame_t, i);
+
+        bf->matched = batch->match(batch->info, batch->bytes->data + bf->offset,
+                bf->len, &bf->search_pos, &bf->search_len);
+    }
+}
+
+static void
+find_batch_worker(gpointer data, gpointer user_data _U_)
+{
+    find_batch_chunk_t *chunk = (find_batch_chunk_t *)data;
+    find_batch_t *batch = chunk->batch;
+
+    find_batch_match(batch, chunk->first, chunk->last);
+    g_free(chunk);
+
+    g_mutex_lock(&batch->mutex);
+    if (--batch->pending == 0)
+        g_cond_signal(&batch->cond);
+    g_mutex_unlock(&batch->mutex);
+}
+
+/*
+ * Read the displayed frames from fdata on, in the order in which
+ * find_packet() will ask about them, and match them.  Returns FALSE if
+ * fdata itself can't be read; a later frame that can't be read ends the
+ * batch, and its error is reported when find_packet() gets to it.
+ */
+static gboolean
+find_batch_fill(capture_file *cf, find_batch_t *batch, frame_data *fdata,
+        wtap_rec *rec, Buffer *buf)
+{
+    guint32 start_num = cf->current_frame ? cf->current_frame->num : 0;
+    guint32 framenum = fdata->num;
+    find_batch_frame_t bf;
+    guint nchunks, i;
+
+    g_array_set_size(batch->frames, 0);
+    g_byte_array_set_size(batch->bytes, 0);
+    batch->next = 0;
+
+    for (;;) {
+        if (fdata->passed_dfilter) {
+            if (batch->frames->len == 0) {
+                if (!cf_read_record(cf, fdata, rec, buf))
+                    return FALSE;
+            } else if (!cf_read_record_no_alert(cf, fdata, rec, buf)) {
+                break;
+            }
+            bf.framenum = fdata->num;
+            bf.offset = batch->bytes->len;
+            bf.len = fdata->cap_len;
+            bf.matched = FALSE;
+            g_byte_array_append(batch->bytes, ws_buffer_start_ptr(buf), fdata->cap_len);
+            g_array_append_val(batch->frames, bf);
+            wtap_rec_reset(rec);
+        }
+
+        /* find_packet() stops when it gets back to where it started. */
+        if (framenum == start_num || batch->frames->len >= batch->max_frames ||
+                batch->bytes->len >= FIND_BATCH_MAX_BYTES)
+            break;
+
+        /* Go on to the frame find_packet() will go on to. */
+        if (batch->dir == SD_BACKWARD) {
+            if (framenum <= 1) {
+                if (!prefs.gui_find_wrap)
+                    break;
+                framenum = cf->count;
+            } else {
+                framenum--;
+            }
+        } else {
+            if (framenum >= cf->count) {
+                if (!prefs.gui_find_wrap)
+                    break;
+                framenum = 1;
+            } else {
+                framenum++;
+            }
+        }
+        fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+        if (fdata == NULL)
+            break;
+    }
+    batch->max_frames = MIN(batch->max_frames * 2, FIND_BATCH_MAX_FRAMES);
+
+    nchunks = MIN(batch->frames->len / FIND_CHUNK_FRAMES, g_get_num_processors());
+    if (batch->pool == NULL || nchunks < 2) {
+        find_batch_match(batch, 0, batch->frames->len);
+        return TRUE;
+    }
+
+    batch->pending = nchunks;
+    for (i = 0; i < nchunks; i++) {
+        find_batch_chunk_t *chunk = g_new(find_batch_chunk_t, 1);
+
+        chunk->batch = batch;
+        chunk->first = (guint)((guint64)batch->frames->len * i / nchunks);
+        chunk->last = (guint)((guint64)batch->frames->len * (i + 1) / nchunks);
+        g_thread_pool_push(batch->pool, chunk, NULL);
+    }
+    g_mutex_lock(&batch->mutex);
+    while (batch->pending != 0)
+        g_cond_wait(&batch->cond, &batch->mutex);
+    g_mutex_unlock(&batch->mutex);
+    return TRUE;
+}
+
+static match_result
+match_data_batch(capture_file *cf, frame_data *fdata,
+        wtap_rec *rec, Buffer *buf, void *criterion)
+{
+    find_batch_t *batch = (find_batch_t *)criterion;
+    find_batch_frame_t *bf;
+
+    if (batch->next >= batch->frames->len ||
+            g_array_index(batch->frames, find_batch_frame_t, batch->next).framenum != fdata->num) {
+        /* We haven't looked at this one yet. */
+        if (!find_batch_fill(cf, batch, fdata, rec, buf))
+            return MR_ERROR;
+        if (batch->frames->len == 0 ||
+                g_array_index(batch->frames, find_batch_frame_t, 0).framenum != fdata->num)
+            return MR_NOTMATCHED;   /* It's not displayed */
+    }
+
+    bf = &g_array_index(batch->frames, find_batch_frame_t, batch->next);
+    batch->next++;
+    if (!bf->matched)
+        return MR_NOTMATCHED;
+    cf->search_pos = bf->search_pos;
+    cf->search_len = bf->search_len;
+    return MR_MATCHED;
+}
+
+static gboolean
+find_packet_data(capture_file *cf, ws_bytes_match_function match,
+        const cbs_t *info, search_direction dir)
+{
+    find_batch_t batch;
+    guint nthreads = g_get_num_processors();
+    gboolean result;
+
+    batch.match = match;
+    batch.info = info;
+    batch.dir = dir;
+    batch.frames = g_array_new(FALSE, FALSE, sizeof(find_batch_frame_t));
+    batch.bytes = g_byte_array_new();
+    batch.next = 0;
+    batch.max_frames = FIND_BATCH_MIN_FRAMES;
+    batch.pool = NULL;
+    if (nthreads > 1)
+        batch.pool = g_thread_pool_new(find_batch_worker, NULL, nthreads, FALSE, NULL);
+    g_mutex_init(&batch.mutex);
+    g_cond_init(&batch.cond);
+    batch.pending = 0;
+
+    result = find_packet(cf, match_data_batch, &batch, dir);
+
+    if (batch.pool != NULL)
+        g_thread_pool_free(batch.pool, FALSE, TRUE);
+    g_cond_clear(&batch.cond);
+    g_mutex_clear(&batch.mutex);
+    g_byte_array_free(batch.bytes, TRUE);
+    g_array_free(batch.frames, TRUE);
+    return result;
+}
+
 static match_result
 match_regex(capture_file *cf, frame_data *fdata,
         wtap_rec *rec, Buffer *buf, void *criterion _U_)
@@ -4080,6 +4520,33 @@ cf_goto_framenum(capture_file *cf)
     return FALSE;
 }
 
+/*
+ * Go to the first displayed frame at or after the given time.
+ */
+gboolean
+cf_goto_time(capture_file *cf, const nstime_t *ts)
+{
+    frame_data *fdata;
+
+    if (cf == NULL || cf->provider.frames == NULL) {
+        statusbar_push_temporary_msg("There is no file loaded");
+        return FALSE;
+    }
+
+    /* The time index gets us to the first frame at or after ts. */
+    for (fdata = frame_data_sequence_find_by_time(cf->provider.frames, ts);
+         fdata != NULL && !fdata->passed_dfilter;
+         fdata = frame_data_sequence_next(cf->provider.frames, fdata))
+        ;
+
+    if (fdata == NULL) {
+        statusbar_push_temporary_msg("There are no displayed packets at or after that time.");
+        return FALSE;
+    }
+
+    return cf_goto_frame(cf, fdata->num);
+}
+
 /* Select the packet on a given row. */
 void
 cf_select_packet(capture_file *cf, frame_data *fdata)
@@ -4234,6 +4701,7 @@ cf_update_section_comment(capture_file *cf, gchar *comment)
     }
     /* Mark the file as having unsaved changes */
     cf->unsaved_changes = TRUE;
+    cf->shb_comment_changed = TRUE;
 }
 
 /*
@@ -4560,6 +5028,7 @@ rescan_file(capture_file *cf, const char *fname, gboolean is_tempfile)
 
     /* No user changes yet. */
     cf->unsaved_changes = FALSE;
+    cf->shb_comment_changed = FALSE;
 
     cf->cd_t        = wtap_file_type_subtype(cf->provider.wth);
     cf->linktypes = g_array_sized_new(FALSE, FALSE, (guint) sizeof(int), 1);
@@ -4700,6 +5169,7 @@ cf_save_records(capture_file *cf, const char *fname, guint save_format,
     }                    how_to_save;
     save_callback_args_t callback_args;
     gboolean needs_reload = FALSE;
+    GArray  *rewrites = NULL;
 
     /* XXX caller should avoid saving the file while a read is pending
      * (e.g. by delaying the save action) */
@@ -4788,6 +5258,31 @@ cf_save_records(capture_file *cf, const char *fname, guint save_format,
                     goto fail;
             }
         }
+    } else if (can_copy_pcapng_blocks(cf, save_format, compression_type,
+                discard_comments, addr_lists, &rewrites)) {
+        /* We're saving a pcapng file as pcapng, and the only changes are
+           to packet comments; copy the file, re-encoding only the packet
+           blocks whose comments were changed, rather than writing every
+           packet out in Wiretap and reading the whole file back in. */
+        if (file_exists(fname))
+            fname_new = ws_strdup_printf("%s~", fname);
+        switch (copy_pcapng_blocks(cf, rewrites, fname_new != NULL ? fname_new : fname)) {
+
+            case CF_WRITE_OK:
+                break;
+
+            case CF_WRITE_ABORTED:
+                if (fname_new != NULL)
+                    ws_unlink(fname_new);
+                g_free(fname_new);
+                pcapng_block_rewrites_free(rewrites);
+                cf_callback_invoke(cf_cb_file_save_stopped, NULL);
+                return CF_WRITE_ABORTED;
+
+            case CF_WRITE_ERROR:
+                goto fail;
+        }
+        how_to_save = SAVE_WITH_COPY;
     } else {
         /* Either we're saving in a different format or we're saving changes,
            such as added, modified, or removed comments, that haven't yet
@@ -4913,6 +5408,7 @@ cf_save_records(capture_file *cf, const char *fname, guint save_format,
 
     cf_callback_invoke(cf_cb_file_save_finished, NULL);
     cf->unsaved_changes = FALSE;
+    cf->shb_comment_changed = FALSE;
 
     if (!dont_reopen) {
         switch (how_to_save) {
@@ -4943,6 +5439,10 @@ cf_save_records(capture_file *cf, const char *fname, guint save_format,
                     g_free(cf->filename);
                     cf->filename = g_strdup(fname);
                     cf->is_tempfile = FALSE;
+                    /* If we re-encoded packet blocks, the new file has
+                       their comments, and the blocks after them moved. */
+                    if (rewrites != NULL)
+                        pcapng_blocks_copied(cf, rewrites);
                 }
                 cf_callback_invoke(cf_cb_file_fast_save_finished, cf);
                 break;
@@ -5017,9 +5517,11 @@ cf_save_records(capture_file *cf, const char *fname, guint save_format,
             cf->packet_comment_count = 0;
         }
     }
+    pcapng_block_rewrites_free(rewrites);
     return CF_WRITE_OK;
 
 fail:
+    pcapng_block_rewrites_free(rewrites);
     if (fname_new != NULL) {
         /* We were trying to write to a temporary file; get rid of it if it
            exists.  (We don't care whether this fails, as, if it fails,
@@ -5034,6 +5536,196 @@ fail:
     return CF_WRITE_ERROR;
 }
 
+/*
+ * Can the specified packets be exported by copying the records as raw
+ * bytes?  That's the case if the file is a plain pcap file, read from
+ * disk, and it's being exported, uncompressed, in the same format, with
+ * nothing about the packets changed; pcap records have no options to
+ * change, and follow each other in the file with nothing in between.
+ */
+static gboolean
+can_copy_pcap_records(capture_file *cf, guint save_format,
+        wtap_compression_type compression_type)
+{
+    if (save_format != cf->cd_t || cf->unsaved_changes || cf->read_lock)
+        return FALSE;
+    if (compression_type != WTAP_UNCOMPRESSED ||
+            cf->compression_type != WTAP_UNCOMPRESSED)
+        return FALSE;
+    if (cf->count == 0)
+        return FALSE;
+    return save_format == (guint)wtap_name_to_file_type_subtype("pcap") ||
+        save_format == (guint)wtap_name_to_file_type_subtype("nsecpcap");
+}
+
+/*
+ * Export the specified packets of a pcap file by copying its file header,
+ * and then each run of consecutive specified records in one go, rather
+ * than reading and writing the records one at a time through Wiretap.
+ */
+static cf_write_status_t
+copy_pcap_records(capture_file *cf, packet_range_t *range,
+        const char *to_filename)
+{
+    pcap_record_copy_t copy;
+    frame_data      *fdata = NULL;
+    guint32          framenum;
+    range_process_e  process_this;
+    cf_write_status_t ret = CF_WRITE_OK;
+
+    progdlg_t       *progbar = NULL;
+    GTimer          *prog_timer;
+    gchar            progbar_status_str[100];
+
+    if (!pcap_record_copy_open(&copy, cf->filename, to_filename))
+        return CF_WRITE_ERROR;
+
+    prog_timer = g_timer_new();
+    cf->stop_flag = FALSE;
+    packet_range_process_init(range);
+
+    for (framenum = 1; framenum <= cf->count; framenum++) {
+        fdata = frame_data_sequence_next(cf->provider.frames, fdata);
+
+        if (progbar == NULL)
+            progbar = delayed_create_progress_dlg(cf->window, "Writing",
+                    "specified records", TRUE, &cf->stop_flag,
+                    (gfloat) framenum / cf->count);
+        if (progbar && g_timer_elapsed(prog_timer, NULL) > PROGBAR_UPDATE_INTERVAL) {
+            snprintf(progbar_status_str, sizeof(progbar_status_str),
+                    "%4u of %u packets", framenum, cf->count);
+            update_progress_dlg(progbar, (gfloat) framenum / cf->count,
+                    progbar_status_str);
+            g_timer_start(prog_timer);
+        }
+        if (cf->stop_flag) {
+            ret = CF_WRITE_ABORTED;
+            break;
+        }
+
+        process_this = packet_range_process_packet(range, fdata);
+        if (!pcap_record_copy_next(&copy, fdata->file_off,
+                    process_this == range_process_this)) {
+            ret = CF_WRITE_ERROR;
+            break;
+        }
+        if (process_this == range_processing_finished)
+            break;
+    }
+
+    if (progbar != NULL)
+        destroy_progress_dlg(progbar);
+    g_timer_destroy(prog_timer);
+    if (!pcap_record_copy_close(&copy, ret == CF_WRITE_OK) && ret == CF_WRITE_OK)
+        ret = CF_WRITE_ERROR;
+    return ret;
+}
+
+/*
+ * Can the file be saved by copying it, re-encoding only the packet blocks
+ * whose comments were changed?  That's the case if it's an uncompressed
+ * pcapng file with a single section, read from disk, that's being saved,
+ * uncompressed, as pcapng, with no change other than to packet comments
+ * and no name resolution information to add.  If so, *rewrites_p is set
+ * to the blocks to replace, in file order.
+ */
+static gboolean
+can_copy_pcapng_blocks(capture_file *cf, guint save_format,
+        wtap_compression_type compression_type, gboolean discard_comments,
+        addrinfo_lists_t *addr_lists, GArray **rewrites_p)
+{
+    int          fd;
+    gboolean     byte_swapped;
+    frame_data  *fdata = NULL;
+    guint32      framenum;
+    GArray      *rewrites;
+
+    if (save_format != cf->cd_t ||
+            save_format != (guint)wtap_pcapng_file_type_subtype())
+        return FALSE;
+    if (compression_type != WTAP_UNCOMPRESSED ||
+            cf->compression_type != WTAP_UNCOMPRESSED)
+        return FALSE;
+    if (discard_comments || cf->read_lock || cf->shb_comment_changed)
+        return FALSE;
+    if (!wtap_addrinfo_list_empty(addr_lists))
+        return FALSE;
+    if (cf->count == 0 || wtap_file_get_num_shbs(cf->provider.wth) != 1)
+        return FALSE;
+
+    /* If anything looks odd, let Wiretap write the file. */
+    fd = pcapng_rewrite_open(cf->filename, &byte_swapped);
+    if (fd < 0)
+        return FALSE;
+
+    rewrites = g_array_new(FALSE, FALSE, sizeof (pcapng_block_rewrite_t));
+    for (framenum = 1; framenum <= cf->count; framenum++) {
+        fdata = frame_data_sequence_next(cf->provider.frames, fdata);
+        if (!fdata->has_modified_block)
+            continue;
+        if (!pcapng_rewrite_packet_block(fd, byte_swapped, fdata->file_off,
+                    cap_file_provider_get_modified_block(&cf->provider, fdata),
+                    rewrites))
+            break;
+    }
+    ws_close(fd);
+
+    if (framenum <= cf->count) {
+        pcapng_block_rewrites_free(rewrites);
+        return FALSE;
+    }
+    *rewrites_p = rewrites;
+    return TRUE;
+}
+
+/*
+ * Save a pcapng file by copying it, with the blocks in rewrites replaced.
+ */
+static cf_write_status_t
+copy_pcapng_blocks(capture_file *cf, GArray *rewrites, const char *to_filename)
+{
+    cf->stop_flag = FALSE;
+    if (pcapng_copy_with_rewrites(cf->filename, to_filename, rewrites,
+                &cf->stop_flag))
+        return CF_WRITE_OK;
+    return cf->stop_flag ? CF_WRITE_ABORTED : CF_WRITE_ERROR;
+}
+
+/*
+ * We've reopened the file saved by copy_pcapng_blocks(); the re-encoded
+ * blocks now have the changed comments, so they're no longer modified,
+ * and every record after one of them has moved by its change in length.
+ */
+static void
+pcapng_blocks_copied(capture_file *cf, GArray *rewrites)
+{
+    frame_data  *fdata = NULL;
+    guint32      framenum;
+    gint64       delta = 0;
+    guint        i = 0;
+    pcapng_block_rewrite_t *rewrite;
+
+    for (framenum = 1; framenum <= cf->count; framenum++) {
+        fdata = frame_data_sequence_next(cf->provider.frames, fdata);
+        if (i < rewrites->len) {
+            rewrite = &g_array_index(rewrites, pcapng_block_rewrite_t, i);
+            if (rewrite->offset == fdata->file_off) {
+                fdata->file_off += delta;
+                delta += (gint64)rewrite->new_block->len - rewrite->old_len;
+                fdata->has_modified_block = FALSE;
+                i++;
+                continue;
+            }
+        }
+        fdata->file_off += delta;
+    }
+
+    if (cf->provider.frames_modified_blocks) {
+        g_tree_destroy(cf->provider.frames_modified_blocks);
+        cf->provider.frames_modified_blocks = NULL;
+    }
+}
+
 cf_write_status_t
 cf_export_specified_packets(capture_file *cf, const char *fname,
         packet_range_t *range, guint save_format,
@@ -5049,6 +5741,38 @@ cf_export_specified_packets(capture_file *cf, const char *fname,
 
     packet_range_process_init(range);
 
+    if (can_copy_pcap_records(cf, save_format, compression_type)) {
+        /* Copy the records as they are; see above.  As below, do a
+           "safe save" if we're overwriting an existing file. */
+        if (file_exists(fname))
+            fname_new = ws_strdup_printf("%s~", fname);
+        switch (copy_pcap_records(cf, range, fname_new != NULL ? fname_new : fname)) {
+
+            case CF_WRITE_OK:
+                break;
+
+            case CF_WRITE_ABORTED:
+                if (fname_new != NULL) {
+                    ws_unlink(fname_new);
+                    g_free(fname_new);
+                } else {
+                    ws_unlink(fname);
+                }
+                return CF_WRITE_ABORTED;
+
+            default:
+                goto fail;
+        }
+        if (fname_new != NULL) {
+            if (ws_rename(fname_new, fname) == -1) {
+                cf_rename_failure_alert_box(fname, errno);
+                goto fail;
+            }
+            g_free(fname_new);
+        }
+        return CF_WRITE_OK;
+    }
+
     /* We're writing out specified packets from the specified capture
        file to another file.  Even if all captured packets are to be
        written, don't special-case the operation - read each packet
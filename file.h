@@ -181,14 +181,19 @@ gboolean cf_read_current_record(capture_file *cf);
 /**
  * Read packets from the "end" of a capture file.
  *
+ * This stops after a bounded amount of time so that the UI stays
+ * responsive when packets arrive faster than they can be dissected;
+ * the caller should call it again later for the packets that remain.
+ *
  * @param cf the capture file to be read from
- * @param to_read the number of packets to read
+ * @param to_read on entry, the number of packets to read; on return, the
+ *  number that are still to be read
  * @param rec pointer to wtap_rec to use when reading
  * @param buf pointer to Buffer to use when reading
  * @param err the error code, if an error had occurred
  * @return one of cf_read_status_t
  */
-cf_read_status_t cf_continue_tail(capture_file *cf, volatile int to_read,
+cf_read_status_t cf_continue_tail(capture_file *cf, int *to_read,
                                   wtap_rec *rec, Buffer *buf, int *err);
 
 /**
@@ -404,6 +409,15 @@ cf_status_t cf_filter_packets(capture_file *cf, gchar *dfilter, gboolean force);
  */
 void cf_reftime_packets(capture_file *cf);
 
+/**
+ * Recalculate the ref time after the time reference mark of one frame
+ * was set or cleared, updating only the frames that depend on it.
+ *
+ * @param cf the capture file
+ * @param fdata the frame whose time reference mark changed
+ */
+void cf_reftime_packet_toggled(capture_file *cf, frame_data *fdata);
+
 /**
  * Return the time it took to load the file (in msec).
  */
@@ -424,6 +438,17 @@ void cf_redissect_packets(capture_file *cf);
  */
 cf_read_status_t cf_retap_packets(capture_file *cf);
 
+/**
+ * Run the taps over just some of the frames, without resetting the tap
+ * listeners first or telling the UI that a retap has started and
+ * finished.
+ *
+ * @param cf the capture file
+ * @param frames a GArray of the guint32 numbers of the frames, in order
+ * @return one of cf_read_status_t
+ */
+cf_read_status_t cf_retap_frames(capture_file *cf, const GArray *frames);
+
 /* print_range, enum which frames should be printed */
 typedef enum {
     print_range_selected_only,    /* selected frame(s) only (currently only one) */
@@ -611,6 +636,15 @@ gboolean cf_goto_frame(capture_file *cf, guint row);
  */
 gboolean cf_goto_framenum(capture_file *cf);
 
+/**
+ * Go to the first displayed packet at or after the given time.
+ *
+ * @param cf the capture file
+ * @param ts the absolute time to go to
+ * @return TRUE if there is such a packet, FALSE otherwise
+ */
+gboolean cf_goto_time(capture_file *cf, const nstime_t *ts);
+
 /**
  * Select the packet in the given row.
  *
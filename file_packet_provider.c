@@ -24,12 +24,21 @@ frame_cmp(gconstpointer a, gconstpointer b, gpointer user_data _U_)
     0;
 }
 
-const char *
-cap_file_provider_get_interface_name(struct packet_provider_data *prov, guint32 interface_id)
+/*
+ * If the file is being read on another thread, its interface list can
+ * change under us, so use the IDBs that thread has handed over.
+ */
+static wtap_block_t
+cap_file_provider_get_idb(struct packet_provider_data *prov, guint32 interface_id)
 {
   wtapng_iface_descriptions_t *idb_info;
   wtap_block_t wtapng_if_descr = NULL;
-  char* interface_name;
+
+  if (prov->idbs) {
+    if (interface_id < prov->idbs->len)
+      wtapng_if_descr = (wtap_block_t)g_ptr_array_index(prov->idbs, interface_id);
+    return wtapng_if_descr;
+  }
 
   idb_info = wtap_file_get_idb_info(prov->wth);
 
@@ -38,6 +47,17 @@ cap_file_provider_get_interface_name(struct packet_provider_data *prov, guint32
 
   g_free(idb_info);
 
+  return wtapng_if_descr;
+}
+
+const char *
+cap_file_provider_get_interface_name(struct packet_provider_data *prov, guint32 interface_id)
+{
+  wtap_block_t wtapng_if_descr;
+  char* interface_name;
+
+  wtapng_if_descr = cap_file_provider_get_idb(prov, interface_id);
+
   if (wtapng_if_descr) {
     if (wtap_block_get_string_option_value(wtapng_if_descr, OPT_IDB_NAME, &interface_name) == WTAP_OPTTYPE_SUCCESS)
       return interface_name;
@@ -52,16 +72,10 @@ cap_file_provider_get_interface_name(struct packet_provider_data *prov, guint32
 const char *
 cap_file_provider_get_interface_description(struct packet_provider_data *prov, guint32 interface_id)
 {
-  wtapng_iface_descriptions_t *idb_info;
-  wtap_block_t wtapng_if_descr = NULL;
+  wtap_block_t wtapng_if_descr;
   char* interface_name;
 
-  idb_info = wtap_file_get_idb_info(prov->wth);
-
-  if (interface_id < idb_info->interface_data->len)
-    wtapng_if_descr = g_array_index(idb_info->interface_data, wtap_block_t, interface_id);
-
-  g_free(idb_info);
+  wtapng_if_descr = cap_file_provider_get_idb(prov, interface_id);
 
   if (wtapng_if_descr) {
     if (wtap_block_get_string_option_value(wtapng_if_descr, OPT_IDB_DESCRIPTION, &interface_name) == WTAP_OPTTYPE_SUCCESS)
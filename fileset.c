@@ -16,11 +16,13 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include <glib.h>
 
 #include <wsutil/file_util.h>
 #include <wsutil/filesystem.h>
+#include <wsutil/glib-compat.h>
 #include <wsutil/ws_assert.h>
 
 #include <epan/strutil.h>
@@ -39,6 +41,28 @@ typedef struct _fileset {
  */
 static fileset set = { NULL, NULL};
 
+/*
+ * What we know about a file in the file set directory. Ring buffer files
+ * don't change any more once dumpcap has moved on to the next one, so we
+ * only have to look at them once; a capture directory can hold tens of
+ * thousands of them and we rescan it every time a file of the set is
+ * opened.
+ */
+typedef struct _fileset_stat {
+    time_t   ctime;          /* create time */
+    time_t   mtime;          /* last modified time */
+    gint64   size;           /* size of file in bytes */
+    gboolean closed;         /* a newer file of the set existed when we looked */
+} fileset_stat;
+
+/*
+ * The files we saw in the last scan, by name. It survives fileset_delete(),
+ * as the dialog deletes the set before each rescan, and only holds the
+ * files of the last scan, so removed files drop out.
+ */
+static char       *stat_cache_dirname = NULL;
+static GHashTable *stat_cache = NULL;
+
 /*
  * Given a stat structure, get the creation time of the file if available,
  * or 0 if not.
@@ -158,6 +182,66 @@ fileset_is_file_in_set(const char *fname1, const char *fname2)
     return TRUE;
 }
 
+/*
+ * Get the start time of a file set file from its name; the caller must
+ * have checked that the name matches the pattern.
+ * d:\dir1\test_00001_20050418010750.cap
+ */
+static time_t
+fileset_time_from_name(const char *fname)
+{
+    const char  *basename = get_basename(fname);
+    const char  *pfx;
+    const char  *digits;
+    struct tm    tm;
+    time_t       t;
+
+    pfx = strrchr(basename, '.');
+    if(pfx == NULL) {  /* suffix is optional */
+        pfx = basename + strlen(basename);
+    }
+    /* 20050418010750 */
+    digits = pfx - strlen("20050418010750");
+
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year  = (digits[0] - '0') * 1000 + (digits[1] - '0') * 100 +
+                  (digits[2] - '0') * 10 + (digits[3] - '0') - 1900;
+    tm.tm_mon   = (digits[4] - '0') * 10 + (digits[5] - '0') - 1;
+    tm.tm_mday  = (digits[6] - '0') * 10 + (digits[7] - '0');
+    tm.tm_hour  = (digits[8] - '0') * 10 + (digits[9] - '0');
+    tm.tm_min   = (digits[10] - '0') * 10 + (digits[11] - '0');
+    tm.tm_sec   = (digits[12] - '0') * 10 + (digits[13] - '0');
+    /* dumpcap names the files in local time */
+    tm.tm_isdst = -1;
+
+    t = mktime(&tm);
+    return t == (time_t) -1 ? 0 : t;
+}
+
+/*
+ * Get the times and size of a file. For members of a file set, the create
+ * time is the start time from the file name.
+ */
+static gboolean
+fileset_stat_file(const char *path, fileset_stat *st)
+{
+    ws_statb64 buf;
+
+    if(ws_stat64(path, &buf) != 0) {
+        return FALSE;
+    }
+
+    if(fileset_filename_match_pattern(path)) {
+        st->ctime = fileset_time_from_name(path);
+    } else {
+        st->ctime = ST_CREATE_TIME(buf);
+    }
+    st->mtime   = buf.st_mtime;
+    st->size    = buf.st_size;
+    st->closed  = FALSE;
+    return TRUE;
+}
+
 /* GCompareFunc helper for g_list_find_custom() */
 static gint
 fileset_find_by_path(gconstpointer a, gconstpointer b)
@@ -175,67 +259,68 @@ fileset_find_by_path(gconstpointer a, gconstpointer b)
 void
 fileset_update_file(const char *path)
 {
-    int fh, result;
-    ws_statb64 buf;
+    fileset_stat st;
+    fileset_stat *cached;
     fileset_entry *entry = NULL;
     GList *entry_list;
 
-    fh = ws_open( path, O_RDONLY, 0000 /* no creation so don't matter */);
-    if(fh !=  -1) {
-
-        /* Get statistics */
-        result = ws_fstat64( fh, &buf );
-
-        /* Show statistics if they are valid */
-        if( result == 0 ) {
-            entry_list = g_list_find_custom(set.entries, path,
-                                            fileset_find_by_path);
-
-            if (entry_list) {
-                entry = (fileset_entry *) entry_list->data;
-                entry->ctime    = ST_CREATE_TIME(buf);
-                entry->mtime    = buf.st_mtime;
-                entry->size     = buf.st_size;
+    if(fileset_stat_file(path, &st)) {
+        entry_list = g_list_find_custom(set.entries, path,
+                                        fileset_find_by_path);
+
+        if (entry_list) {
+            entry = (fileset_entry *) entry_list->data;
+            entry->ctime    = st.ctime;
+            entry->mtime    = st.mtime;
+            entry->size     = st.size;
+
+            /* it's still being written to, look at it again next time */
+            if(stat_cache) {
+                cached = (fileset_stat *) g_hash_table_lookup(stat_cache, entry->name);
+                if(cached) {
+                    *cached = st;
+                }
             }
         }
-
-        ws_close(fh);
     }
 }
 
 /* we know this file is part of the set, so add it */
+/* (the entries are prepended, the caller has to sort the list afterwards) */
 static fileset_entry *
-fileset_add_file(const char *dirname, const char *fname, gboolean current)
+fileset_add_file(const char *dirname, const char *fname, gboolean current,
+                 GHashTable *prev_cache)
 {
-    int fh, result;
-    ws_statb64 buf;
     char *path;
+    fileset_stat st;
+    fileset_stat *cached = NULL;
     fileset_entry *entry = NULL;
 
 
     path = ws_strdup_printf("%s%s", dirname, fname);
 
-    fh = ws_open( path, O_RDONLY, 0000 /* no creation so don't matter */);
-    if(fh !=  -1) {
+    if(prev_cache) {
+        cached = (fileset_stat *) g_hash_table_lookup(prev_cache, fname);
+    }
 
-        /* Get statistics */
-        result = ws_fstat64( fh, &buf );
+    /* only look at the file if it might have changed since the last scan */
+    if((cached && cached->closed) || fileset_stat_file(path, &st)) {
+        if(cached && cached->closed) {
+            st = *cached;
+        }
 
-        /* Show statistics if they are valid */
-        if( result == 0 ) {
-            entry = g_new(fileset_entry, 1);
+        entry = g_new(fileset_entry, 1);
 
-            entry->fullname = g_strdup(path);
-            entry->name     = g_strdup(fname);
-            entry->ctime    = ST_CREATE_TIME(buf);
-            entry->mtime    = buf.st_mtime;
-            entry->size     = buf.st_size;
-            entry->current  = current;
+        entry->fullname = g_strdup(path);
+        entry->name     = g_strdup(fname);
+        entry->ctime    = st.ctime;
+        entry->mtime    = st.mtime;
+        entry->size     = st.size;
+        entry->current  = current;
 
-            set.entries = g_list_append(set.entries, entry);
-        }
+        set.entries = g_list_prepend(set.entries, entry);
 
-        ws_close(fh);
+        g_hash_table_insert(stat_cache, g_strdup(fname), g_memdup2(&st, sizeof(st)));
     }
 
     g_free(path);
@@ -280,6 +365,9 @@ fileset_add_dir(const char *fname, void *window)
     const char    *name;
     GString       *dirname;
     gchar         *fname_dup;
+    GHashTable    *prev_cache;
+    GList         *le;
+    fileset_stat  *cached;
 
 
     /* get (convert) directory name, but don't touch the given string */
@@ -291,6 +379,16 @@ fileset_add_dir(const char *fname, void *window)
 
     dirname = g_string_append_c(dirname, G_DIR_SEPARATOR);
 
+    /* start a new cache, taking over what we knew about this directory */
+    prev_cache = stat_cache;
+    if(prev_cache && g_strcmp0(stat_cache_dirname, dirname->str) != 0) {
+        g_hash_table_destroy(prev_cache);
+        prev_cache = NULL;
+    }
+    g_free(stat_cache_dirname);
+    stat_cache_dirname = g_strdup(dirname->str);
+    stat_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
     /* is the current file probably a part of any fileset? */
     if(fileset_filename_match_pattern(fname)) {
         /* yes, go through the files in the directory and check if the file in question is part of the current file set */
@@ -298,7 +396,7 @@ fileset_add_dir(const char *fname, void *window)
             while ((file = ws_dir_read_name(dir)) != NULL) {
                 name = ws_dir_get_name(file);
                 if(fileset_filename_match_pattern(name) && fileset_is_file_in_set(name, get_basename(fname))) {
-                    fileset_add_file(dirname->str, name, strcmp(name, get_basename(fname))== 0 /* current */);
+                    fileset_add_file(dirname->str, name, strcmp(name, get_basename(fname))== 0 /* current */, prev_cache);
                 }
             } /* while */
 
@@ -306,15 +404,28 @@ fileset_add_dir(const char *fname, void *window)
         } /* if */
     } else {
         /* no, this is a "standalone file", just add this one */
-        fileset_add_file(dirname->str, get_basename(fname), TRUE /* current */);
+        fileset_add_file(dirname->str, get_basename(fname), TRUE /* current */, prev_cache);
         /* don't add the file to the dialog here, this will be done in fileset_update_dlg() below */
     }
 
     g_string_free(dirname, TRUE /* free_segment */);
+    if(prev_cache) {
+        g_hash_table_destroy(prev_cache);
+    }
 
     /* sort entries by creation time */
     set.entries = g_list_sort(set.entries, fileset_sort_compare);
 
+    /* every file but the last one of a set is done */
+    if(fileset_filename_match_pattern(fname)) {
+        for(le = g_list_first(set.entries); le && le->next; le = le->next) {
+            cached = (fileset_stat *) g_hash_table_lookup(stat_cache, ((fileset_entry *)le->data)->name);
+            if(cached) {
+                cached->closed = TRUE;
+            }
+        }
+    }
+
     fileset_update_dlg(window);
 }
 
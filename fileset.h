@@ -19,7 +19,7 @@ extern "C" {
 typedef struct _fileset_entry {
     char     *fullname;      /* File name with path (g_strdup'ed) */
     char     *name;          /* File name without path (g_strdup'ed) */
-    time_t   ctime;          /* create time */
+    time_t   ctime;          /* create time (start time from the name for file set files) */
     time_t   mtime;          /* last modified time */
     gint64   size;           /* size of file in bytes */
     gboolean current;        /* is this the currently loaded file? */
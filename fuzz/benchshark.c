@@ -0,0 +1,529 @@
+/* benchshark.c
+ *
+ * Dissection throughput benchmark, derived from fuzzshark
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Reads each capture file into memory, then dissects its packets in one or
+ * more modes and writes a line of JSON for each file and mode, giving the
+ * time taken per packet and the number of allocations per packet.  The
+ * input is read before the clock starts, so only dissection is measured.
+ *
+ * The modes are:
+ *
+ *   tree       build a visible protocol tree, as for "tshark -V"
+ *   fake-tree  build a protocol tree that isn't visible, as for taps
+ *   columns    build no tree, just fill in the columns, as for "tshark"
+ *   filtered   build a fake tree primed with a display filter and apply it
+ *
+ * Allocations are counted by wrapping malloc(), calloc() and realloc(),
+ * which we can only do with the GNU C library.  Most wmem allocations are
+ * made from blocks the allocator already has; set
+ * WIRESHARK_DEBUG_WMEM_OVERRIDE=simple to count every one of them.
+ */
+
+#include <config.h>
+#define WS_LOG_DOMAIN  LOG_DOMAIN_MAIN
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/epan.h>
+
+#include <ui/clopts_common.h>
+#include <ui/cmdarg_err.h>
+#include <ui/failure_message.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/json_dumper.h>
+#include <wsutil/privileges.h>
+#include <wsutil/report_message.h>
+#include <wsutil/wslog.h>
+#include <wsutil/ws_getopt.h>
+#include <ui/version_info.h>
+
+#include <wiretap/wtap.h>
+
+#include <epan/timestamp.h>
+#include <epan/prefs.h>
+#include <epan/column.h>
+#include <epan/column-info.h>
+#include <epan/epan_dissect.h>
+#include <epan/dfilter/dfilter.h>
+
+#define EPAN_INIT_FAIL 2
+
+#if defined(__has_feature)
+# if __has_feature(address_sanitizer)
+#  define BENCH_HAVE_ASAN
+# endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+# define BENCH_HAVE_ASAN
+#endif
+
+#if defined(__GLIBC__) && !defined(BENCH_HAVE_ASAN)
+#define BENCH_COUNT_ALLOCS
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static guint64 alloc_count;
+
+void *
+malloc(size_t size)
+{
+	alloc_count++;
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+	alloc_count++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	alloc_count++;
+	return __libc_realloc(ptr, size);
+}
+#endif
+
+typedef enum {
+	BENCH_TREE,
+	BENCH_FAKE_TREE,
+	BENCH_COLUMNS,
+	BENCH_FILTERED,
+	BENCH_NUM_MODES
+} bench_mode_e;
+
+static const char *bench_mode_names[BENCH_NUM_MODES] = {
+	"tree",
+	"fake-tree",
+	"columns",
+	"filtered"
+};
+
+/* A packet read from the file, kept in memory for dissection. */
+typedef struct {
+	guint32 presence_flags;
+	nstime_t ts;
+	int tsprec;
+	wtap_packet_header packet_header;
+	guint8 *data;
+} bench_packet_t;
+
+static column_info bench_cinfo;
+static dfilter_t *bench_dfcode;
+
+/*
+ * Report an error in command-line arguments.
+ */
+static void
+benchshark_cmdarg_err(const char *msg_format, va_list ap)
+{
+	fprintf(stderr, "benchshark: ");
+	vfprintf(stderr, msg_format, ap);
+	fprintf(stderr, "\n");
+}
+
+/*
+ * Report additional information for an error in command-line arguments.
+ */
+static void
+benchshark_cmdarg_err_cont(const char *msg_format, va_list ap)
+{
+	vfprintf(stderr, msg_format, ap);
+	fprintf(stderr, "\n");
+}
+
+static void
+print_usage(FILE *output)
+{
+	fprintf(output, "\n");
+	fprintf(output, "Usage: benchshark [options] <infile> ...\n");
+	fprintf(output, "\n");
+	fprintf(output, "  -m <mode>      tree, fake-tree, columns or filtered; may be given more\n");
+	fprintf(output, "                 than once (default: all of them)\n");
+	fprintf(output, "  -Y <filter>    display filter for the filtered mode (default: \"tcp or udp\")\n");
+	fprintf(output, "  -n <count>     dissect each file <count> times (default: 1)\n");
+	fprintf(output, "  -h             display this help and exit\n");
+	fprintf(output, "\n");
+	fprintf(output, "A line of JSON is written for each file and mode.\n");
+}
+
+static const nstime_t *
+benchshark_get_frame_ts(struct packet_provider_data *prov _U_, guint32 frame_num _U_)
+{
+	static nstime_t empty;
+
+	return &empty;
+}
+
+static epan_t *
+benchshark_epan_new(void)
+{
+	static const struct packet_provider_funcs funcs = {
+		benchshark_get_frame_ts,
+		NULL,
+		NULL,
+		NULL
+	};
+
+	return epan_new(NULL, &funcs);
+}
+
+/*
+ * Read all the packets in a file.  Returns NULL, having reported the
+ * error, on failure.
+ */
+static GArray *
+read_packets(const char *filename, int *file_type_subtype)
+{
+	wtap *wth;
+	wtap_rec rec;
+	Buffer buf;
+	int err;
+	gchar *err_info = NULL;
+	gint64 data_offset;
+	GArray *packets;
+	bench_packet_t packet;
+
+	wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+	if (wth == NULL) {
+		cfile_open_failure_message(filename, err, err_info);
+		return NULL;
+	}
+	*file_type_subtype = wtap_file_type_subtype(wth);
+
+	packets = g_array_new(FALSE, FALSE, sizeof(bench_packet_t));
+	wtap_rec_init(&rec);
+	ws_buffer_init(&buf, 1514);
+	while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+		if (rec.rec_type == REC_TYPE_PACKET) {
+			packet.presence_flags = rec.presence_flags;
+			packet.ts = rec.ts;
+			packet.tsprec = rec.tsprec;
+			packet.packet_header = rec.rec_header.packet_header;
+			packet.data = (guint8 *)g_memdup2(ws_buffer_start_ptr(&buf),
+			    rec.rec_header.packet_header.caplen);
+			g_array_append_val(packets, packet);
+		}
+		wtap_rec_reset(&rec);
+	}
+	wtap_rec_cleanup(&rec);
+	ws_buffer_free(&buf);
+	wtap_close(wth);
+
+	if (err != 0) {
+		cfile_read_failure_message(filename, err, err_info);
+		for (guint i = 0; i < packets->len; i++)
+			g_free(g_array_index(packets, bench_packet_t, i).data);
+		g_array_free(packets, TRUE);
+		return NULL;
+	}
+	return packets;
+}
+
+/*
+ * Dissect all the packets once in the given mode.  Returns the number of
+ * packets that passed the filter, in the filtered mode.
+ */
+static guint32
+dissect_packets(GArray *packets, int file_type_subtype, bench_mode_e mode)
+{
+	epan_t *epan;
+	epan_dissect_t *edt;
+	wtap_rec rec;
+	frame_data fdata;
+	frame_data ref_frame;
+	frame_data prev_dis_frame;
+	const frame_data *ref = NULL;
+	const frame_data *prev_dis = NULL;
+	nstime_t elapsed_time;
+	guint32 cum_bytes = 0;
+	guint32 passed = 0;
+	guint i;
+
+	epan = benchshark_epan_new();
+	edt = epan_dissect_new(epan, mode != BENCH_COLUMNS, mode == BENCH_TREE);
+	nstime_set_zero(&elapsed_time);
+
+	for (i = 0; i < packets->len; i++) {
+		bench_packet_t *packet = &g_array_index(packets, bench_packet_t, i);
+		guint32 caplen = packet->packet_header.caplen;
+
+		memset(&rec, 0, sizeof(rec));
+		rec.rec_type = REC_TYPE_PACKET;
+		rec.presence_flags = packet->presence_flags;
+		rec.ts = packet->ts;
+		rec.tsprec = packet->tsprec;
+		rec.rec_header.packet_header = packet->packet_header;
+
+		frame_data_init(&fdata, i + 1, &rec, 0, cum_bytes);
+		frame_data_set_before_dissect(&fdata, &elapsed_time, &ref, prev_dis);
+		if (ref == &fdata) {
+			ref_frame = fdata;
+			ref = &ref_frame;
+		}
+
+		if (mode == BENCH_FILTERED)
+			epan_dissect_prime_with_dfilter(edt, bench_dfcode);
+
+		epan_dissect_run(edt, file_type_subtype, &rec,
+		    tvb_new_real_data(packet->data, caplen, caplen), &fdata,
+		    mode == BENCH_COLUMNS ? &bench_cinfo : NULL);
+
+		if (mode == BENCH_COLUMNS)
+			epan_dissect_fill_in_columns(edt, FALSE, TRUE);
+		else if (mode == BENCH_FILTERED && dfilter_apply_edt(bench_dfcode, edt))
+			passed++;
+
+		frame_data_set_after_dissect(&fdata, &cum_bytes);
+		prev_dis_frame = fdata;
+		prev_dis = &prev_dis_frame;
+
+		epan_dissect_reset(edt);
+		frame_data_destroy(&fdata);
+	}
+
+	epan_dissect_free(edt);
+	epan_free(epan);
+
+	return passed;
+}
+
+static void
+run_benchmark(const char *filename, GArray *packets, int file_type_subtype,
+    bench_mode_e mode, guint32 iterations)
+{
+	json_dumper dumper = {
+		.output_file = stdout,
+	};
+	gint64 start_time;
+	gint64 elapsed_us;
+	guint64 total_packets;
+	guint32 passed = 0;
+	guint32 i;
+#ifdef BENCH_COUNT_ALLOCS
+	guint64 start_allocs;
+	guint64 allocs;
+#endif
+
+#ifdef BENCH_COUNT_ALLOCS
+	start_allocs = alloc_count;
+#endif
+	start_time = g_get_monotonic_time();
+	for (i = 0; i < iterations; i++)
+		passed = dissect_packets(packets, file_type_subtype, mode);
+	elapsed_us = g_get_monotonic_time() - start_time;
+#ifdef BENCH_COUNT_ALLOCS
+	allocs = alloc_count - start_allocs;
+#endif
+
+	total_packets = (guint64)packets->len * iterations;
+
+	json_dumper_begin_object(&dumper);
+	json_dumper_set_member_name(&dumper, "file");
+	json_dumper_value_string(&dumper, filename);
+	json_dumper_set_member_name(&dumper, "mode");
+	json_dumper_value_string(&dumper, bench_mode_names[mode]);
+	json_dumper_set_member_name(&dumper, "packets");
+	json_dumper_value_uint64(&dumper, packets->len);
+	json_dumper_set_member_name(&dumper, "iterations");
+	json_dumper_value_uint64(&dumper, iterations);
+	if (mode == BENCH_FILTERED) {
+		json_dumper_set_member_name(&dumper, "passed");
+		json_dumper_value_uint64(&dumper, passed);
+	}
+	json_dumper_set_member_name(&dumper, "seconds");
+	json_dumper_value_double(&dumper, elapsed_us / 1e6);
+	json_dumper_set_member_name(&dumper, "packets_per_second");
+	json_dumper_value_double(&dumper, elapsed_us > 0 ? total_packets * 1e6 / elapsed_us : 0.0);
+	json_dumper_set_member_name(&dumper, "ns_per_packet");
+	json_dumper_value_double(&dumper, total_packets > 0 ? elapsed_us * 1e3 / total_packets : 0.0);
+	json_dumper_set_member_name(&dumper, "allocs_per_packet");
+#ifdef BENCH_COUNT_ALLOCS
+	json_dumper_value_double(&dumper, total_packets > 0 ? (double)allocs / total_packets : 0.0);
+#else
+	json_dumper_value_anyf(&dumper, "null");
+#endif
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
+	fflush(stdout);
+}
+
+int
+main(int argc, char *argv[])
+{
+	char *configuration_init_error;
+	static const struct report_message_routines benchshark_report_routines = {
+		failure_message,
+		failure_message,
+		open_failure_message,
+		read_failure_message,
+		write_failure_message,
+		cfile_open_failure_message,
+		cfile_dump_open_failure_message,
+		cfile_read_failure_message,
+		cfile_write_failure_message,
+		cfile_close_failure_message
+	};
+	static const struct ws_option long_options[] = {
+		{"help", ws_no_argument, NULL, 'h'},
+		{0, 0, 0, 0 }
+	};
+	gboolean modes[BENCH_NUM_MODES] = { FALSE };
+	gboolean any_mode = FALSE;
+	const char *filter = "tcp or udp";
+	guint32 iterations = 1;
+	char *err_msg = NULL;
+	e_prefs *prefs_p;
+	GArray *packets;
+	int file_type_subtype;
+	int opt;
+	int i;
+	int ret = EXIT_SUCCESS;
+
+	cmdarg_err_init(benchshark_cmdarg_err, benchshark_cmdarg_err_cont);
+
+	/* Initialize log handler early so we can have proper logging during startup. */
+	ws_log_init("benchshark", vcmdarg_err);
+
+	/* Early logging command-line initialization. */
+	ws_log_parse_args(&argc, argv, vcmdarg_err, 1);
+
+	while ((opt = ws_getopt_long(argc, argv, "hm:n:Y:", long_options, NULL)) != -1) {
+		switch (opt) {
+		case 'h':
+			print_usage(stdout);
+			return EXIT_SUCCESS;
+		case 'm':
+			for (i = 0; i < BENCH_NUM_MODES; i++) {
+				if (strcmp(ws_optarg, bench_mode_names[i]) == 0)
+					break;
+			}
+			if (i == BENCH_NUM_MODES) {
+				cmdarg_err("\"%s\" isn't a valid mode", ws_optarg);
+				return 1;
+			}
+			modes[i] = TRUE;
+			any_mode = TRUE;
+			break;
+		case 'n':
+			iterations = get_nonzero_guint32(ws_optarg, "number of iterations");
+			break;
+		case 'Y':
+			filter = ws_optarg;
+			break;
+		default:
+			print_usage(stderr);
+			return 1;
+		}
+	}
+	if (ws_optind >= argc) {
+		print_usage(stderr);
+		return 1;
+	}
+	if (!any_mode) {
+		for (i = 0; i < BENCH_NUM_MODES; i++)
+			modes[i] = TRUE;
+	}
+
+	/*
+	 * Get credential information for later use, and drop privileges
+	 * before doing anything else.
+	 */
+	init_process_policies();
+	relinquish_special_privs_perm();
+
+	configuration_init_error = configuration_init(argv[0], NULL);
+	if (configuration_init_error != NULL) {
+		fprintf(stderr, "benchshark: Can't get pathname of benchshark program: %s.\n", configuration_init_error);
+		g_free(configuration_init_error);
+	}
+
+	/* Initialize the version information. */
+	ws_init_version_info("Benchshark",
+	    epan_gather_compile_info, epan_gather_runtime_info);
+
+	init_report_message("benchshark", &benchshark_report_routines);
+
+	timestamp_set_type(TS_RELATIVE);
+	timestamp_set_precision(TS_PREC_AUTO);
+	timestamp_set_seconds_type(TS_SECONDS_DEFAULT);
+
+	/*
+	 * Libwiretap must be initialized before libwireshark is, so that
+	 * dissection-time handlers for file-type-dependent blocks can
+	 * register using the file type/subtype value for the file type.
+	 */
+	wtap_init(TRUE);
+
+	if (!epan_init(NULL, NULL, TRUE)) {
+		ret = EPAN_INIT_FAIL;
+		goto clean_exit;
+	}
+
+	/* Load libwireshark settings from the current profile. */
+	prefs_p = epan_load_settings();
+	prefs_apply_all();
+
+	/* Build the column format array */
+	build_column_format_array(&bench_cinfo, prefs_p->num_cols, TRUE);
+
+	if (modes[BENCH_FILTERED] && !dfilter_compile(filter, &bench_dfcode, &err_msg)) {
+		cmdarg_err("%s", err_msg);
+		g_free(err_msg);
+		ret = 1;
+		goto clean_exit;
+	}
+
+	for (i = ws_optind; i < argc; i++) {
+		packets = read_packets(argv[i], &file_type_subtype);
+		if (packets == NULL) {
+			ret = 2;
+			continue;
+		}
+		for (int mode = 0; mode < BENCH_NUM_MODES; mode++) {
+			if (modes[mode])
+				run_benchmark(argv[i], packets, file_type_subtype, (bench_mode_e)mode, iterations);
+		}
+		for (guint j = 0; j < packets->len; j++)
+			g_free(g_array_index(packets, bench_packet_t, j).data);
+		g_array_free(packets, TRUE);
+	}
+
+	dfilter_free(bench_dfcode);
+	col_cleanup(&bench_cinfo);
+	epan_cleanup();
+clean_exit:
+	wtap_cleanup();
+	free_progdirs();
+	return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -31,6 +31,7 @@
 #include <epan/packet.h>
 #include <epan/proto.h>
 #include <epan/proto_data.h>
+#include <epan/prefs.h>
 #include <epan/conversation.h>
 #include <epan/conversation_filter.h>
 #include <epan/tap.h>
@@ -64,6 +65,7 @@ typedef struct bridge_info {
     uint32_t visible_fields;
     uint32_t* field_flags;
     int* field_ids;
+    wmem_map_t *extract_cache; // Frame number -> sinsp_field_extract_t array
 } bridge_info;
 
 typedef struct conv_fld_info {
@@ -78,6 +80,8 @@ static gint ett_sinsp_span = -1;
 static gint ett_address = -1;
 static dissector_table_t ptype_dissector_table;
 
+static gboolean pref_cache_extracted_fields = TRUE;
+
 static int dissect_falco_bridge(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data);
 static int dissect_sinsp_span(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data _U_);
 
@@ -339,6 +343,8 @@ import_plugin(char* fname)
     static dissector_handle_t ct_handle;
     ct_handle = create_dissector_handle(dissect_sinsp_span, bi->proto);
     dissector_add_uint("falcobridge.id", bi->source_id, ct_handle);
+
+    bi->extract_cache = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -419,6 +425,14 @@ proto_register_falcoplugin(void)
     proto_register_field_array(proto_falco_bridge, hf, array_length(hf));
     proto_register_subtree_array(ett, array_length(ett));
 
+    module_t *falco_bridge_module = prefs_register_protocol(proto_falco_bridge, NULL);
+    prefs_register_bool_preference(falco_bridge_module, "cache_extracted_fields",
+        "Cache extracted fields",
+        "Keep the field values extracted by each Falco plugin so that redissecting an event,"
+        " e.g. when a display filter is applied, doesn't extract its fields again."
+        " This uses more memory.",
+        &pref_cache_extracted_fields);
+
     register_shutdown_routine(on_wireshark_exit);
 }
 
@@ -494,18 +508,35 @@ dissect_sinsp_span(tvbuff_t* tvb, packet_info* pinfo, proto_tree* tree, void* da
 
     guint8* payload = (guint8*)tvb_get_ptr(tvb, 0, plen);
 
-    sinsp_field_extract_t *sinsp_fields = (sinsp_field_extract_t*) wmem_alloc(pinfo->pool, sizeof(sinsp_field_extract_t) * bi->visible_fields);
-    for (uint32_t fld_idx = 0; fld_idx < bi->visible_fields; fld_idx++) {
-        header_field_info* hfinfo = &(bi->hf[fld_idx].hfinfo);
-        sinsp_field_extract_t *sfe = &sinsp_fields[fld_idx];
+    sinsp_field_extract_t *sinsp_fields = NULL;
+    bool rc = true;
 
-        sfe->field_id = bi->field_ids[fld_idx];
-        sfe->field_name = hfinfo->abbrev;
-        sfe->type = hfinfo->type == FT_STRINGZ ? SFT_STRINGZ : SFT_UINT64;
+    if (pref_cache_extracted_fields) {
+        sinsp_fields = (sinsp_field_extract_t*) wmem_map_lookup(bi->extract_cache, GUINT_TO_POINTER(pinfo->num));
     }
 
-    // If we have a failure, try to dissect what we can first, then bail out with an error.
-    bool rc = extract_sisnp_source_fields(bi->ssi, pinfo->num, payload, plen, pinfo->pool, sinsp_fields, bi->visible_fields);
+    if (!sinsp_fields) {
+        // Cached values, including strings, must last as long as the capture file.
+        wmem_allocator_t *extract_pool = pref_cache_extracted_fields ? wmem_file_scope() : pinfo->pool;
+
+        sinsp_fields = (sinsp_field_extract_t*) wmem_alloc(extract_pool, sizeof(sinsp_field_extract_t) * bi->visible_fields);
+        for (uint32_t fld_idx = 0; fld_idx < bi->visible_fields; fld_idx++) {
+            header_field_info* hfinfo = &(bi->hf[fld_idx].hfinfo);
+            sinsp_field_extract_t *sfe = &sinsp_fields[fld_idx];
+
+            sfe->field_id = bi->field_ids[fld_idx];
+            sfe->field_name = hfinfo->abbrev;
+            sfe->type = hfinfo->type == FT_STRINGZ ? SFT_STRINGZ : SFT_UINT64;
+        }
+
+        // If we have a failure, try to dissect what we can first, then bail out with an error.
+        rc = extract_sisnp_source_fields(bi->ssi, pinfo->num, payload, plen, extract_pool, sinsp_fields, bi->visible_fields);
+
+        // Failures aren't cached so that they are reported each time.
+        if (pref_cache_extracted_fields && rc) {
+            wmem_map_insert(bi->extract_cache, GUINT_TO_POINTER(pinfo->num), sinsp_fields);
+        }
+    }
 
     for (uint32_t fld_idx = 0; fld_idx < bi->visible_fields; fld_idx++) {
         sinsp_field_extract_t *sfe = &sinsp_fields[fld_idx];
@@ -140,8 +140,9 @@ typedef struct _mate_cfg_gop {
 	gint ett_times;
 	gint ett_children;
 
-	GHashTable* gop_index;
-	GHashTable* gog_index;
+	GHashTable* gop_index; /* AVPL_key -> mate_gop */
+	GHashTable* gog_index; /* AVPL_key -> mate_gog */
+	GQueue released_gops; /* released gops waiting to expire, oldest first */
 } mate_cfg_gop;
 
 
@@ -288,7 +289,7 @@ struct _mate_gop {
 	guint32 id;
 	mate_cfg_gop* cfg;
 
-	gchar* gop_key;
+	AVPL_key* gop_key;
 	AVPL* avpl; /* the attributes of the pdu/gop/gog */
 	guint last_n;
 
@@ -31,7 +31,7 @@ typedef struct _tmp_pdu_data {
 
 
 typedef struct _gogkey {
-	gchar* key;
+	AVPL_key* key;
 	mate_cfg_gop* cfg;
 } gogkey;
 
@@ -63,7 +63,7 @@ static gboolean destroy_mate_gops(gpointer k _U_, gpointer v, gpointer p _U_) {
 			g_hash_table_remove(gop->cfg->gop_index,gop->gop_key);
 		}
 
-		g_free(gop->gop_key);
+		delete_avpl_key(gop->gop_key);
 	}
 
 	g_slice_free(mate_max_size,(mate_max_size*)gop);
@@ -105,11 +105,13 @@ static void destroy_gops_in_cfg(gpointer k _U_, gpointer v, gpointer p _U_) {
 
 	g_hash_table_foreach_remove(c->gop_index,return_true,NULL);
 	g_hash_table_destroy(c->gop_index);
-	c->gop_index = g_hash_table_new(g_str_hash,g_str_equal);
+	c->gop_index = g_hash_table_new(avpl_key_hash,avpl_key_equal);
 
 	g_hash_table_foreach_remove(c->gog_index,return_true,NULL);
 	g_hash_table_destroy(c->gog_index);
-	c->gog_index = g_hash_table_new(g_str_hash,g_str_equal);
+	c->gog_index = g_hash_table_new(avpl_key_hash,avpl_key_equal);
+
+	g_queue_clear(&c->released_gops);
 
 	g_hash_table_foreach_remove(c->items,destroy_mate_gops,NULL);
 	c->last_id = 0;
@@ -159,13 +161,21 @@ void initialize_mate_runtime(mate_config* mc) {
 }
 
 
-static mate_gop* new_gop(mate_cfg_gop* cfg, mate_pdu* pdu, gchar* key) {
+static mate_gop* new_gop(mate_cfg_gop* cfg, mate_pdu* pdu, AVPL_key* key) {
 	mate_gop* gop = (mate_gop*)g_slice_new(mate_max_size);
+	gchar* s;
 
 	gop->id = ++(cfg->last_id);
 	gop->cfg = cfg;
 
-	dbg_print(dbg_gop, 1, dbg_facility, "new_gop: %s: ``%s:%d''", key, gop->cfg->name, gop->id);
+	if (*dbg_gop > 0) {
+		s = avpl_key_to_str(key);
+		dbg_print(dbg_gop, 1, dbg_facility, "new_gop: %s: ``%s:%d''", s, gop->cfg->name, gop->id);
+		g_free(s);
+	}
+
+	/* the key outlives the avpl it was made from */
+	avpl_key_subscribe(key);
 
 	gop->gop_key = key;
 	gop->avpl = new_avpl(cfg->name);
@@ -174,7 +184,7 @@ static mate_gop* new_gop(mate_cfg_gop* cfg, mate_pdu* pdu, gchar* key) {
 	gop->gog = NULL;
 	gop->next = NULL;
 
-	gop->expiration = cfg->expiration > 0.0 ? cfg->expiration + rd->now : (float) -1.0 ;
+	gop->expiration = (float) -1.0 ;
 	gop->idle_expiration = cfg->idle_timeout > 0.0 ? cfg->idle_timeout + rd->now : (float) -1.0 ;
 	gop->time_to_die = cfg->lifetime > 0.0 ? cfg->lifetime + rd->now : (float) -1.0 ;
 	gop->time_to_timeout = 0.0f;
@@ -199,6 +209,38 @@ static mate_gop* new_gop(mate_cfg_gop* cfg, mate_pdu* pdu, gchar* key) {
 	return gop;
 }
 
+/* releases a gop, if its type has an Expiration it is queued to be dropped
+   from the gop index once that time has passed since its release */
+static void release_gop(mate_gop* gop) {
+	gop->released = TRUE;
+
+	if (gop->gog && gop->cfg->start) gop->gog->num_of_released_gops++;
+
+	if (gop->cfg->expiration > 0.0) {
+		gop->expiration = gop->cfg->expiration + rd->now;
+		g_queue_push_tail(&gop->cfg->released_gops,gop);
+	}
+}
+
+/* drops from the index the released gops whose expiration has passed, so that
+   the index only holds the gops that pdus can still be assigned to. Every gop
+   of a type expires the same time after its release, so the queue is sorted. */
+static void expire_gops(mate_cfg_gop* cfg) {
+	mate_gop* gop;
+
+	while (( gop = (mate_gop*)g_queue_peek_head(&cfg->released_gops) )) {
+		if (gop->expiration >= rd->now) break;
+
+		g_queue_pop_head(&cfg->released_gops);
+
+		dbg_print (dbg_gop,2,dbg_facility,"expire_gops: expiring gop %s:%d",cfg->name,gop->id);
+
+		if (gop->gop_key && g_hash_table_lookup(cfg->gop_index,gop->gop_key) == gop) {
+			g_hash_table_remove(cfg->gop_index,gop->gop_key);
+		}
+	}
+}
+
 static void adopt_gop(mate_gog* gog, mate_gop* gop) {
 	dbg_print (dbg_gog,5,dbg_facility,"adopt_gop: gog=%p gop=%p",(void*)gog,(void*)gop);
 
@@ -285,7 +327,7 @@ static void gog_remove_keys (mate_gog* gog) {
 			g_hash_table_remove(gog_key->cfg->gog_index,gog_key->key);
 		}
 
-		g_free(gog_key->key);
+		delete_avpl_key(gog_key->key);
 		g_free(gog_key);
 	}
 
@@ -299,6 +341,7 @@ static void reanalyze_gop(mate_config* mc, mate_gop* gop) {
 	AVPL* gogkey_match = NULL;
 	mate_gog* gog = gop->gog;
 	gogkey* gog_key;
+	gchar* s;
 
 	if ( ! gog ) return;
 
@@ -327,23 +370,30 @@ static void reanalyze_gop(mate_config* mc, mate_gop* gop) {
 
 				gog_key = g_new(gogkey, 1);
 
-				gog_key->key = avpl_to_str(gogkey_match);
-				delete_avpl(gogkey_match,FALSE);
+				gog_key->key = new_avpl_key(gogkey_match);
 
 				gog_key->cfg = gop_cfg;
 
 				if (g_hash_table_lookup(gop_cfg->gog_index,gog_key->key)) {
-					g_free(gog_key->key);
+					delete_avpl_key(gog_key->key);
 					g_free(gog_key);
 					gog_key = NULL;
+				} else {
+					avpl_key_subscribe(gog_key->key);
 				}
 
+				delete_avpl(gogkey_match,FALSE);
+
 				if (! gog_key ) {
 					/* XXX: since these gogs actually share key info
 							we should try to merge (non released) gogs
 					        that happen to have equal keys */
 				} else {
-					dbg_print (dbg_gog,1,dbg_facility,"analyze_gop: new key for gog=%s:%d : %s",gog->cfg->name,gog->id,gog_key->key);
+					if (*dbg_gog > 0) {
+						s = avpl_key_to_str(gog_key->key);
+						dbg_print (dbg_gog,1,dbg_facility,"analyze_gop: new key for gog=%s:%d : %s",gog->cfg->name,gog->id,s);
+						g_free(s);
+					}
 					g_ptr_array_add(gog->gog_keys,gog_key);
 					g_hash_table_insert(gog_key->cfg->gog_index,gog_key->key,gog);
 				}
@@ -369,7 +419,8 @@ static void analyze_gop(mate_config* mc, mate_gop* gop) {
 	void* cookie = NULL;
 	AVPL* gogkey_match = NULL;
 	mate_gog* gog = NULL;
-	gchar* key = NULL;
+	AVPL_key* key = NULL;
+	gchar* s;
 
 	if ( ! gop->gog  ) {
 		/* no gog, let's either find one or create it if due */
@@ -389,9 +440,13 @@ static void analyze_gop(mate_config* mc, mate_gop* gop) {
 		while (( curr_gogkey = get_next_avpl(gog_keys,&cookie) )) {
 			if (( gogkey_match = new_avpl_pairs_match(gop->cfg->name, gop->avpl, curr_gogkey, TRUE, TRUE) )) {
 
-				key = avpl_to_str(gogkey_match);
+				key = new_avpl_key(gogkey_match);
 
-				dbg_print (dbg_gog,1,dbg_facility,"analyze_gop: got gogkey_match: %s",key);
+				if (*dbg_gog > 0) {
+					s = avpl_key_to_str(key);
+					dbg_print (dbg_gog,1,dbg_facility,"analyze_gop: got gogkey_match: %s",s);
+					g_free(s);
+				}
 
 				if (( gog = (mate_gog *)g_hash_table_lookup(gop->cfg->gog_index,key) )) {
 					dbg_print (dbg_gog,1,dbg_facility,"analyze_gop: got already a matching gog");
@@ -436,7 +491,7 @@ static void analyze_gop(mate_config* mc, mate_gop* gop) {
 			}
 		} /* while */
 
-		g_free(key);
+		if (key) delete_avpl_key(key);
 		key = NULL;
 
 		if (gogkey_match) delete_avpl(gogkey_match,TRUE);
@@ -454,8 +509,8 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 	*/
 	mate_cfg_gop* cfg = NULL;
 	mate_gop* gop = NULL;
-	gchar* gop_key;
-	gchar* orig_gop_key = NULL;
+	AVPL_key* gop_key;
+	AVPL_key* orig_gop_key = NULL;
 	AVPL* candidate_start = NULL;
 	AVPL* candidate_stop = NULL;
 	AVPL* is_start = NULL;
@@ -465,36 +520,34 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 	AVPL* curr_gogkey = NULL;
 	void* cookie = NULL;
 	AVPL* gogkey_match = NULL;
-	gchar* gogkey_str = NULL;
+	AVPL_key* gogkey = NULL;
 
 	dbg_print (dbg_gop,1,dbg_facility,"analyze_pdu: %s",pdu->cfg->name);
 
 	if (! (cfg = (mate_cfg_gop *)g_hash_table_lookup(mc->gops_by_pduname,pdu->cfg->name)) )
 		return;
 
+	expire_gops(cfg);
+
 	if ((gopkey_match = new_avpl_pairs_match("gop_key_match", pdu->avpl, cfg->key, TRUE, TRUE))) {
-		gop_key = avpl_to_str(gopkey_match);
+		gop_key = new_avpl_key(gopkey_match);
 
 		g_hash_table_lookup_extended(cfg->gop_index,(gconstpointer)gop_key,(gpointer *)&orig_gop_key,(gpointer *)&gop);
 
 		if ( gop ) {
-			g_free(gop_key);
+			delete_avpl_key(gop_key);
 
 			/* is the gop dead ? */
 			if ( ! gop->released &&
 				 ( ( gop->cfg->lifetime > 0.0 && gop->time_to_die >= rd->now) ||
 				   ( gop->cfg->idle_timeout > 0.0 && gop->time_to_timeout >= rd->now) ) ) {
 				dbg_print (dbg_gop,4,dbg_facility,"analyze_pdu: expiring released gop");
-				gop->released = TRUE;
-
-				if (gop->gog && gop->cfg->start) gop->gog->num_of_released_gops++;
+				release_gop(gop);
 			}
 
-			/* TODO: is the gop expired? */
-
 			gop_key = orig_gop_key;
 
-			dbg_print (dbg_gop,2,dbg_facility,"analyze_pdu: got gop: %s",gop_key);
+			dbg_print (dbg_gop,2,dbg_facility,"analyze_pdu: got gop: %s:%d",gop->cfg->name,gop->id);
 
 			if (( candidate_start = cfg->start )) {
 
@@ -540,29 +593,29 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 
 					while (( curr_gogkey = get_next_avpl(gog_keys,&cookie) )) {
 						if (( gogkey_match = new_avpl_pairs_match(cfg->name, gopkey_match, curr_gogkey, TRUE, FALSE) )) {
-							gogkey_str = avpl_to_str(gogkey_match);
+							gogkey = new_avpl_key(gogkey_match);
 
-							if (g_hash_table_lookup(cfg->gog_index,gogkey_str)) {
+							if (g_hash_table_lookup(cfg->gog_index,gogkey)) {
 								gop = new_gop(cfg,pdu,gop_key);
 								g_hash_table_insert(cfg->gop_index,gop_key,gop);
+								delete_avpl_key(gogkey);
 								delete_avpl(gogkey_match,FALSE);
-								g_free(gogkey_str);
 								break;
 							} else {
+								delete_avpl_key(gogkey);
 								delete_avpl(gogkey_match,FALSE);
-								g_free(gogkey_str);
 							}
 						}
 					}
 
 					if ( ! gop ) {
-						g_free(gop_key);
+						delete_avpl_key(gop_key);
 						delete_avpl(gopkey_match,TRUE);
 						return;
 					}
 
 				} else {
-					g_free(gop_key);
+					delete_avpl_key(gop_key);
 					delete_avpl(gopkey_match,TRUE);
 					return;
 				}
@@ -574,7 +627,7 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 					delete_avpl(is_start,FALSE);
 					gop = new_gop(cfg,pdu,gop_key);
 				} else {
-					g_free(gop_key);
+					delete_avpl_key(gop_key);
 					return;
 				}
 
@@ -616,9 +669,8 @@ static void analyze_pdu(mate_config* mc, mate_pdu* pdu) {
 				delete_avpl(is_stop,FALSE);
 
 				if (! gop->released) {
-					gop->released = TRUE;
 					gop->release_time = pdu->rel_time;
-					if (gop->gog && gop->cfg->start) gop->gog->num_of_released_gops++;
+					release_gop(gop);
 				}
 
 				pdu->is_stop = TRUE;
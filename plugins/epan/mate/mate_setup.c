@@ -90,8 +90,9 @@ extern mate_cfg_gop* new_gopcfg(mate_config* mc, gchar* name) {
 
 	cfg->my_hfids = g_hash_table_new(g_str_hash,g_str_equal);
 
-	cfg->gop_index = g_hash_table_new(g_str_hash,g_str_equal);
-	cfg->gog_index = g_hash_table_new(g_str_hash,g_str_equal);
+	cfg->gop_index = g_hash_table_new(avpl_key_hash,avpl_key_equal);
+	cfg->gog_index = g_hash_table_new(avpl_key_hash,avpl_key_equal);
+	g_queue_init(&cfg->released_gops);
 
 	g_hash_table_insert(mc->gopcfgs,(gpointer) cfg->name, (gpointer) cfg);
 
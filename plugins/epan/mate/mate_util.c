@@ -774,6 +774,126 @@ extern gchar* avpl_to_dotstr(AVPL* avpl) {
 	return r;
 }
 
+/**
+ * new_avpl_key:
+ * @param avpl the avpl from which to make the key.
+ *
+ * Creates a key that holds the attributes of an avpl in the same order, to be
+ * used in the GoP and GoG indexes. Since every name and value lives in the
+ * avp_strings collection equal strings have equal pointers, so hashing and
+ * comparing keys is done on the pointers and no string is formatted.
+ *
+ * The new key borrows the strings of the avpl; avpl_key_subscribe() must be
+ * called on it if it is going to outlive the avpl.
+ *
+ * Return value: a pointer to the newly allocated key.
+ *
+ **/
+extern AVPL_key* new_avpl_key(AVPL* avpl) {
+	AVPL_key* key = (AVPL_key*)g_malloc(sizeof(AVPL_key) + avpl->len * sizeof(AVP));
+	AVPN* c;
+	guint hash = avpl->len;
+	guint i = 0;
+
+	for (c = avpl->null.next; c->avp; c = c->next) {
+		key->avps[i] = *(c->avp);
+		hash = (hash << 5) - hash + GPOINTER_TO_UINT(c->avp->n);
+		hash = (hash << 5) - hash + GPOINTER_TO_UINT(c->avp->v);
+		hash = (hash << 5) - hash + (guint)c->avp->o;
+		i++;
+	}
+
+	key->len = i;
+	key->hash = hash;
+	key->subscribed = FALSE;
+
+	return key;
+}
+
+/**
+ * avpl_key_subscribe:
+ * @param key the key.
+ *
+ * Subscribes the strings of a key so that it no longer depends on the avpl it
+ * was made from.
+ *
+ **/
+extern void avpl_key_subscribe(AVPL_key* key) {
+	guint i;
+
+	if (key->subscribed) return;
+
+	for (i = 0; i < key->len; i++) {
+		scs_subscribe(avp_strings, key->avps[i].n);
+		scs_subscribe(avp_strings, key->avps[i].v);
+	}
+
+	key->subscribed = TRUE;
+}
+
+/**
+ * delete_avpl_key:
+ * @param key the key to be deleted.
+ *
+ * Frees a key and unsubscribes its strings if it had subscribed them.
+ *
+ **/
+extern void delete_avpl_key(AVPL_key* key) {
+	guint i;
+
+	if (key->subscribed) {
+		for (i = 0; i < key->len; i++) {
+			scs_unsubscribe(avp_strings, key->avps[i].n);
+			scs_unsubscribe(avp_strings, key->avps[i].v);
+		}
+	}
+
+	g_free(key);
+}
+
+extern guint avpl_key_hash(gconstpointer k) {
+	return ((const AVPL_key*)k)->hash;
+}
+
+extern gboolean avpl_key_equal(gconstpointer a, gconstpointer b) {
+	const AVPL_key* ka = (const AVPL_key*)a;
+	const AVPL_key* kb = (const AVPL_key*)b;
+	guint i;
+
+	if (ka->hash != kb->hash || ka->len != kb->len) return FALSE;
+
+	for (i = 0; i < ka->len; i++) {
+		if (ka->avps[i].n != kb->avps[i].n ||
+			ka->avps[i].v != kb->avps[i].v ||
+			ka->avps[i].o != kb->avps[i].o) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * avpl_key_to_str:
+ * @param key the key to represent.
+ *
+ * Creates a newly allocated string containing a representation of a key,
+ * in the same format as avpl_to_str().
+ *
+ * Return value: a pointer to the newly allocated string.
+ *
+ **/
+extern gchar* avpl_key_to_str(const AVPL_key* key) {
+	GString* s = g_string_new("");
+	guint i;
+
+	for (i = 0; i < key->len; i++) {
+		g_string_append_printf(s," %s%c%s;",key->avps[i].n,key->avps[i].o,key->avps[i].v);
+	}
+
+	return g_string_free(s,FALSE);
+}
+
 /**
 * merge_avpl:
  * @param dst the avpl in which to merge the avps.
@@ -75,6 +75,14 @@ typedef struct _avp_list {
 
 
 
+/* a key made of the avps of an avp list, hashed on their interned strings */
+typedef struct _avpl_key {
+	guint hash;
+	guint len;
+	gboolean subscribed;
+	AVP avps[];
+} AVPL_key;
+
 /* an avpl transformation operation */
 typedef enum _avpl_match_mode {
 	AVPL_NO_MATCH,
@@ -209,6 +217,14 @@ extern AVP* extract_avp_by_name(AVPL* avpl, gchar* name);
 extern gchar* avpl_to_str(AVPL* avpl);
 extern gchar* avpl_to_dotstr(AVPL*);
 
+/* avpl keys, to index items by a set of avps */
+extern AVPL_key* new_avpl_key(AVPL* avpl);
+extern void avpl_key_subscribe(AVPL_key* key);
+extern void delete_avpl_key(AVPL_key* key);
+extern guint avpl_key_hash(gconstpointer k);
+extern gboolean avpl_key_equal(gconstpointer a, gconstpointer b);
+extern gchar* avpl_key_to_str(const AVPL_key* key);
+
 /* deletes an avp list  and eventually its contents */
 extern void delete_avpl(AVPL* avpl, gboolean avps_too);
 
@@ -195,11 +195,16 @@ mate_gop_tree(proto_tree* tree, packet_info *pinfo, tvbuff_t *tvb, mate_gop* gop
 	const gchar* pdu_str;
 	const gchar* type_str;
 	guint32 pdu_item;
+	gchar* gop_key_str;
 
 	gop_item = proto_tree_add_uint(tree,gop->cfg->hfid,tvb,0,0,gop->id);
 	gop_tree = proto_item_add_subtree(gop_item, gop->cfg->ett);
 
-	if (gop->gop_key) proto_tree_add_string(gop_tree,hf_mate_gop_key,tvb,0,0,gop->gop_key);
+	if (gop->gop_key) {
+		gop_key_str = avpl_key_to_str(gop->gop_key);
+		proto_tree_add_string(gop_tree,hf_mate_gop_key,tvb,0,0,gop_key_str);
+		g_free(gop_key_str);
+	}
 
 	gop_attrs_tree(gop_tree,pinfo,tvb,gop);
 
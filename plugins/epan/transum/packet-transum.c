@@ -104,26 +104,42 @@ in a message header
 static wmem_map_t *dcerpc_context_zero;
 
 /*
-    The rrpd_list holds information about all of the APDU Request-Response Pairs seen in the trace.
+    The APDU Request-Response Pairs are kept per TCP or UDP stream, so that matching a packet to its RR Pair
+    doesn't depend on how many streams and RR Pairs the trace has.  For each stream there is:
+
+    rrpds - the most recent RRPDs seen on the stream, newest at the tail.  Only the last MAX_RRPDS_PER_STREAM
+    are kept; older RRPDs are still reported through output_rrpd but no more packets will be matched to them.
+
+    msg_index - a hash of the RRPDs on rrpds by session_id:msg_id, pointing to the newest RRPD with those values.
+    An RRPD whose session_id:msg_id changes is dropped from the hash.  When that happens msg_index_complete is
+    cleared and a failed lookup no longer means that there is no such RRPD, so the rrpds list has to be searched.
+
+    temp_rsp - an RRPD for an APDU where we have not yet seen the header information and so we can't fully
+    qualify the identification of the RRPD (the identification being ip_proto:stream_no:session_id:msg_id).
+    This only occurs when a) we are using one of the decode_based calculations (such as SMB2), and b) when we have
+    TCP Reassembly enabled.  Once we receive a header packet for an APDU we migrate the entry to the matching
+    entry on rrpds.
  */
-static wmem_list_t *rrpd_list = NULL;
+#define MAX_RRPDS_PER_STREAM 256
+
+typedef struct _RRPD_STREAM
+{
+    wmem_list_t *rrpds;
+    wmem_map_t *msg_index;
+    gboolean msg_index_complete;
+    RRPD *temp_rsp;
+} RRPD_STREAM;
+
+static wmem_map_t *tcp_rrpd_streams = NULL;
+static wmem_map_t *udp_rrpd_streams = NULL;
 
 /*
-    output_rrpd is a hash of pointers to RRPDs on the rrpd_list.  The index is the frame number.  This hash is
+    output_rrpd is a hash of pointers to RRPDs.  The index is the frame number.  This hash is
     used during Wireshark's second scan.  As each packet is processed, TRANSUM uses the packet's frame number to index into
     this hash to determine if we have RTE data for this particular packet, and if so the write_rte function is called.
  */
 static wmem_map_t *output_rrpd;
 
-/*
-    The temp_rsp_rrpd_list holds RRPDs for APDUs where we have not yet seen the header information and so we can't
-    fully qualify the identification of the RRPD (the identification being ip_proto:stream_no:session_id:msg_id).
-    This only occurs when a) we are using one of the decode_based calculations (such as SMB2), and b) when we have
-    TCP Reassembly enabled.  Once we receive a header packet for an APDU we migrate the entry from this array to the
-    main rrpd_list.
- */
-static wmem_list_t *temp_rsp_rrpd_list = NULL;  /* Reuse these for speed and efficient memory use - issue a warning if we run out */
-
 /* Optimisation data - the following is used for various optimisation measures */
 static int highest_tcp_stream_no;
 static int highest_udp_stream_no;
@@ -225,292 +241,247 @@ static void update_output_rrpd(RRPD *in_rrpd)
         wmem_map_insert(output_rrpd, GUINT_TO_POINTER(in_rrpd->rsp_last_frame), in_rrpd);
 }
 
-/* Return the index of the RRPD that has been appended */
-static RRPD* append_to_rrpd_list(RRPD *in_rrpd)
+static guint rrpd_msg_hash(gconstpointer key)
 {
-    RRPD *next_rrpd = (RRPD*)wmem_memdup(wmem_file_scope(), in_rrpd, sizeof(RRPD));
+    const RRPD *rrpd = (const RRPD*)key;
 
-    update_output_rrpd(next_rrpd);
+    return (guint)(rrpd->session_id ^ (rrpd->session_id >> 32)) * 31 + (guint)(rrpd->msg_id ^ (rrpd->msg_id >> 32));
+}
 
-    wmem_list_append(rrpd_list, next_rrpd);
+static gboolean rrpd_msg_equal(gconstpointer a, gconstpointer b)
+{
+    const RRPD *rrpd_a = (const RRPD*)a;
+    const RRPD *rrpd_b = (const RRPD*)b;
 
-    return next_rrpd;
+    return rrpd_a->session_id == rrpd_b->session_id && rrpd_a->msg_id == rrpd_b->msg_id;
 }
 
-static RRPD *find_latest_rrpd_dcerpc(RRPD *in_rrpd)
+static RRPD_STREAM *get_rrpd_stream(RRPD *in_rrpd, gboolean create)
 {
-    RRPD *rrpd;
-    wmem_list_frame_t* i;
+    wmem_map_t *streams;
+    RRPD_STREAM *stream;
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
-    {
-        rrpd = (RRPD*)wmem_list_frame_data(i);
+    if (in_rrpd->ip_proto == IP_PROTO_TCP)
+        streams = tcp_rrpd_streams;
+    else if (in_rrpd->ip_proto == IP_PROTO_UDP)
+        streams = udp_rrpd_streams;
+    else
+        return NULL;
 
-        if (rrpd->calculation != RTE_CALC_DCERPC && rrpd->calculation != RTE_CALC_SYN)
-            continue;
+    stream = (RRPD_STREAM*)wmem_map_lookup(streams, GUINT_TO_POINTER(in_rrpd->stream_no));
 
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-        {
-            /* if we can match on session_id and msg_id must be a retransmission of the last request packet or the response */
-            /* this logic works whether or not we are using reassembly */
-            if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id)
-                return rrpd;
-
-            /* If this is a retransmission, we assume it relates to this rrpd_list entry.
-               This is a bit of a kludge and not ideal but a compromise.*/
-            /* ToDo: look at using TCP sequence number to allocate a retransmission to the correct APDU */
-            if (in_rrpd->is_retrans)
-                return rrpd;
-
-            if (preferences.reassembly)
-            {
-                if (in_rrpd->c2s)
-                {
-                    /* if the input rrpd is for c2s and the one we have found already has response information, then the
-                    in_rrpd represents a new RR Pair. */
-                    if (rrpd->rsp_first_frame)
-                        return NULL;
-
-                    /* If the current rrpd_list entry doesn't have a msg_id then we assume we are mid Request APDU and so we have a match. */
-                    if (!rrpd->msg_id)
-                        return rrpd;
-                }
-                else  /* The in_rrpd relates to a packet going s2c */
-                {
-                    /* When reassembly is enabled, multi-packet response information is actually migrated from the temp_rsp_rrpd_list
-                    to the rrpd_list and so we won't come through here. */
-                    ;
-                }
-            }
-            else /* we are not using reassembly */
-            {
-                if (in_rrpd->c2s)
-                {
-                    if (in_rrpd->msg_id)
-                        /* if we have a message id this is a new Request APDU */
-                        return NULL;
-                    else  /* No msg_id */
-                    {
-                        return rrpd;  /* add this packet to the matching stream */
-                    }
-                }
-                else  /* this packet is going s2c */
-                {
-                    if (!in_rrpd->msg_id && rrpd->rsp_first_frame)
-                        /* we need to add this frame to the response APDU of the most recent rrpd_list entry that has already had response packets */
-                        return rrpd;
-                }
-            }
-        }  /* this is the end of the 5-tuple check */
+    if (stream == NULL && create)
+    {
+        stream = wmem_new(wmem_file_scope(), RRPD_STREAM);
+        stream->rrpds = wmem_list_new(wmem_file_scope());
+        stream->msg_index = wmem_map_new(wmem_file_scope(), rrpd_msg_hash, rrpd_msg_equal);
+        stream->msg_index_complete = TRUE;
+        stream->temp_rsp = NULL;
+        wmem_map_insert(streams, GUINT_TO_POINTER(in_rrpd->stream_no), stream);
+    }
 
-        if (in_rrpd->c2s)
-            in_rrpd->req_search_total++;
-        else
-            in_rrpd->rsp_search_total++;
-    } /* end of the for loop */
+    return stream;
+}
 
-    return NULL;
+/* Remove an RRPD from the msg_index, provided it's the entry for its session_id:msg_id */
+static void remove_from_msg_index(RRPD_STREAM *stream, RRPD *rrpd)
+{
+    if (wmem_map_lookup(stream->msg_index, rrpd) == rrpd)
+        wmem_map_remove(stream->msg_index, rrpd);
 }
 
-static RRPD *find_latest_rrpd_dns(RRPD *in_rrpd)
+/* Return the index of the RRPD that has been appended */
+static RRPD* append_to_rrpd_list(RRPD *in_rrpd)
 {
-    RRPD *rrpd;
-    wmem_list_frame_t* i;
+    RRPD *next_rrpd = (RRPD*)wmem_memdup(wmem_file_scope(), in_rrpd, sizeof(RRPD));
+    RRPD_STREAM *stream = get_rrpd_stream(next_rrpd, TRUE);
+    wmem_list_frame_t *oldest;
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
-    {
-        rrpd = (RRPD*)wmem_list_frame_data(i);
+    update_output_rrpd(next_rrpd);
 
-        if (rrpd->calculation != RTE_CALC_DNS)
-            continue;
+    if (stream == NULL)
+        return next_rrpd;
 
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-        {
-            if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id)
-            {
-                if (in_rrpd->c2s && rrpd->rsp_first_frame)
-                    return NULL;  /* this is new */
-                else
-                    return rrpd;
-            }
-        }  /* this is the end of the 5-tuple check */
+    if (wmem_list_count(stream->rrpds) >= MAX_RRPDS_PER_STREAM)
+    {
+        oldest = wmem_list_head(stream->rrpds);
+        remove_from_msg_index(stream, (RRPD*)wmem_list_frame_data(oldest));
+        wmem_list_remove_frame(stream->rrpds, oldest);
+    }
 
-        if (in_rrpd->c2s)
-            in_rrpd->req_search_total++;
-        else
-            in_rrpd->rsp_search_total++;
-    } /* this is the end of the for loop */
+    wmem_list_append(stream->rrpds, next_rrpd);
 
-    return NULL;
+    /* This is now the newest RRPD with its session_id:msg_id.  The old entry is removed first
+       so that the key of the hash entry is the RRPD it points to. */
+    wmem_map_remove(stream->msg_index, next_rrpd);
+    wmem_map_insert(stream->msg_index, next_rrpd, next_rrpd);
+
+    return next_rrpd;
 }
 
-static RRPD *find_latest_rrpd_gtcp(RRPD *in_rrpd)
+/*
+    Look up the newest RRPD on the stream with the session_id:msg_id of in_rrpd.  *found is set
+    to TRUE if the answer is known, FALSE if the rrpds list has to be searched instead.
+ */
+static RRPD *find_rrpd_by_msg_id(RRPD_STREAM *stream, RRPD *in_rrpd, guint calculation, guint other_calculation, gboolean *found)
 {
-    RRPD *rrpd;
-    wmem_list_frame_t* i;
+    RRPD *rrpd = (RRPD*)wmem_map_lookup(stream->msg_index, in_rrpd);
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    if (rrpd == NULL)
     {
-        rrpd = (RRPD*)wmem_list_frame_data(i);
-
-        if (rrpd->calculation != RTE_CALC_GTCP && rrpd->calculation != RTE_CALC_SYN)
-            continue;
-
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-        {
-            if (in_rrpd->c2s && rrpd->rsp_first_frame)
-                return NULL;  /* this is new */
-            else
-                return rrpd;
-        }  /* this is the end of the 5-tuple check */
-
-        if (in_rrpd->c2s)
-            in_rrpd->req_search_total++;
-        else
-            in_rrpd->rsp_search_total++;
-    } /* this is the end of the for loop */
+        *found = stream->msg_index_complete;
+        return NULL;
+    }
 
-    return NULL;
+    /* If the newest RRPD with these values belongs to another calculation, an older one may still match */
+    *found = (rrpd->calculation == calculation || rrpd->calculation == other_calculation);
+    return *found ? rrpd : NULL;
 }
 
-static RRPD *find_latest_rrpd_gudp(RRPD *in_rrpd)
+/* This is used for both DCE-RPC and SMB2 as they match RRPDs in the same way */
+static RRPD *find_latest_rrpd_decode_based(RRPD *in_rrpd, RRPD_STREAM *stream)
 {
     RRPD *rrpd;
     wmem_list_frame_t* i;
+    gboolean found;
+
+    /* A response that isn't a retransmission can only be matched on its session_id and msg_id, except
+       when we are not using reassembly and it doesn't have a msg_id, so look it up directly. */
+    if (!in_rrpd->c2s && !in_rrpd->is_retrans && (preferences.reassembly || in_rrpd->msg_id))
+    {
+        rrpd = find_rrpd_by_msg_id(stream, in_rrpd, in_rrpd->calculation, RTE_CALC_SYN, &found);
+        if (found)
+            return rrpd;
+    }
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    for (i = wmem_list_tail(stream->rrpds); i != NULL; i = wmem_list_frame_prev(i))
     {
         rrpd = (RRPD*)wmem_list_frame_data(i);
 
-        if (rrpd->calculation != RTE_CALC_GUDP)
+        if (rrpd->calculation != in_rrpd->calculation && rrpd->calculation != RTE_CALC_SYN)
             continue;
 
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
+        /* if we can match on session_id and msg_id must be a retransmission of the last request packet or the response */
+        /* this logic works whether or not we are using reassembly */
+        if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id)
+            return rrpd;
+
+        /* If this is a retransmission, we assume it relates to this rrpd_list entry.
+           This is a bit of a kludge and not ideal but a compromise.*/
+        /* ToDo: look at using TCP sequence number to allocate a retransmission to the correct APDU */
+        if (in_rrpd->is_retrans)
+            return rrpd;
+
+        if (preferences.reassembly)
         {
-            if (in_rrpd->c2s && rrpd->rsp_first_frame)
-                return NULL;  /* this is new */
-            else
-                return rrpd;
-        }  /* this is the end of the 5-tuple check */
+            if (in_rrpd->c2s)
+            {
+                /* if the input rrpd is for c2s and the one we have found already has response information, then the
+                in_rrpd represents a new RR Pair. */
+                if (rrpd->rsp_first_frame)
+                    return NULL;
+
+                /* If the current rrpd_list entry doesn't have a msg_id then we assume we are mid Request APDU and so we have a match. */
+                if (!rrpd->msg_id)
+                    return rrpd;
+            }
+            else  /* The in_rrpd relates to a packet going s2c */
+            {
+                /* When reassembly is enabled, multi-packet response information is actually migrated from the
+                temp_rsp entry to the rrpds list and so we won't come through here. */
+                ;
+            }
+        }
+        else /* we are not using reassembly */
+        {
+            if (in_rrpd->c2s)
+            {
+                if (in_rrpd->msg_id)
+                    /* if we have a message id this is a new Request APDU */
+                    return NULL;
+                else  /* No msg_id */
+                {
+                    return rrpd;  /* add this packet to the matching stream */
+                }
+            }
+            else  /* this packet is going s2c */
+            {
+                if (!in_rrpd->msg_id && rrpd->rsp_first_frame)
+                    /* we need to add this frame to the response APDU of the most recent rrpd_list entry that has already had response packets */
+                    return rrpd;
+            }
+        }
 
         if (in_rrpd->c2s)
             in_rrpd->req_search_total++;
         else
             in_rrpd->rsp_search_total++;
-    } /* this is the end of the for loop */
+    } /* end of the for loop */
 
     return NULL;
 }
 
-static RRPD *find_latest_rrpd_smb2(RRPD *in_rrpd)
+static RRPD *find_latest_rrpd_dns(RRPD *in_rrpd, RRPD_STREAM *stream)
 {
     RRPD *rrpd;
     wmem_list_frame_t* i;
+    gboolean found;
+
+    rrpd = find_rrpd_by_msg_id(stream, in_rrpd, RTE_CALC_DNS, RTE_CALC_DNS, &found);
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    if (!found)
     {
-        rrpd = (RRPD*)wmem_list_frame_data(i);
+        for (i = wmem_list_tail(stream->rrpds); i != NULL; i = wmem_list_frame_prev(i))
+        {
+            rrpd = (RRPD*)wmem_list_frame_data(i);
 
-        if (rrpd->calculation != RTE_CALC_SMB2 && rrpd->calculation != RTE_CALC_SYN)
-            continue;
+            if (rrpd->calculation == RTE_CALC_DNS &&
+                rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id)
+                break;
 
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-        {
-            /* if we can match on session_id and msg_id must be a retransmission of the last request packet or the response */
-            /* this logic works whether or not we are using reassembly */
-            if (rrpd->session_id == in_rrpd->session_id && rrpd->msg_id == in_rrpd->msg_id)
-                return rrpd;
-
-            /* If this is a retransmission, we assume it relates to this rrpd_list entry.
-            This is a bit of a kludge and not ideal but a compromise.*/
-            /* ToDo: look at using TCP sequence number to allocate a retransmission to the correct APDU */
-            if (in_rrpd->is_retrans)
-                return rrpd;
-
-            if (preferences.reassembly)
+            if (rrpd->calculation == RTE_CALC_DNS)
             {
                 if (in_rrpd->c2s)
-                {
-                    /* if the input rrpd is for c2s and the one we have found already has response information, then the
-                    in_rrpd represents a new RR Pair. */
-                    if (rrpd->rsp_first_frame)
-                        return NULL;
-
-                    /* If the current rrpd_list entry doesn't have a msg_id then we assume we are mid Request APDU and so we have a match. */
-                    if (!rrpd->msg_id)
-                        return rrpd;
-                }
-                else  /* The in_rrpd relates to a packet going s2c */
-                {
-                    /* When reassembly is enabled, multi-packet response information is actually migrated from the temp_rsp_rrpd_list
-                    to the rrpd_list and so we won't come through here. */
-                    ;
-                }
-            }
-            else /* we are not using reassembly */
-            {
-                if (in_rrpd->c2s)
-                {
-                    if (in_rrpd->msg_id)
-                        /* if we have a message id this is a new Request APDU */
-                        return NULL;
-                    else  /* No msg_id */
-                    {
-                        return rrpd;  /* add this packet to the matching stream */
-                    }
-                }
-                else  /* this packet is going s2c */
-                {
-                    if (!in_rrpd->msg_id && rrpd->rsp_first_frame)
-                        /* we need to add this frame to the response APDU of the most recent rrpd_list entry that has already had response packets */
-                        return rrpd;
-                }
+                    in_rrpd->req_search_total++;
+                else
+                    in_rrpd->rsp_search_total++;
             }
-        }  /* this is the end of the 5-tuple check */
 
-        if (in_rrpd->c2s)
-            in_rrpd->req_search_total++;
-        else
-            in_rrpd->rsp_search_total++;
-    } /* end of the for loop */
+            rrpd = NULL;
+        }
+    }
 
-    return NULL;
+    if (rrpd != NULL && in_rrpd->c2s && rrpd->rsp_first_frame)
+        return NULL;  /* this is new */
+
+    return rrpd;
 }
 
-static RRPD *find_latest_rrpd_syn(RRPD *in_rrpd)
+/*
+    The Generic TCP, Generic UDP and SYN calculations match the most recent RRPD on the stream that
+    has one of the two given calculations.
+ */
+static RRPD *find_latest_rrpd_generic(RRPD_STREAM *stream, guint calculation, guint other_calculation)
 {
     RRPD *rrpd;
     wmem_list_frame_t* i;
 
-    for (i = wmem_list_tail(rrpd_list); i != NULL; i = wmem_list_frame_prev(i))
+    for (i = wmem_list_tail(stream->rrpds); i != NULL; i = wmem_list_frame_prev(i))
     {
         rrpd = (RRPD*)wmem_list_frame_data(i);
 
-        if (rrpd->calculation != RTE_CALC_SYN)
-            continue;
-
-        /* if the input 5-tuple doesn't match the rrpd_list_entry 5-tuple -> go find the next list entry */
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-        {
+        if (rrpd->calculation == calculation || rrpd->calculation == other_calculation)
             return rrpd;
-        }  /* this is the end of the 5-tuple check */
-
-        if (in_rrpd->c2s)
-            in_rrpd->req_search_total++;
-        else
-            in_rrpd->rsp_search_total++;
-    } /* this is the end of the for loop */
+    }
 
     return NULL;
 }
 
 static RRPD *find_latest_rrpd(RRPD *in_rrpd)
 {
+    RRPD_STREAM *stream;
+    RRPD *rrpd;
+
     /* Optimisation Code */
     if (in_rrpd->ip_proto == IP_PROTO_TCP && (int)in_rrpd->stream_no > highest_tcp_stream_no)
     {
@@ -524,30 +495,37 @@ static RRPD *find_latest_rrpd(RRPD *in_rrpd)
     }
     /* End of Optimisation Code */
 
+    stream = get_rrpd_stream(in_rrpd, FALSE);
+    if (stream == NULL)
+        return NULL;
+
     switch (in_rrpd->calculation)
     {
     case RTE_CALC_DCERPC:
-        return find_latest_rrpd_dcerpc(in_rrpd);
+    case RTE_CALC_SMB2:
+        return find_latest_rrpd_decode_based(in_rrpd, stream);
         break;
 
     case RTE_CALC_DNS:
-        return find_latest_rrpd_dns(in_rrpd);
+        return find_latest_rrpd_dns(in_rrpd, stream);
         break;
 
     case RTE_CALC_GTCP:
-        return find_latest_rrpd_gtcp(in_rrpd);
+        rrpd = find_latest_rrpd_generic(stream, RTE_CALC_GTCP, RTE_CALC_SYN);
+        if (rrpd != NULL && in_rrpd->c2s && rrpd->rsp_first_frame)
+            return NULL;  /* this is new */
+        return rrpd;
         break;
 
     case RTE_CALC_GUDP:
-        return find_latest_rrpd_gudp(in_rrpd);
-        break;
-
-    case RTE_CALC_SMB2:
-        return find_latest_rrpd_smb2(in_rrpd);
+        rrpd = find_latest_rrpd_generic(stream, RTE_CALC_GUDP, RTE_CALC_GUDP);
+        if (rrpd != NULL && in_rrpd->c2s && rrpd->rsp_first_frame)
+            return NULL;  /* this is new */
+        return rrpd;
         break;
 
     case RTE_CALC_SYN:
-        return find_latest_rrpd_syn(in_rrpd);
+        return find_latest_rrpd_generic(stream, RTE_CALC_SYN, RTE_CALC_SYN);
         break;
     }
 
@@ -556,6 +534,8 @@ static RRPD *find_latest_rrpd(RRPD *in_rrpd)
 
 static void update_rrpd_list_entry(RRPD *match, RRPD *in_rrpd)
 {
+    RRPD_STREAM *stream;
+
     null_output_rrpd_entries(match);
 
     if (preferences.debug_enabled)
@@ -570,6 +550,15 @@ static void update_rrpd_list_entry(RRPD *match, RRPD *in_rrpd)
         match->req_last_rtime = in_rrpd->req_last_rtime;
         if (in_rrpd->msg_id)
         {
+            if (!rrpd_msg_equal(match, in_rrpd) && (stream = get_rrpd_stream(match, FALSE)) != NULL)
+            {
+                /* We can't tell whether match is the newest RRPD with its new session_id:msg_id,
+                   so leave both of its values out of the msg_index. */
+                remove_from_msg_index(stream, match);
+                wmem_map_remove(stream->msg_index, in_rrpd);
+                stream->msg_index_complete = FALSE;
+            }
+
             match->session_id = in_rrpd->session_id;
             match->msg_id = in_rrpd->msg_id;
         }
@@ -604,31 +593,26 @@ static void update_rrpd_list_entry_req(RRPD *in_rrpd)
 }
 
 /*
-    This function inserts an RRPD into the temp_rsp_rrpd_list.  If this is
+    This function sets the temp_rsp RRPD of the stream.  If this is
     successful return a pointer to the entry, else return NULL.
  */
 static RRPD* insert_into_temp_rsp_rrpd_list(RRPD *in_rrpd)
 {
-    RRPD *rrpd = (RRPD*)wmem_memdup(wmem_file_scope(), in_rrpd, sizeof(RRPD));
+    RRPD_STREAM *stream = get_rrpd_stream(in_rrpd, TRUE);
 
-    wmem_list_append(temp_rsp_rrpd_list, rrpd);
+    if (stream == NULL)
+        return NULL;
 
-    return rrpd;
+    stream->temp_rsp = (RRPD*)wmem_memdup(wmem_file_scope(), in_rrpd, sizeof(RRPD));
+
+    return stream->temp_rsp;
 }
 
 static RRPD* find_temp_rsp_rrpd(RRPD *in_rrpd)
 {
-    wmem_list_frame_t *i;
-    RRPD* rrpd;
+    RRPD_STREAM *stream = get_rrpd_stream(in_rrpd, FALSE);
 
-    for (i = wmem_list_head(temp_rsp_rrpd_list); i; i = wmem_list_frame_next(i))
-    {
-        rrpd = (RRPD*)wmem_list_frame_data(i);
-        if (rrpd->ip_proto == in_rrpd->ip_proto && rrpd->stream_no == in_rrpd->stream_no)
-            return rrpd;
-    }
-
-    return NULL;
+    return stream ? stream->temp_rsp : NULL;
 }
 
 static void update_temp_rsp_rrpd(RRPD *temp_list, RRPD *in_rrpd)
@@ -637,12 +621,17 @@ static void update_temp_rsp_rrpd(RRPD *temp_list, RRPD *in_rrpd)
     temp_list->rsp_last_rtime = in_rrpd->rsp_last_rtime;
 }
 
-/* This function migrates an entry from the temp_rsp_rrpd_list to the main rrpd_list. */
+/* This function migrates the temp_rsp entry of a stream to an entry on its rrpds list. */
 static void migrate_temp_rsp_rrpd(RRPD *main_list, RRPD *temp_list)
 {
+    RRPD_STREAM *stream = get_rrpd_stream(temp_list, FALSE);
+
     update_rrpd_list_entry(main_list, temp_list);
 
-    wmem_list_remove(temp_rsp_rrpd_list, temp_list);
+    if (stream != NULL && stream->temp_rsp == temp_list)
+        stream->temp_rsp = NULL;
+
+    wmem_free(wmem_file_scope(), temp_list);
 }
 
 static void update_rrpd_list_entry_rsp(RRPD *in_rrpd)
@@ -662,7 +651,7 @@ static void update_rrpd_list_entry_rsp(RRPD *in_rrpd)
                 {
                     update_temp_rsp_rrpd(temp_list, in_rrpd);
 
-                    /* Migrate the temp_rsp_rrpd_list entry to the main rrpd_list */
+                    /* Migrate the temp_rsp entry to the rrpds list */
                     match = find_latest_rrpd(in_rrpd);
                     if (match != NULL)
                         migrate_temp_rsp_rrpd(match, temp_list);
@@ -670,14 +659,14 @@ static void update_rrpd_list_entry_rsp(RRPD *in_rrpd)
                 else
                 {
                     match = find_latest_rrpd(in_rrpd);
-                    /* There isn't an entry in the temp_rsp_rrpd_list so update the master rrpd_list entry */
+                    /* There isn't a temp_rsp entry so update the rrpds list entry */
                     if (match != NULL)
                         update_rrpd_list_entry(match, in_rrpd);
                 }
             }
             else
             {
-                /* Update an existing entry to the temp_rsp_rrpd_list or add a new one. */
+                /* Update the existing temp_rsp entry or add a new one. */
                 temp_list = find_temp_rsp_rrpd(in_rrpd);
 
                 if (temp_list != NULL)
@@ -764,8 +753,8 @@ static void init_globals(void)
     /* Create and initialise some dynamic memory areas */
     tcp_stream_exceptions = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
     detected_tcp_svc = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
-    rrpd_list = wmem_list_new(wmem_file_scope());
-    temp_rsp_rrpd_list = wmem_list_new(wmem_file_scope());
+    tcp_rrpd_streams = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    udp_rrpd_streams = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
 
     /* Indicate what fields we're interested in. */
     GArray *wanted_fields = g_array_sized_new(FALSE, FALSE, (guint)sizeof(int), HF_INTEREST_END_OF_LIST);
@@ -77,10 +77,11 @@ usage(gboolean is_error)
         output = stderr;
     }
 
-    fprintf(output, "Usage: randpkt [-b maxbytes] [-c count] [-t type] [-r] filename\n");
+    fprintf(output, "Usage: randpkt [-b maxbytes] [-c count] [-t type] [-r] [-s seed] filename\n");
     fprintf(output, "Default max bytes (per packet) is 5000\n");
     fprintf(output, "Default count is 1000.\n");
     fprintf(output, "-r: random packet type selection\n");
+    fprintf(output, "-s: seed for the random number generator, to produce the same packets every time\n");
     fprintf(output, "\n");
     fprintf(output, "Types:\n");
 
@@ -121,6 +122,8 @@ main(int argc, char *argv[])
     randpkt_example *example;
     guint8* type = NULL;
     int allrandom = FALSE;
+    gboolean have_seed = FALSE;
+    guint32 seed = 0;
     wtap_dumper *savedump;
     int ret = EXIT_SUCCESS;
     static const struct ws_option long_options[] = {
@@ -163,7 +166,7 @@ main(int argc, char *argv[])
     create_app_running_mutex();
 #endif /* _WIN32 */
 
-    while ((opt = ws_getopt_long(argc, argv, "b:c:ht:r", long_options, NULL)) != -1) {
+    while ((opt = ws_getopt_long(argc, argv, "b:c:ht:rs:", long_options, NULL)) != -1) {
         switch (opt) {
             case 'b':	/* max bytes */
                 produce_max_bytes = get_positive_int(ws_optarg, "max bytes");
@@ -191,6 +194,11 @@ main(int argc, char *argv[])
                 allrandom = TRUE;
                 break;
 
+            case 's':
+                seed = get_guint32(ws_optarg, "seed");
+                have_seed = TRUE;
+                break;
+
             default:
                 usage(TRUE);
                 ret = INVALID_OPTION;
@@ -208,6 +216,10 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    if (have_seed) {
+        randpkt_seed(seed);
+    }
+
     if (!allrandom) {
         produce_type = randpkt_parse_type(type);
         g_free(type);
@@ -703,6 +703,15 @@ int randpkt_example_init(randpkt_example* example, char* produce_filename, int p
 	return EXIT_SUCCESS;
 }
 
+void randpkt_seed(guint32 seed)
+{
+	if (pkt_rand == NULL) {
+		pkt_rand = g_rand_new_with_seed(seed);
+	} else {
+		g_rand_set_seed(pkt_rand, seed);
+	}
+}
+
 /* Parse command-line option "type" and return enum type */
 int randpkt_parse_type(char *string)
 {
@@ -711,6 +720,10 @@ int randpkt_parse_type(char *string)
 
 	/* If called with NULL, or empty string, choose a random packet */
 	if (!string || !g_strcmp0(string, "")) {
+		/* If we were given a seed, the choice should depend on it, too. */
+		if (pkt_rand != NULL) {
+			return examples[g_rand_int_range(pkt_rand, 0, num_entries)].produceable_type;
+		}
 		return examples[g_random_int_range(0, num_entries)].produceable_type;
 	}
 
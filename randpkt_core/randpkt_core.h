@@ -37,6 +37,10 @@ guint randpkt_example_count(void);
 /* Return the list of the active examples */
 void randpkt_example_list(char*** abbrev_list, char*** longname_list);
 
+/* Seed the random number generator, so that the same packets are produced
+   every time */
+void randpkt_seed(guint32 seed);
+
 /* Parse command-line option "type" and return enum type */
 int randpkt_parse_type(char *string);
 
@@ -129,6 +129,35 @@ static print_format_e print_format = PR_FMT_TEXT;
 
 static gboolean want_pcap_pkthdr;
 
+/*
+ * With -B, each packet is written as a binary record rather than a line
+ * of text; see "BINARY OUTPUT" in rawshark(1).  The fields found while
+ * dissecting the packet are gathered here until the filters have been
+ * run and the record can be written.
+ */
+static gboolean binary_output;
+static GByteArray *binary_fields;
+
+typedef enum {
+    RAW_FIELD_NONE   = 0,   /* No value */
+    RAW_FIELD_UINT   = 1,   /* guint64 */
+    RAW_FIELD_INT    = 2,   /* gint64 */
+    RAW_FIELD_DOUBLE = 3,   /* double */
+    RAW_FIELD_TIME   = 4,   /* gint64 seconds, gint32 nanoseconds */
+    RAW_FIELD_BYTES  = 5,   /* Raw bytes, e.g. addresses, in network order */
+    RAW_FIELD_STRING = 6    /* UTF-8, not null-terminated */
+} raw_field_type_e;
+
+/*
+ * Records are read from the pipe through this buffer, so that records
+ * written to the pipe in a batch are read with a few large reads rather
+ * than two for every record.
+ */
+#define RAW_PIPE_BUF_SIZE (64 * 1024)
+static guint8 raw_pipe_buf[RAW_PIPE_BUF_SIZE];
+static size_t raw_pipe_buf_len;
+static size_t raw_pipe_buf_pos;
+
 cf_status_t raw_cf_open(capture_file *cf, const char *fname);
 static gboolean load_cap_file(capture_file *cf);
 static gboolean process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
@@ -139,6 +168,7 @@ static void rawshark_cmdarg_err(const char *fmt, va_list ap);
 static void rawshark_cmdarg_err_cont(const char *fmt, va_list ap);
 static void protocolinfo_init(char *field);
 static gboolean parse_field_string_format(char *format);
+static void write_binary_record(guint32 frame_num, guint64 passed_mask);
 
 typedef enum {
     SF_NONE,    /* No format (placeholder) */
@@ -188,6 +218,7 @@ print_usage(FILE *output)
 
     fprintf(output, "\n");
     fprintf(output, "Output:\n");
+    fprintf(output, "  -B                       write binary records with typed field values\n");
     fprintf(output, "  -l                       flush output after each packet\n");
     fprintf(output, "  -S                       format string for fields\n");
     fprintf(output, "                           (%%D - name, %%S - stringval, %%N numval)\n");
@@ -417,7 +448,7 @@ main(int argc, char *argv[])
       {0, 0, 0, 0 }
     };
 
-#define OPTSTRING_INIT "d:F:hlm:nN:o:pr:R:sS:t:v"
+#define OPTSTRING_INIT "Bd:F:hlm:nN:o:pr:R:sS:t:v"
 
     static const char    optstring[] = OPTSTRING_INIT;
     static const struct report_message_routines rawshark_report_routines = {
@@ -538,6 +569,9 @@ main(int argc, char *argv[])
     /* XXX - We should probably have an option to dump libpcap link types */
     while ((opt = ws_getopt_long(argc, argv, optstring, long_options, NULL)) != -1) {
         switch (opt) {
+            case 'B':        /* Binary output */
+                binary_output = TRUE;
+                break;
             case 'd':        /* Payload type */
                 if (!set_link_type(ws_optarg)) {
                     cmdarg_err("Invalid link type or protocol \"%s\"", ws_optarg);
@@ -707,6 +741,10 @@ main(int argc, char *argv[])
        like MATE won't work. */
     prefs_apply_all();
 
+    if (binary_output) {
+        binary_fields = g_byte_array_new();
+    }
+
     /* Initialize our display fields */
     for (fc = 0; fc < disp_fields->len; fc++) {
         protocolinfo_init((char *)g_ptr_array_index(disp_fields, fc));
@@ -815,12 +853,60 @@ main(int argc, char *argv[])
 
 clean_exit:
     g_free(pipe_name);
+    if (binary_fields)
+        g_byte_array_free(binary_fields, TRUE);
     epan_free(cfile.epan);
     epan_cleanup();
     wtap_cleanup();
     return ret;
 }
 
+/**
+ * Copy len bytes from the pipe to ptr, refilling raw_pipe_buf with
+ * whatever the pipe has available as needed.  A read never waits for
+ * more than is needed, so a single record written to the pipe is still
+ * handled as soon as it arrives.
+ * @return TRUE on success; FALSE, with *err set to 0 at the end of the
+ *         input or to an errno value on an error, on failure.
+ */
+static gboolean
+raw_pipe_read_bytes(guchar *ptr, unsigned int len, gint64 *data_offset, int *err)
+{
+    ssize_t bytes_read;
+    size_t  bytes;
+
+    while (len > 0) {
+        if (raw_pipe_buf_pos == raw_pipe_buf_len) {
+            /* Read anything big directly into place. */
+            if (len >= RAW_PIPE_BUF_SIZE) {
+                bytes_read = ws_read(fd, ptr, len);
+                if (bytes_read <= 0) {
+                    *err = (bytes_read == 0) ? 0 : errno;
+                    return FALSE;
+                }
+                len -= (unsigned int)bytes_read;
+                *data_offset += bytes_read;
+                ptr += bytes_read;
+                continue;
+            }
+            bytes_read = ws_read(fd, raw_pipe_buf, RAW_PIPE_BUF_SIZE);
+            if (bytes_read <= 0) {
+                *err = (bytes_read == 0) ? 0 : errno;
+                return FALSE;
+            }
+            raw_pipe_buf_len = (size_t)bytes_read;
+            raw_pipe_buf_pos = 0;
+        }
+        bytes = MIN(len, raw_pipe_buf_len - raw_pipe_buf_pos);
+        memcpy(ptr, raw_pipe_buf + raw_pipe_buf_pos, bytes);
+        raw_pipe_buf_pos += bytes;
+        len -= (unsigned int)bytes;
+        *data_offset += (gint64)bytes;
+        ptr += bytes;
+    }
+    return TRUE;
+}
+
 /**
  * Read data from a raw pipe.  The "raw" data consists of a libpcap
  * packet header followed by the payload.
@@ -835,7 +921,6 @@ static gboolean
 raw_pipe_read(wtap_rec *rec, Buffer *buf, int *err, gchar **err_info, gint64 *data_offset) {
     struct pcap_pkthdr mem_hdr;
     struct pcaprec_hdr disk_hdr;
-    ssize_t bytes_read = 0;
     unsigned int bytes_needed = (unsigned int) sizeof(disk_hdr);
     guchar *ptr = (guchar*) &disk_hdr;
 
@@ -863,21 +948,9 @@ raw_pipe_read(wtap_rec *rec, Buffer *buf, int *err, gchar **err_info, gint64 *da
     }
 #endif
 
-    /* Copied from capture_loop.c */
-    while (bytes_needed > 0) {
-        bytes_read = ws_read(fd, ptr, bytes_needed);
-        if (bytes_read == 0) {
-            *err = 0;
-            *err_info = NULL;
-            return FALSE;
-        } else if (bytes_read < 0) {
-            *err = errno;
-            *err_info = NULL;
-            return FALSE;
-        }
-        bytes_needed -= (unsigned int)bytes_read;
-        *data_offset += bytes_read;
-        ptr += bytes_read;
+    if (!raw_pipe_read_bytes(ptr, bytes_needed, data_offset, err)) {
+        *err_info = NULL;
+        return FALSE;
     }
 
     rec->rec_type = REC_TYPE_PACKET;
@@ -913,20 +986,11 @@ raw_pipe_read(wtap_rec *rec, Buffer *buf, int *err, gchar **err_info, gint64 *da
 
     ws_buffer_assure_space(buf, bytes_needed);
     ptr = ws_buffer_start_ptr(buf);
-    while (bytes_needed > 0) {
-        bytes_read = ws_read(fd, ptr, bytes_needed);
-        if (bytes_read == 0) {
+    if (!raw_pipe_read_bytes(ptr, bytes_needed, data_offset, err)) {
+        if (*err == 0)
             *err = WTAP_ERR_SHORT_READ;
-            *err_info = NULL;
-            return FALSE;
-        } else if (bytes_read < 0) {
-            *err = errno;
-            *err_info = NULL;
-            return FALSE;
-        }
-        bytes_needed -= (unsigned int)bytes_read;
-        *data_offset += bytes_read;
-        ptr += bytes_read;
+        *err_info = NULL;
+        return FALSE;
     }
     return TRUE;
 }
@@ -970,15 +1034,20 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
 {
     frame_data fdata;
     gboolean passed;
+    guint64 passed_mask = 0;
     int i;
 
     if(rec->rec_header.packet_header.len == 0)
     {
         /* The user sends an empty packet when he wants to get output from us even if we don't currently have
            packets to process. We spit out a line with the timestamp and the text "void"
+           (or, in binary mode, a record for frame 0).
         */
-        printf("%lu %" PRIu64 " %d void -\n", (unsigned long int)cf->count,
-               (guint64)rec->ts.secs, rec->ts.nsecs);
+        if (binary_output)
+            write_binary_record(0, 0);
+        else
+            printf("%lu %" PRIu64 " %d void -\n", (unsigned long int)cf->count,
+                   (guint64)rec->ts.secs, rec->ts.nsecs);
 
         fflush(stdout);
 
@@ -1003,7 +1072,8 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         }
     }
 
-    printf("%lu", (unsigned long int) cf->count);
+    if (!binary_output)
+        printf("%lu", (unsigned long int) cf->count);
 
     frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
                                   &cf->provider.ref, cf->provider.prev_dis);
@@ -1035,10 +1105,18 @@ process_packet(capture_file *cf, epan_dissect_t *edt, gint64 offset,
             passed = TRUE;
 
         /* Print a one-line summary */
-        printf(" %d", passed ? 1 : 0);
+        if (binary_output) {
+            if (passed)
+                passed_mask |= G_GUINT64_CONSTANT(1) << i;
+        } else {
+            printf(" %d", passed ? 1 : 0);
+        }
     }
 
-    printf(" -\n");
+    if (binary_output)
+        write_binary_record((guint32)cf->count, passed_mask);
+    else
+        printf(" -\n");
 
     /* The ANSI C standard does not appear to *require* that a line-buffered
        stream be flushed to the host environment whenever a newline is
@@ -1256,6 +1334,169 @@ static gboolean print_field_value(field_info *finfo, int cmd_line_index)
     return TRUE;
 }
 
+/*
+ * Append a field to binary_fields: a guint16 field index, a guint16
+ * raw_field_type_e, a guint32 length, and then the value, all in host
+ * byte order.
+ */
+static void
+append_binary_field(field_info *finfo, int cmd_line_index)
+{
+    guint16       field_index = (guint16)cmd_line_index;
+    guint16       type;
+    guint32       len;
+    guint64       uvalue64;
+    gint64        svalue64;
+    double        dvalue;
+    guint32       addr;
+    gint64        secs;
+    gint32        nsecs;
+    const nstime_t *ts;
+    const wmem_strbuf_t *strbuf;
+    const guint8 *value = NULL;
+    char         *str = NULL;
+    guint8        time_buf[sizeof secs + sizeof nsecs];
+
+    switch (fvalue_type_ftenum(&finfo->value)) {
+        case FT_NONE:
+        case FT_PROTOCOL:
+            type = RAW_FIELD_NONE;
+            len = 0;
+            break;
+        case FT_BOOLEAN:
+            uvalue64 = fvalue_get_uinteger64(&finfo->value) ? 1 : 0;
+            type = RAW_FIELD_UINT;
+            value = (const guint8 *)&uvalue64;
+            len = sizeof uvalue64;
+            break;
+        case FT_CHAR:
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_IPXNET:
+        case FT_FRAMENUM:
+            uvalue64 = fvalue_get_uinteger(&finfo->value);
+            type = RAW_FIELD_UINT;
+            value = (const guint8 *)&uvalue64;
+            len = sizeof uvalue64;
+            break;
+        case FT_UINT40:
+        case FT_UINT48:
+        case FT_UINT56:
+        case FT_UINT64:
+        case FT_EUI64:
+            uvalue64 = fvalue_get_uinteger64(&finfo->value);
+            type = RAW_FIELD_UINT;
+            value = (const guint8 *)&uvalue64;
+            len = sizeof uvalue64;
+            break;
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+            svalue64 = fvalue_get_sinteger(&finfo->value);
+            type = RAW_FIELD_INT;
+            value = (const guint8 *)&svalue64;
+            len = sizeof svalue64;
+            break;
+        case FT_INT40:
+        case FT_INT48:
+        case FT_INT56:
+        case FT_INT64:
+            svalue64 = fvalue_get_sinteger64(&finfo->value);
+            type = RAW_FIELD_INT;
+            value = (const guint8 *)&svalue64;
+            len = sizeof svalue64;
+            break;
+        case FT_FLOAT:
+        case FT_DOUBLE:
+            dvalue = fvalue_get_floating(&finfo->value);
+            type = RAW_FIELD_DOUBLE;
+            value = (const guint8 *)&dvalue;
+            len = sizeof dvalue;
+            break;
+        case FT_ABSOLUTE_TIME:
+        case FT_RELATIVE_TIME:
+            ts = fvalue_get_time(&finfo->value);
+            secs = (gint64)ts->secs;
+            nsecs = (gint32)ts->nsecs;
+            memcpy(time_buf, &secs, sizeof secs);
+            memcpy(time_buf + sizeof secs, &nsecs, sizeof nsecs);
+            type = RAW_FIELD_TIME;
+            value = time_buf;
+            len = sizeof time_buf;
+            break;
+        case FT_IPv4:
+            /* fvalue_get_uinteger() gives us the address in network byte order. */
+            addr = fvalue_get_uinteger(&finfo->value);
+            type = RAW_FIELD_BYTES;
+            value = (const guint8 *)&addr;
+            len = sizeof addr;
+            break;
+        case FT_IPv6:
+        case FT_ETHER:
+        case FT_BYTES:
+        case FT_UINT_BYTES:
+        case FT_OID:
+        case FT_REL_OID:
+        case FT_SYSTEM_ID:
+        case FT_AX25:
+        case FT_VINES:
+        case FT_FCWWN:
+            type = RAW_FIELD_BYTES;
+            value = fvalue_get_bytes(&finfo->value);
+            len = fvalue_length(&finfo->value);
+            break;
+        case FT_STRING:
+        case FT_STRINGZ:
+        case FT_UINT_STRING:
+        case FT_STRINGZPAD:
+        case FT_STRINGZTRUNC:
+            strbuf = fvalue_get_strbuf(&finfo->value);
+            type = RAW_FIELD_STRING;
+            value = (const guint8 *)wmem_strbuf_get_str(strbuf);
+            len = (guint32)wmem_strbuf_get_len(strbuf);
+            break;
+        default:
+            /* Anything else, e.g. GUIDs, as its display filter string. */
+            str = fvalue_to_string_repr(NULL, &finfo->value, FTREPR_DFILTER, finfo->hfinfo->display);
+            if (str != NULL) {
+                type = RAW_FIELD_STRING;
+                value = (const guint8 *)str;
+                len = (guint32)strlen(str);
+            } else {
+                type = RAW_FIELD_NONE;
+                len = 0;
+            }
+            break;
+    }
+
+    g_byte_array_append(binary_fields, (const guint8 *)&field_index, sizeof field_index);
+    g_byte_array_append(binary_fields, (const guint8 *)&type, sizeof type);
+    g_byte_array_append(binary_fields, (const guint8 *)&len, sizeof len);
+    if (len != 0)
+        g_byte_array_append(binary_fields, value, len);
+    wmem_free(NULL, str);
+}
+
+/*
+ * Write a packet's record: a guint32 length of the rest of the record,
+ * the guint32 frame number, a guint64 with bit n set if the packet
+ * passed read filter n, and then the fields in binary_fields.
+ */
+static void
+write_binary_record(guint32 frame_num, guint64 passed_mask)
+{
+    guint32 rec_len = (guint32)(sizeof frame_num + sizeof passed_mask + binary_fields->len);
+
+    fwrite(&rec_len, sizeof rec_len, 1, stdout);
+    fwrite(&frame_num, sizeof frame_num, 1, stdout);
+    fwrite(&passed_mask, sizeof passed_mask, 1, stdout);
+    fwrite(binary_fields->data, 1, binary_fields->len, stdout);
+    g_byte_array_set_size(binary_fields, 0);
+}
+
 static tap_packet_status
 protocolinfo_packet(void *prs, packet_info *pinfo _U_, epan_dissect_t *edt, const void *dummy _U_, tap_flags_t flags _U_)
 {
@@ -1265,7 +1506,8 @@ protocolinfo_packet(void *prs, packet_info *pinfo _U_, epan_dissect_t *edt, cons
 
     gp=proto_get_finfo_ptr_array(edt->tree, rs->hf_index);
     if(!gp){
-        printf(" n.a.");
+        if (!binary_output)
+            printf(" n.a.");
         return TAP_PACKET_DONT_REDRAW;
     }
 
@@ -1273,7 +1515,10 @@ protocolinfo_packet(void *prs, packet_info *pinfo _U_, epan_dissect_t *edt, cons
      * Print each occurrence of the field
      */
     for (i = 0; i < gp->len; i++) {
-        print_field_value((field_info *)gp->pdata[i], rs->cmd_line_index);
+        if (binary_output)
+            append_binary_field((field_info *)gp->pdata[i], rs->cmd_line_index);
+        else
+            print_field_value((field_info *)gp->pdata[i], rs->cmd_line_index);
     }
 
     return TAP_PACKET_DONT_REDRAW;
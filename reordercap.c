@@ -17,6 +17,7 @@
 #include <glib.h>
 
 #include <wsutil/ws_getopt.h>
+#include <wsutil/strtoi.h>
 
 #include <wiretap/wtap.h>
 
@@ -50,6 +51,9 @@ print_usage(FILE *output)
     fprintf(output, "\n");
     fprintf(output, "Options:\n");
     fprintf(output, "  -n        don't write to output file if the input file is ordered.\n");
+    fprintf(output, "  -s <frames>\n");
+    fprintf(output, "            sort in one pass, holding at most <frames> frames back;\n");
+    fprintf(output, "            frames out of place by more than that stay out of order.\n");
     fprintf(output, "  -h        display this help and exit.\n");
     fprintf(output, "  -v        print version information and exit.\n");
 }
@@ -132,6 +136,65 @@ frames_compare(gconstpointer a, gconstpointer b)
     return nstime_cmp(time1, time2);
 }
 
+/*
+ * For -s: a binary heap of the frames that have been read but not yet
+ * written, earliest at the top.  Frames with the same timestamp come out
+ * in the order they were read, as they do from the full sort.
+ */
+static gboolean
+heap_less(GPtrArray *heap, guint i, guint j)
+{
+    const FrameRecord_t *frame1 = (const FrameRecord_t *)heap->pdata[i];
+    const FrameRecord_t *frame2 = (const FrameRecord_t *)heap->pdata[j];
+    int cmp = nstime_cmp(&frame1->frame_time, &frame2->frame_time);
+
+    return cmp < 0 || (cmp == 0 && frame1->num < frame2->num);
+}
+
+static void
+heap_swap(GPtrArray *heap, guint i, guint j)
+{
+    gpointer tmp = heap->pdata[i];
+
+    heap->pdata[i] = heap->pdata[j];
+    heap->pdata[j] = tmp;
+}
+
+static void
+heap_push(GPtrArray *heap, FrameRecord_t *frame)
+{
+    guint i = heap->len;
+
+    g_ptr_array_add(heap, frame);
+    while (i > 0 && heap_less(heap, i, (i - 1) / 2)) {
+        heap_swap(heap, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static FrameRecord_t *
+heap_pop(GPtrArray *heap)
+{
+    FrameRecord_t *top = (FrameRecord_t *)heap->pdata[0];
+    guint i = 0;
+
+    heap->pdata[0] = heap->pdata[heap->len - 1];
+    g_ptr_array_set_size(heap, heap->len - 1);
+    for (;;) {
+        guint child = 2 * i + 1;
+
+        if (child >= heap->len)
+            break;
+        if (child + 1 < heap->len && heap_less(heap, child + 1, child))
+            child++;
+        if (!heap_less(heap, child, i))
+            break;
+        heap_swap(heap, i, child);
+        i = child;
+    }
+    return top;
+}
+
 /*
  * General errors and warnings are reported with an console message
  * in reordercap.
@@ -182,12 +245,20 @@ main(int argc, char *argv[])
     gint64 data_offset;
     guint wrong_order_count = 0;
     gboolean write_output_regardless = TRUE;
+    guint32 sort_window = 0;
+    guint still_wrong_order_count = 0;
     guint i;
     wtap_dump_params params;
     int                          ret = EXIT_SUCCESS;
 
     GPtrArray *frames;
     FrameRecord_t *prevFrame = NULL;
+    nstime_t last_read_time;
+    nstime_t last_written_time;
+    wtap_rec out_rec;
+    Buffer out_buf;
+    guint frame_count = 0;
+    guint frames_written = 0;
 
     int opt;
     static const struct ws_option long_options[] = {
@@ -234,11 +305,18 @@ main(int argc, char *argv[])
     wtap_init(TRUE);
 
     /* Process the options first */
-    while ((opt = ws_getopt_long(argc, argv, "hnv", long_options, NULL)) != -1) {
+    while ((opt = ws_getopt_long(argc, argv, "hns:v", long_options, NULL)) != -1) {
         switch (opt) {
             case 'n':
                 write_output_regardless = FALSE;
                 break;
+            case 's':
+                if (!ws_strtou32(ws_optarg, NULL, &sort_window) || sort_window == 0) {
+                    cmdarg_err("\"%s\" isn't a valid number of frames", ws_optarg);
+                    ret = INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
             case 'h':
                 show_help_header("Reorder timestamps of input file frames into output file.");
                 print_usage(stdout);
@@ -253,6 +331,13 @@ main(int argc, char *argv[])
         }
     }
 
+    if (sort_window != 0 && !write_output_regardless) {
+        /* We don't know whether the file is in order until we've written it. */
+        cmdarg_err("-n can't be used with -s");
+        ret = INVALID_OPTION;
+        goto clean_exit;
+    }
+
     /* Remaining args are file names */
     file_count = argc - ws_optind;
     if (file_count == 2) {
@@ -297,6 +382,74 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    if (sort_window != 0) {
+        /*
+         * Read the file once, writing each frame as soon as more than
+         * sort_window frames have been read after it, so that only
+         * that many frames are held at once and the frames are re-read
+         * from near where we're reading.
+         */
+        frames = g_ptr_array_sized_new(MIN(sort_window, 65536) + 1);
+        nstime_set_unset(&last_read_time);
+        nstime_set_unset(&last_written_time);
+
+        wtap_rec_init(&rec);
+        ws_buffer_init(&buf, 1514);
+        wtap_rec_init(&out_rec);
+        ws_buffer_init(&out_buf, 1514);
+        for (;;) {
+            FrameRecord_t *frame;
+
+            if (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+                frame = g_slice_new(FrameRecord_t);
+                frame->num = ++frame_count;
+                frame->offset = data_offset;
+                if (rec.presence_flags & WTAP_HAS_TS) {
+                    frame->frame_time = rec.ts;
+                } else {
+                    nstime_set_unset(&frame->frame_time);
+                }
+                if (frame_count > 1 && nstime_cmp(&frame->frame_time, &last_read_time) < 0) {
+                    wrong_order_count++;
+                }
+                last_read_time = frame->frame_time;
+                heap_push(frames, frame);
+                wtap_rec_reset(&rec);
+                if (frames->len <= sort_window)
+                    continue;
+            } else if (frames->len == 0) {
+                break;
+            }
+
+            /* Write the earliest of the frames we're holding. */
+            frame = heap_pop(frames);
+            if (frames_written > 0 &&
+                nstime_cmp(&frame->frame_time, &last_written_time) < 0) {
+                still_wrong_order_count++;
+            }
+            last_written_time = frame->frame_time;
+            frames_written++;
+            frame_write(frame, wth, pdh, &out_rec, &out_buf, infile, outfile);
+            g_slice_free(FrameRecord_t, frame);
+        }
+        wtap_rec_cleanup(&out_rec);
+        ws_buffer_free(&out_buf);
+        wtap_rec_cleanup(&rec);
+        ws_buffer_free(&buf);
+        if (err != 0) {
+          /* Print a message noting that the read failed somewhere along the line. */
+          cfile_read_failure_message(infile, err, err_info);
+        }
+
+        printf("%u frames, %u out of order\n", frame_count, wrong_order_count);
+        if (still_wrong_order_count > 0) {
+            printf("%u frames were out of place by more than %u frames, and are still out of order\n",
+                   still_wrong_order_count, sort_window);
+        }
+        g_ptr_array_free(frames, TRUE);
+        goto close_files;
+    }
+
     /* Allocate the array of frame pointers. */
     frames = g_ptr_array_new();
 
@@ -359,6 +512,7 @@ main(int argc, char *argv[])
     /* Free the whole array */
     g_ptr_array_free(frames, TRUE);
 
+close_files:
     /* Close outfile */
     if (!wtap_dump_close(pdh, NULL, &err, &err_info)) {
         cfile_close_failure_message(outfile, err, err_info);
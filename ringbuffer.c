@@ -28,6 +28,7 @@
  *
  */
 
+#define _GNU_SOURCE /* For fallocate() and fopencookie(). */
 #include <config.h>
 
 #ifdef HAVE_LIBPCAP
@@ -47,6 +48,10 @@
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_FALLOCATE
+#include <fcntl.h>
+#endif
+
 #ifdef _WIN32
 #include <wsutil/win32-utils.h>
 #endif
@@ -58,6 +63,23 @@
 #include <zlib.h>
 #endif
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#include <wiretap/file_wrappers.h>
+#endif
+
+#if (defined(HAVE_ZLIB) || defined(HAVE_ZSTD)) && \
+    (defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN))
+/* We can compress files as they're written */
+#define RINGBUF_COMPRESS_INLINE
+#endif
+
+typedef enum {
+    RB_COMPRESS_NONE,
+    RB_COMPRESS_GZIP,
+    RB_COMPRESS_ZSTD
+} rb_compress_type;
+
 /* Ringbuffer file structure */
 typedef struct _rb_file {
     gchar         *name;
@@ -80,12 +102,32 @@ typedef struct _ringbuf_data {
     char         *io_buffer;              /**< The IO buffer used to write to the file */
     gboolean      group_read_access;   /**< TRUE if files need to be opened with group read access */
     FILE         *name_h;              /**< write names of completed files to this handle */
-    gchar        *compress_type;       /**< compress type */
+    rb_compress_type compress;         /**< compress type */
+    int           compress_level;      /**< compression level */
+    gboolean      compress_inline;     /**< TRUE if files are compressed as they're written */
 
     GMutex        mutex;               /**< mutex for oldnames */
     gchar        *oldnames[MAX_FILENAME_QUEUE];       /**< filename list of pending to be deleted */
+
+    guint64       file_size_hint;      /**< Expected size of each file, 0 if unknown */
+    gchar        *next_name;           /**< Temporary name of the file we'll switch to next */
+    int           next_fd;             /**< That file, once prepare_thread has opened it */
+    int           next_err;            /**< Or the error opening it */
+    GThread      *prepare_thread;      /**< Opening the next file */
+    GThread      *retire_thread;       /**< Closing the previous file */
+    int           retire_err;          /**< Error closing the previous file, if any */
 } ringbuf_data;
 
+/* A file we've switched away from, to be closed by retire_thread */
+typedef struct _rb_retire_job {
+    FILE         *pdh;
+    int           fd;
+    char         *io_buffer;
+    gchar        *name;                /**< The file's name */
+    gchar        *stale_name;          /**< File it replaces in the ring, to be deleted */
+    gboolean      compress;            /**< TRUE to compress the file once it's closed */
+} rb_retire_job;
+
 static ringbuf_data rb_data;
 
 /*
@@ -125,56 +167,221 @@ CleanupOldCap(gchar* name)
     g_mutex_unlock(&rb_data.mutex);
 }
 
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
+/*
+ * Files are compressed in independent chunks of RINGBUF_COMPRESS_CHUNK
+ * bytes, as separate gzip members or as separate zstd frames followed
+ * by a zstd seek table, so that readers can start decompressing at any
+ * chunk rather than only at the start of the file.
+ */
+#define RINGBUF_COMPRESS_CHUNK (1024 * 1024)
+
+static const char *
+ringbuf_compress_extension(void)
+{
+    return rb_data.compress == RB_COMPRESS_ZSTD ? ".zst" : ".gz";
+}
+
+/* Largest size a compressed chunk can have */
+static size_t
+ringbuf_compress_bound(void)
+{
+#ifdef HAVE_ZSTD
+    if (rb_data.compress == RB_COMPRESS_ZSTD)
+        return ZSTD_compressBound(RINGBUF_COMPRESS_CHUNK);
+#endif
+#ifdef HAVE_ZLIB
+    /* deflateBound() for a gzip stream, with room for the header. */
+    return compressBound(RINGBUF_COMPRESS_CHUNK) + 18 + 64;
+#else
+    return 0;
+#endif
+}
+
+#ifdef HAVE_ZSTD
+/* One compression context per thread that compresses */
+static GPrivate ringbuf_zstd_cctx = G_PRIVATE_INIT((GDestroyNotify)ZSTD_freeCCtx);
+#endif
+
+/*
+ * Compress a chunk as a complete gzip member or zstd frame; returns the
+ * compressed size, or 0 on error.  dst must be at least
+ * ringbuf_compress_bound() bytes.
+ */
+static size_t
+ringbuf_compress_chunk(guint8 *dst, size_t dst_size, const guint8 *src, size_t src_len)
+{
+#ifdef HAVE_ZSTD
+    if (rb_data.compress == RB_COMPRESS_ZSTD) {
+        ZSTD_CCtx *cctx = (ZSTD_CCtx *)g_private_get(&ringbuf_zstd_cctx);
+        size_t ret;
+
+        if (cctx == NULL) {
+            cctx = ZSTD_createCCtx();
+            if (cctx == NULL)
+                return 0;
+            g_private_set(&ringbuf_zstd_cctx, cctx);
+        }
+        ret = ZSTD_compressCCtx(cctx, dst, dst_size, src, src_len, rb_data.compress_level);
+        return ZSTD_isError(ret) ? 0 : ret;
+    }
+#endif
 #ifdef HAVE_ZLIB
+    if (rb_data.compress == RB_COMPRESS_GZIP) {
+        z_stream zs;
+        size_t ret = 0;
+
+        memset(&zs, 0, sizeof zs);
+        /* 16 + 15 for a gzip header and trailer with the largest window. */
+        if (deflateInit2(&zs, rb_data.compress_level, Z_DEFLATED, 16 + 15, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+            return 0;
+        zs.next_in = (Bytef *)src;
+        zs.avail_in = (uInt)src_len;
+        zs.next_out = dst;
+        zs.avail_out = (uInt)dst_size;
+        if (deflate(&zs, Z_FINISH) == Z_STREAM_END)
+            ret = zs.total_out;
+        deflateEnd(&zs);
+        return ret;
+    }
+#endif
+    return 0;
+}
+
+static gboolean
+ringbuf_write_all(int fd, const guint8 *data, size_t len)
+{
+    ssize_t nwritten;
+
+    while (len != 0) {
+        nwritten = ws_write(fd, data, (unsigned int)len);
+        if (nwritten <= 0)
+            return FALSE;
+        data += nwritten;
+        len -= nwritten;
+    }
+    return TRUE;
+}
+
+/*
+ * Where compressed chunks go.  gzip members are written straight to the
+ * file; zstd frames go through the wiretap zstd writer, which puts the
+ * seek table after them when the file is closed.
+ */
+typedef struct _rb_compress_out {
+    int           fd;
+#ifdef HAVE_ZSTD
+    ZSTDWFILE_T   zstd;                     /**< Opened when the first frame is written */
+#endif
+} rb_compress_out;
+
+static void
+ringbuf_compress_out_init(rb_compress_out *out, int fd)
+{
+    out->fd = fd;
+#ifdef HAVE_ZSTD
+    out->zstd = NULL;
+#endif
+}
+
+/* Write a chunk compressed from src_len bytes; returns FALSE on error. */
+static gboolean
+ringbuf_compress_out_put(rb_compress_out *out, const guint8 *chunk, size_t len, size_t src_len)
+{
+#ifdef HAVE_ZSTD
+    if (rb_data.compress == RB_COMPRESS_ZSTD) {
+        if (out->zstd == NULL && (out->zstd = zstdwfile_fdopen(out->fd)) == NULL)
+            return FALSE;
+        return zstdwfile_write_frame(out->zstd, chunk, (guint)len, (guint)src_len) == 0;
+    }
+#else
+    (void)src_len;
+#endif
+    return ringbuf_write_all(out->fd, chunk, len);
+}
+
+/* Finish the file and close it; returns 0, or an errno value on error. */
+static int
+ringbuf_compress_out_close(rb_compress_out *out)
+{
+#ifdef HAVE_ZSTD
+    if (out->zstd != NULL) {
+        int err = zstdwfile_close(out->zstd);
+
+        /* The only Wiretap error it can report here is a short write. */
+        return err < 0 ? ENOSPC : err;
+    }
+#endif
+    return ws_close(out->fd) < 0 ? errno : 0;
+}
+
+/*
+ * Read up to RINGBUF_COMPRESS_CHUNK bytes; returns the number of bytes
+ * read, 0 at the end of the file, or -1 on error.
+ */
+static ssize_t
+ringbuf_read_chunk(int fd, guint8 *buffer)
+{
+    ssize_t nread, total = 0;
+
+    while (total < RINGBUF_COMPRESS_CHUNK) {
+        nread = ws_read(fd, buffer + total, (unsigned int)(RINGBUF_COMPRESS_CHUNK - total));
+        if (nread < 0)
+            return -1;
+        if (nread == 0)
+            break;
+        total += nread;
+    }
+    return total;
+}
+
 /*
  * compress capture file
  */
 static int
 ringbuf_exec_compress(gchar* name)
 {
-    guint8  *buffer = NULL;
-    gchar* outgz = NULL;
-    int  fd = -1;
-    ssize_t nread;
+    guint8  *buffer = NULL, *out = NULL;
+    size_t   out_size, ret;
+    ssize_t  nread = 0;
+    gchar   *outname;
+    int  fd = -1, outfd;
+    rb_compress_out output;
     gboolean delete_org_file = TRUE;
-    gzFile fi = NULL;
 
     fd = ws_open(name, O_RDONLY | O_BINARY, 0000);
     if (fd < 0) {
+        g_free(name);
         return -1;
     }
-
-    outgz = ws_strdup_printf("%s.gz", name);
-    fi = gzopen(outgz, "wb");
-    g_free(outgz);
-    if (fi == NULL) {
+    outname = ws_strdup_printf("%s%s", name, ringbuf_compress_extension());
+    outfd = ws_open(outname, O_BINARY|O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    g_free(outname);
+    if (outfd < 0) {
         ws_close(fd);
+        g_free(name);
         return -1;
     }
 
-#define FS_READ_SIZE 65536
-    buffer = (guint8*)g_malloc(FS_READ_SIZE);
-    if (buffer == NULL) {
-        ws_close(fd);
-        gzclose(fi);
-        return -1;
-    }
-
-    while ((nread = ws_read(fd, buffer, FS_READ_SIZE)) > 0) {
-        int n = gzwrite(fi, buffer, (unsigned int)nread);
-        if (n <= 0) {
-            /* mark compression as failed */
+    buffer = (guint8*)g_malloc(RINGBUF_COMPRESS_CHUNK);
+    out_size = ringbuf_compress_bound();
+    out = (guint8*)g_malloc(out_size);
+    ringbuf_compress_out_init(&output, outfd);
+    while ((nread = ringbuf_read_chunk(fd, buffer)) > 0) {
+        ret = ringbuf_compress_chunk(out, out_size, buffer, (size_t)nread);
+        if (ret == 0 || !ringbuf_compress_out_put(&output, out, ret, (size_t)nread)) {
             delete_org_file = FALSE;
             break;
         }
     }
-    if (nread < 0) {
-        /* mark compression as failed */
+    if (nread < 0)
+        delete_org_file = FALSE;
+    if (ringbuf_compress_out_close(&output) != 0)
         delete_org_file = FALSE;
-    }
     ws_close(fd);
-    gzclose(fi);
     g_free(buffer);
+    g_free(out);
 
     /* delete the original file only if compression succeeds */
     if (delete_org_file) {
@@ -199,37 +406,247 @@ exec_compress_thread(void* arg)
  * start a thread to compress capture file
  */
 static int
-ringbuf_start_compress_file(rb_file* rfile)
+ringbuf_start_compress_file(const gchar* fname)
 {
-    gchar* name = g_strdup(rfile->name);
+    gchar* name = g_strdup(fname);
     g_thread_new("exec_compress", &exec_compress_thread, name);
     return 0;
 }
-#endif
+
+#ifdef RINGBUF_COMPRESS_INLINE
+/*
+ * Compressing while writing.
+ *
+ * The FILE we hand out writes into a stream that collects the data in
+ * chunks and hands each chunk to a pool of worker threads to compress;
+ * the compressed chunks are written to the file in order, as they're
+ * finished, by whichever thread is writing to or closing the stream.
+ * The file is never read back, and the capture loop only ever waits for
+ * compression if the workers fall RINGBUF_COMPRESS_JOBS_PER_THREAD
+ * chunks per thread behind.
+ */
+#define RINGBUF_COMPRESS_MAX_THREADS    4
+#define RINGBUF_COMPRESS_JOBS_PER_THREAD 2
+
+typedef struct _rb_compress_job {
+    guint8       *src;
+    size_t        src_len;
+    guint8       *dst;
+    size_t        dst_len;                  /**< 0 if compression failed */
+    gboolean      done;                     /**< TRUE once a worker has finished it */
+    struct _rb_cstream *stream;
+} rb_compress_job;
+
+typedef struct _rb_cstream {
+    rb_compress_out out;
+    guint8       *in;                       /**< Chunk being filled */
+    size_t        in_len;
+    GMutex        mutex;
+    GCond         cond;
+    GQueue        jobs;                     /**< Chunks being compressed, in file order */
+    int           err;
+} rb_cstream;
+
+static GThreadPool *ringbuf_compress_pool;
+static guint ringbuf_compress_threads;
+
+static void
+ringbuf_compress_worker(gpointer data, gpointer user_data _U_)
+{
+    rb_compress_job *job = (rb_compress_job *)data;
+    rb_cstream *stream = job->stream;
+
+    job->dst_len = ringbuf_compress_chunk(job->dst, ringbuf_compress_bound(),
+                                          job->src, job->src_len);
+    g_mutex_lock(&stream->mutex);
+    job->done = TRUE;
+    g_cond_broadcast(&stream->cond);
+    g_mutex_unlock(&stream->mutex);
+}
 
 /*
- * create the next filename and open a new binary file with that name
+ * Write out the compressed chunks at the head of the queue, waiting for
+ * them to be compressed until there are no more than max_jobs left.
  */
+static void
+ringbuf_cstream_drain(rb_cstream *stream, guint max_jobs)
+{
+    rb_compress_job *job;
+
+    g_mutex_lock(&stream->mutex);
+    while ((job = (rb_compress_job *)g_queue_peek_head(&stream->jobs)) != NULL) {
+        if (!job->done) {
+            if (g_queue_get_length(&stream->jobs) <= max_jobs)
+                break;
+            g_cond_wait(&stream->cond, &stream->mutex);
+            continue;
+        }
+        g_queue_pop_head(&stream->jobs);
+        g_mutex_unlock(&stream->mutex);
+        if (stream->err == 0) {
+            if (job->dst_len == 0) {
+                stream->err = ENOMEM;
+            } else if (!ringbuf_compress_out_put(&stream->out, job->dst, job->dst_len, job->src_len)) {
+                stream->err = errno != 0 ? errno : ENOSPC;
+            }
+        }
+        g_free(job->src);
+        g_free(job->dst);
+        g_free(job);
+        g_mutex_lock(&stream->mutex);
+    }
+    g_mutex_unlock(&stream->mutex);
+}
+
+static void
+ringbuf_cstream_submit(rb_cstream *stream)
+{
+    rb_compress_job *job;
+
+    if (stream->in_len == 0)
+        return;
+    job = g_new0(rb_compress_job, 1);
+    job->src = stream->in;
+    job->src_len = stream->in_len;
+    job->dst = (guint8 *)g_malloc(ringbuf_compress_bound());
+    job->stream = stream;
+    stream->in = (guint8 *)g_malloc(RINGBUF_COMPRESS_CHUNK);
+    stream->in_len = 0;
+    g_mutex_lock(&stream->mutex);
+    g_queue_push_tail(&stream->jobs, job);
+    g_mutex_unlock(&stream->mutex);
+    g_thread_pool_push(ringbuf_compress_pool, job, NULL);
+    ringbuf_cstream_drain(stream, ringbuf_compress_threads * RINGBUF_COMPRESS_JOBS_PER_THREAD);
+}
+
+static ssize_t
+ringbuf_cstream_write(rb_cstream *stream, const char *buf, size_t size)
+{
+    size_t left = size;
+
+    while (left != 0) {
+        size_t n = MIN(left, RINGBUF_COMPRESS_CHUNK - stream->in_len);
+
+        memcpy(stream->in + stream->in_len, buf, n);
+        stream->in_len += n;
+        buf += n;
+        left -= n;
+        if (stream->in_len == RINGBUF_COMPRESS_CHUNK)
+            ringbuf_cstream_submit(stream);
+    }
+    if (stream->err != 0) {
+        errno = stream->err;
+        return -1;
+    }
+    return (ssize_t)size;
+}
+
 static int
-ringbuf_open_file(rb_file *rfile, int *err)
+ringbuf_cstream_close(rb_cstream *stream)
+{
+    int err;
+
+    ringbuf_cstream_submit(stream);
+    ringbuf_cstream_drain(stream, 0);
+    err = ringbuf_compress_out_close(&stream->out);
+    if (stream->err != 0)
+        err = stream->err;
+    g_free(stream->in);
+    g_mutex_clear(&stream->mutex);
+    g_cond_clear(&stream->cond);
+    g_free(stream);
+    if (err != 0) {
+        errno = err;
+        return EOF;
+    }
+    return 0;
+}
+
+#ifdef HAVE_FOPENCOOKIE
+static ssize_t
+ringbuf_cookie_write(void *cookie, const char *buf, size_t size)
+{
+    return ringbuf_cstream_write((rb_cstream *)cookie, buf, size);
+}
+
+static int
+ringbuf_cookie_close(void *cookie)
+{
+    return ringbuf_cstream_close((rb_cstream *)cookie);
+}
+#else
+static int
+ringbuf_cookie_write(void *cookie, const char *buf, int size)
+{
+    return (int)ringbuf_cstream_write((rb_cstream *)cookie, buf, (size_t)size);
+}
+
+static int
+ringbuf_cookie_close(void *cookie)
+{
+    return ringbuf_cstream_close((rb_cstream *)cookie);
+}
+#endif
+
+/*
+ * Open a FILE that compresses what's written to it into fd, and closes
+ * fd when it's closed.
+ */
+static FILE *
+ringbuf_cstream_fdopen(int fd)
+{
+    rb_cstream *stream;
+    FILE *fh;
+
+    if (ringbuf_compress_pool == NULL) {
+        ringbuf_compress_threads = CLAMP(g_get_num_processors() / 2, 1, RINGBUF_COMPRESS_MAX_THREADS);
+        ringbuf_compress_pool = g_thread_pool_new(ringbuf_compress_worker, NULL,
+                                                  ringbuf_compress_threads, FALSE, NULL);
+    }
+
+    stream = g_new0(rb_cstream, 1);
+    ringbuf_compress_out_init(&stream->out, fd);
+    stream->in = (guint8 *)g_malloc(RINGBUF_COMPRESS_CHUNK);
+    g_mutex_init(&stream->mutex);
+    g_cond_init(&stream->cond);
+    g_queue_init(&stream->jobs);
+#ifdef HAVE_FOPENCOOKIE
+    {
+        cookie_io_functions_t funcs = { NULL, ringbuf_cookie_write, NULL, ringbuf_cookie_close };
+
+        fh = fopencookie(stream, "wb", funcs);
+    }
+#else
+    fh = funopen(stream, NULL, ringbuf_cookie_write, NULL, ringbuf_cookie_close);
+#endif
+    if (fh == NULL) {
+        g_free(stream->in);
+        g_mutex_clear(&stream->mutex);
+        g_cond_clear(&stream->cond);
+        g_free(stream);
+    }
+    return fh;
+}
+#endif /* RINGBUF_COMPRESS_INLINE */
+#endif /* HAVE_ZLIB || HAVE_ZSTD */
+
+/*
+ * create the name of the current file
+ */
+static gchar *
+ringbuf_file_name(void)
 {
     char    filenum[5+1];
     char    timestr[14+1];
     time_t  current_time;
     struct tm *tm;
+    const char *suffix = rb_data.fsuffix ? rb_data.fsuffix : "";
+    const char *extension = "";
 
-    if (rfile->name != NULL) {
-        if (rb_data.unlimited == FALSE) {
-            /* remove old file (if any, so ignore error) */
-            ws_unlink(rfile->name);
-        }
-#ifdef HAVE_ZLIB
-        else if (rb_data.compress_type != NULL && strcmp(rb_data.compress_type, "gzip") == 0) {
-            ringbuf_start_compress_file(rfile);
-        }
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
+    if (rb_data.compress_inline)
+        extension = ringbuf_compress_extension();
 #endif
-        g_free(rfile->name);
-    }
 
 #ifdef _WIN32
     _tzset();
@@ -243,17 +660,19 @@ ringbuf_open_file(rb_file *rfile, int *err)
     else
         (void) g_strlcpy(timestr, "196912312359", sizeof(timestr)); /* second before the Epoch */
     if (rb_data.nametimenum) {
-        rfile->name = g_strconcat(rb_data.fprefix, "_", timestr, "_", filenum, rb_data.fsuffix, NULL);
+        return g_strconcat(rb_data.fprefix, "_", timestr, "_", filenum, suffix, extension, NULL);
     } else {
-        rfile->name = g_strconcat(rb_data.fprefix, "_", filenum, "_", timestr, rb_data.fsuffix, NULL);
-    }
-
-    if (rfile->name == NULL) {
-        if (err != NULL)
-            *err = ENOMEM;
-        return -1;
+        return g_strconcat(rb_data.fprefix, "_", filenum, "_", timestr, suffix, extension, NULL);
     }
+}
 
+/*
+ * create the first filename and open a new binary file with that name
+ */
+static int
+ringbuf_open_file(rb_file *rfile, int *err)
+{
+    rfile->name = ringbuf_file_name();
     rb_data.fd = ws_open(rfile->name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT,
             rb_data.group_read_access ? 0640 : 0600);
 
@@ -264,12 +683,192 @@ ringbuf_open_file(rb_file *rfile, int *err)
     return rb_data.fd;
 }
 
+/*
+ * Switching files happens when the capture loop is busiest, so as
+ * little of it as possible is done then.  The next file is created
+ * ahead of time, under a temporary name, by prepare_thread, and if we
+ * know how big it will get its space is allocated up front, without
+ * changing its size, so that readers of the live file aren't affected;
+ * the switch itself only renames it.  The file switched away from is
+ * closed, and the file it replaces in the ring deleted, by
+ * retire_thread.
+ */
+static void *
+ringbuf_prepare_thread(void *arg _U_)
+{
+    int fd;
+
+    fd = ws_open(rb_data.next_name, O_RDWR|O_BINARY|O_TRUNC|O_CREAT,
+            rb_data.group_read_access ? 0640 : 0600);
+    if (fd == -1) {
+        rb_data.next_err = errno;
+    }
+#ifdef HAVE_FALLOCATE
+    else if (rb_data.file_size_hint != 0) {
+        /* Not every file system can do this; that's fine. */
+        (void) fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)rb_data.file_size_hint);
+    }
+#endif
+    rb_data.next_fd = fd;
+    return NULL;
+}
+
+static void
+ringbuf_start_prepare(void)
+{
+    rb_data.next_fd = -1;
+    rb_data.next_err = 0;
+    rb_data.prepare_thread = g_thread_new("ringbuf_prepare", ringbuf_prepare_thread, NULL);
+}
+
+/*
+ * Wait for the file prepare_thread opened, rename it to name, and make
+ * it the current file.
+ */
+static int
+ringbuf_take_prepared_file(const gchar *name, int *err)
+{
+    g_thread_join(rb_data.prepare_thread);
+    rb_data.prepare_thread = NULL;
+    rb_data.fd = rb_data.next_fd;
+    rb_data.next_fd = -1;
+    if (rb_data.fd == -1) {
+        if (err != NULL)
+            *err = rb_data.next_err;
+        return -1;
+    }
+    if (ws_rename(rb_data.next_name, name) != 0) {
+        if (err != NULL)
+            *err = errno;
+        ws_close(rb_data.fd);
+        ws_unlink(rb_data.next_name);
+        rb_data.fd = -1;
+        return -1;
+    }
+    return rb_data.fd;
+}
+
+/*
+ * Free the space allocated for a file beyond what was written to it.
+ */
+static void
+ringbuf_trim_file(FILE *pdh _U_, int fd _U_)
+{
+#ifdef HAVE_FALLOCATE
+    if (rb_data.file_size_hint != 0 && fflush(pdh) == 0) {
+        gint64 size = ws_lseek64(fd, 0, SEEK_CUR);
+
+        if (size >= 0)
+            (void) ftruncate(fd, (off_t)size);
+    }
+#endif
+}
+
+static void *
+ringbuf_retire_thread(void *arg)
+{
+    rb_retire_job *job = (rb_retire_job *)arg;
+
+    ringbuf_trim_file(job->pdh, job->fd);
+    if (fclose(job->pdh) == EOF) {
+        rb_data.retire_err = errno;
+    }
+    g_free(job->io_buffer);
+
+    if (rb_data.name_h != NULL) {
+        fprintf(rb_data.name_h, "%s\n", job->name);
+        fflush(rb_data.name_h);
+    }
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
+    if (job->compress) {
+        ringbuf_start_compress_file(job->name);
+    }
+#endif
+    if (job->stale_name != NULL) {
+        /* remove old file (if any, so ignore error) */
+        ws_unlink(job->stale_name);
+    }
+
+    g_free(job->name);
+    g_free(job->stale_name);
+    g_free(job);
+    return NULL;
+}
+
+/*
+ * Wait for the previous file to be closed; returns FALSE, with the
+ * error in *err, if closing it failed.
+ */
+static gboolean
+ringbuf_wait_retired(int *err)
+{
+    if (rb_data.retire_thread != NULL) {
+        g_thread_join(rb_data.retire_thread);
+        rb_data.retire_thread = NULL;
+    }
+    if (rb_data.retire_err != 0) {
+        if (err != NULL)
+            *err = rb_data.retire_err;
+        rb_data.retire_err = 0;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Stop preparing the next file, and delete it if it was created.
+ */
+static void
+ringbuf_cancel_prepare(void)
+{
+    if (rb_data.prepare_thread != NULL) {
+        g_thread_join(rb_data.prepare_thread);
+        rb_data.prepare_thread = NULL;
+        if (rb_data.next_fd != -1) {
+            ws_close(rb_data.next_fd);
+            rb_data.next_fd = -1;
+            ws_unlink(rb_data.next_name);
+        }
+    }
+}
+
+/*
+ * Parse "none", "gzip", or "zstd", optionally followed by ":" and a
+ * compression level; capture_opts has already checked it.
+ */
+static void
+ringbuf_parse_compress_type(const gchar *compress_type)
+{
+    const gchar *level;
+
+    rb_data.compress = RB_COMPRESS_NONE;
+    rb_data.compress_level = 0;
+    if (compress_type == NULL)
+        return;
+#ifdef HAVE_ZLIB
+    if (g_str_has_prefix(compress_type, "gzip")) {
+        rb_data.compress = RB_COMPRESS_GZIP;
+        rb_data.compress_level = Z_DEFAULT_COMPRESSION;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (g_str_has_prefix(compress_type, "zstd")) {
+        rb_data.compress = RB_COMPRESS_ZSTD;
+        rb_data.compress_level = 3; /* ZSTD_CLEVEL_DEFAULT */
+    }
+#endif
+    level = strchr(compress_type, ':');
+    if (rb_data.compress != RB_COMPRESS_NONE && level != NULL)
+        rb_data.compress_level = (int)strtol(level + 1, NULL, 10);
+}
+
 /*
  * Initialize the ringbuffer data structures
  */
 int
 ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_access,
-        gchar *compress_type, gboolean has_nametimenum)
+        gchar *compress_type, gboolean compress_inline, gboolean has_nametimenum,
+        guint64 file_size_hint)
 {
     unsigned int i;
     char        *pfx, *last_pathsep;
@@ -286,8 +885,15 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
     rb_data.io_buffer = NULL;
     rb_data.group_read_access = group_read_access;
     rb_data.name_h = NULL;
-    rb_data.compress_type = compress_type;
+    ringbuf_parse_compress_type(compress_type);
+    rb_data.compress_inline = FALSE;
     g_mutex_init(&rb_data.mutex);
+    rb_data.file_size_hint = file_size_hint;
+    rb_data.next_name = NULL;
+    rb_data.next_fd = -1;
+    rb_data.prepare_thread = NULL;
+    rb_data.retire_thread = NULL;
+    rb_data.retire_err = 0;
 
     /* just to be sure ... */
     if (num_files <= RINGBUFFER_MAX_NUM_FILES) {
@@ -330,6 +936,8 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
     }
     g_free(save_file);
     save_file = NULL;
+    rb_data.next_name = g_strconcat(rb_data.fprefix, "_next",
+                                    rb_data.fsuffix ? rb_data.fsuffix : "", ".tmp", NULL);
 
     /* allocate rb_file structures (only one if unlimited since there is no
        need to save all file names in that case) */
@@ -337,6 +945,13 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
     if (num_files == RINGBUFFER_UNLIMITED_FILES) {
         rb_data.unlimited = TRUE;
         rb_data.num_files = 1;
+#ifdef RINGBUF_COMPRESS_INLINE
+        if (compress_inline && rb_data.compress != RB_COMPRESS_NONE) {
+            /* We don't know how big the compressed files will get. */
+            rb_data.compress_inline = TRUE;
+            rb_data.file_size_hint = 0;
+        }
+#endif
     }
 
     rb_data.files = g_new(rb_file, rb_data.num_files);
@@ -353,6 +968,7 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
         ringbuf_error_cleanup();
         return -1;
     }
+    ringbuf_start_prepare();
 
     return rb_data.fd;
 }
@@ -408,18 +1024,23 @@ ringbuf_current_filename(void)
 FILE *
 ringbuf_init_libpcap_fdopen(int *err)
 {
+#ifdef RINGBUF_COMPRESS_INLINE
+    if (rb_data.compress_inline)
+        rb_data.pdh = ringbuf_cstream_fdopen(rb_data.fd);
+    else
+#endif
     rb_data.pdh = ws_fdopen(rb_data.fd, "wb");
     if (rb_data.pdh == NULL) {
         if (err != NULL) {
             *err = errno;
         }
     } else {
-        size_t buffsize = IO_BUF_SIZE;
+        size_t buffsize = RINGBUFFER_IO_BUF_SIZE;
 #ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
         ws_statb64 statb;
 
         if (ws_fstat64(rb_data.fd, &statb) == 0) {
-            if (statb.st_blksize > IO_BUF_SIZE) {
+            if (statb.st_blksize > RINGBUFFER_IO_BUF_SIZE) {
                 buffsize = statb.st_blksize;
             }
         }
@@ -440,38 +1061,49 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
 {
     int     next_file_index;
     rb_file *next_rfile = NULL;
+    rb_retire_job *job;
 
-    /* close current file */
-
-    if (fclose(rb_data.pdh) == EOF) {
-        if (err != NULL) {
-            *err = errno;
-        }
-        ws_close(rb_data.fd);  /* XXX - the above should have closed this already */
-        rb_data.pdh = NULL;    /* it's still closed, we just got an error while closing */
-        rb_data.fd = -1;
-        g_free(rb_data.io_buffer);
-        rb_data.io_buffer = NULL;
+    /* Reports an error closing the file before this one. */
+    if (!ringbuf_wait_retired(err)) {
         return FALSE;
     }
 
+    /* hand the current file over to be closed */
+
+    job = g_new0(rb_retire_job, 1);
+    job->pdh = rb_data.pdh;
+    job->fd = rb_data.fd;
+    job->io_buffer = rb_data.io_buffer;
+    job->name = g_strdup(ringbuf_current_filename());
     rb_data.pdh = NULL;
     rb_data.fd  = -1;
+    rb_data.io_buffer = NULL;
 
-    if (rb_data.name_h != NULL) {
-        fprintf(rb_data.name_h, "%s\n", ringbuf_current_filename());
-        fflush(rb_data.name_h);
-    }
-
-    /* get the next file number and open it */
+    /* get the next file number and switch to the prepared file */
 
     rb_data.curr_file_num++ /* = next_file_num*/;
     next_file_index = (rb_data.curr_file_num) % rb_data.num_files;
     next_rfile = &rb_data.files[next_file_index];
 
-    if (ringbuf_open_file(next_rfile, err) == -1) {
+    if (next_rfile->name != NULL) {
+        if (rb_data.unlimited == FALSE) {
+            job->stale_name = next_rfile->name;
+        } else {
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
+            job->compress = rb_data.compress != RB_COMPRESS_NONE &&
+                            !rb_data.compress_inline;
+#endif
+            g_free(next_rfile->name);
+        }
+        next_rfile->name = NULL;
+    }
+    rb_data.retire_thread = g_thread_new("ringbuf_retire", ringbuf_retire_thread, job);
+
+    next_rfile->name = ringbuf_file_name();
+    if (ringbuf_take_prepared_file(next_rfile->name, err) == -1) {
         return FALSE;
     }
+    ringbuf_start_prepare();
 
     if (ringbuf_init_libpcap_fdopen(err) == NULL) {
         return FALSE;
@@ -493,8 +1125,14 @@ ringbuf_libpcap_dump_close(gchar **save_file, int *err)
 {
     gboolean  ret_val = TRUE;
 
+    ringbuf_cancel_prepare();
+    if (!ringbuf_wait_retired(err)) {
+        ret_val = FALSE;
+    }
+
     /* close current file, if it's open */
     if (rb_data.pdh != NULL) {
+        ringbuf_trim_file(rb_data.pdh, rb_data.fd);
         if (fclose(rb_data.pdh) == EOF) {
             if (err != NULL) {
                 *err = errno;
@@ -549,6 +1187,8 @@ ringbuf_free(void)
         g_free(rb_data.fsuffix);
         rb_data.fsuffix = NULL;
     }
+    g_free(rb_data.next_name);
+    rb_data.next_name = NULL;
 
     CleanupOldCap(NULL);
 }
@@ -561,6 +1201,9 @@ ringbuf_error_cleanup(void)
 {
     unsigned int i;
 
+    ringbuf_cancel_prepare();
+    ringbuf_wait_retired(NULL);
+
     /* try to close via wtap */
     if (rb_data.pdh != NULL) {
         if (fclose(rb_data.pdh) == 0) {
@@ -23,9 +23,25 @@
 #define RINGBUFFER_MAX_NUM_FILES 100000
 /* Maximum number for FAT filesystems */
 #define RINGBUFFER_WARN_NUM_FILES 65535
+/*
+ * Size of the stdio buffer for capture files, so that packets reach the
+ * file in writes of this size rather than of IO_BUF_SIZE.
+ */
+#define RINGBUFFER_IO_BUF_SIZE (1024 * 1024)
 
+/*
+ * compress_type is "none", "gzip", or "zstd", optionally followed by ":" and
+ * a compression level.  Files are compressed only with an unlimited number
+ * of files; if compress_inline is TRUE, and the platform allows it, they're
+ * compressed as they're written, by a pool of threads, rather than after
+ * they're closed.  Nothing can read them until they're closed if they are.
+ *
+ * file_size_hint is the size at which files will be switched, if known, or 0;
+ * where the file system allows it, space for that much is allocated for each
+ * file before it's switched to.
+ */
 int ringbuf_init(const char *capture_name, guint num_files, gboolean group_read_access, gchar* compress_type,
-                 gboolean nametimenum);
+                 gboolean compress_inline, gboolean nametimenum, guint64 file_size_hint);
 gboolean ringbuf_is_initialized(void);
 const gchar *ringbuf_current_filename(void);
 FILE *ringbuf_init_libpcap_fdopen(int *err);
@@ -74,6 +74,16 @@ capture_file cfile;
 static guint32 cum_bytes;
 static frame_data ref_frame;
 
+/* TRUE while cfile is the file the daemon loaded before forking us */
+static gboolean cfile_preloaded = FALSE;
+
+/* TRUE if we're following cfile as it's written, and so keep reading it */
+static gboolean cfile_tailing = FALSE;
+
+/* Time spent dissecting frames, and filtering them, in microseconds */
+static gint64 dissect_time = 0;
+static gint64 filter_time = 0;
+
 static void sharkd_cmdarg_err(const char *msg_format, va_list ap);
 static void sharkd_cmdarg_err_cont(const char *msg_format, va_list ap);
 
@@ -334,68 +344,101 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
 }
 
 
+/*
+ * Read and dissect the records we haven't read yet.  If we're tailing the
+ * file, a record that's cut short may just not have all been written yet,
+ * so rather than failing, we go back to its start, to read it next time.
+ */
 static int
-load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
+read_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
 {
     int          err;
     gchar       *err_info = NULL;
     gint64       data_offset;
+    gint64       record_offset = 0;
+    gint64       start_time = g_get_monotonic_time();
     wtap_rec     rec;
     Buffer       buf;
     epan_dissect_t *edt = NULL;
 
     {
-        /* Allocate a frame_data_sequence for all the frames. */
-        cf->provider.frames = new_frame_data_sequence();
-
-        {
-            gboolean create_proto_tree;
-
-            /*
-             * Determine whether we need to create a protocol tree.
-             * We do if:
-             *
-             *    we're going to apply a read filter;
-             *
-             *    we're going to apply a display filter;
-             *
-             *    a postdissector wants field values or protocols
-             *    on the first pass.
-             */
-            create_proto_tree =
-                (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids());
+        gboolean create_proto_tree;
+
+        /*
+         * Determine whether we need to create a protocol tree.
+         * We do if:
+         *
+         *    we're going to apply a read filter;
+         *
+         *    we're going to apply a display filter;
+         *
+         *    a postdissector wants field values or protocols
+         *    on the first pass.
+         */
+        create_proto_tree =
+            (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids());
 
-            /* We're not going to display the protocol tree on this pass,
-               so it's not going to be "visible". */
-            edt = epan_dissect_new(cf->epan, create_proto_tree, FALSE);
-        }
+        /* We're not going to display the protocol tree on this pass,
+           so it's not going to be "visible". */
+        edt = epan_dissect_new(cf->epan, create_proto_tree, FALSE);
+    }
 
-        wtap_rec_init(&rec);
-        ws_buffer_init(&buf, 1514);
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
 
-        while (wtap_read(cf->provider.wth, &rec, &buf, &err, &err_info, &data_offset)) {
-            if (process_packet(cf, edt, data_offset, &rec, &buf)) {
-                wtap_rec_reset(&rec);
-                /* Stop reading if we have the maximum number of packets;
-                 * When the -c option has not been used, max_packet_count
-                 * starts at 0, which practically means, never stop reading.
-                 * (unless we roll over max_packet_count ?)
-                 */
-                if ( (--max_packet_count == 0) || (max_byte_count != 0 && data_offset >= max_byte_count)) {
-                    err = 0; /* This is not an error */
-                    break;
-                }
+    for (;;) {
+        if (cfile_tailing) {
+            wtap_cleareof(cf->provider.wth);
+            record_offset = wtap_sequential_tell(cf->provider.wth);
+        }
+        if (!wtap_read(cf->provider.wth, &rec, &buf, &err, &err_info, &data_offset))
+            break;
+        if (process_packet(cf, edt, data_offset, &rec, &buf)) {
+            wtap_rec_reset(&rec);
+            /* Stop reading if we have the maximum number of packets;
+             * When the -c option has not been used, max_packet_count
+             * starts at 0, which practically means, never stop reading.
+             * (unless we roll over max_packet_count ?)
+             */
+            if ( (--max_packet_count == 0) || (max_byte_count != 0 && data_offset >= max_byte_count)) {
+                err = 0; /* This is not an error */
+                break;
             }
         }
+    }
 
-        if (edt) {
-            epan_dissect_free(edt);
-            edt = NULL;
-        }
+    if (cfile_tailing && err == WTAP_ERR_SHORT_READ) {
+        g_free(err_info);
+        err_info = NULL;
+        if (wtap_sequential_seek(cf->provider.wth, record_offset, &err))
+            err = 0;
+    }
 
-        wtap_rec_cleanup(&rec);
-        ws_buffer_free(&buf);
+    epan_dissect_free(edt);
 
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+
+    dissect_time += g_get_monotonic_time() - start_time;
+
+    if (err != 0) {
+        cfile_read_failure_message(cf->filename, err, err_info);
+    }
+
+    return err;
+}
+
+static int
+load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
+{
+    int          err;
+
+    /* Allocate a frame_data_sequence for all the frames. */
+    cf->provider.frames = new_frame_data_sequence();
+
+    err = read_cap_file(cf, max_packet_count, max_byte_count);
+
+    if (!cfile_tailing) {
         /* Close the sequential I/O side, to free up memory it requires. */
         wtap_sequential_close(cf->provider.wth);
 
@@ -407,10 +450,6 @@ load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
         cf->provider.prev_cap = NULL;
     }
 
-    if (err != 0) {
-        cfile_read_failure_message(cf->filename, err, err_info);
-    }
-
     return err;
 }
 
@@ -492,15 +531,129 @@ sharkd_cmdarg_err_cont(const char *msg_format, va_list ap)
 cf_status_t
 sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err)
 {
+    cfile_preloaded = FALSE;
+    cfile_tailing = FALSE;
     return cf_open(&cfile, fname, type, is_tempfile, err);
 }
 
+/*
+ * Load a file in the daemon, before it forks any session processes, so
+ * that they all start with it loaded.  They share the memory for the
+ * frames and what the dissectors kept from the first pass with the
+ * daemon, until they change it, rather than each reading and
+ * dissecting the file again.
+ */
+int
+sharkd_preload_cap_file(const char *fname)
+{
+    int err = 0;
+
+    if (sharkd_cf_open(fname, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
+        return err != 0 ? err : -1;
+    err = load_cap_file(&cfile, 0, 0);
+    if (err == 0)
+        cfile_preloaded = TRUE;
+    return err;
+}
+
+/*
+ * In a session process, give the preloaded file a descriptor of its own,
+ * as the one we got from the daemon shares its file position with every
+ * other session process.
+ */
+int
+sharkd_preload_attach(void)
+{
+    int err;
+
+    if (!cfile_preloaded)
+        return 0;
+    err = sharkd_reopen_cap_file();
+    if (err != 0) {
+        /* We can't read packets from it; load it again if asked to. */
+        cfile_preloaded = FALSE;
+    }
+    return err;
+}
+
+/*
+ * Open the capture file again, so that reading packets from it doesn't
+ * move the file position of the process we were forked from.
+ */
+int
+sharkd_reopen_cap_file(void)
+{
+    int err = 0;
+
+    if (cfile.provider.wth == NULL)
+        return 0;
+    wtap_fdclose(cfile.provider.wth);
+    if (!wtap_fdreopen(cfile.provider.wth, cfile.filename, &err))
+        return err != 0 ? err : -1;
+    return 0;
+}
+
+/* Is fname the file the daemon loaded for us? */
+gboolean
+sharkd_is_preloaded(const char *fname)
+{
+    return cfile_preloaded && cfile.filename != NULL && strcmp(cfile.filename, fname) == 0;
+}
+
+/*
+ * The time we've spent dissecting frames, and filtering them, in
+ * microseconds; for measuring how long each request spends on them.
+ */
+void
+sharkd_get_times(gint64 *dissect_us, gint64 *filter_us)
+{
+    *dissect_us = dissect_time;
+    *filter_us = filter_time;
+}
+
 int
 sharkd_load_cap_file(void)
 {
     return load_cap_file(&cfile, 0, 0);
 }
 
+/*
+ * Load the file, like sharkd_load_cap_file(), but keep reading it
+ * sequentially, so that sharkd_continue_tail() can read the records
+ * written to it later, as cf_continue_tail() does for Wireshark.
+ */
+int
+sharkd_tail_cap_file(void)
+{
+    cfile_tailing = TRUE;
+    return load_cap_file(&cfile, 0, 0);
+}
+
+gboolean
+sharkd_is_tailing(void)
+{
+    return cfile_tailing;
+}
+
+/*
+ * Read and dissect the records written to the file we're tailing since
+ * we last read it.
+ */
+int
+sharkd_continue_tail(void)
+{
+    int err;
+
+    if (!cfile_tailing)
+        return 0;
+    err = read_cap_file(&cfile, 0, 0);
+
+    /* Update the file encapsulation; it might have changed based on the
+       packets we've read. */
+    cfile.lnk_t = wtap_file_encap(cfile.provider.wth);
+    return err;
+}
+
 frame_data *
 sharkd_get_frame(guint32 framenum)
 {
@@ -517,6 +670,7 @@ sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num,
     frame_data *fdata;
     epan_dissect_t edt;
     gboolean create_proto_tree;
+    gint64 start_time = g_get_monotonic_time();
 
     fdata = sharkd_get_frame(framenum);
     if (fdata == NULL)
@@ -557,6 +711,9 @@ sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num,
         epan_dissect_fill_in_columns(&edt, FALSE, TRUE/* fill_fd_columns */);
     }
 
+    /* What the callback does with the results isn't dissection. */
+    dissect_time += g_get_monotonic_time() - start_time;
+
     cb(&edt, (dissect_flags & SHARKD_DISSECT_FLAG_PROTO_TREE) ? edt.tree : NULL,
             cinfo, (dissect_flags & SHARKD_DISSECT_FLAG_BYTES) ? edt.pi.data_src : NULL,
             data);
@@ -568,8 +725,20 @@ sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num,
 
 int
 sharkd_retap(void)
+{
+    return sharkd_retap_from(1);
+}
+
+/*
+ * Run the tap listeners over the frames from first_frame on, or, if
+ * frames isn't NULL, over the frames in it, which must be in order.
+ */
+static int
+retap_frames(guint32 first_frame, const GArray *frames)
 {
     guint32          framenum;
+    guint32          i;
+    guint32          count;
     frame_data      *fdata;
     Buffer           buf;
     wtap_rec         rec;
@@ -580,6 +749,7 @@ sharkd_retap(void)
     gboolean      create_proto_tree;
     epan_dissect_t edt;
     column_info   *cinfo;
+    gint64        start_time;
 
     /* Get the union of the flags for all tap listeners. */
     tap_flags = union_of_tap_listener_flags();
@@ -602,9 +772,17 @@ sharkd_retap(void)
     ws_buffer_init(&buf, 1514);
     epan_dissect_init(&edt, cfile.epan, create_proto_tree, FALSE);
 
-    reset_tap_listeners();
+    if (first_frame <= 1)
+        reset_tap_listeners();
+
+    start_time = g_get_monotonic_time();
 
-    for (framenum = 1; framenum <= cfile.count; framenum++) {
+    first_frame = MAX(first_frame, 1);
+    count = (frames != NULL) ? frames->len : (cfile.count >= first_frame ? cfile.count - first_frame + 1 : 0);
+    for (i = 0; i < count; i++) {
+        framenum = (frames != NULL) ? g_array_index(frames, guint32, i) : first_frame + i;
+        if (framenum < 1 || framenum > cfile.count)
+            break;
         fdata = sharkd_get_frame(framenum);
 
         if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
@@ -620,6 +798,8 @@ sharkd_retap(void)
         epan_dissect_reset(&edt);
     }
 
+    dissect_time += g_get_monotonic_time() - start_time;
+
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
     epan_dissect_cleanup(&edt);
@@ -629,50 +809,116 @@ sharkd_retap(void)
     return 0;
 }
 
+/*
+ * Run the tap listeners over the frames from first_frame on; if that's
+ * not the first frame, they go on adding to what they already have.
+ */
 int
-sharkd_filter(const char *dftext, guint8 **result)
+sharkd_retap_from(guint32 first_frame)
 {
-    dfilter_t  *dfcode = NULL;
+    return retap_frames(first_frame, NULL);
+}
 
-    guint32 framenum, prev_dis_num = 0;
-    guint32 frames_count;
+/*
+ * Run the tap listeners over just the frames in frames, e.g. the ones
+ * sharkd_index_field() found for one stream, which must be in order.
+ */
+int
+sharkd_retap_frames(const GArray *frames)
+{
+    return retap_frames(1, frames);
+}
+
+/*
+ * Add the frames from first_frame on to index, a table from the values
+ * of the unsigned integer field hf_index, e.g. tcp.stream, to GArrays of
+ * the numbers of the frames that have them.
+ */
+void
+sharkd_index_field(int hf_index, GHashTable *index, guint32 first_frame)
+{
+    guint32 framenum;
     Buffer buf;
     wtap_rec rec;
     int err;
     char *err_info = NULL;
 
-    guint8 *result_bits;
-    guint8  passed_bits;
-
     epan_dissect_t edt;
+    gint64 start_time = g_get_monotonic_time();
 
-    if (!dfilter_compile(dftext, &dfcode, &err_info)) {
-        g_free(err_info);
-        return -1;
-    }
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    epan_dissect_init(&edt, cfile.epan, TRUE, FALSE);
 
-    /* if dfilter_compile() success, but (dfcode == NULL) all frames are matching */
-    if (dfcode == NULL) {
-        *result = NULL;
-        return 0;
+    for (framenum = MAX(first_frame, 1); framenum <= cfile.count; framenum++) {
+        frame_data *fdata = sharkd_get_frame(framenum);
+        GPtrArray *finfos;
+        guint i;
+
+        if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
+            break;
+
+        epan_dissect_prime_with_hfid(&edt, hf_index);
+
+        fdata->ref_time = FALSE;
+        fdata->frame_ref_num = (framenum != 1) ? 1 : 0;
+        fdata->prev_dis_num = framenum - 1;
+        epan_dissect_run(&edt, cfile.cd_t, &rec,
+                frame_tvbuff_new_buffer(&cfile.provider, fdata, &buf),
+                fdata, NULL);
+
+        finfos = proto_get_finfo_ptr_array(edt.tree, hf_index);
+        for (i = 0; finfos != NULL && i < finfos->len; i++) {
+            field_info *fi = (field_info *) g_ptr_array_index(finfos, i);
+            guint32 value = fvalue_get_uinteger(&fi->value);
+            GArray *value_frames = (GArray *) g_hash_table_lookup(index, GUINT_TO_POINTER(value));
+
+            if (value_frames == NULL) {
+                value_frames = g_array_new(FALSE, FALSE, sizeof(guint32));
+                g_hash_table_insert(index, GUINT_TO_POINTER(value), value_frames);
+            }
+            /* The field can be in a frame more than once, e.g. with tunnels. */
+            if (value_frames->len == 0 || g_array_index(value_frames, guint32, value_frames->len - 1) != framenum)
+                g_array_append_val(value_frames, framenum);
+        }
+
+        wtap_rec_reset(&rec);
+        epan_dissect_reset(&edt);
     }
 
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+    epan_dissect_cleanup(&edt);
+
+    filter_time += g_get_monotonic_time() - start_time;
+}
+
+/*
+ * Add the frames after the ones passed was made from to it.  prev_dis_num
+ * is the last frame already in it.
+ */
+static void
+filter_frames(dfilter_t *dfcode, sharkd_bitmap *passed, guint32 prev_dis_num)
+{
+    guint32 framenum;
+    guint32 frames_count;
+    Buffer buf;
+    wtap_rec rec;
+    int err;
+    char *err_info = NULL;
+
+    epan_dissect_t edt;
+    gint64 start_time = g_get_monotonic_time();
+
     frames_count = cfile.count;
 
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
     epan_dissect_init(&edt, cfile.epan, TRUE, FALSE);
 
-    passed_bits = 0;
-    result_bits = (guint8 *) g_malloc(2 + (frames_count / 8));
-
-    for (framenum = 1; framenum <= frames_count; framenum++) {
+    for (framenum = sharkd_bitmap_length(passed) + 1; framenum <= frames_count; framenum++) {
         frame_data *fdata = sharkd_get_frame(framenum);
-
-        if ((framenum & 7) == 0) {
-            result_bits[(framenum / 8) - 1] = passed_bits;
-            passed_bits = 0;
-        }
+        gboolean frame_passed;
 
         if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
             break;
@@ -687,10 +933,10 @@ sharkd_filter(const char *dftext, guint8 **result)
                 frame_tvbuff_new_buffer(&cfile.provider, fdata, &buf),
                 fdata, NULL);
 
-        if (dfilter_apply_edt(dfcode, &edt)) {
-            passed_bits |= (1 << (framenum % 8));
+        frame_passed = dfilter_apply_edt(dfcode, &edt);
+        if (frame_passed)
             prev_dis_num = framenum;
-        }
+        sharkd_bitmap_append(passed, frame_passed);
 
         /* if passed or ref -> frame_data_set_after_dissect */
 
@@ -698,19 +944,69 @@ sharkd_filter(const char *dftext, guint8 **result)
         epan_dissect_reset(&edt);
     }
 
-    if ((framenum & 7) == 0)
-        framenum--;
-    result_bits[framenum / 8] = passed_bits;
+    sharkd_bitmap_finish(passed);
 
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
     epan_dissect_cleanup(&edt);
 
+    filter_time += g_get_monotonic_time() - start_time;
+}
+
+int
+sharkd_filter(const char *dftext, sharkd_bitmap **result)
+{
+    dfilter_t  *dfcode = NULL;
+    char *err_info = NULL;
+
+    sharkd_bitmap *passed;
+
+    if (!dfilter_compile(dftext, &dfcode, &err_info)) {
+        g_free(err_info);
+        return -1;
+    }
+
+    /* if dfilter_compile() success, but (dfcode == NULL) all frames are matching */
+    if (dfcode == NULL) {
+        *result = NULL;
+        return 0;
+    }
+
+    passed = sharkd_bitmap_new();
+    filter_frames(dfcode, passed, 0);
+
     dfilter_free(dfcode);
 
-    *result = result_bits;
+    *result = passed;
+
+    return sharkd_bitmap_length(passed);
+}
+
+/*
+ * Add the frames read since sharkd_filter() made passed, or since it was
+ * last extended, to it.
+ */
+int
+sharkd_filter_extend(const char *dftext, sharkd_bitmap *passed)
+{
+    dfilter_t  *dfcode = NULL;
+    char *err_info = NULL;
+    guint32 count;
+
+    if (!dfilter_compile(dftext, &dfcode, &err_info)) {
+        g_free(err_info);
+        return -1;
+    }
+    if (dfcode == NULL)
+        return 0;
+
+    count = sharkd_bitmap_count(passed);
+    sharkd_bitmap_reopen(passed);
+    filter_frames(dfcode, passed, count != 0 ? sharkd_bitmap_select(passed, count - 1) : 0);
+
+    dfilter_free(dfcode);
 
-    return framenum;
+    return sharkd_bitmap_length(passed);
 }
 
 /*
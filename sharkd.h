@@ -15,6 +15,8 @@
 #include <file.h>
 #include <wiretap/wtap_opttypes.h>
 
+#include "sharkd_bitmap.h"
+
 #define SHARKD_DISSECT_FLAG_NULL       0x00u
 #define SHARKD_DISSECT_FLAG_BYTES      0x01u
 #define SHARKD_DISSECT_FLAG_COLUMNS    0x02u
@@ -31,8 +33,20 @@ typedef void (*sharkd_dissect_func_t)(epan_dissect_t *edt, proto_tree *tree, str
 /* sharkd.c */
 cf_status_t sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err);
 int sharkd_load_cap_file(void);
+int sharkd_tail_cap_file(void);
+gboolean sharkd_is_tailing(void);
+int sharkd_continue_tail(void);
+void sharkd_get_times(gint64 *dissect_us, gint64 *filter_us);
+int sharkd_preload_cap_file(const char *fname);
+int sharkd_preload_attach(void);
+int sharkd_reopen_cap_file(void);
+gboolean sharkd_is_preloaded(const char *fname);
 int sharkd_retap(void);
-int sharkd_filter(const char *dftext, guint8 **result);
+int sharkd_retap_from(guint32 first_frame);
+int sharkd_retap_frames(const GArray *frames);
+void sharkd_index_field(int hf_index, GHashTable *index, guint32 first_frame);
+int sharkd_filter(const char *dftext, sharkd_bitmap **result);
+int sharkd_filter_extend(const char *dftext, sharkd_bitmap *passed);
 frame_data *sharkd_get_frame(guint32 framenum);
 enum dissect_request_status {
   DISSECT_REQUEST_SUCCESS,
@@ -55,6 +69,7 @@ int sharkd_init(int argc, char **argv);
 int sharkd_loop(int argc _U_, char* argv[] _U_);
 
 /* sharkd_session.c */
+void sharkd_session_init(int mode_setting);
 int sharkd_session_main(int mode_setting);
 
 #endif /* __SHARKD_H */
@@ -0,0 +1,470 @@
+/* sharkd_bitmap.c
+ *
+ * Compressed sets of frame numbers, for sharkd
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/bits_count_ones.h>
+
+#include "sharkd_bitmap.h"
+
+#define CHUNK_FRAMES    65536
+#define CHUNK_BYTES     (CHUNK_FRAMES / 8)
+
+/* A chunk with more runs than this takes less memory as bits. */
+#define CHUNK_RUNS_MAX  (CHUNK_BYTES / (2 * sizeof(guint16)) - 1)
+
+typedef enum {
+    CHUNK_NONE,         /* none of the frames are in the set */
+    CHUNK_ALL,          /* all of them are */
+    CHUNK_RUNS,
+    CHUNK_BITS
+} chunk_type;
+
+typedef struct {
+    chunk_type type;
+    guint32    rank;    /* frames in the set in earlier chunks */
+    guint32    count;   /* frames in the set in this chunk */
+    guint32    nruns;
+    guint16   *runs;    /* for CHUNK_RUNS, the first and last offset of each run */
+    guint8    *bits;    /* for CHUNK_BITS */
+} bitmap_chunk;
+
+struct _sharkd_bitmap {
+    guint32  count;     /* frames added */
+    GArray  *chunks;    /* of bitmap_chunk */
+    guint8  *pending;   /* bits of the chunk being added to */
+};
+
+#define BIT_IS_SET(bits, off)   (((bits)[(off) >> 3] >> ((off) & 7)) & 1)
+
+/*
+ * The number of runs of set bits in the first nframes bits, and the
+ * number of set bits.
+ */
+static guint32
+chunk_count_runs(const guint8 *bits, guint32 nframes, guint32 *count)
+{
+    guint32 nruns = 0;
+    guint32 off;
+    gboolean prev = FALSE;
+
+    for (off = 0; off < nframes; off++) {
+        gboolean cur;
+
+        /* Skip whole bytes that don't start or end a run. */
+        if ((off & 7) == 0 && off + 8 <= nframes) {
+            guint8 b = bits[off >> 3];
+
+            if ((b == 0x00 && !prev) || (b == 0xFF && prev)) {
+                if (prev)
+                    *count += 8;
+                off += 7;
+                continue;
+            }
+        }
+
+        cur = BIT_IS_SET(bits, off);
+        if (cur && !prev)
+            nruns++;
+        if (cur)
+            (*count)++;
+        prev = cur;
+    }
+    return nruns;
+}
+
+/* Make a chunk, in the form that takes the least memory, from bits. */
+static bitmap_chunk
+chunk_compress(const guint8 *bits, guint32 nframes)
+{
+    bitmap_chunk chunk = { CHUNK_NONE, 0, 0, 0, NULL, NULL };
+    guint32 nruns = chunk_count_runs(bits, nframes, &chunk.count);
+    guint32 off, i;
+
+    if (nruns == 0)
+        return chunk;
+
+    if (nruns == 1 && BIT_IS_SET(bits, 0) && BIT_IS_SET(bits, nframes - 1)) {
+        chunk.type = CHUNK_ALL;
+        return chunk;
+    }
+
+    if (nruns > CHUNK_RUNS_MAX) {
+        chunk.type = CHUNK_BITS;
+        chunk.bits = (guint8 *) g_malloc(CHUNK_BYTES);
+        memcpy(chunk.bits, bits, CHUNK_BYTES);
+        return chunk;
+    }
+
+    chunk.type = CHUNK_RUNS;
+    chunk.nruns = nruns;
+    chunk.runs = g_new(guint16, 2 * nruns);
+    i = 0;
+    for (off = 0; off < nframes; off++) {
+        if (!BIT_IS_SET(bits, off))
+            continue;
+        chunk.runs[i++] = (guint16) off;
+        while (off + 1 < nframes && BIT_IS_SET(bits, off + 1))
+            off++;
+        chunk.runs[i++] = (guint16) off;
+    }
+    return chunk;
+}
+
+/* Turn a chunk back into bits. */
+static void
+chunk_expand(const bitmap_chunk *chunk, guint8 *bits)
+{
+    guint32 i, off;
+
+    switch (chunk->type) {
+
+    case CHUNK_NONE:
+        memset(bits, 0x00, CHUNK_BYTES);
+        break;
+
+    case CHUNK_ALL:
+        memset(bits, 0xFF, CHUNK_BYTES);
+        break;
+
+    case CHUNK_RUNS:
+        memset(bits, 0x00, CHUNK_BYTES);
+        for (i = 0; i < chunk->nruns; i++) {
+            for (off = chunk->runs[2 * i]; off <= chunk->runs[2 * i + 1]; off++)
+                bits[off >> 3] |= 1 << (off & 7);
+        }
+        break;
+
+    case CHUNK_BITS:
+        memcpy(bits, chunk->bits, CHUNK_BYTES);
+        break;
+    }
+}
+
+static bitmap_chunk
+chunk_copy(const bitmap_chunk *chunk)
+{
+    bitmap_chunk copy = *chunk;
+
+    if (chunk->runs != NULL)
+        copy.runs = (guint16 *) g_memdup2(chunk->runs, 2 * chunk->nruns * sizeof(guint16));
+    if (chunk->bits != NULL)
+        copy.bits = (guint8 *) g_memdup2(chunk->bits, CHUNK_BYTES);
+    return copy;
+}
+
+static void
+chunk_clear(gpointer data)
+{
+    bitmap_chunk *chunk = (bitmap_chunk *) data;
+
+    g_free(chunk->runs);
+    g_free(chunk->bits);
+}
+
+static sharkd_bitmap *
+bitmap_alloc(void)
+{
+    sharkd_bitmap *bitmap = g_new0(sharkd_bitmap, 1);
+
+    bitmap->chunks = g_array_new(FALSE, FALSE, sizeof(bitmap_chunk));
+    g_array_set_clear_func(bitmap->chunks, chunk_clear);
+    return bitmap;
+}
+
+sharkd_bitmap *
+sharkd_bitmap_new(void)
+{
+    sharkd_bitmap *bitmap = bitmap_alloc();
+
+    bitmap->pending = (guint8 *) g_malloc0(CHUNK_BYTES);
+    return bitmap;
+}
+
+static void
+bitmap_add_chunk(sharkd_bitmap *bitmap, bitmap_chunk *chunk)
+{
+    chunk->rank = 0;
+    if (bitmap->chunks->len != 0) {
+        const bitmap_chunk *prev = &g_array_index(bitmap->chunks, bitmap_chunk, bitmap->chunks->len - 1);
+
+        chunk->rank = prev->rank + prev->count;
+    }
+    g_array_append_val(bitmap->chunks, *chunk);
+}
+
+static void
+bitmap_flush(sharkd_bitmap *bitmap, guint32 nframes)
+{
+    bitmap_chunk chunk = chunk_compress(bitmap->pending, nframes);
+
+    bitmap_add_chunk(bitmap, &chunk);
+    memset(bitmap->pending, 0, CHUNK_BYTES);
+}
+
+void
+sharkd_bitmap_append(sharkd_bitmap *bitmap, gboolean set)
+{
+    guint32 off = bitmap->count % CHUNK_FRAMES;
+
+    if (set)
+        bitmap->pending[off >> 3] |= 1 << (off & 7);
+    bitmap->count++;
+    if (off == CHUNK_FRAMES - 1)
+        bitmap_flush(bitmap, CHUNK_FRAMES);
+}
+
+void
+sharkd_bitmap_finish(sharkd_bitmap *bitmap)
+{
+    if (bitmap->pending == NULL)
+        return;
+    if (bitmap->count % CHUNK_FRAMES != 0)
+        bitmap_flush(bitmap, bitmap->count % CHUNK_FRAMES);
+    g_free(bitmap->pending);
+    bitmap->pending = NULL;
+}
+
+void
+sharkd_bitmap_reopen(sharkd_bitmap *bitmap)
+{
+    guint32 off = bitmap->count % CHUNK_FRAMES;
+    bitmap_chunk *last;
+
+    if (bitmap->pending != NULL)
+        return;
+    bitmap->pending = (guint8 *) g_malloc0(CHUNK_BYTES);
+    if (off == 0)
+        return;
+
+    /* Only the last chunk can be partly filled; turn it back into bits. */
+    last = &g_array_index(bitmap->chunks, bitmap_chunk, bitmap->chunks->len - 1);
+    chunk_expand(last, bitmap->pending);
+    g_array_set_size(bitmap->chunks, bitmap->chunks->len - 1);
+
+    /* An ALL chunk expands to more frames than it was made from. */
+    bitmap->pending[off >> 3] &= (1 << (off & 7)) - 1;
+    memset(&bitmap->pending[(off >> 3) + 1], 0, CHUNK_BYTES - (off >> 3) - 1);
+}
+
+void
+sharkd_bitmap_free(sharkd_bitmap *bitmap)
+{
+    if (bitmap == NULL)
+        return;
+    g_array_free(bitmap->chunks, TRUE);
+    g_free(bitmap->pending);
+    g_free(bitmap);
+}
+
+gboolean
+sharkd_bitmap_test(const sharkd_bitmap *bitmap, guint32 framenum)
+{
+    const bitmap_chunk *chunk;
+    guint32 idx, off, lo, hi;
+
+    if (framenum == 0 || framenum > bitmap->count)
+        return FALSE;
+    idx = framenum - 1;
+    if (idx / CHUNK_FRAMES >= bitmap->chunks->len)
+        return FALSE;   /* not finished yet */
+    chunk = &g_array_index(bitmap->chunks, bitmap_chunk, idx / CHUNK_FRAMES);
+    off = idx % CHUNK_FRAMES;
+
+    switch (chunk->type) {
+
+    case CHUNK_NONE:
+        return FALSE;
+
+    case CHUNK_ALL:
+        return TRUE;
+
+    case CHUNK_RUNS:
+        /* Find the last run that starts at or before off. */
+        lo = 0;
+        hi = chunk->nruns;
+        while (lo < hi) {
+            guint32 mid = lo + (hi - lo) / 2;
+
+            if (chunk->runs[2 * mid] <= off)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo != 0 && off <= chunk->runs[2 * (lo - 1) + 1];
+
+    case CHUNK_BITS:
+        return BIT_IS_SET(chunk->bits, off);
+    }
+    return FALSE;
+}
+
+guint32
+sharkd_bitmap_count(const sharkd_bitmap *bitmap)
+{
+    const bitmap_chunk *last;
+
+    if (bitmap->chunks->len == 0)
+        return 0;
+    last = &g_array_index(bitmap->chunks, bitmap_chunk, bitmap->chunks->len - 1);
+    return last->rank + last->count;
+}
+
+guint32
+sharkd_bitmap_length(const sharkd_bitmap *bitmap)
+{
+    return bitmap->count;
+}
+
+guint32
+sharkd_bitmap_select(const sharkd_bitmap *bitmap, guint32 n)
+{
+    const bitmap_chunk *chunk;
+    guint32 lo, hi, base, off, i;
+
+    if (n >= sharkd_bitmap_count(bitmap))
+        return 0;
+
+    /* Find the first chunk with more than n frames up to its end. */
+    lo = 0;
+    hi = bitmap->chunks->len;
+    while (lo < hi) {
+        guint32 mid = lo + (hi - lo) / 2;
+
+        chunk = &g_array_index(bitmap->chunks, bitmap_chunk, mid);
+        if (chunk->rank + chunk->count <= n)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    chunk = &g_array_index(bitmap->chunks, bitmap_chunk, lo);
+    base = lo * CHUNK_FRAMES + 1;
+    n -= chunk->rank;
+
+    switch (chunk->type) {
+
+    case CHUNK_NONE:
+        break;
+
+    case CHUNK_ALL:
+        return base + n;
+
+    case CHUNK_RUNS:
+        for (i = 0; i < chunk->nruns; i++) {
+            guint32 len = chunk->runs[2 * i + 1] - chunk->runs[2 * i] + 1;
+
+            if (n < len)
+                return base + chunk->runs[2 * i] + n;
+            n -= len;
+        }
+        break;
+
+    case CHUNK_BITS:
+        for (off = 0; off < CHUNK_FRAMES; off += 8) {
+            guint8 b = chunk->bits[off >> 3];
+            guint32 bits_set = ws_count_ones(b);
+
+            if (n >= bits_set) {
+                n -= bits_set;
+                continue;
+            }
+            for (i = 0; i < 8; i++) {
+                if ((b >> i) & 1) {
+                    if (n == 0)
+                        return base + off + i;
+                    n--;
+                }
+            }
+        }
+        break;
+    }
+    return 0;
+}
+
+sharkd_bitmap *
+sharkd_bitmap_combine(const sharkd_bitmap *a, const sharkd_bitmap *b, gboolean either)
+{
+    sharkd_bitmap *result;
+    guint8 *bits_a, *bits_b;
+    guint i, j;
+
+    if (a->count != b->count || a->pending != NULL || b->pending != NULL)
+        return NULL;
+
+    result = bitmap_alloc();
+    result->count = a->count;
+    bits_a = (guint8 *) g_malloc(CHUNK_BYTES);
+    bits_b = (guint8 *) g_malloc(CHUNK_BYTES);
+
+    for (i = 0; i < a->chunks->len; i++) {
+        const bitmap_chunk *ca = &g_array_index(a->chunks, bitmap_chunk, i);
+        const bitmap_chunk *cb = &g_array_index(b->chunks, bitmap_chunk, i);
+        /* For "or", a chunk with all of the frames decides the result, and one with none doesn't matter; for "and", the reverse. */
+        chunk_type decides = either ? CHUNK_ALL : CHUNK_NONE;
+        chunk_type neutral = either ? CHUNK_NONE : CHUNK_ALL;
+        bitmap_chunk chunk;
+
+        if (ca->type == decides || cb->type == neutral)
+            chunk = chunk_copy(ca);
+        else if (cb->type == decides || ca->type == neutral)
+            chunk = chunk_copy(cb);
+        else {
+            guint32 nframes = MIN(a->count - i * CHUNK_FRAMES, CHUNK_FRAMES);
+
+            chunk_expand(ca, bits_a);
+            chunk_expand(cb, bits_b);
+            for (j = 0; j < CHUNK_BYTES; j++)
+                bits_a[j] = either ? (bits_a[j] | bits_b[j]) : (bits_a[j] & bits_b[j]);
+            chunk = chunk_compress(bits_a, nframes);
+        }
+        bitmap_add_chunk(result, &chunk);
+    }
+
+    g_free(bits_a);
+    g_free(bits_b);
+    return result;
+}
+
+size_t
+sharkd_bitmap_size(const sharkd_bitmap *bitmap)
+{
+    size_t size = sizeof(*bitmap) + bitmap->chunks->len * sizeof(bitmap_chunk);
+    guint i;
+
+    for (i = 0; i < bitmap->chunks->len; i++) {
+        const bitmap_chunk *chunk = &g_array_index(bitmap->chunks, bitmap_chunk, i);
+
+        if (chunk->type == CHUNK_RUNS)
+            size += 2 * chunk->nruns * sizeof(guint16);
+        else if (chunk->type == CHUNK_BITS)
+            size += CHUNK_BYTES;
+    }
+    if (bitmap->pending != NULL)
+        size += CHUNK_BYTES;
+    return size;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
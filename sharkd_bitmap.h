@@ -0,0 +1,81 @@
+/** @file
+ *
+ * Compressed sets of frame numbers, for sharkd
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __SHARKD_BITMAP_H
+#define __SHARKD_BITMAP_H
+
+#include <glib.h>
+
+/*
+ * A set of frame numbers, such as the frames that match a filter.
+ *
+ * The frames are split into chunks of 65536, and each chunk is kept in
+ * whichever of these takes the least memory: nothing, for a chunk with
+ * no frames in the set or with all of them; a list of runs of frames;
+ * or a bit per frame.  A filter that matches a few large blocks of a
+ * capture, or almost nothing, takes almost no memory, and no filter
+ * takes much more than a bit per frame.
+ */
+typedef struct _sharkd_bitmap sharkd_bitmap;
+
+/** Start an empty set; add frames 1, 2, ... with sharkd_bitmap_append(). */
+sharkd_bitmap *sharkd_bitmap_new(void);
+
+/** Add the next frame, if set is TRUE, or skip it. */
+void sharkd_bitmap_append(sharkd_bitmap *bitmap, gboolean set);
+
+/** Finish adding frames; frames after the last one are not in the set. */
+void sharkd_bitmap_finish(sharkd_bitmap *bitmap);
+
+/** Go on adding frames to a finished set, after the ones it was made from. */
+void sharkd_bitmap_reopen(sharkd_bitmap *bitmap);
+
+void sharkd_bitmap_free(sharkd_bitmap *bitmap);
+
+/** Is frame framenum in the set? */
+gboolean sharkd_bitmap_test(const sharkd_bitmap *bitmap, guint32 framenum);
+
+/** The number of frames in the set. */
+guint32 sharkd_bitmap_count(const sharkd_bitmap *bitmap);
+
+/** The number of frames the set was made from, in it or not. */
+guint32 sharkd_bitmap_length(const sharkd_bitmap *bitmap);
+
+/**
+ * The frame number of the nth frame in the set, counting from 0, or 0 if
+ * there are no more than n frames in it.  Each chunk keeps count of the
+ * frames in the set before it, so this doesn't look at earlier chunks.
+ */
+guint32 sharkd_bitmap_select(const sharkd_bitmap *bitmap, guint32 n);
+
+/**
+ * The frames in both a and b, or, if either is TRUE, in either of them.
+ * Returns NULL if a and b weren't made from the same number of frames.
+ */
+sharkd_bitmap *sharkd_bitmap_combine(const sharkd_bitmap *a, const sharkd_bitmap *b, gboolean either);
+
+/** How much memory the set uses. */
+size_t sharkd_bitmap_size(const sharkd_bitmap *bitmap);
+
+#endif /* __SHARKD_BITMAP_H */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
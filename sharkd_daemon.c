@@ -33,8 +33,11 @@
 #include <wsutil/ws_getopt.h>
 
 #ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <netinet/tcp.h>
+#include <unistd.h>
 #endif
 
 #include <wsutil/strtoi.h>
@@ -52,6 +55,22 @@
 
 static int mode = 0;
 static socket_handle_t _server_fd = INVALID_SOCKET;
+static const char *preload_file = NULL;
+
+#ifndef _WIN32
+/*
+ * A session process that's been forked, and has set itself up, ahead of
+ * time; it waits for us to hand it a connection over fd.
+ */
+struct sharkd_worker
+{
+    pid_t pid;
+    int fd;
+};
+
+static guint32 pool_size = 0;
+static GArray *idle_workers = NULL;     /* of struct sharkd_worker */
+#endif
 
 static socket_handle_t
 socket_init(char *path)
@@ -183,6 +202,14 @@ print_usage(FILE* output)
     fprintf(output, "  -v, --version            show version information\n");
     fprintf(output, "  -C <config profile>, --config-profile <config profile>\n");
     fprintf(output, "                           start with specified configuration profile\n");
+#ifndef _WIN32
+    fprintf(output, "  -p <file>, --preload <file>\n");
+    fprintf(output, "                           load <file> once, before accepting connections;\n");
+    fprintf(output, "                           sessions that load it share it instead of reading it\n");
+    fprintf(output, "  -w <count>, --workers <count>\n");
+    fprintf(output, "                           keep <count> session processes forked and ready,\n");
+    fprintf(output, "                           so that new connections don't wait for one\n");
+#endif
 
     fprintf(output, "\n");
     fprintf(output, "  Examples:\n");
@@ -217,7 +244,7 @@ sharkd_init(int argc, char **argv)
      * platform-dependent.
      */
 
-#define OPTSTRING "+" "a:hmvC:"
+#define OPTSTRING "+" "a:hmp:vw:C:"
 
     static const char    optstring[] = OPTSTRING;
 
@@ -227,6 +254,8 @@ sharkd_init(int argc, char **argv)
         {"help", ws_no_argument, NULL, 'h'},
         {"version", ws_no_argument, NULL, 'v'},
         {"config-profile", ws_required_argument, NULL, 'C'},
+        {"preload", ws_required_argument, NULL, 'p'},
+        {"workers", ws_required_argument, NULL, 'w'},
         {0, 0, 0, 0 }
     };
 
@@ -321,11 +350,26 @@ sharkd_init(int argc, char **argv)
                     mode = SHARKD_MODE_GOLD_CONSOLE;
                     break;
 
+                case 'p':
+                    // Only the daemon can share a file with its session processes, by forking them
+                    preload_file = ws_optarg;
+                    break;
+
                 case 'v':         /* Show version and exit */
                     show_version();
                     exit(0);
                     break;
 
+                case 'w':
+                    // Only the daemon keeps session processes ready, by forking them
+#ifndef _WIN32
+                    if (!ws_strtou32(ws_optarg, NULL, &pool_size)) {
+                        fprintf(stderr, "Invalid number of workers \"%s\"\n", ws_optarg);
+                        return -1;
+                    }
+#endif
+                    break;
+
                 default:
                     if (!ws_optopt)
                         fprintf(stderr, "This option isn't supported: %s\n", argv[ws_optind]);
@@ -355,6 +399,172 @@ sharkd_init(int argc, char **argv)
     return 0;
 }
 
+#ifndef _WIN32
+/* Pass the descriptor fd over the UNIX socket sock. */
+static gboolean
+sharkd_send_fd(int sock, int fd)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char byte = 0;
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&control, 0, sizeof(control));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    return sendmsg(sock, &msg, 0) == 1;
+}
+
+/* Wait for a descriptor passed over sock; returns -1 if there isn't one. */
+static int
+sharkd_recv_fd(int sock)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char byte;
+    int fd = -1;
+    ssize_t n;
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    do
+        n = recvmsg(sock, &msg, 0);
+    while (n == -1 && errno == EINTR);
+    if (n <= 0)
+        return -1;
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+/*
+ * In a session process, close our copies of the daemon's ends of the
+ * workers' sockets, so that they see it go away when it does.
+ */
+static void
+sharkd_pool_close(void)
+{
+    for (guint i = 0; i < idle_workers->len; i++)
+        close(g_array_index(idle_workers, struct sharkd_worker, i).fd);
+    g_array_set_size(idle_workers, 0);
+}
+
+/*
+ * A worker: set up the session, which is the part of it that doesn't
+ * need the client, then wait for a connection to handle.
+ */
+static int
+sharkd_worker_main(int sock)
+{
+    int fd;
+
+    closesocket(_server_fd);
+    sharkd_pool_close();
+    signal(SIGPIPE, SIG_DFL);
+
+    if (sharkd_preload_attach() != 0)
+        fprintf(stderr, "cannot reopen the preloaded file\n");
+    sharkd_session_init(mode);
+
+    fd = sharkd_recv_fd(sock);
+    close(sock);
+    if (fd == -1)
+        return 0;   /* the daemon has gone away */
+
+    /* redirect stdin, stdout to socket */
+    dup2(fd, 0);
+    dup2(fd, 1);
+    close(fd);
+
+    return sharkd_session_main(mode);
+}
+
+/* Fork workers until there are pool_size of them waiting. */
+static void
+sharkd_pool_fill(void)
+{
+    while (idle_workers->len < pool_size)
+    {
+        struct sharkd_worker worker;
+        int fds[2];
+
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+        {
+            fprintf(stderr, "cannot socketpair(): %s\n", g_strerror(errno));
+            return;
+        }
+
+        worker.pid = fork();
+        if (worker.pid == 0)
+        {
+            close(fds[0]);
+            exit(sharkd_worker_main(fds[1]));
+        }
+        close(fds[1]);
+        if (worker.pid == -1)
+        {
+            fprintf(stderr, "cannot fork(): %s\n", g_strerror(errno));
+            close(fds[0]);
+            return;
+        }
+
+        worker.fd = fds[0];
+        g_array_append_val(idle_workers, worker);
+    }
+}
+
+/*
+ * Hand the connection fd to a waiting worker.  Returns FALSE if there
+ * isn't one that'll take it.
+ */
+static gboolean
+sharkd_pool_handoff(socket_handle_t fd)
+{
+    while (idle_workers->len != 0)
+    {
+        struct sharkd_worker worker = g_array_index(idle_workers, struct sharkd_worker, 0);
+        gboolean sent;
+
+        g_array_remove_index(idle_workers, 0);
+        sent = sharkd_send_fd(worker.fd, fd);
+        close(worker.fd);
+        if (sent)
+            return TRUE;
+        /* It must have died; try the next one. */
+    }
+    return FALSE;
+}
+#endif
+
 int
 #ifndef _WIN32
 sharkd_loop(int argc _U_, char* argv[] _U_)
@@ -367,6 +577,26 @@ sharkd_loop(int argc _U_, char* argv[])
         return sharkd_session_main(mode);
     }
 
+#ifndef _WIN32
+    if (preload_file != NULL)
+    {
+        int err = sharkd_preload_cap_file(preload_file);
+
+        if (err != 0)
+            fprintf(stderr, "cannot preload %s, sessions will load it themselves\n", preload_file);
+        else
+            fprintf(stderr, "Sharkd preloaded: %s\n", preload_file);
+    }
+
+    idle_workers = g_array_new(FALSE, FALSE, sizeof(struct sharkd_worker));
+    if (pool_size != 0)
+    {
+        /* A worker that's died shouldn't take us with it when we hand it a connection. */
+        signal(SIGPIPE, SIG_IGN);
+        sharkd_pool_fill();
+    }
+#endif
+
     while (1)
     {
 #ifndef _WIN32
@@ -390,15 +620,27 @@ sharkd_loop(int argc _U_, char* argv[])
 
         /* wireshark is not ready for handling multiple capture files in single process, so fork(), and handle it in separate process */
 #ifndef _WIN32
+        if (sharkd_pool_handoff(fd))
+        {
+            closesocket(fd);
+            sharkd_pool_fill();
+            continue;
+        }
+
         pid = fork();
         if (pid == 0)
         {
             closesocket(_server_fd);
+            sharkd_pool_close();
+            signal(SIGPIPE, SIG_DFL);
             /* redirect stdin, stdout to socket */
             dup2(fd, 0);
             dup2(fd, 1);
             close(fd);
 
+            if (sharkd_preload_attach() != 0)
+                fprintf(stderr, "cannot reopen the preloaded file\n");
+
             exit(sharkd_session_main(mode));
         }
 
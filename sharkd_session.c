@@ -9,6 +9,8 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#define _GNU_SOURCE /* For fopencookie(). */
+
 #include "wtap_opttypes.h"
 #include <config.h>
 
@@ -18,6 +20,13 @@
 #include <string.h>
 #include <errno.h>
 
+#ifndef _WIN32
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include <glib.h>
 
 #include <wsutil/wsjson.h>
@@ -69,6 +78,7 @@
 
 #include <epan/maxmind_db.h>
 
+#include <wsutil/perf_stats.h>
 #include <wsutil/pint.h>
 #include <wsutil/strtoi.h>
 
@@ -78,16 +88,151 @@
 
 struct sharkd_filter_item
 {
-    guint8 *filtered; /* can be NULL if all frames are matching for given filter. */
+    sharkd_bitmap *passed; /* can be NULL if all frames are matching for given filter. */
+    size_t size;           /* memory used by passed */
+    GList *lru;            /* our entry in filter_lru */
 };
 
+/*
+ * The most memory that the results of filters can use; the results used
+ * least recently are dropped to stay under it.
+ */
+#define SHARKD_FILTER_CACHE_MAX (64 * 1024 * 1024)
+
 static GHashTable *filter_table = NULL;
+static GQueue filter_lru = G_QUEUE_INIT;   /* of filter strings, most recently used first */
+static size_t filter_cache_size = 0;
+
+/*
+ * What we sent for a frame in answer to a frames request, other than
+ * what can change without dissecting it again.
+ */
+struct sharkd_column_item
+{
+    guint32 framenum;
+    char **texts;           /* column texts */
+    gboolean has_comment;   /* if the frame's own block has a comment */
+    size_t size;            /* memory used by texts */
+    GList *lru;             /* our entry in column_lru */
+};
+
+/*
+ * The most memory that the column texts of frames can use; the frames
+ * sent least recently are dropped to stay under it.
+ */
+#define SHARKD_COLUMN_CACHE_MAX (16 * 1024 * 1024)
+
+static GHashTable *column_table = NULL;    /* frame number -> struct sharkd_column_item */
+static GQueue column_lru = G_QUEUE_INIT;   /* of struct sharkd_column_item, most recently used first */
+static size_t column_cache_size = 0;
+static char *column_cache_columns = NULL;  /* the column set that column_table is for */
+
+static GPtrArray *iograph_cache = NULL;    /* of struct sharkd_iograph, least recently used first */
+static GHashTable *stream_index_table = NULL; /* field name -> struct sharkd_stream_index */
+
+/*
+ * The number of buckets request times are counted in: the first is for
+ * requests that took under 1 ms, each of the next ones is for requests
+ * that took up to twice as long as those in the one before, and the last
+ * is for the rest.
+ */
+#define SHARKD_METRICS_BUCKETS 16
+
+struct sharkd_method_metrics
+{
+    guint64 requests;
+    gint64 total_time;          /* in microseconds, as are the rest */
+    gint64 dissect_time;        /* the part of total_time spent dissecting frames */
+    gint64 filter_time;         /* and filtering them */
+    gint64 max_time;
+    guint64 buckets[SHARKD_METRICS_BUCKETS];
+};
+
+static GHashTable *metrics_table = NULL;   /* method name -> struct sharkd_method_metrics */
+static guint32 slow_request_ms = 0;        /* log requests that take longer than this, if it isn't 0 */
 
 static int mode;
 static guint32 rpcid;
 
 static json_dumper dumper = {0};
 
+#if defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN)
+#define SHARKD_HAVE_FRAMES
+#endif
+
+/*
+ * With the "cbor" encoding, dumper.output_file splits what's written to
+ * it into frames, each preceded by its length, and writes them here; a
+ * frame of length 0 ends each response.  NULL with the "json" encoding.
+ */
+static FILE *framed_output = NULL;
+
+/* The largest frame; also the size of the buffer that collects a frame. */
+#define SHARKD_FRAME_MAX (64 * 1024)
+
+#ifndef _WIN32
+/*
+ * A request that's being handled by a child process of its own, so that
+ * we can go on handling other requests until it's done.
+ */
+struct sharkd_job
+{
+    guint32 id;         /* of the request */
+    pid_t pid;
+    int fd;             /* from which we read the response */
+    GString *response;
+};
+
+static GPtrArray *jobs = NULL;
+#endif
+
+#ifdef SHARKD_HAVE_FRAMES
+/*
+ * Write what the dumper wrote as one frame: its length, as a 4-byte
+ * big-endian number, then the bytes themselves.  The FILE's buffer is
+ * SHARKD_FRAME_MAX bytes, so stdio never hands us more than that.
+ */
+#ifdef HAVE_FOPENCOOKIE
+static ssize_t
+sharkd_framed_write(void *cookie, const char *buf, size_t size)
+#else
+static int
+sharkd_framed_write(void *cookie, const char *buf, int size)
+#endif
+{
+    FILE *out = (FILE *)cookie;
+    guint8 len[4];
+
+    /* A frame of length 0 would end the response. */
+    if (size == 0)
+        return 0;
+
+    phton32(len, (guint32)size);
+    if (fwrite(len, 1, sizeof len, out) != sizeof len ||
+        fwrite(buf, 1, (size_t)size, out) != (size_t)size)
+        return -1;
+    return size;
+}
+
+/* A FILE that writes what's written to it to out as frames. */
+static FILE *
+sharkd_framed_open(FILE *out)
+{
+    FILE *fh;
+
+#ifdef HAVE_FOPENCOOKIE
+    cookie_io_functions_t funcs = { NULL, sharkd_framed_write, NULL, NULL };
+
+    fh = fopencookie(out, "w", funcs);
+#else
+    fh = funopen(out, NULL, sharkd_framed_write, NULL, NULL);
+#endif
+    if (fh != NULL)
+        setvbuf(fh, NULL, _IOFBF, SHARKD_FRAME_MAX);
+    return fh;
+}
+#endif
+
 
 static const char *
 json_find_attr(const char *buf, const jsmntok_t *tokens, int count, const char *attr)
@@ -202,7 +347,15 @@ sharkd_json_response_close(void)
      * which is too inefficient, and full buffering,
      * which is what you get if you request line buffering.
      */
-    fflush(stdout);
+    fflush(dumper.output_file);
+
+    if (framed_output != NULL)
+    {
+        static const guint8 end_of_response[4] = { 0, 0, 0, 0 };
+
+        fwrite(end_of_response, 1, sizeof end_of_response, framed_output);
+        fflush(framed_output);
+    }
 }
 
 static void
@@ -365,10 +518,12 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         // Valid methods
         {"method",     "analyse",    1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "bye",        1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
+        {"method",     "cancel",     1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "check",      1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "complete",   1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "download",   1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "dumpconf",   1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
+        {"method",     "encoding",   1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "follow",     1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "frame",      1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "frames",     1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
@@ -376,18 +531,22 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"method",     "intervals",  1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "iograph",    1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "load",       1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
+        {"method",     "metrics",    1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
+        {"method",     "perfstats",  1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "setcomment", 1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "setconf",    1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "status",     1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"method",     "tap",        1, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
 
         // Parameters and their method context
+        {"cancel",     "id",         2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, MANDATORY},
         {"check",      "field",      2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"check",      "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"complete",   "field",      2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"complete",   "pref",       2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"download",   "token",      2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"dumpconf",   "pref",       2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
+        {"encoding",   "encoding",   2, JSMN_STRING,       SHARKD_JSON_STRING,   MANDATORY},
         {"follow",     "follow",     2, JSMN_STRING,       SHARKD_JSON_STRING,   MANDATORY},
         {"follow",     "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   MANDATORY},
         {"frame",      "frame",      2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, MANDATORY},
@@ -405,6 +564,7 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"frames",     "refs",       2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"intervals",  "interval",   2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, OPTIONAL},
         {"intervals",  "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
+        {"iograph",    "background", 2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  OPTIONAL},
         {"iograph",    "interval",   2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, OPTIONAL},
         {"iograph",    "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"iograph",    "graph0",     2, JSMN_STRING,       SHARKD_JSON_STRING,   MANDATORY},
@@ -428,10 +588,14 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"iograph",    "filter8",    2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"iograph",    "filter9",    2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"load",       "file",       2, JSMN_STRING,       SHARKD_JSON_STRING,   MANDATORY},
+        {"load",       "tail",       2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  OPTIONAL},
+        {"metrics",    "slow",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, OPTIONAL},
+        {"perfstats",  "reset",      2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  OPTIONAL},
         {"setcomment", "frame",      2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, MANDATORY},
         {"setcomment", "comment",    2, JSMN_STRING,       SHARKD_JSON_STRING,   OPTIONAL},
         {"setconf",    "name",       2, JSMN_STRING,       SHARKD_JSON_STRING,   MANDATORY},
         {"setconf",    "value",      2, JSMN_UNDEFINED,    SHARKD_JSON_ANY,      MANDATORY},
+        {"tap",        "background", 2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  OPTIONAL},
         {"tap",        "tap0",       2, JSMN_STRING,       SHARKD_JSON_STRING, MANDATORY},
         {"tap",        "tap1",       2, JSMN_STRING,       SHARKD_JSON_STRING, OPTIONAL},
         {"tap",        "tap2",       2, JSMN_STRING,       SHARKD_JSON_STRING, OPTIONAL},
@@ -706,34 +870,316 @@ sharkd_session_filter_free(gpointer data)
 {
     struct sharkd_filter_item *l = (struct sharkd_filter_item *) data;
 
-    g_free(l->filtered);
+    g_queue_delete_link(&filter_lru, l->lru);
+    filter_cache_size -= l->size;
+    sharkd_bitmap_free(l->passed);
     g_free(l);
 }
 
+/*
+ * Split filter into the operands of its top-level operators, if those
+ * are all "and" or all "or"; returns the operands, or NULL if filter
+ * doesn't have any top-level operators, or has some of each.
+ */
+static GPtrArray *
+sharkd_session_filter_split(const char *filter, gboolean *either)
+{
+    GPtrArray *operands = g_ptr_array_new_with_free_func(g_free);
+    const char *operand = filter;
+    const char *p;
+    char quote = '\0';
+    int depth = 0;
+    int ops = 0;    /* 1 for "and", 2 for "or" */
+
+    for (p = filter; *p != '\0'; p++)
+    {
+        int op = 0;
+        size_t op_len = 0;
+
+        if (quote != '\0')
+        {
+            if (*p == '\\' && p[1] != '\0')
+                p++;
+            else if (*p == quote)
+                quote = '\0';
+            continue;
+        }
+
+        if (*p == '"' || *p == '\'')
+            quote = *p;
+        else if (*p == '(')
+            depth++;
+        else if (*p == ')')
+            depth--;
+        else if (depth == 0)
+        {
+            gboolean word_start = (p != filter && (g_ascii_isspace(p[-1]) || p[-1] == ')'));
+
+            if (!strncmp(p, "&&", 2) || !strncmp(p, "||", 2))
+                op_len = 2;
+            else if (word_start && !strncmp(p, "and", 3) && (g_ascii_isspace(p[3]) || p[3] == '('))
+                op_len = 3;
+            else if (word_start && !strncmp(p, "or", 2) && (g_ascii_isspace(p[2]) || p[2] == '('))
+                op_len = 2;
+            if (op_len != 0)
+                op = (*p == '&' || *p == 'a') ? 1 : 2;
+        }
+
+        if (op != 0)
+        {
+            ops |= op;
+            g_ptr_array_add(operands, g_strstrip(g_strndup(operand, p - operand)));
+            p += op_len - 1;
+            operand = p + 1;
+        }
+    }
+
+    if (ops != 1 && ops != 2)
+    {
+        g_ptr_array_free(operands, TRUE);
+        return NULL;
+    }
+
+    g_ptr_array_add(operands, g_strstrip(g_strdup(operand)));
+    *either = (ops == 2);
+    return operands;
+}
+
+/*
+ * If filter is "a && b && ..." or "a || b || ...", and we have the
+ * results of each of a, b, ..., work out its results from those rather
+ * than by dissecting every frame again.
+ */
+static gboolean
+sharkd_session_filter_combine(const char *filter, sharkd_bitmap **result)
+{
+    GPtrArray *operands;
+    const sharkd_bitmap *acc = NULL;
+    sharkd_bitmap *combined = NULL;
+    gboolean either;
+    guint i;
+
+    /*
+     * Whether a frame is displayed depends on the whole filter, so
+     * filters that look at that can't be worked out from their parts.
+     */
+    if (strstr(filter, "displayed") != NULL)
+        return FALSE;
+
+    operands = sharkd_session_filter_split(filter, &either);
+    if (operands == NULL)
+        return FALSE;
+
+    for (i = 0; i < operands->len; i++)
+    {
+        if (!g_hash_table_contains(filter_table, g_ptr_array_index(operands, i)))
+        {
+            g_ptr_array_free(operands, TRUE);
+            return FALSE;
+        }
+    }
+
+    for (i = 0; i < operands->len; i++)
+    {
+        const struct sharkd_filter_item *l =
+            (const struct sharkd_filter_item *) g_hash_table_lookup(filter_table, g_ptr_array_index(operands, i));
+        sharkd_bitmap *next;
+
+        if (l->passed == NULL)
+        {
+            /* Every frame matches it. */
+            if (!either)
+                continue;
+            acc = NULL;
+            break;
+        }
+
+        if (acc == NULL)
+        {
+            acc = l->passed;
+            continue;
+        }
+
+        next = sharkd_bitmap_combine(acc, l->passed, either);
+        sharkd_bitmap_free(combined);
+        combined = next;
+        acc = next;
+        if (next == NULL)
+        {
+            g_ptr_array_free(operands, TRUE);
+            return FALSE;
+        }
+    }
+
+    g_ptr_array_free(operands, TRUE);
+
+    if (acc != NULL && combined == NULL)
+    {
+        /* Only one operand didn't match every frame; take a copy of its results. */
+        combined = sharkd_bitmap_combine(acc, acc, FALSE);
+        if (combined == NULL)
+            return FALSE;
+    }
+    else if (acc == NULL)
+    {
+        sharkd_bitmap_free(combined);
+        combined = NULL;
+    }
+
+    *result = combined;
+    return TRUE;
+}
+
 static const struct sharkd_filter_item *
 sharkd_session_filter_data(const char *filter)
 {
     struct sharkd_filter_item *l;
+    char *key;
 
     l = (struct sharkd_filter_item *) g_hash_table_lookup(filter_table, filter);
-    if (!l)
+    if (l)
     {
-        guint8 *filtered = NULL;
+        g_queue_unlink(&filter_lru, l->lru);
+        g_queue_push_head_link(&filter_lru, l->lru);
+        return l;
+    }
 
-        int ret = sharkd_filter(filter, &filtered);
+    l = g_new(struct sharkd_filter_item, 1);
+    l->passed = NULL;
 
-        if (ret == -1)
+    if (!sharkd_session_filter_combine(filter, &l->passed))
+    {
+        if (sharkd_filter(filter, &l->passed) == -1)
+        {
+            g_free(l);
             return NULL;
+        }
+    }
 
-        l = g_new(struct sharkd_filter_item, 1);
-        l->filtered = filtered;
+    l->size = (l->passed != NULL) ? sharkd_bitmap_size(l->passed) : 0;
+    filter_cache_size += l->size;
 
-        g_hash_table_insert(filter_table, g_strdup(filter), l);
-    }
+    key = g_strdup(filter);
+    g_queue_push_head(&filter_lru, key);
+    l->lru = filter_lru.head;
+    g_hash_table_insert(filter_table, key, l);
+
+    /* Make room for it, by dropping the results we've used least recently. */
+    while (filter_cache_size > SHARKD_FILTER_CACHE_MAX && filter_lru.tail != l->lru)
+        g_hash_table_remove(filter_table, filter_lru.tail->data);
 
     return l;
 }
 
+static void
+sharkd_column_item_free(gpointer data)
+{
+    struct sharkd_column_item *item = (struct sharkd_column_item *) data;
+
+    g_queue_delete_link(&column_lru, item->lru);
+    column_cache_size -= item->size;
+    g_strfreev(item->texts);
+    g_free(item);
+}
+
+/*
+ * Forget what we've worked out from dissecting frames, when the file
+ * or preferences have changed.
+ */
+static void
+sharkd_session_forget_results(void)
+{
+    g_hash_table_remove_all(filter_table);
+    g_hash_table_remove_all(column_table);
+    g_ptr_array_set_size(iograph_cache, 0);
+    g_hash_table_remove_all(stream_index_table);
+}
+
+/*
+ * Make the cache hold the column texts for the column set columns, which
+ * it takes ownership of.  The cache only holds one column set; switching
+ * to another empties it.
+ */
+static void
+sharkd_column_cache_use(char *columns)
+{
+    if (g_strcmp0(columns, column_cache_columns) == 0)
+    {
+        g_free(columns);
+        return;
+    }
+
+    g_hash_table_remove_all(column_table);
+    g_free(column_cache_columns);
+    column_cache_columns = columns;
+}
+
+/* Get the column texts for frame framenum, if we have them. */
+static struct sharkd_column_item *
+sharkd_column_cache_lookup(guint32 framenum)
+{
+    struct sharkd_column_item *item;
+
+    item = (struct sharkd_column_item *) g_hash_table_lookup(column_table, GUINT_TO_POINTER(framenum));
+    if (item)
+    {
+        g_queue_unlink(&column_lru, item->lru);
+        g_queue_push_head_link(&column_lru, item->lru);
+    }
+    return item;
+}
+
+static struct sharkd_column_item *
+sharkd_column_cache_add(guint32 framenum, struct epan_column_info *cinfo, gboolean has_comment)
+{
+    struct sharkd_column_item *item = g_new(struct sharkd_column_item, 1);
+
+    item->framenum = framenum;
+    item->texts = g_new(char *, cinfo->num_cols + 1);
+    item->size = sizeof(*item) + (cinfo->num_cols + 1) * sizeof(char *);
+    for (int col = 0; col < cinfo->num_cols; ++col)
+    {
+        item->texts[col] = g_strdup(get_column_text(cinfo, col));
+        item->size += strlen(item->texts[col]) + 1;
+    }
+    item->texts[cinfo->num_cols] = NULL;
+    item->has_comment = has_comment;
+
+    g_hash_table_replace(column_table, GUINT_TO_POINTER(framenum), item);
+    g_queue_push_head(&column_lru, item);
+    item->lru = column_lru.head;
+    column_cache_size += item->size;
+
+    while (column_cache_size > SHARKD_COLUMN_CACHE_MAX && column_lru.tail != item->lru)
+        g_hash_table_remove(column_table, GUINT_TO_POINTER(((struct sharkd_column_item *) column_lru.tail->data)->framenum));
+
+    return item;
+}
+
+/*
+ * A string that's the same for two frames requests only if they ask
+ * for the same columns.
+ */
+static char *
+sharkd_session_columns_key(const char *buf, const jsmntok_t *tokens, int count)
+{
+    GString *key = g_string_new(NULL);
+
+    for (int i = 0; i < 32; i++)
+    {
+        const char *tok_column;
+        char tok_column_name[64];
+
+        snprintf(tok_column_name, sizeof(tok_column_name), "column%d", i);
+        tok_column = json_find_attr(buf, tokens, count, tok_column_name);
+        if (tok_column == NULL)
+            break;
+        g_string_append(key, tok_column);
+        g_string_append_c(key, '\n');
+    }
+    return g_string_free(key, FALSE);
+}
+
 static gboolean
 sharkd_rtp_match_init(rtpstream_id_t *id, const char *init_str)
 {
@@ -1051,6 +1497,12 @@ sharkd_session_process_info(void)
  *
  * Input:
  *   (m) file - file to be loaded
+ *   (o) tail - true to follow the file as it's written, e.g. by dumpcap; frames
+ *              written to it later are read and dissected as they appear, the
+ *              results of filters and I/O graphs kept for the session are brought
+ *              up to date, and the client is sent a "tail" notification, with
+ *              the number of frames and the duration, like those of status.
+ *              Not supported on Windows, where the file is just loaded.
  *
  * Output object with attributes:
  *   (m) err - error code
@@ -1059,13 +1511,31 @@ static void
 sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 {
     const char *tok_file = json_find_attr(buf, tokens, count, "file");
+    const char *tok_tail = json_find_attr(buf, tokens, count, "tail");
+    gboolean tail = FALSE;
     int err = 0;
 
     if (!tok_file)
         return;
 
+#ifndef _WIN32
+    tail = (tok_tail != NULL && !strcmp(tok_tail, "true"));
+#else
+    (void) tok_tail;
+#endif
+
     fprintf(stderr, "load: filename=%s\n", tok_file);
 
+    if (!tail && sharkd_is_preloaded(tok_file))
+    {
+        /* The daemon has already loaded it for us. */
+        sharkd_json_simple_ok(rpcid);
+        return;
+    }
+
+    /* What we know about frames was for the file we had before. */
+    sharkd_session_forget_results();
+
     if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
     {
         sharkd_json_error(
@@ -1077,7 +1547,7 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
     TRY
     {
-        err = sharkd_load_cap_file();
+        err = tail ? sharkd_tail_cap_file() : sharkd_load_cap_file();
     }
     CATCH(OutOfMemoryError)
     {
@@ -1321,38 +1791,37 @@ sharkd_session_create_columns(column_info *cinfo, const char *buf, const jsmntok
 }
 
 static void
-sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
-        struct epan_column_info *cinfo, const GSList *data_src _U_, void *data _U_)
+sharkd_session_process_frames_write(const frame_data *fdata, const struct sharkd_column_item *item)
 {
-    packet_info *pi = &edt->pi;
-    frame_data *fdata = pi->fd;
     wtap_block_t pkt_block = NULL;
     char *comment;
+    gboolean has_comment;
+    const color_filter_t *color_filter;
 
     json_dumper_begin_object(&dumper);
 
     sharkd_json_array_open("c");
-    for (int col = 0; col < cinfo->num_cols; ++col)
+    for (int col = 0; item->texts[col] != NULL; ++col)
     {
-        sharkd_json_value_string(NULL, get_column_text(cinfo, col));
+        sharkd_json_value_string(NULL, item->texts[col]);
     }
     sharkd_json_array_close();
 
-    sharkd_json_value_anyf("num", "%u", pi->num);
+    sharkd_json_value_anyf("num", "%u", fdata->num);
 
     /*
-     * Get the block for this record, if it has one.
+     * Does this record have any comments?
      */
     if (fdata->has_modified_block)
+    {
         pkt_block = sharkd_get_modified_block(fdata);
+        has_comment = (pkt_block != NULL &&
+                WTAP_OPTTYPE_SUCCESS == wtap_block_get_nth_string_option_value(pkt_block, OPT_COMMENT, 0, &comment));
+    }
     else
-        pkt_block = pi->rec->block;
+        has_comment = item->has_comment;
 
-    /*
-     * Does this record have any comments?
-     */
-    if (pkt_block != NULL &&
-            WTAP_OPTTYPE_SUCCESS == wtap_block_get_nth_string_option_value(pkt_block, OPT_COMMENT, 0, &comment))
+    if (has_comment)
         sharkd_json_value_anyf("ct", "true");
 
     if (fdata->ignored)
@@ -1361,15 +1830,34 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
     if (fdata->marked)
         sharkd_json_value_anyf("m", "true");
 
-    if (fdata->color_filter)
+    color_filter = color_filters_get_by_index(fdata->color_index);
+    if (color_filter)
     {
-        sharkd_json_value_stringf("bg", "%x", color_t_to_rgb(&fdata->color_filter->bg_color));
-        sharkd_json_value_stringf("fg", "%x", color_t_to_rgb(&fdata->color_filter->fg_color));
+        sharkd_json_value_stringf("bg", "%x", color_t_to_rgb(&color_filter->bg_color));
+        sharkd_json_value_stringf("fg", "%x", color_t_to_rgb(&color_filter->fg_color));
     }
 
     json_dumper_end_object(&dumper);
 }
 
+static void
+sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
+        struct epan_column_info *cinfo, const GSList *data_src _U_, void *data _U_)
+{
+    packet_info *pi = &edt->pi;
+    wtap_block_t pkt_block = pi->rec->block;
+    char *comment;
+    gboolean has_comment;
+    const struct sharkd_column_item *item;
+
+    /* Whether the block we read has a comment doesn't change; the modified block is looked at every time. */
+    has_comment = (pkt_block != NULL &&
+            WTAP_OPTTYPE_SUCCESS == wtap_block_get_nth_string_option_value(pkt_block, OPT_COMMENT, 0, &comment));
+
+    item = sharkd_column_cache_add(pi->num, cinfo, has_comment);
+    sharkd_session_process_frames_write(pi->fd, item);
+}
+
 /**
  * sharkd_session_process_frames()
  *
@@ -1401,17 +1889,21 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
     const char *tok_limit  = json_find_attr(buf, tokens, count, "limit");
     const char *tok_refs   = json_find_attr(buf, tokens, count, "refs");
 
-    const guint8 *filter_data = NULL;
+    const sharkd_bitmap *filter_data = NULL;
 
     guint32 next_ref_frame = G_MAXUINT32;
     guint32 skip;
     guint32 limit;
+    guint32 first_frame;
 
     wtap_rec rec; /* Record metadata */
     Buffer rec_buf;   /* Record data */
     column_info *cinfo = &cfile.cinfo;
     column_info user_cinfo;
 
+    /* Before sharkd_session_create_columns() splits the custom columns up. */
+    sharkd_column_cache_use(sharkd_session_columns_key(buf, tokens, count));
+
     if (tok_column)
     {
         memset(&user_cinfo, 0, sizeof(user_cinfo));
@@ -1440,7 +1932,7 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
             return;
         }
 
-        filter_data = filter_item->filtered;
+        filter_data = filter_item->passed;
     }
 
     skip = 0;
@@ -1450,6 +1942,19 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
             return;
     }
 
+    /*
+     * Go straight to the first frame after the ones to skip, so that
+     * a page near the end costs no more than one at the start.
+     */
+    if (filter_data)
+    {
+        first_frame = sharkd_bitmap_select(filter_data, skip);
+        if (first_frame == 0)
+            first_frame = cfile.count + 1;
+    }
+    else
+        first_frame = (skip < cfile.count) ? skip + 1 : cfile.count + 1;
+
     limit = 0;
     if (tok_limit)
     {
@@ -1468,22 +1973,17 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
     wtap_rec_init(&rec);
     ws_buffer_init(&rec_buf, 1514);
 
-    for (guint32 framenum = 1; framenum <= cfile.count; framenum++)
+    for (guint32 framenum = first_frame; framenum <= cfile.count; framenum++)
     {
         frame_data *fdata;
+        const struct sharkd_column_item *column_item;
         enum dissect_request_status status;
         int err;
         gchar *err_info;
 
-        if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
+        if (filter_data && !sharkd_bitmap_test(filter_data, framenum))
             continue;
 
-        if (skip)
-        {
-            skip--;
-            continue;
-        }
-
         if (tok_refs)
         {
             if (framenum >= next_ref_frame)
@@ -1508,10 +2008,21 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
         }
 
         fdata = sharkd_get_frame(framenum);
+
+        /* If we've sent this frame before, send the same again without dissecting it. */
+        column_item = sharkd_column_cache_lookup(framenum);
+        if (column_item)
+        {
+            sharkd_session_process_frames_write(fdata, column_item);
+            if (limit && --limit == 0)
+                break;
+            continue;
+        }
+
         status = sharkd_dissect_request(framenum,
                 (framenum != 1) ? 1 : 0, framenum - 1,
                 &rec, &rec_buf, cinfo,
-                (fdata->color_filter == NULL) ? SHARKD_DISSECT_FLAG_COLOR : SHARKD_DISSECT_FLAG_NULL,
+                (fdata->color_index == 0) ? SHARKD_DISSECT_FLAG_COLOR : SHARKD_DISSECT_FLAG_NULL,
                 &sharkd_session_process_frames_cb, NULL,
                 &err, &err_info);
         switch (status) {
@@ -2761,6 +3272,8 @@ sharkd_session_process_tap_rtp_cb(void *arg)
  * Input:
  *   (m) tap0         - First tap request
  *   (o) tap1...tap15 - Other tap requests
+ *   (o) background   - true to answer other requests while this one is being handled,
+ *                      see sharkd_session_process_background()
  *
  * Output object with attributes:
  *   (m) taps  - array of object with attributes:
@@ -3153,28 +3666,171 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
     }
 }
 
-/**
- * sharkd_session_process_follow()
- *
- * Process follow request
- *
- * Input:
- *   (m) follow  - follow protocol request (e.g. HTTP)
- *   (m) filter  - filter request (e.g. tcp.stream == 1)
- *
- * Output object with attributes:
- *
- *   (m) err    - error code
- *   (m) shost  - server host
- *   (m) sport  - server port
- *   (m) sbytes - server send bytes count
- *   (m) chost  - client host
- *   (m) cport  - client port
- *   (m) cbytes - client send bytes count
- *   (o) payloads - array of object with attributes:
- *                  (o) s - set if server sent, else client
- *                  (m) n - packet number
- *                  (m) d - data base64 encoded
+/*
+ * The frames that have each value of a field that picks out a stream,
+ * e.g. tcp.stream, so that following a stream only dissects its frames.
+ */
+struct sharkd_stream_index
+{
+    GHashTable *frames;     /* value -> GArray of frame numbers */
+    guint32 frame_count;    /* the frames it's been made from */
+};
+
+static void
+sharkd_stream_index_free(gpointer data)
+{
+    struct sharkd_stream_index *index = (struct sharkd_stream_index *) data;
+
+    g_hash_table_destroy(index->frames);
+    g_free(index);
+}
+
+static void
+sharkd_stream_frames_free(gpointer data)
+{
+    g_array_free((GArray *) data, TRUE);
+}
+
+/* Could the rest of a filter let in frames that its start doesn't? */
+static gboolean
+sharkd_filter_has_or(const char *p)
+{
+    if (strstr(p, "||") || strstr(p, "^^"))
+        return TRUE;
+
+    while (*p)
+    {
+        const char *word = p;
+
+        while (g_ascii_isalnum(*p) || *p == '_' || *p == '.')
+            p++;
+        if ((p - word == 2 && g_ascii_strncasecmp(word, "or", 2) == 0) ||
+            (p - word == 3 && g_ascii_strncasecmp(word, "xor", 3) == 0))
+            return TRUE;
+        if (p == word)
+            p++;
+    }
+    return FALSE;
+}
+
+/*
+ * If only frames in one stream can match filter, as with "tcp.stream eq 3"
+ * or "quic.connection.number == 3 && quic.stream.stream_id == 5", which
+ * are what the followers' filters look like, return the frames in that
+ * stream; otherwise return NULL.
+ */
+static const GArray *
+sharkd_session_stream_frames(const char *filter)
+{
+    const char *p = filter;
+    const char *field_start;
+    char *field;
+    header_field_info *hfi;
+    guint32 value;
+    struct sharkd_stream_index *index;
+    GArray *frames;
+
+    if (filter == NULL)
+        return NULL;
+
+    while (g_ascii_isspace(*p))
+        p++;
+    field_start = p;
+    while (g_ascii_isalnum(*p) || *p == '.' || *p == '_' || *p == '-')
+        p++;
+    field = g_strndup(field_start, p - field_start);
+
+    while (g_ascii_isspace(*p))
+        p++;
+    if (strncmp(p, "==", 2) == 0)
+        p += 2;
+    else if (g_ascii_strncasecmp(p, "eq", 2) == 0 && g_ascii_isspace(p[2]))
+        p += 2;
+    else
+        p = NULL;
+    if (p)
+    {
+        while (g_ascii_isspace(*p))
+            p++;
+        if (!ws_strtou32(p, &p, &value))
+            p = NULL;
+    }
+    if (p)
+    {
+        while (g_ascii_isspace(*p))
+            p++;
+        if (*p != '\0')
+        {
+            if (strncmp(p, "&&", 2) == 0)
+                p += 2;
+            else if (g_ascii_strncasecmp(p, "and", 3) == 0 && (g_ascii_isspace(p[3]) || p[3] == '('))
+                p += 3;
+            else
+                p = NULL;
+            if (p && sharkd_filter_has_or(p))
+                p = NULL;
+        }
+    }
+
+    /* Fields with the same name would all have to be indexed. */
+    if (p && (g_str_has_suffix(field, ".stream") || g_str_has_suffix(field, ".connection.number")))
+        hfi = proto_registrar_get_byname(field);
+    else
+        hfi = NULL;
+    if (hfi == NULL || !IS_FT_UINT32(hfi->type) || hfi->same_name_prev_id != -1 || hfi->same_name_next != NULL)
+    {
+        g_free(field);
+        return NULL;
+    }
+
+    index = (struct sharkd_stream_index *) g_hash_table_lookup(stream_index_table, field);
+    if (index == NULL)
+    {
+        index = g_new0(struct sharkd_stream_index, 1);
+        index->frames = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, sharkd_stream_frames_free);
+        g_hash_table_insert(stream_index_table, field, index);
+    }
+    else
+        g_free(field);
+
+    /* Index the frames read since we last looked, e.g. while tailing. */
+    if (index->frame_count < cfile.count)
+    {
+        sharkd_index_field(hfi->id, index->frames, index->frame_count + 1);
+        index->frame_count = cfile.count;
+    }
+
+    frames = (GArray *) g_hash_table_lookup(index->frames, GUINT_TO_POINTER(value));
+    if (frames == NULL)
+    {
+        frames = g_array_new(FALSE, FALSE, sizeof(guint32));
+        g_hash_table_insert(index->frames, GUINT_TO_POINTER(value), frames);
+    }
+    return frames;
+}
+
+/**
+ * sharkd_session_process_follow()
+ *
+ * Process follow request
+ *
+ * Input:
+ *   (m) follow  - follow protocol request (e.g. HTTP)
+ *   (m) filter  - filter request (e.g. tcp.stream == 1)
+ *
+ * Output object with attributes:
+ *
+ *   (m) err    - error code
+ *   (m) shost  - server host
+ *   (m) sport  - server port
+ *   (m) sbytes - server send bytes count
+ *   (m) chost  - client host
+ *   (m) cport  - client port
+ *   (m) cbytes - client send bytes count
+ *   (o) payloads - array of object with attributes:
+ *                  (o) s - set if server sent, else client
+ *                  (m) n - packet number
+ *                  (m) d - data base64 encoded
  */
 static void
 sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
@@ -3186,6 +3842,7 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
     GString *tap_error;
 
     follow_info_t *follow_info;
+    const GArray *frames;
     const char *host;
     char *port;
 
@@ -3215,7 +3872,11 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
         return;
     }
 
-    sharkd_retap();
+    frames = sharkd_session_stream_frames(tok_filter);
+    if (frames != NULL)
+        sharkd_retap_frames(frames);
+    else
+        sharkd_retap();
 
     sharkd_json_result_prologue(rpcid);
 
@@ -3419,6 +4080,7 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
     packet_info *pi = &edt->pi;
     frame_data *fdata = pi->fd;
     wtap_block_t pkt_block = NULL;
+    const color_filter_t *color_filter;
 
     const struct sharkd_frame_request_data * const req_data = (const struct sharkd_frame_request_data * const) data;
     const gboolean display_hidden = (req_data) ? req_data->display_hidden : FALSE;
@@ -3493,10 +4155,11 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
     if (fdata->marked)
         sharkd_json_value_anyf("m", "true");
 
-    if (fdata->color_filter)
+    color_filter = color_filters_get_by_index(fdata->color_index);
+    if (color_filter)
     {
-        sharkd_json_value_stringf("bg", "%x", color_t_to_rgb(&fdata->color_filter->bg_color));
-        sharkd_json_value_stringf("fg", "%x", color_t_to_rgb(&fdata->color_filter->fg_color));
+        sharkd_json_value_stringf("bg", "%x", color_t_to_rgb(&color_filter->bg_color));
+        sharkd_json_value_stringf("fg", "%x", color_t_to_rgb(&color_filter->fg_color));
     }
 
     if (data_src)
@@ -3576,9 +4239,26 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
 
 #define SHARKD_IOGRAPH_MAX_ITEMS 250000 /* 250k limit of items is taken from wireshark-qt, on x86_64 sizeof(io_graph_item_t) is 152, so single graph can take max 36 MB */
 
+/*
+ * When we tap for a graph, we try to do it with a finer interval than was
+ * asked for, as long as that doesn't take more than this many items, so
+ * that we can answer later requests for the same graph with other
+ * intervals without going through the file again.
+ */
+#define SHARKD_IOGRAPH_BASE_ITEMS 65536
+
+/* The number of graphs we keep the items of. */
+#define SHARKD_IOGRAPH_CACHE_MAX 32
+
+/*
+ * The items of a graph, over the whole file; also kept in iograph_cache,
+ * so that later requests for the same graph can be answered from them.
+ */
 struct sharkd_iograph
 {
     /* config */
+    char *key;          /* the filter and the graph request */
+    char *filter;
     int hf_index;
     io_graph_item_unit_t calc_type;
     guint32 interval;
@@ -3590,6 +4270,17 @@ struct sharkd_iograph
     GString *error;
 };
 
+static void
+sharkd_iograph_free(gpointer data)
+{
+    struct sharkd_iograph *graph = (struct sharkd_iograph *) data;
+
+    g_free(graph->key);
+    g_free(graph->filter);
+    g_free(graph->items);
+    g_free(graph);
+}
+
 static tap_packet_status
 sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_, tap_flags_t flags _U_)
 {
@@ -3626,6 +4317,141 @@ sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const vo
     return update_succeeded ? TAP_PACKET_REDRAW : TAP_PACKET_DONT_REDRAW;
 }
 
+/*
+ * The interval to tap for a graph with: the one asked for, divided by 10
+ * as often as it can be without taking more than SHARKD_IOGRAPH_BASE_ITEMS
+ * items for the file.  LOAD items depend on the interval, so LOAD graphs
+ * are tapped with the interval asked for.
+ */
+static guint32
+sharkd_iograph_base_interval(guint32 interval, io_graph_item_unit_t calc_type)
+{
+    guint64 duration_ms = (guint64) nstime_to_msec(&cfile.elapsed_time);
+
+    if (calc_type == IOG_ITEM_UNIT_CALC_LOAD)
+        return interval;
+
+    while (interval >= 10 && interval % 10 == 0 && duration_ms / (interval / 10) < SHARKD_IOGRAPH_BASE_ITEMS)
+        interval /= 10;
+    return interval;
+}
+
+/* Find the items of a graph from which one with this interval can be made. */
+static struct sharkd_iograph *
+sharkd_iograph_cache_lookup(const char *key, guint32 interval)
+{
+    for (guint i = 0; i < iograph_cache->len; i++)
+    {
+        struct sharkd_iograph *graph = (struct sharkd_iograph *) g_ptr_array_index(iograph_cache, i);
+
+        if (strcmp(graph->key, key) != 0 || interval % graph->interval != 0)
+            continue;
+        if (graph->calc_type == IOG_ITEM_UNIT_CALC_LOAD && graph->interval != interval)
+            continue;
+
+        /* Move it to the end, so that it's the last to be dropped. */
+        g_ptr_array_remove_index(iograph_cache, i);
+        g_ptr_array_add(iograph_cache, graph);
+        return graph;
+    }
+    return NULL;
+}
+
+/*
+ * The graphs a request uses were moved to the end by the lookup, and a
+ * request has fewer graphs than the cache holds, so this never drops one
+ * that's in use.
+ */
+static void
+sharkd_iograph_cache_add(struct sharkd_iograph *graph)
+{
+    if (iograph_cache->len >= SHARKD_IOGRAPH_CACHE_MAX)
+        g_ptr_array_remove_index(iograph_cache, 0);
+    g_ptr_array_add(iograph_cache, graph);
+}
+
+/* Add the item from, for a later interval, to the item to. */
+static void
+sharkd_iograph_merge_item(io_graph_item_t *to, const io_graph_item_t *from, int hf_index, io_graph_item_unit_t calc_type)
+{
+    gboolean greater, less;
+
+    if (from->first_frame_in_invl == 0)
+        return;
+
+    if (to->first_frame_in_invl == 0)
+        to->first_frame_in_invl = from->first_frame_in_invl;
+    to->last_frame_in_invl = from->last_frame_in_invl;
+    to->frames += from->frames;
+    to->bytes += from->bytes;
+
+    if (from->fields == 0)
+        return;
+
+    switch (hf_index >= 0 ? proto_registrar_get_ftype(hf_index) : FT_NONE)
+    {
+        case FT_FLOAT:
+            greater = from->float_max > to->float_max;
+            less = from->float_min < to->float_min;
+            break;
+        case FT_RELATIVE_TIME:
+            greater = nstime_cmp(&from->time_max, &to->time_max) > 0;
+            less = nstime_cmp(&from->time_min, &to->time_min) < 0;
+            break;
+        default:
+            greater = from->double_max > to->double_max;
+            less = from->double_min < to->double_min;
+            break;
+    }
+
+    if (greater || to->fields == 0)
+    {
+        to->int_max = from->int_max;
+        to->float_max = from->float_max;
+        to->double_max = from->double_max;
+        to->time_max = from->time_max;
+        if (calc_type == IOG_ITEM_UNIT_CALC_MAX)
+            to->extreme_frame_in_invl = from->extreme_frame_in_invl;
+    }
+    if (less || to->fields == 0)
+    {
+        to->int_min = from->int_min;
+        to->float_min = from->float_min;
+        to->double_min = from->double_min;
+        to->time_min = from->time_min;
+        if (calc_type == IOG_ITEM_UNIT_CALC_MIN)
+            to->extreme_frame_in_invl = from->extreme_frame_in_invl;
+    }
+
+    to->int_tot += from->int_tot;
+    to->float_tot += from->float_tot;
+    to->double_tot += from->double_tot;
+    nstime_add(&to->time_tot, &from->time_tot);
+    to->fields += from->fields;
+}
+
+/*
+ * Make the items for interval from those of graph, whose interval divides
+ * it; returns the number of items in *num_items.
+ */
+static io_graph_item_t *
+sharkd_iograph_derive(const struct sharkd_iograph *graph, guint32 interval, int *num_items)
+{
+    guint32 factor = interval / graph->interval;
+    io_graph_item_t *items;
+    int num;
+
+    num = graph->num_items > 0 ? (int) ((guint32) (graph->num_items - 1) / factor) + 1 : 0;
+    items = g_new(io_graph_item_t, num > 0 ? num : 1);
+    reset_io_graph_items(items, num);
+
+    for (int idx = 0; idx < graph->num_items; idx++)
+        sharkd_iograph_merge_item(&items[(guint32) idx / factor], &graph->items[idx], graph->hf_index, graph->calc_type);
+
+    *num_items = num;
+    return items;
+}
+
 /**
  * sharkd_session_process_iograph()
  *
@@ -3637,10 +4463,16 @@ sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const vo
  *   (o) graph1...graph9    - Other graph requests
  *   (o) filter0            - First graph filter
  *   (o) filter1...filter9  - Other graph filters
+ *   (o) background         - true to answer other requests while this one is being handled,
+ *                            see sharkd_session_process_background()
  *
  * Graph requests can be one of: "packets", "bytes", "bits", "sum:<field>", "frames:<field>", "max:<field>", "min:<field>", "avg:<field>", "load:<field>",
  * if you use variant with <field>, you need to pass field name in filter request.
  *
+ * The items of each graph are kept, usually at a finer interval than was
+ * asked for, so a later request for the same graph and filter, with an
+ * interval that's a multiple of the one kept, doesn't go through the file.
+ *
  * Output object with attributes:
  *   (m) iograph - array of graph results with attributes:
  *                  errmsg - graph cannot be constructed
@@ -3650,8 +4482,9 @@ static void
 sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
 {
     const char *tok_interval = json_find_attr(buf, tokens, count, "interval");
-    struct sharkd_iograph graphs[10];
-    gboolean is_any_ok = FALSE;
+    struct sharkd_iograph *graphs[10];
+    gboolean tapped[10];
+    gboolean is_any_tapped = FALSE;
     int graph_count;
 
     guint32 interval_ms = 1000; /* default: one per second */
@@ -3662,12 +4495,14 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
 
     for (i = graph_count = 0; i < (int) G_N_ELEMENTS(graphs); i++)
     {
-        struct sharkd_iograph *graph = &graphs[graph_count];
+        struct sharkd_iograph *graph;
 
         const char *tok_graph;
         const char *tok_filter;
         char tok_format_buf[32];
         const char *field_name;
+        io_graph_item_unit_t calc_type;
+        char *key;
 
         snprintf(tok_format_buf, sizeof(tok_format_buf), "graph%d", i);
         tok_graph = json_find_attr(buf, tokens, count, tok_format_buf);
@@ -3678,33 +4513,48 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         tok_filter = json_find_attr(buf, tokens, count, tok_format_buf);
 
         if (!strcmp(tok_graph, "packets"))
-            graph->calc_type = IOG_ITEM_UNIT_PACKETS;
+            calc_type = IOG_ITEM_UNIT_PACKETS;
         else if (!strcmp(tok_graph, "bytes"))
-            graph->calc_type = IOG_ITEM_UNIT_BYTES;
+            calc_type = IOG_ITEM_UNIT_BYTES;
         else if (!strcmp(tok_graph, "bits"))
-            graph->calc_type = IOG_ITEM_UNIT_BITS;
+            calc_type = IOG_ITEM_UNIT_BITS;
         else if (g_str_has_prefix(tok_graph, "sum:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_SUM;
+            calc_type = IOG_ITEM_UNIT_CALC_SUM;
         else if (g_str_has_prefix(tok_graph, "frames:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_FRAMES;
+            calc_type = IOG_ITEM_UNIT_CALC_FRAMES;
         else if (g_str_has_prefix(tok_graph, "fields:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_FIELDS;
+            calc_type = IOG_ITEM_UNIT_CALC_FIELDS;
         else if (g_str_has_prefix(tok_graph, "max:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_MAX;
+            calc_type = IOG_ITEM_UNIT_CALC_MAX;
         else if (g_str_has_prefix(tok_graph, "min:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_MIN;
+            calc_type = IOG_ITEM_UNIT_CALC_MIN;
         else if (g_str_has_prefix(tok_graph, "avg:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_AVERAGE;
+            calc_type = IOG_ITEM_UNIT_CALC_AVERAGE;
         else if (g_str_has_prefix(tok_graph, "load:"))
-            graph->calc_type = IOG_ITEM_UNIT_CALC_LOAD;
+            calc_type = IOG_ITEM_UNIT_CALC_LOAD;
         else
             break;
 
+        key = g_strdup_printf("%s\n%s", tok_filter ? tok_filter : "", tok_graph);
+        graph = sharkd_iograph_cache_lookup(key, interval_ms);
+        if (graph)
+        {
+            g_free(key);
+            graphs[graph_count] = graph;
+            tapped[graph_count] = FALSE;
+            graph_count++;
+            continue;
+        }
+
         field_name = strchr(tok_graph, ':');
         if (field_name)
             field_name = field_name + 1;
 
-        graph->interval = interval_ms;
+        graph = g_new0(struct sharkd_iograph, 1);
+        graph->key = key;
+        graph->filter = g_strdup(tok_filter);
+        graph->calc_type = calc_type;
+        graph->interval = sharkd_iograph_base_interval(interval_ms, calc_type);
 
         graph->hf_index = -1;
         graph->error = check_field_unit(field_name, &graph->hf_index, graph->calc_type);
@@ -3716,8 +4566,6 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         if (!graph->error)
             graph->error = register_tap_listener("frame", graph, tok_filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
 
-        graph_count++;
-
         if (graph->error)
         {
             sharkd_json_error(
@@ -3725,61 +4573,77 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
                     "%s", graph->error->str
                     );
             g_string_free(graph->error, TRUE);
+            sharkd_iograph_free(graph);
+            for (i = 0; i < graph_count; i++)
+            {
+                if (tapped[i])
+                {
+                    remove_tap_listener(graphs[i]);
+                    sharkd_iograph_free(graphs[i]);
+                }
+            }
             return;
         }
 
-        if (graph->error == NULL)
-            is_any_ok = TRUE;
+        graphs[graph_count] = graph;
+        tapped[graph_count] = TRUE;
+        graph_count++;
+        is_any_tapped = TRUE;
     }
 
-    /* retap only if we have at least one ok */
-    if (is_any_ok)
+    /* retap only if there's a graph we don't already have the items of */
+    if (is_any_tapped)
         sharkd_retap();
 
+    for (i = 0; i < graph_count; i++)
+    {
+        if (tapped[i])
+        {
+            remove_tap_listener(graphs[i]);
+            sharkd_iograph_cache_add(graphs[i]);
+        }
+    }
+
     sharkd_json_result_prologue(rpcid);
 
     sharkd_json_array_open("iograph");
     for (i = 0; i < graph_count; i++)
     {
-        struct sharkd_iograph *graph = &graphs[i];
+        struct sharkd_iograph *graph = graphs[i];
+        io_graph_item_t *items = graph->items;
+        int num_items = graph->num_items;
+        int idx;
+        int next_idx = 0;
+
+        if (graph->interval != interval_ms)
+            items = sharkd_iograph_derive(graph, interval_ms, &num_items);
 
         json_dumper_begin_object(&dumper);
 
-        if (graph->error)
+        sharkd_json_array_open("items");
+        for (idx = 0; idx < num_items; idx++)
         {
-            fprintf(stderr, "SNAP 6002 - we should never get to here.\n");
-            g_string_free(graph->error, TRUE);
-            exit(-1);
-        }
-        else
-        {
-            int idx;
-            int next_idx = 0;
+            double val;
 
-            sharkd_json_array_open("items");
-            for (idx = 0; idx < graph->num_items; idx++)
-            {
-                double val;
-
-                val = get_io_graph_item(graph->items, graph->calc_type, idx, graph->hf_index, &cfile, graph->interval, graph->num_items);
+            val = get_io_graph_item(items, graph->calc_type, idx, graph->hf_index, &cfile, interval_ms, num_items);
 
-                /* if it's zero, don't display */
-                if (val == 0.0)
-                    continue;
+            /* if it's zero, don't display */
+            if (val == 0.0)
+                continue;
 
-                /* cause zeros are not printed, need to output index */
-                if (next_idx != idx)
-                    sharkd_json_value_stringf(NULL, "%x", idx);
+            /* cause zeros are not printed, need to output index */
+            if (next_idx != idx)
+                sharkd_json_value_stringf(NULL, "%x", idx);
 
-                sharkd_json_value_anyf(NULL, "%f", val);
-                next_idx = idx + 1;
-            }
-            sharkd_json_array_close();
+            sharkd_json_value_anyf(NULL, "%f", val);
+            next_idx = idx + 1;
         }
+        sharkd_json_array_close();
+
         json_dumper_end_object(&dumper);
 
-        remove_tap_listener(graph);
-        g_free(graph->items);
+        if (items != graph->items)
+            g_free(items);
     }
     sharkd_json_array_close();
 
@@ -3813,7 +4677,7 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
     const char *tok_interval = json_find_attr(buf, tokens, count, "interval");
     const char *tok_filter = json_find_attr(buf, tokens, count, "filter");
 
-    const guint8 *filter_data = NULL;
+    const sharkd_bitmap *filter_data = NULL;
 
     struct
     {
@@ -3844,7 +4708,7 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
                     );
             return;
         }
-        filter_data = filter_item->filtered;
+        filter_data = filter_item->passed;
     }
 
     st_total.frames = 0;
@@ -3866,7 +4730,7 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
         gint64 msec_rel;
         gint64 new_idx;
 
-        if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
+        if (filter_data && !sharkd_bitmap_test(filter_data, framenum))
             continue;
 
         fdata = sharkd_get_frame(framenum);
@@ -4340,6 +5204,8 @@ sharkd_session_process_setcomment(char *buf, const jsmntok_t *tokens, int count)
     else
     {
         sharkd_set_modified_block(fdata, pkt_block);
+        /* A column might show the comment. */
+        g_hash_table_remove_all(column_table);
         sharkd_json_simple_ok(rpcid);
     }
 }
@@ -4391,6 +5257,8 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
     switch (ret)
     {
         case PREFS_SET_OK:
+            /* Dissecting frames again might give different results now. */
+            sharkd_session_forget_results();
             sharkd_json_simple_ok(rpcid);
             break;
 
@@ -4953,6 +5821,583 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
     }
 }
 
+#ifndef _WIN32
+/* How often we look for frames written to a file we're following, in ms. */
+#define SHARKD_TAIL_INTERVAL 1000
+
+/*
+ * Read the frames written to the file we're following since we last
+ * looked, bring the results we've kept up to date with them, rather than
+ * working them out again from the first frame, and tell the client.
+ */
+static void
+sharkd_session_continue_tail(void)
+{
+    guint32 first_frame = cfile.count + 1;
+    GHashTableIter iter;
+    gpointer key, value;
+    gboolean iograph_ok = TRUE;
+    guint i;
+
+    if (sharkd_continue_tail() != 0 || cfile.count < first_frame)
+        return;
+
+    g_hash_table_iter_init(&iter, filter_table);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        struct sharkd_filter_item *l = (struct sharkd_filter_item *) value;
+
+        if (l->passed == NULL)
+            continue;
+        sharkd_filter_extend((const char *) key, l->passed);
+        filter_cache_size -= l->size;
+        l->size = sharkd_bitmap_size(l->passed);
+        filter_cache_size += l->size;
+    }
+
+    for (i = 0; i < iograph_cache->len; i++)
+    {
+        struct sharkd_iograph *graph = (struct sharkd_iograph *) g_ptr_array_index(iograph_cache, i);
+        GString *error;
+
+        error = register_tap_listener("frame", graph, graph->filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
+        if (error)
+        {
+            g_string_free(error, TRUE);
+            iograph_ok = FALSE;
+            break;
+        }
+    }
+    if (iograph_ok && iograph_cache->len != 0)
+        sharkd_retap_from(first_frame);
+    while (i-- > 0)
+        remove_tap_listener(g_ptr_array_index(iograph_cache, i));
+    if (!iograph_ok)
+        g_ptr_array_set_size(iograph_cache, 0);
+
+    json_dumper_begin_object(&dumper);
+    sharkd_json_value_string("jsonrpc", "2.0");
+    sharkd_json_value_string("method", "tail");
+    sharkd_json_value_anyf("params", NULL);
+    json_dumper_begin_object(&dumper);
+    sharkd_json_value_anyf("frames", "%u", cfile.count);
+    sharkd_json_value_anyf("duration", "%.9f", nstime_to_sec(&cfile.elapsed_time));
+    json_dumper_end_object(&dumper);
+    json_dumper_end_object(&dumper);
+    sharkd_json_response_close();
+}
+
+/* When we next look for more frames, in g_get_monotonic_time() time. */
+static gint64 tail_due = 0;
+
+/* How long poll() should wait before we look for more frames, in ms. */
+static int
+sharkd_session_tail_timeout(void)
+{
+    gint64 now = g_get_monotonic_time();
+
+    if (tail_due <= now)
+        return 0;
+    return (int) ((tail_due - now + 999) / 1000);
+}
+
+/**
+ * sharkd_session_process_background()
+ *
+ * Handle a request in a child process, so that we can answer other
+ * requests meanwhile; the response is passed on when the child has
+ * finished, which may be after the responses to later requests.
+ *
+ * epan isn't thread-safe, so rather than using a thread, we fork; the
+ * child dissects its own copy of everything, and whatever it changes
+ * goes away with it.
+ *
+ * Returns FALSE if the request couldn't be handed to a child process.
+ */
+static gboolean
+sharkd_session_process_background(void (*process)(char *, const jsmntok_t *, int),
+                                  char *buf, const jsmntok_t *tokens, int count)
+{
+    struct sharkd_job *job;
+    int fds[2];
+    pid_t pid;
+
+    if (pipe(fds) == -1)
+        return FALSE;
+
+    fflush(dumper.output_file);
+    fflush(stdout);
+    pid = fork();
+    if (pid == -1)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return FALSE;
+    }
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+        dumper.output_file = fdopen(fds[1], "w");
+        if (dumper.output_file == NULL || sharkd_reopen_cap_file() != 0)
+            _exit(1);
+#ifdef SHARKD_HAVE_FRAMES
+        /* The response goes to our parent already split into frames. */
+        if (framed_output != NULL)
+        {
+            framed_output = dumper.output_file;
+            dumper.output_file = sharkd_framed_open(framed_output);
+            if (dumper.output_file == NULL)
+                _exit(1);
+        }
+#endif
+        process(buf, tokens, count);
+        fflush(dumper.output_file);
+        _exit(0);
+    }
+
+    close(fds[1]);
+
+    job = g_new(struct sharkd_job, 1);
+    job->id = rpcid;
+    job->pid = pid;
+    job->fd = fds[0];
+    job->response = g_string_new(NULL);
+    g_ptr_array_add(jobs, job);
+    return TRUE;
+}
+
+static void
+sharkd_job_free(struct sharkd_job *job)
+{
+    close(job->fd);
+    g_string_free(job->response, TRUE);
+    g_free(job);
+}
+
+/*
+ * The child handling a request has closed its end of the pipe; pass on
+ * its response.
+ */
+static void
+sharkd_job_finish(struct sharkd_job *job)
+{
+    int status;
+    pid_t pid;
+
+    while ((pid = waitpid(job->pid, &status, 0)) == -1 && errno == EINTR)
+        ;
+
+    if (pid != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0 && job->response->len != 0)
+    {
+        fwrite(job->response->str, 1, job->response->len, stdout);
+        fflush(stdout);
+    }
+    else
+    {
+        sharkd_json_error(
+                job->id, -32603, NULL,
+                "The request failed in the background"
+                );
+    }
+
+    g_ptr_array_remove(jobs, job);
+    sharkd_job_free(job);
+}
+
+/*
+ * Wait until there's input on stdin, if want_input is TRUE, or until a
+ * request being handled in the background has finished, and read what
+ * the children handling requests have written meanwhile.  Returns TRUE
+ * if stdin can be read without blocking.
+ */
+static gboolean
+sharkd_jobs_poll(gboolean want_input)
+{
+    struct pollfd *fds;
+    guint nfds = jobs->len + 1;
+    guint i;
+    char chunk[8192];
+    ssize_t n;
+    gboolean input_ready;
+
+    fds = g_new0(struct pollfd, nfds);
+    fds[0].fd = want_input ? STDIN_FILENO : -1;
+    fds[0].events = POLLIN;
+    for (i = 0; i < jobs->len; i++)
+    {
+        fds[i + 1].fd = ((struct sharkd_job *) g_ptr_array_index(jobs, i))->fd;
+        fds[i + 1].events = POLLIN;
+    }
+
+    if (poll(fds, nfds, sharkd_is_tailing() ? sharkd_session_tail_timeout() : -1) == -1)
+    {
+        g_free(fds);
+        return FALSE;
+    }
+
+    /* Go backwards, so finishing a job doesn't move the ones we haven't looked at. */
+    for (i = nfds - 1; i > 0; i--)
+    {
+        struct sharkd_job *job = (struct sharkd_job *) g_ptr_array_index(jobs, i - 1);
+
+        if (fds[i].revents == 0)
+            continue;
+
+        n = read(job->fd, chunk, sizeof(chunk));
+        if (n > 0)
+            g_string_append_len(job->response, chunk, n);
+        else if (n == 0 || errno != EINTR)
+            sharkd_job_finish(job);
+    }
+
+    input_ready = (fds[0].revents != 0);
+    g_free(fds);
+
+    if (sharkd_is_tailing() && sharkd_session_tail_timeout() == 0)
+    {
+        sharkd_session_continue_tail();
+        tail_due = g_get_monotonic_time() + SHARKD_TAIL_INTERVAL * G_GINT64_CONSTANT(1000);
+    }
+    return input_ready;
+}
+
+/*
+ * Read a request from stdin, which, like fgets(), is a line of at most
+ * size - 1 bytes.  We read stdin ourselves, rather than with fgets(), so
+ * that poll() doesn't miss requests that stdio has already read.
+ */
+static gboolean
+sharkd_session_read_request(char *buf, size_t size)
+{
+    static char input[2 * 1024];
+    static size_t input_len = 0;
+    static gboolean input_eof = FALSE;
+    char *eol;
+    size_t len;
+    ssize_t n;
+
+    ws_assert(size <= sizeof(input) + 1);
+
+    for (;;)
+    {
+        eol = (char *) memchr(input, '\n', input_len);
+        if (eol != NULL || input_len == size - 1 || (input_eof && input_len != 0))
+        {
+            len = (eol != NULL) ? (size_t) (eol - input) + 1 : input_len;
+            memcpy(buf, input, len);
+            buf[len] = '\0';
+            input_len -= len;
+            memmove(input, input + len, input_len);
+            return TRUE;
+        }
+
+        if (input_eof)
+        {
+            /* The client may still be waiting for the rest of the responses. */
+            while (jobs->len != 0)
+                sharkd_jobs_poll(FALSE);
+            return FALSE;
+        }
+
+        if (!sharkd_jobs_poll(TRUE))
+            continue;
+
+        n = read(STDIN_FILENO, input + input_len, size - 1 - input_len);
+        if (n > 0)
+            input_len += (size_t) n;
+        else if (n == 0 || errno != EINTR)
+            input_eof = TRUE;
+    }
+}
+#endif
+
+/**
+ * sharkd_session_process_cancel()
+ *
+ * Process cancel request
+ *
+ * Input:
+ *   (m) id - id of a request that's being handled in the background
+ *
+ * The cancelled request is answered with error -14002.
+ *
+ * Output object with attributes:
+ *   (m) status - "OK"
+ */
+static void
+sharkd_session_process_cancel(char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_id = json_find_attr(buf, tokens, count, "id");
+    guint32 id;
+
+    ws_strtou32(tok_id, NULL, &id);  // we have already validated this
+
+#ifndef _WIN32
+    for (guint i = 0; i < jobs->len; i++)
+    {
+        struct sharkd_job *job = (struct sharkd_job *) g_ptr_array_index(jobs, i);
+
+        if (job->id != id)
+            continue;
+
+        kill(job->pid, SIGKILL);
+        while (waitpid(job->pid, NULL, 0) == -1 && errno == EINTR)
+            ;
+        g_ptr_array_remove_index(jobs, i);
+        sharkd_job_free(job);
+
+        sharkd_json_error(
+                id, -14002, NULL,
+                "The request was cancelled"
+                );
+        sharkd_json_simple_ok(rpcid);
+        return;
+    }
+#endif
+
+    sharkd_json_error(
+            rpcid, -14001, NULL,
+            "No request with id %u is being handled in the background", id
+            );
+}
+
+/**
+ * sharkd_session_process_encoding()
+ *
+ * Process encoding request
+ *
+ * Input:
+ *   (m) encoding - "json", which is what sharkd starts with, or "cbor"
+ *
+ * With "cbor", each response is a CBOR (RFC 8949) item rather than a line
+ * of JSON, sent as frames that each start with their length as a 4-byte
+ * big-endian number; a frame of length 0 ends the response.  Large
+ * responses are sent a frame at a time, as they're built.  Requests are
+ * lines of JSON with either encoding.
+ *
+ * The response to this request is in the encoding used before it.
+ *
+ * Output object with attributes:
+ *   (m) status - "OK"
+ */
+static void
+sharkd_session_process_encoding(char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_encoding = json_find_attr(buf, tokens, count, "encoding");
+
+    if (!strcmp(tok_encoding, "json"))
+    {
+        sharkd_json_simple_ok(rpcid);
+#ifdef SHARKD_HAVE_FRAMES
+        if (framed_output != NULL)
+        {
+            fclose(dumper.output_file);
+            dumper.output_file = framed_output;
+            framed_output = NULL;
+        }
+#endif
+        dumper.flags &= ~JSON_DUMPER_FLAGS_CBOR;
+    }
+    else if (!strcmp(tok_encoding, "cbor"))
+    {
+#ifdef SHARKD_HAVE_FRAMES
+        FILE *fh = framed_output != NULL ? dumper.output_file : sharkd_framed_open(dumper.output_file);
+
+        if (fh == NULL)
+        {
+            sharkd_json_error(
+                    rpcid, -15002, NULL,
+                    "Unable to set up framed output: %s", g_strerror(errno)
+                    );
+            return;
+        }
+        sharkd_json_simple_ok(rpcid);
+        if (framed_output == NULL)
+        {
+            framed_output = dumper.output_file;
+            dumper.output_file = fh;
+        }
+        dumper.flags |= JSON_DUMPER_FLAGS_CBOR;
+#else
+        sharkd_json_error(
+                rpcid, -15002, NULL,
+                "The cbor encoding isn't supported on this platform"
+                );
+#endif
+    }
+    else
+    {
+        sharkd_json_error(
+                rpcid, -15001, NULL,
+                "Unknown encoding \"%s\"", tok_encoding
+                );
+    }
+}
+
+/*
+ * Handle a tap or iograph request, in the background if it asks to be.
+ * Where we can't fork, it's handled as usual.
+ */
+static void
+sharkd_session_process_maybe_background(void (*process)(char *, const jsmntok_t *, int),
+                                        char *buf, const jsmntok_t *tokens, int count)
+{
+#ifndef _WIN32
+    const char *tok_background = json_find_attr(buf, tokens, count, "background");
+
+    if (tok_background != NULL && !strcmp(tok_background, "true") &&
+        sharkd_session_process_background(process, buf, tokens, count))
+        return;
+#endif
+    process(buf, tokens, count);
+}
+
+/**
+ * sharkd_session_process_metrics()
+ *
+ * Process metrics request
+ *
+ * Input:
+ *   (o) slow - log requests that take longer than this many ms to stderr, with the time
+ *              they spent dissecting and filtering frames; 0 to stop logging them
+ *
+ * Output object with attributes:
+ *   (m) methods - array of the methods requested so far in this session, with attributes:
+ *                  (m) method   - method name
+ *                  (m) requests - number of requests
+ *                  (m) time     - time spent on them, in seconds
+ *                  (m) dissect  - part of time spent dissecting frames
+ *                  (m) filter   - part of time spent filtering frames; the rest is mostly
+ *                                 building and writing the responses
+ *                  (m) max      - longest time spent on one request
+ *                  (m) hist     - numbers of requests that took under 1 ms, under 2 ms, under 4 ms,
+ *                                 ..., under 16384 ms, and longer
+ *   (m) slow    - requests that take longer than this many ms are logged, if it isn't 0
+ */
+static void
+sharkd_session_process_metrics(char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_slow = json_find_attr(buf, tokens, count, "slow");
+    GList *methods, *l;
+
+    if (tok_slow)
+        ws_strtou32(tok_slow, NULL, &slow_request_ms);
+
+    sharkd_json_result_prologue(rpcid);
+
+    sharkd_json_array_open("methods");
+    methods = g_list_sort(g_hash_table_get_keys(metrics_table), (GCompareFunc) strcmp);
+    for (l = methods; l; l = l->next)
+    {
+        const char *method = (const char *) l->data;
+        const struct sharkd_method_metrics *m = (const struct sharkd_method_metrics *) g_hash_table_lookup(metrics_table, method);
+
+        json_dumper_begin_object(&dumper);
+        sharkd_json_value_string("method", method);
+        sharkd_json_value_anyf("requests", "%" PRIu64, m->requests);
+        sharkd_json_value_anyf("time", "%.6f", m->total_time / 1000000.0);
+        sharkd_json_value_anyf("dissect", "%.6f", m->dissect_time / 1000000.0);
+        sharkd_json_value_anyf("filter", "%.6f", m->filter_time / 1000000.0);
+        sharkd_json_value_anyf("max", "%.6f", m->max_time / 1000000.0);
+        sharkd_json_array_open("hist");
+        for (int i = 0; i < SHARKD_METRICS_BUCKETS; i++)
+            sharkd_json_value_anyf(NULL, "%" PRIu64, m->buckets[i]);
+        sharkd_json_array_close();
+        json_dumper_end_object(&dumper);
+    }
+    g_list_free(methods);
+    sharkd_json_array_close();
+
+    sharkd_json_value_anyf("slow", "%u", slow_request_ms);
+
+    sharkd_json_result_epilogue();
+}
+
+/**
+ * sharkd_session_process_perfstats()
+ *
+ * Process perfstats request
+ *
+ * Input:
+ *   (o) reset - if true, start the counters over after getting them
+ *
+ * Output object with attributes:
+ *   (m) stats - array of the process's performance counters, rates and gauges, with attributes:
+ *                  (m) name        - short name, e.g. "wiretap.bytes_read"
+ *                  (m) description - what it is
+ *                  (m) unit        - "count", "bytes", "ns" or "per_sec"
+ *                  (m) value       - the value
+ */
+static void
+sharkd_session_process_perfstats(char *buf, const jsmntok_t *tokens, int count)
+{
+    static const char *unit_names[] = { "count", "bytes", "ns", "per_sec" };
+    const char *tok_reset = json_find_attr(buf, tokens, count, "reset");
+    GArray *stats;
+    guint i;
+
+    stats = ws_perf_get_stats();
+    if (tok_reset != NULL && !strcmp(tok_reset, "true"))
+        ws_perf_reset();
+
+    sharkd_json_result_prologue(rpcid);
+
+    sharkd_json_array_open("stats");
+    for (i = 0; i < stats->len; i++)
+    {
+        const ws_perf_stat_t *stat = &g_array_index(stats, ws_perf_stat_t, i);
+
+        json_dumper_begin_object(&dumper);
+        sharkd_json_value_string("name", stat->name);
+        sharkd_json_value_string("description", stat->description);
+        sharkd_json_value_string("unit", unit_names[stat->unit]);
+        sharkd_json_value_anyf("value", "%" PRIu64, stat->value);
+        json_dumper_end_object(&dumper);
+    }
+    sharkd_json_array_close();
+
+    sharkd_json_result_epilogue();
+    g_array_free(stats, TRUE);
+}
+
+/*
+ * Count a request, and log it if it was slow.  dissect_time and
+ * filter_time are the parts of time it spent dissecting and filtering
+ * frames.
+ */
+static void
+sharkd_session_metrics_add(const char *method, const char *filter, gint64 time, gint64 dissect_time, gint64 filter_time)
+{
+    struct sharkd_method_metrics *m;
+    int bucket = 0;
+
+    m = (struct sharkd_method_metrics *) g_hash_table_lookup(metrics_table, method);
+    if (m == NULL)
+    {
+        m = g_new0(struct sharkd_method_metrics, 1);
+        g_hash_table_insert(metrics_table, g_strdup(method), m);
+    }
+
+    m->requests++;
+    m->total_time += time;
+    m->dissect_time += dissect_time;
+    m->filter_time += filter_time;
+    if (time > m->max_time)
+        m->max_time = time;
+
+    while (bucket < SHARKD_METRICS_BUCKETS - 1 && time >= (G_GINT64_CONSTANT(1000) << bucket))
+        bucket++;
+    m->buckets[bucket]++;
+
+    if (slow_request_ms != 0 && time > (gint64) slow_request_ms * 1000)
+    {
+        fprintf(stderr, "slow request: method=%s%s%s time=%.3fms dissect=%.3fms filter=%.3fms\n",
+                method, filter ? " filter=" : "", filter ? filter : "",
+                time / 1000.0, dissect_time / 1000.0, filter_time / 1000.0);
+    }
+}
+
 static void
 sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 {
@@ -4963,6 +6408,7 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
         count--;
 
         const char* tok_method = json_find_attr(buf, tokens, count, "method");
+        gint64 start_time, start_dissect, start_filter, end_dissect, end_filter;
 
         if (!tok_method) {
             sharkd_json_error(
@@ -4970,6 +6416,10 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
                     "No method found");
             return;
         }
+
+        start_time = g_get_monotonic_time();
+        sharkd_get_times(&start_dissect, &start_filter);
+
         if (!strcmp(tok_method, "load"))
             sharkd_session_process_load(buf, tokens, count);
         else if (!strcmp(tok_method, "status"))
@@ -4985,11 +6435,11 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
         else if (!strcmp(tok_method, "frames"))
             sharkd_session_process_frames(buf, tokens, count);
         else if (!strcmp(tok_method, "tap"))
-            sharkd_session_process_tap(buf, tokens, count);
+            sharkd_session_process_maybe_background(sharkd_session_process_tap, buf, tokens, count);
         else if (!strcmp(tok_method, "follow"))
             sharkd_session_process_follow(buf, tokens, count);
         else if (!strcmp(tok_method, "iograph"))
-            sharkd_session_process_iograph(buf, tokens, count);
+            sharkd_session_process_maybe_background(sharkd_session_process_iograph, buf, tokens, count);
         else if (!strcmp(tok_method, "intervals"))
             sharkd_session_process_intervals(buf, tokens, count);
         else if (!strcmp(tok_method, "frame"))
@@ -5002,6 +6452,14 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
             sharkd_session_process_dumpconf(buf, tokens, count);
         else if (!strcmp(tok_method, "download"))
             sharkd_session_process_download(buf, tokens, count);
+        else if (!strcmp(tok_method, "cancel"))
+            sharkd_session_process_cancel(buf, tokens, count);
+        else if (!strcmp(tok_method, "encoding"))
+            sharkd_session_process_encoding(buf, tokens, count);
+        else if (!strcmp(tok_method, "metrics"))
+            sharkd_session_process_metrics(buf, tokens, count);
+        else if (!strcmp(tok_method, "perfstats"))
+            sharkd_session_process_perfstats(buf, tokens, count);
         else if (!strcmp(tok_method, "bye"))
         {
             sharkd_json_simple_ok(rpcid);
@@ -5014,15 +6472,24 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
                     "The method \"%s\" is unknown", tok_method
                     );
         }
+
+        sharkd_get_times(&end_dissect, &end_filter);
+        sharkd_session_metrics_add(tok_method, json_find_attr(buf, tokens, count, "filter"),
+                g_get_monotonic_time() - start_time,
+                end_dissect - start_dissect, end_filter - start_filter);
     }
 }
 
-int
-sharkd_session_main(int mode_setting)
+/*
+ * Get a session ready to handle requests.  The daemon's pool of workers
+ * does this before they're handed a connection, so that the client
+ * doesn't wait for it; otherwise sharkd_session_main() does it.
+ */
+void
+sharkd_session_init(int mode_setting)
 {
-    char buf[2 * 1024];
-    jsmntok_t *tokens = NULL;
-    int tokens_max = -1;
+    if (filter_table != NULL)
+        return;
 
     mode = mode_setting;
 
@@ -5031,13 +6498,34 @@ sharkd_session_main(int mode_setting)
     dumper.output_file = stdout;
 
     filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+    column_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, sharkd_column_item_free);
+    iograph_cache = g_ptr_array_new_with_free_func(sharkd_iograph_free);
+    stream_index_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_stream_index_free);
+    metrics_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+#ifndef _WIN32
+    jobs = g_ptr_array_new();
+#endif
 
 #ifdef HAVE_MAXMINDDB
     /* mmdbresolve was stopped before fork(), force starting it */
     uat_get_table_by_name("MaxMind Database Paths")->post_update_cb();
 #endif
+}
+
+int
+sharkd_session_main(int mode_setting)
+{
+    char buf[2 * 1024];
+    jsmntok_t *tokens = NULL;
+    int tokens_max = -1;
+
+    sharkd_session_init(mode_setting);
 
+#ifndef _WIN32
+    while (sharkd_session_read_request(buf, sizeof(buf)))
+#else
     while (fgets(buf, sizeof(buf), stdin))
+#endif
     {
         /* every command is line seperated JSON */
         int ret;
@@ -5079,6 +6567,12 @@ sharkd_session_main(int mode_setting)
     }
 
     g_hash_table_destroy(filter_table);
+    g_hash_table_destroy(column_table);
+    g_hash_table_destroy(stream_index_table);
+    g_free(column_cache_columns);
+#ifndef _WIN32
+    g_ptr_array_free(jobs, TRUE);
+#endif
     g_free(tokens);
 
     return 0;
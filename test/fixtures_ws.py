@@ -101,6 +101,11 @@ def cmd_capinfos(program):
     return program('capinfos')
 
 
+@fixtures.fixture(scope='session')
+def cmd_captype(program):
+    return program('captype')
+
+
 @fixtures.fixture(scope='session')
 def cmd_dumpcap(program):
     return program('dumpcap')
@@ -111,6 +116,11 @@ def cmd_mergecap(program):
     return program('mergecap')
 
 
+@fixtures.fixture(scope='session')
+def cmd_reordercap(program):
+    return program('reordercap')
+
+
 @fixtures.fixture(scope='session')
 def cmd_rawshark(program):
     return program('rawshark')
@@ -182,6 +192,7 @@ def features(cmd_tshark, make_env):
         have_gnutls='with GnuTLS' in tshark_v,
         have_pkcs11='and PKCS #11 support' in tshark_v,
         have_brotli='with brotli' in tshark_v,
+        have_zstd='with Zstandard' in tshark_v,
         have_plugins='binary plugins supported' in tshark_v,
     )
 
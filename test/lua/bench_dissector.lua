@@ -0,0 +1,78 @@
+----------------------------------------
+-- A postdissector that does what Lua dissectors typically do a lot of,
+-- making TvbRanges, adding items and calling Field extractors, so that
+-- the time Lua takes per packet can be compared between builds.
+-- use with dhcp.pcap in test/captures directory
+--
+-- The first argument, if given, is the number of times to go over each
+-- packet (default 100).
+
+local packet_count = 0
+
+local function testing(...)
+    print("---- Testing "..tostring(...).." ----")
+end
+
+local function test(name, result)
+    io.stdout:write("test "..name.."-"..packet_count.."...")
+    if result == true then
+        io.stdout:write("passed\n")
+    else
+        io.stdout:write("failed!\n")
+        error(name.." test failed!")
+    end
+end
+
+local arg = {...}
+local iterations = tonumber(arg[1]) or 100
+
+local f_eth_src = Field.new("eth.src")
+local f_ip_src = Field.new("ip.src")
+local f_udp_srcport = Field.new("udp.srcport")
+local f_dhcp_option_type = Field.new("dhcp.option.type")
+
+local bench_p = Proto("luabench", "Lua dissection benchmark")
+local pf_byte = ProtoField.uint8("luabench.byte", "Byte", base.HEX)
+local pf_word = ProtoField.uint16("luabench.word", "Word", base.HEX)
+bench_p.fields = { pf_byte, pf_word }
+
+local total_time = 0
+
+testing("Lua dissection benchmark, "..iterations.." iterations per packet")
+
+function bench_p.dissector(tvb, pinfo, tree)
+    packet_count = packet_count + 1
+
+    local start = os.clock()
+    local len = tvb:len()
+    local sum = 0
+    for _ = 1, iterations do
+        local subtree = tree:add(bench_p, tvb())
+        for offset = 0, len - 2, 2 do
+            local range = tvb(offset, 2)
+            sum = sum + range:uint()
+            subtree:add(pf_word, range)
+            subtree:add(pf_byte, tvb(offset, 1))
+        end
+        for _, field in ipairs({ f_eth_src, f_ip_src, f_udp_srcport }) do
+            local fi = field()
+            if fi then sum = sum + fi.len end
+        end
+        sum = sum + select("#", f_dhcp_option_type())
+    end
+    total_time = total_time + (os.clock() - start)
+
+    test("sum", sum > 0)
+    -- Extractors return the same FieldInfo for a field within a packet.
+    test("FieldInfo.same-1", rawequal(f_eth_src(), f_eth_src()))
+    test("FieldInfo.same-2", tostring(f_ip_src()) == tostring(f_ip_src()))
+
+    if packet_count == 4 then
+        print(string.format("%d packets, %d iterations, %.3f ms per packet",
+            packet_count, iterations, total_time * 1000 / packet_count))
+        print("\n-----------------------------\n")
+        print("All tests passed!\n\n")
+    end
+end
+
+register_postdissector(bench_p)
@@ -0,0 +1,115 @@
+----------------------------------------
+-- A file reader that never claims a file, but reads the whole file in its
+-- read_open() the ways Lua file readers do, a line at a time and in blocks
+-- with File:read_into(), checks that they agree, and reports how fast each
+-- is so that they can be compared between builds.
+-- use with dhcp.pcap in test/captures directory (or any other file)
+--
+-- The first argument, if given, is the number of times to read the
+-- file each way (default 100).
+
+local function testing(...)
+    print("---- Testing "..tostring(...).." ----")
+end
+
+local function test(name, result)
+    io.stdout:write("test "..name.."...")
+    if result == true then
+        io.stdout:write("passed\n")
+    else
+        io.stdout:write("failed!\n")
+        error(name.." test failed!")
+    end
+end
+
+local arg = {...}
+local iterations = tonumber(arg[1]) or 100
+
+local done = false
+
+local function report(name, bytes, secs)
+    if secs > 0 then
+        print(string.format("%s: %d bytes in %.3f ms, %.1f MB/s",
+            name, bytes, secs * 1000, bytes / secs / 1000000))
+    else
+        print(string.format("%s: %d bytes", name, bytes))
+    end
+end
+
+local function read_open(file, capture)
+    if done then return false end
+    done = true
+
+    testing("Lua file reading, "..iterations.." iterations")
+
+    file:seek("set", 0)
+    local all = file:read("*a")
+    local size = #all
+    test("read.all", size > 0)
+
+    -- a line at a time
+    local lines, line_bytes
+    local start = os.clock()
+    for _ = 1, iterations do
+        file:seek("set", 0)
+        lines, line_bytes = 0, 0
+        for line in file:lines() do
+            lines = lines + 1
+            line_bytes = line_bytes + #line
+        end
+    end
+    report("lines", size * iterations, os.clock() - start)
+
+    local newlines = select(2, all:gsub("\n", "\n"))
+    local crs = select(2, all:gsub("\r\n", "\r\n"))
+    local expected = newlines + ((all:sub(-1) ~= "\n") and 1 or 0)
+    test("lines.count", lines == expected)
+    test("lines.bytes", line_bytes == size - newlines - crs)
+
+    -- in blocks, into the same ByteArray
+    local block = ByteArray.new()
+    local parts
+    start = os.clock()
+    for _ = 1, iterations do
+        file:seek("set", 0)
+        parts = {}
+        while file:read_into(block) do
+            parts[#parts + 1] = block:raw()
+        end
+    end
+    report("read_into", size * iterations, os.clock() - start)
+    test("read_into.data", table.concat(parts) == all)
+    test("read_into.eof", block:len() == 0)
+
+    -- blocks smaller than the file
+    file:seek("set", 0)
+    parts = {}
+    local counts = {}
+    local n = file:read_into(block, 100)
+    while n do
+        counts[#counts + 1] = n
+        parts[#parts + 1] = block:raw()
+        n = file:read_into(block, 100)
+    end
+    test("read_into.blocks", #counts == math.ceil(size / 100))
+    test("read_into.count", counts[1] == math.min(size, 100))
+    test("read_into.small", table.concat(parts) == all)
+
+    test("read_into.length-1", not pcall(file.read_into, file, block, 0))
+    test("read_into.length-2", not pcall(file.read_into, file, block, -1))
+    test("read_into.bytearray", not pcall(file.read_into, file, "foo"))
+
+    print("\n-----------------------------\n")
+    print("All tests passed!\n\n")
+
+    -- not our file; let the real reader have it
+    return false
+end
+
+local fh = FileHandler.new("Lua file reading benchmark", "lua_bench_file",
+    "A Lua file reader that only times reading files", "rs")
+fh.read_open = read_open
+fh.read = function() return false end
+fh.seek_read = function() return false end
+
+register_filehandler(fh)
@@ -0,0 +1,66 @@
+-- test script for Listener batches
+-- use with dhcp.pcap in test/captures directory
+
+local function testing(...)
+    print("---- Testing "..tostring(...).." ----")
+end
+
+local function test(name, result)
+    io.stdout:write("test "..name.."...")
+    if result == true then
+        io.stdout:write("passed\n")
+    else
+        io.stdout:write("failed!\n")
+        error(name.." test failed!")
+    end
+end
+
+local function makeBatch(tap, ...)
+    tap:set_batch(...)
+end
+
+testing("Listener batches")
+
+local f_frame_number = Field.new("frame.number")
+local f_frame_len = Field.new("frame.len")
+local f_ip_src = Field.new("ip.src")
+local f_dns_id = Field.new("dns.id")
+
+-- dhcp.pcap has 4 packets; batches of 3 make one full batch and one
+-- partial batch, which is handed over before draw().
+local tap = Listener.new("frame")
+test("set_batch-1", pcall(makeBatch, tap, { f_frame_number, f_frame_len, f_ip_src, f_dns_id }, 3))
+test("set_batch-2", not pcall(makeBatch, tap, { "frame.len" }))
+test("set_batch-3", not pcall(makeBatch, tap, { f_frame_len }, 0))
+test("set_batch-4", not pcall(makeBatch, tap))
+
+local packet_calls = 0
+local batches = {}
+local numbers = {}
+local total_len = 0
+
+function tap.packet(pinfo, tvb, tapinfo)
+    packet_calls = packet_calls + 1
+    total_len = total_len - f_frame_len()()
+end
+
+function tap.batch(count, values)
+    batches[#batches + 1] = count
+    for i = 1, count do
+        numbers[#numbers + 1] = values[1][i]
+        total_len = total_len + values[2][i]
+        test("batch.address-"..values[1][i], tostring(values[3][i]) ~= nil)
+        test("batch.missing-"..values[1][i], values[4][i] == nil)
+    end
+end
+
+function tap.draw()
+    test("batch.sizes", #batches == 2 and batches[1] == 3 and batches[2] == 1)
+    test("batch.numbers", table.concat(numbers, ",") == "1,2,3,4")
+    -- packet() is still called when it's set, with the same values.
+    test("batch.packet", packet_calls == 4)
+    test("batch.len", total_len == 0)
+
+    print("\n-----------------------------\n")
+    print("All tests passed!\n\n")
+end
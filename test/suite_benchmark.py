@@ -0,0 +1,113 @@
+#
+# Wireshark tests
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Dissection throughput benchmarks'''
+
+import json
+import os
+import sys
+import subprocesstest
+import fixtures
+
+# Corpora made by randpkt from a fixed seed, so that each run dissects
+# the same packets: (packet type, seed, count).
+randpkt_corpora = (
+    ('dns', 1, 2000),
+    ('tcp', 2, 2000),
+    ('sctp', 3, 2000),
+)
+
+reference_captures = (
+    'dhcp.pcap',
+    'http.pcap',
+    'dns+icmp.pcapng.gz',
+)
+
+benchmark_modes = ('tree', 'fake-tree', 'columns', 'filtered')
+
+# Iterations per file; override with WS_BENCHMARK_ITERATIONS.
+default_iterations = 5
+
+def bench_program(program_path, name):
+    dotexe = '.exe' if sys.platform.startswith('win32') else ''
+    path = os.path.abspath(os.path.join(program_path, name + dotexe))
+    if not os.access(path, os.X_OK):
+        fixtures.skip('Program %s is not available; build the "benchmark" target' % (name,))
+    return path
+
+@fixtures.fixture(scope='session')
+def cmd_benchshark(program_path):
+    return bench_program(program_path, 'benchshark')
+
+@fixtures.fixture(scope='session')
+def cmd_randpkt(program_path):
+    return bench_program(program_path, 'randpkt')
+
+@fixtures.fixture(scope='session')
+def benchmark_results():
+    '''Collects the results of all the tests, and writes them to the file
+    named by WS_BENCHMARK_RESULTS at the end of the session.'''
+    results = []
+    yield results
+    results_file = os.environ.get('WS_BENCHMARK_RESULTS')
+    if results_file and results:
+        with open(results_file, 'w') as results_fd:
+            json.dump(results, results_fd, indent=2)
+            results_fd.write('\n')
+
+@fixtures.fixture
+def run_benchshark(cmd_benchshark, benchmark_results):
+    def run_benchshark_real(self, name, cap_file):
+        iterations = os.environ.get('WS_BENCHMARK_ITERATIONS', str(default_iterations))
+        bench_cmd = [cmd_benchshark, '-n', iterations]
+        for mode in benchmark_modes:
+            bench_cmd += ['-m', mode]
+        bench_cmd.append(cap_file)
+        bench_proc = self.assertRun(bench_cmd)
+        results = [json.loads(line) for line in bench_proc.stdout_str.splitlines() if line]
+        self.assertEqual([r['mode'] for r in results], list(benchmark_modes))
+        for result in results:
+            self.assertGreater(result['packets'], 0)
+            self.assertEqual(result['iterations'], int(iterations))
+            result['file'] = name
+            benchmark_results.append(result)
+        return results
+    return run_benchshark_real
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_benchmark_randpkt(subprocesstest.SubprocessTestCase):
+    def test_benchmark_randpkt(self, cmd_randpkt, run_benchshark):
+        '''Dissection throughput for seeded randpkt corpora'''
+        for pkt_type, seed, count in randpkt_corpora:
+            corpus = self.filename_from_id('randpkt-{}.pcap'.format(pkt_type))
+            self.assertRun((cmd_randpkt,
+                '-s', str(seed),
+                '-c', str(count),
+                '-t', pkt_type,
+                corpus,
+            ))
+            results = run_benchshark(self, 'randpkt-{}-{}'.format(pkt_type, seed), corpus)
+            self.assertEqual(results[0]['packets'], count)
+
+    def test_benchmark_randpkt_reproducible(self, cmd_randpkt):
+        '''randpkt makes the same corpus from the same seed'''
+        corpora = []
+        for run in range(2):
+            corpus = self.filename_from_id('randpkt-seed-{}.pcap'.format(run))
+            self.assertRun((cmd_randpkt, '-s', '42', '-c', '100', '-t', 'dns', corpus))
+            with open(corpus, 'rb') as corpus_fd:
+                corpora.append(corpus_fd.read())
+        self.assertEqual(corpora[0], corpora[1])
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_benchmark_captures(subprocesstest.SubprocessTestCase):
+    def test_benchmark_captures(self, capture_file, run_benchshark):
+        '''Dissection throughput for reference captures'''
+        for cap_name in reference_captures:
+            run_benchshark(self, cap_name, capture_file(cap_name))
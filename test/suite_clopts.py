@@ -288,6 +288,51 @@ class case_tshark_z_expert(subprocesstest.SubprocessTestCase):
         self.assertFalse(self.grepOutput('Chats'))
 
 
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_tshark_dissector_profile(subprocesstest.SubprocessTestCase):
+    def test_tshark_dissector_profile(self, cmd_tshark, capture_file):
+        self.assertRun((cmd_tshark, '-q', '--dissector-profile',
+            '-r', capture_file('dhcp.pcap')))
+        self.assertTrue(self.grepOutput('Dissector profile'))
+        # All four packets get to the DHCP dissector, and it takes them all.
+        self.assertTrue(self.grepOutput(r'^dhcp +4 +4 '))
+        self.assertTrue(self.grepOutput(r'^udp +4 +4 '))
+
+    def test_tshark_no_dissector_profile(self, cmd_tshark, capture_file):
+        self.assertRun((cmd_tshark, '-q', '-r', capture_file('dhcp.pcap')))
+        self.assertFalse(self.grepOutput('Dissector profile'))
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_tshark_prefilter(subprocesstest.SubprocessTestCase):
+    def runPrefilter(self, cmd_tshark, capture_file, dfilter):
+        self.assertRun((cmd_tshark, '--prefilter', '-Y', dfilter,
+            '-T', 'fields', '-e', 'frame.number',
+            '-r', capture_file('dhcp.pcap')))
+        return self.countOutput(r'^\d+$')
+
+    def test_tshark_prefilter_match(self, cmd_tshark, capture_file):
+        # The DHCP magic cookie is in all four packets.
+        self.assertEqual(self.runPrefilter(cmd_tshark, capture_file,
+            'frame contains 63:82:53:63 && udp'), 4)
+
+    def test_tshark_prefilter_no_match(self, cmd_tshark, capture_file):
+        self.assertEqual(self.runPrefilter(cmd_tshark, capture_file,
+            'frame contains "no such string" && udp'), 0)
+
+    def test_tshark_prefilter_or(self, cmd_tshark, capture_file):
+        # The right-hand side can't be checked without dissecting.
+        self.assertEqual(self.runPrefilter(cmd_tshark, capture_file,
+            'frame contains "no such string" || udp'), 4)
+
+    def test_tshark_prefilter_two_pass(self, cmd_tshark, capture_file):
+        self.assertRun((cmd_tshark, '-2', '--prefilter', '-Y', 'udp',
+            '-r', capture_file('dhcp.pcap')),
+            expected_return=self.exit_command_line)
+
+
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
 class case_tshark_extcap(subprocesstest.SubprocessTestCase):
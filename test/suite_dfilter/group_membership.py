@@ -92,3 +92,23 @@ class case_membership(unittest.TestCase):
     def test_membership_12_value_string(self, checkDFilterCount):
         dfilter = 'tcp.checksum.status in {"Unverified", "Good"}'
         checkDFilterCount(dfilter, 1)
+
+    def test_membership_13_int_set(self, checkDFilterCount):
+        dfilter = 'tcp.port in {21, 22, 23, 80, 443, 8080}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_14_int_set_no_match(self, checkDFilterCount):
+        dfilter = 'tcp.port in {21, 22, 23, 443, 8080, 22}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_15_int_set_and_range(self, checkDFilterCount):
+        dfilter = 'tcp.port in {21, 22, 3000 .. 3300, 443}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_16_int_set_and_range_no_match(self, checkDFilterCount):
+        dfilter = 'tcp.dstport in {1, 2, 3, 82 .. 65535}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_17_int_set_signed(self, checkDFilterCount):
+        dfilter = 'tcp.window_size_scalefactor in {-2, -1, 5}'
+        checkDFilterCount(dfilter, 1)
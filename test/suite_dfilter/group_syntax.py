@@ -271,6 +271,11 @@ class case_arithmetic(unittest.TestCase):
         dfilter = "udp.length == ip.len - 20"
         checkDFilterCount(dfilter, 4)
 
+    def test_div_zero_const(self, checkDFilterCount):
+        # Not folded in when compiled; fails to match when run.
+        dfilter = "udp.dstport == 67 / 0"
+        checkDFilterCount(dfilter, 0)
+
     def test_expr_1(self, checkDFilterCount):
         dfilter = 'udp.port * { 10 / {5 - 4} } == udp.port * { {50 + 50} / 2 - 40 }'
         checkDFilterCount(dfilter, 4)
@@ -357,3 +362,18 @@ class case_raw_modifier(unittest.TestCase):
         dfilter = '@s7comm.blockinfo.blocktype == ${@s7comm.blockinfo.blocktype}'
         # select frame 3, expect 2 frames out of 3.
         checkDFilterCountWithSelectedFrame(dfilter, 2, 3)
+
+@fixtures.uses_fixtures
+class case_profile(unittest.TestCase):
+    trace_file = "ipoipoip.pcap"
+
+    def test_profile_1(self, cmd_dftest, capture_file, base_env):
+        dfilter = 'ip.addr == 1.1.1.1'
+        output = subprocess.check_output((cmd_dftest, '-r', capture_file(self.trace_file), dfilter),
+                                         universal_newlines=True,
+                                         env=base_env)
+        assert 'Runs: 2, matched: 1' in output, output
+        read_lines = [line for line in output.splitlines() if ' READ_TREE ' in line]
+        assert read_lines, output
+        # Each run reads ip.addr, which is in both packets.
+        assert read_lines[0].split()[-2:] == ['2', '0'], read_lines[0]
@@ -8,7 +8,10 @@
 #
 '''File format conversion tests'''
 
+import glob
 import os.path
+import shutil
+import struct
 import subprocesstest
 import unittest
 import fixtures
@@ -109,6 +112,173 @@ class case_fileformat_pcapng(subprocesstest.SubprocessTestCase):
             )
         self.assertTrue(self.diffOutput(capture_proc.stdout_str, fileformats_baseline_str, 'tshark', baseline_file))
 
+    def test_pcapng_record_index(self, cmd_editcap, cmd_tshark, capture_file, fileformats_baseline_str):
+        '''Microsecond pcap direct vs pcapng with a record index, two-pass'''
+        outfile = self.filename_from_id('dhcp-record-index.pcapng')
+        self.assertRun((cmd_editcap,
+                '--record-index',
+                capture_file('dhcp.pcapng'), outfile
+                ))
+        capture_proc = self.assertRun((cmd_tshark,
+                '-r', outfile,
+                '-2',
+                '-Tfields',
+                '-e', 'frame.number', '-e', 'frame.time_epoch', '-e', 'frame.time_delta',
+                ),
+            )
+        self.assertTrue(self.diffOutput(capture_proc.stdout_str, fileformats_baseline_str, 'tshark', baseline_file))
+
+    def test_pcapng_record_index_seek(self, cmd_editcap, cmd_tshark, capture_file):
+        '''Records found through a record index are read without reading the ones before them'''
+        indexed = self.filename_from_id('dhcp-seek-index.pcapng')
+        self.assertRun((cmd_editcap,
+                '--record-index',
+                capture_file('dhcp.pcapng'), indexed
+                ))
+        # Give the first packet an interface ID that doesn't exist, so that
+        # reading it, or reading through it from the start, fails.
+        with open(indexed, 'r+b') as f:
+            data = f.read()
+            endian = '<' if data[8:12] == b'\x4d\x3c\x2b\x1a' else '>'
+            offset = 0
+            while struct.unpack(endian + 'I', data[offset:offset + 4])[0] != 6:
+                offset += struct.unpack(endian + 'I', data[offset + 4:offset + 8])[0]
+            f.seek(offset + 8)
+            f.write(struct.pack(endian + 'I', 0x7fffffff))
+        read_proc = self.runProcess((cmd_tshark, '-r', indexed))
+        self.assertNotEqual(read_proc.returncode, 0)
+
+        # Splitting on threads seeks to the first record of each file
+        # through the index, so the second file is written regardless.
+        outfile = self.filename_from_id('dhcp-seek.pcapng')
+        self.assertRun((cmd_editcap,
+                '--threads', '2',
+                '-c', '2',
+                indexed, outfile
+                ), expected_return=2)
+        split_files = sorted(glob.glob(self.filename_from_id('dhcp-seek_*.pcapng')))
+        self.assertEqual(len(split_files), 2)
+        fields = ('-Tfields', '-e', 'frame.time_epoch', '-e', 'frame.len', '-x')
+        split_proc = self.assertRun((cmd_tshark, '-r', split_files[1]) + fields)
+        orig_proc = self.assertRun((cmd_tshark,
+                '-r', capture_file('dhcp.pcapng'),
+                '-Y', 'frame.number >= 3') + fields)
+        self.assertEqual(split_proc.stdout_str, orig_proc.stdout_str)
+
+    def test_pcapng_split_threads(self, cmd_editcap, capture_file):
+        '''Split a pcapng file with a record index on several threads'''
+        indexed = self.filename_from_id('dhcp-split-index.pcapng')
+        self.assertRun((cmd_editcap,
+                '--record-index',
+                capture_file('dhcp.pcapng'), indexed
+                ))
+        outfile = self.filename_from_id('dhcp-split.pcapng')
+        self.assertRun((cmd_editcap,
+                '--threads', '2',
+                '-c', '1',
+                indexed, outfile
+                ))
+        split_files = sorted(glob.glob(self.filename_from_id('dhcp-split_*.pcapng')))
+        self.assertEqual(len(split_files), 4)
+        for split_file in split_files:
+            self.checkPacketCount(1, cap_file=split_file)
+
+    def test_pcapng_threaded_write(self, cmd_editcap, cmd_tshark, capture_file, fileformats_baseline_str):
+        '''Microsecond pcap direct vs pcapng written on a separate thread'''
+        outfile = self.filename_from_id('dhcp-threaded.pcapng')
+        self.assertRun((cmd_editcap,
+                '--threaded-write',
+                capture_file('dhcp.pcapng'), outfile
+                ))
+        capture_proc = self.assertRun((cmd_tshark,
+                '-r', outfile,
+                '-Tfields',
+                '-e', 'frame.number', '-e', 'frame.time_epoch', '-e', 'frame.time_delta',
+                ),
+            )
+        self.assertTrue(self.diffOutput(capture_proc.stdout_str, fileformats_baseline_str, 'tshark', baseline_file))
+
+    def test_pcapng_zstd_seek_table(self, cmd_editcap, cmd_tshark, capture_file, fileformats_baseline_str, features):
+        '''Microsecond pcap direct vs zstd-compressed pcapng with a seek table, two-pass'''
+        if not features.have_zstd:
+            self.skipTest('Requires zstd.')
+        outfile = self.filename_from_id('dhcp.pcapng.zst')
+        self.assertRun((cmd_editcap,
+                '--compress', 'zstd',
+                capture_file('dhcp.pcapng'), outfile
+                ))
+        capture_proc = self.assertRun((cmd_tshark,
+                '-r', outfile,
+                '-2',
+                '-Tfields',
+                '-e', 'frame.number', '-e', 'frame.time_epoch', '-e', 'frame.time_delta',
+                ),
+            )
+        self.assertTrue(self.diffOutput(capture_proc.stdout_str, fileformats_baseline_str, 'tshark', baseline_file))
+
+    def test_pcapng_gz_fast_seek_index(self, cmd_tshark, capture_file, test_env):
+        '''Two-pass read of a gzipped pcapng file, with and without a saved fast seek index'''
+        # Bigger than a seek point span uncompressed, so it has several.
+        infile = self.filename_from_id('netperfmeter.pcapng.gz')
+        shutil.copy(capture_file('netperfmeter.pcapng.gz'), infile)
+        fields = ('-2', '-Tfields',
+                '-e', 'frame.number', '-e', 'frame.time_epoch', '-e', 'frame.len', '-e', 'frame.protocols')
+        plain_proc = self.assertRun((cmd_tshark, '-r', infile) + fields, env=test_env)
+        self.assertFalse(os.path.exists(infile + '.fsidx'))
+
+        index_env = dict(test_env)
+        index_env['WIRESHARK_FAST_SEEK_INDEX'] = '1'
+        # The first read saves the index, and the second one seeks with it.
+        saving_proc = self.assertRun((cmd_tshark, '-r', infile) + fields, env=index_env)
+        self.assertTrue(os.path.exists(infile + '.fsidx'))
+        indexed_proc = self.assertRun((cmd_tshark, '-r', infile) + fields, env=index_env)
+        self.assertEqual(saving_proc.stdout_str, plain_proc.stdout_str)
+        self.assertEqual(indexed_proc.stdout_str, plain_proc.stdout_str)
+
+    def test_pcapng_epb_options(self, cmd_tshark):
+        '''EPB options decoded when asked for vs decoded as they're read'''
+        def pcapng_option(code, value):
+            return struct.pack('<HH', code, len(value)) + value + b'\0' * (-len(value) % 4)
+        def pcapng_block(block_type, body):
+            return struct.pack('<II', block_type, len(body) + 12) + body + struct.pack('<I', len(body) + 12)
+        def epb(n, options):
+            data = bytes(range(n, n + 60))
+            body = struct.pack('<IIIII', 0, 0x5a5a5a, 0x10000 * n, len(data), len(data)) + data
+            if options:
+                body += b''.join(options) + pcapng_option(0, b'')
+            return pcapng_block(6, body)
+        packet_options = (
+            (pcapng_option(1, b'first comment'), pcapng_option(1, b'second comment'),
+             pcapng_option(2, struct.pack('<I', 0x00000006))),
+            (pcapng_option(3, b'\x02\xde\xad\xbe\xef'), pcapng_option(4, struct.pack('<Q', 7)),
+             pcapng_option(5, struct.pack('<Q', 0x1122334455667788)), pcapng_option(6, struct.pack('<I', 3))),
+            (pcapng_option(7, b'\x01' + struct.pack('<Q', 2)), pcapng_option(7, b'\x00\x01\x02\x03')),
+            (),
+        )
+        # A custom option makes the reader decode all of a block's
+        # options as it reads the block.
+        custom_option = pcapng_option(2988, struct.pack('<I', 32473) + b'custom')
+        header = (pcapng_block(0x0A0D0D0A, struct.pack('<IHHq', 0x1A2B3C4D, 1, 0, -1)) +
+                  pcapng_block(1, struct.pack('<HHI', 1, 0, 0)))
+        deferred = self.filename_from_id('epb-options-deferred.pcapng')
+        with open(deferred, 'wb') as f:
+            f.write(header + b''.join(epb(n, options) for n, options in enumerate(packet_options)))
+        eager = self.filename_from_id('epb-options-eager.pcapng')
+        with open(eager, 'wb') as f:
+            f.write(header + b''.join(epb(n, options + (custom_option,)) for n, options in enumerate(packet_options)))
+
+        fields = ('-Tfields',
+                '-e', 'frame.comment', '-e', 'frame.packet_flags',
+                '-e', 'frame.hash', '-e', 'frame.hash.value',
+                '-e', 'frame.drop_count', '-e', 'frame.packet_id', '-e', 'frame.interface_queue',
+                '-e', 'frame.verdict.ebpf_tc', '-e', 'frame.verdict.hw',
+                '-e', 'frame.len', '-x')
+        deferred_proc = self.assertRun((cmd_tshark, '-r', deferred) + fields)
+        eager_proc = self.assertRun((cmd_tshark, '-r', eager) + fields)
+        self.assertIn('first comment,second comment', deferred_proc.stdout_str)
+        self.assertIn('1234605616436508552', deferred_proc.stdout_str)
+        self.assertEqual(deferred_proc.stdout_str, eager_proc.stdout_str)
+
 @fixtures.fixture
 def check_pcapng_dsb_fields(request, cmd_tshark):
     '''Factory that checks whether the DSB within the capture file matches.'''
@@ -249,3 +419,115 @@ class case_fileformat_mime(subprocesstest.SubprocessTestCase):
                 '-e', 'pcapng.block.length_trailer',
             ))
         self.assertEqual(proc.stdout_str.strip(), '480\t128,88,132,132\t128,88,132,132')
+
+
+def pcap_records(filename):
+    '''Returns the time stamp, length and data of each record of a pcap file.'''
+    with open(filename, 'rb') as f:
+        data = f.read()
+    endian = '<' if data[0:4] in (b'\xd4\xc3\xb2\xa1', b'\x4d\x3c\xb2\xa1') else '>'
+    records = []
+    offset = 24
+    while offset < len(data):
+        ts_sec, ts_frac, incl_len, orig_len = struct.unpack(endian + 'IIII', data[offset:offset + 16])
+        records.append((ts_sec, ts_frac, orig_len, data[offset + 16:offset + 16 + incl_len]))
+        offset += 16 + incl_len
+    return records
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_fileformat_editcap_dedup(subprocesstest.SubprocessTestCase):
+    def test_editcap_dedup_window(self, cmd_editcap, cmd_mergecap, capture_file):
+        '''Remove duplicates with windows of several sizes, vs comparing with every packet in the window'''
+        # Each packet of the first copy is 62 packets before its duplicate.
+        infile = self.filename_from_id('dups.pcap')
+        self.assertRun((cmd_mergecap, '-a', '-F', 'pcap', '-w', infile,
+                capture_file('rsasnakeoil2.pcap'), capture_file('dhcp.pcap'), capture_file('rsasnakeoil2.pcap')))
+        in_records = pcap_records(infile)
+        self.assertEqual(len(in_records), 120)
+        for window_args, window in ((('-d',), 5), (('-D', '2'), 2), (('-D', '62'), 62),
+                                    (('-D', '63'), 63), (('-D', '200'), 200)):
+            # A packet is compared with the window - 1 packets before it.
+            expected = []
+            previous = []
+            for record in in_records:
+                key = (record[2], record[3])
+                if key not in previous:
+                    expected.append(record)
+                previous = (previous + [key])[-(window - 1):] if window > 1 else []
+            outfile = self.filename_from_id('dedup-{}.pcap'.format(window))
+            self.assertRun((cmd_editcap, '-F', 'pcap') + window_args + (infile, outfile))
+            self.assertEqual(pcap_records(outfile), expected)
+        # The window edge falls between 62 and 63.
+        self.assertEqual(len(pcap_records(self.filename_from_id('dedup-63.pcap'))), 62)
+        self.assertEqual(len(pcap_records(self.filename_from_id('dedup-62.pcap'))), 120)
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_fileformat_reordercap(subprocesstest.SubprocessTestCase):
+    def test_reordercap_window(self, cmd_editcap, cmd_mergecap, cmd_reordercap, capture_file):
+        '''Sort in one pass with a bounded window, vs the full sort'''
+        shifted = []
+        for shift in ('0', '0.0137', '0.0291'):
+            shifted_file = self.filename_from_id('shifted{}.pcap'.format(len(shifted)))
+            self.assertRun((cmd_editcap, '-t', shift, capture_file('rsasnakeoil2.pcap'), shifted_file))
+            shifted.append(shifted_file)
+        infile = self.filename_from_id('unordered.pcap')
+        self.assertRun((cmd_mergecap, '-a', '-F', 'pcap', '-w', infile) + tuple(shifted))
+        in_records = pcap_records(infile)
+
+        sorted_file = self.filename_from_id('sorted.pcap')
+        self.assertRun((cmd_reordercap, infile, sorted_file))
+        sorted_records = pcap_records(sorted_file)
+        self.assertNotEqual(sorted_records, in_records)
+
+        # A window as big as the file puts everything right.
+        window_file = self.filename_from_id('window.pcap')
+        self.assertRun((cmd_reordercap, '-s', str(len(in_records)), infile, window_file))
+        self.assertEqual(pcap_records(window_file), sorted_records)
+
+        # A small one leaves some frames out of order, but loses none.
+        small_window_file = self.filename_from_id('small-window.pcap')
+        self.assertRun((cmd_reordercap, '-s', '10', infile, small_window_file))
+        self.assertTrue(self.grepOutput('are still out of order'))
+        self.assertEqual(sorted(pcap_records(small_window_file)), sorted(in_records))
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_fileformat_capinfos(subprocesstest.SubprocessTestCase):
+    def info_files(self, capture_file, dirs):
+        # A mix of formats and sizes, with a file that isn't a capture
+        # and one that doesn't exist, so that some reads fail.
+        return (capture_file('dhcp.pcap'), capture_file('rsasnakeoil2.pcap'),
+                capture_file('dhcp.pcapng'), capture_file('netperfmeter.pcapng.gz'),
+                os.path.join(dirs.baseline_dir, baseline_file),
+                capture_file('dmgr.pcapng'), capture_file('no-such-file.pcap'),
+                capture_file('tls12-dsb.pcapng'), capture_file('dhcp-nanosecond.pcap'))
+
+    def check_same_output(self, command, files, options):
+        serial_proc = self.runProcess(command + options + files)
+        threaded_proc = self.runProcess(command + options + ('-j', '3') + files)
+        self.assertEqual(threaded_proc.returncode, serial_proc.returncode)
+        self.assertEqual(threaded_proc.stdout_str, serial_proc.stdout_str)
+        self.assertEqual(threaded_proc.stderr_str, serial_proc.stderr_str)
+        return serial_proc
+
+    def test_capinfos_threads(self, cmd_capinfos, capture_file, dirs):
+        '''capinfos on several threads vs one'''
+        files = self.info_files(capture_file, dirs)
+        proc = self.check_same_output((cmd_capinfos,), files, ())
+        self.assertNotEqual(proc.returncode, 0)
+        self.assertIn(capture_file('tls12-dsb.pcapng'), proc.stdout_str)
+        self.check_same_output((cmd_capinfos,), files, ('-H',))
+        self.check_same_output((cmd_capinfos,), files, ('-T', '-r'))
+        # -C stops at the first file that can't be read.
+        proc = self.check_same_output((cmd_capinfos,), files, ('-C',))
+        self.assertNotIn(capture_file('dmgr.pcapng'), proc.stdout_str)
+
+    def test_captype_threads(self, cmd_captype, capture_file, dirs):
+        '''captype on several threads vs one'''
+        proc = self.check_same_output((cmd_captype,), self.info_files(capture_file, dirs), ())
+        self.assertIn(capture_file('dhcp.pcapng') + ': pcapng', proc.stdout_str)
@@ -10,6 +10,7 @@
 
 import io
 import os.path
+import struct
 import subprocesstest
 import sys
 import unittest
@@ -84,3 +85,47 @@ class case_rawshark_io(subprocesstest.SubprocessTestCase):
         rawshark_cmd = '{0} | "{1}" -r - -n -dencap:1 -R "udp.port==68"'.format(raw_dhcp_cmd, cmd_rawshark)
         rawshark_proc = self.assertRun(rawshark_cmd, shell=True)
         self.assertTrue(self.diffOutput(rawshark_proc.stdout_str, io_baseline_str, 'rawshark', baseline_file))
+
+    @unittest.skipUnless(sys.byteorder == 'little', 'Requires a little endian system')
+    def test_rawshark_io_binary(self, cmd_rawshark):
+        '''Rawshark binary records vs text lines'''
+        raw_dhcp_cmd = subprocesstest.cat_dhcp_command('raw')
+        fields = ('frame.len', 'udp.srcport', 'ip.src', 'eth.src', 'frame.protocols')
+        filters = ('udp.port==68', 'udp.srcport==67')
+        args = ' '.join('-F {}'.format(field) for field in fields)
+        args += ''.join(' -R "{}"'.format(rfilter) for rfilter in filters)
+        rawshark_cmd = '{0} | "{1}" -r - -n -dencap:1 {2}'.format(raw_dhcp_cmd, cmd_rawshark, args)
+        text_proc = self.assertRun(rawshark_cmd, shell=True)
+        binary_file = self.filename_from_id('rawshark.bin')
+        self.assertRun('{0} -B > "{1}"'.format(rawshark_cmd, binary_file), shell=True)
+        with open(binary_file, 'rb') as f:
+            binary_out = f.read()
+
+        # Turn the binary records back into text lines, as described in
+        # rawshark(1).
+        header, records = binary_out.split(b'\n', 1)
+        lines = [header.decode('UTF-8')]
+        while records:
+            rec_len, frame_num, passed = struct.unpack('=IIQ', records[:16])
+            fields_data = records[16:4 + rec_len]
+            records = records[4 + rec_len:]
+            line = str(frame_num)
+            while fields_data:
+                index, value_type, value_len = struct.unpack('=HHI', fields_data[:8])
+                value = fields_data[8:8 + value_len]
+                fields_data = fields_data[8 + value_len:]
+                if value_type == 1:
+                    text = str(struct.unpack('=Q', value)[0])
+                elif value_type == 5 and value_len == 4:
+                    text = '.'.join(str(b) for b in value)
+                elif value_type == 5:
+                    text = ':'.join('%02x' % b for b in value)
+                elif value_type == 6:
+                    text = value.decode('UTF-8')
+                else:
+                    self.fail('Unexpected value type {}'.format(value_type))
+                line += ' {}="{}"'.format(index, text)
+            line += ''.join(' {}'.format((passed >> i) & 1) for i in range(len(filters)))
+            lines.append(line + ' -')
+        self.assertEqual('\n'.join(lines) + '\n', text_proc.stdout_str)
+        self.assertIn('="eth:ethertype:ip:udp:dhcp"', text_proc.stdout_str)
@@ -69,6 +69,19 @@ def check_mergecap(self, mergecap_proc, file_type, encapsulation, tot_packets, g
     self.assertTrue(re.search(midb_pat, capinfos_testout) is not None,
         'Failed to merge {} IDB packets'.format(idb_packets))
 
+# Appending (-a) must give the records of each input in turn, unchanged,
+# whether they're copied as raw bytes or read and written one at a time.
+def check_mergecap_append(self, cmd_tshark, testout_file, in_files):
+    fields_args = ('-Tfields',
+        '-e', 'frame.time_epoch', '-e', 'frame.len', '-e', 'frame.interface_name',
+        '-x',
+    )
+    expected = ''.join(
+        self.assertRun((cmd_tshark, '-r', in_file) + fields_args).stdout_str
+        for in_file in in_files)
+    tshark_proc = self.assertRun((cmd_tshark, '-r', testout_file) + fields_args)
+    self.assertEqual(tshark_proc.stdout_str, expected)
+
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
@@ -121,6 +134,60 @@ class case_mergecap_pcap(subprocesstest.SubprocessTestCase):
         ))
         check_mergecap(self, mergecap_proc, 'pcap', 'Ethernet', 62, 1, 62)
 
+    def test_mergecap_append_2_pcap_pcap(self, cmd_mergecap, cmd_tshark, capture_file):
+        '''Append two pcap files to pcap, copying their records'''
+        testout_file = self.filename_from_id(testout_pcap)
+        in_files = (capture_file('dhcp.pcap'), capture_file('rsasnakeoil2.pcap'))
+        mergecap_proc = self.assertRun((cmd_mergecap,
+            '-V',
+            '-a',
+            '-F', 'pcap',
+            '-w', testout_file,
+        ) + in_files)
+        check_mergecap(self, mergecap_proc, 'pcap', 'Ethernet', 62, 1, 62)
+        check_mergecap_append(self, cmd_tshark, testout_file, in_files)
+
+    def test_mergecap_batches_1_pcap_pcap(self, cmd_mergecap, cmd_tshark, capture_file):
+        '''Merge one pcap file, read in several batches, to pcap'''
+        testout_file = self.filename_from_id(testout_pcap)
+        in_files = (capture_file('rsasnakeoil2.pcap'),)
+        mergecap_proc = self.assertRun((cmd_mergecap,
+            '-V',
+            '-F', 'pcap',
+            '-w', testout_file,
+        ) + in_files)
+        check_mergecap(self, mergecap_proc, 'pcap', 'Ethernet', 58, 1, 58)
+        check_mergecap_append(self, cmd_tshark, testout_file, in_files)
+
+    def test_mergecap_chrono_5_pcap_pcap(self, cmd_mergecap, cmd_editcap, cmd_reordercap, cmd_tshark, capture_file):
+        '''Merge five overlapping pcap files chronologically, vs appending them and sorting'''
+        in_files = []
+        for shift in ('0', '0.0137', '0.0291', '-0.0413', '0.0559'):
+            in_file = self.filename_from_id('shifted{}.pcap'.format(len(in_files)))
+            self.assertRun((cmd_editcap, '-t', shift, capture_file('rsasnakeoil2.pcap'), in_file))
+            in_files.append(in_file)
+        testout_file = self.filename_from_id(testout_pcap)
+        mergecap_proc = self.assertRun((cmd_mergecap,
+            '-V',
+            '-F', 'pcap',
+            '-w', testout_file,
+        ) + tuple(in_files))
+        check_mergecap(self, mergecap_proc, 'pcap', 'Ethernet', 290, 1, 290)
+
+        appended_file = self.filename_from_id('appended.pcap')
+        self.assertRun((cmd_mergecap, '-a', '-F', 'pcap', '-w', appended_file) + tuple(in_files))
+        sorted_file = self.filename_from_id('sorted.pcap')
+        self.assertRun((cmd_reordercap, appended_file, sorted_file))
+
+        fields_args = ('-Tfields', '-e', 'frame.time_epoch', '-e', 'frame.len', '-x')
+        merged_proc = self.assertRun((cmd_tshark, '-r', testout_file) + fields_args)
+        sorted_proc = self.assertRun((cmd_tshark, '-r', sorted_file) + fields_args)
+        self.assertEqual(merged_proc.stdout_str, sorted_proc.stdout_str)
+        # No two records have the same time stamp, so there's only one order.
+        times_proc = self.assertRun((cmd_tshark, '-r', testout_file, '-Tfields', '-e', 'frame.time_epoch'))
+        times = times_proc.stdout_str.split()
+        self.assertEqual(len(set(times)), 290)
+
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
@@ -285,3 +352,39 @@ class case_mergecap_pcapng(subprocesstest.SubprocessTestCase):
         ))
         # check for 11 IDBs, 88*3=264 total pkts, 86*3=258 in first IDB
         check_mergecap(self, mergecap_proc, 'pcapng', 'Per packet', 264, 11, 258)
+
+    def test_mergecap_append_2_pcapng_pcapng(self, cmd_mergecap, cmd_tshark, capture_file):
+        '''Append two pcapng files to pcapng, copying their records'''
+        testout_file = self.filename_from_id(testout_pcapng)
+        in_files = (capture_file('dhcp.pcapng'), capture_file('dhcp-nanosecond.pcapng'))
+        mergecap_proc = self.assertRun((cmd_mergecap,
+            '-V',
+            '-a',
+            '-w', testout_file,
+        ) + in_files)
+        check_mergecap(self, mergecap_proc, 'pcapng', 'Ethernet', 8, 2, 4)
+        check_mergecap_append(self, cmd_tshark, testout_file, in_files)
+
+    def test_mergecap_batches_1_pcapng_pcapng(self, cmd_mergecap, cmd_tshark, capture_file):
+        '''Merge one pcapng file, read in several batches, to pcapng'''
+        testout_file = self.filename_from_id(testout_pcapng)
+        in_files = (capture_file('dmgr.pcapng'),)
+        mergecap_proc = self.assertRun((cmd_mergecap,
+            '-V',
+            '-w', testout_file,
+        ) + in_files)
+        self.assertTrue(self.grepOutput('merging complete'))
+        self.checkPacketCount(42, cap_file=testout_file)
+        check_mergecap_append(self, cmd_tshark, testout_file, in_files)
+
+    def test_mergecap_append_mixed_pcapng(self, cmd_mergecap, cmd_tshark, capture_file):
+        '''Append a pcap and a pcapng file to pcapng, reading and writing each record'''
+        testout_file = self.filename_from_id(testout_pcapng)
+        in_files = (capture_file('dhcp.pcap'), capture_file('dhcp.pcapng'))
+        mergecap_proc = self.assertRun((cmd_mergecap,
+            '-V',
+            '-a',
+            '-w', testout_file,
+        ) + in_files)
+        self.assertTrue(self.grepOutput('merging complete'))
+        check_mergecap_append(self, cmd_tshark, testout_file, in_files)
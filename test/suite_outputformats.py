@@ -93,3 +93,32 @@ class case_outputformats(subprocesstest.SubprocessTestCase):
         ''' Check that the option -j works with -Tek.'''
         check_outputformat("ek", extra_args=['-j', 'dhcp'], expected="dhcp-filter.ek",
             multiline=True)
+
+    def test_outputformat_dissect_workers(self, cmd_mergecap, cmd_tshark, capture_file):
+        '''Checks that the second pass gives the same output in worker processes.'''
+        # More than one block of frames, so that every worker gets some.
+        many_dhcp = self.filename_from_id('many-dhcp.pcap')
+        self.assertRun([cmd_mergecap, '-a', '-F', 'pcap', '-w', many_dhcp] +
+            [capture_file('dhcp.pcap')] * 1000)
+        for format_args in (['-T', 'json'], ['-T', 'fields', '-e', 'frame.number',
+                '-e', 'frame.time_delta_displayed', '-e', 'dhcp.id']):
+            single_proc = self.assertRun([cmd_tshark, '-2', '-r', many_dhcp] + format_args)
+            workers_proc = self.assertRun([cmd_tshark, '-2', '--dissect-workers', '3',
+                '-r', many_dhcp] + format_args)
+            self.assertEqual(single_proc.stdout_str, workers_proc.stdout_str)
+
+    def test_outputformat_flow_shards(self, cmd_mergecap, cmd_tshark, capture_file):
+        '''Checks that splitting the conversations between processes gives the same output.'''
+        # Conversation indices such as udp.stream are numbered per process, so leave them out.
+        many_conv = self.filename_from_id('many-conversations.pcap')
+        self.assertRun([cmd_mergecap, '-a', '-F', 'pcap', '-w', many_conv] +
+            [capture_file('dhcp.pcap'), capture_file('dns_port.pcap')] * 200)
+        fields = ['-e', 'frame.number', '-e', 'frame.time_delta_displayed',
+            '-e', 'ip.src', '-e', 'udp.srcport', '-e', 'dhcp.id']
+        for two_pass in ([], ['-2']):
+            for format_args in (['-T', 'json'] + fields, ['-T', 'fields'] + fields):
+                single_proc = self.assertRun([cmd_tshark, '-r', many_conv] +
+                    two_pass + format_args)
+                shards_proc = self.assertRun([cmd_tshark, '--flow-shards', '3',
+                    '-r', many_conv] + two_pass + format_args)
+                self.assertEqual(single_proc.stdout_str, shards_proc.stdout_str)
@@ -89,6 +89,19 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
                 "filename": "dhcp.pcap", "filesize": 1400}},
         ))
 
+    def test_sharkd_req_load_tail(self, check_sharkd_session, capture_file):
+        # Nothing is being written to the file, so there are no notifications.
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap'), "tail": True}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"status"},
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"frames": 4, "duration": 0.070345000,
+                "filename": "dhcp.pcap", "filesize": 1400}},
+        ))
+
     def test_sharkd_req_analyse(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"load",
@@ -183,6 +196,27 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             },
         ))
 
+    def test_sharkd_req_frames_skip(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"frames",
+            "params":{"skip": 1, "limit": 2}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"frames",
+            "params":{"filter": "frame.len == 342", "skip": 1}
+            },
+            {"jsonrpc":"2.0", "id":4, "method":"frames",
+            "params":{"filter": "frame.len == 342", "skip": 2}
+            },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":[MatchObject({"num": 2}), MatchObject({"num": 3})]},
+            {"jsonrpc":"2.0","id":3,"result":[MatchObject({"num": 4})]},
+            {"jsonrpc":"2.0","id":4,"result":[]},
+        ))
+
     def test_sharkd_req_tap_invalid(self, check_sharkd_session, capture_file):
         # XXX Unrecognized taps result in an empty line, modify
         #     run_sharkd_session such that checking for it is possible.
@@ -308,6 +342,28 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             },
         ))
 
+    def test_sharkd_req_follow_tcp_stream(self, run_sharkd_session, capture_file):
+        # A stream filter only dissects the stream's frames; the result
+        # should be the same as for a filter that looks at all of them.
+        outputs = run_sharkd_session([json.dumps(x) for x in (
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('http2-data-reassembly.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"follow",
+            "params":{"follow": "TCP", "filter": "tcp.stream eq 0"}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"follow",
+            "params":{"follow": "TCP", "filter": "frame && tcp.stream eq 0"}
+            },
+            {"jsonrpc":"2.0", "id":4, "method":"follow",
+            "params":{"follow": "TCP", "filter": "tcp.stream eq 0"}
+            },
+        )])
+        self.assertEqual(len(outputs), 4)
+        self.assertIn('payloads', outputs[1]['result'])
+        self.assertEqual(outputs[1]['result'], outputs[2]['result'])
+        self.assertEqual(outputs[1]['result'], outputs[3]['result'])
+
     def test_sharkd_req_iograph_bad(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"load",
@@ -344,6 +400,29 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             {"jsonrpc":"2.0","id":3,"error":{"code":-6001,"message":"Filter \"garbage filter\" is invalid - \"filter\" was unexpected in this context."}},
         ))
 
+    def test_sharkd_req_iograph_intervals(self, check_sharkd_session, capture_file):
+        # The second and third requests are answered from the items kept
+        # for the first.
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"iograph",
+            "params":{"graph0": "packets", "interval": 10}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"iograph",
+            "params":{"graph0": "packets", "interval": 1000}
+            },
+            {"jsonrpc":"2.0", "id":4, "method":"iograph",
+            "params":{"graph0": "packets", "interval": 20}
+            },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"iograph": [{"items": [2.000000, "7", 2.000000]}]}},
+            {"jsonrpc":"2.0","id":3,"result":{"iograph": [{"items": [4.000000]}]}},
+            {"jsonrpc":"2.0","id":4,"result":{"iograph": [{"items": [2.000000, "3", 2.000000]}]}},
+        ))
+
     def test_sharkd_req_intervals_bad(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"load",
@@ -376,6 +455,32 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             {"jsonrpc":"2.0","id":4,"result":{"intervals":[[0,2,656]],"last":0,"frames":2,"bytes":656}},
         ))
 
+    def test_sharkd_req_intervals_combined_filter(self, check_sharkd_session, capture_file):
+        # The results of the last two filters are worked out from the first two.
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"intervals",
+            "params":{"filter": "frame.number <= 2"}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"intervals",
+            "params":{"filter": "frame.len == 342"}
+            },
+            {"jsonrpc":"2.0", "id":4, "method":"intervals",
+            "params":{"filter": "frame.number <= 2 && frame.len == 342"}
+            },
+            {"jsonrpc":"2.0", "id":5, "method":"intervals",
+            "params":{"filter": "frame.number <= 2 or frame.len == 342"}
+            },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"intervals":[[0,2,656]],"last":0,"frames":2,"bytes":656}},
+            {"jsonrpc":"2.0","id":3,"result":{"intervals":[[0,2,684]],"last":0,"frames":2,"bytes":684}},
+            {"jsonrpc":"2.0","id":4,"result":{"intervals":[[0,1,342]],"last":0,"frames":1,"bytes":342}},
+            {"jsonrpc":"2.0","id":5,"result":{"intervals":[[0,3,998]],"last":0,"frames":3,"bytes":998}},
+        ))
+
     def test_sharkd_req_frame_basic(self, check_sharkd_session, capture_file):
         # XXX add more tests for other options (ref_frame, prev_frame, columns, color, bytes, hidden)
         check_sharkd_session((
@@ -441,6 +546,28 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             {"jsonrpc":"2.0","id":4,"result":{"comment":["foo\nbar"],"fol": MatchAny(list)}},
         ))
 
+    def test_sharkd_req_frames_after_setcomment(self, check_sharkd_session, capture_file):
+        # Frames sent before are sent again from the cache, but with their new comments.
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"frames",
+            "params":{"skip": 2, "limit": 1}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"setcomment",
+            "params":{"frame": 3, "comment": "foo"}
+            },
+            {"jsonrpc":"2.0", "id":4, "method":"frames",
+            "params":{"skip": 2, "limit": 1}
+            },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":[MatchObject({"num": 3, "ct": None})]},
+            {"jsonrpc":"2.0","id":3,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":4,"result":[MatchObject({"num": 3, "ct": True})]},
+        ))
+
     def test_sharkd_req_setconf_bad(self, check_sharkd_session):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"setconf",
@@ -475,6 +602,21 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             },
         ))
 
+    def test_sharkd_req_encoding(self, check_sharkd_session):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"encoding",
+            "params":{"encoding": "xml"}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"encoding",
+            "params":{"encoding": "json"}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"status"},
+        ), (
+            {"jsonrpc":"2.0","id":1,"error":{"code":-15001,"message":"Unknown encoding \"xml\""}},
+            {"jsonrpc":"2.0","id":2,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":3,"result":{"frames":0,"duration":0.000000000}},
+        ))
+
     def test_sharkd_req_download_tls_secrets(self, check_sharkd_session, capture_file):
         # XXX test download for eo: and rtp: too
         check_sharkd_session((
@@ -492,6 +634,44 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             },
         ))
 
+    def test_sharkd_req_metrics(self, check_sharkd_session):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"status"},
+            {"jsonrpc":"2.0", "id":2, "method":"status"},
+            {"jsonrpc":"2.0", "id":3, "method":"metrics",
+            "params":{"slow": 1000}
+            },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"frames":0,"duration":0.000000000}},
+            {"jsonrpc":"2.0","id":2,"result":{"frames":0,"duration":0.000000000}},
+            {"jsonrpc":"2.0","id":3,"result":{"methods": [
+                {"method": "status", "requests": 2, "time": MatchAny(float),
+                 "dissect": 0.0, "filter": 0.0, "max": MatchAny(float),
+                 "hist": MatchList(MatchAny(int), n=16)},
+            ], "slow": 1000}},
+        ))
+
+    def test_sharkd_req_perfstats(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"perfstats",
+            "params":{"reset": True}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"perfstats"},
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"stats": MatchList(
+                {"name": "wiretap.records_read", "description": MatchAny(str),
+                 "unit": "count", "value": 4},
+                match_element=any)}},
+            {"jsonrpc":"2.0","id":3,"result":{"stats": MatchList(
+                {"name": "wiretap.records_read", "description": MatchAny(str),
+                 "unit": "count", "value": 0},
+                match_element=any)}},
+        ))
+
     def test_sharkd_req_bye(self, check_sharkd_session):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"bye"},
@@ -19,10 +19,28 @@ import fixtures
 
 @fixtures.uses_fixtures
 class case_unittests(subprocesstest.SubprocessTestCase):
+    def test_unit_conversation_test(self, program, base_env):
+        '''conversation_test'''
+        self.assertRun((program('conversation_test'),
+            '--verbose'
+        ), env=base_env)
+
     def test_unit_exntest(self, program, base_env):
         '''exntest'''
         self.assertRun(program('exntest'), env=base_env)
 
+    def test_unit_file_wrappers_test(self, program, base_env):
+        '''file_wrappers_test'''
+        self.assertRun((program('file_wrappers_test'),
+            '--verbose'
+        ), env=base_env)
+
+    def test_unit_frame_data_test(self, program, base_env):
+        '''frame_data_test'''
+        self.assertRun((program('frame_data_test'),
+            '--verbose'
+        ), env=base_env)
+
     def test_unit_oids_test(self, program, base_env):
         '''oids_test'''
         self.assertRun(program('oids_test'), env=base_env)
@@ -31,6 +49,14 @@ class case_unittests(subprocesstest.SubprocessTestCase):
         '''reassemble_test'''
         self.assertRun(program('reassemble_test'), env=base_env)
 
+    def test_unit_record_copy_test(self, program, capture_file, base_env):
+        '''record_copy_test'''
+        self.assertRun((program('record_copy_test'),
+            '--verbose',
+            capture_file('rsasnakeoil2.pcap'),
+            capture_file('dhcp.pcapng')
+        ), env=base_env)
+
     def test_unit_tvbtest(self, program, base_env):
         '''tvbtest'''
         self.assertRun(program('tvbtest'), env=base_env)
@@ -51,6 +77,12 @@ class case_unittests(subprocesstest.SubprocessTestCase):
             '--verbose'
         ), env=base_env)
 
+    def test_unit_perf_epan(self, program, base_env):
+        '''epan microbenchmarks, run a few times each'''
+        self.assertRun((program('perf_epan'),
+            '--verbose'
+        ), env=base_env)
+
     def test_unit_wsutil(self, program, base_env):
         '''wsutil unit tests'''
         self.assertRun((program('test_wsutil'),
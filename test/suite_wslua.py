@@ -46,16 +46,18 @@ def check_lua_script(cmd_tshark, features, dirs, capture_file):
 
 @fixtures.fixture(scope='session')
 def check_lua_script_verify(check_lua_script):
-    def check_lua_script_verify_real(self, lua_script, cap_file, check_stage_1=False, heur_regmode=None):
+    def check_lua_script_verify_real(self, lua_script, cap_file, check_stage_1=False, heur_regmode=None, *args):
         # First run tshark with the dissector script.
         if heur_regmode is None:
             tshark_proc = check_lua_script(self, lua_script, dns_port_pcap, check_stage_1,
-                '-V'
+                '-V',
+                *args
             )
         else:
             tshark_proc = check_lua_script(self, lua_script, dns_port_pcap, check_stage_1,
                 '-V',
-                '-X', 'lua_script1:heur_regmode={}'.format(heur_regmode)
+                '-X', 'lua_script1:heur_regmode={}'.format(heur_regmode),
+                *args
             )
 
         # then dump tshark's output to a verification file.
@@ -101,6 +103,12 @@ class case_wslua(subprocesstest.SubprocessTestCase):
         '''wslua dissector functions, mode 3'''
         check_lua_script_verify(self, 'dissector.lua', dns_port_pcap, heur_regmode=3)
 
+    def test_wslua_dissector_mode_2_heur_order(self, check_lua_script_verify):
+        '''wslua dissector functions, mode 2, ordering heuristics by hits, with conversation hints'''
+        check_lua_script_verify(self, 'dissector.lua', dns_port_pcap, False, 2,
+            '-o', 'protocols.heuristic_dissector_order:HIT_COUNT',
+            '-o', 'protocols.heuristic_conversation_hints:TRUE')
+
     def test_wslua_dissector_fpm(self, check_lua_script):
         '''wslua dissector functions, fpm'''
         tshark_fpm_tcp_proc = check_lua_script(self, 'dissectFPM.lua', segmented_fpm_pcap, False,
@@ -133,6 +141,18 @@ class case_wslua(subprocesstest.SubprocessTestCase):
         '''wslua fields'''
         check_lua_script(self, 'field.lua', dhcp_pcap, True)
 
+    def test_wslua_bench_dissector(self, check_lua_script):
+        '''wslua dissection benchmark'''
+        check_lua_script(self, 'bench_dissector.lua', dhcp_pcap, True,
+            '-X', 'lua_script1:20',
+        )
+
+    def test_wslua_bench_file(self, check_lua_script):
+        '''wslua file reading benchmark'''
+        check_lua_script(self, 'bench_file.lua', dhcp_pcap, True,
+            '-X', 'lua_script1:20',
+        )
+
     # reader, writer, and acme_reader were all under wslua_step_file_test
     # in the Bash version.
     def test_wslua_file_reader(self, check_lua_script, cmd_tshark, capture_file):
@@ -189,6 +209,10 @@ class case_wslua(subprocesstest.SubprocessTestCase):
         '''wslua listener'''
         check_lua_script(self, 'listener.lua', dhcp_pcap, True)
 
+    def test_wslua_listener_batch(self, check_lua_script):
+        '''wslua listener batches'''
+        check_lua_script(self, 'listener_batch.lua', dhcp_pcap, True)
+
     def test_wslua_nstime(self, check_lua_script):
         '''wslua nstime'''
         check_lua_script(self, 'nstime.lua', dhcp_pcap, True)
@@ -72,6 +72,7 @@
 #include <string.h>
 #include <wsutil/file_util.h>
 #include <cli_main.h>
+#include <ui/clopts_common.h>
 #include <ui/cmdarg_err.h>
 #include <ui/exit_codes.h>
 #include <ui/text_import.h>
@@ -223,6 +224,7 @@ print_usage (FILE *output)
             "                         Example: -l 7 for ARCNet packets.\n"
             "  -m <max-packet>        max packet length in output; default is %d\n"
             "  -N <intf-name>         assign name to the interface in the pcapng file.\n"
+            "  --threaded-write       write the output file on a separate thread.\n"
             "\n"
             "Prepend dummy header:\n"
             "  -e <l3pid>             prepend dummy Ethernet II header with specified L3PID\n"
@@ -356,12 +358,15 @@ parse_options(int argc, char *argv[], text_import_info_t * const info, wtap_dump
     int   ret;
     int   c;
     char *p;
+#define LONGOPT_THREADED_WRITE LONGOPT_BASE_APPLICATION+1
     static const struct ws_option long_options[] = {
         {"help", ws_no_argument, NULL, 'h'},
         {"version", ws_no_argument, NULL, 'v'},
+        {"threaded-write", ws_no_argument, NULL, LONGOPT_THREADED_WRITE},
         {0, 0, 0, 0 }
     };
     const char *interface_name = NULL;
+    gboolean threaded_write = FALSE;
     /* Link-layer type; see https://www.tcpdump.org/linktypes.html for details */
     guint32 pcap_link_type = 1;   /* Default is LINKTYPE_ETHERNET */
     int file_type_subtype = WTAP_FILE_TYPE_SUBTYPE_UNKNOWN;
@@ -388,6 +393,7 @@ parse_options(int argc, char *argv[], text_import_info_t * const info, wtap_dump
             exit(0);
             break;
         case 'q': quiet = TRUE; break;
+        case LONGOPT_THREADED_WRITE: threaded_write = TRUE; break;
         case 'a': info->hexdump.identify_ascii = TRUE; break;
         case 'D': info->hexdump.has_direction = TRUE; break;
         case 'l':
@@ -857,6 +863,7 @@ parse_options(int argc, char *argv[], text_import_info_t * const info, wtap_dump
 
     params->encap = wtap_encap_type;
     params->snaplen = max_offset;
+    params->threaded_write = threaded_write;
     if (file_type_subtype == WTAP_FILE_TYPE_SUBTYPE_UNKNOWN) {
         file_type_subtype = wtap_pcapng_file_type_subtype();
     }
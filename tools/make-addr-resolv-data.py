@@ -0,0 +1,287 @@
+#!/usr/bin/env python3
+#
+# make-addr-resolv-data.py
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+
+'''\
+Reads the manuf, wka, services and enterprises.tsv files and writes a C
+source file with their contents as sorted tables, for addr_resolv.c,
+so that they don't have to be read every time Wireshark starts.
+
+Usage: make-addr-resolv-data.py manuf wka services enterprises.tsv output.c
+
+The files are parsed the way addr_resolv.c used to parse them, including
+which entry wins when there are duplicates; see addr_resolv_data.h for
+the layout of the tables.
+'''
+
+import os
+import re
+import sys
+
+# Must match addr_resolv_data.h and addr_resolv.h.
+CHUNK_SIZE = 16384
+MAXNAMELEN = 64
+MAX_LINELEN = 1024
+
+
+class StringTable:
+    '''The names, NUL-terminated, in chunks of CHUNK_SIZE bytes; a name
+    doesn't cross from one chunk to the next.  Offset 0 is the empty
+    string, meaning "no name".'''
+
+    def __init__(self):
+        self.chunks = [[b'']]
+        self.used = 1
+        self.offsets = {}
+
+    def add(self, s):
+        if s is None:
+            return 0
+        if s in self.offsets:
+            return self.offsets[s]
+        # Leave room for the NUL that ends each chunk's string literal.
+        if self.used + len(s) + 1 > CHUNK_SIZE - 1:
+            self.chunks.append([])
+            self.used = 0
+        offset = (len(self.chunks) - 1) * CHUNK_SIZE + self.used
+        self.chunks[-1].append(s)
+        self.used += len(s) + 1
+        self.offsets[s] = offset
+        return offset
+
+
+def c_string(s):
+    out = ''
+    for b in s:
+        c = chr(b)
+        if 0x20 <= b < 0x7f and c not in '"\\?':
+            out += c
+        else:
+            # Octal escapes are at most three digits, so, unlike hex
+            # ones, they can't run into the next character.
+            out += '\\%03o' % b
+    return '"' + out + '\\0"'
+
+
+def read_lines(path):
+    '''Lines as fgetline() in addr_resolv.c returns them.'''
+    with open(path, 'rb') as f:
+        for line in f:
+            # fgets() splits overlong lines.
+            while line:
+                piece = line[:MAX_LINELEN - 1]
+                line = line[MAX_LINELEN - 1:]
+                yield re.split(rb'[\r\n]', piece, maxsplit=1)[0]
+
+
+def truncate_name(s):
+    '''g_strlcpy() into a MAXNAMELEN buffer.'''
+    return s[:MAXNAMELEN - 1]
+
+
+def parse_ether_address(s):
+    '''parse_ether_address() with accept_mask TRUE; returns (addr, mask)
+    or None.  The "fast" version in addr_resolv.c accepts a subset of
+    what this does, with the same results.'''
+    # All the separators must be the same.
+    m = re.fullmatch(rb'([0-9A-Fa-f]+(?:([:.-])[0-9A-Fa-f]+(?:\2[0-9A-Fa-f]+)*)?)(?:/([0-9]+))?', s)
+    if m is None:
+        return None
+    octets = [int(o, 16) for o in re.split(rb'[:.-]', m.group(1))]
+    if len(octets) > 6 or max(octets) > 0xFF:
+        return None
+    # Octets that aren't given, as in "01-00-5E/25", are zero.
+    addr = octets + [0] * (6 - len(octets))
+    if m.group(3) is None:
+        if len(octets) == 3:
+            return (bytes(addr), 0)
+        if len(octets) == 6:
+            return (bytes(addr), 48)
+        return None
+    mask = int(m.group(3))
+    if mask == 0 or mask >= 48:
+        return None
+    i, num = divmod(mask, 8)
+    addr[i] &= (0xFF << (8 - num)) & 0xFF
+    for j in range(i + 1, 6):
+        addr[j] = 0
+    return (bytes(addr), mask)
+
+
+def parse_ether_file(path, manuf, wka, ethers):
+    '''parse_ether_line() and add_manuf_name().'''
+    for line in read_lines(path):
+        line = line.strip(b' \t\n\v\f\r')
+        if not line or line.startswith(b'#'):
+            continue
+        line = line.split(b'#', 1)[0].rstrip(b' \t\n\v\f\r')
+        tokens = line.split(None, 1)
+        if not tokens:
+            continue
+        parsed = parse_ether_address(tokens[0])
+        if parsed is None:
+            continue
+        addr, mask = parsed
+        if len(tokens) < 2:
+            continue
+        # The name runs to the next space or tab, and the long name from
+        # there to the next tab.
+        rest = tokens[1].lstrip(b' \t')
+        m = re.match(rb'([^ \t]+)[ \t]?(.*)', rest)
+        name = m.group(1)
+        longname = m.group(2).lstrip(b'\t').split(b'\t', 1)[0] or None
+        if longname is None:
+            longname = name
+        name = truncate_name(name)
+        longname = truncate_name(longname)
+        if mask == 0:
+            manuf[(addr[0] << 16) | (addr[1] << 8) | addr[2]] = (name, longname)
+        elif mask == 48:
+            ethers[addr] = name
+        else:
+            wka[addr] = name
+
+
+def parse_port_range(s):
+    '''range_convert_str() for the ranges in the services file.'''
+    ports = []
+    for part in s.split(b','):
+        part = part.strip()
+        m = re.fullmatch(rb'([0-9]+)(?:-([0-9]+))?', part)
+        if m is None:
+            return None
+        low = int(m.group(1))
+        high = int(m.group(2)) if m.group(2) is not None else low
+        if low > 65535 or high > 65535:
+            return None
+        if low > high:
+            low, high = high, low
+        ports.extend(range(low, high + 1))
+    return ports
+
+
+PROTOS = {b'tcp': 0, b'udp': 1, b'sctp': 2, b'dccp': 3}
+
+
+def parse_services_file(path, services):
+    '''parse_service_line().'''
+    for line in read_lines(path):
+        line = line.split(b'#', 1)[0]
+        tokens = re.findall(rb'[^ \t]+', line)
+        if len(tokens) < 2:
+            continue
+        service = tokens[0]
+        fields = [f for f in tokens[1].split(b'/') if f]
+        if not fields:
+            continue
+        ports = parse_port_range(fields[0])
+        if ports is None:
+            continue
+        for proto in fields[1:]:
+            if proto not in PROTOS:
+                break
+            for port in ports:
+                if port != 0:
+                    services.setdefault(port, [None] * 4)[PROTOS[proto]] = service
+
+
+def parse_enterprises_file(path, enterprises):
+    '''parse_enterprises_line().'''
+    for line in read_lines(path):
+        had_comment = b'#' in line
+        line = line.split(b'#', 1)[0]
+        m = re.match(rb'[ \t]*([^ \t]+)[ \t]?(.*)', line, re.DOTALL)
+        if m is None:
+            continue
+        number = m.group(1)
+        org = m.group(2)
+        if org and had_comment:
+            org = org.rstrip(b' \t\n\v\f\r')
+        if not org:
+            continue
+        if not re.fullmatch(rb'[0-9]+', number) or int(number) > 0xFFFFFFFF:
+            continue
+        enterprises[int(number)] = org
+
+
+def main():
+    if len(sys.argv) != 6:
+        sys.stderr.write(__doc__)
+        sys.exit(1)
+    manuf_path, wka_path, services_path, enterprises_path, out_path = sys.argv[1:]
+
+    manuf = {}
+    wka = {}
+    ethers = {}
+    services = {}
+    enterprises = {}
+    parse_ether_file(manuf_path, manuf, wka, ethers)
+    parse_ether_file(wka_path, manuf, wka, ethers)
+    parse_services_file(services_path, services)
+    parse_enterprises_file(enterprises_path, enterprises)
+
+    strings = StringTable()
+    manuf_rows = []
+    for oui in sorted(manuf):
+        name, longname = manuf[oui]
+        manuf_rows.append('    { 0x%06x, %u, %u },' % (oui, strings.add(name), strings.add(longname)))
+    wka_rows = []
+    for addr in sorted(wka):
+        wka_rows.append('    { { %s }, %u },' % (', '.join('0x%02x' % b for b in addr), strings.add(wka[addr])))
+    ethers_rows = []
+    for addr in sorted(ethers):
+        ethers_rows.append('    { { %s }, %u },' % (', '.join('0x%02x' % b for b in addr), strings.add(ethers[addr])))
+    services_rows = []
+    for port in sorted(services):
+        services_rows.append('    { %u, %s },' % (port, ', '.join(str(strings.add(n)) for n in services[port])))
+    enterprises_rows = []
+    for number in sorted(enterprises):
+        enterprises_rows.append('    { %u, %u },' % (number, strings.add(enterprises[number])))
+
+    with open(out_path, 'w', encoding='ascii', newline='\n') as out:
+        out.write('''\
+/*
+ * Do not modify this file. Changes will be overwritten.
+ *
+ * Generated automatically from %s, %s,
+ * %s and %s
+ * by tools/make-addr-resolv-data.py.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "addr_resolv_data.h"
+
+''' % tuple(os.path.basename(path) for path in sys.argv[1:5]))
+
+        out.write('const char addr_resolv_data_strings[][ADDR_RESOLV_DATA_CHUNK_SIZE] = {\n')
+        for chunk in strings.chunks:
+            out.write('    ' + '\n    '.join(c_string(s) for s in chunk) + ',\n')
+        out.write('};\n\n')
+
+        def write_table(ctype, name, rows):
+            out.write('const %s addr_resolv_data_%s[] = {\n' % (ctype, name))
+            out.write('\n'.join(rows) + '\n')
+            if not rows:
+                out.write('    { 0 }\n')
+            out.write('};\n')
+            out.write('const guint addr_resolv_data_%s_count = %u;\n\n' % (name, len(rows)))
+
+        write_table('addr_resolv_data_manuf_t', 'manuf', manuf_rows)
+        write_table('addr_resolv_data_ether_t', 'wka', wka_rows)
+        write_table('addr_resolv_data_ether_t', 'ethers', ethers_rows)
+        write_table('addr_resolv_data_service_t', 'services', services_rows)
+        write_table('addr_resolv_data_enterprise_t', 'enterprises', enterprises_rows)
+
+
+if __name__ == '__main__':
+    main()
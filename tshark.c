@@ -30,6 +30,8 @@
 
 #ifndef _WIN32
 #include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #endif
 
 #include <glib.h>
@@ -50,6 +52,8 @@
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 #include <wsutil/strtoi.h>
+#include <wsutil/tempfile.h>
+#include <wsutil/perf_stats.h>
 #include <cli_main.h>
 #include <ui/version_info.h>
 #include <wiretap/wtap_opttypes.h>
@@ -61,11 +65,14 @@
 #include <epan/wslua/init_wslua.h>
 #endif
 #include "frame_tvbuff.h"
+#include <epan/conversation.h>
 #include <epan/disabled_protos.h>
+#include <epan/dissector_profile.h>
 #include <epan/prefs.h>
 #include <epan/column.h>
 #include <epan/decode_as.h>
 #include <epan/print.h>
+#include <epan/reassemble.h>
 #include <epan/addr_resolv.h>
 #ifdef HAVE_LIBPCAP
 #include "ui/capture_ui_utils.h"
@@ -81,6 +88,7 @@
 #include "ui/dissect_opts.h"
 #include "ui/ssl_key_export.h"
 #include "ui/failure_message.h"
+#include "ui/flow_shard.h"
 #if defined(HAVE_LIBSMI)
 #include "epan/oids.h"
 #endif
@@ -138,6 +146,19 @@
 #define LONGOPT_CAPTURE_COMMENT         LONGOPT_BASE_APPLICATION+6
 #define LONGOPT_HEXDUMP                 LONGOPT_BASE_APPLICATION+7
 #define LONGOPT_SELECTED_FRAME          LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_DISSECT_WORKERS         LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_FLOW_SHARDS             LONGOPT_BASE_APPLICATION+10
+#define LONGOPT_FLOW_SHARD_SERIAL_PORTS LONGOPT_BASE_APPLICATION+11
+#define LONGOPT_DISSECTOR_PROFILE       LONGOPT_BASE_APPLICATION+12
+#define LONGOPT_EXPIRE_IDLE             LONGOPT_BASE_APPLICATION+13
+#define LONGOPT_MAX_CONVERSATIONS       LONGOPT_BASE_APPLICATION+14
+#define LONGOPT_PREFILTER               LONGOPT_BASE_APPLICATION+15
+#define LONGOPT_READ_AHEAD              LONGOPT_BASE_APPLICATION+16
+#define LONGOPT_STATS_INTERVAL          LONGOPT_BASE_APPLICATION+17
+#define LONGOPT_STATS_INTERVAL_RESET    LONGOPT_BASE_APPLICATION+18
+#define LONGOPT_SLOW_PACKETS            LONGOPT_BASE_APPLICATION+19
+#define LONGOPT_PACKET_TIME_BUDGET      LONGOPT_BASE_APPLICATION+20
+#define LONGOPT_PERF_STATS              LONGOPT_BASE_APPLICATION+21
 
 capture_file cfile;
 
@@ -147,8 +168,54 @@ static frame_data prev_dis_frame;
 static frame_data prev_cap_frame;
 
 static gboolean perform_two_pass_analysis;
+static guint dissect_workers = 1;   /* processes to do the second pass in */
+#define MAX_DISSECT_WORKERS 64
+static guint flow_shards = 1;       /* processes to split the conversations between */
+static range_t *flow_shard_serial_ports;    /* ports whose packets all go in shard 0 */
+static int flow_shard = -1;         /* in a flow shard worker, which one we are */
 static guint32 epan_auto_reset_count = 0;
 static gboolean epan_auto_reset = FALSE;
+static gboolean prefilter_packets = FALSE;  /* skip dissecting packets whose bytes can't match -Y */
+static gboolean use_read_ahead = FALSE;     /* read the file on a separate thread */
+
+/*
+ * Expiry of idle conversations and reassemblies.  To turn the idle time
+ * into a frame number, we remember the first frame seen in each second
+ * of packet time, for as many seconds back as the idle time.
+ */
+static guint expire_idle_secs = 0;
+static guint max_conversations = 0;
+typedef struct {
+    time_t  secs;
+    guint32 framenum;
+} expiry_sample_t;
+static expiry_sample_t *expiry_samples;
+static guint expiry_samples_first, expiry_samples_count;
+
+/*
+ * Printing the taps' statistics every stats_interval seconds while
+ * packets are processed, as well as at the end.
+ */
+static guint stats_interval = 0;
+static gboolean stats_interval_reset = FALSE;   /* start the taps over after each */
+static gint64 stats_next_snapshot;              /* monotonic time of the next one */
+
+/*
+ * The packets that took longest to dissect, for --slow-packets; there
+ * are up to slow_packets_max of them, slowest first.
+ */
+typedef struct {
+    guint32     framenum;
+    gint64      elapsed_us;
+    guint       tree_items;
+    gchar      *protocols;
+} slow_packet_t;
+static guint slow_packets_max = 0;
+static guint slow_packets_count;
+static slow_packet_t *slow_packets;
+static guint packet_time_budget_ms = 0;
+
+static gboolean print_perf_stats = FALSE;       /* print the perf_stats when done */
 
 static guint32 selected_frame_number = 0;
 
@@ -162,7 +229,8 @@ typedef enum {
     WRITE_FIELDS,   /* User defined list of fields */
     WRITE_JSON,     /* JSON */
     WRITE_JSON_RAW, /* JSON only raw hex */
-    WRITE_EK        /* JSON bulk insert to Elasticsearch */
+    WRITE_EK,       /* JSON bulk insert to Elasticsearch */
+    WRITE_ARROW     /* User defined list of fields as an Arrow IPC stream */
         /* Add CSV and the like here */
 } output_action_e;
 
@@ -193,6 +261,7 @@ static gboolean no_duplicate_keys = FALSE;
 static proto_node_children_grouper_func node_children_grouper = proto_node_group_children_by_unique;
 
 static json_dumper jdumper;
+static arrow_writer *arrow_output;
 
 /* The line separator used between packets, changeable via the -S option */
 static const char *separator = "";
@@ -400,6 +469,37 @@ print_usage(FILE *output)
     fprintf(output, "\n");
     fprintf(output, "Processing:\n");
     fprintf(output, "  -2                       perform a two-pass analysis\n");
+    fprintf(output, "  --dissect-workers <count>\n");
+    fprintf(output, "                           do the second pass in <count> processes\n");
+    fprintf(output, "                           (requires -2)\n");
+    fprintf(output, "  --flow-shards <count>    split the conversations between <count> processes\n");
+    fprintf(output, "  --flow-shard-serial-ports <port range>\n");
+    fprintf(output, "                           with --flow-shards, keep packets on these ports\n");
+    fprintf(output, "                           together in one process\n");
+    fprintf(output, "  --dissector-profile      print how many calls, how much time and how much\n");
+    fprintf(output, "                           memory each protocol's dissectors took\n");
+    fprintf(output, "  --expire-idle <seconds>  forget conversations and reassemblies that have\n");
+    fprintf(output, "                           been idle for <seconds> of packet time\n");
+    fprintf(output, "  --max-conversations <count>\n");
+    fprintf(output, "                           forget the least recently used conversations\n");
+    fprintf(output, "                           beyond <count>\n");
+    fprintf(output, "  --prefilter              don't dissect packets that the display filter's\n");
+    fprintf(output, "                           'frame contains' tests show can't match\n");
+    fprintf(output, "  --read-ahead             read the capture file on a separate thread while\n");
+    fprintf(output, "                           packets are dissected\n");
+    fprintf(output, "  --stats-interval <seconds>\n");
+    fprintf(output, "                           print the -z statistics every <seconds>, as well\n");
+    fprintf(output, "                           as at the end\n");
+    fprintf(output, "  --stats-interval-reset   with --stats-interval, start the statistics over\n");
+    fprintf(output, "                           after printing them\n");
+    fprintf(output, "  --slow-packets <count>   list the <count> packets that took longest to\n");
+    fprintf(output, "                           dissect\n");
+    fprintf(output, "  --packet-time-budget <ms>\n");
+    fprintf(output, "                           stop dissecting a packet that has taken longer\n");
+    fprintf(output, "                           than <ms> milliseconds\n");
+    fprintf(output, "  --perf-stats             print how much was read, how long dissecting,\n");
+    fprintf(output, "                           filtering, tapping and output took, and how big\n");
+    fprintf(output, "                           the memory pools and tables got\n");
     fprintf(output, "  -M <packet count>        perform session auto reset\n");
     fprintf(output, "  -R <read filter>, --read-filter <read filter>\n");
     fprintf(output, "                           packet Read filter in Wireshark display filter syntax\n");
@@ -446,15 +546,15 @@ print_usage(FILE *output)
     fprintf(output, "     delimit               delimit ASCII dump text with '|' characters\n");
     fprintf(output, "     noascii               exclude ASCII dump text\n");
     fprintf(output, "     help                  display help for --hexdump and exit\n");
-    fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|?\n");
+    fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|arrow|?\n");
     fprintf(output, "                           format of text output (def: text)\n");
     fprintf(output, "  -j <protocolfilter>      protocols layers filter if -T ek|pdml|json selected\n");
     fprintf(output, "                           (e.g. \"ip ip.flags text\", filter does not expand child\n");
     fprintf(output, "                           nodes, unless child is specified also in the filter)\n");
     fprintf(output, "  -J <protocolfilter>      top level protocol filter if -T ek|pdml|json selected\n");
     fprintf(output, "                           (e.g. \"http tcp\", filter which expands all child nodes)\n");
-    fprintf(output, "  -e <field>               field to print if -Tfields selected (e.g. tcp.port,\n");
-    fprintf(output, "                           _ws.col.Info)\n");
+    fprintf(output, "  -e <field>               field to print if -Tfields or -Tarrow selected (e.g.\n");
+    fprintf(output, "                           tcp.port, _ws.col.Info)\n");
     fprintf(output, "                           this option can be repeated to print multiple fields\n");
     fprintf(output, "  -E<fieldsoption>=<value> set options for output when -Tfields selected:\n");
     fprintf(output, "     bom=y|n               print a UTF-8 BOM\n");
@@ -492,6 +592,7 @@ print_usage(FILE *output)
     fprintf(output, "                           specified protocols within the mapping file\n");
     fprintf(output, "  --temp-dir <directory>   write temporary files to this directory\n");
     fprintf(output, "                           (default: %s)\n", g_get_tmp_dir());
+    fprintf(output, "  --live-shm               also pass live capture data via shared memory\n");
     fprintf(output, "\n");
 
     ws_log_print_usage(output);
@@ -591,6 +692,181 @@ print_current_user(void)
     }
 }
 
+static void
+print_dissector_profile(void)
+{
+    GArray *entries;
+    dissector_profile_entry_t *entry;
+    gchar *name;
+    guint i;
+
+    entries = dissector_profile_get_entries();
+    printf("==================================================================================\n");
+    printf("Dissector profile\n");
+    printf("%-32s %10s %10s %12s %12s %12s\n", "Dissector", "Calls", "Accepted",
+           "Incl. ms", "Excl. ms", "Alloc. bytes");
+    for (i = 0; i < entries->len; i++) {
+        entry = &g_array_index(entries, dissector_profile_entry_t, i);
+        if (entry->heur_short_name != NULL)
+            name = ws_strdup_printf("%s (heuristic)", entry->heur_short_name);
+        else
+            name = g_strdup(proto_get_protocol_filter_name(entry->proto_id));
+        printf("%-32s %10" PRIu64 " %10" PRIu64 " %12.3f %12.3f %12" PRIu64 "\n",
+               name, entry->calls, entry->accepted,
+               entry->inclusive_ns / 1000000.0, entry->exclusive_ns / 1000000.0,
+               entry->bytes_allocated);
+        g_free(name);
+    }
+    printf("==================================================================================\n");
+    g_array_free(entries, TRUE);
+}
+
+/*
+ * Note how long a packet took to dissect, keeping it if it's one of the
+ * slowest so far, with how big its tree is and what protocols are in it.
+ */
+static void
+note_packet_time(epan_dissect_t *edt, guint32 framenum, gint64 elapsed_us)
+{
+    slow_packet_t *slow;
+    wmem_list_frame_t *frame;
+    GString *protocols;
+    guint i;
+
+    if (slow_packets_count == slow_packets_max) {
+        slow = &slow_packets[slow_packets_count - 1];
+        if (elapsed_us <= slow->elapsed_us)
+            return;
+        /* Make way for this one. */
+        g_free(slow->protocols);
+        slow_packets_count--;
+    }
+    if (slow_packets == NULL)
+        slow_packets = g_new(slow_packet_t, slow_packets_max);
+
+    for (i = slow_packets_count; i > 0 && slow_packets[i - 1].elapsed_us < elapsed_us; i--)
+        slow_packets[i] = slow_packets[i - 1];
+    slow = &slow_packets[i];
+    slow_packets_count++;
+
+    slow->framenum = framenum;
+    slow->elapsed_us = elapsed_us;
+    slow->tree_items = edt->tree ? PTREE_DATA(edt->tree)->count : 0;
+
+    /* The protocol stack, as in frame.protocols */
+    protocols = g_string_new(NULL);
+    for (frame = wmem_list_head(edt->pi.layers); frame != NULL; frame = wmem_list_frame_next(frame)) {
+        if (protocols->len != 0)
+            g_string_append_c(protocols, ':');
+        g_string_append(protocols, proto_get_protocol_filter_name(GPOINTER_TO_UINT(wmem_list_frame_data(frame))));
+    }
+    slow->protocols = g_string_free(protocols, FALSE);
+}
+
+static void
+print_slow_packets(void)
+{
+    guint i;
+
+    printf("==================================================================================\n");
+    printf("Slowest packets\n");
+    printf("%10s %12s %10s  %s\n", "Frame", "ms", "Tree items", "Protocols");
+    for (i = 0; i < slow_packets_count; i++) {
+        slow_packet_t *slow = &slow_packets[i];
+
+        printf("%10u %12.3f %10u  %s%s\n", slow->framenum,
+               slow->elapsed_us / 1000.0, slow->tree_items, slow->protocols,
+               (packet_time_budget_ms != 0 &&
+                slow->elapsed_us > (gint64)packet_time_budget_ms * 1000) ?
+                   " (cut short)" : "");
+        g_free(slow->protocols);
+    }
+    printf("==================================================================================\n");
+    g_free(slow_packets);
+    slow_packets = NULL;
+    slow_packets_count = 0;
+}
+
+/*
+ * Print the taps' statistics so far, if it's time to, with a line saying
+ * when, and, with --stats-interval-reset, start them over.  The time is
+ * wall-clock time, so that a live capture reports at a steady rate.
+ */
+static void
+check_stats_interval(void)
+{
+    gint64      now;
+    GDateTime  *date_time;
+    gchar      *date_time_str;
+
+    if (stats_interval == 0)
+        return;
+
+    now = g_get_monotonic_time();
+    if (stats_next_snapshot == 0) {
+        stats_next_snapshot = now + (gint64)stats_interval * G_USEC_PER_SEC;
+        return;
+    }
+    if (now < stats_next_snapshot)
+        return;
+    stats_next_snapshot = now + (gint64)stats_interval * G_USEC_PER_SEC;
+
+    date_time = g_date_time_new_now_local();
+    date_time_str = g_date_time_format(date_time, "%Y-%m-%d %H:%M:%S");
+    printf("Statistics at %s, after %u packets:\n", date_time_str, cfile.count);
+    g_free(date_time_str);
+    g_date_time_unref(date_time);
+
+    draw_tap_listeners(TRUE);
+    if (stats_interval_reset)
+        reset_tap_listeners();
+    fflush(stdout);
+}
+
+#ifdef HAVE_LIBPCAP
+/* So that statistics are printed even while no packets are arriving. */
+static gboolean
+stats_interval_timeout(gpointer data _U_)
+{
+    check_stats_interval();
+    return G_SOURCE_CONTINUE;
+}
+#endif
+
+static void
+print_expiry_stats(void)
+{
+    guint64 expired_conversations, freed_proto_data;
+
+    conversation_get_expiry_stats(&expired_conversations, &freed_proto_data);
+    fprintf(stderr, "Expired %" PRIu64 " conversations (%" PRIu64 " protocol data freed) and %" PRIu64 " reassemblies\n",
+            expired_conversations, freed_proto_data, reassembly_tables_get_expired_count());
+}
+
+/*
+ * Print the performance counters and gauges, to the standard error so
+ * that they don't get mixed up with the packets.
+ */
+static void
+print_perf_stats_table(void)
+{
+    GArray *stats;
+    guint i;
+
+    stats = ws_perf_get_stats();
+    fprintf(stderr, "==================================================================================\n");
+    fprintf(stderr, "Performance statistics\n");
+    for (i = 0; i < stats->len; i++) {
+        ws_perf_stat_t *stat = &g_array_index(stats, ws_perf_stat_t, i);
+        gchar *value = ws_perf_stat_value_to_str(stat);
+
+        fprintf(stderr, "%-32s %-34s %14s\n", stat->name, stat->description, value);
+        g_free(value);
+    }
+    fprintf(stderr, "==================================================================================\n");
+    g_array_free(stats, TRUE);
+}
+
 static void
 gather_tshark_compile_info(feature_list l)
 {
@@ -788,6 +1064,19 @@ main(int argc, char *argv[])
         {"capture-comment", ws_required_argument, NULL, LONGOPT_CAPTURE_COMMENT},
         {"hexdump", ws_required_argument, NULL, LONGOPT_HEXDUMP},
         {"selected-frame", ws_required_argument, NULL, LONGOPT_SELECTED_FRAME},
+        {"dissect-workers", ws_required_argument, NULL, LONGOPT_DISSECT_WORKERS},
+        {"flow-shards", ws_required_argument, NULL, LONGOPT_FLOW_SHARDS},
+        {"flow-shard-serial-ports", ws_required_argument, NULL, LONGOPT_FLOW_SHARD_SERIAL_PORTS},
+        {"dissector-profile", ws_no_argument, NULL, LONGOPT_DISSECTOR_PROFILE},
+        {"expire-idle", ws_required_argument, NULL, LONGOPT_EXPIRE_IDLE},
+        {"max-conversations", ws_required_argument, NULL, LONGOPT_MAX_CONVERSATIONS},
+        {"prefilter", ws_no_argument, NULL, LONGOPT_PREFILTER},
+        {"read-ahead", ws_no_argument, NULL, LONGOPT_READ_AHEAD},
+        {"stats-interval", ws_required_argument, NULL, LONGOPT_STATS_INTERVAL},
+        {"stats-interval-reset", ws_no_argument, NULL, LONGOPT_STATS_INTERVAL_RESET},
+        {"slow-packets", ws_required_argument, NULL, LONGOPT_SLOW_PACKETS},
+        {"packet-time-budget", ws_required_argument, NULL, LONGOPT_PACKET_TIME_BUDGET},
+        {"perf-stats", ws_no_argument, NULL, LONGOPT_PERF_STATS},
         {0, 0, 0, 0}
     };
     gboolean             arg_error = FALSE;
@@ -1207,6 +1496,7 @@ main(int argc, char *argv[])
 #endif
             case LONGOPT_COMPRESS_TYPE:        /* compress type */
             case LONGOPT_CAPTURE_TMPDIR:       /* capture temp directory */
+            case LONGOPT_LIVE_SHM:             /* live capture in shared memory */
                 /* These are options only for packet capture. */
 #ifdef HAVE_LIBPCAP
                 exit_status = capture_opts_add_opt(&global_capture_opts, opt, ws_optarg);
@@ -1451,6 +1741,10 @@ main(int argc, char *argv[])
                     output_action = WRITE_FIELDS;
                     print_details = TRUE;   /* Need full tree info */
                     print_summary = FALSE;  /* Don't allow summary */
+                } else if (strcmp(ws_optarg, "arrow") == 0) {
+                    output_action = WRITE_ARROW;
+                    print_details = TRUE;   /* Need full tree info */
+                    print_summary = FALSE;  /* Don't allow summary */
                 } else if (strcmp(ws_optarg, "json") == 0) {
                     output_action = WRITE_JSON;
                     print_details = TRUE;   /* Need details */
@@ -1468,6 +1762,8 @@ main(int argc, char *argv[])
                     cmdarg_err("Invalid -T parameter \"%s\"; it must be one of:", ws_optarg);                   /* x */
                     cmdarg_err_cont("\t\"fields\"  The values of fields specified with the -e option, in a form\n"
                             "\t          specified by the -E option.\n"
+                            "\t\"arrow\"   The values of fields specified with the -e option, as typed\n"
+                            "\t          columns in an Apache Arrow IPC stream.\n"
                             "\t\"pdml\"    Packet Details Markup Language, an XML-based format for the\n"
                             "\t          details of a decoded packet. This information is equivalent to\n"
                             "\t          the packet details printed with the -V flag.\n"
@@ -1627,6 +1923,64 @@ main(int argc, char *argv[])
                     goto clean_exit;
                 }
             break;
+            case LONGOPT_DISSECT_WORKERS:
+                dissect_workers = get_positive_int(ws_optarg, "number of dissection workers");
+                if (dissect_workers > MAX_DISSECT_WORKERS) {
+                    cmdarg_err("There can be at most %d dissection workers.",
+                            MAX_DISSECT_WORKERS);
+                    exit_status = INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
+            case LONGOPT_FLOW_SHARDS:
+                flow_shards = get_positive_int(ws_optarg, "number of flow shards");
+                if (flow_shards > MAX_DISSECT_WORKERS) {
+                    cmdarg_err("There can be at most %d flow shards.",
+                            MAX_DISSECT_WORKERS);
+                    exit_status = INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
+            case LONGOPT_DISSECTOR_PROFILE:
+                dissector_profile_set_enabled(TRUE);
+                break;
+            case LONGOPT_EXPIRE_IDLE:
+                expire_idle_secs = get_positive_int(ws_optarg, "idle time");
+                break;
+            case LONGOPT_MAX_CONVERSATIONS:
+                max_conversations = get_positive_int(ws_optarg, "number of conversations");
+                break;
+            case LONGOPT_PREFILTER:
+                prefilter_packets = TRUE;
+                break;
+            case LONGOPT_READ_AHEAD:
+                use_read_ahead = TRUE;
+                break;
+            case LONGOPT_STATS_INTERVAL:
+                stats_interval = get_positive_int(ws_optarg, "statistics interval");
+                break;
+            case LONGOPT_STATS_INTERVAL_RESET:
+                stats_interval_reset = TRUE;
+                break;
+            case LONGOPT_SLOW_PACKETS:
+                slow_packets_max = get_positive_int(ws_optarg, "number of slow packets");
+                break;
+            case LONGOPT_PACKET_TIME_BUDGET:
+                packet_time_budget_ms = get_positive_int(ws_optarg, "packet time budget");
+                set_dissection_time_budget((guint64)packet_time_budget_ms * 1000);
+                break;
+            case LONGOPT_PERF_STATS:
+                print_perf_stats = TRUE;
+                break;
+            case LONGOPT_FLOW_SHARD_SERIAL_PORTS:
+                wmem_free(NULL, flow_shard_serial_ports);
+                if (range_convert_str(NULL, &flow_shard_serial_ports, ws_optarg,
+                            G_MAXUINT16) != CVT_NO_ERROR) {
+                    cmdarg_err("\"%s\" isn't a valid port range.", ws_optarg);
+                    exit_status = INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
             default:
             case '?':        /* Bad flag - print usage message */
                 switch(ws_optopt) {
@@ -1666,14 +2020,14 @@ main(int argc, char *argv[])
     }
 
     /* If we specified output fields, but not the output field type... */
-    if ((WRITE_FIELDS != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
+    if ((WRITE_FIELDS != output_action && WRITE_ARROW != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
         cmdarg_err("Output fields were specified with \"-e\", "
-                "but \"-Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
+                "but \"-Tarrow, -Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
         exit_status = INVALID_OPTION;
         goto clean_exit;
-    } else if (WRITE_FIELDS == output_action && 0 == output_fields_num_fields(output_fields)) {
-        cmdarg_err("\"-Tfields\" was specified, but no fields were "
-                "specified with \"-e\".");
+    } else if ((WRITE_FIELDS == output_action || WRITE_ARROW == output_action) && 0 == output_fields_num_fields(output_fields)) {
+        cmdarg_err("\"-T%s\" was specified, but no fields were "
+                "specified with \"-e\".", WRITE_ARROW == output_action ? "arrow" : "fields");
 
         exit_status = INVALID_OPTION;
         goto clean_exit;
@@ -1792,6 +2146,63 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    if (dissect_workers > 1) {
+#ifdef _WIN32
+        cmdarg_err("--dissect-workers isn't supported on Windows.");
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+#else
+        if (!perform_two_pass_analysis) {
+            cmdarg_err("--dissect-workers requires -2.");
+            exit_status = INVALID_OPTION;
+            goto clean_exit;
+        }
+#endif
+    }
+
+    if (prefilter_packets && perform_two_pass_analysis) {
+        cmdarg_err("--prefilter can't be used with -2.");
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+    }
+
+    if (use_read_ahead && perform_two_pass_analysis) {
+        cmdarg_err("--read-ahead can't be used with -2.");
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+    }
+
+    if (stats_interval != 0 && perform_two_pass_analysis) {
+        cmdarg_err("--stats-interval can't be used with -2.");
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+    }
+
+    if (expire_idle_secs != 0 || max_conversations != 0) {
+        if (perform_two_pass_analysis) {
+            cmdarg_err("--expire-idle and --max-conversations can't be used with -2.");
+            exit_status = INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (expire_idle_secs != 0)
+            expiry_samples = g_new(expiry_sample_t, expire_idle_secs + 1);
+        conversation_set_expiry(TRUE, max_conversations);
+    }
+
+    if (flow_shards > 1) {
+#ifdef _WIN32
+        cmdarg_err("--flow-shards isn't supported on Windows.");
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+#else
+        if (dissect_workers > 1) {
+            cmdarg_err("--flow-shards and --dissect-workers can't be used together.");
+            exit_status = INVALID_OPTION;
+            goto clean_exit;
+        }
+#endif
+    }
+
 #ifdef HAVE_LIBPCAP
     if (caps_queries) {
         /* We're supposed to list the link-layer/timestamp types for an interface;
@@ -2465,6 +2876,18 @@ main(int argc, char *argv[])
     if (draw_taps)
         draw_tap_listeners(TRUE);
 
+    if (draw_taps && dissector_profile_is_enabled())
+        print_dissector_profile();
+
+    if (draw_taps && slow_packets_max != 0)
+        print_slow_packets();
+
+    if (expire_idle_secs != 0 || max_conversations != 0)
+        print_expiry_stats();
+
+    if (print_perf_stats)
+        print_perf_stats_table();
+
     if (tls_session_keys_file) {
         gsize keylist_length;
         gchar *keylist = ssl_export_sessions(&keylist_length);
@@ -2481,6 +2904,7 @@ main(int argc, char *argv[])
 
     output_fields_free(output_fields);
     output_fields = NULL;
+    g_free(expiry_samples);
 
 clean_exit:
     cf_close(&cfile);
@@ -2496,6 +2920,8 @@ clean_exit:
     free_progdirs();
     dfilter_free(dfcode);
     g_free(dfilter);
+    wmem_free(NULL, flow_shard_serial_ports);
+    flow_shard_cleanup();
     return exit_status;
 }
 
@@ -2617,6 +3043,11 @@ capture(void)
      */
     set_resolution_synchrony(TRUE);
 
+    if (stats_interval != 0) {
+        check_stats_interval();
+        g_timeout_add_seconds(1, stats_interval_timeout, NULL);
+    }
+
     /* the actual capture loop */
     ctx = g_main_context_default();
     loop_running = TRUE;
@@ -2732,6 +3163,7 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
         /* Attempt to open the capture file and set up to read from it. */
         switch(cf_open(cap_session->cf, capture_opts->save_file, WTAP_TYPE_AUTO, is_tempfile, &err)) {
             case CF_OK:
+                sync_pipe_attach_live_ring(cap_session);
                 break;
             case CF_ERROR:
                 /* Don't unlink (delete) the save file - leave it around,
@@ -3132,108 +3564,850 @@ typedef enum {
     PASS_INTERRUPTED
 } pass_status_t;
 
-static pass_status_t
-process_cap_file_first_pass(capture_file *cf, int max_packet_count,
-        gint64 max_byte_count, int *err, gchar **err_info)
-{
-    wtap_rec        rec;
-    Buffer          buf;
-    epan_dissect_t *edt = NULL;
-    gint64          data_offset;
-    pass_status_t   status = PASS_SUCCEEDED;
-    int             framenum = 0;
-
-    wtap_rec_init(&rec);
-    ws_buffer_init(&buf, 1514);
-
-    /* Allocate a frame_data_sequence for all the frames. */
-    cf->provider.frames = new_frame_data_sequence();
-
-    if (do_dissection) {
-        gboolean create_proto_tree;
-
-        /*
-         * Determine whether we need to create a protocol tree.
-         * We do if:
-         *
-         *    we're going to apply a read filter;
-         *
-         *    we're going to apply a display filter;
-         *
-         *    a postdissector wants field values or protocols
-         *    on the first pass.
-         */
-        create_proto_tree =
-            (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids() || dissect_color);
-
-        ws_debug("tshark: create_proto_tree = %s", create_proto_tree ? "TRUE" : "FALSE");
+#ifndef _WIN32
+/*
+ * Dissecting in worker processes.
+ *
+ * Dissection isn't thread-safe; dissectors, and the conversation,
+ * reassembly and other tables they use, live in global state that
+ * assumes one packet is dissected at a time.  We can, however, fork
+ * worker processes, each with its own copy of that state, and have
+ * each of them dissect and print some of the frames:
+ *
+ *    with --dissect-workers, once the first pass has built all the
+ *    per-frame state, frames can be dissected again in any order, just
+ *    as they are when clicking around Wireshark's packet list, so each
+ *    worker does every n'th block of frames in the second pass;
+ *
+ *    with --flow-shards, each worker does everything for the frames
+ *    of the conversations that hash to it, as if they were the only
+ *    frames in the file.
+ *
+ * Each worker writes its output to its own (unlinked) temporary file
+ * and sends us, over a pipe, messages saying where in that file the
+ * output for each frame, or block of frames, is.  Each worker's
+ * messages are in frame order, so we merge them, copying the output to
+ * the standard output in frame order, and acknowledge each message, so
+ * that the workers don't get too far ahead of us, and can reuse their
+ * files' space.
+ */
+#define WORKER_MSG_BATCH    64      /* messages a worker sends at once */
+#define WORKER_MSG_LAG      256     /* frames after which it sends them anyway */
+#define WORKER_MAX_AHEAD    512     /* messages a worker can have unacknowledged */
+#define WORKER_REWIND_SIZE  (G_GINT64_CONSTANT(64)*1024*1024) /* reuse the file at this size */
 
-        /* We're not going to display the protocol tree on this pass,
-           so it's not going to be "visible". */
-        edt = epan_dissect_new(cf->epan, create_proto_tree, FALSE);
-    }
+typedef enum {
+    WORKER_MSG_OUTPUT,      /* output for the frame(s) starting at framenum */
+    WORKER_MSG_PROGRESS,    /* no more output for frames before framenum */
+    WORKER_MSG_DONE         /* finished, or stopped at framenum; a worker_status_t follows */
+} worker_msg_type_e;
+
+typedef struct {
+    guint32  type;          /* a worker_msg_type_e */
+    guint32  framenum;
+    gint64   start;         /* offset of the output in the worker's file */
+    gint64   end;           /* offset just past it */
+} worker_msg_t;
+
+/* How a worker's passes went; the err_info strings, if any, follow it. */
+typedef struct {
+    int      first_pass_status;
+    int      first_pass_err;
+    guint32  first_pass_err_info_len;
+    int      status;
+    int      err;
+    guint32  err_info_len;
+    guint32  err_framenum;
+} worker_status_t;
+
+typedef struct {
+    pid_t        pid;
+    int          out_fd;    /* the worker's output file */
+    int          msg_fd;    /* pipe on which the worker sends us worker_msg_ts */
+    int          ack_fd;    /* pipe on which we acknowledge them */
+    worker_msg_t msg;       /* its next message, if have_msg is set */
+    gboolean     have_msg;
+    gboolean     done;      /* set once we've had its WORKER_MSG_DONE */
+    gboolean     lost;      /* set if it went away without one */
+    guint        pending_acks;
+} dissect_worker_t;
 
-    ws_debug("tshark: reading records for first pass");
-    *err = 0;
-    while (wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
-        if (read_interrupted) {
-            status = PASS_INTERRUPTED;
-            break;
+typedef enum {
+    WORKERS_FINISHED,       /* they all got to the end */
+    WORKERS_STOPPED,        /* one of them, or we, stopped early */
+    WORKERS_FAILED          /* we lost one of them */
+} workers_result_t;
+
+#define WORKERS_NOT_STARTED (-2)
+#define WORKERS_STARTED     (-1)
+
+/* In a worker, our ends of the pipes to the parent, and what's on them. */
+static int          worker_msg_fd = -1;
+static int          worker_ack_fd = -1;
+static worker_msg_t worker_msgs[WORKER_MSG_BATCH];
+static guint        worker_n_msgs;
+static guint        worker_unacked;
+static guint32      worker_last_framenum;   /* of the last message */
+static guint32      worker_last_seen;       /* the last frame we got through */
+static gint64       worker_output_start;
+
+/* Write all of a buffer to a file descriptor. */
+static gboolean
+worker_write(int fd, const void *data, size_t len)
+{
+    const char *p = (const char *)data;
+    ssize_t     n;
+
+    while (len != 0) {
+        n = ws_write(fd, p, len);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
         }
-        framenum++;
+        p += n;
+        len -= n;
+    }
+    return TRUE;
+}
 
-        if (process_packet_first_pass(cf, edt, data_offset, &rec, &buf)) {
-            /* Stop reading if we hit a stop condition */
-            if (max_packet_count > 0 && framenum >= max_packet_count) {
-                ws_debug("tshark: max_packet_count (%d) reached", max_packet_count);
-                *err = 0; /* This is not an error */
-                break;
-            }
-            if (max_byte_count != 0 && data_offset >= max_byte_count) {
-                ws_debug("tshark: max_byte_count (%" PRId64 "/%" PRId64 ") reached",
-                        data_offset, max_byte_count);
-                *err = 0; /* This is not an error */
-                break;
-            }
+/*
+ * Read all of a buffer from a file descriptor; returns FALSE on EOF or
+ * an error, including being interrupted if read_interrupted got set.
+ */
+static gboolean
+worker_read(int fd, void *data, size_t len)
+{
+    char    *p = (char *)data;
+    ssize_t  n;
+
+    while (len != 0) {
+        n = ws_read(fd, p, len);
+        if (n == -1) {
+            if (errno == EINTR && !read_interrupted)
+                continue;
+            return FALSE;
         }
-        wtap_rec_reset(&rec);
+        if (n == 0)
+            return FALSE;
+        p += n;
+        len -= n;
     }
-    if (*err != 0)
-        status = PASS_READ_ERROR;
+    return TRUE;
+}
 
-    if (edt)
-        epan_dissect_free(edt);
+/* In a worker, send the parent the messages we've batched up. */
+static void
+worker_send_msgs(void)
+{
+    if (worker_n_msgs == 0)
+        return;
 
-    /* Close the sequential I/O side, to free up memory it requires. */
-    wtap_sequential_close(cf->provider.wth);
+    /* The output they describe has to be in the file first. */
+    fflush(stdout);
+    if (ferror(stdout)) {
+        show_print_file_io_error();
+        _exit(2);
+    }
+    if (!worker_write(worker_msg_fd, worker_msgs,
+                worker_n_msgs * sizeof worker_msgs[0]))
+        _exit(0);   /* the parent has given up on us */
+    worker_unacked += worker_n_msgs;
+    worker_n_msgs = 0;
+}
 
-    /* Allow the protocol dissectors to free up memory that they
-     * don't need after the sequential run-through of the packets. */
-    postseq_cleanup_all_protocols();
+/*
+ * In a worker, wait until the parent has acknowledged all but
+ * max_unacked of our messages.
+ */
+static void
+worker_wait_for_acks(guint max_unacked)
+{
+    guint8  acks[WORKER_MSG_BATCH];
+    ssize_t n;
 
-    cf->provider.prev_dis = NULL;
-    cf->provider.prev_cap = NULL;
+    worker_send_msgs();
+    while (worker_unacked > max_unacked) {
+        n = ws_read(worker_ack_fd, acks, sizeof acks);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            _exit(0);   /* the parent has given up on us */
+        worker_unacked -= (guint)n;
+    }
+}
 
-    ws_buffer_free(&buf);
-    wtap_rec_cleanup(&rec);
+static worker_msg_t *
+worker_queue_msg(worker_msg_type_e type, guint32 framenum)
+{
+    worker_msg_t *msg;
+
+    if (worker_n_msgs == WORKER_MSG_BATCH)
+        worker_send_msgs();
+    if (worker_unacked + worker_n_msgs >= WORKER_MAX_AHEAD)
+        worker_wait_for_acks(WORKER_MAX_AHEAD / 2);
+    msg = &worker_msgs[worker_n_msgs++];
+    msg->type = type;
+    msg->framenum = framenum;
+    msg->start = 0;
+    msg->end = 0;
+    worker_last_framenum = framenum;
+    return msg;
+}
 
-    return status;
+/* In a worker, start the output for a frame, or a block of frames. */
+static void
+worker_output_begin(void)
+{
+    if (ftello(stdout) >= WORKER_REWIND_SIZE) {
+        /*
+         * Our file has gotten big; once all of it has been copied,
+         * start over.
+         */
+        worker_wait_for_acks(0);
+        if (ftruncate(fileno(stdout), 0) == -1 ||
+                fseeko(stdout, 0, SEEK_SET) == -1) {
+            show_print_file_io_error();
+            _exit(2);
+        }
+    }
+    worker_output_start = ftello(stdout);
 }
 
-static gboolean
-process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
-        frame_data *fdata, wtap_rec *rec,
-        Buffer *buf, guint tap_flags)
+/*
+ * In a worker, finish the output for the frame, or block of frames,
+ * starting at framenum.
+ */
+static void
+worker_output_end(guint32 framenum)
 {
-    column_info    *cinfo;
-    gboolean        passed;
+    worker_msg_t *msg;
 
-    /* If we're not running a display filter and we're not printing any
-       packet information, we don't need to do a dissection. This means
-       that all packets can be marked as 'passed'. */
-    passed = TRUE;
+    msg = worker_queue_msg(WORKER_MSG_OUTPUT, framenum);
+    msg->start = worker_output_start;
+    msg->end = ftello(stdout);
+}
 
-    /* If we're going to print packet information, or we're going to
+/*
+ * In a worker, note that we've got through a frame, whether we printed
+ * it or not.  The parent can't copy anybody's output past the frame of
+ * our next message, so don't sit on messages, or go quiet, for too long.
+ */
+static void
+worker_frame_done(guint32 framenum)
+{
+    worker_last_seen = framenum;
+    if (worker_n_msgs == 0) {
+        if (framenum - worker_last_framenum >= WORKER_MSG_LAG) {
+            worker_queue_msg(WORKER_MSG_PROGRESS, framenum + 1);
+            worker_send_msgs();
+        }
+    } else if (framenum - worker_msgs[0].framenum >= WORKER_MSG_LAG) {
+        worker_send_msgs();
+    }
+}
+
+/*
+ * In a worker, tell the parent how we got on, and quit.  If we didn't
+ * get to the end, the parent stops copying output at the frame after
+ * the last one we got through.
+ */
+static void G_GNUC_NORETURN
+worker_done(worker_status_t *status, const gchar *first_pass_err_info,
+        const gchar *err_info)
+{
+    worker_msg_t *msg;
+
+    msg = worker_queue_msg(WORKER_MSG_DONE, G_MAXUINT32);
+    if (status->first_pass_status == PASS_INTERRUPTED ||
+            status->status != PASS_SUCCEEDED)
+        msg->framenum = worker_last_seen + 1;
+    worker_send_msgs();
+
+    status->first_pass_err_info_len =
+        first_pass_err_info != NULL ? (guint32)strlen(first_pass_err_info) : 0;
+    status->err_info_len = err_info != NULL ? (guint32)strlen(err_info) : 0;
+    if (worker_write(worker_msg_fd, status, sizeof *status) &&
+            worker_write(worker_msg_fd, first_pass_err_info,
+                status->first_pass_err_info_len))
+        worker_write(worker_msg_fd, err_info, status->err_info_len);
+    _exit(0);
+}
+
+/*
+ * Fork n_workers worker processes, with their standard output going to
+ * temporary files.  Returns, in each worker, its index; in the parent,
+ * WORKERS_STARTED, or, if they couldn't all be started, in which case
+ * none are left running, WORKERS_NOT_STARTED.
+ */
+static int
+start_dissect_workers(dissect_worker_t *workers, guint n_workers)
+{
+    guint               n_started, i;
+    dissect_worker_t   *w;
+    const char         *tmpdir = NULL;
+    gchar              *tmpname;
+    GError             *gerr = NULL;
+    int                 msg_pipe[2], ack_pipe[2];
+
+#ifdef HAVE_LIBPCAP
+    tmpdir = global_capture_opts.temp_dir;
+#endif
+
+    /* Anything we've buffered should be written once, by us. */
+    fflush(stdout);
+
+    for (n_started = 0; n_started < n_workers; n_started++) {
+        w = &workers[n_started];
+        memset(w, 0, sizeof *w);
+        w->out_fd = create_tempfile(tmpdir, &tmpname, "tshark_worker", NULL, &gerr);
+        if (w->out_fd == -1) {
+            ws_warning("Not using worker processes: %s", gerr->message);
+            g_error_free(gerr);
+            break;
+        }
+        ws_unlink(tmpname);
+        g_free(tmpname);
+        if (pipe(msg_pipe) == -1) {
+            ws_warning("Not using worker processes: %s", g_strerror(errno));
+            ws_close(w->out_fd);
+            break;
+        }
+        if (pipe(ack_pipe) == -1) {
+            ws_warning("Not using worker processes: %s", g_strerror(errno));
+            ws_close(msg_pipe[0]);
+            ws_close(msg_pipe[1]);
+            ws_close(w->out_fd);
+            break;
+        }
+        w->pid = fork();
+        if (w->pid == 0) {
+            /* We're the worker; keep only our own ends of our pipes. */
+            for (i = 0; i < n_started; i++) {
+                ws_close(workers[i].out_fd);
+                ws_close(workers[i].msg_fd);
+                ws_close(workers[i].ack_fd);
+            }
+            ws_close(msg_pipe[0]);
+            ws_close(ack_pipe[1]);
+            worker_msg_fd = msg_pipe[1];
+            worker_ack_fd = ack_pipe[0];
+            dup2(w->out_fd, 1);
+            ws_close(w->out_fd);
+            fseeko(stdout, 0, SEEK_SET);
+            /* If the parent goes away, just quit. */
+            signal(SIGPIPE, SIG_IGN);
+            return (int)n_started;
+        }
+        ws_close(msg_pipe[1]);
+        ws_close(ack_pipe[0]);
+        w->msg_fd = msg_pipe[0];
+        w->ack_fd = ack_pipe[1];
+        if (w->pid == -1) {
+            ws_warning("Not using worker processes: %s", g_strerror(errno));
+            ws_close(w->out_fd);
+            ws_close(w->msg_fd);
+            ws_close(w->ack_fd);
+            break;
+        }
+    }
+
+    if (n_started < n_workers) {
+        /* Stop the ones we started. */
+        for (i = 0; i < n_started; i++) {
+            kill(workers[i].pid, SIGKILL);
+            waitpid(workers[i].pid, NULL, 0);
+            ws_close(workers[i].out_fd);
+            ws_close(workers[i].msg_fd);
+            ws_close(workers[i].ack_fd);
+        }
+        return WORKERS_NOT_STARTED;
+    }
+    return WORKERS_STARTED;
+}
+
+/* Acknowledge the messages we've dealt with from a worker. */
+static void
+ack_worker(dissect_worker_t *w)
+{
+    static const guint8 acks[WORKER_MSG_BATCH];
+
+    if (w->pending_acks != 0) {
+        /* If it's gone away, we'll find out when we read from it. */
+        worker_write(w->ack_fd, acks, w->pending_acks);
+        w->pending_acks = 0;
+    }
+}
+
+/* Get a worker's next message, if we haven't already got it. */
+static gboolean
+get_worker_msg(dissect_worker_t *workers, guint n_workers,
+        dissect_worker_t *w)
+{
+    guint i;
+
+    if (w->have_msg)
+        return TRUE;
+
+    /*
+     * We might block; make sure nobody's waiting for us to acknowledge
+     * their messages meanwhile.
+     */
+    for (i = 0; i < n_workers; i++)
+        ack_worker(&workers[i]);
+    if (!worker_read(w->msg_fd, &w->msg, sizeof w->msg)) {
+        if (!read_interrupted)
+            w->lost = TRUE;
+        return FALSE;
+    }
+    w->have_msg = TRUE;
+    return TRUE;
+}
+
+static gboolean
+read_worker_err_info(dissect_worker_t *w, guint32 len, gchar **err_info)
+{
+    *err_info = NULL;
+    if (len == 0)
+        return TRUE;
+    *err_info = (gchar *)g_malloc(len + 1);
+    if (!worker_read(w->msg_fd, *err_info, len)) {
+        g_free(*err_info);
+        *err_info = NULL;
+        return FALSE;
+    }
+    (*err_info)[len] = '\0';
+    return TRUE;
+}
+
+/* Copy the output a worker's message describes to the standard output. */
+static gboolean
+copy_worker_output(dissect_worker_t *w)
+{
+    guint8  copybuf[65536];
+    gint64  off;
+    ssize_t n;
+
+    for (off = w->msg.start; off < w->msg.end; off += n) {
+        n = pread(w->out_fd, copybuf, (size_t)MIN(w->msg.end - off,
+                    (gint64)sizeof copybuf), off);
+        if (n <= 0) {
+            w->lost = TRUE;
+            return FALSE;
+        }
+        if (fwrite(copybuf, 1, n, stdout) != (size_t)n) {
+            show_print_file_io_error();
+            exit(2);
+        }
+    }
+    if (line_buffered)
+        fflush(stdout);
+    if (ferror(stdout)) {
+        show_print_file_io_error();
+        exit(2);
+    }
+    return TRUE;
+}
+
+static gboolean
+worker_status_ok(const worker_status_t *status)
+{
+    return status->first_pass_status == PASS_SUCCEEDED &&
+        status->status == PASS_SUCCEEDED;
+}
+
+/*
+ * Copy the workers' output to the standard output, in frame order,
+ * until they've all finished or one of them has stopped early, and get
+ * how the one that stopped, or else the first one that had a problem,
+ * got on.  *copied is set if any output was copied.
+ */
+static workers_result_t
+merge_worker_output(dissect_worker_t *workers, guint n_workers,
+        worker_status_t *status, gchar **first_pass_err_info,
+        gchar **err_info, gboolean *copied)
+{
+    dissect_worker_t   *w, *next;
+    worker_status_t     ws;
+    gchar              *ws_first_pass_err_info, *ws_err_info;
+    guint               i, n_done = 0;
+
+    memset(status, 0, sizeof *status);
+    status->first_pass_status = PASS_SUCCEEDED;
+    status->status = PASS_SUCCEEDED;
+    *first_pass_err_info = NULL;
+    *err_info = NULL;
+    *copied = FALSE;
+
+    while (n_done < n_workers) {
+        if (read_interrupted) {
+            status->status = PASS_INTERRUPTED;
+            return WORKERS_STOPPED;
+        }
+
+        /* Find the worker whose next message is for the earliest frame. */
+        next = NULL;
+        for (i = 0; i < n_workers; i++) {
+            w = &workers[i];
+            if (w->done)
+                continue;
+            if (!get_worker_msg(workers, n_workers, w)) {
+                if (w->lost)
+                    return WORKERS_FAILED;
+                status->status = PASS_INTERRUPTED;
+                return WORKERS_STOPPED;
+            }
+            if (next == NULL || w->msg.framenum < next->msg.framenum)
+                next = w;
+        }
+        w = next;
+        w->have_msg = FALSE;
+        if (++w->pending_acks == WORKER_MSG_BATCH)
+            ack_worker(w);
+
+        switch (w->msg.type) {
+
+        case WORKER_MSG_OUTPUT:
+            if (!copy_worker_output(w))
+                return WORKERS_FAILED;
+            *copied = TRUE;
+            break;
+
+        case WORKER_MSG_PROGRESS:
+            break;
+
+        case WORKER_MSG_DONE:
+            w->done = TRUE;
+            n_done++;
+            if (!worker_read(w->msg_fd, &ws, sizeof ws) ||
+                    !read_worker_err_info(w, ws.first_pass_err_info_len,
+                        &ws_first_pass_err_info)) {
+                w->lost = TRUE;
+                return WORKERS_FAILED;
+            }
+            if (!read_worker_err_info(w, ws.err_info_len, &ws_err_info)) {
+                g_free(ws_first_pass_err_info);
+                w->lost = TRUE;
+                return WORKERS_FAILED;
+            }
+            if (w->msg.framenum != G_MAXUINT32 || n_done == 1 ||
+                    (worker_status_ok(status) && !worker_status_ok(&ws))) {
+                g_free(*first_pass_err_info);
+                g_free(*err_info);
+                *status = ws;
+                *first_pass_err_info = ws_first_pass_err_info;
+                *err_info = ws_err_info;
+            } else {
+                g_free(ws_first_pass_err_info);
+                g_free(ws_err_info);
+            }
+            if (w->msg.framenum != G_MAXUINT32) {
+                /* It stopped early; nobody gets any further. */
+                return WORKERS_STOPPED;
+            }
+            break;
+
+        default:
+            w->lost = TRUE;
+            return WORKERS_FAILED;
+        }
+    }
+    return WORKERS_FINISHED;
+}
+
+/*
+ * Reap the workers, stopping any that are still going.  Returns FALSE,
+ * having reported why, if any of them failed.
+ */
+static gboolean
+stop_dissect_workers(dissect_worker_t *workers, guint n_workers)
+{
+    dissect_worker_t   *w;
+    guint               i;
+    int                 wstatus;
+    gboolean            ok = TRUE;
+
+    /* Closing the pipes tells any workers still running to stop. */
+    for (i = 0; i < n_workers; i++) {
+        w = &workers[i];
+        ws_close(w->msg_fd);
+        ws_close(w->ack_fd);
+        if (!w->done && !w->lost)
+            kill(w->pid, SIGTERM);
+    }
+    for (i = 0; i < n_workers; i++) {
+        w = &workers[i];
+        wstatus = 0;
+        while (waitpid(w->pid, &wstatus, 0) == -1 && errno == EINTR)
+            ;
+        ws_close(w->out_fd);
+        if (!w->done && !w->lost)
+            continue;   /* we stopped it */
+        if (WIFSIGNALED(wstatus)) {
+            cmdarg_err("A worker process died: %s.",
+                    g_strsignal(WTERMSIG(wstatus)));
+            ok = FALSE;
+        } else if (WIFEXITED(wstatus) && WEXITSTATUS(wstatus) != 0) {
+            /* It's already said why. */
+            ok = FALSE;
+        } else if (w->lost) {
+            cmdarg_err("A worker process stopped unexpectedly.");
+            ok = FALSE;
+        }
+    }
+    return ok;
+}
+
+/*
+ * Flow shards.
+ */
+static GByteArray *flow_shard_frames;   /* bitmap of our frames, for the second pass */
+
+static gboolean
+flow_shard_owns_record(wtap_rec *rec, Buffer *buf)
+{
+    return flow_shard_of_record(rec, ws_buffer_start_ptr(buf), flow_shards,
+            flow_shard_serial_ports) == (guint)flow_shard;
+}
+
+/* Remember, in the first pass, whether a frame is ours. */
+static void
+flow_shard_note_frame(guint32 framenum, gboolean ours)
+{
+    static const guint8 zero = 0;
+    guint idx = (framenum - 1) / 8;
+
+    if (flow_shard_frames == NULL)
+        flow_shard_frames = g_byte_array_new();
+    while (idx >= flow_shard_frames->len)
+        g_byte_array_append(flow_shard_frames, &zero, 1);
+    if (ours)
+        flow_shard_frames->data[idx] |= 1 << ((framenum - 1) % 8);
+}
+
+static gboolean
+flow_shard_frame_is_ours(guint32 framenum)
+{
+    guint idx = (framenum - 1) / 8;
+
+    return idx < flow_shard_frames->len &&
+        (flow_shard_frames->data[idx] & (1 << ((framenum - 1) % 8))) != 0;
+}
+
+/* Note, in the pass that prints, that another shard has a frame. */
+static void
+flow_shard_frame_skipped(guint32 framenum)
+{
+    /*
+     * If another shard prints the first element of a JSON array,
+     * the first one we print isn't the first.
+     */
+    if (framenum == 1 &&
+            (output_action == WRITE_JSON || output_action == WRITE_JSON_RAW))
+        json_dumper_skip_array_element(&jdumper);
+    worker_frame_done(framenum);
+}
+
+/*
+ * Do the time stamp and byte count bookkeeping for a frame another
+ * shard has that dissecting it in the first pass would have.
+ */
+static void
+skip_packet_first_pass(capture_file *cf, gboolean dissecting, gint64 offset,
+        wtap_rec *rec)
+{
+    frame_data fdlocal;
+
+    frame_data_init(&fdlocal, cf->count + 1, rec, offset, cum_bytes);
+    if (dissecting) {
+        frame_data_set_before_dissect(&fdlocal, &cf->elapsed_time,
+                &cf->provider.ref, cf->provider.prev_dis);
+        if (cf->provider.ref == &fdlocal) {
+            ref_frame = fdlocal;
+            cf->provider.ref = &ref_frame;
+        }
+    }
+    frame_data_set_after_dissect(&fdlocal, &cum_bytes);
+    cf->provider.prev_cap = cf->provider.prev_dis = frame_data_sequence_add(cf->provider.frames, &fdlocal);
+    cf->count++;
+}
+
+/* The same, for the only pass of one-pass processing. */
+static void
+skip_packet_single_pass(capture_file *cf, gint64 offset, wtap_rec *rec)
+{
+    frame_data fdata;
+
+    cf->count++;
+    frame_data_init(&fdata, cf->count, rec, offset, cum_bytes);
+    frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
+            &cf->provider.ref, cf->provider.prev_dis);
+    if (cf->provider.ref == &fdata) {
+        ref_frame = fdata;
+        cf->provider.ref = &ref_frame;
+    }
+    frame_data_set_after_dissect(&fdata, &cum_bytes);
+    prev_dis_frame = fdata;
+    cf->provider.prev_dis = &prev_dis_frame;
+    prev_cap_frame = fdata;
+    cf->provider.prev_cap = &prev_cap_frame;
+    frame_data_destroy(&fdata);
+}
+
+/*
+ * The same, for the second pass, for a frame that some other process
+ * is printing; without a display filter, every frame is displayed.
+ */
+static void
+skip_packet_second_pass(capture_file *cf, frame_data *fdata)
+{
+    frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+            &cf->provider.ref, cf->provider.prev_dis);
+    if (cf->provider.ref == fdata) {
+        ref_frame = *fdata;
+        cf->provider.ref = &ref_frame;
+    }
+    frame_data_set_after_dissect(fdata, &cum_bytes);
+    cf->provider.prev_dis = fdata;
+    cf->provider.prev_cap = fdata;
+}
+#endif /* _WIN32 */
+
+static pass_status_t
+process_cap_file_first_pass(capture_file *cf, int max_packet_count,
+        gint64 max_byte_count, int *err, gchar **err_info)
+{
+    wtap_rec        rec;
+    Buffer          buf;
+    epan_dissect_t *edt = NULL;
+    gint64          data_offset;
+    pass_status_t   status = PASS_SUCCEEDED;
+    int             framenum = 0;
+    gboolean        ours = TRUE;
+    gboolean        looking_up_names;
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+
+    looking_up_names = do_dissection && gbl_resolv_flags.network_name &&
+        gbl_resolv_flags.use_external_net_name_resolver;
+
+    /* Allocate a frame_data_sequence for all the frames. */
+    cf->provider.frames = new_frame_data_sequence();
+
+    if (do_dissection) {
+        gboolean create_proto_tree;
+
+        /*
+         * Determine whether we need to create a protocol tree.
+         * We do if:
+         *
+         *    we're going to apply a read filter;
+         *
+         *    we're going to apply a display filter;
+         *
+         *    a postdissector wants field values or protocols
+         *    on the first pass;
+         *
+         *    we're resolving network addresses with external
+         *    resolvers, as dissectors only look up host names when
+         *    building a tree, and we want to start the lookups on
+         *    this pass so that they can all be done before the
+         *    second.
+         */
+        create_proto_tree =
+            (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids() || dissect_color ||
+             looking_up_names);
+
+        ws_debug("tshark: create_proto_tree = %s", create_proto_tree ? "TRUE" : "FALSE");
+
+        /* We're not going to display the protocol tree on this pass,
+           so it's not going to be "visible". */
+        edt = epan_dissect_new(cf->epan, create_proto_tree, FALSE);
+    }
+
+    ws_debug("tshark: reading records for first pass");
+    *err = 0;
+    while (wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
+        if (read_interrupted) {
+            status = PASS_INTERRUPTED;
+            break;
+        }
+        framenum++;
+
+#ifndef _WIN32
+        if (flow_shard >= 0) {
+            ours = flow_shard_owns_record(&rec, &buf);
+            flow_shard_note_frame(cf->count + 1, ours);
+            if (!ours)
+                skip_packet_first_pass(cf, edt != NULL, data_offset, &rec);
+        }
+#endif
+
+        if (!ours || process_packet_first_pass(cf, edt, data_offset, &rec, &buf)) {
+            /* Send any host name lookups that dissection queued, and
+               pick up any replies, without waiting for them. */
+            if (looking_up_names)
+                host_name_lookup_process();
+
+            /* Stop reading if we hit a stop condition */
+            if (max_packet_count > 0 && framenum >= max_packet_count) {
+                ws_debug("tshark: max_packet_count (%d) reached", max_packet_count);
+                *err = 0; /* This is not an error */
+                break;
+            }
+            if (max_byte_count != 0 && data_offset >= max_byte_count) {
+                ws_debug("tshark: max_byte_count (%" PRId64 "/%" PRId64 ") reached",
+                        data_offset, max_byte_count);
+                *err = 0; /* This is not an error */
+                break;
+            }
+        }
+        wtap_rec_reset(&rec);
+    }
+    if (*err != 0)
+        status = PASS_READ_ERROR;
+
+    if (edt)
+        epan_dissect_free(edt);
+
+    /* Close the sequential I/O side, to free up memory it requires. */
+    wtap_sequential_close(cf->provider.wth);
+
+    /* Allow the protocol dissectors to free up memory that they
+     * don't need after the sequential run-through of the packets. */
+    postseq_cleanup_all_protocols();
+
+    /* Finish the host name lookups started on this pass, so that the
+     * second pass, which resolves names synchronously, finds them all
+     * done rather than looking them up one at a time. */
+    if (looking_up_names && status != PASS_INTERRUPTED)
+        host_name_lookup_wait();
+
+    cf->provider.prev_dis = NULL;
+    cf->provider.prev_cap = NULL;
+
+    ws_buffer_free(&buf);
+    wtap_rec_cleanup(&rec);
+
+    return status;
+}
+
+static gboolean
+process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
+        frame_data *fdata, wtap_rec *rec,
+        Buffer *buf, guint tap_flags)
+{
+    column_info    *cinfo;
+    gboolean        passed;
+    guint64         output_start;
+
+    /* If we're not running a display filter and we're not printing any
+       packet information, we don't need to do a dissection. This means
+       that all packets can be marked as 'passed'. */
+    passed = TRUE;
+
+    /* If we're going to print packet information, or we're going to
        run a read filter, or we're going to process taps, set up to
        do a dissection and do so.  (This is the second pass of two
        passes over the packets; that's the pass where we print
@@ -3269,9 +4443,18 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
             fdata->need_colorize = 1;
         }
 
-        epan_dissect_run_with_taps(edt, cf->cd_t, rec,
-                frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
-                fdata, cinfo);
+        if (slow_packets_max != 0) {
+            gint64 start_us = g_get_monotonic_time();
+
+            epan_dissect_run_with_taps(edt, cf->cd_t, rec,
+                    frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
+                    fdata, cinfo);
+            note_packet_time(edt, fdata->num, g_get_monotonic_time() - start_us);
+        } else {
+            epan_dissect_run_with_taps(edt, cf->cd_t, rec,
+                    frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
+                    fdata, cinfo);
+        }
 
         /* Run the read/display filter if we have one. */
         if (cf->dfcode)
@@ -3284,6 +4467,7 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
         if (print_packet_info) {
             /* We're printing packet information; print the information for
                this packet. */
+            output_start = ws_perf_timer_start();
             print_packet(cf, edt);
 
             /* If we're doing "line-buffering", flush the standard output
@@ -3291,6 +4475,7 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
                option, for an explanation of why we do that. */
             if (line_buffered)
                 fflush(stdout);
+            ws_perf_timer_stop(WS_PERF_OUTPUT_TIME, output_start);
 
             if (ferror(stdout)) {
                 show_print_file_io_error();
@@ -3307,12 +4492,316 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
     return passed || fdata->dependent_of_displayed;
 }
 
+/*
+ * Reading ahead, with --read-ahead: a reader thread fills batches of
+ * records with wtap_read_batch() while the main thread dissects and
+ * prints the ones already read.  The batches go back and forth between
+ * the two threads through a pair of queues; as there are only
+ * READ_AHEAD_BATCHES of them, the reader can get only that far ahead.
+ *
+ * Whatever else libwiretap comes across while reading - IDBs, and the
+ * names and secrets it hands to its callbacks - goes along with the
+ * batch it was read with, and is passed on by the main thread before
+ * the batch's records are processed, so no epan code runs on the
+ * reader thread and nothing that thread changes is looked at by the
+ * main thread.
+ */
+#define READ_AHEAD_BATCHES      4
+#define READ_AHEAD_BATCH_RECS   256
+
+typedef enum {
+    READ_AHEAD_IPV4,
+    READ_AHEAD_IPV6,
+    READ_AHEAD_SECRETS
+} read_ahead_event_type_t;
+
+typedef struct {
+    read_ahead_event_type_t type;
+    guint32     ipv4;
+    ws_in6_addr ipv6;
+    gchar      *name;
+    gboolean    static_entry;
+    guint32     secrets_type;
+    void       *secrets;
+    guint       secrets_size;
+} read_ahead_event_t;
+
+typedef struct {
+    wtap_rec_batch batch;
+    int         err;        /* why the batch isn't full, if it isn't */
+    gchar      *err_info;
+    GPtrArray  *idbs;       /* IDBs read along with the batch */
+    GArray     *events;     /* read_ahead_event_t's from libwiretap's callbacks */
+} read_ahead_batch_t;
+
+typedef struct {
+    capture_file *cf;
+    wtap        *wth;
+    GThread     *thread;
+    GAsyncQueue *full;      /* batches read, for the main thread */
+    GAsyncQueue *empty;     /* batches to read into, for the reader thread */
+    gint         stop;      /* tells the reader thread to stop */
+    read_ahead_batch_t batches[READ_AHEAD_BATCHES];
+    read_ahead_batch_t *current;    /* the batch the main thread is on */
+    guint        next;      /* the main thread's next record in it */
+    guint        idbs_processed;    /* IDBs handed to process_new_idbs() */
+} read_ahead_t;
+
+static read_ahead_t *read_ahead;
+
+/* The batch the reader thread is filling in; only it uses this. */
+static read_ahead_batch_t *read_ahead_filling;
+
+static void
+read_ahead_add_ipv4_name(const guint addr, const gchar *name,
+        const gboolean static_entry)
+{
+    read_ahead_event_t event;
+
+    memset(&event, 0, sizeof event);
+    event.type = READ_AHEAD_IPV4;
+    event.ipv4 = addr;
+    event.name = g_strdup(name);
+    event.static_entry = static_entry;
+    g_array_append_val(read_ahead_filling->events, event);
+}
+
+static void
+read_ahead_add_ipv6_name(const void *addrp, const gchar *name,
+        const gboolean static_entry)
+{
+    read_ahead_event_t event;
+
+    memset(&event, 0, sizeof event);
+    event.type = READ_AHEAD_IPV6;
+    memcpy(&event.ipv6, addrp, sizeof event.ipv6);
+    event.name = g_strdup(name);
+    event.static_entry = static_entry;
+    g_array_append_val(read_ahead_filling->events, event);
+}
+
+static void
+read_ahead_add_secrets(guint32 secrets_type, const void *secrets, guint size)
+{
+    read_ahead_event_t event;
+
+    /*
+     * wtap_set_cb_new_secrets() passes on the secrets read so far when
+     * the callback is set; those went to secrets_wtap_callback() when
+     * the file was opened.
+     */
+    if (read_ahead_filling == NULL)
+        return;
+
+    memset(&event, 0, sizeof event);
+    event.type = READ_AHEAD_SECRETS;
+    event.secrets_type = secrets_type;
+    event.secrets = g_memdup2(secrets, size);
+    event.secrets_size = size;
+    g_array_append_val(read_ahead_filling->events, event);
+}
+
+static gpointer
+read_ahead_thread(gpointer data)
+{
+    read_ahead_t *ra = (read_ahead_t *)data;
+    read_ahead_batch_t *rab;
+    wtap_block_t if_data;
+
+    for (;;) {
+        rab = (read_ahead_batch_t *)g_async_queue_pop(ra->empty);
+        if (g_atomic_int_get(&ra->stop))
+            break;
+
+        read_ahead_filling = rab;
+        rab->err = 0;
+        wtap_read_batch(ra->wth, &rab->batch, &rab->err, &rab->err_info);
+        while ((if_data = wtap_get_next_interface_description(ra->wth)) != NULL)
+            g_ptr_array_add(rab->idbs, if_data);
+        read_ahead_filling = NULL;
+
+        g_async_queue_push(ra->full, rab);
+        if (rab->batch.count < rab->batch.capacity)
+            break;      /* end of file, or an error */
+    }
+    return NULL;
+}
+
+static void
+read_ahead_start(capture_file *cf)
+{
+    read_ahead_t *ra = g_new0(read_ahead_t, 1);
+
+    ra->cf = cf;
+    ra->wth = cf->provider.wth;
+    ra->full = g_async_queue_new();
+    ra->empty = g_async_queue_new();
+    for (guint i = 0; i < READ_AHEAD_BATCHES; i++) {
+        read_ahead_batch_t *rab = &ra->batches[i];
+
+        wtap_rec_batch_init(&rab->batch, READ_AHEAD_BATCH_RECS);
+        rab->idbs = g_ptr_array_new();
+        rab->events = g_array_new(FALSE, FALSE, sizeof (read_ahead_event_t));
+        g_async_queue_push(ra->empty, rab);
+    }
+
+    /*
+     * The interface list grows as the reader thread reads, so the
+     * packet provider has to look interfaces up in the IDBs it has
+     * been handed instead.
+     */
+    cf->provider.idbs = g_ptr_array_new();
+
+    wtap_set_cb_new_ipv4(ra->wth, read_ahead_add_ipv4_name);
+    wtap_set_cb_new_ipv6(ra->wth, read_ahead_add_ipv6_name);
+    wtap_set_cb_new_secrets(ra->wth, read_ahead_add_secrets);
+
+    read_ahead = ra;
+    ra->thread = g_thread_new("tshark read-ahead", read_ahead_thread, ra);
+}
+
+/*
+ * Pass on what libwiretap handed its callbacks while reading a batch,
+ * or, if pass_on is FALSE, just discard it.
+ */
+static void
+read_ahead_flush_events(read_ahead_batch_t *rab, gboolean pass_on)
+{
+    for (guint i = 0; i < rab->events->len; i++) {
+        read_ahead_event_t *event = &g_array_index(rab->events, read_ahead_event_t, i);
+
+        if (pass_on) {
+            switch (event->type) {
+
+            case READ_AHEAD_IPV4:
+                add_ipv4_name(event->ipv4, event->name, event->static_entry);
+                break;
+
+            case READ_AHEAD_IPV6:
+                add_ipv6_name(&event->ipv6, event->name, event->static_entry);
+                break;
+
+            case READ_AHEAD_SECRETS:
+                secrets_wtap_callback(event->secrets_type, event->secrets,
+                        event->secrets_size);
+                break;
+            }
+        }
+        g_free(event->name);
+        g_free(event->secrets);
+    }
+    g_array_set_size(rab->events, 0);
+}
+
+/*
+ * Get the next record the reader thread read, with its data in buf.
+ * Returns FALSE at the end of the file or on a read error, as
+ * wtap_read() does.
+ */
+static gboolean
+read_ahead_next(wtap_rec **rec, Buffer *buf, int *err,
+        gchar **err_info, gint64 *data_offset)
+{
+    read_ahead_t *ra = read_ahead;
+    read_ahead_batch_t *rab = ra->current;
+    wtap_rec_batch *batch;
+
+    while (rab == NULL || ra->next >= rab->batch.count) {
+        if (rab != NULL) {
+            if (rab->batch.count < rab->batch.capacity) {
+                /* That was the last one. */
+                *err = rab->err;
+                *err_info = rab->err_info;
+                rab->err_info = NULL;
+                return FALSE;
+            }
+            g_async_queue_push(ra->empty, rab);
+        }
+        rab = (read_ahead_batch_t *)g_async_queue_pop(ra->full);
+        ra->current = rab;
+        ra->next = 0;
+
+        for (guint i = 0; i < rab->idbs->len; i++)
+            g_ptr_array_add(ra->cf->provider.idbs, g_ptr_array_index(rab->idbs, i));
+        g_ptr_array_set_size(rab->idbs, 0);
+        read_ahead_flush_events(rab, TRUE);
+    }
+
+    batch = &rab->batch;
+    *rec = &batch->recs[ra->next];
+    *data_offset = batch->offsets[ra->next];
+    ws_buffer_borrow(buf, wtap_rec_batch_data(batch, ra->next),
+            batch->data_offsets[ra->next + 1] - batch->data_offsets[ra->next]);
+    ra->next++;
+    return TRUE;
+}
+
+/* Get the next IDB the reader thread read, if there is one. */
+static wtap_block_t
+read_ahead_next_idb(void)
+{
+    GPtrArray *idbs = read_ahead->cf->provider.idbs;
+
+    if (read_ahead->idbs_processed < idbs->len)
+        return (wtap_block_t)g_ptr_array_index(idbs, read_ahead->idbs_processed++);
+    return NULL;
+}
+
+/*
+ * Stop the reader thread, if it hasn't stopped already, and free the
+ * batches.  The records must no longer be in use.
+ */
+static void
+read_ahead_stop(void)
+{
+    read_ahead_t *ra = read_ahead;
+    read_ahead_batch_t *rab;
+
+    /*
+     * If the reader thread is waiting for a batch to read into, give
+     * it back all of them so it notices it's to stop.
+     */
+    g_atomic_int_set(&ra->stop, 1);
+    if (ra->current != NULL)
+        g_async_queue_push(ra->empty, ra->current);
+    while ((rab = (read_ahead_batch_t *)g_async_queue_try_pop(ra->full)) != NULL)
+        g_async_queue_push(ra->empty, rab);
+    g_thread_join(ra->thread);
+
+    for (guint i = 0; i < READ_AHEAD_BATCHES; i++) {
+        rab = &ra->batches[i];
+        read_ahead_flush_events(rab, FALSE);
+        wtap_rec_batch_cleanup(&rab->batch);
+        g_free(rab->err_info);
+        g_ptr_array_free(rab->idbs, TRUE);
+        g_array_free(rab->events, TRUE);
+    }
+    g_async_queue_unref(ra->full);
+    g_async_queue_unref(ra->empty);
+    g_ptr_array_free(ra->cf->provider.idbs, TRUE);
+    ra->cf->provider.idbs = NULL;
+    g_free(ra);
+    read_ahead = NULL;
+
+    /*
+     * The file is closed after this pass, so libwiretap's callbacks
+     * are left pointing at ours.
+     */
+}
+
 static gboolean
 process_new_idbs(wtap *wth, wtap_dumper *pdh, int *err, gchar **err_info)
 {
     wtap_block_t if_data;
 
-    while ((if_data = wtap_get_next_interface_description(wth)) != NULL) {
+    for (;;) {
+        if (read_ahead != NULL)
+            if_data = read_ahead_next_idb();
+        else
+            if_data = wtap_get_next_interface_description(wth);
+        if (if_data == NULL)
+            break;
+
         /*
          * Only add interface blocks if the output file supports (meaning
          * *requires*) them.
@@ -3330,6 +4819,186 @@ process_new_idbs(wtap *wth, wtap_dumper *pdh, int *err, gchar **err_info)
     return TRUE;
 }
 
+#ifndef _WIN32
+/*
+ * Running the second pass in worker processes; each of them dissects
+ * and prints every n'th block of frames.
+ */
+#define WORKER_BLOCK_FRAMES 1024    /* frames in a block */
+
+/*
+ * Can the second pass be done by worker processes?  Each worker
+ * dissects only some of the frames, so nothing may depend on this pass
+ * having seen all of them, and the workers can share nothing but the
+ * standard output.
+ */
+static gboolean
+can_use_dissect_workers(capture_file *cf, wtap_dumper *pdh,
+        epan_dissect_t *edt)
+{
+    const char *why;
+
+    if (cf->count <= WORKER_BLOCK_FRAMES)
+        return FALSE;   /* not worth it */
+
+    if (pdh != NULL)
+        why = "packets are being written to a capture file";
+    else if (edt == NULL || !print_packet_info)
+        why = "packets aren't being printed";
+    else if (cf->dfcode != NULL)
+        why = "a display filter is being applied";
+    else if (have_tap_listeners())
+        why = "statistics or other taps are being run";
+    else if (gbl_resolv_flags.network_name &&
+            gbl_resolv_flags.use_external_net_name_resolver)
+        why = "network names are being looked up";
+    else if (maxmind_db_is_running())
+        why = "MaxMind databases are being used";
+    else if (dissector_profile_is_enabled())
+        why = "dissectors are being profiled";
+    else if (slow_packets_max != 0)
+        why = "slow packets are being looked for";
+    else
+        return TRUE;
+
+    ws_warning("Not using dissection workers, as %s.", why);
+    return FALSE;
+}
+
+/*
+ * The body of a worker process: dissect and print worker's share of
+ * the frames, which is every n_workers'th block of them.  Never returns.
+ */
+static void G_GNUC_NORETURN
+dissect_worker_main(capture_file *cf, epan_dissect_t *edt, guint tap_flags,
+        guint worker, guint n_workers)
+{
+    wtap_rec            rec;
+    Buffer              buf;
+    worker_status_t     status;
+    guint32             framenum, block_start = 0;
+    frame_data         *fdata;
+    int                 err;
+    gchar              *err_info = NULL;
+
+    memset(&status, 0, sizeof status);
+    status.first_pass_status = PASS_SUCCEEDED;
+    status.status = PASS_SUCCEEDED;
+
+    /*
+     * Each worker needs its own file offset to read the capture file
+     * at, rather than sharing one with everybody else.
+     */
+    wtap_fdclose(cf->provider.wth);
+    if (!wtap_fdreopen(cf->provider.wth, cf->filename, &err)) {
+        status.status = PASS_READ_ERROR;
+        status.err = err;
+        worker_done(&status, NULL, NULL);
+    }
+
+    /* The first packet in the JSON array isn't ours, if we're not first. */
+    if ((output_action == WRITE_JSON || output_action == WRITE_JSON_RAW) &&
+            worker != 0)
+        json_dumper_skip_array_element(&jdumper);
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+
+    for (framenum = 1; framenum <= cf->count; framenum++) {
+        fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+        if (((framenum - 1) / WORKER_BLOCK_FRAMES) % n_workers != worker) {
+            /* Another worker is printing this frame. */
+            skip_packet_second_pass(cf, fdata);
+            worker_frame_done(framenum);
+            continue;
+        }
+
+        if ((framenum - 1) % WORKER_BLOCK_FRAMES == 0) {
+            /* This is the start of one of our blocks. */
+            block_start = framenum;
+            worker_output_begin();
+        }
+
+        if (read_interrupted) {
+            status.status = PASS_INTERRUPTED;
+            break;
+        }
+        if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf,
+                    &err, &err_info)) {
+            status.status = PASS_READ_ERROR;
+            status.err = err;
+            break;
+        }
+        process_packet_second_pass(cf, edt, fdata, &rec, &buf, tap_flags);
+        wtap_rec_reset(&rec);
+
+        if (framenum % WORKER_BLOCK_FRAMES == 0 || framenum == cf->count)
+            worker_output_end(block_start);
+        worker_frame_done(framenum);
+    }
+
+    /* Hand over what we printed of this block before stopping. */
+    if (status.status != PASS_SUCCEEDED)
+        worker_output_end(block_start);
+    worker_done(&status, NULL, err_info);
+}
+
+/*
+ * Do the second pass in worker processes.  Returns FALSE, having
+ * printed nothing, if the workers couldn't be started, in which case
+ * the caller should do the pass itself.
+ */
+static gboolean
+process_cap_file_second_pass_in_workers(capture_file *cf,
+        epan_dissect_t *edt, guint tap_flags, pass_status_t *status,
+        int *err, gchar **err_info, volatile guint32 *err_framenum)
+{
+    dissect_worker_t    workers[MAX_DISSECT_WORKERS];
+    guint               n_workers;
+    int                 worker;
+    worker_status_t     ws;
+    workers_result_t    result;
+    gchar              *first_pass_err_info;
+    gboolean            copied;
+
+    n_workers = MIN(dissect_workers,
+            (cf->count + WORKER_BLOCK_FRAMES - 1) / WORKER_BLOCK_FRAMES);
+
+    /*
+     * We're done with the sequential file handle; close it now, so
+     * that the workers don't inherit any decompression threads it
+     * might have, which fork() wouldn't bring along.
+     */
+    wtap_sequential_close(cf->provider.wth);
+
+    worker = start_dissect_workers(workers, n_workers);
+    if (worker == WORKERS_NOT_STARTED)
+        return FALSE;
+    if (worker != WORKERS_STARTED)
+        dissect_worker_main(cf, edt, tap_flags, worker, n_workers);
+
+    /* Copy the blocks to the standard output, in order. */
+    result = merge_worker_output(workers, n_workers, &ws,
+            &first_pass_err_info, err_info, &copied);
+    g_free(first_pass_err_info);
+    if (!stop_dissect_workers(workers, n_workers) ||
+            result == WORKERS_FAILED)
+        exit(2);
+    *status = (pass_status_t)ws.status;
+    *err = ws.err;
+    *err_framenum = ws.err_framenum;
+
+    /*
+     * Our JSON dumper didn't see the packets go by, so tell it there
+     * were some, for it to finish the array properly.
+     */
+    if ((output_action == WRITE_JSON || output_action == WRITE_JSON_RAW) &&
+            copied)
+        json_dumper_skip_array_element(&jdumper);
+    return TRUE;
+}
+#endif /* _WIN32 */
+
 static pass_status_t
 process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
         int *err, gchar **err_info,
@@ -3400,12 +5069,29 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
      */
     set_resolution_synchrony(TRUE);
 
+#ifndef _WIN32
+    if (dissect_workers > 1 && can_use_dissect_workers(cf, pdh, edt) &&
+            process_cap_file_second_pass_in_workers(cf, edt, tap_flags,
+                &status, err, err_info, err_framenum))
+        goto done;  /* the workers did it all */
+#endif
+
     for (framenum = 1; framenum <= (int)cf->count; framenum++) {
         if (read_interrupted) {
             status = PASS_INTERRUPTED;
             break;
         }
         fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+#ifndef _WIN32
+        if (flow_shard >= 0) {
+            if (!flow_shard_frame_is_ours(framenum)) {
+                skip_packet_second_pass(cf, fdata);
+                flow_shard_frame_skipped(framenum);
+                continue;
+            }
+            worker_output_begin();
+        }
+#endif
         if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf, err,
                     err_info)) {
             /* Error reading from the input file. */
@@ -3419,8 +5105,14 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
                this packet out. */
             write_framenum++;
             if (pdh != NULL) {
+                gboolean dumped;
+                guint64 output_start;
+
                 ws_debug("tshark: writing packet #%d to outfile packet #%d", framenum, write_framenum);
-                if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
+                output_start = ws_perf_timer_start();
+                dumped = wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info);
+                ws_perf_timer_stop(WS_PERF_OUTPUT_TIME, output_start);
+                if (!dumped) {
                     /* Error writing to the output file. */
                     ws_debug("tshark: error writing to a capture file (%d)", *err);
                     *err_framenum = framenum;
@@ -3436,8 +5128,17 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
             }
         }
         wtap_rec_reset(&rec);
+#ifndef _WIN32
+        if (flow_shard >= 0) {
+            worker_output_end(framenum);
+            worker_frame_done(framenum);
+        }
+#endif
     }
 
+#ifndef _WIN32
+done:
+#endif
     if (edt)
         epan_dissect_free(edt);
 
@@ -3454,7 +5155,8 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         int *err, gchar **err_info,
         volatile guint32 *err_framenum)
 {
-    wtap_rec        rec;
+    wtap_rec        own_rec;
+    wtap_rec       *rec;
     Buffer          buf;
     gboolean create_proto_tree = FALSE;
     gboolean        filtering_tap_listeners;
@@ -3464,8 +5166,9 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
     epan_dissect_t *edt = NULL;
     gint64          data_offset;
     pass_status_t   status = PASS_SUCCEEDED;
+    gboolean        ours = TRUE;
 
-    wtap_rec_init(&rec);
+    wtap_rec_init(&own_rec);
     ws_buffer_init(&buf, 1514);
 
     /* Do we have any tap listeners with filters? */
@@ -3516,8 +5219,20 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
      */
     set_resolution_synchrony(TRUE);
 
+    if (use_read_ahead)
+        read_ahead_start(cf);
+
     *err = 0;
-    while (wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
+    for (;;) {
+        if (read_ahead != NULL) {
+            if (!read_ahead_next(&rec, &buf, err, err_info, &data_offset))
+                break;
+        } else {
+            rec = &own_rec;
+            if (!wtap_read(cf->provider.wth, rec, &buf, err, err_info, &data_offset))
+                break;
+        }
+
         if (read_interrupted) {
             status = PASS_INTERRUPTED;
             break;
@@ -3537,15 +5252,31 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
 
         reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
 
-        if (process_packet_single_pass(cf, edt, data_offset, &rec, &buf, tap_flags)) {
+#ifndef _WIN32
+        if (flow_shard >= 0) {
+            ours = flow_shard_owns_record(rec, &buf);
+            if (ours)
+                worker_output_begin();
+            else
+                skip_packet_single_pass(cf, data_offset, rec);
+        }
+#endif
+
+        if (ours && process_packet_single_pass(cf, edt, data_offset, rec, &buf, tap_flags)) {
             /* Either there's no read filtering or this packet passed the
                filter, so, if we're writing to a capture file, write
                this packet out. */
             write_framenum++;
             if (pdh != NULL) {
+                gboolean dumped;
+                guint64 output_start;
+
                 ws_debug("tshark: writing packet #%d to outfile as #%d",
                         framenum, write_framenum);
-                if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
+                output_start = ws_perf_timer_start();
+                dumped = wtap_dump(pdh, rec, ws_buffer_start_ptr(&buf), err, err_info);
+                ws_perf_timer_stop(WS_PERF_OUTPUT_TIME, output_start);
+                if (!dumped) {
                     /* Error writing to the output file. */
                     ws_debug("tshark: error writing to a capture file (%d)", *err);
                     *err_framenum = framenum;
@@ -3554,6 +5285,16 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
                 }
             }
         }
+#ifndef _WIN32
+        if (flow_shard >= 0) {
+            if (ours) {
+                worker_output_end(framenum);
+                worker_frame_done(framenum);
+            } else {
+                flow_shard_frame_skipped(framenum);
+            }
+        }
+#endif
         /* Stop reading if we hit a stop condition */
         if (max_packet_count > 0 && framenum >= max_packet_count) {
             ws_debug("tshark: max_packet_count (%d) reached", max_packet_count);
@@ -3571,22 +5312,133 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
             *err = 0; /* This is not an error */
             break;
         }
-        wtap_rec_reset(&rec);
+        wtap_rec_reset(&own_rec);
     }
     if (*err != 0 && status == PASS_SUCCEEDED) {
         /* Error reading from the input file. */
         status = PASS_READ_ERROR;
     }
 
+    if (read_ahead != NULL)
+        read_ahead_stop();
+
     if (edt)
         epan_dissect_free(edt);
 
     ws_buffer_free(&buf);
-    wtap_rec_cleanup(&rec);
+    wtap_rec_cleanup(&own_rec);
 
     return status;
 }
 
+#ifndef _WIN32
+/*
+ * Can the conversations be split between worker processes?  Each
+ * worker dissects only its own conversations, so nothing may depend on
+ * having seen all the packets, and the workers can share nothing but
+ * the standard output.
+ */
+static gboolean
+can_use_flow_shards(capture_file *cf, wtap_dumper *pdh)
+{
+    ws_statb64  statb;
+    const char *why;
+
+    if (pdh != NULL)
+        why = "packets are being written to a capture file";
+    else if (!do_dissection || !print_packet_info)
+        why = "packets aren't being printed";
+    else if (cf->rfcode != NULL || cf->dfcode != NULL)
+        why = "a filter is being applied";
+    else if (have_tap_listeners())
+        why = "statistics or other taps are being run";
+    else if (gbl_resolv_flags.network_name &&
+            gbl_resolv_flags.use_external_net_name_resolver)
+        why = "network names are being looked up";
+    else if (maxmind_db_is_running())
+        why = "MaxMind databases are being used";
+    else if (dissector_profile_is_enabled())
+        why = "dissectors are being profiled";
+    else if (slow_packets_max != 0)
+        why = "slow packets are being looked for";
+    else if (ws_stat64(cf->filename, &statb) != 0 || !S_ISREG(statb.st_mode))
+        why = "the capture file can't be read more than once";
+    else
+        return TRUE;
+
+    ws_warning("Not using flow shards, as %s.", why);
+    return FALSE;
+}
+
+/*
+ * Process the capture file in flow shard workers.  Returns TRUE, in
+ * the parent, once they've done it all, with how it went; returns
+ * FALSE if they couldn't be started, and in each worker, once it has
+ * reopened the file, in which case the caller should go ahead and
+ * process the file.
+ */
+static gboolean
+process_cap_file_in_flow_shards(capture_file *cf,
+        pass_status_t *first_pass_status, int *err_pass1,
+        gchar **err_info_pass1, pass_status_t *second_pass_status,
+        int *err, gchar **err_info, volatile guint32 *err_framenum)
+{
+    dissect_worker_t    workers[MAX_DISSECT_WORKERS];
+    int                 worker;
+    worker_status_t     ws;
+    workers_result_t    result;
+    wtap               *wth;
+    gboolean            copied;
+
+    worker = start_dissect_workers(workers, flow_shards);
+    if (worker == WORKERS_NOT_STARTED)
+        return FALSE;
+    if (worker != WORKERS_STARTED) {
+        /*
+         * We're a shard; read the file from the start ourselves.
+         * Don't close the parent's handle; any threads it has for
+         * reading ahead didn't come along with fork(), and closing
+         * it would wait for them.
+         */
+        flow_shard = worker;
+        wth = wtap_open_offline(cf->filename, cf->open_type, err, err_info,
+                perform_two_pass_analysis);
+        if (wth == NULL) {
+            memset(&ws, 0, sizeof ws);
+            ws.first_pass_status = PASS_SUCCEEDED;
+            ws.status = PASS_READ_ERROR;
+            ws.err = *err;
+            worker_done(&ws, NULL, *err_info);
+        }
+        cf->provider.wth = wth;
+        wtap_set_cb_new_ipv4(cf->provider.wth, add_ipv4_name);
+        wtap_set_cb_new_ipv6(cf->provider.wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
+        wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
+        return FALSE;
+    }
+
+    result = merge_worker_output(workers, flow_shards, &ws, err_info_pass1,
+            err_info, &copied);
+    if (!stop_dissect_workers(workers, flow_shards) ||
+            result == WORKERS_FAILED)
+        exit(2);
+    *first_pass_status = (pass_status_t)ws.first_pass_status;
+    *err_pass1 = ws.first_pass_err;
+    *second_pass_status = (pass_status_t)ws.status;
+    *err = ws.err;
+    *err_framenum = ws.err_framenum;
+
+    /*
+     * Our JSON dumper didn't see the packets go by, so tell it there
+     * were some, for it to finish the array properly.
+     */
+    if ((output_action == WRITE_JSON || output_action == WRITE_JSON_RAW) &&
+            copied)
+        json_dumper_skip_array_element(&jdumper);
+    return TRUE;
+}
+#endif /* _WIN32 */
+
 static process_file_status_t
 process_cap_file(capture_file *cf, char *save_file, int out_file_type,
         gboolean out_file_name_res, int max_packet_count, gint64 max_byte_count,
@@ -3693,8 +5545,14 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
     sigaction(SIGHUP, NULL, &oldaction);
     if (oldaction.sa_handler == SIG_DFL)
         sigaction(SIGHUP, &action, NULL);
-#endif /* _WIN32 */
 
+    if (flow_shards > 1 && can_use_flow_shards(cf, pdh) &&
+            process_cap_file_in_flow_shards(cf, &first_pass_status,
+                &err_pass1, &err_info_pass1, &second_pass_status, &err,
+                &err_info, &err_framenum)) {
+        ws_debug("tshark: flow shards done");
+    } else
+#endif /* _WIN32 */
     if (perform_two_pass_analysis) {
         ws_debug("tshark: perform_two_pass_analysis, do_dissection=%s", do_dissection ? "TRUE" : "FALSE");
 
@@ -3737,6 +5595,21 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
                 &err_framenum);
     }
 
+#ifndef _WIN32
+    if (flow_shard >= 0) {
+        /* We're a flow shard worker; the parent reports how it went. */
+        worker_status_t ws;
+
+        memset(&ws, 0, sizeof ws);
+        ws.first_pass_status = first_pass_status;
+        ws.first_pass_err = err_pass1;
+        ws.status = second_pass_status;
+        ws.err = err;
+        ws.err_framenum = err_framenum;
+        worker_done(&ws, err_info_pass1, err_info);
+    }
+#endif
+
     if (first_pass_status != PASS_SUCCEEDED ||
             second_pass_status != PASS_SUCCEEDED) {
         /*
@@ -3860,6 +5733,40 @@ out:
     return status;
 }
 
+/*
+ * Forget the conversations and reassemblies that have been idle for too
+ * long, or the least recently used conversations if there are too many.
+ * The idle ones are looked for at most once per second of packet time.
+ */
+static void
+expire_idle_state(const frame_data *fdata)
+{
+    expiry_sample_t *sample;
+    guint32 oldest_frame = 0;
+
+    if (expire_idle_secs != 0 && fdata->has_ts) {
+        if (expiry_samples_count == 0 ||
+            fdata->abs_ts.secs > expiry_samples[(expiry_samples_first + expiry_samples_count - 1) % (expire_idle_secs + 1)].secs) {
+            /* A new second; drop the samples that are too old, and add it. */
+            while (expiry_samples_count != 0 &&
+                   (expiry_samples_count == expire_idle_secs + 1 ||
+                    expiry_samples[expiry_samples_first].secs < fdata->abs_ts.secs - (time_t)expire_idle_secs)) {
+                expiry_samples_first = (expiry_samples_first + 1) % (expire_idle_secs + 1);
+                expiry_samples_count--;
+            }
+            sample = &expiry_samples[(expiry_samples_first + expiry_samples_count) % (expire_idle_secs + 1)];
+            sample->secs = fdata->abs_ts.secs;
+            sample->framenum = fdata->num;
+            expiry_samples_count++;
+
+            /* Everything before the oldest second still remembered is idle. */
+            oldest_frame = expiry_samples[expiry_samples_first].framenum;
+            reassembly_tables_expire(oldest_frame);
+        }
+    }
+    conversation_expire(oldest_frame);
+}
+
 static gboolean
 process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         wtap_rec *rec, Buffer *buf, guint tap_flags)
@@ -3867,6 +5774,7 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
     frame_data      fdata;
     column_info    *cinfo;
     gboolean        passed;
+    guint64         output_start;
 
     /* Count this packet. */
     cf->count++;
@@ -3914,18 +5822,36 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
             cf->provider.ref = &ref_frame;
         }
 
-        if (dissect_color) {
-            color_filters_prime_edt(edt);
-            fdata.need_colorize = 1;
-        }
+        if (prefilter_packets && cf->dfcode &&
+            !dfilter_may_match_bytes(cf->dfcode, ws_buffer_start_ptr(buf), fdata.cap_len)) {
+            /* The packet's bytes show that it can't match the filter, so
+               don't dissect it.  Whatever dissecting it would have done
+               for later packets, such as reassembly, is lost, which is
+               why this isn't done by default. */
+            passed = FALSE;
+        } else {
+            if (dissect_color) {
+                color_filters_prime_edt(edt);
+                fdata.need_colorize = 1;
+            }
 
-        epan_dissect_run_with_taps(edt, cf->cd_t, rec,
-                frame_tvbuff_new_buffer(&cf->provider, &fdata, buf),
-                &fdata, cinfo);
+            if (slow_packets_max != 0) {
+                gint64 start_us = g_get_monotonic_time();
 
-        /* Run the filter if we have it. */
-        if (cf->dfcode)
-            passed = dfilter_apply_edt(cf->dfcode, edt);
+                epan_dissect_run_with_taps(edt, cf->cd_t, rec,
+                        frame_tvbuff_new_buffer(&cf->provider, &fdata, buf),
+                        &fdata, cinfo);
+                note_packet_time(edt, fdata.num, g_get_monotonic_time() - start_us);
+            } else {
+                epan_dissect_run_with_taps(edt, cf->cd_t, rec,
+                        frame_tvbuff_new_buffer(&cf->provider, &fdata, buf),
+                        &fdata, cinfo);
+            }
+
+            /* Run the filter if we have it. */
+            if (cf->dfcode)
+                passed = dfilter_apply_edt(cf->dfcode, edt);
+        }
     }
 
     if (passed) {
@@ -3936,6 +5862,7 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
             /* We're printing packet information; print the information for
                this packet. */
             ws_assert(edt);
+            output_start = ws_perf_timer_start();
             print_packet(cf, edt);
 
             /* If we're doing "line-buffering", flush the standard output
@@ -3943,6 +5870,7 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
                option, for an explanation of why we do that. */
             if (line_buffered)
                 fflush(stdout);
+            ws_perf_timer_stop(WS_PERF_OUTPUT_TIME, output_start);
 
             if (ferror(stdout)) {
                 show_print_file_io_error();
@@ -3961,7 +5889,11 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
     if (edt) {
         epan_dissect_reset(edt);
         frame_data_destroy(&fdata);
+        if (expire_idle_secs != 0 || max_conversations != 0)
+            expire_idle_state(&fdata);
     }
+
+    check_stats_interval();
     return passed;
 }
 
@@ -3984,6 +5916,10 @@ write_preamble(capture_file *cf)
             write_fields_preamble(output_fields, stdout);
             return !ferror(stdout);
 
+        case WRITE_ARROW:
+            arrow_output = write_arrow_preamble(output_fields, stdout);
+            return !ferror(stdout);
+
         case WRITE_JSON:
         case WRITE_JSON_RAW:
             jdumper = write_json_preamble(stdout);
@@ -4067,7 +6003,7 @@ print_columns(capture_file *cf, const epan_dissect_t *edt)
     *line_bufp = '\0';
 
     if (dissect_color)
-        color_filter = edt->pi.fd->color_filter;
+        color_filter = color_filters_get_by_index(edt->pi.fd->color_index);
 
     for (i = 0; i < cf->cinfo.num_cols; i++) {
         col_item = &cf->cinfo.columns[i];
@@ -4338,6 +6274,10 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
             }
             break;
 
+        case WRITE_ARROW:
+            write_arrow_proto_tree(output_fields, edt, &cf->cinfo, arrow_output);
+            return !ferror(stdout);
+
         case WRITE_JSON:
             if (print_summary)
                 ws_assert_not_reached();
@@ -4401,6 +6341,11 @@ write_finale(void)
             write_fields_finale(output_fields, stdout);
             return !ferror(stdout);
 
+        case WRITE_ARROW:
+            write_arrow_finale(arrow_output);
+            arrow_output = NULL;
+            return !ferror(stdout);
+
         case WRITE_JSON:
         case WRITE_JSON_RAW:
             write_json_finale(&jdumper);
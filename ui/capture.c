@@ -419,6 +419,9 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
         cf_set_tempfile((capture_file *)cap_session->cf, TRUE);
     }
 
+    /* Anything we hadn't read from the old file was read by cf_finish_tail(). */
+    cap_session->pending_records = 0;
+
     /* save the new filename */
     capture_opts->save_file = g_strdup(new_file);
 
@@ -427,6 +430,7 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
         /* Attempt to open the capture file and set up to read from it. */
         switch(cf_open((capture_file *)cap_session->cf, capture_opts->save_file, WTAP_TYPE_AUTO, is_tempfile, &err)) {
             case CF_OK:
+                sync_pipe_attach_live_ring(cap_session);
                 break;
             case CF_ERROR:
                 /* Don't unlink (delete) the save file - leave it around,
@@ -519,36 +523,63 @@ capture_info_new_packets(int to_read, wtap *wth, info_data_t* cap_info)
     capture_info_ui_update(&cap_info->ui);
 }
 
+/*
+ * Read records from the capture file in real time mode. If
+ * cf_continue_tail() runs out of time, the records it didn't get to are
+ * kept in pending_records, and are read along with the next batch the
+ * capture child tells us about or by capture_input_continue_tail().
+ */
+static void
+capture_input_continue_tail_real(capture_session *cap_session, int to_read)
+{
+    int  err;
+
+    to_read += cap_session->pending_records;
+    cap_session->pending_records = 0;
+
+    switch (cf_continue_tail((capture_file *)cap_session->cf, &to_read,
+                             &cap_session->rec, &cap_session->buf, &err)) {
+
+        case CF_READ_OK:
+        case CF_READ_ERROR:
+            /* Just because we got an error, that doesn't mean we were unable
+               to read any of the file; we handle what we could get from the
+               file.
+
+               XXX - abort on a read error? */
+            cap_session->pending_records = to_read;
+            capture_callback_invoke(capture_cb_capture_update_continue, cap_session);
+            break;
+
+        case CF_READ_ABORTED:
+            /* Kill the child capture process; the user wants to exit, and we
+               shouldn't just leave it running. */
+            capture_kill_child(cap_session);
+            break;
+    }
+}
+
+void
+capture_input_continue_tail(capture_session *cap_session)
+{
+    if (cap_session->state != CAPTURE_RUNNING || cap_session->pending_records == 0)
+        return;
+
+    if (cap_session->capture_opts->real_time_mode && cap_session->capture_opts->save_file)
+        capture_input_continue_tail_real(cap_session, 0);
+}
+
 /* capture child tells us we have new packets to read */
 static void
 capture_input_new_packets(capture_session *cap_session, int to_read)
 {
     capture_options *capture_opts = cap_session->capture_opts;
-    int  err;
 
     ws_assert(capture_opts->save_file);
 
     if(capture_opts->real_time_mode) {
         /* Read from the capture file the number of records the child told us it added. */
-        switch (cf_continue_tail((capture_file *)cap_session->cf, to_read,
-                                 &cap_session->rec, &cap_session->buf, &err)) {
-
-            case CF_READ_OK:
-            case CF_READ_ERROR:
-                /* Just because we got an error, that doesn't mean we were unable
-                   to read any of the file; we handle what we could get from the
-                   file.
-
-                   XXX - abort on a read error? */
-                capture_callback_invoke(capture_cb_capture_update_continue, cap_session);
-                break;
-
-            case CF_READ_ABORTED:
-                /* Kill the child capture process; the user wants to exit, and we
-                   shouldn't just leave it running. */
-                capture_kill_child(cap_session);
-                break;
-        }
+        capture_input_continue_tail_real(cap_session, to_read);
     } else {
         cf_fake_continue_tail((capture_file *)cap_session->cf);
 
@@ -716,6 +747,7 @@ capture_input_closed(capture_session *cap_session, gchar *msg)
             /* Read what remains of the capture file. */
             status = cf_finish_tail((capture_file *)cap_session->cf,
                                     &cap_session->rec, &cap_session->buf, &err);
+            cap_session->pending_records = 0;
 
             /* Tell the GUI we are not doing a capture any more.
                Must be done after the cf_finish_tail(), so file lengths are
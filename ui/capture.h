@@ -81,6 +81,17 @@ capture_stop(capture_session *cap_session);
 extern void
 capture_kill_child(capture_session *cap_session);
 
+/**
+ * Read records that were left unread in real time mode because the
+ * capture child wrote them faster than we could dissect them. The GUI
+ * should call this when it's idle after a capture_cb_capture_update_continue
+ * callback while cap_session->pending_records is non-zero.
+ *
+ * @param cap_session the handle for the capture session
+ */
+extern void
+capture_input_continue_tail(capture_session *cap_session);
+
 struct if_stat_cache_s;
 typedef struct if_stat_cache_s if_stat_cache_t;
 
@@ -18,6 +18,7 @@
 #include <epan/tap.h>
 #include <epan/stat_tap_ui.h>
 #include <epan/conversation_table.h>
+#include <wsutil/strtoi.h>
 #include <ui/cmdarg_err.h>
 #include <ui/cli/tshark-tap.h>
 
@@ -96,6 +97,8 @@ endpoints_draw(void *arg)
 		}
 		max_frames = last_frames;
 	} while (last_frames);
+	if (iu->hash.pruned_items)
+		printf("(%" PRIu64 " entries for less busy endpoints dropped)\n", iu->hash.pruned_items);
 	printf("================================================================================\n");
 }
 
@@ -106,9 +109,28 @@ void init_endpoints(struct register_ct *ct, const char *filter)
 
 	iu = g_new0(endpoints_t, 1);
 	iu->type = proto_get_protocol_short_name(find_protocol_by_id(get_conversation_proto_id(ct)));
-	iu->filter = g_strdup(filter);
 	iu->hash.user_data = iu;
 
+	/*
+	 * "top=<count>," in front of the filter keeps only the <count> or so
+	 * busiest endpoints, so that memory use is bounded however many
+	 * there are.
+	 */
+	if (filter && strncmp(filter, "top=", 4) == 0) {
+		const char *end;
+		guint32 max_items;
+
+		if (!ws_strtou32(filter + 4, &end, &max_items) || max_items == 0 ||
+		    (*end != '\0' && *end != ',')) {
+			g_free(iu);
+			cmdarg_err("Invalid \"top=\" count in \"%s\"", filter);
+			exit(1);
+		}
+		iu->hash.max_items = max_items;
+		filter = (*end == ',') ? end + 1 : NULL;
+	}
+	iu->filter = g_strdup(filter);
+
 	error_string = register_tap_listener(proto_get_protocol_filter_name(get_conversation_proto_id(ct)), &iu->hash, filter, 0, NULL, get_endpoint_packet_func(ct), endpoints_draw, NULL);
 	if (error_string) {
 		g_free(iu);
@@ -27,8 +27,9 @@
 #include "tap-exportobject.h"
 
 typedef struct _export_object_list_gui_t {
-    GSList *entries;
+    GPtrArray *entries;
     register_eo_t* eo;
+    const gchar *save_in_path;
 } export_object_list_gui_t;
 
 static GHashTable* eo_opts = NULL;
@@ -82,19 +83,61 @@ gboolean eo_tap_opt_add(const char *option_string)
     return FALSE;
 }
 
+static void
+eo_save_entry(const gchar *save_in_path, export_object_entry_t *entry)
+{
+    GString *safe_filename = NULL;
+    gchar *save_as_fullpath = NULL;
+    guint count = 0;
+
+    do {
+        g_free(save_as_fullpath);
+        if (entry->filename) {
+            safe_filename = eo_massage_str(entry->filename,
+                EXPORT_OBJECT_MAXFILELEN, count);
+        } else {
+            char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
+            const char *ext;
+            ext = eo_ct2ext(entry->content_type);
+            snprintf(generic_name, sizeof(generic_name),
+                "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
+            safe_filename = eo_massage_str(generic_name,
+                EXPORT_OBJECT_MAXFILELEN, count);
+        }
+        save_as_fullpath = g_build_filename(save_in_path, safe_filename->str, NULL);
+        g_string_free(safe_filename, TRUE);
+    } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < prefs.gui_max_export_objects);
+    write_file_binary_mode(save_as_fullpath, entry->payload_data, entry->payload_len);
+    g_free(save_as_fullpath);
+}
+
 static void
 object_list_add_entry(void *gui_data, export_object_entry_t *entry)
 {
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)gui_data;
 
-    object_list->entries = g_slist_append(object_list->entries, entry);
+    /*
+     * Unless the dissector goes back to entries it has already added,
+     * write each object out as soon as it's complete rather than holding
+     * all of them, and their payloads, in memory until the end.
+     */
+    if (!get_eo_entries_updated(object_list->eo)) {
+        eo_save_entry(object_list->save_in_path, entry);
+        eo_free_entry(entry);
+        return;
+    }
+
+    g_ptr_array_add(object_list->entries, entry);
 }
 
 static export_object_entry_t*
 object_list_get_entry(void *gui_data, int row) {
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)gui_data;
 
-    return (export_object_entry_t *)g_slist_nth_data(object_list->entries, row);
+    if (row < 0 || (guint)row >= object_list->entries->len)
+        return NULL;
+
+    return (export_object_entry_t *)g_ptr_array_index(object_list->entries, row);
 }
 
 /* This is just for writing Exported Objects to a file */
@@ -103,56 +146,22 @@ eo_draw(void *tapdata)
 {
     export_object_list_t *tap_object = (export_object_list_t *)tapdata;
     export_object_list_gui_t *object_list = (export_object_list_gui_t*)tap_object->gui_data;
-    GSList *slist = object_list->entries;
-    export_object_entry_t *entry;
-    gchar* save_in_path = (gchar*)g_hash_table_lookup(eo_opts, proto_get_protocol_filter_name(get_eo_proto_id(object_list->eo)));
-    GString *safe_filename = NULL;
-    gchar *save_as_fullpath = NULL;
-    guint count = 0;
-
-    if (!g_file_test(save_in_path, G_FILE_TEST_IS_DIR)) {
-        /* If the destination directory (or its parents) do not exist, create them. */
-        if (g_mkdir_with_parents(save_in_path, 0755) == -1) {
-            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
-                    save_in_path, g_strerror(errno));
-            return;
-        }
-    }
+    guint i;
 
-    while (slist) {
-        entry = (export_object_entry_t *)slist->data;
-        do {
-            g_free(save_as_fullpath);
-            if (entry->filename) {
-                safe_filename = eo_massage_str(entry->filename,
-                    EXPORT_OBJECT_MAXFILELEN, count);
-            } else {
-                char generic_name[EXPORT_OBJECT_MAXFILELEN+1];
-                const char *ext;
-                ext = eo_ct2ext(entry->content_type);
-                snprintf(generic_name, sizeof(generic_name),
-                    "object%u%s%s", entry->pkt_num, ext ? "." : "", ext ? ext : "");
-                safe_filename = eo_massage_str(generic_name,
-                    EXPORT_OBJECT_MAXFILELEN, count);
-            }
-            save_as_fullpath = g_build_filename(save_in_path, safe_filename->str, NULL);
-            g_string_free(safe_filename, TRUE);
-        } while (g_file_test(save_as_fullpath, G_FILE_TEST_EXISTS) && ++count < prefs.gui_max_export_objects);
-        count = 0;
-        write_file_binary_mode(save_as_fullpath, entry->payload_data, entry->payload_len);
-        g_free(save_as_fullpath);
-        save_as_fullpath = NULL;
-        slist = slist->next;
+    for (i = 0; i < object_list->entries->len; i++) {
+        eo_save_entry(object_list->save_in_path,
+                      (export_object_entry_t *)g_ptr_array_index(object_list->entries, i));
     }
 }
 
 static void
-exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
+exportobject_handler(gpointer key, gpointer value, gpointer user_data _U_)
 {
     GString *error_msg;
     export_object_list_t *tap_data;
     export_object_list_gui_t *object_list;
     register_eo_t* eo;
+    const gchar *save_in_path = (const gchar *)value;
 
     eo = get_eo_by_name((const char*)key);
     if (eo == NULL)
@@ -161,6 +170,16 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
         return;
     }
 
+    /* Objects can be written as they're found, so create the directory now. */
+    if (!g_file_test(save_in_path, G_FILE_TEST_IS_DIR)) {
+        /* If the destination directory (or its parents) do not exist, create them. */
+        if (g_mkdir_with_parents(save_in_path, 0755) == -1) {
+            fprintf(stderr, "Failed to create export objects output directory \"%s\": %s\n",
+                    save_in_path, g_strerror(errno));
+            return;
+        }
+    }
+
     tap_data = g_new0(export_object_list_t,1);
     object_list = g_new0(export_object_list_gui_t,1);
 
@@ -169,6 +188,8 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
     tap_data->gui_data = (void*)object_list;
 
     object_list->eo = eo;
+    object_list->save_in_path = save_in_path;
+    object_list->entries = g_ptr_array_new();
 
     /* Data will be gathered via a tap callback */
     error_msg = register_tap_listener(get_eo_tap_listener_name(eo), tap_data, NULL, 0,
@@ -178,6 +199,7 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
         cmdarg_err("Can't register %s tap: %s", (const char*)key, error_msg->str);
         g_string_free(error_msg, TRUE);
         g_free(tap_data);
+        g_ptr_array_free(object_list->entries, TRUE);
         g_free(object_list);
         return;
     }
@@ -170,6 +170,7 @@ commandline_print_usage(gboolean for_help_option) {
 #endif
     fprintf(output, "  --temp-dir <directory>   write temporary files to this directory\n");
     fprintf(output, "                           (default: %s)\n", g_get_tmp_dir());
+    fprintf(output, "  --live-shm               also pass live capture data via shared memory\n");
     fprintf(output, "\n");
 
     ws_log_print_usage(output);
@@ -438,6 +439,7 @@ void commandline_other_options(int argc, char *argv[], gboolean opt_reset)
             case 'i':        /* Use interface x */
             case LONGOPT_SET_TSTAMP_TYPE: /* Set capture timestamp type */
             case LONGOPT_CAPTURE_TMPDIR: /* capture temp directory */
+            case LONGOPT_LIVE_SHM:       /* live capture in shared memory */
 #ifdef HAVE_PCAP_CREATE
             case 'I':        /* Capture in monitor mode, if available */
 #endif
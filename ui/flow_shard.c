@@ -0,0 +1,440 @@
+/* flow_shard.c
+ * Assigning records to flow shards
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/aftypes.h>
+#include <epan/ipproto.h>
+#include <epan/etypes.h>
+
+#include <wsutil/pint.h>
+
+#include "flow_shard.h"
+
+#define SLL_HEADER_LEN      16
+#define SLL2_HEADER_LEN     20
+#define NULL_HEADER_LEN     4
+#define ETH_HEADER_LEN      14
+#define VLAN_TAG_LEN        4
+#define IPV4_MIN_HEADER_LEN 20
+#define IPV6_HEADER_LEN     40
+
+/*
+ * What's known about an IP fragment.  Only the first fragment of a
+ * datagram has the transport header, so the rest are matched up with it
+ * by their addresses, protocol and identification.
+ */
+typedef struct {
+    gboolean      is_fragment;
+    gboolean      is_first;     /* fragment offset 0 */
+    gboolean      is_last;      /* more fragments flag clear */
+    const guint8 *ident;
+    guint         ident_len;
+} ip_frag_info_t;
+
+/*
+ * The shards of fragmented datagrams whose first fragment has been seen,
+ * plus 1, so that the fragments after the first one, which don't have the
+ * ports, go in the same shard as it and the rest of its flow.  Every
+ * worker sees every record, in order, so they all end up with the same
+ * entries.  Entries are removed when the last fragment is seen; the table
+ * is emptied if it grows past MAX_FRAG_DATAGRAMS, in case many datagrams
+ * never get theirs.
+ */
+static GHashTable *frag_datagrams;
+
+#define MAX_FRAG_DATAGRAMS  65536
+
+typedef struct {
+    const guint8 *addr;
+    guint16       port;
+} flow_endpoint_t;
+
+static guint
+add_bytes_to_hash(guint hash_val, const guint8 *data, guint len)
+{
+    guint idx;
+
+    /* The same one-at-a-time hash add_address_to_hash() uses. */
+    for (idx = 0; idx < len; idx++) {
+        hash_val += data[idx];
+        hash_val += ( hash_val << 10 );
+        hash_val ^= ( hash_val >> 6 );
+    }
+    return hash_val;
+}
+
+static guint
+add_endpoint_to_hash(guint hash_val, const flow_endpoint_t *ep, guint addr_len)
+{
+    guint8 port[2];
+
+    hash_val = add_bytes_to_hash(hash_val, ep->addr, addr_len);
+    phton16(port, ep->port);
+    return add_bytes_to_hash(hash_val, port, sizeof port);
+}
+
+/*
+ * Hash a conversation, with the endpoints in a canonical order, so that
+ * both directions hash the same.
+ */
+static guint
+conversation_hash(guint8 proto, flow_endpoint_t *a, flow_endpoint_t *b,
+    guint addr_len)
+{
+    int cmp;
+    guint hash_val = 0;
+
+    cmp = memcmp(a->addr, b->addr, addr_len);
+    if (cmp > 0 || (cmp == 0 && a->port > b->port)) {
+        flow_endpoint_t *tmp = a;
+        a = b;
+        b = tmp;
+    }
+    hash_val = add_bytes_to_hash(hash_val, &proto, 1);
+    hash_val = add_endpoint_to_hash(hash_val, a, addr_len);
+    hash_val = add_endpoint_to_hash(hash_val, b, addr_len);
+
+    hash_val += ( hash_val << 3 );
+    hash_val ^= ( hash_val >> 11 );
+    hash_val += ( hash_val << 15 );
+
+    return hash_val;
+}
+
+static gboolean
+proto_has_ports(guint8 proto)
+{
+    switch (proto) {
+
+    case IP_PROTO_TCP:
+    case IP_PROTO_UDP:
+    case IP_PROTO_SCTP:
+    case IP_PROTO_DCCP:
+    case IP_PROTO_UDPLITE:
+        /* All of these start with the source and destination ports. */
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+
+/* Identify a fragmented datagram, in the same way in either direction. */
+static GBytes *
+datagram_key(guint8 proto, const guint8 *src, const guint8 *dst,
+    guint addr_len, const ip_frag_info_t *frag)
+{
+    GByteArray *key = g_byte_array_sized_new(1 + frag->ident_len + 2 * addr_len);
+
+    if (memcmp(src, dst, addr_len) > 0) {
+        const guint8 *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    g_byte_array_append(key, &proto, 1);
+    g_byte_array_append(key, frag->ident, frag->ident_len);
+    g_byte_array_append(key, src, addr_len);
+    g_byte_array_append(key, dst, addr_len);
+    return g_byte_array_free_to_bytes(key);
+}
+
+/*
+ * Shard an IP packet, given its upper-layer protocol, addresses, what's
+ * known about it if it's a fragment, and the transport header, if it
+ * has one.
+ */
+static guint
+shard_of_ip(guint8 proto, const guint8 *src, const guint8 *dst,
+    guint addr_len, const ip_frag_info_t *frag, const guint8 *transport,
+    guint transport_len, guint n_shards, const range_t *serial_ports)
+{
+    flow_endpoint_t a, b;
+    GBytes *key;
+    guint shard;
+
+    a.addr = src;
+    a.port = 0;
+    b.addr = dst;
+    b.port = 0;
+
+    if (frag->is_fragment && !frag->is_first) {
+        /*
+         * Go in the same shard as the first fragment.  If it hasn't been
+         * seen, as when fragments arrive out of order, fall back on the
+         * addresses and protocol alone; the flow may then be split.
+         */
+        key = datagram_key(proto, src, dst, addr_len, frag);
+        shard = frag_datagrams != NULL ?
+            GPOINTER_TO_UINT(g_hash_table_lookup(frag_datagrams, key)) : 0;
+        if (shard != 0 && frag->is_last)
+            g_hash_table_remove(frag_datagrams, key);
+        g_bytes_unref(key);
+        if (shard != 0)
+            return shard - 1;
+        return conversation_hash(proto, &a, &b, addr_len) % n_shards;
+    }
+
+    shard = G_MAXUINT;
+    if (proto_has_ports(proto) && transport_len >= 4) {
+        a.port = pntoh16(transport);
+        b.port = pntoh16(transport + 2);
+        if (serial_ports != NULL &&
+            (value_is_in_range(serial_ports, a.port) ||
+             value_is_in_range(serial_ports, b.port)))
+            shard = 0;
+    }
+    if (shard == G_MAXUINT)
+        shard = conversation_hash(proto, &a, &b, addr_len) % n_shards;
+
+    if (frag->is_fragment) {
+        /* The first fragment of a datagram; remember where it went. */
+        if (frag_datagrams == NULL)
+            frag_datagrams = g_hash_table_new_full(g_bytes_hash,
+                g_bytes_equal, (GDestroyNotify)g_bytes_unref, NULL);
+        else if (g_hash_table_size(frag_datagrams) >= MAX_FRAG_DATAGRAMS)
+            g_hash_table_remove_all(frag_datagrams);
+        g_hash_table_insert(frag_datagrams,
+            datagram_key(proto, src, dst, addr_len, frag),
+            GUINT_TO_POINTER(shard + 1));
+    }
+    return shard;
+}
+
+static guint
+shard_of_ipv4(const guint8 *pd, guint len, guint n_shards,
+    const range_t *serial_ports)
+{
+    guint hlen;
+    guint16 off;
+    ip_frag_info_t frag;
+
+    if (len < IPV4_MIN_HEADER_LEN || (pd[0] >> 4) != 4)
+        return 0;
+    hlen = (pd[0] & 0x0F) * 4;
+    if (hlen < IPV4_MIN_HEADER_LEN || hlen > len)
+        return 0;
+    /* More fragments set, or a non-zero fragment offset. */
+    off = pntoh16(pd + 6);
+    frag.is_fragment = (off & 0x3FFF) != 0;
+    frag.is_first = (off & 0x1FFF) == 0;
+    frag.is_last = (off & 0x2000) == 0;
+    frag.ident = pd + 4;
+    frag.ident_len = 2;
+    return shard_of_ip(pd[9], pd + 12, pd + 16, 4, &frag,
+        pd + hlen, len - hlen, n_shards, serial_ports);
+}
+
+static guint
+shard_of_ipv6(const guint8 *pd, guint len, guint n_shards,
+    const range_t *serial_ports)
+{
+    guint8 nxt;
+    guint offset, ext_len;
+    guint16 off;
+    ip_frag_info_t frag;
+
+    if (len < IPV6_HEADER_LEN || (pd[0] >> 4) != 6)
+        return 0;
+    memset(&frag, 0, sizeof frag);
+    nxt = pd[6];
+    offset = IPV6_HEADER_LEN;
+    for (;;) {
+        switch (nxt) {
+
+        case IP_PROTO_HOPOPTS:
+        case IP_PROTO_ROUTING:
+        case IP_PROTO_DSTOPTS:
+            if (len - offset < 2)
+                return 0;
+            ext_len = (pd[offset + 1] + 1) * 8;
+            break;
+
+        case IP_PROTO_AH:
+            if (len - offset < 2)
+                return 0;
+            ext_len = (pd[offset + 1] + 2) * 4;
+            break;
+
+        case IP_PROTO_FRAGMENT:
+            if (len - offset < 8)
+                return 0;
+            off = pntoh16(pd + offset + 2);
+            frag.is_fragment = TRUE;
+            frag.is_first = (off & 0xFFF8) == 0;
+            frag.is_last = (off & 0x0001) == 0;
+            frag.ident = pd + offset + 4;
+            frag.ident_len = 4;
+            if (!frag.is_first) {
+                /*
+                 * What follows is the middle of the datagram, not more
+                 * headers, so go by the header that the fragment header
+                 * says comes next.  That's the upper-layer protocol, unless
+                 * there are more extension headers in the fragmentable
+                 * part; they're rare enough not to worry about.
+                 */
+                return shard_of_ip(pd[offset], pd + 8, pd + 24, 16, &frag,
+                    NULL, 0, n_shards, serial_ports);
+            }
+            ext_len = 8;
+            break;
+
+        default:
+            return shard_of_ip(nxt, pd + 8, pd + 24, 16, &frag, pd + offset,
+                len - offset, n_shards, serial_ports);
+        }
+        if (ext_len > len - offset)
+            return 0;
+        nxt = pd[offset];
+        offset += ext_len;
+    }
+}
+
+static guint
+shard_of_ethertype(guint16 etype, const guint8 *pd, guint len,
+    guint n_shards, const range_t *serial_ports)
+{
+    switch (etype) {
+
+    case ETHERTYPE_IP:
+        return shard_of_ipv4(pd, len, n_shards, serial_ports);
+
+    case ETHERTYPE_IPv6:
+        return shard_of_ipv6(pd, len, n_shards, serial_ports);
+
+    default:
+        return 0;
+    }
+}
+
+static guint
+shard_of_raw_ip(const guint8 *pd, guint len, guint n_shards,
+    const range_t *serial_ports)
+{
+    if (len < 1)
+        return 0;
+    switch (pd[0] >> 4) {
+
+    case 4:
+        return shard_of_ipv4(pd, len, n_shards, serial_ports);
+
+    case 6:
+        return shard_of_ipv6(pd, len, n_shards, serial_ports);
+
+    default:
+        return 0;
+    }
+}
+
+static gboolean
+is_af_inet6(guint32 af)
+{
+    switch (af) {
+
+    case BSD_AF_INET6_BSD:
+    case BSD_AF_INET6_FREEBSD:
+    case BSD_AF_INET6_DARWIN:
+    case LINUX_AF_INET6:
+    case SOLARIS_AF_INET6:
+    case WINSOCK_AF_INET6:
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+
+guint
+flow_shard_of_record(const wtap_rec *rec, const guint8 *pd, guint n_shards,
+    const range_t *serial_ports)
+{
+    guint len;
+    guint offset;
+    guint16 etype;
+    guint32 af;
+
+    if (n_shards <= 1 || rec->rec_type != REC_TYPE_PACKET)
+        return 0;
+    len = rec->rec_header.packet_header.caplen;
+
+    switch (rec->rec_header.packet_header.pkt_encap) {
+
+    case WTAP_ENCAP_ETHERNET:
+        if (len < ETH_HEADER_LEN)
+            return 0;
+        offset = ETH_HEADER_LEN;
+        etype = pntoh16(pd + 12);
+        while (etype == ETHERTYPE_VLAN || etype == ETHERTYPE_IEEE_802_1AD ||
+               etype == ETHERTYPE_QINQ_OLD) {
+            if (len - offset < VLAN_TAG_LEN)
+                return 0;
+            etype = pntoh16(pd + offset + 2);
+            offset += VLAN_TAG_LEN;
+        }
+        return shard_of_ethertype(etype, pd + offset, len - offset,
+            n_shards, serial_ports);
+
+    case WTAP_ENCAP_SLL:
+        if (len < SLL_HEADER_LEN)
+            return 0;
+        return shard_of_ethertype(pntoh16(pd + 14), pd + SLL_HEADER_LEN,
+            len - SLL_HEADER_LEN, n_shards, serial_ports);
+
+    case WTAP_ENCAP_SLL2:
+        if (len < SLL2_HEADER_LEN)
+            return 0;
+        return shard_of_ethertype(pntoh16(pd), pd + SLL2_HEADER_LEN,
+            len - SLL2_HEADER_LEN, n_shards, serial_ports);
+
+    case WTAP_ENCAP_NULL:
+    case WTAP_ENCAP_LOOP:
+        /*
+         * The address family is in the byte order of the machine that
+         * did the capture for NULL, and big-endian for LOOP; try both.
+         */
+        if (len < NULL_HEADER_LEN)
+            return 0;
+        af = pntoh32(pd);
+        if (af > 0xFFFF)
+            af = pletoh32(pd);
+        if (af == COMMON_AF_INET)
+            return shard_of_ipv4(pd + NULL_HEADER_LEN, len - NULL_HEADER_LEN,
+                n_shards, serial_ports);
+        if (is_af_inet6(af))
+            return shard_of_ipv6(pd + NULL_HEADER_LEN, len - NULL_HEADER_LEN,
+                n_shards, serial_ports);
+        return 0;
+
+    case WTAP_ENCAP_RAW_IP:
+        return shard_of_raw_ip(pd, len, n_shards, serial_ports);
+
+    case WTAP_ENCAP_RAW_IP4:
+        return shard_of_ipv4(pd, len, n_shards, serial_ports);
+
+    case WTAP_ENCAP_RAW_IP6:
+        return shard_of_ipv6(pd, len, n_shards, serial_ports);
+
+    default:
+        return 0;
+    }
+}
+
+void
+flow_shard_cleanup(void)
+{
+    if (frag_datagrams != NULL) {
+        g_hash_table_destroy(frag_datagrams);
+        frag_datagrams = NULL;
+    }
+}
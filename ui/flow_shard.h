@@ -0,0 +1,60 @@
+/** @file
+ *
+ * Assigning records to flow shards
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FLOW_SHARD_H__
+#define __FLOW_SHARD_H__
+
+#include <wiretap/wtap.h>
+#include <epan/range.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Work out which of n_shards shards a record belongs to, so that all the
+ * records of a conversation, in either direction, end up in the same
+ * shard.
+ *
+ * This looks only at the raw packet data, as it has to be done before
+ * the record is dissected; it understands Ethernet (including VLAN tags),
+ * Linux cooked captures, BSD loopback and raw IP, and IPv4 and IPv6 with
+ * TCP, UDP, SCTP, DCCP or UDP-Lite on top of them, whose ports are part
+ * of the conversation.  The fragments of an IP datagram after the first
+ * one don't have the ports, so they go in the same shard as the first
+ * one, and so as the rest of the flow; this must therefore be called for
+ * every record, in order.  Fragments seen before the first fragment of
+ * their datagram are sharded by their addresses and protocol alone.
+ *
+ * Records that don't look like that (and non-packet records), and packets
+ * with a port in serial_ports, which should be used for protocols whose
+ * state spans conversations, are all put in shard 0.
+ *
+ * @param rec The record.
+ * @param pd The record's data.
+ * @param n_shards The number of shards.
+ * @param serial_ports Ports whose packets all go in shard 0, or NULL.
+ * @return The shard, from 0 to n_shards - 1.
+ */
+extern guint flow_shard_of_record(const wtap_rec *rec, const guint8 *pd,
+    guint n_shards, const range_t *serial_ports);
+
+/**
+ * Free what flow_shard_of_record() has remembered about fragmented
+ * datagrams.
+ */
+extern void flow_shard_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FLOW_SHARD_H__ */
@@ -263,3 +263,88 @@ double get_io_graph_item(const io_graph_item_t *items_, io_graph_item_unit_t val
     }
     return value;
 }
+
+void merge_io_graph_item(io_graph_item_t *item, const io_graph_item_t *from, int hf_index, io_graph_item_unit_t item_unit)
+{
+    gboolean new_max = FALSE;
+    gboolean new_min = FALSE;
+
+    if (from->first_frame_in_invl != 0) {
+        if (item->first_frame_in_invl == 0) {
+            item->first_frame_in_invl = from->first_frame_in_invl;
+        }
+        item->last_frame_in_invl = from->last_frame_in_invl;
+    }
+    item->frames += from->frames;
+    item->bytes += from->bytes;
+
+    /* LOAD spreads a call's time over the intervals it spans, including
+     * ones with no frames of their own. */
+    nstime_add(&item->time_tot, &from->time_tot);
+
+    if (from->fields == 0 || hf_index < 0) {
+        return;
+    }
+
+    switch (proto_registrar_get_ftype(hf_index)) {
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+    case FT_UINT40:
+    case FT_UINT48:
+    case FT_UINT56:
+    case FT_UINT64:
+        new_max = (guint64)from->int_max > (guint64)item->int_max;
+        new_min = (guint64)from->int_min < (guint64)item->int_min;
+        break;
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        new_max = from->int_max > item->int_max;
+        new_min = from->int_min < item->int_min;
+        break;
+    case FT_FLOAT:
+        new_max = from->float_max > item->float_max;
+        new_min = from->float_min < item->float_min;
+        break;
+    case FT_DOUBLE:
+        new_max = from->double_max > item->double_max;
+        new_min = from->double_min < item->double_min;
+        break;
+    case FT_RELATIVE_TIME:
+        new_max = nstime_cmp(&from->time_max, &item->time_max) > 0;
+        new_min = nstime_cmp(&from->time_min, &item->time_min) < 0;
+        break;
+    default:
+        break;
+    }
+
+    if (new_max || item->fields == 0) {
+        item->int_max = from->int_max;
+        item->float_max = from->float_max;
+        item->double_max = from->double_max;
+        item->time_max = from->time_max;
+        if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+            item->extreme_frame_in_invl = from->extreme_frame_in_invl;
+        }
+    }
+    if (new_min || item->fields == 0) {
+        item->int_min = from->int_min;
+        item->float_min = from->float_min;
+        item->double_min = from->double_min;
+        item->time_min = from->time_min;
+        if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+            item->extreme_frame_in_invl = from->extreme_frame_in_invl;
+        }
+    }
+    item->int_tot += from->int_tot;
+    item->float_tot += from->float_tot;
+    item->double_tot += from->double_tot;
+    item->fields += from->fields;
+}
@@ -128,6 +128,15 @@ GString *check_field_unit(const char *field_name, int *hf_index, io_graph_item_u
  */
 double get_io_graph_item(const io_graph_item_t *items, io_graph_item_unit_t val_units, int idx, int hf_index, const capture_file *cap_file, int interval, int cur_idx);
 
+/** Add the values of one io_graph_item_t to another, e.g. to make a longer
+ * interval out of several shorter ones. The items must be merged in order.
+ * @param item [in,out] Item to update.
+ * @param from [in] Item to add to it.
+ * @param hf_index [in] Header field index for advanced statistics.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ */
+void merge_io_graph_item(io_graph_item_t *item, const io_graph_item_t *from, int hf_index, io_graph_item_unit_t item_unit);
+
 /** Update the values of an io_graph_item_t.
  *
  * Frame and byte counts are always calculated. If edt is non-NULL advanced
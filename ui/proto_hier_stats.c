@@ -159,9 +159,8 @@ process_tree(proto_tree *protocol_tree, ph_stats_t* ps)
 
     static gboolean
 process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
-               wtap_rec *rec, Buffer *buf, ph_stats_t* ps)
+               wtap_rec *rec, Buffer *buf, epan_dissect_t *edt, ph_stats_t* ps)
 {
-    epan_dissect_t	edt;
     double		cur_time;
 
     /* Load the record from the capture file */
@@ -169,15 +168,12 @@ process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
         return FALSE;	/* failure */
 
     /* Dissect the record   tree  not visible */
-    epan_dissect_init(&edt, cf->epan, TRUE, FALSE);
-    /* Don't fake protocols. We need them for the protocol hierarchy */
-    epan_dissect_fake_protocols(&edt, FALSE);
-    epan_dissect_run(&edt, cf->cd_t, rec,
+    epan_dissect_run(edt, cf->cd_t, rec,
                      frame_tvbuff_new_buffer(&cf->provider, frame, buf),
                      frame, cinfo);
 
     /* Get stats from this protocol tree */
-    process_tree(edt.tree, ps);
+    process_tree(edt->tree, ps);
 
     if (frame->has_ts) {
         /* Update times */
@@ -188,8 +184,8 @@ process_record(capture_file *cf, frame_data *frame, column_info *cinfo,
             ps->last_time = cur_time;
     }
 
-    /* Free our memory. */
-    epan_dissect_cleanup(&edt);
+    /* Free our memory, keeping the tree and allocators for the next record. */
+    epan_dissect_reset(edt);
 
     return TRUE;	/* success */
 }
@@ -205,6 +201,7 @@ ph_stats_new(capture_file *cf)
     int		count;
     wtap_rec	rec;
     Buffer	buf;
+    epan_dissect_t	edt;
     float	progbar_val;
     gchar	status_str[100];
     int		progbar_nextstep;
@@ -237,6 +234,15 @@ ph_stats_new(capture_file *cf)
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
 
+    /*
+     * Set up the dissection once and reset it after each record, rather
+     * than creating and freeing a tree for every record.  The tree isn't
+     * visible, so most items other than protocols are never created.
+     */
+    epan_dissect_init(&edt, cf->epan, TRUE, FALSE);
+    /* Don't fake protocols. We need them for the protocol hierarchy */
+    epan_dissect_fake_protocols(&edt, FALSE);
+
     for (framenum = 1; framenum <= cf->count; framenum++) {
         frame = frame_data_sequence_find(cf->provider.frames, framenum);
 
@@ -304,7 +310,7 @@ ph_stats_new(capture_file *cf)
             ps->tot_packets++;
 
             /* we don't care about colinfo */
-            if (!process_record(cf, frame, NULL, &rec, &buf, ps)) {
+            if (!process_record(cf, frame, NULL, &rec, &buf, &edt, ps)) {
                 /*
                  * Give up, and set "stop_flag" so we
                  * just abort rather than popping up
@@ -320,6 +326,7 @@ ph_stats_new(capture_file *cf)
         count++;
     }
 
+    epan_dissect_cleanup(&edt);
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
 
@@ -34,7 +34,9 @@ ByteViewTab::ByteViewTab(QWidget *parent, epan_dissect_t *edt_fixed) :
     cap_file_(0),
     is_fixed_packet_(edt_fixed != NULL),
     edt_(edt_fixed),
-    disable_hover_(false)
+    disable_hover_(false),
+    field_map_tvb_(NULL),
+    field_map_tree_(NULL)
 {
     setAccessibleName(tr("Packet bytes"));
     setTabPosition(QTabWidget::South);
@@ -134,7 +136,7 @@ void ByteViewTab::byteViewTextHovered(int idx)
 
         if (tvb && tree)
         {
-            field_info * fi = proto_find_field_from_offset(tree, idx, tvb);
+            field_info * fi = fieldAtOffset(tree, tvb, idx);
             if (fi)
             {
                 FieldInformation finfo(fi, this);
@@ -157,7 +159,7 @@ void ByteViewTab::byteViewTextMarked(int idx)
 
         if (tvb && tree)
         {
-            field_info * fi = proto_find_field_from_offset(tree, idx, tvb);
+            field_info * fi = fieldAtOffset(tree, tvb, idx);
             if (fi)
             {
                 FieldInformation finfo(fi, this);
@@ -170,6 +172,57 @@ void ByteViewTab::byteViewTextMarked(int idx)
     emit fieldSelected((FieldInformation *)0);
 }
 
+// Find the field at an offset in a tvb, as proto_find_field_from_offset
+// does: the last visible field in the tree, in pre-order, that covers it.
+// Rather than walking the whole tree each time the mouse moves, we walk it
+// once per tvb and record which field covers each stretch of the tvb.
+field_info * ByteViewTab::fieldAtOffset(proto_tree *tree, tvbuff_t *tvb, int offset)
+{
+    if (tvb != field_map_tvb_ || tree != field_map_tree_) {
+        field_map_.clear();
+        field_map_tvb_ = tvb;
+        field_map_tree_ = tree;
+        proto_tree_children_foreach(tree, addFieldToMap, this);
+    }
+
+    QMap<int, field_info *>::const_iterator it = field_map_.upperBound(offset);
+    if (it == field_map_.constBegin()) {
+        return NULL;
+    }
+    --it;
+    return it.value();
+}
+
+void ByteViewTab::addFieldToMap(proto_node *node, gpointer byte_view_tab_ptr)
+{
+    ByteViewTab *byte_view_tab = static_cast<ByteViewTab *>(byte_view_tab_ptr);
+    QMap<int, field_info *> &field_map = byte_view_tab->field_map_;
+    field_info *fi = PNODE_FINFO(node);
+
+    if (fi && !proto_item_is_hidden(node) && !proto_item_is_generated(node) &&
+            fi->ds_tvb && fi->ds_tvb == byte_view_tab->field_map_tvb_ &&
+            fi->start >= 0 && fi->length > 0) {
+        // Later fields take precedence, so this field covers start through
+        // end, and whatever covered end before goes on covering it.
+        int end = fi->start + fi->length;
+        QMap<int, field_info *>::iterator it = field_map.upperBound(end);
+        field_info *end_fi = NULL;
+        if (it != field_map.begin()) {
+            --it;
+            end_fi = it.value();
+        }
+        field_map.insert(end, end_fi);
+
+        it = field_map.lowerBound(fi->start);
+        while (it != field_map.end() && it.key() < end) {
+            it = field_map.erase(it);
+        }
+        field_map.insert(fi->start, fi);
+    }
+
+    proto_tree_children_foreach(node, addFieldToMap, byte_view_tab_ptr);
+}
+
 ByteViewText * ByteViewTab::findByteViewTextForTvb(tvbuff_t * search_tvb, int * idx)
 {
 
@@ -234,6 +287,9 @@ void ByteViewTab::selectedFrameChanged(QList<int> frames)
 {
     clear();
     qDeleteAll(findChildren<ByteViewText *>());
+    field_map_.clear();
+    field_map_tvb_ = NULL;
+    field_map_tree_ = NULL;
 
     if (!is_fixed_packet_) {
         /* If this is not a fixed packet (not the packet dialog), it must be the
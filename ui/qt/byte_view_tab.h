@@ -20,6 +20,7 @@
 
 #include "cfile.h"
 
+#include <QMap>
 #include <QTabWidget>
 
 
@@ -54,7 +55,12 @@ private:
                                packet dissection context can change. */
     epan_dissect_t *edt_;   /* Packet dissection result for the currently selected packet. */
     bool disable_hover_;
+    QMap<int, field_info *> field_map_;  /* Field covering each stretch of field_map_tvb_, by start offset. */
+    tvbuff_t *field_map_tvb_;
+    proto_tree *field_map_tree_;
 
+    field_info * fieldAtOffset(proto_tree *tree, tvbuff_t *tvb, int offset);
+    static void addFieldToMap(proto_node *node, gpointer byte_view_tab_ptr);
     void setTabsVisible();
     ByteViewText * findByteViewTextForTvb(tvbuff_t * search, int * idx = 0);
     void addTab(const char *name = "", tvbuff_t *tvb = NULL);
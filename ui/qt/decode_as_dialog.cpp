@@ -199,8 +199,11 @@ void DecodeAsDialog::on_clearToolButton_clicked()
 
 void DecodeAsDialog::applyChanges()
 {
-    model_->applyChanges();
-    mainApp->queueAppSignal(MainApplication::PacketDissectionChanged);
+    // Redissecting a big file takes a while; skip it if no packet
+    // looked up anything that has changed.
+    if (model_->applyChanges()) {
+        mainApp->queueAppSignal(MainApplication::PacketDissectionChanged);
+    }
 }
 
 void DecodeAsDialog::on_buttonBox_clicked(QAbstractButton *button)
@@ -0,0 +1,114 @@
+/* dissector_profile_dialog.cpp
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "dissector_profile_dialog.h"
+#include <ui_dissector_profile_dialog.h>
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <epan/proto.h>
+#include <epan/dissector_profile.h>
+
+#include <QPushButton>
+#include <QTreeWidgetItem>
+
+#include "main_application.h"
+
+enum {
+    col_dissector_,
+    col_calls_,
+    col_accepted_,
+    col_inclusive_,
+    col_exclusive_,
+    col_bytes_
+};
+
+DissectorProfileDialog::DissectorProfileDialog(QWidget *parent) :
+    GeometryStateDialog(parent),
+    ui(new Ui::DissectorProfileDialog)
+{
+    ui->setupUi(this);
+    if (parent) loadGeometry(parent->width() * 2 / 3, parent->height() * 3 / 4);
+    setAttribute(Qt::WA_DeleteOnClose, true);
+    setWindowTitle(mainApp->windowTitleString(tr("Dissector Profile")));
+
+    reset_button_ = ui->buttonBox->addButton(tr("Reset"), QDialogButtonBox::ActionRole);
+    reset_button_->setToolTip(tr("Forget what has been counted so far."));
+    connect(reset_button_, SIGNAL(clicked()), this, SLOT(resetProfile()));
+    refresh_button_ = ui->buttonBox->addButton(tr("Refresh"), QDialogButtonBox::ActionRole);
+    refresh_button_->setToolTip(tr("Show what has been counted so far."));
+    connect(refresh_button_, SIGNAL(clicked()), this, SLOT(fillTree()));
+
+    ui->enableCheckBox->setChecked(dissector_profile_is_enabled());
+    ui->profileTreeWidget->sortByColumn(col_exclusive_, Qt::DescendingOrder);
+
+    fillTree();
+    updateWidgets();
+}
+
+DissectorProfileDialog::~DissectorProfileDialog()
+{
+    delete ui;
+}
+
+void DissectorProfileDialog::on_enableCheckBox_toggled(bool checked)
+{
+    // Packets aren't dissected while we're handling a signal, so this is
+    // between packets.
+    dissector_profile_set_enabled(checked);
+    updateWidgets();
+}
+
+void DissectorProfileDialog::resetProfile()
+{
+    dissector_profile_reset();
+    fillTree();
+}
+
+void DissectorProfileDialog::fillTree()
+{
+    GArray *entries = dissector_profile_get_entries();
+
+    ui->profileTreeWidget->setSortingEnabled(false);
+    ui->profileTreeWidget->clear();
+    for (guint i = 0; i < entries->len; i++) {
+        dissector_profile_entry_t *entry = &g_array_index(entries, dissector_profile_entry_t, i);
+        QTreeWidgetItem *ti = new QTreeWidgetItem();
+        QString name;
+
+        if (entry->heur_short_name) {
+            name = tr("%1 (heuristic)").arg(entry->heur_short_name);
+        } else {
+            name = proto_get_protocol_short_name(find_protocol_by_id(entry->proto_id));
+        }
+        ti->setText(col_dissector_, name);
+        ti->setData(col_calls_, Qt::DisplayRole, (qulonglong)entry->calls);
+        ti->setData(col_accepted_, Qt::DisplayRole, (qulonglong)entry->accepted);
+        ti->setData(col_inclusive_, Qt::DisplayRole, entry->inclusive_ns / 1000000.0);
+        ti->setData(col_exclusive_, Qt::DisplayRole, entry->exclusive_ns / 1000000.0);
+        ti->setData(col_bytes_, Qt::DisplayRole, (qulonglong)entry->bytes_allocated);
+        for (int col = col_calls_; col <= col_bytes_; col++) {
+            ti->setTextAlignment(col, Qt::AlignRight);
+        }
+        ui->profileTreeWidget->addTopLevelItem(ti);
+    }
+    g_array_free(entries, TRUE);
+    ui->profileTreeWidget->setSortingEnabled(true);
+
+    for (int col = 0; col < ui->profileTreeWidget->columnCount(); col++) {
+        ui->profileTreeWidget->resizeColumnToContents(col);
+    }
+}
+
+void DissectorProfileDialog::updateWidgets()
+{
+    refresh_button_->setEnabled(ui->enableCheckBox->isChecked());
+}
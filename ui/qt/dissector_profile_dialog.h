@@ -0,0 +1,42 @@
+/** @file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef DISSECTOR_PROFILE_DIALOG_H
+#define DISSECTOR_PROFILE_DIALOG_H
+
+#include "geometry_state_dialog.h"
+
+namespace Ui {
+class DissectorProfileDialog;
+}
+
+class QPushButton;
+
+class DissectorProfileDialog : public GeometryStateDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DissectorProfileDialog(QWidget *parent = 0);
+    ~DissectorProfileDialog();
+
+private slots:
+    void on_enableCheckBox_toggled(bool checked);
+    void resetProfile();
+    void fillTree();
+
+private:
+    Ui::DissectorProfileDialog *ui;
+    QPushButton *reset_button_;
+    QPushButton *refresh_button_;
+
+    void updateWidgets();
+};
+
+#endif // DISSECTOR_PROFILE_DIALOG_H
@@ -75,6 +75,9 @@ FollowStreamDialog::FollowStreamDialog(QWidget &parent, CaptureFile &cf, follow_
     follower_(NULL),
     show_type_(SHOW_ASCII),
     truncated_(false),
+    pending_from_server_(FALSE),
+    pending_packet_num_(0),
+    pending_colorize_(FALSE),
     client_buffer_count_(0),
     server_buffer_count_(0),
     client_packet_count_(0),
@@ -562,6 +565,7 @@ FollowStreamDialog::readStream()
 
     ui->teStreamContent->clear();
     text_pos_to_packet_.clear();
+    pending_text_.clear();
 
     truncated_ = false;
     frs_return_t ret;
@@ -592,6 +596,7 @@ FollowStreamDialog::readStream()
         break;
     }
 
+    flushText();
     ui->teStreamContent->moveCursor(QTextCursor::Start);
 
     return ret;
@@ -604,12 +609,41 @@ FollowStreamDialog::followStream()
 }
 
 const int FollowStreamDialog::max_document_length_ = 500 * 1000 * 1000; // Just a guess
+const int FollowStreamDialog::max_pending_length_ = 1000 * 1000;
+
+// Inserting text into the document is slow, and showBuffer adds it a
+// line at a time for hex dumps and C arrays, so we collect the text of
+// each packet and insert it all at once.
 void FollowStreamDialog::addText(QString text, gboolean is_from_server, guint32 packet_num, gboolean colorize)
 {
     if (truncated_) {
         return;
     }
 
+    if (!pending_text_.isEmpty() && (is_from_server != pending_from_server_
+            || packet_num != pending_packet_num_ || colorize != pending_colorize_)) {
+        flushText();
+    }
+
+    pending_text_ += text;
+    pending_from_server_ = is_from_server;
+    pending_packet_num_ = packet_num;
+    pending_colorize_ = colorize;
+
+    if (pending_text_.length() >= max_pending_length_) {
+        flushText();
+    }
+}
+
+void FollowStreamDialog::flushText()
+{
+    if (truncated_ || pending_text_.isEmpty()) {
+        return;
+    }
+
+    QString text = pending_text_;
+    pending_text_.clear();
+
     int char_count = ui->teStreamContent->document()->characterCount();
     if (char_count + text.length() > max_document_length_) {
         text.truncate(max_document_length_ - char_count);
@@ -621,10 +655,10 @@ void FollowStreamDialog::addText(QString text, gboolean is_from_server, guint32
     ui->teStreamContent->moveCursor(QTextCursor::End);
 
     QTextCharFormat tcf = ui->teStreamContent->currentCharFormat();
-    if (!colorize) {
+    if (!pending_colorize_) {
         tcf.setBackground(palette().window().color());
         tcf.setForeground(palette().windowText().color());
-    } else if (is_from_server) {
+    } else if (pending_from_server_) {
         tcf.setForeground(ColorUtils::fromColorT(prefs.st_server_fg));
         tcf.setBackground(ColorUtils::fromColorT(prefs.st_server_bg));
     } else {
@@ -634,7 +668,7 @@ void FollowStreamDialog::addText(QString text, gboolean is_from_server, guint32
     ui->teStreamContent->setCurrentCharFormat(tcf);
 
     ui->teStreamContent->insertPlainText(text);
-    text_pos_to_packet_[ui->teStreamContent->textCursor().anchor()] = packet_num;
+    text_pos_to_packet_[ui->teStreamContent->textCursor().anchor()] = pending_packet_num_;
 
     if (truncated_) {
         tcf = ui->teStreamContent->currentCharFormat();
@@ -1225,6 +1259,7 @@ FollowStreamDialog::readFollowStream()
             if (frs_return == FRS_PRINT_ERROR)
                 return frs_return;
             if (elapsed_timer.elapsed() > info_update_freq_) {
+                flushText();
                 fillHintLabel(ui->teStreamContent->textCursor().position());
                 mainApp->processEvents();
                 elapsed_timer.start();
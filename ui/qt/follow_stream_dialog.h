@@ -92,6 +92,7 @@ private:
 
     void followStream();
     void addText(QString text, gboolean is_from_server, guint32 packet_num, gboolean colorize = true);
+    void flushText();
 
     Ui::FollowStreamDialog  *ui;
 
@@ -107,7 +108,12 @@ private:
     show_type_t             show_type_;
     QString                 data_out_filename_;
     static const int        max_document_length_;
+    static const int        max_pending_length_;
     bool                    truncated_;
+    QString                 pending_text_;
+    gboolean                pending_from_server_;
+    guint32                 pending_packet_num_;
+    gboolean                pending_colorize_;
     QString                 previous_filter_;
     QString                 filter_out_filter_;
     QString                 output_filter_;
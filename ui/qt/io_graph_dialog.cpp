@@ -1239,14 +1239,19 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 {
     int interval = ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt();
     bool need_retap = false;
+    bool need_recalc = false;
 
     if (uat_model_ != NULL) {
         for (int row = 0; row < uat_model_->rowCount(); row++) {
             IOGraph *iog = ioGraphs_.value(row, NULL);
             if (iog) {
-                iog->setInterval(interval);
+                bool merged = iog->setInterval(interval);
                 if (iog->visible()) {
-                    need_retap = true;
+                    if (merged) {
+                        need_recalc = true;
+                    } else {
+                        need_retap = true;
+                    }
                 }
             }
         }
@@ -1254,6 +1259,8 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 
     if (need_retap) {
         scheduleRetap(true);
+    } else if (need_recalc) {
+        scheduleRecalc(true);
     }
 
     updateLegend();
@@ -2157,9 +2164,38 @@ bool IOGraph::hasItemToShow(int idx, double value) const
     return result;
 }
 
-void IOGraph::setInterval(int interval)
+// Returns false if the packets have to be tapped again for the new
+// interval. If it's a multiple of the old one we can work out the new
+// intervals by merging the ones we have instead.
+bool IOGraph::setInterval(int interval)
 {
+    int old_interval = interval_;
+
     interval_ = interval;
+    if (interval == old_interval || cur_idx_ < 0) {
+        return true;
+    }
+
+    // If cur_idx_ hit the end some packets didn't fit.
+    if (old_interval <= 0 || interval % old_interval != 0 || cur_idx_ >= max_io_items_ - 1) {
+        return false;
+    }
+
+    int factor = interval / old_interval;
+    int new_cur_idx = cur_idx_ / factor;
+    for (int idx = 0; idx <= cur_idx_; idx++) {
+        // Every item we write to has already been read.
+        io_graph_item_t item = items_[idx];
+        if (idx % factor == 0) {
+            items_[idx / factor] = item;
+        } else {
+            merge_io_graph_item(&items_[idx / factor], &item, hf_index_, val_units_);
+        }
+    }
+    reset_io_graph_items(&items_[new_cur_idx + 1], cur_idx_ - new_cur_idx);
+    cur_idx_ = new_cur_idx;
+
+    return true;
 }
 
 // Get the value at the given interval (idx) for the current value unit.
@@ -214,11 +214,12 @@ public:
         addDetails();
     }
 
-    // Does this tap-info match this existing UE item?
-    bool isMatch(const mac_lte_tap_info *mlt_info) {
-        return ((rnti_ == mlt_info->rnti) &&
-                (type_ == mlt_info->rntiType) &&
-                (ueid_ == mlt_info->ueid));
+    // Key identifying the UE that a tap-info belongs to: a UE item matches
+    // tap-infos with the same rnti, rnti type and ueid.
+    static quint64 ueKey(const mac_lte_tap_info *mlt_info) {
+        return ((quint64)mlt_info->ueid << 32) |
+               ((quint64)mlt_info->rntiType << 16) |
+               mlt_info->rnti;
     }
 
     // Update this UE according to the tap info
@@ -712,6 +713,7 @@ void LteMacStatisticsDialog::tapReset(void *ws_dlg_ptr)
         return;
     }
 
+    ws_dlg->ueItems_.clear();
     ws_dlg->statsTreeWidget()->clear();
     ws_dlg->clearCommonStats();
 }
@@ -737,25 +739,13 @@ tap_packet_status LteMacStatisticsDialog::tapPacket(void *ws_dlg_ptr, struct _pa
     }
 
     // Look for an existing UE to match this tap info.
-    MacUETreeWidgetItem *mac_ue_ti = NULL;
-    for (int i = 0; i < ws_dlg->statsTreeWidget()->topLevelItemCount(); i++) {
-        QTreeWidgetItem *ti = ws_dlg->statsTreeWidget()->topLevelItem(i);
-        // Make sure we're looking at a UE entry
-        if (ti->type() != mac_whole_ue_row_type_) {
-            continue;
-        }
-
-        // See if current item matches tap.
-        MacUETreeWidgetItem *cur_muds_ti = static_cast<MacUETreeWidgetItem*>(ti);
-        if (cur_muds_ti->isMatch(mlt_info)) {
-            mac_ue_ti = cur_muds_ti;
-            break;
-        }
-    }
+    quint64 ue_key = MacUETreeWidgetItem::ueKey(mlt_info);
+    MacUETreeWidgetItem *mac_ue_ti = ws_dlg->ueItems_.value(ue_key, NULL);
 
     // If don't find matching UE, create a new one.
     if (!mac_ue_ti) {
         mac_ue_ti = new MacUETreeWidgetItem(ws_dlg->statsTreeWidget(), mlt_info);
+        ws_dlg->ueItems_.insert(ue_key, mac_ue_ti);
         for (int col = 0; col < ws_dlg->statsTreeWidget()->columnCount(); col++) {
             // int QTreeWidgetItem::textAlignment(int column) const
             // Returns the text alignment for the label in the given column.
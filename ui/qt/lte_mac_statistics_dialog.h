@@ -14,6 +14,7 @@
 
 #include <QLabel>
 #include <QCheckBox>
+#include <QHash>
 
 #include <ui/qt/models/percent_bar_delegate.h>
 
@@ -33,6 +34,8 @@ typedef struct mac_lte_common_stats {
     guint16  max_dl_ues_in_tti;
 } mac_lte_common_stats;
 
+class MacUETreeWidgetItem;
+
 
 class LteMacStatisticsDialog : public TapParameterDialog
 {
@@ -63,6 +66,8 @@ private:
     // Common stats.
     mac_lte_common_stats commonStats_;
     bool commonStatsCurrent_;          // Set when changes have not yet been drawn
+    // UE items by ueid/rnti type/rnti, so each tapped packet finds its UE directly.
+    QHash<quint64, MacUETreeWidgetItem *> ueItems_;
     void updateCommonStats(const struct mac_lte_tap_info *mlt_info);
     void drawCommonStats();
     void clearCommonStats();
@@ -107,6 +107,7 @@ LteRlcGraphDialog::LteRlcGraphDialog(QWidget &parent, CaptureFile &cf, bool chan
 // Destructor
 LteRlcGraphDialog::~LteRlcGraphDialog()
 {
+    rlc_graph_segment_list_free(&graph_);
     delete ui;
 }
 
@@ -397,11 +397,6 @@ public:
         }
     }
 
-    // Does UE match?
-    bool isMatch(const rlc_lte_tap_info *rlt_info) {
-        return ueid_ == rlt_info->ueid;
-    }
-
     // Update UE/channels from tap info.
     void update(const rlc_lte_tap_info *tap_info) {
 
@@ -764,6 +759,7 @@ void LteRlcStatisticsDialog::tapReset(void *ws_dlg_ptr)
     }
 
     // Clears/deletes all UEs.
+    ws_dlg->ueItems_.clear();
     ws_dlg->statsTreeWidget()->clear();
     ws_dlg->packet_count_ = 0;
 }
@@ -781,22 +777,13 @@ tap_packet_status LteRlcStatisticsDialog::tapPacket(void *ws_dlg_ptr, struct _pa
 
     ws_dlg->incFrameCount();
 
-    // Look for this UE (TODO: avoid linear search if have lots of UEs in capture...)
-    RlcUeTreeWidgetItem *ue_ti = NULL;
-    for (int i = 0; i < ws_dlg->statsTreeWidget()->topLevelItemCount(); i++) {
-        QTreeWidgetItem *ti = ws_dlg->statsTreeWidget()->topLevelItem(i);
-        if (ti->type() != rlc_ue_row_type_) continue;
-        RlcUeTreeWidgetItem *cur_ru_ti = static_cast<RlcUeTreeWidgetItem*>(ti);
-
-        if (cur_ru_ti->isMatch(rlt_info)) {
-            ue_ti = cur_ru_ti;
-            break;
-        }
-    }
+    // Look for this UE.
+    RlcUeTreeWidgetItem *ue_ti = ws_dlg->ueItems_.value(rlt_info->ueid, NULL);
 
     if (!ue_ti) {
         // Existing UE wasn't found so create a new one.
         ue_ti = new RlcUeTreeWidgetItem(ws_dlg->statsTreeWidget(), rlt_info);
+        ws_dlg->ueItems_.insert(rlt_info->ueid, ue_ti);
         for (int col = 0; col < ws_dlg->statsTreeWidget()->columnCount(); col++) {
             // int QTreeWidgetItem::textAlignment(int column) const
             // Returns the text alignment for the label in the given column.
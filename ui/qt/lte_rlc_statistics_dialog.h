@@ -13,6 +13,9 @@
 #include "tap_parameter_dialog.h"
 
 #include <QCheckBox>
+#include <QHash>
+
+class RlcUeTreeWidgetItem;
 
 class LteRlcStatisticsDialog : public TapParameterDialog
 {
@@ -45,6 +48,8 @@ private:
 
     CaptureFile &cf_;
     int packet_count_;
+    // UE items by ueid, so each tapped PDU finds its UE directly.
+    QHash<unsigned, RlcUeTreeWidgetItem *> ueItems_;
 
     // Callbacks for register_tap_listener
     static void tapReset(void *ws_dlg_ptr);
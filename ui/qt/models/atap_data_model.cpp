@@ -41,8 +41,11 @@ ATapDataModel::ATapDataModel(dataModelType type, int protoId, QString filter, QO
     hash_.conv_array = nullptr;
     hash_.hashtable = nullptr;
     hash_.user_data = this;
+    hash_.max_items = 0;
+    hash_.pruned_items = 0;
 
     storage_ = nullptr;
+    _prunedItems = 0;
     _resolveNames = false;
     _absoluteTime = false;
     _nanoseconds = false;
@@ -61,7 +64,8 @@ ATapDataModel::ATapDataModel(dataModelType type, int protoId, QString filter, QO
 
 ATapDataModel::~ATapDataModel()
 {
-    remove_tap_listener(hash());
+    if (!_disableTap)
+        remove_tap_listener(hash());
 }
 
 int ATapDataModel::protoId() const
@@ -132,7 +136,8 @@ void ATapDataModel::disableTap()
 
 int ATapDataModel::rowCount(const QModelIndex &) const
 {
-    return storage_ ? (int) storage_->len : 0;
+    /* The tap may have added rows to storage_ that we haven't told the views about yet */
+    return (int) _rowFrames.size();
 }
 
 void ATapDataModel::tapReset(void *tapdata) {
@@ -189,6 +194,8 @@ void ATapDataModel::resetData()
 
     beginResetModel();
     storage_ = nullptr;
+    _rowFrames.clear();
+    _prunedItems = 0;
     if (_type == ATapDataModel::DATAMODEL_ENDPOINT)
         reset_endpoint_table_data(&hash_);
     else if (_type == ATapDataModel::DATAMODEL_CONVERSATION)
@@ -205,14 +212,59 @@ void ATapDataModel::updateData(GArray * newData)
     if (_disableTap)
         return;
 
-    beginResetModel();
-    storage_ = newData;
-    endResetModel();
+    /* Rows are only ever added to the array while tapping, unless the table
+     * gets pruned, in which case the tap makes a new array */
+    if (!newData || newData != storage_ || hash_.pruned_items != _prunedItems) {
+        beginResetModel();
+        storage_ = newData;
+        _prunedItems = hash_.pruned_items;
+        _rowFrames.clear();
+        if (storage_) {
+            _rowFrames.reserve((int) storage_->len);
+            for (int row = 0; row < (int) storage_->len; row++)
+                _rowFrames.append(rowFrames(row));
+        }
+        endResetModel();
+    } else {
+        /* Only tell the views about the rows that changed, so that sorting
+         * and filtering can carry on from where they were */
+        int knownRows = (int) _rowFrames.size();
+        int lastColumn = columnCount() - 1;
+        int firstChanged = -1;
+        for (int row = 0; row <= knownRows; row++) {
+            if (row < knownRows && rowFrames(row) != _rowFrames[row]) {
+                _rowFrames[row] = rowFrames(row);
+                if (firstChanged < 0)
+                    firstChanged = row;
+            } else if (firstChanged >= 0) {
+                emit dataChanged(index(firstChanged, 0), index(row - 1, lastColumn));
+                firstChanged = -1;
+            }
+        }
+
+        if ((int) storage_->len > knownRows) {
+            beginInsertRows(QModelIndex(), knownRows, (int) storage_->len - 1);
+            for (int row = knownRows; row < (int) storage_->len; row++)
+                _rowFrames.append(rowFrames(row));
+            endInsertRows();
+        }
+    }
 
     if (_type == ATapDataModel::DATAMODEL_CONVERSATION)
         ((ConversationDataModel *)(this))->doDataUpdate();
 }
 
+quint64 ATapDataModel::rowFrames(int row) const
+{
+    if (_type == ATapDataModel::DATAMODEL_ENDPOINT) {
+        endpoint_item_t *item = &g_array_index(storage_, endpoint_item_t, row);
+        return item->tx_frames_total + item->rx_frames_total;
+    }
+
+    conv_item_t *item = &g_array_index(storage_, conv_item_t, row);
+    return item->tx_frames_total + item->rx_frames_total;
+}
+
 bool ATapDataModel::resolveNames() const
 {
     return _resolveNames;
@@ -19,6 +19,7 @@
 #include <epan/conversation_table.h>
 
 #include <QAbstractListModel>
+#include <QVector>
 
 /**
  * @brief DataModel for tap user data
@@ -239,6 +240,13 @@ private:
     int _protoId;
 
     conv_hash_t hash_;
+
+    /* The total packet count of each row the views know about, as of the
+     * last update, to tell which rows changed since */
+    QVector<quint64> _rowFrames;
+    guint64 _prunedItems;
+
+    quint64 rowFrames(int row) const;
 };
 
 class EndpointDataModel : public ATapDataModel
@@ -705,12 +705,16 @@ void DecodeAsModel::gatherChangedEntries(const gchar *table_name,
     }
 }
 
-void DecodeAsModel::applyChanges()
+bool DecodeAsModel::applyChanges()
 {
     dissector_table_t sub_dissectors;
     module_t *module;
     pref_t* pref_value;
     dissector_handle_t handle;
+    // Only changes to uint tables, made through the tables themselves, can
+    // be checked against the lookups packets have made.
+    bool uint_tables_only = true;
+    dissector_uint_lookups_t *saved_lookups = dissector_all_tables_save_uint_lookups();
     // Reset all dissector tables, then apply all rules from model.
 
     // We can't call g_hash_table_removed from g_hash_table_foreach, which
@@ -737,6 +741,9 @@ void DecodeAsModel::applyChanges()
         dissector_reset_uint(uint_entry.first, uint_entry.second);
     }
     changed_uint_entries_.clear();
+    if (!changed_string_entries_.isEmpty()) {
+        uint_tables_only = false;
+    }
     foreach (CharPtrPair char_ptr_entry, changed_string_entries_) {
         dissector_reset_string(char_ptr_entry.first, char_ptr_entry.second);
     }
@@ -758,6 +765,12 @@ void DecodeAsModel::applyChanges()
                 gconstpointer  selector_value;
                 QByteArray byteArray;
 
+                if (!IS_FT_UINT(selector_type) ||
+                        decode_as_entry->change_value != decode_as_default_change ||
+                        decode_as_entry->reset_value != decode_as_default_reset) {
+                    uint_tables_only = false;
+                }
+
                 switch (selector_type) {
                 case FT_UINT8:
                 case FT_UINT16:
@@ -824,4 +837,9 @@ void DecodeAsModel::applyChanges()
         }
     }
     prefs_apply_all();
+
+    // Packets that never looked up any of the changed values will be
+    // dissected exactly as before.
+    bool lookups_changed = dissector_all_tables_uint_lookups_changed(saved_lookups);
+    return !uint_tables_only || lookups_changed;
 }
@@ -80,7 +80,9 @@ public:
 
     static QString entryString(const gchar *table_name, gconstpointer value);
 
-    void applyChanges();
+    // Returns false if the changes can't affect how any packet
+    // dissected so far is dissected.
+    bool applyChanges();
 
 protected:
     static void buildChangedList(const gchar *table_name, ftenum_t selector_type,
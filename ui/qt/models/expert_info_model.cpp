@@ -20,13 +20,27 @@ ExpertPacketItem::ExpertPacketItem(const expert_info_t& expert_info, column_info
     hf_id_(expert_info.hf_index),
     protocol_(expert_info.protocol),
     summary_(expert_info.summary),
-    parentItem_(parent)
+    parentItem_(parent),
+    row_(0)
 {
     if (cinfo) {
         info_ = col_get_text(cinfo, COL_INFO);
     }
 }
 
+ExpertPacketItem::ExpertPacketItem(const ExpertPacketItem& other, ExpertPacketItem* parent) :
+    packet_num_(other.packet_num_),
+    group_(other.group_),
+    severity_(other.severity_),
+    hf_id_(other.hf_id_),
+    protocol_(other.protocol_),
+    summary_(other.summary_),
+    info_(other.info_),
+    parentItem_(parent),
+    row_(0)
+{
+}
+
 ExpertPacketItem::~ExpertPacketItem()
 {
     for (int row = 0; row < childItems_.count(); row++)
@@ -55,8 +69,11 @@ QString ExpertPacketItem::groupKey(bool group_by_summary) {
 
 void ExpertPacketItem::appendChild(ExpertPacketItem* child, QString hash)
 {
+    child->row_ = static_cast<int>(childItems_.count());
     childItems_.append(child);
-    hashChild_[hash] = child;
+    if (!hash.isEmpty()) {
+        hashChild_[hash] = child;
+    }
 }
 
 ExpertPacketItem* ExpertPacketItem::child(int row)
@@ -66,7 +83,7 @@ ExpertPacketItem* ExpertPacketItem::child(int row)
 
 ExpertPacketItem* ExpertPacketItem::child(QString hash)
 {
-    return hashChild_[hash];
+    return hashChild_.value(hash);
 }
 
 int ExpertPacketItem::childCount() const
@@ -76,10 +93,7 @@ int ExpertPacketItem::childCount() const
 
 int ExpertPacketItem::row() const
 {
-    if (parentItem_)
-        return static_cast<int>(parentItem_->childItems_.indexOf(const_cast<ExpertPacketItem*>(this)));
-
-    return 0;
+    return row_;
 }
 
 ExpertPacketItem* ExpertPacketItem::parentItem()
@@ -356,8 +370,10 @@ int ExpertInfoModel::columnCount(const QModelIndex&) const
 void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
 {
     QString groupKey = ExpertPacketItem::groupKey(FALSE, expert_info.severity, expert_info.group, QString(expert_info.protocol), expert_info.hf_index);
-    QString summaryKey = ExpertPacketItem::groupKey(TRUE, expert_info.severity, expert_info.group, QString(expert_info.protocol), expert_info.hf_index);
+    QString summaryKey = groupKey + QString("|%1").arg(expert_info.hf_index);
 
+    // Every item made for this entry shares the strings of the first one,
+    // so the Info column is fetched and stored only once.
     ExpertPacketItem* expert_root = root_->child(groupKey);
     if (expert_root == NULL) {
         ExpertPacketItem *new_item = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), root_);
@@ -368,7 +384,7 @@ void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
     }
 
     ExpertPacketItem *expert = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_root);
-    expert_root->appendChild(expert, groupKey);
+    expert_root->appendChild(expert);
 
     //add the summary children off of the first child of the root children
     ExpertPacketItem* summary_root = expert_root->child(0);
@@ -376,14 +392,14 @@ void ExpertInfoModel::addExpertInfo(const struct expert_info_s& expert_info)
     //make a summary child
     ExpertPacketItem* expert_summary_root = summary_root->child(summaryKey);
     if (expert_summary_root == NULL) {
-        ExpertPacketItem *new_summary = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), summary_root);
+        ExpertPacketItem *new_summary = new ExpertPacketItem(*expert, summary_root);
 
         summary_root->appendChild(new_summary, summaryKey);
         expert_summary_root = new_summary;
     }
 
-    ExpertPacketItem *expert_summary = new ExpertPacketItem(expert_info, &(capture_file_.capFile()->cinfo), expert_summary_root);
-    expert_summary_root->appendChild(expert_summary, summaryKey);
+    ExpertPacketItem *expert_summary = new ExpertPacketItem(*expert, expert_summary_root);
+    expert_summary_root->appendChild(expert_summary);
 }
 
 void ExpertInfoModel::tapReset(void *eid_ptr)
@@ -28,6 +28,8 @@ class ExpertPacketItem
 {
 public:
     ExpertPacketItem(const expert_info_t& expert_info, column_info *cinfo, ExpertPacketItem* parent);
+    // Shares other's strings, for the several items made for one entry.
+    ExpertPacketItem(const ExpertPacketItem& other, ExpertPacketItem* parent);
     virtual ~ExpertPacketItem();
 
     unsigned int packetNum() const { return packet_num_; }
@@ -41,7 +43,7 @@ public:
     static QString groupKey(bool group_by_summary, int severity, int group, QString protocol, int expert_hf);
     QString groupKey(bool group_by_summary);
 
-    void appendChild(ExpertPacketItem* child, QString hash);
+    void appendChild(ExpertPacketItem* child, QString hash = QString());
     ExpertPacketItem* child(int row);
     ExpertPacketItem* child(QString hash);
     int childCount() const;
@@ -61,6 +63,7 @@ private:
 
     QList<ExpertPacketItem*> childItems_;
     ExpertPacketItem* parentItem_;
+    int row_;
     QHash<QString, ExpertPacketItem*> hashChild_;    //optimization for insertion
 };
 
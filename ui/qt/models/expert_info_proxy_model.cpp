@@ -17,6 +17,7 @@
 ExpertInfoProxyModel::ExpertInfoProxyModel(QObject *parent) : QSortFilterProxyModel(parent),
     severityMode_(Group)
 {
+    connect(this, &QSortFilterProxyModel::modelReset, this, [this]() { filteredCounts_.clear(); });
 }
 
 bool ExpertInfoProxyModel::lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const
@@ -176,9 +177,19 @@ QVariant ExpertInfoProxyModel::data(const QModelIndex &proxy_index, int role) co
             //only show counts for parent
             if (!source_index.parent().isValid()) {
                 //because of potential filtering, count is computed manually
-                unsigned int count = 0;
                 ExpertPacketItem *child_item,
                                  *item = static_cast<ExpertPacketItem*>(source_index.internalPointer());
+                //all of a group's children have the group's severity
+                if (hidden_severities_.contains(item->severity()))
+                    return 0U;
+                if (textFilter_.isEmpty())
+                    return static_cast<unsigned int>(item->childCount());
+
+                QHash<const ExpertPacketItem *, unsigned int>::const_iterator it = filteredCounts_.constFind(item);
+                if (it != filteredCounts_.constEnd())
+                    return it.value();
+
+                unsigned int count = 0;
                 for (int row = 0; row < item->childCount(); row++) {
                     child_item = item->child(row);
                     if (child_item == NULL)
@@ -186,6 +197,7 @@ QVariant ExpertInfoProxyModel::data(const QModelIndex &proxy_index, int role) co
                     if (filterAcceptItem(*child_item))
                         count++;
                 }
+                filteredCounts_.insert(item, count);
 
                 return count;
             }
@@ -232,18 +244,16 @@ bool ExpertInfoProxyModel::filterAcceptItem(ExpertPacketItem& item) const
         return false;
 
     if (!textFilter_.isEmpty()) {
-        QRegularExpression regex(textFilter_, QRegularExpression::CaseInsensitiveOption |
-                                 QRegularExpression::UseUnicodePropertiesOption);
-        if (! regex.isValid())
+        if (! textRegex_.isValid())
             return false;
 
-        if (item.protocol().contains(regex))
+        if (item.protocol().contains(textRegex_))
             return true;
 
-        if (item.summary().contains(regex))
+        if (item.summary().contains(textRegex_))
             return true;
 
-        if (item.colInfo().contains(regex))
+        if (item.colInfo().contains(textRegex_))
             return true;
 
         return false;
@@ -280,11 +290,16 @@ void ExpertInfoProxyModel::setSeverityFilter(int severity, bool hide)
         hidden_severities_.removeOne(severity);
     }
 
+    filteredCounts_.clear();
     invalidateFilter();
 }
 
 void ExpertInfoProxyModel::setSummaryFilter(const QString &filter)
 {
     textFilter_ = filter;
+    // Compile it once here rather than for every item filtered.
+    textRegex_ = QRegularExpression(textFilter_, QRegularExpression::CaseInsensitiveOption |
+                                    QRegularExpression::UseUnicodePropertiesOption);
+    filteredCounts_.clear();
     invalidateFilter();
 }
@@ -14,6 +14,8 @@
 
 #include <config.h>
 
+#include <QHash>
+#include <QRegularExpression>
 #include <QSortFilterProxyModel>
 
 class ExpertPacketItem;
@@ -55,6 +57,11 @@ protected:
     QList<int> hidden_severities_;
 
     QString textFilter_;
+    QRegularExpression textRegex_;
+
+    // Children of each group that pass the text filter, counted when
+    // first shown.
+    mutable QHash<const ExpertPacketItem *, unsigned int> filteredCounts_;
 
 };
 
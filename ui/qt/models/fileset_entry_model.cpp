@@ -13,8 +13,6 @@
 
 #include <ui/qt/utils/qt_ui_utils.h>
 
-#include <QRegularExpression>
-
 FilesetEntryModel::FilesetEntryModel(QObject * parent) :
     QAbstractItemModel(parent)
 {}
@@ -44,27 +42,21 @@ QVariant FilesetEntryModel::data(const QModelIndex &index, int role) const
         case Name:
             return QString(entry->name);
         case Created:
-        {
-            QString created = nameToDate(entry->name);
-            if (created.length() < 1) {
-                /* if this file doesn't follow the file set pattern, */
-                /* use the creation time of that file if available */
-                /* https://en.wikipedia.org/wiki/ISO_8601 */
-                /*
-                 * macOS provides 0 if the file system doesn't support the
-                 * creation time; FreeBSD provides -1.
-                 *
-                 * If this OS doesn't provide the creation time with stat(),
-                 * it will be 0.
-                 */
-                if (entry->ctime > 0) {
-                    created = time_tToString(entry->ctime);
-                } else {
-                    created = UTF8_EM_DASH;
-                }
+            /*
+             * For files that follow the file set pattern this is the
+             * time from the name, otherwise the creation time of that
+             * file if available.
+             *
+             * macOS provides 0 if the file system doesn't support the
+             * creation time; FreeBSD provides -1.
+             *
+             * If this OS doesn't provide the creation time with stat(),
+             * it will be 0.
+             */
+            if (entry->ctime > 0) {
+                return time_tToString(entry->ctime);
             }
-            return created;
-        }
+            return UTF8_EM_DASH;
         case Modified:
             return time_tToString(entry->mtime);
         case Size:
@@ -120,23 +112,6 @@ void FilesetEntryModel::clear()
     endResetModel();
 }
 
-QString FilesetEntryModel::nameToDate(const char *name) const {
-    QString dn;
-
-    if (!fileset_filename_match_pattern(name))
-        return NULL;
-
-    dn = name;
-    dn.remove(QRegularExpression(".*_"));
-    dn.truncate(14);
-    dn.insert(4, '-');
-    dn.insert(7, '-');
-    dn.insert(10, ' ');
-    dn.insert(13, ':');
-    dn.insert(16, ':');
-    return dn;
-}
-
 QString FilesetEntryModel::time_tToString(time_t clock) const
 {
     struct tm *local = localtime(&clock);
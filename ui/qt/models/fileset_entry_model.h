@@ -45,7 +45,6 @@ private:
     QVector<const fileset_entry *> entries_;
     enum Column { Name, Created, Modified, Size, ColumnCount };
 
-    QString nameToDate(const char *name) const ;
     QString time_tToString(time_t clock) const;
 };
 
@@ -19,6 +19,7 @@
 #include <epan/prefs.h>
 
 #include "ui/packet_list_utils.h"
+#include "ui/progress_dlg.h"
 #include "ui/recent.h"
 
 #include <epan/color_filters.h>
@@ -36,6 +37,8 @@
 #include <QFontMetrics>
 #include <QModelIndex>
 #include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent>
 
 // Print timing information
 //#define DEBUG_PACKET_LIST_MODEL 1
@@ -71,7 +74,13 @@ PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
     number_to_row_(QVector<int>()),
     max_row_height_(0),
     max_line_count_(1),
-    idle_dissection_row_(0)
+    idle_dissection_row_(0),
+    sorting_(false),
+    sort_stop_flag_(FALSE),
+    ahead_next_row_(0),
+    ahead_last_row_(-1),
+    ahead_prev_row_(-1),
+    ahead_first_row_(0)
 {
     Q_ASSERT(glbl_plist_model == Q_NULLPTR);
     glbl_plist_model = this;
@@ -162,6 +171,8 @@ guint PacketListModel::recreateVisibleRows()
 }
 
 void PacketListModel::clear() {
+    // Stop any sort that's waiting on dissection; its rows are going away.
+    sort_stop_flag_ = TRUE;
     beginResetModel();
     qDeleteAll(physical_rows_);
     physical_rows_.resize(0);
@@ -172,6 +183,8 @@ void PacketListModel::clear() {
     max_row_height_ = 0;
     max_line_count_ = 1;
     idle_dissection_row_ = 0;
+    ahead_last_row_ = -1;
+    ahead_prev_row_ = -1;
 }
 
 void PacketListModel::invalidateAllColumnStrings()
@@ -299,7 +312,7 @@ void PacketListModel::toggleFrameRefTime(const QModelIndex &rt_index)
         fdata->ref_time=1;
         cap_file_->ref_time_count++;
     }
-    cf_reftime_packets(cap_file_);
+    cf_reftime_packet_toggled(cap_file_, fdata);
     if (!fdata->ref_time && !fdata->passed_dfilter) {
         cap_file_->displayed_count--;
     }
@@ -346,6 +359,7 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 {
     if (!cap_file_ || visible_rows_.count() < 1) return;
     if (column < 0) return;
+    if (sorting_) return;
 
     if (physical_rows_.count() < 1)
         return;
@@ -357,8 +371,6 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     QString col_title = get_column_title(column);
 
-    // XXX Use updateProgress instead. We'd have to switch from std::sort to
-    // something we can interrupt.
     if (!col_title.isEmpty()) {
         QString busy_msg = tr("Sorting \"%1\"…").arg(col_title);
         mainApp->pushStatus(MainApplication::BusyStatus, busy_msg);
@@ -367,7 +379,16 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     busy_timer_.start();
     sort_column_is_numeric_ = isNumericColumn(sort_column_);
     QVector<PacketListRecord *> sorted_visible_rows_ = visible_rows_;
-    std::sort(sorted_visible_rows_.begin(), sorted_visible_rows_.end(), recordLessThan);
+    if (text_sort_column_ < 0) {
+        // Frame data columns are cheap to compare.
+        std::sort(sorted_visible_rows_.begin(), sorted_visible_rows_.end(), recordLessThan);
+    } else if (!sortByColumnText(sorted_visible_rows_, col_title)) {
+        // Stopped, or the rows went away while we were dissecting them.
+        if (!col_title.isEmpty()) {
+            mainApp->popStatus(MainApplication::BusyStatus);
+        }
+        return;
+    }
 
     beginResetModel();
     visible_rows_.resize(0);
@@ -394,6 +415,125 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
     }
 }
 
+// The text of a row's sort column, taken once so that comparing rows
+// doesn't mean dissecting them.
+struct PacketListSortKey {
+    PacketListRecord *record;
+    QString text;
+    double number;
+    bool numeric;
+};
+
+static const int sort_chunk_min_ = 10000;
+
+// Sort rows by the text of the sort column. Dissecting the rows has to be
+// done here, one row at a time, but it shows its progress and can be
+// stopped; the sort keys are then parsed and sorted in chunks on all of
+// the cores and the chunks merged. Returns false if the sort was stopped.
+bool PacketListModel::sortByColumnText(QVector<PacketListRecord *> &rows, const QString &col_title)
+{
+    QVector<PacketListSortKey> keys(rows.count());
+    progdlg_t *progbar = NULL;
+    QElapsedTimer progress_timer;
+    QByteArray title = tr("Sorting").toUtf8();
+    QByteArray item_title = col_title.toUtf8();
+    bool stopped = false;
+
+    sorting_ = true;
+    sort_stop_flag_ = FALSE;
+    progress_timer.start();
+    for (int i = 0; i < rows.count(); i++) {
+        if (progress_timer.elapsed() > busy_timeout_) {
+            float progress = static_cast<float>(i) / rows.count();
+            // Both of these process events, which might stop us.
+            if (!progbar) {
+                progbar = delayed_create_progress_dlg(cap_file_->window, title.constData(), item_title.constData(),
+                                                      TRUE, &sort_stop_flag_, progress);
+            } else {
+                update_progress_dlg(progbar, progress, NULL);
+            }
+            progress_timer.restart();
+            if (sort_stop_flag_) {
+                stopped = true;
+                break;
+            }
+        }
+        keys[i].record = rows[i];
+        keys[i].text = rows[i]->columnString(sort_cap_file_, sort_column_);
+    }
+    if (progbar) {
+        destroy_progress_dlg(progbar);
+    }
+    sorting_ = false;
+    if (stopped) {
+        return false;
+    }
+
+    bool numeric = sort_column_is_numeric_;
+    bool ascending = sort_order_ == Qt::AscendingOrder;
+    auto key_less_than = [numeric, ascending](const PacketListSortKey &k1, const PacketListSortKey &k2) {
+        int cmp_val = k1.text.compare(k2.text);
+        if (cmp_val != 0 && numeric) {
+            // Same as recordLessThan.
+            if (!k1.numeric && !k2.numeric) {
+                cmp_val = 0;
+            } else if (!k1.numeric || (k2.numeric && k1.number < k2.number)) {
+                cmp_val = -1;
+            } else if (!k2.numeric || (k1.number > k2.number)) {
+                cmp_val = 1;
+            }
+        }
+        if (cmp_val == 0) {
+            cmp_val = frame_data_compare(NULL, k1.record->frameData(), k2.record->frameData(), COL_NUMBER);
+        }
+        return ascending ? cmp_val < 0 : cmp_val > 0;
+    };
+
+    int chunk_count = qMax(1, qMin(QThread::idealThreadCount(), static_cast<int>(keys.count()) / sort_chunk_min_));
+    QVector<int> bounds;
+    for (int i = 0; i <= chunk_count; i++) {
+        bounds << static_cast<int>(static_cast<qint64>(keys.count()) * i / chunk_count);
+    }
+
+    QList<QFuture<void>> futures;
+    for (int i = 0; i < chunk_count; i++) {
+        PacketListSortKey *first = keys.data() + bounds[i];
+        PacketListSortKey *last = keys.data() + bounds[i + 1];
+        futures << QtConcurrent::run([first, last, numeric, key_less_than]() {
+            if (numeric) {
+                for (PacketListSortKey *key = first; key < last; key++) {
+                    key->number = parseNumericColumn(key->text, &key->numeric);
+                }
+            }
+            std::sort(first, last, key_less_than);
+        });
+    }
+    foreach (QFuture<void> future, futures) {
+        future.waitForFinished();
+    }
+
+    // Merge neighbouring chunks, in parallel, until there's one left.
+    for (int width = 1; width < chunk_count; width *= 2) {
+        futures.clear();
+        for (int i = 0; i + width < chunk_count; i += 2 * width) {
+            PacketListSortKey *first = keys.data() + bounds[i];
+            PacketListSortKey *middle = keys.data() + bounds[i + width];
+            PacketListSortKey *last = keys.data() + bounds[qMin(i + 2 * width, chunk_count)];
+            futures << QtConcurrent::run([first, middle, last, key_less_than]() {
+                std::inplace_merge(first, middle, last, key_less_than);
+            });
+        }
+        foreach (QFuture<void> future, futures) {
+            future.waitForFinished();
+        }
+    }
+
+    for (int i = 0; i < keys.count(); i++) {
+        rows[i] = keys[i].record;
+    }
+    return true;
+}
+
 bool PacketListModel::isNumericColumn(int column)
 {
     if (column < 0) {
@@ -593,8 +733,11 @@ QVariant PacketListModel::data(const QModelIndex &d_index, int role) const
             color = &prefs.gui_ignored_bg;
         } else if (fdata->marked) {
             color = &prefs.gui_marked_bg;
-        } else if (fdata->color_filter && recent.packet_list_colorize) {
-            const color_filter_t *color_filter = (const color_filter_t *) fdata->color_filter;
+        } else if (fdata->color_index && recent.packet_list_colorize) {
+            const color_filter_t *color_filter = color_filters_get_by_index(fdata->color_index);
+            if (!color_filter) {
+                return QVariant();
+            }
             color = &color_filter->bg_color;
         } else {
             return QVariant();
@@ -605,8 +748,11 @@ QVariant PacketListModel::data(const QModelIndex &d_index, int role) const
             color = &prefs.gui_ignored_fg;
         } else if (fdata->marked) {
             color = &prefs.gui_marked_fg;
-        } else if (fdata->color_filter && recent.packet_list_colorize) {
-            const color_filter_t *color_filter = (const color_filter_t *) fdata->color_filter;
+        } else if (fdata->color_index && recent.packet_list_colorize) {
+            const color_filter_t *color_filter = color_filters_get_by_index(fdata->color_index);
+            if (!color_filter) {
+                return QVariant();
+            }
             color = &color_filter->fg_color;
         } else {
             return QVariant();
@@ -713,6 +859,77 @@ void PacketListModel::dissectIdle(bool reset)
     emit bgColorizationProgress(first+1, idle_dissection_row_+1);
 }
 
+// Number of pages to dissect below and above the rows in view. Most
+// scrolling is downward.
+static const int dissect_ahead_pages_below_ = 2;
+static const int dissect_ahead_pages_above_ = 1;
+void PacketListModel::dissectAhead(int first, int last)
+{
+    if (first < 0 || last < first) {
+        return;
+    }
+
+    int page = last - first + 1;
+    bool idle = ahead_next_row_ > ahead_last_row_ && ahead_prev_row_ < ahead_first_row_;
+
+    ahead_next_row_ = last + 1;
+    ahead_last_row_ = qMin(last + page * dissect_ahead_pages_below_, static_cast<int>(visible_rows_.count()) - 1);
+    ahead_prev_row_ = first - 1;
+    ahead_first_row_ = qMax(first - page * dissect_ahead_pages_above_, 0);
+
+    if (idle) {
+        QTimer::singleShot(0, this, SLOT(dissectAheadIdle()));
+    }
+}
+
+// Dissect the rows around the view for up to idle_dissection_interval_
+// at a time, the rows below first, and tell the view about the ones we
+// dissected. Rows that are already dissected are skipped.
+void PacketListModel::dissectAheadIdle()
+{
+    if (!cap_file_ || cap_file_->read_lock || cap_file_->redissecting) {
+        ahead_last_row_ = -1;
+        ahead_prev_row_ = -1;
+        return;
+    }
+
+    QElapsedTimer timer;
+    int dissected_first = -1;
+    int dissected_last = -1;
+
+    timer.start();
+    while (timer.elapsed() < idle_dissection_interval_) {
+        int row;
+        if (ahead_next_row_ <= ahead_last_row_) {
+            row = ahead_next_row_++;
+        } else if (ahead_prev_row_ >= ahead_first_row_) {
+            row = ahead_prev_row_--;
+        } else {
+            break;
+        }
+        if (row >= visible_rows_.count()) {
+            continue;
+        }
+        PacketListRecord *record = visible_rows_[row];
+        if (record->dissected()) {
+            continue;
+        }
+        record->ensureColorized(cap_file_);
+        if (dissected_first < 0 || row < dissected_first) {
+            dissected_first = row;
+        }
+        dissected_last = qMax(dissected_last, row);
+    }
+
+    if (dissected_last >= 0) {
+        emit dataChanged(index(dissected_first, 0), index(dissected_last, columnCount() - 1));
+    }
+
+    if (ahead_next_row_ <= ahead_last_row_ || ahead_prev_row_ >= ahead_first_row_) {
+        QTimer::singleShot(0, this, SLOT(dissectAheadIdle()));
+    }
+}
+
 // XXX Pass in cinfo from packet_list_append so that we can fill in
 // line counts?
 gint PacketListModel::appendPacket(frame_data *fdata)
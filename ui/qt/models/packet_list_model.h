@@ -86,6 +86,13 @@ public slots:
     void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
     void flushVisibleRows();
     void dissectIdle(bool reset = false);
+    /**
+     * @brief Dissect the rows on either side of the ones in view, so that
+     * they're ready when the view scrolls to them.
+     * @param first The first row in view.
+     * @param last The last row in view.
+     */
+    void dissectAhead(int first, int last);
 
 private:
     capture_file *cap_file_;
@@ -105,16 +112,28 @@ private:
     static capture_file *sort_cap_file_;
     static bool recordLessThan(PacketListRecord *r1, PacketListRecord *r2);
     static double parseNumericColumn(const QString &val, bool *ok);
+    bool sortByColumnText(QVector<PacketListRecord *> &rows, const QString &col_title);
 
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
 
+    bool sorting_;
+    gboolean sort_stop_flag_;
+
+    // Rows after and before the ones in view that are still to be
+    // dissected ahead of time.
+    int ahead_next_row_;
+    int ahead_last_row_;
+    int ahead_prev_row_;
+    int ahead_first_row_;
+
     struct _GStringChunk *string_cache_pool_;
 
     bool isNumericColumn(int column);
 
 private slots:
     void emitItemHeightChanged(const QModelIndex &ih_index);
+    void dissectAheadIdle();
 };
 
 #endif // PACKET_LIST_MODEL_H
@@ -17,6 +17,7 @@
 #include <epan/wmem_scopes.h>
 
 #include <epan/color_filters.h>
+#include <epan/prefs.h>
 
 #include "frame_tvbuff.h"
 
@@ -27,6 +28,16 @@
 QMap<int, int> PacketListRecord::cinfo_column_;
 unsigned PacketListRecord::col_data_ver_ = 1;
 unsigned PacketListRecord::rows_color_ver_ = 1;
+PacketListRecord *PacketListRecord::lru_first_ = NULL;
+PacketListRecord *PacketListRecord::lru_last_ = NULL;
+size_t PacketListRecord::col_text_total_size_ = 0;
+QSet<QString> PacketListRecord::interned_strings_;
+
+// Rough per-string overhead of a QString and its data header.
+static const size_t string_overhead_ = 32;
+// Interning limits, so that the table itself stays small.
+static const int max_interned_strings_ = 65536;
+static const int max_interned_length_ = 64;
 
 PacketListRecord::PacketListRecord(frame_data *frameData) :
     fdata_(frameData),
@@ -36,13 +47,16 @@ PacketListRecord::PacketListRecord(frame_data *frameData) :
     color_ver_(0),
     colorized_(false),
     conv_index_(0),
-    read_failed_(false)
+    read_failed_(false),
+    lru_prev_(NULL),
+    lru_next_(NULL),
+    col_text_size_(0)
 {
 }
 
 PacketListRecord::~PacketListRecord()
 {
-    col_text_.clear();
+    dropColumnStrings();
 }
 
 void PacketListRecord::ensureColorized(capture_file *cap_file)
@@ -85,8 +99,110 @@ const QString PacketListRecord::columnString(capture_file *cap_file, int column,
     if (column >= col_text_.count() || col_text_.at(column).isNull() || data_ver_ != col_data_ver_ || dissect_color) {
         dissect(cap_file, dissect_color);
     }
+    lruTouch();
+
+    return col_text_.value(column);
+}
+
+void PacketListRecord::lruUnlink()
+{
+    if (lru_prev_) {
+        lru_prev_->lru_next_ = lru_next_;
+    } else if (lru_first_ == this) {
+        lru_first_ = lru_next_;
+    }
+    if (lru_next_) {
+        lru_next_->lru_prev_ = lru_prev_;
+    } else if (lru_last_ == this) {
+        lru_last_ = lru_prev_;
+    }
+    lru_prev_ = lru_next_ = NULL;
+}
+
+void PacketListRecord::lruTouch()
+{
+    if (col_text_.isEmpty() || lru_first_ == this) {
+        return;
+    }
+
+    lruUnlink();
+    lru_next_ = lru_first_;
+    if (lru_first_) {
+        lru_first_->lru_prev_ = this;
+    }
+    lru_first_ = this;
+    if (!lru_last_) {
+        lru_last_ = this;
+    }
+}
+
+void PacketListRecord::dropColumnStrings()
+{
+    lruUnlink();
+    col_text_.clear();
+    col_text_total_size_ -= col_text_size_;
+    col_text_size_ = 0;
+}
+
+// Drop the column strings of the least recently used records until we're
+// within the cache size, but never those of keep.
+void PacketListRecord::trimColumnStrings(PacketListRecord *keep)
+{
+    size_t limit = static_cast<size_t>(prefs.gui_packet_list_cache_size) * 1024 * 1024;
+
+    if (limit == 0) {
+        return;
+    }
 
-    return col_text_.at(column);
+    while (col_text_total_size_ > limit && lru_last_ && lru_last_ != keep) {
+        lru_last_->dropColumnStrings();
+    }
+}
+
+// Protocol names, addresses, ports and the like repeat from packet to
+// packet, as do columns that a dissector set to a constant string.
+bool PacketListRecord::internColumn(column_info *cinfo, int column, const QString &col_str)
+{
+    if (col_str.size() > max_interned_length_) {
+        return false;
+    }
+
+    switch (cinfo->columns[column].col_fmt) {
+    case COL_PROTOCOL:
+    case COL_IF_DIR:
+    case COL_8021Q_VLAN_ID:
+    case COL_EXPERT:
+    case COL_FREQ_CHAN:
+    case COL_DEF_SRC:
+    case COL_RES_SRC:
+    case COL_UNRES_SRC:
+    case COL_DEF_DL_SRC:
+    case COL_RES_DL_SRC:
+    case COL_UNRES_DL_SRC:
+    case COL_DEF_NET_SRC:
+    case COL_RES_NET_SRC:
+    case COL_UNRES_NET_SRC:
+    case COL_DEF_DST:
+    case COL_RES_DST:
+    case COL_UNRES_DST:
+    case COL_DEF_DL_DST:
+    case COL_RES_DL_DST:
+    case COL_UNRES_DL_DST:
+    case COL_DEF_NET_DST:
+    case COL_RES_NET_DST:
+    case COL_UNRES_NET_DST:
+    case COL_DEF_SRC_PORT:
+    case COL_RES_SRC_PORT:
+    case COL_UNRES_SRC_PORT:
+    case COL_DEF_DST_PORT:
+    case COL_RES_DST_PORT:
+    case COL_UNRES_DST_PORT:
+        return true;
+    default:
+        break;
+    }
+
+    return cinfo->columns[column].col_data != cinfo->columns[column].col_buf;
 }
 
 void PacketListRecord::resetColumns(column_info *cinfo)
@@ -98,6 +214,7 @@ void PacketListRecord::resetColumns(column_info *cinfo)
     }
 
     cinfo_column_.clear();
+    interned_strings_.clear();
     int i, j;
     for (i = 0, j = 0; i < cinfo->num_cols; i++) {
         if (!col_based_on_frame_data(cinfo, i)) {
@@ -151,7 +268,7 @@ void PacketListRecord::dissect(capture_file *cap_file, bool dissect_color)
             cacheColumnStrings(cinfo);
         }
         if (dissect_color) {
-            fdata_->color_filter = NULL;
+            fdata_->color_index = 0;
             colorized_ = true;
         }
         ws_buffer_free(&buf);
@@ -223,7 +340,7 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         return;
     }
 
-    col_text_.clear();
+    dropColumnStrings();
     lines_ = 1;
     line_count_changed_ = false;
 
@@ -290,6 +407,20 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         }
 
         col_str = QString(get_column_text(cinfo, column));
+        if (internColumn(cinfo, column, col_str)) {
+            QSet<QString>::const_iterator interned = interned_strings_.constFind(col_str);
+            if (interned != interned_strings_.constEnd()) {
+                col_str = *interned;
+                col_text_size_ += sizeof(QString);
+            } else {
+                if (interned_strings_.size() < max_interned_strings_) {
+                    interned_strings_.insert(col_str);
+                }
+                col_text_size_ += string_overhead_ + col_str.size() * sizeof(QChar);
+            }
+        } else {
+            col_text_size_ += string_overhead_ + col_str.size() * sizeof(QChar);
+        }
         col_text_ << col_str;
         col_lines = static_cast<int>(col_str.count('\n'));
         if (col_lines > lines_) {
@@ -298,4 +429,8 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         }
 #endif // MINIMIZE_STRING_COPYING
     }
+
+    col_text_total_size_ += col_text_size_;
+    lruTouch();
+    trimColumnStrings(this);
 }
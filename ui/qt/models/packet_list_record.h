@@ -21,6 +21,7 @@
 
 #include <QByteArray>
 #include <QList>
+#include <QSet>
 #include <QVariant>
 
 struct conversation;
@@ -40,6 +41,8 @@ public:
     // packet_list->col_to_text in gtk/packet_list_store.c
     static int textColumn(int column) { return cinfo_column_.value(column, -1); }
     bool colorized() { return colorized_; }
+    // Are the column strings and colorization up to date?
+    bool dissected() const { return !col_text_.isEmpty() && data_ver_ == col_data_ver_ && colorized_ && color_ver_ == rows_color_ver_; }
     unsigned int conversation() { return conv_index_; }
 
     int columnTextSize(const char *str);
@@ -72,8 +75,29 @@ private:
 
     bool read_failed_;
 
+    /**
+     * Records with column strings, most recently used first. When the
+     * strings take more than the gui.packet_list_cache_size preference,
+     * the least recently used records drop theirs; they're dissected
+     * again if they're needed.
+     */
+    PacketListRecord *lru_prev_;
+    PacketListRecord *lru_next_;
+    size_t col_text_size_;
+    static PacketListRecord *lru_first_;
+    static PacketListRecord *lru_last_;
+    static size_t col_text_total_size_;
+
+    /** Column strings that many records are likely to share */
+    static QSet<QString> interned_strings_;
+
     void dissect(capture_file *cap_file, bool dissect_color = false);
     void cacheColumnStrings(column_info *cinfo);
+    void lruUnlink();
+    void lruTouch();
+    void dropColumnStrings();
+    static void trimColumnStrings(PacketListRecord *keep);
+    static bool internColumn(column_info *cinfo, int column, const QString &col_str);
 };
 
 #endif // PACKET_LIST_RECORD_H
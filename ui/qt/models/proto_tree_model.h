@@ -28,6 +28,7 @@ public:
     QModelIndex index(int row, int, const QModelIndex &parent = QModelIndex()) const;
     virtual QModelIndex parent(const QModelIndex &index) const;
     virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    virtual bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
     virtual int columnCount(const QModelIndex &) const { return 1; }
     virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
 
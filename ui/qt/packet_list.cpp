@@ -197,6 +197,9 @@ PacketList::PacketList(QWidget *parent) :
     overlay_timer_id_(0),
     create_near_overlay_(true),
     create_far_overlay_(true),
+    overlay_start_(-1),
+    overlay_row_count_(-1),
+    far_overlay_rows_(-1),
     mouse_pressed_at_(QModelIndex()),
     capture_in_progress_(false),
     tail_timer_id_(0),
@@ -247,6 +250,8 @@ PacketList::PacketList(QWidget *parent) :
 
     connect(packet_list_model_, SIGNAL(goToPacket(int)), this, SLOT(goToPacket(int)));
     connect(packet_list_model_, SIGNAL(itemHeightChanged(const QModelIndex&)), this, SLOT(updateRowHeights(const QModelIndex&)));
+    // Sorting and refiltering move rows between the far overlay's stripes.
+    connect(packet_list_model_, &PacketListModel::modelReset, this, [=]() { create_far_overlay_ = true; });
     connect(mainApp, SIGNAL(addressResolutionChanged()), this, SLOT(redrawVisiblePacketsDontSelectCurrent()));
     connect(mainApp, SIGNAL(columnDataChanged()), this, SLOT(redrawVisiblePacketsDontSelectCurrent()));
     connect(mainApp, &MainApplication::preferencesChanged, this, [=]() {
@@ -261,6 +266,7 @@ PacketList::PacketList(QWidget *parent) :
             this, SLOT(sectionMoved(int,int,int)));
 
     connect(verticalScrollBar(), SIGNAL(actionTriggered(int)), this, SLOT(vScrollBarActionTriggered(int)));
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &PacketList::dissectAhead);
 }
 
 void PacketList::colorsChanged()
@@ -750,7 +756,7 @@ void PacketList::timerEvent(QTimerEvent *event)
     } else if (event->timerId() == overlay_timer_id_) {
         if (!capture_in_progress_) {
             if (create_near_overlay_) drawNearOverlay();
-            if (create_far_overlay_) drawFarOverlay();
+            if (create_far_overlay_ || !far_overlay_dirty_rows_.isEmpty()) drawFarOverlay();
         }
     } else {
         QTreeView::timerEvent(event);
@@ -787,7 +793,7 @@ void PacketList::mousePressEvent (QMouseEvent *event)
         // Make sure the packet list's frame.marked related field text is updated.
         redrawVisiblePackets();
 
-        create_far_overlay_ = true;
+        farOverlayRowsChanged(QModelIndexList() << curIndex);
         packets_bar_update();
     }
 }
@@ -928,6 +934,7 @@ void PacketList::resizeEvent(QResizeEvent *event)
     create_near_overlay_ = true;
     create_far_overlay_ = true;
     QTreeView::resizeEvent(event);
+    dissectAhead();
 }
 
 void PacketList::setColumnVisibility()
@@ -1197,6 +1204,25 @@ void PacketList::captureFileReadFinished()
     // Invalidating the column strings picks up and request/response
     // tracking changes. We might just want to call it from flushVisibleRows.
     packet_list_model_->invalidateAllColumnStrings();
+    dissectAhead();
+}
+
+// Have the model dissect the rows just out of view while we're idle, so
+// that scrolling to them doesn't have to wait for them to be dissected.
+void PacketList::dissectAhead()
+{
+    if (!packet_list_model_ || !model()) {
+        return;
+    }
+
+    QModelIndex first_index = indexAt(viewport()->rect().topLeft());
+    if (!first_index.isValid()) {
+        return;
+    }
+    QModelIndex last_index = indexAt(viewport()->rect().bottomLeft());
+    int last = last_index.isValid() ? last_index.row() : packet_list_model_->rowCount() - 1;
+
+    packet_list_model_->dissectAhead(first_index.row(), last);
 }
 
 void PacketList::freeze()
@@ -1216,6 +1242,12 @@ void PacketList::freeze()
 
 void PacketList::thaw(bool restore_selection)
 {
+    if (model() == packet_list_model_) {
+        // We weren't frozen, or we've already been thawed, e.g. by cf_read
+        // showing the packets it's read so far.
+        return;
+    }
+
     setHeaderHidden(false);
     setModel(packet_list_model_);
 
@@ -1248,6 +1280,9 @@ void PacketList::clear() {
     QImage overlay;
     overlay_sb_->setNearOverlayImage(overlay);
     overlay_sb_->setMarkedPacketImage(overlay);
+    overlay_colors_.clear();
+    far_overlay_stripes_.clear();
+    far_overlay_dirty_rows_.clear();
     create_near_overlay_ = true;
     create_far_overlay_ = true;
 }
@@ -1687,7 +1722,7 @@ void PacketList::markFrame()
     // Make sure the packet list's frame.marked related field text is updated.
     redrawVisiblePackets();
 
-    create_far_overlay_ = true;
+    farOverlayRowsChanged(frames);
     packets_bar_update();
 }
 
@@ -1746,7 +1781,7 @@ void PacketList::setTimeReference()
 {
     if (!cap_file_ || !packet_list_model_) return;
     packet_list_model_->toggleFrameRefTime(currentIndex());
-    create_far_overlay_ = true;
+    farOverlayRowsChanged(QModelIndexList() << currentIndex());
 }
 
 void PacketList::unsetAllTimeReferences()
@@ -1985,38 +2020,36 @@ void PacketList::drawNearOverlay()
 
     qreal dp_ratio = overlay_sb_->devicePixelRatio();
     int o_height = overlay_sb_->height() * dp_ratio;
-    int o_rows = qMin(packet_list_model_->rowCount(), o_height);
+    int pl_rows = packet_list_model_->rowCount();
+    int o_rows = qMin(pl_rows, o_height);
     QFontMetricsF fmf(mainApp->font());
     int o_width = ((static_cast<int>(fmf.height())) * 2 * dp_ratio) + 2; // 2ems + 1-pixel border on either side.
 
     if (recent.packet_list_colorize && o_rows > 0) {
-        QImage overlay(o_width, o_height, QImage::Format_ARGB32_Premultiplied);
-
-        QPainter painter(&overlay);
-
-        overlay.fill(Qt::transparent);
-
-        int cur_line = 0;
         int start = 0;
 
-        if (packet_list_model_->rowCount() > o_height && overlay_sb_->maximum() > 0) {
-            start += ((double) overlay_sb_->value() / overlay_sb_->maximum()) * (packet_list_model_->rowCount() - o_rows);
+        if (pl_rows > o_height && overlay_sb_->maximum() > 0) {
+            start += ((double) overlay_sb_->value() / overlay_sb_->maximum()) * (pl_rows - o_rows);
         }
         int end = start + o_rows;
+
+        // Work out the color of each line of the overlay from the rows'
+        // color filter indexes first; we're called on every repaint, and
+        // most of the time nothing in the overlay has changed.
+        QVector<QRgb> line_colors(o_height, 0);
+        int cur_line = 0;
         for (int row = start; row < end; row++) {
             packet_list_model_->ensureRowColorized(row);
 
             frame_data *fdata = packet_list_model_->getRowFdata(row);
-            const color_t *bgcolor = NULL;
-            if (fdata->color_filter) {
-                const color_filter_t *color_filter = (const color_filter_t *) fdata->color_filter;
-                bgcolor = &color_filter->bg_color;
-            }
+            const color_filter_t *color_filter = color_filters_get_by_index(fdata->color_index);
 
             int next_line = (row - start) * o_height / o_rows;
-            if (bgcolor) {
-                QColor color(ColorUtils::fromColorT(bgcolor));
-                painter.fillRect(0, cur_line, o_width, next_line - cur_line, color);
+            if (color_filter) {
+                QRgb rgb = ColorUtils::fromColorT(&color_filter->bg_color).rgb();
+                for (int line = cur_line; line < next_line; line++) {
+                    line_colors[line] = rgb;
+                }
             }
             cur_line = next_line;
         }
@@ -2036,7 +2069,7 @@ void PacketList::drawNearOverlay()
                 if (sel_row < start) {
                     selected_pos = 0;
                 } else if (sel_row >= end) {
-                    selected_pos = overlay.height() - 1;
+                    selected_pos = o_height - 1;
                 } else {
                     selected_pos = (sel_row - start) * o_height / o_rows;
                 }
@@ -2060,18 +2093,71 @@ void PacketList::drawNearOverlay()
             }
         }
 
-        overlay_sb_->setNearOverlayImage(overlay, packet_list_model_->rowCount(), start, end, positions, (o_height / o_rows));
+        QSize o_size(o_width, o_height);
+        if (line_colors == overlay_colors_ && positions == overlay_positions_
+                && start == overlay_start_ && pl_rows == overlay_row_count_
+                && o_size == overlay_size_) {
+            return;
+        }
+        overlay_colors_ = line_colors;
+        overlay_positions_ = positions;
+        overlay_start_ = start;
+        overlay_row_count_ = pl_rows;
+        overlay_size_ = o_size;
+
+        QImage overlay(o_width, o_height, QImage::Format_ARGB32_Premultiplied);
+        overlay.fill(Qt::transparent);
+        {
+            QPainter painter(&overlay);
+            int line = 0;
+            while (line < o_height) {
+                int run_end = line + 1;
+                while (run_end < o_height && line_colors[run_end] == line_colors[line]) {
+                    run_end++;
+                }
+                if (line_colors[line] != 0) {
+                    painter.fillRect(0, line, o_width, run_end - line, QColor(line_colors[line]));
+                }
+                line = run_end;
+            }
+        }
+
+        overlay_sb_->setNearOverlayImage(overlay, pl_rows, start, end, positions, (o_height / o_rows));
     } else {
+        overlay_colors_.clear();
         QImage overlay;
         overlay_sb_->setNearOverlayImage(overlay);
     }
 }
 
-void PacketList::drawFarOverlay()
+// The far overlay tick marks for a row.
+int PacketList::farOverlayFlags(int row)
 {
-    if (create_far_overlay_) {
-        create_far_overlay_ = false;
+    frame_data *fdata = packet_list_model_->getRowFdata(row);
+
+    if (fdata->ref_time) return FarOverlayRefTime;
+    if (fdata->marked || fdata->ignored) return FarOverlayMarked;
+    return 0;
+}
+
+// Rows whose marks changed; only their stripes of the far overlay
+// need to be worked out again.
+void PacketList::farOverlayRowsChanged(const QModelIndexList &rows)
+{
+    foreach (QModelIndex idx, rows) {
+        if (idx.isValid()) {
+            far_overlay_dirty_rows_ << idx.row();
+        }
     }
+}
+
+void PacketList::drawFarOverlay()
+{
+    bool rows_only = !create_far_overlay_;
+    QList<int> dirty_rows = far_overlay_dirty_rows_;
+
+    create_far_overlay_ = false;
+    far_overlay_dirty_rows_.clear();
 
     if (!cap_file_ || cap_file_->state != FILE_READ_DONE) return;
 
@@ -2090,6 +2176,32 @@ void PacketList::drawFarOverlay()
     // some sort of groove.
     if (!overlay.isNull() && recent.packet_list_colorize && pl_rows > 0) {
 
+        // Each line of the overlay is a stripe of rows. Scanning all of
+        // them is slow for large captures, so when just a few rows have
+        // been marked or unmarked only their stripes are scanned again.
+        if (!rows_only || far_overlay_stripes_.size() != o_height || far_overlay_rows_ != pl_rows) {
+            far_overlay_stripes_.fill(0, o_height);
+            far_overlay_rows_ = pl_rows;
+            for (int row = 0; row < pl_rows; row++) {
+                int flags = farOverlayFlags(row);
+                if (flags) {
+                    far_overlay_stripes_[(qint64) row * o_height / pl_rows] |= flags;
+                }
+            }
+        } else {
+            foreach (int row, dirty_rows) {
+                if (row < 0 || row >= pl_rows) continue;
+                int stripe = (qint64) row * o_height / pl_rows;
+                int first = ((qint64) stripe * pl_rows + o_height - 1) / o_height;
+                int last = ((qint64) (stripe + 1) * pl_rows + o_height - 1) / o_height;
+                quint8 flags = 0;
+                for (int stripe_row = first; stripe_row < last; stripe_row++) {
+                    flags |= farOverlayFlags(stripe_row);
+                }
+                far_overlay_stripes_[stripe] = flags;
+            }
+        }
+
         QPainter painter(&overlay);
 
         // Draw text-colored tick marks on a transparent background.
@@ -2100,18 +2212,18 @@ void PacketList::drawFarOverlay()
         tick_color.setAlphaF(0.3f);
         painter.setPen(tick_color);
 
-        for (int row = 0; row < pl_rows; row++) {
-
-            frame_data *fdata = packet_list_model_->getRowFdata(row);
-            if (fdata->marked || fdata->ref_time || fdata->ignored) {
-                int new_line = row * o_height / pl_rows;
-                int tick_width = o_width / 3;
-                // Marked or ignored: left side, time refs: right side.
-                // XXX Draw ignored ticks in the middle?
-                int x1 = fdata->ref_time ? o_width - tick_width : 1;
-                int x2 = fdata->ref_time ? o_width - 1 : tick_width;
-
-                painter.drawLine(x1, new_line, x2, new_line);
+        int tick_width = o_width / 3;
+        for (int line = 0; line < o_height; line++) {
+            quint8 flags = far_overlay_stripes_[line];
+            // Marked or ignored: left side, time refs: right side.
+            // XXX Draw ignored ticks in the middle?
+            if (flags & FarOverlayMarked) {
+                painter.drawLine(1, line, tick_width, line);
+            }
+            if (flags & FarOverlayRefTime) {
+                painter.drawLine(o_width - tick_width, line, o_width - 1, line);
+            }
+            if (flags) {
                 have_marked_image = true;
             }
         }
@@ -2120,6 +2232,8 @@ void PacketList::drawFarOverlay()
             overlay_sb_->setMarkedPacketImage(overlay);
             return;
         }
+    } else {
+        far_overlay_stripes_.clear();
     }
 
     if (!have_marked_image) {
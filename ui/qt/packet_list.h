@@ -125,7 +125,18 @@ private:
     int overlay_timer_id_;
     bool create_near_overlay_;
     bool create_far_overlay_;
+    // What the near overlay was last drawn from.
     QVector<QRgb> overlay_colors_;
+    QList<int> overlay_positions_;
+    int overlay_start_;
+    int overlay_row_count_;
+    QSize overlay_size_;
+    // Tick marks for each line of the far overlay, and the rows whose
+    // marks have changed since it was drawn.
+    enum { FarOverlayMarked = 0x01, FarOverlayRefTime = 0x02 };
+    QVector<quint8> far_overlay_stripes_;
+    int far_overlay_rows_;
+    QList<int> far_overlay_dirty_rows_;
 
     QModelIndex mouse_pressed_at_;
 
@@ -150,7 +161,10 @@ private:
     void drawCurrentPacket();
     void applyRecentColumnWidths();
     void scrollViewChanged(bool at_end);
+    void dissectAhead();
     void colorsChanged();
+    int farOverlayFlags(int row);
+    void farOverlayRowsChanged(const QModelIndexList &rows);
     QString joinSummaryRow(QStringList col_parts, int row, SummaryCopyType type);
 
 signals:
@@ -0,0 +1,96 @@
+/* perf_stats_dialog.cpp
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "perf_stats_dialog.h"
+#include <ui_perf_stats_dialog.h>
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <wsutil/perf_stats.h>
+
+#include <QPushButton>
+#include <QTimer>
+#include <QTreeWidgetItem>
+
+#include "main_application.h"
+
+enum {
+    col_description_,
+    col_name_,
+    col_value_
+};
+
+// The counters are cheap to read, so keep the values current while the
+// dialog is open.
+static const int update_interval_ = 1000; // ms
+
+PerfStatsDialog::PerfStatsDialog(QWidget *parent) :
+    GeometryStateDialog(parent),
+    ui(new Ui::PerfStatsDialog),
+    update_timer_(new QTimer(this))
+{
+    ui->setupUi(this);
+    if (parent) loadGeometry(parent->width() / 2, parent->height() / 2);
+    setAttribute(Qt::WA_DeleteOnClose, true);
+    setWindowTitle(mainApp->windowTitleString(tr("Performance Statistics")));
+
+    QPushButton *reset_button = ui->buttonBox->addButton(tr("Reset"), QDialogButtonBox::ActionRole);
+    reset_button->setToolTip(tr("Start the counters and rates over."));
+    connect(reset_button, SIGNAL(clicked()), this, SLOT(resetStats()));
+
+    connect(update_timer_, SIGNAL(timeout()), this, SLOT(updateTree()));
+    update_timer_->start(update_interval_);
+
+    updateTree();
+    for (int col = 0; col < ui->statsTreeWidget->columnCount(); col++) {
+        ui->statsTreeWidget->resizeColumnToContents(col);
+    }
+}
+
+PerfStatsDialog::~PerfStatsDialog()
+{
+    delete ui;
+}
+
+void PerfStatsDialog::resetStats()
+{
+    ws_perf_reset();
+    updateTree();
+}
+
+void PerfStatsDialog::updateTree()
+{
+    GArray *stats = ws_perf_get_stats();
+
+    // The set of statistics only changes when gauges are registered or
+    // unregistered, e.g. when epan is reinitialized, so update the rows
+    // in place if we can, to keep the selection and scroll position.
+    if (ui->statsTreeWidget->topLevelItemCount() != (int)stats->len) {
+        ui->statsTreeWidget->clear();
+        for (guint i = 0; i < stats->len; i++) {
+            QTreeWidgetItem *ti = new QTreeWidgetItem();
+            ti->setTextAlignment(col_value_, Qt::AlignRight);
+            ui->statsTreeWidget->addTopLevelItem(ti);
+        }
+    }
+
+    for (guint i = 0; i < stats->len; i++) {
+        ws_perf_stat_t *stat = &g_array_index(stats, ws_perf_stat_t, i);
+        QTreeWidgetItem *ti = ui->statsTreeWidget->topLevelItem(i);
+        char *value = ws_perf_stat_value_to_str(stat);
+
+        ti->setText(col_description_, stat->description);
+        ti->setText(col_name_, stat->name);
+        ti->setText(col_value_, value);
+        g_free(value);
+    }
+    g_array_free(stats, TRUE);
+}
@@ -0,0 +1,38 @@
+/** @file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef PERF_STATS_DIALOG_H
+#define PERF_STATS_DIALOG_H
+
+#include "geometry_state_dialog.h"
+
+namespace Ui {
+class PerfStatsDialog;
+}
+
+class QTimer;
+
+class PerfStatsDialog : public GeometryStateDialog
+{
+    Q_OBJECT
+
+public:
+    explicit PerfStatsDialog(QWidget *parent = 0);
+    ~PerfStatsDialog();
+
+private slots:
+    void resetStats();
+    void updateTree();
+
+private:
+    Ui::PerfStatsDialog *ui;
+    QTimer *update_timer_;
+};
+
+#endif // PERF_STATS_DIALOG_H
@@ -452,6 +452,9 @@ void ProtoTree::foreachTreeNode(proto_node *node, gpointer proto_tree_ptr)
 void ProtoTree::foreachExpand(const QModelIndex &index = QModelIndex()) {
 
     // Restore expanded state. (Note QModelIndex() refers to the root node)
+    // Only descend into items we expand; the children of collapsed items
+    // are restored by syncExpanded when they're expanded, so that a big
+    // tree doesn't have to be walked in full.
     int children = proto_tree_model_->rowCount(index);
     QModelIndex childIndex;
     for (int child = 0; child < children; child++) {
@@ -460,8 +463,8 @@ void ProtoTree::foreachExpand(const QModelIndex &index = QModelIndex()) {
             ProtoNode *node = proto_tree_model_->protoNodeFromIndex(childIndex);
             if (node && node->isValid() && tree_expanded(node->protoNode()->finfo->tree_type)) {
                 expand(childIndex);
+                foreachExpand(childIndex);
             }
-            foreachExpand(childIndex);
         }
     }
 }
@@ -544,6 +547,12 @@ void ProtoTree::syncExpanded(const QModelIndex &index) {
     if (finfo.treeType() != -1) {
         tree_expanded_set(finfo.treeType(), TRUE);
     }
+
+    // Restore the expanded state of its children, which setRootNode
+    // skipped while this was collapsed.
+    disconnect(this, SIGNAL(expanded(QModelIndex)), this, SLOT(syncExpanded(QModelIndex)));
+    foreachExpand(index);
+    connect(this, SIGNAL(expanded(QModelIndex)), this, SLOT(syncExpanded(QModelIndex)));
 }
 
 void ProtoTree::syncCollapsed(const QModelIndex &index) {
@@ -40,6 +40,8 @@
 #include <QVariant>
 #include <QTimer>
 
+#include <algorithm>
+
 // To do:
 // - Only allow one rtpstream_info_t per RtpAudioStream?
 
@@ -169,7 +171,8 @@ void RtpAudioStream::reset(double global_start_time)
     stop_rel_time_ = start_rel_time_;
     audio_out_rate_ = 0;
     max_sample_val_ = 1;
-    packet_timestamps_.clear();
+    visual_timestamps_.clear();
+    visual_frames_.clear();
     visual_samples_.clear();
     out_of_seq_timestamps_.clear();
     jitter_drop_timestamps_.clear();
@@ -492,16 +495,16 @@ void RtpAudioStream::decodeVisual()
 
             // Create timestamp and visual sample
             for (unsigned i = 0; i < out_len; i++) {
-                double time = start_rel_time_ + (double) sample_no / visual_sample_rate_;
-                packet_timestamps_[time] = frame_num;
+                visual_timestamps_.append(start_rel_time_ + (double) sample_no / visual_sample_rate_);
+                visual_frames_.append(frame_num);
                 if (qAbs(resample_buff[i]) > max_sample_val_) max_sample_val_ = qAbs(resample_buff[i]);
                 visual_samples_.append(resample_buff[i]);
                 sample_no++;
             }
         } else {
             // Insert end of line mark
-            double time = start_rel_time_ + (double) sample_no / visual_sample_rate_;
-            packet_timestamps_[time] = frame_num;
+            visual_timestamps_.append(start_rel_time_ + (double) sample_no / visual_sample_rate_);
+            visual_frames_.append(frame_num);
             visual_samples_.append(SAMPLE_NaN);
             sample_no += out_len;
         }
@@ -521,12 +524,12 @@ const QStringList RtpAudioStream::payloadNames() const
 
 const QVector<double> RtpAudioStream::visualTimestamps(bool relative)
 {
-    QVector<double> ts_keys = packet_timestamps_.keys().toVector();
-    if (relative) return ts_keys;
+    if (relative) return visual_timestamps_;
 
     QVector<double> adj_timestamps;
-    for (int i = 0; i < ts_keys.size(); i++) {
-        adj_timestamps.append(ts_keys[i] + start_abs_offset_ - start_rel_time_);
+    adj_timestamps.reserve(visual_timestamps_.size());
+    for (int i = 0; i < visual_timestamps_.size(); i++) {
+        adj_timestamps.append(visual_timestamps_[i] + start_abs_offset_ - start_rel_time_);
     }
     return adj_timestamps;
 }
@@ -538,6 +541,7 @@ const QVector<double> RtpAudioStream::visualSamples(int y_offset)
 {
     QVector<double> adj_samples;
     double scaled_offset = y_offset * stack_offset_;
+    adj_samples.reserve(visual_samples_.size());
     for (int i = 0; i < visual_samples_.size(); i++) {
         if (SAMPLE_NaN != visual_samples_[i]) {
             adj_samples.append(((double)visual_samples_[i] * G_MAXINT16 / max_sample_val_used_) + scaled_offset);
@@ -635,12 +639,12 @@ const QVector<double> RtpAudioStream::insertedSilenceSamples(int y_offset)
 
 quint32 RtpAudioStream::nearestPacket(double timestamp, bool is_relative)
 {
-    if (packet_timestamps_.size() < 1) return 0;
+    if (visual_timestamps_.size() < 1) return 0;
 
     if (!is_relative) timestamp -= start_abs_offset_;
-    QMap<double, quint32>::iterator it = packet_timestamps_.lowerBound(timestamp);
-    if (it == packet_timestamps_.end()) return 0;
-    return it.value();
+    QVector<double>::const_iterator it = std::lower_bound(visual_timestamps_.constBegin(), visual_timestamps_.constEnd(), timestamp);
+    if (it == visual_timestamps_.constEnd()) return 0;
+    return visual_frames_.at(static_cast<int>(it - visual_timestamps_.constBegin()));
 }
 
 QAudio::State RtpAudioStream::outputState() const
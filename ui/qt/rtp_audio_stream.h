@@ -197,7 +197,9 @@ private:
     QSet<QString> payload_names_;
     struct SpeexResamplerState_ *audio_resampler_;
     struct SpeexResamplerState_ *visual_resampler_;
-    QMap<double, quint32> packet_timestamps_;
+    // One entry per visual sample, in time order.
+    QVector<double> visual_timestamps_;
+    QVector<quint32> visual_frames_;
     QVector<qint16> visual_samples_;
     QVector<double> out_of_seq_timestamps_;
     QVector<double> jitter_drop_timestamps_;
@@ -48,45 +48,21 @@ SCTPAssocAnalyseDialog::~SCTPAssocAnalyseDialog()
 
 const sctp_assoc_info_t* SCTPAssocAnalyseDialog::findAssocForPacket(capture_file* cf)
 {
-    frame_data     *fdata;
-    GList          *list, *framelist;
     const sctp_assoc_info_t *assoc;
-    bool           frame_found = false;
 
-    fdata = cf->current_frame;
     if (sctp_stat_get_info()->is_registered == FALSE) {
         register_tap_listener_sctp_stat();
         /*  (redissect all packets) */
         cf_retap_packets(cf);
     }
-    list = g_list_first(sctp_stat_get_info()->assoc_info_list);
-
-    while (list) {
-        assoc = gxx_list_data(const sctp_assoc_info_t*, list);
-
-        framelist = g_list_first(assoc->frame_numbers);
-        guint32 fn;
-        while (framelist) {
-            fn = GPOINTER_TO_UINT(framelist->data);
-            if (fn == fdata->num) {
-                frame_found = TRUE;
-                break;
-            }
-            framelist = gxx_list_next(framelist);
-        }
-        if (frame_found) {
-            return assoc;
-        } else {
-            list = gxx_list_next(list);
-        }
-    }
 
-    if (!frame_found) {
+    assoc = get_sctp_assoc_for_frame(cf->current_frame->num);
+    if (!assoc) {
         QMessageBox msgBox;
         msgBox.setText(tr("No Association found for this packet."));
         msgBox.exec();
     }
-    return Q_NULLPTR;
+    return assoc;
 }
 
 const _sctp_assoc_info* SCTPAssocAnalyseDialog::findAssoc(QWidget *parent, guint16 assoc_id)
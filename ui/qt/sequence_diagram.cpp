@@ -16,6 +16,8 @@
 #include <ui/qt/utils/qt_ui_utils.h>
 #include "ui/recent.h"
 
+#include <cmath>
+
 #include <QFont>
 #include <QFontMetrics>
 #include <QPalette>
@@ -27,16 +29,45 @@ const int max_comment_em_width_ = 20;
 // UML-like network node sequence diagrams.
 // https://developer.ibm.com/articles/the-sequence-diagram/
 
-WSCPSeqData::WSCPSeqData() :
-  key(0),
-  value(NULL)
+WSCPSeqTicker::WSCPSeqTicker(const QVector<_seq_analysis_item *> *items, LabelType label_type) :
+    items_(items),
+    label_type_(label_type),
+    elide_width_(0)
 {
 }
 
-WSCPSeqData::WSCPSeqData(double key, struct _seq_analysis_item *value) :
-  key(key),
-  value(value)
+void WSCPSeqTicker::setElideFont(const QFont &font, int elide_width)
 {
+    elide_font_ = font;
+    elide_width_ = elide_width;
+}
+
+QString WSCPSeqTicker::getTickLabel(double tick, const QLocale &, QChar, int)
+{
+    int row = qRound(tick);
+
+    if (row < 0 || row >= items_->size()) return QString();
+
+    seq_analysis_item_t *sai = items_->at(row);
+    if (label_type_ == TimeLabel) {
+        return sai->time_str;
+    }
+    return QFontMetrics(elide_font_).elidedText(sai->comment, Qt::ElideRight, elide_width_);
+}
+
+QVector<double> WSCPSeqTicker::createTickVector(double, const QCPRange &range)
+{
+    QVector<double> ticks;
+
+    if (items_->isEmpty()) return ticks;
+
+    // One tick either side of the range, as QCPAxisTickerText does.
+    int first = qMax(int(qMax(std::ceil(range.lower), 0.0)) - 1, 0);
+    int last = qMin(int(qMin(std::floor(range.upper), double(items_->size()))) + 1, int(items_->size()) - 1);
+    for (int row = first; row <= last; row++) {
+        ticks.append(row);
+    }
+    return ticks;
 }
 
 SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *commentAxis) :
@@ -44,23 +75,23 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
     key_axis_(keyAxis),
     value_axis_(valueAxis),
     comment_axis_(commentAxis),
-    data_(NULL),
     sainfo_(NULL),
     selected_packet_(0),
     selected_key_(-1.0)
 {
-    data_ = new WSCPSeqDataMap();
     // xaxis (value): Address
     // yaxis (key): Time
     // yaxis2 (comment): Extra info ("Comment" in GTK+)
 
 //    valueAxis->setAutoTickStep(false);
+    value_axis_->setTicker(QSharedPointer<QCPAxisTicker>(new QCPAxisTickerText));
+    key_axis_->setTicker(QSharedPointer<QCPAxisTicker>(new WSCPSeqTicker(&items_, WSCPSeqTicker::TimeLabel)));
+    comment_axis_->setTicker(QSharedPointer<QCPAxisTicker>(new WSCPSeqTicker(&items_, WSCPSeqTicker::CommentLabel)));
+
     QList<QCPAxis *> axes;
     axes << value_axis_ << key_axis_ << comment_axis_;
     QPen no_pen(Qt::NoPen);
     foreach (QCPAxis *axis, axes) {
-        QSharedPointer<QCPAxisTicker> ticker(new QCPAxisTickerText);
-        axis->setTicker(ticker);
         axis->setSubTickPen(no_pen);
         axis->setTickPen(no_pen);
         axis->setBasePen(no_pen);
@@ -88,83 +119,53 @@ SequenceDiagram::SequenceDiagram(QCPAxis *keyAxis, QCPAxis *valueAxis, QCPAxis *
 
 SequenceDiagram::~SequenceDiagram()
 {
-    delete data_;
+    // The time and comment tickers point to items_.
+    key_axis_->setTicker(QSharedPointer<QCPAxisTicker>(new QCPAxisTickerText));
+    comment_axis_->setTicker(QSharedPointer<QCPAxisTicker>(new QCPAxisTickerText));
 }
 
 int SequenceDiagram::adjacentPacket(bool next)
 {
-    int adjacent_packet = -1;
-    WSCPSeqDataMap::const_iterator it;
+    int key;
 
-    if (data_->size() < 1) return adjacent_packet;
+    if (items_.size() < 1) return -1;
 
     if (selected_packet_ < 1) {
-        if (next) {
-            it = data_->constBegin();
-        } else {
-            it = data_->constEnd();
-            --it;
-        }
-        selected_key_ = it.value().key;
-        return it.value().value->frame_number;
-    }
-
-    if (next) {
-        for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-            if (it.value().value->frame_number == selected_packet_) {
-                ++it;
-                if (it != data_->constEnd()) {
-                    adjacent_packet = it.value().value->frame_number;
-                    selected_key_ = it.value().key;
-                }
-                break;
-            }
-        }
+        key = next ? 0 : items_.size() - 1;
     } else {
-        it = data_->constEnd();
-        --it;
-        while (it != data_->constBegin()) {
-            guint32 prev_frame = it.value().value->frame_number;
-            --it;
-            if (prev_frame == selected_packet_) {
-                adjacent_packet = it.value().value->frame_number;
-                selected_key_ = it.value().key;
-                break;
-            }
-        }
+        key = item_keys_.value(selected_packet_, -1);
+        if (key < 0) return -1;
+        key += next ? 1 : -1;
+        if (key < 0 || key >= items_.size()) return -1;
     }
 
-    return adjacent_packet;
+    selected_key_ = key;
+    return items_.at(key)->frame_number;
 }
 
 void SequenceDiagram::setData(_seq_analysis_info *sainfo)
 {
-    data_->clear();
+    items_.clear();
+    item_keys_.clear();
     sainfo_ = sainfo;
     if (!sainfo) return;
 
-    double cur_key = 0.0;
-    QVector<double> key_ticks, val_ticks;
-    QVector<QString> key_labels, val_labels, com_labels;
+    QVector<double> val_ticks;
+    QVector<QString> val_labels;
     QFontMetrics com_fm(comment_axis_->tickLabelFont());
     int elide_w = com_fm.height() * max_comment_em_width_;
     char* addr_str;
 
+    // The time and comment labels are made by the tickers, for the rows
+    // that are visible.
+    items_.reserve(static_cast<int>(g_queue_get_length(sainfo->items)));
     for (GList *cur = g_queue_peek_nth_link(sainfo->items, 0); cur; cur = gxx_list_next(cur)) {
         seq_analysis_item_t *sai = gxx_list_data(seq_analysis_item_t *, cur);
         if (sai->display) {
-            WSCPSeqData new_data;
-
-            new_data.key = cur_key;
-            new_data.value = sai;
-            data_->insert(new_data.key, new_data);
-
-            key_ticks.append(cur_key);
-            key_labels.append(sai->time_str);
-
-            com_labels.append(com_fm.elidedText(sai->comment, Qt::ElideRight, elide_w));
-
-            cur_key++;
+            if (!item_keys_.contains(sai->frame_number)) {
+                item_keys_.insert(sai->frame_number, items_.size());
+            }
+            items_.append(sai);
         }
     }
 
@@ -179,12 +180,10 @@ void SequenceDiagram::setData(_seq_analysis_info *sainfo)
         wmem_free(Q_NULLPTR, addr_str);
     }
 
-    QSharedPointer<QCPAxisTickerText> key_ticker = qSharedPointerCast<QCPAxisTickerText>(keyAxis()->ticker());
-    key_ticker->setTicks(key_ticks, key_labels);
     QSharedPointer<QCPAxisTickerText> value_ticker = qSharedPointerCast<QCPAxisTickerText>(valueAxis()->ticker());
     value_ticker->setTicks(val_ticks, val_labels);
-    QSharedPointer<QCPAxisTickerText> comment_ticker = qSharedPointerCast<QCPAxisTickerText>(comment_axis_->ticker());
-    comment_ticker->setTicks(key_ticks, com_labels);
+    QSharedPointer<WSCPSeqTicker> comment_ticker = qSharedPointerCast<WSCPSeqTicker>(comment_axis_->ticker());
+    comment_ticker->setElideFont(comment_axis_->tickLabelFont(), elide_w);
 }
 
 void SequenceDiagram::setSelectedPacket(int selected_packet)
@@ -202,8 +201,8 @@ _seq_analysis_item *SequenceDiagram::itemForPosY(int ypos)
 {
     double key_pos = qRound(key_axis_->pixelToCoord(ypos));
 
-    if (key_pos >= 0 && key_pos < data_->size()) {
-        return data_->value(key_pos).value;
+    if (key_pos >= 0 && key_pos < items_.size()) {
+        return items_.at(key_pos);
     }
     return NULL;
 }
@@ -212,7 +211,7 @@ double SequenceDiagram::selectTest(const QPointF &pos, bool, QVariant *) const
 {
     double key_pos = qRound(key_axis_->pixelToCoord(pos.y()));
 
-    if (key_pos >= 0 && key_pos < data_->size()) {
+    if (key_pos >= 0 && key_pos < items_.size()) {
         return 1.0;
     }
 
@@ -240,17 +239,25 @@ void SequenceDiagram::draw(QCPPainter *painter)
     painter->restore();
     fg_pen = pen();
 
-    WSCPSeqDataMap::const_iterator it;
-    for (it = data_->constBegin(); it != data_->constEnd(); ++it) {
-        double cur_key = it.key();
-        seq_analysis_item_t *sai = it.value().value;
+    if (items_.isEmpty()) return;
+
+    // Rows are at keys 0, 1, ...; only look at the ones that are visible,
+    // and the ones either side whose backgrounds overlap the edges.
+    int first_key = qMax(int(qMax(std::floor(key_axis_->range().lower), 0.0)) - 1, 0);
+    int last_key = qMin(int(qMin(std::ceil(key_axis_->range().upper), double(items_.size()))) + 1, int(items_.size()) - 1);
+    if (selected_packet_ > 0) {
+        selected_key_ = item_keys_.value(selected_packet_, -1);
+    }
+
+    for (int key = first_key; key <= last_key; key++) {
+        double cur_key = key;
+        seq_analysis_item_t *sai = items_.at(key);
         QColor bg_color;
 
         if (sai->frame_number == selected_packet_) {
             QPalette sel_pal;
             fg_pen.setColor(sel_pal.color(QPalette::HighlightedText));
             bg_color = sel_pal.color(QPalette::Highlight);
-            selected_key_ = cur_key;
         } else if ((sai->has_color_filter) && (recent.packet_list_colorize)) {
             fg_pen.setColor(QColor().fromRgb(sai->fg_color));
             bg_color = QColor().fromRgb(sai->bg_color);
@@ -363,24 +370,8 @@ void SequenceDiagram::drawLegendIcon(QCPPainter *, const QRectF &) const
 
 QCPRange SequenceDiagram::getKeyRange(bool &validRange, QCP::SignDomain) const
 {
-    QCPRange range;
-    bool valid = false;
-
-    WSCPSeqDataMap::const_iterator it = data_->constBegin();
-    while (it != data_->constEnd()) {
-        double cur_key = it.key();
-        if (!valid) {
-            range.lower = range.upper = cur_key;
-            valid = true;
-        } else if (cur_key < range.lower) {
-            range.lower = cur_key;
-        } else if (cur_key > range.upper) {
-            range.upper = cur_key;
-        }
-        ++it;
-    }
-    validRange = valid;
-    return range;
+    validRange = !items_.isEmpty();
+    return validRange ? QCPRange(0, items_.size() - 1) : QCPRange();
 }
 
 QCPRange SequenceDiagram::getValueRange(bool &validRange, QCP::SignDomain, const QCPRange &) const
@@ -390,7 +381,7 @@ QCPRange SequenceDiagram::getValueRange(bool &validRange, QCP::SignDomain, const
 
     if (sainfo_) {
         range.lower = 0;
-        range.upper = data_->size();
+        range.upper = items_.size();
         valid = true;
     }
     validRange = valid;
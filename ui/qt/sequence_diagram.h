@@ -16,24 +16,40 @@
 
 #include <epan/address.h>
 
+#include <QFont>
+#include <QHash>
 #include <QObject>
-#include <QMultiMap>
+#include <QVector>
 #include <ui/qt/widgets/qcustomplot.h>
 
 struct _seq_analysis_info;
 struct _seq_analysis_item;
 
-// Some of this is probably unnecessary
-class WSCPSeqData
+// Labels the rows of the diagram with their items' times or comments.
+// Only the ticks in the visible range are created, so the labels are
+// made for the rows on screen rather than for every item in the flow.
+class WSCPSeqTicker : public QCPAxisTicker
 {
 public:
-  WSCPSeqData();
-  WSCPSeqData(double key, _seq_analysis_item *value);
-  double key;
-  struct _seq_analysis_item *value;
-};
+    enum LabelType { TimeLabel, CommentLabel };
+
+    WSCPSeqTicker(const QVector<struct _seq_analysis_item *> *items, LabelType label_type);
 
-typedef QMultiMap<double, WSCPSeqData> WSCPSeqDataMap;
+    // Comment labels are elided to elide_width using font.
+    void setElideFont(const QFont &font, int elide_width);
+
+protected:
+    virtual double getTickStep(const QCPRange &) Q_DECL_OVERRIDE { return 1.0; }
+    virtual int getSubTickCount(double) Q_DECL_OVERRIDE { return 0; }
+    virtual QString getTickLabel(double tick, const QLocale &locale, QChar formatChar, int precision) Q_DECL_OVERRIDE;
+    virtual QVector<double> createTickVector(double tickStep, const QCPRange &range) Q_DECL_OVERRIDE;
+
+private:
+    const QVector<struct _seq_analysis_item *> *items_;
+    LabelType label_type_;
+    QFont elide_font_;
+    int elide_width_;
+};
 
 class SequenceDiagram : public QCPAbstractPlottable
 {
@@ -55,7 +71,7 @@ public:
     struct _seq_analysis_item *itemForPosY(int ypos);
 
     // reimplemented virtual methods:
-    virtual void clearData() { data_->clear(); }
+    virtual void clearData() { items_.clear(); item_keys_.clear(); }
     virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=0) const Q_DECL_OVERRIDE;
 
 public slots:
@@ -71,7 +87,9 @@ private:
     QCPAxis *key_axis_;
     QCPAxis *value_axis_;
     QCPAxis *comment_axis_;
-    WSCPSeqDataMap *data_;
+    // The displayed items, one per row, and the row of each frame.
+    QVector<struct _seq_analysis_item *> items_;
+    QHash<guint32, int> item_keys_;
     struct _seq_analysis_info *sainfo_;
     guint32 selected_packet_;
     double selected_key_;
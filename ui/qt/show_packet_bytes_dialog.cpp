@@ -636,6 +636,7 @@ void ShowPacketBytesDialog::updateFieldBytes(bool initialization)
 void ShowPacketBytesDialog::updatePacketBytes(void)
 {
     static const gchar hexchars[16] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
+    static const gchar upper_hexchars[16] = {'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'};
 
     ui->tePacketBytes->clear();
     ui->tePacketBytes->setCurrentFont(mainApp->monospaceFont());
@@ -763,8 +764,10 @@ void ShowPacketBytesDialog::updatePacketBytes(void)
         int pos = 0, len = static_cast<int>(field_bytes_.length());
         // Use 16-bit offset if there are <= 65536 bytes, 32-bit offset if there are more
         unsigned int offset_chars = (len - 1 <= 0xFFFF) ? 4 : 8;
-        QString text;
-        text.reserve((len / 16) * 80);
+        // Build the whole dump as UTF-8 and convert it to a QString once,
+        // rather than converting and appending every line.
+        QByteArray text;
+        text.reserve((len / 16 + 1) * (offset_chars + 53 + 16 * (int)(sizeof(UTF8_MIDDLE_DOT) - 1) + 2));
 
         while (pos < len) {
             char hexbuf[256];
@@ -772,7 +775,10 @@ void ShowPacketBytesDialog::updatePacketBytes(void)
             int i;
 
             // Dump offset
-            cur += snprintf(cur, 20, "%0*X  ", offset_chars, pos);
+            for (i = offset_chars - 1; i >= 0; i--)
+                *cur++ = upper_hexchars[(pos >> (i * 4)) & 0xf];
+            *cur++ = ' ';
+            *cur++ = ' ';
 
             // Dump bytes as hex
             for (i = 0; i < 16 && pos + i < len; i++) {
@@ -800,13 +806,12 @@ void ShowPacketBytesDialog::updatePacketBytes(void)
 
             pos += i;
             *cur++ = '\n';
-            *cur = 0;
 
-            text.append(hexbuf);
+            text.append(hexbuf, static_cast<int>(cur - hexbuf));
         }
 
         ui->tePacketBytes->setLineWrapMode(QTextEdit::NoWrap);
-        ui->tePacketBytes->setPlainText(text);
+        ui->tePacketBytes->setPlainText(QString::fromUtf8(text));
         break;
     }
 
@@ -30,6 +30,7 @@
 #include <QDir>
 #include <QIcon>
 #include <QPushButton>
+#include <QtMath>
 
 #include <QDebug>
 
@@ -91,6 +92,79 @@ double QCPErrorBarsNotSelectable::selectTest(const QPointF &pos, bool onlySelect
     return -1.0;
 }
 
+// QCPGraph thins out points that land on the same pixel column, but
+// QCPErrorBars draws every bar in view, which for a long stream zoomed
+// out is millions of lines per repaint. When there are more bars than
+// columns, merge the spines that overlap in each column instead.
+void QCPErrorBarsNotSelectable::draw(QCPPainter *painter)
+{
+    QCPAxis *key_axis = mKeyAxis.data();
+    QCPAxis *value_axis = mValueAxis.data();
+
+    if (!mDataPlottable || !key_axis || !value_axis || mErrorType != etValueError
+            || key_axis->orientation() != Qt::Horizontal
+            || !mDataPlottable->interface1D()->sortKeyIsMainKey()
+            || key_axis->range().size() <= 0 || mDataContainer->isEmpty()) {
+        QCPErrorBars::draw(painter);
+        return;
+    }
+
+    QCPErrorBarsDataContainer::const_iterator begin, end;
+    getVisibleDataBounds(begin, end, QCPDataRange(0, dataCount()));
+    if (end - begin <= key_axis->axisRect()->width() * 2) {
+        QCPErrorBars::draw(painter);
+        return;
+    }
+
+    applyDefaultAntialiasingHint(painter);
+    painter->setBrush(Qt::NoBrush);
+    QPen pen(mPen);
+    if (pen.capStyle() == Qt::SquareCap) {
+        pen.setCapStyle(Qt::FlatCap);
+    }
+    painter->setPen(pen);
+
+    // Whiskers are left out; at this density they'd cover each other.
+    QVector<QLineF> spines, bar_lines, whiskers;
+    std::vector<std::pair<double, double> > column_spans;
+    int column = 0;
+
+    auto flush_column = [&]() {
+        if (column_spans.empty()) return;
+        std::sort(column_spans.begin(), column_spans.end());
+        double x = column + 0.5;
+        double top = column_spans[0].first;
+        double bottom = column_spans[0].second;
+        for (size_t i = 1; i < column_spans.size(); i++) {
+            // Spans less than a pixel apart look joined anyway.
+            if (column_spans[i].first > bottom + 1.0) {
+                spines << QLineF(x, top, x, bottom);
+                top = column_spans[i].first;
+            }
+            bottom = qMax(bottom, column_spans[i].second);
+        }
+        spines << QLineF(x, top, x, bottom);
+        column_spans.clear();
+    };
+
+    for (QCPErrorBarsDataContainer::const_iterator it = begin; it != end; ++it) {
+        bar_lines.clear();
+        getErrorBarLines(it, bar_lines, whiskers);
+        whiskers.clear();
+        foreach (const QLineF &line, bar_lines) {
+            int x = qFloor(line.x1());
+            if (x != column) {
+                flush_column();
+                column = x;
+            }
+            column_spans.push_back(std::make_pair(qMin(line.y1(), line.y2()), qMax(line.y1(), line.y2())));
+        }
+    }
+    flush_column();
+
+    painter->drawLines(spines);
+}
+
 TCPStreamDialog::TCPStreamDialog(QWidget *parent, capture_file *cf, tcp_graph_type graph_type) :
     GeometryStateDialog(parent),
     ui(new Ui::TCPStreamDialog),
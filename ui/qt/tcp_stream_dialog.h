@@ -41,6 +41,9 @@ public:
     virtual ~QCPErrorBarsNotSelectable();
 
     virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = 0) const Q_DECL_OVERRIDE;
+
+protected:
+    virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
 };
 
 class TCPStreamDialog : public GeometryStateDialog
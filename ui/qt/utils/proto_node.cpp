@@ -13,23 +13,35 @@
 #include <epan/prefs.h>
 
 ProtoNode::ProtoNode(proto_node *node, ProtoNode *parent) :
-    node_(node), parent_(parent)
+    node_(node), children_populated_(false), parent_(parent), row_(-1)
 {
-    if (node_) {
+}
+
+void ProtoNode::populateChildren() const
+{
+    if (children_populated_) {
+        return;
+    }
+    children_populated_ = true;
 
-        int num_children = 0;
-        for (proto_node *child = node_->first_child; child; child = child->next) {
-            if (!isHidden(child)) {
-                num_children++;
-            }
+    if (!node_) {
+        return;
+    }
+
+    int num_children = 0;
+    for (proto_node *child = node_->first_child; child; child = child->next) {
+        if (!isHidden(child)) {
+            num_children++;
         }
+    }
 
-        m_children.reserve(num_children);
+    m_children.reserve(num_children);
 
-        for (proto_node *child = node_->first_child; child; child = child->next) {
-            if (!isHidden(child)) {
-                m_children.append(new ProtoNode(child, this));
-            }
+    for (proto_node *child = node_->first_child; child; child = child->next) {
+        if (!isHidden(child)) {
+            ProtoNode *child_node = new ProtoNode(child, const_cast<ProtoNode *>(this));
+            child_node->row_ = static_cast<int>(m_children.count());
+            m_children.append(child_node);
         }
     }
 }
@@ -91,16 +103,33 @@ int ProtoNode::childrenCount() const
 {
     if (!node_) return 0;
 
+    populateChildren();
     return (int)m_children.count();
 }
 
+// Unlike childrenCount(), this doesn't wrap the children.
+bool ProtoNode::hasChildren() const
+{
+    if (!node_) return false;
+
+    if (children_populated_) {
+        return !m_children.isEmpty();
+    }
+    for (proto_node *child = node_->first_child; child; child = child->next) {
+        if (!isHidden(child)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 int ProtoNode::row()
 {
     if (!isChild()) {
         return -1;
     }
 
-    return (int)parent_->m_children.indexOf(const_cast<ProtoNode*>(this));
+    return row_;
 }
 
 bool ProtoNode::isExpanded() const
@@ -118,6 +147,7 @@ proto_node * ProtoNode::protoNode() const
 
 ProtoNode* ProtoNode::child(int row)
 {
+    populateChildren();
     if (row < 0 || row >= m_children.size())
         return nullptr;
     return m_children.at(row);
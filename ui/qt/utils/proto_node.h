@@ -45,6 +45,7 @@ public:
     proto_node *protoNode() const;
     ProtoNode *child(int row);
     int childrenCount() const;
+    bool hasChildren() const;
     int row();
     ProtoNode *parentNode();
 
@@ -54,9 +55,14 @@ public:
 
 private:
     proto_node * node_;
-    QVector<ProtoNode*>m_children;
+    // Children are wrapped when they're first asked for, so that only the
+    // parts of the tree that are shown cost anything.
+    mutable QVector<ProtoNode*>m_children;
+    mutable bool children_populated_;
     ProtoNode *parent_;
+    int row_;
     static bool isHidden(proto_node * node);
+    void populateChildren() const;
 };
 
 
@@ -21,12 +21,12 @@
 #include "ui/recent.h"
 
 #include <QActionGroup>
+#include <QFontMetricsF>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QScrollBar>
 #include <QStyle>
 #include <QStyleOption>
-#include <QTextLayout>
 
 // To do:
 // - Add recent settings and context menu items to show/hide the offset.
@@ -34,18 +34,19 @@
 // - Move more common metrics to DataPrinter.
 
 // Alternative implementations:
-// - Pre-draw all of our characters and paint our display using pixmap
-//   copying? That would make this behave like a terminal screen, which
-//   is what we ultimately want.
 // - Use QGraphicsView + QGraphicsScene + QGraphicsTextItem instead?
 
+// Number of lines of text we keep around. A little more than a screenful
+// would do, but lines are small and this makes scrolling back and forth
+// through large buffers cheap.
+static const int line_cache_size_ = 4096;
+
 Q_DECLARE_METATYPE(bytes_view_type)
 Q_DECLARE_METATYPE(bytes_encoding_type)
 Q_DECLARE_METATYPE(DataPrinter::DumpType)
 
 ByteViewText::ByteViewText(const QByteArray &data, packet_char_enc encoding, QWidget *parent) :
     QAbstractScrollArea(parent),
-    layout_(new QTextLayout()),
     data_(data),
     encoding_(encoding),
     hovered_byte_offset_(-1),
@@ -61,11 +62,12 @@ ByteViewText::ByteViewText(const QByteArray &data, packet_char_enc encoding, QWi
     show_ascii_(true),
     row_width_(recent.gui_bytes_view == BYTES_HEX ? 16 : 8),
     font_width_(0),
+    char_width_(0.0),
     line_height_(0),
-    allow_hover_selection_(false)
+    line_ascent_(0),
+    allow_hover_selection_(false),
+    line_cache_(line_cache_size_)
 {
-    layout_->setCacheEnabled(true);
-
     offset_normal_fg_ = ColorUtils::alphaBlend(palette().windowText(), palette().window(), 0.35);
     offset_field_fg_ = ColorUtils::alphaBlend(palette().windowText(), palette().window(), 0.65);
 
@@ -81,7 +83,6 @@ ByteViewText::ByteViewText(const QByteArray &data, packet_char_enc encoding, QWi
 ByteViewText::~ByteViewText()
 {
     ctx_menu_.clear();
-    delete(layout_);
 }
 
 void ByteViewText::createContextMenu()
@@ -207,7 +208,6 @@ void ByteViewText::setMonospaceFont(const QFont &mono_font)
 
     setFont(int_font);
     viewport()->setFont(int_font);
-    layout_->setFont(int_font);
 
     updateLayoutMetrics();
 
@@ -218,6 +218,8 @@ void ByteViewText::setMonospaceFont(const QFont &mono_font)
 void ByteViewText::updateByteViewSettings()
 {
     row_width_ = recent.gui_bytes_view == BYTES_HEX ? 16 : 8;
+    line_cache_.clear();
+    column_to_byte_.clear();
 
     updateContextMenu();
     updateScrollbars();
@@ -255,7 +257,6 @@ void ByteViewText::paintEvent(QPaintEvent *)
     int widget_height = height();
     painter.save();
 
-    x_pos_to_column_.clear();
     while ((int) (row_y + line_height_) < widget_height && offset < (int) data_.size()) {
         drawLine(&painter, offset, row_y);
         offset += row_width_;
@@ -365,8 +366,16 @@ const int ByteViewText::separator_interval_ = DataPrinter::separatorInterval();
 void ByteViewText::updateLayoutMetrics()
 {
     font_width_  = stringWidth("M");
+    // The font is monospaced, so this is the width of every character
+    // cell, including the fractional part that font_width_ drops.
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    char_width_ = QFontMetricsF(font()).horizontalAdvance(QChar('M'));
+#else
+    char_width_ = QFontMetricsF(font()).width(QChar('M'));
+#endif
     // We might want to match ProtoTree::rowHeight.
     line_height_ = fontMetrics().lineSpacing();
+    line_ascent_ = fontMetrics().ascent();
 }
 
 int ByteViewText::stringWidth(const QString &line)
@@ -378,51 +387,36 @@ int ByteViewText::stringWidth(const QString &line)
 #endif
 }
 
-// Draw a line of byte view text for a given offset.
-// Text highlighting is handled using QTextLayout::FormatRange.
-void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y)
+// Get the text of the line for a given offset, which only depends on the
+// data and on the display settings.
+QString ByteViewText::lineText(const int offset)
 {
-    if (isEmpty()) {
-        return;
+    QString *cached = line_cache_.object(offset);
+    if (cached) {
+        return *cached;
     }
 
-    // Build our pixel to byte offset vector the first time through.
-    bool build_x_pos = x_pos_to_column_.empty() ? true : false;
-    int tvb_len = static_cast<int>(data_.size());
-    int max_tvb_pos = qMin(offset + row_width_, tvb_len) - 1;
-    QList<QTextLayout::FormatRange> fmt_list;
-
     static const char hexchars[16] = {
         '0', '1', '2', '3', '4', '5', '6', '7',
         '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
 
+    int max_tvb_pos = qMin(offset + row_width_, static_cast<int>(data_.size())) - 1;
     QString line;
-    HighlightMode offset_mode = ModeOffsetNormal;
 
     // Offset.
     if (show_offset_) {
         line = QString(" %1 ").arg(offset, offsetChars(false), 16, QChar('0'));
-        if (build_x_pos) {
-            x_pos_to_column_.fill(-1, stringWidth(line));
-        }
     }
 
     // Hex
     if (show_hex_) {
         int ascii_start = static_cast<int>(line.length()) + DataPrinter::hexChars() + 3;
-        // Extra hover space before and after each byte.
-        int slop = font_width_ / 2;
-
-        if (build_x_pos) {
-            x_pos_to_column_ += QVector<int>().fill(-1, slop);
-        }
 
         for (int tvb_pos = offset; tvb_pos <= max_tvb_pos; tvb_pos++) {
             line += ' ';
             /* insert a space every separator_interval_ bytes */
             if ((tvb_pos != offset) && ((tvb_pos % separator_interval_) == 0)) {
                 line += ' ';
-                x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset - 1, font_width_);
             }
 
             switch (recent.gui_bytes_view) {
@@ -437,157 +431,208 @@ void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y
                 }
                 break;
             }
-            if (build_x_pos) {
-                x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset, stringWidth(line) - x_pos_to_column_.size() + slop);
-            }
-            if (tvb_pos == hovered_byte_offset_ || tvb_pos == marked_byte_offset_) {
-                int ho_len = recent.gui_bytes_view == BYTES_HEX ? 2 : 8;
-                QRect ho_rect = painter->boundingRect(QRect(), Qt::AlignHCenter|Qt::AlignVCenter, line.right(ho_len));
-                ho_rect.moveRight(stringWidth(line));
-                ho_rect.moveTop(row_y);
-                hover_outlines_.append(ho_rect);
-            }
         }
         line += QString(ascii_start - line.length(), ' ');
-        if (build_x_pos) {
-            x_pos_to_column_ += QVector<int>().fill(-1, stringWidth(line) - x_pos_to_column_.size());
-        }
-
-        addHexFormatRange(fmt_list, proto_start_, proto_len_, offset, max_tvb_pos, ModeProtocol);
-        if (addHexFormatRange(fmt_list, field_start_, field_len_, offset, max_tvb_pos, ModeField)) {
-            offset_mode = ModeOffsetField;
-        }
-        addHexFormatRange(fmt_list, field_a_start_, field_a_len_, offset, max_tvb_pos, ModeField);
     }
 
     // ASCII
     if (show_ascii_) {
-        bool in_non_printable = false;
-        int np_start = 0;
-        int np_len = 0;
-        char c;
-
         for (int tvb_pos = offset; tvb_pos <= max_tvb_pos; tvb_pos++) {
             /* insert a space every separator_interval_ bytes */
             if ((tvb_pos != offset) && ((tvb_pos % separator_interval_) == 0)) {
                 line += ' ';
-                if (build_x_pos) {
-                    x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset - 1, font_width_ / 2);
-                }
-            }
-
-            if (recent.gui_bytes_encoding != BYTES_ENC_EBCDIC && encoding_ == PACKET_CHAR_ENC_CHAR_ASCII) {
-                c = data_[tvb_pos];
-            } else {
-                c = EBCDIC_to_ASCII1(data_[tvb_pos]);
             }
 
+            char c = asciiChar(tvb_pos);
             if (g_ascii_isprint(c)) {
                 line += c;
-                if (in_non_printable) {
-                    in_non_printable = false;
-                    addAsciiFormatRange(fmt_list, np_start, np_len, offset, max_tvb_pos, ModeNonPrintable);
-                }
             } else {
                 line += UTF8_MIDDLE_DOT;
-                if (!in_non_printable) {
-                    in_non_printable = true;
-                    np_start = tvb_pos;
-                    np_len = 1;
-                } else {
-                    np_len++;
-                }
             }
-            if (build_x_pos) {
-                x_pos_to_column_ += QVector<int>().fill(tvb_pos - offset, stringWidth(line) - x_pos_to_column_.size());
+        }
+    }
+
+    line_cache_.insert(offset, new QString(line));
+    return line;
+}
+
+char ByteViewText::asciiChar(const int tvb_pos)
+{
+    if (recent.gui_bytes_encoding != BYTES_ENC_EBCDIC && encoding_ == PACKET_CHAR_ENC_CHAR_ASCII) {
+        return data_[tvb_pos];
+    }
+    return EBCDIC_to_ASCII1(data_[tvb_pos]);
+}
+
+// Map each character column of a full line to the byte it shows, or -1.
+// The space before each byte and the extra space at each separator are
+// included, so that there are no dead spots between bytes when hovering.
+void ByteViewText::updateColumnMap()
+{
+    int chars_per_byte = recent.gui_bytes_view == BYTES_HEX ? 2 : 8;
+
+    column_to_byte_.fill(-1, offsetChars() + DataPrinter::hexChars() + 3
+                         + row_width_ + ((row_width_ - 1) / separator_interval_));
+
+    for (int byte = 0; byte < row_width_; byte++) {
+        if (show_hex_) {
+            int column = hexColumn(byte);
+            if (byte > 0 && byte % separator_interval_ == 0) {
+                column_to_byte_[column - 2] = byte - 1;
+            }
+            for (int i = -1; i < chars_per_byte; i++) {
+                column_to_byte_[column + i] = byte;
+            }
+        }
+        if (show_ascii_) {
+            int column = asciiColumn(byte);
+            if (byte > 0 && byte % separator_interval_ == 0) {
+                column_to_byte_[column - 1] = byte - 1;
             }
+            column_to_byte_[column] = byte;
+        }
+    }
+}
+
+// Column of the first hex character of the byte at line_pos in a line.
+int ByteViewText::hexColumn(int line_pos)
+{
+    int chars_plus_pad = recent.gui_bytes_view == BYTES_HEX ? 3 : 9;
+    return offsetChars() + 1 // offset + spacing
+            + (line_pos / separator_interval_)
+            + (line_pos * chars_plus_pad);
+}
+
+// Column of the ASCII character of the byte at line_pos in a line.
+int ByteViewText::asciiColumn(int line_pos)
+{
+    return offsetChars() + DataPrinter::hexChars() + 3 // offset + hex + spacing
+            + (line_pos / separator_interval_)
+            + line_pos;
+}
+
+// Draw a line of byte view text for a given offset.
+// The font is monospaced, so rather than laying out each line we put
+// every character in a char_width_ wide cell, work out the highlight mode
+// of each cell, and draw each run of cells with the same mode in one go.
+void ByteViewText::drawLine(QPainter *painter, const int offset, const int row_y)
+{
+    if (isEmpty()) {
+        return;
+    }
+
+    int tvb_len = static_cast<int>(data_.size());
+    int max_tvb_pos = qMin(offset + row_width_, tvb_len) - 1;
+    const QString line = lineText(offset);
+    QVector<HighlightMode> modes(static_cast<int>(line.length()), ModeNormal);
+    HighlightMode offset_mode = ModeOffsetNormal;
+
+    // Hex
+    if (show_hex_) {
+        int ho_len = recent.gui_bytes_view == BYTES_HEX ? 2 : 8;
+
+        addHexFormatRange(modes, proto_start_, proto_len_, offset, max_tvb_pos, ModeProtocol);
+        if (addHexFormatRange(modes, field_start_, field_len_, offset, max_tvb_pos, ModeField)) {
+            offset_mode = ModeOffsetField;
+        }
+        addHexFormatRange(modes, field_a_start_, field_a_len_, offset, max_tvb_pos, ModeField);
+
+        for (int tvb_pos = offset; tvb_pos <= max_tvb_pos; tvb_pos++) {
             if (tvb_pos == hovered_byte_offset_ || tvb_pos == marked_byte_offset_) {
-                QRect ho_rect = painter->boundingRect(QRect(), 0, line.right(1));
-                ho_rect.moveRight(stringWidth(line));
-                ho_rect.moveTop(row_y);
-                hover_outlines_.append(ho_rect);
+                hover_outlines_.append(cellRect(hexColumn(tvb_pos - offset), ho_len, row_y));
             }
         }
-        if (in_non_printable) {
-            addAsciiFormatRange(fmt_list, np_start, np_len, offset, max_tvb_pos, ModeNonPrintable);
+    }
+
+    // ASCII
+    if (show_ascii_) {
+        for (int tvb_pos = offset; tvb_pos <= max_tvb_pos; tvb_pos++) {
+            if (!g_ascii_isprint(asciiChar(tvb_pos))) {
+                addAsciiFormatRange(modes, tvb_pos, 1, offset, max_tvb_pos, ModeNonPrintable);
+            }
+            if (tvb_pos == hovered_byte_offset_ || tvb_pos == marked_byte_offset_) {
+                hover_outlines_.append(cellRect(asciiColumn(tvb_pos - offset), 1, row_y));
+            }
         }
-        addAsciiFormatRange(fmt_list, proto_start_, proto_len_, offset, max_tvb_pos, ModeProtocol);
-        if (addAsciiFormatRange(fmt_list, field_start_, field_len_, offset, max_tvb_pos, ModeField)) {
+        addAsciiFormatRange(modes, proto_start_, proto_len_, offset, max_tvb_pos, ModeProtocol);
+        if (addAsciiFormatRange(modes, field_start_, field_len_, offset, max_tvb_pos, ModeField)) {
             offset_mode = ModeOffsetField;
         }
-        addAsciiFormatRange(fmt_list, field_a_start_, field_a_len_, offset, max_tvb_pos, ModeField);
+        addAsciiFormatRange(modes, field_a_start_, field_a_len_, offset, max_tvb_pos, ModeField);
     }
 
     // XXX Fields won't be highlighted if neither hex nor ascii are enabled.
-    addFormatRange(fmt_list, 0, offsetChars(), offset_mode);
+    addFormatRange(modes, 0, offsetChars(), offset_mode);
 
-    layout_->clearLayout();
-    layout_->clearFormats();
-    layout_->setText(line);
-    layout_->setFormats(fmt_list.toVector());
-    layout_->beginLayout();
-    QTextLine tl = layout_->createLine();
-    tl.setLineWidth(totalPixels());
-    tl.setLeadingIncluded(true);
-    layout_->endLayout();
-    layout_->draw(painter, QPointF(0.0, row_y));
+    int run_start = 0;
+    for (int column = 1; column <= line.length(); column++) {
+        if (column < line.length() && modes[column] == modes[run_start]) {
+            continue;
+        }
+        drawRun(painter, line.mid(run_start, column - run_start), run_start, row_y, modes[run_start]);
+        run_start = column;
+    }
 }
 
-bool ByteViewText::addFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int start, int length, HighlightMode mode)
+void ByteViewText::drawRun(QPainter *painter, const QString &text, int column, int row_y, HighlightMode mode)
 {
-    if (length < 1)
-        return false;
+    QRectF run_rect(column * char_width_, row_y, text.length() * char_width_, line_height_);
 
-    QTextLayout::FormatRange format_range;
-    format_range.start = start;
-    format_range.length = length;
     switch (mode) {
     case ModeNormal:
-        return false;
+        painter->setPen(palette().text().color());
+        break;
     case ModeField:
-        format_range.format.setBackground(palette().highlight());
-        format_range.format.setForeground(palette().highlightedText());
+        painter->fillRect(run_rect, palette().highlight());
+        painter->setPen(palette().highlightedText().color());
         break;
     case ModeProtocol:
-        format_range.format.setBackground(palette().window());
-        format_range.format.setForeground(palette().windowText());
+        painter->fillRect(run_rect, palette().window());
+        painter->setPen(palette().windowText().color());
         break;
     case ModeOffsetNormal:
-        format_range.format.setForeground(offset_normal_fg_);
+    case ModeNonPrintable:
+        painter->setPen(offset_normal_fg_);
         break;
     case ModeOffsetField:
-        format_range.format.setForeground(offset_field_fg_);
-        break;
-    case ModeNonPrintable:
-        format_range.format.setForeground(offset_normal_fg_);
+        painter->setPen(offset_field_fg_);
         break;
     }
-    fmt_list << format_range;
+    painter->drawText(QPointF(run_rect.left(), row_y + line_ascent_), text);
+}
+
+QRect ByteViewText::cellRect(int column, int length, int row_y)
+{
+    return QRectF(column * char_width_, row_y, length * char_width_, line_height_).toRect();
+}
+
+bool ByteViewText::addFormatRange(QVector<HighlightMode> &modes, int start, int length, HighlightMode mode)
+{
+    if (length < 1 || mode == ModeNormal)
+        return false;
+
+    int end = qMin(start + length, static_cast<int>(modes.size()));
+    for (int column = qMax(start, 0); column < end; column++) {
+        modes[column] = mode;
+    }
     return true;
 }
 
-bool ByteViewText::addHexFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, ByteViewText::HighlightMode mode)
+bool ByteViewText::addHexFormatRange(QVector<HighlightMode> &modes, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, ByteViewText::HighlightMode mode)
 {
     int mark_end = mark_start + mark_length - 1;
     if (mark_start < 0 || mark_length < 1) return false;
     if (mark_start > max_tvb_pos && mark_end < tvb_offset) return false;
 
     int chars_per_byte = recent.gui_bytes_view == BYTES_HEX ? 2 : 8;
-    int chars_plus_pad = chars_per_byte + 1;
     int byte_start = qMax(tvb_offset, mark_start) - tvb_offset;
     int byte_end = qMin(max_tvb_pos, mark_end) - tvb_offset;
-    int fmt_start = offsetChars() + 1 // offset + spacing
-            + (byte_start / separator_interval_)
-            + (byte_start * chars_plus_pad);
-    int fmt_length = offsetChars() + 1 // offset + spacing
-            + (byte_end / separator_interval_)
-            + (byte_end * chars_plus_pad)
-            + chars_per_byte
-            - fmt_start;
-    return addFormatRange(fmt_list, fmt_start, fmt_length, mode);
+    int fmt_start = hexColumn(byte_start);
+    int fmt_length = hexColumn(byte_end) + chars_per_byte - fmt_start;
+    return addFormatRange(modes, fmt_start, fmt_length, mode);
 }
 
-bool ByteViewText::addAsciiFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, ByteViewText::HighlightMode mode)
+bool ByteViewText::addAsciiFormatRange(QVector<HighlightMode> &modes, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, ByteViewText::HighlightMode mode)
 {
     int mark_end = mark_start + mark_length - 1;
     if (mark_start < 0 || mark_length < 1) return false;
@@ -595,15 +640,11 @@ bool ByteViewText::addAsciiFormatRange(QList<QTextLayout::FormatRange> &fmt_list
 
     int byte_start = qMax(tvb_offset, mark_start) - tvb_offset;
     int byte_end = qMin(max_tvb_pos, mark_end) - tvb_offset;
-    int fmt_start = offsetChars() + DataPrinter::hexChars() + 3 // offset + hex + spacing
-            + (byte_start / separator_interval_)
-            + byte_start;
-    int fmt_length = offsetChars() + DataPrinter::hexChars() + 3 // offset + hex + spacing
-            + (byte_end / separator_interval_)
-            + byte_end
+    int fmt_start = asciiColumn(byte_start);
+    int fmt_length = asciiColumn(byte_end)
             + 1 // Just one character.
             - fmt_start;
-    return addFormatRange(fmt_list, fmt_start, fmt_length, mode);
+    return addFormatRange(modes, fmt_start, fmt_length, mode);
 }
 
 void ByteViewText::scrollToByte(int byte)
@@ -689,16 +730,23 @@ void ByteViewText::updateScrollbars()
 
 int ByteViewText::byteOffsetAtPixel(QPoint pos)
 {
+    if (char_width_ <= 0.0) {
+        return -1;
+    }
+    if (column_to_byte_.isEmpty()) {
+        updateColumnMap();
+    }
+
     int byte = (verticalScrollBar()->value() + (pos.y() / line_height_)) * row_width_;
-    int x = (horizontalScrollBar()->value() * font_width_) + pos.x();
-    int col = x_pos_to_column_.value(x, -1);
+    qreal x = (horizontalScrollBar()->value() * font_width_) + pos.x();
+    int col = x < 0 ? -1 : column_to_byte_.value(int(x / char_width_), -1);
 
     if (col < 0) {
         return -1;
     }
 
     byte += col;
-    if (byte > data_.size()) {
+    if (byte >= data_.size()) {
         return -1;
     }
     return byte;
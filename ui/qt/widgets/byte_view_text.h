@@ -15,12 +15,12 @@
 #include "ui/recent.h"
 
 #include <QAbstractScrollArea>
+#include <QCache>
 #include <QFont>
 #include <QVector>
 #include <QMenu>
 #include <QSize>
 #include <QString>
-#include <QTextLayout>
 #include <QVector>
 
 #include <ui/qt/utils/data_printer.h>
@@ -74,15 +74,21 @@ private:
         ModeNonPrintable
     } HighlightMode;
 
-    QTextLayout *layout_;
     const QByteArray data_;
 
     void updateLayoutMetrics();
     int stringWidth(const QString &line);
+    QString lineText(const int offset);
+    char asciiChar(const int tvb_pos);
+    void updateColumnMap();
+    int hexColumn(int line_pos);
+    int asciiColumn(int line_pos);
     void drawLine(QPainter *painter, const int offset, const int row_y);
-    bool addFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int start, int length, HighlightMode mode);
-    bool addHexFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, HighlightMode mode);
-    bool addAsciiFormatRange(QList<QTextLayout::FormatRange> &fmt_list, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, HighlightMode mode);
+    void drawRun(QPainter *painter, const QString &text, int column, int row_y, HighlightMode mode);
+    QRect cellRect(int column, int length, int row_y);
+    bool addFormatRange(QVector<HighlightMode> &modes, int start, int length, HighlightMode mode);
+    bool addHexFormatRange(QVector<HighlightMode> &modes, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, HighlightMode mode);
+    bool addAsciiFormatRange(QVector<HighlightMode> &modes, int mark_start, int mark_length, int tvb_offset, int max_tvb_pos, HighlightMode mode);
     void scrollToByte(int byte);
     void updateScrollbars();
     int byteOffsetAtPixel(QPoint pos);
@@ -122,13 +128,18 @@ private:
     bool show_ascii_;           // Should we show the ASCII display?
     int row_width_;             // Number of bytes per line
     int font_width_;            // Single character width and text margin. NOTE: Use fontMetrics::width for multiple characters.
+    qreal char_width_;          // Exact character cell width, for painting and hit testing
     int line_height_;           // Font line spacing
+    int line_ascent_;           // Font ascent
     QList<QRect> hover_outlines_; // Hovered byte outlines.
 
     bool allow_hover_selection_;
 
+    // Lines of text by offset
+    QCache<int, QString> line_cache_;
+
     // Data selection
-    QVector<int> x_pos_to_column_;
+    QVector<int> column_to_byte_;   // Byte in a line shown in each character column
 
     // Context menu actions
     QAction *action_allow_hover_selection_;
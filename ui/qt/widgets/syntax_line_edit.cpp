@@ -32,10 +32,59 @@
 #include <QScrollBar>
 #include <QStringListModel>
 #include <QStyleOptionFrame>
+#include <QVector>
+#include <algorithm>
 #include <limits>
 
 const int max_completion_items_ = 20;
 
+// The filter names of every protocol and field, sorted without regard to
+// case, so that the names that start with a word are found with a binary
+// search instead of a walk over every registered field. The names are
+// kept in one buffer, since there can be hundreds of thousands of them.
+struct FilterNameEntry {
+    int name_offset;    // into filter_names_
+    int proto_id;
+    int proto_dots;     // periods in the protocol's filter name
+    bool is_protocol;
+};
+
+static QByteArray filter_names_;
+static QVector<FilterNameEntry> filter_name_index_;
+
+static void buildFilterNameIndex()
+{
+    void *proto_cookie;
+
+    filter_names_.clear();
+    filter_name_index_.clear();
+
+    for (int proto_id = proto_get_first_protocol(&proto_cookie); proto_id != -1; proto_id = proto_get_next_protocol(&proto_cookie)) {
+        const char *pfname = proto_get_protocol_filter_name(proto_id);
+        int proto_dots = static_cast<int>(QByteArray(pfname).count('.'));
+        FilterNameEntry entry = { static_cast<int>(filter_names_.size()), proto_id, proto_dots, true };
+
+        filter_names_.append(pfname, static_cast<int>(strlen(pfname)) + 1);
+        filter_name_index_ << entry;
+
+        void *field_cookie;
+        for (header_field_info *hfinfo = proto_get_first_protocol_field(proto_id, &field_cookie); hfinfo; hfinfo = proto_get_next_protocol_field(proto_id, &field_cookie)) {
+            if (hfinfo->same_name_prev_id != -1) continue; // Ignore duplicate names.
+
+            entry.name_offset = static_cast<int>(filter_names_.size());
+            entry.is_protocol = false;
+            filter_names_.append(hfinfo->abbrev, static_cast<int>(strlen(hfinfo->abbrev)) + 1);
+            filter_name_index_ << entry;
+        }
+    }
+
+    const char *names = filter_names_.constData();
+    std::sort(filter_name_index_.begin(), filter_name_index_.end(),
+              [names](const FilterNameEntry &a, const FilterNameEntry &b) {
+        return g_ascii_strcasecmp(names + a.name_offset, names + b.name_offset) < 0;
+    });
+}
+
 SyntaxLineEdit::SyntaxLineEdit(QWidget *parent) :
     QLineEdit(parent),
     completer_(NULL),
@@ -295,6 +344,49 @@ void SyntaxLineEdit::checkInteger(QString number)
     }
 }
 
+void SyntaxLineEdit::invalidateFieldCompletions()
+{
+    filter_names_.clear();
+    filter_name_index_.clear();
+}
+
+QStringList SyntaxLineEdit::fieldCompletionList(const QString &field_word)
+{
+    QStringList field_list;
+
+    if (filter_name_index_.isEmpty()) {
+        buildFilterNameIndex();
+    }
+
+    const QByteArray fw_ba = field_word.toUtf8();
+    const char *fw_utf8 = fw_ba.constData();
+    gsize fw_len = (gsize) strlen(fw_utf8);
+    const char *names = filter_names_.constData();
+    int field_dots = static_cast<int>(field_word.count('.')); // Some protocol names (_ws.expert) contain periods.
+
+    auto it = std::lower_bound(filter_name_index_.cbegin(), filter_name_index_.cend(), fw_utf8,
+                               [names](const FilterNameEntry &entry, const char *word) {
+        return g_ascii_strcasecmp(names + entry.name_offset, word) < 0;
+    });
+    for (; it != filter_name_index_.cend(); ++it) {
+        const char *name = names + it->name_offset;
+
+        if (g_ascii_strncasecmp(fw_utf8, name, fw_len)) break;
+
+        if (!proto_is_protocol_enabled(find_protocol_by_id(it->proto_id))) continue;
+
+        if (it->is_protocol) {
+            field_list << name;
+        } else if (field_dots > it->proto_dots && strlen(name) != fw_len) {
+            // Add fields only if we're past the protocol name.
+            field_list << name;
+        }
+    }
+    field_list.sort();
+
+    return field_list;
+}
+
 bool SyntaxLineEdit::isComplexFilter(const QString &filter)
 {
     bool is_complex = false;
@@ -44,6 +44,10 @@ public:
                                                 const QString &err_msg,
                                                 qsizetype loc_start, size_t loc_length);
 
+    // Rebuild the protocol and field name index used for completion the
+    // next time it's needed, e.g. after Lua plugins have been reloaded.
+    static void invalidateFieldCompletions();
+
 public slots:
     void setStyleSheet(const QString &style_sheet);
     // Insert filter text at the current position, adding spaces where needed.
@@ -60,6 +64,8 @@ protected:
     QStringListModel *completion_model_;
     void setCompletionTokenChars(const QString &token_chars) { token_chars_ = token_chars; }
     bool isComplexFilter(const QString &filter);
+    // Protocol and field names that complete field_word.
+    QStringList fieldCompletionList(const QString &field_word);
     virtual void buildCompletionList(const QString&) { }
     // x = Start position, y = length
     QPoint getTokenUnderCursor();
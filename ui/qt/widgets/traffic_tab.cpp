@@ -136,7 +136,11 @@ QTreeView * TrafficTab::createTree(int protoId)
             }
         }
 
-        TrafficDataFilterProxy * proxyModel = new TrafficDataFilterProxy();
+        /* The tree owns its models, so that removing the tab also removes
+         * the tap listener rather than leaving it to collect data on every
+         * following retap. */
+        TrafficDataFilterProxy * proxyModel = new TrafficDataFilterProxy(tree);
+        model->setParent(proxyModel);
         proxyModel->setSourceModel(model);
         tree->setModel(proxyModel);
 
@@ -155,6 +159,8 @@ QTreeView * TrafficTab::createTree(int protoId)
             }
         });
         connect(proxyModel, &TrafficDataFilterProxy::modelReset, this, &TrafficTab::modelReset);
+        /* While tapping, new rows are inserted rather than the model being reset */
+        connect(proxyModel, &TrafficDataFilterProxy::rowsInserted, this, &TrafficTab::modelReset);
 
         /* If the columns for the tree have changed, contact the tab. By also having the tab
          * columns changed signal connecting back to the tree, it will propagate to all trees
@@ -204,12 +210,14 @@ void TrafficTab::setOpenTabs(QList<int> protocols)
 {
     QList<int> tabs = _tabs.keys();
     QList<int> remove;
+    bool added = false;
     blockSignals(true);
 
     foreach(int protocol, protocols)
     {
         if (! tabs.contains(protocol)) {
             insertProtoTab(protocol, false);
+            added = true;
         }
         tabs.removeAll(protocol);
     }
@@ -220,7 +228,9 @@ void TrafficTab::setOpenTabs(QList<int> protocols)
     blockSignals(false);
 
     emit tabsChanged(_tabs.keys());
-    emit retapRequired();
+    /* Only new tables need data; the others already have theirs */
+    if (added)
+        emit retapRequired();
 }
 
 void TrafficTab::insertProtoTab(int protoId, bool emitSignals)
@@ -294,7 +304,11 @@ void TrafficTab::removeProtoTab(int protoId, bool emitSignals)
         for(int idx = 0; idx < count(); idx++) {
             TabData tabData = qvariant_cast<TabData>(tabBar()->tabData(idx));
             if (protoId == tabData.protoId()) {
+                QWidget * tree = widget(idx);
                 removeTab(idx);
+                /* Deleting the tree deletes its model and tap listener. A
+                 * retap may be running, so leave it to the event loop. */
+                tree->deleteLater();
                 break;
             }
         }
@@ -309,10 +323,9 @@ void TrafficTab::removeProtoTab(int protoId, bool emitSignals)
         _tabs.insert(tabData.protoId(), idx);
     }
 
-    if (emitSignals) {
+    /* The remaining tables keep their data, so there's nothing to retap */
+    if (emitSignals)
         emit tabsChanged(_tabs.keys());
-        emit retapRequired();
-    }
 }
 
 void TrafficTab::doCurrentIndexChange(const QModelIndex & cur, const QModelIndex &)
@@ -170,15 +170,21 @@ void WirelessTimeline::mouseReleaseEvent(QMouseEvent *event)
 
 void WirelessTimeline::clip_tsf()
 {
+    if (radio_start_tsf.isEmpty())
+        return;
+
+    guint64 first_start_tsf = radio_start_tsf.first();
+    guint64 last_end_tsf = radio_end_tsf.last();
+
     // did we go past the start of the file?
-    if (((gint64) start_tsf) < ((gint64) first->start_tsf)) {
+    if (((gint64) start_tsf) < ((gint64) first_start_tsf)) {
         // align the start of the file at the left edge
-        guint64 shift = first->start_tsf - start_tsf;
+        guint64 shift = first_start_tsf - start_tsf;
         start_tsf += shift;
         end_tsf += shift;
     }
-    if (end_tsf > last->end_tsf) {
-        guint64 shift = end_tsf - last->end_tsf;
+    if (end_tsf > last_end_tsf) {
+        guint64 shift = end_tsf - last_end_tsf;
         start_tsf -= shift;
         end_tsf -= shift;
     }
@@ -190,43 +196,42 @@ void WirelessTimeline::selectedFrameChanged(QList<int>)
     if (isHidden())
         return;
 
-    if (cfile.current_frame) {
-        struct wlan_radio *wr = get_wlan_radio(cfile.current_frame->num);
+    if (cfile.current_frame && have_radio(cfile.current_frame->num)) {
+        guint64 wr_start_tsf = radio_start(cfile.current_frame->num);
+        guint64 wr_end_tsf = radio_end(cfile.current_frame->num);
 
         guint left_margin = 0.9 * start_tsf + 0.1 * end_tsf;
         guint right_margin = 0.1 * start_tsf + 0.9 * end_tsf;
         guint64 half_window = (end_tsf - start_tsf)/2;
 
-        if (wr) {
-            // are we to the left of the left margin?
-            if (wr->start_tsf < left_margin) {
-                // scroll the left edge back to the left margin
-                guint64 offset = left_margin - wr->start_tsf;
-                if (offset < half_window) {
-                    // small movement; keep packet to margin
-                    start_tsf -= offset;
-                    end_tsf -= offset;
-                } else {
-                    // large movement; move packet to center of window
-                    guint64 center = (wr->start_tsf + wr->end_tsf)/2;
-                    start_tsf = center - half_window;
-                    end_tsf = center + half_window;
-                }
-            } else if (wr->end_tsf > right_margin) {
-                guint64 offset = wr->end_tsf - right_margin;
-                if (offset < half_window) {
-                    start_tsf += offset;
-                    end_tsf += offset;
-                } else {
-                    guint64 center = (wr->start_tsf + wr->end_tsf)/2;
-                    start_tsf = center - half_window;
-                    end_tsf = center + half_window;
-                }
+        // are we to the left of the left margin?
+        if (wr_start_tsf < left_margin) {
+            // scroll the left edge back to the left margin
+            guint64 offset = left_margin - wr_start_tsf;
+            if (offset < half_window) {
+                // small movement; keep packet to margin
+                start_tsf -= offset;
+                end_tsf -= offset;
+            } else {
+                // large movement; move packet to center of window
+                guint64 center = (wr_start_tsf + wr_end_tsf)/2;
+                start_tsf = center - half_window;
+                end_tsf = center + half_window;
+            }
+        } else if (wr_end_tsf > right_margin) {
+            guint64 offset = wr_end_tsf - right_margin;
+            if (offset < half_window) {
+                start_tsf += offset;
+                end_tsf += offset;
+            } else {
+                guint64 center = (wr_start_tsf + wr_end_tsf)/2;
+                start_tsf = center - half_window;
+                end_tsf = center + half_window;
             }
-            clip_tsf();
-
-            update();
         }
+        clip_tsf();
+
+        update();
     }
 }
 
@@ -250,8 +255,9 @@ void WirelessTimeline::captureFileReadStarted(capture_file *cf)
 
 void WirelessTimeline::captureFileReadFinished()
 {
-    /* All frames must be included in packet list */
-    if (cfile.count == 0 || g_hash_table_size(radio_packet_list) != cfile.count)
+    /* All frames must be included in packet list, and the summary
+     * not have been made yet */
+    if (cfile.count == 0 || radio_frames != cfile.count || radio_info.size() != (int) cfile.count)
         return;
 
     /* check that all frames have start and end tsf time and are reasonable time order.
@@ -267,7 +273,7 @@ void WirelessTimeline::captureFileReadFinished()
     /* TODO: update GUI to handle captures with occasional frames missing TSF data */
     /* TODO: indicate error message to the user */
     for (guint32 n = 1; n < cfile.count; n++) {
-        struct wlan_radio *w = get_wlan_radio(n);
+        const struct wlan_radio *w = radio_info[n-1];
         if (w->start_tsf == 0 || w->end_tsf == 0) {
             QString err = tr("Packet number %1 does not include TSF timestamp, not showing timeline.").arg(n);
             mainApp->pushStatus(MainApplication::TemporaryStatus, err);
@@ -280,11 +286,10 @@ void WirelessTimeline::captureFileReadFinished()
         }
     }
 
-    first = get_wlan_radio(1);
-    last = get_wlan_radio(cfile.count);
+    build_radio_summary();
 
-    start_tsf = first->start_tsf;
-    end_tsf = last->end_tsf;
+    start_tsf = radio_start_tsf.first();
+    end_tsf = radio_end_tsf.last();
 
     /* TODO: only reset the zoom level if the file is changed, not on redissection */
     zoom_level = 0;
@@ -337,20 +342,17 @@ WirelessTimeline::WirelessTimeline(QWidget *parent) : QWidget(parent)
     packet_list = NULL;
     start_tsf = 0;
     end_tsf = 0;
-    first = NULL;
-    last = NULL;
     capfile = NULL;
+    radio_frames = 0;
+    cache_start_tsf = 0;
+    cache_end_tsf = 0;
+    cache_displayed_count = 0;
 
-    radio_packet_list = g_hash_table_new(g_direct_hash, g_direct_equal);
     connect(mainApp, SIGNAL(appInitialized()), this, SLOT(appInitialized()));
 }
 
 WirelessTimeline::~WirelessTimeline()
 {
-    if (radio_packet_list != NULL)
-    {
-        g_hash_table_destroy(radio_packet_list);
-    }
 }
 
 void WirelessTimeline::setPacketList(PacketList *packet_list)
@@ -362,13 +364,16 @@ void WirelessTimeline::tap_timeline_reset(void* tapdata)
 {
     WirelessTimeline* timeline = (WirelessTimeline*)tapdata;
 
-    if (timeline->radio_packet_list != NULL)
-    {
-        g_hash_table_destroy(timeline->radio_packet_list);
-    }
     timeline->hide();
 
-    timeline->radio_packet_list = g_hash_table_new(g_direct_hash, g_direct_equal);
+    timeline->radio_info.clear();
+    timeline->radio_frames = 0;
+    timeline->radio_start_tsf.clear();
+    timeline->radio_end_tsf.clear();
+    timeline->radio_ifs.clear();
+    timeline->radio_nav.clear();
+    timeline->radio_rssi.clear();
+    timeline->packet_cache = QPixmap();
 }
 
 tap_packet_status WirelessTimeline::tap_timeline_packet(void *tapdata, packet_info* pinfo, epan_dissect_t* edt _U_, const void *data, tap_flags_t)
@@ -376,23 +381,64 @@ tap_packet_status WirelessTimeline::tap_timeline_packet(void *tapdata, packet_in
     WirelessTimeline* timeline = (WirelessTimeline*)tapdata;
     const struct wlan_radio *wlan_radio_info = (const struct wlan_radio *)data;
 
-    /* Save the radio information in our own (GUI) hashtable */
-    g_hash_table_insert(timeline->radio_packet_list, GUINT_TO_POINTER(pinfo->num), (gpointer)wlan_radio_info);
+    /* Save the radio information by frame number; frames come in order */
+    int idx = (int) pinfo->num - 1;
+    if (idx == timeline->radio_info.size()) {
+        timeline->radio_info.append(NULL);
+    } else if (idx > timeline->radio_info.size()) {
+        timeline->radio_info.resize(idx + 1);
+    }
+    if (timeline->radio_info[idx] == NULL) {
+        timeline->radio_frames++;
+    }
+    timeline->radio_info[idx] = wlan_radio_info;
     return TAP_PACKET_DONT_REDRAW;
 }
 
-struct wlan_radio* WirelessTimeline::get_wlan_radio(guint32 packet_num)
+bool WirelessTimeline::have_radio(guint32 packet_num) const
 {
-    return (struct wlan_radio*)g_hash_table_lookup(radio_packet_list, GUINT_TO_POINTER(packet_num));
+    return packet_num >= 1 && packet_num <= (guint32) radio_start_tsf.size();
 }
 
-void WirelessTimeline::doToolTip(struct wlan_radio *wr, QPoint pos, int x)
+/* Copy what we draw out of the wlan_radio structs, which can't be done in
+ * the tap as the dissector fixes up the times of the earlier frames of an
+ * aggregate when it sees its last frame. The columns are far smaller and
+ * faster to walk than the structs, and are all we look at from now on. */
+void WirelessTimeline::build_radio_summary()
 {
-    if (x < position(wr->start_tsf, 1.0)) {
-        QToolTip::showText(pos, QString("Inter frame space %1 " UTF8_MICRO_SIGN "s").arg(wr->ifs));
+    int count = radio_info.size();
+
+    radio_start_tsf.resize(count);
+    radio_end_tsf.resize(count);
+    radio_ifs.resize(count);
+    radio_nav.resize(count);
+    radio_rssi.resize(count);
+
+    for (int i = 0; i < count; i++) {
+        const struct wlan_radio *wr = radio_info[i];
+
+        radio_start_tsf[i] = wr->start_tsf;
+        radio_end_tsf[i] = wr->end_tsf;
+        radio_ifs[i] = (gint32) CLAMP(wr->ifs, G_MININT32, G_MAXINT32);
+        radio_nav[i] = wr->nav;
+        radio_rssi[i] = wr->aggregate ? wr->aggregate->rssi : wr->rssi;
+    }
+
+    radio_info.clear();
+    radio_info.squeeze();
+    packet_cache = QPixmap();
+}
+
+void WirelessTimeline::doToolTip(guint32 packet_num, QPoint pos, int x)
+{
+    guint64 wr_start_tsf = radio_start(packet_num);
+    guint64 wr_end_tsf = radio_end(packet_num);
+
+    if (x < position(wr_start_tsf, 1.0)) {
+        QToolTip::showText(pos, QString("Inter frame space %1 " UTF8_MICRO_SIGN "s").arg(radio_ifs[packet_num-1]));
     } else {
         QToolTip::showText(pos, QString("Total duration %1 " UTF8_MICRO_SIGN "s\nNAV %2 " UTF8_MICRO_SIGN "s")
-                           .arg(wr->end_tsf-wr->start_tsf).arg(wr->nav));
+                           .arg(wr_end_tsf-wr_start_tsf).arg(radio_nav[packet_num-1]));
     }
 }
 
@@ -402,8 +448,8 @@ bool WirelessTimeline::event(QEvent *event)
     if (event->type() == QEvent::ToolTip) {
         QHelpEvent *helpEvent = static_cast<QHelpEvent *>(event);
         guint packet = find_packet(helpEvent->pos().x());
-        if (packet) {
-            doToolTip(get_wlan_radio(packet), helpEvent->globalPos(), helpEvent->x());
+        if (have_radio(packet)) {
+            doToolTip(packet, helpEvent->globalPos(), helpEvent->x());
         } else {
             QToolTip::hideText();
             event->ignore();
@@ -436,13 +482,13 @@ void WirelessTimeline::bgColorizationProgress(int first, int last)
 {
     if (isHidden()) return;
 
-    struct wlan_radio *first_wr = get_wlan_radio(first);
+    if (!have_radio(first) || !have_radio(last-1)) return;
 
-    struct wlan_radio *last_wr = get_wlan_radio(last-1);
-
-    int x = position(first_wr->start_tsf, 1);
-    int x_end = position(last_wr->end_tsf, 1);
+    int x = position(radio_start(first), 1);
+    int x_end = position(radio_end(last-1), 1);
 
+    /* the colors of these packets have changed, render them again */
+    packet_cache_dirty += QRect(x, 0, x_end-x+1, height());
     update(x, 0, x_end-x+1, height());
 }
 
@@ -451,7 +497,7 @@ void WirelessTimeline::bgColorizationProgress(int first, int last)
 void WirelessTimeline::zoom(double x_fraction)
 {
     /* adjust the zoom around the selected packet */
-    guint64 file_range = last->end_tsf - first->start_tsf;
+    guint64 file_range = radio_end_tsf.last() - radio_start_tsf.first();
     guint64 center = start_tsf + x_fraction * (end_tsf - start_tsf);
     guint64 span = pow(file_range, 1.0 - zoom_level / TIMELINE_MAX_ZOOM);
     start_tsf = center - span * x_fraction;
@@ -462,17 +508,19 @@ void WirelessTimeline::zoom(double x_fraction)
 
 int WirelessTimeline::find_packet_tsf(guint64 tsf)
 {
-    if (cfile.count < 1)
+    guint32 count = (guint32) radio_end_tsf.size();
+
+    if (count < 1)
         return 0;
 
-    if (cfile.count < 2)
+    if (count < 2)
         return 1;
 
     guint32 min_count = 1;
-    guint32 max_count = cfile.count-1;
+    guint32 max_count = count-1;
 
-    guint64 min_tsf = get_wlan_radio(min_count)->end_tsf;
-    guint64 max_tsf = get_wlan_radio(max_count)->end_tsf;
+    guint64 min_tsf = radio_end(min_count);
+    guint64 max_tsf = radio_end(max_count);
 
     for (;;) {
         if (tsf >= max_tsf)
@@ -485,7 +533,7 @@ int WirelessTimeline::find_packet_tsf(guint64 tsf)
         if (middle == min_count)
             return middle+1;
 
-        guint64 middle_tsf = get_wlan_radio(middle)->end_tsf;
+        guint64 middle_tsf = radio_end(middle);
 
         if (tsf >= middle_tsf) {
             min_count = middle;
@@ -498,22 +546,14 @@ int WirelessTimeline::find_packet_tsf(guint64 tsf)
 }
 
 void
-WirelessTimeline::paintEvent(QPaintEvent *qpe)
+WirelessTimeline::paintEvent(QPaintEvent *)
 {
     QPainter p(this);
 
     // painting is done in device pixels in the x axis, get the ratio here
     float ratio = p.device()->devicePixelRatio();
 
-    unsigned int packet;
-    double zoom;
-    int last_x=-1;
-    int left = qpe->rect().left()*ratio;
-    int right = qpe->rect().right()*ratio;
-    float rgb[TIMELINE_HEIGHT][3];
-    reset_rgb(rgb);
-
-    zoom = ((double) width())/(end_tsf - start_tsf) * ratio;
+    int x1, x2;
 
     /* background is light grey */
     p.fillRect(0, 0, width(), TIMELINE_HEIGHT, QColor(240,240,240));
@@ -524,32 +564,82 @@ WirelessTimeline::paintEvent(QPaintEvent *qpe)
 
     frame_data * topData = packet_list->getFDataForRow(top);
     frame_data * botData = packet_list->getFDataForRow(bottom);
-    if (! topData || ! botData)
+    if (! topData || ! botData || ! have_radio(topData->num) || ! have_radio(botData->num))
         return;
 
-    int x1 = top == -1 ? 0 : position(get_wlan_radio(topData->num)->start_tsf, ratio);
-    int x2 = bottom == -1 ? width() : position(get_wlan_radio(botData->num)->end_tsf, ratio);
+    x1 = top == -1 ? 0 : position(radio_start(topData->num), ratio);
+    x2 = bottom == -1 ? width() : position(radio_end(botData->num), ratio);
     p.fillRect(QRectF(x1/ratio, 0, (x2-x1+1)/ratio, TIMELINE_HEIGHT), Qt::white);
 
     /* background of current packet is blue */
-    if (cfile.current_frame) {
-        struct wlan_radio *wr = get_wlan_radio(cfile.current_frame->num);
-        if (wr) {
-            x1 = position(wr->start_tsf, ratio);
-            x2 = position(wr->end_tsf, ratio);
-            p.fillRect(QRectF(x1/ratio, 0, (x2-x1+1)/ratio, TIMELINE_HEIGHT), Qt::blue);
-        }
+    if (cfile.current_frame && have_radio(cfile.current_frame->num)) {
+        x1 = position(radio_start(cfile.current_frame->num), ratio);
+        x2 = position(radio_end(cfile.current_frame->num), ratio);
+        p.fillRect(QRectF(x1/ratio, 0, (x2-x1+1)/ratio, TIMELINE_HEIGHT), Qt::blue);
+    }
+
+    /* the packets, which only need to be rendered again when the view,
+     * the display filter or their colors change */
+    update_packet_cache(ratio);
+    p.drawPixmap(0, 0, packet_cache);
+}
+
+void
+WirelessTimeline::update_packet_cache(float ratio)
+{
+    QSize size(qRound(width()*ratio), qRound(TIMELINE_HEIGHT*ratio));
+    QString dfilter = cfile.dfilter;
+
+    if (packet_cache.size() != size || packet_cache.devicePixelRatio() != ratio ||
+            cache_start_tsf != start_tsf || cache_end_tsf != end_tsf ||
+            cache_dfilter != dfilter || cache_displayed_count != cfile.displayed_count) {
+        packet_cache = QPixmap(size);
+        packet_cache.setDevicePixelRatio(ratio);
+        packet_cache.fill(Qt::transparent);
+        packet_cache_dirty = QRect(0, 0, width(), TIMELINE_HEIGHT);
+        cache_start_tsf = start_tsf;
+        cache_end_tsf = end_tsf;
+        cache_dfilter = dfilter;
+        cache_displayed_count = cfile.displayed_count;
     }
 
+    if (packet_cache_dirty.isEmpty())
+        return;
+
+    QRect dirty = packet_cache_dirty.boundingRect().intersected(QRect(0, 0, width(), TIMELINE_HEIGHT));
+    packet_cache_dirty = QRegion();
+    if (dirty.isEmpty())
+        return;
+
+    QPainter p(&packet_cache);
+    p.setClipRect(dirty);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    p.fillRect(dirty, Qt::transparent);
+    p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    render_packets(p, dirty.left()*ratio, dirty.right()*ratio, ratio);
+}
+
+/* render the packets between device pixels left and right */
+void
+WirelessTimeline::render_packets(QPainter &p, int left, int right, float ratio)
+{
+    unsigned int packet;
+    double zoom;
+    int last_x=-1;
+    float rgb[TIMELINE_HEIGHT][3];
+    reset_rgb(rgb);
+
+    zoom = ((double) width())/(end_tsf - start_tsf) * ratio;
+
     QGraphicsScene qs;
-    for (packet = find_packet_tsf(start_tsf + left/zoom - RENDER_EARLY); packet <= cfile.count; packet++) {
+    for (packet = find_packet_tsf(start_tsf + left/zoom - RENDER_EARLY); packet <= (guint32) radio_start_tsf.size(); packet++) {
         frame_data *fdata = frame_data_sequence_find(cfile.provider.frames, packet);
-        struct wlan_radio *ri = get_wlan_radio(fdata->num);
+        guint64 ri_start_tsf = radio_start(packet);
+        guint64 ri_end_tsf = radio_end(packet);
+        guint16 ri_nav = radio_nav[packet-1];
         float x, width, red, green, blue;
 
-        if (ri == NULL) continue;
-
-        gint8 rssi = ri->aggregate ? ri->aggregate->rssi : ri->rssi;
+        gint8 rssi = radio_rssi[packet-1];
         guint height = (rssi+100)/2;
         gint end_nav;
 
@@ -563,10 +653,10 @@ WirelessTimeline::paintEvent(QPaintEvent *qpe)
 
         /* skip frames we don't have start and end data for */
         /* TODO: show something, so it's clear a frame is missing */
-        if (ri->start_tsf == 0 || ri->end_tsf == 0)
+        if (ri_start_tsf == 0 || ri_end_tsf == 0)
             continue;
 
-        x = ((gint64) (ri->start_tsf - start_tsf))*zoom;
+        x = ((gint64) (ri_start_tsf - start_tsf))*zoom;
         /* is there a previous anti-aliased pixel to output */
         if (last_x >= 0 && ((int) x) != last_x) {
             /* write it out now */
@@ -579,7 +669,7 @@ WirelessTimeline::paintEvent(QPaintEvent *qpe)
             break;
         }
 
-        width = (ri->end_tsf - ri->start_tsf)*zoom;
+        width = (ri_end_tsf - ri_start_tsf)*zoom;
         if (width < 0) {
             continue;
         }
@@ -593,8 +683,9 @@ WirelessTimeline::paintEvent(QPaintEvent *qpe)
         if (first_packet < 0)
             first_packet = packet;
 
-        if (fdata->color_filter) {
-            const color_t *c = &((const color_filter_t *) fdata->color_filter)->fg_color;
+        const color_filter_t *color_filter = color_filters_get_by_index(fdata->color_index);
+        if (color_filter) {
+            const color_t *c = &color_filter->fg_color;
             red = c->red / 65535.0;
             green = c->green / 65535.0;
             blue = c->blue / 65535.0;
@@ -603,8 +694,8 @@ WirelessTimeline::paintEvent(QPaintEvent *qpe)
         }
 
         /* record NAV field at higher magnifications */
-        end_nav = x + width + ri->nav*zoom;
-        if (zoom >= 0.01 && ri->nav && end_nav > 0) {
+        end_nav = x + width + ri_nav*zoom;
+        if (zoom >= 0.01 && ri_nav && end_nav > 0) {
             gint y = 2*(packet % (TIMELINE_HEIGHT/2));
             qs.addLine(QLineF((x+width)/ratio, y, end_nav/ratio, y), QPen(pcolor(red,green,blue)));
         }
@@ -34,7 +34,10 @@
 
 #include <epan/dissectors/packet-ieee80211-radio.h>
 
+#include <QPixmap>
+#include <QRegion>
 #include <QScrollArea>
+#include <QVector>
 
 #include "cfile.h"
 
@@ -46,6 +49,7 @@
 
 class WirelessTimeline;
 class PacketList;
+class QPainter;
 
 class WirelessTimeline : public QWidget
 {
@@ -75,13 +79,18 @@ protected:
     static void tap_timeline_reset(void* tapdata);
     static tap_packet_status tap_timeline_packet(void *tapdata, packet_info* pinfo, epan_dissect_t* edt, const void *data, tap_flags_t flags);
 
-    struct wlan_radio* get_wlan_radio(guint32 packet_num);
+    bool have_radio(guint32 packet_num) const;
+    guint64 radio_start(guint32 packet_num) const { return radio_start_tsf[packet_num-1]; }
+    guint64 radio_end(guint32 packet_num) const { return radio_end_tsf[packet_num-1]; }
+    void build_radio_summary();
 
     void clip_tsf();
     int position(guint64 tsf, float ratio);
     int find_packet_tsf(guint64 tsf);
-    void doToolTip(struct wlan_radio *wr, QPoint pos, int x);
+    void doToolTip(guint32 packet_num, QPoint pos, int x);
     void zoom(double x_fraction);
+    void update_packet_cache(float ratio);
+    void render_packets(QPainter &p, int left, int right, float ratio);
     double zoom_level;
     qreal start_x, last_x;
     PacketList *packet_list;
@@ -91,10 +100,26 @@ protected:
     guint64 start_tsf;
     guint64 end_tsf;
     int first_packet; /* first packet displayed */
-    struct wlan_radio *first, *last;
     capture_file *capfile;
 
-    GHashTable* radio_packet_list;
+    /* radio info of each frame as the tap sees it, by frame number - 1 */
+    QVector<const struct wlan_radio *> radio_info;
+    guint32 radio_frames;
+
+    /* compact summary of radio_info made once the file is read, by frame number - 1 */
+    QVector<guint64> radio_start_tsf;
+    QVector<guint64> radio_end_tsf;
+    QVector<gint32> radio_ifs;
+    QVector<guint16> radio_nav;
+    QVector<gint8> radio_rssi;
+
+    /* the packets as last rendered, and what they were rendered for */
+    QPixmap packet_cache;
+    QRegion packet_cache_dirty;
+    guint64 cache_start_tsf;
+    guint64 cache_end_tsf;
+    QString cache_dfilter;
+    guint32 cache_displayed_count;
 
 protected slots:
     void selectedFrameChanged(QList<int>);
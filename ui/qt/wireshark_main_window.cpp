@@ -328,6 +328,7 @@ WiresharkMainWindow::WiresharkMainWindow(QWidget *parent) :
 #ifdef HAVE_LIBPCAP
     , capture_options_dialog_(NULL)
     , info_data_()
+    , tail_continue_queued_(false)
 #endif
 #if defined(Q_OS_MAC)
     , dock_menu_(NULL)
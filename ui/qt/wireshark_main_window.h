@@ -186,6 +186,7 @@ private:
     capture_session cap_session_;
     CaptureOptionsDialog *capture_options_dialog_;
     info_data_t info_data_;
+    bool tail_continue_queued_;
 #endif
 
 #if defined(Q_OS_MAC)
@@ -288,6 +289,7 @@ public slots:
 #ifdef HAVE_LIBPCAP
     void captureCapturePrepared(capture_session *);
     void captureCaptureUpdateStarted(capture_session *);
+    void captureCaptureUpdateContinue(capture_session *);
     void captureCaptureUpdateFinished(capture_session *);
     void captureCaptureFixedFinished(capture_session *cap_session);
     void captureCaptureFailed(capture_session *);
@@ -497,6 +499,8 @@ private slots:
 
     void on_actionStatisticsCaptureFileProperties_triggered();
     void on_actionStatisticsResolvedAddresses_triggered();
+    void on_actionStatisticsPerfStats_triggered();
+    void on_actionStatisticsDissectorProfile_triggered();
     void on_actionStatisticsProtocolHierarchy_triggered();
     void on_actionStatisticsFlowGraph_triggered();
     void openTcpStreamDialog(int graph_type);
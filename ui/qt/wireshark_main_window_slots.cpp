@@ -142,6 +142,8 @@ DIAG_ON(frame-larger-than=)
 #include "protocol_hierarchy_dialog.h"
 #include <ui/qt/utils/qt_ui_utils.h>
 #include "resolved_addresses_dialog.h"
+#include "dissector_profile_dialog.h"
+#include "perf_stats_dialog.h"
 #include "rpc_service_response_time_dialog.h"
 #include "rtp_stream_dialog.h"
 #include "rtp_analysis_dialog.h"
@@ -168,6 +170,7 @@ DIAG_ON(frame-larger-than=)
 #include <QMessageBox>
 #include <QMetaObject>
 #include <QToolBar>
+#include <QTimer>
 #include <QDesktopServices>
 #include <QUrl>
 #include <QMutex>
@@ -532,6 +535,21 @@ void WiresharkMainWindow::captureCaptureUpdateStarted(capture_session *session)
     setForCapturedPackets(true);
 }
 
+void WiresharkMainWindow::captureCaptureUpdateContinue(capture_session *session) {
+
+    // If we couldn't keep up with the capture child, read the rest of what
+    // it's written once any queued redraws and input have been handled,
+    // rather than waiting for its next update.
+    if (session->pending_records == 0 || tail_continue_queued_)
+        return;
+
+    tail_continue_queued_ = true;
+    QTimer::singleShot(0, this, [this]() {
+        tail_continue_queued_ = false;
+        capture_input_continue_tail(&cap_session_);
+    });
+}
+
 void WiresharkMainWindow::captureCaptureUpdateFinished(capture_session *session) {
 
     /* The capture isn't stopping any more - it's stopped. */
@@ -722,6 +740,9 @@ void WiresharkMainWindow::captureEventHandler(CaptureEvent ev)
         case CaptureEvent::Started:
             captureCaptureUpdateStarted(ev.capSession());
             break;
+        case CaptureEvent::Continued:
+            captureCaptureUpdateContinue(ev.capSession());
+            break;
         case CaptureEvent::Finished:
             captureCaptureUpdateFinished(ev.capSession());
             break;
@@ -1511,6 +1532,7 @@ void WiresharkMainWindow::fieldsChanged()
         g_free(err_msg);
     }
     tap_listeners_dfilter_recompile();
+    SyntaxLineEdit::invalidateFieldCompletions();
 
     emit checkDisplayFilter();
 
@@ -3981,6 +4003,18 @@ void WiresharkMainWindow::on_actionStatisticsResolvedAddresses_triggered()
     resolved_addresses_dialog->show();
 }
 
+void WiresharkMainWindow::on_actionStatisticsDissectorProfile_triggered()
+{
+    DissectorProfileDialog *dissector_profile_dialog = new DissectorProfileDialog(this);
+    dissector_profile_dialog->show();
+}
+
+void WiresharkMainWindow::on_actionStatisticsPerfStats_triggered()
+{
+    PerfStatsDialog *perf_stats_dialog = new PerfStatsDialog(this);
+    perf_stats_dialog->show();
+}
+
 void WiresharkMainWindow::on_actionStatisticsProtocolHierarchy_triggered()
 {
     ProtocolHierarchyDialog *phd = new ProtocolHierarchyDialog(*this, capture_file_);
@@ -0,0 +1,395 @@
+/* record_copy.c
+ * Routines for copying the records of a capture file as raw bytes
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wiretap/pcapng_module.h>
+#include <wsutil/file_util.h>
+#include <wsutil/report_message.h>
+#include <wsutil/ws_roundup.h>
+
+#include "ui/record_copy.h"
+
+#define PCAP_FILE_HDR_LEN       24
+#define PCAP_RECORD_HDR_LEN     16
+
+#define PCAPNG_BLOCK_HDR_LEN            8   /* block type, block total length */
+#define PCAPNG_PACKET_FIXED_LEN         20  /* EPB/PB fields before the packet data */
+#define PCAPNG_PACKET_BLOCK_MIN_LEN     (PCAPNG_BLOCK_HDR_LEN + PCAPNG_PACKET_FIXED_LEN + 4)
+#define PCAPNG_SHB_MAGIC                0x1A2B3C4D
+/* The largest block the pcapng reader accepts. */
+#define PCAPNG_MAX_BLOCK_LEN            (PCAPNG_PACKET_BLOCK_MIN_LEN + WTAP_MAX_PACKET_SIZE_DBUS + 131072)
+
+gboolean
+record_copy_range(int from_fd, const char *from_filename, int to_fd,
+        const char *to_filename, gint64 start, gint64 end, guint8 *buf,
+        size_t buf_size)
+{
+    ws_file_ssize_t nread, nwritten;
+    size_t          chunk;
+
+    if (ws_lseek64(from_fd, start, SEEK_SET) == -1) {
+        report_read_failure(from_filename, errno);
+        return FALSE;
+    }
+    while (start < end) {
+        chunk = (size_t)MIN((gint64)buf_size, end - start);
+        nread = ws_read(from_fd, buf, chunk);
+        if (nread <= 0) {
+            report_read_failure(from_filename,
+                    nread < 0 ? errno : WTAP_ERR_SHORT_READ);
+            return FALSE;
+        }
+        nwritten = ws_write(to_fd, buf, nread);
+        if (nwritten < nread) {
+            report_write_failure(to_filename,
+                    nwritten < 0 ? errno : WTAP_ERR_SHORT_WRITE);
+            return FALSE;
+        }
+        start += nread;
+    }
+    return TRUE;
+}
+
+gboolean
+pcap_record_copy_open(pcap_record_copy_t *copy, const char *from_filename,
+        const char *to_filename)
+{
+    guint8  hdr[PCAP_FILE_HDR_LEN];
+    guint32 magic;
+
+    copy->from_fd = ws_open(from_filename, O_RDONLY | O_BINARY, 0000);
+    if (copy->from_fd < 0) {
+        report_open_failure(from_filename, errno, FALSE);
+        return FALSE;
+    }
+    if (ws_read(copy->from_fd, hdr, sizeof hdr) != (ws_file_ssize_t)sizeof hdr) {
+        report_read_failure(from_filename, WTAP_ERR_SHORT_READ);
+        ws_close(copy->from_fd);
+        return FALSE;
+    }
+    memcpy(&magic, hdr, sizeof magic);
+    copy->byte_swapped = (magic != 0xa1b2c3d4 && magic != 0xa1b23c4d);
+
+    copy->to_fd = ws_open(to_filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+    if (copy->to_fd < 0) {
+        report_open_failure(to_filename, errno, TRUE);
+        ws_close(copy->from_fd);
+        return FALSE;
+    }
+    if (ws_write(copy->to_fd, hdr, sizeof hdr) != (ws_file_ssize_t)sizeof hdr) {
+        report_write_failure(to_filename, errno);
+        ws_close(copy->from_fd);
+        ws_close(copy->to_fd);
+        return FALSE;
+    }
+
+    copy->from_filename = from_filename;
+    copy->to_filename = to_filename;
+    copy->run_start = -1;
+    copy->last_offset = -1;
+    copy->buf = (guint8 *)g_malloc(RECORD_COPY_BUF_SIZE);
+    return TRUE;
+}
+
+gboolean
+pcap_record_copy_next(pcap_record_copy_t *copy, gint64 offset, gboolean wanted)
+{
+    copy->last_offset = offset;
+    if (wanted) {
+        if (copy->run_start < 0)
+            copy->run_start = offset;
+        return TRUE;
+    }
+
+    /* This record isn't wanted, so a run of wanted ones ends here. */
+    if (copy->run_start >= 0) {
+        if (!record_copy_range(copy->from_fd, copy->from_filename,
+                    copy->to_fd, copy->to_filename, copy->run_start, offset,
+                    copy->buf, RECORD_COPY_BUF_SIZE))
+            return FALSE;
+        copy->run_start = -1;
+    }
+    return TRUE;
+}
+
+gboolean
+pcap_record_copy_close(pcap_record_copy_t *copy, gboolean complete)
+{
+    guint8   hdr[PCAP_RECORD_HDR_LEN];
+    guint32  incl_len;
+    gboolean ret = TRUE;
+
+    if (complete && copy->run_start >= 0) {
+        /* The run goes up to the end of the last record passed in. */
+        if (ws_lseek64(copy->from_fd, copy->last_offset, SEEK_SET) == -1 ||
+                ws_read(copy->from_fd, hdr, PCAP_RECORD_HDR_LEN) != PCAP_RECORD_HDR_LEN) {
+            report_read_failure(copy->from_filename, WTAP_ERR_SHORT_READ);
+            ret = FALSE;
+        } else {
+            memcpy(&incl_len, hdr + 8, sizeof incl_len);
+            if (copy->byte_swapped)
+                incl_len = GUINT32_SWAP_LE_BE(incl_len);
+            ret = record_copy_range(copy->from_fd, copy->from_filename,
+                    copy->to_fd, copy->to_filename, copy->run_start,
+                    copy->last_offset + PCAP_RECORD_HDR_LEN + incl_len,
+                    copy->buf, RECORD_COPY_BUF_SIZE);
+        }
+    }
+
+    g_free(copy->buf);
+    ws_close(copy->from_fd);
+    if (ws_close(copy->to_fd) < 0 && ret) {
+        report_write_failure(copy->to_filename, errno);
+        ret = FALSE;
+    }
+    return ret;
+}
+
+static guint16
+pcapng_get16(const guint8 *p, gboolean byte_swapped)
+{
+    guint16 v;
+
+    memcpy(&v, p, sizeof v);
+    return byte_swapped ? GUINT16_SWAP_LE_BE(v) : v;
+}
+
+static guint32
+pcapng_get32(const guint8 *p, gboolean byte_swapped)
+{
+    guint32 v;
+
+    memcpy(&v, p, sizeof v);
+    return byte_swapped ? GUINT32_SWAP_LE_BE(v) : v;
+}
+
+static void
+pcapng_append16(GByteArray *out, guint16 v, gboolean byte_swapped)
+{
+    if (byte_swapped)
+        v = GUINT16_SWAP_LE_BE(v);
+    g_byte_array_append(out, (const guint8 *)&v, sizeof v);
+}
+
+/*
+ * Re-encode an EPB or obsolete PB with the comments of pkt_block in place
+ * of the ones in the file, keeping its other options as they are.
+ * Returns NULL if the block is malformed or the comments don't fit.
+ */
+static GByteArray *
+reencode_packet_block(const guint8 *block, guint32 block_len,
+        gboolean byte_swapped, wtap_block_t pkt_block)
+{
+    static const guint8 padding[3] = { 0, 0, 0 };
+    GByteArray *out;
+    guint32     caplen, opt_off, opt_end, opt_start;
+    guint16     opt_code, opt_len;
+    char       *comment;
+    size_t      comment_len;
+    guint32     new_len;
+    guint       i;
+
+    if (block_len < PCAPNG_PACKET_BLOCK_MIN_LEN || block_len % 4 != 0)
+        return NULL;
+    caplen = pcapng_get32(block + PCAPNG_BLOCK_HDR_LEN + 12, byte_swapped);
+    if (caplen > block_len - PCAPNG_PACKET_BLOCK_MIN_LEN)
+        return NULL;
+    opt_start = PCAPNG_BLOCK_HDR_LEN + PCAPNG_PACKET_FIXED_LEN + WS_ROUNDUP_4(caplen);
+    opt_end = block_len - 4;
+    if (opt_start > opt_end)
+        return NULL;
+
+    out = g_byte_array_sized_new(block_len);
+    g_byte_array_append(out, block, opt_start);
+
+    /* Keep every option other than the comments. */
+    for (opt_off = opt_start; opt_off + 4 <= opt_end; ) {
+        opt_code = pcapng_get16(block + opt_off, byte_swapped);
+        opt_len = pcapng_get16(block + opt_off + 2, byte_swapped);
+        if (opt_code == 0)
+            break;      /* opt_endofopt */
+        if (WS_ROUNDUP_4(opt_len) > opt_end - opt_off - 4) {
+            g_byte_array_free(out, TRUE);
+            return NULL;
+        }
+        if (opt_code != OPT_COMMENT)
+            g_byte_array_append(out, block + opt_off, 4 + WS_ROUNDUP_4(opt_len));
+        opt_off += 4 + WS_ROUNDUP_4(opt_len);
+    }
+
+    for (i = 0; pkt_block != NULL &&
+            wtap_block_get_nth_string_option_value(pkt_block, OPT_COMMENT, i, &comment) == WTAP_OPTTYPE_SUCCESS; i++) {
+        comment_len = strlen(comment);
+        if (comment_len > G_MAXUINT16 || out->len > G_MAXINT32) {
+            g_byte_array_free(out, TRUE);
+            return NULL;
+        }
+        pcapng_append16(out, OPT_COMMENT, byte_swapped);
+        pcapng_append16(out, (guint16)comment_len, byte_swapped);
+        g_byte_array_append(out, (const guint8 *)comment, (guint)comment_len);
+        g_byte_array_append(out, padding, WS_ROUNDUP_4((guint)comment_len) - (guint)comment_len);
+    }
+
+    /* If there are any options, they end with an opt_endofopt. */
+    if (out->len > opt_start) {
+        pcapng_append16(out, 0, byte_swapped);
+        pcapng_append16(out, 0, byte_swapped);
+    }
+
+    new_len = out->len + 4;
+    if (byte_swapped)
+        new_len = GUINT32_SWAP_LE_BE(new_len);
+    memcpy(out->data + 4, &new_len, sizeof new_len);
+    g_byte_array_append(out, (const guint8 *)&new_len, sizeof new_len);
+    return out;
+}
+
+int
+pcapng_rewrite_open(const char *filename, gboolean *byte_swapped)
+{
+    int    fd;
+    guint8 hdr[PCAPNG_BLOCK_HDR_LEN + 4];
+
+    fd = ws_open(filename, O_RDONLY | O_BINARY, 0000);
+    if (fd < 0)
+        return -1;
+    if (ws_read(fd, hdr, sizeof hdr) != (ws_file_ssize_t)sizeof hdr ||
+            pcapng_get32(hdr, FALSE) != BLOCK_TYPE_SHB) {
+        ws_close(fd);
+        return -1;
+    }
+    *byte_swapped = pcapng_get32(hdr + PCAPNG_BLOCK_HDR_LEN, FALSE) != PCAPNG_SHB_MAGIC;
+    return fd;
+}
+
+gboolean
+pcapng_rewrite_packet_block(int fd, gboolean byte_swapped, gint64 offset,
+        wtap_block_t pkt_block, GArray *rewrites)
+{
+    guint8   hdr[PCAPNG_BLOCK_HDR_LEN];
+    guint32  block_type, block_len;
+    guint8  *block;
+    pcapng_block_rewrite_t rewrite;
+
+    if (ws_lseek64(fd, offset, SEEK_SET) == -1 ||
+            ws_read(fd, hdr, PCAPNG_BLOCK_HDR_LEN) != PCAPNG_BLOCK_HDR_LEN)
+        return FALSE;
+    block_type = pcapng_get32(hdr, byte_swapped);
+    block_len = pcapng_get32(hdr + 4, byte_swapped);
+    /* Only packet blocks with options can carry comments. */
+    if (block_type != BLOCK_TYPE_EPB && block_type != BLOCK_TYPE_PB)
+        return FALSE;
+    if (block_len < PCAPNG_PACKET_BLOCK_MIN_LEN || block_len > PCAPNG_MAX_BLOCK_LEN)
+        return FALSE;
+    block = (guint8 *)g_malloc(block_len);
+    memcpy(block, hdr, PCAPNG_BLOCK_HDR_LEN);
+    if (ws_read(fd, block + PCAPNG_BLOCK_HDR_LEN, block_len - PCAPNG_BLOCK_HDR_LEN) !=
+            (ws_file_ssize_t)(block_len - PCAPNG_BLOCK_HDR_LEN)) {
+        g_free(block);
+        return FALSE;
+    }
+
+    rewrite.offset = offset;
+    rewrite.old_len = block_len;
+    rewrite.new_block = reencode_packet_block(block, block_len,
+            byte_swapped, pkt_block);
+    g_free(block);
+    if (rewrite.new_block == NULL)
+        return FALSE;
+    g_array_append_val(rewrites, rewrite);
+    return TRUE;
+}
+
+void
+pcapng_block_rewrites_free(GArray *rewrites)
+{
+    guint i;
+
+    if (rewrites == NULL)
+        return;
+    for (i = 0; i < rewrites->len; i++)
+        g_byte_array_free(g_array_index(rewrites, pcapng_block_rewrite_t, i).new_block, TRUE);
+    g_array_free(rewrites, TRUE);
+}
+
+gboolean
+pcapng_copy_with_rewrites(const char *from_filename, const char *to_filename,
+        GArray *rewrites, const gboolean *stop_flag)
+{
+    int         from_fd, to_fd;
+    guint8     *copy_buf;
+    gint64      run_start = 0;
+    gint64      file_end;
+    guint       i;
+    pcapng_block_rewrite_t *rewrite;
+    gboolean    ret = TRUE;
+
+    from_fd = ws_open(from_filename, O_RDONLY | O_BINARY, 0000);
+    if (from_fd < 0) {
+        report_open_failure(from_filename, errno, FALSE);
+        return FALSE;
+    }
+    to_fd = ws_open(to_filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+    if (to_fd < 0) {
+        report_open_failure(to_filename, errno, TRUE);
+        ws_close(from_fd);
+        return FALSE;
+    }
+
+    copy_buf = (guint8 *)g_malloc(RECORD_COPY_BUF_SIZE);
+
+    for (i = 0; i < rewrites->len; i++) {
+        rewrite = &g_array_index(rewrites, pcapng_block_rewrite_t, i);
+        if (!record_copy_range(from_fd, from_filename, to_fd, to_filename,
+                    run_start, rewrite->offset, copy_buf,
+                    RECORD_COPY_BUF_SIZE)) {
+            ret = FALSE;
+            break;
+        }
+        if (ws_write(to_fd, rewrite->new_block->data, rewrite->new_block->len) !=
+                (ws_file_ssize_t)rewrite->new_block->len) {
+            report_write_failure(to_filename, errno);
+            ret = FALSE;
+            break;
+        }
+        run_start = rewrite->offset + rewrite->old_len;
+        if (stop_flag != NULL && *stop_flag) {
+            ret = FALSE;
+            break;
+        }
+    }
+
+    if (ret) {
+        /* Copy everything after the last re-encoded block. */
+        file_end = ws_lseek64(from_fd, 0, SEEK_END);
+        if (file_end == -1) {
+            report_read_failure(from_filename, errno);
+            ret = FALSE;
+        } else if (!record_copy_range(from_fd, from_filename, to_fd,
+                    to_filename, run_start, file_end, copy_buf,
+                    RECORD_COPY_BUF_SIZE)) {
+            ret = FALSE;
+        }
+    }
+
+    g_free(copy_buf);
+    ws_close(from_fd);
+    if (ws_close(to_fd) < 0 && ret) {
+        report_write_failure(to_filename, errno);
+        ret = FALSE;
+    }
+    return ret;
+}
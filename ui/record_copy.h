@@ -0,0 +1,166 @@
+/** @file
+ *
+ * Copying the records of a capture file as raw bytes, for saving or
+ * exporting them without reading each one in and writing it out again
+ * through Wiretap.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __RECORD_COPY_H__
+#define __RECORD_COPY_H__
+
+#include <wiretap/wtap.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Failures are reported with report_open_failure(), report_read_failure()
+ * and report_write_failure().
+ */
+
+/**
+ * Copy bytes [start, end) of one file to the current position in another.
+ *
+ * @param from_fd The file to copy from
+ * @param from_filename Its name, for reporting failures
+ * @param to_fd The file to copy to
+ * @param to_filename Its name, for reporting failures
+ * @param start Offset of the first byte to copy
+ * @param end Offset just past the last byte to copy
+ * @param buf Buffer to copy through
+ * @param buf_size Size of buf
+ *
+ * @return TRUE on success, FALSE on failure.
+ */
+gboolean record_copy_range(int from_fd, const char *from_filename,
+        int to_fd, const char *to_filename, gint64 start, gint64 end,
+        guint8 *buf, size_t buf_size);
+
+/** Size of the buffer to pass to record_copy_range() */
+#define RECORD_COPY_BUF_SIZE    (1024 * 1024)
+
+/**
+ * Copies some of the records of a pcap file to a new pcap file.  Each
+ * run of records that are next to each other in the input is copied in
+ * one go.
+ */
+typedef struct {
+    int          from_fd;
+    const char  *from_filename;
+    int          to_fd;
+    const char  *to_filename;
+    gboolean     byte_swapped;
+    gint64       run_start;     /**< Offset of the first record of the current run, or -1 */
+    gint64       last_offset;   /**< Offset of the last record passed to pcap_record_copy_next() */
+    guint8      *buf;
+} pcap_record_copy_t;
+
+/**
+ * Open a pcap file to copy records from, and create the file to copy them
+ * to, with the same file header.
+ *
+ * @param copy The copy to set up
+ * @param from_filename The pcap file to copy records from
+ * @param to_filename The file to create
+ *
+ * @return TRUE on success, FALSE on failure.
+ */
+gboolean pcap_record_copy_open(pcap_record_copy_t *copy,
+        const char *from_filename, const char *to_filename);
+
+/**
+ * Go on to the next record in the input file.  Every record has to be
+ * passed in, in file order, up to the last one that's wanted.
+ *
+ * @param copy The copy
+ * @param offset Offset of the record's header in the input file
+ * @param wanted TRUE if the record is to be copied
+ *
+ * @return TRUE on success, FALSE on failure.
+ */
+gboolean pcap_record_copy_next(pcap_record_copy_t *copy, gint64 offset,
+        gboolean wanted);
+
+/**
+ * Finish the copy, and close both files.
+ *
+ * @param copy The copy
+ * @param complete TRUE to copy the last run of wanted records, which
+ * ends with the last record passed in; FALSE if the copy is being
+ * abandoned
+ *
+ * @return TRUE on success, FALSE on failure.
+ */
+gboolean pcap_record_copy_close(pcap_record_copy_t *copy, gboolean complete);
+
+/**
+ * A pcapng packet block whose comments have been changed, and the block
+ * that replaces it when the file is copied.
+ */
+typedef struct {
+    gint64      offset;     /**< Offset of the block in the file */
+    guint32     old_len;    /**< Its length in the file */
+    GByteArray *new_block;  /**< The block to write in its place */
+} pcapng_block_rewrite_t;
+
+/**
+ * Open a pcapng file to re-encode packet blocks from.  Nothing is
+ * reported on failure, so the caller can fall back on Wiretap.
+ *
+ * @param filename The file
+ * @param[out] byte_swapped Set to TRUE if its section is in the other
+ * byte order
+ *
+ * @return The file descriptor, or -1 if the file can't be read or doesn't
+ * start with a section header block.
+ */
+int pcapng_rewrite_open(const char *filename, gboolean *byte_swapped);
+
+/**
+ * Re-encode the packet block (EPB, or obsolete PB) at an offset, with
+ * the comments of pkt_block in place of its own and its other options
+ * kept as they are, and append it to an array of rewrites.  Nothing is
+ * reported on failure.
+ *
+ * @param fd File descriptor from pcapng_rewrite_open()
+ * @param byte_swapped As set by pcapng_rewrite_open()
+ * @param offset Offset of the block
+ * @param pkt_block The block with the new comments, or NULL for none
+ * @param rewrites Array of pcapng_block_rewrite_t, in file order
+ *
+ * @return TRUE on success, FALSE if the block isn't a packet block, is
+ * malformed, or the comments don't fit.
+ */
+gboolean pcapng_rewrite_packet_block(int fd, gboolean byte_swapped,
+        gint64 offset, wtap_block_t pkt_block, GArray *rewrites);
+
+/** Free an array of rewrites and the blocks in it. */
+void pcapng_block_rewrites_free(GArray *rewrites);
+
+/**
+ * Copy a pcapng file, with the blocks in rewrites replaced.
+ *
+ * @param from_filename The file to copy
+ * @param to_filename The file to create
+ * @param rewrites Array of pcapng_block_rewrite_t, in file order
+ * @param stop_flag If not NULL, checked after each rewrite; the copy is
+ * abandoned if it's set
+ *
+ * @return TRUE on success, FALSE on failure or if the copy was stopped.
+ */
+gboolean pcapng_copy_with_rewrites(const char *from_filename,
+        const char *to_filename, GArray *rewrites, const gboolean *stop_flag);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __RECORD_COPY_H__ */
+
@@ -0,0 +1,413 @@
+/* record_copy_test.c
+ * Tests that copying records as raw bytes writes the same records as
+ * reading them in and writing them out through Wiretap.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <wiretap/wtap.h>
+#include <wsutil/file_util.h>
+#include <wsutil/report_message.h>
+#include <wsutil/wslog.h>
+
+#include "ui/failure_message.h"
+#include "ui/record_copy.h"
+
+/* Capture files to copy from, from the command line. */
+static const char *pcap_file;
+static const char *pcapng_file;
+
+static char *tmp_dir;
+
+typedef struct {
+    gint64  offset;
+    wtap_rec rec;
+    Buffer  buf;
+} test_record_t;
+
+static wtap *
+open_capture(const char *filename)
+{
+    wtap *wth;
+    int err;
+    gchar *err_info = NULL;
+
+    wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    if (wth == NULL)
+        g_error("Can't open %s: %s", filename, wtap_strerror(err));
+    return wth;
+}
+
+/* Read every record of a file, with its offset. */
+static GPtrArray *
+read_records(const char *filename)
+{
+    GPtrArray *records = g_ptr_array_new();
+    wtap *wth = open_capture(filename);
+    test_record_t *record;
+    int err = 0;
+    gchar *err_info = NULL;
+
+    for (;;) {
+        record = g_new0(test_record_t, 1);
+        wtap_rec_init(&record->rec);
+        ws_buffer_init(&record->buf, 1514);
+        if (!wtap_read(wth, &record->rec, &record->buf, &err, &err_info, &record->offset))
+            break;
+        g_ptr_array_add(records, record);
+    }
+    g_assert_cmpint(err, ==, 0);
+    wtap_rec_cleanup(&record->rec);
+    ws_buffer_free(&record->buf);
+    g_free(record);
+    wtap_close(wth);
+    return records;
+}
+
+static void
+free_records(GPtrArray *records)
+{
+    guint i;
+
+    for (i = 0; i < records->len; i++) {
+        test_record_t *record = (test_record_t *)records->pdata[i];
+
+        wtap_rec_cleanup(&record->rec);
+        ws_buffer_free(&record->buf);
+        g_free(record);
+    }
+    g_ptr_array_free(records, TRUE);
+}
+
+/* Do two records have the same comments? */
+static void
+check_same_comments(wtap_block_t block1, wtap_block_t block2)
+{
+    guint count1 = block1 != NULL ? wtap_block_count_option(block1, OPT_COMMENT) : 0;
+    guint count2 = block2 != NULL ? wtap_block_count_option(block2, OPT_COMMENT) : 0;
+    char *comment1, *comment2;
+    guint i;
+
+    g_assert_cmpuint(count1, ==, count2);
+    for (i = 0; i < count1; i++) {
+        g_assert_cmpint(wtap_block_get_nth_string_option_value(block1, OPT_COMMENT, i, &comment1), ==, WTAP_OPTTYPE_SUCCESS);
+        g_assert_cmpint(wtap_block_get_nth_string_option_value(block2, OPT_COMMENT, i, &comment2), ==, WTAP_OPTTYPE_SUCCESS);
+        g_assert_cmpstr(comment1, ==, comment2);
+    }
+}
+
+/* Are the records of two files the same? */
+static void
+check_same_records(const char *filename1, const char *filename2)
+{
+    GPtrArray *records1 = read_records(filename1);
+    GPtrArray *records2 = read_records(filename2);
+    guint i;
+
+    g_assert_cmpuint(records1->len, ==, records2->len);
+    for (i = 0; i < records1->len; i++) {
+        test_record_t *r1 = (test_record_t *)records1->pdata[i];
+        test_record_t *r2 = (test_record_t *)records2->pdata[i];
+
+        g_assert_cmpuint(r1->rec.rec_type, ==, r2->rec.rec_type);
+        g_assert_cmpint(r1->rec.ts.secs, ==, r2->rec.ts.secs);
+        g_assert_cmpint(r1->rec.ts.nsecs, ==, r2->rec.ts.nsecs);
+        g_assert_cmpuint(r1->rec.rec_header.packet_header.caplen, ==,
+                         r2->rec.rec_header.packet_header.caplen);
+        g_assert_cmpuint(r1->rec.rec_header.packet_header.len, ==,
+                         r2->rec.rec_header.packet_header.len);
+        g_assert_cmpint(r1->rec.rec_header.packet_header.pkt_encap, ==,
+                        r2->rec.rec_header.packet_header.pkt_encap);
+        g_assert_cmpmem(ws_buffer_start_ptr(&r1->buf), r1->rec.rec_header.packet_header.caplen,
+                        ws_buffer_start_ptr(&r2->buf), r2->rec.rec_header.packet_header.caplen);
+        check_same_comments(r1->rec.block, r2->rec.block);
+    }
+    free_records(records1);
+    free_records(records2);
+}
+
+/*
+ * Write the wanted records of a file through Wiretap, the way
+ * cf_export_specified_packets() does when it can't copy them; if blocks
+ * isn't NULL, the records that have one are written with it in place of
+ * their own, the way cf_save_records() saves edited comments.
+ */
+static void
+write_records(const char *from_filename, GPtrArray *records,
+              const gboolean *wanted, wtap_block_t *blocks,
+              const char *to_filename)
+{
+    wtap *wth = open_capture(from_filename);
+    wtap_dump_params params;
+    wtap_dumper *pdh;
+    wtap_rec rec;
+    Buffer buf;
+    int err;
+    gchar *err_info = NULL;
+    guint i;
+
+    wtap_dump_params_init(&params, wth);
+    pdh = wtap_dump_open(to_filename, wtap_file_type_subtype(wth),
+                         WTAP_UNCOMPRESSED, &params, &err, &err_info);
+    g_assert_nonnull(pdh);
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    for (i = 0; i < records->len; i++) {
+        test_record_t *record = (test_record_t *)records->pdata[i];
+
+        if (!wanted[i])
+            continue;
+        g_assert_true(wtap_seek_read(wth, record->offset, &rec, &buf, &err, &err_info));
+        if (blocks != NULL && blocks[i] != NULL) {
+            wtap_block_unref(rec.block);
+            rec.block = wtap_block_ref(blocks[i]);
+            rec.block_was_modified = TRUE;
+        }
+        g_assert_true(wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), &err, &err_info));
+        wtap_rec_reset(&rec);
+    }
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+
+    g_assert_true(wtap_dump_close(pdh, NULL, &err, &err_info));
+    wtap_dump_params_cleanup(&params);
+    wtap_close(wth);
+}
+
+/*
+ * Export runs of records from a pcap file, including the first and the
+ * last, by copying them, and through Wiretap.
+ */
+static void
+test_pcap_export(void)
+{
+    GPtrArray *records = read_records(pcap_file);
+    gboolean *wanted;
+    char *copied = g_build_filename(tmp_dir, "copied.pcap", NULL);
+    char *written = g_build_filename(tmp_dir, "written.pcap", NULL);
+    pcap_record_copy_t copy;
+    guint i;
+
+    g_assert_cmpuint(records->len, >=, 6);
+    wanted = g_new(gboolean, records->len);
+    for (i = 0; i < records->len; i++)
+        wanted[i] = (i % 3 != 1);
+
+    g_assert_true(pcap_record_copy_open(&copy, pcap_file, copied));
+    for (i = 0; i < records->len; i++) {
+        test_record_t *record = (test_record_t *)records->pdata[i];
+
+        g_assert_true(pcap_record_copy_next(&copy, record->offset, wanted[i]));
+    }
+    g_assert_true(pcap_record_copy_close(&copy, TRUE));
+
+    write_records(pcap_file, records, wanted, NULL, written);
+    check_same_records(copied, written);
+
+    /* Stopping at an unwanted record, as when the range is finished. */
+    g_assert_true(pcap_record_copy_open(&copy, pcap_file, copied));
+    for (i = 0; i < 5; i++) {
+        test_record_t *record = (test_record_t *)records->pdata[i];
+
+        g_assert_true(pcap_record_copy_next(&copy, record->offset, i < 4));
+        wanted[i] = (i < 4);
+    }
+    g_assert_true(pcap_record_copy_close(&copy, TRUE));
+    for (; i < records->len; i++)
+        wanted[i] = FALSE;
+
+    write_records(pcap_file, records, wanted, NULL, written);
+    check_same_records(copied, written);
+
+    ws_unlink(copied);
+    ws_unlink(written);
+    g_free(copied);
+    g_free(written);
+    g_free(wanted);
+    free_records(records);
+}
+
+/* A copy of a record's block, with its comments replaced. */
+static wtap_block_t
+set_comments(test_record_t *record, const char *comment1, const char *comment2)
+{
+    wtap_block_t block = wtap_block_make_copy(record->rec.block);
+
+    while (wtap_block_remove_nth_option_instance(block, OPT_COMMENT, 0) == WTAP_OPTTYPE_SUCCESS)
+        ;
+    if (comment1 != NULL)
+        wtap_block_add_string_option(block, OPT_COMMENT, comment1, strlen(comment1));
+    if (comment2 != NULL)
+        wtap_block_add_string_option(block, OPT_COMMENT, comment2, strlen(comment2));
+    return block;
+}
+
+/*
+ * Save a pcapng file with the comments of some records changed, by
+ * copying it and re-encoding their blocks, and through Wiretap.
+ */
+static void
+save_comments(const char *from_filename, GPtrArray *records,
+              wtap_block_t *blocks, const char *copied, const char *written)
+{
+    gboolean *wanted = g_new(gboolean, records->len);
+    GArray *rewrites = g_array_new(FALSE, FALSE, sizeof (pcapng_block_rewrite_t));
+    gboolean byte_swapped;
+    int fd;
+    guint i;
+
+    fd = pcapng_rewrite_open(from_filename, &byte_swapped);
+    g_assert_cmpint(fd, >=, 0);
+    for (i = 0; i < records->len; i++) {
+        test_record_t *record = (test_record_t *)records->pdata[i];
+
+        wanted[i] = TRUE;
+        if (blocks[i] != NULL)
+            g_assert_true(pcapng_rewrite_packet_block(fd, byte_swapped,
+                                                      record->offset, blocks[i], rewrites));
+    }
+    ws_close(fd);
+    g_assert_true(pcapng_copy_with_rewrites(from_filename, copied, rewrites, NULL));
+    pcapng_block_rewrites_free(rewrites);
+
+    write_records(from_filename, records, wanted, blocks, written);
+    check_same_records(copied, written);
+    g_free(wanted);
+}
+
+static void
+free_blocks(wtap_block_t *blocks, guint count)
+{
+    guint i;
+
+    for (i = 0; i < count; i++)
+        wtap_block_unref(blocks[i]);
+    g_free(blocks);
+}
+
+/*
+ * Add comments to a pcapng file's packets, then change and remove them,
+ * by re-encoding the blocks, and through Wiretap.
+ */
+static void
+test_pcapng_comments(void)
+{
+    GPtrArray *records = read_records(pcapng_file);
+    GPtrArray *commented_records;
+    wtap_block_t *blocks;
+    char *commented = g_build_filename(tmp_dir, "commented.pcapng", NULL);
+    char *copied = g_build_filename(tmp_dir, "copied.pcapng", NULL);
+    char *written = g_build_filename(tmp_dir, "written.pcapng", NULL);
+    GArray *rewrites;
+    wtap_block_t block;
+    gboolean byte_swapped;
+    int fd;
+    gboolean stop = TRUE;
+    char *comment;
+
+    g_assert_cmpuint(records->len, >=, 4);
+
+    /* Add comments to packets that have none. */
+    blocks = g_new0(wtap_block_t, records->len);
+    blocks[0] = set_comments((test_record_t *)records->pdata[0], "first", "second");
+    blocks[2] = set_comments((test_record_t *)records->pdata[2], "a longer comment, to change the block's length", NULL);
+    save_comments(pcapng_file, records, blocks, commented, written);
+    free_blocks(blocks, records->len);
+
+    /* Change them, remove some, and add another. */
+    commented_records = read_records(commented);
+    blocks = g_new0(wtap_block_t, commented_records->len);
+    blocks[0] = set_comments((test_record_t *)commented_records->pdata[0], "replaced", NULL);
+    blocks[1] = set_comments((test_record_t *)commented_records->pdata[1], "new", NULL);
+    blocks[2] = set_comments((test_record_t *)commented_records->pdata[2], NULL, NULL);
+    save_comments(commented, commented_records, blocks, copied, written);
+    free_blocks(blocks, commented_records->len);
+    free_records(commented_records);
+
+    commented_records = read_records(copied);
+    g_assert_cmpint(wtap_block_get_nth_string_option_value(((test_record_t *)commented_records->pdata[0])->rec.block,
+                                                           OPT_COMMENT, 0, &comment), ==, WTAP_OPTTYPE_SUCCESS);
+    g_assert_cmpstr(comment, ==, "replaced");
+    g_assert_cmpuint(wtap_block_count_option(((test_record_t *)commented_records->pdata[2])->rec.block, OPT_COMMENT), ==, 0);
+    free_records(commented_records);
+
+    /* A stopped copy fails. */
+    rewrites = g_array_new(FALSE, FALSE, sizeof (pcapng_block_rewrite_t));
+    block = set_comments((test_record_t *)records->pdata[1], "stopped", NULL);
+    fd = pcapng_rewrite_open(pcapng_file, &byte_swapped);
+    g_assert_cmpint(fd, >=, 0);
+    g_assert_true(pcapng_rewrite_packet_block(fd, byte_swapped,
+                                              ((test_record_t *)records->pdata[1])->offset, block, rewrites));
+    ws_close(fd);
+    wtap_block_unref(block);
+    g_assert_false(pcapng_copy_with_rewrites(pcapng_file, copied, rewrites, &stop));
+    pcapng_block_rewrites_free(rewrites);
+
+    ws_unlink(commented);
+    ws_unlink(copied);
+    ws_unlink(written);
+    g_free(commented);
+    g_free(copied);
+    g_free(written);
+    free_records(records);
+}
+
+int
+main(int argc, char **argv)
+{
+    static const struct report_message_routines test_report_routines = {
+        failure_message,
+        failure_message,
+        open_failure_message,
+        read_failure_message,
+        write_failure_message,
+        cfile_open_failure_message,
+        cfile_dump_open_failure_message,
+        cfile_read_failure_message,
+        cfile_write_failure_message,
+        cfile_close_failure_message
+    };
+    GError *error = NULL;
+    int ret;
+
+    ws_log_init("record_copy_test", NULL);
+
+    g_test_init(&argc, &argv, NULL);
+
+    if (argc != 3) {
+        g_printerr("Usage: record_copy_test <pcap file> <pcapng file>\n");
+        return 2;
+    }
+    pcap_file = argv[1];
+    pcapng_file = argv[2];
+
+    init_report_message("record_copy_test", &test_report_routines);
+    wtap_init(FALSE);
+
+    tmp_dir = g_dir_make_tmp("record_copy_test_XXXXXX", &error);
+    g_assert_no_error(error);
+
+    g_test_add_func("/record_copy/pcap_export", test_pcap_export);
+    g_test_add_func("/record_copy/pcapng_comments", test_pcapng_comments);
+
+    ret = g_test_run();
+
+    g_rmdir(tmp_dir);
+    g_free(tmp_dir);
+    wtap_cleanup();
+
+    return ret;
+}
+
@@ -36,13 +36,21 @@
 extern "C" {
 #endif /* __cplusplus */
 
+/** A payload type seen in an rtp stream and its name */
+typedef struct _rtpstream_payload_name {
+    guint8          payload_type;
+    const gchar    *name;
+} rtpstream_payload_name_t;
+
 /** Defines an rtp stream */
 typedef struct _rtpstream_info {
     rtpstream_id_t  id;
 
     guint8          first_payload_type; /**< Numeric payload type */
     const gchar    *first_payload_type_name; /**< Payload type name */
-    const gchar    *payload_type_names[256]; /**< Seen payload type names. Array index is payload type (byte), filled only during TAP_ANALYSE */
+    guint32         payload_types_seen[256 / 32]; /**< Bitmap of seen payload types, filled only during TAP_ANALYSE */
+    rtpstream_payload_name_t *payload_type_names; /**< Seen payload type names, in payload type order, filled only during TAP_ANALYSE */
+    guint           num_payload_type_names; /**< Number of entries in payload_type_names */
     gchar          *all_payload_type_names; /**< All seen payload names for a stream in one string */
 
     gboolean        is_srtp;
@@ -22,6 +22,8 @@
 #include <epan/epan_dissect.h>
 #include <epan/tap.h>
 
+#include <wsutil/glib-compat.h>
+
 /* Return TRUE if the 2 sets of parameters refer to the same channel. */
 gboolean compare_rlc_headers(guint16 ueid1, guint16 channelType1, guint16 channelId1, guint8 rlcMode1, guint8 direction1,
                              guint16 ueid2, guint16 channelType2, guint16 channelId2, guint8 rlcMode2, guint8 direction2,
@@ -201,15 +203,16 @@ static tap_packet_status rlc_lte_tap_for_graph_data(void *pct, packet_info *pinf
             segment->SN = rlchdr->sequenceNumber;
             segment->isResegmented = rlchdr->isResegmented;
             segment->pduLength = rlchdr->pduLength;
+            segment->noOfNACKs = 0;
+            segment->NACKs = NULL;
         }
         else {
-            /* Status PDU */
-            gint n;
+            /* Status PDU.  Only keep as many NACKs as it actually has, as
+               a long capture can have a great many of these. */
             segment->ACKNo = rlchdr->ACKNo;
-            segment->noOfNACKs = rlchdr->noOfNACKs;
-            for (n=0; n < rlchdr->noOfNACKs; n++) {
-                segment->NACKs[n] = rlchdr->NACKs[n];
-            }
+            segment->noOfNACKs = MIN(rlchdr->noOfNACKs, MAX_NACKs);
+            segment->NACKs = segment->noOfNACKs ?
+                (guint16 *)g_memdup2(rlchdr->NACKs, segment->noOfNACKs * sizeof(guint16)) : NULL;
         }
 
         /* Add segment to end of list */
@@ -288,7 +291,9 @@ void rlc_graph_segment_list_free(struct rlc_graph * g)
     /* Free all segments */
     while (g->segments) {
         segment = g->segments->next;
+        g_free(g->segments->NACKs);
         g_free(g->segments);
         g->segments = segment;
     }
+    g->last_segment = NULL;
 }
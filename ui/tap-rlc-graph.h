@@ -33,7 +33,7 @@ struct rlc_segment {
     guint16         ACKNo;
     #define MAX_NACKs 128
     guint16         noOfNACKs;
-    guint16         NACKs[MAX_NACKs];
+    guint16         *NACKs;         /* noOfNACKs entries, NULL for data PDUs */
     guint16         pduLength;
 
     guint16         ueid;
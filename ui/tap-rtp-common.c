@@ -71,6 +71,8 @@ void rtpstream_info_copy_deep(rtpstream_info_t *dest, const rtpstream_info_t *sr
     *dest = *src;  /* memberwise copy of struct */
     copy_address(&(dest->id.src_addr), &(src->id.src_addr));
     copy_address(&(dest->id.dst_addr), &(src->id.dst_addr));
+    dest->payload_type_names = (rtpstream_payload_name_t *)g_memdup2(src->payload_type_names,
+        src->num_payload_type_names * sizeof(rtpstream_payload_name_t));
     dest->all_payload_type_names = g_strdup(src->all_payload_type_names);
 }
 
@@ -90,6 +92,7 @@ rtpstream_info_t *rtpstream_info_malloc_and_copy_deep(const rtpstream_info_t *sr
 /* free rtpstream_info_t referenced values */
 void rtpstream_info_free_data(rtpstream_info_t *info)
 {
+    g_free(info->payload_type_names);
     if (info->all_payload_type_names != NULL) {
         g_free(info->all_payload_type_names);
     }
@@ -255,10 +258,18 @@ register_tap_listener_rtpstream(rtpstream_tapinfo_t *tapinfo, const char *fstrin
 
 static const gchar *PAYLOAD_UNKNOWN_STR = "Unknown";
 
+/*
+ * Streams usually only have one or two payload types, so rather than a
+ * table of names for all 256 in every stream, which adds up with tens of
+ * thousands of streams, keep a bitmap of the ones that have been seen and
+ * a short sorted array of their names.
+ */
 static void update_payload_names(rtpstream_info_t *stream_info, const struct _rtp_info *rtpinfo)
 {
     GString *payload_type_names;
     const gchar *new_payload_type_str;
+    guint8 payload_type = rtpinfo->info_payload_type;
+    guint i;
 
     /* Ensure that we have non empty payload_type_str */
     if (rtpinfo->info_payload_type_str != NULL) {
@@ -271,17 +282,28 @@ static void update_payload_names(rtpstream_info_t *stream_info, const struct _rt
             PAYLOAD_UNKNOWN_STR
         );
     }
-    stream_info->payload_type_names[rtpinfo->info_payload_type] = new_payload_type_str;
+    stream_info->payload_types_seen[payload_type / 32] |= 1U << (payload_type % 32);
+
+    for (i = 0; i < stream_info->num_payload_type_names; i++) {
+        if (stream_info->payload_type_names[i].payload_type > payload_type) {
+            break;
+        }
+    }
+    stream_info->payload_type_names = g_renew(rtpstream_payload_name_t,
+        stream_info->payload_type_names, stream_info->num_payload_type_names + 1);
+    memmove(&stream_info->payload_type_names[i + 1], &stream_info->payload_type_names[i],
+        (stream_info->num_payload_type_names - i) * sizeof(rtpstream_payload_name_t));
+    stream_info->payload_type_names[i].payload_type = payload_type;
+    stream_info->payload_type_names[i].name = new_payload_type_str;
+    stream_info->num_payload_type_names++;
 
     /* Join all existing payload names to one string */
     payload_type_names = g_string_sized_new(40); /* Preallocate memory */
-    for(int i=0; i<256; i++) {
-        if (stream_info->payload_type_names[i] != NULL) {
-            if (payload_type_names->len > 0) {
-                g_string_append(payload_type_names, ", ");
-            }
-            g_string_append(payload_type_names, stream_info->payload_type_names[i]);
+    for (i = 0; i < stream_info->num_payload_type_names; i++) {
+        if (payload_type_names->len > 0) {
+            g_string_append(payload_type_names, ", ");
         }
+        g_string_append(payload_type_names, stream_info->payload_type_names[i].name);
     }
     if (stream_info->all_payload_type_names != NULL) {
         g_free(stream_info->all_payload_type_names);
@@ -292,7 +314,7 @@ static void update_payload_names(rtpstream_info_t *stream_info, const struct _rt
 
 gboolean rtpstream_is_payload_used(const rtpstream_info_t *stream_info, const guint8 payload_type)
 {
-    return stream_info->payload_type_names[payload_type] != NULL;
+    return (stream_info->payload_types_seen[payload_type / 32] & (1U << (payload_type % 32))) != 0;
 }
 
 #define RTPFILE_VERSION "1.0"
@@ -543,7 +565,7 @@ void rtpstream_info_analyse_process(rtpstream_info_t *stream_info, const packet_
 {
     /* get RTP stats for the packet */
     rtppacket_analyse(&(stream_info->rtp_stats), pinfo, rtpinfo);
-    if (stream_info->payload_type_names[rtpinfo->info_payload_type] == NULL ) {
+    if (!rtpstream_is_payload_used(stream_info, rtpinfo->info_payload_type)) {
         update_payload_names(stream_info, rtpinfo);
     }
 
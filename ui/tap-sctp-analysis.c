@@ -37,6 +37,11 @@
 
 static sctp_allassocs_info_t sctp_tapinfo_struct = {0, NULL, FALSE, NULL};
 
+/* Associations by assoc_id, and the last element of assoc_info_list, so
+ * that neither finding nor adding an association has to walk the list. */
+static GHashTable *assoc_table = NULL;
+static GList *assoc_info_tail = NULL;
+
 static void
 free_first(gpointer data, gpointer user_data _U_)
 {
@@ -108,7 +113,7 @@ reset(void *arg)
 
         if (info->frame_numbers != NULL)
         {
-            g_list_free(info->frame_numbers);
+            g_array_free(info->frame_numbers, TRUE);
             info->frame_numbers = NULL;
         }
 
@@ -169,6 +174,9 @@ reset(void *arg)
     g_list_free(tapdata->assoc_info_list);
     tapdata->sum_tvbs = 0;
     tapdata->assoc_info_list = NULL;
+    assoc_info_tail = NULL;
+    if (assoc_table != NULL)
+        g_hash_table_remove_all(assoc_table);
 }
 
 
@@ -226,23 +234,31 @@ calc_checksum(const struct _sctp_info *check_data, sctp_assoc_info_t *data)
 static sctp_assoc_info_t *
 find_assoc(sctp_tmp_info_t *needle)
 {
-    sctp_allassocs_info_t *assoc_info;
-    sctp_assoc_info_t *info = NULL;
-    GList* list;
+    if (assoc_table == NULL)
+        return NULL;
 
-    assoc_info = &sctp_tapinfo_struct;
-    if ((list = g_list_last(assoc_info->assoc_info_list))!=NULL)
-    {
-        while (list)
-        {
-            info = (sctp_assoc_info_t*)(list->data);
-            if (needle->assoc_id == info->assoc_id)
-                return info;
+    return (sctp_assoc_info_t *)g_hash_table_lookup(assoc_table, GUINT_TO_POINTER(needle->assoc_id));
+}
 
-            list = g_list_previous(list);
-        }
-    }
-    return NULL;
+static void
+add_assoc(sctp_assoc_info_t *info)
+{
+    if (assoc_table == NULL)
+        assoc_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_hash_table_insert(assoc_table, GUINT_TO_POINTER(info->assoc_id), info);
+
+    if (assoc_info_tail != NULL)
+        assoc_info_tail = g_list_append(assoc_info_tail, info)->next;
+    else
+        sctp_tapinfo_struct.assoc_info_list = assoc_info_tail = g_list_append(NULL, info);
+}
+
+static void
+add_frame_number(sctp_assoc_info_t *info, guint32 number)
+{
+    if (info->frame_numbers == NULL)
+        info->frame_numbers = g_array_new(FALSE, FALSE, sizeof(guint32));
+    g_array_append_val(info->frame_numbers, number);
 }
 
 static sctp_assoc_info_t *
@@ -723,7 +739,7 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                 else
                     info = add_address(store, info, 1);
                 number = pinfo->num;
-                info->frame_numbers=g_list_prepend(info->frame_numbers, GUINT_TO_POINTER(number));
+                add_frame_number(info, number);
                 if (datachunk || forwardchunk) {
                     info->tsn1 = g_list_prepend(info->tsn1, tsn);
                     tsn_used = TRUE;
@@ -732,7 +748,7 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
                     info->sack2 = g_list_prepend(info->sack2, sack);
                     sack_used = TRUE;
                 }
-                sctp_tapinfo_struct.assoc_info_list = g_list_append(sctp_tapinfo_struct.assoc_info_list, info);
+                add_assoc(info);
             }
             else
             {
@@ -814,7 +830,7 @@ packet(void *tapdata _U_, packet_info *pinfo, epan_dissect_t *edt _U_, const voi
             sack->frame_number = tsn->frame_number = pinfo->num;
         }
         number = pinfo->num;
-        info->frame_numbers=g_list_prepend(info->frame_numbers, GUINT_TO_POINTER(number));
+        add_frame_number(info, number);
 
         store = g_new(address, 1);
         copy_address(store, &tmp_info.src);
@@ -1277,6 +1293,37 @@ get_sctp_assoc_info(guint16 assoc_id)
     return find_assoc(&needle);
 }
 
+const sctp_assoc_info_t *
+get_sctp_assoc_for_frame(guint32 frame_num)
+{
+    GList *list;
+
+    /* Packets are tapped in order, so each association's frame numbers
+     * are sorted and can be binary searched. */
+    for (list = g_list_first(sctp_tapinfo_struct.assoc_info_list); list; list = g_list_next(list))
+    {
+        const sctp_assoc_info_t *info = (const sctp_assoc_info_t *)list->data;
+        guint low = 0, high;
+
+        if (info->frame_numbers == NULL)
+            continue;
+        high = info->frame_numbers->len;
+        while (low < high)
+        {
+            guint mid = low + (high - low) / 2;
+            guint32 fn = g_array_index(info->frame_numbers, guint32, mid);
+
+            if (fn == frame_num)
+                return info;
+            if (fn < frame_num)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+    }
+    return NULL;
+}
+
 void
 register_tap_listener_sctp_stat(void)
 {
@@ -252,7 +252,7 @@ typedef struct _sctp_assoc_info {
 	sctp_init_collision_t *dir1;
 	sctp_init_collision_t *dir2;
 	GSList	  *min_max;
-	GList	  *frame_numbers;
+	GArray	  *frame_numbers;	/* guint32 frame numbers, ascending */
 	GList	  *tsn1;
 	GPtrArray *sort_tsn1;
 	GPtrArray *sort_sack1;
@@ -298,6 +298,8 @@ void sctp_stat_scan(void);
 void remove_tap_listener_sctp_stat(void);
 
 const sctp_assoc_info_t* get_sctp_assoc_info(guint16 assoc_id);
+/* Returns the association that frame frame_num belongs to, if any. */
+const sctp_assoc_info_t* get_sctp_assoc_for_frame(guint32 frame_num);
 const sctp_assoc_info_t* get_selected_assoc(void);
 
 #ifdef __cplusplus
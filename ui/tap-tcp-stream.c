@@ -104,6 +104,7 @@ graph_segment_list_get(capture_file *cf, struct tcp_graph *tg)
 {
     GString    *error_string;
     tcp_scan_t  ts;
+    GArray     *frames;
 
     if (!cf || !tg) {
         return;
@@ -123,7 +124,19 @@ graph_segment_list_get(capture_file *cf, struct tcp_graph *tg)
         g_string_free(error_string, TRUE);
         exit(1);   /* XXX: fix this */
     }
-    cf_retap_packets(cf);
+
+    /* If the TCP dissector knows which frames are in the stream, only
+     * dissect those, and don't hand them to anyone else's listeners.
+     */
+    frames = get_tcp_stream_frames(tg->stream);
+    if (frames) {
+        set_tap_listener_exclusive(&ts);
+        cf_retap_frames(cf, frames);
+        set_tap_listener_exclusive(NULL);
+        g_array_free(frames, TRUE);
+    } else {
+        cf_retap_packets(cf);
+    }
     remove_tap_listener(&ts);
 }
 
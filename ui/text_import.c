@@ -387,6 +387,28 @@ parse_num(const char *str, int offset, guint32* num)
     return IMPORT_SUCCESS;
 }
 
+/*
+ * The value of each hex digit, or -1.
+ */
+static const gint8 hex_digit_value[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
 /*----------------------------------------------------------------------
  * Write this byte into current packet
  */
@@ -394,9 +416,20 @@ static import_status_t
 write_byte(const char *str)
 {
     guint32 num;
+    gint8   hi, lo;
 
-    if (parse_num(str, FALSE, &num) != IMPORT_SUCCESS)
+    /*
+     * The scanner only gives us bytes as two hex digits, so look them
+     * up rather than going through strtoul() for every byte; fall back
+     * on parse_num() for anything else.
+     */
+    hi = hex_digit_value[(guint8)str[0]];
+    lo = (hi >= 0) ? hex_digit_value[(guint8)str[1]] : -1;
+    if (lo >= 0 && hex_digit_value[(guint8)str[2]] < 0) {
+        num = (guint32)((hi << 4) | lo);
+    } else if (parse_num(str, FALSE, &num) != IMPORT_SUCCESS) {
         return IMPORT_FAILURE;
+    }
 
     packet_buf[curr_offset] = (guint8) num;
     curr_offset++;
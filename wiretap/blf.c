@@ -67,6 +67,13 @@ typedef struct blf_log_container {
     unsigned char  *real_data;        /* cache for decompressed data */
 } blf_log_container_t;
 
+/*
+ * How many decompressed log containers are kept in memory. Containers are
+ * typically 128 KiB uncompressed, so this bounds the cache to a few MiB
+ * however large the file is; the least recently used one is dropped first.
+ */
+#define BLF_INFLATED_CONTAINERS_MAX 32
+
 typedef struct blf_data {
     gint64  start_of_last_obj;
     gint64  current_real_seek_pos;
@@ -74,6 +81,7 @@ typedef struct blf_data {
 
     guint   current_log_container;
     GArray *log_containers;
+    GQueue  inflated_containers;      /* indexes of containers with real_data, most recently used first */
 
     GHashTable *channel_to_iface_ht;
     guint32     next_interface_id;
@@ -456,11 +464,20 @@ blf_find_logcontainer_for_address(blf_t *blf_data, gint64 pos, blf_log_container
         return FALSE;
     }
 
-    for (guint i = 0; i < blf_data->log_containers->len; i++) {
-        tmp = &g_array_index(blf_data->log_containers, blf_log_container_t, i);
-        if (tmp->real_start_pos <= pos && pos < tmp->real_start_pos + (gint64)tmp->real_length) {
+    /* The containers are in file order, so their real start positions are ascending. */
+    guint low = 0;
+    guint high = blf_data->log_containers->len;
+
+    while (low < high) {
+        guint mid = low + (high - low) / 2;
+        tmp = &g_array_index(blf_data->log_containers, blf_log_container_t, mid);
+        if (pos < tmp->real_start_pos) {
+            high = mid;
+        } else if (pos >= tmp->real_start_pos + (gint64)tmp->real_length) {
+            low = mid + 1;
+        } else {
             *container = tmp;
-            *container_index = i;
+            *container_index = mid;
             return TRUE;
         }
     }
@@ -468,6 +485,28 @@ blf_find_logcontainer_for_address(blf_t *blf_data, gint64 pos, blf_log_container
     return FALSE;
 }
 
+static void
+blf_touch_inflated_container(blf_t *blf_data, guint index_log_container) {
+    GList *link = g_queue_find(&blf_data->inflated_containers, GUINT_TO_POINTER(index_log_container));
+
+    if (link != NULL && link != blf_data->inflated_containers.head) {
+        g_queue_unlink(&blf_data->inflated_containers, link);
+        g_queue_push_head_link(&blf_data->inflated_containers, link);
+    }
+}
+
+static void
+blf_add_inflated_container(blf_t *blf_data, guint index_log_container) {
+    g_queue_push_head(&blf_data->inflated_containers, GUINT_TO_POINTER(index_log_container));
+
+    while (g_queue_get_length(&blf_data->inflated_containers) > BLF_INFLATED_CONTAINERS_MAX) {
+        guint lru_index = GPOINTER_TO_UINT(g_queue_pop_tail(&blf_data->inflated_containers));
+        blf_log_container_t *lru = &g_array_index(blf_data->log_containers, blf_log_container_t, lru_index);
+        g_free(lru->real_data);
+        lru->real_data = NULL;
+    }
+}
+
 static gboolean
 blf_pull_logcontainer_into_memory(blf_params_t *params, guint index_log_container) {
     blf_t *blf_data = params->blf_data;
@@ -481,6 +520,7 @@ blf_pull_logcontainer_into_memory(blf_params_t *params, guint index_log_containe
     tmp = g_array_index(blf_data->log_containers, blf_log_container_t, index_log_container);
 
     if (tmp.real_data != NULL) {
+        blf_touch_inflated_container(blf_data, index_log_container);
         return TRUE;
     }
 
@@ -498,14 +538,25 @@ blf_pull_logcontainer_into_memory(blf_params_t *params, guint index_log_containe
         /* pull compressed data into buffer */
         unsigned char *compressed_data = g_try_malloc0((gsize)tmp.infile_length);
         guint64 data_length = (unsigned int)tmp.infile_length - (tmp.infile_data_start - tmp.infile_start_pos);
+        if (compressed_data == NULL) {
+            ws_debug("cannot allocate memory for compressed data");
+            return FALSE;
+        }
         if (!wtap_read_bytes_or_eof(params->fh, compressed_data, (unsigned int)data_length, &err, &err_info)) {
             ws_debug("cannot read compressed data");
+            g_free(compressed_data);
             return FALSE;
         }
 
         unsigned char *buf = g_try_malloc0((gsize)tmp.real_length);
         z_stream infstream = {0};
 
+        if (buf == NULL) {
+            ws_debug("cannot allocate memory for decompressed data");
+            g_free(compressed_data);
+            return FALSE;
+        }
+
         infstream.avail_in  = (unsigned int)data_length;
         infstream.next_in   = compressed_data;
         infstream.avail_out = (unsigned int)tmp.real_length;
@@ -517,6 +568,8 @@ blf_pull_logcontainer_into_memory(blf_params_t *params, guint index_log_containe
             if (infstream.msg != NULL) {
                 ws_debug("inflateInit returned: \"%s\"", infstream.msg);
             }
+            g_free(compressed_data);
+            g_free(buf);
             return FALSE;
         }
 
@@ -527,6 +580,9 @@ blf_pull_logcontainer_into_memory(blf_params_t *params, guint index_log_containe
             if (infstream.msg != NULL) {
                 ws_debug("inflate returned: \"%s\"", infstream.msg);
             }
+            inflateEnd(&infstream);
+            g_free(compressed_data);
+            g_free(buf);
             return FALSE;
         }
 
@@ -535,11 +591,16 @@ blf_pull_logcontainer_into_memory(blf_params_t *params, guint index_log_containe
             if (infstream.msg != NULL) {
                 ws_debug("inflateEnd returned: \"%s\"", infstream.msg);
             }
+            g_free(compressed_data);
+            g_free(buf);
             return FALSE;
         }
 
+        g_free(compressed_data);
+
         tmp.real_data = buf;
         g_array_index(blf_data->log_containers, blf_log_container_t, index_log_container) = tmp;
+        blf_add_inflated_container(blf_data, index_log_container);
         return TRUE;
 #else
         return FALSE;
@@ -1881,6 +1942,7 @@ static void blf_close(wtap *wth) {
         }
         g_array_free(blf->log_containers, TRUE);
         blf->log_containers = NULL;
+        g_queue_clear(&blf->inflated_containers);
     }
 
     if (blf != NULL && blf->channel_to_iface_ht != NULL) {
@@ -1942,6 +2004,7 @@ blf_open(wtap *wth, int *err, gchar **err_info) {
     blf = g_new(blf_t, 1);
     blf->log_containers = NULL;
     blf->current_log_container = 0;
+    g_queue_init(&blf->inflated_containers);
     blf->current_real_seek_pos = 0;
     blf->start_offset_ns = 1000 * 1000 * 1000 * (guint64)mktime(&timestamp);
     blf->start_offset_ns += 1000 * 1000 * header.start_date.ms;
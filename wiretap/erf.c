@@ -60,6 +60,8 @@ static gboolean erf_read_header(wtap *wth, FILE_T fh,
                                 GPtrArray *anchor_mappings_to_update);
 static gboolean erf_read(wtap *wth, wtap_rec *rec, Buffer *buf,
                          int *err, gchar **err_info, gint64 *data_offset);
+static void erf_read_batch(wtap *wth, wtap_rec_batch *batch,
+                           int *err, gchar **err_info);
 static gboolean erf_seek_read(wtap *wth, gint64 seek_off,
                               wtap_rec *rec, Buffer *buf,
                               int *err, gchar **err_info);
@@ -554,6 +556,7 @@ extern wtap_open_return_val erf_open(wtap *wth, int *err, gchar **err_info)
   wth->file_encap = WTAP_ENCAP_ERF;
 
   wth->subtype_read = erf_read;
+  wth->subtype_read_batch = erf_read_batch;
   wth->subtype_seek_read = erf_seek_read;
   wth->subtype_close = erf_close;
   wth->file_tsprec = WTAP_TSPREC_NSEC;
@@ -563,28 +566,32 @@ extern wtap_open_return_val erf_open(wtap *wth, int *err, gchar **err_info)
   return WTAP_OPEN_MINE;
 }
 
-/* Read the next packet */
-static gboolean erf_read(wtap *wth, wtap_rec *rec, Buffer *buf,
-                         int *err, gchar **err_info, gint64 *data_offset)
+/*
+ * Read the next record, skipping padding records, from the sequential
+ * stream.  If batch isn't NULL, the record data goes straight into the
+ * batch arena.  anchor_mappings_to_update is scratch space, emptied here.
+ */
+static gboolean erf_read_record(wtap *wth, wtap_rec *rec, Buffer *buf,
+                                wtap_rec_batch *batch,
+                                GPtrArray *anchor_mappings_to_update,
+                                int *err, gchar **err_info)
 {
   erf_header_t erf_header;
   guint32      packet_size, bytes_read;
-  GPtrArray *anchor_mappings_to_update;
 
-  *data_offset = file_tell(wth->fh);
-
-  anchor_mappings_to_update = g_ptr_array_new_with_free_func(erf_anchor_mapping_destroy);
+  g_ptr_array_set_size(anchor_mappings_to_update, 0);
 
   do {
     if (!erf_read_header(wth, wth->fh, rec, &erf_header,
                          err, err_info, &bytes_read, &packet_size,
                          anchor_mappings_to_update)) {
-      g_ptr_array_free(anchor_mappings_to_update, TRUE);
       return FALSE;
     }
 
+    if (batch != NULL) {
+      buf = wtap_rec_batch_reserve(batch, packet_size);
+    }
     if (!wtap_read_packet_bytes(wth->fh, buf, packet_size, err, err_info)) {
-      g_ptr_array_free(anchor_mappings_to_update, TRUE);
       return FALSE;
     }
 
@@ -596,16 +603,62 @@ static gboolean erf_read(wtap *wth, wtap_rec *rec, Buffer *buf,
     if ((erf_header.type & 0x7F) == ERF_TYPE_META && packet_size > 0)
     {
       if (populate_summary_info((erf_t*) wth->priv, wth, &rec->rec_header.packet_header.pseudo_header, buf, packet_size, anchor_mappings_to_update, err, err_info) < 0) {
-        g_ptr_array_free(anchor_mappings_to_update, TRUE);
         return FALSE;
       }
     }
 
+    if (erf_header.type == ERF_TYPE_PAD) {
+      /* Drop the block made for the padding record we're skipping. */
+      wtap_block_unref(rec->block);
+      rec->block = NULL;
+    }
+
   } while ( erf_header.type == ERF_TYPE_PAD );
 
+  return TRUE;
+}
+
+/* Read the next packet */
+static gboolean erf_read(wtap *wth, wtap_rec *rec, Buffer *buf,
+                         int *err, gchar **err_info, gint64 *data_offset)
+{
+  GPtrArray *anchor_mappings_to_update;
+  gboolean   ret;
+
+  *data_offset = file_tell(wth->fh);
+
+  anchor_mappings_to_update = g_ptr_array_new_with_free_func(erf_anchor_mapping_destroy);
+  ret = erf_read_record(wth, rec, buf, NULL, anchor_mappings_to_update, err, err_info);
   g_ptr_array_free(anchor_mappings_to_update, TRUE);
 
-  return TRUE;
+  return ret;
+}
+
+/*
+ * Read a batch of records, with the record data going straight into the
+ * batch arena, and with the anchor mapping scratch array shared by the
+ * whole batch rather than allocated for each record.
+ */
+static void erf_read_batch(wtap *wth, wtap_rec_batch *batch,
+                           int *err, gchar **err_info)
+{
+  GPtrArray *anchor_mappings_to_update;
+  wtap_rec  *rec;
+  gint64     data_offset;
+
+  anchor_mappings_to_update = g_ptr_array_new_with_free_func(erf_anchor_mapping_destroy);
+
+  while ((rec = wtap_rec_batch_next(wth, batch)) != NULL) {
+    data_offset = file_tell(wth->fh);
+    if (!erf_read_record(wth, rec, &batch->buf, batch,
+                         anchor_mappings_to_update, err, err_info)) {
+      wtap_rec_batch_discard(batch);
+      break;
+    }
+    wtap_rec_batch_add(batch, data_offset);
+  }
+
+  g_ptr_array_free(anchor_mappings_to_update, TRUE);
 }
 
 static gboolean erf_seek_read(wtap *wth, gint64 seek_off,
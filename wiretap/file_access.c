@@ -930,6 +930,14 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 
 		file_set_random_access(wth->fh, FALSE, wth->fast_seek);
 		file_set_random_access(wth->random_fh, TRUE, wth->fast_seek);
+
+		/* Restore the seek points from a previous open, if we can. */
+		wth->fast_seek_from_index = file_fast_seek_load(wth->random_fh,
+		    filename, wth->fast_seek);
+		/* Or from a seek table in the file itself. */
+		if (!wth->fast_seek_from_index)
+			wth->fast_seek_from_index = file_zstd_seek_table_load(wth->random_fh,
+			    wth->fast_seek);
 	}
 
 	/* 'type' is 1 greater than the array index */
@@ -2163,7 +2171,7 @@ wtap_dump_can_open(int file_type_subtype)
 	return TRUE;
 }
 
-#ifdef HAVE_ZLIB
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
 gboolean
 wtap_dump_can_compress(int file_type_subtype)
 {
@@ -2193,6 +2201,8 @@ static gboolean wtap_dump_open_finish(wtap_dumper *wdh, int *err,
 static WFILE_T wtap_dump_file_open(wtap_dumper *wdh, const char *filename);
 static WFILE_T wtap_dump_file_fdopen(wtap_dumper *wdh, int fd);
 static int wtap_dump_file_close(wtap_dumper *wdh);
+static void wtap_dump_async_start(wtap_dumper *wdh);
+static gboolean wtap_dump_async_drain(wtap_dumper *wdh, int *err);
 
 static wtap_dumper *
 wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_type,
@@ -2248,6 +2258,23 @@ wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_t
 		return NULL;
 	}
 
+	/* And can we write that type of compression? */
+	switch (compression_type) {
+
+	case WTAP_UNCOMPRESSED:
+#ifdef HAVE_ZLIB
+	case WTAP_GZIP_COMPRESSED:
+#endif
+#ifdef HAVE_ZSTD
+	case WTAP_ZSTD_COMPRESSED:
+#endif
+		break;
+
+	default:
+		*err = WTAP_ERR_COMPRESSION_NOT_SUPPORTED;
+		return NULL;
+	}
+
 	/* Allocate a data structure for the output stream. */
 	wdh = g_new0(wtap_dumper, 1);
 	if (wdh == NULL) {
@@ -2259,6 +2286,8 @@ wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_t
 	wdh->snaplen = params->snaplen;
 	wdh->encap = params->encap;
 	wdh->compression_type = compression_type;
+	wdh->write_record_index = params->write_record_index;
+	wdh->threaded_write = params->threaded_write;
 	wdh->wslua_data = NULL;
 	wdh->interface_data = g_array_new(FALSE, FALSE, sizeof(wtap_block_t));
 
@@ -2574,6 +2603,15 @@ wtap_dump_open_finish(wtap_dumper *wdh, int *err, gchar **err_info)
 	if (file_type_subtype_table[wdh->file_type_subtype].wslua_info)
 		wdh->wslua_data = file_type_subtype_table[wdh->file_type_subtype].wslua_info->wslua_data;
 
+	/*
+	 * If we were asked to write on a separate thread, do so if
+	 * the file is written purely sequentially; otherwise, the
+	 * seeks would just keep waiting for the writer thread.
+	 */
+	if (wdh->threaded_write &&
+	    !file_type_subtype_table[wdh->file_type_subtype].writing_must_seek)
+		wtap_dump_async_start(wdh);
+
 	/* Now try to open the file for writing. */
 	if (!(*file_type_subtype_table[wdh->file_type_subtype].dump_open)(wdh, err,
 	    err_info)) {
@@ -2610,6 +2648,8 @@ wtap_dump(wtap_dumper *wdh, const wtap_rec *rec,
 gboolean
 wtap_dump_flush(wtap_dumper *wdh, int *err)
 {
+	if (wdh->async != NULL && !wtap_dump_async_drain(wdh, err))
+		return FALSE;
 #ifdef HAVE_ZLIB
 	if (wdh->compression_type == WTAP_GZIP_COMPRESSED) {
 		if (gzwfile_flush((GZWFILE_T)wdh->fh) == -1) {
@@ -2617,6 +2657,14 @@ wtap_dump_flush(wtap_dumper *wdh, int *err)
 			return FALSE;
 		}
 	} else
+#endif
+#ifdef HAVE_ZSTD
+	if (wdh->compression_type == WTAP_ZSTD_COMPRESSED) {
+		if (zstdwfile_flush((ZSTDWFILE_T)wdh->fh) == -1) {
+			*err = zstdwfile_geterr((ZSTDWFILE_T)wdh->fh);
+			return FALSE;
+		}
+	} else
 #endif
 	{
 		if (fflush((FILE *)wdh->fh) == EOF) {
@@ -2720,15 +2768,19 @@ wtap_dump_discard_decryption_secrets(wtap_dumper *wdh)
 }
 
 /* internally open a file for writing (compressed or not) */
-#ifdef HAVE_ZLIB
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
 static WFILE_T
 wtap_dump_file_open(wtap_dumper *wdh, const char *filename)
 {
-	if (wdh->compression_type == WTAP_GZIP_COMPRESSED) {
+#ifdef HAVE_ZLIB
+	if (wdh->compression_type == WTAP_GZIP_COMPRESSED)
 		return gzwfile_open(filename);
-	} else {
-		return ws_fopen(filename, "wb");
-	}
+#endif
+#ifdef HAVE_ZSTD
+	if (wdh->compression_type == WTAP_ZSTD_COMPRESSED)
+		return zstdwfile_open(filename);
+#endif
+	return ws_fopen(filename, "wb");
 }
 #else
 static WFILE_T
@@ -2739,15 +2791,19 @@ wtap_dump_file_open(wtap_dumper *wdh _U_, const char *filename)
 #endif
 
 /* internally open a file for writing (compressed or not) */
-#ifdef HAVE_ZLIB
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
 static WFILE_T
 wtap_dump_file_fdopen(wtap_dumper *wdh, int fd)
 {
-	if (wdh->compression_type == WTAP_GZIP_COMPRESSED) {
+#ifdef HAVE_ZLIB
+	if (wdh->compression_type == WTAP_GZIP_COMPRESSED)
 		return gzwfile_fdopen(fd);
-	} else {
-		return ws_fdopen(fd, "wb");
-	}
+#endif
+#ifdef HAVE_ZSTD
+	if (wdh->compression_type == WTAP_ZSTD_COMPRESSED)
+		return zstdwfile_fdopen(fd);
+#endif
+	return ws_fdopen(fd, "wb");
 }
 #else
 static WFILE_T
@@ -2758,8 +2814,8 @@ wtap_dump_file_fdopen(wtap_dumper *wdh _U_, int fd)
 #endif
 
 /* internally writing raw bytes (compressed or not) */
-gboolean
-wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err)
+static gboolean
+wtap_dump_file_write_raw(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err)
 {
 	size_t nwritten;
 
@@ -2774,6 +2830,18 @@ wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err
 			return FALSE;
 		}
 	} else
+#endif
+#ifdef HAVE_ZSTD
+	if (wdh->compression_type == WTAP_ZSTD_COMPRESSED) {
+		nwritten = zstdwfile_write((ZSTDWFILE_T)wdh->fh, buf, (unsigned int) bufsize);
+		/*
+		 * zstdwfile_write() returns 0 on error.
+		 */
+		if (nwritten == 0) {
+			*err = zstdwfile_geterr((ZSTDWFILE_T)wdh->fh);
+			return FALSE;
+		}
+	} else
 #endif
 	{
 		errno = WTAP_ERR_CANT_WRITE;
@@ -2793,14 +2861,246 @@ wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err
 	return TRUE;
 }
 
+/*
+ * Threaded output.
+ *
+ * The caller fills a buffer of WTAP_ASYNC_BUFFER_SIZE bytes; when it's
+ * full, it's handed to a writer thread, which does the (possibly
+ * compressing) write while the caller goes on filling the next buffer.
+ * There are WTAP_ASYNC_BUFFER_COUNT buffers in all; if the writer
+ * thread has all of them, the caller has to wait for one, which is
+ * counted as a stall, and wtap_dump_is_backlogged() lets the caller
+ * find out beforehand whether that's going to happen.
+ *
+ * Only the writer thread touches wdh->fh while buffers are queued;
+ * the caller waits for all of them to come back ("draining") before
+ * it flushes, seeks, tells, or closes the file.  Errors from the
+ * writer thread are picked up as buffers come back and are reported
+ * by the next write, flush, or close.
+ */
+#define WTAP_ASYNC_BUFFER_SIZE	(1024 * 1024)
+#define WTAP_ASYNC_BUFFER_COUNT	4
+
+typedef struct {
+	guint8	*data;
+	size_t	len;
+} wtap_async_buffer_t;
+
+typedef struct wtap_dump_async {
+	GThread		*thread;
+	GAsyncQueue	*to_write;	/* buffers for the writer thread */
+	GAsyncQueue	*written;	/* buffers the writer thread is done with */
+	wtap_async_buffer_t buffers[WTAP_ASYNC_BUFFER_COUNT];
+	wtap_async_buffer_t *idle[WTAP_ASYNC_BUFFER_COUNT];
+	guint		n_idle;
+	guint		n_queued;
+	wtap_async_buffer_t *cur;	/* buffer being filled, if any */
+	wtap_async_buffer_t stop;	/* tells the writer thread to exit */
+	gint		err;		/* first write error, set by the writer thread */
+	guint64		stalls;
+} wtap_dump_async_t;
+
+static gpointer
+wtap_dump_async_thread(gpointer data)
+{
+	wtap_dumper *wdh = (wtap_dumper *)data;
+	wtap_dump_async_t *async = wdh->async;
+	wtap_async_buffer_t *buffer;
+	int err;
+
+	for (;;) {
+		buffer = (wtap_async_buffer_t *)g_async_queue_pop(async->to_write);
+		if (buffer == &async->stop)
+			break;
+		/*
+		 * Once a write has failed, don't write anything more;
+		 * the buffers still come back so that the caller
+		 * doesn't wait for them forever.
+		 */
+		if (g_atomic_int_get(&async->err) == 0 &&
+		    !wtap_dump_file_write_raw(wdh, buffer->data, buffer->len, &err))
+			g_atomic_int_set(&async->err, err);
+		buffer->len = 0;
+		g_async_queue_push(async->written, buffer);
+	}
+	return NULL;
+}
+
+static void
+wtap_dump_async_start(wtap_dumper *wdh)
+{
+	wtap_dump_async_t *async;
+	guint i;
+
+	async = g_new0(wtap_dump_async_t, 1);
+	for (i = 0; i < WTAP_ASYNC_BUFFER_COUNT; i++) {
+		async->buffers[i].data = (guint8 *)g_malloc(WTAP_ASYNC_BUFFER_SIZE);
+		async->idle[i] = &async->buffers[i];
+	}
+	async->n_idle = WTAP_ASYNC_BUFFER_COUNT;
+	async->to_write = g_async_queue_new();
+	async->written = g_async_queue_new();
+	wdh->async = async;
+	async->thread = g_thread_new("wtap dump", wtap_dump_async_thread, wdh);
+}
+
+/* Take back a buffer from the writer thread, waiting if asked to. */
+static gboolean
+wtap_dump_async_reclaim(wtap_dump_async_t *async, gboolean wait)
+{
+	wtap_async_buffer_t *buffer;
+
+	if (async->n_queued == 0)
+		return FALSE;
+	if (wait)
+		buffer = (wtap_async_buffer_t *)g_async_queue_pop(async->written);
+	else
+		buffer = (wtap_async_buffer_t *)g_async_queue_try_pop(async->written);
+	if (buffer == NULL)
+		return FALSE;
+	async->n_queued--;
+	async->idle[async->n_idle++] = buffer;
+	return TRUE;
+}
+
+static void
+wtap_dump_async_submit(wtap_dump_async_t *async)
+{
+	if (async->cur == NULL)
+		return;
+	if (async->cur->len == 0) {
+		async->idle[async->n_idle++] = async->cur;
+	} else {
+		g_async_queue_push(async->to_write, async->cur);
+		async->n_queued++;
+	}
+	async->cur = NULL;
+}
+
+/*
+ * Hand over any partly-filled buffer and wait for the writer thread
+ * to finish with everything; on return, the caller may use wdh->fh
+ * directly.
+ */
+static gboolean
+wtap_dump_async_drain(wtap_dumper *wdh, int *err)
+{
+	wtap_dump_async_t *async = wdh->async;
+
+	wtap_dump_async_submit(async);
+	while (async->n_queued != 0)
+		wtap_dump_async_reclaim(async, TRUE);
+	if (g_atomic_int_get(&async->err) != 0) {
+		*err = g_atomic_int_get(&async->err);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+wtap_dump_async_stop(wtap_dumper *wdh)
+{
+	wtap_dump_async_t *async = wdh->async;
+	guint i;
+
+	g_async_queue_push(async->to_write, &async->stop);
+	g_thread_join(async->thread);
+	g_async_queue_unref(async->to_write);
+	g_async_queue_unref(async->written);
+	for (i = 0; i < WTAP_ASYNC_BUFFER_COUNT; i++)
+		g_free(async->buffers[i].data);
+	g_free(async);
+	wdh->async = NULL;
+}
+
+static gboolean
+wtap_dump_async_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err)
+{
+	wtap_dump_async_t *async = wdh->async;
+	const guint8 *p = (const guint8 *)buf;
+	size_t chunk;
+
+	while (bufsize != 0) {
+		if (async->cur == NULL) {
+			/* Pick up any buffers that have been written. */
+			while (wtap_dump_async_reclaim(async, FALSE))
+				;
+			if (async->n_idle == 0) {
+				async->stalls++;
+				wtap_dump_async_reclaim(async, TRUE);
+			}
+			if (g_atomic_int_get(&async->err) != 0) {
+				*err = g_atomic_int_get(&async->err);
+				return FALSE;
+			}
+			async->cur = async->idle[--async->n_idle];
+		}
+		chunk = WTAP_ASYNC_BUFFER_SIZE - async->cur->len;
+		if (chunk > bufsize)
+			chunk = bufsize;
+		memcpy(async->cur->data + async->cur->len, p, chunk);
+		async->cur->len += chunk;
+		p += chunk;
+		bufsize -= chunk;
+		if (async->cur->len == WTAP_ASYNC_BUFFER_SIZE)
+			wtap_dump_async_submit(async);
+	}
+	return TRUE;
+}
+
+gboolean
+wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err)
+{
+	if (wdh->async != NULL)
+		return wtap_dump_async_write(wdh, buf, bufsize, err);
+	return wtap_dump_file_write_raw(wdh, buf, bufsize, err);
+}
+
+gboolean
+wtap_dump_is_backlogged(wtap_dumper *wdh)
+{
+	wtap_dump_async_t *async = wdh->async;
+
+	if (async == NULL || async->cur != NULL)
+		return FALSE;
+	while (wtap_dump_async_reclaim(async, FALSE))
+		;
+	return async->n_idle == 0;
+}
+
+guint64
+wtap_dump_get_stall_count(wtap_dumper *wdh)
+{
+	return wdh->async != NULL ? wdh->async->stalls : 0;
+}
+
 /* internally close a file for writing (compressed or not) */
 static int
 wtap_dump_file_close(wtap_dumper *wdh)
 {
+	if (wdh->async != NULL) {
+		int err;
+		gboolean ok;
+
+		ok = wtap_dump_async_drain(wdh, &err);
+		wtap_dump_async_stop(wdh);
+		if (!ok) {
+			/* Close the file anyway, but report the write error. */
+			wtap_dump_file_close(wdh);
+			errno = err;
+			return EOF;
+		}
+	}
+
 #ifdef HAVE_ZLIB
 	if (wdh->compression_type == WTAP_GZIP_COMPRESSED)
 		return gzwfile_close((GZWFILE_T)wdh->fh);
 	else
+#endif
+#ifdef HAVE_ZSTD
+	if (wdh->compression_type == WTAP_ZSTD_COMPRESSED)
+		return zstdwfile_close((ZSTDWFILE_T)wdh->fh);
+	else
 #endif
 		return fclose((FILE *)wdh->fh);
 }
@@ -2808,12 +3108,12 @@ wtap_dump_file_close(wtap_dumper *wdh)
 gint64
 wtap_dump_file_seek(wtap_dumper *wdh, gint64 offset, int whence, int *err)
 {
-#ifdef HAVE_ZLIB
+	if (wdh->async != NULL && !wtap_dump_async_drain(wdh, err))
+		return -1;
 	if (wdh->compression_type != WTAP_UNCOMPRESSED) {
 		*err = WTAP_ERR_CANT_SEEK_COMPRESSED;
 		return -1;
 	} else
-#endif
 	{
 		if (-1 == ws_fseek64((FILE *)wdh->fh, offset, whence)) {
 			*err = errno;
@@ -2829,12 +3129,12 @@ gint64
 wtap_dump_file_tell(wtap_dumper *wdh, int *err)
 {
 	gint64 rval;
-#ifdef HAVE_ZLIB
+	if (wdh->async != NULL && !wtap_dump_async_drain(wdh, err))
+		return -1;
 	if (wdh->compression_type != WTAP_UNCOMPRESSED) {
 		*err = WTAP_ERR_CANT_SEEK_COMPRESSED;
 		return -1;
 	} else
-#endif
 	{
 		if (-1 == (rval = ws_ftell64((FILE *)wdh->fh))) {
 			*err = errno;
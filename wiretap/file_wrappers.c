@@ -15,6 +15,7 @@
  */
 
 #include "config.h"
+#define WS_LOG_DOMAIN LOG_DOMAIN_WIRETAP
 #include "file_wrappers.h"
 
 #include <assert.h>
@@ -23,6 +24,18 @@
 #include "wtap-int.h"
 
 #include <wsutil/file_util.h>
+#include <wsutil/perf_stats.h>
+#include <wsutil/wslog.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
 
 #ifdef HAVE_ZLIB
 #define ZLIB_CONST
@@ -63,19 +76,20 @@
  */
 static struct compression_type {
     wtap_compression_type  type;
+    const char            *name;
     const char            *extension;
     const char            *description;
 } compression_types[] = {
 #ifdef HAVE_ZLIB
-    { WTAP_GZIP_COMPRESSED, "gz", "gzip compressed" },
+    { WTAP_GZIP_COMPRESSED, "gzip", "gz", "gzip compressed" },
 #endif
 #ifdef HAVE_ZSTD
-    { WTAP_ZSTD_COMPRESSED, "zst", "zstd compressed" },
+    { WTAP_ZSTD_COMPRESSED, "zstd", "zst", "zstd compressed" },
 #endif
 #ifdef USE_LZ4
-    { WTAP_LZ4_COMPRESSED, "lz4", "lz4 compressed" },
+    { WTAP_LZ4_COMPRESSED, "lz4", "lz4", "lz4 compressed" },
 #endif
-    { WTAP_UNCOMPRESSED, NULL, NULL }
+    { WTAP_UNCOMPRESSED, NULL, NULL, NULL }
 };
 
 static wtap_compression_type file_get_compression_type(FILE_T stream);
@@ -108,6 +122,17 @@ wtap_compression_type_extension(wtap_compression_type compression_type)
 	return NULL;
 }
 
+wtap_compression_type
+wtap_name_to_compression_type(const char *name)
+{
+	for (struct compression_type *p = compression_types;
+	    p->type != WTAP_UNCOMPRESSED; p++) {
+		if (strcmp(name, p->name) == 0)
+			return p->type;
+	}
+	return WTAP_UNCOMPRESSED;
+}
+
 GSList *
 wtap_get_all_compression_type_extensions_list(void)
 {
@@ -159,6 +184,17 @@ typedef enum {
  */
 #define MAX_READ_BUF_SIZE	(1U << 30)
 
+#ifdef HAVE_SYS_MMAN_H
+/*
+ * When reading an uncompressed file through a memory mapping, the
+ * output buffer is a window onto the mapping; this is the most we
+ * make visible through it at once.  It only limits how far we can
+ * seek within the "buffer" and how coarse file_tell_raw() is, not
+ * how much we can read without a system call.
+ */
+#define MAP_WINDOW_SIZE	(1U << 20)
+#endif
+
 struct wtap_reader_buf {
     guint8 *buf;  /* buffer */
     guint8 *next; /* next byte to deliver from buffer */
@@ -203,6 +239,23 @@ struct wtap_reader {
 #ifdef USE_LZ4
     LZ4F_dctx *lz4_dctx;
 #endif
+#ifdef HAVE_ZSTD
+    struct zstd_readahead *zstd_ra; /* parallel frame decompression, or NULL */
+    gboolean zstd_ra_disabled;  /* TRUE if we shouldn't try that again */
+#endif
+    gboolean random_access;     /* TRUE if set up for random access */
+#ifdef HAVE_SYS_MMAN_H
+    /* memory mapping of an uncompressed regular file */
+    guint8 *map;                /* start of the mapping, or NULL if not mapped */
+    gint64 map_size;            /* size of the mapping */
+    gboolean out_is_mapped;     /* TRUE if out.buf points into the mapping */
+    struct file_map_slot *map_slot; /* where the mapping is registered */
+    guint8 *retired_map;        /* mapping we've stopped reading from, kept
+                                   until close as callers may refer to it */
+    gint64 retired_map_size;    /* size of that mapping */
+    struct file_map_slot *retired_map_slot;
+#endif
+    ws_shm_ring *live_ring;     /* recently written bytes of the file, or NULL */
 };
 
 /* Current read offset within a buffer. */
@@ -266,6 +319,26 @@ buf_read(FILE_T state, struct wtap_reader_buf *buf)
         to_read = space_left;
     }
 
+    if (state->live_ring != NULL) {
+        /*
+         * If what we want is in the ring, take it from there, and move
+         * past it in the file.
+         */
+        gint64 copied = ws_shm_ring_read(state->live_ring, state->raw_pos,
+                                         read_ptr, to_read);
+
+        if (copied > 0) {
+            if (ws_lseek64(state->fd, copied, SEEK_CUR) == -1) {
+                state->err = errno;
+                state->err_info = NULL;
+                return -1;
+            }
+            state->raw_pos += copied;
+            buf->avail += (guint)copied;
+            ws_perf_add(WS_PERF_BYTES_READ, copied);
+            return 0;
+        }
+    }
     ret = ws_read(state->fd, read_ptr, to_read);
     if (ret < 0) {
         state->err = errno;
@@ -276,6 +349,7 @@ buf_read(FILE_T state, struct wtap_reader_buf *buf)
         state->eof = TRUE;
     state->raw_pos += ret;
     buf->avail += (guint)ret;
+    ws_perf_add(WS_PERF_BYTES_READ, ret);
     return 0;
 }
 
@@ -291,6 +365,248 @@ fill_in_buffer(FILE_T state)
     return 0;
 }
 
+#ifdef HAVE_SYS_MMAN_H
+/*
+ * If a mapped file is truncated by someone else while we're reading
+ * it, touching a page of the mapping that's now past the end of the
+ * file raises SIGBUS, possibly long after we handed the page out.
+ * Rather than only mapping files that can't change, which we can't
+ * know, we catch that: every mapping is registered here, and the
+ * SIGBUS handler replaces the rest of a mapping that faulted with
+ * zeroed memory and flags it, so whoever touched it sees zeroes, and
+ * the next read from the file reports a short read.
+ *
+ * The handler only reads the table, and a slot's start is set last
+ * and cleared first, so it never sees a half-registered mapping.
+ */
+#define MAX_FILE_MAPS   64
+
+struct file_map_slot {
+    guint8 *start;              /* start of the mapping; NULL if unused */
+    size_t size;                /* size of the mapping */
+    gint truncated;             /* set if the file was truncated under it */
+};
+
+static struct file_map_slot file_maps[MAX_FILE_MAPS];
+static struct sigaction file_map_old_sigbus;
+static size_t file_map_page_size;
+
+static void
+file_map_sigbus(int sig _U_, siginfo_t *info, void *context _U_)
+{
+    guint8 *addr = (guint8 *)info->si_addr;
+    guint8 *start, *page;
+    size_t size;
+    int i;
+
+    for (i = 0; i < MAX_FILE_MAPS; i++) {
+        start = (guint8 *)g_atomic_pointer_get(&file_maps[i].start);
+        size = file_maps[i].size;
+        if (start == NULL || addr < start || addr >= start + size)
+            continue;
+        page = start + ((size_t)(addr - start) & ~(file_map_page_size - 1));
+        if (mmap(page, (size_t)(start + size - page), PROT_READ,
+                 MAP_PRIVATE|MAP_FIXED|MAP_ANONYMOUS, -1, 0) == MAP_FAILED)
+            break;
+        g_atomic_int_set(&file_maps[i].truncated, 1);
+        return;
+    }
+
+    /*
+     * Not one of ours, or we couldn't patch it up; put back whatever
+     * handled SIGBUS before, which gets it when the access is retried.
+     */
+    sigaction(SIGBUS, &file_map_old_sigbus, NULL);
+}
+
+/*
+ * Register a mapping, installing the SIGBUS handler if it's the first.
+ * Returns NULL if there are too many mappings, or the handler can't be
+ * installed, in which case the file shouldn't be read through it.
+ */
+static struct file_map_slot *
+file_map_register(guint8 *start, size_t size)
+{
+    static gsize handler_installed;
+    int i;
+
+    if (g_once_init_enter(&handler_installed)) {
+        struct sigaction sa;
+        gsize installed = 1;
+
+        memset(&sa, 0, sizeof sa);
+        sa.sa_sigaction = file_map_sigbus;
+        sa.sa_flags = SA_SIGINFO|SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        file_map_page_size = (size_t)sysconf(_SC_PAGESIZE);
+        if (sigaction(SIGBUS, &sa, &file_map_old_sigbus) == -1)
+            installed = 2;
+        g_once_init_leave(&handler_installed, installed);
+    }
+    if (handler_installed != 1)
+        return NULL;
+
+    for (i = 0; i < MAX_FILE_MAPS; i++) {
+        /* Claim the slot with its size, then publish the start. */
+        if (g_atomic_pointer_get(&file_maps[i].start) == NULL &&
+            g_atomic_int_compare_and_exchange(&file_maps[i].truncated, 0, -1)) {
+            file_maps[i].size = size;
+            g_atomic_pointer_set(&file_maps[i].start, start);
+            g_atomic_int_set(&file_maps[i].truncated, 0);
+            return &file_maps[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+file_map_unregister(struct file_map_slot *slot)
+{
+    if (slot == NULL)
+        return;
+    g_atomic_pointer_set(&slot->start, NULL);
+    slot->size = 0;
+    g_atomic_int_set(&slot->truncated, 0);
+}
+
+/*
+ * If the file was truncated under the mapping, fail with a short read;
+ * returns -1 if so.
+ */
+static int
+file_map_check(FILE_T state)
+{
+    if (state->map_slot != NULL &&
+        g_atomic_int_get(&state->map_slot->truncated) == 1) {
+        state->err = WTAP_ERR_SHORT_READ;
+        state->err_info = "file was truncated while being read";
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Make the output buffer a window onto the mapping, starting at
+ * raw_off in the file; returns FALSE if raw_off is at or past the
+ * end of the mapping.
+ */
+static gboolean
+map_window(FILE_T state, gint64 raw_off)
+{
+    gint64 left;
+
+    if (raw_off >= state->map_size)
+        return FALSE;
+    left = state->map_size - raw_off;
+    state->out.buf = state->map + raw_off;
+    state->out.next = state->out.buf;
+    state->out.avail = left > MAP_WINDOW_SIZE ? MAP_WINDOW_SIZE : (guint)left;
+    state->raw_pos = raw_off + state->out.avail;
+    ws_perf_add(WS_PERF_BYTES_READ, state->out.avail);
+    return TRUE;
+}
+
+/*
+ * Try to map a regular, uncompressed file, so that reads and seeks
+ * don't need system calls.  Failure isn't an error; we just fall
+ * back on ws_read().
+ */
+static void
+file_map(FILE_T state)
+{
+    ws_statb64 st;
+    void *map;
+
+    if (state->start != 0 || ws_fstat64(state->fd, &st) == -1)
+        return;
+    if (!S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (guint64)st.st_size > G_MAXSIZE)
+        return;
+
+    /*
+     * Map it read-only, so that it costs no swap or commit charge;
+     * callers handed packet data in place by file_read_mapped() that
+     * want to modify it must copy it first.
+     */
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+        state->fd, 0);
+    if (map == MAP_FAILED) {
+        ws_debug("can't map file, reading it instead: %s", g_strerror(errno));
+        return;
+    }
+
+    /*
+     * Don't bother for compressed files; the decompressors work
+     * from the input buffer anyway.
+     */
+    if (st.st_size >= 2 &&
+        ((const guint8 *)map)[0] == 31 && ((const guint8 *)map)[1] == 139) {
+        munmap(map, (size_t)st.st_size);
+        return;
+    }
+    if (st.st_size >= 4 &&
+        (memcmp(map, "\x28\xb5\x2f\xfd", 4) == 0 ||
+         memcmp(map, "\x04\x22\x4d\x18", 4) == 0)) {
+        munmap(map, (size_t)st.st_size);
+        return;
+    }
+
+    state->map_slot = file_map_register((guint8 *)map, (size_t)st.st_size);
+    if (state->map_slot == NULL) {
+        ws_debug("can't guard mapping against truncation, reading file instead");
+        munmap(map, (size_t)st.st_size);
+        return;
+    }
+    posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+    state->map = (guint8 *)map;
+    state->map_size = st.st_size;
+}
+
+/*
+ * Stop using the mapping, e.g. because we've reached its end and the
+ * file might have grown since we mapped it, and go back to reading
+ * from the file descriptor at the current raw position.
+ *
+ * Data handed out by file_read_mapped() may still be in use, so the
+ * mapping itself isn't unmapped until the file is closed.
+ */
+static int
+file_unmap(FILE_T state)
+{
+    gint64 raw_off;
+
+    if (state->map == NULL)
+        return 0;
+
+    if (state->out_is_mapped) {
+        raw_off = state->raw_pos - state->out.avail;
+        state->out.buf = (unsigned char *)g_try_malloc(state->size << 1);
+        if (state->out.buf == NULL) {
+            state->err = ENOMEM;
+            state->err_info = NULL;
+            return -1;
+        }
+        if (state->fd != -1 && ws_lseek64(state->fd, raw_off, SEEK_SET) == -1) {
+            state->err = errno;
+            state->err_info = NULL;
+            g_free(state->out.buf);
+            state->out.buf = NULL;
+            return -1;
+        }
+        state->out_is_mapped = FALSE;
+        state->raw_pos = raw_off;
+        buf_reset(&state->out);
+    }
+    state->retired_map = state->map;
+    state->retired_map_size = state->map_size;
+    state->retired_map_slot = state->map_slot;
+    state->map = NULL;
+    state->map_size = 0;
+    state->map_slot = NULL;
+    return 0;
+}
+#endif /* HAVE_SYS_MMAN_H */
+
 #define ZLIB_WINSIZE 32768
 
 struct fast_seek_point {
@@ -381,6 +697,324 @@ fast_seek_reset(
 #endif
 }
 
+/*
+ * Persistent fast seek index.
+ *
+ * If the WIRESHARK_FAST_SEEK_INDEX environment variable is set, the
+ * seek points built while reading a compressed file sequentially are
+ * saved in "<file>.fsidx" when the sequential pass reaches the end of
+ * the file, and restored from there when the file is opened again, so
+ * that random access is fast without decompressing everything first.
+ *
+ * The index is in host byte order and records the size and
+ * modification time of the capture file; it's ignored if either
+ * doesn't match, or if it's from a different byte order or index
+ * version.
+ */
+#define FAST_SEEK_INDEX_SUFFIX  ".fsidx"
+#define FAST_SEEK_INDEX_MAGIC   "WSFSIDX"
+#define FAST_SEEK_INDEX_VERSION 1
+#define FAST_SEEK_INDEX_BOM     0x1A2B3C4D
+
+struct fast_seek_index_header {
+    char magic[8];              /* FAST_SEEK_INDEX_MAGIC, NUL-terminated */
+    guint32 version;            /* FAST_SEEK_INDEX_VERSION */
+    guint32 bom;                /* FAST_SEEK_INDEX_BOM */
+    guint64 file_size;          /* size of the capture file */
+    gint64 file_mtime;          /* modification time of the capture file */
+    guint32 npoints;            /* number of seek points that follow */
+    guint32 winsize;            /* ZLIB_WINSIZE */
+};
+
+struct fast_seek_index_point {
+    gint64 out;
+    gint64 in;
+    guint32 compression;
+    gint32 bits;
+    guint32 adler;
+    guint32 total_out;
+    /* followed by ZLIB_WINSIZE bytes of window for ZLIB points */
+};
+
+static gboolean
+fast_seek_index_enabled(void)
+{
+    return g_getenv("WIRESHARK_FAST_SEEK_INDEX") != NULL;
+}
+
+/*
+ * Restore the seek points for a file from its index, if there is a
+ * valid one; seek must be empty.  Returns TRUE if it was restored.
+ */
+gboolean
+file_fast_seek_load(FILE_T stream, const char *path, GPtrArray *seek)
+{
+    struct fast_seek_index_header hdr;
+    struct fast_seek_index_point ip;
+    ws_statb64 st;
+    char *index_path;
+    FILE *fp;
+    guint32 i;
+    gint64 last_out = -1;
+
+    if (!fast_seek_index_enabled() || seek->len != 0)
+        return FALSE;
+    if (ws_fstat64(stream->fd, &st) == -1)
+        return FALSE;
+
+    index_path = ws_strdup_printf("%s" FAST_SEEK_INDEX_SUFFIX, path);
+    fp = ws_fopen(index_path, "rb");
+    g_free(index_path);
+    if (fp == NULL)
+        return FALSE;
+
+    if (fread(&hdr, sizeof hdr, 1, fp) != 1 ||
+        memcmp(hdr.magic, FAST_SEEK_INDEX_MAGIC, sizeof hdr.magic) != 0 ||
+        hdr.version != FAST_SEEK_INDEX_VERSION ||
+        hdr.bom != FAST_SEEK_INDEX_BOM ||
+        hdr.winsize != ZLIB_WINSIZE ||
+        hdr.file_size != (guint64)st.st_size ||
+        hdr.file_mtime != (gint64)st.st_mtime)
+        goto fail;
+
+    for (i = 0; i < hdr.npoints; i++) {
+        struct fast_seek_point *val;
+
+        if (fread(&ip, sizeof ip, 1, fp) != 1)
+            goto fail;
+        /* Points have to be in order for fast_seek_find(). */
+        if (ip.out <= last_out || ip.in < 0 || ip.in > st.st_size)
+            goto fail;
+        last_out = ip.out;
+
+        val = g_new(struct fast_seek_point, 1);
+        val->out = ip.out;
+        val->in = ip.in;
+        val->compression = (compression_t)ip.compression;
+        g_ptr_array_add(seek, val);
+
+        switch (ip.compression) {
+
+        case UNCOMPRESSED:
+        case ZSTD:
+        case LZ4:
+            break;
+
+#ifdef HAVE_ZLIB
+        case GZIP_AFTER_HEADER:
+            break;
+
+        case ZLIB:
+#ifdef HAVE_INFLATEPRIME
+            val->data.zlib.bits = ip.bits;
+#else
+            if (ip.bits != 0)
+                goto fail;
+#endif
+            val->data.zlib.adler = ip.adler;
+            val->data.zlib.total_out = ip.total_out;
+            if (fread(val->data.zlib.window, ZLIB_WINSIZE, 1, fp) != 1)
+                goto fail;
+            break;
+#endif
+
+        default:
+            goto fail;
+        }
+    }
+    fclose(fp);
+    return TRUE;
+
+fail:
+    fclose(fp);
+    for (i = 0; i < seek->len; i++)
+        g_free(seek->pdata[i]);
+    g_ptr_array_set_size(seek, 0);
+    return FALSE;
+}
+
+/*
+ * Save the seek points for a compressed file that's been read
+ * sequentially all the way to the end.  Failure isn't reported;
+ * the index is just a cache.
+ */
+void
+file_fast_seek_save(FILE_T stream, const char *path, GPtrArray *seek)
+{
+    struct fast_seek_index_header hdr;
+    struct fast_seek_index_point ip;
+    ws_statb64 st;
+    char *index_path, *tmp_path;
+    FILE *fp;
+    guint i;
+
+    if (!fast_seek_index_enabled() || !stream->is_compressed ||
+        !stream->eof || seek->len < 2)
+        return;
+    if (ws_fstat64(stream->fd, &st) == -1)
+        return;
+
+    index_path = ws_strdup_printf("%s" FAST_SEEK_INDEX_SUFFIX, path);
+    tmp_path = ws_strdup_printf("%s.tmp", index_path);
+    fp = ws_fopen(tmp_path, "wb");
+    if (fp == NULL)
+        goto done;
+
+    memset(&hdr, 0, sizeof hdr);
+    memcpy(hdr.magic, FAST_SEEK_INDEX_MAGIC, sizeof hdr.magic);
+    hdr.version = FAST_SEEK_INDEX_VERSION;
+    hdr.bom = FAST_SEEK_INDEX_BOM;
+    hdr.file_size = (guint64)st.st_size;
+    hdr.file_mtime = (gint64)st.st_mtime;
+    hdr.npoints = seek->len;
+    hdr.winsize = ZLIB_WINSIZE;
+    if (fwrite(&hdr, sizeof hdr, 1, fp) != 1)
+        goto fail;
+
+    for (i = 0; i < seek->len; i++) {
+        const struct fast_seek_point *item = (const struct fast_seek_point *)seek->pdata[i];
+
+        memset(&ip, 0, sizeof ip);
+        ip.out = item->out;
+        ip.in = item->in;
+        ip.compression = item->compression;
+#ifdef HAVE_ZLIB
+        if (item->compression == ZLIB) {
+#ifdef HAVE_INFLATEPRIME
+            ip.bits = item->data.zlib.bits;
+#endif
+            ip.adler = item->data.zlib.adler;
+            ip.total_out = item->data.zlib.total_out;
+        }
+#endif
+        if (fwrite(&ip, sizeof ip, 1, fp) != 1)
+            goto fail;
+#ifdef HAVE_ZLIB
+        if (item->compression == ZLIB &&
+            fwrite(item->data.zlib.window, ZLIB_WINSIZE, 1, fp) != 1)
+            goto fail;
+#endif
+    }
+    if (fclose(fp) == 0 && ws_rename(tmp_path, index_path) == 0)
+        goto done;
+    ws_unlink(tmp_path);
+    goto done;
+
+fail:
+    fclose(fp);
+    ws_unlink(tmp_path);
+done:
+    g_free(tmp_path);
+    g_free(index_path);
+}
+
+/*
+ * zstd files can end with a seek table in the zstd "seekable format":
+ * a skippable frame listing the compressed and decompressed size of
+ * each frame, followed by a footer at the very end of the file.
+ * Decompressors skip that frame; we use it to put a seek point at the
+ * start of every frame without having to read the whole file first.
+ * Our zstd writer, and dumpcap when it compresses ring buffer files,
+ * write one.
+ */
+#define ZSTD_SEEKABLE_MAGIC             0x8F92EAB1U
+#define ZSTD_SEEK_TABLE_FRAME_MAGIC     0x184D2A5EU
+#define ZSTD_SEEK_TABLE_FOOTER_SIZE     9
+#define ZSTD_SEEK_TABLE_MAX_FRAMES      0x8000000U
+#define ZSTD_SEEK_TABLE_CHECKSUM_FLAG   0x80
+
+#ifdef HAVE_ZSTD
+/*
+ * Set up seek points from the seek table of a zstd file, if it has a
+ * valid one; stream must not have been read from yet, and seek must be
+ * empty.  Returns TRUE if it was loaded.
+ */
+gboolean
+file_zstd_seek_table_load(FILE_T stream, GPtrArray *seek)
+{
+    static const guint8 zstd_magic[4] = { 0x28, 0xb5, 0x2f, 0xfd };
+    ws_statb64 st;
+    guint8 magic[4];
+    guint8 footer[ZSTD_SEEK_TABLE_FOOTER_SIZE];
+    guint8 *table = NULL, *entry;
+    guint32 nframes, entry_size, i;
+    gint64 table_size, in = 0, out = 0;
+    gboolean ok = FALSE;
+
+    if (seek->len != 0 || stream->raw_pos != 0)
+        return FALSE;
+    if (ws_fstat64(stream->fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+        st.st_size < (gint64)sizeof magic + 8 + ZSTD_SEEK_TABLE_FOOTER_SIZE)
+        return FALSE;
+
+    if (ws_read(stream->fd, magic, sizeof magic) != (ssize_t)sizeof magic ||
+        memcmp(magic, zstd_magic, sizeof magic) != 0)
+        goto done;
+    if (ws_lseek64(stream->fd, st.st_size - ZSTD_SEEK_TABLE_FOOTER_SIZE, SEEK_SET) == -1 ||
+        ws_read(stream->fd, footer, sizeof footer) != (ssize_t)sizeof footer ||
+        pletoh32(&footer[5]) != ZSTD_SEEKABLE_MAGIC)
+        goto done;
+
+    nframes = pletoh32(&footer[0]);
+    entry_size = (footer[4] & ZSTD_SEEK_TABLE_CHECKSUM_FLAG) ? 12 : 8;
+    if (nframes == 0 || nframes > ZSTD_SEEK_TABLE_MAX_FRAMES)
+        goto done;
+    table_size = 8 + (gint64)nframes * entry_size + ZSTD_SEEK_TABLE_FOOTER_SIZE;
+    if (table_size > st.st_size)
+        goto done;
+
+    table = (guint8 *)g_try_malloc((gsize)table_size);
+    if (table == NULL ||
+        ws_lseek64(stream->fd, st.st_size - table_size, SEEK_SET) == -1 ||
+        ws_read(stream->fd, table, (unsigned int)table_size) != (ssize_t)table_size ||
+        pletoh32(&table[0]) != ZSTD_SEEK_TABLE_FRAME_MAGIC ||
+        pletoh32(&table[4]) != (guint32)(table_size - 8))
+        goto done;
+
+    for (i = 0, entry = table + 8; i < nframes; i++, entry += entry_size) {
+        guint32 compressed_size = pletoh32(&entry[0]);
+        guint32 decompressed_size = pletoh32(&entry[4]);
+
+        if (compressed_size == 0)
+            break;
+        /* Frames that decompress to nothing can't be seeked to. */
+        if (decompressed_size != 0) {
+            struct fast_seek_point *val = g_new(struct fast_seek_point, 1);
+
+            val->in = in;
+            val->out = out;
+            val->compression = ZSTD;
+            g_ptr_array_add(seek, val);
+        }
+        in += compressed_size;
+        out += decompressed_size;
+    }
+    /* The frames have to account for everything before the table. */
+    if (i == nframes && in == st.st_size - table_size)
+        ok = TRUE;
+
+done:
+    g_free(table);
+    if (!ok) {
+        for (i = 0; i < seek->len; i++)
+            g_free(seek->pdata[i]);
+        g_ptr_array_set_size(seek, 0);
+    }
+    if (ws_lseek64(stream->fd, 0, SEEK_SET) == -1) {
+        /* We can't read the file from the start; let that be noticed then. */
+        stream->err = errno;
+        stream->err_info = NULL;
+    }
+    return ok;
+}
+#else
+gboolean
+file_zstd_seek_table_load(FILE_T stream _U_, GPtrArray *seek _U_)
+{
+    return FALSE;
+}
+#endif
+
 #ifdef HAVE_ZLIB
 
 /* Get next byte from input, or -1 if end or error.
@@ -657,42 +1291,361 @@ DIAG_ON(cast-qual)
                 cur->have = ZLIB_WINSIZE;
             }
 
-            if (cur->have >= ZLIB_WINSIZE && ret != Z_STREAM_END && (strm->data_type & 128) && !(strm->data_type & 64))
-                zlib_fast_seek_add(state, cur, (strm->data_type & 7), state->raw_pos - strm->avail_in, state->pos + (count - strm->avail_out));
+            if (cur->have >= ZLIB_WINSIZE && ret != Z_STREAM_END && (strm->data_type & 128) && !(strm->data_type & 64))
+                zlib_fast_seek_add(state, cur, (strm->data_type & 7), state->raw_pos - strm->avail_in, state->pos + (count - strm->avail_out));
+        }
+#endif
+        buf2 = (buf2 + count2 - strm->avail_out);
+        count2 = strm->avail_out;
+
+    } while (strm->avail_out && ret != Z_STREAM_END);
+
+    /* update available output and crc check value */
+    state->out.next = buf;
+    state->out.avail = count - strm->avail_out;
+
+    /* Check gzip trailer if at end of deflate stream.
+       We don't fail immediately here, we just set an error
+       indication, so that we try to process what data we
+       got before the error.  The next attempt to read
+       something past that data will get the error. */
+    if (ret == Z_STREAM_END) {
+        if (gz_next4(state, &crc) != -1 &&
+            gz_next4(state, &len) != -1) {
+            if (crc != strm->adler && !state->dont_check_crc) {
+                state->err = WTAP_ERR_DECOMPRESS;
+                state->err_info = "bad CRC";
+            } else if (len != (strm->total_out & 0xffffffffUL)) {
+                state->err = WTAP_ERR_DECOMPRESS;
+                state->err_info = "length field wrong";
+            }
+        }
+        state->last_compression = state->compression;
+        state->compression = UNKNOWN;      /* ready for next stream, once have is 0 */
+        g_free(state->fast_seek_cur);
+        state->fast_seek_cur = NULL;
+    }
+}
+#endif
+
+#ifdef HAVE_ZSTD
+/*
+ * Parallel decompression of zstd files made of many independent frames,
+ * such as the ones we write (see zstdwfile_write()).
+ *
+ * When reading such a file sequentially, we read the compressed data
+ * ourselves, split it into frames, and hand each frame to a worker
+ * thread to decompress into a buffer of its own.  The frames are
+ * queued in file order, so the reader just copies out of the frame at
+ * the head of the queue, while up to ZSTD_RA_JOBS_PER_THREAD frames
+ * per thread are being decompressed ahead of it.
+ *
+ * All files share one pool of as many threads as there are processors,
+ * so reading several files at once, as mergecap does, doesn't start a
+ * set of threads for each of them.
+ *
+ * This is only done for regular files that aren't being used for
+ * random access, and only for frames that record their decompressed
+ * size and aren't too large.  Once we see a frame that doesn't qualify,
+ * we seek back to it and go back to streaming decompression for the
+ * rest of the file.
+ */
+#define ZSTD_RA_MAX_FRAME_SIZE  (64U << 20)
+#define ZSTD_RA_READ_SIZE       (1U << 20)
+#define ZSTD_RA_JOBS_PER_THREAD 2
+
+struct zstd_ra_job {
+    struct zstd_readahead *ra;  /* file it's for */
+    guint8 *src;                /* compressed frame */
+    size_t src_len;
+    guint8 *dst;                /* decompressed frame */
+    size_t dst_len;
+    size_t result;              /* ZSTD_decompressDCtx() return value */
+    gboolean done;              /* TRUE once a worker has finished it */
+};
+
+struct zstd_readahead {
+    GMutex mutex;
+    GCond cond;
+    GQueue jobs;                /* queued jobs, in file order */
+    guint pending;              /* jobs pushed to the pool and not done */
+    guint max_jobs;             /* maximum number of queued jobs */
+    struct zstd_ra_job *cur;    /* job we're handing data out from */
+    size_t cur_off;             /* offset of next byte to hand out */
+
+    guint8 *in;                 /* compressed data read but not queued */
+    size_t in_len;
+    size_t in_size;
+    gint64 raw_off;             /* file offset of in[0] */
+    gint64 out_off;             /* uncompressed offset of in[0] */
+    gboolean in_eof;            /* TRUE if we've read everything */
+    gboolean done;              /* TRUE if no more frames will be queued */
+};
+
+static GThreadPool *zstd_ra_pool;
+static guint zstd_ra_threads;
+
+/* One decompression context per worker thread */
+static void
+zstd_ra_dctx_free(gpointer p)
+{
+    ZSTD_freeDCtx((ZSTD_DCtx *)p);
+}
+
+static GPrivate zstd_ra_dctx = G_PRIVATE_INIT(zstd_ra_dctx_free);
+
+static void
+zstd_ra_job_free(struct zstd_ra_job *job)
+{
+    g_free(job->src);
+    g_free(job->dst);
+    g_free(job);
+}
+
+static void
+zstd_ra_worker(gpointer data, gpointer user_data _U_)
+{
+    struct zstd_ra_job *job = (struct zstd_ra_job *)data;
+    struct zstd_readahead *ra = job->ra;
+    ZSTD_DCtx *dctx = (ZSTD_DCtx *)g_private_get(&zstd_ra_dctx);
+
+    if (dctx == NULL) {
+        dctx = ZSTD_createDCtx();
+        g_private_set(&zstd_ra_dctx, dctx);
+    }
+    if (dctx != NULL)
+        job->result = ZSTD_decompressDCtx(dctx, job->dst, job->dst_len,
+                                          job->src, job->src_len);
+    else
+        job->result = (size_t)-1;  /* ZSTD_isError() is TRUE for that */
+
+    /* Once we've unlocked, the file may be closed; don't touch ra. */
+    g_mutex_lock(&ra->mutex);
+    job->done = TRUE;
+    ra->pending--;
+    g_cond_broadcast(&ra->cond);
+    g_mutex_unlock(&ra->mutex);
+}
+
+/*
+ * Get the pool shared by all files, creating it the first time.
+ * Returns NULL if there's no point, or it can't be created.
+ */
+static GThreadPool *
+zstd_ra_get_pool(void)
+{
+    static gsize initialized;
+
+    if (g_once_init_enter(&initialized)) {
+        zstd_ra_threads = g_get_num_processors();
+        if (zstd_ra_threads >= 2)
+            zstd_ra_pool = g_thread_pool_new(zstd_ra_worker, NULL,
+                                             zstd_ra_threads, FALSE, NULL);
+        g_once_init_leave(&initialized, 1);
+    }
+    return zstd_ra_pool;
+}
+
+/* Wait for all queued jobs and free everything. */
+static void
+zstd_ra_free(FILE_T state)
+{
+    struct zstd_readahead *ra = state->zstd_ra;
+    struct zstd_ra_job *job;
+
+    if (ra == NULL)
+        return;
+    g_mutex_lock(&ra->mutex);
+    while (ra->pending != 0)
+        g_cond_wait(&ra->cond, &ra->mutex);
+    g_mutex_unlock(&ra->mutex);
+    while ((job = (struct zstd_ra_job *)g_queue_pop_head(&ra->jobs)) != NULL)
+        zstd_ra_job_free(job);
+    if (ra->cur != NULL)
+        zstd_ra_job_free(ra->cur);
+    g_mutex_clear(&ra->mutex);
+    g_cond_clear(&ra->cond);
+    g_free(ra->in);
+    g_free(ra);
+    state->zstd_ra = NULL;
+}
+
+/*
+ * Start parallel decompression at the zstd frame that begins
+ * at the current input position, if we can.
+ */
+static gboolean
+zstd_ra_start(FILE_T state)
+{
+    struct zstd_readahead *ra;
+    gint64 raw_off;
+
+    if (state->zstd_ra_disabled || state->random_access)
+        return FALSE;
+    if (zstd_ra_get_pool() == NULL)
+        return FALSE;
+
+    /* We need to be able to seek back if we have to give up. */
+    raw_off = state->raw_pos - state->in.avail;
+    if (ws_lseek64(state->fd, raw_off, SEEK_SET) == -1)
+        return FALSE;
+
+    ra = g_new0(struct zstd_readahead, 1);
+    g_mutex_init(&ra->mutex);
+    g_cond_init(&ra->cond);
+    g_queue_init(&ra->jobs);
+    ra->max_jobs = zstd_ra_threads * ZSTD_RA_JOBS_PER_THREAD;
+    ra->raw_off = raw_off;
+    ra->out_off = state->pos;
+
+    state->raw_pos = raw_off;
+    buf_reset(&state->in);
+    state->zstd_ra = ra;
+    return TRUE;
+}
+
+/*
+ * Queue the next frame for decompression, reading more input if
+ * necessary.  Returns -1 on a read error; otherwise sets ra->done
+ * if there's nothing more to queue.
+ */
+static int
+zstd_ra_queue_frame(FILE_T state)
+{
+    struct zstd_readahead *ra = state->zstd_ra;
+    struct zstd_ra_job *job;
+    size_t frame_len;
+    unsigned long long content_len;
+
+    for (;;) {
+        if (ra->in_len != 0) {
+            frame_len = ZSTD_findFrameCompressedSize(ra->in, ra->in_len);
+            if (!ZSTD_isError(frame_len))
+                break;
+        }
+        if (ra->in_eof || ra->in_len >= ZSTD_RA_MAX_FRAME_SIZE) {
+            /* End of file, or something we can't do in parallel. */
+            ra->done = TRUE;
+            return 0;
+        }
+        if (ra->in_size - ra->in_len < ZSTD_RA_READ_SIZE) {
+            ra->in_size = ra->in_len + ZSTD_RA_READ_SIZE;
+            ra->in = (guint8 *)g_realloc(ra->in, ra->in_size);
+        }
+        ssize_t ret = ws_read(state->fd, ra->in + ra->in_len, ZSTD_RA_READ_SIZE);
+        if (ret < 0) {
+            state->err = errno;
+            state->err_info = NULL;
+            return -1;
+        }
+        if (ret == 0)
+            ra->in_eof = TRUE;
+        ra->in_len += ret;
+        state->raw_pos += ret;
+        ws_perf_add(WS_PERF_BYTES_READ, ret);
+    }
+
+    content_len = ZSTD_getFrameContentSize(ra->in, frame_len);
+    if (content_len == ZSTD_CONTENTSIZE_UNKNOWN ||
+        content_len == ZSTD_CONTENTSIZE_ERROR ||
+        content_len > ZSTD_RA_MAX_FRAME_SIZE) {
+        ra->done = TRUE;
+        return 0;
+    }
+
+    if (state->fast_seek && content_len != 0)
+        fast_seek_header(state, ra->raw_off, ra->out_off, ZSTD);
+
+    job = g_new0(struct zstd_ra_job, 1);
+    job->ra = ra;
+    job->src = (guint8 *)g_memdup2(ra->in, frame_len);
+    job->src_len = frame_len;
+    job->dst_len = (size_t)content_len;
+    job->dst = (guint8 *)g_malloc(job->dst_len != 0 ? job->dst_len : 1);
+    g_queue_push_tail(&ra->jobs, job);
+    g_mutex_lock(&ra->mutex);
+    ra->pending++;
+    g_mutex_unlock(&ra->mutex);
+    g_thread_pool_push(zstd_ra_pool, job, NULL);
+
+    ra->in_len -= frame_len;
+    memmove(ra->in, ra->in + frame_len, ra->in_len);
+    ra->raw_off += frame_len;
+    ra->out_off += content_len;
+    return 0;
+}
+
+/*
+ * Fill the output buffer from the decompressed frames.  When there are
+ * no more frames that we can decompress in parallel, either finish up
+ * at the end of the file or go back to decompressing the rest of it
+ * the usual way.
+ */
+static int
+zstd_ra_fill(FILE_T state)
+{
+    struct zstd_readahead *ra = state->zstd_ra;
+    struct zstd_ra_job *job;
+    size_t n;
+
+    for (;;) {
+        if (ra->cur != NULL) {
+            if (ra->cur_off < ra->cur->dst_len) {
+                n = ra->cur->dst_len - ra->cur_off;
+                if (n > (state->size << 1))
+                    n = state->size << 1;
+                memcpy(state->out.buf, ra->cur->dst + ra->cur_off, n);
+                state->out.next = state->out.buf;
+                state->out.avail = (guint)n;
+                ra->cur_off += n;
+                return 0;
+            }
+            zstd_ra_job_free(ra->cur);
+            ra->cur = NULL;
         }
-#endif
-        buf2 = (buf2 + count2 - strm->avail_out);
-        count2 = strm->avail_out;
 
-    } while (strm->avail_out && ret != Z_STREAM_END);
+        while (!ra->done && g_queue_get_length(&ra->jobs) < ra->max_jobs) {
+            if (zstd_ra_queue_frame(state) == -1)
+                return -1;
+        }
 
-    /* update available output and crc check value */
-    state->out.next = buf;
-    state->out.avail = count - strm->avail_out;
+        job = (struct zstd_ra_job *)g_queue_pop_head(&ra->jobs);
+        if (job == NULL)
+            break;
+        g_mutex_lock(&ra->mutex);
+        while (!job->done)
+            g_cond_wait(&ra->cond, &ra->mutex);
+        g_mutex_unlock(&ra->mutex);
+        if (ZSTD_isError(job->result) || job->result != job->dst_len) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = ZSTD_isError(job->result) ?
+                ZSTD_getErrorName(job->result) : "zstd frame size mismatch";
+            zstd_ra_job_free(job);
+            return -1;
+        }
+        ra->cur = job;
+        ra->cur_off = 0;
+    }
 
-    /* Check gzip trailer if at end of deflate stream.
-       We don't fail immediately here, we just set an error
-       indication, so that we try to process what data we
-       got before the error.  The next attempt to read
-       something past that data will get the error. */
-    if (ret == Z_STREAM_END) {
-        if (gz_next4(state, &crc) != -1 &&
-            gz_next4(state, &len) != -1) {
-            if (crc != strm->adler && !state->dont_check_crc) {
-                state->err = WTAP_ERR_DECOMPRESS;
-                state->err_info = "bad CRC";
-            } else if (len != (strm->total_out & 0xffffffffUL)) {
-                state->err = WTAP_ERR_DECOMPRESS;
-                state->err_info = "length field wrong";
-            }
+    /* Everything we queued has been handed out. */
+    if (ra->in_eof && ra->in_len == 0) {
+        state->eof = TRUE;
+    } else {
+        /* Resume with ordinary decompression at the leftover data. */
+        if (ws_lseek64(state->fd, ra->raw_off, SEEK_SET) == -1) {
+            state->err = errno;
+            state->err_info = NULL;
+            return -1;
         }
+        state->raw_pos = ra->raw_off;
         state->last_compression = state->compression;
-        state->compression = UNKNOWN;      /* ready for next stream, once have is 0 */
-        g_free(state->fast_seek_cur);
-        state->fast_seek_cur = NULL;
+        state->compression = UNKNOWN;
+        state->zstd_ra_disabled = TRUE;
     }
+    zstd_ra_free(state);
+    return 0;
 }
-#endif
+#endif /* HAVE_ZSTD */
 
 static int
 gz_head(FILE_T state)
@@ -861,9 +1814,21 @@ gz_head(FILE_T state)
     /* FD 37 7A 58 5A 00 */
 #endif
 
+    /*
+     * After the end of a frame, the next one may start anywhere in the
+     * input buffer, and not all of its magic number may have been
+     * read yet.
+     */
+    if (state->in.avail < 4) {
+        memmove(state->in.buf, state->in.next, state->in.avail);
+        state->in.next = state->in.buf;
+        if (fill_in_buffer(state) == -1)
+            return -1;
+    }
+
     if (state->in.avail >= 4
-        && state->in.buf[0] == 0x28 && state->in.buf[1] == 0xb5
-        && state->in.buf[2] == 0x2f && state->in.buf[3] == 0xfd) {
+        && state->in.next[0] == 0x28 && state->in.next[1] == 0xb5
+        && state->in.next[2] == 0x2f && state->in.next[3] == 0xfd) {
 #ifdef HAVE_ZSTD
         const size_t ret = ZSTD_initDStream(state->zstd_dctx);
         if (ZSTD_isError(ret)) {
@@ -874,6 +1839,10 @@ gz_head(FILE_T state)
 
         state->compression = ZSTD;
         state->is_compressed = TRUE;
+        if (zstd_ra_start(state))
+            return 0;
+        if (state->fast_seek)
+            fast_seek_header(state, state->raw_pos - state->in.avail, state->pos, ZSTD);
         return 0;
 #else
         state->err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
@@ -883,8 +1852,8 @@ gz_head(FILE_T state)
     }
 
     if (state->in.avail >= 4
-        && state->in.buf[0] == 0x04 && state->in.buf[1] == 0x22
-        && state->in.buf[2] == 0x4d && state->in.buf[3] == 0x18) {
+        && state->in.next[0] == 0x04 && state->in.next[1] == 0x22
+        && state->in.next[2] == 0x4d && state->in.next[3] == 0x18) {
 #ifdef USE_LZ4
 #if LZ4_VERSION_NUMBER >= 10800
         LZ4F_resetDecompressionContext(state->lz4_dctx);
@@ -897,6 +1866,8 @@ gz_head(FILE_T state)
             return -1;
         }
 #endif
+        if (state->fast_seek)
+            fast_seek_header(state, state->raw_pos - state->in.avail, state->pos, LZ4);
         state->compression = LZ4;
         state->is_compressed = TRUE;
         return 0;
@@ -918,6 +1889,22 @@ gz_head(FILE_T state)
     /* not a compressed file -- copy everything we've read into the
        input buffer to the output buffer and fall to raw i/o */
     already_read = bytes_in_buffer(&state->in);
+#ifdef HAVE_SYS_MMAN_H
+    if (state->map != NULL && !state->is_compressed) {
+        /* The data is all in the mapping; back up to where we
+           started reading and hand it out from there instead. */
+        if (!state->out_is_mapped) {
+            g_free(state->out.buf);
+            state->out_is_mapped = TRUE;
+        }
+        state->raw_pos -= already_read;
+        state->out.buf = state->map + state->raw_pos;
+        buf_reset(&state->out);
+        buf_reset(&state->in);
+        state->compression = UNCOMPRESSED;
+        return 0;
+    }
+#endif
     if (already_read != 0) {
         memcpy(state->out.buf, state->in.buf, already_read);
         state->out.avail = already_read;
@@ -932,6 +1919,8 @@ gz_head(FILE_T state)
 static int /* gz_make */
 fill_out_buffer(FILE_T state)
 {
+    gboolean decompressed = TRUE;
+
     if (state->compression == UNKNOWN) {          /* look for compression header */
         if (gz_head(state) == -1)
             return -1;
@@ -939,8 +1928,22 @@ fill_out_buffer(FILE_T state)
             return 0;
     }
     if (state->compression == UNCOMPRESSED) {           /* straight copy */
+#ifdef HAVE_SYS_MMAN_H
+        if (state->out_is_mapped) {
+            if (file_map_check(state) == -1)
+                return -1;
+            if (map_window(state, state->raw_pos))
+                return 0;
+            /* Past the end of the mapping; the file may have grown. */
+            ws_debug("reached end of mapping at %" PRId64 ", reading file instead",
+                state->raw_pos);
+            if (file_unmap(state) == -1)
+                return -1;
+        }
+#endif
         if (buf_read(state, &state->out) < 0)
             return -1;
+        decompressed = FALSE;
     }
 #ifdef HAVE_ZLIB
     else if (state->compression == ZLIB) {      /* decompress */
@@ -948,6 +1951,12 @@ fill_out_buffer(FILE_T state)
     }
 #endif
 #ifdef HAVE_ZSTD
+    else if (state->compression == ZSTD && state->zstd_ra != NULL) {
+        ws_assert(state->out.avail == 0);
+
+        if (zstd_ra_fill(state) == -1)
+            return -1;
+    }
     else if (state->compression == ZSTD) {
         ws_assert(state->out.avail == 0);
 
@@ -1007,6 +2016,8 @@ fill_out_buffer(FILE_T state)
         }
     }
 #endif
+    if (decompressed)
+        ws_perf_add(WS_PERF_BYTES_DECOMPRESSED, state->out.avail);
     return 0;
 }
 
@@ -1049,6 +2060,9 @@ gz_skip(FILE_T state, gint64 len)
 static void
 gz_reset(FILE_T state)
 {
+#ifdef HAVE_ZSTD
+    zstd_ra_free(state);
+#endif
     buf_reset(&state->out);       /* no output data available */
     state->eof = FALSE;           /* not at end of file */
     state->compression = UNKNOWN; /* look for compression header */
@@ -1264,6 +2278,10 @@ file_open(const char *path)
         return NULL;
     }
 
+#ifdef HAVE_SYS_MMAN_H
+    file_map(ft);
+#endif
+
 #ifdef HAVE_ZLIB
     /*
      * If this file's name ends in ".caz", it's probably a compressed
@@ -1288,10 +2306,26 @@ file_open(const char *path)
     return ft;
 }
 
+/*
+ * Read what's most recently been written to the file from ring, if it's
+ * still there, rather than from the file.
+ */
+void
+file_set_live_ring(FILE_T stream, ws_shm_ring *ring)
+{
+    ws_shm_ring_close(stream->live_ring);
+    stream->live_ring = ring;
+}
+
 void
-file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
+file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArray *seek)
 {
     stream->fast_seek = seek;
+    stream->random_access = random_flag;
+#ifdef HAVE_SYS_MMAN_H
+    if (random_flag && stream->map != NULL)
+        posix_madvise(stream->map, (size_t)stream->map_size, POSIX_MADV_RANDOM);
+#endif
 }
 
 gint64
@@ -1429,11 +2463,24 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             off2 = here->out;
         } else
 #endif
+        if (here->compression == ZSTD || here->compression == LZ4) {
+            /* Start of a frame; decompress forward from there. */
+            off = here->in;
+            off2 = here->out;
+        } else
         {
             off2 = (file->pos + offset);
             off = here->in + (off2 - here->out);
         }
 
+#ifdef HAVE_ZSTD
+        zstd_ra_free(file);
+#endif
+#ifdef HAVE_SYS_MMAN_H
+        /* Nothing to do for the file descriptor if we're reading from a
+           mapping; just start the next window at the new offset. */
+        if (!file->out_is_mapped || here->compression != UNCOMPRESSED)
+#endif
         if (ws_lseek64(file->fd, off, SEEK_SET) == -1) {
             *err = errno;
             return -1;
@@ -1480,6 +2527,30 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             strm->adler = crc32(0L, Z_NULL, 0);
             file->compression = ZLIB;
         } else
+#endif
+#ifdef HAVE_ZSTD
+        if (here->compression == ZSTD) {
+            const size_t ret = ZSTD_initDStream(file->zstd_dctx);
+            if (ZSTD_isError(ret)) {
+                *err = WTAP_ERR_DECOMPRESS;
+                return -1;
+            }
+            file->compression = ZSTD;
+        } else
+#endif
+#ifdef USE_LZ4
+        if (here->compression == LZ4) {
+#if LZ4_VERSION_NUMBER >= 10800
+            LZ4F_resetDecompressionContext(file->lz4_dctx);
+#else
+            LZ4F_freeDecompressionContext(file->lz4_dctx);
+            if (LZ4F_isError(LZ4F_createDecompressionContext(&file->lz4_dctx, LZ4F_VERSION))) {
+                *err = WTAP_ERR_INTERNAL;
+                return -1;
+            }
+#endif
+            file->compression = LZ4;
+        } else
 #endif
             file->compression = here->compression;
 
@@ -1514,6 +2585,9 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         /*
          * Yes.  Just seek there within the file.
          */
+#ifdef HAVE_SYS_MMAN_H
+        if (!file->out_is_mapped)
+#endif
         if (ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
             *err = errno;
             return -1;
@@ -1703,6 +2777,62 @@ file_read(void *buf, unsigned int len, FILE_T file)
     return (int)got;
 }
 
+/*
+ * If we're reading an uncompressed file through a memory mapping, and
+ * the next count bytes are all in the mapping, return a pointer to them
+ * and advance past them; otherwise return NULL without reading
+ * anything, in which case the caller should use file_read().
+ *
+ * The pointer remains valid until the file is closed, even if we stop
+ * reading through the mapping in the meantime.  The mapping is
+ * read-only; the data must be copied before it's modified.
+ */
+const guint8 *
+#ifdef HAVE_SYS_MMAN_H
+file_read_mapped(FILE_T file, unsigned int count)
+#else
+file_read_mapped(FILE_T file _U_, unsigned int count _U_)
+#endif
+{
+#ifdef HAVE_SYS_MMAN_H
+    const guint8 *ptr;
+    gint64 raw_off;
+
+    if (!file->out_is_mapped || file->err != 0 || count == 0)
+        return NULL;
+    if (file_map_check(file) == -1)
+        return NULL;
+
+    /* process a skip request */
+    if (file->seek_pending) {
+        file->seek_pending = FALSE;
+        if (gz_skip(file, file->skip) == -1)
+            return NULL;
+        if (!file->out_is_mapped)
+            return NULL;
+    }
+
+    raw_off = file->raw_pos - file->out.avail;
+    if ((guint64)count > (guint64)(file->map_size - raw_off))
+        return NULL;
+    ptr = file->map + raw_off;
+    if (count <= file->out.avail) {
+        file->out.next += count;
+        file->out.avail -= count;
+    } else {
+        /* Runs past the current window; the next window starts
+           after the data. */
+        file->out.buf = file->map + raw_off + count;
+        buf_reset(&file->out);
+        file->raw_pos = raw_off + count;
+    }
+    file->pos += count;
+    return ptr;
+#else
+    return NULL;
+#endif
+}
+
 /*
  * XXX - this *peeks* at next byte, not a character.
  */
@@ -1897,6 +3027,14 @@ file_fdreopen(FILE_T file, const char *path)
     if ((fd = ws_open(path, O_RDONLY|O_BINARY, 0000)) == -1)
         return FALSE;
     file->fd = fd;
+    /* Seeks can be relative, so pick up where the old descriptor was. */
+    if (ws_lseek64(fd, file->raw_pos, SEEK_SET) == -1)
+        return FALSE;
+#ifdef HAVE_SYS_MMAN_H
+    /* The mapping is of the old file; read the new one normally. */
+    if (file_unmap(file) == -1)
+        return FALSE;
+#endif
     return TRUE;
 }
 
@@ -1906,6 +3044,9 @@ file_close(FILE_T file)
     int fd = file->fd;
 
     /* free memory and close file */
+#ifdef HAVE_ZSTD
+    zstd_ra_free(file);
+#endif
     if (file->size) {
 #ifdef HAVE_ZLIB
         inflateEnd(&(file->strm));
@@ -1915,11 +3056,25 @@ file_close(FILE_T file)
 #endif
 #ifdef USE_LZ4
         LZ4F_freeDecompressionContext(file->lz4_dctx);
+#endif
+#ifdef HAVE_SYS_MMAN_H
+        if (!file->out_is_mapped)
 #endif
         g_free(file->out.buf);
         g_free(file->in.buf);
     }
+#ifdef HAVE_SYS_MMAN_H
+    if (file->map != NULL) {
+        file_map_unregister(file->map_slot);
+        munmap(file->map, (size_t)file->map_size);
+    }
+    if (file->retired_map != NULL) {
+        file_map_unregister(file->retired_map_slot);
+        munmap(file->retired_map, (size_t)file->retired_map_size);
+    }
+#endif
     g_free(file->fast_seek_cur);
+    ws_shm_ring_close(file->live_ring);
     file->err = 0;
     file->err_info = NULL;
     g_free(file);
@@ -2221,6 +3376,246 @@ gzwfile_geterr(GZWFILE_T state)
 }
 #endif
 
+#ifdef HAVE_ZSTD
+/*
+ * zstd file writing.
+ *
+ * Rather than writing one big frame, we compress every ZSTD_WFRAME_SIZE
+ * bytes of data as a separate frame that records its decompressed size.
+ * That costs very little compression, but the frames can be found and
+ * decompressed independently, so readers can seek to the start of any
+ * of them, and can decompress several of them at once.  When the file
+ * is closed, a seek table listing the frames is written at the end, so
+ * readers can find them without reading the file first.
+ */
+#define ZSTD_WFRAME_SIZE (1U << 20)
+
+struct zstd_writer {
+    int fd;                 /* file descriptor */
+    ZSTD_CCtx *cctx;        /* compression context */
+    int level;              /* compression level */
+    guint8 *in;             /* data not yet compressed */
+    guint in_len;
+    guint8 *out;            /* compressed frame */
+    size_t out_size;
+    GArray *frames;         /* compressed and decompressed size of each frame, for the seek table */
+    int err;                /* error code */
+};
+
+ZSTDWFILE_T
+zstdwfile_open(const char *path)
+{
+    int fd;
+    ZSTDWFILE_T state;
+    int save_errno;
+
+    fd = ws_open(path, O_BINARY|O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd == -1)
+        return NULL;
+    state = zstdwfile_fdopen(fd);
+    if (state == NULL) {
+        save_errno = errno;
+        ws_close(fd);
+        errno = save_errno;
+    }
+    return state;
+}
+
+ZSTDWFILE_T
+zstdwfile_fdopen(int fd)
+{
+    ZSTDWFILE_T state;
+
+    state = (ZSTDWFILE_T)g_try_malloc0(sizeof *state);
+    if (state == NULL)
+        return NULL;
+    state->fd = fd;
+    state->level = 3;       /* ZSTD_CLEVEL_DEFAULT */
+    state->cctx = ZSTD_createCCtx();
+    state->in = (guint8 *)g_try_malloc(ZSTD_WFRAME_SIZE);
+    state->out_size = ZSTD_compressBound(ZSTD_WFRAME_SIZE);
+    state->out = (guint8 *)g_try_malloc(state->out_size);
+    state->frames = g_array_new(FALSE, FALSE, sizeof(guint32));
+    if (state->cctx == NULL || state->in == NULL || state->out == NULL) {
+        g_array_free(state->frames, TRUE);
+        ZSTD_freeCCtx(state->cctx);
+        g_free(state->in);
+        g_free(state->out);
+        g_free(state);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return state;
+}
+
+/* Write out a compressed frame, and note it in the seek table.  Return
+   -1, and set state->err, on failure; return 0 on success. */
+static int
+zstd_wput(ZSTDWFILE_T state, const guint8 *frame, guint len,
+          guint decompressed_len)
+{
+    ssize_t got;
+
+    got = ws_write(state->fd, frame, len);
+    if (got < 0) {
+        state->err = errno;
+        return -1;
+    }
+    if ((guint)got != len) {
+        state->err = WTAP_ERR_SHORT_WRITE;
+        return -1;
+    }
+    if (state->frames != NULL) {
+        guint32 sizes[2] = { len, decompressed_len };
+
+        g_array_append_vals(state->frames, sizes, 2);
+        if (state->frames->len / 2 >= ZSTD_SEEK_TABLE_MAX_FRAMES) {
+            /* Too many frames for a seek table; don't bother. */
+            g_array_free(state->frames, TRUE);
+            state->frames = NULL;
+        }
+    }
+    return 0;
+}
+
+/* Compress whatever's buffered as one frame and write it out.  Return -1,
+   and set state->err, on failure; return 0 on success. */
+static int
+zstd_wframe(ZSTDWFILE_T state)
+{
+    size_t ret;
+
+    if (state->in_len == 0)
+        return 0;
+    ret = ZSTD_compressCCtx(state->cctx, state->out, state->out_size,
+                            state->in, state->in_len, state->level);
+    if (ZSTD_isError(ret)) {
+        state->err = WTAP_ERR_INTERNAL;
+        return -1;
+    }
+    if (zstd_wput(state, state->out, (guint)ret, state->in_len) == -1)
+        return -1;
+    state->in_len = 0;
+    return 0;
+}
+
+/* Write the seek table.  Return -1, and set state->err, on failure;
+   return 0 on success. */
+static int
+zstd_wseek_table(ZSTDWFILE_T state)
+{
+    guint nframes = state->frames->len / 2;
+    gsize table_size = 8 + (gsize)nframes * 8 + ZSTD_SEEK_TABLE_FOOTER_SIZE;
+    guint8 *table, *p;
+    ssize_t got;
+    guint i;
+
+    if (nframes == 0)
+        return 0;
+    table = (guint8 *)g_malloc(table_size);
+    phtole32(&table[0], ZSTD_SEEK_TABLE_FRAME_MAGIC);
+    phtole32(&table[4], (guint32)(table_size - 8));
+    for (i = 0, p = table + 8; i < nframes; i++, p += 8) {
+        phtole32(&p[0], g_array_index(state->frames, guint32, 2 * i));
+        phtole32(&p[4], g_array_index(state->frames, guint32, 2 * i + 1));
+    }
+    phtole32(&p[0], nframes);
+    p[4] = 0;               /* no checksums */
+    phtole32(&p[5], ZSTD_SEEKABLE_MAGIC);
+
+    got = ws_write(state->fd, table, (unsigned int)table_size);
+    g_free(table);
+    if (got < 0) {
+        state->err = errno;
+        return -1;
+    }
+    if ((size_t)got != table_size) {
+        state->err = WTAP_ERR_SHORT_WRITE;
+        return -1;
+    }
+    return 0;
+}
+
+/* Write out len bytes from buf.  Return 0, and set state->err, on
+   failure; return the number of bytes written on success. */
+guint
+zstdwfile_write(ZSTDWFILE_T state, const void *buf, guint len)
+{
+    guint put = len;
+    guint n;
+
+    if (state->err != 0 || len == 0)
+        return 0;
+
+    while (len != 0) {
+        n = ZSTD_WFRAME_SIZE - state->in_len;
+        if (n > len)
+            n = len;
+        memcpy(state->in + state->in_len, buf, n);
+        state->in_len += n;
+        buf = (const guint8 *)buf + n;
+        len -= n;
+        if (state->in_len == ZSTD_WFRAME_SIZE && zstd_wframe(state) == -1)
+            return 0;
+    }
+    return put;
+}
+
+/* Write out a complete zstd frame that was compressed elsewhere, say on
+   another thread, after ending the current frame; decompressed_len is
+   the size of the data in it, for the seek table.  Returns 0 on success,
+   -1 on failure. */
+int
+zstdwfile_write_frame(ZSTDWFILE_T state, const void *frame, guint len,
+                      guint decompressed_len)
+{
+    if (state->err != 0 || zstd_wframe(state) == -1)
+        return -1;
+    return zstd_wput(state, (const guint8 *)frame, len, decompressed_len);
+}
+
+/* Write out everything buffered so far, ending the current frame.
+   Returns 0 on success, -1 on failure. */
+int
+zstdwfile_flush(ZSTDWFILE_T state)
+{
+    if (state->err != 0)
+        return -1;
+    return zstd_wframe(state);
+}
+
+/* Flush out all data written, and close the file.  Returns a Wiretap
+   error on failure; returns 0 on success. */
+int
+zstdwfile_close(ZSTDWFILE_T state)
+{
+    int ret = 0;
+
+    if (state->err == 0 && zstd_wframe(state) == -1)
+        ret = state->err;
+    else if (state->err == 0 && state->frames != NULL &&
+             zstd_wseek_table(state) == -1)
+        ret = state->err;
+    else if (state->err != 0)
+        ret = state->err;
+    if (state->frames != NULL)
+        g_array_free(state->frames, TRUE);
+    ZSTD_freeCCtx(state->cctx);
+    g_free(state->in);
+    g_free(state->out);
+    if (ws_close(state->fd) == -1 && ret == 0)
+        ret = errno;
+    g_free(state);
+    return ret;
+}
+
+int
+zstdwfile_geterr(ZSTDWFILE_T state)
+{
+    return state->err;
+}
+#endif /* HAVE_ZSTD */
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -16,12 +16,17 @@
 extern FILE_T file_open(const char *path);
 extern FILE_T file_fdopen(int fildes);
 extern void file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArray *seek);
+extern gboolean file_fast_seek_load(FILE_T stream, const char *path, GPtrArray *seek);
+extern void file_fast_seek_save(FILE_T stream, const char *path, GPtrArray *seek);
+extern gboolean file_zstd_seek_table_load(FILE_T stream, GPtrArray *seek);
+extern void file_set_live_ring(FILE_T stream, ws_shm_ring *ring);
 WS_DLL_PUBLIC gint64 file_seek(FILE_T stream, gint64 offset, int whence, int *err);
 WS_DLL_PUBLIC gint64 file_tell(FILE_T stream);
 extern gint64 file_tell_raw(FILE_T stream);
 extern int file_fstat(FILE_T stream, ws_statb64 *statb, int *err);
 WS_DLL_PUBLIC gboolean file_iscompressed(FILE_T stream);
 WS_DLL_PUBLIC int file_read(void *buf, unsigned int count, FILE_T file);
+WS_DLL_PUBLIC const guint8 *file_read_mapped(FILE_T file, unsigned int count);
 WS_DLL_PUBLIC int file_peekc(FILE_T stream);
 WS_DLL_PUBLIC int file_getc(FILE_T stream);
 WS_DLL_PUBLIC char *file_gets(char *buf, int len, FILE_T stream);
@@ -44,4 +49,17 @@ extern int gzwfile_close(GZWFILE_T state);
 extern int gzwfile_geterr(GZWFILE_T state);
 #endif /* HAVE_ZLIB */
 
+#ifdef HAVE_ZSTD
+typedef struct zstd_writer *ZSTDWFILE_T;
+
+extern ZSTDWFILE_T zstdwfile_open(const char *path);
+WS_DLL_PUBLIC ZSTDWFILE_T zstdwfile_fdopen(int fd);
+extern guint zstdwfile_write(ZSTDWFILE_T state, const void *buf, guint len);
+WS_DLL_PUBLIC int zstdwfile_write_frame(ZSTDWFILE_T state, const void *frame,
+                                        guint len, guint decompressed_len);
+extern int zstdwfile_flush(ZSTDWFILE_T state);
+WS_DLL_PUBLIC int zstdwfile_close(ZSTDWFILE_T state);
+extern int zstdwfile_geterr(ZSTDWFILE_T state);
+#endif /* HAVE_ZSTD */
+
 #endif /* __FILE_H__ */
@@ -0,0 +1,297 @@
+/* file_wrappers_test.c
+ * Tests for reading uncompressed files, through a memory mapping where
+ * there is one.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+
+#include "file_wrappers.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <unistd.h>
+#endif
+
+/*
+ * Big enough to span more than one window onto the mapping, and not a
+ * multiple of the page size.
+ */
+#define TEST_FILE_SIZE  ((1U << 20) * 3 / 2 + 123)
+
+static guint8 *test_data;
+static char *test_path;
+
+static void
+write_test_file(void)
+{
+    GError *error = NULL;
+    int fd;
+
+    fd = g_file_open_tmp("wtap_file_wrappers_XXXXXX", &test_path, &error);
+    g_assert_no_error(error);
+    g_assert_cmpint(ws_write(fd, test_data, TEST_FILE_SIZE), ==, TEST_FILE_SIZE);
+    ws_close(fd);
+}
+
+static void
+remove_test_file(void)
+{
+    ws_unlink(test_path);
+    g_free(test_path);
+    test_path = NULL;
+}
+
+static void
+test_read_to_eof(void)
+{
+    FILE_T fh;
+    guint8 *buf = (guint8 *)g_malloc(TEST_FILE_SIZE);
+    const guint8 *mapped;
+    guint off = 0;
+    int got;
+
+    write_test_file();
+    fh = file_open(test_path);
+    g_assert_nonnull(fh);
+
+    /* Odd sizes, so reads straddle the windows onto the mapping. */
+    got = file_read(buf, 17, fh);
+    g_assert_cmpint(got, ==, 17);
+    off += got;
+#ifdef HAVE_SYS_MMAN_H
+    /* The rest is handed out in place. */
+    mapped = file_read_mapped(fh, 1000);
+    g_assert_nonnull(mapped);
+    g_assert_cmpmem(mapped, 1000, test_data + off, 1000);
+    memcpy(buf + off, mapped, 1000);
+    off += 1000;
+    /* Even when it runs past the current window. */
+    mapped = file_read_mapped(fh, (1U << 20));
+    g_assert_nonnull(mapped);
+    g_assert_cmpmem(mapped, (1U << 20), test_data + off, (1U << 20));
+    memcpy(buf + off, mapped, (1U << 20));
+    off += (1U << 20);
+    /* But not past the end of the file. */
+    g_assert_null(file_read_mapped(fh, TEST_FILE_SIZE));
+#else
+    (void)mapped;
+#endif
+    while ((got = file_read(buf + off, MIN(4099, TEST_FILE_SIZE - off), fh)) > 0)
+        off += got;
+    g_assert_cmpint(got, ==, 0);
+    g_assert_cmpuint(off, ==, TEST_FILE_SIZE);
+    g_assert_cmpmem(buf, TEST_FILE_SIZE, test_data, TEST_FILE_SIZE);
+    g_assert_cmpint(file_tell(fh), ==, TEST_FILE_SIZE);
+
+    /* At the end, reads return nothing, and that's not an error. */
+    g_assert_cmpint(file_read(buf, 10, fh), ==, 0);
+    g_assert_true(file_eof(fh));
+    g_assert_cmpint(file_error(fh, NULL), ==, 0);
+    g_assert_null(file_read_mapped(fh, 1));
+
+    file_close(fh);
+    remove_test_file();
+    g_free(buf);
+}
+
+static void
+check_seeks(FILE_T fh)
+{
+    static const gint64 offsets[] = {
+        (1U << 20) + 5,         /* into the second window */
+        10,                     /* back into the first */
+        TEST_FILE_SIZE - 7,     /* just before the end */
+        4096 * 3,               /* back again */
+    };
+    guint8 buf[64];
+    int err;
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS(offsets); i++) {
+        guint len = (guint)MIN(sizeof buf, TEST_FILE_SIZE - offsets[i]);
+
+        g_assert_cmpint(file_seek(fh, offsets[i], SEEK_SET, &err), ==, offsets[i]);
+        g_assert_cmpint(file_read(buf, len, fh), ==, len);
+        g_assert_cmpmem(buf, len, test_data + offsets[i], len);
+        g_assert_cmpint(file_tell(fh), ==, offsets[i] + len);
+    }
+
+    /* Relative seeks. */
+    g_assert_cmpint(file_seek(fh, 100, SEEK_SET, &err), ==, 100);
+    g_assert_cmpint(file_seek(fh, 200, SEEK_CUR, &err), ==, 300);
+    g_assert_cmpint(file_read(buf, 8, fh), ==, 8);
+    g_assert_cmpmem(buf, 8, test_data + 300, 8);
+    g_assert_cmpint(file_seek(fh, -108, SEEK_CUR, &err), ==, 200);
+    g_assert_cmpint(file_read(buf, 8, fh), ==, 8);
+    g_assert_cmpmem(buf, 8, test_data + 200, 8);
+
+    /* Seeking to the end leaves nothing to read. */
+    g_assert_cmpint(file_seek(fh, TEST_FILE_SIZE, SEEK_SET, &err), ==, TEST_FILE_SIZE);
+    g_assert_cmpint(file_read(buf, 8, fh), ==, 0);
+    g_assert_true(file_eof(fh));
+
+    /* Seeking back after hitting the end works. */
+    g_assert_cmpint(file_seek(fh, 1, SEEK_SET, &err), ==, 1);
+    g_assert_cmpint(file_read(buf, 8, fh), ==, 8);
+    g_assert_cmpmem(buf, 8, test_data + 1, 8);
+}
+
+/* Seeking without fast seek data, as on the sequential handle. */
+static void
+test_seek(void)
+{
+    FILE_T fh;
+
+    write_test_file();
+    fh = file_open(test_path);
+    g_assert_nonnull(fh);
+    check_seeks(fh);
+    file_close(fh);
+    remove_test_file();
+}
+
+/*
+ * Seeking with the fast seek data a sequential read leaves behind, as
+ * on the random-access handle.
+ */
+static void
+test_seek_random(void)
+{
+    GPtrArray *fast_seek = g_ptr_array_new_with_free_func(g_free);
+    FILE_T fh, random_fh;
+    guint8 buf[4096];
+
+    write_test_file();
+    fh = file_open(test_path);
+    g_assert_nonnull(fh);
+    random_fh = file_open(test_path);
+    g_assert_nonnull(random_fh);
+    file_set_random_access(fh, FALSE, fast_seek);
+    file_set_random_access(random_fh, TRUE, fast_seek);
+
+    while (file_read(buf, sizeof buf, fh) > 0)
+        ;
+    g_assert_true(file_eof(fh));
+    check_seeks(random_fh);
+
+    file_close(random_fh);
+    file_close(fh);
+    remove_test_file();
+    g_ptr_array_free(fast_seek, TRUE);
+}
+
+#ifdef HAVE_SYS_MMAN_H
+/* Data added after the file was mapped is read from the file. */
+static void
+test_grown(void)
+{
+    FILE_T fh;
+    guint8 *buf = (guint8 *)g_malloc(TEST_FILE_SIZE);
+    guint off = 0;
+    int fd, got;
+
+    write_test_file();
+    fh = file_open(test_path);
+    g_assert_nonnull(fh);
+    while ((got = file_read(buf, 65536, fh)) > 0)
+        off += got;
+    g_assert_cmpint(got, ==, 0);
+    g_assert_cmpuint(off, ==, TEST_FILE_SIZE);
+
+    fd = ws_open(test_path, O_WRONLY|O_APPEND, 0);
+    g_assert_cmpint(fd, !=, -1);
+    g_assert_cmpint(ws_write(fd, test_data, 1000), ==, 1000);
+    ws_close(fd);
+
+    file_clearerr(fh);
+    g_assert_cmpint(file_read(buf, TEST_FILE_SIZE, fh), ==, 1000);
+    g_assert_cmpmem(buf, 1000, test_data, 1000);
+    g_assert_cmpint(file_tell(fh), ==, TEST_FILE_SIZE + 1000);
+
+    file_close(fh);
+    remove_test_file();
+    g_free(buf);
+}
+
+/*
+ * A file truncated by someone else while mapped is a short read,
+ * not a SIGBUS.
+ */
+static void
+test_truncated(void)
+{
+    FILE_T fh;
+    guint8 *buf = (guint8 *)g_malloc(TEST_FILE_SIZE);
+    int fd, got;
+
+    write_test_file();
+    fh = file_open(test_path);
+    g_assert_nonnull(fh);
+    g_assert_cmpint(file_read(buf, 16, fh), ==, 16);
+
+    fd = ws_open(test_path, O_WRONLY, 0);
+    g_assert_cmpint(fd, !=, -1);
+    g_assert_cmpint(ftruncate(fd, 100), ==, 0);
+    ws_close(fd);
+
+    while ((got = file_read(buf, 65536, fh)) > 0)
+        ;
+    g_assert_cmpint(got, ==, -1);
+    g_assert_cmpint(file_error(fh, NULL), ==, WTAP_ERR_SHORT_READ);
+
+    file_close(fh);
+    remove_test_file();
+    g_free(buf);
+}
+#endif
+
+int
+main(int argc, char **argv)
+{
+    guint i;
+    int ret;
+
+    g_test_init(&argc, &argv, NULL);
+
+    test_data = (guint8 *)g_malloc(TEST_FILE_SIZE);
+    for (i = 0; i < TEST_FILE_SIZE; i++)
+        test_data[i] = (guint8)(i * 7 + (i >> 8));
+
+    g_test_add_func("/file_wrappers/read_to_eof", test_read_to_eof);
+    g_test_add_func("/file_wrappers/seek", test_seek);
+    g_test_add_func("/file_wrappers/seek_random", test_seek_random);
+#ifdef HAVE_SYS_MMAN_H
+    g_test_add_func("/file_wrappers/grown", test_grown);
+    g_test_add_func("/file_wrappers/truncated", test_truncated);
+#endif
+
+    ret = g_test_run();
+
+    g_free(test_data);
+
+    return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -67,10 +67,13 @@ static int libpcap_try_record(wtap *wth, int *err, gchar **err_info);
 
 static gboolean libpcap_read(wtap *wth, wtap_rec *rec, Buffer *buf,
     int *err, gchar **err_info, gint64 *data_offset);
+static void libpcap_read_batch(wtap *wth, wtap_rec_batch *batch,
+    int *err, gchar **err_info);
 static gboolean libpcap_seek_read(wtap *wth, gint64 seek_off,
     wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
 static gboolean libpcap_read_packet(wtap *wth, FILE_T fh,
-    wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+    wtap_rec *rec, Buffer *buf, wtap_rec_batch *batch, int *err,
+    gchar **err_info);
 static int libpcap_read_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
     struct pcaprec_ss990915_hdr *hdr);
 static void libpcap_close(wtap *wth);
@@ -296,6 +299,7 @@ wtap_open_return_val libpcap_open(wtap *wth, int *err, gchar **err_info)
 	/* This is a libpcap file */
 	wth->subtype_read = libpcap_read;
 	wth->subtype_seek_read = libpcap_seek_read;
+	wth->subtype_read_batch = libpcap_read_batch;
 	wth->subtype_close = libpcap_close;
 	wth->snapshot_length = hdr.snaplen;
 	libpcap = g_new0(libpcap_t, 1);
@@ -899,7 +903,27 @@ static gboolean libpcap_read(wtap *wth, wtap_rec *rec, Buffer *buf,
 {
 	*data_offset = file_tell(wth->fh);
 
-	return libpcap_read_packet(wth, wth->fh, rec, buf, err, err_info);
+	return libpcap_read_packet(wth, wth->fh, rec, buf, NULL, err,
+	    err_info);
+}
+
+/* Read a batch of packets, with the packet data going straight into
+   the batch arena. */
+static void libpcap_read_batch(wtap *wth, wtap_rec_batch *batch,
+    int *err, gchar **err_info)
+{
+	wtap_rec *rec;
+	gint64 data_offset;
+
+	while ((rec = wtap_rec_batch_next(wth, batch)) != NULL) {
+		data_offset = file_tell(wth->fh);
+		if (!libpcap_read_packet(wth, wth->fh, rec, &batch->buf, batch,
+		    err, err_info)) {
+			wtap_rec_batch_discard(batch);
+			return;
+		}
+		wtap_rec_batch_add(batch, data_offset);
+	}
 }
 
 static gboolean
@@ -909,7 +933,7 @@ libpcap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
 	if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
 		return FALSE;
 
-	if (!libpcap_read_packet(wth, wth->random_fh, rec, buf, err,
+	if (!libpcap_read_packet(wth, wth->random_fh, rec, buf, NULL, err,
 	    err_info)) {
 		if (*err == 0)
 			*err = WTAP_ERR_SHORT_READ;
@@ -920,7 +944,7 @@ libpcap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
 
 static gboolean
 libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
-    Buffer *buf, int *err, gchar **err_info)
+    Buffer *buf, wtap_rec_batch *batch, int *err, gchar **err_info)
 {
 	struct pcaprec_ss990915_hdr hdr;
 	guint packet_size;
@@ -1008,10 +1032,35 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	rec->rec_header.packet_header.len = orig_size;
 
 	/*
-	 * Read the packet data.
+	 * Read the packet data; if we're reading a batch, now that we
+	 * know how big the packet is, read it straight into the batch
+	 * arena.
+	 *
+	 * Otherwise, if this is a sequential read, skip it if our caller
+	 * doesn't want it, or hand it back in place if it's mapped, unless
+	 * we'll be byte-swapping it, in which case the pages of the
+	 * mapping would get copied anyway.
 	 */
-	if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
-		return FALSE;	/* failed */
+	if (batch != NULL) {
+		buf = wtap_rec_batch_reserve(batch, packet_size);
+		if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
+			return FALSE;	/* failed */
+	} else if (fh == wth->fh && wth->skip_packet_data &&
+	    !pcap_read_post_process_needs_data(wth->file_encap,
+	      libpcap->byte_swapped)) {
+		if (!wtap_skip_packet_bytes(fh, buf, packet_size, err,
+		    err_info))
+			return FALSE;	/* failed */
+	} else if (fh == wth->fh &&
+	    !pcap_read_post_process_modifies_data(wth->file_encap,
+	      libpcap->byte_swapped)) {
+		if (!wtap_read_packet_bytes_in_place(fh, buf, packet_size, err,
+		    err_info))
+			return FALSE;	/* failed */
+	} else {
+		if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
+			return FALSE;	/* failed */
+	}
 
 	pcap_read_post_process(is_nokia, wth->file_encap, rec,
 	    ws_buffer_start_ptr(buf), libpcap->byte_swapped, libpcap->fcs_len);
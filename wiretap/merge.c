@@ -27,13 +27,18 @@
 #include "merge.h"
 #include "wtap_opttypes.h"
 #include "wtap-int.h"
+#include "file_wrappers.h"
+#include "pcapng_module.h"
 
 #include <wsutil/filesystem.h>
 #include "wsutil/os_version_info.h"
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 
-
+/*
+ * Number of records to read ahead from each input file at a time.
+ */
+#define MERGE_READ_AHEAD 32
 
 static const char* idb_merge_mode_strings[] = {
     /* IDB_MERGE_MODE_NONE */
@@ -79,8 +84,9 @@ cleanup_in_file(merge_in_file_t *in_file)
     g_array_free(in_file->idb_index_map, TRUE);
     in_file->idb_index_map = NULL;
 
-    wtap_rec_cleanup(&in_file->rec);
-    ws_buffer_free(&in_file->frame_buffer);
+    wtap_rec_batch_cleanup(&in_file->batch);
+    g_free(in_file->batch_err_info);
+    in_file->batch_err_info = NULL;
 }
 
 static void
@@ -145,8 +151,8 @@ merge_open_in_files(guint in_file_count, const char *const *in_file_names,
             *err_fileno = i;
             return FALSE;
         }
-        wtap_rec_init(&files[i].rec);
-        ws_buffer_init(&files[i].frame_buffer, 1514);
+        wtap_rec_batch_init(&files[i].batch, MERGE_READ_AHEAD);
+        files[i].batch_pos = 0;
         files[i].size = size;
         files[i].idb_index_map = g_array_new(FALSE, FALSE, sizeof(guint));
     }
@@ -204,22 +210,142 @@ merge_select_frame_type(int in_file_count, merge_in_file_t in_files[])
 }
 
 /*
- * returns TRUE if first argument is earlier than second
+ * Make the next record from a file current, reading another batch of
+ * records from the file if we've used up the ones we have.  Sets the
+ * file's state to RECORD_PRESENT, AT_EOF or GOT_ERROR; an error that
+ * cut a batch short is only reported once the records before it have
+ * been used up.
+ */
+static void
+merge_fetch_record(merge_in_file_t *in_file)
+{
+    in_file->batch_pos++;
+    if (in_file->batch_pos >= in_file->batch.count) {
+        if (in_file->batch_err != 0 ||
+            wtap_read_batch(in_file->wth, &in_file->batch,
+                            &in_file->batch_err,
+                            &in_file->batch_err_info) == 0) {
+            in_file->state = (in_file->batch_err != 0) ? GOT_ERROR : AT_EOF;
+            return;
+        }
+        in_file->batch_pos = 0;
+    }
+    in_file->state = RECORD_PRESENT;
+}
+
+/*
+ * Returns TRUE if the current record of in_files[a] goes before that
+ * of in_files[b].
+ *
+ * Files at EOF go after everything else.  Records with no time stamp
+ * go before all other records, in file order; yes, this means you won't
+ * get a chronological merge of those records, but you obviously *can't*
+ * get that.  Records with the same time stamp are taken from the later
+ * file first.
  */
 static gboolean
-is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
+merge_is_before(const merge_in_file_t in_files[], guint a, guint b)
 {
-    if (l->secs > r->secs) {  /* left is later */
-        return FALSE;
-    } else if (l->secs < r->secs) { /* left is earlier */
+    const wtap_rec *rec_a, *rec_b;
+    int cmp;
+
+    if (in_files[a].state != RECORD_PRESENT)
+        return in_files[b].state != RECORD_PRESENT && a < b;
+    if (in_files[b].state != RECORD_PRESENT)
         return TRUE;
-    } else if (l->nsecs > r->nsecs) { /* tv_sec equal, l.usec later */
+
+    rec_a = &in_files[a].batch.recs[in_files[a].batch_pos];
+    rec_b = &in_files[b].batch.recs[in_files[b].batch_pos];
+    if (!(rec_a->presence_flags & WTAP_HAS_TS))
+        return !(rec_b->presence_flags & WTAP_HAS_TS) ? a < b : TRUE;
+    if (!(rec_b->presence_flags & WTAP_HAS_TS))
         return FALSE;
+
+    cmp = nstime_cmp(&rec_a->ts, &rec_b->ts);
+    if (cmp != 0)
+        return cmp < 0;
+    return a > b;
+}
+
+/*
+ * Loser tree over the input files, so that finding the file with the
+ * next record takes O(log n) comparisons rather than O(n).
+ *
+ * The files are the leaves, numbered in_file_count through
+ * 2*in_file_count-1; internal node i, for 1 <= i < in_file_count, has
+ * children 2i and 2i+1 and holds the file that lost the match played
+ * there, and node 0 holds the overall winner.
+ */
+typedef struct {
+    merge_in_file_t *in_files;
+    guint            in_file_count;
+    guint           *nodes;
+    guint            last;       /* file whose record we returned last, or G_MAXUINT */
+} merge_tree_t;
+
+static void
+merge_tree_init(merge_tree_t *tree, merge_in_file_t in_files[],
+                guint in_file_count)
+{
+    tree->in_files = in_files;
+    tree->in_file_count = in_file_count;
+    tree->nodes = NULL;
+    tree->last = G_MAXUINT;
+}
+
+static void
+merge_tree_build(merge_tree_t *tree)
+{
+    guint n = tree->in_file_count;
+    guint *winners = g_new(guint, 2 * n);
+    guint i;
+
+    tree->nodes = g_new(guint, n);
+    for (i = 0; i < n; i++)
+        winners[n + i] = i;
+    for (i = n - 1; i >= 1; i--) {
+        guint left = winners[2 * i];
+        guint right = winners[2 * i + 1];
+
+        if (merge_is_before(tree->in_files, right, left)) {
+            winners[i] = right;
+            tree->nodes[i] = left;
+        } else {
+            winners[i] = left;
+            tree->nodes[i] = right;
+        }
     }
-    /* either one < two or one == two
-     * either way, return one
-     */
-    return TRUE;
+    tree->nodes[0] = (n == 1) ? 0 : winners[1];
+    g_free(winners);
+}
+
+/*
+ * The current record of file changed; replay its matches on the way
+ * up to the root.
+ */
+static void
+merge_tree_replay(merge_tree_t *tree, guint file)
+{
+    guint node = (file + tree->in_file_count) / 2;
+    guint winner = file;
+
+    while (node >= 1) {
+        if (merge_is_before(tree->in_files, tree->nodes[node], winner)) {
+            guint loser = winner;
+
+            winner = tree->nodes[node];
+            tree->nodes[node] = loser;
+        }
+        node /= 2;
+    }
+    tree->nodes[0] = winner;
+}
+
+static void
+merge_tree_cleanup(merge_tree_t *tree)
+{
+    g_free(tree->nodes);
+    tree->nodes = NULL;
 }
 
 /** Read the next packet, in chronological order, from the set of files to
@@ -234,8 +360,7 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * On an EOF (meaning all the files are at EOF), set *err to 0 and return
  * NULL.
  *
- * @param in_file_count number of entries in in_files
- * @param in_files input file array
+ * @param tree loser tree over the input files
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @return pointer to merge_in_file_t for file from which that packet
@@ -243,80 +368,62 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * all files
  */
 static merge_in_file_t *
-merge_read_packet(int in_file_count, merge_in_file_t in_files[],
-                  int *err, gchar **err_info)
+merge_read_packet(merge_tree_t *tree, int *err, gchar **err_info)
 {
-    int i;
-    int ei = -1;
-    nstime_t tv = NSTIME_INIT_MAX;
-    wtap_rec *rec;
-
-    /*
-     * Make sure we have a record available from each file that's not at
-     * EOF, and search for the record with the earliest time stamp or
-     * with no time stamp (those records are treated as earlier than
-     * all other records).  Yes, this means you won't get a chronological
-     * merge of those records, but you obviously *can't* get that.
-     */
-    for (i = 0; i < in_file_count; i++) {
-        gint64 data_offset;
-
-        if (in_files[i].state == RECORD_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, &in_files[i].rec,
-                           &in_files[i].frame_buffer, err, err_info,
-                           &data_offset)) {
-                if (*err != 0) {
-                    in_files[i].state = GOT_ERROR;
-                    return &in_files[i];
-                }
-                in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = RECORD_PRESENT;
-        }
+    merge_in_file_t *in_files = tree->in_files;
+    merge_in_file_t *in_file;
+    guint i;
 
-        if (in_files[i].state == RECORD_PRESENT) {
-            rec = &in_files[i].rec;
-            if (!(rec->presence_flags & WTAP_HAS_TS)) {
-                /*
-                 * No time stamp.  Pick this record, and stop looking.
-                 */
-                ei = i;
-                break;
-            }
-            if (is_earlier(&rec->ts, &tv)) {
-                /*
-                 * This record's time stamp is earlier than any of the
-                 * records we've seen so far.  Pick it, for now, but
-                 * keep looking.
-                 */
-                tv = rec->ts;
-                ei = i;
-            }
+    if (tree->nodes == NULL) {
+        /*
+         * First time through; get a record from each file, and play
+         * the whole tournament.
+         */
+        for (i = 0; i < tree->in_file_count; i++) {
+            merge_fetch_record(&in_files[i]);
+            if (in_files[i].state == GOT_ERROR)
+                goto error;
         }
+        merge_tree_build(tree);
+    } else if (tree->last != G_MAXUINT) {
+        /*
+         * Replace the record we returned last time, and replay its
+         * matches.
+         */
+        i = tree->last;
+        merge_fetch_record(&in_files[i]);
+        if (in_files[i].state == GOT_ERROR)
+            goto error;
+        merge_tree_replay(tree, i);
     }
 
-    if (ei == -1) {
+    in_file = &in_files[tree->nodes[0]];
+    if (in_file->state != RECORD_PRESENT) {
         /* All the streams are at EOF.  Return an EOF indication. */
+        tree->last = G_MAXUINT;
         *err = 0;
         return NULL;
     }
 
     /* We'll need to read another packet from this file. */
-    in_files[ei].state = RECORD_NOT_PRESENT;
+    in_file->state = RECORD_NOT_PRESENT;
+    tree->last = tree->nodes[0];
 
     /* Count this packet. */
-    in_files[ei].packet_num++;
+    in_file->packet_num++;
 
     /*
      * Return a pointer to the merge_in_file_t of the file from which the
      * packet was read.
      */
     *err = 0;
-    return &in_files[ei];
+    return in_file;
+
+error:
+    *err = in_files[i].batch_err;
+    *err_info = in_files[i].batch_err_info;
+    in_files[i].batch_err_info = NULL;
+    return &in_files[i];
 }
 
 /** Read the next packet, in file sequence order, from the set of files
@@ -344,7 +451,6 @@ merge_append_read_packet(int in_file_count, merge_in_file_t in_files[],
                          int *err, gchar **err_info)
 {
     int i;
-    gint64 data_offset;
 
     /*
      * Find the first file not at EOF, and read the next packet from it.
@@ -352,17 +458,20 @@ merge_append_read_packet(int in_file_count, merge_in_file_t in_files[],
     for (i = 0; i < in_file_count; i++) {
         if (in_files[i].state == AT_EOF)
             continue; /* This file is already at EOF */
-        if (wtap_read(in_files[i].wth, &in_files[i].rec,
-                      &in_files[i].frame_buffer, err, err_info,
-                      &data_offset))
-            break; /* We have a packet */
-        if (*err != 0) {
+        merge_fetch_record(&in_files[i]);
+        if (in_files[i].state == RECORD_PRESENT) {
+            /* We have a packet; we'll need to read another one next time. */
+            in_files[i].state = RECORD_NOT_PRESENT;
+            break;
+        }
+        if (in_files[i].state == GOT_ERROR) {
             /* Read error - quit immediately. */
-            in_files[i].state = GOT_ERROR;
+            *err = in_files[i].batch_err;
+            *err_info = in_files[i].batch_err_info;
+            in_files[i].batch_err_info = NULL;
             return &in_files[i];
         }
-        /* EOF - flag this file as being at EOF, and try the next one. */
-        in_files[i].state = AT_EOF;
+        /* EOF - try the next file. */
     }
     if (i == in_file_count) {
         /* All the streams are at EOF.  Return an EOF indication. */
@@ -903,6 +1012,231 @@ map_rec_interface_id(wtap_rec *rec, const merge_in_file_t *in_file)
     return TRUE;
 }
 
+/*
+ * Appending by copying records as raw bytes.
+ *
+ * If the input files are all of the output file type, and in the byte
+ * order and time stamp precision that it's written in, their records
+ * needn't be read and written with Wiretap: the output file's headers
+ * are written as usual, and then each input file's records are copied
+ * as they are, with only the interface IDs of pcapng packet blocks
+ * mapped to those of the merged IDBs.
+ */
+typedef enum {
+    RAW_COPY_NONE,
+    RAW_COPY_PCAP,
+    RAW_COPY_PCAPNG
+} raw_copy_format_e;
+
+#define RAW_PCAP_REC_HDR_LEN        16  /* time stamp, captured and original length */
+#define RAW_PCAPNG_BLOCK_HDR_LEN    8   /* block type, block total length */
+#define RAW_PCAPNG_PB_HDR_LEN       28  /* block header, interface ID, time stamp, captured and original length */
+#define RAW_PCAPNG_SPB_HDR_LEN      12  /* block header, original length */
+#define RAW_PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+
+/*
+ * Read the start of the next record: a pcap record header, or a pcapng
+ * block header followed, for packet blocks, by the fields up to the
+ * packet data.  Sets *hdr_len to the number of bytes read, and *rec_len
+ * to the length of the whole record.  Returns FALSE, with *err set to 0,
+ * at the end of the file.
+ */
+static gboolean
+raw_read_rec_header(FILE_T fh, const raw_copy_format_e format, guint8 *hdr,
+                    guint *hdr_len, guint32 *rec_len, int *err,
+                    gchar **err_info)
+{
+    guint32 block_type, caplen;
+
+    if (format == RAW_COPY_PCAP) {
+        if (!wtap_read_bytes_or_eof(fh, hdr, RAW_PCAP_REC_HDR_LEN, err, err_info))
+            return FALSE;
+        memcpy(&caplen, hdr + 8, sizeof caplen);
+        if (caplen > WTAP_MAX_PACKET_SIZE_DBUS) {
+            *err = WTAP_ERR_BAD_FILE;
+            *err_info = ws_strdup_printf("merge: record length %u is too large", caplen);
+            return FALSE;
+        }
+        *hdr_len = RAW_PCAP_REC_HDR_LEN;
+        *rec_len = RAW_PCAP_REC_HDR_LEN + caplen;
+        return TRUE;
+    }
+
+    if (!wtap_read_bytes_or_eof(fh, hdr, RAW_PCAPNG_BLOCK_HDR_LEN, err, err_info))
+        return FALSE;
+    memcpy(&block_type, hdr, sizeof block_type);
+    memcpy(rec_len, hdr + 4, sizeof *rec_len);
+    *hdr_len = RAW_PCAPNG_BLOCK_HDR_LEN;
+    if (block_type == BLOCK_TYPE_EPB || block_type == BLOCK_TYPE_PB)
+        *hdr_len = RAW_PCAPNG_PB_HDR_LEN;
+    else if (block_type == BLOCK_TYPE_SPB)
+        *hdr_len = RAW_PCAPNG_SPB_HDR_LEN;
+    /* Every block ends with its length again. */
+    if (*rec_len % 4 != 0 || *rec_len < *hdr_len + 4) {
+        *err = WTAP_ERR_BAD_FILE;
+        *err_info = ws_strdup_printf("merge: block length %u is not valid", *rec_len);
+        return FALSE;
+    }
+    return wtap_read_bytes(fh, hdr + RAW_PCAPNG_BLOCK_HDR_LEN,
+                           *hdr_len - RAW_PCAPNG_BLOCK_HDR_LEN, err, err_info);
+}
+
+/*
+ * Returns TRUE if a record can be copied as it is (apart from its
+ * interface ID) and be what merge_process_packets() would have written,
+ * or, for pcapng ISBs and NRBs, be left out as it would have left it out.
+ */
+static gboolean
+raw_rec_is_copyable(const merge_in_file_t *in_file,
+                    const raw_copy_format_e format, const guint8 *hdr,
+                    const guint32 rec_len, const guint snaplen)
+{
+    guint32 block_type, interface_id, caplen;
+    guint16 pb_interface_id;
+
+    if (format == RAW_COPY_PCAP)
+        return rec_len - RAW_PCAP_REC_HDR_LEN <= snaplen;
+
+    memcpy(&block_type, hdr, sizeof block_type);
+    switch (block_type) {
+
+    case BLOCK_TYPE_EPB:
+    case BLOCK_TYPE_PB:
+        if (block_type == BLOCK_TYPE_EPB) {
+            memcpy(&interface_id, hdr + 8, sizeof interface_id);
+        } else {
+            memcpy(&pb_interface_id, hdr + 8, sizeof pb_interface_id);
+            interface_id = pb_interface_id;
+            /* Mapped IDs must fit in the PB's 16-bit field. */
+            if (interface_id < in_file->idb_index_map->len &&
+                g_array_index(in_file->idb_index_map, guint, interface_id) > G_MAXUINT16)
+                return FALSE;
+        }
+        memcpy(&caplen, hdr + 20, sizeof caplen);
+        return interface_id < in_file->idb_index_map->len && caplen <= snaplen;
+
+    case BLOCK_TYPE_SPB:
+        /* An SPB is always for the first interface. */
+        return in_file->idb_index_map->len != 0 &&
+               g_array_index(in_file->idb_index_map, guint, 0) == 0 &&
+               rec_len - RAW_PCAPNG_SPB_HDR_LEN - 4 <= snaplen;
+
+    case BLOCK_TYPE_ISB:
+    case BLOCK_TYPE_NRB:
+        return TRUE;
+
+    default:
+        /*
+         * Other sections, IDBs after the packets have started, DSBs,
+         * and records other than packets go through Wiretap.
+         */
+        return FALSE;
+    }
+}
+
+/*
+ * Check that every record of an input file, from where Wiretap left off
+ * after reading its headers, can be copied, and then go back there.
+ */
+static gboolean
+raw_scan_in_file(merge_in_file_t *in_file, const raw_copy_format_e format,
+                 const guint snaplen)
+{
+    FILE_T   fh = in_file->wth->fh;
+    gint64   start;
+    guint8   hdr[RAW_PCAPNG_PB_HDR_LEN];
+    guint    hdr_len;
+    guint32  rec_len;
+    int      err = 0;
+    gchar   *err_info = NULL;
+    gboolean copyable = TRUE;
+
+    start = file_tell(fh);
+    for (;;) {
+        if (!raw_read_rec_header(fh, format, hdr, &hdr_len, &rec_len, &err, &err_info)) {
+            copyable = (err == 0);
+            break;
+        }
+        if (!raw_rec_is_copyable(in_file, format, hdr, rec_len, snaplen) ||
+            !wtap_read_bytes(fh, NULL, rec_len - hdr_len, &err, &err_info)) {
+            copyable = FALSE;
+            break;
+        }
+    }
+    g_free(err_info);
+
+    if (file_seek(fh, start, SEEK_SET, &err) == -1)
+        return FALSE;
+    return copyable;
+}
+
+/*
+ * Can the input files be appended to the output file by copying their
+ * records?  If so, returns the format of the records.
+ */
+static raw_copy_format_e
+merge_raw_copy_format(merge_in_file_t *in_files, const guint in_file_count,
+                      const int file_type, const guint snaplen)
+{
+    raw_copy_format_e format;
+    gint64   magic_offset;
+    guint32  native_magic, magic;
+    gint64   start;
+    int      err;
+    gchar   *err_info = NULL;
+    guint    i;
+
+    if (file_type == wtap_pcapng_file_type_subtype()) {
+        format = RAW_COPY_PCAPNG;
+        magic_offset = RAW_PCAPNG_BLOCK_HDR_LEN;
+        native_magic = RAW_PCAPNG_BYTE_ORDER_MAGIC;
+    } else if (file_type == wtap_pcap_file_type_subtype()) {
+        format = RAW_COPY_PCAP;
+        magic_offset = 0;
+        native_magic = 0xa1b2c3d4;
+    } else if (file_type == wtap_pcap_nsec_file_type_subtype()) {
+        format = RAW_COPY_PCAP;
+        magic_offset = 0;
+        native_magic = 0xa1b23c4d;
+    } else {
+        return RAW_COPY_NONE;
+    }
+
+    for (i = 0; i < in_file_count; i++) {
+        if (wtap_file_type_subtype(in_files[i].wth) != file_type)
+            return RAW_COPY_NONE;
+
+        /*
+         * The output is written in our byte order, so the input must be
+         * too.  A pcapng file must also have only the one section, which
+         * raw_scan_in_file() checks.
+         */
+        start = file_tell(in_files[i].wth->fh);
+        if (file_seek(in_files[i].wth->fh, magic_offset, SEEK_SET, &err) == -1)
+            return RAW_COPY_NONE;
+        if (!wtap_read_bytes(in_files[i].wth->fh, &magic, sizeof magic, &err, &err_info))
+            magic = 0;
+        g_free(err_info);
+        err_info = NULL;
+        if (file_seek(in_files[i].wth->fh, start, SEEK_SET, &err) == -1 ||
+            magic != native_magic)
+            return RAW_COPY_NONE;
+    }
+
+    for (i = 0; i < in_file_count; i++) {
+        if (!raw_scan_in_file(&in_files[i], format, snaplen))
+            return RAW_COPY_NONE;
+    }
+    return format;
+}
+
+static merge_result merge_finish(wtap_dumper *pdh, merge_result status,
+                                 merge_in_file_t *in_files, const guint in_file_count,
+                                 const merge_in_file_t *in_file, const int count,
+                                 merge_progress_callback_t* cb,
+                                 int *err, gchar **err_info, guint *err_fileno,
+                                 guint32 *err_framenum);
+
 static merge_result
 merge_process_packets(wtap_dumper *pdh, const int file_type,
                       merge_in_file_t *in_files, const guint in_file_count,
@@ -916,10 +1250,13 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
 {
     merge_result        status = MERGE_OK;
     merge_in_file_t    *in_file;
+    merge_tree_t        tree;
     int                 count = 0;
     gboolean            stop_flag = FALSE;
     wtap_rec *rec,      snap_rec;
 
+    merge_tree_init(&tree, in_files, in_file_count);
+
     for (;;) {
         *err = 0;
 
@@ -928,8 +1265,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
                                                err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
-                                        err_info);
+            in_file = merge_read_packet(&tree, err, err_info);
         }
 
         if (in_file == NULL) {
@@ -953,7 +1289,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
             break;
         }
 
-        rec = &in_file->rec;
+        rec = &in_file->batch.recs[in_file->batch_pos];
 
         if (wtap_file_type_subtype_supports_block(file_type,
                                                   WTAP_BLOCK_IF_ID_AND_INFO) != BLOCK_NOT_SUPPORTED) {
@@ -1019,7 +1355,8 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
             }
         }
 
-        if (!wtap_dump(pdh, rec, ws_buffer_start_ptr(&in_file->frame_buffer),
+        if (!wtap_dump(pdh, rec,
+                       wtap_rec_batch_data(&in_file->batch, in_file->batch_pos),
                        err, err_info)) {
             status = MERGE_ERR_CANT_WRITE_OUTFILE;
             break;
@@ -1027,6 +1364,106 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
         wtap_rec_reset(rec);
     }
 
+    merge_tree_cleanup(&tree);
+
+    return merge_finish(pdh, status, in_files, in_file_count, in_file, count,
+                        cb, err, err_info, err_fileno, err_framenum);
+}
+
+/*
+ * Append the input files to the output file by copying their records,
+ * as checked by merge_raw_copy_format().
+ */
+static merge_result
+merge_copy_raw_packets(wtap_dumper *pdh, const raw_copy_format_e format,
+                       merge_in_file_t *in_files, const guint in_file_count,
+                       merge_progress_callback_t* cb,
+                       int *err, gchar **err_info, guint *err_fileno,
+                       guint32 *err_framenum)
+{
+    merge_result        status = MERGE_OK;
+    merge_in_file_t    *in_file = NULL;
+    int                 count = 0;
+    guint8              hdr[RAW_PCAPNG_PB_HDR_LEN];
+    guint               hdr_len;
+    guint32             rec_len, block_type, interface_id;
+    guint16             pb_interface_id;
+    guint8             *data = NULL;
+    guint32             data_size = 0;
+    guint               i;
+
+    for (i = 0; i < in_file_count && status == MERGE_OK; i++) {
+        in_file = &in_files[i];
+
+        for (;;) {
+            *err = 0;
+            if (!raw_read_rec_header(in_file->wth->fh, format, hdr, &hdr_len,
+                                     &rec_len, err, err_info)) {
+                if (*err != 0)
+                    status = MERGE_ERR_CANT_READ_INFILE;
+                break;
+            }
+            if (rec_len - hdr_len > data_size) {
+                data_size = rec_len - hdr_len;
+                data = (guint8 *)g_realloc(data, data_size);
+            }
+            if (!wtap_read_bytes(in_file->wth->fh, data, rec_len - hdr_len,
+                                 err, err_info)) {
+                status = MERGE_ERR_CANT_READ_INFILE;
+                break;
+            }
+
+            if (format == RAW_COPY_PCAPNG) {
+                memcpy(&block_type, hdr, sizeof block_type);
+                if (block_type == BLOCK_TYPE_ISB || block_type == BLOCK_TYPE_NRB)
+                    continue;   /* not written when merging, either */
+                if (block_type == BLOCK_TYPE_EPB) {
+                    memcpy(&interface_id, hdr + 8, sizeof interface_id);
+                    interface_id = g_array_index(in_file->idb_index_map, guint, interface_id);
+                    memcpy(hdr + 8, &interface_id, sizeof interface_id);
+                } else if (block_type == BLOCK_TYPE_PB) {
+                    memcpy(&pb_interface_id, hdr + 8, sizeof pb_interface_id);
+                    pb_interface_id = (guint16)g_array_index(in_file->idb_index_map, guint, pb_interface_id);
+                    memcpy(hdr + 8, &pb_interface_id, sizeof pb_interface_id);
+                }
+            }
+
+            in_file->packet_num++;
+            count++;
+            if (cb && cb->callback_func(MERGE_EVENT_RECORD_WAS_READ, count, in_files, in_file_count, cb->data)) {
+                /* The user decided to abort the merge. */
+                status = MERGE_USER_ABORTED;
+                break;
+            }
+
+            if (!wtap_dump_file_write(pdh, hdr, hdr_len, err) ||
+                !wtap_dump_file_write(pdh, data, rec_len - hdr_len, err)) {
+                status = MERGE_ERR_CANT_WRITE_OUTFILE;
+                break;
+            }
+            pdh->bytes_dumped += rec_len;
+        }
+    }
+    g_free(data);
+
+    return merge_finish(pdh, status, in_files, in_file_count,
+                        status == MERGE_OK ? NULL : in_file, count,
+                        cb, err, err_info, err_fileno, err_framenum);
+}
+
+/*
+ * Close the output file, and then the input files, once the records have
+ * been written, and set *err_fileno and *err_framenum to where any error
+ * was.
+ */
+static merge_result
+merge_finish(wtap_dumper *pdh, merge_result status,
+             merge_in_file_t *in_files, const guint in_file_count,
+             const merge_in_file_t *in_file, const int count,
+             merge_progress_callback_t* cb,
+             int *err, gchar **err_info, guint *err_fileno,
+             guint32 *err_framenum)
+{
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
 
@@ -1078,6 +1515,7 @@ merge_files_common(const gchar* out_filename, /* filename in normal output mode,
     int                 frame_type = WTAP_ENCAP_PER_PACKET;
     merge_result        status = MERGE_OK;
     wtap_dumper        *pdh;
+    raw_copy_format_e   raw_format = RAW_COPY_NONE;
     GArray             *shb_hdrs = NULL;
     wtapng_iface_descriptions_t *idb_inf = NULL;
     GArray             *dsb_combined = NULL;
@@ -1175,14 +1613,25 @@ merge_files_common(const gchar* out_filename, /* filename in normal output mode,
         return MERGE_ERR_CANT_OPEN_OUTFILE;
     }
 
+    if (do_append) {
+        /* Concatenating files of the output type may need no re-encoding. */
+        raw_format = merge_raw_copy_format(in_files, in_file_count, file_type, snaplen);
+    }
+
     if (cb)
         cb->callback_func(MERGE_EVENT_READY_TO_MERGE, 0, in_files, in_file_count, cb->data);
 
-    status = merge_process_packets(pdh, file_type, in_files, in_file_count,
-                                   do_append, mode, snaplen, cb,
-                                   idb_inf, dsb_combined,
-                                   err, err_info,
-                                   err_fileno, err_framenum);
+    if (raw_format != RAW_COPY_NONE) {
+        status = merge_copy_raw_packets(pdh, raw_format, in_files, in_file_count,
+                                        cb, err, err_info,
+                                        err_fileno, err_framenum);
+    } else {
+        status = merge_process_packets(pdh, file_type, in_files, in_file_count,
+                                       do_append, mode, snaplen, cb,
+                                       idb_inf, dsb_combined,
+                                       err, err_info,
+                                       err_fileno, err_framenum);
+    }
 
     g_free(in_files);
     wtap_block_array_free(shb_hdrs);
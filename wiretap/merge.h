@@ -30,8 +30,10 @@ typedef enum {
 typedef struct merge_in_file_s {
     const char     *filename;
     wtap           *wth;
-    wtap_rec        rec;
-    Buffer          frame_buffer;
+    wtap_rec_batch  batch;          /* records read ahead from this file */
+    guint           batch_pos;      /* index in batch of the current record */
+    int             batch_err;      /* error that cut the last batch short, or 0 */
+    gchar          *batch_err_info;
     in_file_state_e state;
     guint32         packet_num;     /* current packet number */
     gint64          size;           /* file size */
@@ -2643,6 +2643,46 @@ pcap_read_post_process(gboolean is_nokia, int wtap_encap,
 	}
 }
 
+/*
+ * Does pcap_read_post_process() change the packet data for this
+ * encapsulation, or does it only look at it?  If it only looks at it,
+ * the data can be handed out in place, e.g. from a memory mapping.
+ */
+gboolean
+pcap_read_post_process_modifies_data(int wtap_encap, gboolean bytes_swapped)
+{
+	if (!bytes_swapped)
+		return FALSE;
+
+	switch (wtap_encap) {
+
+	case WTAP_ENCAP_SLL:
+	case WTAP_ENCAP_SLL2:
+	case WTAP_ENCAP_USB_LINUX:
+	case WTAP_ENCAP_USB_LINUX_MMAPPED:
+	case WTAP_ENCAP_NFLOG:
+	case WTAP_ENCAP_PFLOG:
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Does pcap_read_post_process() look at the packet data, so that it
+ * can't be skipped?
+ */
+gboolean
+pcap_read_post_process_needs_data(int wtap_encap, gboolean bytes_swapped)
+{
+	switch (wtap_encap) {
+
+	case WTAP_ENCAP_ATM_PDUS:
+	case WTAP_ENCAP_USB_LINUX_MMAPPED:
+		return TRUE;
+	}
+	return pcap_read_post_process_modifies_data(wtap_encap, bytes_swapped);
+}
+
 gboolean
 wtap_encap_requires_phdr(int wtap_encap)
 {
@@ -43,6 +43,9 @@
 static gboolean
 pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
             gchar **err_info, gint64 *data_offset);
+static void
+pcapng_read_batch(wtap *wth, wtap_rec_batch *batch, int *err,
+                  gchar **err_info);
 static gboolean
 pcapng_seek_read(wtap *wth, gint64 seek_off,
                  wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
@@ -134,6 +137,55 @@ typedef struct pcapng_custom_block_s {
 
 #define MIN_CB_SIZE     ((guint32)(MIN_BLOCK_SIZE + sizeof(pcapng_custom_block_t)))
 
+/*
+ * Record index block.
+ *
+ * This isn't a standard block type; it uses a block type from the
+ * local use range, so other readers will skip it.  We write it, if
+ * asked to, at the end of a file, as a chain of one or more blocks
+ * listing the offset and time stamp of every record in the file, so
+ * that a reader can go straight to a given record, or binary-search
+ * for a time, without reading the whole file.
+ *
+ * Each block records its own offset; we only use the index if the
+ * last block of the file is an index block found at the offset it
+ * claims, so files that were concatenated or had blocks appended
+ * after being written aren't given a bogus index.
+ */
+#define BLOCK_TYPE_IDX          0x80000001
+
+typedef struct pcapng_record_index_block_s {
+    guint64 self_offset;        /* offset of this block in the file */
+    guint64 prev_offset;        /* offset of the previous index block, or IDX_NO_PREV */
+    guint32 first_record;       /* number, counting from 0, of the first record listed */
+    guint32 num_entries;        /* number of records listed in this block */
+    guint32 flags;
+    guint32 reserved;
+    /* ... Entries ... */
+} pcapng_record_index_block_t;
+
+typedef struct pcapng_record_index_entry_s {
+    guint64 offset;             /* offset of the block for the record */
+    gint64  secs;               /* time stamp of the record */
+    guint32 nsecs;
+    guint32 reserved;
+} pcapng_record_index_entry_t;
+
+#define IDX_NO_PREV             G_GUINT64_CONSTANT(0xFFFFFFFFFFFFFFFF)
+#define IDX_FLAG_SORTED         0x00000001  /* time stamps never decrease */
+
+/*
+ * Maximum number of records listed in one index block; this keeps each
+ * block to about 1.5 MiB.
+ */
+#define IDX_MAX_ENTRIES         65536
+
+/*
+ * Minimum index block size = minimum block size + size of fixed length
+ * portion of the index block.
+ */
+#define MIN_IDX_SIZE    ((guint32)(MIN_BLOCK_SIZE + sizeof(pcapng_record_index_block_t)))
+
 /*
  * Minimum ISB size = minimum block size + size of fixed length portion of ISB.
  */
@@ -252,8 +304,15 @@ typedef struct {
     GArray *sections;             /**< Sections found in the capture file. */
     wtap_new_ipv4_callback_t add_new_ipv4;
     wtap_new_ipv6_callback_t add_new_ipv6;
+    wtap_rec_batch *batch;        /**< Batch being read by pcapng_read_batch(), or NULL */
 } pcapng_t;
 
+/* Per-file state for writing */
+typedef struct {
+    GArray *record_index;         /**< pcapng_record_index_entry_t for each record written, or NULL */
+    gboolean record_index_sorted; /**< TRUE if the time stamps of those records never decrease */
+} pcapng_dump_t;
+
 /*
  * Table for plugins to handle particular block types.
  *
@@ -889,52 +948,68 @@ pcapng_process_unhandled_option(wtapng_block_t *wblock _U_,
 }
 #endif
 
-gboolean
-pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
-                       section_info_t *section_info,
-                       guint opt_cont_buf_len,
-                       gboolean (*process_option)(wtapng_block_t *,
-                                                  const section_info_t *,
-                                                  guint16, guint16,
-                                                  const guint8 *,
-                                                  int *, gchar **),
-                       pcapng_opt_byte_order_e byte_order,
-                       int *err, gchar **err_info)
+/*
+ * Get the opt_cont_buf_len bytes of options that follow in the file.
+ * If the file is memory-mapped, *option_ptr points into the mapping
+ * and *option_content is set to NULL; otherwise, the options are read
+ * into a buffer that's returned in *option_content and must be freed.
+ * Either way, *option_ptr is aligned on at least a 4-byte boundary.
+ */
+static gboolean
+pcapng_get_options(FILE_T fh, guint opt_cont_buf_len,
+                   guint8 **option_content, const guint8 **option_ptr,
+                   int *err, gchar **err_info)
+{
+    *option_content = NULL;
+    *option_ptr = file_read_mapped(fh, opt_cont_buf_len);
+    if (*option_ptr == NULL || ((guintptr)*option_ptr & 3) != 0) {
+        /* Allocate enough memory to hold all options */
+        *option_content = (guint8 *)g_try_malloc(opt_cont_buf_len);
+        if (*option_content == NULL) {
+            *err = ENOMEM;  /* we assume we're out of memory */
+            return FALSE;
+        }
+
+        if (*option_ptr != NULL) {
+            /* Mapped, but misaligned (blocks should be padded, though) */
+            memcpy(*option_content, *option_ptr, opt_cont_buf_len);
+        } else {
+            /* Read all the options into the buffer */
+            if (!wtap_read_bytes(fh, *option_content, opt_cont_buf_len, err, err_info)) {
+                ws_debug("failed to read options");
+                g_free(*option_content);
+                *option_content = NULL;
+                return FALSE;
+            }
+        }
+        *option_ptr = *option_content;
+    }
+    return TRUE;
+}
+
+static gboolean
+pcapng_process_options_buffer(wtapng_block_t *wblock,
+                              section_info_t *section_info,
+                              const guint8 *option_ptr,
+                              guint opt_cont_buf_len,
+                              gboolean (*process_option)(wtapng_block_t *,
+                                                         const section_info_t *,
+                                                         guint16, guint16,
+                                                         const guint8 *,
+                                                         int *, gchar **),
+                              pcapng_opt_byte_order_e byte_order,
+                              int *err, gchar **err_info)
 {
-    guint8 *option_content; /* Allocate as large as the options block */
     guint opt_bytes_remaining;
-    const guint8 *option_ptr;
     const pcapng_option_header_t *oh;
     guint16 option_code, option_length;
     guint rounded_option_length;
 
-    ws_debug("Options %u bytes", opt_cont_buf_len);
-    if (opt_cont_buf_len == 0) {
-        /* No options, so nothing to do */
-        return TRUE;
-    }
-
-    /* Allocate enough memory to hold all options */
-    option_content = (guint8 *)g_try_malloc(opt_cont_buf_len);
-    if (option_content == NULL) {
-        *err = ENOMEM;  /* we assume we're out of memory */
-        return FALSE;
-    }
-
-    /* Read all the options into the buffer */
-    if (!wtap_read_bytes(fh, option_content, opt_cont_buf_len, err, err_info)) {
-        ws_debug("failed to read options");
-        g_free(option_content);
-        return FALSE;
-    }
-
     /*
-     * Now process them.
-     * option_ptr starts out aligned on at least a 4-byte boundary, as
-     * that's what g_try_malloc() gives us, and each option is padded
-     * to a length that's a multiple of 4 bytes, so it remains aligned.
+     * option_ptr starts out aligned on at least a 4-byte boundary,
+     * and each option is padded to a length that's a multiple of
+     * 4 bytes, so it remains aligned.
      */
-    option_ptr = &option_content[0];
     opt_bytes_remaining = opt_cont_buf_len;
     while (opt_bytes_remaining != 0) {
         /* Get option header. */
@@ -943,7 +1018,6 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
         if (sizeof (*oh) > opt_bytes_remaining) {
             *err = WTAP_ERR_BAD_FILE;
             *err_info = ws_strdup_printf("pcapng: Not enough data for option header");
-            g_free(option_content);
             return FALSE;
         }
         option_code = oh->option_code;
@@ -985,7 +1059,6 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
             *err = WTAP_ERR_BAD_FILE;
             *err_info = ws_strdup_printf("pcapng: Not enough data to handle option of length %u",
                                         option_length);
-            g_free(option_content);
             return FALSE;
         }
 
@@ -1010,7 +1083,6 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                                                   option_ptr,
                                                   byte_order,
                                                   err, err_info)) {
-                    g_free(option_content);
                     return FALSE;
                 }
                 break;
@@ -1020,17 +1092,51 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                     !(*process_option)(wblock, (const section_info_t *)section_info, option_code,
                                        option_length, option_ptr,
                                        err, err_info)) {
-                    g_free(option_content);
                     return FALSE;
                 }
         }
         option_ptr += rounded_option_length; /* multiple of 4 bytes, so it remains aligned */
         opt_bytes_remaining -= rounded_option_length;
     }
-    g_free(option_content);
     return TRUE;
 }
 
+gboolean
+pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
+                       section_info_t *section_info,
+                       guint opt_cont_buf_len,
+                       gboolean (*process_option)(wtapng_block_t *,
+                                                  const section_info_t *,
+                                                  guint16, guint16,
+                                                  const guint8 *,
+                                                  int *, gchar **),
+                       pcapng_opt_byte_order_e byte_order,
+                       int *err, gchar **err_info)
+{
+    guint8 *option_content; /* Allocate as large as the options block */
+    const guint8 *option_ptr;
+    gboolean ret;
+
+    ws_debug("Options %u bytes", opt_cont_buf_len);
+    if (opt_cont_buf_len == 0) {
+        /* No options, so nothing to do */
+        return TRUE;
+    }
+
+    /*
+     * If the file is memory-mapped, process the options in place
+     * rather than copying them.
+     */
+    if (!pcapng_get_options(fh, opt_cont_buf_len, &option_content,
+                            &option_ptr, err, err_info))
+        return FALSE;
+    ret = pcapng_process_options_buffer(wblock, section_info, option_ptr,
+                                        opt_cont_buf_len, process_option,
+                                        byte_order, err, err_info);
+    g_free(option_content);
+    return ret;
+}
+
 typedef enum {
     PCAPNG_BLOCK_OK,
     PCAPNG_BLOCK_NOT_SHB,
@@ -1818,6 +1924,130 @@ pcapng_process_packet_block_option(wtapng_block_t *wblock,
     return TRUE;
 }
 
+/*
+ * Per-packet options are decoded only when someone asks for them; most
+ * programs never look at the flags, hashes, drop counts, etc. on each
+ * packet, and decoding them is a bunch of allocations per packet.
+ *
+ * We do that only for blocks whose options are all ones that
+ * pcapng_process_packet_block_option() handles without errors; if
+ * there's anything else, such as custom options or options with a bad
+ * length, the options are processed right away so that handlers get
+ * called and errors get reported as they always have been.
+ */
+#define PCAPNG_DEFERRED_BYTE_SWAPPED 0x00000001
+
+static void
+pcapng_decode_packet_block_options(wtap_block_t block, const guint8 *data,
+                                   guint len, guint32 flags)
+{
+    section_info_t section_info;
+    wtapng_block_t wblock;
+    int err;
+    gchar *err_info = NULL;
+
+    memset(&section_info, 0, sizeof section_info);
+    section_info.byte_swapped = (flags & PCAPNG_DEFERRED_BYTE_SWAPPED) != 0;
+    memset(&wblock, 0, sizeof wblock);
+    wblock.block = block;
+    if (!pcapng_process_options_buffer(&wblock, &section_info, data, len,
+                                       pcapng_process_packet_block_option,
+                                       OPT_SECTION_BYTE_ORDER,
+                                       &err, &err_info)) {
+        /* pcapng_scan_packet_block_options() should have prevented this. */
+        ws_warning("pcapng: error decoding deferred packet options: %s",
+                   err_info != NULL ? err_info : "unknown error");
+        g_free(err_info);
+    }
+}
+
+/*
+ * Check whether the options of a packet block can be decoded later,
+ * and get the value of the packet flags option, if present, as that's
+ * needed now.
+ */
+static gboolean
+pcapng_scan_packet_block_options(const section_info_t *section_info,
+                                 const guint8 *option_ptr,
+                                 guint opt_bytes_remaining,
+                                 gboolean *have_flags, guint32 *flags)
+{
+    const pcapng_option_header_t *oh;
+    guint16 option_code, option_length;
+    guint rounded_option_length;
+    guint32 value;
+
+    *have_flags = FALSE;
+    while (opt_bytes_remaining != 0) {
+        if (sizeof (*oh) > opt_bytes_remaining)
+            return FALSE;
+        oh = (const pcapng_option_header_t *)(const void *)option_ptr;
+        option_code = oh->option_code;
+        option_length = oh->option_length;
+        if (section_info->byte_swapped) {
+            option_code = GUINT16_SWAP_LE_BE(option_code);
+            option_length = GUINT16_SWAP_LE_BE(option_length);
+        }
+        option_ptr += sizeof (*oh);
+        opt_bytes_remaining -= (guint)sizeof (*oh);
+        rounded_option_length = ROUND_TO_4BYTE(option_length);
+        if (rounded_option_length > opt_bytes_remaining)
+            return FALSE;
+
+        switch (option_code) {
+
+        case OPT_EOFOPT:
+            return TRUE;
+
+        case OPT_COMMENT:
+            break;
+
+        case OPT_EPB_FLAGS:
+            if (option_length != 4)
+                return FALSE;
+            if (!*have_flags) {
+                memcpy(&value, option_ptr, sizeof value);
+                if (section_info->byte_swapped)
+                    value = GUINT32_SWAP_LE_BE(value);
+                *flags = value;
+                *have_flags = TRUE;
+            }
+            break;
+
+        case OPT_EPB_QUEUE:
+            if (option_length != 4)
+                return FALSE;
+            break;
+
+        case OPT_EPB_DROPCOUNT:
+        case OPT_EPB_PACKETID:
+            if (option_length != 8)
+                return FALSE;
+            break;
+
+        case OPT_EPB_HASH:
+            if (option_length < 1)
+                return FALSE;
+            break;
+
+        case OPT_EPB_VERDICT:
+            if (option_length < 1)
+                return FALSE;
+            if ((option_ptr[0] == OPT_VERDICT_TYPE_TC ||
+                 option_ptr[0] == OPT_VERDICT_TYPE_XDP) &&
+                option_length != 9)
+                return FALSE;
+            break;
+
+        default:
+            return FALSE;
+        }
+        option_ptr += rounded_option_length;
+        opt_bytes_remaining -= rounded_option_length;
+    }
+    return TRUE;
+}
+
 static gboolean
 pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
                          section_info_t *section_info,
@@ -1831,6 +2061,7 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wtapng_packet_t packet;
     guint32 padding;
     guint32 flags;
+    gboolean have_flags;
     guint64 tmp64;
     interface_info_t iface_info;
     guint64 ts;
@@ -2004,8 +2235,13 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wblock->rec->ts.nsecs = (int)(((ts % iface_info.time_units_per_second) * 1000000000) / iface_info.time_units_per_second);
 
     /* "(Enhanced) Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                packet.cap_len - pseudo_header_len, err, err_info))
+    if (wblock->skip_data &&
+        !pcap_read_post_process_needs_data(iface_info.wtap_encap, section_info->byte_swapped)) {
+        if (!wtap_skip_packet_bytes(fh, wblock->frame_buffer,
+                                    packet.cap_len - pseudo_header_len, err, err_info))
+            return FALSE;
+    } else if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                       packet.cap_len - pseudo_header_len, err, err_info))
         return FALSE;
     block_read += packet.cap_len - pseudo_header_len;
 
@@ -2024,15 +2260,51 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
         (int)sizeof(pcapng_block_header_t) -
         block_read -    /* fixed and variable part, including padding */
         (int)sizeof(bh->block_total_length);
-    if (!pcapng_process_options(fh, wblock, section_info, opt_cont_buf_len,
-                                pcapng_process_packet_block_option,
-                                OPT_SECTION_BYTE_ORDER, err, err_info))
-        return FALSE;
+    have_flags = FALSE;
+    if (enhanced && opt_cont_buf_len != 0) {
+        /*
+         * An EPB has no drop count in its fixed part that we'd have
+         * to add as an option, so we may be able to leave the
+         * options undecoded.
+         */
+        guint8 *option_content;
+        const guint8 *option_ptr;
+        gboolean ok = TRUE;
+
+        if (!pcapng_get_options(fh, opt_cont_buf_len, &option_content,
+                                &option_ptr, err, err_info))
+            return FALSE;
+        if (pcapng_scan_packet_block_options(section_info, option_ptr,
+                                             opt_cont_buf_len,
+                                             &have_flags, &flags)) {
+            wtap_block_set_deferred_options(wblock->block,
+                                            pcapng_decode_packet_block_options,
+                                            option_ptr, opt_cont_buf_len,
+                                            section_info->byte_swapped ? PCAPNG_DEFERRED_BYTE_SWAPPED : 0);
+        } else {
+            have_flags = FALSE;
+            ok = pcapng_process_options_buffer(wblock, section_info,
+                                               option_ptr, opt_cont_buf_len,
+                                               pcapng_process_packet_block_option,
+                                               OPT_SECTION_BYTE_ORDER,
+                                               err, err_info);
+        }
+        g_free(option_content);
+        if (!ok)
+            return FALSE;
+    } else {
+        if (!pcapng_process_options(fh, wblock, section_info, opt_cont_buf_len,
+                                    pcapng_process_packet_block_option,
+                                    OPT_SECTION_BYTE_ORDER, err, err_info))
+            return FALSE;
+    }
 
     /*
      * Did we get a packet flags option?
      */
-    if (WTAP_OPTTYPE_SUCCESS == wtap_block_get_uint32_option_value(wblock->block, OPT_PKT_FLAGS, &flags)) {
+    if (!wtap_block_has_deferred_options(wblock->block))
+        have_flags = (WTAP_OPTTYPE_SUCCESS == wtap_block_get_uint32_option_value(wblock->block, OPT_PKT_FLAGS, &flags));
+    if (have_flags) {
         if (PACK_FLAGS_FCS_LENGTH(flags) != 0) {
             /* The FCS length is present */
             fcslen = PACK_FLAGS_FCS_LENGTH(flags);
@@ -2041,7 +2313,7 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     /*
      * How about a drop_count option? If not, set it from other sources
      */
-    if (WTAP_OPTTYPE_SUCCESS != wtap_block_get_uint64_option_value(wblock->block, OPT_PKT_DROPCOUNT, &tmp64) && packet.drops_count != 0xFFFF) {
+    if (packet.drops_count != 0xFFFF && WTAP_OPTTYPE_SUCCESS != wtap_block_get_uint64_option_value(wblock->block, OPT_PKT_DROPCOUNT, &tmp64)) {
         wtap_block_add_uint64_option(wblock->block, OPT_PKT_DROPCOUNT, (guint64)packet.drops_count);
     }
 
@@ -2185,8 +2457,13 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
 
     /* "Simple Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                simple_packet.cap_len, err, err_info))
+    if (wblock->skip_data &&
+        !pcap_read_post_process_needs_data(iface_info.wtap_encap, section_info->byte_swapped)) {
+        if (!wtap_skip_packet_bytes(fh, wblock->frame_buffer,
+                                    simple_packet.cap_len, err, err_info))
+            return FALSE;
+    } else if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                       simple_packet.cap_len, err, err_info))
         return FALSE;
 
     /* jump over potential padding bytes at end of the packet data */
@@ -3244,6 +3521,18 @@ pcapng_read_block(wtap *wth, FILE_T fh, pcapng_t *pn,
             return FALSE;
         }
 
+        /*
+         * If we're reading a batch, packet data can be read straight
+         * into the batch arena, as it can't be bigger than the block.
+         */
+        if (pn->batch != NULL &&
+            (bh.block_type == BLOCK_TYPE_EPB ||
+             bh.block_type == BLOCK_TYPE_PB ||
+             bh.block_type == BLOCK_TYPE_SPB)) {
+            wblock->frame_buffer = wtap_rec_batch_reserve(pn->batch,
+                                                          bh.block_total_length);
+        }
+
         /*
          * ***DO NOT*** add any items to this table that are not
          * standardized block types in the current pcapng spec at
@@ -3318,6 +3607,149 @@ pcapng_read_block(wtap *wth, FILE_T fh, pcapng_t *pn,
     return TRUE;
 }
 
+/*
+ * Read the record index at the end of the file, if there is one, and
+ * attach it to the wtap.  Errors aren't reported; if there's no usable
+ * index, the file is simply treated as not having one.
+ *
+ * Only the random-access handle is used, so the sequential read
+ * position isn't disturbed.  We don't do this for compressed files, as
+ * the index offsets are offsets in the uncompressed data and we can't
+ * find the end of that without decompressing the whole file.
+ */
+static void
+pcapng_read_record_index(wtap *wth, const section_info_t *section_info)
+{
+    FILE_T fh = wth->random_fh;
+    gint64 file_size;
+    gint64 block_off;
+    guint64 prev_offset = IDX_NO_PREV;
+    guint32 next_record = 0;
+    guint32 block_total_length;
+    pcapng_block_header_t bh;
+    pcapng_record_index_block_t ib;
+    pcapng_record_index_entry_t *entries = NULL;
+    GArray *record_index = NULL;
+    gboolean sorted = TRUE;
+    int err;
+    gchar *err_info = NULL;
+
+    if (fh == NULL || file_iscompressed(wth->fh))
+        return;
+
+    file_size = wtap_file_size(wth, &err);
+    if (file_size < MIN_IDX_SIZE)
+        return;
+
+    block_off = file_size;
+    do {
+        /*
+         * Get the length of the block that ends here from its trailer.
+         */
+        if (file_seek(fh, block_off - (gint64)sizeof block_total_length,
+                      SEEK_SET, &err) < 0)
+            goto fail;
+        if (!wtap_read_bytes(fh, &block_total_length,
+                             sizeof block_total_length, &err, &err_info))
+            goto fail;
+        if (section_info->byte_swapped)
+            block_total_length = GUINT32_SWAP_LE_BE(block_total_length);
+        if (block_total_length < MIN_IDX_SIZE ||
+            block_total_length > block_off)
+            goto fail;
+        block_off -= block_total_length;
+
+        /*
+         * If this isn't the first block we've looked at, it has to be
+         * where the one after it said it was.
+         */
+        if (record_index != NULL && (guint64)block_off != prev_offset)
+            goto fail;
+
+        if (file_seek(fh, block_off, SEEK_SET, &err) < 0)
+            goto fail;
+        if (!wtap_read_bytes(fh, &bh, sizeof bh, &err, &err_info))
+            goto fail;
+        if (!wtap_read_bytes(fh, &ib, sizeof ib, &err, &err_info))
+            goto fail;
+        if (section_info->byte_swapped) {
+            bh.block_type         = GUINT32_SWAP_LE_BE(bh.block_type);
+            bh.block_total_length = GUINT32_SWAP_LE_BE(bh.block_total_length);
+            ib.self_offset        = GUINT64_SWAP_LE_BE(ib.self_offset);
+            ib.prev_offset        = GUINT64_SWAP_LE_BE(ib.prev_offset);
+            ib.first_record       = GUINT32_SWAP_LE_BE(ib.first_record);
+            ib.num_entries        = GUINT32_SWAP_LE_BE(ib.num_entries);
+            ib.flags              = GUINT32_SWAP_LE_BE(ib.flags);
+        }
+        if (bh.block_type != BLOCK_TYPE_IDX ||
+            bh.block_total_length != block_total_length ||
+            ib.self_offset != (guint64)block_off ||
+            ib.num_entries > IDX_MAX_ENTRIES ||
+            block_total_length - MIN_IDX_SIZE != ib.num_entries * sizeof *entries ||
+            ib.num_entries > G_MAXUINT32 - ib.first_record)
+            goto fail;
+
+        if (record_index == NULL) {
+            /*
+             * The last block lists the last records, so it tells us
+             * how many records there are.  Each entry takes up more
+             * than one byte of the file, so don't believe a count
+             * larger than the file.
+             */
+            next_record = ib.first_record + ib.num_entries;
+            if ((guint64)next_record > (guint64)file_size)
+                goto fail;
+            record_index = g_array_sized_new(FALSE, FALSE,
+                                             sizeof(wtap_record_index_entry),
+                                             next_record);
+            g_array_set_size(record_index, next_record);
+            entries = g_new(pcapng_record_index_entry_t, IDX_MAX_ENTRIES);
+        } else if (ib.first_record + ib.num_entries != next_record) {
+            goto fail;
+        }
+
+        if (!wtap_read_bytes(fh, entries, ib.num_entries * sizeof *entries,
+                             &err, &err_info))
+            goto fail;
+        for (guint32 i = 0; i < ib.num_entries; i++) {
+            wtap_record_index_entry *entry;
+
+            if (section_info->byte_swapped) {
+                entries[i].offset = GUINT64_SWAP_LE_BE(entries[i].offset);
+                entries[i].secs   = GUINT64_SWAP_LE_BE(entries[i].secs);
+                entries[i].nsecs  = GUINT32_SWAP_LE_BE(entries[i].nsecs);
+            }
+            if (entries[i].offset >= (guint64)block_off)
+                goto fail;
+            entry = &g_array_index(record_index, wtap_record_index_entry,
+                                   ib.first_record + i);
+            entry->offset = (gint64)entries[i].offset;
+            entry->ts.secs = (time_t)entries[i].secs;
+            entry->ts.nsecs = (int)entries[i].nsecs;
+        }
+        if (!(ib.flags & IDX_FLAG_SORTED))
+            sorted = FALSE;
+
+        next_record = ib.first_record;
+        prev_offset = ib.prev_offset;
+    } while (prev_offset != IDX_NO_PREV);
+
+    if (next_record != 0)
+        goto fail;
+
+    ws_debug("read index of %u records", record_index->len);
+    g_free(entries);
+    wth->record_index = record_index;
+    wth->record_index_sorted = sorted;
+    return;
+
+fail:
+    g_free(err_info);
+    g_free(entries);
+    if (record_index != NULL)
+        g_array_free(record_index, TRUE);
+}
+
 /* Process an IDB that we've just read. The contents of wblock are copied as needed. */
 static void
 pcapng_process_idb(wtap *wth, section_info_t *section_info,
@@ -3422,6 +3854,7 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
     /* we don't expect any packet blocks yet */
     wblock.frame_buffer = NULL;
     wblock.rec = NULL;
+    wblock.skip_data = FALSE;
 
     switch (pcapng_read_section_header_block(wth->fh, &bh, &first_section,
                                              &wblock, err, err_info)) {
@@ -3511,9 +3944,11 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
      */
     pcapng->add_new_ipv4 = NULL;
     pcapng->add_new_ipv6 = NULL;
+    pcapng->batch = NULL;
 
     wth->subtype_read = pcapng_read;
     wth->subtype_seek_read = pcapng_seek_read;
+    wth->subtype_read_batch = pcapng_read_batch;
     wth->subtype_close = pcapng_close;
     wth->file_type_subtype = pcapng_file_type_subtype;
 
@@ -3574,6 +4009,9 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
         ws_debug("Read IDB number_of_interfaces %u, wtap_encap %i",
                  wth->interface_data->len, wth->file_encap);
     }
+
+    pcapng_read_record_index(wth, &g_array_index(pcapng->sections,
+                                                 section_info_t, 0));
     return WTAP_OPEN_MINE;
 }
 
@@ -3592,6 +4030,7 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 
     wblock.frame_buffer  = buf;
     wblock.rec = rec;
+    wblock.skip_data = wth->skip_packet_data;
 
     pcapng->add_new_ipv4 = wth->add_new_ipv4;
     pcapng->add_new_ipv6 = wth->add_new_ipv6;
@@ -3740,6 +4179,27 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     return TRUE;
 }
 
+/* Read a batch of records; packet data goes straight into the batch
+   arena, other records' data is copied there. */
+static void
+pcapng_read_batch(wtap *wth, wtap_rec_batch *batch, int *err,
+                  gchar **err_info)
+{
+    pcapng_t *pcapng = (pcapng_t *)wth->priv;
+    wtap_rec *rec;
+    gint64 data_offset;
+
+    pcapng->batch = batch;
+    while ((rec = wtap_rec_batch_next(wth, batch)) != NULL) {
+        if (!pcapng_read(wth, rec, &batch->buf, err, err_info, &data_offset)) {
+            wtap_rec_batch_discard(batch);
+            break;
+        }
+        wtap_rec_batch_add(batch, data_offset);
+    }
+    pcapng->batch = NULL;
+}
+
 /* classic wtap: seek to file position and read packet */
 static gboolean
 pcapng_seek_read(wtap *wth, gint64 seek_off,
@@ -3790,6 +4250,7 @@ pcapng_seek_read(wtap *wth, gint64 seek_off,
 
     wblock.frame_buffer = buf;
     wblock.rec = rec;
+    wblock.skip_data = FALSE;
 
     /* read the block */
     if (!pcapng_read_block(wth, wth->random_fh, pcapng, section_info,
@@ -5975,6 +6436,8 @@ static gboolean pcapng_dump(wtap_dumper *wdh,
                             const wtap_rec *rec,
                             const guint8 *pd, int *err, gchar **err_info)
 {
+    pcapng_dump_t *pcapng = (pcapng_dump_t *)wdh->priv;
+    gint64 rec_off;
 #ifdef HAVE_PLUGINS
     block_handler *handler;
 #endif
@@ -5998,6 +6461,8 @@ static gboolean pcapng_dump(wtap_dumper *wdh,
              wtap_encap_description(rec->rec_header.packet_header.pkt_encap),
              rec->rec_type);
 
+    rec_off = wdh->bytes_dumped;
+
     switch (rec->rec_type) {
 
         case REC_TYPE_PACKET:
@@ -6066,6 +6531,99 @@ static gboolean pcapng_dump(wtap_dumper *wdh,
             return FALSE;
     }
 
+    /*
+     * If we're indexing the records, and we actually wrote this one
+     * (custom blocks that mustn't be copied are silently dropped),
+     * add it to the index.
+     */
+    if (pcapng != NULL && pcapng->record_index != NULL &&
+        wdh->bytes_dumped != rec_off) {
+        pcapng_record_index_entry_t entry = { 0 };
+        const pcapng_record_index_entry_t *prev = NULL;
+
+        if (pcapng->record_index->len != 0)
+            prev = &g_array_index(pcapng->record_index, pcapng_record_index_entry_t,
+                                  pcapng->record_index->len - 1);
+
+        entry.offset = (guint64)rec_off;
+        if (rec->presence_flags & WTAP_HAS_TS) {
+            entry.secs = (gint64)rec->ts.secs;
+            entry.nsecs = (guint32)rec->ts.nsecs;
+        } else if (prev != NULL) {
+            /* No time stamp; use that of the previous record. */
+            entry.secs = prev->secs;
+            entry.nsecs = prev->nsecs;
+        }
+        if (prev != NULL &&
+            (entry.secs < prev->secs ||
+             (entry.secs == prev->secs && entry.nsecs < prev->nsecs)))
+            pcapng->record_index_sorted = FALSE;
+        if (pcapng->record_index->len == G_MAXUINT32) {
+            /* Too many records to index; don't write an index. */
+            g_array_free(pcapng->record_index, TRUE);
+            pcapng->record_index = NULL;
+        } else {
+            g_array_append_val(pcapng->record_index, entry);
+        }
+    }
+
+    return TRUE;
+}
+
+/*
+ * Write the record index, as a chain of index blocks of at most
+ * IDX_MAX_ENTRIES records each.
+ */
+static gboolean
+pcapng_write_record_index(wtap_dumper *wdh, pcapng_dump_t *pcapng, int *err)
+{
+    GArray *record_index = pcapng->record_index;
+    guint64 prev_offset = IDX_NO_PREV;
+    guint32 first_record, num_entries;
+    pcapng_block_header_t bh;
+    pcapng_record_index_block_t ib;
+
+    for (first_record = 0; first_record < record_index->len;
+         first_record += num_entries) {
+        num_entries = MIN(record_index->len - first_record, IDX_MAX_ENTRIES);
+
+        /* write block header */
+        bh.block_type = BLOCK_TYPE_IDX;
+        bh.block_total_length = MIN_IDX_SIZE +
+            num_entries * (guint32)sizeof(pcapng_record_index_entry_t);
+
+        ib.self_offset = (guint64)wdh->bytes_dumped;
+        ib.prev_offset = prev_offset;
+        ib.first_record = first_record;
+        ib.num_entries = num_entries;
+        ib.flags = pcapng->record_index_sorted ? IDX_FLAG_SORTED : 0;
+        ib.reserved = 0;
+
+        if (!wtap_dump_file_write(wdh, &bh, sizeof bh, err))
+            return FALSE;
+        wdh->bytes_dumped += sizeof bh;
+
+        /* write block fixed content */
+        if (!wtap_dump_file_write(wdh, &ib, sizeof ib, err))
+            return FALSE;
+        wdh->bytes_dumped += sizeof ib;
+
+        /* write the entries */
+        if (!wtap_dump_file_write(wdh,
+                                  &g_array_index(record_index, pcapng_record_index_entry_t, first_record),
+                                  num_entries * sizeof(pcapng_record_index_entry_t), err))
+            return FALSE;
+        wdh->bytes_dumped += num_entries * sizeof(pcapng_record_index_entry_t);
+
+        /* write block footer */
+        if (!wtap_dump_file_write(wdh, &bh.block_total_length,
+                                  sizeof bh.block_total_length, err))
+            return FALSE;
+        wdh->bytes_dumped += sizeof bh.block_total_length;
+
+        prev_offset = ib.self_offset;
+    }
+
     return TRUE;
 }
 
@@ -6074,6 +6632,8 @@ static gboolean pcapng_dump(wtap_dumper *wdh,
 static gboolean pcapng_dump_finish(wtap_dumper *wdh, int *err,
                                    gchar **err_info _U_)
 {
+    pcapng_dump_t *pcapng = (pcapng_dump_t *)wdh->priv;
+    gboolean ret = TRUE;
     guint i, j;
 
     /* Flush any hostname resolution info we may have */
@@ -6095,13 +6655,25 @@ static gboolean pcapng_dump_finish(wtap_dumper *wdh, int *err,
             ws_debug("write ISB for interface %u",
                      ((wtapng_if_stats_mandatory_t*)wtap_block_get_mandatory_data(if_stats))->interface_id);
             if (!pcapng_write_interface_statistics_block(wdh, if_stats, err)) {
-                return FALSE;
+                ret = FALSE;
+                goto done;
             }
         }
     }
 
+    /* The record index has to be the last thing in the file. */
+    if (pcapng != NULL && pcapng->record_index != NULL) {
+        if (!pcapng_write_record_index(wdh, pcapng, err))
+            ret = FALSE;
+    }
+
+done:
+    if (pcapng != NULL && pcapng->record_index != NULL) {
+        g_array_free(pcapng->record_index, TRUE);
+        pcapng->record_index = NULL;
+    }
     ws_debug("leaving function");
-    return TRUE;
+    return ret;
 }
 
 /* Returns TRUE on success, FALSE on failure; sets "*err" to an error code on
@@ -6117,6 +6689,15 @@ pcapng_dump_open(wtap_dumper *wdh, int *err, gchar **err_info _U_)
     wdh->subtype_write = pcapng_dump;
     wdh->subtype_finish = pcapng_dump_finish;
 
+    if (wdh->write_record_index) {
+        pcapng_dump_t *pcapng = g_new0(pcapng_dump_t, 1);
+
+        pcapng->record_index = g_array_new(FALSE, FALSE,
+                                           sizeof(pcapng_record_index_entry_t));
+        pcapng->record_index_sorted = TRUE;
+        wdh->priv = pcapng;
+    }
+
     /* write the section header block */
     if (!pcapng_write_section_header_block(wdh, err)) {
         return FALSE;
@@ -52,6 +52,7 @@ typedef struct wtapng_block_s {
     wtap_block_t block;
     wtap_rec     *rec;
     Buffer       *frame_buffer;
+    gboolean     skip_data;      /* TRUE if packet data needn't be read */
 } wtapng_block_t;
 
 /* Section data in private struct */
@@ -29,6 +29,8 @@ typedef gboolean (*subtype_read_func)(struct wtap*, wtap_rec *,
                                       Buffer *, int *, char **, gint64 *);
 typedef gboolean (*subtype_seek_read_func)(struct wtap*, gint64, wtap_rec *,
                                            Buffer *, int *, char **);
+typedef void (*subtype_read_batch_func)(struct wtap*, wtap_rec_batch *,
+                                        int *, char **);
 
 /**
  * Struct holding data of the currently read file.
@@ -52,6 +54,7 @@ struct wtap {
 
     subtype_read_func           subtype_read;
     subtype_seek_read_func      subtype_seek_read;
+    subtype_read_batch_func     subtype_read_batch;     /**< Read a batch of records, or NULL to use subtype_read for each */
     void                        (*subtype_sequential_close)(struct wtap*);
     void                        (*subtype_close)(struct wtap*);
     int                         file_encap;    /* per-file, for those
@@ -74,6 +77,10 @@ struct wtap {
     wtap_new_ipv6_callback_t    add_new_ipv6;
     wtap_new_secrets_callback_t add_new_secrets;
     GPtrArray                   *fast_seek;
+    gboolean                    fast_seek_from_index;   /**< TRUE if fast_seek was restored from an index file */
+    GArray                      *record_index;          /**< wtap_record_index_entry for each record, from the file's own index, or NULL */
+    gboolean                    record_index_sorted;    /**< TRUE if the time stamps in record_index never decrease */
+    gboolean                    skip_packet_data;       /**< TRUE if wtap_read() callers don't want packet data */
 };
 
 struct wtap_dumper;
@@ -98,6 +105,9 @@ struct wtap_dumper {
     int                     encap;
     wtap_compression_type   compression_type;
     gboolean                needs_reload;    /* TRUE if the file requires re-loading after saving with wtap */
+    gboolean                write_record_index; /* TRUE if the subtype should write a record index, if it can */
+    gboolean                threaded_write;     /* TRUE if output should be written on a separate thread */
+    struct wtap_dump_async *async;              /* writer thread state, if writing on a separate thread */
     gint64                  bytes_dumped;
 
     void                    *priv;           /* this one holds per-file state and is free'd automatically by wtap_dump_close() */
@@ -121,6 +131,27 @@ struct wtap_dumper {
     guint                   dsbs_growing_written;   /**< Number of already processed DSBs in dsbs_growing. */
 };
 
+/*
+ * Helpers for subtype_read_batch routines.
+ *
+ * wtap_rec_batch_next() returns the next record of the batch, set up
+ * for reading, or NULL if the batch is full.
+ *
+ * wtap_rec_batch_reserve() makes sure the batch arena has room for
+ * space bytes of data for that record, and returns a Buffer such that
+ * reading no more than that much data into it puts the data straight
+ * into the arena.  If it isn't called, the data should be read into
+ * batch->buf, and is copied into the arena.
+ *
+ * wtap_rec_batch_add() adds the record, which was read from the
+ * given offset, to the batch; wtap_rec_batch_discard() cleans up after
+ * a read of the record that failed.
+ */
+wtap_rec *wtap_rec_batch_next(wtap *wth, wtap_rec_batch *batch);
+Buffer *wtap_rec_batch_reserve(wtap_rec_batch *batch, gsize space);
+void wtap_rec_batch_add(wtap_rec_batch *batch, gint64 offset);
+void wtap_rec_batch_discard(wtap_rec_batch *batch);
+
 WS_DLL_PUBLIC gboolean wtap_dump_file_write(wtap_dumper *wdh, const void *buf,
     size_t bufsize, int *err);
 WS_DLL_PUBLIC gint64 wtap_dump_file_seek(wtap_dumper *wdh, gint64 offset, int whence, int *err);
@@ -319,6 +350,31 @@ gboolean
 wtap_read_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
     gchar **err_info);
 
+/*
+ * Skip over packet data, for readers whose callers have said they don't
+ * want it with wtap_set_skip_packet_data(); the Buffer is left empty.
+ * Errors are reported as wtap_read_packet_bytes() reports them.
+ */
+WS_DLL_PUBLIC
+gboolean
+wtap_skip_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
+    gchar **err_info);
+
+/*
+ * Like wtap_read_packet_bytes(), but if the data is in a memory mapping
+ * of the file, make the Buffer refer to it in place rather than copying
+ * it; see ws_buffer_borrow().
+ *
+ * The mapping stays around until the file is closed, so the data stays
+ * valid until then, or until the Buffer is reused.  The mapping is
+ * read-only; callers that modify the data must first get the Buffer's
+ * own copy of it with ws_buffer_assure_space().
+ */
+WS_DLL_PUBLIC
+gboolean
+wtap_read_packet_bytes_in_place(FILE_T fh, Buffer *buf, guint length, int *err,
+    gchar **err_info);
+
 /*
  * Implementation of wth->subtype_read that reads the full file contents
  * as a single packet.
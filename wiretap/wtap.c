@@ -19,6 +19,7 @@
 #include "file_wrappers.h"
 #include <wsutil/file_util.h>
 #include <wsutil/buffer.h>
+#include <wsutil/perf_stats.h>
 #include <wsutil/ws_assert.h>
 #include <wsutil/wslog.h>
 #ifdef HAVE_PLUGINS
@@ -116,6 +117,58 @@ wtap_file_tsprec(wtap *wth)
 	return wth->file_tsprec;
 }
 
+guint32
+wtap_get_record_index_count(wtap *wth)
+{
+	if (wth->record_index == NULL)
+		return 0;
+	return wth->record_index->len;
+}
+
+const wtap_record_index_entry *
+wtap_get_record_index_entry(wtap *wth, guint32 recnum)
+{
+	if (wth->record_index == NULL || recnum >= wth->record_index->len)
+		return NULL;
+	return &g_array_index(wth->record_index, wtap_record_index_entry, recnum);
+}
+
+gboolean
+wtap_find_record_index_by_time(wtap *wth, const nstime_t *ts, guint32 *recnum)
+{
+	GArray *record_index = wth->record_index;
+	guint32 lo, hi;
+
+	if (record_index == NULL)
+		return FALSE;
+
+	if (!wth->record_index_sorted) {
+		/* No choice but to look at every entry. */
+		for (guint32 i = 0; i < record_index->len; i++) {
+			if (nstime_cmp(&g_array_index(record_index, wtap_record_index_entry, i).ts, ts) >= 0) {
+				*recnum = i;
+				return TRUE;
+			}
+		}
+		return FALSE;
+	}
+
+	lo = 0;
+	hi = record_index->len;
+	while (lo < hi) {
+		guint32 mid = lo + (hi - lo) / 2;
+
+		if (nstime_cmp(&g_array_index(record_index, wtap_record_index_entry, mid).ts, ts) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == record_index->len)
+		return FALSE;
+	*recnum = lo;
+	return TRUE;
+}
+
 guint
 wtap_file_get_num_shbs(wtap *wth)
 {
@@ -1427,6 +1480,12 @@ wtap_sequential_close(wtap *wth)
 		(*wth->subtype_sequential_close)(wth);
 
 	if (wth->fh != NULL) {
+		/*
+		 * If we've read through the whole file, we've seen all
+		 * the seek points, so save them for next time.
+		 */
+		if (wth->fast_seek != NULL && !wth->fast_seek_from_index)
+			file_fast_seek_save(wth->fh, wth->pathname, wth->fast_seek);
 		file_close(wth->fh);
 		wth->fh = NULL;
 	}
@@ -1473,6 +1532,9 @@ wtap_close(wtap *wth)
 		g_ptr_array_free(wth->fast_seek, TRUE);
 	}
 
+	if (wth->record_index != NULL)
+		g_array_free(wth->record_index, TRUE);
+
 	wtap_block_array_free(wth->shb_hdrs);
 	wtap_block_array_free(wth->nrb_hdrs);
 	wtap_block_array_free(wth->interface_data);
@@ -1487,6 +1549,26 @@ wtap_cleareof(wtap *wth) {
 	file_clearerr(wth->fh);
 }
 
+gint64
+wtap_sequential_tell(wtap *wth)
+{
+	return file_tell(wth->fh);
+}
+
+gboolean
+wtap_sequential_seek(wtap *wth, gint64 offset, int *err)
+{
+	if (file_seek(wth->fh, offset, SEEK_SET, err) == -1)
+		return FALSE;
+	file_clearerr(wth->fh);
+	return TRUE;
+}
+
+void
+wtap_set_live_ring(wtap *wth, ws_shm_ring *ring) {
+	file_set_live_ring(wth->fh, ring);
+}
+
 void wtap_set_cb_new_ipv4(wtap *wth, wtap_new_ipv4_callback_t add_new_ipv4) {
 	if (wth)
 		wth->add_new_ipv4 = add_new_ipv4;
@@ -1497,6 +1579,11 @@ void wtap_set_cb_new_ipv6(wtap *wth, wtap_new_ipv6_callback_t add_new_ipv6) {
 		wth->add_new_ipv6 = add_new_ipv6;
 }
 
+void wtap_set_skip_packet_data(wtap *wth, gboolean skip) {
+	if (wth)
+		wth->skip_packet_data = skip;
+}
+
 void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secrets) {
 	/* Is a valid wth given that supports DSBs? */
 	if (!wth || !wth->dsbs)
@@ -1596,9 +1683,186 @@ wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 		ws_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_PER_PACKET);
 	}
 
+	ws_perf_add(WS_PERF_RECORDS_READ, 1);
 	return TRUE;	/* success */
 }
 
+/*
+ * Number of bytes of data a record has in the buffer handed to the
+ * read routine; this matches what frame_data_init() uses as the
+ * captured length.
+ */
+static guint32
+wtap_rec_data_length(const wtap_rec *rec)
+{
+	switch (rec->rec_type) {
+
+	case REC_TYPE_PACKET:
+		return rec->rec_header.packet_header.caplen;
+
+	case REC_TYPE_FT_SPECIFIC_EVENT:
+	case REC_TYPE_FT_SPECIFIC_REPORT:
+		return rec->rec_header.ft_specific_header.record_len;
+
+	case REC_TYPE_SYSCALL:
+		return rec->rec_header.syscall_header.event_filelen;
+
+	case REC_TYPE_SYSTEMD_JOURNAL_EXPORT:
+		return rec->rec_header.systemd_journal_export_header.record_len;
+
+	case REC_TYPE_CUSTOM_BLOCK:
+		if (rec->rec_header.custom_block_header.pen == PEN_NFLX)
+			return rec->rec_header.custom_block_header.length - 4;
+		return rec->rec_header.custom_block_header.length;
+	}
+	return 0;
+}
+
+void
+wtap_rec_batch_init(wtap_rec_batch *batch, guint capacity)
+{
+	ws_assert(capacity > 0);
+
+	batch->capacity = capacity;
+	batch->count = 0;
+	batch->recs = g_new(wtap_rec, capacity);
+	for (guint i = 0; i < capacity; i++)
+		wtap_rec_init(&batch->recs[i]);
+	batch->offsets = g_new(gint64, capacity);
+	batch->data_offsets = g_new0(gsize, capacity + 1);
+	ws_buffer_init(&batch->arena, 65536);
+	ws_buffer_init(&batch->buf, 1514);
+	memset(&batch->view, 0, sizeof batch->view);
+	batch->reserved = FALSE;
+}
+
+void
+wtap_rec_batch_cleanup(wtap_rec_batch *batch)
+{
+	for (guint i = 0; i < batch->capacity; i++)
+		wtap_rec_cleanup(&batch->recs[i]);
+	g_free(batch->recs);
+	g_free(batch->offsets);
+	g_free(batch->data_offsets);
+	ws_buffer_free(&batch->arena);
+	ws_buffer_free(&batch->buf);
+	batch->recs = NULL;
+	batch->offsets = NULL;
+	batch->data_offsets = NULL;
+	batch->capacity = 0;
+	batch->count = 0;
+}
+
+const guint8 *
+wtap_rec_batch_data(const wtap_rec_batch *batch, guint i)
+{
+	ws_assert(i < batch->count);
+	return batch->arena.data + batch->data_offsets[i];
+}
+
+wtap_rec *
+wtap_rec_batch_next(wtap *wth, wtap_rec_batch *batch)
+{
+	wtap_rec *rec;
+
+	if (batch->count >= batch->capacity)
+		return NULL;
+
+	/*
+	 * Release what the previous batch left in this record, and
+	 * initialize it the way wtap_read() does.
+	 */
+	rec = &batch->recs[batch->count];
+	wtap_rec_reset(rec);
+	wtap_init_rec(wth, rec);
+	batch->reserved = FALSE;
+	return rec;
+}
+
+Buffer *
+wtap_rec_batch_reserve(wtap_rec_batch *batch, gsize space)
+{
+	/*
+	 * The arena's start is always 0, so this only ever grows the
+	 * allocation; it never moves the data that's already there.
+	 *
+	 * The view is never freed or grown; a reader that asks for no
+	 * more than space bytes leaves ws_buffer_assure_space() nothing
+	 * to do.
+	 */
+	ws_buffer_assure_space(&batch->arena, space);
+	batch->view.data = ws_buffer_end_ptr(&batch->arena);
+	batch->view.allocated = batch->arena.allocated - batch->arena.first_free;
+	batch->view.start = 0;
+	batch->view.first_free = 0;
+	batch->reserved = TRUE;
+	return &batch->view;
+}
+
+void
+wtap_rec_batch_add(wtap_rec_batch *batch, gint64 offset)
+{
+	wtap_rec *rec = &batch->recs[batch->count];
+	guint32 data_len = wtap_rec_data_length(rec);
+
+	if (rec->rec_type == REC_TYPE_PACKET) {
+		/* See wtap_read(). */
+		ws_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_PER_PACKET);
+	}
+
+	if (batch->reserved)
+		ws_buffer_increase_length(&batch->arena, data_len);
+	else
+		ws_buffer_append(&batch->arena, ws_buffer_start_ptr(&batch->buf), data_len);
+	batch->offsets[batch->count] = offset;
+	batch->count++;
+	batch->data_offsets[batch->count] = batch->arena.first_free;
+}
+
+void
+wtap_rec_batch_discard(wtap_rec_batch *batch)
+{
+	/*
+	 * Unreference any block created for this record.
+	 */
+	wtap_rec_reset(&batch->recs[batch->count]);
+}
+
+guint
+wtap_read_batch(wtap *wth, wtap_rec_batch *batch, int *err, gchar **err_info)
+{
+	wtap_rec *rec;
+	gint64 offset;
+
+	batch->count = 0;
+	batch->data_offsets[0] = 0;
+	ws_buffer_clean(&batch->arena);
+
+	*err = 0;
+	*err_info = NULL;
+	if (wth->subtype_read_batch != NULL) {
+		(*wth->subtype_read_batch)(wth, batch, err, err_info);
+	} else {
+		while ((rec = wtap_rec_batch_next(wth, batch)) != NULL) {
+			if (!wth->subtype_read(wth, rec, &batch->buf, err,
+			    err_info, &offset)) {
+				wtap_rec_batch_discard(batch);
+				break;
+			}
+			wtap_rec_batch_add(batch, offset);
+		}
+	}
+
+	/*
+	 * If the batch was cut short without an error indication, we
+	 * reached the end of the file; see if there's any deferred
+	 * error, as wtap_read() does.
+	 */
+	if (batch->count < batch->capacity && *err == 0)
+		*err = file_error(wth->fh, err_info);
+	return batch->count;
+}
+
 /*
  * Read a given number of bytes from a file into a buffer or, if
  * buf is NULL, just discard them.
@@ -1673,11 +1937,38 @@ gboolean
 wtap_read_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
     gchar **err_info)
 {
+	/*
+	 * If the buffer still refers to the previous record's data in
+	 * place, drop that rather than copying it.
+	 */
+	if (ws_buffer_is_borrowed(buf))
+		ws_buffer_clean(buf);
 	ws_buffer_assure_space(buf, length);
 	return wtap_read_bytes(fh, ws_buffer_start_ptr(buf), length, err,
 	    err_info);
 }
 
+gboolean
+wtap_skip_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
+    gchar **err_info)
+{
+	ws_buffer_clean(buf);
+	return wtap_read_bytes(fh, NULL, length, err, err_info);
+}
+
+gboolean
+wtap_read_packet_bytes_in_place(FILE_T fh, Buffer *buf, guint length, int *err,
+    gchar **err_info)
+{
+	const guint8 *data;
+
+	data = file_read_mapped(fh, length);
+	if (data == NULL)
+		return wtap_read_packet_bytes(fh, buf, length, err, err_info);
+	ws_buffer_borrow(buf, data, length);
+	return TRUE;
+}
+
 /*
  * Return an approximation of the amount of data we've read sequentially
  * from the file so far.  (gint64, in case that's 64 bits.)
@@ -14,6 +14,7 @@
 #include <wsutil/buffer.h>
 #include <wsutil/nstime.h>
 #include <wsutil/inet_addr.h>
+#include <wsutil/shm_ring.h>
 #include "wtap_opttypes.h"
 
 #ifdef __cplusplus
@@ -1467,6 +1468,8 @@ typedef struct wtap_dump_params {
                                                  This array may grow since the dumper was opened and will subsequently
                                                  be written before newer packets are written in wtap_dump. */
     gboolean    dont_copy_idbs;             /**< XXX - don't copy IDBs; this should eventually always be the case. */
+    gboolean    write_record_index;         /**< Write an index of the records at the end of the file, if the file type supports it. */
+    gboolean    threaded_write;             /**< Do the (possibly compressing) writes on a separate thread, if the file type is written sequentially. */
 } wtap_dump_params;
 
 /* Zero-initializer for wtap_dump_params. */
@@ -1746,6 +1749,30 @@ struct wtap* wtap_open_offline(const char *filename, unsigned int type, int *err
 WS_DLL_PUBLIC
 void wtap_cleareof(wtap *wth);
 
+/**
+ * The offset of the next record to be read with wtap_read().  When
+ * tailing a file, a read that fails with WTAP_ERR_SHORT_READ may just
+ * have got to a record that hasn't all been written yet; going back to
+ * this offset with wtap_sequential_seek() lets it be read again later.
+ */
+WS_DLL_PUBLIC
+gint64 wtap_sequential_tell(wtap *wth);
+
+/**
+ * Go back to an offset wtap_sequential_tell() returned, and clear any
+ * error or EOF, so that the next wtap_read() starts from there.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_sequential_seek(wtap *wth, gint64 offset, int *err);
+
+/**
+ * When tailing a file that's being written, read the bytes most recently
+ * written from ring, which the writer is appending them to, rather than
+ * from the file.  Takes ownership of ring.
+ */
+WS_DLL_PUBLIC
+void wtap_set_live_ring(wtap *wth, ws_shm_ring *ring);
+
 /**
  * Set callback functions to add new hostnames. Currently pcapng-only.
  * MUST match add_ipv4_name and add_ipv6_name in addr_resolv.c.
@@ -1766,6 +1793,16 @@ typedef void (*wtap_new_secrets_callback_t)(guint32 secrets_type, const void *se
 WS_DLL_PUBLIC
 void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secrets);
 
+/**
+ * Say whether the caller of wtap_read() wants the packet data, or only
+ * the records' metadata (time stamps, lengths, interfaces and so on).
+ * If it doesn't, readers that can skip over the data do so, leaving the
+ * Buffer empty although the record's captured length is filled in as
+ * usual; others read it anyway.  wtap_seek_read() always reads the data.
+ */
+WS_DLL_PUBLIC
+void wtap_set_skip_packet_data(wtap *wth, gboolean skip);
+
 /** Read the next record in the file, filling in *phdr and *buf.
  *
  * @wth a wtap * returned by a call that opened a file for reading.
@@ -1785,6 +1822,61 @@ WS_DLL_PUBLIC
 gboolean wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     gchar **err_info, gint64 *offset);
 
+/**
+ * A batch of records, filled in by wtap_read_batch().
+ *
+ * The data for all the records in a batch is stored contiguously in a
+ * single arena.  The records and the arena are reused from one batch to
+ * the next, so the records and their data are only valid until the next
+ * call to wtap_read_batch() or wtap_rec_batch_cleanup().
+ */
+typedef struct wtap_rec_batch {
+    guint     capacity;         /**< Maximum number of records in a batch */
+    guint     count;            /**< Number of records in the current batch */
+    wtap_rec *recs;             /**< The records */
+    gint64   *offsets;          /**< Offset of each record, for wtap_seek_read() */
+    gsize    *data_offsets;     /**< Offset of each record's data in the arena; there are count + 1 of these, the last being the end of the data */
+    Buffer    arena;            /**< Data for all the records in the batch */
+
+    /* For use by libwiretap only */
+    Buffer    buf;              /**< Scratch buffer for readers that can't read into the arena */
+    Buffer    view;             /**< The part of the arena reserved for the current record */
+    gboolean  reserved;         /**< TRUE if the current record's data is being read into view */
+} wtap_rec_batch;
+
+/** Initialize a batch that holds up to capacity records. */
+WS_DLL_PUBLIC
+void wtap_rec_batch_init(wtap_rec_batch *batch, guint capacity);
+
+/** Free everything wtap_rec_batch_init() and wtap_read_batch() allocated. */
+WS_DLL_PUBLIC
+void wtap_rec_batch_cleanup(wtap_rec_batch *batch);
+
+/** Return a pointer to the data for the i'th record of a batch. */
+WS_DLL_PUBLIC
+const guint8 *wtap_rec_batch_data(const wtap_rec_batch *batch, guint i);
+
+/** Read up to batch->capacity records, replacing the previous contents
+ * of the batch.
+ *
+ * This returns the same records wtap_read() would, but with less
+ * per-record overhead; for some file types, the records' data is read
+ * directly into the batch arena.
+ *
+ * @param wth a wtap * returned by a call that opened a file for reading.
+ * @param batch the batch to fill in.
+ * @param err set to 0 if the batch isn't full because the end of the
+ * file was reached, or to a positive "errno" value or a negative
+ * number indicating the type of error if an error stopped the batch
+ * short.  The records that were read are valid either way.
+ * @param err_info for some errors, a string giving more details of
+ * the error.
+ * @return the number of records read, which is also put in batch->count.
+ */
+WS_DLL_PUBLIC
+guint wtap_read_batch(wtap *wth, wtap_rec_batch *batch, int *err,
+    gchar **err_info);
+
 /** Read the record at a specified offset in a capture file, filling in
  * *phdr and *buf.
  *
@@ -1833,11 +1925,55 @@ WS_DLL_PUBLIC
 const char *wtap_compression_type_description(wtap_compression_type compression_type);
 WS_DLL_PUBLIC
 const char *wtap_compression_type_extension(wtap_compression_type compression_type);
+
+/**
+ * Look up a compression type by name ("gzip", "zstd", or "lz4").
+ *
+ * @return WTAP_UNCOMPRESSED if the name isn't that of a compression
+ * type we support.
+ */
+WS_DLL_PUBLIC
+wtap_compression_type wtap_name_to_compression_type(const char *name);
 WS_DLL_PUBLIC
 GSList *wtap_get_all_compression_type_extensions_list(void);
 
 /*** get various information snippets about the current file ***/
 
+/**
+ * An entry in the index of records that some files (currently, pcapng
+ * files written with wtap_dump_params.write_record_index set) carry.
+ */
+typedef struct wtap_record_index_entry {
+    gint64   offset;    /**< Offset of the record, for wtap_seek_read() */
+    nstime_t ts;        /**< Time stamp of the record */
+} wtap_record_index_entry;
+
+/**
+ * Return the number of records in the file's record index, or 0 if the
+ * file doesn't have one.  Only files opened for random access have their
+ * index read.
+ */
+WS_DLL_PUBLIC
+guint32 wtap_get_record_index_count(wtap *wth);
+
+/**
+ * Return the index entry for a record, counting from 0, or NULL if the
+ * file has no index or not that many records.
+ */
+WS_DLL_PUBLIC
+const wtap_record_index_entry *wtap_get_record_index_entry(wtap *wth, guint32 recnum);
+
+/**
+ * Find, using the record index, the first record with a time stamp at
+ * or after ts.
+ *
+ * @return TRUE, with the record's number, counting from 0, in *recnum,
+ * if there is such a record; FALSE if there isn't, or the file has no
+ * index.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_find_record_index_by_time(wtap *wth, const nstime_t *ts, guint32 *recnum);
+
 /** Return an approximation of the amount of data we've read sequentially
  * from the file so far. */
 WS_DLL_PUBLIC
@@ -2141,6 +2277,31 @@ gboolean wtap_dump(wtap_dumper *, const wtap_rec *, const guint8 *,
      int *err, gchar **err_info);
 WS_DLL_PUBLIC
 gboolean wtap_dump_flush(wtap_dumper *, int *);
+
+/**
+ * @brief Check whether output is backing up.
+ * @details If the dumper was opened with wtap_dump_params.threaded_write
+ * and the writer thread hasn't yet finished with any of its buffers,
+ * the next write that fills a buffer will have to wait for it.  Callers
+ * that can't afford to block, such as capture programs, can use this to
+ * decide to drop or hold back records instead.
+ *
+ * @param wdh The dumper.
+ * @return TRUE if the next write is likely to block, FALSE otherwise
+ * (always FALSE if the dumper doesn't write on a separate thread).
+ */
+WS_DLL_PUBLIC
+gboolean wtap_dump_is_backlogged(wtap_dumper *wdh);
+
+/**
+ * @brief Get the number of times writing had to wait for the writer thread.
+ *
+ * @param wdh The dumper.
+ * @return The number of stalls so far; 0 if the dumper doesn't write on
+ * a separate thread.
+ */
+WS_DLL_PUBLIC
+guint64 wtap_dump_get_stall_count(wtap_dumper *wdh);
 WS_DLL_PUBLIC
 int wtap_dump_file_type_subtype(wtap_dumper *wdh);
 WS_DLL_PUBLIC
@@ -84,6 +84,10 @@ struct wtap_block
     wtap_blocktype_t* info;
     void* mandatory_data;
     GArray* options;
+    wtap_block_option_decoder_func decode_options;  /* if not NULL, raw_options haven't been decoded yet */
+    guint8* raw_options;
+    guint raw_options_len;
+    guint32 raw_options_flags;
     gint ref_count;
 #ifdef DEBUG_COUNT_REFS
     guint id;
@@ -285,6 +289,46 @@ void* wtap_block_get_mandatory_data(wtap_block_t block)
     return block->mandatory_data;
 }
 
+/*
+ * If the block's options were handed to us undecoded, decode them now;
+ * anything that looks at or changes block->options has to do this first.
+ */
+static void
+wtap_block_decode_deferred_options(wtap_block_t block)
+{
+    wtap_block_option_decoder_func decode = block->decode_options;
+
+    if (decode == NULL)
+        return;
+    /* Clear this first; the decoder adds options to the block. */
+    block->decode_options = NULL;
+    decode(block, block->raw_options, block->raw_options_len,
+           block->raw_options_flags);
+    g_free(block->raw_options);
+    block->raw_options = NULL;
+    block->raw_options_len = 0;
+}
+
+void
+wtap_block_set_deferred_options(wtap_block_t block,
+                                wtap_block_option_decoder_func decode,
+                                const guint8 *data, guint len, guint32 flags)
+{
+    wtap_block_decode_deferred_options(block);
+    if (len == 0)
+        return;
+    block->decode_options = decode;
+    block->raw_options = (guint8 *)g_memdup2(data, len);
+    block->raw_options_len = len;
+    block->raw_options_flags = flags;
+}
+
+gboolean
+wtap_block_has_deferred_options(wtap_block_t block)
+{
+    return block != NULL && block->decode_options != NULL;
+}
+
 static wtap_optval_t *
 wtap_block_get_option(wtap_block_t block, guint option_id)
 {
@@ -294,6 +338,7 @@ wtap_block_get_option(wtap_block_t block, guint option_id)
     if (block == NULL) {
         return NULL;
     }
+    wtap_block_decode_deferred_options(block);
 
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
@@ -314,6 +359,7 @@ wtap_block_get_nth_option(wtap_block_t block, guint option_id, guint idx)
     if (block == NULL) {
         return NULL;
     }
+    wtap_block_decode_deferred_options(block);
 
     opt_idx = 0;
     for (i = 0; i < block->options->len; i++) {
@@ -338,6 +384,10 @@ wtap_block_t wtap_block_create(wtap_block_type_t block_type)
     block = g_new(struct wtap_block, 1);
     block->info = blocktype_list[block_type];
     block->options = g_array_new(FALSE, FALSE, sizeof(wtap_option_t));
+    block->decode_options = NULL;
+    block->raw_options = NULL;
+    block->raw_options_len = 0;
+    block->raw_options_flags = 0;
     block->info->create(block);
     block->ref_count = 1;
 #ifdef DEBUG_COUNT_REFS
@@ -440,6 +490,7 @@ void wtap_block_unref(wtap_block_t block)
             g_free(block->mandatory_data);
             wtap_block_free_options(block);
             g_array_free(block->options, TRUE);
+            g_free(block->raw_options);
             g_free(block);
         }
 #ifdef DEBUG_COUNT_REFS
@@ -482,6 +533,8 @@ wtap_block_copy(wtap_block_t dest_block, wtap_block_t src_block)
     /* Copy the options.  For now, don't remove any options that are in destination
      * but not source.
      */
+    wtap_block_decode_deferred_options(dest_block);
+    wtap_block_decode_deferred_options(src_block);
     for (i = 0; i < src_block->options->len; i++)
     {
         src_opt = &g_array_index(src_block->options, wtap_option_t, i);
@@ -562,6 +615,7 @@ wtap_block_count_option(wtap_block_t block, guint option_id)
     if (block == NULL) {
         return 0;
     }
+    wtap_block_decode_deferred_options(block);
 
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
@@ -582,6 +636,7 @@ gboolean wtap_block_foreach_option(wtap_block_t block, wtap_block_foreach_func f
     if (block == NULL) {
         return TRUE;
     }
+    wtap_block_decode_deferred_options(block);
 
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
@@ -602,6 +657,7 @@ wtap_block_add_option_common(wtap_block_t block, guint option_id, wtap_opttype_e
     if (block == NULL) {
         return WTAP_OPTTYPE_BAD_BLOCK;
     }
+    wtap_block_decode_deferred_options(block);
 
     opttype = GET_OPTION_TYPE(block->info->options, option_id);
     if (opttype == NULL) {
@@ -1199,6 +1255,7 @@ wtap_block_get_nflx_custom_option(wtap_block_t block, guint32 nflx_type, char *n
     if (block == NULL) {
         return WTAP_OPTTYPE_BAD_BLOCK;
     }
+    wtap_block_decode_deferred_options(block);
     opttype = GET_OPTION_TYPE(block->info->options, OPT_CUSTOM_BIN_COPY);
     if (opttype == NULL) {
         return WTAP_OPTTYPE_NO_SUCH_OPTION;
@@ -1482,6 +1539,7 @@ wtap_block_remove_option(wtap_block_t block, guint option_id)
     if (block == NULL) {
         return WTAP_OPTTYPE_BAD_BLOCK;
     }
+    wtap_block_decode_deferred_options(block);
 
     opttype = GET_OPTION_TYPE(block->info->options, option_id);
     if (opttype == NULL) {
@@ -1526,6 +1584,7 @@ wtap_block_remove_nth_option_instance(wtap_block_t block, guint option_id,
     if (block == NULL) {
         return WTAP_OPTTYPE_BAD_BLOCK;
     }
+    wtap_block_decode_deferred_options(block);
 
     opttype = GET_OPTION_TYPE(block->info->options, option_id);
     if (opttype == NULL) {
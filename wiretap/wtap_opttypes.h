@@ -1108,6 +1108,40 @@ wtap_block_copy(wtap_block_t dest_block, wtap_block_t src_block);
 WS_DLL_PUBLIC wtap_block_t
 wtap_block_make_copy(wtap_block_t block);
 
+/** Callback that decodes a block's options from raw bytes.
+ *
+ * It's called with the block, and the data, length and flags handed to
+ * wtap_block_set_deferred_options(), and adds the options to the block.
+ * It can't fail; the data should have been checked beforehand.
+ */
+typedef void (*wtap_block_option_decoder_func)(wtap_block_t block, const guint8 *data, guint len, guint32 flags);
+
+/** Give a block its options in undecoded form.
+ *
+ * A copy of the data is kept with the block, and decoded with the given
+ * callback the first time anything looks at or changes the block's
+ * options, so that readers needn't build options nobody uses.  Any
+ * options already deferred are decoded first.
+ *
+ * @param[in] block Block to which to give the options
+ * @param[in] decode Callback to decode the options
+ * @param[in] data Raw option data; if len is 0, nothing is deferred
+ * @param[in] len Length of the raw option data
+ * @param[in] flags Passed to the callback, e.g. the byte order of the data
+ */
+WS_DLL_PUBLIC void
+wtap_block_set_deferred_options(wtap_block_t block,
+                                wtap_block_option_decoder_func decode,
+                                const guint8 *data, guint len, guint32 flags);
+
+/** Check whether a block has options that haven't been decoded yet.
+ *
+ * @param[in] block Block to check
+ * @return TRUE if it has, FALSE if not
+ */
+WS_DLL_PUBLIC gboolean
+wtap_block_has_deferred_options(wtap_block_t block);
+
 typedef gboolean (*wtap_block_foreach_func)(wtap_block_t block, guint option_id, wtap_opttype_e option_type, wtap_optval_t *option, void *user_data);
 WS_DLL_PUBLIC gboolean
 wtap_block_foreach_option(wtap_block_t block, wtap_block_foreach_func func, void* user_data);
@@ -26,6 +26,7 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#define _GNU_SOURCE /* For fwrite_unlocked(). */
 #include <config.h>
 
 #include <stdlib.h>
@@ -188,6 +189,43 @@ write_to_file(FILE* pfile, const guint8* data, size_t data_length,
         return TRUE;
 }
 
+/*
+ * The per-packet writers below make several small writes per packet;
+ * rather than have each of them take the stream's lock, they take it
+ * once per packet and write with the unlocked variant of fwrite().
+ */
+#if defined(_WIN32)
+#define LOCK_FILE(pfile)        _lock_file(pfile)
+#define UNLOCK_FILE(pfile)      _unlock_file(pfile)
+#define FWRITE_UNLOCKED         _fwrite_nolock
+#elif defined(HAVE_FWRITE_UNLOCKED)
+#define LOCK_FILE(pfile)        flockfile(pfile)
+#define UNLOCK_FILE(pfile)      funlockfile(pfile)
+#define FWRITE_UNLOCKED         fwrite_unlocked
+#else
+#define LOCK_FILE(pfile)
+#define UNLOCK_FILE(pfile)
+#define FWRITE_UNLOCKED         fwrite
+#endif
+
+/* Write to capture file, with the stream already locked */
+static gboolean
+write_to_file_unlocked(FILE* pfile, const guint8* data, size_t data_length,
+                       guint64 *bytes_written, int *err)
+{
+        if (FWRITE_UNLOCKED(data, data_length, 1, pfile) != 1) {
+                if (ferror(pfile)) {
+                        *err = errno;
+                } else {
+                        *err = 0;
+                }
+                return FALSE;
+        }
+
+        (*bytes_written) += data_length;
+        return TRUE;
+}
+
 /* Writing pcap files */
 
 /* Write the file header to a dump file.
@@ -220,15 +258,17 @@ libpcap_write_packet(FILE* pfile,
                      guint64 *bytes_written, int *err)
 {
         struct pcaprec_hdr rec_hdr;
+        gboolean ret;
 
         rec_hdr.ts_sec = (guint32)sec; /* Y2.038K issue in pcap format.... */
         rec_hdr.ts_usec = usec;
         rec_hdr.incl_len = caplen;
         rec_hdr.orig_len = len;
-        if (!write_to_file(pfile, (const guint8*)&rec_hdr, sizeof(rec_hdr), bytes_written, err))
-                return FALSE;
-
-        return write_to_file(pfile, pd, caplen, bytes_written, err);
+        LOCK_FILE(pfile);
+        ret = write_to_file_unlocked(pfile, (const guint8*)&rec_hdr, sizeof(rec_hdr), bytes_written, err) &&
+              write_to_file_unlocked(pfile, pd, caplen, bytes_written, err);
+        UNLOCK_FILE(pfile);
+        return ret;
 }
 
 /* Writing pcapng files */
@@ -554,10 +594,12 @@ pcapng_write_enhanced_packet_block(FILE* pfile,
         guint32 block_total_length;
         guint64 timestamp;
         guint32 options_length;
-        const guint32 padding = 0;
-        guint8 buff[8];
-        guint8 i;
+        /* Padding, flags, end of options and the block total length */
+        guint8 tail[3 + sizeof(struct ws_option) + sizeof(guint32) +
+                    sizeof(struct ws_option) + sizeof(guint32)];
+        size_t tail_len = 0;
         guint8 pad_len = 0;
+        gboolean ret;
 
         block_total_length = (guint32)(sizeof(struct epb) +
                                        ADD_PADDING(caplen) +
@@ -581,52 +623,53 @@ pcapng_write_enhanced_packet_block(FILE* pfile,
         epb.timestamp_low = (guint32)(timestamp & 0xffffffff);
         epb.captured_len = caplen;
         epb.packet_len = len;
-        if (!write_to_file(pfile, (const guint8*)&epb, sizeof(struct epb), bytes_written, err))
-                return FALSE;
-        if (!write_to_file(pfile, pd, caplen, bytes_written, err))
-                return FALSE;
-        /* Use more efficient write in case of no "extras" */
         if(caplen % 4) {
             pad_len = 4 - (caplen % 4);
         }
+
+        LOCK_FILE(pfile);
+        if (!write_to_file_unlocked(pfile, (const guint8*)&epb, sizeof(struct epb), bytes_written, err) ||
+            !write_to_file_unlocked(pfile, pd, caplen, bytes_written, err)) {
+                UNLOCK_FILE(pfile);
+                return FALSE;
+        }
         /*
-         * If we have no options to write, just write out the padding and
-         * the block total length with one fwrite() call.
+         * Everything after the packet data, except a comment, goes out
+         * with one write: the padding, then the options, then the block
+         * total length.
          */
-        if(!comment && flags == 0 && options_length==0){
-            /* Put padding in the buffer */
-            for (i = 0; i < pad_len; i++) {
-                buff[i] = 0;
-            }
-            /* Write the total length */
-            memcpy(&buff[i], &block_total_length, sizeof(guint32));
-            i += sizeof(guint32);
-            return write_to_file(pfile, (const guint8*)&buff, i, bytes_written, err);
-        }
-        if (pad_len) {
-                if (!write_to_file(pfile, (const guint8*)&padding, pad_len, bytes_written, err))
+        memset(tail, 0, pad_len);
+        tail_len = pad_len;
+        if (comment) {
+                if ((tail_len != 0 &&
+                     !write_to_file_unlocked(pfile, tail, tail_len, bytes_written, err)) ||
+                    !pcapng_write_string_option(pfile, OPT_COMMENT, comment,
+                                                bytes_written, err)) {
+                        UNLOCK_FILE(pfile);
                         return FALSE;
+                }
+                tail_len = 0;
         }
-        if (!pcapng_write_string_option(pfile, OPT_COMMENT, comment,
-                                        bytes_written, err))
-                return FALSE;
         if (flags != 0) {
                 option.type = EPB_FLAGS;
                 option.value_length = sizeof(guint32);
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct ws_option), bytes_written, err))
-                        return FALSE;
-                if (!write_to_file(pfile, (const guint8*)&flags, sizeof(guint32), bytes_written, err))
-                        return FALSE;
+                memcpy(&tail[tail_len], &option, sizeof(struct ws_option));
+                tail_len += sizeof(struct ws_option);
+                memcpy(&tail[tail_len], &flags, sizeof(guint32));
+                tail_len += sizeof(guint32);
         }
         if (options_length != 0) {
-                /* write end of options */
+                /* end of options */
                 option.type = OPT_ENDOFOPT;
                 option.value_length = 0;
-                if (!write_to_file(pfile, (const guint8*)&option, sizeof(struct ws_option), bytes_written, err))
-                        return FALSE;
-        }
-
-       return write_to_file(pfile, (const guint8*)&block_total_length, sizeof(guint32), bytes_written, err);
+                memcpy(&tail[tail_len], &option, sizeof(struct ws_option));
+                tail_len += sizeof(struct ws_option);
+        }
+        memcpy(&tail[tail_len], &block_total_length, sizeof(guint32));
+        tail_len += sizeof(guint32);
+        ret = write_to_file_unlocked(pfile, tail, tail_len, bytes_written, err);
+        UNLOCK_FILE(pfile);
+        return ret;
 }
 
 gboolean
@@ -0,0 +1,730 @@
+/* arrow_writer.c
+ * Routines for writing typed columns in the Apache Arrow IPC stream format.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#define WS_LOG_DOMAIN LOG_DOMAIN_WSUTIL
+
+#include "arrow_writer.h"
+
+#include <string.h>
+
+#include <wsutil/pint.h>
+#include <wsutil/ws_assert.h>
+#include <wsutil/wslog.h>
+
+/*
+ * A minimal FlatBuffers encoder for the Arrow metadata, see
+ * https://flatbuffers.dev/flatbuffers_internals.html and the schema in
+ * format/Message.fbs and format/Schema.fbs of the Arrow sources.
+ *
+ * The reference builder works back to front. Here objects are written front
+ * to back instead: a table comes before the objects it refers to, and its
+ * offset fields are patched once those have been written, so that offsets
+ * point forward as required.
+ */
+
+#define FB_OFFSET   0   /* fb_field.size of an offset to a later object */
+#define FB_MAX_SLOTS 8  /* more than any table used here has fields */
+
+typedef struct {
+    guint16 id;         /* Index of the field in its table */
+    guint8  size;       /* 1, 2, 4 or 8 bytes, or FB_OFFSET */
+    guint64 value;
+} fb_field;
+
+#define FB_FIELD_SIZE(f) ((f)->size == FB_OFFSET ? 4 : (f)->size)
+
+/* Appends zeros until the length is rem modulo align. */
+static void
+fb_pad(GByteArray *fb, guint align, guint rem)
+{
+    static const guint8 zeros[8];
+
+    g_byte_array_append(fb, zeros, (align + rem - fb->len % align) % align);
+}
+
+static void
+fb_put(GByteArray *fb, guint size, guint64 value)
+{
+    guint8 bytes[8];
+
+    switch (size) {
+    case 1:
+        bytes[0] = (guint8)value;
+        break;
+    case 2:
+        bytes[0] = (guint8)value;
+        bytes[1] = (guint8)(value >> 8);
+        break;
+    case 4:
+        phtole32(bytes, (guint32)value);
+        break;
+    case 8:
+        phtole64(bytes, value);
+        break;
+    default:
+        ws_assert_not_reached();
+    }
+    g_byte_array_append(fb, bytes, size);
+}
+
+/* Points the offset at position "at" to the object at position "target". */
+static void
+fb_patch(GByteArray *fb, guint at, guint target)
+{
+    ws_assert(target > at);
+    phtole32(fb->data + at, target - at);
+}
+
+/*
+ * Writes a table, preceded by its vtable, and returns its position. The
+ * position of each offset field is stored in offset_at, in the order of
+ * fields, for fb_patch().
+ */
+static guint
+fb_table(GByteArray *fb, const fb_field *fields, guint n_fields, guint *offset_at)
+{
+    static const guint8 sizes[] = { 8, 4, 2, 1 };
+    guint16 slot[FB_MAX_SLOTS] = { 0 };
+    guint n_slots = 0;
+    guint table_size = 4;
+    guint vtable_pos, table_pos;
+    guint i, s;
+
+    /*
+     * Lay the fields out by decreasing size after the 4-byte vtable offset.
+     * The table starts 4 bytes past a multiple of 8, so every field ends up
+     * aligned.
+     */
+    for (s = 0; s < G_N_ELEMENTS(sizes); s++) {
+        for (i = 0; i < n_fields; i++) {
+            if (FB_FIELD_SIZE(&fields[i]) != sizes[s])
+                continue;
+            ws_assert(fields[i].id < FB_MAX_SLOTS);
+            slot[fields[i].id] = table_size;
+            table_size += sizes[s];
+            n_slots = MAX(n_slots, fields[i].id + 1U);
+        }
+    }
+
+    fb_pad(fb, 2, 0);
+    vtable_pos = fb->len;
+    fb_put(fb, 2, 4 + 2 * n_slots);
+    fb_put(fb, 2, table_size);
+    for (i = 0; i < n_slots; i++) {
+        fb_put(fb, 2, slot[i]);
+    }
+
+    fb_pad(fb, 8, 4);
+    table_pos = fb->len;
+    fb_put(fb, 4, table_pos - vtable_pos);
+    for (s = 0; s < G_N_ELEMENTS(sizes); s++) {
+        for (i = 0; i < n_fields; i++) {
+            if (FB_FIELD_SIZE(&fields[i]) == sizes[s])
+                fb_put(fb, sizes[s], fields[i].size == FB_OFFSET ? 0 : fields[i].value);
+        }
+    }
+
+    for (i = 0; i < n_fields; i++) {
+        if (fields[i].size == FB_OFFSET)
+            *offset_at++ = table_pos + slot[fields[i].id];
+    }
+    return table_pos;
+}
+
+static guint
+fb_string(GByteArray *fb, const char *str)
+{
+    guint len = (guint)strlen(str);
+    guint pos;
+
+    fb_pad(fb, 4, 0);
+    pos = fb->len;
+    fb_put(fb, 4, len);
+    g_byte_array_append(fb, (const guint8 *)str, len + 1);
+    return pos;
+}
+
+/* Writes a vector of n offsets, to be patched at slot_at[0..n-1]. */
+static guint
+fb_offsets(GByteArray *fb, guint n, guint *slot_at)
+{
+    guint pos;
+    guint i;
+
+    fb_pad(fb, 4, 0);
+    pos = fb->len;
+    fb_put(fb, 4, n);
+    for (i = 0; i < n; i++) {
+        slot_at[i] = fb->len;
+        fb_put(fb, 4, 0);
+    }
+    return pos;
+}
+
+/* Writes a vector of n structs made of 64-bit integers. */
+static guint
+fb_structs(GByteArray *fb, const GByteArray *structs, guint n)
+{
+    guint pos;
+
+    fb_pad(fb, 8, 4);
+    pos = fb->len;
+    fb_put(fb, 4, n);
+    g_byte_array_append(fb, structs->data, structs->len);
+    return pos;
+}
+
+/* Arrow metadata constants. */
+#define ARROW_METADATA_V5           4
+#define ARROW_HEADER_SCHEMA         1
+#define ARROW_HEADER_RECORD_BATCH   3
+#define ARROW_TYPE_ID_INT           2
+#define ARROW_TYPE_ID_FLOAT         3
+#define ARROW_TYPE_ID_UTF8          5
+#define ARROW_TYPE_ID_BOOL          6
+#define ARROW_TYPE_ID_TIMESTAMP     10
+#define ARROW_TYPE_ID_LIST          12
+#define ARROW_TYPE_ID_DURATION      18
+#define ARROW_PRECISION_DOUBLE      2
+#define ARROW_TIME_UNIT_NANOSECOND  3
+
+#define ARROW_CONTINUATION          0xFFFFFFFF
+
+typedef struct {
+    char       *name;
+    arrow_type  type;
+    gboolean    is_list;
+    GByteArray *validity;       /* A bit per row */
+    guint       null_count;
+    GByteArray *list_offsets;   /* List columns: an int32 per row, plus one */
+    GByteArray *data;           /* Values; bits for ARROW_TYPE_BOOL */
+    GByteArray *str_offsets;    /* ARROW_TYPE_UTF8: an int32 per value, plus one */
+    guint       n_values;       /* Values in the batch */
+    guint       row_values;     /* Values in the current row */
+} arrow_column;
+
+struct arrow_writer {
+    FILE       *fh;
+    guint       batch_rows;
+    GArray     *columns;        /* of arrow_column */
+    guint       rows;           /* Rows in the batch */
+    gboolean    schema_written;
+    gboolean    failed;
+};
+
+/* Strings are flushed early rather than overflowing the int32 offsets. */
+#define ARROW_MAX_BATCH_STRING_BYTES (1U << 30)
+
+static guint8
+arrow_type_id(arrow_type type)
+{
+    switch (type) {
+    case ARROW_TYPE_INT64:
+    case ARROW_TYPE_UINT64:
+    case ARROW_TYPE_UINT32:
+        return ARROW_TYPE_ID_INT;
+    case ARROW_TYPE_DOUBLE:
+        return ARROW_TYPE_ID_FLOAT;
+    case ARROW_TYPE_BOOL:
+        return ARROW_TYPE_ID_BOOL;
+    case ARROW_TYPE_TIMESTAMP:
+        return ARROW_TYPE_ID_TIMESTAMP;
+    case ARROW_TYPE_DURATION:
+        return ARROW_TYPE_ID_DURATION;
+    case ARROW_TYPE_UTF8:
+        return ARROW_TYPE_ID_UTF8;
+    }
+    ws_assert_not_reached();
+}
+
+/* Size of a value in bytes, or 0 for bits and strings. */
+static guint
+arrow_type_width(arrow_type type)
+{
+    switch (type) {
+    case ARROW_TYPE_UINT32:
+        return 4;
+    case ARROW_TYPE_BOOL:
+    case ARROW_TYPE_UTF8:
+        return 0;
+    default:
+        return 8;
+    }
+}
+
+/* Writes the table for the type of a Field and patches "at" with it. */
+static void
+arrow_type_table(GByteArray *fb, guint at, arrow_type type)
+{
+    fb_field fields[2];
+    guint n_fields = 0;
+    guint timezone_at;
+
+    switch (type) {
+    case ARROW_TYPE_INT64:
+    case ARROW_TYPE_UINT64:
+    case ARROW_TYPE_UINT32:
+        fields[n_fields++] = (fb_field){ 0, 4, arrow_type_width(type) * 8 };   /* bitWidth */
+        fields[n_fields++] = (fb_field){ 1, 1, type == ARROW_TYPE_INT64 };     /* is_signed */
+        break;
+    case ARROW_TYPE_DOUBLE:
+        fields[n_fields++] = (fb_field){ 0, 2, ARROW_PRECISION_DOUBLE };        /* precision */
+        break;
+    case ARROW_TYPE_TIMESTAMP:
+        fields[n_fields++] = (fb_field){ 0, 2, ARROW_TIME_UNIT_NANOSECOND };    /* unit */
+        fields[n_fields++] = (fb_field){ 1, FB_OFFSET, 0 };                     /* timezone */
+        break;
+    case ARROW_TYPE_DURATION:
+        fields[n_fields++] = (fb_field){ 0, 2, ARROW_TIME_UNIT_NANOSECOND };    /* unit */
+        break;
+    case ARROW_TYPE_BOOL:
+    case ARROW_TYPE_UTF8:
+        break;
+    }
+
+    fb_patch(fb, at, fb_table(fb, fields, n_fields, &timezone_at));
+    if (type == ARROW_TYPE_TIMESTAMP) {
+        fb_patch(fb, timezone_at, fb_string(fb, "UTC"));
+    }
+}
+
+/* Writes a Field table and patches "at" with it. */
+static void
+arrow_field(GByteArray *fb, guint at, const char *name, arrow_type type,
+            gboolean is_list, gboolean nullable)
+{
+    const fb_field fields[] = {
+        { 0, FB_OFFSET, 0 },                                        /* name */
+        { 1, 1, nullable },                                         /* nullable */
+        { 2, 1, is_list ? ARROW_TYPE_ID_LIST : arrow_type_id(type) },   /* type_type */
+        { 3, FB_OFFSET, 0 },                                        /* type */
+        { 5, FB_OFFSET, 0 },                                        /* children */
+    };
+    guint offset_at[3];
+    guint child_at;
+
+    fb_patch(fb, at, fb_table(fb, fields, G_N_ELEMENTS(fields), offset_at));
+    fb_patch(fb, offset_at[0], fb_string(fb, name));
+    if (is_list) {
+        fb_patch(fb, offset_at[1], fb_table(fb, NULL, 0, NULL));
+        fb_patch(fb, offset_at[2], fb_offsets(fb, 1, &child_at));
+        arrow_field(fb, child_at, "item", type, FALSE, FALSE);
+    } else {
+        arrow_type_table(fb, offset_at[1], type);
+        fb_patch(fb, offset_at[2], fb_offsets(fb, 0, NULL));
+    }
+}
+
+/*
+ * Starts the Message flatbuffer in fb, and returns the position of its
+ * header offset, to be patched with the header table.
+ */
+static guint
+arrow_message_begin(GByteArray *fb, guint8 header_type, guint64 body_length)
+{
+    const fb_field fields[] = {
+        { 0, 2, ARROW_METADATA_V5 },    /* version */
+        { 1, 1, header_type },          /* header_type */
+        { 2, FB_OFFSET, 0 },            /* header */
+        { 3, 8, body_length },          /* bodyLength */
+    };
+    guint header_at;
+
+    fb_put(fb, 4, 0);                   /* root table offset */
+    fb_patch(fb, 0, fb_table(fb, fields, G_N_ELEMENTS(fields), &header_at));
+    return header_at;
+}
+
+/* Writes an encapsulated message: its metadata followed by the body. */
+static void
+arrow_write_message(arrow_writer *writer, GByteArray *fb, const GPtrArray *body)
+{
+    static const guint8 zeros[8];
+    guint8 prefix[8];
+    guint i;
+
+    fb_pad(fb, 8, 0);
+    phtole32(prefix, ARROW_CONTINUATION);
+    phtole32(prefix + 4, fb->len);
+    if (fwrite(prefix, sizeof prefix, 1, writer->fh) != 1 ||
+        fwrite(fb->data, fb->len, 1, writer->fh) != 1) {
+        writer->failed = TRUE;
+        return;
+    }
+    for (i = 0; body && i < body->len; i++) {
+        const GByteArray *buf = (const GByteArray *)g_ptr_array_index(body, i);
+
+        if (buf->len && fwrite(buf->data, buf->len, 1, writer->fh) != 1) {
+            writer->failed = TRUE;
+            return;
+        }
+        if (buf->len % 8 && fwrite(zeros, 8 - buf->len % 8, 1, writer->fh) != 1) {
+            writer->failed = TRUE;
+            return;
+        }
+    }
+}
+
+static void
+arrow_write_schema(arrow_writer *writer)
+{
+    GByteArray *fb = g_byte_array_new();
+    const fb_field fields[] = {
+        { 1, FB_OFFSET, 0 },            /* fields */
+    };
+    guint header_at, fields_at;
+    guint *slot_at = g_new(guint, writer->columns->len);
+    guint i;
+
+    header_at = arrow_message_begin(fb, ARROW_HEADER_SCHEMA, 0);
+    fb_patch(fb, header_at, fb_table(fb, fields, G_N_ELEMENTS(fields), &fields_at));
+    fb_patch(fb, fields_at, fb_offsets(fb, writer->columns->len, slot_at));
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_column *col = &g_array_index(writer->columns, arrow_column, i);
+
+        arrow_field(fb, slot_at[i], col->name, col->type, col->is_list, TRUE);
+    }
+    arrow_write_message(writer, fb, NULL);
+
+    g_free(slot_at);
+    g_byte_array_free(fb, TRUE);
+    writer->schema_written = TRUE;
+}
+
+static void
+arrow_append_bit(GByteArray *bits, guint index, gboolean set)
+{
+    static const guint8 zero;
+
+    if (index % 8 == 0)
+        g_byte_array_append(bits, &zero, 1);
+    if (set)
+        bits->data[index / 8] |= 1 << (index % 8);
+}
+
+static void
+arrow_append_int32(GByteArray *buf, guint32 value)
+{
+    guint8 bytes[4];
+
+    phtole32(bytes, value);
+    g_byte_array_append(buf, bytes, 4);
+}
+
+static void
+arrow_column_reset(arrow_column *col)
+{
+    g_byte_array_set_size(col->validity, 0);
+    g_byte_array_set_size(col->data, 0);
+    col->null_count = 0;
+    col->n_values = 0;
+    col->row_values = 0;
+    if (col->list_offsets) {
+        g_byte_array_set_size(col->list_offsets, 0);
+        arrow_append_int32(col->list_offsets, 0);
+    }
+    if (col->str_offsets) {
+        g_byte_array_set_size(col->str_offsets, 0);
+        arrow_append_int32(col->str_offsets, 0);
+    }
+}
+
+/* Appends a FieldNode or Buffer struct. */
+static void
+arrow_append_pair(GByteArray *structs, guint64 a, guint64 b)
+{
+    guint8 bytes[16];
+
+    phtole64(bytes, a);
+    phtole64(bytes + 8, b);
+    g_byte_array_append(structs, bytes, 16);
+}
+
+static void
+arrow_add_buffer(GPtrArray *body, GByteArray *buffers, guint64 *body_length, GByteArray *buf)
+{
+    g_ptr_array_add(body, buf);
+    arrow_append_pair(buffers, *body_length, buf->len);
+    *body_length += (buf->len + 7) & ~7U;
+}
+
+/* Writes the rows collected so far as a record batch. */
+static void
+arrow_write_batch(arrow_writer *writer)
+{
+    GByteArray *fb, *nodes, *buffers;
+    GPtrArray *body;
+    GByteArray *no_validity;
+    guint64 body_length = 0;
+    guint n_nodes = 0;
+    guint i;
+    guint header_at;
+    guint batch_at[2];
+    const fb_field fields[] = {
+        { 0, 8, writer->rows },         /* length */
+        { 1, FB_OFFSET, 0 },            /* nodes */
+        { 2, FB_OFFSET, 0 },            /* buffers */
+    };
+
+    if (!writer->schema_written)
+        arrow_write_schema(writer);
+    if (writer->rows == 0)
+        return;
+
+    nodes = g_byte_array_new();
+    buffers = g_byte_array_new();
+    body = g_ptr_array_new();
+    no_validity = g_byte_array_new();
+
+    /* Nodes and buffers come in the order of a depth-first walk of the schema. */
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_column *col = &g_array_index(writer->columns, arrow_column, i);
+
+        arrow_append_pair(nodes, writer->rows, col->null_count);
+        n_nodes++;
+        arrow_add_buffer(body, buffers, &body_length, col->validity);
+        if (col->is_list) {
+            arrow_add_buffer(body, buffers, &body_length, col->list_offsets);
+            arrow_append_pair(nodes, col->n_values, 0);
+            n_nodes++;
+            arrow_add_buffer(body, buffers, &body_length, no_validity);
+        }
+        if (col->str_offsets)
+            arrow_add_buffer(body, buffers, &body_length, col->str_offsets);
+        arrow_add_buffer(body, buffers, &body_length, col->data);
+    }
+
+    fb = g_byte_array_new();
+    header_at = arrow_message_begin(fb, ARROW_HEADER_RECORD_BATCH, body_length);
+    fb_patch(fb, header_at, fb_table(fb, fields, G_N_ELEMENTS(fields), batch_at));
+    fb_patch(fb, batch_at[0], fb_structs(fb, nodes, n_nodes));
+    fb_patch(fb, batch_at[1], fb_structs(fb, buffers, body->len));
+    arrow_write_message(writer, fb, body);
+
+    g_byte_array_free(fb, TRUE);
+    g_byte_array_free(nodes, TRUE);
+    g_byte_array_free(buffers, TRUE);
+    g_byte_array_free(no_validity, TRUE);
+    g_ptr_array_free(body, TRUE);
+
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_column_reset(&g_array_index(writer->columns, arrow_column, i));
+    }
+    writer->rows = 0;
+}
+
+arrow_writer *
+arrow_writer_new(FILE *fh, guint batch_rows)
+{
+    arrow_writer *writer = g_new0(arrow_writer, 1);
+
+    writer->fh = fh;
+    writer->batch_rows = batch_rows ? batch_rows : ARROW_WRITER_BATCH_ROWS;
+    writer->columns = g_array_new(FALSE, TRUE, sizeof(arrow_column));
+    return writer;
+}
+
+void
+arrow_writer_add_column(arrow_writer *writer, const char *name,
+                        arrow_type type, gboolean is_list)
+{
+    arrow_column col = { 0 };
+
+    g_return_if_fail(!writer->schema_written && writer->rows == 0);
+
+    col.name = g_strdup(name);
+    col.type = type;
+    col.is_list = is_list;
+    col.validity = g_byte_array_new();
+    col.data = g_byte_array_new();
+    if (is_list)
+        col.list_offsets = g_byte_array_new();
+    if (type == ARROW_TYPE_UTF8)
+        col.str_offsets = g_byte_array_new();
+    arrow_column_reset(&col);
+    g_array_append_val(writer->columns, col);
+}
+
+#define ARROW_TYPES(t) (1U << (t))
+
+/*
+ * Returns the column if it is of one of the given types and can take
+ * another value in this row, counting that value.
+ */
+static arrow_column *
+arrow_writer_value(arrow_writer *writer, guint column, guint types)
+{
+    arrow_column *col;
+
+    g_return_val_if_fail(column < writer->columns->len, NULL);
+    col = &g_array_index(writer->columns, arrow_column, column);
+    g_return_val_if_fail(ARROW_TYPES(col->type) & types, NULL);
+    if (!col->is_list && col->row_values > 0)
+        return NULL;
+    col->row_values++;
+    col->n_values++;
+    return col;
+}
+
+static void
+arrow_append_int64(GByteArray *buf, guint64 value)
+{
+    guint8 bytes[8];
+
+    phtole64(bytes, value);
+    g_byte_array_append(buf, bytes, 8);
+}
+
+void
+arrow_writer_append_int(arrow_writer *writer, guint column, gint64 value)
+{
+    arrow_column *col = arrow_writer_value(writer, column,
+            ARROW_TYPES(ARROW_TYPE_INT64) | ARROW_TYPES(ARROW_TYPE_TIMESTAMP) |
+            ARROW_TYPES(ARROW_TYPE_DURATION));
+
+    if (col)
+        arrow_append_int64(col->data, (guint64)value);
+}
+
+void
+arrow_writer_append_uint(arrow_writer *writer, guint column, guint64 value)
+{
+    arrow_column *col = arrow_writer_value(writer, column,
+            ARROW_TYPES(ARROW_TYPE_UINT64) | ARROW_TYPES(ARROW_TYPE_UINT32));
+
+    if (!col)
+        return;
+    if (col->type == ARROW_TYPE_UINT32)
+        arrow_append_int32(col->data, (guint32)value);
+    else
+        arrow_append_int64(col->data, value);
+}
+
+void
+arrow_writer_append_double(arrow_writer *writer, guint column, double value)
+{
+    arrow_column *col = arrow_writer_value(writer, column, ARROW_TYPES(ARROW_TYPE_DOUBLE));
+    guint64 bits;
+
+    if (!col)
+        return;
+    memcpy(&bits, &value, sizeof bits);
+    arrow_append_int64(col->data, bits);
+}
+
+void
+arrow_writer_append_bool(arrow_writer *writer, guint column, gboolean value)
+{
+    arrow_column *col = arrow_writer_value(writer, column, ARROW_TYPES(ARROW_TYPE_BOOL));
+
+    if (col)
+        arrow_append_bit(col->data, col->n_values - 1, value);
+}
+
+void
+arrow_writer_append_string(arrow_writer *writer, guint column, const char *value)
+{
+    arrow_column *col = arrow_writer_value(writer, column, ARROW_TYPES(ARROW_TYPE_UTF8));
+
+    if (!col)
+        return;
+    g_byte_array_append(col->data, (const guint8 *)value, (guint)strlen(value));
+    arrow_append_int32(col->str_offsets, col->data->len);
+}
+
+gboolean
+arrow_writer_end_row(arrow_writer *writer)
+{
+    gboolean flush = FALSE;
+    guint i;
+
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_column *col = &g_array_index(writer->columns, arrow_column, i);
+        gboolean valid = col->row_values > 0;
+
+        arrow_append_bit(col->validity, writer->rows, valid);
+        if (!valid)
+            col->null_count++;
+
+        if (col->is_list) {
+            arrow_append_int32(col->list_offsets, col->n_values);
+        } else if (!valid) {
+            /* A null still takes a slot in the values. */
+            static const guint8 zeros[8];
+
+            switch (col->type) {
+            case ARROW_TYPE_BOOL:
+                arrow_append_bit(col->data, col->n_values, FALSE);
+                break;
+            case ARROW_TYPE_UTF8:
+                arrow_append_int32(col->str_offsets, col->data->len);
+                break;
+            default:
+                g_byte_array_append(col->data, zeros, arrow_type_width(col->type));
+                break;
+            }
+            col->n_values++;
+        }
+        col->row_values = 0;
+
+        if (col->type == ARROW_TYPE_UTF8 && col->data->len >= ARROW_MAX_BATCH_STRING_BYTES)
+            flush = TRUE;
+    }
+    writer->rows++;
+
+    if (flush || writer->rows >= writer->batch_rows)
+        arrow_write_batch(writer);
+    return !writer->failed;
+}
+
+gboolean
+arrow_writer_finish(arrow_writer *writer)
+{
+    guint8 eos[8];
+    gboolean ok;
+    guint i;
+
+    arrow_write_batch(writer);
+
+    phtole32(eos, ARROW_CONTINUATION);
+    phtole32(eos + 4, 0);
+    if (fwrite(eos, sizeof eos, 1, writer->fh) != 1)
+        writer->failed = TRUE;
+    ok = !writer->failed;
+
+    for (i = 0; i < writer->columns->len; i++) {
+        arrow_column *col = &g_array_index(writer->columns, arrow_column, i);
+
+        g_free(col->name);
+        g_byte_array_free(col->validity, TRUE);
+        g_byte_array_free(col->data, TRUE);
+        if (col->list_offsets)
+            g_byte_array_free(col->list_offsets, TRUE);
+        if (col->str_offsets)
+            g_byte_array_free(col->str_offsets, TRUE);
+    }
+    g_array_free(writer->columns, TRUE);
+    g_free(writer);
+    return ok;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
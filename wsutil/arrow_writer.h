@@ -0,0 +1,126 @@
+/** @file
+ * Routines for writing typed columns in the Apache Arrow IPC stream format.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __ARROW_WRITER_H__
+#define __ARROW_WRITER_H__
+
+#include "ws_symbol_export.h"
+#include <glib.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Writes rows of values as an Arrow IPC stream
+ * (https://arrow.apache.org/docs/format/Columnar.html#ipc-streaming-format):
+ * a schema followed by record batches of up to batch_rows rows each. The
+ * stream can be read with e.g. pyarrow.ipc.open_stream() and converted to
+ * Parquet or loaded into Spark or DuckDB without parsing any text.
+ *
+ * Example:
+ *
+ *  arrow_writer *writer = arrow_writer_new(stdout, 0);
+ *  arrow_writer_add_column(writer, "frame.number", ARROW_TYPE_UINT64, FALSE);
+ *  arrow_writer_add_column(writer, "ip.src", ARROW_TYPE_UINT32, TRUE);
+ *  arrow_writer_append_uint(writer, 0, 1);
+ *  arrow_writer_append_uint(writer, 1, 0xc0a80001);
+ *  arrow_writer_end_row(writer);
+ *  arrow_writer_finish(writer);
+ *
+ * A column's values are all of one type. A list column takes any number of
+ * values per row; a plain column takes one, and further values in the same
+ * row are ignored. A column that gets no value in a row is null there.
+ */
+
+typedef enum {
+    ARROW_TYPE_INT64,       /**< Signed 64-bit integer */
+    ARROW_TYPE_UINT64,      /**< Unsigned 64-bit integer */
+    ARROW_TYPE_UINT32,      /**< Unsigned 32-bit integer, e.g. IPv4 addresses */
+    ARROW_TYPE_DOUBLE,      /**< 64-bit floating point */
+    ARROW_TYPE_BOOL,        /**< Boolean */
+    ARROW_TYPE_TIMESTAMP,   /**< Nanoseconds since the epoch, UTC */
+    ARROW_TYPE_DURATION,    /**< Nanoseconds */
+    ARROW_TYPE_UTF8         /**< UTF-8 string */
+} arrow_type;
+
+typedef struct arrow_writer arrow_writer;
+
+/** Default number of rows in a record batch. */
+#define ARROW_WRITER_BATCH_ROWS 65536
+
+/**
+ * Creates a writer for fh. A batch_rows of 0 means ARROW_WRITER_BATCH_ROWS.
+ * Nothing is written until the first row is complete.
+ */
+WS_DLL_PUBLIC arrow_writer *
+arrow_writer_new(FILE *fh, guint batch_rows);
+
+/**
+ * Adds a column. Columns are numbered from 0 in the order they are added,
+ * and must all be added before the first value.
+ */
+WS_DLL_PUBLIC void
+arrow_writer_add_column(arrow_writer *writer, const char *name,
+                        arrow_type type, gboolean is_list);
+
+/** Appends a value to an ARROW_TYPE_INT64, _TIMESTAMP or _DURATION column. */
+WS_DLL_PUBLIC void
+arrow_writer_append_int(arrow_writer *writer, guint column, gint64 value);
+
+/** Appends a value to an ARROW_TYPE_UINT64 or _UINT32 column. */
+WS_DLL_PUBLIC void
+arrow_writer_append_uint(arrow_writer *writer, guint column, guint64 value);
+
+/** Appends a value to an ARROW_TYPE_DOUBLE column. */
+WS_DLL_PUBLIC void
+arrow_writer_append_double(arrow_writer *writer, guint column, double value);
+
+/** Appends a value to an ARROW_TYPE_BOOL column. */
+WS_DLL_PUBLIC void
+arrow_writer_append_bool(arrow_writer *writer, guint column, gboolean value);
+
+/** Appends a NUL-terminated UTF-8 string to an ARROW_TYPE_UTF8 column. */
+WS_DLL_PUBLIC void
+arrow_writer_append_string(arrow_writer *writer, guint column, const char *value);
+
+/**
+ * Completes the current row, and writes a record batch if it is full.
+ * Returns FALSE if writing failed.
+ */
+WS_DLL_PUBLIC gboolean
+arrow_writer_end_row(arrow_writer *writer);
+
+/**
+ * Writes the remaining rows and the end-of-stream marker, and frees the
+ * writer. The file is not closed. Returns FALSE if writing failed.
+ */
+WS_DLL_PUBLIC gboolean
+arrow_writer_finish(arrow_writer *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ARROW_WRITER_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -40,6 +40,46 @@ ws_buffer_init(Buffer* buffer, gsize space)
 	}
 	buffer->start = 0;
 	buffer->first_free = 0;
+	buffer->borrowed = FALSE;
+	buffer->own_data = NULL;
+	buffer->own_allocated = 0;
+}
+
+/*
+ * Stop referring to borrowed data and go back to our own storage,
+ * copying the borrowed contents into it if keep_contents is TRUE.
+ */
+static void
+ws_buffer_return_borrowed(Buffer* buffer, gboolean keep_contents)
+{
+	guint8 *contents = buffer->data + buffer->start;
+	gsize length = buffer->first_free - buffer->start;
+
+	buffer->data = buffer->own_data;
+	buffer->allocated = buffer->own_allocated;
+	buffer->start = 0;
+	buffer->first_free = 0;
+	buffer->borrowed = FALSE;
+	buffer->own_data = NULL;
+	buffer->own_allocated = 0;
+	if (keep_contents && length != 0)
+		ws_buffer_append(buffer, contents, length);
+}
+
+/* Makes the buffer refer to data it doesn't own, without copying it */
+void
+ws_buffer_borrow(Buffer* buffer, const guint8 *data, gsize bytes)
+{
+	ws_assert(buffer);
+	if (!buffer->borrowed) {
+		buffer->own_data = buffer->data;
+		buffer->own_allocated = buffer->allocated;
+		buffer->borrowed = TRUE;
+	}
+	buffer->data = (guint8 *)data;
+	buffer->allocated = bytes;
+	buffer->start = 0;
+	buffer->first_free = bytes;
 }
 
 /* Frees the memory used by a buffer */
@@ -47,6 +87,8 @@ void
 ws_buffer_free(Buffer* buffer)
 {
 	ws_assert(buffer);
+	if (buffer->borrowed)
+		ws_buffer_return_borrowed(buffer, FALSE);
 	if (buffer->allocated == SMALL_BUFFER_SIZE) {
 		ws_assert(buffer->data);
 		g_ptr_array_add(small_buffers, buffer->data);
@@ -69,6 +111,12 @@ ws_buffer_assure_space(Buffer* buffer, gsize space)
 	gsize space_used;
 	gboolean space_at_beginning;
 
+	/* We can't grow borrowed data; get our own copy of it. */
+	if (buffer->borrowed) {
+		ws_buffer_return_borrowed(buffer, TRUE);
+		available_at_end = buffer->allocated - buffer->first_free;
+	}
+
 	/* If we've got the space already, good! */
 	if (space <= available_at_end) {
 		return;
@@ -122,6 +170,8 @@ ws_buffer_remove_start(Buffer* buffer, gsize bytes)
 	buffer->start += bytes;
 
 	if (buffer->start == buffer->first_free) {
+		if (buffer->borrowed)
+			ws_buffer_return_borrowed(buffer, FALSE);
 		buffer->start = 0;
 		buffer->first_free = 0;
 	}
@@ -182,6 +232,15 @@ ws_buffer_append_buffer(Buffer* buffer, Buffer* src_buffer)
 }
 #endif
 
+#ifndef SOME_FUNCTIONS_ARE_DEFINES
+gboolean
+ws_buffer_is_borrowed(Buffer* buffer)
+{
+	ws_assert(buffer);
+	return buffer->borrowed;
+}
+#endif
+
 void
 ws_buffer_cleanup(void)
 {
@@ -23,6 +23,9 @@ typedef struct Buffer {
 	gsize	allocated;
 	gsize	start;
 	gsize	first_free;
+	gboolean borrowed;	/* data is someone else's; don't free it */
+	guint8	*own_data;	/* our own data and allocated, while borrowed */
+	gsize	own_allocated;
 } Buffer;
 
 WS_DLL_PUBLIC
@@ -35,6 +38,16 @@ WS_DLL_PUBLIC
 void ws_buffer_append(Buffer* buffer, guint8 *from, gsize bytes);
 WS_DLL_PUBLIC
 void ws_buffer_remove_start(Buffer* buffer, gsize bytes);
+/*
+ * Make the buffer's contents the given bytes, without copying them.
+ * They must stay valid, and unchanged, for as long as the buffer refers
+ * to them; the buffer goes back to its own storage, copying them if
+ * needed, as soon as it's asked for space, appended to, emptied, or
+ * freed.  Whether the contents may be modified through
+ * ws_buffer_start_ptr() while borrowed is up to whoever lent them.
+ */
+WS_DLL_PUBLIC
+void ws_buffer_borrow(Buffer* buffer, const guint8 *data, gsize bytes);
 WS_DLL_PUBLIC
 void ws_buffer_cleanup(void);
 
@@ -45,6 +58,7 @@ void ws_buffer_cleanup(void);
 # define ws_buffer_start_ptr(buffer) ((buffer)->data + (buffer)->start)
 # define ws_buffer_end_ptr(buffer) ((buffer)->data + (buffer)->first_free)
 # define ws_buffer_append_buffer(buffer,src_buffer) ws_buffer_append((buffer), ws_buffer_start_ptr(src_buffer), ws_buffer_length(src_buffer))
+# define ws_buffer_is_borrowed(buffer) ((buffer)->borrowed)
 #else
  void ws_buffer_clean(Buffer* buffer);
  void ws_buffer_increase_length(Buffer* buffer, unsigned int bytes);
@@ -52,6 +66,7 @@ void ws_buffer_cleanup(void);
  guint8* ws_buffer_start_ptr(Buffer* buffer);
  guint8* ws_buffer_end_ptr(Buffer* buffer);
  void ws_buffer_append_buffer(Buffer* buffer, Buffer* src_buffer);
+ gboolean ws_buffer_is_borrowed(Buffer* buffer);
 #endif
 
 #ifdef __cplusplus
@@ -15,9 +15,26 @@
 
 #include "config.h"
 
+#ifdef __APPLE__
+#if defined(__clang__) && (__clang_major__ >= 6)
+/* allow HAVE_SSE4_2 to be used for clang 6.0+ case because we know it works */
+#else
+/* don't allow it otherwise, for Mac OSX */
+#undef HAVE_SSE4_2
+#endif
+#endif
+
+#include <string.h>
+
 #include <glib.h>
 #include <wsutil/crc32.h>
 
+#include "crc32_int.h"
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
 #define CRC32_ACCUMULATE(c,d,table) (c=(c>>8)^(table)[(c^(d))&0xFF])
 
 /*****************************************************************/
@@ -353,6 +370,98 @@ static const guint32 crc32_5D6DCB[] =
 		0x0098206c, 0x00c54da7, 0x0022fbfa, 0x007f9631
 };
 
+/*
+ * Tables for "slice-by-8", which processes 8 bytes at a time: entry i of
+ * table k is the CRC of byte i followed by k zero bytes, so the CRC of
+ * 8 bytes is the XOR of one lookup per byte.  They're made from the
+ * tables above the first time they're needed.
+ */
+static guint32 crc32c_slice8_table[8][256];
+static guint32 crc32_ccitt_slice8_table[8][256];
+
+static crc32c_func crc32c_update;
+
+static void
+crc32_make_slice8_table(guint32 slice8[8][256], const guint32 *table)
+{
+	guint i, k;
+
+	for (i = 0; i < 256; i++)
+		slice8[0][i] = table[i];
+	for (k = 1; k < 8; k++) {
+		for (i = 0; i < 256; i++)
+			slice8[k][i] = (slice8[k-1][i] >> 8) ^ table[slice8[k-1][i] & 0xFF];
+	}
+}
+
+static guint32
+crc32_slice8(const guint32 t[8][256], guint32 crc, const guint8 *p, size_t len)
+{
+	guint32 hi;
+
+	while (len >= 8) {
+		crc ^= (guint32)p[0] | (guint32)p[1] << 8 |
+			(guint32)p[2] << 16 | (guint32)p[3] << 24;
+		hi = (guint32)p[4] | (guint32)p[5] << 8 |
+			(guint32)p[6] << 16 | (guint32)p[7] << 24;
+		crc = t[7][crc & 0xFF] ^ t[6][(crc >> 8) & 0xFF] ^
+			t[5][(crc >> 16) & 0xFF] ^ t[4][crc >> 24] ^
+			t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+			t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+		p += 8;
+		len -= 8;
+	}
+	while (len-- > 0)
+		CRC32_ACCUMULATE(crc, *p++, t[0]);
+	return crc;
+}
+
+static guint32
+crc32c_slice8(guint32 crc, const guint8 *p, size_t len)
+{
+	return crc32_slice8(crc32c_slice8_table, crc, p, len);
+}
+
+#if defined(__ARM_FEATURE_CRC32)
+/* The compiler was told the processor has the ARMv8 CRC32 instructions. */
+static guint32
+crc32c_armv8(guint32 crc, const guint8 *p, size_t len)
+{
+	guint64 v;
+
+	while (len >= 8) {
+		memcpy(&v, p, sizeof v);
+		crc = __crc32cd(crc, v);
+		p += 8;
+		len -= 8;
+	}
+	while (len-- > 0)
+		crc = __crc32cb(crc, *p++);
+	return crc;
+}
+#endif
+
+static void
+crc32_init(void)
+{
+	static gsize initialized = 0;
+
+	if (g_once_init_enter(&initialized)) {
+		crc32_make_slice8_table(crc32c_slice8_table, crc32c_table);
+		crc32_make_slice8_table(crc32_ccitt_slice8_table, crc32_ccitt_table);
+#if defined(__ARM_FEATURE_CRC32)
+		crc32c_update = crc32c_armv8;
+#else
+		crc32c_update = crc32c_slice8;
+#endif
+#ifdef HAVE_SSE4_2
+		if (ws_crc32c_sse42_supported())
+			crc32c_update = crc32c_sse42;
+#endif
+		g_once_init_leave(&initialized, 1);
+	}
+}
+
 guint32
 crc32c_table_lookup (guchar pos)
 {
@@ -368,10 +477,10 @@ crc32_ccitt_table_lookup (guchar pos)
 guint32
 crc32c_calculate(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
 	crc = CRC32C_SWAP(crc);
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
+	if (len > 0) {
+		crc32_init();
+		crc = crc32c_update(crc, (const guint8 *)buf, len);
 	}
 	return CRC32C_SWAP(crc);
 }
@@ -379,9 +488,9 @@ crc32c_calculate(const void *buf, int len, guint32 crc)
 guint32
 crc32c_calculate_no_swap(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
+	if (len > 0) {
+		crc32_init();
+		crc = crc32c_update(crc, (const guint8 *)buf, len);
 	}
 
 	return crc;
@@ -396,11 +505,12 @@ crc32_ccitt(const guint8 *buf, guint len)
 guint32
 crc32_ccitt_seed(const guint8 *buf, guint len, guint32 seed)
 {
-	guint i;
 	guint32 crc32 = seed;
 
-	for (i = 0; i < len; i++)
-		CRC32_ACCUMULATE(crc32, buf[i], crc32_ccitt_table);
+	if (len > 0) {
+		crc32_init();
+		crc32 = crc32_slice8(crc32_ccitt_slice8_table, crc32, buf, len);
+	}
 
 	return ( ~crc32 );
 }
@@ -0,0 +1,21 @@
+/** @file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CRC32_INT_H__
+#define __CRC32_INT_H__
+
+/* Updates an unswapped, uncomplemented CRC-32C with len bytes at p. */
+typedef guint32 (*crc32c_func)(guint32 crc, const guint8 *p, size_t len);
+
+#ifdef HAVE_SSE4_2
+gboolean ws_crc32c_sse42_supported(void);
+guint32 crc32c_sse42(guint32 crc, const guint8 *p, size_t len);
+#endif
+
+#endif /* __CRC32_INT_H__ */
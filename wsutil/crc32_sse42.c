@@ -0,0 +1,69 @@
+/* crc32_sse42.c
+ * CRC-32C (Castagnoli) using the SSE4.2 CRC32 instruction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SSE4_2
+
+#include <glib.h>
+#include "ws_cpuid.h"
+
+#include <nmmintrin.h>
+#include <string.h>
+#include "crc32_int.h"
+
+gboolean
+ws_crc32c_sse42_supported(void)
+{
+    return ws_cpuid_sse42();
+}
+
+guint32
+crc32c_sse42(guint32 crc, const guint8 *p, size_t len)
+{
+    guint32 v32;
+#if defined(__x86_64__) || defined(_M_X64)
+    guint64 crc64 = crc;
+    guint64 v64;
+
+    while (len >= 8) {
+        memcpy(&v64, p, sizeof v64);
+        crc64 = _mm_crc32_u64(crc64, v64);
+        p += 8;
+        len -= 8;
+    }
+    crc = (guint32)crc64;
+#endif
+
+    while (len >= 4) {
+        memcpy(&v32, p, sizeof v32);
+        crc = _mm_crc32_u32(crc, v32);
+        p += 4;
+        len -= 4;
+    }
+    while (len-- > 0)
+        crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+
+#endif /* HAVE_SSE4_2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
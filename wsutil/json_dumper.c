@@ -14,8 +14,12 @@
 #include "json_dumper.h"
 #define WS_LOG_DOMAIN LOG_DOMAIN_WSUTIL
 
+#include <errno.h>
 #include <math.h>
+#include <string.h>
 
+#include <wsutil/pint.h>
+#include <wsutil/to_str.h>
 #include <wsutil/wslog.h>
 
 /*
@@ -36,6 +40,22 @@ enum json_dumper_element_type {
 #define JSON_DUMPER_FLAGS_ERROR     (1 << 16)   /* Output flag: an error occurred. */
 #define JSON_DUMPER_FLAGS_NO_DEBUG  (1 << 17)   /* Input flag: disable debug prints (intended for speeding up fuzzing). */
 
+#define JSON_DUMPER_IS_CBOR(dumper)     ((dumper)->flags & JSON_DUMPER_FLAGS_CBOR)
+
+/* CBOR major types, and the initial bytes we use that aren't just one. */
+#define CBOR_TYPE_UINT          0
+#define CBOR_TYPE_NEGINT        1
+#define CBOR_TYPE_BYTES         2
+#define CBOR_TYPE_TEXT          3
+#define CBOR_BYTES_INDEFINITE   0x5f
+#define CBOR_ARRAY_INDEFINITE   0x9f
+#define CBOR_MAP_INDEFINITE     0xbf
+#define CBOR_FALSE              0xf4
+#define CBOR_TRUE               0xf5
+#define CBOR_NULL               0xf6
+#define CBOR_FLOAT64            0xfb
+#define CBOR_BREAK              0xff
+
 enum json_dumper_change {
     JSON_DUMPER_BEGIN,
     JSON_DUMPER_END,
@@ -45,47 +65,79 @@ enum json_dumper_change {
     JSON_DUMPER_FINISH,
 };
 
-/* JSON Dumper putc */
+/* Write out the buffered output. */
 static void
-jd_putc(const json_dumper *dumper, char c)
+jd_flush(json_dumper *dumper)
 {
+    if (dumper->buffer_len == 0) {
+        return;
+    }
+
     if (dumper->output_file) {
-        fputc(c, dumper->output_file);
+        fwrite(dumper->buffer, 1, dumper->buffer_len, dumper->output_file);
     }
 
     if (dumper->output_string) {
-        g_string_append_c(dumper->output_string, c);
+        g_string_append_len(dumper->output_string, dumper->buffer, dumper->buffer_len);
     }
+    dumper->buffer_len = 0;
 }
 
-/* JSON Dumper puts */
-static void
-jd_puts(const json_dumper *dumper, const char *s)
+/* JSON Dumper putc */
+static inline void
+jd_putc(json_dumper *dumper, char c)
 {
-    if (dumper->output_file) {
-        fputs(s, dumper->output_file);
-    }
-
-    if (dumper->output_string) {
-        g_string_append(dumper->output_string, s);
+    if (dumper->buffer_len == sizeof(dumper->buffer)) {
+        jd_flush(dumper);
     }
+    dumper->buffer[dumper->buffer_len++] = c;
 }
 
 static void
-jd_puts_len(const json_dumper *dumper, const char *s, gsize len)
+jd_puts_len(json_dumper *dumper, const char *s, gsize len)
 {
-    if (dumper->output_file) {
-        fwrite(s, 1, len, dumper->output_file);
-    }
+    if (len > sizeof(dumper->buffer) - dumper->buffer_len) {
+        jd_flush(dumper);
+        if (len >= sizeof(dumper->buffer)) {
+            /* Too big to be worth copying. */
+            if (dumper->output_file) {
+                fwrite(s, 1, len, dumper->output_file);
+            }
 
-    if (dumper->output_string) {
-        g_string_append_len(dumper->output_string, s, len);
+            if (dumper->output_string) {
+                g_string_append_len(dumper->output_string, s, len);
+            }
+            return;
+        }
     }
+    memcpy(dumper->buffer + dumper->buffer_len, s, len);
+    dumper->buffer_len += len;
 }
 
+/* JSON Dumper puts */
 static void
-jd_vprintf(const json_dumper *dumper, const char *format, va_list args)
+jd_puts(json_dumper *dumper, const char *s)
 {
+    jd_puts_len(dumper, s, strlen(s));
+}
+
+static void
+jd_vprintf(json_dumper *dumper, const char *format, va_list args)
+{
+    gsize space = sizeof(dumper->buffer) - dumper->buffer_len;
+    va_list args_copy;
+    int len;
+
+    /* Format straight into the buffer if the result fits. */
+    va_copy(args_copy, args);
+    len = vsnprintf(dumper->buffer + dumper->buffer_len, space, format, args_copy);
+    va_end(args_copy);
+    if (len >= 0 && (gsize)len < space) {
+        dumper->buffer_len += len;
+        return;
+    }
+
+    jd_flush(dumper);
     if (dumper->output_file) {
         vfprintf(dumper->output_file, format, args);
     }
@@ -95,11 +147,28 @@ jd_vprintf(const json_dumper *dumper, const char *format, va_list args)
     }
 }
 
+/*
+ * Characters that json_puts_string() cannot copy as they are: JSON_ESC_ALWAYS
+ * for control characters, quotes and backslashes, which are escaped,
+ * JSON_ESC_SLASH for "/", which is escaped after "<", and JSON_ESC_DOT for
+ * ".", which is replaced in member names with JSON_DUMPER_DOT_TO_UNDERSCORE.
+ */
+#define JSON_ESC_ALWAYS 1
+#define JSON_ESC_SLASH  2
+#define JSON_ESC_DOT    4
+
+static const guint8 json_escape_class[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 2,   /* '"', '.', '/' */
+    [0x5c] = 1,                                         /* '\\' */
+};
+
 static void
-json_puts_string(const json_dumper *dumper, const char *str, gboolean dot_to_underscore)
+json_puts_string(json_dumper *dumper, const char *str, gboolean dot_to_underscore)
 {
     if (!str) {
-        jd_puts(dumper, "null");
+        jd_puts_len(dumper, "null", 4);
         return;
     }
 
@@ -107,28 +176,176 @@ json_puts_string(const json_dumper *dumper, const char *str, gboolean dot_to_und
         "u0000", "u0001", "u0002", "u0003", "u0004", "u0005", "u0006", "u0007", "b",     "t",     "n",     "u000b", "f",     "r",     "u000e", "u000f",
         "u0010", "u0011", "u0012", "u0013", "u0014", "u0015", "u0016", "u0017", "u0018", "u0019", "u001a", "u001b", "u001c", "u001d", "u001e", "u001f"
     };
+    const guint8 stop = JSON_ESC_ALWAYS | JSON_ESC_SLASH | (dot_to_underscore ? JSON_ESC_DOT : 0);
+    const guchar *p = (const guchar *)str;
+    const guchar *run;
 
     jd_putc(dumper, '"');
-    for (int i = 0; str[i]; i++) {
-        if ((guint)str[i] < 0x20) {
+    for (;;) {
+        /* Copy the longest run that needs no escaping in one go. */
+        run = p;
+        while (!(json_escape_class[*p] & stop)) {
+            p++;
+        }
+        if (p != run) {
+            jd_puts_len(dumper, (const char *)run, p - run);
+        }
+
+        if (*p == '\0') {
+            break;
+        } else if (*p < 0x20) {
             jd_putc(dumper, '\\');
-            jd_puts(dumper, json_cntrl[(guint)str[i]]);
-        } else if (i > 0 && str[i - 1] == '<' && str[i] == '/') {
+            jd_puts(dumper, json_cntrl[*p]);
+        } else if (*p == '/') {
             // Convert </script> to <\/script> to avoid breaking web pages.
-            jd_puts(dumper, "\\/");
-        } else {
-            if (str[i] == '\\' || str[i] == '"') {
+            if ((const char *)p > str && p[-1] == '<') {
                 jd_putc(dumper, '\\');
             }
-            if (dot_to_underscore && str[i] == '.')
-                jd_putc(dumper, '_');
-            else
-                jd_putc(dumper, str[i]);
+            jd_putc(dumper, '/');
+        } else if (*p == '.') {
+            jd_putc(dumper, '_');
+        } else {
+            jd_putc(dumper, '\\');
+            jd_putc(dumper, *p);
         }
+        p++;
     }
     jd_putc(dumper, '"');
 }
 
+/* Writes the head of a CBOR data item, with its major type and argument. */
+static void
+cbor_put_head(json_dumper *dumper, guint8 major_type, guint64 arg)
+{
+    guint8 head[9];
+    gsize len;
+
+    head[0] = major_type << 5;
+    if (arg < 24) {
+        head[0] |= (guint8)arg;
+        len = 1;
+    } else if (arg <= G_MAXUINT8) {
+        head[0] |= 24;
+        head[1] = (guint8)arg;
+        len = 2;
+    } else if (arg <= G_MAXUINT16) {
+        head[0] |= 25;
+        phton16(head + 1, (guint16)arg);
+        len = 3;
+    } else if (arg <= G_MAXUINT32) {
+        head[0] |= 26;
+        phton32(head + 1, (guint32)arg);
+        len = 5;
+    } else {
+        head[0] |= 27;
+        phton64(head + 1, arg);
+        len = 9;
+    }
+    jd_puts_len(dumper, (const char *)head, len);
+}
+
+static void
+cbor_put_int64(json_dumper *dumper, gint64 value)
+{
+    if (value < 0) {
+        cbor_put_head(dumper, CBOR_TYPE_NEGINT, (guint64)(-(value + 1)));
+    } else {
+        cbor_put_head(dumper, CBOR_TYPE_UINT, (guint64)value);
+    }
+}
+
+static void
+cbor_put_double(json_dumper *dumper, double value)
+{
+    guint8 item[9];
+    guint64 bits;
+
+    if (!isfinite(value)) {
+        /* As JSON has nothing for them either. */
+        jd_putc(dumper, (char)CBOR_NULL);
+        return;
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    item[0] = CBOR_FLOAT64;
+    phton64(item + 1, bits);
+    jd_puts_len(dumper, (const char *)item, sizeof(item));
+}
+
+static void
+cbor_put_text_len(json_dumper *dumper, const char *str, gsize len, gboolean dot_to_underscore)
+{
+    cbor_put_head(dumper, CBOR_TYPE_TEXT, len);
+    if (dot_to_underscore && memchr(str, '.', len) != NULL) {
+        char *copy = g_strndup(str, len);
+
+        g_strdelimit(copy, ".", '_');
+        jd_puts_len(dumper, copy, len);
+        g_free(copy);
+    } else {
+        jd_puts_len(dumper, str, len);
+    }
+}
+
+static void
+cbor_put_text(json_dumper *dumper, const char *str, gboolean dot_to_underscore)
+{
+    if (!str) {
+        jd_putc(dumper, (char)CBOR_NULL);
+        return;
+    }
+    cbor_put_text_len(dumper, str, strlen(str), dot_to_underscore);
+}
+
+/* Writes the CBOR equivalent of a JSON literal, see json_dumper.h. */
+static void
+cbor_put_literal(json_dumper *dumper, const char *text)
+{
+    gsize len = strlen(text);
+    char *end;
+
+    if (strcmp(text, "true") == 0) {
+        jd_putc(dumper, (char)CBOR_TRUE);
+        return;
+    }
+    if (strcmp(text, "false") == 0) {
+        jd_putc(dumper, (char)CBOR_FALSE);
+        return;
+    }
+    if (strcmp(text, "null") == 0) {
+        jd_putc(dumper, (char)CBOR_NULL);
+        return;
+    }
+    if (len >= 2 && text[0] == '"' && text[len - 1] == '"') {
+        cbor_put_text_len(dumper, text + 1, len - 2, FALSE);
+        return;
+    }
+    if (len != 0 && (g_ascii_isdigit(text[0]) || text[0] == '-')) {
+        errno = 0;
+        if (text[0] == '-') {
+            gint64 value = g_ascii_strtoll(text, &end, 10);
+
+            if (errno == 0 && *end == '\0') {
+                cbor_put_int64(dumper, value);
+                return;
+            }
+        } else {
+            guint64 value = g_ascii_strtoull(text, &end, 10);
+
+            if (errno == 0 && *end == '\0') {
+                cbor_put_head(dumper, CBOR_TYPE_UINT, value);
+                return;
+            }
+        }
+        errno = 0;
+        double value = g_ascii_strtod(text, &end);
+        if (errno == 0 && *end == '\0') {
+            cbor_put_double(dumper, value);
+            return;
+        }
+    }
+    cbor_put_text_len(dumper, text, len, FALSE);
+}
+
 /**
  * Called when a programming error is encountered where the JSON manipulation
  * state got corrupted. This could happen when pairing the wrong begin/end
@@ -153,6 +370,7 @@ json_dumper_bad(json_dumper *dumper, enum json_dumper_change change,
         /* Console output can be slow, disable log calls to speed up fuzzing. */
         return;
     }
+    jd_flush(dumper);
     if (dumper->output_file) {
         fflush(dumper->output_file);
     }
@@ -222,16 +440,30 @@ json_dumper_check_state(json_dumper *dumper, enum json_dumper_change change, enu
 }
 
 static void
-print_newline_indent(const json_dumper *dumper, int depth)
+print_newline_indent(json_dumper *dumper, int depth)
 {
     if ((dumper->flags & JSON_DUMPER_FLAGS_PRETTY_PRINT)) {
         jd_putc(dumper, '\n');
         for (int i = 0; i < depth; i++) {
-            jd_puts(dumper, "  ");
+            jd_puts_len(dumper, "  ", 2);
         }
     }
 }
 
+/*
+ * Writes out the buffered output once an object or array begins or ends at
+ * the top level or directly within it, e.g. after each packet of tshark's
+ * "-T json" array, so that it is not held back from other writers of the
+ * same file for long.
+ */
+static void
+flush_if_shallow(json_dumper *dumper)
+{
+    if (dumper->current_depth <= 1) {
+        jd_flush(dumper);
+    }
+}
+
 /**
  * Prints commas, newlines and indentation (if necessary). Used for array
  * values, object names and normal values (strings, etc.).
@@ -239,6 +471,10 @@ print_newline_indent(const json_dumper *dumper, int depth)
 static void
 prepare_token(json_dumper *dumper)
 {
+    if (JSON_DUMPER_IS_CBOR(dumper)) {
+        // CBOR needs no separators.
+        return;
+    }
     if (dumper->current_depth == 0) {
         // not part of an array or object.
         return;
@@ -273,8 +509,12 @@ prepare_token(json_dumper *dumper)
  * necessary, it is preceded by newline and indentation).
  */
 static void
-finish_token(const json_dumper *dumper, char close_char)
+finish_token(json_dumper *dumper, char close_char)
 {
+    if (JSON_DUMPER_IS_CBOR(dumper)) {
+        jd_putc(dumper, (char)CBOR_BREAK);
+        return;
+    }
     // if the object/array was non-empty, add a newline and indentation.
     if (dumper->state[dumper->current_depth]) {
         print_newline_indent(dumper, dumper->current_depth - 1);
@@ -290,11 +530,12 @@ json_dumper_begin_object(json_dumper *dumper)
     }
 
     prepare_token(dumper);
-    jd_putc(dumper, '{');
+    jd_putc(dumper, JSON_DUMPER_IS_CBOR(dumper) ? (char)CBOR_MAP_INDEFINITE : '{');
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_OBJECT;
     ++dumper->current_depth;
     dumper->state[dumper->current_depth] = 0;
+    flush_if_shallow(dumper);
 }
 
 void
@@ -305,10 +546,14 @@ json_dumper_set_member_name(json_dumper *dumper, const char *name)
     }
 
     prepare_token(dumper);
-    json_puts_string(dumper, name, dumper->flags & JSON_DUMPER_DOT_TO_UNDERSCORE);
-    jd_putc(dumper, ':');
-    if ((dumper->flags & JSON_DUMPER_FLAGS_PRETTY_PRINT)) {
-        jd_putc(dumper, ' ');
+    if (JSON_DUMPER_IS_CBOR(dumper)) {
+        cbor_put_text(dumper, name, dumper->flags & JSON_DUMPER_DOT_TO_UNDERSCORE);
+    } else {
+        json_puts_string(dumper, name, dumper->flags & JSON_DUMPER_DOT_TO_UNDERSCORE);
+        jd_putc(dumper, ':');
+        if ((dumper->flags & JSON_DUMPER_FLAGS_PRETTY_PRINT)) {
+            jd_putc(dumper, ' ');
+        }
     }
 
     dumper->state[dumper->current_depth - 1] |= JSON_DUMPER_HAS_NAME;
@@ -324,6 +569,7 @@ json_dumper_end_object(json_dumper *dumper)
     finish_token(dumper, '}');
 
     --dumper->current_depth;
+    flush_if_shallow(dumper);
 }
 
 void
@@ -334,11 +580,12 @@ json_dumper_begin_array(json_dumper *dumper)
     }
 
     prepare_token(dumper);
-    jd_putc(dumper, '[');
+    jd_putc(dumper, JSON_DUMPER_IS_CBOR(dumper) ? (char)CBOR_ARRAY_INDEFINITE : '[');
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_ARRAY;
     ++dumper->current_depth;
     dumper->state[dumper->current_depth] = 0;
+    flush_if_shallow(dumper);
 }
 
 void
@@ -351,6 +598,22 @@ json_dumper_end_array(json_dumper *dumper)
     finish_token(dumper, ']');
 
     --dumper->current_depth;
+    flush_if_shallow(dumper);
+}
+
+void
+json_dumper_skip_array_element(json_dumper *dumper)
+{
+    if (!json_dumper_check_state(dumper, JSON_DUMPER_SET_VALUE, JSON_DUMPER_TYPE_VALUE)) {
+        return;
+    }
+    if (dumper->current_depth == 0 ||
+            JSON_DUMPER_TYPE(dumper->state[dumper->current_depth - 1]) != JSON_DUMPER_TYPE_ARRAY) {
+        dumper->flags |= JSON_DUMPER_FLAGS_ERROR;
+        return;
+    }
+
+    dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
 }
 
 void
@@ -361,7 +624,11 @@ json_dumper_value_string(json_dumper *dumper, const char *value)
     }
 
     prepare_token(dumper);
-    json_puts_string(dumper, value, FALSE);
+    if (JSON_DUMPER_IS_CBOR(dumper)) {
+        cbor_put_text(dumper, value, FALSE);
+    } else {
+        json_puts_string(dumper, value, FALSE);
+    }
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
 }
@@ -375,7 +642,9 @@ json_dumper_value_double(json_dumper *dumper, double value)
 
     prepare_token(dumper);
     gchar buffer[G_ASCII_DTOSTR_BUF_SIZE] = { 0 };
-    if (isfinite(value) && g_ascii_dtostr(buffer, G_ASCII_DTOSTR_BUF_SIZE, value) && buffer[0]) {
+    if (JSON_DUMPER_IS_CBOR(dumper)) {
+        cbor_put_double(dumper, value);
+    } else if (isfinite(value) && g_ascii_dtostr(buffer, G_ASCII_DTOSTR_BUF_SIZE, value) && buffer[0]) {
         jd_puts(dumper, buffer);
     } else {
         jd_puts(dumper, "null");
@@ -384,6 +653,46 @@ json_dumper_value_double(json_dumper *dumper, double value)
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
 }
 
+void
+json_dumper_value_int64(json_dumper *dumper, gint64 value)
+{
+    if (!json_dumper_check_state(dumper, JSON_DUMPER_SET_VALUE, JSON_DUMPER_TYPE_VALUE)) {
+        return;
+    }
+
+    prepare_token(dumper);
+    if (JSON_DUMPER_IS_CBOR(dumper)) {
+        cbor_put_int64(dumper, value);
+    } else {
+        char buffer[sizeof("-9223372036854775808")];
+        char *end = buffer + sizeof(buffer);
+        char *start = int64_to_str_back(end, value);
+        jd_puts_len(dumper, start, end - start);
+    }
+
+    dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
+}
+
+void
+json_dumper_value_uint64(json_dumper *dumper, guint64 value)
+{
+    if (!json_dumper_check_state(dumper, JSON_DUMPER_SET_VALUE, JSON_DUMPER_TYPE_VALUE)) {
+        return;
+    }
+
+    prepare_token(dumper);
+    if (JSON_DUMPER_IS_CBOR(dumper)) {
+        cbor_put_head(dumper, CBOR_TYPE_UINT, value);
+    } else {
+        char buffer[sizeof("18446744073709551615")];
+        char *end = buffer + sizeof(buffer);
+        char *start = uint64_to_str_back(end, value);
+        jd_puts_len(dumper, start, end - start);
+    }
+
+    dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
+}
+
 void
 json_dumper_value_va_list(json_dumper *dumper, const char *format, va_list ap)
 {
@@ -392,7 +701,14 @@ json_dumper_value_va_list(json_dumper *dumper, const char *format, va_list ap)
     }
 
     prepare_token(dumper);
-    jd_vprintf(dumper, format, ap);
+    if (JSON_DUMPER_IS_CBOR(dumper)) {
+        char *text = g_strdup_vprintf(format, ap);
+
+        cbor_put_literal(dumper, text);
+        g_free(text);
+    } else {
+        jd_vprintf(dumper, format, ap);
+    }
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
 }
@@ -414,7 +730,10 @@ json_dumper_finish(json_dumper *dumper)
         return FALSE;
     }
 
-    jd_putc(dumper, '\n');
+    if (!JSON_DUMPER_IS_CBOR(dumper)) {
+        jd_putc(dumper, '\n');
+    }
+    jd_flush(dumper);
     dumper->state[0] = 0;
     return TRUE;
 }
@@ -431,7 +750,7 @@ json_dumper_begin_base64(json_dumper *dumper)
 
     prepare_token(dumper);
 
-    jd_putc(dumper, '"');
+    jd_putc(dumper, JSON_DUMPER_IS_CBOR(dumper) ? (char)CBOR_BYTES_INDEFINITE : '"');
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_BASE64;
     ++dumper->current_depth;
@@ -445,6 +764,16 @@ json_dumper_write_base64(json_dumper* dumper, const guchar *data, size_t len)
         return;
     }
 
+    if (JSON_DUMPER_IS_CBOR(dumper)) {
+        /* The data goes in as it is, as a chunk of the byte string. */
+        if (len > 0) {
+            cbor_put_head(dumper, CBOR_TYPE_BYTES, len);
+            jd_puts_len(dumper, (const char *)data, len);
+        }
+        dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_BASE64;
+        return;
+    }
+
     #define CHUNK_SIZE 1024
     gchar buf[(CHUNK_SIZE / 3 + 1) * 4 + 4];
 
@@ -466,6 +795,12 @@ json_dumper_end_base64(json_dumper *dumper)
         return;
     }
 
+    if (JSON_DUMPER_IS_CBOR(dumper)) {
+        jd_putc(dumper, (char)CBOR_BREAK);
+        --dumper->current_depth;
+        return;
+    }
+
     gchar buf[4];
     gsize wrote;
 
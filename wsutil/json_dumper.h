@@ -46,21 +46,41 @@ extern "C" {
  *  json_dumper_end_array(&dumper);
  *  json_dumper_end_object(&dumper);
  *  json_dumper_finish(&dumper);
+ *
+ * With JSON_DUMPER_FLAGS_CBOR, the same calls write CBOR (RFC 8949): objects
+ * and arrays become indefinite-length maps and arrays, so nothing needs to be
+ * held back until they end, and base64 data becomes a byte string. Values
+ * written with json_dumper_value_anyf() are converted from their JSON text:
+ * true, false, null, integers and other numbers become the CBOR equivalents,
+ * text in double quotes becomes a text string of what is between them, and
+ * anything else becomes a text string as it is. Pretty printing is ignored,
+ * and json_dumper_finish() adds no newline.
  */
 
 /** Maximum object/array nesting depth. */
 #define JSON_DUMPER_MAX_DEPTH   1100
+/** Size of the buffer in which output is collected before it is written. */
+#define JSON_DUMPER_BUFFER_SIZE 4096
 typedef struct json_dumper {
     FILE    *output_file;    /**< Output file. If it is not NULL, JSON will be dumped in the file. */
     GString *output_string;  /**< Output GLib strings. If it is not NULL, JSON will be dumped in the string. */
 #define JSON_DUMPER_FLAGS_PRETTY_PRINT  (1 << 0)    /* Enable pretty printing. */
 #define JSON_DUMPER_DOT_TO_UNDERSCORE   (1 << 1)    /* Convert dots to underscores in keys */
+#define JSON_DUMPER_FLAGS_CBOR          (1 << 2)    /* Write CBOR instead of JSON, see below. */
     int     flags;
     /* for internal use, initialize with zeroes. */
     int     current_depth;
     gint    base64_state;
     gint    base64_save;
     guint8  state[JSON_DUMPER_MAX_DEPTH];
+    /*
+     * Output not yet written to output_file or output_string. It is written
+     * whenever an object or array at the top level or directly within the
+     * top-level one ends, so that other output to the same file can go in
+     * between two packets, and by json_dumper_finish().
+     */
+    gsize   buffer_len;
+    char    buffer[JSON_DUMPER_BUFFER_SIZE];
 } json_dumper;
 
 WS_DLL_PUBLIC void
@@ -78,12 +98,35 @@ json_dumper_begin_array(json_dumper *dumper);
 WS_DLL_PUBLIC void
 json_dumper_end_array(json_dumper *dumper);
 
+/**
+ * Accounts for an array element that was written to the output by someone
+ * else, e.g. another process writing to the same file, so that what this
+ * dumper writes next is separated from it without writing anything now.
+ * Only valid directly within an array.
+ */
+WS_DLL_PUBLIC void
+json_dumper_skip_array_element(json_dumper *dumper);
+
 WS_DLL_PUBLIC void
 json_dumper_value_string(json_dumper *dumper, const char *value);
 
 WS_DLL_PUBLIC void
 json_dumper_value_double(json_dumper *dumper, double value);
 
+/**
+ * Dump an integer as a JSON number. Cheaper than json_dumper_value_anyf()
+ * with "%" PRId64.
+ */
+WS_DLL_PUBLIC void
+json_dumper_value_int64(json_dumper *dumper, gint64 value);
+
+/**
+ * Dump an unsigned integer as a JSON number. Cheaper than
+ * json_dumper_value_anyf() with "%" PRIu64.
+ */
+WS_DLL_PUBLIC void
+json_dumper_value_uint64(json_dumper *dumper, guint64 value);
+
 /**
  * Dump number, "true", "false" or "null" values.
  */
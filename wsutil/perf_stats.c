@@ -0,0 +1,175 @@
+/* perf_stats.c
+ * Performance counters and timers that are always on.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#define WS_LOG_DOMAIN LOG_DOMAIN_WSUTIL
+
+#include "perf_stats.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <wsutil/str_util.h>
+
+/*
+ * glib only has atomic operations on ints and pointers, and the counters
+ * need 64 bits even on 32-bit platforms.
+ */
+#ifdef _MSC_VER
+#define PERF_ATOMIC_ADD(p, v)   InterlockedExchangeAdd64((volatile LONG64 *)(p), (LONG64)(v))
+#define PERF_ATOMIC_GET(p)      ((guint64)InterlockedCompareExchange64((volatile LONG64 *)(p), 0, 0))
+#define PERF_ATOMIC_SET(p, v)   InterlockedExchange64((volatile LONG64 *)(p), (LONG64)(v))
+#else
+#define PERF_ATOMIC_ADD(p, v)   __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define PERF_ATOMIC_GET(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define PERF_ATOMIC_SET(p, v)   __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#endif
+
+static const struct {
+    const char     *name;
+    const char     *description;
+    ws_perf_unit_e  unit;
+} counter_info[WS_PERF_NUM_COUNTERS] = {
+    { "wiretap.bytes_read",         "Bytes read",           WS_PERF_UNIT_BYTES },
+    { "wiretap.bytes_decompressed", "Bytes decompressed",   WS_PERF_UNIT_BYTES },
+    { "wiretap.records_read",       "Records read",         WS_PERF_UNIT_COUNT },
+    { "epan.dissect_time",          "Dissection time",      WS_PERF_UNIT_NS },
+    { "epan.filter_time",           "Filter time",          WS_PERF_UNIT_NS },
+    { "epan.tap_time",              "Tap time",             WS_PERF_UNIT_NS },
+    { "ui.output_time",             "Output time",          WS_PERF_UNIT_NS },
+};
+
+static guint64 counters[WS_PERF_NUM_COUNTERS];
+
+/* When the counters were last reset, or 0 if they never have been. */
+static guint64 reset_time_ns;
+
+typedef struct {
+    const char     *name;
+    const char     *description;
+    ws_perf_unit_e  unit;
+    guint64       (*fetch)(void);
+} perf_gauge_t;
+
+static GArray *gauges;
+
+void
+ws_perf_add(ws_perf_counter_e counter, guint64 value)
+{
+    PERF_ATOMIC_ADD(&counters[counter], value);
+}
+
+void
+ws_perf_timer_stop(ws_perf_counter_e counter, guint64 start)
+{
+    PERF_ATOMIC_ADD(&counters[counter], ws_clock_get_monotonic_ns() - start);
+}
+
+void
+ws_perf_gauge_register(const char *name, const char *description,
+                       ws_perf_unit_e unit, guint64 (*fetch)(void))
+{
+    perf_gauge_t gauge = { name, description, unit, fetch };
+
+    if (gauges == NULL)
+        gauges = g_array_new(FALSE, FALSE, sizeof(perf_gauge_t));
+    g_array_append_val(gauges, gauge);
+}
+
+void
+ws_perf_gauges_cleanup(void)
+{
+    if (gauges != NULL) {
+        g_array_free(gauges, TRUE);
+        gauges = NULL;
+    }
+}
+
+void
+ws_perf_reset(void)
+{
+    int i;
+
+    for (i = 0; i < WS_PERF_NUM_COUNTERS; i++)
+        PERF_ATOMIC_SET(&counters[i], 0);
+    reset_time_ns = ws_clock_get_monotonic_ns();
+}
+
+static void
+append_stat(GArray *stats, const char *name, const char *description,
+            ws_perf_unit_e unit, guint64 value)
+{
+    ws_perf_stat_t stat = { name, description, unit, value };
+
+    g_array_append_val(stats, stat);
+}
+
+GArray *
+ws_perf_get_stats(void)
+{
+    GArray *stats = g_array_new(FALSE, FALSE, sizeof(ws_perf_stat_t));
+    guint64 elapsed_ns = 0;
+    int i;
+    guint j;
+
+    for (i = 0; i < WS_PERF_NUM_COUNTERS; i++) {
+        append_stat(stats, counter_info[i].name, counter_info[i].description,
+                    counter_info[i].unit, PERF_ATOMIC_GET(&counters[i]));
+    }
+
+    if (reset_time_ns != 0)
+        elapsed_ns = ws_clock_get_monotonic_ns() - reset_time_ns;
+    append_stat(stats, "wiretap.records_per_sec", "Records per second",
+                WS_PERF_UNIT_PER_SEC,
+                elapsed_ns == 0 ? 0 :
+                    (guint64)(PERF_ATOMIC_GET(&counters[WS_PERF_RECORDS_READ]) * 1e9 / elapsed_ns));
+
+    for (j = 0; gauges != NULL && j < gauges->len; j++) {
+        perf_gauge_t *gauge = &g_array_index(gauges, perf_gauge_t, j);
+
+        append_stat(stats, gauge->name, gauge->description, gauge->unit,
+                    gauge->fetch());
+    }
+    return stats;
+}
+
+char *
+ws_perf_stat_value_to_str(const ws_perf_stat_t *stat)
+{
+    switch (stat->unit) {
+
+    case WS_PERF_UNIT_BYTES:
+        return format_size(stat->value, FORMAT_SIZE_UNIT_BYTES, FORMAT_SIZE_PREFIX_IEC);
+
+    case WS_PERF_UNIT_NS:
+        return g_strdup_printf("%.3f ms", stat->value / 1000000.0);
+
+    case WS_PERF_UNIT_PER_SEC:
+        return g_strdup_printf("%" PRIu64 "/s", stat->value);
+
+    case WS_PERF_UNIT_COUNT:
+    default:
+        return g_strdup_printf("%" PRIu64, stat->value);
+    }
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
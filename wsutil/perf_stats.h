@@ -0,0 +1,134 @@
+/** @file
+ * Performance counters and timers that are always on, for seeing where
+ * the time and memory go while reading and dissecting captures.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WSUTIL_PERF_STATS_H__
+#define __WSUTIL_PERF_STATS_H__
+
+#include "ws_symbol_export.h"
+#include <glib.h>
+
+#include <wsutil/time_util.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Counters only ever go up, until ws_perf_reset(); updating one is an
+ * atomic add, so they're cheap enough to leave on, and can be updated
+ * from more than one thread.  Timers are counters of nanoseconds.
+ *
+ * Gauges are values, such as the size of a table, that the code that
+ * owns them is asked for when the statistics are read.
+ */
+typedef enum {
+    WS_PERF_BYTES_READ,             /**< Bytes read from capture files */
+    WS_PERF_BYTES_DECOMPRESSED,     /**< Bytes got by decompressing capture files */
+    WS_PERF_RECORDS_READ,           /**< Records read from capture files */
+    WS_PERF_DISSECT_TIME,           /**< Time spent dissecting records */
+    WS_PERF_FILTER_TIME,            /**< Time spent applying filters */
+    WS_PERF_TAP_TIME,               /**< Time spent in tap listeners' packet routines */
+    WS_PERF_OUTPUT_TIME,            /**< Time spent printing or writing records */
+    WS_PERF_NUM_COUNTERS
+} ws_perf_counter_e;
+
+typedef enum {
+    WS_PERF_UNIT_COUNT,
+    WS_PERF_UNIT_BYTES,
+    WS_PERF_UNIT_NS,                /**< Nanoseconds */
+    WS_PERF_UNIT_PER_SEC            /**< A count per second since the statistics were reset */
+} ws_perf_unit_e;
+
+/** A counter, gauge or rate, as got by ws_perf_get_stats(). */
+typedef struct {
+    const char     *name;           /**< Short name, e.g. "wiretap.bytes_read" */
+    const char     *description;    /**< Description, e.g. "Bytes read" */
+    ws_perf_unit_e  unit;
+    guint64         value;
+} ws_perf_stat_t;
+
+/** Add to a counter.
+ *
+ * @param counter The counter.
+ * @param value What to add to it.
+ */
+WS_DLL_PUBLIC void ws_perf_add(ws_perf_counter_e counter, guint64 value);
+
+/** Start timing something, for ws_perf_timer_stop().
+ *
+ * @return The time it was started.
+ */
+static inline guint64
+ws_perf_timer_start(void)
+{
+    return ws_clock_get_monotonic_ns();
+}
+
+/** Add the time since ws_perf_timer_start() to a timer.
+ *
+ * @param counter The timer.
+ * @param start What ws_perf_timer_start() returned.
+ */
+WS_DLL_PUBLIC void ws_perf_timer_stop(ws_perf_counter_e counter, guint64 start);
+
+/** Register a gauge.  The strings must outlive the registration.
+ *
+ * @param name Short name, e.g. "epan.conversations".
+ * @param description Description, e.g. "Conversations".
+ * @param unit What the value is in.
+ * @param fetch Returns the current value.  It's called from the thread
+ * that calls ws_perf_get_stats().
+ */
+WS_DLL_PUBLIC void ws_perf_gauge_register(const char *name, const char *description,
+                                          ws_perf_unit_e unit, guint64 (*fetch)(void));
+
+/** Unregister all the gauges, as the code that registered them is being
+ * cleaned up.
+ */
+WS_DLL_PUBLIC void ws_perf_gauges_cleanup(void);
+
+/** Zero the counters, and start the time that rates are worked out over
+ * again.
+ */
+WS_DLL_PUBLIC void ws_perf_reset(void);
+
+/** Get the counters, the rates worked out from them, and the gauges.
+ *
+ * @return A GArray of ws_perf_stat_t, to be freed with
+ * g_array_free(stats, TRUE).
+ */
+WS_DLL_PUBLIC GArray *ws_perf_get_stats(void);
+
+/** Format a statistic's value with its unit, e.g. "12.345 ms".
+ *
+ * @param stat The statistic.
+ * @return The string, to be freed with g_free().
+ */
+WS_DLL_PUBLIC char *ws_perf_stat_value_to_str(const ws_perf_stat_t *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WSUTIL_PERF_STATS_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
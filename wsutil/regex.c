@@ -17,6 +17,10 @@
 
 struct _ws_regex {
     pcre2_code *code;
+    /* We don't use the matched substring but pcre2_match requires
+     * at least one pair of offsets, so keep one set of them to use
+     * for every match rather than allocating it each time. */
+    pcre2_match_data *match_data;
     char *pattern;
 };
 
@@ -75,6 +79,16 @@ compile_pcre2(const char *patt, ssize_t size, char **errmsg, unsigned flags)
         return NULL;
     }
 
+    /* Compile to machine code, if the library supports it, as these
+     * are mostly run against a lot of packets. If that doesn't work
+     * pcre2_match() just interprets the pattern. */
+    errorcode = pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+    if (errorcode != 0) {
+        char *msg = get_error_msg(errorcode);
+        ws_debug("Not using PCRE2 JIT: %s.", msg);
+        g_free(msg);
+    }
+
     return code;
 }
 
@@ -90,6 +104,7 @@ ws_regex_compile_ex(const char *patt, ssize_t size, char **errmsg, unsigned flag
 
     ws_regex_t *re = g_new(ws_regex_t, 1);
     re->code = code;
+    re->match_data = pcre2_match_data_create(1, NULL);
     re->pattern = ws_escape_string_len(NULL, patt, size, false);
     return re;
 }
@@ -122,6 +137,18 @@ match_pcre2(pcre2_code *code, const char *subject, ssize_t subj_length,
                     match_data,
                     NULL);
 
+    if (rc == PCRE2_ERROR_JIT_STACKLIMIT) {
+        /* The machine code ran out of stack; the interpreter doesn't
+         * have that limit. */
+        rc = pcre2_match(code,
+                        subject,
+                        length,
+                        0,
+                        PCRE2_NO_JIT,
+                        match_data,
+                        NULL);
+    }
+
     if (rc < 0) {
         /* No match */
         if (rc != PCRE2_ERROR_NOMATCH) {
@@ -150,18 +177,10 @@ bool
 ws_regex_matches_length(const ws_regex_t *re,
                         const char *subj, ssize_t subj_length)
 {
-    bool matched;
-    pcre2_match_data *match_data;
-
     ws_return_val_if_null(re, FALSE);
     ws_return_val_if_null(subj, FALSE);
 
-    /* We don't use the matched substring but pcre2_match requires
-     * at least one pair of offsets. */
-    match_data = pcre2_match_data_create(1, NULL);
-    matched = match_pcre2(re->code, subj, subj_length, match_data);
-    pcre2_match_data_free(match_data);
-    return matched;
+    return match_pcre2(re->code, subj, subj_length, re->match_data);
 }
 
 
@@ -171,19 +190,16 @@ ws_regex_matches_pos(const ws_regex_t *re,
                         size_t pos_vect[2])
 {
     bool matched;
-    pcre2_match_data *match_data;
 
     ws_return_val_if_null(re, FALSE);
     ws_return_val_if_null(subj, FALSE);
 
-    match_data = pcre2_match_data_create(1, NULL);
-    matched = match_pcre2(re->code, subj, subj_length, match_data);
+    matched = match_pcre2(re->code, subj, subj_length, re->match_data);
     if (matched && pos_vect) {
-        PCRE2_SIZE *ovect = pcre2_get_ovector_pointer(match_data);
+        PCRE2_SIZE *ovect = pcre2_get_ovector_pointer(re->match_data);
         pos_vect[0] = ovect[0];
         pos_vect[1] = ovect[1];
     }
-    pcre2_match_data_free(match_data);
     return matched;
 }
 
@@ -192,6 +208,7 @@ void
 ws_regex_free(ws_regex_t *re)
 {
     pcre2_code_free(re->code);
+    pcre2_match_data_free(re->match_data);
     g_free(re->pattern);
     g_free(re);
 }
@@ -17,6 +17,8 @@ extern "C" {
 #endif
 
 struct _ws_regex;
+/* A compiled regex keeps the state of its last match, so one mustn't be
+ * used for matching by more than one thread at a time. */
 typedef struct _ws_regex ws_regex_t;
 
 WS_DLL_PUBLIC ws_regex_t *
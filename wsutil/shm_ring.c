@@ -0,0 +1,329 @@
+/* shm_ring.c
+ * A ring of the most recent bytes written to a file, in shared memory.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#define WS_LOG_DOMAIN LOG_DOMAIN_WSUTIL
+
+#include "shm_ring.h"
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef HAVE_SHM_OPEN
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <ws_attributes.h>
+#include <wsutil/ws_assert.h>
+
+#define SHM_RING_MAGIC      0x57535247  /* "WSRG" */
+#define SHM_RING_VERSION    1
+
+/*
+ * The start of the shared memory; the data follows it.  The offsets
+ * of the fields are the same for 32-bit and 64-bit processes.
+ *
+ * The writer changes reserved and written only while seq is odd, so a
+ * reader takes a copy of them that it knows is consistent by reading
+ * seq, them, and seq again, and trying again if seq was odd or changed.
+ * Bytes up to written have been copied into the ring; bytes up to
+ * reserved may be being copied, and so bytes from reserved - size on
+ * may be being overwritten.
+ */
+typedef struct {
+    guint32      magic;
+    guint32      version;
+    guint64      size;          /**< Bytes of data; a power of 2 */
+    gint         seq;
+    guint32      pad;
+    guint64      reserved;      /**< End of the bytes being written */
+    guint64      written;       /**< End of the bytes that have been written */
+} shm_ring_header;
+
+#define SHM_RING_DATA_OFFSET 64
+
+/*
+ * The size is checked against the mapping once, when the ring is created
+ * or opened, and kept here; the copy in the shared header is never used
+ * again, so a writer changing it can't make us copy outside the mapping.
+ */
+struct _ws_shm_ring {
+    shm_ring_header *hdr;
+    guint8          *data;
+    size_t           size;      /**< Bytes of data; a power of 2 */
+    size_t           map_size;
+    char            *name;      /**< Our name, if we created it */
+};
+
+#ifdef HAVE_SHM_OPEN
+static ws_shm_ring *
+shm_ring_map(int fd, size_t map_size, int prot, int *err)
+{
+    ws_shm_ring *ring;
+    void *map;
+
+    map = mmap(NULL, map_size, prot, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        *err = errno;
+        return NULL;
+    }
+    ring = g_new0(ws_shm_ring, 1);
+    ring->hdr = (shm_ring_header *)map;
+    ring->data = (guint8 *)map + SHM_RING_DATA_OFFSET;
+    ring->size = map_size - SHM_RING_DATA_OFFSET;
+    ring->map_size = map_size;
+    return ring;
+}
+
+ws_shm_ring *
+ws_shm_ring_create(const char *name, size_t size, int *err)
+{
+    ws_shm_ring *ring;
+    size_t map_size = SHM_RING_DATA_OFFSET + size;
+    int fd;
+
+    ws_assert(size != 0 && (size & (size - 1)) == 0);
+
+    /* Don't pick up a ring left behind by a process that crashed. */
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600);
+    if (fd == -1) {
+        *err = errno;
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)map_size) == -1) {
+        *err = errno;
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    ring = shm_ring_map(fd, map_size, PROT_READ|PROT_WRITE, err);
+    close(fd);
+    if (ring == NULL) {
+        shm_unlink(name);
+        return NULL;
+    }
+    ring->name = g_strdup(name);
+    ring->hdr->size = size;
+    ring->hdr->version = SHM_RING_VERSION;
+    /* Readers check this last. */
+    g_atomic_int_set((gint *)&ring->hdr->magic, SHM_RING_MAGIC);
+    return ring;
+}
+
+ws_shm_ring *
+ws_shm_ring_open(const char *name, int *err)
+{
+    ws_shm_ring *ring;
+    struct stat statb;
+    size_t size;
+    int fd;
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        *err = errno;
+        return NULL;
+    }
+    if (fstat(fd, &statb) == -1) {
+        *err = errno;
+        close(fd);
+        return NULL;
+    }
+    /*
+     * The name is predictable, so make sure it's ours, and that nobody
+     * else could have got at it, before trusting what's in it; we
+     * create rings with mode 0600.
+     */
+    if (statb.st_uid != geteuid() || (statb.st_mode & (S_IRWXG|S_IRWXO)) != 0) {
+        *err = EACCES;
+        close(fd);
+        return NULL;
+    }
+    if (statb.st_size <= SHM_RING_DATA_OFFSET) {
+        *err = EINVAL;
+        close(fd);
+        return NULL;
+    }
+    size = (size_t)statb.st_size - SHM_RING_DATA_OFFSET;
+    if ((size & (size - 1)) != 0) {
+        *err = EINVAL;
+        close(fd);
+        return NULL;
+    }
+    ring = shm_ring_map(fd, (size_t)statb.st_size, PROT_READ, err);
+    close(fd);
+    if (ring == NULL)
+        return NULL;
+    if ((guint32)g_atomic_int_get((gint *)&ring->hdr->magic) != SHM_RING_MAGIC ||
+        ring->hdr->version != SHM_RING_VERSION ||
+        ring->hdr->size != size) {
+        *err = EINVAL;
+        ws_shm_ring_close(ring);
+        return NULL;
+    }
+    return ring;
+}
+
+void
+ws_shm_ring_close(ws_shm_ring *ring)
+{
+    if (ring == NULL)
+        return;
+    munmap(ring->hdr, ring->map_size);
+    if (ring->name != NULL) {
+        shm_unlink(ring->name);
+        g_free(ring->name);
+    }
+    g_free(ring);
+}
+
+/* Copy len bytes into the ring at offset, wrapping at its end. */
+static void
+shm_ring_put(ws_shm_ring *ring, guint64 offset, const guint8 *from, size_t len)
+{
+    size_t size = ring->size;
+    size_t start = (size_t)(offset & (size - 1));
+    size_t first = MIN(len, size - start);
+
+    memcpy(ring->data + start, from, first);
+    memcpy(ring->data, from + first, len - first);
+}
+
+/* Copy len bytes out of the ring at offset, wrapping at its end. */
+static void
+shm_ring_get(ws_shm_ring *ring, guint64 offset, guint8 *to, size_t len)
+{
+    size_t size = ring->size;
+    size_t start = (size_t)(offset & (size - 1));
+    size_t first = MIN(len, size - start);
+
+    memcpy(to, ring->data + start, first);
+    memcpy(to + first, ring->data, len - first);
+}
+
+void
+ws_shm_ring_write(ws_shm_ring *ring, const void *data, size_t len)
+{
+    shm_ring_header *hdr = ring->hdr;
+    const guint8 *p = (const guint8 *)data;
+    guint64 end = hdr->written + len;
+
+    /* Only the last size bytes will be left. */
+    if (len > ring->size) {
+        p += len - ring->size;
+        len = ring->size;
+    }
+
+    g_atomic_int_inc(&hdr->seq);
+    hdr->reserved = end;
+    g_atomic_int_inc(&hdr->seq);
+
+    shm_ring_put(ring, end - len, p, len);
+
+    g_atomic_int_inc(&hdr->seq);
+    hdr->written = end;
+    g_atomic_int_inc(&hdr->seq);
+}
+
+/* Get consistent copies of reserved and written. */
+static void
+shm_ring_positions(shm_ring_header *hdr, guint64 *reserved, guint64 *written)
+{
+    gint seq;
+
+    for (;;) {
+        seq = g_atomic_int_get(&hdr->seq);
+        if ((seq & 1) == 0) {
+            *reserved = hdr->reserved;
+            *written = hdr->written;
+            if (g_atomic_int_get(&hdr->seq) == seq)
+                return;
+        }
+        g_thread_yield();
+    }
+}
+
+gint64
+ws_shm_ring_read(ws_shm_ring *ring, gint64 offset, void *buf, size_t len)
+{
+    shm_ring_header *hdr = ring->hdr;
+    guint64 reserved, written;
+    size_t count;
+
+    shm_ring_positions(hdr, &reserved, &written);
+    if ((guint64)offset >= written)
+        return 0;
+    if (reserved > ring->size && (guint64)offset < reserved - ring->size)
+        return -1;
+    count = (size_t)MIN((guint64)len, written - (guint64)offset);
+    shm_ring_get(ring, (guint64)offset, (guint8 *)buf, count);
+
+    /* Make sure the writer didn't start overwriting them meanwhile. */
+    shm_ring_positions(hdr, &reserved, &written);
+    if (reserved > ring->size && (guint64)offset < reserved - ring->size)
+        return -1;
+    return (gint64)count;
+}
+
+#else /* HAVE_SHM_OPEN */
+
+ws_shm_ring *
+ws_shm_ring_create(const char *name _U_, size_t size _U_, int *err)
+{
+    *err = ENOTSUP;
+    return NULL;
+}
+
+ws_shm_ring *
+ws_shm_ring_open(const char *name _U_, int *err)
+{
+    *err = ENOTSUP;
+    return NULL;
+}
+
+void
+ws_shm_ring_close(ws_shm_ring *ring _U_)
+{
+}
+
+void
+ws_shm_ring_write(ws_shm_ring *ring _U_, const void *data _U_, size_t len _U_)
+{
+}
+
+gint64
+ws_shm_ring_read(ws_shm_ring *ring _U_, gint64 offset _U_, void *buf _U_, size_t len _U_)
+{
+    return -1;
+}
+
+#endif /* HAVE_SHM_OPEN */
+
+char *
+ws_shm_ring_capture_name(long pid)
+{
+    return g_strdup_printf("/wireshark-capture-%ld", pid);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
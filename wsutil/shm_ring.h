@@ -0,0 +1,87 @@
+/** @file
+ * A ring of the most recent bytes written to a file, in shared memory.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WSUTIL_SHM_RING_H__
+#define __WSUTIL_SHM_RING_H__
+
+#include "ws_symbol_export.h"
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * One process appends everything it writes to a file to the ring, as
+ * it writes it; other processes reading the same file can then get the
+ * bytes that were written recently from the ring rather than from the
+ * file.  The ring keeps the last size bytes written; a read of bytes
+ * that have already been overwritten, or that get overwritten while
+ * they're being read, fails, and the reader should read them from the
+ * file instead.
+ *
+ * There's one writer; the ring is removed when the writer closes it,
+ * although readers that already have it open can go on using it.
+ * Where POSIX shared memory isn't available, creating or opening a
+ * ring fails with ENOTSUP.
+ */
+typedef struct _ws_shm_ring ws_shm_ring;
+
+/**
+ * Create a ring with room for size bytes, which must be a power of 2.
+ * Returns NULL, with an errno value in *err, on failure.
+ */
+WS_DLL_PUBLIC ws_shm_ring *ws_shm_ring_create(const char *name, size_t size, int *err);
+
+/**
+ * Open a ring another process created.  The ring must belong to our
+ * effective user ID and be accessible only by it, or *err is set to
+ * EACCES.  Returns NULL, with an errno value in *err, on failure.
+ */
+WS_DLL_PUBLIC ws_shm_ring *ws_shm_ring_open(const char *name, int *err);
+
+/** Close a ring, and remove it if we created it. */
+WS_DLL_PUBLIC void ws_shm_ring_close(ws_shm_ring *ring);
+
+/** Append len bytes written to the file. */
+WS_DLL_PUBLIC void ws_shm_ring_write(ws_shm_ring *ring, const void *data, size_t len);
+
+/**
+ * Copy up to len bytes starting at offset in the file into buf.
+ * Returns the number of bytes copied, which is 0 if nothing at offset
+ * has been written yet, or -1 if the bytes at offset are no longer in
+ * the ring.
+ */
+WS_DLL_PUBLIC gint64 ws_shm_ring_read(ws_shm_ring *ring, gint64 offset, void *buf, size_t len);
+
+/**
+ * The name of the ring with which capture process pid shares the file
+ * it's writing with the process that started it.
+ */
+WS_DLL_PUBLIC char *ws_shm_ring_capture_name(long pid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WSUTIL_SHM_RING_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -1207,16 +1207,38 @@ EBCDIC_to_ASCII1(guint8 c)
                                    offset, 2 blanks separating offset
                                    from data dump, data dump */
 
+/*
+ * What each byte value shows as in the ASCII part of a hex dump, for each
+ * hex_dump_enc; filled in the first time it is needed.
+ */
+static gchar hex_dump_printable[2][256];
+
+static const gchar *
+hex_dump_printable_table(hex_dump_enc encoding)
+{
+    gchar *table = hex_dump_printable[encoding == HEXDUMP_ENC_EBCDIC];
+
+    if (table['0'] == '\0') {
+        for (unsigned c = 0; c < 256; c++) {
+            guchar a = encoding == HEXDUMP_ENC_EBCDIC ? EBCDIC_to_ASCII1(c) : c;
+            table[c] = ((a >= ' ') && (a < 0x7f)) ? a : '.';
+        }
+    }
+    return table;
+}
+
 gboolean
 hex_dump_buffer(gboolean (*print_line)(void *, const char *), void *fp,
                                     const guchar *cp, guint length,
                                     hex_dump_enc encoding,
                                     guint ascii_option)
 {
-    register unsigned int ad, i, j, k, l;
+    unsigned int          ad, i, l, n;
     guchar                c;
     gchar                 line[MAX_LINE_LEN + 1];
+    gchar                *hex, *ascii;
     unsigned int          use_digits;
+    const gchar          *printable = hex_dump_printable_table(encoding);
 
     static gchar binhex[16] = {
         '0', '1', '2', '3', '4', '5', '6', '7',
@@ -1238,58 +1260,54 @@ hex_dump_buffer(gboolean (*print_line)(void *, const char *), void *fp,
     else
         use_digits = 4; /* we'll supply 4 digits */
 
-    ad = 0;
-    i = 0;
-    j = 0;
-    k = 0;
-    while (i < length) {
-        if ((i & 15) == 0) {
-            /*
-             * Start of a new line.
-             */
-            j = 0;
-            l = use_digits;
-            do {
-                l--;
-                c = (ad >> (l*4)) & 0xF;
-                line[j++] = binhex[c];
-            } while (l != 0);
-            line[j++] = ' ';
-            line[j++] = ' ';
-            memset(line+j, ' ', DATA_DUMP_LEN);
+    /*
+     * The offset is followed by two blanks, and the hex dump by two
+     * more; those, and the blanks between the bytes of the hex dump,
+     * are the same on every line.
+     */
+    hex = line + use_digits + 2;
+    ascii = hex + HEX_DUMP_LEN + 2;
+    memset(line + use_digits, ' ', 2 + HEX_DUMP_LEN + 2);
 
-            /*
-             * Offset in line of ASCII dump.
-             */
-            k = j + HEX_DUMP_LEN + 2;
-            if (ascii_option == HEXDUMP_ASCII_DELIMIT)
-                line[k++] = '|';
+    /*
+     * Format a whole line at a time, rather than checking for the
+     * start and end of a line at every byte.
+     */
+    for (ad = 0; ad < length; ad += BYTES_PER_LINE) {
+        gchar *k = ascii;
+
+        n = length - ad < BYTES_PER_LINE ? length - ad : BYTES_PER_LINE;
+
+        l = use_digits;
+        do {
+            l--;
+            line[use_digits - 1 - l] = binhex[(ad >> (l*4)) & 0xF];
+        } while (l != 0);
+
+        for (i = 0; i < n; i++) {
+            c = cp[i];
+            hex[i*3] = binhex[c>>4];
+            hex[i*3 + 1] = binhex[c&0xf];
         }
-        c = *cp++;
-        line[j++] = binhex[c>>4];
-        line[j++] = binhex[c&0xf];
-        j++;
-        if (ascii_option != HEXDUMP_ASCII_EXCLUDE ) {
-            if (encoding == HEXDUMP_ENC_EBCDIC) {
-                c = EBCDIC_to_ASCII1(c);
-            }
-            line[k++] = ((c >= ' ') && (c < 0x7f)) ? c : '.';
+        /* Blank out the rest of a short last line. */
+        for (; i < BYTES_PER_LINE; i++) {
+            hex[i*3] = ' ';
+            hex[i*3 + 1] = ' ';
         }
-        i++;
-        if (((i & 15) == 0) || (i == length)) {
-            /*
-             * We'll be starting a new line, or
-             * we're finished printing this buffer;
-             * dump out the line we've constructed,
-             * and advance the offset.
-             */
+
+        if (ascii_option != HEXDUMP_ASCII_EXCLUDE) {
             if (ascii_option == HEXDUMP_ASCII_DELIMIT)
-                line[k++] = '|';
-            line[k] = '\0';
-            if (!print_line(fp, line))
-                return FALSE;
-            ad += 16;
+                *k++ = '|';
+            for (i = 0; i < n; i++)
+                *k++ = printable[cp[i]];
+            if (ascii_option == HEXDUMP_ASCII_DELIMIT)
+                *k++ = '|';
         }
+        *k = '\0';
+        cp += n;
+
+        if (!print_line(fp, line))
+            return FALSE;
     }
     return TRUE;
 }
@@ -570,6 +570,154 @@ static void test_int64_to_str_back(void)
     g_assert_cmpstr(str, ==, "9223372036854775807");
 }
 
+static void test_guint32_to_str_buf(void)
+{
+    static const guint32 values[] = { 0, 9, 10, 99, 100, 999, 1000, 65535, 99999999, 100000000, 999999999, 1000000000, G_MAXUINT32 };
+    char buf[16], expected[16];
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS(values); i++) {
+        snprintf(expected, sizeof expected, "%u", values[i]);
+        guint32_to_str_buf(values[i], buf, sizeof buf);
+        g_assert_cmpstr(buf, ==, expected);
+    }
+
+    guint32_to_str_buf(12345, buf, 5);
+    g_assert_cmpstr(buf, ==, "[Buf");
+}
+
+static void test_guint64_to_str_buf(void)
+{
+    static const guint64 values[] = {
+        0, 9, 10, 4294967295, G_GUINT64_CONSTANT(4294967296),
+        G_GUINT64_CONSTANT(9999999999999999999), G_GUINT64_CONSTANT(10000000000000000000),
+        G_MAXUINT64
+    };
+    char buf[24], expected[24];
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS(values); i++) {
+        snprintf(expected, sizeof expected, "%" G_GUINT64_FORMAT, values[i]);
+        guint64_to_str_buf(values[i], buf, sizeof buf);
+        g_assert_cmpstr(buf, ==, expected);
+    }
+}
+
+static void test_ip_to_str_buf(void)
+{
+    static const guint8 addrs[][4] = {
+        { 0, 0, 0, 0 }, { 255, 255, 255, 255 }, { 10, 0, 99, 100 }, { 192, 168, 1, 9 }
+    };
+    static const char *expected[] = {
+        "0.0.0.0", "255.255.255.255", "10.0.99.100", "192.168.1.9"
+    };
+    char buf[WS_INET_ADDRSTRLEN];
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS(addrs); i++) {
+        ip_to_str_buf(addrs[i], buf, sizeof buf);
+        g_assert_cmpstr(buf, ==, expected[i]);
+    }
+}
+
+static void test_ip6_to_str_buf(void)
+{
+    static const struct {
+        const char *str;
+        guint16     words[8];
+    } tests[] = {
+        { "::",                     { 0, 0, 0, 0, 0, 0, 0, 0 } },
+        { "::1",                    { 0, 0, 0, 0, 0, 0, 0, 1 } },
+        { "fe80::",                 { 0xfe80, 0, 0, 0, 0, 0, 0, 0 } },
+        { "2001:db8::ab:c",         { 0x2001, 0xdb8, 0, 0, 0, 0, 0xab, 0xc } },
+        { "2001:db8:0:1:0:1:0:1",   { 0x2001, 0xdb8, 0, 1, 0, 1, 0, 1 } },
+        { "1:0:0:2::3",             { 1, 0, 0, 2, 0, 0, 0, 3 } },
+        { "1::2:0:0:3:4",           { 1, 0, 0, 2, 0, 0, 3, 4 } },
+        { "1::2:0:0:0",             { 1, 0, 0, 0, 2, 0, 0, 0 } },
+        { "::ffff:192.0.2.1",       { 0, 0, 0, 0, 0, 0xffff, 0xc000, 0x0201 } },
+        { "::192.0.2.1",            { 0, 0, 0, 0, 0, 0, 0xc000, 0x0201 } },
+        { "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff",
+                                    { 0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff } },
+    };
+    ws_in6_addr addr;
+    char buf[WS_INET6_ADDRSTRLEN];
+    size_t i;
+    int j;
+
+    /* The longest run of zeros is shortened, or the first of the longest. */
+    for (i = 0; i < G_N_ELEMENTS(tests); i++) {
+        for (j = 0; j < 8; j++) {
+            addr.bytes[2 * j] = tests[i].words[j] >> 8;
+            addr.bytes[2 * j + 1] = tests[i].words[j] & 0xff;
+        }
+        ip6_to_str_buf(&addr, buf, sizeof buf);
+        g_assert_cmpstr(buf, ==, tests[i].str);
+    }
+}
+
+static void test_bytes_to_hexstr(void)
+{
+    guint8 bytes[40];
+    char buf[81], expected[81];
+    char *end;
+    size_t len, i;
+
+    for (i = 0; i < sizeof bytes; i++)
+        bytes[i] = (guint8)(i * 37 + 5);
+
+    /* Lengths on both sides of the 16-byte blocks. */
+    for (len = 0; len <= sizeof bytes; len++) {
+        for (i = 0; i < len; i++)
+            snprintf(&expected[2 * i], 3, "%02x", bytes[i]);
+        expected[2 * len] = '\0';
+        end = bytes_to_hexstr(buf, bytes, len);
+        g_assert_true(end == buf + 2 * len);
+        *end = '\0';
+        g_assert_cmpstr(buf, ==, expected);
+    }
+}
+
+static void test_to_str_perf(void)
+{
+#define TO_STR_LOOP_COUNT (10 * 1000 * 1000)
+    static const guint8 ipv4[4] = { 192, 168, 100, 1 };
+    ws_in6_addr ipv6 = {{ 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0x12, 0, 0, 0xab, 0xcd, 0, 0x01 }};
+    guint8 bytes[64];
+    char buf[160];
+    int i;
+    double start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    memset(bytes, 0x5a, sizeof bytes);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < TO_STR_LOOP_COUNT; i++)
+        guint32_to_str_buf((guint32)i * 2654435761U, buf, sizeof buf);
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "guint32_to_str_buf(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < TO_STR_LOOP_COUNT; i++)
+        ip_to_str_buf(ipv4, buf, sizeof buf);
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "ip_to_str_buf(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < TO_STR_LOOP_COUNT; i++)
+        ip6_to_str_buf(&ipv6, buf, sizeof buf);
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "ip6_to_str_buf(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < TO_STR_LOOP_COUNT; i++)
+        bytes_to_hexstr(buf, bytes, sizeof bytes);
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "bytes_to_hexstr(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+}
+
 #include "nstime.h"
 #include "time_util.h"
 
@@ -635,6 +783,173 @@ void test_nstime_from_iso8601(void)
     g_assert_cmpint(result.nsecs, ==, expect.nsecs);
 }
 
+#include "crc32.h"
+
+/* Bit at a time, to check the table-driven and hardware versions against. */
+static guint32
+crc32_reflected_reference(const guint8 *p, size_t len, guint32 crc, guint32 poly)
+{
+    while (len-- > 0) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+    }
+    return crc;
+}
+
+static void test_crc32c(void)
+{
+    const char *check = "123456789";
+    guint8 buf[1100];
+    guint32 seed = 0x12345678;
+
+    g_assert_cmphex(~CRC32C_SWAP(crc32c_calculate(check, 9, CRC32C_PRELOAD)), ==, 0xE3069283);
+
+    for (size_t i = 0; i < sizeof buf; i++)
+        buf[i] = (guint8)(i * 7 + (i >> 5));
+    for (int off = 0; off < 16; off++) {
+        for (int len = 0; len < 1024; len += (len < 40 ? 1 : 37)) {
+            g_assert_cmphex(crc32c_calculate_no_swap(buf + off, len, seed), ==,
+                crc32_reflected_reference(buf + off, len, seed, 0x82F63B78));
+            seed = seed * 69069 + 1;
+        }
+    }
+}
+
+static void test_crc32_ccitt(void)
+{
+    const char *check = "123456789";
+    guint8 buf[1100];
+    guint32 seed = 0x12345678;
+
+    g_assert_cmphex(crc32_ccitt((const guint8 *)check, 9), ==, 0xCBF43926);
+
+    for (size_t i = 0; i < sizeof buf; i++)
+        buf[i] = (guint8)(i * 7 + (i >> 5));
+    for (int off = 0; off < 16; off++) {
+        for (guint len = 0; len < 1024; len += (len < 40 ? 1 : 37)) {
+            g_assert_cmphex(crc32_ccitt_seed(buf + off, len, seed), ==,
+                ~crc32_reflected_reference(buf + off, len, seed, 0xEDB88320));
+            seed = seed * 69069 + 1;
+        }
+    }
+}
+
+#include "ws_mempbrk.h"
+
+static const char *mempbrk_http_headers =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/115.0\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Cookie: session=5f2b1c9e8a7d6e4f3a2b1c0d9e8f7a6b; theme=dark; _ga=GA1.2.1234567890.1234567890\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static void test_mempbrk(void)
+{
+    /* Needles below and above 0x80, more than SSE 4.2 handles. */
+    const char *needles = "\r\n;=,: \x80\xa0\xc3\xfe\x7f\x01\x0f\x10\x1f\xf0";
+    ws_mempbrk_pattern pattern;
+    guint8 buf[200];
+    const guint8 *expected;
+    const guint8 *found;
+    guchar found_needle;
+
+    memset(&pattern, 0, sizeof pattern);
+    ws_mempbrk_compile(&pattern, needles);
+    for (int i = 0; i < 256; i++)
+        buf[i % sizeof buf] = (guint8)i;
+
+    for (size_t off = 0; off < 40; off++) {
+        for (size_t len = 0; off + len <= sizeof buf; len++) {
+            expected = NULL;
+            for (size_t i = off; i < off + len; i++) {
+                if (buf[i] != '\0' && strchr(needles, buf[i])) {
+                    expected = buf + i;
+                    break;
+                }
+            }
+            found_needle = 0;
+            found = ws_mempbrk_exec(buf + off, len, &pattern, &found_needle);
+            g_assert_true(found == expected);
+            if (expected)
+                g_assert_cmpuint(found_needle, ==, *expected);
+        }
+    }
+
+    memset(&pattern, 0, sizeof pattern);
+    ws_mempbrk_compile(&pattern, "\r\n");
+    found = ws_mempbrk_exec((const guint8 *)mempbrk_http_headers,
+        strlen(mempbrk_http_headers), &pattern, &found_needle);
+    g_assert_true(found == (const guint8 *)mempbrk_http_headers + strlen("GET /index.html HTTP/1.1"));
+    g_assert_cmpuint(found_needle, ==, '\r');
+}
+
+static void test_mempbrk_perf(void)
+{
+#define MEMPBRK_LOOP_COUNT (1 * 1000 * 1000)
+    ws_mempbrk_pattern pattern;
+    const guint8 *data = (const guint8 *)mempbrk_http_headers;
+    const guint8 *p, *found;
+    size_t len, left;
+    guint lines = 0;
+    int i;
+    double start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    /* Split the headers into lines, as the line-based dissectors do. */
+    memset(&pattern, 0, sizeof pattern);
+    ws_mempbrk_compile(&pattern, "\r\n");
+    len = strlen(mempbrk_http_headers);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < MEMPBRK_LOOP_COUNT; i++) {
+        p = data;
+        left = len;
+        while ((found = ws_mempbrk_exec(p, left, &pattern, NULL)) != NULL) {
+            lines++;
+            left -= found + 1 - p;
+            p = found + 1;
+        }
+    }
+    RESOURCE_USAGE_END;
+    g_assert_cmpuint(lines, ==, 18 * MEMPBRK_LOOP_COUNT);
+    g_test_minimized_result(utime_ms + stime_ms,
+        "ws_mempbrk_exec(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+}
+
+#include "unicode-utils.h"
+
+static void test_utf8_valid_prefix_len(void)
+{
+    struct {
+        const char *str;
+        size_t len;
+        size_t valid;
+    } tests[] = {
+        { "", 0, 0 },
+        { "plain ASCII, long enough for some whole blocks", 47, 47 },
+        { "NUL\0is valid", 13, 13 },
+        { "caf\xc3\xa9", 5, 5 },
+        { "caf\xc3", 4, 3 },               /* truncated */
+        { "\xe2\x82\xac euro", 8, 8 },
+        { "\xf0\x9f\x98\x80!", 5, 5 },
+        { "ab\xc0\xaf", 4, 2 },           /* overlong */
+        { "ab\xe0\x80\xaf", 5, 2 },       /* overlong */
+        { "ab\xed\xa0\x80", 5, 2 },       /* surrogate */
+        { "ab\xf4\x90\x80\x80", 6, 2 },   /* above U+10FFFF */
+        { "ab\xf5\x80\x80\x80", 6, 2 },
+        { "0123456789abcdef0123456789abcdef\x80", 33, 32 },
+        { "0123456789abcdef0123456789abcde\xc3\xa9", 33, 33 },
+    };
+
+    for (size_t i = 0; i < G_N_ELEMENTS(tests); i++) {
+        g_assert_cmpuint(ws_utf8_valid_prefix_len((const guint8 *)tests[i].str, tests[i].len), ==, tests[i].valid);
+    }
+}
+
 #include "ws_getopt.h"
 
 #define ARGV_MAX 31
@@ -808,6 +1123,291 @@ static void test_getopt_opterr1(void)
     g_test_trap_assert_stderr("/bin/ls: unrecognized option: z\n");
 }
 
+#include "json_dumper.h"
+
+static void test_json_dumper(void)
+{
+    json_dumper dumper = {
+        .output_string = g_string_new(NULL),
+        .flags = JSON_DUMPER_DOT_TO_UNDERSCORE,
+    };
+    char *long_str;
+
+    json_dumper_begin_object(&dumper);
+    json_dumper_set_member_name(&dumper, "ip.src");
+    json_dumper_value_string(&dumper, "a\"b\\c\n\001</script>.x\xc3\xa9");
+    json_dumper_set_member_name(&dumper, "n");
+    json_dumper_begin_array(&dumper);
+    json_dumper_value_int64(&dumper, G_MININT64);
+    json_dumper_value_uint64(&dumper, G_MAXUINT64);
+    json_dumper_value_int64(&dumper, 0);
+    json_dumper_value_anyf(&dumper, "%d", -42);
+    json_dumper_value_string(&dumper, NULL);
+    json_dumper_end_array(&dumper);
+    json_dumper_end_object(&dumper);
+    g_assert_true(json_dumper_finish(&dumper));
+    g_assert_cmpstr(dumper.output_string->str, ==,
+            "{\"ip_src\":\"a\\\"b\\\\c\\n\\u0001<\\/script>.x\xc3\xa9\","
+            "\"n\":[-9223372036854775808,18446744073709551615,0,-42,null]}\n");
+
+    /* Strings bigger than the output buffer. */
+    long_str = g_strnfill(3 * JSON_DUMPER_BUFFER_SIZE, 'x');
+    long_str[JSON_DUMPER_BUFFER_SIZE] = '"';
+    g_string_truncate(dumper.output_string, 0);
+    json_dumper_value_string(&dumper, long_str);
+    g_assert_true(json_dumper_finish(&dumper));
+    g_assert_cmpuint(dumper.output_string->len, ==, 3 * JSON_DUMPER_BUFFER_SIZE + 4);
+    g_assert_cmpint(dumper.output_string->str[JSON_DUMPER_BUFFER_SIZE + 1], ==, '\\');
+
+    g_free(long_str);
+    g_string_free(dumper.output_string, TRUE);
+}
+
+static void test_json_dumper_cbor(void)
+{
+    json_dumper dumper = {
+        .output_string = g_string_new(NULL),
+        .flags = JSON_DUMPER_DOT_TO_UNDERSCORE | JSON_DUMPER_FLAGS_CBOR | JSON_DUMPER_FLAGS_PRETTY_PRINT,
+    };
+    static const guint8 expected[] = {
+        0xbf,
+            0x66, 'i', 'p', '_', 's', 'r', 'c', 0x62, 'a', 'b',
+            0x61, 'n', 0x9f,
+                0x20,
+                0x18, 0x18,
+                0x3b, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                0x1b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                0xf5,
+                0x61, 'x',
+                0x39, 0x01, 0x00,
+                0xfb, 0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0xf6,
+                0x5f, 0x42, 0x01, 0x02, 0xff,
+            0xff,
+        0xff,
+    };
+
+    json_dumper_begin_object(&dumper);
+    json_dumper_set_member_name(&dumper, "ip.src");
+    json_dumper_value_string(&dumper, "ab");
+    json_dumper_set_member_name(&dumper, "n");
+    json_dumper_begin_array(&dumper);
+    json_dumper_value_int64(&dumper, -1);
+    json_dumper_value_uint64(&dumper, 24);
+    json_dumper_value_int64(&dumper, G_MININT64);
+    json_dumper_value_uint64(&dumper, G_MAXUINT64);
+    json_dumper_value_anyf(&dumper, "true");
+    json_dumper_value_anyf(&dumper, "\"%s\"", "x");
+    json_dumper_value_anyf(&dumper, "%d", -257);
+    json_dumper_value_double(&dumper, 1.5);
+    json_dumper_value_string(&dumper, NULL);
+    json_dumper_begin_base64(&dumper);
+    json_dumper_write_base64(&dumper, (const guchar *)"\x01\x02", 2);
+    json_dumper_end_base64(&dumper);
+    json_dumper_end_array(&dumper);
+    json_dumper_end_object(&dumper);
+    g_assert_true(json_dumper_finish(&dumper));
+    g_assert_cmpmem(dumper.output_string->str, dumper.output_string->len, expected, sizeof(expected));
+
+    g_string_free(dumper.output_string, TRUE);
+}
+
+static void test_json_dumper_perf(void)
+{
+#define JSON_LOOP_COUNT (1 * 1000 * 1000)
+    json_dumper dumper = {
+        .output_string = g_string_new(NULL),
+        .flags = JSON_DUMPER_FLAGS_PRETTY_PRINT,
+    };
+    int i;
+    double start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    RESOURCE_USAGE_START;
+    json_dumper_begin_array(&dumper);
+    for (i = 0; i < JSON_LOOP_COUNT; i++) {
+        json_dumper_begin_object(&dumper);
+        json_dumper_set_member_name(&dumper, "http.request.full_uri");
+        json_dumper_value_string(&dumper, "http://www.example.com/index.html?q=\"json\"");
+        json_dumper_set_member_name(&dumper, "tcp.len");
+        json_dumper_value_int64(&dumper, i);
+        json_dumper_set_member_name(&dumper, "frame.protocols");
+        json_dumper_value_string(&dumper, "eth:ethertype:ip:tcp:http");
+        json_dumper_end_object(&dumper);
+        if (dumper.output_string->len > 1024 * 1024)
+            g_string_truncate(dumper.output_string, 0);
+    }
+    json_dumper_end_array(&dumper);
+    json_dumper_finish(&dumper);
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "json_dumper: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    g_string_free(dumper.output_string, TRUE);
+}
+
+#include "arrow_writer.h"
+#include "pint.h"
+
+/* Reads back the messages of an Arrow IPC stream, checking the framing. */
+static void test_arrow_writer(void)
+{
+    FILE *fh = tmpfile();
+    arrow_writer *writer;
+    guint8 *buf;
+    long len, off;
+    guint8 header_types[4];
+    guint n_messages = 0;
+
+    g_assert_nonnull(fh);
+    writer = arrow_writer_new(fh, 2);
+    arrow_writer_add_column(writer, "frame.number", ARROW_TYPE_UINT64, FALSE);
+    arrow_writer_add_column(writer, "ip.src", ARROW_TYPE_UINT32, TRUE);
+    arrow_writer_add_column(writer, "http.host", ARROW_TYPE_UTF8, FALSE);
+    arrow_writer_add_column(writer, "frame.time", ARROW_TYPE_TIMESTAMP, FALSE);
+    for (guint64 i = 1; i <= 3; i++) {
+        arrow_writer_append_uint(writer, 0, i);
+        arrow_writer_append_uint(writer, 1, 0xc0a80001);
+        arrow_writer_append_uint(writer, 1, 0xc0a80002);
+        if (i != 2)
+            arrow_writer_append_string(writer, 2, "example.com");
+        arrow_writer_append_int(writer, 3, 1000000000 * (gint64)i);
+        g_assert_true(arrow_writer_end_row(writer));
+    }
+    g_assert_true(arrow_writer_finish(writer));
+
+    len = ftell(fh);
+    g_assert_cmpint(len, >, 0);
+    buf = g_malloc(len);
+    rewind(fh);
+    g_assert_cmpuint(fread(buf, 1, len, fh), ==, len);
+    fclose(fh);
+
+    for (off = 0; ; ) {
+        guint32 meta_len, root, vtable, table, header_type_at;
+
+        g_assert_cmpint(off + 8, <=, len);
+        g_assert_cmphex(pletoh32(buf + off), ==, 0xFFFFFFFF);
+        meta_len = pletoh32(buf + off + 4);
+        off += 8;
+        if (meta_len == 0)
+            break;
+        g_assert_cmpuint(meta_len % 8, ==, 0);
+        g_assert_cmpuint(n_messages, <, G_N_ELEMENTS(header_types));
+
+        /* Message.header_type is field 1 of the root table. */
+        root = pletoh32(buf + off);
+        table = off + root;
+        vtable = table - pletoh32(buf + table);
+        header_type_at = pletoh16(buf + vtable + 6);
+        g_assert_cmpuint(header_type_at, !=, 0);
+        header_types[n_messages++] = buf[table + header_type_at];
+
+        /* Message.bodyLength is field 3. */
+        off += meta_len;
+        if (pletoh16(buf + vtable) > 10 && pletoh16(buf + vtable + 10) != 0)
+            off += (long)pletoh64(buf + table + pletoh16(buf + vtable + 10));
+    }
+    g_assert_cmpint(off, ==, len);
+
+    /* A schema, then two batches of 2 and 1 rows. */
+    g_assert_cmpuint(n_messages, ==, 3);
+    g_assert_cmpuint(header_types[0], ==, 1);
+    g_assert_cmpuint(header_types[1], ==, 3);
+    g_assert_cmpuint(header_types[2], ==, 3);
+
+    g_free(buf);
+}
+
+#include <errno.h>
+
+#include "shm_ring.h"
+
+#ifdef HAVE_SHM_OPEN
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define TEST_SHM_RING_SIZE 64
+
+static void test_shm_ring(void)
+{
+#ifdef HAVE_SHM_OPEN
+    char *name = g_strdup_printf("/wireshark-test-%ld", (long)getpid());
+    ws_shm_ring *writer, *reader;
+    guint8 data[TEST_SHM_RING_SIZE * 3];
+    guint8 buf[TEST_SHM_RING_SIZE * 2];
+    int err;
+    int fd;
+    guint i;
+
+    for (i = 0; i < sizeof data; i++)
+        data[i] = (guint8)i;
+
+    writer = ws_shm_ring_create(name, TEST_SHM_RING_SIZE, &err);
+    g_assert_nonnull(writer);
+    reader = ws_shm_ring_open(name, &err);
+    g_assert_nonnull(reader);
+
+    /* Nothing written yet. */
+    g_assert_cmpint(ws_shm_ring_read(reader, 0, buf, 10), ==, 0);
+
+    /* Write and read back. */
+    ws_shm_ring_write(writer, data, 40);
+    g_assert_cmpint(ws_shm_ring_read(reader, 0, buf, sizeof buf), ==, 40);
+    g_assert_cmpmem(buf, 40, data, 40);
+    g_assert_cmpint(ws_shm_ring_read(reader, 10, buf, 5), ==, 5);
+    g_assert_cmpmem(buf, 5, data + 10, 5);
+    g_assert_cmpint(ws_shm_ring_read(reader, 40, buf, 5), ==, 0);
+
+    /* Wrap: bytes 40-79 go at 40-63 and then 0-15. */
+    ws_shm_ring_write(writer, data + 40, 40);
+    g_assert_cmpint(ws_shm_ring_read(reader, 30, buf, sizeof buf), ==, 50);
+    g_assert_cmpmem(buf, 50, data + 30, 50);
+
+    /* The first 16 bytes have been overwritten. */
+    g_assert_cmpint(ws_shm_ring_read(reader, 15, buf, 10), ==, -1);
+    g_assert_cmpint(ws_shm_ring_read(reader, 16, buf, 10), ==, 10);
+    g_assert_cmpmem(buf, 10, data + 16, 10);
+
+    /* A reader that falls more than a ring behind is told so. */
+    ws_shm_ring_write(writer, data + 80, sizeof data - 80);
+    g_assert_cmpint(ws_shm_ring_read(reader, 80, buf, 10), ==, -1);
+    g_assert_cmpint(ws_shm_ring_read(reader, sizeof data - TEST_SHM_RING_SIZE,
+        buf, sizeof buf), ==, TEST_SHM_RING_SIZE);
+    g_assert_cmpmem(buf, TEST_SHM_RING_SIZE,
+        data + sizeof data - TEST_SHM_RING_SIZE, TEST_SHM_RING_SIZE);
+
+    /* More than a ring in one write keeps just the end of it. */
+    ws_shm_ring_write(writer, data, sizeof data);
+    g_assert_cmpint(ws_shm_ring_read(reader, 2 * sizeof data - TEST_SHM_RING_SIZE,
+        buf, sizeof buf), ==, TEST_SHM_RING_SIZE);
+    g_assert_cmpmem(buf, TEST_SHM_RING_SIZE,
+        data + sizeof data - TEST_SHM_RING_SIZE, TEST_SHM_RING_SIZE);
+    ws_shm_ring_close(reader);
+
+    /* A ring others can get at isn't opened. */
+    fd = shm_open(name, O_RDWR, 0);
+    g_assert_cmpint(fd, !=, -1);
+    g_assert_cmpint(fchmod(fd, 0644), ==, 0);
+    g_assert_null(ws_shm_ring_open(name, &err));
+    g_assert_cmpint(err, ==, EACCES);
+
+    /* Nor is one whose size isn't a power of 2. */
+    g_assert_cmpint(fchmod(fd, 0600), ==, 0);
+    g_assert_cmpint(ftruncate(fd, 64 + TEST_SHM_RING_SIZE + 8), ==, 0);
+    g_assert_null(ws_shm_ring_open(name, &err));
+    g_assert_cmpint(err, ==, EINVAL);
+    close(fd);
+
+    ws_shm_ring_close(writer);
+    g_free(name);
+#else
+    g_test_skip("Shared memory not supported");
+#endif
+}
+
 int main(int argc, char **argv)
 {
     int ret;
@@ -849,14 +1449,44 @@ int main(int argc, char **argv)
     g_test_add_func("/to_str/uint64_to_str_back_len", test_uint64_to_str_back_len);
     g_test_add_func("/to_str/int_to_str_back", test_int_to_str_back);
     g_test_add_func("/to_str/int64_to_str_back", test_int64_to_str_back);
+    g_test_add_func("/to_str/guint32_to_str_buf", test_guint32_to_str_buf);
+    g_test_add_func("/to_str/guint64_to_str_buf", test_guint64_to_str_buf);
+    g_test_add_func("/to_str/ip_to_str_buf", test_ip_to_str_buf);
+    g_test_add_func("/to_str/ip6_to_str_buf", test_ip6_to_str_buf);
+    g_test_add_func("/to_str/bytes_to_hexstr", test_bytes_to_hexstr);
+
+    if (g_test_perf()) {
+        g_test_add_func("/to_str/to_str_perf", test_to_str_perf);
+    }
 
     g_test_add_func("/nstime/from_iso8601", test_nstime_from_iso8601);
 
+    g_test_add_func("/crc32/crc32c", test_crc32c);
+    g_test_add_func("/crc32/ccitt", test_crc32_ccitt);
+
+    g_test_add_func("/ws_mempbrk/exec", test_mempbrk);
+
+    if (g_test_perf()) {
+        g_test_add_func("/ws_mempbrk/exec_perf", test_mempbrk_perf);
+    }
+
+    g_test_add_func("/unicode/utf8_valid_prefix_len", test_utf8_valid_prefix_len);
+
     g_test_add_func("/ws_getopt/basic1", test_getopt_long_basic1);
     g_test_add_func("/ws_getopt/basic2", test_getopt_long_basic2);
     g_test_add_func("/ws_getopt/optional1", test_getopt_optional_argument1);
     g_test_add_func("/ws_getopt/opterr1", test_getopt_opterr1);
 
+    g_test_add_func("/json_dumper/dump", test_json_dumper);
+    g_test_add_func("/json_dumper/cbor", test_json_dumper_cbor);
+    if (g_test_perf()) {
+        g_test_add_func("/json_dumper/dump_perf", test_json_dumper_perf);
+    }
+
+    g_test_add_func("/arrow_writer/stream", test_arrow_writer);
+
+    g_test_add_func("/shm_ring/read_write", test_shm_ring);
+
     ret = g_test_run();
 
     return ret;
@@ -65,6 +65,14 @@ guint64 create_timestamp(void);
 WS_DLL_PUBLIC
 struct timespec *ws_clock_get_realtime(struct timespec *ts);
 
+/**
+ * Fetch a monotonic time, in nanoseconds, for measuring intervals; it's
+ * not related to the time of day, and is as precise as the system's
+ * clock allows.
+ */
+WS_DLL_PUBLIC
+guint64 ws_clock_get_monotonic_ns(void);
+
 /*
  * Portability wrapper around strptime().
  */
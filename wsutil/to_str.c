@@ -15,6 +15,12 @@
 #include <time.h>
 #include <glib.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "to_str.h"
 
 #include <wsutil/utf8_entities.h>
@@ -22,6 +28,7 @@
 #include <wsutil/inet_addr.h>
 #include <wsutil/pint.h>
 #include <wsutil/ws_return.h>
+#include <wsutil/bits_ctz.h>
 
 /*
  * If a user _does_ pass in a too-small buffer, this is probably
@@ -72,6 +79,54 @@ static const char fast_strings[][4] = {
 	"248", "249", "250", "251", "252", "253", "254", "255"
 };
 
+/* The two decimal digits of each of 0 to 99, so that numbers can be
+ * formatted two digits, and one division, at a time. */
+static const char two_digits[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const guint64 powers_of_10[] = {
+	G_GUINT64_CONSTANT(1),
+	G_GUINT64_CONSTANT(10),
+	G_GUINT64_CONSTANT(100),
+	G_GUINT64_CONSTANT(1000),
+	G_GUINT64_CONSTANT(10000),
+	G_GUINT64_CONSTANT(100000),
+	G_GUINT64_CONSTANT(1000000),
+	G_GUINT64_CONSTANT(10000000),
+	G_GUINT64_CONSTANT(100000000),
+	G_GUINT64_CONSTANT(1000000000),
+	G_GUINT64_CONSTANT(10000000000),
+	G_GUINT64_CONSTANT(100000000000),
+	G_GUINT64_CONSTANT(1000000000000),
+	G_GUINT64_CONSTANT(10000000000000),
+	G_GUINT64_CONSTANT(100000000000000),
+	G_GUINT64_CONSTANT(1000000000000000),
+	G_GUINT64_CONSTANT(10000000000000000),
+	G_GUINT64_CONSTANT(100000000000000000),
+	G_GUINT64_CONSTANT(1000000000000000000),
+	G_GUINT64_CONSTANT(10000000000000000000)
+};
+
+/* The number of decimal digits in u, without a chain of comparisons:
+ * bits * 1233 / 4096 is a close enough approximation of bits * log10(2)
+ * to be either the number of digits or one more than it. */
+static inline size_t
+decimal_digits(const guint64 u)
+{
+	size_t digits = ((ws_ilog2(u | 1) + 1) * 1233) >> 12;
+
+	return digits + ((u | 1) >= powers_of_10[digits]);
+}
+
 static inline char
 low_nibble_of_octet_to_hex(guint8 oct)
 {
@@ -177,11 +232,52 @@ qword_to_hex_punct(char *out, guint64 qword, char punct)
 char *
 bytes_to_hexstr(char *out, const guint8 *ad, size_t len)
 {
-	size_t i;
+	size_t i = 0;
 
 	ws_return_val_if_null(ad, NULL);
 
-	for (i = 0; i < len; i++)
+#if defined(__SSE2__) || defined(_M_X64)
+	/* 16 bytes at a time: split them into nibbles, turn each nibble
+	 * into '0'-'9' or 'a'-'f', and interleave the high and low ones. */
+	if (len >= 16) {
+		const __m128i nibble_mask = _mm_set1_epi8(0x0F);
+		const __m128i nine = _mm_set1_epi8(9);
+		const __m128i ascii_zero = _mm_set1_epi8('0');
+		const __m128i letter_offset = _mm_set1_epi8('a' - '0' - 10);
+
+		for (; i + 16 <= len; i += 16) {
+			__m128i bytes = _mm_loadu_si128((const __m128i *)(const void *)(ad + i));
+			__m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble_mask);
+			__m128i lo = _mm_and_si128(bytes, nibble_mask);
+
+			hi = _mm_add_epi8(_mm_add_epi8(hi, ascii_zero),
+			    _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letter_offset));
+			lo = _mm_add_epi8(_mm_add_epi8(lo, ascii_zero),
+			    _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letter_offset));
+			_mm_storeu_si128((__m128i *)(void *)out, _mm_unpacklo_epi8(hi, lo));
+			_mm_storeu_si128((__m128i *)(void *)(out + 16), _mm_unpackhi_epi8(hi, lo));
+			out += 32;
+		}
+	}
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+	/* 16 bytes at a time: look each nibble up in a table, and store
+	 * the high and low ones interleaved. */
+	if (len >= 16) {
+		const uint8x16_t hex_digits = vld1q_u8((const uint8_t *)"0123456789abcdef");
+		uint8x16x2_t digits;
+
+		for (; i + 16 <= len; i += 16) {
+			uint8x16_t bytes = vld1q_u8(ad + i);
+
+			digits.val[0] = vqtbl1q_u8(hex_digits, vshrq_n_u8(bytes, 4));
+			digits.val[1] = vqtbl1q_u8(hex_digits, vandq_u8(bytes, vdupq_n_u8(0x0F)));
+			vst2q_u8((uint8_t *)out, digits);
+			out += 32;
+		}
+	}
+#endif
+
+	for (; i < len; i++)
 		out = byte_to_hex(out, ad[i]);
 	return out;
 }
@@ -373,23 +469,21 @@ hex64_to_str_back_len(char *ptr, guint64 value, int len)
 char *
 uint_to_str_back(char *ptr, guint32 value)
 {
-	char const *p;
-
-	/* special case */
-	if (value == 0)
-		*(--ptr) = '0';
-
-	while (value >= 10) {
-		p = fast_strings[100 + (value % 100)];
+	guint32 rem;
 
+	while (value >= 100) {
+		rem = value % 100;
 		value /= 100;
-
-		*(--ptr) = p[2];
-		*(--ptr) = p[1];
+		ptr -= 2;
+		memcpy(ptr, &two_digits[2 * rem], 2);
 	}
 
-	if (value)
-		*(--ptr) = (value) | '0';
+	if (value >= 10) {
+		ptr -= 2;
+		memcpy(ptr, &two_digits[2 * value], 2);
+	} else {
+		*(--ptr) = '0' + value;
+	}
 
 	return ptr;
 }
@@ -397,26 +491,22 @@ uint_to_str_back(char *ptr, guint32 value)
 char *
 uint64_to_str_back(char *ptr, guint64 value)
 {
-	char const *p;
-
-	/* special case */
-	if (value == 0)
-		*(--ptr) = '0';
-
-	while (value >= 10) {
-		p = fast_strings[100 + (value % 100)];
-
-		value /= 100;
-
-		*(--ptr) = p[2];
-		*(--ptr) = p[1];
+	guint32 low;
+	int i;
+
+	/* 64-bit divisions are slow, so peel off eight digits at a time
+	 * until what's left fits in 32 bits. */
+	while (value > G_MAXUINT32) {
+		low = (guint32)(value % 100000000);
+		value /= 100000000;
+		for (i = 0; i < 4; i++) {
+			ptr -= 2;
+			memcpy(ptr, &two_digits[2 * (low % 100)], 2);
+			low /= 100;
+		}
 	}
 
-	/* value will be 0..9, so using '& 0xF' is safe, and faster than '% 10' */
-	if (value)
-		*(--ptr) = (value & 0xF) | '0';
-
-	return ptr;
+	return uint_to_str_back(ptr, (guint32)value);
 }
 
 char *
@@ -483,27 +573,10 @@ int64_to_str_back(char *ptr, gint64 value)
 	return ptr;
 }
 
-static size_t
-guint32_to_str_buf_len(const guint32 u)
-{
-	/* ((2^32)-1) == 2147483647 */
-	if (u >= 1000000000)return 10;
-	if (u >= 100000000) return 9;
-	if (u >= 10000000)  return 8;
-	if (u >= 1000000)   return 7;
-	if (u >= 100000)    return 6;
-	if (u >= 10000)     return 5;
-	if (u >= 1000)      return 4;
-	if (u >= 100)       return 3;
-	if (u >= 10)        return 2;
-
-	return 1;
-}
-
 void
 guint32_to_str_buf(guint32 u, gchar *buf, size_t buf_len)
 {
-	size_t str_len = guint32_to_str_buf_len(u)+1;
+	size_t str_len = decimal_digits(u)+1;
 
 	gchar *bp = &buf[str_len];
 
@@ -514,38 +587,10 @@ guint32_to_str_buf(guint32 u, gchar *buf, size_t buf_len)
 	uint_to_str_back(bp, u);
 }
 
-static size_t
-guint64_to_str_buf_len(const guint64 u)
-{
-	/* ((2^64)-1) == 18446744073709551615 */
-
-	if (u >= G_GUINT64_CONSTANT(10000000000000000000)) return 20;
-	if (u >= G_GUINT64_CONSTANT(1000000000000000000))  return 19;
-	if (u >= G_GUINT64_CONSTANT(100000000000000000))   return 18;
-	if (u >= G_GUINT64_CONSTANT(10000000000000000))    return 17;
-	if (u >= G_GUINT64_CONSTANT(1000000000000000))     return 16;
-	if (u >= G_GUINT64_CONSTANT(100000000000000))      return 15;
-	if (u >= G_GUINT64_CONSTANT(10000000000000))       return 14;
-	if (u >= G_GUINT64_CONSTANT(1000000000000))        return 13;
-	if (u >= G_GUINT64_CONSTANT(100000000000))         return 12;
-	if (u >= G_GUINT64_CONSTANT(10000000000))          return 11;
-	if (u >= G_GUINT64_CONSTANT(1000000000))           return 10;
-	if (u >= G_GUINT64_CONSTANT(100000000))            return 9;
-	if (u >= G_GUINT64_CONSTANT(10000000))             return 8;
-	if (u >= G_GUINT64_CONSTANT(1000000))              return 7;
-	if (u >= G_GUINT64_CONSTANT(100000))               return 6;
-	if (u >= G_GUINT64_CONSTANT(10000))                return 5;
-	if (u >= G_GUINT64_CONSTANT(1000))                 return 4;
-	if (u >= G_GUINT64_CONSTANT(100))                  return 3;
-	if (u >= G_GUINT64_CONSTANT(10))                   return 2;
-
-	return 1;
-}
-
 void
 guint64_to_str_buf(guint64 u, gchar *buf, size_t buf_len)
 {
-	size_t str_len = guint64_to_str_buf_len(u)+1;
+	size_t str_len = decimal_digits(u)+1;
 
 	gchar *bp = &buf[str_len];
 
@@ -563,38 +608,23 @@ guint64_to_str_buf(guint64 u, gchar *buf, size_t buf_len)
 void
 ip_to_str_buf(const guint8 *ad, gchar *buf, const int buf_len)
 {
-	register gchar const *p;
-	register gchar *b=buf;
+	gchar *b = buf;
+	int i;
 
 	_return_if_nospace(WS_INET_ADDRSTRLEN, buf, buf_len);
 
-	p=fast_strings[*ad++];
-	do {
-		*b++=*p;
-		p++;
-	} while(*p);
-	*b++='.';
-
-	p=fast_strings[*ad++];
-	do {
-		*b++=*p;
-		p++;
-	} while(*p);
-	*b++='.';
-
-	p=fast_strings[*ad++];
-	do {
-		*b++=*p;
-		p++;
-	} while(*p);
-	*b++='.';
-
-	p=fast_strings[*ad];
-	do {
-		*b++=*p;
-		p++;
-	} while(*p);
-	*b=0;
+	/*
+	 * Each fast_strings entry is padded with NULs to four bytes,
+	 * so copy all four and then step over just the digits; the
+	 * last copy ends at most at the end of the WS_INET_ADDRSTRLEN
+	 * bytes.
+	 */
+	for (i = 0; i < 4; i++) {
+		memcpy(b, fast_strings[ad[i]], 4);
+		b += 1 + (ad[i] >= 10) + (ad[i] >= 100);
+		*b++ = '.';
+	}
+	b[-1] = '\0';
 }
 
 char *ip_to_str(wmem_allocator_t *scope, const guint8 *ad)
@@ -606,22 +636,82 @@ char *ip_to_str(wmem_allocator_t *scope, const guint8 *ad)
 	return buf;
 }
 
+/*
+ * Format an IPv6 address the way inet_ntop() in GNU libc, and the BIND
+ * code it came from, does: the first longest run of two or more zero
+ * groups becomes "::", and an IPv4-compatible or IPv4-mapped address
+ * ends with a dotted-quad IPv4 address.  buf must have room for
+ * WS_INET6_ADDRSTRLEN bytes.
+ */
+static void
+ip6_to_str_buf_fast(const guint8 *ad, gchar *buf)
+{
+	guint16 words[8];
+	int best_base = -1, best_len = 0;
+	int cur_base = -1, cur_len = 0;
+	int i;
+	gchar *b = buf;
+
+	for (i = 0; i < 8; i++) {
+		words[i] = pntoh16(ad + 2 * i);
+		if (words[i] == 0) {
+			if (cur_base == -1) {
+				cur_base = i;
+				cur_len = 1;
+			} else {
+				cur_len++;
+			}
+			if (cur_len > best_len) {
+				best_base = cur_base;
+				best_len = cur_len;
+			}
+		} else {
+			cur_base = -1;
+		}
+	}
+	if (best_len < 2)
+		best_base = -1;
+
+	for (i = 0; i < 8; i++) {
+		if (best_base != -1 && i >= best_base && i < best_base + best_len) {
+			if (i == best_base)
+				*b++ = ':';
+			continue;
+		}
+		if (i != 0)
+			*b++ = ':';
+		if (i == 6 && best_base == 0 &&
+		    (best_len == 6 || (best_len == 5 && words[5] == 0xffff))) {
+			ip_to_str_buf(ad + 12, b, WS_INET_ADDRSTRLEN);
+			return;
+		}
+		b = word_to_hex_npad(b, words[i]);
+	}
+	if (best_base != -1 && best_base + best_len == 8)
+		*b++ = ':';
+	*b = '\0';
+}
+
 void
 ip6_to_str_buf(const ws_in6_addr *addr, gchar *buf, size_t buf_size)
 {
-	/*
-	 * If there is not enough space then ws_inet_ntop6() will leave
-	 * an error message in the buffer, we don't need
-	 * to use _return_if_nospace().
-	 */
-	ws_inet_ntop6(addr, buf, (guint)buf_size);
+	if (buf_size < WS_INET6_ADDRSTRLEN) {
+		/*
+		 * If there is not enough space then ws_inet_ntop6() will
+		 * leave an error message in the buffer, we don't need
+		 * to use _return_if_nospace().
+		 */
+		ws_inet_ntop6(addr, buf, (guint)buf_size);
+		return;
+	}
+	ip6_to_str_buf_fast(addr->bytes, buf);
 }
 
 char *ip6_to_str(wmem_allocator_t *scope, const ws_in6_addr *ad)
 {
 	char *buf = wmem_alloc(scope, WS_INET6_ADDRSTRLEN * sizeof(char));
 
-	ws_inet_ntop6(ad, buf, WS_INET6_ADDRSTRLEN);
+	ip6_to_str_buf_fast(ad->bytes, buf);
 
 	return buf;
 }
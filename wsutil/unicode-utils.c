@@ -12,6 +12,14 @@
 
 #include "unicode-utils.h"
 
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 int ws_utf8_seqlen[256] = {
   1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 0x00...0x0f */
   1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 0x10...0x1f */
@@ -31,6 +39,82 @@ int ws_utf8_seqlen[256] = {
   4,4,4,4,4,0,0,0,0,0,0,0,0,0,0,0,  /* 0xf0...0xff */
 };
 
+/* Are the 16 bytes at p all ASCII? */
+static inline gboolean
+utf8_block_is_ascii(const guint8 *p)
+{
+#if defined(__SSE2__) || defined(_M_X64)
+  return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(const void *)p)) == 0;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  return vmaxvq_u8(vld1q_u8(p)) < 0x80;
+#else
+  guint64 w[2];
+
+  memcpy(w, p, sizeof w);
+  return ((w[0] | w[1]) & G_GUINT64_CONSTANT(0x8080808080808080)) == 0;
+#endif
+}
+
+/* Is b a continuation byte? */
+#define UTF8_IS_CONT(b)  (((b) & 0xc0) == 0x80)
+
+size_t
+ws_utf8_valid_prefix_len(const guint8 *str, size_t len)
+{
+  size_t i = 0;
+  guint8 ch, lo, hi;
+
+  while (i < len) {
+    ch = str[i];
+    if (ch < 0x80) {
+      i++;
+      while (len - i >= 16 && utf8_block_is_ascii(str + i))
+        i += 16;
+      continue;
+    }
+
+    /* The second byte's range depends on the first byte, which rules
+     * out overlong forms, surrogates and values above U+10FFFF; the
+     * others are just continuation bytes. */
+    lo = 0x80;
+    hi = 0xbf;
+    switch (ws_utf8_char_len(ch)) {
+
+    case 2:
+      if (len - i < 2 || !UTF8_IS_CONT(str[i+1]))
+        return i;
+      i += 2;
+      break;
+
+    case 3:
+      if (ch == 0xe0)
+        lo = 0xa0;
+      else if (ch == 0xed)
+        hi = 0x9f;
+      if (len - i < 3 || str[i+1] < lo || str[i+1] > hi ||
+          !UTF8_IS_CONT(str[i+2]))
+        return i;
+      i += 3;
+      break;
+
+    case 4:
+      if (ch == 0xf0)
+        lo = 0x90;
+      else if (ch == 0xf4)
+        hi = 0x8f;
+      if (len - i < 4 || str[i+1] < lo || str[i+1] > hi ||
+          !UTF8_IS_CONT(str[i+2]) || !UTF8_IS_CONT(str[i+3]))
+        return i;
+      i += 4;
+      break;
+
+    default:
+      return i;
+    }
+  }
+  return i;
+}
+
 #ifdef _WIN32
 
 #include <strsafe.h>
@@ -69,6 +69,19 @@ int ws_utf8_seqlen[256];
  */
 #define ws_utf8_char_len(ch)  (ws_utf8_seqlen[(ch)])
 
+/** Return the length of the longest prefix of the len bytes at str that
+ * is well-formed UTF-8 made up of whole characters, as defined by Table
+ * 3-7 of the Unicode Standard.  Unlike g_utf8_validate(), NUL is valid.
+ * Runs of ASCII are checked 16 bytes at a time.
+ *
+ * @param str The bytes to check.
+ * @param len The number of bytes.
+ * @return The number of bytes, from the start, that are valid; len if
+ * they all are.
+ */
+WS_DLL_PUBLIC
+size_t ws_utf8_valid_prefix_len(const guint8 *str, size_t len);
+
 
 #ifdef _WIN32
 
@@ -42,6 +42,9 @@ struct _wmem_allocator_t {
     void                        *private_data;
     enum _wmem_allocator_type_t  type;
     gboolean                     in_scope;
+
+    /* Statistics */
+    guint64                      bytes_allocated;
 };
 
 #ifdef __cplusplus
@@ -41,6 +41,8 @@ wmem_alloc(wmem_allocator_t *allocator, const size_t size)
         return NULL;
     }
 
+    allocator->bytes_allocated += size;
+
     return allocator->walloc(allocator->private_data, size);
 }
 
@@ -93,6 +95,8 @@ wmem_realloc(wmem_allocator_t *allocator, void *ptr, const size_t size)
 
     ASSERT(allocator->in_scope);
 
+    allocator->bytes_allocated += size;
+
     return allocator->wrealloc(allocator->private_data, ptr, size);
 }
 
@@ -142,6 +146,7 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     allocator->type      = real_type;
     allocator->callbacks = NULL;
     allocator->in_scope  = TRUE;
+    allocator->bytes_allocated = 0;
 
     switch (real_type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -225,6 +230,12 @@ wmem_in_scope(wmem_allocator_t *allocator)
     return allocator->in_scope;
 }
 
+guint64
+wmem_bytes_allocated(wmem_allocator_t *allocator)
+{
+    return allocator->bytes_allocated;
+}
+
 
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
@@ -230,6 +230,17 @@ WS_DLL_PUBLIC
 gboolean
 wmem_in_scope(wmem_allocator_t *allocator);
 
+/** Get the number of bytes that have been requested from an allocator, by
+ * wmem_alloc() and wmem_realloc(), since it was created; freeing memory
+ * doesn't reduce it.
+ *
+ * @param allocator The allocator.
+ * @return The number of bytes requested.
+ */
+WS_DLL_PUBLIC
+guint64
+wmem_bytes_allocated(wmem_allocator_t *allocator);
+
 /** @} */
 
 #ifdef __cplusplus
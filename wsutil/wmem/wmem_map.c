@@ -10,8 +10,12 @@
  */
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
+#include <wsutil/bits_ctz.h>
+
 #include "wmem_core.h"
 #include "wmem_list.h"
 #include "wmem_map.h"
@@ -41,6 +45,12 @@ typedef struct _wmem_map_item_t {
     struct _wmem_map_item_t *next;
 } wmem_map_item_t;
 
+/* An item of a flat map, stored in the table itself. */
+typedef struct _wmem_map_slot_t {
+    const void *key;
+    void *value;
+} wmem_map_slot_t;
+
 struct _wmem_map_t {
     guint count; /* number of items stored */
 
@@ -52,6 +62,15 @@ struct _wmem_map_t {
 
     wmem_map_item_t **table;
 
+    /* For flat maps, which use open addressing instead of chaining: a
+     * control byte for each slot, saying whether it's empty, deleted, or
+     * full, in which case it also has 7 bits of the key's hash, and the
+     * slots themselves. */
+    gboolean         flat;
+    guint8          *ctrl;
+    wmem_map_slot_t *slots;
+    size_t           growth_left; /* empty slots that may still be filled */
+
     GHashFunc  hash_func;
     GEqualFunc eql_func;
 
@@ -98,6 +117,21 @@ wmem_map_new(wmem_allocator_t *allocator,
     map->data_allocator = allocator;
     map->count = 0;
     map->table = NULL;
+    map->flat  = FALSE;
+    map->ctrl  = NULL;
+    map->slots = NULL;
+
+    return map;
+}
+
+wmem_map_t *
+wmem_map_new_flat(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new(allocator, hash_func, eql_func);
+    map->flat = TRUE;
 
     return map;
 }
@@ -110,6 +144,8 @@ wmem_map_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
 
     map->count = 0;
     map->table = NULL;
+    map->ctrl  = NULL;
+    map->slots = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(map->metadata_allocator, map->metadata_scope_cb_id);
@@ -144,6 +180,9 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
     map->data_allocator = data_scope;
     map->count = 0;
     map->table = NULL;
+    map->flat  = FALSE;
+    map->ctrl  = NULL;
+    map->slots = NULL;
 
     map->metadata_scope_cb_id = wmem_register_callback(metadata_scope, wmem_map_destroy_cb, map);
     map->data_scope_cb_id  = wmem_register_callback(data_scope, wmem_map_reset_cb, map);
@@ -151,6 +190,292 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
     return map;
 }
 
+wmem_map_t *
+wmem_map_new_flat_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new_autoreset(metadata_scope, data_scope, hash_func, eql_func);
+    map->flat = TRUE;
+
+    return map;
+}
+
+/* Flat maps.
+ *
+ * These keep the keys and values in the table itself, in the manner of
+ * Google's "Swiss tables": the slots are split into groups of eight, and a
+ * key's hash picks a group to start looking in and seven bits to look for
+ * in the control bytes of each group; a whole group's control bytes are
+ * checked for those bits at once, as a 64-bit word, so most lookups only
+ * compare keys that really match, and touch one or two cache lines. Groups
+ * are probed in triangular order, which visits each of them once, and the
+ * search stops at a group with an empty slot. The table is kept at most
+ * half full, counting deleted slots, so there always is one; groups of
+ * eight, unlike the sixteen SSE2 can check at once, fill up too often if
+ * it's allowed to get any fuller, and then searches have to go on to the
+ * next group.
+ */
+#define FLAT_GROUP_WIDTH 8
+
+#define FLAT_CTRL_EMPTY   0x80
+#define FLAT_CTRL_DELETED 0xFE  /* full slots have the top bit clear */
+
+#define FLAT_LSBS G_GUINT64_CONSTANT(0x0101010101010101)
+#define FLAT_MSBS G_GUINT64_CONSTANT(0x8080808080808080)
+
+/* The base-2 logarithm of the default capacity, which is two groups. */
+#define WMEM_MAP_FLAT_DEFAULT_CAPACITY 4
+
+#define FLAT_GROUPS(MAP) (CAPACITY(MAP) / FLAT_GROUP_WIDTH)
+#define FLAT_MAX_LOAD(MAP) (CAPACITY(MAP) / 2)
+
+/* The hash function's result, mixed with the random value, and with all
+ * its bits spread around, as both the low and the high bits are used. */
+static inline guint32
+flat_hash(const wmem_map_t *map, const void *key)
+{
+    guint32 h = map->hash_func(key) ^ x;
+
+    /* The MurmurHash3 finalizer */
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+#define FLAT_H1(HASH) ((HASH) >> 7)             /* picks the first group */
+#define FLAT_H2(HASH) ((guint8)((HASH) & 0x7F)) /* goes in the control byte */
+
+static inline guint64
+flat_load_group(const wmem_map_t *map, size_t group)
+{
+    guint64 ctrl;
+
+    memcpy(&ctrl, map->ctrl + group * FLAT_GROUP_WIDTH, sizeof ctrl);
+    return GUINT64_FROM_LE(ctrl);
+}
+
+/* Each of these returns a word with the top bit set in each byte that
+ * matches. flat_match() may also match a full slot that doesn't have the
+ * bits, right after one that does, which only costs a key comparison. */
+static inline guint64
+flat_match(guint64 ctrl, guint8 h2)
+{
+    guint64 cmp = ctrl ^ (FLAT_LSBS * h2);
+
+    return (cmp - FLAT_LSBS) & ~cmp & FLAT_MSBS;
+}
+
+static inline guint64
+flat_match_empty(guint64 ctrl)
+{
+    return ctrl & ~(ctrl << 6) & FLAT_MSBS;
+}
+
+static inline guint64
+flat_match_empty_or_deleted(guint64 ctrl)
+{
+    return ctrl & FLAT_MSBS;
+}
+
+/* The slot of the first match in the group */
+#define FLAT_MATCH_SLOT(GROUP, MATCH) \
+    ((GROUP) * FLAT_GROUP_WIDTH + (size_t)ws_ctz(MATCH) / 8)
+
+static void
+flat_alloc_table(wmem_map_t *map)
+{
+    map->ctrl  = (guint8 *)wmem_alloc(map->data_allocator, CAPACITY(map));
+    memset(map->ctrl, FLAT_CTRL_EMPTY, CAPACITY(map));
+    map->slots = wmem_alloc_array(map->data_allocator, wmem_map_slot_t, CAPACITY(map));
+    map->growth_left = FLAT_MAX_LOAD(map);
+}
+
+static void
+flat_init_table(wmem_map_t *map)
+{
+    map->count    = 0;
+    map->capacity = WMEM_MAP_FLAT_DEFAULT_CAPACITY;
+    flat_alloc_table(map);
+}
+
+/* Returns the slot the key is in, or -1 if it's not in the map. */
+static inline gssize
+flat_find(const wmem_map_t *map, const void *key, guint32 hash)
+{
+    size_t  group_mask = FLAT_GROUPS(map) - 1;
+    size_t  group = FLAT_H1(hash) & group_mask;
+    size_t  step = 0;
+    size_t  slot;
+    guint64 ctrl, match;
+
+    for (;;) {
+        ctrl = flat_load_group(map, group);
+        for (match = flat_match(ctrl, FLAT_H2(hash)); match; match &= match - 1) {
+            slot = FLAT_MATCH_SLOT(group, match);
+            if (map->eql_func(key, map->slots[slot].key)) {
+                return (gssize)slot;
+            }
+        }
+        if (flat_match_empty(ctrl)) {
+            return -1;
+        }
+        step++;
+        group = (group + step) & group_mask;
+    }
+}
+
+/* Returns the first empty or deleted slot the key could go in. */
+static size_t
+flat_find_free(const wmem_map_t *map, guint32 hash)
+{
+    size_t  group_mask = FLAT_GROUPS(map) - 1;
+    size_t  group = FLAT_H1(hash) & group_mask;
+    size_t  step = 0;
+    guint64 match;
+
+    for (;;) {
+        match = flat_match_empty_or_deleted(flat_load_group(map, group));
+        if (match) {
+            return FLAT_MATCH_SLOT(group, match);
+        }
+        step++;
+        group = (group + step) & group_mask;
+    }
+}
+
+/* Rebuild the table, doubling it unless it's mostly full of deleted
+ * slots rather than items. */
+static void
+flat_rehash(wmem_map_t *map)
+{
+    guint8          *old_ctrl  = map->ctrl;
+    wmem_map_slot_t *old_slots = map->slots;
+    size_t           old_cap   = CAPACITY(map);
+    size_t           i, slot;
+
+    if (map->count * 2 >= FLAT_MAX_LOAD(map)) {
+        map->capacity++;
+    }
+    flat_alloc_table(map);
+
+    for (i = 0; i < old_cap; i++) {
+        if (old_ctrl[i] & 0x80) {
+            continue;   /* empty or deleted */
+        }
+        slot = flat_find_free(map, flat_hash(map, old_slots[i].key));
+        map->ctrl[slot]  = old_ctrl[i];
+        map->slots[slot] = old_slots[i];
+        map->growth_left--;
+    }
+
+    wmem_free(map->data_allocator, old_ctrl);
+    wmem_free(map->data_allocator, old_slots);
+}
+
+/* Empty a slot that was full. If its group still has an empty slot, no
+ * search has ever gone on past the group, so this one can be made empty
+ * too; otherwise, it has to be marked as deleted, so that searches for the
+ * keys beyond it don't stop there. */
+static void
+flat_clear_slot(wmem_map_t *map, size_t slot)
+{
+    if (flat_match_empty(flat_load_group(map, slot / FLAT_GROUP_WIDTH))) {
+        map->ctrl[slot] = FLAT_CTRL_EMPTY;
+        map->growth_left++;
+    } else {
+        map->ctrl[slot] = FLAT_CTRL_DELETED;
+    }
+    map->count--;
+}
+
+static void *
+flat_insert(wmem_map_t *map, const void *key, void *value)
+{
+    guint32  hash;
+    gssize   found;
+    size_t   slot;
+    void    *old_val;
+
+    /* Make sure we have a table */
+    if (map->ctrl == NULL) {
+        flat_init_table(map);
+    }
+
+    hash  = flat_hash(map, key);
+    found = flat_find(map, key, hash);
+    if (found >= 0) {
+        /* replace and return old value for this key */
+        old_val = map->slots[found].value;
+        map->slots[found].value = value;
+        return old_val;
+    }
+
+    slot = flat_find_free(map, hash);
+    if (map->ctrl[slot] == FLAT_CTRL_EMPTY) {
+        if (map->growth_left == 0) {
+            flat_rehash(map);
+            slot = flat_find_free(map, hash);
+        }
+        map->growth_left--;
+    }
+    map->ctrl[slot]        = FLAT_H2(hash);
+    map->slots[slot].key   = key;
+    map->slots[slot].value = value;
+    map->count++;
+
+    /* no previous entry, return NULL */
+    return NULL;
+}
+
+static inline gboolean
+flat_lookup_extended(wmem_map_t *map, const void *key, const void **orig_key, void **value)
+{
+    gssize found;
+
+    /* Make sure we have a table */
+    if (map->ctrl == NULL) {
+        return FALSE;
+    }
+
+    found = flat_find(map, key, flat_hash(map, key));
+    if (found < 0) {
+        return FALSE;
+    }
+    if (orig_key) {
+        *orig_key = map->slots[found].key;
+    }
+    if (value) {
+        *value = map->slots[found].value;
+    }
+    return TRUE;
+}
+
+static gboolean
+flat_remove(wmem_map_t *map, const void *key, void **value)
+{
+    gssize found;
+
+    /* Make sure we have a table */
+    if (map->ctrl == NULL) {
+        return FALSE;
+    }
+
+    found = flat_find(map, key, flat_hash(map, key));
+    if (found < 0) {
+        return FALSE;
+    }
+    if (value) {
+        *value = map->slots[found].value;
+    }
+    flat_clear_slot(map, found);
+    return TRUE;
+}
+
 static inline void
 wmem_map_grow(wmem_map_t *map)
 {
@@ -189,6 +514,10 @@ wmem_map_insert(wmem_map_t *map, const void *key, void *value)
     wmem_map_item_t **item;
     void *old_val;
 
+    if (map->flat) {
+        return flat_insert(map, key, value);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         wmem_map_init_table(map);
@@ -231,6 +560,10 @@ wmem_map_contains(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map->flat) {
+        return flat_lookup_extended(map, key, NULL, NULL);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
@@ -254,6 +587,11 @@ void *
 wmem_map_lookup(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
+    void *value;
+
+    if (map->flat) {
+        return flat_lookup_extended(map, key, NULL, &value) ? value : NULL;
+    }
 
     /* Make sure we have a table */
     if (map->table == NULL) {
@@ -279,6 +617,10 @@ wmem_map_lookup_extended(wmem_map_t *map, const void *key, const void **orig_key
 {
     wmem_map_item_t *item;
 
+    if (map->flat) {
+        return flat_lookup_extended(map, key, orig_key, value);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
@@ -310,6 +652,10 @@ wmem_map_remove(wmem_map_t *map, const void *key)
     wmem_map_item_t **item, *tmp;
     void *value;
 
+    if (map->flat) {
+        return flat_remove(map, key, &value) ? value : NULL;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return NULL;
@@ -341,6 +687,10 @@ wmem_map_steal(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t **item, *tmp;
 
+    if (map->flat) {
+        return flat_remove(map, key, NULL);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return FALSE;
@@ -372,6 +722,18 @@ wmem_map_get_keys(wmem_allocator_t *list_allocator, wmem_map_t *map)
     wmem_map_item_t *cur;
     wmem_list_t* list = wmem_list_new(list_allocator);
 
+    if (map->flat) {
+        if (map->ctrl != NULL) {
+            capacity = CAPACITY(map);
+            for (i=0; i<capacity; i++) {
+                if (!(map->ctrl[i] & 0x80)) {
+                    wmem_list_prepend(list, (void*)map->slots[i].key);
+                }
+            }
+        }
+        return list;
+    }
+
     if (map->table != NULL) {
         capacity = CAPACITY(map);
 
@@ -394,6 +756,18 @@ wmem_map_foreach(wmem_map_t *map, GHFunc foreach_func, gpointer user_data)
     wmem_map_item_t *cur;
     unsigned i;
 
+    if (map->flat) {
+        if (map->ctrl == NULL) {
+            return;
+        }
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (!(map->ctrl[i] & 0x80)) {
+                foreach_func((gpointer)map->slots[i].key, map->slots[i].value, user_data);
+            }
+        }
+        return;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return;
@@ -414,6 +788,20 @@ wmem_map_foreach_remove(wmem_map_t *map, GHRFunc foreach_func, gpointer user_dat
     wmem_map_item_t **item, *tmp;
     unsigned i, deleted = 0;
 
+    if (map->flat) {
+        if (map->ctrl == NULL) {
+            return 0;
+        }
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (!(map->ctrl[i] & 0x80) &&
+                    foreach_func((gpointer)map->slots[i].key, map->slots[i].value, user_data)) {
+                flat_clear_slot(map, i);
+                deleted++;
+            }
+        }
+        return deleted;
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         return 0;
@@ -76,6 +76,33 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
         GHashFunc hash_func, GEqualFunc eql_func)
 G_GNUC_MALLOC;
 
+/** Creates a map like wmem_map_new(), except that it uses open addressing,
+ * keeping the keys and values in one table rather than in a list for each
+ * bucket. This makes lookups, especially of keys that aren't in the map,
+ * faster, and makes inserts allocate nothing (except when the table grows),
+ * at the cost of some memory for the empty slots; it's meant for big, busy
+ * maps. The map is used exactly like any other.
+ *
+ * @param allocator The allocator scope with which to create the map.
+ * @param hash_func The hash function used to place inserted keys.
+ * @param eql_func  The equality function used to compare inserted keys.
+ * @return The newly-allocated map.
+ */
+WS_DLL_PUBLIC
+wmem_map_t *
+wmem_map_new_flat(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+G_GNUC_MALLOC;
+
+/** Creates a map like wmem_map_new_flat(), but with two allocator scopes,
+ * like wmem_map_new_autoreset().
+ */
+WS_DLL_PUBLIC
+wmem_map_t *
+wmem_map_new_flat_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope,
+        GHashFunc hash_func, GEqualFunc eql_func)
+G_GNUC_MALLOC;
+
 /** Inserts a value into the map.
  *
  * @param map The map to insert into.
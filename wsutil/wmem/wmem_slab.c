@@ -0,0 +1,159 @@
+/* wmem_slab.c
+ * Wireshark Memory Manager Slab
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "wmem-int.h"
+#include "wmem_core.h"
+#include "wmem_allocator.h"
+#include "wmem_slab.h"
+#include "wmem_user_cb.h"
+
+/* Objects are aligned the same way the pools align their allocations. */
+#define WMEM_SLAB_ALIGN_AMOUNT (2 * sizeof (gsize))
+#define WMEM_SLAB_ALIGN_SIZE(SIZE) ((~(WMEM_SLAB_ALIGN_AMOUNT-1)) & \
+        ((SIZE) + (WMEM_SLAB_ALIGN_AMOUNT-1)))
+
+/* The first chunk holds this many objects; each one after that holds twice
+ * as many as the last, up to the maximum, so that a slab that's only used
+ * for a few objects between each wmem_free_all() doesn't take much, and
+ * one that's used for a lot of them doesn't go back to the pool often. The
+ * size reached is kept across wmem_free_all(). */
+#define WMEM_SLAB_MIN_CHUNK_OBJECTS 32
+#define WMEM_SLAB_MAX_CHUNK_OBJECTS 1024
+
+/* A freed object holds the next freed one. */
+typedef struct _wmem_slab_free_t {
+    struct _wmem_slab_free_t *next;
+} wmem_slab_free_t;
+
+struct _wmem_slab_t {
+    wmem_allocator_t *allocator;
+    size_t            object_size;
+    guint             chunk_objects;    /* objects in the next chunk */
+    guint8           *next;             /* next unused object in the current chunk */
+    guint8           *end;              /* end of the current chunk */
+    wmem_slab_free_t *free_list;
+    guint             callback_id;
+    gboolean          per_object;       /* allocate each object from the pool */
+};
+
+static gboolean
+wmem_slab_event_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
+        void *user_data)
+{
+    wmem_slab_t *slab = (wmem_slab_t *)user_data;
+
+    if (event == WMEM_CB_DESTROY_EVENT) {
+        wmem_free(NULL, slab);
+        return FALSE;
+    }
+
+    /* The chunks are gone; start over. */
+    slab->next      = NULL;
+    slab->end       = NULL;
+    slab->free_list = NULL;
+    return TRUE;
+}
+
+wmem_slab_t *
+wmem_slab_new(wmem_allocator_t *allocator, const size_t object_size)
+{
+    wmem_slab_t *slab;
+
+    ASSERT(allocator != NULL);
+
+    slab = wmem_new(NULL, wmem_slab_t);
+
+    slab->allocator     = allocator;
+    slab->object_size   = WMEM_SLAB_ALIGN_SIZE(MAX(object_size, sizeof (wmem_slab_free_t)));
+    slab->chunk_objects = WMEM_SLAB_MIN_CHUNK_OBJECTS;
+    slab->next          = NULL;
+    slab->end           = NULL;
+    slab->free_list     = NULL;
+    slab->callback_id   = wmem_register_callback(allocator, wmem_slab_event_cb, slab);
+
+    /* The strict and simple allocators are for debugging; let them (or
+     * valgrind and the like) see each object. */
+    slab->per_object    = (allocator->type == WMEM_ALLOCATOR_STRICT ||
+                           allocator->type == WMEM_ALLOCATOR_SIMPLE);
+
+    return slab;
+}
+
+void *
+wmem_slab_alloc(wmem_slab_t *slab)
+{
+    void   *ptr;
+    size_t  chunk_size;
+
+    if (slab->per_object) {
+        return wmem_alloc(slab->allocator, slab->object_size);
+    }
+
+    if (slab->free_list) {
+        ptr = slab->free_list;
+        slab->free_list = slab->free_list->next;
+        return ptr;
+    }
+
+    if (slab->next == slab->end) {
+        chunk_size = slab->object_size * slab->chunk_objects;
+        slab->next = (guint8 *)wmem_alloc(slab->allocator, chunk_size);
+        slab->end  = slab->next + chunk_size;
+        if (slab->chunk_objects < WMEM_SLAB_MAX_CHUNK_OBJECTS) {
+            slab->chunk_objects *= 2;
+        }
+    }
+
+    ptr = slab->next;
+    slab->next += slab->object_size;
+    return ptr;
+}
+
+void
+wmem_slab_free(wmem_slab_t *slab, void *ptr)
+{
+    wmem_slab_free_t *obj = (wmem_slab_free_t *)ptr;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    if (slab->per_object) {
+        wmem_free(slab->allocator, ptr);
+        return;
+    }
+
+    obj->next = slab->free_list;
+    slab->free_list = obj;
+}
+
+void
+wmem_destroy_slab(wmem_slab_t *slab)
+{
+    wmem_unregister_callback(slab->allocator, slab->callback_id);
+    wmem_free(NULL, slab);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
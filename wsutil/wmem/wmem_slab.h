@@ -0,0 +1,104 @@
+/** @file
+ * Definitions for the Wireshark Memory Manager Slab
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WMEM_SLAB_H__
+#define __WMEM_SLAB_H__
+
+#include <glib.h>
+
+#include "wmem_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @addtogroup wmem
+ *  @{
+ *    @defgroup wmem-slab Slab
+ *
+ *    A slab hands out objects of one fixed size, carved out of large
+ *    chunks allocated from a wmem pool. Unlike objects allocated from the
+ *    pool itself, they carry no per-object header, and allocating one is
+ *    usually just a pointer bump. They're all freed, along with the chunks,
+ *    when the pool is freed with wmem_free_all(); the slab then starts
+ *    over, and can go on being used. With the strict and simple allocators,
+ *    which are for debugging, each object is allocated from the pool.
+ *
+ *    @{
+ */
+
+struct _wmem_slab_t;
+
+typedef struct _wmem_slab_t wmem_slab_t;
+
+/** Create a slab of objects of the given size, taking its memory from the
+ * given pool. The slab itself isn't allocated from the pool, as it outlives
+ * wmem_free_all(); free it with wmem_destroy_slab() before the pool is
+ * destroyed, or let it be freed along with the pool.
+ *
+ * @param allocator The pool to take memory from; it must not be NULL.
+ * @param object_size The size of the objects.
+ * @return The new slab.
+ */
+WS_DLL_PUBLIC
+wmem_slab_t *
+wmem_slab_new(wmem_allocator_t *allocator, const size_t object_size)
+G_GNUC_MALLOC;
+
+/** Allocate an object from a slab. Its contents are uninitialized.
+ *
+ * @param slab The slab to allocate from.
+ * @return A pointer to the object.
+ */
+WS_DLL_PUBLIC
+void *
+wmem_slab_alloc(wmem_slab_t *slab)
+G_GNUC_MALLOC;
+
+/** Return an object to a slab, for it to be handed out again. Freeing the
+ * objects isn't necessary; they're all freed when the pool is.
+ *
+ * @param slab The slab the object was allocated from.
+ * @param ptr The object.
+ */
+WS_DLL_PUBLIC
+void
+wmem_slab_free(wmem_slab_t *slab, void *ptr);
+
+/** Destroy a slab. Objects allocated from it stay valid until the pool is
+ * freed.
+ *
+ * @param slab The slab to destroy.
+ */
+WS_DLL_PUBLIC
+void
+wmem_destroy_slab(wmem_slab_t *slab);
+
+/**   @}
+ *  @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WMEM_SLAB_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
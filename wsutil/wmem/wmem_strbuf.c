@@ -20,11 +20,24 @@
 
 #define DEFAULT_MINIMUM_SIZE 16
 
+/* When a string outgrows its initial buffer, grow it to at least this
+ * size, rather than doubling it one small step at a time, so that a
+ * typical label or column string needs one more allocation at most. */
+#define GROWN_MINIMUM_SIZE 64
+
 /* _ROOM accounts for the null-terminator, _RAW_ROOM does not.
  * Some functions need one, some functions need the other. */
 #define WMEM_STRBUF_ROOM(S) ((S)->alloc_size - (S)->len - 1)
 #define WMEM_STRBUF_RAW_ROOM(S) ((S)->alloc_size - (S)->len)
 
+/* The initial buffer is allocated along with the wmem_strbuf_t, just
+ * after it, so that making a short string, such as a field's value, takes
+ * one allocation rather than two; or, with wmem_strbuf_init_buf(), it's
+ * provided by the caller. Either way it isn't ours to free or realloc,
+ * and it's only replaced if the string outgrows it. */
+#define WMEM_STRBUF_INITIAL_STR(S) ((gchar *)((S) + 1))
+#define WMEM_STRBUF_HAS_INITIAL_STR(S) ((S)->str == (S)->initial_str)
+
 wmem_strbuf_t *
 wmem_strbuf_sized_new(wmem_allocator_t *allocator,
                       size_t alloc_size, size_t max_size)
@@ -33,19 +46,52 @@ wmem_strbuf_sized_new(wmem_allocator_t *allocator,
 
     ASSERT((max_size == 0) || (alloc_size <= max_size));
 
-    strbuf = wmem_new(allocator, wmem_strbuf_t);
+    if (alloc_size == 0) {
+        alloc_size = DEFAULT_MINIMUM_SIZE;
+    }
+
+    strbuf = (wmem_strbuf_t *)wmem_alloc(allocator, sizeof(wmem_strbuf_t) + alloc_size);
 
     strbuf->allocator = allocator;
     strbuf->len       = 0;
-    strbuf->alloc_size = alloc_size ? alloc_size : DEFAULT_MINIMUM_SIZE;
+    strbuf->alloc_size = alloc_size;
     strbuf->max_size   = max_size;
 
-    strbuf->str    = (gchar *)wmem_alloc(strbuf->allocator, strbuf->alloc_size);
+    strbuf->str    = WMEM_STRBUF_INITIAL_STR(strbuf);
     strbuf->str[0] = '\0';
+    strbuf->initial_str = strbuf->str;
 
     return strbuf;
 }
 
+void
+wmem_strbuf_init_buf(wmem_strbuf_t *strbuf, wmem_allocator_t *allocator,
+                     gchar *buf, size_t buf_size, size_t max_size)
+{
+    ASSERT(buf_size > 0);
+    ASSERT((max_size == 0) || (buf_size <= max_size));
+
+    strbuf->allocator  = allocator;
+    strbuf->len        = 0;
+    strbuf->alloc_size = buf_size;
+    strbuf->max_size   = max_size;
+
+    strbuf->str    = buf;
+    strbuf->str[0] = '\0';
+    strbuf->initial_str = buf;
+}
+
+void
+wmem_strbuf_release(wmem_strbuf_t *strbuf)
+{
+    if (!WMEM_STRBUF_HAS_INITIAL_STR(strbuf)) {
+        wmem_free(strbuf->allocator, strbuf->str);
+    }
+    strbuf->str = NULL;
+    strbuf->len = 0;
+    strbuf->alloc_size = 0;
+}
+
 wmem_strbuf_t *
 wmem_strbuf_new_len(wmem_allocator_t *allocator, const gchar *str, size_t len)
 {
@@ -112,6 +158,10 @@ wmem_strbuf_grow(wmem_strbuf_t *strbuf, const size_t to_add)
         new_alloc_len *= 2;
     }
 
+    if (WMEM_STRBUF_HAS_INITIAL_STR(strbuf) && new_alloc_len < GROWN_MINIMUM_SIZE) {
+        new_alloc_len = GROWN_MINIMUM_SIZE;
+    }
+
     /* max length only enforced if not 0 */
     if (strbuf->max_size && new_alloc_len > strbuf->max_size) {
         new_alloc_len = strbuf->max_size;
@@ -121,7 +171,15 @@ wmem_strbuf_grow(wmem_strbuf_t *strbuf, const size_t to_add)
         return;
     }
 
-    strbuf->str = (gchar *)wmem_realloc(strbuf->allocator, strbuf->str, new_alloc_len);
+    if (WMEM_STRBUF_HAS_INITIAL_STR(strbuf)) {
+        gchar *str = (gchar *)wmem_alloc(strbuf->allocator, new_alloc_len);
+
+        memcpy(str, strbuf->str, strbuf->len + 1);
+        strbuf->str = str;
+    }
+    else {
+        strbuf->str = (gchar *)wmem_realloc(strbuf->allocator, strbuf->str, new_alloc_len);
+    }
 
     strbuf->alloc_size = new_alloc_len;
 }
@@ -398,7 +456,15 @@ wmem_strbuf_finalize(wmem_strbuf_t *strbuf)
     if (strbuf == NULL)
         return NULL;
 
-    char *ret = (char *)wmem_realloc(strbuf->allocator, strbuf->str, strbuf->len+1);
+    char *ret;
+
+    if (WMEM_STRBUF_HAS_INITIAL_STR(strbuf)) {
+        ret = (char *)wmem_alloc(strbuf->allocator, strbuf->len+1);
+        memcpy(ret, strbuf->str, strbuf->len+1);
+    }
+    else {
+        ret = (char *)wmem_realloc(strbuf->allocator, strbuf->str, strbuf->len+1);
+    }
 
     wmem_free(strbuf->allocator, strbuf);
 
@@ -411,7 +477,9 @@ wmem_strbuf_destroy(wmem_strbuf_t *strbuf)
     if (strbuf == NULL)
         return;
 
-    wmem_free(strbuf->allocator, strbuf->str);
+    if (!WMEM_STRBUF_HAS_INITIAL_STR(strbuf)) {
+        wmem_free(strbuf->allocator, strbuf->str);
+    }
     wmem_free(strbuf->allocator, strbuf);
 }
 
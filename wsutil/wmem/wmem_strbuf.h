@@ -48,6 +48,7 @@ struct _wmem_strbuf_t {
     /* private fields */
     size_t alloc_size;
     size_t max_size;
+    gchar *initial_str;
 };
 
 typedef struct _wmem_strbuf_t wmem_strbuf_t;
@@ -58,8 +59,31 @@ wmem_strbuf_sized_new(wmem_allocator_t *allocator,
                       size_t alloc_size, size_t max_size)
 G_GNUC_MALLOC;
 
+/* Most labels fit in 64 bytes, so start with that rather than growing
+ * a small buffer several times for each one. */
 #define wmem_strbuf_new_label(ALLOCATOR) \
-    wmem_strbuf_sized_new((ALLOCATOR), 0, ITEM_LABEL_LENGTH)
+    wmem_strbuf_sized_new((ALLOCATOR), 64, ITEM_LABEL_LENGTH)
+
+/* Initializes a string buffer whose string starts out in buf, a buffer of
+ * buf_size bytes provided by the caller, typically on the stack, and is
+ * moved to memory from allocator only if it outgrows buf. Building a short
+ * string that is only needed for a moment, such as a hash table key to look
+ * up, then costs no allocations at all.
+ *
+ * A buffer initialized this way must be cleaned up with
+ * wmem_strbuf_release(), not wmem_strbuf_destroy() or
+ * wmem_strbuf_finalize(), and must not be used after buf goes out of scope.
+ */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_init_buf(wmem_strbuf_t *strbuf, wmem_allocator_t *allocator,
+                     gchar *buf, size_t buf_size, size_t max_size);
+
+/* Frees any memory a buffer initialized with wmem_strbuf_init_buf() has
+ * allocated. The wmem_strbuf_t itself belongs to the caller. */
+WS_DLL_PUBLIC
+void
+wmem_strbuf_release(wmem_strbuf_t *strbuf);
 
 WS_DLL_PUBLIC
 wmem_strbuf_t *
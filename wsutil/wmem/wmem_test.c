@@ -43,6 +43,7 @@ wmem_allocator_force_new(const wmem_allocator_type_t type)
     allocator->type = type;
     allocator->callbacks = NULL;
     allocator->in_scope = TRUE;
+    allocator->bytes_allocated = 0;
 
     switch (type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -194,6 +195,94 @@ wmem_test_allocator_callbacks(void)
     g_assert_true(cb_called_count == 3);
 }
 
+static void
+wmem_test_allocator_bytes_allocated(void)
+{
+    wmem_allocator_t *allocator;
+    void             *ptr;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+    g_assert_true(wmem_bytes_allocated(allocator) == 0);
+
+    ptr = wmem_alloc(allocator, 10);
+    g_assert_true(wmem_bytes_allocated(allocator) == 10);
+    ptr = wmem_realloc(allocator, ptr, 100);
+    g_assert_true(wmem_bytes_allocated(allocator) == 110);
+    wmem_free(allocator, ptr);
+    g_assert_true(wmem_bytes_allocated(allocator) == 110);
+
+    wmem_alloc0(allocator, 5);
+    wmem_free_all(allocator);
+    g_assert_true(wmem_bytes_allocated(allocator) == 115);
+
+    wmem_destroy_allocator(allocator);
+}
+
+static void
+wmem_test_allocator_slab(void)
+{
+    wmem_allocator_t *allocator;
+    wmem_slab_t      *slab;
+    guint32          *objs[CONTAINER_ITERS];
+    guint32          *obj;
+    int               i, j;
+
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_BLOCK);
+    slab = wmem_slab_new(allocator, 10 * sizeof (guint32));
+
+    for (j = 0; j < 3; j++) {
+        for (i = 0; i < CONTAINER_ITERS; i++) {
+            objs[i] = (guint32 *)wmem_slab_alloc(slab);
+            g_assert_true(((gsize)objs[i] % (2 * sizeof (gsize))) == 0);
+            memset(objs[i], 0, 10 * sizeof (guint32));
+            objs[i][0] = i;
+            objs[i][9] = i;
+        }
+        for (i = 0; i < CONTAINER_ITERS; i++) {
+            g_assert_true(objs[i][0] == (guint32)i);
+            g_assert_true(objs[i][9] == (guint32)i);
+        }
+        wmem_block_verify(allocator);
+
+        /* Freed objects are handed out again, most recently freed first. */
+        wmem_slab_free(slab, objs[5]);
+        wmem_slab_free(slab, objs[7]);
+        obj = (guint32 *)wmem_slab_alloc(slab);
+        g_assert_true(obj == objs[7]);
+        obj = (guint32 *)wmem_slab_alloc(slab);
+        g_assert_true(obj == objs[5]);
+        wmem_slab_free(slab, NULL);
+
+        /* The slab starts over after the pool is freed. */
+        wmem_free_all(allocator);
+    }
+
+    wmem_destroy_slab(slab);
+    wmem_free_all(allocator);
+
+    /* A slab that isn't destroyed goes with the pool. */
+    slab = wmem_slab_new(allocator, 1);
+    objs[0] = (guint32 *)wmem_slab_alloc(slab);
+    objs[1] = (guint32 *)wmem_slab_alloc(slab);
+    g_assert_true(objs[0] != objs[1]);
+    wmem_destroy_allocator(allocator);
+
+    /* With the strict allocator, the objects are checked one by one. */
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_STRICT);
+    slab = wmem_slab_new(allocator, 10 * sizeof (guint32));
+    for (i = 0; i < MAX_SIMULTANEOUS_ALLOCS; i++) {
+        objs[i] = (guint32 *)wmem_slab_alloc(slab);
+        memset(objs[i], 0, 10 * sizeof (guint32));
+    }
+    wmem_strict_check_canaries(allocator);
+    for (i = 0; i < MAX_SIMULTANEOUS_ALLOCS; i += 2) {
+        wmem_slab_free(slab, objs[i]);
+    }
+    wmem_strict_check_canaries(allocator);
+    wmem_destroy_slab(slab);
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_allocator_det(wmem_allocator_t *allocator, wmem_verify_func verify,
         guint len)
@@ -628,6 +717,60 @@ wmem_test_stringperf(void)
     g_free(str_ptr);
 }
 
+/* Allocate objects the sizes of a proto_node and a field_info in turn, a
+ * packet's worth at a time, freeing them all after each packet, the way
+ * dissection does. */
+static void
+wmem_test_slabperf(void)
+{
+#define SLAB_PACKET_COUNT   (10 * 1000)
+#define SLAB_PACKET_OBJECTS 1000
+#define SLAB_SMALL_SIZE     48
+#define SLAB_LARGE_SIZE     96
+    wmem_allocator_t   *allocator;
+    wmem_slab_t        *small_slab, *large_slab;
+    void               *obj;
+    int                 i, j;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < SLAB_PACKET_COUNT; i++) {
+        for (j = 0; j < SLAB_PACKET_OBJECTS; j++) {
+            obj = wmem_alloc(allocator, SLAB_SMALL_SIZE);
+            *(int *)obj = j;
+            obj = wmem_alloc(allocator, SLAB_LARGE_SIZE);
+            *(int *)obj = j;
+        }
+        wmem_free_all(allocator);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_alloc(block_fast): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    small_slab = wmem_slab_new(allocator, SLAB_SMALL_SIZE);
+    large_slab = wmem_slab_new(allocator, SLAB_LARGE_SIZE);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < SLAB_PACKET_COUNT; i++) {
+        for (j = 0; j < SLAB_PACKET_OBJECTS; j++) {
+            obj = wmem_slab_alloc(small_slab);
+            *(int *)obj = j;
+            obj = wmem_slab_alloc(large_slab);
+            *(int *)obj = j;
+        }
+        wmem_free_all(allocator);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_slab_alloc(block_fast): u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    wmem_destroy_slab(small_slab);
+    wmem_destroy_slab(large_slab);
+    wmem_destroy_allocator(allocator);
+}
+
 /* DATA STRUCTURE TESTING FUNCTIONS (/wmem/datastruct/) */
 
 static void
@@ -1016,6 +1159,271 @@ wmem_test_map(void)
     wmem_destroy_allocator(allocator);
 }
 
+/* Fixed-size keys, hashed and compared as bytes, like the keys of the
+ * conversation indexes; the hash puts them in only a few buckets, so that
+ * most of them collide. */
+typedef struct {
+    guint32 words[4];
+} fixed_test_key_t;
+
+static guint
+fixed_test_key_hash(gconstpointer v)
+{
+    return ((const fixed_test_key_t *)v)->words[0] % 4;
+}
+
+static gboolean
+fixed_test_key_equal(gconstpointer v1, gconstpointer v2)
+{
+    return memcmp(v1, v2, sizeof (fixed_test_key_t)) == 0;
+}
+
+static fixed_test_key_t *
+fixed_test_key_new(wmem_allocator_t *allocator, unsigned int i)
+{
+    fixed_test_key_t *key = wmem_new0(allocator, fixed_test_key_t);
+
+    key->words[0] = i;
+    key->words[3] = ~i;
+    return key;
+}
+
+static void
+wmem_test_map_flat(void)
+{
+    wmem_allocator_t   *allocator, *extra_allocator;
+    wmem_map_t       *map;
+    wmem_list_t      *keys;
+    gchar            *str_key;
+    unsigned int      i, round;
+    void             *ret;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+    extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    /* insertion, lookup and removal of simple integer keys */
+    map = wmem_map_new_flat(allocator, g_direct_hash, g_direct_equal);
+    g_assert_true(map);
+    g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(1)) == NULL);
+    g_assert_true(wmem_map_remove(map, GINT_TO_POINTER(1)) == NULL);
+
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(777777));
+        g_assert_true(ret == NULL);
+        ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(777777));
+        g_assert_true(wmem_map_size(map) == i+1);
+    }
+    wmem_strict_check_canaries(allocator);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(i)) == GINT_TO_POINTER(i));
+        g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(i+CONTAINER_ITERS)) == NULL);
+    }
+    /* remove every other key, then check that the rest can still be found
+     * past the deleted slots */
+    for (i=0; i<CONTAINER_ITERS; i+=2) {
+        ret = wmem_map_remove(map, GINT_TO_POINTER(i));
+        g_assert_true(ret == GINT_TO_POINTER(i));
+        g_assert_true(wmem_map_steal(map, GINT_TO_POINTER(i)) == FALSE);
+    }
+    g_assert_true(wmem_map_size(map) == CONTAINER_ITERS/2);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_map_contains(map, GINT_TO_POINTER(i)) == (i % 2 == 1));
+    }
+    keys = wmem_map_get_keys(allocator, map);
+    g_assert_true(wmem_list_count(keys) == CONTAINER_ITERS/2);
+    wmem_free_all(allocator);
+
+    /* keep a small map busy, so that it fills up with deleted slots, which
+     * have to be reclaimed without the table growing without end */
+    map = wmem_map_new_flat(allocator, g_direct_hash, g_direct_equal);
+    for (round=0; round<CONTAINER_ITERS; round++) {
+        for (i=0; i<8; i++) {
+            wmem_map_insert(map, GINT_TO_POINTER(round*8+i), GINT_TO_POINTER(i));
+        }
+        for (i=0; i<8; i++) {
+            g_assert_true(wmem_map_steal(map, GINT_TO_POINTER(round*8+i)));
+        }
+        g_assert_true(wmem_map_size(map) == 0);
+    }
+    wmem_strict_check_canaries(allocator);
+    wmem_free_all(allocator);
+
+    /* test auto-reset functionality */
+    map = wmem_map_new_flat_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
+    g_assert_true(map);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+        g_assert_true(ret == NULL);
+    }
+    wmem_free_all(extra_allocator);
+    g_assert_true(wmem_map_size(map) == 0);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(i)) == NULL);
+    }
+    wmem_map_insert(map, GINT_TO_POINTER(1), GINT_TO_POINTER(2));
+    g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(1)) == GINT_TO_POINTER(2));
+    wmem_free_all(allocator);
+
+    /* string keys, foreach and foreach_remove */
+    map = wmem_map_new_flat(allocator, wmem_str_hash, g_str_equal);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        str_key = wmem_test_rand_string(allocator, 1, 64);
+        wmem_map_insert(map, str_key, GINT_TO_POINTER(2));
+        g_assert_true(wmem_map_lookup(map, str_key) == GINT_TO_POINTER(2));
+    }
+    wmem_map_foreach(map, check_val_map, GINT_TO_POINTER(2));
+    wmem_map_foreach_remove(map, equal_val_map, GINT_TO_POINTER(2));
+    g_assert_true(wmem_map_size(map) == 0);
+
+    map = wmem_map_new_flat(allocator, g_direct_hash, g_direct_equal);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+    }
+    for (i=0; i<CONTAINER_ITERS; i+=2) {
+        g_assert_true(wmem_map_foreach_remove(map, equal_val_map, GINT_TO_POINTER(i)) == 1);
+    }
+    g_assert_true(wmem_map_size(map) == CONTAINER_ITERS/2);
+    for (i=1; i<CONTAINER_ITERS; i+=2) {
+        g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(i)) == GINT_TO_POINTER(i));
+    }
+
+    wmem_free_all(allocator);
+
+    /* fixed-size keys that collide: they have to be told apart by the
+     * equality function, found past each other's deleted slots, and
+     * survive the table growing */
+    map = wmem_map_new_flat(allocator, fixed_test_key_hash, fixed_test_key_equal);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        ret = wmem_map_insert(map, fixed_test_key_new(allocator, i), GINT_TO_POINTER(i+1));
+        g_assert_true(ret == NULL);
+        g_assert_true(wmem_map_size(map) == i+1);
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        fixed_test_key_t key;
+
+        memset(&key, 0, sizeof key);
+        key.words[0] = i;
+        key.words[3] = ~i;
+        g_assert_true(wmem_map_lookup(map, &key) == GINT_TO_POINTER(i+1));
+        /* same hash, different key */
+        key.words[3] = i;
+        g_assert_true(wmem_map_lookup(map, &key) == NULL);
+    }
+    /* leave deleted slots in every bucket's run of keys */
+    for (i=0; i<CONTAINER_ITERS; i+=3) {
+        fixed_test_key_t *key = fixed_test_key_new(allocator, i);
+
+        g_assert_true(wmem_map_remove(map, key) == GINT_TO_POINTER(i+1));
+        g_assert_true(wmem_map_remove(map, key) == NULL);
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        fixed_test_key_t *key = fixed_test_key_new(allocator, i);
+
+        g_assert_true(wmem_map_lookup(map, key) == (i % 3 == 0 ? NULL : GINT_TO_POINTER(i+1)));
+    }
+    /* putting the keys back, over the deleted slots, doesn't add them twice */
+    for (i=0; i<CONTAINER_ITERS; i+=3) {
+        ret = wmem_map_insert(map, fixed_test_key_new(allocator, i), GINT_TO_POINTER(i+2));
+        g_assert_true(ret == NULL);
+    }
+    g_assert_true(wmem_map_size(map) == CONTAINER_ITERS);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        fixed_test_key_t *key = fixed_test_key_new(allocator, i);
+
+        g_assert_true(wmem_map_lookup(map, key) == GINT_TO_POINTER(i % 3 == 0 ? i+2 : i+1));
+    }
+    wmem_strict_check_canaries(allocator);
+
+    wmem_destroy_allocator(extra_allocator);
+    wmem_destroy_allocator(allocator);
+}
+
+/* Make and destroy short string buffers, the way string fields' values
+ * are set and cleaned up. */
+static void
+wmem_test_strbufperf(void)
+{
+#define STRBUF_PERF_COUNT (10 * 1000 * 1000)
+    wmem_strbuf_t      *strbuf;
+    const char         *values[] = { "", "GET", "example.com", "text/html; charset=UTF-8" };
+    size_t              total = 0;
+    int                 i;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < STRBUF_PERF_COUNT; i++) {
+        strbuf = wmem_strbuf_new(NULL, values[i % G_N_ELEMENTS(values)]);
+        total += wmem_strbuf_get_len(strbuf);
+        wmem_strbuf_destroy(strbuf);
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "wmem_strbuf_new/destroy: u %.3f ms s %.3f ms", utime_ms, stime_ms);
+
+    g_assert_true(total == (size_t)STRBUF_PERF_COUNT / 4 * (0 + 3 + 11 + 24));
+}
+
+/* Compare the chained and flat maps, with a big map of integer keys, like
+ * the ones holding conversations or reassemblies, looked up in an order
+ * other than the one they were inserted in. */
+static void
+wmem_test_mapperf(void)
+{
+#define MAP_PERF_KEYS    (1000 * 1000)
+#define MAP_PERF_LOOKUPS 4
+    wmem_allocator_t   *allocator;
+    wmem_map_t         *map;
+    int                 flat, i, j, k;
+    guint               found;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    for (flat = 0; flat < 2; flat++) {
+        const char *kind = flat ? "flat" : "chained";
+
+        map = flat ? wmem_map_new_flat(allocator, g_direct_hash, g_direct_equal) :
+                     wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < MAP_PERF_KEYS; i++) {
+            wmem_map_insert(map, GINT_TO_POINTER(i * 7 + 1), GINT_TO_POINTER(i));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s inserts: u %.3f ms s %.3f ms", kind, utime_ms, stime_ms);
+
+        found = 0;
+        RESOURCE_USAGE_START;
+        for (j = 0; j < MAP_PERF_LOOKUPS; j++) {
+            for (i = 0; i < MAP_PERF_KEYS; i++) {
+                k = (int)(((guint64)i * 7919) % MAP_PERF_KEYS);
+                found += wmem_map_lookup(map, GINT_TO_POINTER(k * 7 + 1)) != NULL;
+            }
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s lookups: u %.3f ms s %.3f ms", kind, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (j = 0; j < MAP_PERF_LOOKUPS; j++) {
+            for (i = 0; i < MAP_PERF_KEYS; i++) {
+                k = (int)(((guint64)i * 7919) % MAP_PERF_KEYS);
+                found += wmem_map_lookup(map, GINT_TO_POINTER(k * 7 + 2)) != NULL;
+            }
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s failed lookups: u %.3f ms s %.3f ms", kind, utime_ms, stime_ms);
+
+        g_assert_true(found == (MAP_PERF_KEYS - 1) * MAP_PERF_LOOKUPS);
+        wmem_free_all(allocator);
+    }
+
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_queue(void)
 {
@@ -1172,6 +1580,31 @@ wmem_test_strbuf(void)
     g_assert_true(strlen(wmem_strbuf_get_str(strbuf)) ==
              wmem_strbuf_get_len(strbuf));
 
+    /* A buffer on the stack, which moves to the allocator when it's
+     * outgrown. */
+    {
+        gchar          stack_buf[8];
+        wmem_strbuf_t  stack_strbuf;
+
+        wmem_strbuf_init_buf(&stack_strbuf, allocator, stack_buf, sizeof stack_buf, 0);
+        wmem_strbuf_append(&stack_strbuf, "TEST");
+        g_assert_true(wmem_strbuf_get_str(&stack_strbuf) == stack_buf);
+        g_assert_cmpstr(wmem_strbuf_get_str(&stack_strbuf), ==, "TEST");
+
+        wmem_strbuf_append_printf(&stack_strbuf, "%s", "FUZZFUZZ");
+        g_assert_true(wmem_strbuf_get_str(&stack_strbuf) != stack_buf);
+        g_assert_cmpstr(wmem_strbuf_get_str(&stack_strbuf), ==, "TESTFUZZFUZZ");
+        g_assert_cmpuint(wmem_strbuf_get_len(&stack_strbuf), ==, 12);
+        wmem_strict_check_canaries(allocator);
+        wmem_strbuf_release(&stack_strbuf);
+
+        wmem_strbuf_init_buf(&stack_strbuf, allocator, stack_buf, sizeof stack_buf, sizeof stack_buf);
+        wmem_strbuf_append(&stack_strbuf, "TESTFUZZFUZZ");
+        g_assert_true(wmem_strbuf_get_str(&stack_strbuf) == stack_buf);
+        g_assert_cmpstr(wmem_strbuf_get_str(&stack_strbuf), ==, "TESTFUZ");
+        wmem_strbuf_release(&stack_strbuf);
+    }
+
     wmem_destroy_allocator(allocator);
 }
 
@@ -1249,6 +1682,43 @@ wmem_test_tree(void)
     g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
     wmem_free_all(allocator);
 
+    /* test the sorted array variant against an ordinary tree, with keys
+     * going in both in order and out of order */
+    tree = wmem_tree_new_sorted32(allocator);
+    g_assert_true(wmem_tree_is_empty(tree));
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32(tree, i*2+1) == NULL);
+        wmem_tree_insert32(tree, i*2+1, GINT_TO_POINTER(i+1));
+        g_assert_true(wmem_tree_lookup32(tree, i*2+1) == GINT_TO_POINTER(i+1));
+        g_assert_true(wmem_tree_lookup32_le(tree, i*2+2) == GINT_TO_POINTER(i+1));
+        g_assert_true(wmem_tree_lookup32_le(tree, 0) == NULL);
+    }
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
+    wmem_tree_insert32(tree, 1, GINT_TO_POINTER(CONTAINER_ITERS+1));
+    g_assert_true(wmem_tree_lookup32(tree, 1) == GINT_TO_POINTER(CONTAINER_ITERS+1));
+    g_assert_true(wmem_tree_remove32(tree, 3) == GINT_TO_POINTER(2));
+    g_assert_true(!wmem_tree_contains32(tree, 2));
+    g_assert_true(wmem_tree_lookup32_le(tree, 4) == NULL);
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS-1);
+    wmem_free_all(allocator);
+
+    {
+        wmem_tree_t *rb_tree = wmem_tree_new(allocator);
+        tree = wmem_tree_new_sorted32(allocator);
+        for (i=0; i<CONTAINER_ITERS; i++) {
+            guint32 rand_int = g_test_rand_int();
+            wmem_tree_insert32(rb_tree, rand_int, GINT_TO_POINTER(i+1));
+            wmem_tree_insert32(tree, rand_int, GINT_TO_POINTER(i+1));
+        }
+        g_assert_true(wmem_tree_count(tree) == wmem_tree_count(rb_tree));
+        for (i=0; i<CONTAINER_ITERS; i++) {
+            guint32 rand_int = g_test_rand_int();
+            g_assert_true(wmem_tree_lookup32_le(tree, rand_int) ==
+                    wmem_tree_lookup32_le(rb_tree, rand_int));
+        }
+        wmem_free_all(allocator);
+    }
+
     /* test auto-reset functionality */
     tree = wmem_tree_new_autoreset(allocator, extra_allocator);
     for (i=0; i<CONTAINER_ITERS; i++) {
@@ -1480,17 +1950,23 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/allocator/simple",    wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict",    wmem_test_allocator_strict);
     g_test_add_func("/wmem/allocator/callbacks", wmem_test_allocator_callbacks);
+    g_test_add_func("/wmem/allocator/bytes_allocated", wmem_test_allocator_bytes_allocated);
+    g_test_add_func("/wmem/allocator/slab",      wmem_test_allocator_slab);
 
     g_test_add_func("/wmem/utils/misc",    wmem_test_miscutls);
     g_test_add_func("/wmem/utils/strings", wmem_test_strutls);
 
     if (g_test_perf()) {
         g_test_add_func("/wmem/utils/stringperf", wmem_test_stringperf);
+        g_test_add_func("/wmem/allocator/slabperf", wmem_test_slabperf);
+        g_test_add_func("/wmem/datastruct/mapperf", wmem_test_mapperf);
+        g_test_add_func("/wmem/utils/strbufperf", wmem_test_strbufperf);
     }
 
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);
     g_test_add_func("/wmem/datastruct/list",   wmem_test_list);
     g_test_add_func("/wmem/datastruct/map",    wmem_test_map);
+    g_test_add_func("/wmem/datastruct/map/flat", wmem_test_map_flat);
     g_test_add_func("/wmem/datastruct/queue",  wmem_test_queue);
     g_test_add_func("/wmem/datastruct/stack",  wmem_test_stack);
     g_test_add_func("/wmem/datastruct/strbuf", wmem_test_strbuf);
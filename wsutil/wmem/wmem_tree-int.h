@@ -53,6 +53,15 @@ struct _wmem_tree_t {
     guint             data_scope_cb_id;
 
     void (*post_rotation_cb)(wmem_tree_node_t *);
+
+    /* Trees made by wmem_tree_new_sorted32() keep their keys and values in
+     * two parallel arrays, sorted by key, instead of in nodes under root.
+     * A removed key keeps its slot with a NULL value. */
+    gboolean          is_sorted32;
+    guint32          *keys32;
+    void            **values32;
+    guint             count32;
+    guint             size32;
 };
 
 typedef int (*compare_func)(const void *a, const void *b);
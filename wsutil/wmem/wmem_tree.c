@@ -205,6 +205,85 @@ wmem_tree_new(wmem_allocator_t *allocator)
     return tree;
 }
 
+wmem_tree_t *
+wmem_tree_new_sorted32(wmem_allocator_t *allocator)
+{
+    wmem_tree_t *tree;
+
+    tree = wmem_tree_new(allocator);
+    tree->is_sorted32 = TRUE;
+
+    return tree;
+}
+
+/* Returns the index of the first key in a sorted32 tree that is greater
+ * than the given key, i.e. the slot the key would be appended after. */
+static guint
+sorted32_upper_bound(const wmem_tree_t *tree, guint32 key)
+{
+    guint lo = 0, hi = tree->count32;
+
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        if (tree->keys32[mid] <= key) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static void
+sorted32_insert(wmem_tree_t *tree, guint32 key, void *data)
+{
+    guint idx;
+
+    /* Most keys arrive in ascending order, so check the end first. */
+    if (tree->count32 == 0 || tree->keys32[tree->count32 - 1] < key) {
+        idx = tree->count32;
+    }
+    else {
+        idx = sorted32_upper_bound(tree, key);
+        if (idx > 0 && tree->keys32[idx - 1] == key) {
+            tree->values32[idx - 1] = data;
+            return;
+        }
+    }
+
+    if (tree->count32 == tree->size32) {
+        tree->size32 = tree->size32 ? tree->size32 * 2 : 16;
+        tree->keys32 = (guint32 *)wmem_realloc(tree->data_allocator,
+                tree->keys32, tree->size32 * sizeof(guint32));
+        tree->values32 = (void **)wmem_realloc(tree->data_allocator,
+                tree->values32, tree->size32 * sizeof(void *));
+    }
+
+    if (idx < tree->count32) {
+        memmove(&tree->keys32[idx + 1], &tree->keys32[idx],
+                (tree->count32 - idx) * sizeof(guint32));
+        memmove(&tree->values32[idx + 1], &tree->values32[idx],
+                (tree->count32 - idx) * sizeof(void *));
+    }
+    tree->keys32[idx] = key;
+    tree->values32[idx] = data;
+    tree->count32++;
+}
+
+/* Returns the index of the key plus one, or 0 if it isn't there. */
+static guint
+sorted32_find(const wmem_tree_t *tree, guint32 key)
+{
+    guint idx = sorted32_upper_bound(tree, key);
+
+    if (idx > 0 && tree->keys32[idx - 1] == key) {
+        return idx;
+    }
+    return 0;
+}
+
 static gboolean
 wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
         void *user_data)
@@ -212,6 +291,10 @@ wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
     wmem_tree_t *tree = (wmem_tree_t *)user_data;
 
     tree->root = NULL;
+    tree->keys32 = NULL;
+    tree->values32 = NULL;
+    tree->count32 = 0;
+    tree->size32 = 0;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
@@ -282,6 +365,16 @@ free_tree_node(wmem_allocator_t *allocator, wmem_tree_node_t* node, gboolean fre
 void
 wmem_tree_destroy(wmem_tree_t *tree, gboolean free_keys, gboolean free_values)
 {
+    if (tree->is_sorted32) {
+        /* The keys are the 32-bit values themselves, never allocated. */
+        if (free_values) {
+            for (guint i = 0; i < tree->count32; i++) {
+                wmem_free(tree->data_allocator, tree->values32[i]);
+            }
+        }
+        wmem_free(tree->data_allocator, tree->keys32);
+        wmem_free(tree->data_allocator, tree->values32);
+    }
     free_tree_node(tree->data_allocator, tree->root, free_keys, free_values);
     if (tree->metadata_allocator) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
@@ -295,6 +388,9 @@ wmem_tree_destroy(wmem_tree_t *tree, gboolean free_keys, gboolean free_values)
 gboolean
 wmem_tree_is_empty(wmem_tree_t *tree)
 {
+    if (tree->is_sorted32) {
+        return tree->count32 == 0;
+    }
     return tree->root == NULL;
 }
 
@@ -496,6 +592,10 @@ wmem_tree_insert(wmem_tree_t *tree, const void *key, void *data, compare_func cm
 void
 wmem_tree_insert32(wmem_tree_t *tree, guint32 key, void *data)
 {
+    if (tree->is_sorted32) {
+        sorted32_insert(tree, key, data);
+        return;
+    }
     lookup_or_insert32(tree, key, NULL, data, FALSE, TRUE);
 }
 
@@ -503,6 +603,10 @@ gboolean wmem_tree_contains32(wmem_tree_t *tree, guint32 key)
 {
     wmem_tree_node_t *node = tree->root;
 
+    if (tree->is_sorted32) {
+        return sorted32_find(tree, key) != 0;
+    }
+
     while (node) {
         if (key == GPOINTER_TO_UINT(node->key)) {
             return TRUE;
@@ -523,6 +627,11 @@ wmem_tree_lookup32(wmem_tree_t *tree, guint32 key)
 {
     wmem_tree_node_t *node = tree->root;
 
+    if (tree->is_sorted32) {
+        guint idx = sorted32_find(tree, key);
+        return idx ? tree->values32[idx - 1] : NULL;
+    }
+
     while (node) {
         if (key == GPOINTER_TO_UINT(node->key)) {
             return node->data;
@@ -543,6 +652,11 @@ wmem_tree_lookup32_le(wmem_tree_t *tree, guint32 key)
 {
     wmem_tree_node_t *node = tree->root;
 
+    if (tree->is_sorted32) {
+        guint idx = sorted32_upper_bound(tree, key);
+        return idx ? tree->values32[idx - 1] : NULL;
+    }
+
     while (node) {
         if (key == GPOINTER_TO_UINT(node->key)) {
             return node->data;
@@ -614,6 +728,7 @@ wmem_tree_remove32(wmem_tree_t *tree, guint32 key)
 void
 wmem_tree_insert_string(wmem_tree_t* tree, const gchar* k, void* v, guint32 flags)
 {
+    g_return_if_fail(!tree->is_sorted32);
     char *key;
     compare_func cmp;
 
@@ -662,6 +777,7 @@ create_sub_tree(void* d)
 void
 wmem_tree_insert32_array(wmem_tree_t *tree, wmem_tree_key_t *key, void *data)
 {
+    g_return_if_fail(!tree->is_sorted32);
     wmem_tree_t *insert_tree = NULL;
     wmem_tree_key_t *cur_key;
     guint32 i, insert_key32 = 0;
@@ -772,6 +888,17 @@ gboolean
 wmem_tree_foreach(wmem_tree_t* tree, wmem_foreach_func callback,
         void *user_data)
 {
+    if (tree->is_sorted32) {
+        for (guint i = 0; i < tree->count32; i++) {
+            /* No callback for "removed" keys */
+            if (tree->values32[i] &&
+                    callback(GUINT_TO_POINTER(tree->keys32[i]), tree->values32[i], user_data)) {
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+
     if(!tree->root)
         return FALSE;
 
@@ -832,6 +959,26 @@ wmem_print_subtree(wmem_tree_t *tree, guint32 level, wmem_printer_func key_print
 
     wmem_print_indent(level);
 
+    if (tree->is_sorted32) {
+        printf("WMEM sorted tree:%p count:%u size:%u\n", (void *)tree,
+                tree->count32, tree->size32);
+        for (guint i = 0; i < tree->count32; i++) {
+            wmem_print_indent(level + 1);
+            printf("KEY:%u data:%p\n", tree->keys32[i], tree->values32[i]);
+            if (key_printer) {
+                wmem_print_indent(level + 1);
+                key_printer(GUINT_TO_POINTER(tree->keys32[i]));
+                printf("\n");
+            }
+            if (data_printer) {
+                wmem_print_indent(level + 1);
+                data_printer(tree->values32[i]);
+                printf("\n");
+            }
+        }
+        return;
+    }
+
     printf("WMEM tree:%p root:%p\n", (void *)tree, (void *)tree->root);
     if (tree->root) {
         wmem_tree_print_nodes("Root-", tree->root, level, key_printer, data_printer);
@@ -43,6 +43,22 @@ wmem_tree_t *
 wmem_tree_new(wmem_allocator_t *allocator)
 G_GNUC_MALLOC;
 
+/** Creates a tree with the given allocator scope for 32-bit keys only, which
+ * keeps its keys in a sorted array rather than in red/black nodes. Lookups
+ * (in particular wmem_tree_lookup32_le()) are a binary search over
+ * contiguous memory, and inserting a key larger than all the others, such as
+ * a frame number while reading a capture in order, is an append. Inserting
+ * anywhere else moves the larger keys up, so this is only a good choice when
+ * keys mostly arrive in ascending order.
+ *
+ * Only the wmem_tree_*32() functions, wmem_tree_foreach(), wmem_tree_count(),
+ * wmem_tree_is_empty(), wmem_tree_destroy() and wmem_print_tree() can be used
+ * with such a tree; the string and array functions cannot. */
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new_sorted32(wmem_allocator_t *allocator)
+G_GNUC_MALLOC;
+
 /** Creates a tree with two allocator scopes. The base structure lives in the
  * metadata scope, and the tree data lives in the data scope. Every time free_all
  * occurs in the data scope the tree is transparently emptied without affecting
@@ -54,6 +54,13 @@ ws_cpuid(guint32 *CPUInfo, guint32 selector)
 	/* XXX, how to check if it's supported on MSVC? just in case clear all flags above */
 	return TRUE;
 }
+
+static inline guint64
+ws_xgetbv0(void)
+{
+	/* https://docs.microsoft.com/en-us/cpp/intrinsics/xgetbv */
+	return _xgetbv(0);
+}
 #else /* not x86 */
 static gboolean
 ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
@@ -61,6 +68,12 @@ ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
 	/* Not x86, so no cpuid instruction */
 	return FALSE;
 }
+
+static inline guint64
+ws_xgetbv0(void)
+{
+	return 0;
+}
 #endif
 
 #elif defined(__GNUC__)  /* GCC/clang */
@@ -78,6 +91,22 @@ ws_cpuid(guint32 *CPUInfo, int selector)
 							"c" (0));
 	return TRUE;
 }
+
+/*
+ * Get extended control register 0, which says what register state the
+ * OS saves; only call this if cpuid says the OS has enabled XSAVE.
+ */
+static inline guint64
+ws_xgetbv0(void)
+{
+	guint32 eax, edx;
+
+	__asm__ __volatile__("xgetbv"
+						: "=a" (eax),
+							"=d" (edx)
+						: "c" (0));
+	return ((guint64)edx << 32) | eax;
+}
 #elif defined(__i386__)
 static gboolean
 ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
@@ -107,6 +136,12 @@ ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
 	 */
 	return FALSE;
 }
+
+static inline guint64
+ws_xgetbv0(void)
+{
+	return 0;
+}
 #else /* not x86 */
 static gboolean
 ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
@@ -114,6 +149,12 @@ ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
 	/* Not x86, so no cpuid instruction */
 	return FALSE;
 }
+
+static inline guint64
+ws_xgetbv0(void)
+{
+	return 0;
+}
 #endif
 
 #else /* Other compilers */
@@ -123,6 +164,12 @@ ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
 {
 	return FALSE;
 }
+
+static inline guint64
+ws_xgetbv0(void)
+{
+	return 0;
+}
 #endif
 
 static int
@@ -136,3 +183,25 @@ ws_cpuid_sse42(void)
 	/* in ECX bit 20 toggled on */
 	return (CPUInfo[2] & (1 << 20));
 }
+
+static inline int
+ws_cpuid_avx2(void)
+{
+	guint32 CPUInfo[4];
+
+	if (!ws_cpuid(CPUInfo, 0) || CPUInfo[0] < 7)
+		return 0;
+
+	/* in ECX, OSXSAVE (bit 27) and AVX (bit 28) toggled on */
+	ws_cpuid(CPUInfo, 1);
+	if ((CPUInfo[2] & (3U << 27)) != (3U << 27))
+		return 0;
+
+	/* and the OS saves the SSE and AVX registers */
+	if ((ws_xgetbv0() & 0x6) != 0x6)
+		return 0;
+
+	/* in EBX of leaf 7 bit 5 toggled on */
+	ws_cpuid(CPUInfo, 7);
+	return (CPUInfo[1] & (1 << 5));
+}
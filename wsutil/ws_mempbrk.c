@@ -22,6 +22,8 @@
 #endif
 #endif
 
+#include <string.h>
+
 #include <glib.h>
 #include "ws_symbol_export.h"
 #include "ws_mempbrk.h"
@@ -31,14 +33,26 @@ void
 ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const gchar *needles)
 {
     const gchar *n = needles;
+    guint8 c;
+
+    memset(pattern->nibble_lo, 0, sizeof pattern->nibble_lo);
+    memset(pattern->nibble_hi, 0, sizeof pattern->nibble_hi);
     while (*n) {
-        pattern->patt[(int)*n] = 1;
+        c = (guint8)*n;
+        pattern->patt[c] = 1;
+        if (c < 0x80)
+            pattern->nibble_lo[c & 0x0F] |= 1 << (c >> 4);
+        else
+            pattern->nibble_hi[c & 0x0F] |= 1 << ((c >> 4) & 7);
         n++;
     }
 
 #ifdef HAVE_SSE4_2
     ws_mempbrk_sse42_compile(pattern, needles);
 #endif
+#ifdef HAVE_AVX2
+    ws_mempbrk_avx2_compile(pattern);
+#endif
 }
 
 
@@ -63,10 +77,18 @@ ws_mempbrk_portable_exec(const guint8* haystack, size_t haystacklen, const ws_me
 WS_DLL_PUBLIC const guint8 *
 ws_mempbrk_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
 {
+#ifdef HAVE_AVX2
+    if (haystacklen >= 32 && pattern->use_avx2)
+        return ws_mempbrk_avx2_exec(haystack, haystacklen, pattern, found_needle);
+#endif
 #ifdef HAVE_SSE4_2
     if (haystacklen >= 16 && pattern->use_sse42)
         return ws_mempbrk_sse42_exec(haystack, haystacklen, pattern, found_needle);
 #endif
+#ifdef WS_MEMPBRK_NEON
+    if (haystacklen >= 16)
+        return ws_mempbrk_neon_exec(haystack, haystacklen, pattern, found_needle);
+#endif
 
     return ws_mempbrk_portable_exec(haystack, haystacklen, pattern, found_needle);
 }
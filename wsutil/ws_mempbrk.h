@@ -24,6 +24,14 @@ typedef struct {
     gboolean use_sse42;
     __m128i mask;
 #endif
+#ifdef HAVE_AVX2
+    gboolean use_avx2;
+#endif
+    /* Bit (high nibble & 7) of nibble_lo[low nibble] is set for each
+     * needle below 0x80, and of nibble_hi[low nibble] for each one above;
+     * used by the AVX2 and NEON versions. */
+    guint8 nibble_lo[16];
+    guint8 nibble_hi[16];
 } ws_mempbrk_pattern;
 
 /** Compile the pattern for the needles to find using ws_mempbrk_exec().
@@ -0,0 +1,96 @@
+/* ws_mempbrk_avx2.c
+ * ws_mempbrk_exec() using AVX2, 32 bytes at a time
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <glib.h>
+#include "ws_cpuid.h"
+
+#include <immintrin.h>
+#include "ws_mempbrk.h"
+#include "ws_mempbrk_int.h"
+#include "bits_ctz.h"
+
+void
+ws_mempbrk_avx2_compile(ws_mempbrk_pattern* pattern)
+{
+    pattern->use_avx2 = ws_cpuid_avx2();
+}
+
+/*
+ * Returns a mask with bit i set if byte i of value is a needle.  The low
+ * nibble of each byte looks up the needles with that low nibble, among
+ * those below or above 0x80 depending on the top bit, and the high
+ * nibble picks the bit for the needle itself.
+ */
+static inline guint32
+mempbrk_avx2_match(__m256i value, __m256i nibble_lo, __m256i nibble_hi, __m256i bits)
+{
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    __m256i lo, hi, found;
+
+    lo = _mm256_and_si256(value, low_mask);
+    hi = _mm256_and_si256(_mm256_srli_epi16(value, 4), low_mask);
+    found = _mm256_blendv_epi8(_mm256_shuffle_epi8(nibble_lo, lo),
+                               _mm256_shuffle_epi8(nibble_hi, lo), value);
+    found = _mm256_and_si256(found, _mm256_shuffle_epi8(bits, hi));
+    found = _mm256_cmpeq_epi8(found, _mm256_setzero_si256());
+    return ~(guint32)_mm256_movemask_epi8(found);
+}
+
+/* haystacklen must be at least 32. */
+const guint8 *
+ws_mempbrk_avx2_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+    const __m256i nibble_lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(const void *)pattern->nibble_lo));
+    const __m256i nibble_hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(const void *)pattern->nibble_hi));
+    const __m256i bits = _mm256_setr_epi8(
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const guint8 *p = haystack;
+    const guint8 *last = haystack + haystacklen - 32;
+    guint32 mask;
+
+    for (;;) {
+        if (p > last) {
+            /* Look at the last 32 bytes; the ones before p in them
+             * have already been seen not to match. */
+            p = last;
+        }
+        mask = mempbrk_avx2_match(_mm256_loadu_si256((const __m256i *)(const void *)p),
+                                  nibble_lo, nibble_hi, bits);
+        if (mask != 0) {
+            p += ws_ctz(mask);
+            if (found_needle)
+                *found_needle = *p;
+            return p;
+        }
+        if (p == last)
+            return NULL;
+        p += 32;
+    }
+}
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -17,4 +17,15 @@ void ws_mempbrk_sse42_compile(ws_mempbrk_pattern* pattern, const gchar *needles)
 const char *ws_mempbrk_sse42_exec(const char* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
 #endif
 
+#ifdef HAVE_AVX2
+void ws_mempbrk_avx2_compile(ws_mempbrk_pattern* pattern);
+const guint8 *ws_mempbrk_avx2_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
+#endif
+
+/* Every AArch64 processor has NEON. */
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define WS_MEMPBRK_NEON 1
+const guint8 *ws_mempbrk_neon_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle);
+#endif
+
 #endif /* __WS_MEMPBRK_INT_H__ */
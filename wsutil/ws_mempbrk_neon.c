@@ -0,0 +1,87 @@
+/* ws_mempbrk_neon.c
+ * ws_mempbrk_exec() using NEON, 16 bytes at a time
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include "ws_mempbrk.h"
+#include "ws_mempbrk_int.h"
+
+#ifdef WS_MEMPBRK_NEON
+
+#include <arm_neon.h>
+#include "bits_ctz.h"
+
+/*
+ * Returns 0xFF in each byte of value that's a needle, and 0 in the
+ * others; see mempbrk_avx2_match() in ws_mempbrk_avx2.c.
+ */
+static inline uint8x16_t
+mempbrk_neon_match(uint8x16_t value, uint8x16_t nibble_lo, uint8x16_t nibble_hi, uint8x16_t bits)
+{
+    uint8x16_t lo, high_bit, found;
+
+    lo = vandq_u8(value, vdupq_n_u8(0x0F));
+    high_bit = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(value), 7));
+    found = vbslq_u8(high_bit, vqtbl1q_u8(nibble_hi, lo), vqtbl1q_u8(nibble_lo, lo));
+    return vtstq_u8(found, vqtbl1q_u8(bits, vshrq_n_u8(value, 4)));
+}
+
+/* haystacklen must be at least 16. */
+const guint8 *
+ws_mempbrk_neon_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+    static const guint8 bit_table[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+    };
+    const uint8x16_t nibble_lo = vld1q_u8(pattern->nibble_lo);
+    const uint8x16_t nibble_hi = vld1q_u8(pattern->nibble_hi);
+    const uint8x16_t bits = vld1q_u8(bit_table);
+    const guint8 *p = haystack;
+    const guint8 *last = haystack + haystacklen - 16;
+    uint8x16_t found;
+    guint64 mask;
+
+    for (;;) {
+        if (p > last) {
+            /* Look at the last 16 bytes; the ones before p in them
+             * have already been seen not to match. */
+            p = last;
+        }
+        found = mempbrk_neon_match(vld1q_u8(p), nibble_lo, nibble_hi, bits);
+        if (vmaxvq_u8(found) != 0) {
+            /* Narrow each byte to a nibble, so the first match is the
+             * lowest set nibble of a 64-bit value. */
+            mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(found), 4)), 0);
+            p += ws_ctz(mask) >> 2;
+            if (found_needle)
+                *found_needle = *p;
+            return p;
+        }
+        if (p == last)
+            return NULL;
+        p += 16;
+    }
+}
+
+#endif /* WS_MEMPBRK_NEON */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */